@@ -54,6 +54,8 @@
 #include <utils/Log.h>
 #include <utils/Errors.h>
 
+#include <algorithm>
+
 #include <binder/Parcel.h>
 #include <camera/CameraMetadata.h>
 #include <camera_metadata_hidden.h>
@@ -134,6 +136,8 @@ status_t CameraMetadata::unlock(const camera_metadata_t *buffer) const {
         return BAD_VALUE;
     }
     mLocked = false;
+    // The buffer may have been modified directly while it was locked.
+    invalidateTagIndex();
     return OK;
 }
 
@@ -144,6 +148,7 @@ camera_metadata_t* CameraMetadata::release() {
     }
     camera_metadata_t *released = mBuffer;
     mBuffer = NULL;
+    invalidateTagIndex();
     return released;
 }
 
@@ -155,6 +160,7 @@ void CameraMetadata::clear() {
     if (mBuffer) {
         free_camera_metadata(mBuffer);
         mBuffer = NULL;
+        invalidateTagIndex();
     }
 }
 
@@ -165,6 +171,7 @@ void CameraMetadata::acquire(camera_metadata_t *buffer) {
     }
     clear();
     mBuffer = buffer;
+    invalidateTagIndex();
 
     ALOGE_IF(validate_camera_metadata_structure(mBuffer, /*size*/NULL) != OK,
              "%s: Failed to validate metadata structure %p",
@@ -191,6 +198,7 @@ status_t CameraMetadata::append(const camera_metadata_t* other) {
     size_t extraEntries = get_camera_metadata_entry_count(other);
     size_t extraData = get_camera_metadata_data_count(other);
     resizeIfNeeded(extraEntries, extraData);
+    invalidateTagIndex();
 
     return append_camera_metadata(mBuffer, other);
 }
@@ -214,6 +222,7 @@ status_t CameraMetadata::sort() {
         ALOGE("%s: CameraMetadata is locked", __FUNCTION__);
         return INVALID_OPERATION;
     }
+    invalidateTagIndex();
     return sort_camera_metadata(mBuffer);
 }
 
@@ -365,6 +374,7 @@ status_t CameraMetadata::updateImpl(uint32_t tag, const void *data,
             data_count);
 
     res = resizeIfNeeded(1, data_size);
+    invalidateTagIndex();
 
     if (res == OK) {
         camera_metadata_entry_t entry;
@@ -398,7 +408,7 @@ status_t CameraMetadata::updateImpl(uint32_t tag, const void *data,
 
 bool CameraMetadata::exists(uint32_t tag) const {
     camera_metadata_ro_entry entry;
-    return find_camera_metadata_ro_entry(mBuffer, tag, &entry) == 0;
+    return findEntry(tag, &entry) == 0;
 }
 
 camera_metadata_entry_t CameraMetadata::find(uint32_t tag) {
@@ -409,7 +419,11 @@ camera_metadata_entry_t CameraMetadata::find(uint32_t tag) {
         entry.count = 0;
         return entry;
     }
-    res = find_camera_metadata_entry(mBuffer, tag, &entry);
+    camera_metadata_ro_entry roEntry;
+    res = findEntry(tag, &roEntry);
+    if (res == OK) {
+        res = get_camera_metadata_entry(mBuffer, roEntry.index, &entry);
+    }
     if (CC_UNLIKELY( res != OK )) {
         entry.count = 0;
         entry.data.u8 = NULL;
@@ -420,7 +434,7 @@ camera_metadata_entry_t CameraMetadata::find(uint32_t tag) {
 camera_metadata_ro_entry_t CameraMetadata::find(uint32_t tag) const {
     status_t res;
     camera_metadata_ro_entry entry;
-    res = find_camera_metadata_ro_entry(mBuffer, tag, &entry);
+    res = findEntry(tag, &entry);
     if (CC_UNLIKELY( res != OK )) {
         entry.count = 0;
         entry.data.u8 = NULL;
@@ -447,6 +461,7 @@ status_t CameraMetadata::erase(uint32_t tag) {
         return res;
     }
     res = delete_camera_metadata_entry(mBuffer, entry.index);
+    invalidateTagIndex();
     if (res != OK) {
         ALOGE("%s: Error deleting entry %s.%s (%x): %s %d",
                 __FUNCTION__,
@@ -457,6 +472,46 @@ status_t CameraMetadata::erase(uint32_t tag) {
     return res;
 }
 
+status_t CameraMetadata::findEntry(uint32_t tag, camera_metadata_ro_entry_t *entry) const {
+    if (mBuffer == NULL || get_camera_metadata_entry_count(mBuffer) < kTagIndexMinEntries) {
+        return find_camera_metadata_ro_entry(mBuffer, tag, entry);
+    }
+
+    std::unique_lock<std::mutex> l(mTagIndexLock);
+    if (!mTagIndexValid) {
+        if (++mFindsSinceChange < kTagIndexMinFinds) {
+            l.unlock();
+            return find_camera_metadata_ro_entry(mBuffer, tag, entry);
+        }
+        size_t entryCount = get_camera_metadata_entry_count(mBuffer);
+        mTagIndex.clear();
+        mTagIndex.reserve(entryCount);
+        for (size_t i = 0; i < entryCount; i++) {
+            camera_metadata_ro_entry_t e;
+            if (get_camera_metadata_ro_entry(mBuffer, i, &e) != OK) {
+                return find_camera_metadata_ro_entry(mBuffer, tag, entry);
+            }
+            mTagIndex.emplace_back(e.tag, i);
+        }
+        // For duplicate tags, the lowest index sorts first, as with a linear search.
+        std::sort(mTagIndex.begin(), mTagIndex.end());
+        mTagIndexValid = true;
+    }
+
+    auto it = std::lower_bound(mTagIndex.begin(), mTagIndex.end(),
+            std::make_pair(tag, static_cast<uint32_t>(0)));
+    if (it == mTagIndex.end() || it->first != tag) {
+        return NAME_NOT_FOUND;
+    }
+    return get_camera_metadata_ro_entry(mBuffer, it->second, entry);
+}
+
+void CameraMetadata::invalidateTagIndex() const {
+    std::lock_guard<std::mutex> l(mTagIndexLock);
+    mTagIndexValid = false;
+    mFindsSinceChange = 0;
+}
+
 status_t CameraMetadata::removePermissionEntries(metadata_vendor_id_t vendorId,
         std::vector<int32_t> *tagsRemoved) {
     uint32_t tagCount = 0;
@@ -818,6 +873,8 @@ void CameraMetadata::swap(CameraMetadata& other) {
 
     other.mBuffer = thisBuf;
     mBuffer = otherBuf;
+    invalidateTagIndex();
+    other.invalidateTagIndex();
 }
 
 status_t CameraMetadata::getTagFromName(const char *name,
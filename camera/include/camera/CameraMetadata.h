@@ -53,6 +53,10 @@
 
 #include "system/camera_metadata.h"
 
+#include <mutex>
+#include <utility>
+#include <vector>
+
 #include <utils/String8.h>
 #include <utils/Vector.h>
 #include <binder/Parcelable.h>
@@ -292,6 +296,30 @@ class CameraMetadata: public Parcelable {
     camera_metadata_t *mBuffer;
     mutable bool       mLocked;
 
+    /**
+     * Lookup index for buffers that are searched many times between
+     * modifications, such as result metadata going through the camera service.
+     * It is built lazily by find() once enough lookups hit an unchanged buffer,
+     * and is dropped by any change to the buffer's entries.
+     */
+    static const size_t   kTagIndexMinEntries = 32;
+    static const uint32_t kTagIndexMinFinds = 16;
+    mutable std::mutex mTagIndexLock;
+    // (tag, entry index) pairs, sorted
+    mutable std::vector<std::pair<uint32_t, uint32_t>> mTagIndex;
+    mutable bool       mTagIndexValid = false;
+    mutable uint32_t   mFindsSinceChange = 0;
+
+    /**
+     * Find an entry, going through the lookup index when it's worth it
+     */
+    status_t findEntry(uint32_t tag, camera_metadata_ro_entry_t *entry) const;
+
+    /**
+     * Drop the lookup index after the entries of the buffer have changed
+     */
+    void invalidateTagIndex() const;
+
     /**
      * Check if tag has a given type
      */
@@ -63,6 +63,8 @@ camera_status_t ACaptureRequest_addTarget(
     auto pair = req->targets->mOutputs.insert(*target);
     if (!pair.second) {
         ALOGW("%s: target %p already exists!", __FUNCTION__, target);
+    } else {
+        req->markModified();
     }
     return ACAMERA_OK;
 }
@@ -81,7 +83,9 @@ camera_status_t ACaptureRequest_removeTarget(
                 __FUNCTION__, req, req_targets, target);
         return ACAMERA_ERROR_INVALID_PARAMETER;
     }
-    req->targets->mOutputs.erase(*target);
+    if (req->targets->mOutputs.erase(*target) > 0) {
+        req->markModified();
+    }
     return ACAMERA_OK;
 }
 
@@ -140,6 +144,7 @@ camera_status_t ACaptureRequest_setEntry_##NAME(
                __FUNCTION__, req, tag, count, data);                                    \
         return ACAMERA_ERROR_INVALID_PARAMETER;                                         \
     }                                                                                   \
+    req->markModified();                                                                \
     return req->settings->update(tag, count, data);                                     \
 }
 
@@ -168,6 +173,7 @@ camera_status_t ACaptureRequest_setEntry_physicalCamera_##NAME(
             __FUNCTION__, physicalId);                                                  \
       return ACAMERA_ERROR_INVALID_PARAMETER;                                           \
     }                                                                                   \
+    req->markModified();                                                                \
     return req->physicalSettings[physicalId]->update(tag, count, data);                 \
 }
 
@@ -81,6 +81,8 @@ CameraDevice::CameraDevice(
     }
     mHandler = new CallbackHandler(id);
     mCbLooper->registerHandler(mHandler);
+    mCleanupSessionsMsg = new AMessage(kWhatCleanUpSessions, mHandler);
+    mCallbackMessagePool.reserve(kCallbackMessagePoolSize);
 
     const CameraMetadata& metadata = mChars->getInternalData();
     camera_metadata_ro_entry entry = metadata.find(ANDROID_REQUEST_PARTIAL_RESULT_COUNT);
@@ -116,8 +118,27 @@ void
 CameraDevice::postSessionMsgAndCleanup(sp<AMessage>& msg) {
     msg->post();
     msg.clear();
-    sp<AMessage> cleanupMsg = new AMessage(kWhatCleanUpSessions, mHandler);
-    cleanupMsg->post();
+    mCleanupSessionsMsg->post();
+}
+
+sp<AMessage>
+CameraDevice::obtainCallbackMessageLocked(uint32_t what) {
+    for (auto& pooled : mCallbackMessagePool) {
+        // Only the pool holds a reference once the looper has delivered the
+        // message, and the handler clears it before releasing it.
+        if (pooled->getStrongCount() == 1) {
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (pooled->countEntries() == 0) {
+                pooled->setWhat(what);
+                return pooled;
+            }
+        }
+    }
+    sp<AMessage> msg = new AMessage(what, mHandler);
+    if (mCallbackMessagePool.size() < kCallbackMessagePoolSize) {
+        mCallbackMessagePool.push_back(msg);
+    }
+    return msg;
 }
 
 // TODO: cached created request?
@@ -338,6 +359,7 @@ camera_status_t CameraDevice::updateOutputConfigurationLocked(ACaptureSessionOut
         }
     }
     mConfiguredOutputs[streamId] = std::make_pair(output->mWindow, outConfig);
+    mCaptureRequestCache.clear();
 
     return ACAMERA_OK;
 }
@@ -439,7 +461,7 @@ CameraDevice::allocateCaptureRequest(
         }
         if (!found) {
             ALOGE("Unconfigured output target %p in capture request!", anw);
-            return ret;
+            return ACAMERA_ERROR_INVALID_PARAMETER;
         }
     }
 
@@ -447,6 +469,32 @@ CameraDevice::allocateCaptureRequest(
     return ACAMERA_OK;
 }
 
+camera_status_t
+CameraDevice::getCachedCaptureRequestLocked(
+        const ACaptureRequest* request, /*out*/sp<CaptureRequest>& outReq) {
+    for (const auto& entry : mCaptureRequestCache) {
+        if (entry.generation == request->generation) {
+            outReq = entry.request;
+            return ACAMERA_OK;
+        }
+    }
+
+    sp<CaptureRequest> req;
+    camera_status_t ret = allocateCaptureRequest(request, req);
+    if (ret != ACAMERA_OK) {
+        return ret;
+    }
+    if (mCaptureRequestCache.size() < kMaxCachedCaptureRequests) {
+        mCaptureRequestCache.push_back({request->generation, req});
+    } else {
+        mCaptureRequestCache[mNextCaptureRequestCacheSlot] = {request->generation, req};
+        mNextCaptureRequestCacheSlot =
+                (mNextCaptureRequestCacheSlot + 1) % kMaxCachedCaptureRequests;
+    }
+    outReq = req;
+    return ACAMERA_OK;
+}
+
 ACaptureRequest*
 CameraDevice::allocateACaptureRequest(sp<CaptureRequest>& req, const std::string& deviceId) {
     ACaptureRequest* pRequest = new ACaptureRequest();
@@ -731,6 +779,8 @@ CameraDevice::configureStreamsLocked(const ACaptureSessionOutputContainer* outpu
         postSessionMsgAndCleanup(msg);
     }
     mIdle = true;
+    // Cached requests carry stream/surface indices of the old configuration
+    mCaptureRequestCache.clear();
 
     binder::Status remoteRet = mRemote->beginConfigure();
     if (!remoteRet.isOk()) {
@@ -954,10 +1004,63 @@ void CameraDevice::stopLooperAndDisconnect() {
 }
 
 CameraDevice::CallbackHandler::CallbackHandler(const char* id) : mId(id) {
+    mCallbackRequests.reserve(kMaxCallbackRequests);
+}
+
+CameraDevice::CallbackHandler::~CallbackHandler() {
+    for (auto& entry : mCallbackRequests) {
+        freeACaptureRequest(entry.callbackRequest);
+    }
+}
+
+ACaptureRequest*
+CameraDevice::CallbackHandler::getCallbackRequest(const sp<CaptureRequest>& request) {
+    // Repeating requests deliver every frame with the same CaptureRequest, so
+    // the app facing copy (and its settings clone) only needs to be built once.
+    // A weak reference that still promotes guarantees the entry belongs to this
+    // very request and not a new one allocated at the same address.
+    for (auto& entry : mCallbackRequests) {
+        if (entry.request.unsafe_get() != request.get() || entry.request.promote() == nullptr) {
+            continue;
+        }
+        if (entry.callbackRequest->generation == entry.generation) {
+            return entry.callbackRequest;
+        }
+        // The app modified the copy it was handed; rebuild it
+        freeACaptureRequest(entry.callbackRequest);
+        sp<CaptureRequest> req = request;
+        entry.callbackRequest = allocateACaptureRequest(req, mId);
+        entry.generation = entry.callbackRequest->generation;
+        return entry.callbackRequest;
+    }
+
+    sp<CaptureRequest> req = request;
+    CallbackRequest entry = {request, allocateACaptureRequest(req, mId), 0};
+    entry.generation = entry.callbackRequest->generation;
+    if (mCallbackRequests.size() < kMaxCallbackRequests) {
+        mCallbackRequests.push_back(entry);
+        return entry.callbackRequest;
+    }
+    CallbackRequest& victim = mCallbackRequests[mNextCallbackRequestSlot];
+    mNextCallbackRequestSlot = (mNextCallbackRequestSlot + 1) % kMaxCallbackRequests;
+    freeACaptureRequest(victim.callbackRequest);
+    victim = entry;
+    return victim.callbackRequest;
 }
 
 void CameraDevice::CallbackHandler::onMessageReceived(
         const sp<AMessage> &msg) {
+    dispatchMessage(msg);
+    if (msg->what() != kWhatCleanUpSessions) {
+        // Drop the payload here so the message can be recycled by
+        // obtainCallbackMessageLocked once the looper releases it.
+        // kWhatCleanUpSessions is shared and never carries a payload.
+        msg->clear();
+    }
+}
+
+void CameraDevice::CallbackHandler::dispatchMessage(
+        const sp<AMessage> &msg) {
     switch (msg->what()) {
         case kWhatOnDisconnected:
         case kWhatOnError:
@@ -1125,9 +1228,8 @@ void CameraDevice::CallbackHandler::onMessageReceived(
                         ALOGE("%s: Cannot find timestamp!", __FUNCTION__);
                         return;
                     }
-                    ACaptureRequest* request = allocateACaptureRequest(requestSp, mId);
+                    ACaptureRequest* request = getCallbackRequest(requestSp);
                     (*onStart)(context, session.get(), request, timestamp);
-                    freeACaptureRequest(request);
                     break;
                 }
                 case kWhatCaptureStart2:
@@ -1154,9 +1256,8 @@ void CameraDevice::CallbackHandler::onMessageReceived(
                         return;
                     }
 
-                    ACaptureRequest* request = allocateACaptureRequest(requestSp, mId);
+                    ACaptureRequest* request = getCallbackRequest(requestSp);
                     (*onStart2)(context, session.get(), request, timestamp, frameNumber);
-                    freeACaptureRequest(request);
                     break;
                 }
                 case kWhatCaptureResult:
@@ -1177,9 +1278,8 @@ void CameraDevice::CallbackHandler::onMessageReceived(
                         return;
                     }
                     sp<ACameraMetadata> result(static_cast<ACameraMetadata*>(obj.get()));
-                    ACaptureRequest* request = allocateACaptureRequest(requestSp, mId);
+                    ACaptureRequest* request = getCallbackRequest(requestSp);
                     (*onResult)(context, session.get(), request, result.get());
-                    freeACaptureRequest(request);
                     break;
                 }
                 case kWhatLogicalCaptureResult:
@@ -1233,11 +1333,10 @@ void CameraDevice::CallbackHandler::onMessageReceived(
                         physicalMetadataCopyPtrs.push_back(physicalMetadataCopy[i].get());
                     }
 
-                    ACaptureRequest* request = allocateACaptureRequest(requestSp, mId);
+                    ACaptureRequest* request = getCallbackRequest(requestSp);
                     (*onResult)(context, session.get(), request, result.get(),
                             physicalResultInfo.size(), physicalCameraIdPtrs.data(),
                             physicalMetadataCopyPtrs.data());
-                    freeACaptureRequest(request);
                     break;
                 }
                 case kWhatCaptureFail:
@@ -1261,9 +1360,8 @@ void CameraDevice::CallbackHandler::onMessageReceived(
                             static_cast<CameraCaptureFailure*>(obj.get()));
                     ACameraCaptureFailure* failure =
                             static_cast<ACameraCaptureFailure*>(failureSp.get());
-                    ACaptureRequest* request = allocateACaptureRequest(requestSp, mId);
+                    ACaptureRequest* request = getCallbackRequest(requestSp);
                     (*onFail)(context, session.get(), request, failure);
-                    freeACaptureRequest(request);
                     break;
                 }
                 case kWhatLogicalCaptureFail:
@@ -1294,9 +1392,8 @@ void CameraDevice::CallbackHandler::onMessageReceived(
                         failure.physicalCameraId = nullptr;
                     }
                     failure.captureFailure = *failureSp;
-                    ACaptureRequest* request = allocateACaptureRequest(requestSp, mId);
+                    ACaptureRequest* request = getCallbackRequest(requestSp);
                     (*onFail)(context, session.get(), request, &failure);
-                    freeACaptureRequest(request);
                     break;
                 }
                 case kWhatCaptureSeqEnd:
@@ -1371,9 +1468,8 @@ void CameraDevice::CallbackHandler::onMessageReceived(
                         return;
                     }
 
-                    ACaptureRequest* request = allocateACaptureRequest(requestSp, mId);
+                    ACaptureRequest* request = getCallbackRequest(requestSp);
                     (*onBufferLost)(context, session.get(), request, anw, frameNumber);
-                    freeACaptureRequest(request);
                     break;
                 }
             }
@@ -1705,10 +1801,10 @@ CameraDevice::ServiceCallback::onCaptureStarted(
         sp<CaptureRequest> request = cbh.mRequests[burstId];
         sp<AMessage> msg = nullptr;
         if (v2Callback) {
-            msg = new AMessage(kWhatCaptureStart2, dev->mHandler);
+            msg = dev->obtainCallbackMessageLocked(kWhatCaptureStart2);
             msg->setPointer(kCallbackFpKey, (void*) onStart2);
         } else {
-            msg = new AMessage(kWhatCaptureStart, dev->mHandler);
+            msg = dev->obtainCallbackMessageLocked(kWhatCaptureStart);
             msg->setPointer(kCallbackFpKey, (void *)onStart);
         }
         msg->setPointer(kContextKey, cbh.mContext);
@@ -1773,9 +1869,8 @@ CameraDevice::ServiceCallback::onResultReceived(
         sp<ACameraPhysicalCaptureResultInfo> physicalResult(
                 new ACameraPhysicalCaptureResultInfo(physicalResultInfos, frameNumber));
 
-        sp<AMessage> msg = new AMessage(
-                cbh.mIsLogicalCameraCallback ? kWhatLogicalCaptureResult : kWhatCaptureResult,
-                dev->mHandler);
+        sp<AMessage> msg = dev->obtainCallbackMessageLocked(
+                cbh.mIsLogicalCameraCallback ? kWhatLogicalCaptureResult : kWhatCaptureResult);
         msg->setPointer(kContextKey, cbh.mContext);
         msg->setObject(kSessionSpKey, session);
         msg->setObject(kCaptureRequestKey, request);
@@ -156,6 +156,15 @@ class CameraDevice final : public RefBase {
     camera_status_t allocateCaptureRequest(
             const ACaptureRequest* request, sp<CaptureRequest>& outReq);
 
+    // Same as allocateCaptureRequest, but returns the request built by an earlier
+    // submission if neither the ACaptureRequest nor the stream configuration changed.
+    camera_status_t getCachedCaptureRequestLocked(
+            const ACaptureRequest* request, sp<CaptureRequest>& outReq);
+
+    // Returns a callback message for the handler, recycling one that the handler
+    // has finished with when possible.
+    sp<AMessage> obtainCallbackMessageLocked(uint32_t what);
+
     static ACaptureRequest* allocateACaptureRequest(sp<CaptureRequest>& req,
             const std::string& deviceId);
     static void freeACaptureRequest(ACaptureRequest*);
@@ -173,6 +182,8 @@ class CameraDevice final : public RefBase {
 
     // Input message will be posted and cleared after this returns
     void postSessionMsgAndCleanup(sp<AMessage>& msg);
+    // Posted after every session message; holds no payload so it is never reallocated
+    sp<AMessage> mCleanupSessionsMsg;
 
     static camera_status_t getIGBPfromAnw(
             ANativeWindow* anw, sp<IGraphicBufferProducer>& out);
@@ -190,6 +201,22 @@ class CameraDevice final : public RefBase {
     // stream id -> pair of (ANW* from application, OutputConfiguration used for camera service)
     std::map<int, std::pair<ANativeWindow*, OutputConfiguration>> mConfiguredOutputs;
 
+    // Parcelable requests of recent submissions, keyed by ACaptureRequest::generation.
+    // Cleared whenever mConfiguredOutputs changes since the stream/surface indices
+    // baked into the requests depend on it.
+    struct CachedCaptureRequest {
+        uint64_t generation;
+        sp<CaptureRequest> request;
+    };
+    static constexpr size_t kMaxCachedCaptureRequests = 8;
+    std::vector<CachedCaptureRequest> mCaptureRequestCache;
+    size_t mNextCaptureRequestCacheSlot = 0;
+
+    // Callback messages handed to mHandler. A message is reused once the handler
+    // cleared it and nobody but this pool holds a reference to it.
+    static constexpr size_t kCallbackMessagePoolSize = 16;
+    std::vector<sp<AMessage>> mCallbackMessagePool;
+
     // TODO: maybe a bool will suffice for synchronous implementation?
     std::atomic_bool mClosing;
     inline bool isClosed() { return mClosing; }
@@ -247,10 +274,26 @@ class CameraDevice final : public RefBase {
     class CallbackHandler : public AHandler {
       public:
         explicit CallbackHandler(const char* id);
+        ~CallbackHandler();
         void onMessageReceived(const sp<AMessage> &msg) override;
 
       private:
+        void dispatchMessage(const sp<AMessage> &msg);
+
+        // Returns the app facing copy of |request|, reusing the one built for an
+        // earlier callback of the same request unless the app modified it.
+        // Only valid during the callback.
+        ACaptureRequest* getCallbackRequest(const sp<CaptureRequest>& request);
+
         std::string mId;
+        struct CallbackRequest {
+            wp<CaptureRequest> request;
+            ACaptureRequest* callbackRequest;
+            uint64_t generation;
+        };
+        static constexpr size_t kMaxCallbackRequests = 4;
+        std::vector<CallbackRequest> mCallbackRequests;
+        size_t mNextCallbackRequestSlot = 0;
         // This handler will cache all capture session sp until kWhatCleanUpSessions
         // is processed. This is used to guarantee the last session reference is always
         // being removed in callback thread without holding camera device lock
@@ -17,6 +17,7 @@
 #define _ACAPTURE_REQUEST_H
 
 #include <camera/NdkCaptureRequest.h>
+#include <atomic>
 #include <set>
 #include <unordered_map>
 
@@ -52,6 +53,7 @@ struct ACameraOutputTargets {
 struct ACaptureRequest {
     camera_status_t setContext(void* ctx) {
         context = ctx;
+        markModified();
         return ACAMERA_OK;
     }
 
@@ -64,6 +66,21 @@ struct ACaptureRequest {
     std::unordered_map<std::string, sp<ACameraMetadata>> physicalSettings;
     ACameraOutputTargets* targets;
     void*                 context;
+
+    // Process-wide unique stamp of the current request content. Every mutation
+    // assigns a fresh value, so the camera device can reuse the parcelable
+    // request it built for an unchanged ACaptureRequest.
+    uint64_t              generation = nextGeneration();
+
+    void markModified() {
+        generation = nextGeneration();
+    }
+
+  private:
+    static uint64_t nextGeneration() {
+        static std::atomic<uint64_t> sGeneration{0};
+        return sGeneration.fetch_add(1, std::memory_order_relaxed) + 1;
+    }
 };
 
 #endif // _ACAPTURE_REQUEST_H
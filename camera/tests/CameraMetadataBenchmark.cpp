@@ -0,0 +1,113 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <camera/CameraMetadata.h>
+#include <system/camera_metadata.h>
+
+using namespace android;
+
+namespace {
+
+// Fills metadata with one value for every framework tag, in random order, which
+// is about the size of the static metadata of a real device.
+std::vector<uint32_t> fillMetadata(CameraMetadata* metadata) {
+    std::vector<uint32_t> tags;
+    for (int section = 0; section < ANDROID_SECTION_COUNT; section++) {
+        for (uint32_t tag = camera_metadata_section_bounds[section][0];
+                tag < camera_metadata_section_bounds[section][1]; tag++) {
+            if (get_camera_metadata_tag_type(tag) != -1) {
+                tags.push_back(tag);
+            }
+        }
+    }
+    std::shuffle(tags.begin(), tags.end(), std::mt19937(42));
+
+    const int64_t value[2] = {};
+    for (uint32_t tag : tags) {
+        switch (get_camera_metadata_tag_type(tag)) {
+            case TYPE_BYTE:
+                metadata->update(tag, reinterpret_cast<const uint8_t*>(value), 1);
+                break;
+            case TYPE_INT32:
+                metadata->update(tag, reinterpret_cast<const int32_t*>(value), 1);
+                break;
+            case TYPE_FLOAT:
+                metadata->update(tag, reinterpret_cast<const float*>(value), 1);
+                break;
+            case TYPE_INT64:
+                metadata->update(tag, value, 1);
+                break;
+            case TYPE_DOUBLE:
+                metadata->update(tag, reinterpret_cast<const double*>(value), 1);
+                break;
+            case TYPE_RATIONAL:
+                metadata->update(tag,
+                        reinterpret_cast<const camera_metadata_rational_t*>(value), 1);
+                break;
+        }
+    }
+    return tags;
+}
+
+// Lookups on metadata that doesn't change, e.g. static characteristics.
+void BM_CameraMetadata_Find(benchmark::State& state) {
+    CameraMetadata metadata;
+    std::vector<uint32_t> tags = fillMetadata(&metadata);
+    if (state.range(0)) {
+        metadata.sort();
+    }
+
+    const CameraMetadata& constMetadata = metadata;
+    size_t i = 0;
+    for (auto _ : state) {
+        camera_metadata_ro_entry_t entry = constMetadata.find(tags[i++ % tags.size()]);
+        if (entry.count != 1) {
+            state.SkipWithError("tag not found");
+            break;
+        }
+        benchmark::DoNotOptimize(entry);
+    }
+    state.SetLabel(state.range(0) ? "sorted" : "unsorted");
+}
+BENCHMARK(BM_CameraMetadata_Find)->Arg(0)->Arg(1);
+
+// One modification followed by a number of lookups, as when a capture result
+// goes through the result mappers and the frame processor.
+void BM_CameraMetadata_UpdateThenFind(benchmark::State& state) {
+    CameraMetadata metadata;
+    std::vector<uint32_t> tags = fillMetadata(&metadata);
+    const int32_t frameCount = 0;
+
+    size_t i = 0;
+    for (auto _ : state) {
+        metadata.update(ANDROID_REQUEST_FRAME_COUNT, &frameCount, 1);
+        for (int64_t n = 0; n < state.range(0); n++) {
+            camera_metadata_entry_t entry = metadata.find(tags[i++ % tags.size()]);
+            benchmark::DoNotOptimize(entry);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_CameraMetadata_UpdateThenFind)->Arg(4)->Arg(16)->Arg(64)->Arg(256);
+
+} // namespace
+
+BENCHMARK_MAIN();
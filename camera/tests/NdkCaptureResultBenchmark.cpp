@@ -0,0 +1,219 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+
+#include <benchmark/benchmark.h>
+#include <camera/NdkCameraCaptureSession.h>
+#include <camera/NdkCameraDevice.h>
+#include <camera/NdkCameraManager.h>
+#include <camera/NdkCameraMetadata.h>
+#include <camera/NdkCaptureRequest.h>
+#include <media/NdkImageReader.h>
+
+namespace {
+
+constexpr int32_t kWidth = 320;
+constexpr int32_t kHeight = 240;
+constexpr int32_t kMaxImages = 8;
+constexpr auto kResultTimeout = std::chrono::seconds(5);
+
+// Counts results delivered through the NDK capture callbacks.
+struct ResultCounter {
+    std::mutex mutex;
+    std::condition_variable cond;
+    int64_t completed = 0;
+    int64_t failed = 0;
+
+    static void onCompleted(void* context, ACameraCaptureSession*, ACaptureRequest*,
+            const ACameraMetadata*) {
+        ResultCounter* thiz = static_cast<ResultCounter*>(context);
+        std::lock_guard<std::mutex> l(thiz->mutex);
+        thiz->completed++;
+        thiz->cond.notify_one();
+    }
+
+    static void onFailed(void* context, ACameraCaptureSession*, ACaptureRequest*,
+            ACameraCaptureFailure*) {
+        ResultCounter* thiz = static_cast<ResultCounter*>(context);
+        std::lock_guard<std::mutex> l(thiz->mutex);
+        thiz->failed++;
+        thiz->cond.notify_one();
+    }
+
+    bool waitFor(int64_t count) {
+        std::unique_lock<std::mutex> l(mutex);
+        return cond.wait_for(l, kResultTimeout,
+                [&] { return completed + failed >= count; });
+    }
+};
+
+void onImageAvailable(void*, AImageReader* reader) {
+    AImage* image = nullptr;
+    if (AImageReader_acquireLatestImage(reader, &image) == AMEDIA_OK) {
+        AImage_delete(image);
+    }
+}
+
+void onDeviceDisconnected(void*, ACameraDevice*) {}
+void onDeviceError(void*, ACameraDevice*, int) {}
+void onSessionState(void*, ACameraCaptureSession*) {}
+
+// Picks the first backward compatible camera and the AE target fps range whose
+// upper bound is closest to, but not above, |targetFps|.
+bool findCamera(ACameraManager* manager, int32_t targetFps, std::string* cameraId,
+        int32_t fpsRange[2]) {
+    ACameraIdList* idList = nullptr;
+    if (ACameraManager_getCameraIdList(manager, &idList) != ACAMERA_OK) {
+        return false;
+    }
+    bool found = false;
+    for (int i = 0; i < idList->numCameras && !found; i++) {
+        ACameraMetadata* chars = nullptr;
+        if (ACameraManager_getCameraCharacteristics(manager, idList->cameraIds[i], &chars)
+                != ACAMERA_OK) {
+            continue;
+        }
+        ACameraMetadata_const_entry caps = {};
+        ACameraMetadata_getConstEntry(chars, ACAMERA_REQUEST_AVAILABLE_CAPABILITIES, &caps);
+        bool backwardCompatible = false;
+        for (uint32_t c = 0; c < caps.count; c++) {
+            backwardCompatible |= caps.data.u8[c] ==
+                    ACAMERA_REQUEST_AVAILABLE_CAPABILITIES_BACKWARD_COMPATIBLE;
+        }
+        ACameraMetadata_const_entry ranges = {};
+        ACameraMetadata_getConstEntry(chars, ACAMERA_CONTROL_AE_AVAILABLE_TARGET_FPS_RANGES,
+                &ranges);
+        if (backwardCompatible) {
+            for (uint32_t r = 0; r + 1 < ranges.count; r += 2) {
+                int32_t upper = ranges.data.i32[r + 1];
+                if (upper <= targetFps && (!found || upper > fpsRange[1] ||
+                        (upper == fpsRange[1] && ranges.data.i32[r] > fpsRange[0]))) {
+                    fpsRange[0] = ranges.data.i32[r];
+                    fpsRange[1] = upper;
+                    *cameraId = idList->cameraIds[i];
+                    found = true;
+                }
+            }
+        }
+        ACameraMetadata_free(chars);
+    }
+    ACameraManager_deleteCameraIdList(idList);
+    return found;
+}
+
+// Streams a repeating request into a small image reader and measures how many
+// capture results per second reach the app. The argument is the requested frame
+// rate; devices that can't stream that fast use their highest supported rate.
+void BM_NdkRepeatingResultDelivery(benchmark::State& state) {
+    const int32_t targetFps = static_cast<int32_t>(state.range(0));
+    ACameraManager* manager = ACameraManager_create();
+    std::string cameraId;
+    int32_t fpsRange[2] = {};
+    if (!findCamera(manager, targetFps, &cameraId, fpsRange)) {
+        ACameraManager_delete(manager);
+        state.SkipWithError("no backward compatible camera");
+        return;
+    }
+
+    ACameraDevice* device = nullptr;
+    ACameraDevice_StateCallbacks deviceCb = {nullptr, onDeviceDisconnected, onDeviceError};
+    AImageReader* reader = nullptr;
+    ANativeWindow* window = nullptr;
+    ACaptureSessionOutputContainer* outputs = nullptr;
+    ACaptureSessionOutput* output = nullptr;
+    ACameraCaptureSession* session = nullptr;
+    ACameraCaptureSession_stateCallbacks sessionCb = {nullptr, onSessionState,
+            onSessionState, onSessionState};
+    ACaptureRequest* request = nullptr;
+    ACameraOutputTarget* target = nullptr;
+    ResultCounter counter;
+    AImageReader_ImageListener listener = {nullptr, onImageAvailable};
+    ACameraCaptureSession_captureCallbacks captureCb = {};
+    captureCb.context = &counter;
+    captureCb.onCaptureCompleted = ResultCounter::onCompleted;
+    captureCb.onCaptureFailed = ResultCounter::onFailed;
+
+    bool ok = ACameraManager_openCamera(manager, cameraId.c_str(), &deviceCb, &device)
+                    == ACAMERA_OK &&
+            AImageReader_new(kWidth, kHeight, AIMAGE_FORMAT_YUV_420_888, kMaxImages, &reader)
+                    == AMEDIA_OK &&
+            AImageReader_setImageListener(reader, &listener) == AMEDIA_OK &&
+            AImageReader_getWindow(reader, &window) == AMEDIA_OK &&
+            ACaptureSessionOutputContainer_create(&outputs) == ACAMERA_OK &&
+            ACaptureSessionOutput_create(window, &output) == ACAMERA_OK &&
+            ACaptureSessionOutputContainer_add(outputs, output) == ACAMERA_OK &&
+            ACameraDevice_createCaptureSession(device, outputs, &sessionCb, &session)
+                    == ACAMERA_OK &&
+            ACameraDevice_createCaptureRequest(device, TEMPLATE_PREVIEW, &request)
+                    == ACAMERA_OK &&
+            ACameraOutputTarget_create(window, &target) == ACAMERA_OK &&
+            ACaptureRequest_addTarget(request, target) == ACAMERA_OK &&
+            ACaptureRequest_setEntry_i32(request, ACAMERA_CONTROL_AE_TARGET_FPS_RANGE, 2,
+                    fpsRange) == ACAMERA_OK &&
+            ACameraCaptureSession_setRepeatingRequest(session, &captureCb, 1, &request,
+                    nullptr) == ACAMERA_OK;
+
+    if (!ok) {
+        state.SkipWithError("failed to start repeating request");
+    } else if (!counter.waitFor(kMaxImages)) {
+        // Let the pipeline fill before timing
+        state.SkipWithError("timed out waiting for first results");
+    } else {
+        int64_t start = 0;
+        {
+            std::lock_guard<std::mutex> l(counter.mutex);
+            start = counter.completed + counter.failed;
+        }
+        int64_t expected = start;
+        for (auto _ : state) {
+            // One second worth of results per iteration
+            expected += fpsRange[1];
+            if (!counter.waitFor(expected)) {
+                state.SkipWithError("timed out waiting for results");
+                break;
+            }
+        }
+        std::lock_guard<std::mutex> l(counter.mutex);
+        state.counters["results"] = benchmark::Counter(
+                static_cast<double>(counter.completed + counter.failed - start),
+                benchmark::Counter::kIsRate);
+        state.counters["failed"] = static_cast<double>(counter.failed);
+        state.SetLabel("camera " + cameraId + " @ [" + std::to_string(fpsRange[0]) + ", " +
+                std::to_string(fpsRange[1]) + "] fps");
+    }
+
+    if (session != nullptr) {
+        ACameraCaptureSession_stopRepeating(session);
+        ACameraCaptureSession_close(session);
+    }
+    if (target != nullptr) ACameraOutputTarget_free(target);
+    if (request != nullptr) ACaptureRequest_free(request);
+    if (output != nullptr) ACaptureSessionOutput_free(output);
+    if (outputs != nullptr) ACaptureSessionOutputContainer_free(outputs);
+    if (device != nullptr) ACameraDevice_close(device);
+    if (reader != nullptr) AImageReader_delete(reader);
+    ACameraManager_delete(manager);
+}
+BENCHMARK(BM_NdkRepeatingResultDelivery)->Arg(30)->Arg(60)->Arg(240)
+        ->Unit(benchmark::kMillisecond)->UseRealTime()->Iterations(5);
+
+} // namespace
+
+BENCHMARK_MAIN();
@@ -0,0 +1,212 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <inttypes.h>
+
+#define LOG_TAG "ScreenRecord"
+#define ATRACE_TAG ATRACE_TAG_GRAPHICS
+//#define LOG_NDEBUG 0
+#include <utils/Log.h>
+
+#include <media/MediaCodecBuffer.h>
+#include <media/NdkMediaFormatPriv.h>
+#include <media/stagefright/foundation/ADebug.h>
+#include <media/stagefright/foundation/AMessage.h>
+#include <utils/SystemClock.h>
+#include <utils/Timers.h>
+#include <utils/Trace.h>
+
+#include "StreamEncoder.h"
+
+using namespace android;
+
+static const char* kMimeTypeApplicationOctetstream = "application/octet-stream";
+
+StreamEncoder::StreamEncoder(const char* name, AMediaMuxer* muxer, FILE* rawFp,
+        bool winscopeTracks, FILE* timestampFp) :
+        mName(name),
+        mMuxer(muxer),
+        mRawFp(rawFp),
+        mWinscopeTracks(winscopeTracks),
+        mTimestampFp(timestampFp),
+        mTrackIdx(-1),
+        mMetaLegacyTrackIdx(-1),
+        mMetaTrackIdx(-1),
+        mNumFrames(0),
+        mEos(false),
+        mStatus(NO_ERROR) {
+    CHECK((rawFp == NULL && muxer != NULL) || (rawFp != NULL && muxer == NULL));
+}
+
+sp<AMessage> StreamEncoder::getCallback() {
+    return new AMessage(kWhatEncoderActivity, this);
+}
+
+status_t StreamEncoder::waitForEos(int64_t timeoutUsec) {
+    Mutex::Autolock _l(mMutex);
+    nsecs_t deadlineNsec = systemTime(SYSTEM_TIME_MONOTONIC) + timeoutUsec * 1000;
+    while (!mEos) {
+        nsecs_t remainingNsec = deadlineNsec - systemTime(SYSTEM_TIME_MONOTONIC);
+        if (remainingNsec <= 0) {
+            return ETIMEDOUT;
+        }
+        mEosCond.waitRelative(mMutex, remainingNsec);
+    }
+    return mStatus;
+}
+
+void StreamEncoder::signalEos(status_t err) {
+    Mutex::Autolock _l(mMutex);
+    if (!mEos) {
+        mEos = true;
+        mStatus = err;
+        mEosCond.broadcast();
+    }
+}
+
+void StreamEncoder::onMessageReceived(const sp<AMessage>& msg) {
+    CHECK_EQ(msg->what(), kWhatEncoderActivity);
+
+    int32_t cbID;
+    CHECK(msg->findInt32("callbackID", &cbID));
+    status_t err = NO_ERROR;
+    switch (cbID) {
+    case MediaCodec::CB_INPUT_AVAILABLE:
+        // Input comes from the virtual display surface.
+        break;
+    case MediaCodec::CB_OUTPUT_FORMAT_CHANGED:
+        err = onFormatChanged();
+        break;
+    case MediaCodec::CB_OUTPUT_AVAILABLE:
+        err = onOutputAvailable(msg);
+        break;
+    case MediaCodec::CB_ERROR:
+        CHECK(msg->findInt32("err", &err));
+        fprintf(stderr, "Encoder (%s) reported error %d\n", mName, err);
+        break;
+    default:
+        ALOGV("Ignoring callback %d from %s encoder", cbID, mName);
+        break;
+    }
+    if (err != NO_ERROR) {
+        signalEos(err);
+    }
+}
+
+status_t StreamEncoder::onFormatChanged() {
+    // Format includes CSD, which we must provide to muxer.
+    ALOGV("Encoder (%s) format changed", mName);
+    if (mMuxer == NULL) {
+        return NO_ERROR;
+    }
+
+    sp<AMessage> newFormat;
+    status_t err = mEncoder->getOutputFormat(&newFormat);
+    if (err != NO_ERROR) {
+        return err;
+    }
+    AMediaFormat *ndkFormat = AMediaFormat_fromMsg(&newFormat);
+    mTrackIdx = AMediaMuxer_addTrack(mMuxer, ndkFormat);
+    if (mWinscopeTracks) {
+        AMediaFormat *metaFormat = AMediaFormat_new();
+        AMediaFormat_setString(metaFormat, AMEDIAFORMAT_KEY_MIME,
+                kMimeTypeApplicationOctetstream);
+        mMetaLegacyTrackIdx = AMediaMuxer_addTrack(mMuxer, metaFormat);
+        mMetaTrackIdx = AMediaMuxer_addTrack(mMuxer, metaFormat);
+        AMediaFormat_delete(metaFormat);
+    }
+    ALOGV("Starting %s muxer", mName);
+    err = AMediaMuxer_start(mMuxer);
+    if (err != NO_ERROR) {
+        fprintf(stderr, "Unable to start %s muxer (err=%d)\n", mName, err);
+    }
+    return err;
+}
+
+status_t StreamEncoder::onOutputAvailable(const sp<AMessage>& msg) {
+    int32_t index;
+    size_t size;
+    int64_t ptsUsec;
+    int32_t flags;
+    CHECK(msg->findInt32("index", &index));
+    CHECK(msg->findSize("size", &size));
+    CHECK(msg->findInt64("timeUs", &ptsUsec));
+    CHECK(msg->findInt32("flags", &flags));
+
+    if ((flags & MediaCodec::BUFFER_FLAG_CODECCONFIG) != 0 && mMuxer != NULL) {
+        // ignore this -- we passed the CSD into MediaMuxer when
+        // we got the format change notification
+        size = 0;
+    }
+
+    status_t err = NO_ERROR;
+    if (size != 0) {
+        sp<MediaCodecBuffer> buffer;
+        err = mEncoder->getOutputBuffer(index, &buffer);
+        if (err != NO_ERROR || buffer == NULL) {
+            fprintf(stderr, "Unable to get %s output buffer (err=%d)\n", mName, err);
+            return err != NO_ERROR ? err : UNKNOWN_ERROR;
+        }
+
+        // If the virtual display isn't providing us with timestamps,
+        // use the current time.
+        if (ptsUsec == 0) {
+            ptsUsec = systemTime(SYSTEM_TIME_MONOTONIC) / 1000;
+        }
+
+        if (mMuxer == NULL) {
+            fwrite(buffer->data(), 1, size, mRawFp);
+            if ((flags & MediaCodec::BUFFER_FLAG_CODECCONFIG) == 0) {
+                fflush(mRawFp);
+            }
+        } else {
+            ATRACE_NAME("write sample");
+            AMediaCodecBufferInfo bufferInfo = {
+                0 /* offset */,
+                static_cast<int32_t>(size),
+                ptsUsec /* presentationTimeUs */,
+                static_cast<uint32_t>(flags)
+            };
+            err = AMediaMuxer_writeSampleData(mMuxer, mTrackIdx, buffer->data(), &bufferInfo);
+            if (err != NO_ERROR) {
+                fprintf(stderr, "Failed writing %s data to muxer (err=%d)\n", mName, err);
+                return err;
+            }
+            if (mWinscopeTracks) {
+                mTimestampsMonotonicUs.add(ptsUsec);
+            }
+        }
+
+        if (mTimestampFp != NULL && (flags & MediaCodec::BUFFER_FLAG_CODECCONFIG) == 0) {
+            // One call per line so that streams sharing the file don't interleave.
+            fprintf(mTimestampFp, "%s %" PRId64 " %" PRId64 " %zu %d\n",
+                    mName, ptsUsec, elapsedRealtimeNano(), size,
+                    (flags & MediaCodec::BUFFER_FLAG_SYNCFRAME) != 0);
+        }
+        mNumFrames++;
+    }
+
+    err = mEncoder->releaseOutputBuffer(index);
+    if (err != NO_ERROR) {
+        fprintf(stderr, "Unable to release %s output buffer (err=%d)\n", mName, err);
+        return err;
+    }
+    if ((flags & MediaCodec::BUFFER_FLAG_EOS) != 0) {
+        ALOGI("Received end-of-stream from %s encoder", mName);
+        signalEos(NO_ERROR);
+    }
+    return NO_ERROR;
+}
@@ -0,0 +1,102 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SCREENRECORD_STREAMENCODER_H
+#define SCREENRECORD_STREAMENCODER_H
+
+#include <media/NdkMediaMuxer.h>
+#include <media/stagefright/MediaCodec.h>
+#include <media/stagefright/foundation/AHandler.h>
+#include <utils/Condition.h>
+#include <utils/Mutex.h>
+#include <utils/Vector.h>
+
+#include <stdio.h>
+
+namespace android {
+
+/*
+ * Drains one encoder in asynchronous mode.  Output buffers are delivered
+ * by MediaCodec callbacks on the looper this handler is registered with,
+ * so several streams can be written in parallel without polling.
+ *
+ * Exactly one of muxer or rawFp must be non-null.  The muxer must *not*
+ * have been started; that happens once the encoder reports its format.
+ */
+class StreamEncoder : public AHandler {
+public:
+    StreamEncoder(const char* name, AMediaMuxer* muxer, FILE* rawFp,
+            bool winscopeTracks, FILE* timestampFp);
+
+    // Returns the message to hand to MediaCodec::setCallback() before the
+    // encoder is started.  The handler must be registered with a looper.
+    sp<AMessage> getCallback();
+
+    // Sets the encoder whose callbacks this handler receives.
+    void setEncoder(const sp<MediaCodec>& encoder) { mEncoder = encoder; }
+
+    // Waits up to the specified number of microseconds for the end of the
+    // stream.  Returns ETIMEDOUT if the stream is still running, otherwise
+    // the final status of the stream.
+    status_t waitForEos(int64_t timeoutUsec);
+
+    // The following are only valid once waitForEos() has returned.
+    uint32_t getNumFrames() const { return mNumFrames; }
+    const Vector<int64_t>& getTimestamps() const { return mTimestampsMonotonicUs; }
+    ssize_t getMetaLegacyTrackIdx() const { return mMetaLegacyTrackIdx; }
+    ssize_t getMetaTrackIdx() const { return mMetaTrackIdx; }
+
+protected:
+    virtual ~StreamEncoder() {}
+
+    // (overrides AHandler method)
+    virtual void onMessageReceived(const sp<AMessage>& msg);
+
+private:
+    enum {
+        kWhatEncoderActivity = 'encA',
+    };
+
+    StreamEncoder(const StreamEncoder&);
+    StreamEncoder& operator=(const StreamEncoder&);
+
+    status_t onFormatChanged();
+    status_t onOutputAvailable(const sp<AMessage>& msg);
+    void signalEos(status_t err);
+
+    const char* mName;
+    AMediaMuxer* mMuxer;
+    FILE* mRawFp;
+    bool mWinscopeTracks;
+    FILE* mTimestampFp;
+    sp<MediaCodec> mEncoder;
+
+    ssize_t mTrackIdx;
+    ssize_t mMetaLegacyTrackIdx;
+    ssize_t mMetaTrackIdx;
+    uint32_t mNumFrames;
+    Vector<int64_t> mTimestampsMonotonicUs;
+
+    // Guards the end-of-stream state, which is set on the looper thread.
+    Mutex mMutex;
+    Condition mEosCond;
+    bool mEos;
+    status_t mStatus;
+};
+
+}; // namespace android
+
+#endif /*SCREENRECORD_STREAMENCODER_H*/
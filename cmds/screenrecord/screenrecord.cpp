@@ -70,6 +70,7 @@
 #include "screenrecord.h"
 #include "Overlay.h"
 #include "FrameOutput.h"
+#include "StreamEncoder.h"
 
 using android::ABuffer;
 using android::ALooper;
@@ -95,6 +96,7 @@ using android::SurfaceComposerClient;
 using android::Vector;
 using android::sp;
 using android::status_t;
+using android::StreamEncoder;
 using android::SurfaceControl;
 
 using android::INVALID_OPERATION;
@@ -129,6 +131,9 @@ static uint32_t gVideoHeight = 0;
 static uint32_t gBitRate = 20000000;     // 20Mbps
 static uint32_t gTimeLimitSec = kMaxTimeLimitSec;
 static uint32_t gBframes = 0;
+static uint32_t gSecondaryWidth = 0;    // reduced-resolution stream, 0 if none
+static uint32_t gSecondaryHeight = 0;
+static const char* gFrameTimestampsFile = NULL; // per-frame timestamp export
 static std::optional<PhysicalDisplayId> gPhysicalDisplayId;
 // Set by signal handler to stop recording.
 static volatile bool gStopRequested = false;
@@ -188,23 +193,27 @@ static status_t configureSignals() {
 /*
  * Configures and starts the MediaCodec encoder.  Obtains an input surface
  * from the codec.
+ *
+ * If callback is non-null the codec runs in asynchronous mode and reports
+ * its output through that message.
  */
-static status_t prepareEncoder(float displayFps, sp<MediaCodec>* pCodec,
+static status_t prepareEncoder(float displayFps, uint32_t videoWidth, uint32_t videoHeight,
+        uint32_t bitRate, const sp<AMessage>& callback, sp<MediaCodec>* pCodec,
         sp<IGraphicBufferProducer>* pBufferProducer) {
     status_t err;
 
     if (gVerbose) {
         printf("Configuring recorder for %dx%d %s at %.2fMbps\n",
-                gVideoWidth, gVideoHeight, kMimeTypeAvc, gBitRate / 1000000.0);
+                videoWidth, videoHeight, kMimeTypeAvc, bitRate / 1000000.0);
         fflush(stdout);
     }
 
     sp<AMessage> format = new AMessage;
-    format->setInt32(KEY_WIDTH, gVideoWidth);
-    format->setInt32(KEY_HEIGHT, gVideoHeight);
+    format->setInt32(KEY_WIDTH, videoWidth);
+    format->setInt32(KEY_HEIGHT, videoHeight);
     format->setString(KEY_MIME, kMimeTypeAvc);
     format->setInt32(KEY_COLOR_FORMAT, OMX_COLOR_FormatAndroidOpaque);
-    format->setInt32(KEY_BIT_RATE, gBitRate);
+    format->setInt32(KEY_BIT_RATE, bitRate);
     format->setInt32(KEY_I_FRAME_INTERVAL, 10);
     format->setInt32(KEY_MAX_B_FRAMES, gBframes);
     if (gBframes > 0) {
@@ -241,8 +250,8 @@ static status_t prepareEncoder(float displayFps, sp<MediaCodec>* pCodec,
     sp<MediaCodecInfo> info = mcl->getCodecInfo(codecIdx);
     sp<MediaCodecInfo::Capabilities> capabilities = info->getCapabilitiesFor(kMimeTypeAvc);
     const sp<AMessage> &details = capabilities->getDetails();
-    std::string perfPointKey = "performance-point-" + std::to_string(gVideoWidth) + "x" +
-       std::to_string(gVideoHeight) + "-range";
+    std::string perfPointKey = "performance-point-" + std::to_string(videoWidth) + "x" +
+       std::to_string(videoHeight) + "-range";
     AString minPerfPoint, maxPerfPoint;
     AString perfPoint;
     if (details->findString(perfPointKey.c_str(), &perfPoint)
@@ -254,11 +263,20 @@ static status_t prepareEncoder(float displayFps, sp<MediaCodec>* pCodec,
     }
     format->setFloat(KEY_FRAME_RATE, displayFps);
 
+    if (callback != NULL) {
+        err = codec->setCallback(callback);
+        if (err != NO_ERROR) {
+            fprintf(stderr, "ERROR: unable to set codec callback (err=%d)\n", err);
+            codec->release();
+            return err;
+        }
+    }
+
     err = codec->configure(format, NULL, NULL,
             MediaCodec::CONFIGURE_FLAG_ENCODE);
     if (err != NO_ERROR) {
         fprintf(stderr, "ERROR: unable to configure %s codec at %dx%d (err=%d)\n",
-                kMimeTypeAvc, gVideoWidth, gVideoHeight, err);
+                kMimeTypeAvc, videoWidth, videoHeight, err);
         codec->release();
         return err;
     }
@@ -302,7 +320,8 @@ static status_t prepareEncoder(float displayFps, sp<MediaCodec>* pCodec,
 static status_t setDisplayProjection(
         SurfaceComposerClient::Transaction& t,
         const sp<IBinder>& dpy,
-        const ui::DisplayState& displayState) {
+        const ui::DisplayState& displayState,
+        uint32_t streamWidth, uint32_t streamHeight) {
     // Set the region of the layer stack we're interested in, which in our case is "all of it".
     Rect layerStackRect(displayState.layerStackSpaceRect);
 
@@ -324,11 +343,11 @@ static status_t setDisplayProjection(
     uint32_t videoWidth, videoHeight;
     uint32_t outWidth, outHeight;
     if (!gRotate) {
-        videoWidth = gVideoWidth;
-        videoHeight = gVideoHeight;
+        videoWidth = streamWidth;
+        videoHeight = streamHeight;
     } else {
-        videoWidth = gVideoHeight;
-        videoHeight = gVideoWidth;
+        videoWidth = streamHeight;
+        videoHeight = streamWidth;
     }
     if (videoHeight > (uint32_t)(videoWidth * displayAspect)) {
         // limited by narrow width; reduce height
@@ -387,12 +406,13 @@ static status_t getPhysicalDisplayId(PhysicalDisplayId& outDisplayId) {
 static status_t prepareVirtualDisplay(
         const ui::DisplayState& displayState,
         const sp<IGraphicBufferProducer>& bufferProducer,
-        sp<IBinder>* pDisplayHandle, sp<SurfaceControl>* mirrorRoot) {
+        sp<IBinder>* pDisplayHandle, sp<SurfaceControl>* mirrorRoot,
+        ui::LayerStack* pLayerStack) {
     sp<IBinder> dpy = SurfaceComposerClient::createDisplay(
             String8("ScreenRecorder"), false /*secure*/);
     SurfaceComposerClient::Transaction t;
     t.setDisplaySurface(dpy, bufferProducer);
-    setDisplayProjection(t, dpy, displayState);
+    setDisplayProjection(t, dpy, displayState, gVideoWidth, gVideoHeight);
     ui::LayerStack layerStack = ui::LayerStack::fromValue(std::rand());
     t.setDisplayLayerStack(dpy, layerStack);
     PhysicalDisplayId displayId;
@@ -408,6 +428,28 @@ static status_t prepareVirtualDisplay(
     t.setLayerStack(*mirrorRoot, layerStack);
     t.apply();
 
+    *pDisplayHandle = dpy;
+    *pLayerStack = layerStack;
+
+    return NO_ERROR;
+}
+
+/*
+ * Configures a second virtual display showing the same mirrored layer stack
+ * as the primary one, composed at the secondary stream's size.
+ */
+static status_t prepareSecondaryVirtualDisplay(
+        const ui::DisplayState& displayState,
+        const sp<IGraphicBufferProducer>& bufferProducer,
+        ui::LayerStack layerStack, sp<IBinder>* pDisplayHandle) {
+    sp<IBinder> dpy = SurfaceComposerClient::createDisplay(
+            String8("ScreenRecorderSecondary"), false /*secure*/);
+    SurfaceComposerClient::Transaction t;
+    t.setDisplaySurface(dpy, bufferProducer);
+    setDisplayProjection(t, dpy, displayState, gSecondaryWidth, gSecondaryHeight);
+    t.setDisplayLayerStack(dpy, layerStack);
+    t.apply();
+
     *pDisplayHandle = dpy;
 
     return NO_ERROR;
@@ -538,7 +580,8 @@ static status_t writeWinscopeMetadata(const Vector<std::int64_t>& timestampsMono
 /*
  * Update the display projection if size or orientation have changed.
  */
-void updateDisplayProjection(const sp<IBinder>& virtualDpy, ui::DisplayState& displayState) {
+void updateDisplayProjection(const sp<IBinder>& virtualDpy, ui::DisplayState& displayState,
+        const sp<IBinder>& secondaryDpy = nullptr) {
     ATRACE_NAME("updateDisplayProjection");
 
     PhysicalDisplayId displayId;
@@ -567,7 +610,11 @@ void updateDisplayProjection(const sp<IBinder>& virtualDpy, ui::DisplayState& di
               displayState.layerStackSpaceRect.getHeight());
 
         SurfaceComposerClient::Transaction t;
-        setDisplayProjection(t, virtualDpy, currentDisplayState);
+        setDisplayProjection(t, virtualDpy, currentDisplayState, gVideoWidth, gVideoHeight);
+        if (secondaryDpy != nullptr) {
+            setDisplayProjection(t, secondaryDpy, currentDisplayState,
+                    gSecondaryWidth, gSecondaryHeight);
+        }
         t.apply();
     }
 }
@@ -773,6 +820,102 @@ static status_t runEncoder(const sp<MediaCodec>& encoder, AMediaMuxer* muxer, FI
     return NO_ERROR;
 }
 
+/*
+ * Runs one or two encoders in asynchronous mode.  Each StreamEncoder writes
+ * its own output from its looper as buffers arrive, so this thread only
+ * watches for the stop request, the time limit, and display changes.
+ *
+ * The secondary encoder, stream and display may be null.
+ */
+static status_t runStreamEncoders(const sp<MediaCodec>& encoder,
+        const sp<StreamEncoder>& stream, AMediaMuxer* muxer,
+        const sp<MediaCodec>& secondaryEncoder, const sp<StreamEncoder>& secondaryStream,
+        const sp<IBinder>& virtualDpy, const sp<IBinder>& secondaryDpy,
+        ui::DisplayState displayState) {
+    static const int64_t kPollUsec = 100000;
+    static const int64_t kDrainTimeoutUsec = 2000000;
+    status_t err = NO_ERROR;
+    int64_t startWhenNsec = systemTime(CLOCK_MONOTONIC);
+    int64_t endWhenNsec = startWhenNsec + seconds_to_nanoseconds(gTimeLimitSec);
+
+    while (!gStopRequested) {
+        if (systemTime(CLOCK_MONOTONIC) > endWhenNsec) {
+            if (gVerbose) {
+                printf("Time limit reached\n");
+                fflush(stdout);
+            }
+            break;
+        }
+
+        err = stream->waitForEos(kPollUsec);
+        if (err == ETIMEDOUT && secondaryStream != NULL) {
+            err = secondaryStream->waitForEos(0);
+        }
+        if (err != ETIMEDOUT) {
+            // Not expecting EOS from SurfaceFlinger; stop both streams on
+            // either EOS or an error.
+            break;
+        }
+        err = NO_ERROR;
+
+        updateDisplayProjection(virtualDpy, displayState, secondaryDpy);
+    }
+
+    ALOGV("Encoders stopping (req=%d)", gStopRequested);
+    encoder->signalEndOfInputStream();
+    if (secondaryEncoder != NULL) {
+        secondaryEncoder->signalEndOfInputStream();
+    }
+
+    status_t drainErr = stream->waitForEos(kDrainTimeoutUsec);
+    bool drained = drainErr != ETIMEDOUT;
+    if (secondaryStream != NULL) {
+        status_t secondaryErr = secondaryStream->waitForEos(kDrainTimeoutUsec);
+        if (secondaryErr == ETIMEDOUT) {
+            fprintf(stderr, "Timed out draining secondary encoder\n");
+            secondaryEncoder->stop();
+        } else if (drainErr == NO_ERROR) {
+            drainErr = secondaryErr;
+        }
+    }
+    if (!drained) {
+        fprintf(stderr, "Timed out draining encoder\n");
+        // Stop callbacks before the muxer is stopped under them.
+        encoder->stop();
+    } else if (err == NO_ERROR) {
+        err = drainErr;
+    }
+
+    if (gVerbose) {
+        printf("Encoder stopping; recorded %u frames", stream->getNumFrames());
+        if (secondaryStream != NULL) {
+            printf(" (%u secondary)", secondaryStream->getNumFrames());
+        }
+        printf(" in %" PRId64 " seconds\n", nanoseconds_to_seconds(
+                systemTime(CLOCK_MONOTONIC) - startWhenNsec));
+        fflush(stdout);
+    }
+
+    const Vector<int64_t>& timestampsMonotonicUs = stream->getTimestamps();
+    if (drained && stream->getMetaLegacyTrackIdx() >= 0 && stream->getMetaTrackIdx() >= 0
+            && !timestampsMonotonicUs.isEmpty()) {
+        status_t metaErr = writeWinscopeMetadataLegacy(timestampsMonotonicUs,
+                stream->getMetaLegacyTrackIdx(), muxer);
+        if (metaErr != NO_ERROR) {
+            fprintf(stderr, "Failed writing legacy winscope metadata to muxer (err=%d)\n",
+                    metaErr);
+            return metaErr;
+        }
+
+        metaErr = writeWinscopeMetadata(timestampsMonotonicUs, stream->getMetaTrackIdx(), muxer);
+        if (metaErr != NO_ERROR) {
+            fprintf(stderr, "Failed writing winscope metadata to muxer (err=%d)\n", metaErr);
+            return metaErr;
+        }
+    }
+    return err;
+}
+
 /*
  * Raw H.264 byte stream output requested.  Send the output to stdout
  * if desired.  If the output is a tty, reconfigure it to avoid the
@@ -811,6 +954,49 @@ static FILE* prepareRawOutput(const char* fileName) {
     return rawFp;
 }
 
+/*
+ * Creates a muxer for the MP4, WebM or 3GPP output formats, replacing any
+ * existing file.
+ */
+static AMediaMuxer* prepareMuxer(const char* fileName) {
+    int err = unlink(fileName);
+    if (err != 0 && errno != ENOENT) {
+        fprintf(stderr, "ERROR: couldn't remove existing file\n");
+        abort();
+    }
+    int fd = open(fileName, O_CREAT | O_LARGEFILE | O_TRUNC | O_RDWR, S_IRUSR | S_IWUSR);
+    if (fd < 0) {
+        fprintf(stderr, "ERROR: couldn't open file\n");
+        abort();
+    }
+    AMediaMuxer* muxer;
+    if (gOutputFormat == FORMAT_MP4) {
+        muxer = AMediaMuxer_new(fd, AMEDIAMUXER_OUTPUT_FORMAT_MPEG_4);
+    } else if (gOutputFormat == FORMAT_WEBM) {
+        muxer = AMediaMuxer_new(fd, AMEDIAMUXER_OUTPUT_FORMAT_WEBM);
+    } else {
+        muxer = AMediaMuxer_new(fd, AMEDIAMUXER_OUTPUT_FORMAT_THREE_GPP);
+    }
+    close(fd);
+    if (gRotate) {
+        AMediaMuxer_setOrientationHint(muxer, 90); // TODO: does this do anything?
+    }
+    return muxer;
+}
+
+/*
+ * Derives the secondary stream's file name by inserting "-secondary" ahead
+ * of the extension, e.g. "/sdcard/ui.mp4" becomes "/sdcard/ui-secondary.mp4".
+ */
+static String8 getSecondaryFileName(const char* fileName) {
+    const char* slash = strrchr(fileName, '/');
+    const char* dot = strrchr(fileName, '.');
+    if (dot == NULL || (slash != NULL && dot < slash)) {
+        return String8::format("%s-secondary", fileName);
+    }
+    return String8::format("%.*s-secondary%s", (int) (dot - fileName), fileName, dot);
+}
+
 static inline uint32_t floorToEven(uint32_t num) {
     return num & ~1;
 }
@@ -822,13 +1008,25 @@ struct RecordingData {
 
     sp<Overlay> overlay;
 
+    // Asynchronous encoding only; the secondary members are set when a
+    // reduced-resolution stream is recorded alongside the primary one.
+    sp<ALooper> outputLooper;
+    sp<MediaCodec> secondaryEncoder;
+    sp<IBinder> secondaryDpy;
+    sp<ALooper> secondaryOutputLooper;
+
     ~RecordingData() {
         if (dpy != nullptr) SurfaceComposerClient::destroyDisplay(dpy);
+        if (secondaryDpy != nullptr) SurfaceComposerClient::destroyDisplay(secondaryDpy);
         if (overlay != nullptr) overlay->stop();
         if (encoder != nullptr) {
             encoder->stop();
             encoder->release();
         }
+        if (secondaryEncoder != nullptr) {
+            secondaryEncoder->stop();
+            secondaryEncoder->release();
+        }
     }
 };
 
@@ -933,12 +1131,84 @@ static status_t recordScreen(const char* fileName) {
         gVideoHeight = floorToEven(layerStackSpaceRect.getHeight());
     }
 
+    const bool asyncEncoding = gSecondaryWidth != 0 || gFrameTimestampsFile != NULL;
+
+    // Prepare the output first: in asynchronous mode the encoders write to
+    // it from their own threads as soon as frames arrive.
+    AMediaMuxer *muxer = nullptr;
+    FILE* rawFp = NULL;
+    switch (gOutputFormat) {
+        case FORMAT_MP4:
+        case FORMAT_WEBM:
+        case FORMAT_3GPP: {
+            // Configure muxer.  We have to wait for the CSD blob from the encoder
+            // before we can start it.
+            muxer = prepareMuxer(fileName);
+            break;
+        }
+        case FORMAT_H264:
+        case FORMAT_FRAMES:
+        case FORMAT_RAW_FRAMES: {
+            rawFp = prepareRawOutput(fileName);
+            if (rawFp == NULL) {
+                return -1;
+            }
+            break;
+        }
+        default:
+            fprintf(stderr, "ERROR: unknown format %d\n", gOutputFormat);
+            abort();
+    }
+
+    AMediaMuxer *secondaryMuxer = nullptr;
+    FILE* secondaryRawFp = NULL;
+    if (gSecondaryWidth != 0) {
+        String8 secondaryFileName = getSecondaryFileName(fileName);
+        if (muxer != NULL) {
+            secondaryMuxer = prepareMuxer(secondaryFileName.c_str());
+        } else {
+            secondaryRawFp = prepareRawOutput(secondaryFileName.c_str());
+            if (secondaryRawFp == NULL) {
+                return -1;
+            }
+        }
+        if (gVerbose) {
+            printf("Secondary stream goes to %s\n", secondaryFileName.c_str());
+            fflush(stdout);
+        }
+    }
+
+    FILE* timestampFp = NULL;
+    if (gFrameTimestampsFile != NULL) {
+        timestampFp = fopen(gFrameTimestampsFile, "w");
+        if (timestampFp == NULL) {
+            fprintf(stderr, "fopen timestamps failed: %s\n", strerror(errno));
+            return -1;
+        }
+        fprintf(timestampFp, "# stream pts_us elapsed_realtime_ns bytes sync\n");
+    }
+
     RecordingData recordingData = RecordingData();
     // Configure and start the encoder.
     sp<FrameOutput> frameOutput;
     sp<IGraphicBufferProducer> encoderInputSurface;
+    sp<StreamEncoder> stream;
+    sp<StreamEncoder> secondaryStream;
+    sp<IGraphicBufferProducer> secondaryInputSurface;
     if (gOutputFormat != FORMAT_FRAMES && gOutputFormat != FORMAT_RAW_FRAMES) {
-        err = prepareEncoder(displayMode.refreshRate, &recordingData.encoder, &encoderInputSurface);
+        sp<AMessage> callback;
+        if (asyncEncoding) {
+            recordingData.outputLooper = new ALooper;
+            recordingData.outputLooper->setName("screenrecord_output");
+            recordingData.outputLooper->start();
+            stream = new StreamEncoder("primary", muxer, rawFp,
+                    gOutputFormat == FORMAT_MP4 /*winscopeTracks*/, timestampFp);
+            recordingData.outputLooper->registerHandler(stream);
+            callback = stream->getCallback();
+        }
+
+        err = prepareEncoder(displayMode.refreshRate, gVideoWidth, gVideoHeight, gBitRate,
+                callback, &recordingData.encoder, &encoderInputSurface);
 
         if (err != NO_ERROR && !gSizeSpecified) {
             // fallback is defined for landscape; swap if we're in portrait
@@ -951,8 +1221,8 @@ static status_t recordScreen(const char* fileName) {
                         gVideoWidth, gVideoHeight, newWidth, newHeight);
                 gVideoWidth = newWidth;
                 gVideoHeight = newHeight;
-                err = prepareEncoder(displayMode.refreshRate, &recordingData.encoder,
-                                      &encoderInputSurface);
+                err = prepareEncoder(displayMode.refreshRate, gVideoWidth, gVideoHeight,
+                        gBitRate, callback, &recordingData.encoder, &encoderInputSurface);
             }
         }
         if (err != NO_ERROR) return err;
@@ -960,6 +1230,30 @@ static status_t recordScreen(const char* fileName) {
         // From here on, we must explicitly release() the encoder before it goes
         // out of scope, or we will get an assertion failure from stagefright
         // later on in a different thread.
+
+        if (stream != NULL) {
+            stream->setEncoder(recordingData.encoder);
+        }
+
+        if (gSecondaryWidth != 0) {
+            // Scale the bit rate with the pixel count.
+            uint64_t secondaryBitRate = (uint64_t) gBitRate * gSecondaryWidth * gSecondaryHeight
+                    / ((uint64_t) gVideoWidth * gVideoHeight);
+            secondaryBitRate = std::max(secondaryBitRate, (uint64_t) kMinBitRate);
+
+            recordingData.secondaryOutputLooper = new ALooper;
+            recordingData.secondaryOutputLooper->setName("screenrecord_output2");
+            recordingData.secondaryOutputLooper->start();
+            secondaryStream = new StreamEncoder("secondary", secondaryMuxer, secondaryRawFp,
+                    false /*winscopeTracks*/, timestampFp);
+            recordingData.secondaryOutputLooper->registerHandler(secondaryStream);
+
+            err = prepareEncoder(displayMode.refreshRate, gSecondaryWidth, gSecondaryHeight,
+                    secondaryBitRate, secondaryStream->getCallback(),
+                    &recordingData.secondaryEncoder, &secondaryInputSurface);
+            if (err != NO_ERROR) return err;
+            secondaryStream->setEncoder(recordingData.secondaryEncoder);
+        }
     } else {
         // We're not using an encoder at all.  The "encoder input surface" we hand to
         // SurfaceFlinger will just feed directly to us.
@@ -999,55 +1293,21 @@ static status_t recordScreen(const char* fileName) {
     // cleaned up by SurfaceFlinger. When the reference is dropped, SurfaceFlinger will delete
     // the resource.
     sp<SurfaceControl> mirrorRoot;
+    ui::LayerStack layerStack;
     // Configure virtual display.
-    err = prepareVirtualDisplay(displayState, bufferProducer, &recordingData.dpy, &mirrorRoot);
+    err = prepareVirtualDisplay(displayState, bufferProducer, &recordingData.dpy, &mirrorRoot,
+            &layerStack);
     if (err != NO_ERROR) {
         return err;
     }
-
-    AMediaMuxer *muxer = nullptr;
-    FILE* rawFp = NULL;
-    switch (gOutputFormat) {
-        case FORMAT_MP4:
-        case FORMAT_WEBM:
-        case FORMAT_3GPP: {
-            // Configure muxer.  We have to wait for the CSD blob from the encoder
-            // before we can start it.
-            err = unlink(fileName);
-            if (err != 0 && errno != ENOENT) {
-                fprintf(stderr, "ERROR: couldn't remove existing file\n");
-                abort();
-            }
-            int fd = open(fileName, O_CREAT | O_LARGEFILE | O_TRUNC | O_RDWR, S_IRUSR | S_IWUSR);
-            if (fd < 0) {
-                fprintf(stderr, "ERROR: couldn't open file\n");
-                abort();
-            }
-            if (gOutputFormat == FORMAT_MP4) {
-                muxer = AMediaMuxer_new(fd, AMEDIAMUXER_OUTPUT_FORMAT_MPEG_4);
-            } else if (gOutputFormat == FORMAT_WEBM) {
-                muxer = AMediaMuxer_new(fd, AMEDIAMUXER_OUTPUT_FORMAT_WEBM);
-            } else {
-                muxer = AMediaMuxer_new(fd, AMEDIAMUXER_OUTPUT_FORMAT_THREE_GPP);
-            }
-            close(fd);
-            if (gRotate) {
-                AMediaMuxer_setOrientationHint(muxer, 90); // TODO: does this do anything?
-            }
-            break;
-        }
-        case FORMAT_H264:
-        case FORMAT_FRAMES:
-        case FORMAT_RAW_FRAMES: {
-            rawFp = prepareRawOutput(fileName);
-            if (rawFp == NULL) {
-                return -1;
-            }
-            break;
+    if (secondaryInputSurface != NULL) {
+        // SurfaceFlinger composes the mirror a second time at the reduced
+        // size, so the secondary stream needs no extra GL pass of its own.
+        err = prepareSecondaryVirtualDisplay(displayState, secondaryInputSurface, layerStack,
+                &recordingData.secondaryDpy);
+        if (err != NO_ERROR) {
+            return err;
         }
-        default:
-            fprintf(stderr, "ERROR: unknown format %d\n", gOutputFormat);
-            abort();
     }
 
     if (gOutputFormat == FORMAT_FRAMES || gOutputFormat == FORMAT_RAW_FRAMES) {
@@ -1081,7 +1341,14 @@ static status_t recordScreen(const char* fileName) {
         }
     } else {
         // Main encoder loop.
-        err = runEncoder(recordingData.encoder, muxer, rawFp, recordingData.dpy, displayState);
+        if (asyncEncoding) {
+            err = runStreamEncoders(recordingData.encoder, stream, muxer,
+                    recordingData.secondaryEncoder, secondaryStream,
+                    recordingData.dpy, recordingData.secondaryDpy, displayState);
+        } else {
+            err = runEncoder(recordingData.encoder, muxer, rawFp, recordingData.dpy,
+                    displayState);
+        }
         if (err != NO_ERROR) {
             fprintf(stderr, "Encoder failed (err=%d)\n", err);
             // fall through to cleanup
@@ -1095,6 +1362,15 @@ static status_t recordScreen(const char* fileName) {
 
     // Shut everything down, starting with the producer side.
     encoderInputSurface = NULL;
+    secondaryInputSurface = NULL;
+    if (secondaryMuxer != NULL) {
+        AMediaMuxer_stop(secondaryMuxer);
+    } else if (secondaryRawFp != NULL) {
+        fclose(secondaryRawFp);
+    }
+    if (timestampFp != NULL) {
+        fclose(timestampFp);
+    }
     if (muxer != NULL) {
         // If we don't stop muxer explicitly, i.e. let the destructor run,
         // it may hang (b/11050628).
@@ -1247,6 +1523,11 @@ static void usage() {
         "--display-id ID\n"
         "    specify the physical display ID to record. Default is the primary display.\n"
         "    see \"dumpsys SurfaceFlinger --display-id\" for valid display IDs.\n"
+        "--secondary-size WIDTHxHEIGHT\n"
+        "    Also record a stream at this size, e.g. \"640x360\", to a second file\n"
+        "    named after the first with a \"-secondary\" suffix.\n"
+        "--frame-timestamps FILE\n"
+        "    Write the presentation and output time of every encoded frame to FILE.\n"
         "--verbose\n"
         "    Display interesting information on stdout.\n"
         "--help\n"
@@ -1279,6 +1560,8 @@ int main(int argc, char* const argv[]) {
         { "persistent-surface", no_argument,        NULL, 'p' },
         { "bframes",            required_argument,  NULL, 'B' },
         { "display-id",         required_argument,  NULL, 'd' },
+        { "secondary-size",     required_argument,  NULL, 'S' },
+        { "frame-timestamps",   required_argument,  NULL, 'T' },
         { NULL,                 0,                  NULL, 0 }
     };
 
@@ -1398,6 +1681,17 @@ int main(int argc, char* const argv[]) {
 
             fprintf(stderr, "Invalid physical display ID\n");
             return 2;
+        case 'S':
+            if (!parseWidthHeight(optarg, &gSecondaryWidth, &gSecondaryHeight)
+                    || gSecondaryWidth == 0 || gSecondaryHeight == 0) {
+                fprintf(stderr, "Invalid secondary size '%s', must be width x height\n",
+                        optarg);
+                return 2;
+            }
+            break;
+        case 'T':
+            gFrameTimestampsFile = optarg;
+            break;
         default:
             if (ic != '?') {
                 fprintf(stderr, "getopt_long returned unexpected value 0x%x\n", ic);
@@ -1412,6 +1706,15 @@ int main(int argc, char* const argv[]) {
     }
 
     const char* fileName = argv[optind];
+    if ((gSecondaryWidth != 0 || gFrameTimestampsFile != NULL)
+            && (gOutputFormat == FORMAT_FRAMES || gOutputFormat == FORMAT_RAW_FRAMES)) {
+        fprintf(stderr, "Secondary streams and frame timestamps need an encoded format\n");
+        return 2;
+    }
+    if (gSecondaryWidth != 0 && strcmp(fileName, "-") == 0) {
+        fprintf(stderr, "Secondary stream can't be written to stdout\n");
+        return 2;
+    }
     if (gOutputFormat == FORMAT_MP4) {
         // MediaMuxer tries to create the file in the constructor, but we don't
         // learn about the failure until muxer.start(), which returns a generic
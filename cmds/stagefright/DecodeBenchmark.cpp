@@ -0,0 +1,473 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "DecodeBenchmark"
+#include <utils/Log.h>
+
+#include <algorithm>
+#include <map>
+#include <vector>
+
+#include "DecodeBenchmark.h"
+
+#include <gui/BufferItemConsumer.h>
+#include <gui/BufferQueue.h>
+#include <gui/Surface.h>
+#include <media/MediaCodecBuffer.h>
+#include <media/stagefright/MediaCodec.h>
+#include <media/stagefright/MediaCodecList.h>
+#include <media/stagefright/NuMediaExtractor.h>
+#include <media/stagefright/foundation/ABuffer.h>
+#include <media/stagefright/foundation/ADebug.h>
+#include <media/stagefright/foundation/AHandler.h>
+#include <media/stagefright/foundation/ALooper.h>
+#include <media/stagefright/foundation/AMessage.h>
+#include <ui/GraphicBuffer.h>
+#include <utils/Condition.h>
+#include <utils/Mutex.h>
+
+namespace android {
+
+namespace {
+
+struct CpuTimes {
+    uint64_t mBusy = 0;
+    uint64_t mTotal = 0;
+};
+
+// Reads the system-wide jiffies from /proc/stat; the codec usually runs in
+// another process, so our own rusage alone would miss most of the work.
+bool readSystemCpuTimes(CpuTimes *times) {
+    FILE *fp = fopen("/proc/stat", "r");
+    if (fp == NULL) {
+        return false;
+    }
+    unsigned long long user, nice, system, idle, iowait, irq, softirq, steal;
+    int n = fscanf(fp, "cpu %llu %llu %llu %llu %llu %llu %llu %llu",
+            &user, &nice, &system, &idle, &iowait, &irq, &softirq, &steal);
+    fclose(fp);
+    if (n != 8) {
+        return false;
+    }
+    times->mTotal = user + nice + system + idle + iowait + irq + softirq + steal;
+    times->mBusy = times->mTotal - idle - iowait;
+    return true;
+}
+
+int64_t getProcessCpuTimeUs() {
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0;
+    }
+    return (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000LL
+            + usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+}
+
+int64_t getPercentile(const std::vector<int64_t> &sorted, int percentile) {
+    size_t index = std::min(sorted.size() - 1, sorted.size() * percentile / 100);
+    return sorted[index];
+}
+
+// Stands in for a display: releases every frame as soon as it is queued.
+struct DrainingConsumer : public BufferItemConsumer::FrameAvailableListener {
+    explicit DrainingConsumer(const sp<BufferItemConsumer> &consumer)
+        : mConsumer(consumer) {
+    }
+
+    void onFrameAvailable(const BufferItem & /* item */) override {
+        sp<BufferItemConsumer> consumer = mConsumer.promote();
+        BufferItem item;
+        if (consumer != NULL && consumer->acquireBuffer(&item, 0) == OK) {
+            consumer->releaseBuffer(item);
+        }
+    }
+
+private:
+    wp<BufferItemConsumer> mConsumer;
+};
+
+// One extractor -> decoder pipeline.  Input is read from the extractor and
+// output released from the codec callbacks, so the extractor and codec
+// overlap instead of alternating as they do in the read() loop.
+struct DecodeSession : public AHandler {
+    DecodeSession(size_t id, const DecodeBenchmarkOptions &options)
+        : mId(id),
+          mOptions(options),
+          mSawInputEOS(false),
+          mNumFramesIn(0),
+          mNumFramesOut(0),
+          mStartTimeUs(0),
+          mEndTimeUs(0),
+          mDone(false),
+          mStatus(OK) {
+    }
+
+    status_t init(const char *filename) {
+        mExtractor = new NuMediaExtractor(NuMediaExtractor::EntryPoint::OTHER);
+        status_t err = mExtractor->setDataSource(NULL /* httpService */, filename);
+        if (err != OK) {
+            fprintf(stderr, "unable to instantiate extractor.\n");
+            return err;
+        }
+
+        sp<AMessage> format;
+        AString mime;
+        size_t i;
+        for (i = 0; i < mExtractor->countTracks(); ++i) {
+            if (mExtractor->getTrackFormat(i, &format) == OK
+                    && format->findString("mime", &mime)
+                    && !strncasecmp(mime.c_str(), mOptions.mAudio ? "audio/" : "video/", 6)) {
+                break;
+            }
+        }
+        if (i == mExtractor->countTracks()) {
+            fprintf(stderr, "No suitable %s track found.\n", mOptions.mAudio ? "audio" : "video");
+            return NAME_NOT_FOUND;
+        }
+        mMime = mime;
+        err = mExtractor->selectTrack(i);
+        if (err != OK) {
+            return err;
+        }
+
+        // MediaCodec blocks its caller until its own looper replies, so it
+        // must not share ours.
+        mCodecLooper = new ALooper;
+        mCodecLooper->setName("decode_bench_codec");
+        mCodecLooper->start();
+
+        Vector<AString> names;
+        if (mOptions.mComponentName != nullptr) {
+            names.push(AString(mOptions.mComponentName));
+        } else {
+            MediaCodecList::findMatchingCodecs(
+                    mime.c_str(), false /* encoder */, mOptions.mCodecFlags, &names);
+        }
+        for (const AString &name : names) {
+            mCodec = MediaCodec::CreateByComponentName(mCodecLooper, name, &err);
+            if (mCodec != NULL) {
+                mCodecName = name;
+                break;
+            }
+        }
+        if (mCodec == NULL) {
+            fprintf(stderr, "unable to create a decoder for %s.\n", mime.c_str());
+            return err != OK ? err : NAME_NOT_FOUND;
+        }
+
+        if (mOptions.mUseSurface && !mOptions.mAudio) {
+            sp<IGraphicBufferProducer> producer;
+            sp<IGraphicBufferConsumer> consumer;
+            BufferQueue::createBufferQueue(&producer, &consumer);
+            mConsumer = new BufferItemConsumer(consumer, GraphicBuffer::USAGE_HW_TEXTURE);
+            mConsumer->setName(String8::format("DecodeBenchmark-%zu", mId));
+            mDrainingConsumer = new DrainingConsumer(mConsumer);
+            mConsumer->setFrameAvailableListener(mDrainingConsumer);
+            mSurface = new Surface(producer);
+        }
+
+        err = mCodec->setCallback(new AMessage(kWhatCodecNotify, this));
+        if (err != OK) {
+            return err;
+        }
+        return mCodec->configure(format, mSurface, NULL /* crypto */, 0 /* flags */);
+    }
+
+    status_t start() {
+        mStartTimeUs = ALooper::GetNowUs();
+        return mCodec->start();
+    }
+
+    status_t waitForCompletion() {
+        Mutex::Autolock autoLock(mLock);
+        while (!mDone) {
+            mCondition.wait(mLock);
+        }
+        return mStatus;
+    }
+
+    void release() {
+        if (mCodec != NULL) {
+            mCodec->release();
+            mCodec.clear();
+        }
+        if (mCodecLooper != NULL) {
+            mCodecLooper->stop();
+        }
+    }
+
+    // The following are only valid once waitForCompletion() has returned.
+    const AString &getCodecName() const { return mCodecName; }
+    const AString &getMime() const { return mMime; }
+    int64_t getNumFramesOut() const { return mNumFramesOut; }
+    int64_t getDurationUs() const { return mEndTimeUs - mStartTimeUs; }
+    const std::vector<int64_t> &getLatenciesUs() const { return mLatenciesUs; }
+
+protected:
+    virtual ~DecodeSession() {}
+
+    virtual void onMessageReceived(const sp<AMessage> &msg) {
+        CHECK_EQ(msg->what(), (uint32_t)kWhatCodecNotify);
+
+        int32_t cbID;
+        CHECK(msg->findInt32("callbackID", &cbID));
+        status_t err = OK;
+        switch (cbID) {
+            case MediaCodec::CB_INPUT_AVAILABLE:
+            {
+                int32_t index;
+                CHECK(msg->findInt32("index", &index));
+                err = onInputAvailable(index);
+                break;
+            }
+            case MediaCodec::CB_OUTPUT_AVAILABLE:
+                err = onOutputAvailable(msg);
+                break;
+            case MediaCodec::CB_ERROR:
+                CHECK(msg->findInt32("err", &err));
+                fprintf(stderr, "session %zu: decoder reported error %d\n", mId, err);
+                break;
+            default:
+                break;
+        }
+        if (err != OK) {
+            finish(err);
+        }
+    }
+
+private:
+    enum {
+        kWhatCodecNotify = 'cdcN',
+    };
+
+    status_t onInputAvailable(int32_t index) {
+        if (mSawInputEOS) {
+            return OK;
+        }
+
+        size_t trackIndex;
+        if (mExtractor->getSampleTrackIndex(&trackIndex) != OK
+                || (mOptions.mMaxNumFrames > 0 && mNumFramesIn >= mOptions.mMaxNumFrames)) {
+            mSawInputEOS = true;
+            return mCodec->queueInputBuffer(
+                    index, 0 /* offset */, 0 /* size */, 0ll /* timeUs */,
+                    MediaCodec::BUFFER_FLAG_EOS);
+        }
+
+        sp<MediaCodecBuffer> buffer;
+        status_t err = mCodec->getInputBuffer(index, &buffer);
+        if (err != OK) {
+            return err;
+        }
+        sp<ABuffer> abuffer = new ABuffer(buffer->base(), buffer->capacity());
+        err = mExtractor->readSampleData(abuffer);
+        if (err != OK) {
+            return err;
+        }
+        buffer->setRange(abuffer->offset(), abuffer->size());
+
+        int64_t timeUs;
+        CHECK_EQ(mExtractor->getSampleTime(&timeUs), (status_t)OK);
+        mQueueTimesUs[timeUs] = ALooper::GetNowUs();
+
+        err = mCodec->queueInputBuffer(
+                index, buffer->offset(), buffer->size(), timeUs, 0 /* flags */);
+        if (err != OK) {
+            return err;
+        }
+        mExtractor->advance();
+        ++mNumFramesIn;
+        return OK;
+    }
+
+    status_t onOutputAvailable(const sp<AMessage> &msg) {
+        int32_t index;
+        size_t size;
+        int64_t timeUs;
+        int32_t flags;
+        CHECK(msg->findInt32("index", &index));
+        CHECK(msg->findSize("size", &size));
+        CHECK(msg->findInt64("timeUs", &timeUs));
+        CHECK(msg->findInt32("flags", &flags));
+
+        if (size > 0) {
+            // Audio decoders may split or merge access units; only frames
+            // whose timestamp matches an input contribute a latency sample.
+            auto it = mQueueTimesUs.find(timeUs);
+            if (it != mQueueTimesUs.end()) {
+                mLatenciesUs.push_back(ALooper::GetNowUs() - it->second);
+                mQueueTimesUs.erase(it);
+            }
+            ++mNumFramesOut;
+        }
+
+        status_t err;
+        if (mSurface != NULL && size > 0) {
+            err = mCodec->renderOutputBufferAndRelease(index);
+        } else {
+            err = mCodec->releaseOutputBuffer(index);
+        }
+        if (err != OK) {
+            return err;
+        }
+        if (flags & MediaCodec::BUFFER_FLAG_EOS) {
+            finish(OK);
+        }
+        return OK;
+    }
+
+    void finish(status_t err) {
+        Mutex::Autolock autoLock(mLock);
+        if (mDone) {
+            return;
+        }
+        mEndTimeUs = ALooper::GetNowUs();
+        mDone = true;
+        mStatus = err;
+        mCondition.signal();
+    }
+
+    const size_t mId;
+    const DecodeBenchmarkOptions mOptions;
+
+    sp<NuMediaExtractor> mExtractor;
+    sp<ALooper> mCodecLooper;
+    sp<MediaCodec> mCodec;
+    AString mCodecName;
+    AString mMime;
+
+    sp<BufferItemConsumer> mConsumer;
+    sp<DrainingConsumer> mDrainingConsumer;
+    sp<Surface> mSurface;
+
+    // Only touched on our looper.
+    bool mSawInputEOS;
+    int64_t mNumFramesIn;
+    int64_t mNumFramesOut;
+    std::map<int64_t, int64_t> mQueueTimesUs;
+    std::vector<int64_t> mLatenciesUs;
+    int64_t mStartTimeUs;
+    int64_t mEndTimeUs;
+
+    Mutex mLock;
+    Condition mCondition;
+    bool mDone;
+    status_t mStatus;
+
+    DISALLOW_EVIL_CONSTRUCTORS(DecodeSession);
+};
+
+void printLatencies(const char *prefix, std::vector<int64_t> *latenciesUs) {
+    if (latenciesUs->empty()) {
+        printf("%slatency: no samples\n", prefix);
+        return;
+    }
+    std::sort(latenciesUs->begin(), latenciesUs->end());
+    printf("%slatency p50 %.2f ms, p90 %.2f ms, p99 %.2f ms, max %.2f ms\n", prefix,
+            getPercentile(*latenciesUs, 50) / 1E3, getPercentile(*latenciesUs, 90) / 1E3,
+            getPercentile(*latenciesUs, 99) / 1E3, latenciesUs->back() / 1E3);
+}
+
+}  // namespace
+
+status_t runDecodeBenchmark(const char *filename, const DecodeBenchmarkOptions &options) {
+    std::vector<sp<ALooper>> loopers;
+    std::vector<sp<DecodeSession>> sessions;
+    status_t err = OK;
+
+    for (size_t i = 0; i < options.mNumSessions && err == OK; ++i) {
+        sp<ALooper> looper = new ALooper;
+        looper->setName("decode_bench");
+        looper->start();
+        sp<DecodeSession> session = new DecodeSession(i, options);
+        looper->registerHandler(session);
+        loopers.push_back(looper);
+        sessions.push_back(session);
+        err = session->init(filename);
+    }
+
+    CpuTimes startCpu, endCpu;
+    bool haveSystemCpu = readSystemCpuTimes(&startCpu);
+    int64_t startProcessCpuUs = getProcessCpuTimeUs();
+    int64_t startTimeUs = ALooper::GetNowUs();
+
+    for (size_t i = 0; i < sessions.size() && err == OK; ++i) {
+        err = sessions[i]->start();
+    }
+
+    std::vector<int64_t> allLatenciesUs;
+    int64_t totalFrames = 0;
+    if (err == OK) {
+        for (size_t i = 0; i < sessions.size(); ++i) {
+            status_t sessionErr = sessions[i]->waitForCompletion();
+            if (sessionErr != OK && err == OK) {
+                err = sessionErr;
+            }
+        }
+    }
+
+    int64_t wallTimeUs = ALooper::GetNowUs() - startTimeUs;
+    int64_t processCpuUs = getProcessCpuTimeUs() - startProcessCpuUs;
+    haveSystemCpu = haveSystemCpu && readSystemCpuTimes(&endCpu);
+
+    for (const sp<DecodeSession> &session : sessions) {
+        session->release();
+    }
+    for (const sp<ALooper> &looper : loopers) {
+        looper->stop();
+    }
+    if (err != OK) {
+        fprintf(stderr, "decode benchmark failed: %d\n", err);
+        return err;
+    }
+
+    printf("%s: %zu session(s), %s, %s\n", filename, sessions.size(),
+            sessions[0]->getMime().c_str(), sessions[0]->getCodecName().c_str());
+    for (size_t i = 0; i < sessions.size(); ++i) {
+        const sp<DecodeSession> &session = sessions[i];
+        std::vector<int64_t> latenciesUs = session->getLatenciesUs();
+        int64_t durationUs = session->getDurationUs();
+        printf("session %zu: %" PRId64 " frames in %.2f secs (%.2f fps)\n",
+                i, session->getNumFramesOut(), durationUs / 1E6,
+                durationUs > 0 ? session->getNumFramesOut() * 1E6 / durationUs : 0.);
+        printLatencies("    ", &latenciesUs);
+
+        totalFrames += session->getNumFramesOut();
+        allLatenciesUs.insert(allLatenciesUs.end(), latenciesUs.begin(), latenciesUs.end());
+    }
+
+    printf("total: %" PRId64 " frames in %.2f secs (%.2f fps)\n",
+            totalFrames, wallTimeUs / 1E6, wallTimeUs > 0 ? totalFrames * 1E6 / wallTimeUs : 0.);
+    printLatencies("total: ", &allLatenciesUs);
+
+    printf("cpu: this process %.1f%% of one core",
+            wallTimeUs > 0 ? processCpuUs * 100. / wallTimeUs : 0.);
+    if (haveSystemCpu && endCpu.mTotal > startCpu.mTotal) {
+        printf(", system %.1f%% of %ld cores",
+                (endCpu.mBusy - startCpu.mBusy) * 100. / (endCpu.mTotal - startCpu.mTotal),
+                sysconf(_SC_NPROCESSORS_ONLN));
+    }
+    printf("\n");
+    return OK;
+}
+
+}  // namespace android
@@ -0,0 +1,41 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef DECODE_BENCHMARK_H_
+
+#define DECODE_BENCHMARK_H_
+
+#include <utils/Errors.h>
+
+namespace android {
+
+struct DecodeBenchmarkOptions {
+    size_t mNumSessions = 1;
+    bool mAudio = false;            // decode the first audio track instead of video
+    bool mUseSurface = false;       // render video output to a per-session surface
+    long mMaxNumFrames = 0;         // 0 means decode all available
+    uint32_t mCodecFlags = 0;       // MediaCodecList::k* flags
+    const char *mComponentName = nullptr;
+};
+
+// Decodes |filename| with |mNumSessions| concurrent extractor -> MediaCodec
+// pipelines, each driven by asynchronous codec callbacks, and prints the
+// throughput, per-frame latency percentiles and CPU utilization.
+status_t runDecodeBenchmark(const char *filename, const DecodeBenchmarkOptions &options);
+
+}  // namespace android
+
+#endif // DECODE_BENCHMARK_H_
@@ -67,6 +67,7 @@
 #include <android/hardware/media/omx/1.0/IOmx.h>
 
 #include "AudioPlayer.h"
+#include "DecodeBenchmark.h"
 
 using namespace android;
 
@@ -652,6 +653,9 @@ static void usage(const char *me) {
     fprintf(stderr, "       -d(ump) output_filename (raw stream data to a file)\n");
     fprintf(stderr, "       -D(ump) output_filename (decoded PCM data to a file)\n");
     fprintf(stderr, "       -v be more verbose\n");
+    fprintf(stderr, "       -p N benchmark decoding with N concurrent asynchronous\n"
+                    "          sessions; reports fps, latency percentiles and cpu load\n"
+                    "          (honors -a, -m, -s, -r, -N and -S/-T for surface output)\n");
 }
 
 static void dumpCodecDetails(bool queryDecoders) {
@@ -796,6 +800,7 @@ int main(int argc, char **argv) {
     bool dumpStream = false;
     bool dumpPCMStream = false;
     int32_t pixelFormat = 0;        // thumbnail pixel format
+    long benchmarkSessions = 0;     // 0 means no decode benchmark
     String8 dumpStreamFilename;
     gNumRepetitions = 1;
     gMaxNumFrames = 0;
@@ -809,7 +814,7 @@ int main(int argc, char **argv) {
     sp<android::ALooper> looper;
 
     int res;
-    while ((res = getopt(argc, argv, "vhaqn:lm:b:itsrow:kN:xSTd:D:P:")) >= 0) {
+    while ((res = getopt(argc, argv, "vhaqn:lm:b:itsrow:kN:xSTd:D:P:p:")) >= 0) {
         switch (res) {
             case 'a':
             {
@@ -851,6 +856,7 @@ int main(int argc, char **argv) {
             }
 
             case 'P':
+            case 'p':
             case 'm':
             case 'n':
             case 'b':
@@ -868,6 +874,8 @@ int main(int argc, char **argv) {
                     gMaxNumFrames = x;
                 } else if (res == 'P') {
                     pixelFormat = x;
+                } else if (res == 'p') {
+                    benchmarkSessions = x;
                 } else {
                     CHECK_EQ(res, 'b');
                     gReproduceBug = x;
@@ -1098,6 +1106,29 @@ int main(int argc, char **argv) {
         CHECK(transStatus.isOk());
     }
 
+    if (benchmarkSessions > 0) {
+        DecodeBenchmarkOptions options;
+        options.mNumSessions = benchmarkSessions;
+        options.mAudio = audioOnly;
+        options.mUseSurface = useSurfaceAlloc || useSurfaceTexAlloc;
+        options.mMaxNumFrames = gMaxNumFrames;
+        if (gPreferSoftwareCodec) {
+            options.mCodecFlags |= MediaCodecList::kPreferSoftwareCodecs;
+        }
+        if (gForceToUseHardwareCodec) {
+            options.mCodecFlags |= MediaCodecList::kHardwareCodecsOnly;
+        }
+        if (!gComponentNameOverride.isEmpty()) {
+            options.mComponentName = gComponentNameOverride.c_str();
+        }
+
+        status_t err = OK;
+        for (int k = 0; k < argc && err == OK; ++k) {
+            err = runDecodeBenchmark(argv[k], options);
+        }
+        return err == OK ? 0 : 1;
+    }
+
     sp<SurfaceComposerClient> composerClient;
     sp<SurfaceControl> control;
 
@@ -31,10 +31,8 @@
 using ::aidl::android::hardware::drm::CryptoSchemes;
 using DestinationBufferAidl = ::aidl::android::hardware::drm::DestinationBuffer;
 using ::aidl::android::hardware::drm::Mode;
-using ::aidl::android::hardware::drm::Pattern;
 using SharedBufferAidl = ::aidl::android::hardware::drm::SharedBuffer;
 using ::aidl::android::hardware::drm::Status;
-using ::aidl::android::hardware::drm::SubSample;
 using ::aidl::android::hardware::drm::Uuid;
 using ::aidl::android::hardware::drm::SecurityLevel;
 using NativeHandleAidlCommon = ::aidl::android::hardware::common::NativeHandle;
@@ -75,12 +73,13 @@ static std::vector<Byte> toStdVec(const Vector<uint8_t>& vector) {
 status_t CryptoHalAidl::checkSharedBuffer(const SharedBufferHidl& buffer) {
     int32_t seqNum = static_cast<int32_t>(buffer.bufferId);
     // memory must be in one of the heaps that have been set
-    if (mHeapSizes.indexOfKey(seqNum) < 0) {
+    ssize_t index = mHeapSizes.indexOfKey(seqNum);
+    if (index < 0) {
         return UNKNOWN_ERROR;
     }
 
     // memory must be within the address space of the heap
-    size_t heapSize = mHeapSizes.valueFor(seqNum);
+    size_t heapSize = mHeapSizes.valueAt(index);
     if (heapSize < buffer.offset + buffer.size || SIZE_MAX - buffer.offset < buffer.size) {
         android_errorWriteLog(0x534e4554, "76221123");
         return UNKNOWN_ERROR;
@@ -300,18 +299,6 @@ ssize_t CryptoHalAidl::decrypt(const uint8_t keyId[16], const uint8_t iv[16],
             return UNKNOWN_ERROR;
     }
 
-    Pattern aPattern;
-    aPattern.encryptBlocks = pattern.mEncryptBlocks;
-    aPattern.skipBlocks = pattern.mSkipBlocks;
-
-    std::vector<SubSample> stdSubSamples;
-    for (size_t i = 0; i < numSubSamples; i++) {
-        SubSample subSample;
-        subSample.numBytesOfClearData = subSamples[i].mNumBytesOfClearData;
-        subSample.numBytesOfEncryptedData = subSamples[i].mNumBytesOfEncryptedData;
-        stdSubSamples.push_back(subSample);
-    }
-
     bool secure;
     if (hDestination.type == BufferTypeHidl::SHARED_MEMORY) {
         status_t status = checkSharedBuffer(hDestination.nonsecureMemory);
@@ -334,16 +321,19 @@ ssize_t CryptoHalAidl::decrypt(const uint8_t keyId[16], const uint8_t iv[16],
     status_t err = UNKNOWN_ERROR;
     mLock.unlock();
 
-    std::vector<uint8_t> keyIdAidl(toStdVec(keyId, 16));
-    std::vector<uint8_t> ivAidl(toStdVec(iv, 16));
-
+    // The rest of the conversion doesn't need mLock.
     DecryptArgs args;
     args.secure = secure;
-    args.keyId = keyIdAidl;
-    args.iv = ivAidl;
+    args.keyId = toStdVec(keyId, 16);
+    args.iv = toStdVec(iv, 16);
     args.mode = aMode;
-    args.pattern = aPattern;
-    args.subSamples = std::move(stdSubSamples);
+    args.pattern.encryptBlocks = pattern.mEncryptBlocks;
+    args.pattern.skipBlocks = pattern.mSkipBlocks;
+    args.subSamples.resize(numSubSamples);
+    for (size_t i = 0; i < numSubSamples; i++) {
+        args.subSamples[i].numBytesOfClearData = subSamples[i].mNumBytesOfClearData;
+        args.subSamples[i].numBytesOfEncryptedData = subSamples[i].mNumBytesOfEncryptedData;
+    }
     args.source = hidlSharedBufferToAidlSharedBuffer(hSource);
     args.offset = offset;
     args.destination = hidlDestinationBufferToAidlDestinationBuffer(hDestination);
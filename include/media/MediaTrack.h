@@ -127,6 +127,16 @@ struct MediaTrack
     virtual status_t read(
             MediaBufferBase **buffer, const ReadOptions *options = NULL) = 0;
 
+    // Same as read(), but the track may read the sample straight into data, e.g. the
+    // input buffer of a codec, saving a copy. In that case (*buffer)->data() is data,
+    // which must remain valid until the buffer is released. Otherwise the sample is
+    // returned in a buffer of the track, as by read().
+    virtual status_t readInto(
+            void * /* data */, size_t /* size */,
+            MediaBufferBase **buffer, const ReadOptions *options = NULL) {
+        return read(buffer, options);
+    }
+
     // Returns true if |read| supports nonblocking option, otherwise false.
     // |readMultiple| if supported, always allows the nonblocking option.
     virtual bool supportNonblockingRead() {
@@ -148,6 +158,8 @@ public:
     virtual status_t stop();
     virtual status_t getFormat(MetaDataBase& format);
     virtual status_t read(MediaBufferBase **buffer, const ReadOptions *options = NULL);
+    virtual status_t readInto(void *data, size_t size,
+            MediaBufferBase **buffer, const ReadOptions *options = NULL);
 
     virtual bool supportNonblockingRead();
 
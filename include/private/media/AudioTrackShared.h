@@ -20,6 +20,8 @@
 #include <stdint.h>
 #include <sys/types.h>
 
+#include <atomic>
+
 #include <audio_utils/minifloat.h>
 #include <utils/threads.h>
 #include <utils/Log.h>
@@ -415,12 +417,27 @@ public:
         if (timestamp == nullptr) {
             return BAD_VALUE;
         }
-        (void) mTimestampObserver.poll(mTimestamp);
+        if (mTimestampObserver.poll(mTimestamp)) {
+            mTimestampCleared.store(false, std::memory_order_release);
+        }
         *timestamp = mTimestamp;
         return OK;
     }
 
+    // Lock-free read of the timestamp last published by the server, for use by any thread
+    // concurrently with the proxy owner.  Returns false if the track is invalid, if there is
+    // no valid timestamp since the last clearTimestamp(), or if the server was busy publishing;
+    // the caller should then use getTimestamp() with the proxy owner's synchronization.
+    bool        peekTimestamp(ExtendedTimestamp *timestamp) const {
+        if ((android_atomic_acquire_load(&mCblk->mFlags) & CBLK_INVALID) != 0
+                || mTimestampCleared.load(std::memory_order_acquire)) {
+            return false;
+        }
+        return mTimestampObserver.peek(*timestamp);
+    }
+
     void        clearTimestamp() {
+        mTimestampCleared.store(true, std::memory_order_release);
         mTimestamp.clear();
     }
 
@@ -437,6 +454,9 @@ private:
     // is initialized by the client constructor.
     ExtendedTimestampQueue::Observer mTimestampObserver;
     ExtendedTimestamp mTimestamp; // initialized by constructor
+    // true until getTimestamp() has observed a server push after construction or
+    // clearTimestamp(), so that peekTimestamp() does not return a stale timestamp.
+    std::atomic<bool> mTimestampCleared{true};
 };
 
 // ----------------------------------------------------------------------------
@@ -18,7 +18,7 @@
 
 #include <algorithm>
 #include <map>
-#include <sstream>
+#include <string>
 #include <utility>
 #include <vector>
 
@@ -100,12 +100,18 @@ using media::audio::common::PcmType;
 
 namespace {
 
+// Same result as reading with std::getline(), without the cost of a stream: a trailing
+// separator does not produce an empty string.
 std::vector<std::string> splitString(const std::string& s, char separator) {
-    std::istringstream iss(s);
-    std::string t;
     std::vector<std::string> result;
-    while (std::getline(iss, t, separator)) {
-        result.push_back(std::move(t));
+    size_t start = 0;
+    while (start < s.size()) {
+        size_t end = s.find(separator, start);
+        if (end == std::string::npos) {
+            end = s.size();
+        }
+        result.emplace_back(s, start, end - start);
+        start = end + 1;
     }
     return result;
 }
@@ -1936,21 +1942,21 @@ legacy2aidl_audio_flags_mask_t_int32_t_mask(audio_flags_mask_t legacy) {
 
 ConversionResult<std::string>
 aidl2legacy_AudioTags_string(const std::vector<std::string>& aidl) {
-    std::ostringstream tagsBuffer;
+    std::string tags;
     bool hasValue = false;
     for (const auto& tag : aidl) {
         if (hasValue) {
-            tagsBuffer << AUDIO_ATTRIBUTES_TAGS_SEPARATOR;
+            tags += AUDIO_ATTRIBUTES_TAGS_SEPARATOR;
         }
         if (strchr(tag.c_str(), AUDIO_ATTRIBUTES_TAGS_SEPARATOR) == nullptr) {
-            tagsBuffer << tag;
+            tags += tag;
             hasValue = true;
         } else {
             ALOGE("Tag is ill-formed: \"%s\"", tag.c_str());
             return unexpected(BAD_VALUE);
         }
     }
-    return tagsBuffer.str();
+    return tags;
 }
 
 ConversionResult<std::vector<std::string>>
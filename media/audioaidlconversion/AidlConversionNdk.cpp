@@ -14,7 +14,7 @@
  * limitations under the License.
  */
 
-#include <sstream>
+#include <string>
 #include <utility>
 
 #include <system/audio.h>
@@ -42,29 +42,35 @@ namespace {
 
 ::android::status_t combineString(
         const std::vector<std::string>& v, char separator, std::string* result) {
-    std::ostringstream oss;
+    std::string combined;
     for (const auto& s : v) {
-        if (oss.tellp() > 0) {
-            oss << separator;
+        if (!combined.empty()) {
+            combined += separator;
         }
         if (s.find(separator) == std::string::npos) {
-            oss << s;
+            combined += s;
         } else {
             ALOGE("%s: string \"%s\" contains separator character \"%c\"",
                     __func__, s.c_str(), separator);
             return BAD_VALUE;
         }
     }
-    *result = oss.str();
+    *result = std::move(combined);
     return OK;
 }
 
+// Same result as reading with std::getline(), without the cost of a stream: a trailing
+// separator does not produce an empty string.
 std::vector<std::string> splitString(const std::string& s, char separator) {
-    std::istringstream iss(s);
-    std::string t;
     std::vector<std::string> result;
-    while (std::getline(iss, t, separator)) {
-        result.push_back(std::move(t));
+    size_t start = 0;
+    while (start < s.size()) {
+        size_t end = s.find(separator, start);
+        if (end == std::string::npos) {
+            end = s.size();
+        }
+        result.emplace_back(s, start, end - start);
+        start = end + 1;
     }
     return result;
 }
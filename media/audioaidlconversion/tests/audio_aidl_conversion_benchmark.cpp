@@ -0,0 +1,106 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Per call cost of the conversions done on every createTrack, getOutputForAttr and
+// routing callback. Each benchmark converts from legacy to AIDL and back.
+
+#include <string.h>
+#include <string>
+
+#include <benchmark/benchmark.h>
+
+#include <media/AidlConversionCppNdk.h>
+#include <media/AidlConversionNdk.h>
+
+using namespace aidl::android;   // for conversion functions
+
+static void BM_AudioConfig(benchmark::State& state) {
+    audio_config_t legacy = AUDIO_CONFIG_INITIALIZER;
+    legacy.sample_rate = 48000;
+    legacy.channel_mask = AUDIO_CHANNEL_OUT_STEREO;
+    legacy.format = AUDIO_FORMAT_PCM_FLOAT;
+    for (auto _ : state) {
+        auto aidl = legacy2aidl_audio_config_t_AudioConfig(legacy, false /*isInput*/);
+        auto back = aidl2legacy_AudioConfig_audio_config_t(aidl.value(), false /*isInput*/);
+        benchmark::DoNotOptimize(back);
+    }
+}
+
+static void BM_ChannelMask(benchmark::State& state) {
+    const audio_channel_mask_t legacy = static_cast<audio_channel_mask_t>(state.range(0));
+    for (auto _ : state) {
+        auto aidl = legacy2aidl_audio_channel_mask_t_AudioChannelLayout(legacy, false);
+        auto back = aidl2legacy_AudioChannelLayout_audio_channel_mask_t(aidl.value(), false);
+        benchmark::DoNotOptimize(back);
+    }
+}
+
+static void BM_AudioAttributes(benchmark::State& state) {
+    audio_attributes_t legacy = AUDIO_ATTRIBUTES_INITIALIZER;
+    legacy.usage = AUDIO_USAGE_MEDIA;
+    legacy.content_type = AUDIO_CONTENT_TYPE_MUSIC;
+    if (state.range(0) != 0) {
+        strncpy(legacy.tags, "VX_GOOGLE_41;VX_GOOGLE_42", sizeof(legacy.tags) - 1);
+    }
+    for (auto _ : state) {
+        auto aidl = legacy2aidl_audio_attributes_t_AudioAttributes(legacy);
+        auto back = aidl2legacy_AudioAttributes_audio_attributes_t(aidl.value());
+        benchmark::DoNotOptimize(back);
+    }
+}
+
+static void BM_AudioDevice(benchmark::State& state) {
+    const audio_devices_t type = static_cast<audio_devices_t>(state.range(0));
+    const std::string address = audio_is_bluetooth_out_sco_device(type)
+            || audio_is_a2dp_out_device(type) ? "00:11:22:33:44:55" : "";
+    for (auto _ : state) {
+        auto aidl = legacy2aidl_audio_device_AudioDevice(type, address);
+        audio_devices_t backType;
+        std::string backAddress;
+        benchmark::DoNotOptimize(
+                aidl2legacy_AudioDevice_audio_device(aidl.value(), &backType, &backAddress));
+    }
+}
+
+static void BM_PlaybackTrackMetadata(benchmark::State& state) {
+    playback_track_metadata_v7 legacy{};
+    legacy.base.usage = AUDIO_USAGE_MEDIA;
+    legacy.base.content_type = AUDIO_CONTENT_TYPE_MUSIC;
+    legacy.base.gain = 1.0f;
+    legacy.channel_mask = AUDIO_CHANNEL_OUT_STEREO;
+    if (state.range(0) != 0) {
+        strncpy(legacy.tags, "VX_GOOGLE_41;VX_GOOGLE_42", sizeof(legacy.tags) - 1);
+    }
+    for (auto _ : state) {
+        auto aidl = legacy2aidl_playback_track_metadata_v7_PlaybackTrackMetadata(legacy);
+        auto back = aidl2legacy_PlaybackTrackMetadata_playback_track_metadata_v7(aidl.value());
+        benchmark::DoNotOptimize(back);
+    }
+}
+
+BENCHMARK(BM_AudioConfig);
+BENCHMARK(BM_ChannelMask)
+        ->Arg(AUDIO_CHANNEL_OUT_STEREO)
+        ->Arg(AUDIO_CHANNEL_OUT_7POINT1)
+        // Not a predefined layout, converted bit by bit.
+        ->Arg(AUDIO_CHANNEL_OUT_FRONT_LEFT | AUDIO_CHANNEL_OUT_LOW_FREQUENCY);
+BENCHMARK(BM_AudioAttributes)->Arg(0)->Arg(1);
+BENCHMARK(BM_AudioDevice)
+        ->Arg(AUDIO_DEVICE_OUT_SPEAKER)
+        ->Arg(AUDIO_DEVICE_OUT_BLUETOOTH_A2DP);
+BENCHMARK(BM_PlaybackTrackMetadata)->Arg(0)->Arg(1);
+
+BENCHMARK_MAIN();
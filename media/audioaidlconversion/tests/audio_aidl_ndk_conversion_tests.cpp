@@ -135,3 +135,19 @@ TEST(AudioTags, IllFormedAidlTag) {
         }
     }
 }
+
+TEST(AudioTags, SplitLegacyTags) {
+    const std::string separator(1, AUDIO_ATTRIBUTES_TAGS_SEPARATOR);
+    {
+        auto conv = legacy2aidl_string_AudioTags("");
+        ASSERT_TRUE(conv.ok());
+        EXPECT_TRUE(conv.value().empty());
+    }
+    {
+        // A trailing separator does not add an empty tag, an inner one does.
+        auto conv = legacy2aidl_string_AudioTags(
+                "VX_GOOGLE_41" + separator + separator + "VX_GOOGLE_42" + separator);
+        ASSERT_TRUE(conv.ok());
+        EXPECT_EQ((std::vector<std::string>{"VX_GOOGLE_41", "", "VX_GOOGLE_42"}), conv.value());
+    }
+}
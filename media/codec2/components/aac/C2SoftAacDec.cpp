@@ -18,6 +18,7 @@
 #define LOG_TAG "C2SoftAacDec"
 #include <log/log.h>
 
+#include <algorithm>
 #include <inttypes.h>
 #include <math.h>
 #include <numeric>
@@ -392,6 +393,10 @@ status_t C2SoftAacDec::initDecoder() {
     ALOGV("AAC decoder using maximum output channel count %d", maxChannelCount);
     aacDecoder_SetParam(mAACDecoder, AAC_PCM_MAX_OUTPUT_CHANNELS, maxChannelCount);
 
+    mDrcEffectType = effectType;
+    mDrcAlbumMode = albumMode;
+    mMaxOutputChannelCount = maxChannelCount;
+
     return status;
 }
 
@@ -403,30 +408,45 @@ bool C2SoftAacDec::outputDelayRingBufferPutSamples(INT_PCM *samples, int32_t num
         ALOGE("RING BUFFER WOULD OVERFLOW");
         return false;
     }
-    if (mOutputDelayRingBufferWritePos + numSamples <= mOutputDelayRingBufferSize
-            && (mOutputDelayRingBufferReadPos <= mOutputDelayRingBufferWritePos
-                    || mOutputDelayRingBufferReadPos > mOutputDelayRingBufferWritePos + numSamples)) {
-        // faster memcopy loop without checks, if the preconditions allow this
-        for (int32_t i = 0; i < numSamples; i++) {
-            mOutputDelayRingBuffer[mOutputDelayRingBufferWritePos++] = samples[i];
-        }
+    if (samples == &mOutputDelayRingBuffer[mOutputDelayRingBufferWritePos]) {
+        // decoded in place
+        outputDelayRingBufferCommitSamples(numSamples);
+        return true;
+    }
+    // copy in at most two segments, the second one wrapping around to the start
+    int32_t firstSamples = std::min(
+            numSamples, mOutputDelayRingBufferSize - mOutputDelayRingBufferWritePos);
+    memcpy(&mOutputDelayRingBuffer[mOutputDelayRingBufferWritePos], samples,
+           firstSamples * sizeof(INT_PCM));
+    memcpy(&mOutputDelayRingBuffer[0], samples + firstSamples,
+           (numSamples - firstSamples) * sizeof(INT_PCM));
+    outputDelayRingBufferCommitSamples(numSamples);
+    return true;
+}
 
-        if (mOutputDelayRingBufferWritePos >= mOutputDelayRingBufferSize) {
-            mOutputDelayRingBufferWritePos -= mOutputDelayRingBufferSize;
-        }
+INT_PCM *C2SoftAacDec::outputDelayRingBufferWritePtr(int32_t numSamples) {
+    // the space past the write position is contiguous up to the read position, or the end of
+    // the ring buffer if the read position is behind the write position
+    int32_t contiguous;
+    if (mOutputDelayRingBufferFilled == mOutputDelayRingBufferSize) {
+        contiguous = 0;
+    } else if (mOutputDelayRingBufferReadPos > mOutputDelayRingBufferWritePos) {
+        contiguous = mOutputDelayRingBufferReadPos - mOutputDelayRingBufferWritePos;
     } else {
-        ALOGV("slow C2SoftAacDec::outputDelayRingBufferPutSamples()");
+        contiguous = mOutputDelayRingBufferSize - mOutputDelayRingBufferWritePos;
+    }
+    if (contiguous < numSamples) {
+        return nullptr;
+    }
+    return &mOutputDelayRingBuffer[mOutputDelayRingBufferWritePos];
+}
 
-        for (int32_t i = 0; i < numSamples; i++) {
-            mOutputDelayRingBuffer[mOutputDelayRingBufferWritePos] = samples[i];
-            mOutputDelayRingBufferWritePos++;
-            if (mOutputDelayRingBufferWritePos >= mOutputDelayRingBufferSize) {
-                mOutputDelayRingBufferWritePos -= mOutputDelayRingBufferSize;
-            }
-        }
+void C2SoftAacDec::outputDelayRingBufferCommitSamples(int32_t numSamples) {
+    mOutputDelayRingBufferWritePos += numSamples;
+    if (mOutputDelayRingBufferWritePos >= mOutputDelayRingBufferSize) {
+        mOutputDelayRingBufferWritePos -= mOutputDelayRingBufferSize;
     }
     mOutputDelayRingBufferFilled += numSamples;
-    return true;
 }
 
 int32_t C2SoftAacDec::outputDelayRingBufferGetSamples(INT_PCM *samples, int32_t numSamples) {
@@ -436,32 +456,18 @@ int32_t C2SoftAacDec::outputDelayRingBufferGetSamples(INT_PCM *samples, int32_t
         return -1;
     }
 
-    if (mOutputDelayRingBufferReadPos + numSamples <= mOutputDelayRingBufferSize
-            && (mOutputDelayRingBufferWritePos < mOutputDelayRingBufferReadPos
-                    || mOutputDelayRingBufferWritePos >= mOutputDelayRingBufferReadPos + numSamples)) {
-        // faster memcopy loop without checks, if the preconditions allow this
-        if (samples != nullptr) {
-            for (int32_t i = 0; i < numSamples; i++) {
-                samples[i] = mOutputDelayRingBuffer[mOutputDelayRingBufferReadPos++];
-            }
-        } else {
-            mOutputDelayRingBufferReadPos += numSamples;
-        }
-        if (mOutputDelayRingBufferReadPos >= mOutputDelayRingBufferSize) {
-            mOutputDelayRingBufferReadPos -= mOutputDelayRingBufferSize;
-        }
-    } else {
-        ALOGV("slow C2SoftAacDec::outputDelayRingBufferGetSamples()");
-
-        for (int32_t i = 0; i < numSamples; i++) {
-            if (samples != nullptr) {
-                samples[i] = mOutputDelayRingBuffer[mOutputDelayRingBufferReadPos];
-            }
-            mOutputDelayRingBufferReadPos++;
-            if (mOutputDelayRingBufferReadPos >= mOutputDelayRingBufferSize) {
-                mOutputDelayRingBufferReadPos -= mOutputDelayRingBufferSize;
-            }
-        }
+    if (samples != nullptr) {
+        // copy out at most two segments, the second one wrapping around to the start
+        int32_t firstSamples = std::min(
+                numSamples, mOutputDelayRingBufferSize - mOutputDelayRingBufferReadPos);
+        memcpy(samples, &mOutputDelayRingBuffer[mOutputDelayRingBufferReadPos],
+               firstSamples * sizeof(INT_PCM));
+        memcpy(samples + firstSamples, &mOutputDelayRingBuffer[0],
+               (numSamples - firstSamples) * sizeof(INT_PCM));
+    }
+    mOutputDelayRingBufferReadPos += numSamples;
+    if (mOutputDelayRingBufferReadPos >= mOutputDelayRingBufferSize) {
+        mOutputDelayRingBufferReadPos -= mOutputDelayRingBufferSize;
     }
     mOutputDelayRingBufferFilled -= numSamples;
     return numSamples;
@@ -719,20 +725,31 @@ void C2SoftAacDec::process(
         ALOGV("AAC decoder using encoder-side DRC reference level of %d", encTargetLevel);
         mDrcWrap.setParam(DRC_PRES_MODE_WRAP_ENCODER_TARGET, (unsigned)encTargetLevel);
 
+        // The decoder parameters below are only set again when they change.
+
         // AAC_UNIDRC_SET_EFFECT
         int32_t effectType = mIntf->getDrcEffectType();
-        ALOGV("AAC decoder using MPEG-D DRC effect type %d", effectType);
-        aacDecoder_SetParam(mAACDecoder, AAC_UNIDRC_SET_EFFECT, effectType);
+        if (effectType != mDrcEffectType) {
+            ALOGV("AAC decoder using MPEG-D DRC effect type %d", effectType);
+            aacDecoder_SetParam(mAACDecoder, AAC_UNIDRC_SET_EFFECT, effectType);
+            mDrcEffectType = effectType;
+        }
 
         // AAC_UNIDRC_ALBUM_MODE
         int32_t albumMode = mIntf->getDrcAlbumMode();
-        ALOGV("AAC decoder using MPEG-D DRC album mode %d", albumMode);
-        aacDecoder_SetParam(mAACDecoder, AAC_UNIDRC_ALBUM_MODE, albumMode);
+        if (albumMode != mDrcAlbumMode) {
+            ALOGV("AAC decoder using MPEG-D DRC album mode %d", albumMode);
+            aacDecoder_SetParam(mAACDecoder, AAC_UNIDRC_ALBUM_MODE, albumMode);
+            mDrcAlbumMode = albumMode;
+        }
 
         // AAC_PCM_MAX_OUTPUT_CHANNELS
         int32_t maxChannelCount = mIntf->getMaxChannelCount();
-        ALOGV("AAC decoder using maximum output channel count %d", maxChannelCount);
-        aacDecoder_SetParam(mAACDecoder, AAC_PCM_MAX_OUTPUT_CHANNELS, maxChannelCount);
+        if (maxChannelCount != mMaxOutputChannelCount) {
+            ALOGV("AAC decoder using maximum output channel count %d", maxChannelCount);
+            aacDecoder_SetParam(mAACDecoder, AAC_PCM_MAX_OUTPUT_CHANNELS, maxChannelCount);
+            mMaxOutputChannelCount = maxChannelCount;
+        }
 
         mDrcWrap.update();
 
@@ -750,9 +767,15 @@ void C2SoftAacDec::process(
                 break;
             }
 
+            // Decode straight into the ring buffer when a whole output frame fits before its
+            // end, and through tmpOutBuffer otherwise.
+            INT_PCM *outBuffer = outputDelayRingBufferWritePtr(2048 * MAX_CHANNEL_COUNT);
+            if (outBuffer == nullptr) {
+                outBuffer = tmpOutBuffer;
+            }
             int numConsumed = mStreamInfo->numTotalBytes;
             decoderErr = aacDecoder_DecodeFrame(mAACDecoder,
-                                       tmpOutBuffer,
+                                       outBuffer,
                                        2048 * MAX_CHANNEL_COUNT,
                                        0 /* flags */);
 
@@ -778,7 +801,7 @@ void C2SoftAacDec::process(
                 mStreamInfo->frameSize * sizeof(int16_t) * mStreamInfo->numChannels;
 
             if (decoderErr == AAC_DEC_OK) {
-                if (!outputDelayRingBufferPutSamples(tmpOutBuffer,
+                if (!outputDelayRingBufferPutSamples(outBuffer,
                         mStreamInfo->frameSize * mStreamInfo->numChannels)) {
                     mSignalledError = true;
                     work->result = C2_CORRUPTED;
@@ -787,9 +810,9 @@ void C2SoftAacDec::process(
             } else {
                 ALOGW("AAC decoder returned error 0x%4.4x, substituting silence", decoderErr);
 
-                memset(tmpOutBuffer, 0, numOutBytes); // TODO: check for overflow
+                memset(outBuffer, 0, numOutBytes); // TODO: check for overflow
 
-                if (!outputDelayRingBufferPutSamples(tmpOutBuffer,
+                if (!outputDelayRingBufferPutSamples(outBuffer,
                         mStreamInfo->frameSize * mStreamInfo->numChannels)) {
                     mSignalledError = true;
                     work->result = C2_CORRUPTED;
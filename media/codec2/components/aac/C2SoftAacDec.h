@@ -67,6 +67,10 @@ private:
     std::list<Info> mBuffersInfo;
 
     CDrcPresModeWrapper mDrcWrap;
+    // Values last set on the decoder.
+    int32_t mDrcEffectType;
+    int32_t mDrcAlbumMode;
+    int32_t mMaxOutputChannelCount;
 
     enum {
         NONE,
@@ -99,6 +103,10 @@ private:
     int32_t mOutputDelayRingBufferFilled;
     int mDeviceApiLevel;
     bool outputDelayRingBufferPutSamples(INT_PCM *samples, int numSamples);
+    // Returns where numSamples can be decoded in place, or nullptr if they do not fit before
+    // the end of the ring buffer. Samples decoded there are added with PutSamples.
+    INT_PCM *outputDelayRingBufferWritePtr(int32_t numSamples);
+    void outputDelayRingBufferCommitSamples(int32_t numSamples);
     int32_t outputDelayRingBufferGetSamples(INT_PCM *samples, int numSamples);
     int32_t outputDelayRingBufferSamplesAvailable();
     int32_t outputDelayRingBufferSpaceLeft();
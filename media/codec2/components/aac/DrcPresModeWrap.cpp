@@ -125,26 +125,31 @@ CDrcPresModeWrapper::submitStreamData(CStreamInfo* pStreamInfo)
 void
 CDrcPresModeWrapper::setParam(const DRC_PRES_MODE_WRAP_PARAM param, const int value)
 {
+    int *target;
     switch (param) {
     case DRC_PRES_MODE_WRAP_DESIRED_TARGET:
-        mDesTarget = value;
+        target = &mDesTarget;
         break;
     case DRC_PRES_MODE_WRAP_DESIRED_ATT_FACTOR:
-        mDesAttFactor = value;
+        target = &mDesAttFactor;
         break;
     case DRC_PRES_MODE_WRAP_DESIRED_BOOST_FACTOR:
-        mDesBoostFactor = value;
+        target = &mDesBoostFactor;
         break;
     case DRC_PRES_MODE_WRAP_DESIRED_HEAVY:
-        mDesHeavy = value;
+        target = &mDesHeavy;
         break;
     case DRC_PRES_MODE_WRAP_ENCODER_TARGET:
-        mEncoderTarget = value;
+        target = &mEncoderTarget;
         break;
     default:
-        break;
+        return;
+    }
+    // only recompute the decoder DRC parameters when a value changes
+    if (*target != value) {
+        *target = value;
+        mDataUpdate = true;
     }
-    mDataUpdate = true;
 }
 
 void
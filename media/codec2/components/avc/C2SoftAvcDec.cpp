@@ -292,6 +292,10 @@ public:
         return C2R::Ok();
     }
 
+    std::shared_ptr<C2StreamPictureSizeInfo::output> getSize_l() {
+        return mSize;
+    }
+
     std::shared_ptr<C2StreamColorAspectsInfo::output> getColorAspects_l() {
         return mColorAspects;
     }
@@ -308,19 +312,6 @@ private:
     std::shared_ptr<C2StreamPixelFormatInfo::output> mPixelFormat;
 };
 
-static size_t getCpuCoreCount() {
-    long cpuCoreCount = 1;
-#if defined(_SC_NPROCESSORS_ONLN)
-    cpuCoreCount = sysconf(_SC_NPROCESSORS_ONLN);
-#else
-    // _SC_NPROC_ONLN must be defined...
-    cpuCoreCount = sysconf(_SC_NPROC_ONLN);
-#endif
-    CHECK(cpuCoreCount >= 1);
-    ALOGV("Number of CPU cores: %ld", cpuCoreCount);
-    return (size_t)cpuCoreCount;
-}
-
 static void *ivd_aligned_malloc(void *ctxt, WORD32 alignment, WORD32 size) {
     (void) ctxt;
     return memalign(alignment, size);
@@ -442,6 +433,14 @@ status_t C2SoftAvcDec::setNumCores() {
     ivdext_ctl_set_num_cores_ip_t s_set_num_cores_ip = {};
     ivdext_ctl_set_num_cores_op_t s_set_num_cores_op = {};
 
+    // The decoder only applies the thread count after a create or a reset, refresh the share
+    // of the cores of this instance at these points.
+    if (mThreadBudget) {
+        IntfImpl::Lock lock = mIntf->lock();
+        std::shared_ptr<C2StreamPictureSizeInfo::output> size = mIntf->getSize_l();
+        mNumCores = mThreadBudget->getThreadCount(size->width, size->height);
+    }
+
     s_set_num_cores_ip.u4_size = sizeof(ivdext_ctl_set_num_cores_ip_t);
     s_set_num_cores_ip.e_cmd = IVD_CMD_VIDEO_CTL;
     s_set_num_cores_ip.e_sub_cmd = IVDEXT_CMD_CTL_SET_NUM_CORES;
@@ -510,7 +509,8 @@ void C2SoftAvcDec::getVersion() {
 
 status_t C2SoftAvcDec::initDecoder() {
     if (OK != createDecoder()) return UNKNOWN_ERROR;
-    mNumCores = MIN(getCpuCoreCount(), MAX_NUM_CORES);
+    mNumCores = 1;
+    mThreadBudget = std::make_unique<SimpleC2ThreadBudget>(MAX_NUM_CORES);
     mStride = ALIGN128(mWidth);
     mSignalledError = false;
     resetPlugin();
@@ -694,6 +694,7 @@ status_t C2SoftAvcDec::deleteDecoder() {
         }
         mDecHandle = nullptr;
     }
+    mThreadBudget.reset();
 
     return OK;
 }
@@ -24,6 +24,7 @@
 
 #include <atomic>
 #include <SimpleC2Component.h>
+#include <SimpleC2ThreadBudget.h>
 
 #include "ih264_typedefs.h"
 #include "ih264d.h"
@@ -152,6 +153,7 @@ private:
     uint8_t *mOutBufferFlush;
 
     size_t mNumCores;
+    std::unique_ptr<SimpleC2ThreadBudget> mThreadBudget;
     IV_COLOR_FORMAT_T mIvColorFormat;
     uint32_t mOutputDelay;
     uint32_t mWidth;
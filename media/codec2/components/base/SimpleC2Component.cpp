@@ -21,8 +21,15 @@
 #include <android/hardware_buffer.h>
 #include <cutils/properties.h>
 #include <media/stagefright/foundation/AMessage.h>
+#include <media/stagefright/foundation/MediaTrace.h>
 
 #include <inttypes.h>
+#include <libyuv.h>
+
+#include <algorithm>
+#include <mutex>
+#include <string>
+#include <vector>
 
 #include <C2Config.h>
 #include <C2Debug.h>
@@ -187,6 +194,24 @@ static C2ColorAspectsStruct FillMissingColorAspects(
     return _aspects;
 }
 
+#if LIBYUV_VERSION >= 1779
+static const libyuv::YuvConstants *GetYuvConstantsForAspects(
+        const C2ColorAspectsStruct &aspects) {
+    bool isFullRange = aspects.range == C2Color::RANGE_FULL;
+
+    switch (aspects.matrix) {
+    case C2Color::MATRIX_BT601:
+        return isFullRange ? &libyuv::kYuvJPEGConstants : &libyuv::kYuvI601Constants;
+
+    case C2Color::MATRIX_BT709:
+        return isFullRange ? &libyuv::kYuvF709Constants : &libyuv::kYuvH709Constants;
+
+    case C2Color::MATRIX_BT2020:
+    default:
+        return isFullRange ? &libyuv::kYuvV2020Constants : &libyuv::kYuv2020Constants;
+    }
+}
+#else  // LIBYUV_VERSION < 1779
 // matrix conversion coefficients
 // (see media/libstagefright/colorconverter/ColorConverter.cpp for more details)
 struct Coeffs {
@@ -231,6 +256,7 @@ static const struct Coeffs GetCoeffsForAspects(const C2ColorAspectsStruct &aspec
         }
     }
 }
+#endif  // LIBYUV_VERSION >= 1779
 
 }
 
@@ -244,6 +270,12 @@ void convertYUV420Planar16ToRGBA1010102(
 
     C2ColorAspectsStruct _aspects = FillMissingColorAspects(aspects, width, height);
 
+#if LIBYUV_VERSION >= 1779
+    // libyuv selects the NEON / SSE / AVX2 row functions at runtime.
+    libyuv::I010ToAB30Matrix(srcY, srcYStride, srcU, srcUStride, srcV, srcVStride,
+                             (uint8_t *)dst, dstStride * sizeof(uint32_t),
+                             GetYuvConstantsForAspects(_aspects), width, height);
+#else  // LIBYUV_VERSION < 1779
     struct Coeffs coeffs = GetCoeffsForAspects(_aspects);
 
     int32_t _y = coeffs._y;
@@ -326,6 +358,7 @@ void convertYUV420Planar16ToRGBA1010102(
         srcV += srcVStride;
         dst += dstStride * 2;
     }
+#endif  // LIBYUV_VERSION >= 1779
 }
 
 void convertYUV420Planar16ToY410OrRGBA1010102(
@@ -348,13 +381,8 @@ void convertYUV420Planar16ToYV12(uint8_t *dstY, uint8_t *dstU, uint8_t *dstV, co
                                  size_t srcUStride, size_t srcVStride, size_t dstYStride,
                                  size_t dstUVStride, size_t width, size_t height,
                                  bool isMonochrome) {
-    for (size_t y = 0; y < height; ++y) {
-        for (size_t x = 0; x < width; ++x) {
-            dstY[x] = (uint8_t)(srcY[x] >> 2);
-        }
-        srcY += srcYStride;
-        dstY += dstYStride;
-    }
+    // A scale of 16384 keeps the 8 most significant of the 10 bits.
+    libyuv::Convert16To8Plane(srcY, srcYStride, dstY, dstYStride, 16384, width, height);
 
     if (isMonochrome) {
         // Fill with neutral U/V values.
@@ -367,16 +395,10 @@ void convertYUV420Planar16ToYV12(uint8_t *dstY, uint8_t *dstU, uint8_t *dstV, co
         return;
     }
 
-    for (size_t y = 0; y < (height + 1) / 2; ++y) {
-        for (size_t x = 0; x < (width + 1) / 2; ++x) {
-            dstU[x] = (uint8_t)(srcU[x] >> 2);
-            dstV[x] = (uint8_t)(srcV[x] >> 2);
-        }
-        srcU += srcUStride;
-        srcV += srcVStride;
-        dstU += dstUVStride;
-        dstV += dstUVStride;
-    }
+    libyuv::Convert16To8Plane(srcU, srcUStride, dstU, dstUVStride, 16384,
+                              (width + 1) / 2, (height + 1) / 2);
+    libyuv::Convert16To8Plane(srcV, srcVStride, dstV, dstUVStride, 16384,
+                              (width + 1) / 2, (height + 1) / 2);
 }
 
 void convertYUV420Planar16ToP010(uint16_t *dstY, uint16_t *dstUV, const uint16_t *srcY,
@@ -384,6 +406,9 @@ void convertYUV420Planar16ToP010(uint16_t *dstY, uint16_t *dstUV, const uint16_t
                                  size_t srcUStride, size_t srcVStride, size_t dstYStride,
                                  size_t dstUVStride, size_t width, size_t height,
                                  bool isMonochrome) {
+#if LIBYUV_VERSION >= 1779
+    libyuv::ConvertToMSBPlane_16(srcY, srcYStride, dstY, dstYStride, width, height, 10);
+#else  // LIBYUV_VERSION < 1779
     for (size_t y = 0; y < height; ++y) {
         for (size_t x = 0; x < width; ++x) {
             dstY[x] = srcY[x] << 6;
@@ -391,6 +416,7 @@ void convertYUV420Planar16ToP010(uint16_t *dstY, uint16_t *dstUV, const uint16_t
         srcY += srcYStride;
         dstY += dstYStride;
     }
+#endif  // LIBYUV_VERSION >= 1779
 
     if (isMonochrome) {
         // Fill with neutral U/V values.
@@ -404,6 +430,10 @@ void convertYUV420Planar16ToP010(uint16_t *dstY, uint16_t *dstUV, const uint16_t
         return;
     }
 
+#if LIBYUV_VERSION >= 1779
+    libyuv::MergeUVPlane_16(srcU, srcUStride, srcV, srcVStride, dstUV, dstUVStride,
+                            (width + 1) / 2, (height + 1) / 2, 10);
+#else  // LIBYUV_VERSION < 1779
     for (size_t y = 0; y < (height + 1) / 2; ++y) {
         for (size_t x = 0; x < (width + 1) / 2; ++x) {
             dstUV[2 * x] = srcU[x] << 6;
@@ -413,6 +443,7 @@ void convertYUV420Planar16ToP010(uint16_t *dstY, uint16_t *dstUV, const uint16_t
         srcV += srcVStride;
         dstUV += dstUVStride;
     }
+#endif  // LIBYUV_VERSION >= 1779
 }
 
 void convertP010ToYUV420Planar16(uint16_t *dstY, uint16_t *dstU, uint16_t *dstV,
@@ -420,6 +451,9 @@ void convertP010ToYUV420Planar16(uint16_t *dstY, uint16_t *dstU, uint16_t *dstV,
                                  size_t srcYStride, size_t srcUVStride, size_t dstYStride,
                                  size_t dstUStride, size_t dstVStride, size_t width,
                                  size_t height, bool isMonochrome) {
+#if LIBYUV_VERSION >= 1779
+    libyuv::ConvertToLSBPlane_16(srcY, srcYStride, dstY, dstYStride, width, height, 10);
+#else  // LIBYUV_VERSION < 1779
     for (size_t y = 0; y < height; ++y) {
         for (size_t x = 0; x < width; ++x) {
             dstY[x] = srcY[x] >> 6;
@@ -427,6 +461,7 @@ void convertP010ToYUV420Planar16(uint16_t *dstY, uint16_t *dstU, uint16_t *dstV,
         srcY += srcYStride;
         dstY += dstYStride;
     }
+#endif  // LIBYUV_VERSION >= 1779
 
     if (isMonochrome) {
         // Fill with neutral U/V values.
@@ -441,6 +476,10 @@ void convertP010ToYUV420Planar16(uint16_t *dstY, uint16_t *dstU, uint16_t *dstV,
         return;
     }
 
+#if LIBYUV_VERSION >= 1779
+    libyuv::SplitUVPlane_16(srcUV, srcUVStride, dstU, dstUStride, dstV, dstVStride,
+                            (width + 1) / 2, (height + 1) / 2, 10);
+#else  // LIBYUV_VERSION < 1779
     for (size_t y = 0; y < (height + 1) / 2; ++y) {
         for (size_t x = 0; x < (width + 1) / 2; ++x) {
             dstU[x] = srcUV[2 * x] >> 6;
@@ -450,6 +489,7 @@ void convertP010ToYUV420Planar16(uint16_t *dstY, uint16_t *dstU, uint16_t *dstV,
         dstV += dstVStride;
         srcUV += srcUVStride;
     }
+#endif  // LIBYUV_VERSION >= 1779
 }
 
 static const int16_t bt709Matrix_10bit[2][3][3] = {
@@ -669,22 +709,123 @@ struct DummyReadView : public C2ReadView {
     DummyReadView() : C2ReadView(C2_NO_INIT) {}
 };
 
+/**
+ * Loopers shared by the audio components of the process.
+ *
+ * Each audio component otherwise runs its own looper thread, which is mostly idle. When the
+ * debug.stagefright.c2-shared-loopers property is set to N > 0, audio components instead
+ * register their handler on one of at most N shared loopers, the one with the fewest
+ * components. A looper processes one work per message, so the components on a looper take
+ * turns and each component stays serialized on its handler.
+ *
+ * Video components keep their own looper, as they may wait for output buffers in process().
+ */
+class SharedLoopers {
+public:
+    static SharedLoopers &Get() {
+        static SharedLoopers sInstance;
+        return sInstance;
+    }
+
+    // Returns the looper for a new component, or nullptr if loopers are not shared.
+    sp<ALooper> acquire() {
+        if (mMaxLoopers == 0) {
+            return nullptr;
+        }
+        std::lock_guard<std::mutex> lock(mLock);
+        Entry *least = nullptr;
+        for (Entry &entry : mEntries) {
+            if (!least || entry.components < least->components) {
+                least = &entry;
+            }
+        }
+        if (!least || (least->components > 0 && mEntries.size() < mMaxLoopers)) {
+            sp<ALooper> looper = new ALooper;
+            looper->setName(("c2-soft-shared #" + std::to_string(mNextId++)).c_str());
+            if (looper->start(false, false, ANDROID_PRIORITY_AUDIO) != OK) {
+                return nullptr;
+            }
+            mEntries.push_back({looper, 0});
+            least = &mEntries.back();
+        }
+        ++least->components;
+        ALOGD("%s has %zu components (%zu shared loopers)",
+              least->looper->getName(), least->components, mEntries.size());
+        return least->looper;
+    }
+
+    void release(const sp<ALooper> &looper) {
+        sp<ALooper> stopped;
+        {
+            std::lock_guard<std::mutex> lock(mLock);
+            for (auto it = mEntries.begin(); it != mEntries.end(); ++it) {
+                if (it->looper != looper) {
+                    continue;
+                }
+                ALOGD("%s has %zu components (%zu shared loopers)",
+                      looper->getName(), it->components - 1, mEntries.size());
+                if (--it->components == 0) {
+                    stopped = it->looper;
+                    mEntries.erase(it);
+                }
+                break;
+            }
+        }
+        if (stopped) {
+            (void)stopped->stop();
+        }
+    }
+
+private:
+    SharedLoopers()
+        : mMaxLoopers(std::max(property_get_int32("debug.stagefright.c2-shared-loopers", 0), 0)),
+          mNextId(0) {}
+
+    struct Entry {
+        sp<ALooper> looper;
+        size_t components;
+    };
+
+    const size_t mMaxLoopers;
+    std::mutex mLock;
+    std::vector<Entry> mEntries;
+    uint32_t mNextId;
+};
+
+bool IsAudioComponent(const std::shared_ptr<C2ComponentInterface> &intf) {
+    C2ComponentDomainSetting domain;
+    return intf->query_vb({&domain}, {}, C2_DONT_BLOCK, nullptr) == C2_OK
+            && domain.value == C2Component::DOMAIN_AUDIO;
+}
+
 }  // namespace
 
 SimpleC2Component::SimpleC2Component(
         const std::shared_ptr<C2ComponentInterface> &intf)
     : mDummyReadView(DummyReadView()),
       mIntf(intf),
-      mLooper(new ALooper),
       mHandler(new WorkHandler) {
-    mLooper->setName(intf->getName().c_str());
+    if (IsAudioComponent(intf)) {
+        mLooper = SharedLoopers::Get().acquire();
+    }
+    mSharedLooper = (mLooper != nullptr);
+    if (!mSharedLooper) {
+        mLooper = new ALooper;
+        mLooper->setName(intf->getName().c_str());
+    }
     (void)mLooper->registerHandler(mHandler);
-    mLooper->start(false, false, ANDROID_PRIORITY_VIDEO);
+    if (!mSharedLooper) {
+        mLooper->start(false, false, ANDROID_PRIORITY_VIDEO);
+    }
 }
 
 SimpleC2Component::~SimpleC2Component() {
     mLooper->unregisterHandler(mHandler->id());
-    (void)mLooper->stop();
+    if (mSharedLooper) {
+        SharedLoopers::Get().release(mLooper);
+    } else {
+        (void)mLooper->stop();
+    }
 }
 
 c2_status_t SimpleC2Component::setListener_vb(
@@ -1020,8 +1161,12 @@ bool SimpleC2Component::processQueue() {
         ALOGD("Encountered null input buffer. Clearing the input buffer");
         work->input.buffers.clear();
     }
+    MEDIA_TRACE_CODEC("SimpleC2Component::process", mIntf->getName().c_str(),
+            work->input.ordinal.customOrdinal.peekll(), work->input.ordinal.frameIndex.peekll());
     process(work, mOutputBlockPool);
     ALOGV("processed frame #%" PRIu64, work->input.ordinal.frameIndex.peeku());
+    MEDIA_TRACE_CODEC("SimpleC2Component::processed", mIntf->getName().c_str(),
+            work->input.ordinal.customOrdinal.peekll(), work->input.ordinal.frameIndex.peekll());
     Mutexed<WorkQueue>::Locked queue(mWorkQueue);
     if (queue->generation() != generation) {
         ALOGD("work form old generation: was %" PRIu64 " now %" PRIu64,
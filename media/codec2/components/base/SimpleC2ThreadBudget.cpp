@@ -0,0 +1,88 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "SimpleC2ThreadBudget"
+#include <log/log.h>
+
+#include <unistd.h>
+
+#include <algorithm>
+
+#include <media/stagefright/foundation/Mutexed.h>
+
+#include <SimpleC2ThreadBudget.h>
+
+namespace android {
+
+namespace {
+
+// Below this many pixels per thread, the synchronization between the row or slice threads of
+// the codec libraries costs more than what the parallelism brings.
+constexpr uint64_t kMinPixelsPerThread = 640 * 360;
+
+struct Budget {
+    size_t instances = 0;
+    uint64_t totalPixels = 0;  // of all instances
+};
+
+Mutexed<Budget> &GetBudget() {
+    static Mutexed<Budget> sBudget;
+    return sBudget;
+}
+
+size_t GetOnlineCoreCount() {
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count >= 1 ? (size_t)count : 1;
+}
+
+}  // namespace
+
+SimpleC2ThreadBudget::SimpleC2ThreadBudget(size_t maxThreads)
+    : mMaxThreads(std::max(maxThreads, (size_t)1)),
+      mPixels(0) {
+    Mutexed<Budget>::Locked budget(GetBudget());
+    ++budget->instances;
+}
+
+SimpleC2ThreadBudget::~SimpleC2ThreadBudget() {
+    Mutexed<Budget>::Locked budget(GetBudget());
+    --budget->instances;
+    budget->totalPixels -= mPixels;
+}
+
+size_t SimpleC2ThreadBudget::getThreadCount(uint32_t width, uint32_t height) {
+    const uint64_t pixels = (uint64_t)width * height;
+    const size_t cores = GetOnlineCoreCount();
+    size_t share;
+    size_t instances;
+    {
+        Mutexed<Budget>::Locked budget(GetBudget());
+        budget->totalPixels = budget->totalPixels - mPixels + pixels;
+        mPixels = pixels;
+        instances = budget->instances;
+        share = budget->totalPixels == 0
+                ? cores / instances
+                : (size_t)(cores * pixels / budget->totalPixels);
+    }
+    const size_t useful = (size_t)((pixels + kMinPixelsPerThread - 1) / kMinPixelsPerThread);
+    const size_t threads = std::max(std::min({share, useful, mMaxThreads}), (size_t)1);
+    ALOGV("%zu threads for %ux%u (%zu cores, %zu instances)",
+          threads, width, height, cores, instances);
+    return threads;
+}
+
+}  // namespace android
@@ -232,6 +232,8 @@ private:
     Mutexed<ExecState> mExecState;
 
     sp<ALooper> mLooper;
+    // Whether mLooper is shared with other components, see SharedLoopers.
+    bool mSharedLooper;
     sp<WorkHandler> mHandler;
 
     class WorkQueue {
@@ -0,0 +1,58 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SIMPLE_C2_THREAD_BUDGET_H_
+#define SIMPLE_C2_THREAD_BUDGET_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace android {
+
+/**
+ * Process wide budget for the internal threads of the software codecs.
+ *
+ * A codec instance holds one budget for as long as its codec library instance exists, and
+ * queries it whenever it (re)configures the thread count of the library. The online cores
+ * are shared between all such instances in the process in proportion to their frame sizes,
+ * so that many concurrent decodes do not oversubscribe the cores. An instance also never
+ * gets more threads than its frame size can keep busy.
+ */
+class SimpleC2ThreadBudget {
+public:
+    /**
+     * \param maxThreads the largest thread count the codec library supports
+     */
+    explicit SimpleC2ThreadBudget(size_t maxThreads);
+    ~SimpleC2ThreadBudget();
+
+    /**
+     * Updates the frame size of this instance, and returns the number of threads it should
+     * use from now on, which is at least 1.
+     */
+    size_t getThreadCount(uint32_t width, uint32_t height);
+
+private:
+    SimpleC2ThreadBudget(const SimpleC2ThreadBudget &) = delete;
+    SimpleC2ThreadBudget &operator=(const SimpleC2ThreadBudget &) = delete;
+
+    const size_t mMaxThreads;
+    uint64_t mPixels;
+};
+
+}  // namespace android
+
+#endif  // SIMPLE_C2_THREAD_BUDGET_H_
@@ -44,6 +44,12 @@ constexpr char COMPONENT_NAME[] = CODECNAME;
 
 constexpr size_t kMinInputBufferSize = 2 * 1024 * 1024;
 
+// In frame parallel mode, up to this many temporal units are in flight in the decoder, which
+// delays the output by as many frames. It is only used for large frames, where the tile and
+// superblock row threads alone cannot keep the cores busy.
+constexpr uint32_t kFrameParallelOutputDelay = 4;
+constexpr uint64_t kMinFrameParallelPixels = 1920 * 1080;
+
 class C2SoftGav1Dec::IntfImpl : public SimpleInterface<void>::BaseParams {
  public:
   explicit IntfImpl(const std::shared_ptr<C2ReflectorHelper> &helper)
@@ -56,6 +62,13 @@ class C2SoftGav1Dec::IntfImpl : public SimpleInterface<void>::BaseParams {
     noInputLatency();
     noTimeStretch();
 
+    addParameter(
+        DefineParam(mActualOutputDelay, C2_PARAMKEY_OUTPUT_DELAY)
+            .withDefault(new C2PortActualDelayTuning::output(0u))
+            .withFields({C2F(mActualOutputDelay, value).inRange(0, kFrameParallelOutputDelay)})
+            .withSetter(Setter<decltype(*mActualOutputDelay)>::StrictValueWithNoDeps)
+            .build());
+
     addParameter(DefineParam(mAttrib, C2_PARAMKEY_COMPONENT_ATTRIBUTES)
                      .withConstValue(new C2ComponentAttributesSetting(
                          C2Component::ATTRIB_IS_TEMPORAL))
@@ -362,6 +375,7 @@ class C2SoftGav1Dec::IntfImpl : public SimpleInterface<void>::BaseParams {
 
   // unsafe getters
   std::shared_ptr<C2StreamPixelFormatInfo::output> getPixelFormat_l() const { return mPixelFormat; }
+  std::shared_ptr<C2StreamPictureSizeInfo::output> getSize_l() const { return mSize; }
 
   static C2R HdrStaticInfoSetter(bool mayBlock, C2P<C2StreamHdrStaticInfo::output> &me) {
     (void)mayBlock;
@@ -424,7 +438,10 @@ C2SoftGav1Dec::C2SoftGav1Dec(const char *name, c2_node_id_t id,
     : SimpleC2Component(
           std::make_shared<SimpleInterface<IntfImpl>>(name, id, intfImpl)),
       mIntf(intfImpl),
-      mCodecCtx(nullptr) {
+      mCodecCtx(nullptr),
+      mFrameParallel(false),
+      mOutputDelay(0u),
+      mFramesInFlight(0u) {
   mTimeStart = mTimeEnd = systemTime();
 }
 
@@ -472,10 +489,20 @@ c2_status_t C2SoftGav1Dec::onFlush_sm() {
 
   mSignalledError = false;
   mSignalledOutputEos = false;
+  mFramesInFlight = 0u;
 
   return C2_OK;
 }
 
+// static
+void C2SoftGav1Dec::ReleaseInputBuffer(void *callbackPrivateData, void *bufferPrivateData) {
+  C2SoftGav1Dec *thiz = static_cast<C2SoftGav1Dec *>(callbackPrivateData);
+  Mutexed<std::list<InputBuffer>>::Locked inputBuffers(thiz->mInputBuffers);
+  inputBuffers->remove_if([bufferPrivateData](const InputBuffer &input) {
+    return &input == bufferPrivateData;
+  });
+}
+
 static int GetCPUCoreCount() {
   int cpuCoreCount = 1;
 #if defined(_SC_NPROCESSORS_ONLN)
@@ -493,9 +520,12 @@ bool C2SoftGav1Dec::initDecoder() {
   mSignalledError = false;
   mSignalledOutputEos = false;
   mHalPixelFormat = HAL_PIXEL_FORMAT_YV12;
+  uint64_t pixels;
   {
       IntfImpl::Lock lock = mIntf->lock();
       mPixelFormatInfo = mIntf->getPixelFormat_l();
+      std::shared_ptr<C2StreamPictureSizeInfo::output> size = mIntf->getSize_l();
+      pixels = (uint64_t)size->width * size->height;
   }
   mCodecCtx.reset(new libgav1::Decoder());
 
@@ -506,18 +536,39 @@ bool C2SoftGav1Dec::initDecoder() {
 
   libgav1::DecoderSettings settings = {};
   settings.threads = GetCPUCoreCount();
+  mFrameParallel = settings.threads > 1 && pixels >= kMinFrameParallelPixels;
+  mOutputDelay = mFrameParallel ? kFrameParallelOutputDelay : 0u;
+  mFramesInFlight = 0u;
+  if (mFrameParallel) {
+    // The decoder reads the input buffers until it releases them.
+    settings.frame_parallel = true;
+    settings.blocking_dequeue = true;
+    settings.callback_private_data = this;
+    settings.release_input_buffer = ReleaseInputBuffer;
+  }
 
-  ALOGV("Using libgav1 AV1 software decoder.");
+  ALOGV("Using libgav1 AV1 software decoder%s.", mFrameParallel ? " in frame parallel mode" : "");
   Libgav1StatusCode status = mCodecCtx->Init(&settings);
   if (status != kLibgav1StatusOk) {
     ALOGE("av1 decoder failed to initialize. status: %d.", status);
     return false;
   }
 
+  C2PortActualDelayTuning::output outputDelay(mOutputDelay);
+  std::vector<std::unique_ptr<C2SettingResult>> failures;
+  if (mIntf->config({&outputDelay}, C2_MAY_BLOCK, &failures) != C2_OK) {
+    ALOGE("Cannot set output delay");
+    return false;
+  }
+
   return true;
 }
 
-void C2SoftGav1Dec::destroyDecoder() { mCodecCtx = nullptr; }
+void C2SoftGav1Dec::destroyDecoder() {
+  mCodecCtx = nullptr;
+  Mutexed<std::list<InputBuffer>>::Locked inputBuffers(mInputBuffers);
+  inputBuffers->clear();
+}
 
 void fillEmptyWork(const std::unique_ptr<C2Work> &work) {
   uint32_t flags = 0;
@@ -604,25 +655,39 @@ void C2SoftGav1Dec::process(const std::unique_ptr<C2Work> &work,
     mTimeStart = systemTime();
     nsecs_t delay = mTimeStart - mTimeEnd;
 
-    const Libgav1StatusCode status =
-        mCodecCtx->EnqueueFrame(bitstream, inSize, frameIndex,
-                                /*buffer_private_data=*/nullptr);
+    void *bufferPrivateData = nullptr;
+    if (mFrameParallel) {
+      Mutexed<std::list<InputBuffer>>::Locked inputBuffers(mInputBuffers);
+      inputBuffers->push_back({work->input.buffers[0], rView});
+      bufferPrivateData = &inputBuffers->back();
+    }
+    Libgav1StatusCode status =
+        mCodecCtx->EnqueueFrame(bitstream, inSize, frameIndex, bufferPrivateData);
+    // The decoder queue is full, make room by outputting the oldest frame.
+    while (status == kLibgav1StatusTryAgain && mFramesInFlight > 0 &&
+           dequeueFrames(pool, work, mFramesInFlight - 1)) {
+      status = mCodecCtx->EnqueueFrame(bitstream, inSize, frameIndex, bufferPrivateData);
+    }
 
     mTimeEnd = systemTime();
     nsecs_t decodeTime = mTimeEnd - mTimeStart;
     ALOGV("decodeTime=%4" PRId64 " delay=%4" PRId64 "\n", decodeTime, delay);
 
     if (status != kLibgav1StatusOk) {
+      if (bufferPrivateData) {
+        ReleaseInputBuffer(this, bufferPrivateData);
+      }
       ALOGE("av1 decoder failed to decode frame. status: %d.", status);
       work->result = C2_CORRUPTED;
       work->workletsProcessed = 1u;
       mSignalledError = true;
       return;
     }
-
+    ++mFramesInFlight;
   }
 
-  (void)outputBuffer(pool, work);
+  // Works of frames still in flight complete later through finish().
+  (void)dequeueFrames(pool, work, mOutputDelay);
 
   if (eos) {
     drainInternal(DRAIN_COMPONENT_WITH_EOS, pool, work);
@@ -763,6 +828,9 @@ bool C2SoftGav1Dec::outputBuffer(const std::shared_ptr<C2BlockPool> &pool,
     ALOGE("av1 decoder DequeueFrame failed. status: %d.", status);
     return false;
   }
+  if (status == kLibgav1StatusOk && mFramesInFlight > 0) {
+    --mFramesInFlight;
+  }
 
   // |buffer| can be NULL if status was equal to kLibgav1StatusOk or
   // kLibgav1StatusNothingToDequeue. This is not an error. This could mean one
@@ -1038,6 +1106,19 @@ bool C2SoftGav1Dec::outputBuffer(const std::shared_ptr<C2BlockPool> &pool,
   return true;
 }
 
+bool C2SoftGav1Dec::dequeueFrames(const std::shared_ptr<C2BlockPool> &pool,
+                                  const std::unique_ptr<C2Work> &work,
+                                  uint32_t maxFramesInFlight) {
+  while (mFramesInFlight > maxFramesInFlight) {
+    const uint32_t framesInFlight = mFramesInFlight;
+    (void)outputBuffer(pool, work);
+    if (mSignalledError || mFramesInFlight == framesInFlight) {
+      return false;
+    }
+  }
+  return true;
+}
+
 c2_status_t C2SoftGav1Dec::drainInternal(
     uint32_t drainMode, const std::shared_ptr<C2BlockPool> &pool,
     const std::unique_ptr<C2Work> &work) {
@@ -1050,6 +1131,8 @@ c2_status_t C2SoftGav1Dec::drainInternal(
     return C2_OMITTED;
   }
 
+  // SignalEOS() drops the frames still in flight, output them first.
+  (void)dequeueFrames(pool, work, 0u);
   const Libgav1StatusCode status = mCodecCtx->SignalEOS();
   if (status != kLibgav1StatusOk) {
     ALOGE("Failed to flush av1 decoder. status: %d.", status);
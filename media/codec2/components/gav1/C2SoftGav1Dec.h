@@ -19,9 +19,11 @@
 
 #include <inttypes.h>
 
+#include <list>
 #include <memory>
 
 #include <media/stagefright/foundation/ColorUtils.h>
+#include <media/stagefright/foundation/Mutexed.h>
 
 #include <SimpleC2Component.h>
 #include <C2Config.h>
@@ -62,6 +64,18 @@ struct C2SoftGav1Dec : public SimpleC2Component {
   uint32_t mHeight;
   bool mSignalledOutputEos;
   bool mSignalledError;
+  // Whether several temporal units are decoded at once.
+  bool mFrameParallel;
+  uint32_t mOutputDelay;
+  // Temporal units enqueued to the decoder and not dequeued yet.
+  uint32_t mFramesInFlight;
+
+  // Input buffers of the temporal units the decoder still reads in frame parallel mode.
+  struct InputBuffer {
+    std::shared_ptr<C2Buffer> buffer;
+    C2ReadView view;
+  };
+  Mutexed<std::list<InputBuffer>> mInputBuffers;
   // Used during 10-bit I444/I422 to 10-bit P010 & 8-bit I420 conversions.
   std::unique_ptr<uint16_t[]> mTmpFrameBuffer;
   size_t mTmpFrameBufferSize = 0;
@@ -94,6 +108,8 @@ struct C2SoftGav1Dec : public SimpleC2Component {
   nsecs_t mTimeEnd = 0;    // Time at the end of decode()
 
   bool initDecoder();
+  // Called by the decoder, possibly on one of its threads, when it is done with an input.
+  static void ReleaseInputBuffer(void *callbackPrivateData, void *bufferPrivateData);
   void getHDRStaticParams(const libgav1::DecoderBuffer *buffer,
                   const std::unique_ptr<C2Work> &work);
   void getHDR10PlusInfoData(const libgav1::DecoderBuffer *buffer,
@@ -107,6 +123,10 @@ struct C2SoftGav1Dec : public SimpleC2Component {
   bool allocTmpFrameBuffer(size_t size);
   bool outputBuffer(const std::shared_ptr<C2BlockPool>& pool,
                     const std::unique_ptr<C2Work>& work);
+  // Outputs the oldest frames in flight until at most |maxFramesInFlight| remain. Returns
+  // false if the decoder could not output a frame.
+  bool dequeueFrames(const std::shared_ptr<C2BlockPool>& pool,
+                     const std::unique_ptr<C2Work>& work, uint32_t maxFramesInFlight);
   c2_status_t drainInternal(uint32_t drainMode,
                             const std::shared_ptr<C2BlockPool>& pool,
                             const std::unique_ptr<C2Work>& work);
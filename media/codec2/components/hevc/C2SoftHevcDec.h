@@ -22,6 +22,7 @@
 #include <atomic>
 #include <inttypes.h>
 #include <SimpleC2Component.h>
+#include <SimpleC2ThreadBudget.h>
 
 #include "ihevc_typedefs.h"
 #include "ihevcd_cxa.h"
@@ -110,6 +111,7 @@ struct C2SoftHevcDec : public SimpleC2Component {
     uint8_t *mOutBufferFlush;
 
     size_t mNumCores;
+    std::unique_ptr<SimpleC2ThreadBudget> mThreadBudget;
     IV_COLOR_FORMAT_T mIvColorformat;
     uint32_t mOutputDelay;
     uint32_t mWidth;
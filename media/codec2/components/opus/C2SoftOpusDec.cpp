@@ -374,10 +374,16 @@ void C2SoftOpusDec::process(
     // other timestamp).
     if (work->input.ordinal.timestamp.peeku() == 0) mSamplesToDiscard = mCodecDelay;
 
+    // Size the output block for the samples of this packet rather than for the largest
+    // packet of the largest channel count.
+    int frameSize = opus_packet_get_nb_samples(data, inSize, kRate);
+    if (frameSize <= 0 || frameSize > kMaxOpusOutputPacketSizeSamples) {
+        frameSize = kMaxOpusOutputPacketSizeSamples;
+    }
     std::shared_ptr<C2LinearBlock> block;
     C2MemoryUsage usage = { C2MemoryUsage::CPU_READ, C2MemoryUsage::CPU_WRITE };
     c2_status_t err = pool->fetchLinearBlock(
-                          kMaxNumSamplesPerBuffer * kMaxChannels * sizeof(int16_t),
+                          frameSize * mHeader.channels * sizeof(int16_t),
                           usage, &block);
     if (err != C2_OK) {
         ALOGE("fetchLinearBlock for Output failed with status %d", err);
@@ -395,7 +401,7 @@ void C2SoftOpusDec::process(
                                              data,
                                              inSize,
                                              reinterpret_cast<int16_t *> (wView.data()),
-                                             kMaxOpusOutputPacketSizeSamples,
+                                             frameSize,
                                              0);
     if (numSamples < 0) {
         ALOGE("opus_multistream_decode returned numSamples %d", numSamples);
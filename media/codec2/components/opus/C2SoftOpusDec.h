@@ -44,10 +44,6 @@ struct C2SoftOpusDec : public SimpleC2Component {
             uint32_t drainMode,
             const std::shared_ptr<C2BlockPool> &pool) override;
 private:
-    enum {
-        kMaxNumSamplesPerBuffer = 960 * 6
-    };
-
     std::shared_ptr<IntfImpl> mIntf;
     OpusMSDecoder *mDecoder;
     OpusHeader mHeader;
@@ -486,17 +486,22 @@ void C2SoftOpusEnc::process(const std::unique_ptr<C2Work>& work,
         }
         const unsigned nInputSamples = processSize / sizeof(int16_t);
 
-        for (unsigned i = 0; i < nInputSamples; i++) {
-            int32_t data = pcmBytes[2 * i + 1] << 8 | pcmBytes[2 * i];
-            data = ((data & 0xFFFF) ^ 0x8000) - 0x8000;
-            mInputBufferPcm16[i + filledSamples] = data;
+        // Encode whole frames straight from the input buffer; only partial frames go through
+        // mInputBufferPcm16. The input is native (little-endian) 16-bit PCM.
+        const int16_t* pcm16 = mInputBufferPcm16;
+        if (mBufferAvailable && mFilledLen == 0 && processSize == mNumPcmBytesPerInputFrame
+                && ((uintptr_t)pcmBytes % alignof(int16_t)) == 0) {
+            pcm16 = reinterpret_cast<const int16_t*>(pcmBytes);
+        } else {
+            memcpy(mInputBufferPcm16 + filledSamples, pcmBytes,
+                   nInputSamples * sizeof(int16_t));
         }
         inPos += processSize;
         mFilledLen += processSize;
         if (!mBufferAvailable) break;
         uint8_t* outPtr = wView.data() + mBytesEncoded;
         int encodedBytes =
-            opus_multistream_encode(mEncoder, mInputBufferPcm16,
+            opus_multistream_encode(mEncoder, pcm16,
                                     mNumSamplesPerFrame, outPtr, kMaxPayload - mBytesEncoded);
         ALOGV("encoded %i Opus bytes from %zu PCM bytes", encodedBytes,
               processSize);
@@ -0,0 +1,146 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Benchmark of the AAC-LC decoding of C2SoftAacDec for stereo, 5.1 and 7.1 streams, reporting
+// decoded frames per second. The streams are encoded at start up with the FDK encoder from a
+// synthesized signal, so no resource file is needed.
+
+#include <math.h>
+
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "aacenc_lib.h"
+#include "C2SoftCodecBenchmark.h"
+
+using namespace android;
+
+namespace {
+
+constexpr uint32_t kSampleRate = 48000;
+constexpr int kFramesPerIteration = 100;  // about 2 s
+
+struct EncodedStream {
+    std::vector<uint8_t> csd;
+    std::vector<std::vector<uint8_t>> frames;
+};
+
+// Encodes kFramesPerIteration AAC-LC frames of a tone per channel.
+bool encodeStream(uint32_t channelCount, CHANNEL_MODE channelMode, EncodedStream* stream) {
+    HANDLE_AACENCODER encoder;
+    if (aacEncOpen(&encoder, 0, channelCount) != AACENC_OK) {
+        return false;
+    }
+    bool ok = aacEncoder_SetParam(encoder, AACENC_AOT, AOT_AAC_LC) == AACENC_OK
+            && aacEncoder_SetParam(encoder, AACENC_SAMPLERATE, kSampleRate) == AACENC_OK
+            && aacEncoder_SetParam(encoder, AACENC_CHANNELMODE, channelMode) == AACENC_OK
+            && aacEncoder_SetParam(encoder, AACENC_BITRATE, 64000 * channelCount) == AACENC_OK
+            && aacEncoder_SetParam(encoder, AACENC_TRANSMUX, TT_MP4_RAW) == AACENC_OK
+            && aacEncEncode(encoder, nullptr, nullptr, nullptr, nullptr) == AACENC_OK;
+    AACENC_InfoStruct info;
+    ok = ok && aacEncInfo(encoder, &info) == AACENC_OK;
+    if (ok) {
+        stream->csd.assign(info.confBuf, info.confBuf + info.confSize);
+        std::vector<INT_PCM> pcm(info.frameLength * channelCount);
+        std::vector<uint8_t> out(info.maxOutBufBytes);
+        int64_t sample = 0;
+        while (ok && stream->frames.size() < (size_t)kFramesPerIteration) {
+            for (UINT i = 0; i < info.frameLength; ++i, ++sample) {
+                for (uint32_t ch = 0; ch < channelCount; ++ch) {
+                    pcm[i * channelCount + ch] = (INT_PCM)(8000 * sin(
+                            2 * M_PI * (220 + 110 * ch) * sample / kSampleRate));
+                }
+            }
+            void* inBuffer[] = { pcm.data() };
+            INT inBufferIds[] = { IN_AUDIO_DATA };
+            INT inBufferSize[] = { (INT)(pcm.size() * sizeof(INT_PCM)) };
+            INT inBufferElSize[] = { sizeof(INT_PCM) };
+            AACENC_BufDesc inBufDesc = {1, inBuffer, inBufferIds, inBufferSize, inBufferElSize};
+            void* outBuffer[] = { out.data() };
+            INT outBufferIds[] = { OUT_BITSTREAM_DATA };
+            INT outBufferSize[] = { (INT)out.size() };
+            INT outBufferElSize[] = { sizeof(UCHAR) };
+            AACENC_BufDesc outBufDesc =
+                    {1, outBuffer, outBufferIds, outBufferSize, outBufferElSize};
+            AACENC_InArgs inArgs = {};
+            inArgs.numInSamples = pcm.size();
+            AACENC_OutArgs outArgs = {};
+            ok = aacEncEncode(encoder, &inBufDesc, &outBufDesc, &inArgs, &outArgs) == AACENC_OK;
+            if (ok && outArgs.numOutBytes > 0) {
+                stream->frames.emplace_back(out.begin(), out.begin() + outArgs.numOutBytes);
+            }
+        }
+    }
+    aacEncClose(&encoder);
+    return ok;
+}
+
+// Args: channel count, FDK channel mode.
+void runDecoder(benchmark::State& state) {
+    const uint32_t channelCount = state.range(0);
+    EncodedStream stream;
+    if (!encodeStream(channelCount, (CHANNEL_MODE)state.range(1), &stream)) {
+        state.SkipWithError("cannot encode the stream");
+        return;
+    }
+    C2SoftCodecBenchmarkComponent decoder;
+    if (const char* error = decoder.init()) {
+        state.SkipWithError(error);
+        return;
+    }
+    int64_t queued = 0;
+    if (!decoder.queue(stream.csd, C2FrameData::FLAG_CODEC_CONFIG, 0)) {
+        state.SkipWithError("cannot queue the codec config");
+        return;
+    }
+    int64_t frames = 0;
+    for (auto _ : state) {
+        for (const std::vector<uint8_t>& frame : stream.frames) {
+            if (!decoder.queue(frame, 0, queued++ * 1024 * 1000000ll / kSampleRate)) {
+                state.SkipWithError("queue failed");
+                return;
+            }
+        }
+        if (!decoder.waitForAll()) {
+            state.SkipWithError("decoding failed");
+            return;
+        }
+        frames += stream.frames.size();
+    }
+    state.SetItemsProcessed(frames);
+    state.counters["frames/s"] = benchmark::Counter(frames, benchmark::Counter::kIsRate);
+}
+
+}  // namespace
+
+static void BM_DecodeStereo(benchmark::State& state) {
+    runDecoder(state);
+}
+
+static void BM_Decode5_1(benchmark::State& state) {
+    runDecoder(state);
+}
+
+static void BM_Decode7_1(benchmark::State& state) {
+    runDecoder(state);
+}
+
+BENCHMARK(BM_DecodeStereo)->Args({2, MODE_2})->UseRealTime();
+BENCHMARK(BM_Decode5_1)->Args({6, MODE_1_2_2_1})->UseRealTime();
+BENCHMARK(BM_Decode7_1)->Args({8, MODE_1_2_2_2_1})->UseRealTime();
+
+BENCHMARK_MAIN();
@@ -0,0 +1,163 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_C2_SOFT_CODEC_BENCHMARK_H_
+#define ANDROID_C2_SOFT_CODEC_BENCHMARK_H_
+
+#include <string.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <C2ComponentFactory.h>
+#include <C2PlatformSupport.h>
+
+extern "C" ::C2ComponentFactory* CreateCodec2Factory();
+extern "C" void DestroyCodec2Factory(::C2ComponentFactory* factory);
+
+namespace android {
+
+// Component driver shared by the benchmarks of the software components. It runs the component
+// of the factory linked into the benchmark.
+class C2SoftCodecBenchmarkComponent {
+public:
+    ~C2SoftCodecBenchmarkComponent() {
+        if (mComponent) {
+            mComponent->release();
+            mComponent.reset();
+        }
+        if (mFactory) {
+            DestroyCodec2Factory(mFactory);
+        }
+    }
+
+    // Creates the component, applies |params| and starts it.
+    // Returns nullptr on success, or the error to report.
+    const char* init(const std::vector<C2Param*>& params = {}) {
+        mFactory = CreateCodec2Factory();
+        if (mFactory == nullptr
+                || mFactory->createComponent(0, &mComponent) != C2_OK) {
+            return "cannot create the component";
+        }
+        if (GetCodec2BlockPool(C2BlockPool::BASIC_LINEAR, nullptr, &mPool) != C2_OK) {
+            return "cannot get the basic linear block pool";
+        }
+        std::vector<std::unique_ptr<C2SettingResult>> failures;
+        if (!params.empty()
+                && mComponent->intf()->config_vb(params, C2_MAY_BLOCK, &failures) != C2_OK) {
+            return "cannot configure the component";
+        }
+        mListener = std::make_shared<Listener>();
+        if (mComponent->setListener_vb(mListener, C2_MAY_BLOCK) != C2_OK
+                || mComponent->start() != C2_OK) {
+            return "cannot start the component";
+        }
+        return nullptr;
+    }
+
+    bool queue(const uint8_t* data, size_t size, uint32_t flags, int64_t timestampUs) {
+        std::shared_ptr<C2LinearBlock> block;
+        if (mPool->fetchLinearBlock(
+                size, {C2MemoryUsage::CPU_READ, C2MemoryUsage::CPU_WRITE}, &block) != C2_OK) {
+            return false;
+        }
+        C2WriteView view = block->map().get();
+        if (view.error() != C2_OK) {
+            return false;
+        }
+        memcpy(view.base(), data, size);
+
+        std::unique_ptr<C2Work> work = std::make_unique<C2Work>();
+        work->input.flags = (C2FrameData::flags_t)flags;
+        work->input.ordinal.timestamp = timestampUs;
+        work->input.ordinal.frameIndex = mQueued;
+        work->input.buffers.push_back(
+                C2Buffer::CreateLinearBuffer(block->share(0, size, C2Fence())));
+        work->worklets.emplace_back(new C2Worklet);
+        std::list<std::unique_ptr<C2Work>> items;
+        items.push_back(std::move(work));
+        ++mQueued;
+        return mComponent->queue_nb(&items) == C2_OK;
+    }
+
+    bool queue(const std::vector<uint8_t>& data, uint32_t flags, int64_t timestampUs) {
+        return queue(data.data(), data.size(), flags, timestampUs);
+    }
+
+    // Waits until all the queued works are done, or returns false on error or time out.
+    bool waitForAll() { return mListener->waitForDone(mQueued); }
+
+private:
+    static constexpr auto kTimeout = std::chrono::seconds(5);
+
+    class Listener : public C2Component::Listener {
+    public:
+        void onWorkDone_nb(std::weak_ptr<C2Component>,
+                           std::list<std::unique_ptr<C2Work>> workItems) override {
+            std::lock_guard lock(mLock);
+            for (const std::unique_ptr<C2Work>& work : workItems) {
+                if (work->result != C2_OK) {
+                    mError = true;
+                }
+                // Encoders send the outputs of a work as they come, ahead of the work itself;
+                // only count the latter.
+                if (work->worklets.empty()
+                        || !(work->worklets.front()->output.flags
+                                & C2FrameData::FLAG_INCOMPLETE)) {
+                    ++mDone;
+                }
+            }
+            mCondition.notify_all();
+        }
+
+        void onTripped_nb(std::weak_ptr<C2Component>,
+                          std::vector<std::shared_ptr<C2SettingResult>>) override {
+        }
+
+        void onError_nb(std::weak_ptr<C2Component>, uint32_t) override {
+            std::lock_guard lock(mLock);
+            mError = true;
+            mCondition.notify_all();
+        }
+
+        bool waitForDone(int64_t count) {
+            std::unique_lock lock(mLock);
+            return mCondition.wait_for(lock, kTimeout, [this, count] {
+                return mError || mDone >= count;
+            }) && !mError;
+        }
+
+    private:
+        std::mutex mLock;
+        std::condition_variable mCondition;
+        int64_t mDone = 0;
+        bool mError = false;
+    };
+
+    ::C2ComponentFactory* mFactory = nullptr;
+    std::shared_ptr<C2Component> mComponent;
+    std::shared_ptr<C2BlockPool> mPool;
+    std::shared_ptr<Listener> mListener;
+    int64_t mQueued = 0;
+};
+
+}  // namespace android
+
+#endif  // ANDROID_C2_SOFT_CODEC_BENCHMARK_H_
@@ -0,0 +1,165 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Benchmark of the decoding of C2SoftOpusDec for 48 kHz stereo and first order ambisonics
+// streams, reporting decoded frames per second. The streams are encoded at start up with the
+// libopus multistream encoder from a synthesized signal, so no resource file is needed.
+
+#include <math.h>
+
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "C2SoftCodecBenchmark.h"
+
+extern "C" {
+    #include <opus.h>
+    #include <opus_multistream.h>
+}
+
+using namespace android;
+
+namespace {
+
+constexpr int kSampleRate = 48000;
+constexpr int kFrameSize = 960;  // 20 ms
+constexpr int kFramesPerIteration = 100;  // 2 s
+constexpr int kMaxChannels = 8;
+constexpr uint64_t kSeekPreRollNs = 80000000;  // 80 ms
+
+struct EncodedStream {
+    std::vector<uint8_t> head;
+    uint64_t codecDelayNs;
+    std::vector<std::vector<uint8_t>> frames;
+};
+
+// Writes the identification header of https://wiki.xiph.org/OggOpus#ID_Header.
+void writeHead(int channels, int mappingFamily, int streams, int coupled,
+               const uint8_t* mapping, int preSkip, std::vector<uint8_t>* head) {
+    const uint8_t header[19] = {
+        'O', 'p', 'u', 's', 'H', 'e', 'a', 'd',
+        1, (uint8_t)channels,
+        (uint8_t)preSkip, (uint8_t)(preSkip >> 8),
+        (uint8_t)kSampleRate, (uint8_t)(kSampleRate >> 8),
+        (uint8_t)(kSampleRate >> 16), (uint8_t)(kSampleRate >> 24),
+        0, 0,  // gain
+        (uint8_t)mappingFamily,
+    };
+    head->assign(header, header + sizeof(header));
+    if (mappingFamily != 0) {
+        head->push_back(streams);
+        head->push_back(coupled);
+        head->insert(head->end(), mapping, mapping + channels);
+    }
+}
+
+// Encodes kFramesPerIteration frames of a tone per channel.
+bool encodeStream(int channels, int mappingFamily, EncodedStream* stream) {
+    int streams = 0;
+    int coupled = 0;
+    uint8_t mapping[kMaxChannels];
+    int error = OPUS_OK;
+    OpusMSEncoder* encoder = opus_multistream_surround_encoder_create(
+            kSampleRate, channels, mappingFamily, &streams, &coupled, mapping,
+            OPUS_APPLICATION_AUDIO, &error);
+    if (encoder == nullptr || error != OPUS_OK) {
+        return false;
+    }
+    opus_int32 lookahead = 0;
+    bool ok = opus_multistream_encoder_ctl(encoder, OPUS_SET_BITRATE(64000 * channels)) == OPUS_OK
+            && opus_multistream_encoder_ctl(encoder, OPUS_GET_LOOKAHEAD(&lookahead)) == OPUS_OK;
+    if (ok) {
+        writeHead(channels, mappingFamily, streams, coupled, mapping, lookahead, &stream->head);
+        stream->codecDelayNs = lookahead * 1000000000ll / kSampleRate;
+        std::vector<opus_int16> pcm(kFrameSize * channels);
+        std::vector<uint8_t> out(4000 * channels);
+        int64_t sample = 0;
+        while (ok && stream->frames.size() < (size_t)kFramesPerIteration) {
+            for (int i = 0; i < kFrameSize; ++i, ++sample) {
+                for (int ch = 0; ch < channels; ++ch) {
+                    pcm[i * channels + ch] = (opus_int16)(8000 * sin(
+                            2 * M_PI * (220 + 110 * ch) * sample / kSampleRate));
+                }
+            }
+            opus_int32 size = opus_multistream_encode(
+                    encoder, pcm.data(), kFrameSize, out.data(), out.size());
+            ok = size > 0;
+            if (ok) {
+                stream->frames.emplace_back(out.begin(), out.begin() + size);
+            }
+        }
+    }
+    opus_multistream_encoder_destroy(encoder);
+    return ok;
+}
+
+// Args: channel count, channel mapping family.
+void runDecoder(benchmark::State& state) {
+    const int channels = state.range(0);
+    EncodedStream stream;
+    if (!encodeStream(channels, state.range(1), &stream)) {
+        state.SkipWithError("cannot encode the stream");
+        return;
+    }
+    C2SoftCodecBenchmarkComponent decoder;
+    if (const char* error = decoder.init()) {
+        state.SkipWithError(error);
+        return;
+    }
+    if (!decoder.queue(stream.head, C2FrameData::FLAG_CODEC_CONFIG, 0)
+            || !decoder.queue((const uint8_t*)&stream.codecDelayNs, sizeof(uint64_t),
+                              C2FrameData::FLAG_CODEC_CONFIG, 0)
+            || !decoder.queue((const uint8_t*)&kSeekPreRollNs, sizeof(uint64_t),
+                              C2FrameData::FLAG_CODEC_CONFIG, 0)) {
+        state.SkipWithError("cannot queue the codec config");
+        return;
+    }
+    int64_t queued = 0;
+    int64_t frames = 0;
+    for (auto _ : state) {
+        for (const std::vector<uint8_t>& frame : stream.frames) {
+            // Start past 0, where the decoder discards the codec delay again.
+            if (!decoder.queue(frame, 0, ++queued * kFrameSize * 1000000ll / kSampleRate)) {
+                state.SkipWithError("queue failed");
+                return;
+            }
+        }
+        if (!decoder.waitForAll()) {
+            state.SkipWithError("decoding failed");
+            return;
+        }
+        frames += stream.frames.size();
+    }
+    state.SetItemsProcessed(frames);
+    state.counters["frames/s"] = benchmark::Counter(frames, benchmark::Counter::kIsRate);
+}
+
+}  // namespace
+
+static void BM_DecodeStereo(benchmark::State& state) {
+    runDecoder(state);
+}
+
+// First order ambisonics, as 4 uncoupled streams.
+static void BM_DecodeAmbisonics(benchmark::State& state) {
+    runDecoder(state);
+}
+
+BENCHMARK(BM_DecodeStereo)->Args({2, 0})->UseRealTime();
+BENCHMARK(BM_DecodeAmbisonics)->Args({4, 2})->UseRealTime();
+
+BENCHMARK_MAIN();
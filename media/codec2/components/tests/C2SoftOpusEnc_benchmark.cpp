@@ -0,0 +1,91 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Benchmark of the 48 kHz encoding of C2SoftOpusEnc for stereo and 4 channel input, reporting
+// encoded 20 ms frames per second. The input buffers hold 10, 20 or 40 ms of PCM, so that
+// frames are either split across input buffers or taken whole from them.
+
+#include <math.h>
+
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "C2SoftCodecBenchmark.h"
+
+using namespace android;
+
+namespace {
+
+constexpr int kSampleRate = 48000;
+constexpr int kFrameDurationMs = 20;  // default of the encoder
+constexpr int kDurationPerIterationMs = 2000;
+
+// Args: channel count, input buffer duration in ms.
+void runEncoder(benchmark::State& state) {
+    const int channels = state.range(0);
+    const int bufferMs = state.range(1);
+    const size_t bufferSamples = kSampleRate * bufferMs / 1000;
+
+    std::vector<int16_t> pcm(bufferSamples * channels);
+    for (size_t i = 0; i < bufferSamples; ++i) {
+        for (int ch = 0; ch < channels; ++ch) {
+            pcm[i * channels + ch] = (int16_t)(8000 * sin(
+                    2 * M_PI * (220 + 110 * ch) * i / kSampleRate));
+        }
+    }
+    C2StreamSampleRateInfo::input sampleRate(0u, kSampleRate);
+    C2StreamChannelCountInfo::input channelCount(0u, channels);
+    C2StreamBitrateInfo::output bitrate(0u, 64000 * channels);
+    C2SoftCodecBenchmarkComponent encoder;
+    if (const char* error = encoder.init({&sampleRate, &channelCount, &bitrate})) {
+        state.SkipWithError(error);
+        return;
+    }
+    int64_t queued = 0;
+    int64_t frames = 0;
+    for (auto _ : state) {
+        for (int i = 0; i < kDurationPerIterationMs / bufferMs; ++i) {
+            if (!encoder.queue((const uint8_t*)pcm.data(), pcm.size() * sizeof(int16_t), 0,
+                               queued++ * bufferMs * 1000ll)) {
+                state.SkipWithError("queue failed");
+                return;
+            }
+        }
+        if (!encoder.waitForAll()) {
+            state.SkipWithError("encoding failed");
+            return;
+        }
+        frames += kDurationPerIterationMs / kFrameDurationMs;
+    }
+    state.SetItemsProcessed(frames);
+    state.counters["frames/s"] = benchmark::Counter(frames, benchmark::Counter::kIsRate);
+}
+
+}  // namespace
+
+static void BM_EncodeStereo(benchmark::State& state) {
+    runEncoder(state);
+}
+
+static void BM_Encode4Channels(benchmark::State& state) {
+    runEncoder(state);
+}
+
+BENCHMARK(BM_EncodeStereo)->ArgsProduct({{2}, {10, 20, 40}})->UseRealTime();
+BENCHMARK(BM_Encode4Channels)->ArgsProduct({{4}, {10, 20, 40}})->UseRealTime();
+
+BENCHMARK_MAIN();
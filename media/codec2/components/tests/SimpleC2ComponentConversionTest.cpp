@@ -0,0 +1,301 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Compares the vectorized YUV conversions of SimpleC2Component against scalar references.
+
+#include <stdlib.h>
+
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <tuple>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <C2Config.h>
+#include <Codec2CommonUtils.h>
+#include <SimpleC2Component.h>
+
+using namespace android;
+
+namespace {
+
+constexpr uint16_t kNeutralUVBitDepth10 = 512;
+
+// Allowed difference per 10-bit RGB channel, as libyuv uses less precise coefficients.
+constexpr int32_t kMaxRgbError = 8;
+
+void referenceYUV420Planar16ToYV12(uint8_t *dstY, uint8_t *dstU, uint8_t *dstV,
+                                   const uint16_t *srcY, const uint16_t *srcU,
+                                   const uint16_t *srcV, size_t srcYStride, size_t srcUStride,
+                                   size_t srcVStride, size_t dstYStride, size_t dstUVStride,
+                                   size_t width, size_t height) {
+    for (size_t y = 0; y < height; ++y) {
+        for (size_t x = 0; x < width; ++x) {
+            dstY[x] = (uint8_t)(srcY[x] >> 2);
+        }
+        srcY += srcYStride;
+        dstY += dstYStride;
+    }
+    for (size_t y = 0; y < (height + 1) / 2; ++y) {
+        for (size_t x = 0; x < (width + 1) / 2; ++x) {
+            dstU[x] = (uint8_t)(srcU[x] >> 2);
+            dstV[x] = (uint8_t)(srcV[x] >> 2);
+        }
+        srcU += srcUStride;
+        srcV += srcVStride;
+        dstU += dstUVStride;
+        dstV += dstUVStride;
+    }
+}
+
+void referenceYUV420Planar16ToP010(uint16_t *dstY, uint16_t *dstUV, const uint16_t *srcY,
+                                   const uint16_t *srcU, const uint16_t *srcV,
+                                   size_t srcYStride, size_t srcUStride, size_t srcVStride,
+                                   size_t dstYStride, size_t dstUVStride, size_t width,
+                                   size_t height) {
+    for (size_t y = 0; y < height; ++y) {
+        for (size_t x = 0; x < width; ++x) {
+            dstY[x] = srcY[x] << 6;
+        }
+        srcY += srcYStride;
+        dstY += dstYStride;
+    }
+    for (size_t y = 0; y < (height + 1) / 2; ++y) {
+        for (size_t x = 0; x < (width + 1) / 2; ++x) {
+            dstUV[2 * x] = srcU[x] << 6;
+            dstUV[2 * x + 1] = srcV[x] << 6;
+        }
+        srcU += srcUStride;
+        srcV += srcVStride;
+        dstUV += dstUVStride;
+    }
+}
+
+void referenceP010ToYUV420Planar16(uint16_t *dstY, uint16_t *dstU, uint16_t *dstV,
+                                   const uint16_t *srcY, const uint16_t *srcUV,
+                                   size_t srcYStride, size_t srcUVStride, size_t dstYStride,
+                                   size_t dstUStride, size_t dstVStride, size_t width,
+                                   size_t height) {
+    for (size_t y = 0; y < height; ++y) {
+        for (size_t x = 0; x < width; ++x) {
+            dstY[x] = srcY[x] >> 6;
+        }
+        srcY += srcYStride;
+        dstY += dstYStride;
+    }
+    for (size_t y = 0; y < (height + 1) / 2; ++y) {
+        for (size_t x = 0; x < (width + 1) / 2; ++x) {
+            dstU[x] = srcUV[2 * x] >> 6;
+            dstV[x] = srcUV[2 * x + 1] >> 6;
+        }
+        dstU += dstUStride;
+        dstV += dstVStride;
+        srcUV += srcUVStride;
+    }
+}
+
+// Limited range BT.709 and BT.2020 coefficients of the scalar conversion.
+void referenceYUV420Planar16ToRGBA1010102(uint32_t *dst, const uint16_t *srcY,
+                                          const uint16_t *srcU, const uint16_t *srcV,
+                                          size_t srcYStride, size_t srcUStride,
+                                          size_t srcVStride, size_t dstStride, size_t width,
+                                          size_t height, C2Color::matrix_t matrix) {
+    const bool bt709 = matrix == C2Color::MATRIX_BT709;
+    const int32_t cY = 1196;
+    const int32_t cRV = bt709 ? 1841 : 1724;
+    const int32_t cGU = bt709 ? 219 : 192;
+    const int32_t cGV = bt709 ? 547 : 668;
+    const int32_t cBU = bt709 ? 2169 : 2200;
+    for (size_t y = 0; y < height; ++y) {
+        for (size_t x = 0; x < width; ++x) {
+            const int32_t u = srcU[(y / 2) * srcUStride + x / 2] - 512;
+            const int32_t v = srcV[(y / 2) * srcVStride + x / 2] - 512;
+            const int32_t yMult = (srcY[y * srcYStride + x] - 64) * cY + 512;
+            const int32_t b = std::clamp((yMult + u * cBU) / 1024, 0, 1023);
+            const int32_t g = std::clamp((yMult - v * cGV - u * cGU) / 1024, 0, 1023);
+            const int32_t r = std::clamp((yMult + v * cRV) / 1024, 0, 1023);
+            dst[y * dstStride + x] = 3u << 30 | (b << 20) | (g << 10) | r;
+        }
+    }
+}
+
+template<typename T>
+std::vector<T> randomPlane(size_t stride, size_t height, uint32_t max, std::mt19937 *random) {
+    std::uniform_int_distribution<uint32_t> distribution(0, max);
+    std::vector<T> plane(stride * height);
+    for (T &value : plane) {
+        value = distribution(*random);
+    }
+    return plane;
+}
+
+// Width and height, including odd sizes and sizes that are not a multiple of the vectors.
+class ConversionTest : public ::testing::TestWithParam<std::tuple<size_t, size_t>> {
+protected:
+    void SetUp() override {
+        std::tie(mWidth, mHeight) = GetParam();
+        mChromaWidth = (mWidth + 1) / 2;
+        mChromaHeight = (mHeight + 1) / 2;
+        // Strides larger than the rows, to catch reads and writes past the row ends.
+        mStride = mWidth + 24;
+        mChromaStride = mChromaWidth + 16;
+    }
+
+    size_t mWidth;
+    size_t mHeight;
+    size_t mChromaWidth;
+    size_t mChromaHeight;
+    size_t mStride;
+    size_t mChromaStride;
+    std::mt19937 mRandom{42};
+};
+
+TEST_P(ConversionTest, YUV420Planar16ToYV12) {
+    auto srcY = randomPlane<uint16_t>(mStride, mHeight, 1023, &mRandom);
+    auto srcU = randomPlane<uint16_t>(mChromaStride, mChromaHeight, 1023, &mRandom);
+    auto srcV = randomPlane<uint16_t>(mChromaStride, mChromaHeight, 1023, &mRandom);
+    std::vector<uint8_t> dst(mStride * mHeight + 2 * mChromaStride * mChromaHeight, 0xA5);
+    std::vector<uint8_t> ref = dst;
+
+    auto convert = [&](std::vector<uint8_t> &out, bool reference) {
+        uint8_t *dstY = out.data();
+        uint8_t *dstV = dstY + mStride * mHeight;
+        uint8_t *dstU = dstV + mChromaStride * mChromaHeight;
+        if (reference) {
+            referenceYUV420Planar16ToYV12(dstY, dstU, dstV, srcY.data(), srcU.data(),
+                                          srcV.data(), mStride, mChromaStride, mChromaStride,
+                                          mStride, mChromaStride, mWidth, mHeight);
+        } else {
+            convertYUV420Planar16ToYV12(dstY, dstU, dstV, srcY.data(), srcU.data(),
+                                        srcV.data(), mStride, mChromaStride, mChromaStride,
+                                        mStride, mChromaStride, mWidth, mHeight);
+        }
+    };
+    convert(dst, false);
+    convert(ref, true);
+    EXPECT_EQ(ref, dst);
+}
+
+TEST_P(ConversionTest, YUV420Planar16ToP010) {
+    auto srcY = randomPlane<uint16_t>(mStride, mHeight, 1023, &mRandom);
+    auto srcU = randomPlane<uint16_t>(mChromaStride, mChromaHeight, 1023, &mRandom);
+    auto srcV = randomPlane<uint16_t>(mChromaStride, mChromaHeight, 1023, &mRandom);
+    const size_t uvStride = 2 * mChromaStride;
+    std::vector<uint16_t> dst(mStride * mHeight + uvStride * mChromaHeight, 0xA5A5);
+    std::vector<uint16_t> ref = dst;
+
+    convertYUV420Planar16ToP010(dst.data(), dst.data() + mStride * mHeight, srcY.data(),
+                                srcU.data(), srcV.data(), mStride, mChromaStride, mChromaStride,
+                                mStride, uvStride, mWidth, mHeight);
+    referenceYUV420Planar16ToP010(ref.data(), ref.data() + mStride * mHeight, srcY.data(),
+                                  srcU.data(), srcV.data(), mStride, mChromaStride,
+                                  mChromaStride, mStride, uvStride, mWidth, mHeight);
+    EXPECT_EQ(ref, dst);
+}
+
+TEST_P(ConversionTest, YUV420Planar16ToP010Monochrome) {
+    auto srcY = randomPlane<uint16_t>(mStride, mHeight, 1023, &mRandom);
+    const size_t uvStride = 2 * mChromaStride;
+    std::vector<uint16_t> dst(mStride * mHeight + uvStride * mChromaHeight, 0xA5A5);
+
+    convertYUV420Planar16ToP010(dst.data(), dst.data() + mStride * mHeight, srcY.data(),
+                                nullptr, nullptr, mStride, 0, 0, mStride, uvStride, mWidth,
+                                mHeight, true /* isMonochrome */);
+    for (size_t y = 0; y < mHeight; ++y) {
+        for (size_t x = 0; x < mWidth; ++x) {
+            ASSERT_EQ(srcY[y * mStride + x] << 6, dst[y * mStride + x]);
+        }
+    }
+    const uint16_t *dstUV = dst.data() + mStride * mHeight;
+    for (size_t y = 0; y < mChromaHeight; ++y) {
+        for (size_t x = 0; x < 2 * mChromaWidth; ++x) {
+            ASSERT_EQ(kNeutralUVBitDepth10 << 6, dstUV[y * uvStride + x]);
+        }
+    }
+}
+
+TEST_P(ConversionTest, P010ToYUV420Planar16) {
+    auto srcY = randomPlane<uint16_t>(mStride, mHeight, 0xFFFF, &mRandom);
+    auto srcUV = randomPlane<uint16_t>(2 * mChromaStride, mChromaHeight, 0xFFFF, &mRandom);
+    std::vector<uint16_t> dst(mStride * mHeight + 2 * mChromaStride * mChromaHeight, 0xA5A5);
+    std::vector<uint16_t> ref = dst;
+
+    auto convert = [&](std::vector<uint16_t> &out, bool reference) {
+        uint16_t *dstY = out.data();
+        uint16_t *dstU = dstY + mStride * mHeight;
+        uint16_t *dstV = dstU + mChromaStride * mChromaHeight;
+        if (reference) {
+            referenceP010ToYUV420Planar16(dstY, dstU, dstV, srcY.data(), srcUV.data(),
+                                          mStride, 2 * mChromaStride, mStride, mChromaStride,
+                                          mChromaStride, mWidth, mHeight);
+        } else {
+            convertP010ToYUV420Planar16(dstY, dstU, dstV, srcY.data(), srcUV.data(), mStride,
+                                        2 * mChromaStride, mStride, mChromaStride,
+                                        mChromaStride, mWidth, mHeight);
+        }
+    };
+    convert(dst, false);
+    convert(ref, true);
+    EXPECT_EQ(ref, dst);
+}
+
+TEST_P(ConversionTest, YUV420Planar16ToRGBA1010102) {
+    if (!isAtLeastT()) {
+        GTEST_SKIP() << "Y410 is used before Android T";
+    }
+    // The conversion writes two rows at a time.
+    const size_t height = mHeight + (mHeight & 1);
+    auto srcY = randomPlane<uint16_t>(mStride, height, 1023, &mRandom);
+    auto srcU = randomPlane<uint16_t>(mChromaStride, mChromaHeight, 1023, &mRandom);
+    auto srcV = randomPlane<uint16_t>(mChromaStride, mChromaHeight, 1023, &mRandom);
+
+    for (C2Color::matrix_t matrix : {C2Color::MATRIX_BT709, C2Color::MATRIX_BT2020}) {
+        auto aspects = std::make_shared<C2ColorAspectsStruct>(
+                C2Color::RANGE_LIMITED, C2Color::PRIMARIES_UNSPECIFIED,
+                C2Color::TRANSFER_UNSPECIFIED, matrix);
+        std::vector<uint32_t> dst(mStride * height);
+        std::vector<uint32_t> ref(mStride * height);
+        convertYUV420Planar16ToY410OrRGBA1010102(dst.data(), srcY.data(), srcU.data(),
+                                                 srcV.data(), mStride, mChromaStride,
+                                                 mChromaStride, mStride, mWidth, mHeight,
+                                                 aspects);
+        referenceYUV420Planar16ToRGBA1010102(ref.data(), srcY.data(), srcU.data(), srcV.data(),
+                                             mStride, mChromaStride, mChromaStride, mStride,
+                                             mWidth, mHeight, matrix);
+        for (size_t y = 0; y < mHeight; ++y) {
+            for (size_t x = 0; x < mWidth; ++x) {
+                const uint32_t actual = dst[y * mStride + x];
+                const uint32_t expected = ref[y * mStride + x];
+                ASSERT_EQ(expected >> 30, actual >> 30) << "alpha at " << x << "," << y;
+                for (int shift = 0; shift < 30; shift += 10) {
+                    const int32_t a = (actual >> shift) & 0x3FF;
+                    const int32_t e = (expected >> shift) & 0x3FF;
+                    ASSERT_LE(abs(a - e), kMaxRgbError)
+                            << "channel " << shift / 10 << " at " << x << "," << y;
+                }
+            }
+        }
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(Sizes, ConversionTest,
+                         ::testing::Values(std::make_tuple(2, 2), std::make_tuple(33, 17),
+                                           std::make_tuple(176, 144),
+                                           std::make_tuple(1920, 1080)));
+
+}  // namespace
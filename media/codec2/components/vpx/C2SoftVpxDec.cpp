@@ -479,6 +479,12 @@ status_t C2SoftVpxDec::initDecoder() {
     }
 
     if (mMode == MODE_VP9) {
+        // libvpx no longer implements frame threading. Row based multi-threading lets the
+        // decoder threads work on streams with few tiles, as most high resolution ones.
+        if (mCoreCount > 1 && (vpx_err = vpx_codec_control(mCodecCtx, VP9D_SET_ROW_MT, 1))) {
+            ALOGW("on2 decoder failed to enable row based multi-threading. (%d)", vpx_err);
+        }
+
         using namespace std::string_literals;
         for (int i = 0; i < mCoreCount; ++i) {
             sp<ConverterThread> thread(new ConverterThread(mQueue));
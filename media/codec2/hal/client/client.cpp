@@ -38,6 +38,7 @@
 #include <codec2/hidl/1.1/types.h>
 #include <codec2/hidl/1.2/types.h>
 #include <codec2/hidl/output.h>
+#include <media/stagefright/foundation/MediaTrace.h>
 
 #include <cutils/native_handle.h>
 #include <gui/bufferqueue/2.0/B2HGraphicBufferProducer.h>
@@ -166,6 +167,106 @@ public:
     }
 };
 
+// This class caches the interface data that cannot change while a service is
+// alive: the supported params and the possible values of the fields of each
+// component, and the struct descriptors of the service. Creating a component
+// or an interface with a name that was seen before then does not need these
+// round trips again. The data of a service is dropped when the service dies
+// (see Codec2Client::Cache::invalidate()).
+class InterfaceCache {
+public:
+    static InterfaceCache& Get() {
+        static InterfaceCache sCache;
+        return sCache;
+    }
+
+    bool getSupportedParams(
+            C2String const& serviceName,
+            C2String const& name,
+            std::vector<std::shared_ptr<C2ParamDescriptor>>* const params) {
+        std::scoped_lock lock{mMutex};
+        Service& service = mServices[serviceName];
+        auto it = service.supportedParams.find(name);
+        if (it == service.supportedParams.end()) {
+            return false;
+        }
+        params->insert(params->end(), it->second.begin(), it->second.end());
+        return true;
+    }
+
+    void putSupportedParams(
+            C2String const& serviceName,
+            C2String const& name,
+            std::vector<std::shared_ptr<C2ParamDescriptor>> const& params) {
+        std::scoped_lock lock{mMutex};
+        mServices[serviceName].supportedParams.emplace(name, params);
+    }
+
+    bool getPossibleValues(
+            C2String const& serviceName,
+            C2String const& name,
+            C2FieldSupportedValuesQuery* const query) {
+        std::scoped_lock lock{mMutex};
+        Service& service = mServices[serviceName];
+        auto it = service.possibleValues.find({name, query->field()});
+        if (it == service.possibleValues.end()) {
+            return false;
+        }
+        query->values = it->second;
+        query->status = C2_OK;
+        return true;
+    }
+
+    void putPossibleValues(
+            C2String const& serviceName,
+            C2String const& name,
+            C2FieldSupportedValuesQuery const& query) {
+        std::scoped_lock lock{mMutex};
+        mServices[serviceName].possibleValues.emplace(
+                std::make_pair(name, query.field()), query.values);
+    }
+
+    std::unique_ptr<C2StructDescriptor> getStructDescriptor(
+            C2String const& serviceName,
+            C2Param::CoreIndex coreIndex) {
+        std::scoped_lock lock{mMutex};
+        Service& service = mServices[serviceName];
+        auto it = service.structDescriptors.find(coreIndex.coreIndex());
+        if (it == service.structDescriptors.end()) {
+            return nullptr;
+        }
+        return std::make_unique<C2StructDescriptor>(*it->second);
+    }
+
+    void putStructDescriptor(
+            C2String const& serviceName,
+            C2Param::CoreIndex coreIndex,
+            C2StructDescriptor const& descriptor) {
+        std::scoped_lock lock{mMutex};
+        mServices[serviceName].structDescriptors.emplace(
+                coreIndex.coreIndex(),
+                std::make_shared<C2StructDescriptor>(descriptor));
+    }
+
+    void invalidate(C2String const& serviceName) {
+        std::scoped_lock lock{mMutex};
+        mServices.erase(serviceName);
+    }
+
+private:
+    struct Service {
+        std::map<C2String, std::vector<std::shared_ptr<C2ParamDescriptor>>>
+                supportedParams;
+        std::map<std::pair<C2String, C2ParamField>, C2FieldSupportedValues>
+                possibleValues;
+        std::map<uint32_t, std::shared_ptr<const C2StructDescriptor>>
+                structDescriptors;
+    };
+
+    std::mutex mMutex;
+    std::map<C2String, Service> mServices;
+};
+
 }  // unnamed namespace
 
 // This class caches a Codec2Client object and its component traits. The client
@@ -215,6 +316,7 @@ public:
     void invalidate() {
         std::scoped_lock lock{mClientMutex};
         mClient = nullptr;
+        InterfaceCache::Get().invalidate(GetServiceNames()[mIndex]);
     }
 
     // Returns a list of traits for components supported by the service. This
@@ -420,12 +522,18 @@ c2_status_t Codec2ConfigurableClient::config(
 
 c2_status_t Codec2ConfigurableClient::querySupportedParams(
         std::vector<std::shared_ptr<C2ParamDescriptor>>* const params) const {
-    // TODO: Cache and query properly!
+    bool cached = !mServiceName.empty();
+    if (cached && InterfaceCache::Get().getSupportedParams(
+            mServiceName, mName, params)) {
+        return C2_OK;
+    }
+    size_t numParams = params->size();
+    bool complete = false;
     c2_status_t status;
     Return<void> transStatus = mBase->querySupportedParams(
             std::numeric_limits<uint32_t>::min(),
             std::numeric_limits<uint32_t>::max(),
-            [&status, params](
+            [&status, &complete, params](
                     Status s,
                     const hidl_vec<ParamDescriptor>& p) {
                 status = static_cast<c2_status_t>(s);
@@ -443,17 +551,57 @@ c2_status_t Codec2ConfigurableClient::querySupportedParams(
                         return;
                     }
                 }
+                complete = true;
             });
     if (!transStatus.isOk()) {
         LOG(ERROR) << "querySupportedParams -- transaction failed.";
         return C2_TRANSACTION_FAILED;
     }
+    if (cached && complete) {
+        InterfaceCache::Get().putSupportedParams(
+                mServiceName, mName,
+                std::vector<std::shared_ptr<C2ParamDescriptor>>(
+                        params->begin() + numParams, params->end()));
+    }
     return status;
 }
 
 c2_status_t Codec2ConfigurableClient::querySupportedValues(
         std::vector<C2FieldSupportedValuesQuery>& fields,
         c2_blocking_t mayBlock) const {
+    if (mServiceName.empty()) {
+        return querySupportedValuesFromService(fields, mayBlock);
+    }
+
+    // Possible values do not depend on the configuration: serve them from the
+    // cache, and only query the service for the others.
+    InterfaceCache& cache = InterfaceCache::Get();
+    std::vector<size_t> queried;
+    std::vector<C2FieldSupportedValuesQuery> queries;
+    for (size_t i = 0; i < fields.size(); ++i) {
+        if (fields[i].type() != C2FieldSupportedValuesQuery::POSSIBLE
+                || !cache.getPossibleValues(mServiceName, mName, &fields[i])) {
+            queried.push_back(i);
+            queries.push_back(fields[i]);
+        }
+    }
+    if (queries.empty()) {
+        return C2_OK;
+    }
+    c2_status_t status = querySupportedValuesFromService(queries, mayBlock);
+    for (size_t i = 0; i < queries.size(); ++i) {
+        fields[queried[i]] = queries[i];
+        if (status == C2_OK && queries[i].status == C2_OK
+                && queries[i].type() == C2FieldSupportedValuesQuery::POSSIBLE) {
+            cache.putPossibleValues(mServiceName, mName, queries[i]);
+        }
+    }
+    return status;
+}
+
+c2_status_t Codec2ConfigurableClient::querySupportedValuesFromService(
+        std::vector<C2FieldSupportedValuesQuery>& fields,
+        c2_blocking_t mayBlock) const {
     hidl_vec<FieldSupportedValuesQuery> inFields(fields.size());
     for (size_t i = 0; i < fields.size(); ++i) {
         if (!objcpy(&inFields[i], fields[i])) {
@@ -725,6 +873,8 @@ c2_status_t Codec2Client::createComponent(
         return C2_CORRUPTED;
     }
 
+    (*component)->mServiceName = getServiceName();
+
     status = (*component)->setDeathListener(*component, listener);
     if (status != C2_OK) {
         LOG(ERROR) << "createComponent(" << name.c_str()
@@ -766,6 +916,9 @@ c2_status_t Codec2Client::createInterface(
         return status;
     }
 
+    if (*interface) {
+        (*interface)->mServiceName = getServiceName();
+    }
     return status;
 }
 
@@ -842,6 +995,11 @@ std::shared_ptr<C2ParamReflector>
     // should reflect the HAL API.
     struct SimpleParamReflector : public C2ParamReflector {
         virtual std::unique_ptr<C2StructDescriptor> describe(C2Param::CoreIndex coreIndex) const {
+            std::unique_ptr<C2StructDescriptor> cached =
+                    InterfaceCache::Get().getStructDescriptor(mServiceName, coreIndex);
+            if (cached) {
+                return cached;
+            }
             hidl_vec<ParamIndex> indices(1);
             indices[0] = static_cast<ParamIndex>(coreIndex.coreIndex());
             std::unique_ptr<C2StructDescriptor> descriptor;
@@ -880,16 +1038,21 @@ std::shared_ptr<C2ParamReflector>
                            << transStatus.description();
                 descriptor.reset();
             }
+            if (descriptor) {
+                InterfaceCache::Get().putStructDescriptor(
+                        mServiceName, coreIndex, *descriptor);
+            }
             return descriptor;
         }
 
-        SimpleParamReflector(sp<Base> base)
-            : mBase(base) { }
+        SimpleParamReflector(sp<Base> base, C2String const& serviceName)
+            : mBase(base), mServiceName(serviceName) { }
 
         sp<Base> mBase;
+        C2String mServiceName;
     };
 
-    return std::make_shared<SimpleParamReflector>(mBase1_0);
+    return std::make_shared<SimpleParamReflector>(mBase1_0, getServiceName());
 };
 
 std::vector<std::string> const& Codec2Client::GetServiceNames() {
@@ -1330,6 +1493,13 @@ void Codec2Client::Component::handleOnWorkDone(
 
 c2_status_t Codec2Client::Component::queue(
         std::list<std::unique_ptr<C2Work>>* const items) {
+#ifdef MEDIA_TRACE_ENABLE_CODEC
+    for (const std::unique_ptr<C2Work> &work : *items) {
+        MEDIA_TRACE_CODEC("Codec2Client::queue", getName().c_str(),
+                work->input.ordinal.customOrdinal.peekll(),
+                work->input.ordinal.frameIndex.peekll());
+    }
+#endif
     WorkBundle workBundle;
     if (!objcpy(&workBundle, *items, mBufferPoolSender.get())) {
         LOG(ERROR) << "queue -- bad input.";
@@ -133,8 +133,16 @@ struct Codec2ConfigurableClient {
     Codec2ConfigurableClient(const sp<Base>& base);
 
 protected:
+    c2_status_t querySupportedValuesFromService(
+            std::vector<C2FieldSupportedValuesQuery>& fields,
+            c2_blocking_t mayBlock) const;
+
     sp<Base> mBase;
     C2String mName;
+    // Name of the service hosting this component or interface. If set, the
+    // immutable interface data (supported params and possible values) is
+    // cached per service and component name.
+    C2String mServiceName;
 
     friend struct Codec2Client;
 };
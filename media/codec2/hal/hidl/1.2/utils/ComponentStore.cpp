@@ -23,6 +23,7 @@
 #include <codec2/hidl/1.2/types.h>
 
 #include <android-base/file.h>
+#include <bufferpool/ClientManager.h>
 #include <media/stagefright/bqhelper/GraphicBufferSource.h>
 #include <utils/Errors.h>
 
@@ -542,6 +543,11 @@ Return<void> ComponentStore::debug(
             }
         }
 
+        // Dump buffer pool statistics.
+        out << indent << "Buffer pools:" << std::endl << std::endl;
+        out << indent << indent << ::android::hardware::media::bufferpool::V2_0::
+                implementation::ClientManager::getStatsString() << std::endl << std::endl;
+
         out << "End of dump -- C2ComponentStore: "
                 << mStore->getName() << std::endl;
     }
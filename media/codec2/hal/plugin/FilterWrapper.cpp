@@ -16,8 +16,12 @@
 
 //#define LOG_NDEBUG 0
 #define LOG_TAG "Codec2-FilterWrapper"
+#define ATRACE_TAG ATRACE_TAG_VIDEO
 #include <android-base/logging.h>
+#include <android-base/properties.h>
+#include <utils/Trace.h>
 
+#include <chrono>
 #include <set>
 
 #include <dlfcn.h>
@@ -41,13 +45,103 @@ static constexpr uint32_t kTypesForLastFilter[] = {
     C2PortBlockPoolsTuning::output::PARAM_TYPE,
 };
 
+// In pipelined mode, the wrapped interface declares the frames held by the filter chain as
+// additional pipeline delay, so that the client keeps enough work in flight for the decoder
+// to decode frame N+1 while the filters process frame N.
+static bool IsPipelined() {
+    return base::GetBoolProperty("debug.codec2.filter_wrapper.pipelined", false);
+}
+
+// Number of frames after which the per-stage timings are logged.
+static constexpr uint64_t kStageTimingsLogInterval = 300;
+
+/**
+ * Per-stage timings of the wrapped decoder. Stage 0 is the decoder and stage i is the i-th
+ * running filter; the time of a stage spans from queueing the work to the component until
+ * the component returns it.
+ */
+class StageTimings {
+public:
+    explicit StageTimings(std::vector<std::string> &&names) : mStages(names.size()) {
+        for (size_t i = 0; i < names.size(); ++i) {
+            mStages[i].name = std::move(names[i]);
+            mStages[i].counterName = "FilterWrapper-" + mStages[i].name + "-us";
+        }
+    }
+
+    void onQueued(uint64_t frameIndex) {
+        std::unique_lock lock(mMutex);
+        mStageStart[frameIndex] = std::chrono::steady_clock::now();
+    }
+
+    void onStageDone(size_t stage, uint64_t frameIndex) {
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        std::unique_lock lock(mMutex);
+        auto it = mStageStart.find(frameIndex);
+        if (it == mStageStart.end() || stage >= mStages.size()) {
+            return;
+        }
+        int64_t durationUs = std::chrono::duration_cast<std::chrono::microseconds>(
+                now - it->second).count();
+        Stage &s = mStages[stage];
+        ++s.count;
+        s.totalUs += durationUs;
+        s.maxUs = std::max(s.maxUs, durationUs);
+        ATRACE_INT64(s.counterName.c_str(), durationUs);
+        if (stage + 1 < mStages.size()) {
+            it->second = now;
+            return;
+        }
+        mStageStart.erase(it);
+        if (s.count % kStageTimingsLogInterval == 0) {
+            logAndClear_l();
+        }
+    }
+
+    void onDropped(uint64_t frameIndex) {
+        std::unique_lock lock(mMutex);
+        mStageStart.erase(frameIndex);
+    }
+
+    void clear() {
+        std::unique_lock lock(mMutex);
+        mStageStart.clear();
+    }
+
+private:
+    struct Stage {
+        std::string name;
+        std::string counterName;
+        uint64_t count = 0;
+        int64_t totalUs = 0;
+        int64_t maxUs = 0;
+    };
+
+    std::mutex mMutex;
+    std::vector<Stage> mStages;
+    std::map<uint64_t, std::chrono::steady_clock::time_point> mStageStart;
+
+    void logAndClear_l() {
+        for (Stage &s : mStages) {
+            if (s.count == 0) {
+                continue;
+            }
+            LOG(DEBUG) << "stage timings: " << s.name << " avg=" << (s.totalUs / s.count)
+                    << "us max=" << s.maxUs << "us over " << s.count << " frames";
+            s.count = 0;
+            s.totalUs = 0;
+            s.maxUs = 0;
+        }
+    }
+};
+
 class WrappedDecoderInterface : public C2ComponentInterface {
 public:
     WrappedDecoderInterface(
             std::shared_ptr<C2ComponentInterface> intf,
             std::vector<FilterWrapper::Component> &&filters,
             std::weak_ptr<FilterWrapper> filterWrapper)
-        : mIntf(intf), mFilterWrapper(filterWrapper) {
+        : mIntf(intf), mFilterWrapper(filterWrapper), mPipelined(IsPipelined()) {
         takeFilters(std::move(filters));
         for (size_t i = 0; i < mFilters.size(); ++i) {
             mControlParamTypes.insert(
@@ -93,6 +187,7 @@ public:
         mFilters = std::move(filters);
         mTypeToIndexForQuery.clear();
         mTypeToIndexForConfig.clear();
+        mFiltersPipelineDelay = 0u;
         for (size_t i = 0; i < mFilters.size(); ++i) {
             if (i == 0) {
                 transferParams_l(mIntf, mFilters[0].intf, C2_MAY_BLOCK);
@@ -106,6 +201,7 @@ public:
             for (C2Param::Type type : mFilters[i].desc.affectedParams) {
                 mTypeToIndexForQuery[type.type()] = i;
             }
+            mFiltersPipelineDelay += queryFilterDelay_l(mFilters[i]);
         }
         for (size_t i = mFilters.size(); i > 0; --i) {
             if (i == 1) {
@@ -229,6 +325,15 @@ public:
                 std::make_move_iterator(heapParamsForIntf.begin()),
                 std::make_move_iterator(heapParamsForIntf.end()));
 
+        if (mPipelined && mFiltersPipelineDelay > 0u) {
+            for (C2Param *param : stackParamsForIntf) {
+                addFiltersPipelineDelay_l(param);
+            }
+            for (const std::unique_ptr<C2Param> &param : *heapParams) {
+                addFiltersPipelineDelay_l(param.get());
+            }
+        }
+
         return result;
     }
 
@@ -373,6 +478,34 @@ private:
     std::map<uint32_t, size_t> mTypeToIndexForQuery;
     std::map<uint32_t, size_t> mTypeToIndexForConfig;
     std::set<C2Param::Type> mControlParamTypes;
+    const bool mPipelined;
+    // Frames that the filters may hold on top of the decoder's own pipeline delay.
+    uint32_t mFiltersPipelineDelay = 0u;
+
+    uint32_t queryFilterDelay_l(const FilterWrapper::Component &filter) {
+        C2PortActualDelayTuning::input inputDelay(0u);
+        C2ActualPipelineDelayTuning pipelineDelay(0u);
+        C2PortActualDelayTuning::output outputDelay(0u);
+        c2_status_t err = filter.intf->query_vb(
+                {&inputDelay, &pipelineDelay, &outputDelay}, {}, C2_MAY_BLOCK, nullptr);
+        if (err != C2_OK && err != C2_BAD_INDEX) {
+            LOG(DEBUG) << "WrappedDecoderInterface: " << filter.traits.name
+                    << " returned error for query_vb; err=" << err;
+        }
+        // The filter processes one frame while the decoder produces the next one, on top of
+        // the frames the filter declares to hold itself.
+        uint32_t delay = 1u;
+        delay += inputDelay ? inputDelay.value : 0u;
+        delay += pipelineDelay ? pipelineDelay.value : 0u;
+        delay += outputDelay ? outputDelay.value : 0u;
+        return delay;
+    }
+
+    void addFiltersPipelineDelay_l(C2Param *param) const {
+        if (param && *param && param->type() == C2ActualPipelineDelayTuning::PARAM_TYPE) {
+            static_cast<C2ActualPipelineDelayTuning *>(param)->value += mFiltersPipelineDelay;
+        }
+    }
 
     c2_status_t transferParams_l(
             const std::shared_ptr<C2ComponentInterface> &curr,
@@ -507,6 +640,11 @@ public:
     }
 
     c2_status_t queue_nb(std::list<std::unique_ptr<C2Work>>* const items) override {
+        if (mStageTimings && items) {
+            for (const std::unique_ptr<C2Work> &work : *items) {
+                mStageTimings->onQueued(work->input.ordinal.frameIndex.peeku());
+            }
+        }
         return mComp->queue_nb(items);
     }
 
@@ -525,6 +663,9 @@ public:
             }
             flushedWork->splice(flushedWork->end(), filterFlushedWork);
         }
+        if (mStageTimings) {
+            mStageTimings->clear();
+        }
         return result;
     }
 
@@ -644,10 +785,14 @@ private:
         PassingListener(
                 std::shared_ptr<C2Component> wrappedComponent,
                 const std::shared_ptr<Listener> &wrappedComponentListener,
-                std::shared_ptr<C2Component> nextComponent)
+                std::shared_ptr<C2Component> nextComponent,
+                const std::shared_ptr<StageTimings> &stageTimings,
+                size_t stage)
             : mWrappedComponent(wrappedComponent),
               mWrappedComponentListener(wrappedComponentListener),
-              mNextComponent(nextComponent) {
+              mNextComponent(nextComponent),
+              mStageTimings(stageTimings),
+              mStage(stage) {
         }
 
         void onWorkDone_nb(
@@ -660,6 +805,7 @@ private:
                     // Next component unexpectedly released while the work is
                     // in-flight. Report C2_CORRUPTED to the client.
                     work->result = C2_CORRUPTED;
+                    mStageTimings->onDropped(work->input.ordinal.frameIndex.peeku());
                     failedWorkItems.push_back(std::move(work));
                 }
                 workItems.clear();
@@ -668,10 +814,12 @@ private:
                     const std::unique_ptr<C2Work> &work = *it;
                     if (work->result != C2_OK
                             || work->worklets.size() != 1) {
+                        mStageTimings->onDropped(work->input.ordinal.frameIndex.peeku());
                         failedWorkItems.push_back(std::move(*it));
                         it = workItems.erase(it);
                         continue;
                     }
+                    mStageTimings->onStageDone(mStage, work->input.ordinal.frameIndex.peeku());
                     C2FrameData &output = work->worklets.front()->output;
                     c2_cntr64_t customOrdinal = work->input.ordinal.customOrdinal;
                     work->input = std::move(output);
@@ -717,15 +865,21 @@ private:
         std::weak_ptr<C2Component> mWrappedComponent;
         std::weak_ptr<Listener> mWrappedComponentListener;
         std::weak_ptr<C2Component> mNextComponent;
+        std::shared_ptr<StageTimings> mStageTimings;
+        size_t mStage;
     };
 
     class LastListener : public Listener {
     public:
         LastListener(
                 std::shared_ptr<C2Component> wrappedComponent,
-                const std::shared_ptr<Listener> &wrappedComponentListener)
+                const std::shared_ptr<Listener> &wrappedComponentListener,
+                const std::shared_ptr<StageTimings> &stageTimings,
+                size_t stage)
             : mWrappedComponent(wrappedComponent),
-              mWrappedComponentListener(wrappedComponentListener) {
+              mWrappedComponentListener(wrappedComponentListener),
+              mStageTimings(stageTimings),
+              mStage(stage) {
         }
 
         void onWorkDone_nb(
@@ -734,6 +888,9 @@ private:
             if (mWrappedComponent.expired()) {
                 return;
             }
+            for (const std::unique_ptr<C2Work> &work : workItems) {
+                mStageTimings->onStageDone(mStage, work->input.ordinal.frameIndex.peeku());
+            }
             if (std::shared_ptr<Listener> wrappedComponentListener =
                     mWrappedComponentListener.lock()) {
                 wrappedComponentListener->onWorkDone_nb(
@@ -760,6 +917,8 @@ private:
     private:
         std::weak_ptr<C2Component> mWrappedComponent;
         std::weak_ptr<Listener> mWrappedComponentListener;
+        std::shared_ptr<StageTimings> mStageTimings;
+        size_t mStage;
     };
 
     std::shared_ptr<C2Component> mComp;
@@ -768,6 +927,7 @@ private:
     std::vector<FilterWrapper::Component> mRunningFilters;
     std::weak_ptr<FilterWrapper> mFilterWrapper;
     std::shared_ptr<Listener> mListener;
+    std::shared_ptr<StageTimings> mStageTimings;
 #if defined(LOG_NDEBUG) && !LOG_NDEBUG
     base::ScopedLogSeverity mScopedLogSeverity{base::VERBOSE};
 #endif
@@ -777,23 +937,35 @@ private:
             const std::shared_ptr<Listener> &listener,
             c2_blocking_t mayBlock) {
         if (filters.empty()) {
+            mStageTimings.reset();
             return mComp->setListener_vb(listener, mayBlock);
         }
+        std::vector<std::string> stageNames{mComp->intf()->getName()};
+        for (const FilterWrapper::Component &filter : filters) {
+            stageNames.push_back(filter.traits.name);
+        }
+        mStageTimings = std::make_shared<StageTimings>(std::move(stageNames));
         std::shared_ptr passingListener = std::make_shared<PassingListener>(
                 shared_from_this(),
                 listener,
-                filters.front().comp);
+                filters.front().comp,
+                mStageTimings,
+                0 /* stage */);
         mComp->setListener_vb(passingListener, mayBlock);
         for (size_t i = 0; i < filters.size() - 1; ++i) {
             filters[i].comp->setListener_vb(
                     std::make_shared<PassingListener>(
                             shared_from_this(),
                             listener,
-                            filters[i + 1].comp),
+                            filters[i + 1].comp,
+                            mStageTimings,
+                            i + 1 /* stage */),
                     mayBlock);
         }
         filters.back().comp->setListener_vb(
-                std::make_shared<LastListener>(shared_from_this(), listener), mayBlock);
+                std::make_shared<LastListener>(
+                        shared_from_this(), listener, mStageTimings, filters.size()),
+                mayBlock);
         return C2_OK;
     }
 };
@@ -593,6 +593,7 @@ private:
                     .setUseColorManagerment(true)
                     .setEnableProtectedContext(false)
                     .setPrecacheToneMapperShaderOnly(true)
+                    .setPrecacheInBackground(true)
                     .setContextPriority(renderengine::RenderEngine::ContextPriority::LOW)
                     .build());
         if (!renderEngine) {
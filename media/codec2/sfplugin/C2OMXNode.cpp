@@ -59,7 +59,7 @@ public:
 
 class C2OMXNode::QueueThread : public Thread {
 public:
-    QueueThread() : Thread(false) {}
+    explicit QueueThread(const wp<C2OMXNode> &node) : Thread(false), mNode(node) {}
     ~QueueThread() override = default;
     void queue(
             const std::shared_ptr<Codec2Client::Component> &comp,
@@ -70,7 +70,25 @@ public:
         Mutexed<Jobs>::Locked jobs(mJobs);
         auto it = jobs->queues.try_emplace(comp, comp).first;
         it->second.workList.emplace_back(
-                std::move(work), fenceFd, std::move(fd0), std::move(fd1));
+                std::move(work), fenceFd, std::move(fd0), std::move(fd1), systemTime());
+        jobs->cond.broadcast();
+    }
+
+    void setMaxBacklog(size_t maxBacklog) {
+        Mutexed<Jobs>::Locked jobs(mJobs);
+        jobs->maxBacklog = maxBacklog;
+        jobs->cond.broadcast();
+    }
+
+    void onWorkDone(const std::shared_ptr<Codec2Client::Component> &comp) {
+        Mutexed<Jobs>::Locked jobs(mJobs);
+        auto it = jobs->queues.find(comp);
+        if (it == jobs->queues.end()) {
+            return;
+        }
+        if (it->second.inFlight > 0) {
+            --it->second.inFlight;
+        }
         jobs->cond.broadcast();
     }
 
@@ -103,6 +121,7 @@ protected:
             Mutexed<Jobs>::Locked jobs(mJobs);
             nsecs_t nowNs = systemTime();
             bool queued = false;
+            std::list<WorkFence> dropped;
             for (auto it = jobs->queues.begin(); it != jobs->queues.end(); ) {
                 Queue &queue = it->second;
                 if (queue.workList.empty()
@@ -116,6 +135,15 @@ protected:
                     it = jobs->queues.erase(it);
                     continue;
                 }
+                if (isBacklogged(jobs->maxBacklog, queue, nowNs)) {
+                    // Hold on to the latest frame only until the encoder catches up.
+                    while (queue.workList.size() > 1) {
+                        dropped.push_back(std::move(queue.workList.front()));
+                        queue.workList.pop_front();
+                    }
+                    ++it;
+                    continue;
+                }
                 std::list<std::unique_ptr<C2Work>> items;
                 std::vector<int> fenceFds;
                 std::vector<android::base::unique_fd> uniqueFds;
@@ -129,6 +157,7 @@ protected:
                 for (const std::unique_ptr<C2Param> &param : jobs->configUpdate) {
                     items.front()->input.configUpdate.emplace_back(C2Param::Copy(*param));
                 }
+                queue.inFlight += items.size();
 
                 jobs.unlock();
                 for (int fenceFd : fenceFds) {
@@ -145,6 +174,11 @@ protected:
                 it = jobs->queues.upper_bound(comp);
                 queued = true;
             }
+            if (!dropped.empty()) {
+                jobs.unlock();
+                releaseDropped(&dropped);
+                jobs.lock();
+            }
             if (queued) {
                 jobs->configUpdate.clear();
                 return true;
@@ -164,41 +198,82 @@ private:
                 std::unique_ptr<C2Work> &&w,
                 int fd,
                 android::base::unique_fd &&uniqueFd0,
-                android::base::unique_fd &&uniqueFd1)
+                android::base::unique_fd &&uniqueFd1,
+                nsecs_t queuedNs)
             : work(std::move(w)),
               fenceFd(fd),
               fd0(std::move(uniqueFd0)),
-              fd1(std::move(uniqueFd1)) {}
+              fd1(std::move(uniqueFd1)),
+              queuedTimestampNs(queuedNs) {}
 
         std::unique_ptr<C2Work> work;
         int fenceFd;
         android::base::unique_fd fd0;
         android::base::unique_fd fd1;
+        nsecs_t queuedTimestampNs = 0;
     };
     struct Queue {
         Queue(const std::shared_ptr<Codec2Client::Component> &comp)
-            : component(comp), lastQueuedTimestampNs(0) {}
+            : component(comp), lastQueuedTimestampNs(0), inFlight(0) {}
         Queue(const Queue &) = delete;
         Queue &operator =(const Queue &) = delete;
 
         std::weak_ptr<Codec2Client::Component> component;
         std::list<WorkFence> workList;
         nsecs_t lastQueuedTimestampNs;
+        // number of works queued to the component and not returned yet
+        size_t inFlight;
     };
     struct Jobs {
         std::map<std::weak_ptr<Codec2Client::Component>,
                  Queue,
                  std::owner_less<std::weak_ptr<Codec2Client::Component>>> queues;
         std::vector<std::unique_ptr<C2Param>> configUpdate;
+        // if >0: frames are held back while this many works are in flight; 0: no pacing
+        size_t maxBacklog = 0;
         Condition cond;
     };
     Mutexed<Jobs> mJobs;
+    wp<C2OMXNode> mNode;
+
+    static bool isBacklogged(size_t maxBacklog, const Queue &queue, nsecs_t nowNs) {
+        // A frame is never held for long, in case the encoder stalls or does not return
+        // some of the works.
+        constexpr nsecs_t kMaxHoldNs = nsecs_t(100) * 1000 * 1000;  // 100ms
+        if (maxBacklog == 0 || queue.inFlight < maxBacklog) {
+            return false;
+        }
+        for (const WorkFence &workFence : queue.workList) {
+            if (workFence.work->input.flags & C2FrameData::FLAG_END_OF_STREAM) {
+                return false;
+            }
+        }
+        return nowNs - queue.workList.back().queuedTimestampNs < kMaxHoldNs;
+    }
+
+    void releaseDropped(std::list<WorkFence> *dropped) {
+        sp<C2OMXNode> node = mNode.promote();
+        for (WorkFence &workFence : *dropped) {
+            uint64_t index = workFence.work->input.ordinal.frameIndex.peeku();
+            ALOGV("dropping frame #%llu: encoder is backlogged", (unsigned long long)index);
+            // The buffer goes back to the source only once the producer is done with it.
+            sp<Fence> fence(new Fence(workFence.fenceFd));
+            fence->waitForever(LOG_TAG);
+            (void)workFence.fd0.release();
+            (void)workFence.fd1.release();
+            workFence.work.reset();
+            if (node) {
+                (void)node->releaseBuffer(index);
+            }
+        }
+        dropped->clear();
+    }
 };
 
 C2OMXNode::C2OMXNode(const std::shared_ptr<Codec2Client::Component> &comp)
     : mComp(comp), mFrameIndex(0), mWidth(0), mHeight(0), mUsage(0),
       mAdjustTimestampGapUs(0), mFirstInputFrame(true),
-      mQueueThread(new QueueThread) {
+      mQueueThread(new QueueThread(this)) {
     android_fdsan_set_error_level(ANDROID_FDSAN_ERROR_LEVEL_WARN_ALWAYS);
     mQueueThread->run("C2OMXNode", PRIORITY_AUDIO);
 
@@ -536,23 +611,32 @@ void C2OMXNode::setFrameSize(uint32_t width, uint32_t height) {
 }
 
 void C2OMXNode::onInputBufferDone(c2_cntr64_t index) {
+    if (releaseBuffer(index.peeku())) {
+        if (std::shared_ptr<Codec2Client::Component> comp = mComp.lock()) {
+            mQueueThread->onWorkDone(comp);
+        }
+    }
+}
+
+bool C2OMXNode::releaseBuffer(uint64_t index) {
     if (!mBufferSource) {
-        ALOGD("Buffer source not set (index=%llu)", index.peekull());
-        return;
+        ALOGD("Buffer source not set (index=%llu)", (unsigned long long)index);
+        return false;
     }
 
     int32_t bufferId = 0;
     {
         decltype(mBufferIdsInUse)::Locked bufferIds(mBufferIdsInUse);
-        auto it = bufferIds->find(index.peeku());
+        auto it = bufferIds->find(index);
         if (it == bufferIds->end()) {
-            ALOGV("Untracked input index %llu (maybe already removed)", index.peekull());
-            return;
+            ALOGV("Untracked input index %llu (maybe already removed)", (unsigned long long)index);
+            return false;
         }
         bufferId = it->second;
         (void)bufferIds->erase(it);
     }
     (void)mBufferSource->onInputBufferEmptied(bufferId, -1);
+    return true;
 }
 
 android_dataspace C2OMXNode::getDataspace() {
@@ -563,4 +647,8 @@ void C2OMXNode::setPriority(int priority) {
     mQueueThread->setPriority(priority);
 }
 
+void C2OMXNode::setMaxBacklog(size_t maxBacklog) {
+    mQueueThread->setMaxBacklog(maxBacklog);
+}
+
 }  // namespace android
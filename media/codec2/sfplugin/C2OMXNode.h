@@ -103,6 +103,15 @@ struct C2OMXNode : public BnOMXNode {
      */
     void setPriority(int priority);
 
+    /**
+     * Sets the maximum number of works in flight in the component before
+     * frames from the source are held back. While the component is at this
+     * backlog, only the latest frame is kept and the older ones are dropped.
+     *
+     * \param maxBacklog maximum number of works in flight; 0 for no pacing
+     */
+    void setMaxBacklog(size_t maxBacklog);
+
 private:
     std::weak_ptr<Codec2Client::Component> mComp;
     sp<IOMXBufferSource> mBufferSource;
@@ -127,6 +136,13 @@ private:
 
     class QueueThread;
     sp<QueueThread> mQueueThread;
+
+    /**
+     * Returns the buffer of the work |index| to the source.
+     *
+     * \return true if the buffer was in use.
+     */
+    bool releaseBuffer(uint64_t index);
 };
 
 }  // namespace android
@@ -68,6 +68,12 @@ typedef CCodecConfig Config;
 
 namespace {
 
+// default time an input work may be held back to be queued with the next ones
+constexpr int64_t kDefaultInputBatchWindowUs = 2000;
+
+// works an encoder may have in flight from an input surface in low latency mode
+constexpr int32_t kLowLatencyMaxInputSurfaceBacklog = 2;
+
 class CCodecWatchdog : public AHandler {
 private:
     enum {
@@ -413,6 +419,13 @@ public:
             mConfig.mPriority = config.mPriority;
         }
 
+        // backlog-aware pacing
+        if (mConfig.mMaxBacklog != config.mMaxBacklog) {
+            mNode->setMaxBacklog(config.mMaxBacklog);
+            status << " maxBacklog=" << config.mMaxBacklog;
+            mConfig.mMaxBacklog = config.mMaxBacklog;
+        }
+
         if (status.str().empty()) {
             ALOGD("ISConfig not changed");
         } else {
@@ -684,6 +697,10 @@ public:
         mCodec->mCallback->onFirstTunnelFrameReady();
     }
 
+    void onInputBatchPending(int64_t delayUs) override {
+        (new AMessage(CCodec::kWhatFlushInputBatch, mCodec))->post(delayUs);
+    }
+
 private:
     CCodec *mCodec;
 };
@@ -857,6 +874,24 @@ void CCodec::configure(const sp<AMessage> &msg) {
             mChannel->setMetaMode(CCodecBufferChannel::MODE_ANW);
         }
 
+        // adaptive pipeline depth, e.g. a low range for low latency playback and a high one
+        // for transcoding
+        int32_t minSmoothness, maxSmoothness;
+        if (msg->findInt32("android._smoothness-factor-min", &minSmoothness)
+                && msg->findInt32("android._smoothness-factor-max", &maxSmoothness)
+                && minSmoothness >= 0 && maxSmoothness >= minSmoothness) {
+            mChannel->setSmoothnessFactorBounds(minSmoothness, maxSmoothness);
+        }
+
+        // gather input works into fewer transactions, e.g. for low bitrate audio where the
+        // binder transaction costs more than the decoding
+        int32_t inputBatchSize;
+        if (msg->findInt32("android._input-batch-size", &inputBatchSize) && inputBatchSize > 1) {
+            int64_t inputBatchWindowUs = kDefaultInputBatchWindowUs;
+            (void)msg->findInt64("android._input-batch-window-us", &inputBatchWindowUs);
+            mChannel->setInputBatching(inputBatchSize, inputBatchWindowUs);
+        }
+
         status_t err = OK;
         sp<RefBase> obj;
         sp<Surface> surface;
@@ -1018,6 +1053,20 @@ void CCodec::configure(const sp<AMessage> &msg) {
             }
             config->mISConfig->mUsage = 0;
             config->mISConfig->mPriority = INT_MAX;
+
+            {
+                // Hold back frames while the encoder is behind, so that high refresh rate
+                // sources do not add latency. Low latency sessions keep the encoder
+                // backlog to a minimum.
+                int32_t maxBacklog = base::GetIntProperty(
+                        "debug.stagefright.c2-input-surface-max-backlog", 0);
+                int32_t lowLatency = 0;
+                if (maxBacklog <= 0 && msg->findInt32(KEY_LOW_LATENCY, &lowLatency)
+                        && lowLatency) {
+                    maxBacklog = kLowLatencyMaxInputSurfaceBacklog;
+                }
+                config->mISConfig->mMaxBacklog = std::max(maxBacklog, 0);
+            }
         }
 
         /*
@@ -2509,6 +2558,10 @@ void CCodec::onMessageReceived(const sp<AMessage> &msg) {
             // watch message already posted; no-op.
             break;
         }
+        case kWhatFlushInputBatch: {
+            mChannel->flushInputBatch();
+            break;
+        }
         default: {
             ALOGE("unrecognized message");
             break;
@@ -50,6 +50,7 @@
 #include <media/stagefright/foundation/ALookup.h>
 #include <media/stagefright/foundation/AMessage.h>
 #include <media/stagefright/foundation/AUtils.h>
+#include <media/stagefright/foundation/MediaTrace.h>
 #include <media/stagefright/foundation/hexdump.h>
 #include <media/stagefright/MediaCodecConstants.h>
 #include <media/stagefright/SkipCutBuffer.h>
@@ -81,6 +82,9 @@ namespace {
 
 constexpr size_t kSmoothnessFactor = 4;
 
+// Number of reassembled audio frames packed in each input block of an audio encoder.
+constexpr int32_t kFramesPerReassemblerBlock = 4;
+
 // This is for keeping IGBP's buffer dropping logic in legacy mode other
 // than making it non-blocking. Do not change this value.
 const static size_t kDequeueTimeoutNs = 0;
@@ -159,6 +163,10 @@ CCodecBufferChannel::CCodecBufferChannel(
       mIsSurfaceToDisplay(false),
       mHasPresentFenceTimes(false),
       mRenderingDepth(3u),
+      mMinSmoothnessFactor(kSmoothnessFactor),
+      mMaxSmoothnessFactor(kSmoothnessFactor),
+      mMaxInputBatch(0u),
+      mInputBatchWindowUs(0),
       mMetaMode(MODE_NONE),
       mInputMetEos(false),
       mLastInputBufferAvailableTs(0u),
@@ -180,6 +188,13 @@ CCodecBufferChannel::CCodecBufferChannel(
         output->numSlots = kSmoothnessFactor;
         output->bounded = false;
     }
+    {
+        Mutexed<InputBatch>::Locked batch(mInputBatch);
+        batch->maxWorks = 0u;
+        batch->window = PipelineWatcher::Clock::duration::zero();
+        batch->numTransactions = 0u;
+        batch->numWorks = 0u;
+    }
     {
         Mutexed<BlockPools>::Locked pools(mBlockPools);
         pools->outputPoolId = C2BlockPool::BASIC_LINEAR;
@@ -363,9 +378,12 @@ status_t CCodecBufferChannel::queueInputBufferInternal(
                         work->input.ordinal.frameIndex.peeku(),
                         std::vector(work->input.buffers),
                         now);
+                MEDIA_TRACE_CODEC("CCodecBufferChannel::queue", mName,
+                        work->input.ordinal.customOrdinal.peekll(),
+                        work->input.ordinal.frameIndex.peekll());
             }
         }
-        err = mComponent->queue(&items);
+        err = queueWorks(&items);
     }
     if (err != C2_OK) {
         Mutexed<PipelineWatcher>::Locked watcher(mPipelineWatcher);
@@ -385,9 +403,78 @@ status_t CCodecBufferChannel::queueInputBufferInternal(
     }
 
     feedInputBufferIfAvailableInternal();
+    if (err == C2_OK && mInput.lock()->buffers->numClientBuffers() == 0) {
+        // The client cannot queue more input until the held back works are processed.
+        err = flushInputBatchInternal(true /* force */);
+    }
+    return err;
+}
+
+c2_status_t CCodecBufferChannel::queueWorks(std::list<std::unique_ptr<C2Work>> *items) {
+    bool eos = std::any_of(items->begin(), items->end(), [](const std::unique_ptr<C2Work> &work) {
+        return (work->input.flags & C2FrameData::FLAG_END_OF_STREAM) != 0;
+    });
+    Mutexed<InputBatch>::Locked batch(mInputBatch);
+    if (batch->maxWorks > 1 && !eos) {
+        PipelineWatcher::Clock::time_point now = PipelineWatcher::Clock::now();
+        bool first = batch->works.empty();
+        if (first) {
+            batch->firstQueuedAt = now;
+        }
+        batch->works.splice(batch->works.end(), *items);
+        if (batch->works.size() < batch->maxWorks && now - batch->firstQueuedAt < batch->window) {
+            if (first) {
+                mCCodecCallback->onInputBatchPending(
+                        std::chrono::duration_cast<std::chrono::microseconds>(
+                                batch->window).count());
+            }
+            return C2_OK;
+        }
+    }
+    items->splice(items->begin(), batch->works);
+    ++batch->numTransactions;
+    batch->numWorks += items->size();
+    return mComponent->queue(items);
+}
+
+c2_status_t CCodecBufferChannel::flushInputBatchInternal(bool force) {
+    std::list<std::unique_ptr<C2Work>> items;
+    c2_status_t err = C2_OK;
+    {
+        Mutexed<InputBatch>::Locked batch(mInputBatch);
+        if (batch->works.empty()) {
+            return C2_OK;
+        }
+        if (!force && PipelineWatcher::Clock::now() - batch->firstQueuedAt < batch->window) {
+            // a later batch, which has its own pending flush
+            return C2_OK;
+        }
+        items.swap(batch->works);
+        ++batch->numTransactions;
+        batch->numWorks += items.size();
+        err = mComponent->queue(&items);
+    }
+    if (err != C2_OK) {
+        ALOGD("[%s] failed to queue a batch of %zu works (err=%d)", mName, items.size(), err);
+        Mutexed<PipelineWatcher>::Locked watcher(mPipelineWatcher);
+        for (const std::unique_ptr<C2Work> &work : items) {
+            watcher->onWorkDone(work->input.ordinal.frameIndex.peeku());
+        }
+    }
     return err;
 }
 
+void CCodecBufferChannel::flushInputBatch() {
+    QueueGuard guard(mSync);
+    if (!guard.isRunning()) {
+        return;
+    }
+    c2_status_t err = flushInputBatchInternal(false /* force */);
+    if (err != C2_OK) {
+        mCCodecCallback->onError(toStatusT(err), ACTION_CODE_FATAL);
+    }
+}
+
 status_t CCodecBufferChannel::setParameters(std::vector<std::unique_ptr<C2Param>> &params) {
     QueueGuard guard(mSync);
     if (!guard.isRunning()) {
@@ -1267,8 +1354,10 @@ status_t CCodecBufferChannel::start(
     uint32_t pipelineDelayValue = pipelineDelay ? pipelineDelay.value : 0;
     uint32_t outputDelayValue = outputDelay ? outputDelay.value : 0;
 
-    size_t numInputSlots = inputDelayValue + pipelineDelayValue + kSmoothnessFactor;
-    size_t numOutputSlots = outputDelayValue + kSmoothnessFactor;
+    const uint32_t minSmoothnessFactor = mMinSmoothnessFactor;
+    const uint32_t maxSmoothnessFactor = mMaxSmoothnessFactor;
+    size_t numInputSlots = inputDelayValue + pipelineDelayValue + maxSmoothnessFactor;
+    size_t numOutputSlots = outputDelayValue + maxSmoothnessFactor;
 
     // TODO: get this from input format
     bool secure = mComponent->getName().find(".secure") != std::string::npos;
@@ -1383,7 +1472,10 @@ status_t CCodecBufferChannel::start(
                     encoderFrameSize.value,
                     sampleRate.value,
                     channelCount.value,
-                    pcmEncoding ? pcmEncoding.value : C2Config::PCM_16);
+                    pcmEncoding ? pcmEncoding.value : C2Config::PCM_16,
+                    std::max(1, android::base::GetIntProperty(
+                            "debug.stagefright.ccodec_reassembler_frames_per_block",
+                            kFramesPerReassemblerBlock)));
         }
         bool conforming = (apiFeatures & API_SAME_INPUT_BUFFER);
         // For encrypted content, framework decrypts source buffer (ashmem) into
@@ -1669,9 +1761,18 @@ status_t CCodecBufferChannel::start(
         watcher->inputDelay(inputDelayValue)
                 .pipelineDelay(pipelineDelayValue)
                 .outputDelay(outputDelayValue)
-                .smoothnessFactor(kSmoothnessFactor);
+                .smoothnessFactor(kSmoothnessFactor)
+                .smoothnessFactorBounds(minSmoothnessFactor, maxSmoothnessFactor);
         watcher->flush();
     }
+    {
+        Mutexed<InputBatch>::Locked batch(mInputBatch);
+        batch->works.clear();
+        batch->maxWorks = mMaxInputBatch;
+        batch->window = std::chrono::microseconds(mInputBatchWindowUs.load());
+        batch->numTransactions = 0;
+        batch->numWorks = 0;
+    }
 
     mInputMetEos = false;
     mSync.start();
@@ -1794,7 +1895,18 @@ status_t CCodecBufferChannel::requestInitialInputBuffers(
 
 void CCodecBufferChannel::stop() {
     mSync.stop();
+    // Hand the held back works to the component, which processes or flushes them next.
+    (void)flushInputBatchInternal(true /* force */);
     mFirstValidFrameIndex = mFrameIndex.load(std::memory_order_relaxed);
+    uint64_t numTransactions, numWorks;
+    {
+        Mutexed<InputBatch>::Locked batch(mInputBatch);
+        numTransactions = batch->numTransactions;
+        numWorks = batch->numWorks;
+    }
+    ALOGD("[%s] stop: pipeline %s, %llu works in %llu queue transactions", mName,
+          mPipelineWatcher.lock()->statsString().c_str(),
+          (unsigned long long)numWorks, (unsigned long long)numTransactions);
 }
 
 void CCodecBufferChannel::stopUseOutputSurface(bool pushBlankBuffer) {
@@ -2108,7 +2220,7 @@ bool CCodecBufferChannel::handleWork(
         size_t newNumSlots =
             newInputDelay.value_or(input->inputDelay) +
             newPipelineDelay.value_or(input->pipelineDelay) +
-            kSmoothnessFactor;
+            mMaxSmoothnessFactor;
         if (input->buffers->isArrayMode()) {
             if (input->numSlots >= newNumSlots) {
                 input->numExtraSlots = 0;
@@ -2139,7 +2251,7 @@ bool CCodecBufferChannel::handleWork(
         reorderDepth = output->buffers->getReorderDepth();
         if (newOutputDelay) {
             output->outputDelay = newOutputDelay.value();
-            numOutputSlots = newOutputDelay.value() + kSmoothnessFactor;
+            numOutputSlots = newOutputDelay.value() + mMaxSmoothnessFactor;
             if (output->numSlots < numOutputSlots) {
                 output->numSlots = numOutputSlots;
                 if (output->buffers->isArrayMode()) {
@@ -2195,6 +2307,8 @@ bool CCodecBufferChannel::handleWork(
     }
     ScopedTrace trace(ATRACE_TAG, android::base::StringPrintf(
             "CCodecBufferChannel::onWorkDone(%s@ts=%lld)", mName, timestamp.peekll()).c_str());
+    MEDIA_TRACE_CODEC("CCodecBufferChannel::workDone", mName, timestamp.peekll(),
+            work->input.ordinal.frameIndex.peekll());
     ALOGV("[%s] onWorkDone: input %lld, codec %lld => output %lld => %lld",
           mName,
           work->input.ordinal.customOrdinal.peekll(),
@@ -2430,11 +2544,23 @@ PipelineWatcher::Clock::duration CCodecBufferChannel::elapsed() {
     size_t outputDelay = mOutput.lock()->outputDelay;
     {
         Mutexed<Input>::Locked input(mInput);
-        n = input->inputDelay + input->pipelineDelay + outputDelay + kSmoothnessFactor;
+        n = input->inputDelay + input->pipelineDelay + outputDelay;
         ALOGD("[%s] DEBUG: elapsed: n=%zu [in=%u pipeline=%u out=%zu]", mName, n,
                 input->inputDelay, input->pipelineDelay, outputDelay);
     }
-    return mPipelineWatcher.lock()->elapsed(PipelineWatcher::Clock::now(), n);
+    Mutexed<PipelineWatcher>::Locked watcher(mPipelineWatcher);
+    n += watcher->smoothnessFactor();
+    return watcher->elapsed(PipelineWatcher::Clock::now(), n);
+}
+
+void CCodecBufferChannel::setSmoothnessFactorBounds(uint32_t min, uint32_t max) {
+    mMinSmoothnessFactor = std::min(min, max);
+    mMaxSmoothnessFactor = max;
+}
+
+void CCodecBufferChannel::setInputBatching(uint32_t maxWorks, int64_t windowUs) {
+    mMaxInputBatch = maxWorks;
+    mInputBatchWindowUs = std::max(windowUs, int64_t(0));
 }
 
 void CCodecBufferChannel::setMetaMode(MetaMode mode) {
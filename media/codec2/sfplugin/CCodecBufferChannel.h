@@ -48,6 +48,7 @@ public:
     virtual void onOutputFramesRendered(int64_t mediaTimeUs, nsecs_t renderTimeNs) = 0;
     virtual void onOutputBuffersChanged() = 0;
     virtual void onFirstTunnelFrameReady() = 0;
+    virtual void onInputBatchPending(int64_t delayUs) = 0;
 };
 
 /**
@@ -208,6 +209,27 @@ public:
 
     void setMetaMode(MetaMode mode);
 
+    /**
+     * Let the number of work items queued beyond the component delays adapt
+     * between |min| and |max| from the measured turnaround, instead of the
+     * fixed default. Takes effect at the next start().
+     */
+    void setSmoothnessFactorBounds(uint32_t min, uint32_t max);
+
+    /**
+     * Gather up to |maxWorks| input works queued within |windowUs| into one
+     * queue() transaction to the component. Works with end of stream are
+     * never held back. |maxWorks| of 0 or 1 disables batching. Takes effect
+     * at the next start().
+     */
+    void setInputBatching(uint32_t maxWorks, int64_t windowUs);
+
+    /**
+     * Queue the works gathered by input batching once the first of them has
+     * waited for the batching window.
+     */
+    void flushInputBatch();
+
 private:
     class QueueGuard;
 
@@ -279,6 +301,8 @@ private:
     status_t queueInputBufferInternal(sp<MediaCodecBuffer> buffer,
                                       std::shared_ptr<C2LinearBlock> encryptedBlock = nullptr,
                                       size_t blockSize = 0);
+    c2_status_t queueWorks(std::list<std::unique_ptr<C2Work>> *items);
+    c2_status_t flushInputBatchInternal(bool force);
     bool handleWork(
             std::unique_ptr<C2Work> work, const sp<AMessage> &outputFormat,
             const C2StreamInitDataInfo::output *initData);
@@ -349,6 +373,23 @@ private:
     Mutexed<OutputSurface> mOutputSurface;
     int mRenderingDepth;
 
+    // bounds of the pipeline smoothness factor, the buffers are sized for the highest one
+    std::atomic_uint32_t mMinSmoothnessFactor;
+    std::atomic_uint32_t mMaxSmoothnessFactor;
+
+    // input works held back to be queued in one transaction
+    struct InputBatch {
+        std::list<std::unique_ptr<C2Work>> works;
+        PipelineWatcher::Clock::time_point firstQueuedAt;
+        uint32_t maxWorks;
+        PipelineWatcher::Clock::duration window;
+        uint64_t numTransactions;
+        uint64_t numWorks;
+    };
+    Mutexed<InputBatch> mInputBatch;
+    std::atomic_uint32_t mMaxInputBatch;
+    std::atomic_int64_t mInputBatchWindowUs;
+
     struct BlockPools {
         C2Allocator::id_t inputAllocatorId;
         std::shared_ptr<C2BlockPool> inputPool;
@@ -1110,6 +1110,8 @@ status_t CCodecConfig::initialize(
     // enumerate all fields
     mParamUpdater = std::make_shared<ReflectedParamUpdater>();
     mParamUpdater->clear();
+    mReflectedConfig.clear();
+    mReflectedParams.clear();
     mParamUpdater->supportWholeParam(
             C2_PARAMKEY_TEMPORAL_LAYERING, C2StreamTemporalLayeringTuning::CORE_INDEX);
     mParamUpdater->addParamDesc(mReflector, mParamDescs);
@@ -1291,33 +1293,74 @@ bool CCodecConfig::updateConfiguration(
     return false;
 }
 
-bool CCodecConfig::updateFormats(Domain domain) {
-    // get addresses of params in the current config
-    std::vector<C2Param*> paramPointers;
-    for (const auto &it : mCurrentConfig) {
-        paramPointers.push_back(it.second.get());
-    }
-
-    ReflectedParamUpdater::Dict reflected = mParamUpdater->getParams(paramPointers);
-    std::string config = reflected.debugString();
-    std::set<std::string> configLines;
-    std::string diff;
+static std::vector<std::string> GetLines(const std::string &str) {
+    std::vector<std::string> lines;
     for (size_t start = 0; start != std::string::npos; ) {
-        size_t end = config.find('\n', start);
+        size_t end = str.find('\n', start);
         size_t count = (end == std::string::npos)
                 ? std::string::npos
                 : end - start + 1;
-        std::string line = config.substr(start, count);
-        configLines.insert(line);
-        if (mLastConfig.count(line) == 0) {
-            diff.append(line);
-        }
+        lines.push_back(str.substr(start, count));
         start = (end == std::string::npos) ? std::string::npos : end + 1;
     }
-    if (!diff.empty()) {
-        ALOGD("c2 config diff is %s", diff.c_str());
+    return lines;
+}
+
+bool CCodecConfig::updateFormats(Domain domain) {
+    // find the params that changed since the last update; only these are reflected again
+    std::vector<C2Param*> changedParams;
+    std::vector<C2Param::Index> changedIndices;
+    for (const auto &[index, param] : mCurrentConfig) {
+        auto it = mReflectedParams.find(index);
+        bool present = param && *param;
+        if (it == mReflectedParams.end() ? !present : (present && *it->second == *param)) {
+            // unchanged
+            continue;
+        }
+        changedIndices.push_back(index);
+        if (present) {
+            changedParams.push_back(param.get());
+            mReflectedParams[index] = C2Param::Copy(*param);
+        } else {
+            mReflectedParams.erase(index);
+        }
+    }
+    for (auto it = mReflectedParams.begin(); it != mReflectedParams.end(); ) {
+        if (mCurrentConfig.count(it->first) == 0) {
+            changedIndices.push_back(it->first);
+            it = mReflectedParams.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    ReflectedParamUpdater::Dict oldValues;
+    std::vector<std::string> keys;
+    for (const C2Param::Index &index : changedIndices) {
+        mParamUpdater->getKeysForParamIndex(index, &keys);
+        for (const std::string &key : keys) {
+            auto it = mReflectedConfig.find(key);
+            if (it != mReflectedConfig.end()) {
+                oldValues.insert(mReflectedConfig.extract(it));
+            }
+        }
+    }
+    ReflectedParamUpdater::Dict newValues = mParamUpdater->getParams(changedParams);
+    if (!newValues.empty()) {
+        std::vector<std::string> lines = GetLines(oldValues.debugString());
+        std::set<std::string> oldLines(lines.begin(), lines.end());
+        std::string diff;
+        for (const std::string &line : GetLines(newValues.debugString())) {
+            if (oldLines.count(line) == 0) {
+                diff.append(line);
+            }
+        }
+        if (!diff.empty()) {
+            ALOGD("c2 config diff is %s", diff.c_str());
+        }
     }
-    mLastConfig.swap(configLines);
+    mReflectedConfig.merge(newValues);
+    const ReflectedParamUpdater::Dict &reflected = mReflectedConfig;
 
     bool changed = false;
     if (domain & mInputDomain) {
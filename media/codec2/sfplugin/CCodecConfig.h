@@ -142,7 +142,11 @@ struct CCodecConfig {
     /// Vendor field name -> desc map.
     std::map<std::string, std::shared_ptr<C2ParamDescriptor>> mVendorParams;
 
-    std::set<std::string> mLastConfig;
+    /// reflected values of mReflectedParams. Only the fields of the params that changed are
+    /// reflected again in updateFormats.
+    ReflectedParamUpdater::Dict mReflectedConfig;
+    /// copies of the params of mCurrentConfig as of the last updateFormats
+    std::map<C2Param::Index, std::unique_ptr<C2Param>> mReflectedParams;
 
     /// Tunneled codecs
     bool mTunneled;
@@ -196,6 +200,8 @@ struct CCodecConfig {
 
         mLocalParams.emplace(index, validator);
         mParamUpdater->addStandardParam<T>(name, attrib);
+        // the new fields must be reflected
+        mReflectedParams.erase(index);
         return true;
     }
 
@@ -298,8 +298,11 @@ public:
 
         bool tryWrapping = !copy;
 
-        // Temporarily disable wrapping
-        tryWrapping = false;
+        // Wrapping hands the mapped planes to the client instead of copying them, and relies on
+        // gralloc mapping the planes of a buffer contiguously. It is thus opt-in.
+        static const bool sWrapGraphic = ::android::base::GetBoolProperty(
+                "debug.stagefright.ccodec_wrap_graphic", false);
+        tryWrapping = tryWrapping && sWrapGraphic;
 
         switch (layout.type) {
             case C2PlanarLayout::TYPE_YUV: {
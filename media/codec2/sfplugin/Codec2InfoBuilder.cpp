@@ -16,10 +16,17 @@
 
 //#define LOG_NDEBUG 0
 #define LOG_TAG "Codec2InfoBuilder"
+#define ATRACE_TAG  ATRACE_TAG_VIDEO
 #include <log/log.h>
+#include <utils/Trace.h>
 
 #include <strings.h>
 
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <thread>
+
 #include <C2Component.h>
 #include <C2Config.h>
 #include <C2Debug.h>
@@ -91,10 +98,35 @@ std::optional<int32_t> findFrameworkColorFormat(
     return std::nullopt;
 }
 
+// Profile levels and color formats of a media type, as queried from the component
+// interface. They are recorded so that the interfaces can be queried concurrently, and
+// written to the codec list afterwards in a deterministic order.
+struct MediaTypeCaps {
+    std::vector<std::pair<uint32_t, uint32_t>> profileLevels;
+    std::vector<uint32_t> colorFormats;
+
+    void addProfileLevel(uint32_t profile, uint32_t level) {
+        profileLevels.emplace_back(profile, level);
+    }
+
+    void addColorFormat(uint32_t colorFormat) {
+        colorFormats.push_back(colorFormat);
+    }
+
+    void writeTo(MediaCodecInfo::CapabilitiesWriter *caps) const {
+        for (const auto &[profile, level] : profileLevels) {
+            caps->addProfileLevel(profile, level);
+        }
+        for (uint32_t colorFormat : colorFormats) {
+            caps->addColorFormat(colorFormat);
+        }
+    }
+};
+
 // returns true if component advertised supported profile level(s)
 bool addSupportedProfileLevels(
         std::shared_ptr<Codec2Client::Interface> intf,
-        MediaCodecInfo::CapabilitiesWriter *caps,
+        MediaTypeCaps *caps,
         const Traits& trait, const std::string &mediaType) {
     std::shared_ptr<C2Mapper::ProfileLevelMapper> mapper =
         C2Mapper::GetProfileLevelMapper(trait.mediaType);
@@ -244,7 +276,7 @@ bool addSupportedProfileLevels(
 
 void addSupportedColorFormats(
         std::shared_ptr<Codec2Client::Interface> intf,
-        MediaCodecInfo::CapabilitiesWriter *caps,
+        MediaTypeCaps *caps,
         const Traits& trait, const std::string &mediaType,
         const PixelFormatMap &pixelFormatMap) {
     // TODO: get this from intf() as well, but how do we map them to
@@ -391,6 +423,130 @@ Switch isDomainEnabled(
     return isSettingEnabled("domain-" + domain, settings);
 }
 
+// HAL pixel format -> framework color format maps of each service, built the first time a
+// component of the service is queried.
+class PixelFormatMaps {
+public:
+    const PixelFormatMap &get(const std::shared_ptr<Codec2Client> &client) {
+        std::lock_guard<std::mutex> lock(mMutex);
+        auto it = mMaps.find(client->getServiceName());
+        if (it != mMaps.end()) {
+            return it->second;
+        }
+        it = mMaps.try_emplace(client->getServiceName()).first;
+        PixelFormatMap &pixelFormatMap = it->second;
+        pixelFormatMap[HAL_PIXEL_FORMAT_YCBCR_420_888] = COLOR_FormatYUV420Flexible;
+        pixelFormatMap[HAL_PIXEL_FORMAT_YCBCR_P010]    = COLOR_FormatYUVP010;
+        pixelFormatMap[HAL_PIXEL_FORMAT_RGBA_1010102]  = COLOR_Format32bitABGR2101010;
+        pixelFormatMap[HAL_PIXEL_FORMAT_RGBA_FP16]     = COLOR_Format64bitABGRFloat;
+
+        std::shared_ptr<C2StoreFlexiblePixelFormatDescriptorsInfo> pixelFormatInfo;
+        std::vector<std::unique_ptr<C2Param>> heapParams;
+        if (client->query(
+                    {},
+                    {C2StoreFlexiblePixelFormatDescriptorsInfo::PARAM_TYPE},
+                    C2_MAY_BLOCK,
+                    &heapParams) == C2_OK
+                && heapParams.size() == 1u) {
+            pixelFormatInfo.reset(C2StoreFlexiblePixelFormatDescriptorsInfo::From(
+                    heapParams[0].release()));
+        }
+        if (pixelFormatInfo && *pixelFormatInfo) {
+            for (size_t i = 0; i < pixelFormatInfo->flexCount(); ++i) {
+                C2FlexiblePixelFormatDescriptorStruct &desc =
+                    pixelFormatInfo->m.values[i];
+                std::optional<int32_t> colorFormat = findFrameworkColorFormat(desc);
+                if (colorFormat) {
+                    pixelFormatMap[desc.pixelFormat] = *colorFormat;
+                }
+            }
+        }
+        return pixelFormatMap;
+    }
+
+private:
+    std::mutex mMutex;
+    std::map<std::string, PixelFormatMap> mMaps;
+};
+
+// Result of the interface queries of a component name or alias.
+struct ComponentInfo {
+    std::shared_ptr<Codec2Client::Interface> intf;
+    // media type -> capabilities queried from |intf|
+    std::map<std::string, MediaTypeCaps> mediaTypeCaps;
+};
+
+// Creates the interface of a component name or alias, and queries the capabilities of the
+// media types listed for it in the XML. This is the part of the codec list that talks to the
+// services, so it runs concurrently for all components.
+void queryComponent(
+        const Traits &trait, const std::string &nameOrAlias,
+        const MediaCodecsXmlParser &parser, PixelFormatMaps *pixelFormatMaps,
+        ComponentInfo *info) {
+    ScopedTrace trace(ATRACE_TAG, ("Codec2InfoBuilder::query " + nameOrAlias).c_str());
+    std::shared_ptr<Codec2Client> client;
+    info->intf = Codec2Client::CreateInterfaceByName(nameOrAlias.c_str(), &client);
+    if (!info->intf) {
+        return;
+    }
+    auto codecIt = parser.getCodecMap().find(nameOrAlias);
+    if (codecIt == parser.getCodecMap().end()) {
+        return;
+    }
+    for (const auto &typeIt : codecIt->second.typeMap) {
+        const std::string &mediaType = typeIt.first;
+        MediaTypeCaps &caps = info->mediaTypeCaps[mediaType];
+        if (!addSupportedProfileLevels(info->intf, &caps, trait, mediaType)) {
+            // TODO(b/193279646) This will get fixed in C2InterfaceHelper
+            // Some components may not advertise supported values if they use a const
+            // param for profile/level (they support only one profile). For now cover
+            // only VP8 here until it is fixed.
+            if (mediaType == MIMETYPE_VIDEO_VP8) {
+                caps.addProfileLevel(VP8ProfileMain, VP8Level_Version0);
+            }
+        }
+        addSupportedColorFormats(
+                info->intf, &caps, trait, mediaType, pixelFormatMaps->get(client));
+    }
+}
+
+// Queries all component names and aliases of |traits| on a bounded number of threads.
+// The results are in the order of the traits, each name followed by its aliases.
+std::vector<ComponentInfo> queryComponents(
+        const std::vector<Traits> &traits, const MediaCodecsXmlParser &parser) {
+    constexpr size_t kMaxQueryThreads = 8;
+
+    std::vector<std::pair<const Traits *, std::string>> jobs;
+    for (const Traits &trait : traits) {
+        jobs.emplace_back(&trait, trait.name);
+        for (const std::string &alias : trait.aliases) {
+            jobs.emplace_back(&trait, alias);
+        }
+    }
+    std::vector<ComponentInfo> infos(jobs.size());
+    PixelFormatMaps pixelFormatMaps;
+    std::atomic_size_t next{0};
+    auto work = [&jobs, &infos, &parser, &pixelFormatMaps, &next] {
+        for (size_t i = next++; i < jobs.size(); i = next++) {
+            queryComponent(*jobs[i].first, jobs[i].second, parser, &pixelFormatMaps, &infos[i]);
+        }
+    };
+
+    size_t numThreads = std::min({
+            jobs.size(),
+            kMaxQueryThreads,
+            size_t(std::max(1u, std::thread::hardware_concurrency()))});
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < numThreads; ++i) {
+        threads.emplace_back(work);
+    }
+    work();
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+    return infos;
+}
+
 } // unnamed namespace
 
 status_t Codec2InfoBuilder::buildMediaCodecList(MediaCodecListWriter* writer) {
@@ -508,7 +664,8 @@ status_t Codec2InfoBuilder::buildMediaCodecList(MediaCodecListWriter* writer) {
         }
     }
 
-    std::map<std::string, PixelFormatMap> nameToPixelFormatMap;
+    std::vector<ComponentInfo> infos = queryComponents(traits, parser);
+    size_t infoIndex = 0;
     for (const Traits& trait : traits) {
         C2Component::rank_t rank = trait.rank;
 
@@ -522,10 +679,8 @@ status_t Codec2InfoBuilder::buildMediaCodecList(MediaCodecListWriter* writer) {
         nameAndAliases.insert(nameAndAliases.begin(), trait.name);
         for (const std::string &nameOrAlias : nameAndAliases) {
             bool isAlias = trait.name != nameOrAlias;
-            std::shared_ptr<Codec2Client> client;
-            std::shared_ptr<Codec2Client::Interface> intf =
-                Codec2Client::CreateInterfaceByName(nameOrAlias.c_str(), &client);
-            if (!intf) {
+            const ComponentInfo &info = infos[infoIndex++];
+            if (!info.intf) {
                 ALOGD("could not create interface for %s'%s'",
                         isAlias ? "alias " : "",
                         nameOrAlias.c_str());
@@ -709,49 +864,10 @@ status_t Codec2InfoBuilder::buildMediaCodecList(MediaCodecListWriter* writer) {
                     }
                 }
 
-                if (!addSupportedProfileLevels(intf, caps.get(), trait, mediaType)) {
-                    // TODO(b/193279646) This will get fixed in C2InterfaceHelper
-                    // Some components may not advertise supported values if they use a const
-                    // param for profile/level (they support only one profile). For now cover
-                    // only VP8 here until it is fixed.
-                    if (mediaType == MIMETYPE_VIDEO_VP8) {
-                        caps->addProfileLevel(VP8ProfileMain, VP8Level_Version0);
-                    }
-                }
-
-                auto it = nameToPixelFormatMap.find(client->getServiceName());
-                if (it == nameToPixelFormatMap.end()) {
-                    it = nameToPixelFormatMap.try_emplace(client->getServiceName()).first;
-                    PixelFormatMap &pixelFormatMap = it->second;
-                    pixelFormatMap[HAL_PIXEL_FORMAT_YCBCR_420_888] = COLOR_FormatYUV420Flexible;
-                    pixelFormatMap[HAL_PIXEL_FORMAT_YCBCR_P010]    = COLOR_FormatYUVP010;
-                    pixelFormatMap[HAL_PIXEL_FORMAT_RGBA_1010102]  = COLOR_Format32bitABGR2101010;
-                    pixelFormatMap[HAL_PIXEL_FORMAT_RGBA_FP16]     = COLOR_Format64bitABGRFloat;
-
-                    std::shared_ptr<C2StoreFlexiblePixelFormatDescriptorsInfo> pixelFormatInfo;
-                    std::vector<std::unique_ptr<C2Param>> heapParams;
-                    if (client->query(
-                                {},
-                                {C2StoreFlexiblePixelFormatDescriptorsInfo::PARAM_TYPE},
-                                C2_MAY_BLOCK,
-                                &heapParams) == C2_OK
-                            && heapParams.size() == 1u) {
-                        pixelFormatInfo.reset(C2StoreFlexiblePixelFormatDescriptorsInfo::From(
-                                heapParams[0].release()));
-                    }
-                    if (pixelFormatInfo && *pixelFormatInfo) {
-                        for (size_t i = 0; i < pixelFormatInfo->flexCount(); ++i) {
-                            C2FlexiblePixelFormatDescriptorStruct &desc =
-                                pixelFormatInfo->m.values[i];
-                            std::optional<int32_t> colorFormat = findFrameworkColorFormat(desc);
-                            if (colorFormat) {
-                                pixelFormatMap[desc.pixelFormat] = *colorFormat;
-                            }
-                        }
-                    }
+                auto it = info.mediaTypeCaps.find(mediaType);
+                if (it != info.mediaTypeCaps.end()) {
+                    it->second.writeTo(caps.get());
                 }
-                addSupportedColorFormats(
-                        intf, caps.get(), trait, mediaType, it->second);
             }
         }
     }
@@ -32,7 +32,10 @@ FrameReassembler::FrameReassembler()
       mSampleRate(0u),
       mChannelCount(0u),
       mEncoding(C2Config::PCM_16),
-      mCurrentOrdinal({0, 0, 0}) {
+      mCurrentOrdinal({0, 0, 0}),
+      mFramesPerBlock(1u),
+      mFrameOffset(0u),
+      mFrameFill(0u) {
 }
 
 void FrameReassembler::init(
@@ -41,13 +44,15 @@ void FrameReassembler::init(
         uint32_t frameSize,
         uint32_t sampleRate,
         uint32_t channelCount,
-        C2Config::pcm_encoding_t encoding) {
+        C2Config::pcm_encoding_t encoding,
+        uint32_t framesPerBlock) {
     mBlockPool = pool;
     mUsage = usage;
     mFrameSize = frameSize;
     mSampleRate = sampleRate;
     mChannelCount = channelCount;
     mEncoding = encoding;
+    mFramesPerBlock = std::max(framesPerBlock, 1u);
 }
 
 void FrameReassembler::updateFrameSize(uint32_t frameSize) {
@@ -94,11 +99,13 @@ c2_status_t FrameReassembler::process(
 
     items->splice(items->end(), mPendingWork);
 
-    // Fill mCurrentBlock
-    if (mCurrentBlock) {
+    size_t frameBytes = frameSizeBytes();
+
+    // Fill the pending frame
+    if (mFrameFill > 0) {
         // First check the timestamp
         c2_cntr64_t endTimestampUs = mCurrentOrdinal.timestamp;
-        endTimestampUs += bytesToSamples(mWriteView->size()) * 1000000 / mSampleRate;
+        endTimestampUs += bytesToSamples(mFrameFill) * 1000000 / mSampleRate;
         if (timeUs < endTimestampUs.peek()) {
             uint64_t diffUs = (endTimestampUs - timeUs).peeku();
             if (diffUs > kToleranceUs) {
@@ -113,12 +120,11 @@ c2_status_t FrameReassembler::process(
                 // The timestamp is going forward; add silence as necessary.
                 size_t gapSamples = usToSamples(diffUs);
                 size_t remainingSamples =
-                    (mWriteView->capacity() - mWriteView->size())
-                    / mChannelCount / bytesPerSample();
+                    (frameBytes - mFrameFill) / mChannelCount / bytesPerSample();
                 if (gapSamples < remainingSamples) {
                     size_t gapBytes = gapSamples * mChannelCount * bytesPerSample();
-                    memset(mWriteView->base() + mWriteView->size(), 0u, gapBytes);
-                    mWriteView->setSize(mWriteView->size() + gapBytes);
+                    memset(mWriteView->base() + mFrameOffset + mFrameFill, 0u, gapBytes);
+                    mFrameFill += gapBytes;
                 } else {
                     finishCurrentBlock(items);
                 }
@@ -126,15 +132,13 @@ c2_status_t FrameReassembler::process(
         }
     }
 
-    if (mCurrentBlock) {
-        // Append the data at the end of the current block
-        size_t copySize = std::min(
-                buffer->size(),
-                size_t(mWriteView->capacity() - mWriteView->size()));
-        memcpy(mWriteView->base() + mWriteView->size(), buffer->data(), copySize);
+    if (mFrameFill > 0) {
+        // Append the data at the end of the pending frame
+        size_t copySize = std::min(buffer->size(), frameBytes - mFrameFill);
+        memcpy(mWriteView->base() + mFrameOffset + mFrameFill, buffer->data(), copySize);
         buffer->setRange(buffer->offset() + copySize, buffer->size() - copySize);
-        mWriteView->setSize(mWriteView->size() + copySize);
-        if (mWriteView->size() == mWriteView->capacity()) {
+        mFrameFill += copySize;
+        if (mFrameFill == frameBytes) {
             finishCurrentBlock(items);
         }
         timeUs += bytesToSamples(copySize) * 1000000 / mSampleRate;
@@ -145,28 +149,21 @@ c2_status_t FrameReassembler::process(
         mCurrentOrdinal.customOrdinal = timeUs;
     }
 
-    size_t frameSizeBytes = mFrameSize.value() * mChannelCount * bytesPerSample();
     while (buffer->size() > 0) {
         LOG_ALWAYS_FATAL_IF(
-                mCurrentBlock,
-                "There's remaining data but the pending block is not filled & finished");
-        std::unique_ptr<C2Work> work(new C2Work);
-        c2_status_t err = mBlockPool->fetchLinearBlock(frameSizeBytes, mUsage, &mCurrentBlock);
+                mFrameFill > 0,
+                "There's remaining data but the pending frame is not filled & finished");
+        c2_status_t err = startFrame();
         if (err != C2_OK) {
             return err;
         }
-        size_t copySize = std::min(buffer->size(), frameSizeBytes);
-        mWriteView = mCurrentBlock->map().get();
-        if (mWriteView->error() != C2_OK) {
-            return mWriteView->error();
-        }
-        ALOGV("buffer={offset=%zu size=%zu} copySize=%zu",
-                buffer->offset(), buffer->size(), copySize);
-        memcpy(mWriteView->base(), buffer->data(), copySize);
-        mWriteView->setOffset(0u);
-        mWriteView->setSize(copySize);
+        size_t copySize = std::min(buffer->size(), frameBytes);
+        ALOGV("buffer={offset=%zu size=%zu} copySize=%zu frameOffset=%zu",
+                buffer->offset(), buffer->size(), copySize, mFrameOffset);
+        memcpy(mWriteView->base() + mFrameOffset, buffer->data(), copySize);
+        mFrameFill = copySize;
         buffer->setRange(buffer->offset() + copySize, buffer->size() - copySize);
-        if (copySize == frameSizeBytes) {
+        if (copySize == frameBytes) {
             finishCurrentBlock(items);
         }
     }
@@ -183,6 +180,8 @@ void FrameReassembler::flush() {
     mPendingWork.clear();
     mWriteView.reset();
     mCurrentBlock.reset();
+    mFrameOffset = 0u;
+    mFrameFill = 0u;
 }
 
 uint64_t FrameReassembler::bytesToSamples(size_t numBytes) const {
@@ -199,20 +198,47 @@ uint32_t FrameReassembler::bytesPerSample() const {
          : (mEncoding == C2Config::PCM_FLOAT) ? 4 : 0;
 }
 
+size_t FrameReassembler::frameSizeBytes() const {
+    return mFrameSize.value() * mChannelCount * bytesPerSample();
+}
+
+c2_status_t FrameReassembler::startFrame() {
+    size_t frameBytes = frameSizeBytes();
+    if (mCurrentBlock && mFrameOffset + frameBytes <= mCurrentBlock->capacity()) {
+        return C2_OK;
+    }
+    // The previous block, if any, is kept alive by the frames shared from it.
+    mWriteView.reset();
+    mCurrentBlock.reset();
+    mFrameOffset = 0u;
+    c2_status_t err = mBlockPool->fetchLinearBlock(
+            frameBytes * mFramesPerBlock, mUsage, &mCurrentBlock);
+    if (err != C2_OK) {
+        return err;
+    }
+    mWriteView = mCurrentBlock->map().get();
+    if (mWriteView->error() != C2_OK) {
+        err = mWriteView->error();
+        mWriteView.reset();
+        mCurrentBlock.reset();
+        return err;
+    }
+    return C2_OK;
+}
+
 void FrameReassembler::finishCurrentBlock(std::list<std::unique_ptr<C2Work>> *items) {
-    if (!mCurrentBlock) {
+    if (mFrameFill == 0) {
         // No-op
         return;
     }
-    if (mWriteView->size() < mWriteView->capacity()) {
-        memset(mWriteView->base() + mWriteView->size(), 0u,
-                mWriteView->capacity() - mWriteView->size());
-        mWriteView->setSize(mWriteView->capacity());
+    size_t frameBytes = frameSizeBytes();
+    if (mFrameFill < frameBytes) {
+        memset(mWriteView->base() + mFrameOffset + mFrameFill, 0u, frameBytes - mFrameFill);
     }
     std::unique_ptr<C2Work> work{std::make_unique<C2Work>()};
     work->input.ordinal = mCurrentOrdinal;
     work->input.buffers.push_back(C2Buffer::CreateLinearBuffer(
-            mCurrentBlock->share(0, mCurrentBlock->capacity(), C2Fence())));
+            mCurrentBlock->share(mFrameOffset, frameBytes, C2Fence())));
     work->worklets.clear();
     work->worklets.emplace_back(new C2Worklet);
     items->push_back(std::move(work));
@@ -220,8 +246,14 @@ void FrameReassembler::finishCurrentBlock(std::list<std::unique_ptr<C2Work>> *it
     ++mCurrentOrdinal.frameIndex;
     mCurrentOrdinal.timestamp += mFrameSize.value() * 1000000 / mSampleRate;
     mCurrentOrdinal.customOrdinal = mCurrentOrdinal.timestamp;
-    mCurrentBlock.reset();
-    mWriteView.reset();
+    mFrameOffset += frameBytes;
+    mFrameFill = 0u;
+    if (mFrameOffset + frameBytes > mCurrentBlock->capacity()) {
+        // Do not hold on to a full block; it returns to the pool with its last frame.
+        mWriteView.reset();
+        mCurrentBlock.reset();
+        mFrameOffset = 0u;
+    }
 }
 
 }  // namespace android
@@ -31,13 +31,20 @@ class FrameReassembler {
 public:
     FrameReassembler();
 
+    /**
+     * Frames are written back to back in linear blocks of |framesPerBlock| frames, and each
+     * frame is sent as a sub-range of its block, so that a block is fetched from |pool| only
+     * once every |framesPerBlock| frames. A block returns to the pool once all its frames are
+     * released.
+     */
     void init(
             const std::shared_ptr<C2BlockPool> &pool,
             C2MemoryUsage usage,
             uint32_t frameSize,
             uint32_t sampleRate,
             uint32_t channelCount,
-            C2Config::pcm_encoding_t encoding);
+            C2Config::pcm_encoding_t encoding,
+            uint32_t framesPerBlock = 1u);
     void updateFrameSize(uint32_t frameSize);
     void updateSampleRate(uint32_t sampleRate);
     void updateChannelCount(uint32_t channelCount);
@@ -60,12 +67,18 @@ private:
     C2Config::pcm_encoding_t mEncoding;
     std::list<std::unique_ptr<C2Work>> mPendingWork;
     C2WorkOrdinalStruct mCurrentOrdinal;
+    uint32_t mFramesPerBlock;
     std::shared_ptr<C2LinearBlock> mCurrentBlock;
     std::optional<C2WriteView> mWriteView;
+    size_t mFrameOffset;  // offset of the current frame in mCurrentBlock
+    size_t mFrameFill;    // bytes written to the current frame; 0 if there is no pending frame
 
     uint64_t bytesToSamples(size_t numBytes) const;
     size_t usToSamples(uint64_t us) const;
     uint32_t bytesPerSample() const;
+    size_t frameSizeBytes() const;
+
+    c2_status_t startFrame();
 
     void finishCurrentBlock(std::list<std::unique_ptr<C2Work>> *items);
 };
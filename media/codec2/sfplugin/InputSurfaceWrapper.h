@@ -80,6 +80,7 @@ public:
         float mMinAdjustedFps = 0.0; // minimum fps via PTS manipulation
         uint64_t mUsage = 0; // consumer usage
         int mPriority = INT_MAX; // priority of queue thread (if any); INT_MAX for no-op
+        size_t mMaxBacklog = 0; // max works in flight before holding back frames; 0 for no-op
     };
 
     /**
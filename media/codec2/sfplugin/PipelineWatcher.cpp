@@ -17,14 +17,36 @@
 //#define LOG_NDEBUG 0
 #define LOG_TAG "PipelineWatcher"
 
+#include <inttypes.h>
+
+#include <algorithm>
 #include <numeric>
 
+#include <android-base/stringprintf.h>
 #include <log/log.h>
 
 #include "PipelineWatcher.h"
 
 namespace android {
 
+namespace {
+
+// number of completed work items between two adaptations of the smoothness factor
+constexpr uint32_t kAdaptationWindow = 16;
+
+// weight of a new sample in the moving averages, as a shift
+constexpr int kAverageShift = 4;
+
+PipelineWatcher::Clock::duration movingAverage(
+        PipelineWatcher::Clock::duration average, PipelineWatcher::Clock::duration sample) {
+    if (average == PipelineWatcher::Clock::duration::zero()) {
+        return sample;
+    }
+    return average + (sample - average) / (1 << kAverageShift);
+}
+
+}  // namespace
+
 PipelineWatcher &PipelineWatcher::inputDelay(uint32_t value) {
     mInputDelay = value;
     return *this;
@@ -42,6 +64,17 @@ PipelineWatcher &PipelineWatcher::outputDelay(uint32_t value) {
 
 PipelineWatcher &PipelineWatcher::smoothnessFactor(uint32_t value) {
     mSmoothnessFactor = value;
+    mMinSmoothnessFactor = value;
+    mMaxSmoothnessFactor = value;
+    return *this;
+}
+
+PipelineWatcher &PipelineWatcher::smoothnessFactorBounds(uint32_t min, uint32_t max) {
+    mMinSmoothnessFactor = std::min(min, max);
+    mMaxSmoothnessFactor = max;
+    mSmoothnessFactor = std::clamp(mSmoothnessFactor, mMinSmoothnessFactor, mMaxSmoothnessFactor);
+    mWindowWorkDone = 0;
+    mWindowFull = 0;
     return *this;
 }
 
@@ -59,6 +92,10 @@ void PipelineWatcher::onWorkQueued(
               (unsigned long long)frameIndex);
         (void)mFramesInPipeline.erase(it);
     }
+    if (mLastQueuedAt != Clock::time_point() && queuedAt > mLastQueuedAt) {
+        mAvgQueueInterval = movingAverage(mAvgQueueInterval, queuedAt - mLastQueuedAt);
+    }
+    mLastQueuedAt = queuedAt;
     (void)mFramesInPipeline.try_emplace(frameIndex, std::move(buffers), queuedAt);
 }
 
@@ -91,18 +128,52 @@ void PipelineWatcher::onWorkDone(uint64_t frameIndex) {
               (unsigned long long)frameIndex);
         return;
     }
+    const Clock::duration turnaround = Clock::now() - it->second.queuedAt;
     (void)mFramesInPipeline.erase(it);
+
+    mAvgTurnaround = movingAverage(mAvgTurnaround, turnaround);
+    mMaxTurnaround = std::max(mMaxTurnaround, turnaround);
+    ++mWorkDone;
+    if (++mWindowWorkDone >= kAdaptationWindow) {
+        adaptSmoothnessFactor();
+    }
+}
+
+void PipelineWatcher::adaptSmoothnessFactor() {
+    if (mMinSmoothnessFactor < mMaxSmoothnessFactor) {
+        const uint32_t delays = mInputDelay + mPipelineDelay + mOutputDelay;
+        // work items in flight needed to keep up with the queue rate
+        uint64_t needed = 0;
+        if (mAvgQueueInterval > Clock::duration::zero()) {
+            needed = (mAvgTurnaround + mAvgQueueInterval - Clock::duration(1)) / mAvgQueueInterval;
+        }
+        if (mWindowFull * 2 >= mWindowWorkDone
+                && mSmoothnessFactor < mMaxSmoothnessFactor) {
+            // the client had more work than the pipeline took most of the time
+            ++mSmoothnessFactor;
+            ALOGV("smoothness factor grows to %u", mSmoothnessFactor);
+        } else if (needed + 1 < delays + mSmoothnessFactor
+                && mSmoothnessFactor > mMinSmoothnessFactor) {
+            --mSmoothnessFactor;
+            ALOGV("smoothness factor shrinks to %u (%" PRIu64 " needed)",
+                  mSmoothnessFactor, needed);
+        }
+    }
+    mWindowWorkDone = 0;
+    mWindowFull = 0;
 }
 
 void PipelineWatcher::flush() {
     ALOGV("flush");
     mFramesInPipeline.clear();
+    mLastQueuedAt = Clock::time_point();
 }
 
 bool PipelineWatcher::pipelineFull(size_t *pipelineRoom) const {
     if (mFramesInPipeline.size() >=
             mInputDelay + mPipelineDelay + mOutputDelay + mSmoothnessFactor) {
         ALOGV("pipelineFull: too many frames in pipeline (%zu)", mFramesInPipeline.size());
+        ++mWindowFull;
         return true;
     }
     size_t sizeWithInputReleased = std::count_if(
@@ -157,4 +228,18 @@ PipelineWatcher::Clock::duration PipelineWatcher::elapsed(
     return durations[n];
 }
 
+std::string PipelineWatcher::statsString() const {
+    using std::chrono::duration_cast;
+    using std::chrono::microseconds;
+    return android::base::StringPrintf(
+            "%" PRIu64 " works done, turnaround avg %lldus max %lldus, queue interval avg %lldus, "
+            "depth %u+%u+%u+%u (smoothness %u..%u)",
+            mWorkDone,
+            (long long)duration_cast<microseconds>(mAvgTurnaround).count(),
+            (long long)duration_cast<microseconds>(mMaxTurnaround).count(),
+            (long long)duration_cast<microseconds>(mAvgQueueInterval).count(),
+            mInputDelay, mPipelineDelay, mOutputDelay, mSmoothnessFactor,
+            mMinSmoothnessFactor, mMaxSmoothnessFactor);
+}
+
 }  // namespace android
@@ -20,6 +20,7 @@
 #include <chrono>
 #include <map>
 #include <memory>
+#include <string>
 
 #include <C2Work.h>
 
@@ -37,7 +38,9 @@ public:
         : mInputDelay(0),
           mPipelineDelay(0),
           mOutputDelay(0),
-          mSmoothnessFactor(0) {}
+          mSmoothnessFactor(0),
+          mMinSmoothnessFactor(0),
+          mMaxSmoothnessFactor(0) {}
     ~PipelineWatcher() = default;
 
     /**
@@ -64,6 +67,23 @@ public:
      */
     PipelineWatcher &smoothnessFactor(uint32_t value);
 
+    /**
+     * Let the smoothness factor adapt to the measured turnaround of the work
+     * items. The factor grows while the client keeps the pipeline full, and
+     * shrinks while fewer work items than in the pipeline would sustain the
+     * rate at which the client queues. Equal bounds keep the factor fixed.
+     *
+     * \param min   the lowest smoothness factor
+     * \param max   the highest smoothness factor
+     * eturn  this object
+     */
+    PipelineWatcher &smoothnessFactorBounds(uint32_t min, uint32_t max);
+
+    /**
+     * eturn  the current smoothness factor
+     */
+    uint32_t smoothnessFactor() const { return mSmoothnessFactor; }
+
     /**
      * Client queued a work item to the component.
      *
@@ -119,11 +139,32 @@ public:
      */
     Clock::duration elapsed(const Clock::time_point &now, size_t n) const;
 
+    /**
+     * eturn  turnaround statistics of the work items and the current pipeline depth,
+     *          for logging.
+     */
+    std::string statsString() const;
+
 private:
     uint32_t mInputDelay;
     uint32_t mPipelineDelay;
     uint32_t mOutputDelay;
     uint32_t mSmoothnessFactor;
+    uint32_t mMinSmoothnessFactor;
+    uint32_t mMaxSmoothnessFactor;
+
+    // turnaround statistics, kept across flushes
+    Clock::duration mAvgTurnaround{Clock::duration::zero()};
+    Clock::duration mMaxTurnaround{Clock::duration::zero()};
+    Clock::duration mAvgQueueInterval{Clock::duration::zero()};
+    Clock::time_point mLastQueuedAt;
+    uint64_t mWorkDone{0};
+
+    // adaptation window
+    uint32_t mWindowWorkDone{0};
+    mutable uint32_t mWindowFull{0};
+
+    void adaptSmoothnessFactor();
 
     struct Frame {
         Frame(std::vector<std::shared_ptr<C2Buffer>> &&b,
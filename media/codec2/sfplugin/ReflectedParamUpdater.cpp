@@ -177,7 +177,7 @@ void ReflectedParamUpdater::addParamStructDesc(
         ALOGV("%s registered", fieldName.c_str());
         // TODO: get the proper size by iterating through the fields.
         // only insert fields the very first time
-        mMap.emplace(fieldName, FieldDesc {
+        addField(fieldName, FieldDesc {
             desc,
             std::make_unique<C2FieldDescriptor>(
                     it->type(), it->extent(), it->name(),
@@ -210,7 +210,7 @@ void ReflectedParamUpdater::addParamDesc(
     // this is opt-in for now
     auto it = mWholeParams.find(paramName);
     if (it != mWholeParams.end() && it->second.coreIndex() == desc->index().coreIndex()) {
-        mMap.emplace(paramName, FieldDesc{ desc, nullptr, 0 /* offset */ });
+        addField(paramName, FieldDesc{ desc, nullptr, 0 /* offset */ });
         // don't add fields of whole parameters.
         return;
     }
@@ -218,6 +218,14 @@ void ReflectedParamUpdater::addParamDesc(
     addParamStructDesc(desc, paramName, 0 /* offset */, structDesc, reflector);
 }
 
+void ReflectedParamUpdater::addField(const std::string &name, FieldDesc &&desc) {
+    C2Param::Index index = desc.paramDesc->index();
+    auto insertion = mMap.emplace(name, std::move(desc));
+    if (insertion.second) {
+        mFieldsByIndex[index].push_back(insertion.first);
+    }
+}
+
 void ReflectedParamUpdater::supportWholeParam(std::string name, C2Param::CoreIndex index) {
     mWholeParams.emplace(name, index);
 }
@@ -279,12 +287,12 @@ void ReflectedParamUpdater::getKeysForParamIndex(
         std::vector<std::string> *keys /* nonnull */) const {
     CHECK(keys != nullptr);
     keys->clear();
-    for (const std::pair<const std::string, FieldDesc> &kv : mMap) {
-        const std::string &name = kv.first;
-        const FieldDesc &desc = kv.second;
-        if (desc.paramDesc->index() == index) {
-            keys->push_back(name);
-        }
+    auto it = mFieldsByIndex.find(index);
+    if (it == mFieldsByIndex.end()) {
+        return;
+    }
+    for (const auto &field : it->second) {
+        keys->push_back(field->first);
     }
 }
 
@@ -508,13 +516,20 @@ ReflectedParamUpdater::getParams(const std::vector<C2Param*> &params) const {
         }
     }
 
-    for (const std::pair<const std::string, FieldDesc> &kv : mMap) {
-        const std::string &name = kv.first;
-        const FieldDesc &desc = kv.second;
-        if (paramsMap.count(desc.paramDesc->index()) == 0) {
-            continue;
+    // only visit the fields of the given params
+    std::vector<std::pair<std::map<std::string, FieldDesc>::const_iterator, C2Param *>> fields;
+    for (const std::pair<const C2Param::Index, C2Param *> &entry : paramsMap) {
+        auto it = mFieldsByIndex.find(entry.first);
+        if (it != mFieldsByIndex.end()) {
+            for (const auto &field : it->second) {
+                fields.emplace_back(field, entry.second);
+            }
         }
-        C2Param *param = paramsMap[desc.paramDesc->index()];
+    }
+
+    for (const auto &[field, param] : fields) {
+        const std::string &name = field->first;
+        const FieldDesc &desc = field->second;
         Value value;
 
         // handle whole params first
@@ -592,6 +607,7 @@ ReflectedParamUpdater::getParams(const std::vector<C2Param*> &params) const {
 }
 
 void ReflectedParamUpdater::clear() {
+    mFieldsByIndex.clear();
     mMap.clear();
 }
 
@@ -19,6 +19,7 @@
 
 #include <map>
 #include <memory>
+#include <vector>
 
 #include <C2.h>
 #include <C2Param.h>
@@ -217,6 +218,10 @@ private:
         size_t offset;
     };
     std::map<std::string, FieldDesc> mMap;
+    /// fields of mMap grouped by param index, so that only the fields of the queried params
+    /// are visited
+    std::map<C2Param::Index, std::vector<std::map<std::string, FieldDesc>::const_iterator>>
+        mFieldsByIndex;
     std::map<C2Param::Index, std::string> mParamNames;
     std::map<std::string, C2Param::CoreIndex> mWholeParams;
 
@@ -224,6 +229,8 @@ private:
             const Dict &params,
             std::function<void(const std::string &, const FieldDesc &, const void *, size_t)> work) const;
 
+    void addField(const std::string &name, FieldDesc &&desc);
+
     C2_DO_NOT_COPY(ReflectedParamUpdater);
 };
 
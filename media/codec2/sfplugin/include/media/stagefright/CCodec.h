@@ -150,6 +150,7 @@ private:
 
         kWhatWorkDone,
         kWhatWatch,
+        kWhatFlushInputBatch,
     };
 
     enum {
@@ -496,6 +496,38 @@ TEST_F(CCodecConfigTest, PixelAspectRatioUpdate) {
             << "mInputFormat = " << mConfig.mInputFormat->debugString().c_str();
 }
 
+TEST_F(CCodecConfigTest, RepeatedPixelAspectRatioUpdate) {
+    init(C2Component::DOMAIN_VIDEO, C2Component::KIND_DECODER, MIMETYPE_VIDEO_AVC);
+
+    ASSERT_EQ(OK, mConfig.initialize(mReflector, mConfigurable));
+
+    std::vector<std::unique_ptr<C2Param>> configUpdate;
+    configUpdate.push_back(C2Param::Copy(C2StreamPixelAspectRatioInfo::output(0u, 12, 11)));
+    ASSERT_TRUE(mConfig.updateConfiguration(configUpdate, D::ALL));
+
+    // Only the changed param is reflected again; the rest of the format must be kept.
+    configUpdate.clear();
+    configUpdate.push_back(C2Param::Copy(C2StreamPixelAspectRatioInfo::output(0u, 4, 3)));
+    ASSERT_TRUE(mConfig.updateConfiguration(configUpdate, D::ALL));
+
+    int32_t parWidth{0};
+    ASSERT_TRUE(mConfig.mOutputFormat->findInt32(KEY_PIXEL_ASPECT_RATIO_WIDTH, &parWidth))
+            << "mOutputFormat = " << mConfig.mOutputFormat->debugString().c_str();
+    ASSERT_EQ(4, parWidth);
+    int32_t parHeight{0};
+    ASSERT_TRUE(mConfig.mOutputFormat->findInt32(KEY_PIXEL_ASPECT_RATIO_HEIGHT, &parHeight))
+            << "mOutputFormat = " << mConfig.mOutputFormat->debugString().c_str();
+    ASSERT_EQ(3, parHeight);
+    AString mediaType;
+    ASSERT_TRUE(mConfig.mOutputFormat->findString(KEY_MIME, &mediaType))
+            << "mOutputFormat = " << mConfig.mOutputFormat->debugString().c_str();
+
+    // The same value again is not a change.
+    configUpdate.clear();
+    configUpdate.push_back(C2Param::Copy(C2StreamPixelAspectRatioInfo::output(0u, 4, 3)));
+    ASSERT_FALSE(mConfig.updateConfiguration(configUpdate, D::ALL));
+}
+
 TEST_F(CCodecConfigTest, DataspaceUpdate) {
     init(C2Component::DOMAIN_VIDEO, C2Component::KIND_ENCODER, MIMETYPE_VIDEO_AVC);
 
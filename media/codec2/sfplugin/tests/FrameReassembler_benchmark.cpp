@@ -0,0 +1,101 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Benchmark of the reassembly of 10 ms PCM input buffers into AAC and Opus encoder frames,
+// reporting encoder frames per second for a given number of frames per block.
+
+#include <list>
+#include <memory>
+
+#include <benchmark/benchmark.h>
+
+#include <C2PlatformSupport.h>
+
+#include <media/stagefright/foundation/ABuffer.h>
+#include <media/stagefright/foundation/AMessage.h>
+
+#include "FrameReassembler.h"
+
+using namespace android;
+
+namespace {
+
+constexpr uint32_t kSampleRate = 48000;
+constexpr uint32_t kChannelCount = 2;
+constexpr uint32_t kBytesPerSample = 2;  // PCM_16
+constexpr uint32_t kInputSamples = kSampleRate / 100;  // 10 ms
+constexpr int kInputBuffersPerIteration = 100;  // 1 s
+
+// Args: encoder frame size in samples, frames per block.
+void runReassembler(benchmark::State& state) {
+    const uint32_t frameSize = state.range(0);
+    const uint32_t framesPerBlock = state.range(1);
+
+    std::shared_ptr<C2BlockPool> pool;
+    if (GetCodec2BlockPool(C2BlockPool::BASIC_LINEAR, nullptr, &pool) != C2_OK) {
+        state.SkipWithError("cannot get the basic linear block pool");
+        return;
+    }
+    FrameReassembler frameReassembler;
+    frameReassembler.init(
+            pool,
+            {C2MemoryUsage::CPU_READ, C2MemoryUsage::CPU_WRITE},
+            frameSize,
+            kSampleRate,
+            kChannelCount,
+            C2Config::PCM_16,
+            framesPerBlock);
+
+    const size_t inputBytes = kInputSamples * kChannelCount * kBytesPerSample;
+    sp<MediaCodecBuffer> buffer = new MediaCodecBuffer(new AMessage, new ABuffer(inputBytes));
+    memset(buffer->base(), 0x5a, inputBytes);
+    std::list<std::unique_ptr<C2Work>> items;
+    int64_t timeUs = 0;
+    int64_t frames = 0;
+    for (auto _ : state) {
+        for (int i = 0; i < kInputBuffersPerIteration; ++i) {
+            buffer->setRange(0, inputBytes);
+            buffer->meta()->setInt64("timeUs", timeUs);
+            if (frameReassembler.process(buffer, &items) != C2_OK) {
+                state.SkipWithError("process failed");
+                return;
+            }
+            timeUs += 10000;
+            // Release the frames as the encoder would.
+            frames += items.size();
+            items.clear();
+        }
+    }
+    state.SetItemsProcessed(frames);
+    state.counters["frames/s"] = benchmark::Counter(frames, benchmark::Counter::kIsRate);
+}
+
+}  // namespace
+
+// AAC-LC encoder frames of 1024 samples.
+static void BM_ReassembleAac(benchmark::State& state) {
+    runReassembler(state);
+}
+
+// Opus encoder frames of 10 ms.
+static void BM_ReassembleOpus(benchmark::State& state) {
+    runReassembler(state);
+}
+
+BENCHMARK(BM_ReassembleAac)->ArgsProduct({{1024}, {1, 4, 8}});
+BENCHMARK(BM_ReassembleOpus)->ArgsProduct({{kInputSamples}, {1, 4, 8}});
+
+BENCHMARK_MAIN();
@@ -54,7 +54,8 @@ public:
             size_t inputFrameSizeInBytes,
             size_t count,
             size_t expectedOutputSize,
-            bool separateEos) {
+            bool separateEos,
+            uint32_t framesPerBlock = 1u) {
         FrameReassembler frameReassembler;
         frameReassembler.init(
                 mPool,
@@ -62,7 +63,8 @@ public:
                 encoderFrameSize,
                 sampleRate,
                 channelCount,
-                encoding);
+                encoding,
+                framesPerBlock);
 
         ASSERT_TRUE(frameReassembler) << "FrameReassembler init failed";
 
@@ -378,4 +380,43 @@ TEST_F(FrameReassemblerTest, PushBigChunk) {
     }
 }
 
+// Push frames of various sizes with several frames packed in each block.
+TEST_F(FrameReassemblerTest, PushMultipleFramesPerBlock) {
+    ASSERT_EQ(OK, initStatus());
+    for (bool separateEos : {false, true}) {
+        for (uint32_t framesPerBlock : {2u, 4u}) {
+            testPushSameSize(
+                    1024 /* frame size in samples */,
+                    48000 /* sample rate */,
+                    1 /* channel count */,
+                    PCM_16,
+                    2048 /* input frame size in bytes = 1024 samples * 1 channel * 2 bytes/sample */,
+                    10 /* count */,
+                    20480 /* expected output size = 10 * 2048 bytes/frame */,
+                    separateEos,
+                    framesPerBlock);
+            testPushSameSize(
+                    1024 /* frame size in samples */,
+                    48000 /* sample rate */,
+                    1 /* channel count */,
+                    PCM_16,
+                    960 /* input frame size in bytes = 480 samples * 1 channel * 2 bytes/sample */,
+                    10 /* count */,
+                    10240 /* expected output size = 5 * 2048 bytes/frame */,
+                    separateEos,
+                    framesPerBlock);
+            testPushSameSize(
+                    1024 /* frame size in samples */,
+                    48000 /* sample rate */,
+                    1 /* channel count */,
+                    PCM_FLOAT,
+                    100000 /* input frame size in bytes */,
+                    1 /* count */,
+                    102400 /* expected output size = 25 * 4096 bytes/frame */,
+                    separateEos,
+                    framesPerBlock);
+        }
+    }
+}
+
 } // namespace android
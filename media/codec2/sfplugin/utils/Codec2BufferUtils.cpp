@@ -39,13 +39,14 @@ namespace {
 
 /**
  * A flippable, optimizable memcpy. Constructs such as (from ? src : dst)
- * do not work as the results are always const.
+ * do not work as the results are always const. A non-zero S is the size of every copy, which
+ * turns the copy into a single load and store.
  */
 template<bool ToA, size_t S>
 struct MemCopier {
     template<typename A, typename B>
     inline static void copy(A *a, const B *b, size_t size) {
-        __builtin_memcpy(a, b, size);
+        __builtin_memcpy(a, b, S != 0 ? S : size);
     }
 };
 
@@ -57,6 +58,28 @@ struct MemCopier<false, S> {
     }
 };
 
+/**
+ * Copies a plane pixel by pixel, for interleaved planes. S is the pixel size, or 0 if only known
+ * at runtime as |bpp|.
+ */
+template<bool ToMediaImage, size_t S, typename ImagePixel, typename ViewPixel>
+static void CopyPixels(
+        ImagePixel *imgRow, int32_t imgColInc, int32_t imgRowInc,
+        ViewPixel *viewRow, int32_t viewColInc, int32_t viewRowInc,
+        uint32_t planeW, uint32_t planeH, size_t bpp) {
+    for (uint32_t row = 0; row < planeH; ++row) {
+        ImagePixel *imgPtr = imgRow;
+        ViewPixel *viewPtr = viewRow;
+        for (uint32_t col = 0; col < planeW; ++col) {
+            MemCopier<ToMediaImage, S>::copy(imgPtr, viewPtr, bpp);
+            imgPtr += imgColInc;
+            viewPtr += viewColInc;
+        }
+        imgRow += imgRowInc;
+        viewRow += viewRowInc;
+    }
+}
+
 /**
  * Copies between a MediaImage and a graphic view.
  *
@@ -101,18 +124,18 @@ static status_t _ImageCopy(View &view, const MediaImage2 *img, ImagePixel *imgBa
                 imgRow += img->mPlane[i].mRowInc;
                 viewRow += plane.rowInc;
             }
+        } else if (bpp == 1) {
+            CopyPixels<ToMediaImage, 1>(
+                    imgRow, img->mPlane[i].mColInc, img->mPlane[i].mRowInc,
+                    viewRow, plane.colInc, plane.rowInc, planeW, planeH, bpp);
+        } else if (bpp == 2) {
+            CopyPixels<ToMediaImage, 2>(
+                    imgRow, img->mPlane[i].mColInc, img->mPlane[i].mRowInc,
+                    viewRow, plane.colInc, plane.rowInc, planeW, planeH, bpp);
         } else {
-            for (uint32_t row = 0; row < planeH; ++row) {
-                decltype(imgRow) imgPtr = imgRow;
-                decltype(viewRow) viewPtr = viewRow;
-                for (uint32_t col = 0; col < planeW; ++col) {
-                    MemCopier<ToMediaImage, 0>::copy(imgPtr, viewPtr, bpp);
-                    imgPtr += img->mPlane[i].mColInc;
-                    viewPtr += plane.colInc;
-                }
-                imgRow += img->mPlane[i].mRowInc;
-                viewRow += plane.rowInc;
-            }
+            CopyPixels<ToMediaImage, 0>(
+                    imgRow, img->mPlane[i].mColInc, img->mPlane[i].mRowInc,
+                    viewRow, plane.colInc, plane.rowInc, planeW, planeH, bpp);
         }
     }
     return OK;
@@ -432,6 +432,38 @@ TEST_F(C2BufferTest, BlockPoolTest) {
     }
 }
 
+TEST_F(C2BufferTest, BlockPoolReuseTest) {
+    constexpr size_t kCapacity = 64u * 1024u;
+    constexpr C2MemoryUsage kUsage = { C2MemoryUsage::CPU_READ, C2MemoryUsage::CPU_WRITE };
+
+    std::shared_ptr<C2BlockPool> blockPool(makeLinearBlockPool());
+
+    std::shared_ptr<C2LinearBlock> block;
+    ASSERT_EQ(C2_OK, blockPool->fetchLinearBlock(kCapacity, kUsage, &block));
+    ASSERT_TRUE(block);
+    const C2Handle *handle = block->handle();
+    ASSERT_NE(nullptr, handle);
+
+    // a released block is served again for the same parameters
+    block.reset();
+    ASSERT_EQ(C2_OK, blockPool->fetchLinearBlock(kCapacity, kUsage, &block));
+    ASSERT_TRUE(block);
+    EXPECT_EQ(handle, block->handle());
+    EXPECT_EQ(kCapacity, block->capacity());
+
+    // but not while it is still in use
+    std::shared_ptr<C2LinearBlock> other;
+    ASSERT_EQ(C2_OK, blockPool->fetchLinearBlock(kCapacity, kUsage, &other));
+    ASSERT_TRUE(other);
+    EXPECT_NE(block->handle(), other->handle());
+
+    // nor for other parameters
+    block.reset();
+    ASSERT_EQ(C2_OK, blockPool->fetchLinearBlock(kCapacity * 2, kUsage, &block));
+    ASSERT_TRUE(block);
+    EXPECT_EQ(kCapacity * 2, block->capacity());
+}
+
 void fillPlane(const C2Rect rect, const C2PlaneInfo info, uint8_t *addr, uint8_t value) {
     for (uint32_t row = 0; row < rect.height / info.rowSampling; ++row) {
         int32_t rowOffset = (row + rect.top / info.rowSampling) * info.rowInc;
@@ -0,0 +1,89 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Fetch rate of C2PooledBlockPool with the block turnover of a high frame rate pipeline,
+// reporting fetches per second and the share of a 240 and 480 fps frame interval spent
+// on each fetch.
+
+#include <deque>
+#include <memory>
+
+#include <benchmark/benchmark.h>
+#include <C2Buffer.h>
+#include <C2BufferPriv.h>
+#include <C2PlatformSupport.h>
+
+using namespace android;
+
+namespace {
+
+constexpr C2MemoryUsage kUsage = { C2MemoryUsage::CPU_READ, C2MemoryUsage::CPU_WRITE };
+
+// compressed 1080p frame and raw 1080p frame
+constexpr uint32_t kCapacities[] = { 256u * 1024u, 1920u * 1080u * 3u / 2u };
+
+std::shared_ptr<C2BlockPool> makePool(benchmark::State& state) {
+    std::shared_ptr<C2Allocator> allocator;
+    std::shared_ptr<C2AllocatorStore> store = GetCodec2PlatformAllocatorStore();
+    if (store->fetchAllocator(C2AllocatorStore::DEFAULT_LINEAR, &allocator) != C2_OK) {
+        state.SkipWithError("no linear allocator");
+        return nullptr;
+    }
+    return std::make_shared<C2PooledBlockPool>(allocator, C2BlockPool::PLATFORM_START);
+}
+
+void setCounters(benchmark::State& state, int64_t fetches) {
+    state.SetItemsProcessed(fetches);
+    state.counters["fetches/s"] = benchmark::Counter(fetches, benchmark::Counter::kIsRate);
+    // frame interval share of one fetch, 1 being the whole interval
+    state.counters["240fps"] = benchmark::Counter(
+            fetches / 240., benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
+    state.counters["480fps"] = benchmark::Counter(
+            fetches / 480., benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
+}
+
+}  // namespace
+
+// Fetches blocks while the given number of the previous ones are still in flight, as in a
+// pipeline of that depth. Args: capacity index, pipeline depth.
+static void BM_FetchLinearBlock(benchmark::State& state) {
+    const uint32_t capacity = kCapacities[state.range(0)];
+    const size_t depth = state.range(1);
+    std::shared_ptr<C2BlockPool> pool = makePool(state);
+    if (pool == nullptr) {
+        return;
+    }
+    std::deque<std::shared_ptr<C2LinearBlock>> inFlight;
+    int64_t fetches = 0;
+    for (auto _ : state) {
+        std::shared_ptr<C2LinearBlock> block;
+        if (pool->fetchLinearBlock(capacity, kUsage, &block) != C2_OK) {
+            state.SkipWithError("fetchLinearBlock failed");
+            break;
+        }
+        inFlight.push_back(std::move(block));
+        if (inFlight.size() > depth) {
+            inFlight.pop_front();
+        }
+        ++fetches;
+    }
+    inFlight.clear();
+    setCounters(state, fetches);
+}
+
+BENCHMARK(BM_FetchLinearBlock)->ArgsProduct({{0, 1}, {1, 4, 8}});
+
+BENCHMARK_MAIN();
@@ -18,6 +18,9 @@
 #define LOG_TAG "C2Buffer"
 #include <utils/Log.h>
 
+#include <atomic>
+#include <chrono>
+#include <functional>
 #include <list>
 #include <map>
 #include <mutex>
@@ -351,21 +354,33 @@ c2_status_t C2BasicLinearBlockPool::fetchLinearBlock(
 }
 
 struct C2_HIDE C2PooledBlockPoolData : _C2BlockPoolData {
+    typedef std::function<void(std::shared_ptr<bufferpool::BufferPoolData> &&)> OnRelease;
 
     virtual type_t getType() const override {
         return TYPE_BUFFERPOOL;
     }
 
     void getBufferPoolData(std::shared_ptr<bufferpool::BufferPoolData> *data) const {
+        // the buffer may now be held outside of the block; only the accessor knows
+        // when it is released.
+        mExported = true;
         *data = mData;
     }
 
-    C2PooledBlockPoolData(const std::shared_ptr<bufferpool::BufferPoolData> &data) : mData(data) {}
+    C2PooledBlockPoolData(const std::shared_ptr<bufferpool::BufferPoolData> &data,
+                          OnRelease onRelease = nullptr)
+            : mData(data), mOnRelease(std::move(onRelease)), mExported(false) {}
 
-    virtual ~C2PooledBlockPoolData() override {}
+    virtual ~C2PooledBlockPoolData() override {
+        if (mOnRelease && !mExported) {
+            mOnRelease(std::move(mData));
+        }
+    }
 
 private:
     std::shared_ptr<bufferpool::BufferPoolData> mData;
+    OnRelease mOnRelease;
+    mutable std::atomic_bool mExported;
 };
 
 bool _C2BlockFactory::GetBufferPoolData(
@@ -381,22 +396,33 @@ bool _C2BlockFactory::GetBufferPoolData(
 }
 
 struct C2_HIDE C2PooledBlockPoolData2 : _C2BlockPoolData { // AIDL BufferPool(bufferpool2)
+    typedef std::function<void(std::shared_ptr<bufferpool2::BufferPoolData> &&)> OnRelease;
 
     type_t getType() const override {
         return TYPE_BUFFERPOOL2;
     }
 
     void getBufferPoolData(std::shared_ptr<bufferpool2::BufferPoolData> *data) const {
+        // the buffer may now be held outside of the block; only the accessor knows
+        // when it is released.
+        mExported = true;
         *data = mData;
     }
 
-    C2PooledBlockPoolData2(const std::shared_ptr<bufferpool2::BufferPoolData> &data)
-            : mData(data) {}
+    C2PooledBlockPoolData2(const std::shared_ptr<bufferpool2::BufferPoolData> &data,
+                           OnRelease onRelease = nullptr)
+            : mData(data), mOnRelease(std::move(onRelease)), mExported(false) {}
 
-    virtual ~C2PooledBlockPoolData2() override {}
+    virtual ~C2PooledBlockPoolData2() override {
+        if (mOnRelease && !mExported) {
+            mOnRelease(std::move(mData));
+        }
+    }
 
 private:
     std::shared_ptr<bufferpool2::BufferPoolData> mData;
+    OnRelease mOnRelease;
+    mutable std::atomic_bool mExported;
 };
 
 bool _C2BlockFactory::GetBufferPoolData(
@@ -729,12 +755,119 @@ c2_status_t _C2BufferPoolAllocator::priorGraphicAllocation(
     return mAllocator->priorGraphicAllocation(handle, c2Allocation);
 }
 
+/**
+ * Blocks recently released by the users of a C2PooledBlockPool, kept locally so that a fetch
+ * with the same allocation parameters is served without a buffer pool allocation, which takes
+ * the ClientManager and Accessor locks.
+ *
+ * Only blocks whose buffer pool data never left the block are kept. The accessor still sees a
+ * kept buffer as used by this client; it gets the buffer back through the regular release once
+ * the buffer was not reused for kMaxIdle, is pushed out of the cache, or the cache is cleared.
+ */
+template <typename BufferPoolData>
+class C2_HIDE _C2PooledBlockCache
+        : public std::enable_shared_from_this<_C2PooledBlockCache<BufferPoolData>> {
+public:
+    typedef std::function<void(std::shared_ptr<BufferPoolData> &&)> OnRelease;
+
+    struct Entry {
+        std::vector<uint8_t> params;
+        std::shared_ptr<BufferPoolData> data;
+        std::shared_ptr<C2LinearAllocation> linear;
+        std::shared_ptr<C2GraphicAllocation> graphic;
+        std::chrono::steady_clock::time_point releasedAt;
+    };
+
+    ~_C2PooledBlockCache() {
+        ALOGV("pooled block cache: %llu hits, %llu misses",
+              (unsigned long long)mHits, (unsigned long long)mMisses);
+    }
+
+    /**
+     * Takes the most recently released block with the given allocation parameters.
+     */
+    bool take(const std::vector<uint8_t> &params, Entry *entry) {
+        std::list<Entry> expired;
+        bool found = false;
+        {
+            std::lock_guard<std::mutex> lock(mLock);
+            expire_l(std::chrono::steady_clock::now(), &expired);
+            for (auto it = mEntries.begin(); it != mEntries.end(); ++it) {
+                if (it->params == params) {
+                    *entry = std::move(*it);
+                    mEntries.erase(it);
+                    found = true;
+                    break;
+                }
+            }
+            ++(found ? mHits : mMisses);
+        }
+        // expired entries are released to the accessor outside of the lock
+        return found;
+    }
+
+    /**
+     * Returns the release callback of a block, which keeps the block in this cache if the
+     * cache still exists.
+     */
+    OnRelease onRelease(const std::vector<uint8_t> &params,
+                        const std::shared_ptr<C2LinearAllocation> &linear,
+                        const std::shared_ptr<C2GraphicAllocation> &graphic) {
+        std::weak_ptr<_C2PooledBlockCache> weak = this->weak_from_this();
+        return [weak, params, linear, graphic](std::shared_ptr<BufferPoolData> &&data) {
+            std::shared_ptr<_C2PooledBlockCache> cache = weak.lock();
+            if (cache && data && (linear || graphic)) {
+                cache->put({params, std::move(data), linear, graphic,
+                            std::chrono::steady_clock::now()});
+            }
+        };
+    }
+
+    /**
+     * Releases all kept blocks to the accessor.
+     */
+    void clear() {
+        std::list<Entry> entries;
+        std::lock_guard<std::mutex> lock(mLock);
+        entries.swap(mEntries);
+    }
+
+private:
+    static constexpr size_t kMaxEntries = 8;
+    static constexpr std::chrono::steady_clock::duration kMaxIdle = std::chrono::seconds(1);
+
+    void put(Entry &&entry) {
+        std::list<Entry> expired;
+        std::lock_guard<std::mutex> lock(mLock);
+        expire_l(entry.releasedAt, &expired);
+        mEntries.push_front(std::move(entry));
+        if (mEntries.size() > kMaxEntries) {
+            expired.splice(expired.end(), mEntries, std::prev(mEntries.end()));
+        }
+    }
+
+    // entries are in release order, the most recent first
+    void expire_l(std::chrono::steady_clock::time_point now, std::list<Entry> *expired) {
+        while (!mEntries.empty() && now - mEntries.back().releasedAt >= kMaxIdle) {
+            expired->splice(expired->end(), mEntries, std::prev(mEntries.end()));
+        }
+    }
+
+    std::mutex mLock;
+    std::list<Entry> mEntries;
+    uint64_t mHits = 0;
+    uint64_t mMisses = 0;
+};
+
 class C2PooledBlockPool::Impl {
+    typedef _C2PooledBlockCache<bufferpool::BufferPoolData> Cache;
+
 public:
     Impl(const std::shared_ptr<C2Allocator> &allocator)
             : mInit(C2_OK),
               mBufferPoolManager(bufferpool_impl::ClientManager::getInstance()),
-              mAllocator(std::make_shared<_C2BufferPoolAllocator>(allocator)) {
+              mAllocator(std::make_shared<_C2BufferPoolAllocator>(allocator)),
+              mCache(std::make_shared<Cache>()) {
         if (mAllocator && mBufferPoolManager) {
             if (mBufferPoolManager->create(
                     mAllocator, &mConnectionId) == ResultStatus::OK) {
@@ -745,6 +878,7 @@ public:
     }
 
     ~Impl() {
+        mCache->clear();
         if (mInit == C2_OK) {
             mBufferPoolManager->close(mConnectionId);
         }
@@ -759,15 +893,27 @@ public:
         }
         std::vector<uint8_t> params;
         mAllocator->getLinearParams(capacity, usage, &params);
+        Cache::Entry kept;
+        if (mCache->take(params, &kept)) {
+            *block = _C2BlockFactory::CreateLinearBlock(
+                    kept.linear,
+                    std::make_shared<C2PooledBlockPoolData>(
+                            kept.data, mCache->onRelease(params, kept.linear, nullptr)),
+                    0, capacity);
+            if (*block) {
+                return C2_OK;
+            }
+        }
         std::shared_ptr<bufferpool::BufferPoolData> bufferPoolData;
         native_handle_t *cHandle = nullptr;
         ResultStatus status = mBufferPoolManager->allocate(
                 mConnectionId, params, &cHandle, &bufferPoolData);
         if (status == ResultStatus::OK) {
             std::shared_ptr<C2LinearAllocation> alloc;
-            std::shared_ptr<C2PooledBlockPoolData> poolData =
-                    std::make_shared<C2PooledBlockPoolData>(bufferPoolData);
             c2_status_t err = mAllocator->priorLinearAllocation(cHandle, &alloc);
+            std::shared_ptr<C2PooledBlockPoolData> poolData =
+                    std::make_shared<C2PooledBlockPoolData>(
+                            bufferPoolData, mCache->onRelease(params, alloc, nullptr));
             if (err == C2_OK && poolData && alloc) {
                 *block = _C2BlockFactory::CreateLinearBlock(alloc, poolData, 0, capacity);
                 if (*block) {
@@ -792,16 +938,28 @@ public:
         }
         std::vector<uint8_t> params;
         mAllocator->getGraphicParams(width, height, format, usage, &params);
+        Cache::Entry kept;
+        if (mCache->take(params, &kept)) {
+            *block = _C2BlockFactory::CreateGraphicBlock(
+                    kept.graphic,
+                    std::make_shared<C2PooledBlockPoolData>(
+                            kept.data, mCache->onRelease(params, nullptr, kept.graphic)),
+                    C2Rect(width, height));
+            if (*block) {
+                return C2_OK;
+            }
+        }
         std::shared_ptr<bufferpool::BufferPoolData> bufferPoolData;
         native_handle_t *cHandle = nullptr;
         ResultStatus status = mBufferPoolManager->allocate(
                 mConnectionId, params, &cHandle, &bufferPoolData);
         if (status == ResultStatus::OK) {
             std::shared_ptr<C2GraphicAllocation> alloc;
-            std::shared_ptr<C2PooledBlockPoolData> poolData =
-                std::make_shared<C2PooledBlockPoolData>(bufferPoolData);
             c2_status_t err = mAllocator->priorGraphicAllocation(
                     cHandle, &alloc);
+            std::shared_ptr<C2PooledBlockPoolData> poolData =
+                std::make_shared<C2PooledBlockPoolData>(
+                        bufferPoolData, mCache->onRelease(params, nullptr, alloc));
             if (err == C2_OK && poolData && alloc) {
                 *block = _C2BlockFactory::CreateGraphicBlock(
                         alloc, poolData, C2Rect(width, height));
@@ -826,6 +984,7 @@ private:
     const android::sp<bufferpool_impl::ClientManager> mBufferPoolManager;
     bufferpool_impl::ConnectionId mConnectionId; // locally
     const std::shared_ptr<_C2BufferPoolAllocator> mAllocator;
+    const std::shared_ptr<Cache> mCache;
 };
 
 /**
@@ -1041,11 +1200,14 @@ c2_status_t _C2BufferPoolAllocator2::priorGraphicAllocation(
 }
 
 class C2PooledBlockPool::Impl2 {
+    typedef _C2PooledBlockCache<bufferpool2::BufferPoolData> Cache;
+
 public:
     Impl2(const std::shared_ptr<C2Allocator> &allocator)
             : mInit(C2_OK),
               mBufferPoolManager(bufferpool2_impl::ClientManager::getInstance()),
-              mAllocator(std::make_shared<_C2BufferPoolAllocator2>(allocator)) {
+              mAllocator(std::make_shared<_C2BufferPoolAllocator2>(allocator)),
+              mCache(std::make_shared<Cache>()) {
         if (mAllocator && mBufferPoolManager) {
             if (mBufferPoolManager->create(
                     mAllocator, &mConnectionId) == ResultStatus2::OK) {
@@ -1056,6 +1218,7 @@ public:
     }
 
     ~Impl2() {
+        mCache->clear();
         if (mInit == C2_OK) {
             mBufferPoolManager->close(mConnectionId);
         }
@@ -1070,15 +1233,27 @@ public:
         }
         std::vector<uint8_t> params;
         mAllocator->getLinearParams(capacity, usage, &params);
+        Cache::Entry kept;
+        if (mCache->take(params, &kept)) {
+            *block = _C2BlockFactory::CreateLinearBlock(
+                    kept.linear,
+                    std::make_shared<C2PooledBlockPoolData2>(
+                            kept.data, mCache->onRelease(params, kept.linear, nullptr)),
+                    0, capacity);
+            if (*block) {
+                return C2_OK;
+            }
+        }
         std::shared_ptr<bufferpool2::BufferPoolData> bufferPoolData;
         native_handle_t *cHandle = nullptr;
         bufferpool2_impl::BufferPoolStatus status = mBufferPoolManager->allocate(
                 mConnectionId, params, &cHandle, &bufferPoolData);
         if (status == ResultStatus2::OK) {
             std::shared_ptr<C2LinearAllocation> alloc;
-            std::shared_ptr<C2PooledBlockPoolData2> poolData =
-                    std::make_shared<C2PooledBlockPoolData2>(bufferPoolData);
             c2_status_t err = mAllocator->priorLinearAllocation(cHandle, &alloc);
+            std::shared_ptr<C2PooledBlockPoolData2> poolData =
+                    std::make_shared<C2PooledBlockPoolData2>(
+                            bufferPoolData, mCache->onRelease(params, alloc, nullptr));
             if (err == C2_OK && poolData && alloc) {
                 *block = _C2BlockFactory::CreateLinearBlock(alloc, poolData, 0, capacity);
                 if (*block) {
@@ -1103,16 +1278,28 @@ public:
         }
         std::vector<uint8_t> params;
         mAllocator->getGraphicParams(width, height, format, usage, &params);
+        Cache::Entry kept;
+        if (mCache->take(params, &kept)) {
+            *block = _C2BlockFactory::CreateGraphicBlock(
+                    kept.graphic,
+                    std::make_shared<C2PooledBlockPoolData2>(
+                            kept.data, mCache->onRelease(params, nullptr, kept.graphic)),
+                    C2Rect(width, height));
+            if (*block) {
+                return C2_OK;
+            }
+        }
         std::shared_ptr<bufferpool2::BufferPoolData> bufferPoolData;
         native_handle_t *cHandle = nullptr;
         bufferpool2_impl::BufferPoolStatus status = mBufferPoolManager->allocate(
                 mConnectionId, params, &cHandle, &bufferPoolData);
         if (status == ResultStatus2::OK) {
             std::shared_ptr<C2GraphicAllocation> alloc;
-            std::shared_ptr<C2PooledBlockPoolData2> poolData =
-                std::make_shared<C2PooledBlockPoolData2>(bufferPoolData);
             c2_status_t err = mAllocator->priorGraphicAllocation(
                     cHandle, &alloc);
+            std::shared_ptr<C2PooledBlockPoolData2> poolData =
+                std::make_shared<C2PooledBlockPoolData2>(
+                        bufferPoolData, mCache->onRelease(params, nullptr, alloc));
             if (err == C2_OK && poolData && alloc) {
                 *block = _C2BlockFactory::CreateGraphicBlock(
                         alloc, poolData, C2Rect(width, height));
@@ -1137,6 +1324,7 @@ private:
     const std::shared_ptr<bufferpool2_impl::ClientManager> mBufferPoolManager;
     bufferpool2_impl::ConnectionId mConnectionId; // locally
     const std::shared_ptr<_C2BufferPoolAllocator2> mAllocator;
+    const std::shared_ptr<Cache> mCache;
 };
 
 C2PooledBlockPool::C2PooledBlockPool(
@@ -0,0 +1,82 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef IMG_UTILS_BUFFERED_OUTPUT_H
+#define IMG_UTILS_BUFFERED_OUTPUT_H
+
+#include <img_utils/Output.h>
+
+#include <cutils/compiler.h>
+#include <utils/Errors.h>
+
+#include <stdint.h>
+#include <vector>
+
+namespace android {
+namespace img_utils {
+
+/**
+ * Utility class that coalesces small writes into large writes to the wrapped
+ * Output.  Writes larger than the buffer are passed through directly.
+ */
+class ANDROID_API BufferedOutput : public Output {
+    public:
+        enum {
+            DEFAULT_BUFFER_SIZE = 1 << 20, // 1mb
+        };
+
+        /**
+         * Wrap the given Output.  Buffered bytes are only guaranteed to reach the
+         * wrapped Output after flush or close is called.
+         */
+        explicit BufferedOutput(Output* out, size_t bufferSize = DEFAULT_BUFFER_SIZE);
+
+        virtual ~BufferedOutput();
+
+        /**
+         * Call open on the wrapped output.
+         */
+        virtual status_t open();
+
+        /**
+         * Buffer count bytes from the given buffer starting at offset.
+         *
+         * Returns OK on success, or a negative error code.
+         */
+        virtual status_t write(const uint8_t* buf, size_t offset, size_t count);
+
+        /**
+         * Write any buffered bytes to the wrapped output.
+         *
+         * Returns OK on success, or a negative error code.
+         */
+        virtual status_t flush();
+
+        /**
+         * Flush and call close on the wrapped output.
+         */
+        virtual status_t close();
+
+    private:
+        Output* mOutput;
+        std::vector<uint8_t> mBuffer;
+        size_t mBufferSize;
+};
+
+} /*namespace img_utils*/
+} /*namespace android*/
+
+#endif /*IMG_UTILS_BUFFERED_OUTPUT_H*/
@@ -25,6 +25,8 @@
 #include <endian.h>
 #include <assert.h>
 
+#include <algorithm>
+
 namespace android {
 namespace img_utils {
 
@@ -131,34 +133,33 @@ class ANDROID_API EndianOutput : public Output {
 template<typename T>
 inline status_t EndianOutput::writeHelper(const T* buf, size_t offset, size_t count) {
     assert(offset <= count);
+    if (mEndian != BIG && mEndian != LITTLE) {
+        return BAD_VALUE;
+    }
+
+    // Convert in fixed size batches; the byte swapping loops can be vectorized
+    // and the wrapped output sees one write per batch instead of per element.
+    const size_t batchSize = 256;
+    T tmp[batchSize];
     status_t res = OK;
-    size_t size = sizeof(T);
-    switch(mEndian) {
-        case BIG: {
-            for (size_t i = offset; i < count; ++i) {
-                T tmp = convertToBigEndian<T>(buf[offset + i]);
-                if ((res = mOutput->write(reinterpret_cast<uint8_t*>(&tmp), 0, size))
-                        != OK) {
-                    return res;
-                }
-                mOffset += size;
+    for (size_t i = offset; i < count;) {
+        size_t n = std::min(batchSize, count - i);
+        const T* src = buf + offset + i;
+        if (mEndian == BIG) {
+            for (size_t j = 0; j < n; ++j) {
+                tmp[j] = convertToBigEndian<T>(src[j]);
             }
-            break;
-        }
-        case LITTLE: {
-            for (size_t i = offset; i < count; ++i) {
-                T tmp = convertToLittleEndian<T>(buf[offset + i]);
-                if ((res = mOutput->write(reinterpret_cast<uint8_t*>(&tmp), 0, size))
-                        != OK) {
-                    return res;
-                }
-                mOffset += size;
+        } else {
+            for (size_t j = 0; j < n; ++j) {
+                tmp[j] = convertToLittleEndian<T>(src[j]);
             }
-            break;
         }
-        default: {
-            return BAD_VALUE;
+        size_t size = n * sizeof(T);
+        if ((res = mOutput->write(reinterpret_cast<uint8_t*>(tmp), 0, size)) != OK) {
+            return res;
         }
+        mOffset += size;
+        i += n;
     }
     return res;
 }
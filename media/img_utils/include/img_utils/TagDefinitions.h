@@ -204,6 +204,11 @@ enum {
     TAG_ORIENTATION_UNKNOWN = 9
 };
 
+enum {
+    TAG_COMPRESSION_NONE = 1,
+    TAG_COMPRESSION_DEFLATE = 8
+};
+
 /**
  * TIFF_EP_TAG_DEFINITIONS contains tags defined in the TIFF EP spec
  */
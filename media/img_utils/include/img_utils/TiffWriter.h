@@ -31,6 +31,7 @@
 
 #include <cutils/compiler.h>
 #include <stdint.h>
+#include <vector>
 
 namespace android {
 namespace img_utils {
@@ -175,6 +176,19 @@ class ANDROID_API TiffWriter : public LightRefBase<TiffWriter> {
          */
         virtual status_t addStrip(uint32_t ifd);
 
+        /**
+         * Losslessly compress the strips of the given IFD with Deflate.
+         *
+         * This only applies when writing with StripSources; call it after
+         * addStrip.  On write, the strip data is read from the source for the
+         * IFD and the strips are compressed in parallel on up to maxThreads
+         * threads (0 picks the number of available cores).  The StripByteCounts
+         * and Compression tags are updated before the header is written.
+         *
+         * Returns OK on success, or a negative error code.
+         */
+        virtual status_t setStripCompression(uint32_t ifd, uint32_t maxThreads = 0);
+
         /**
          * Return the TIFF entry with the given tag ID in the IFD with the given ID,
          * or an empty pointer if none exists.
@@ -260,11 +274,21 @@ class ANDROID_API TiffWriter : public LightRefBase<TiffWriter> {
         const TagDefinition_t* lookupDefinition(uint16_t tag) const;
         status_t calculateOffsets();
 
+        /**
+         * Read the strips of the given IFD from the source and compress them,
+         * updating the strip tags of the IFD to match the compressed strips.
+         */
+        status_t compressStrips(uint32_t ifd, StripSource* source, uint32_t maxThreads,
+                /*out*/std::vector<std::vector<uint8_t>>* strips);
+
         sp<TiffIfd> mIfd;
         KeyedVector<uint32_t, sp<TiffIfd> > mNamedIfds;
         KeyedVector<uint16_t, const TagDefinition_t*>* mTagMaps;
         size_t mNumTagMaps;
 
+        // IFDs with compressed strips, mapped to the compression thread count
+        KeyedVector<uint32_t, uint32_t> mCompressedIfds;
+
         static KeyedVector<uint16_t, const TagDefinition_t*> sTagMaps[];
 };
 
@@ -0,0 +1,74 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <img_utils/BufferedOutput.h>
+
+#include <utils/Log.h>
+
+namespace android {
+namespace img_utils {
+
+BufferedOutput::BufferedOutput(Output* out, size_t bufferSize)
+        : mOutput(out), mBufferSize(bufferSize) {
+    mBuffer.reserve(mBufferSize);
+}
+
+BufferedOutput::~BufferedOutput() {
+    if (!mBuffer.empty()) {
+        ALOGW("%s: Destructor called with %zu bytes not flushed.", __FUNCTION__,
+                mBuffer.size());
+    }
+}
+
+status_t BufferedOutput::open() {
+    mBuffer.clear();
+    return mOutput->open();
+}
+
+status_t BufferedOutput::write(const uint8_t* buf, size_t offset, size_t count) {
+    if (mBuffer.size() + count > mBufferSize) {
+        status_t res = flush();
+        if (res != OK) {
+            return res;
+        }
+        if (count >= mBufferSize) {
+            return mOutput->write(buf, offset, count);
+        }
+    }
+    mBuffer.insert(mBuffer.end(), buf + offset, buf + offset + count);
+    return OK;
+}
+
+status_t BufferedOutput::flush() {
+    if (mBuffer.empty()) {
+        return OK;
+    }
+    status_t res = mOutput->write(mBuffer.data(), 0, mBuffer.size());
+    if (res != OK) {
+        ALOGE("%s: Failed to write %zu buffered bytes.", __FUNCTION__, mBuffer.size());
+    }
+    mBuffer.clear();
+    return res;
+}
+
+status_t BufferedOutput::close() {
+    status_t res = flush();
+    status_t closeRes = mOutput->close();
+    return (res != OK) ? res : closeRes;
+}
+
+} /*namespace img_utils*/
+} /*namespace android*/
@@ -16,11 +16,19 @@
 
 #define LOG_TAG "TiffWriter"
 
+#include <img_utils/BufferedOutput.h>
+#include <img_utils/ByteArrayOutput.h>
 #include <img_utils/TiffHelpers.h>
 #include <img_utils/TiffWriter.h>
 #include <img_utils/TagDefinitions.h>
 
 #include <assert.h>
+#include <zlib.h>
+
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <thread>
 
 namespace android {
 namespace img_utils {
@@ -59,13 +67,37 @@ TiffWriter::~TiffWriter() {}
 status_t TiffWriter::write(Output* out, StripSource** sources, size_t sourcesCount,
         Endianness end) {
     status_t ret = OK;
-    EndianOutput endOut(out, end);
+    BufferedOutput bufOut(out);
+    EndianOutput endOut(&bufOut, end);
 
     if (mIfd == NULL) {
         ALOGE("%s: Tiff header is empty.", __FUNCTION__);
         return BAD_VALUE;
     }
 
+    // Compressed strip sizes are needed to lay out the file, so compress first.
+    std::map<uint32_t, std::vector<std::vector<uint8_t>>> compressedStrips;
+    for (size_t i = 0; i < mCompressedIfds.size(); ++i) {
+        uint32_t ifdKey = mCompressedIfds.keyAt(i);
+        ssize_t index = mNamedIfds.indexOfKey(ifdKey);
+        if (index < 0 || !mNamedIfds[index]->uninitializedOffsets()) {
+            continue;
+        }
+        StripSource* source = NULL;
+        for (size_t j = 0; j < sourcesCount; ++j) {
+            if (sources[j]->getIfd() == ifdKey) {
+                source = sources[j];
+                break;
+            }
+        }
+        if (source == NULL) {
+            ALOGE("%s: No stream for byte strips for IFD %u", __FUNCTION__, ifdKey);
+            return BAD_VALUE;
+        }
+        BAIL_ON_FAIL(compressStrips(ifdKey, source, mCompressedIfds.valueAt(i),
+                &compressedStrips[ifdKey]), ret);
+    }
+
     uint32_t totalSize = getTotalSize();
 
     KeyedVector<uint32_t, uint32_t> offsetVector;
@@ -106,11 +138,20 @@ status_t TiffWriter::write(Output* out, StripSource** sources, size_t sourcesCou
 
     for (size_t i = 0; i < offVecSize; ++i) {
         uint32_t ifdKey = offsetVector.keyAt(i);
-        uint32_t sizeToWrite = mNamedIfds[ifdKey]->getStripSize();
+        uint32_t sizeToWrite = mNamedIfds.valueFor(ifdKey)->getStripSize();
+        auto compressed = compressedStrips.find(ifdKey);
+        if (compressed != compressedStrips.end()) {
+            for (const auto& strip : compressed->second) {
+                BAIL_ON_FAIL(endOut.write(strip.data(), 0, strip.size()), ret);
+            }
+            ZERO_TILL_WORD(&endOut, sizeToWrite, ret);
+            assert(offsetVector[i] == endOut.getCurrentOffset());
+            continue;
+        }
         bool found = false;
         for (size_t j = 0; j < sourcesCount; ++j) {
             if (sources[j]->getIfd() == ifdKey) {
-                if ((ret = sources[i]->writeToStream(endOut, sizeToWrite)) != OK) {
+                if ((ret = sources[j]->writeToStream(endOut, sizeToWrite)) != OK) {
                     ALOGE("%s: Could not write to stream, received %d.", __FUNCTION__, ret);
                     return ret;
                 }
@@ -126,12 +167,13 @@ status_t TiffWriter::write(Output* out, StripSource** sources, size_t sourcesCou
         assert(offsetVector[i] == endOut.getCurrentOffset());
     }
 
-    return ret;
+    return bufOut.flush();
 }
 
 status_t TiffWriter::write(Output* out, Endianness end) {
     status_t ret = OK;
-    EndianOutput endOut(out, end);
+    BufferedOutput bufOut(out);
+    EndianOutput endOut(&bufOut, end);
 
     if (mIfd == NULL) {
         ALOGE("%s: Tiff header is empty.", __FUNCTION__);
@@ -146,7 +188,7 @@ status_t TiffWriter::write(Output* out, Endianness end) {
         offset += ifd->getSize();
         ifd = ifd->getNextIfd();
     }
-    return ret;
+    return bufOut.flush();
 }
 
 
@@ -214,6 +256,101 @@ status_t TiffWriter::addStrip(uint32_t ifd) {
     return selected->validateAndSetStripTags();
 }
 
+status_t TiffWriter::setStripCompression(uint32_t ifd, uint32_t maxThreads) {
+    ssize_t index = mNamedIfds.indexOfKey(ifd);
+    if (index < 0) {
+        ALOGE("%s: Ifd %u doesn't exist, cannot compress strips.", __FUNCTION__, ifd);
+        return BAD_VALUE;
+    }
+    if (!mNamedIfds[index]->uninitializedOffsets()) {
+        ALOGE("%s: Ifd %u has no strip entries, call addStrip first.", __FUNCTION__, ifd);
+        return BAD_VALUE;
+    }
+    mCompressedIfds.add(ifd, maxThreads);
+    return OK;
+}
+
+status_t TiffWriter::compressStrips(uint32_t ifd, StripSource* source, uint32_t maxThreads,
+        /*out*/std::vector<std::vector<uint8_t>>* strips) {
+    status_t ret = OK;
+    sp<TiffIfd> selected = mNamedIfds.valueFor(ifd);
+    sp<TiffEntry> byteCountsEntry = selected->getEntry(TAG_STRIPBYTECOUNTS);
+    if (byteCountsEntry == NULL) {
+        ALOGE("%s: IFD %u does not contain StripByteCounts entry.", __FUNCTION__, ifd);
+        return BAD_VALUE;
+    }
+    uint32_t stripCount = byteCountsEntry->getCount();
+    const uint32_t* rawByteCounts = byteCountsEntry->getData<uint32_t>();
+    std::vector<uint32_t> byteCounts(rawByteCounts, rawByteCounts + stripCount);
+    std::vector<size_t> stripOffsets(stripCount);
+    size_t rawSize = 0;
+    for (uint32_t i = 0; i < stripCount; ++i) {
+        stripOffsets[i] = rawSize;
+        rawSize += byteCounts[i];
+    }
+
+    ByteArrayOutput raw;
+    if ((ret = source->writeToStream(raw, rawSize)) != OK) {
+        ALOGE("%s: Could not read strips for IFD %u, received %d.", __FUNCTION__, ifd, ret);
+        return ret;
+    }
+    if (raw.getSize() != rawSize) {
+        ALOGE("%s: Source for IFD %u wrote %zu bytes, expected %zu.", __FUNCTION__, ifd,
+                raw.getSize(), rawSize);
+        return BAD_VALUE;
+    }
+    const uint8_t* rawData = raw.getArray();
+
+    // Strips are independent, hand them out to the workers one at a time.
+    strips->clear();
+    strips->resize(stripCount);
+    std::atomic<uint32_t> nextStrip(0);
+    std::atomic<bool> failed(false);
+    auto compressWorker = [&]() {
+        for (uint32_t i = nextStrip++; i < stripCount && !failed; i = nextStrip++) {
+            std::vector<uint8_t>& strip = (*strips)[i];
+            uLongf size = compressBound(byteCounts[i]);
+            strip.resize(size);
+            if (compress2(strip.data(), &size, rawData + stripOffsets[i], byteCounts[i],
+                    Z_DEFAULT_COMPRESSION) != Z_OK) {
+                failed = true;
+                return;
+            }
+            strip.resize(size);
+        }
+    };
+
+    if (maxThreads == 0) {
+        maxThreads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    uint32_t threadCount = std::min(maxThreads, std::max(1u, stripCount));
+    std::vector<std::thread> workers;
+    for (uint32_t i = 1; i < threadCount; ++i) {
+        workers.emplace_back(compressWorker);
+    }
+    compressWorker();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    if (failed) {
+        ALOGE("%s: Failed to compress strips for IFD %u.", __FUNCTION__, ifd);
+        return BAD_VALUE;
+    }
+
+    for (uint32_t i = 0; i < stripCount; ++i) {
+        byteCounts[i] = (*strips)[i].size();
+    }
+    sp<TiffEntry> newByteCounts = uncheckedBuildEntry(TAG_STRIPBYTECOUNTS, LONG, stripCount,
+            UNDEFINED_ENDIAN, byteCounts.data());
+    if (newByteCounts == NULL || selected->addEntry(newByteCounts) != OK) {
+        ALOGE("%s: Failed to update StripByteCounts entry in IFD %u.", __FUNCTION__, ifd);
+        return BAD_VALUE;
+    }
+
+    uint16_t compression = TAG_COMPRESSION_DEFLATE;
+    return addEntry(TAG_COMPRESSION, 1, &compression, ifd);
+}
+
 status_t TiffWriter::addIfd(uint32_t ifd) {
     ssize_t index = mNamedIfds.indexOfKey(ifd);
     if (index >= 0) {
@@ -91,6 +91,54 @@ AAUDIO_API aaudio_policy_t AAudio_getMMapPolicy();
  */
 AAUDIO_API bool AAudioStream_isMMapUsed(AAudioStream* stream);
 
+enum {
+    /**
+     * Time the data thread woke up after the time it asked for.
+     */
+    AAUDIO_WAKEUP_HISTOGRAM_SCHEDULING_LATENCY = 0,
+
+    /**
+     * Time the DSP reached a timestamp position after the earliest time predicted for it.
+     */
+    AAUDIO_WAKEUP_HISTOGRAM_TIMESTAMP_LATENESS,
+};
+typedef int32_t aaudio_wakeup_histogram_t;
+
+enum {
+    AAUDIO_WAKEUP_HISTOGRAM_BIN_WIDTH_MICROS = 50,
+    /**
+     * The last bin counts all values beyond the range of the other bins.
+     */
+    AAUDIO_WAKEUP_HISTOGRAM_BIN_COUNT = 64,
+};
+
+/**
+ * Copy a histogram of the wakeup timing of an MMAP stream since it was opened.
+ * Bin i counts the values from i to (i + 1) * AAUDIO_WAKEUP_HISTOGRAM_BIN_WIDTH_MICROS.
+ * Negative values are counted in bin 0.
+ * @note This is only for testing. Do not use this in an application.
+ * It may change or be removed at any time.
+ * @param histogram AAUDIO_WAKEUP_HISTOGRAM_SCHEDULING_LATENCY or
+ *        AAUDIO_WAKEUP_HISTOGRAM_TIMESTAMP_LATENESS
+ * @param counts array that receives the bin counts
+ * @param numCounts size of the array, up to AAUDIO_WAKEUP_HISTOGRAM_BIN_COUNT bins are copied
+ * @return number of bins copied, or AAUDIO_ERROR_UNIMPLEMENTED if the stream does not
+ *         use the MMAP data path, or another negative error
+ */
+AAUDIO_API int32_t AAudioStream_getWakeupHistogram(AAudioStream* stream,
+        aaudio_wakeup_histogram_t histogram, int32_t* counts, int32_t numCounts);
+
+/**
+ * Return the margin that the data thread of an MMAP stream currently adds to its
+ * predicted wakeup time. It adapts to the measured timing when the aaudio.wakeup_tuning
+ * property is set.
+ * @note This is only for testing. Do not use this in an application.
+ * It may change or be removed at any time.
+ * @return margin in microseconds, or AAUDIO_ERROR_UNIMPLEMENTED if the stream does not
+ *         use the MMAP data path
+ */
+AAUDIO_API int32_t AAudioStream_getWakeupMarginMicros(AAudioStream* stream);
+
 #ifdef __cplusplus
 }
 #endif
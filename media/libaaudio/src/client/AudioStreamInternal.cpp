@@ -315,7 +315,18 @@ aaudio_result_t AudioStreamInternal::configureDataInformation(int32_t callbackFr
         mTimeOffsetNanos = offsetMicros * AAUDIO_NANOS_PER_MICROSECOND;
     }
 
-    setBufferSize(mBufferCapacityInFrames / 2); // Default buffer size to match Q
+    applyBufferSize(mBufferCapacityInFrames / 2); // Default buffer size to match Q
+    if (!mInService && getDirection() == AAUDIO_DIRECTION_OUTPUT
+            && AAudioProperty_isBufferTuningEnabled()) {
+        setBufferSizeTuningEnabled(true);
+    }
+
+    // A free running FIFO has no software on the other end, so it needs no margin by default.
+    mWakeupController.configure(
+            (int64_t) getFramesPerBurst() * AAUDIO_NANOS_PER_SECOND / getSampleRate(),
+            mAudioEndpoint->isFreeRunning() ? 0 : mWakeupDelayNanos);
+    mWakeupController.setAdaptive(AAudioProperty_isWakeupTuningEnabled());
+    mNeedWakeupControllerReset.request();
     return AAUDIO_OK;
 }
 
@@ -415,7 +426,7 @@ aaudio_result_t AudioStreamInternal::exitStandby_l() {
               "frames to write: %d", framesWritten, fullFramesAvailable);
     }
     // Reset previous buffer size as it may be requested by the client.
-    setBufferSize(previousBufferSize);
+    applyBufferSize(previousBufferSize);
 
 exit:
     return result;
@@ -474,6 +485,8 @@ aaudio_result_t AudioStreamInternal::requestStart_l()
     startTime = AudioClock::getNanoseconds();
     mClockModel.start(startTime);
     mNeedCatchUp.request();  // Ask data processing code to catch up when first timestamp received.
+    mNeedBufferSizeTunerReset.request();
+    mNeedWakeupControllerReset.request();
 
     // Start data callback thread.
     if (result == AAUDIO_OK && isDataCallbackSet()) {
@@ -547,6 +560,9 @@ aaudio_result_t AudioStreamInternal::requestStop_l() {
     }
 
     mClockModel.stop(AudioClock::getNanoseconds());
+    ALOGD("%s() %d wakeups, %d without data, wakeup margin %d micros", __func__,
+          mWakeupController.getWakeupCount(), mWakeupController.getEmptyWakeupCount(),
+          getWakeupMarginMicros());
     setState(AAUDIO_STREAM_STATE_STOPPING);
     mAtomicInternalTimestamp.clear();
 
@@ -802,6 +818,12 @@ aaudio_result_t AudioStreamInternal::processData(void *buffer, int32_t numFrames
     const int64_t entryTimeNanos = currentTimeNanos;
     const int64_t deadlineNanos = currentTimeNanos + timeoutNanoseconds;
     int32_t framesLeft = numFrames;
+    int64_t sleptUntilNanos = 0; // requested wakeup time, if we slept
+
+    if (mNeedWakeupControllerReset.isRequested()) {
+        mWakeupController.reset(getXRunCount(), currentTimeNanos);
+        mNeedWakeupControllerReset.acknowledge();
+    }
 
     // Loop until all the data has been processed or until a timeout occurs.
     while (framesLeft > 0) {
@@ -813,6 +835,11 @@ aaudio_result_t AudioStreamInternal::processData(void *buffer, int32_t numFrames
             result = framesProcessed;
             break;
         }
+        if (sleptUntilNanos != 0) {
+            mWakeupController.onWakeup(sleptUntilNanos, currentTimeNanos, framesProcessed,
+                                       getXRunCount());
+            sleptUntilNanos = 0;
+        }
         framesLeft -= (int32_t) framesProcessed;
         audioData += framesProcessed * getBytesPerFrame();
 
@@ -820,11 +847,9 @@ aaudio_result_t AudioStreamInternal::processData(void *buffer, int32_t numFrames
         if (timeoutNanoseconds == 0) {
             break; // don't block
         } else if (wakeTimeNanos != 0) {
-            if (!mAudioEndpoint->isFreeRunning()) {
-                // If there is software on the other end of the FIFO then it may get delayed.
-                // So wake up just a little after we expect it to be ready.
-                wakeTimeNanos += mWakeupDelayNanos;
-            }
+            // The other end of the FIFO, software or DSP, may be later than predicted.
+            // So wake up just a little after we expect it to be ready.
+            wakeTimeNanos += mWakeupController.getMarginNanos();
 
             currentTimeNanos = AudioClock::getNanoseconds();
             int64_t earliestWakeTime = currentTimeNanos + mMinimumSleepNanos;
@@ -857,6 +882,7 @@ aaudio_result_t AudioStreamInternal::processData(void *buffer, int32_t numFrames
 
             AudioClock::sleepUntilNanoTime(wakeTimeNanos);
             currentTimeNanos = AudioClock::getNanoseconds();
+            sleptUntilNanos = wakeTimeNanos;
         }
     }
 
@@ -872,10 +898,24 @@ aaudio_result_t AudioStreamInternal::processData(void *buffer, int32_t numFrames
 }
 
 void AudioStreamInternal::processTimestamp(uint64_t position, int64_t time) {
+    if (mClockModel.isRunning()) {
+        // How much later than predicted the DSP reached this position.
+        mWakeupController.onTimestamp(time - mClockModel.convertPositionToTime(position));
+    }
     mClockModel.processTimestamp(position, time);
 }
 
 aaudio_result_t AudioStreamInternal::setBufferSize(int32_t requestedFrames) {
+    const aaudio_result_t result = applyBufferSize(requestedFrames);
+    if (result > 0) {
+        // The application size is the lower limit for tuning.
+        mBufferSizeFloorFrames = result;
+        mNeedBufferSizeTunerReset.request();
+    }
+    return result;
+}
+
+aaudio_result_t AudioStreamInternal::applyBufferSize(int32_t requestedFrames) {
     int32_t adjustedFrames = requestedFrames;
     const int32_t maximumSize = getBufferCapacity() - getFramesPerBurst();
     // Minimum size should be a multiple number of bursts.
@@ -922,6 +962,25 @@ int32_t AudioStreamInternal::getBufferSize() const {
     return mBufferSizeInFrames;
 }
 
+void AudioStreamInternal::tuneBufferSize(int64_t nanoTime) {
+    if (mNeedBufferSizeTunerReset.isRequested()) {
+        mBufferSizeTuner.configure(getFramesPerBurst(),
+                                   mBufferSizeFloorFrames.load(),
+                                   getBufferCapacity() - getFramesPerBurst());
+        mBufferSizeTuner.reset(getBufferSize(), getXRunCount(), nanoTime);
+        mClockModel.resetRecentMaxLateness();
+        mNeedBufferSizeTunerReset.acknowledge();
+        return;
+    }
+    const int64_t latenessFrames = mClockModel.convertDeltaTimeToPosition(
+            mClockModel.getRecentMaxLatenessNanos());
+    mClockModel.resetRecentMaxLateness();
+    const int32_t bufferSize = mBufferSizeTuner.update(nanoTime, getXRunCount(), latenessFrames);
+    if (bufferSize != getBufferSize()) {
+        applyBufferSize(bufferSize);
+    }
+}
+
 int32_t AudioStreamInternal::getBufferCapacity() const {
     return mBufferCapacityInFrames;
 }
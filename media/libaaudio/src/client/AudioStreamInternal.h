@@ -18,11 +18,14 @@
 #define ANDROID_AAUDIO_AUDIO_STREAM_INTERNAL_H
 
 #include <stdint.h>
+#include <atomic>
 #include <aaudio/AAudio.h>
 
 #include "binding/AudioEndpointParcelable.h"
 #include "binding/AAudioServiceInterface.h"
+#include "client/BufferSizeTuner.h"
 #include "client/IsochronousClockModel.h"
+#include "client/WakeupController.h"
 #include "client/AudioEndpoint.h"
 #include "core/AudioStream.h"
 #include "utility/AudioClock.h"
@@ -58,10 +61,29 @@ public:
 
     int32_t getBufferCapacity() const override;
 
+    /**
+     * Enable runtime tuning of the buffer size based on underruns and timing jitter.
+     * The last size passed to setBufferSize() becomes the lower limit.
+     * This is enabled for output streams by AAUDIO_PROP_BUFFER_TUNING.
+     */
+    void setBufferSizeTuningEnabled(bool enabled) {
+        mBufferSizeTuningEnabled = enabled;
+        mNeedBufferSizeTunerReset.request();
+    }
+
     int32_t getXRunCount() const override {
         return mXRunCount;
     }
 
+    int32_t getWakeupHistogram(int32_t which, int32_t *counts,
+                               int32_t numCounts) const override {
+        return mWakeupController.getHistogram(which, counts, numCounts);
+    }
+
+    int32_t getWakeupMarginMicros() const override {
+        return (int32_t) (mWakeupController.getMarginNanos() / AAUDIO_NANOS_PER_MICROSECOND);
+    }
+
     aaudio_result_t registerThread() override;
 
     aaudio_result_t unregisterThread() override;
@@ -148,6 +170,14 @@ protected:
      */
     bool isClockModelInControl() const;
 
+    /**
+     * Adjust the buffer size from the recent underruns and timing of the clock model.
+     * Called from the thread that writes the data, while the stream is running.
+     */
+    void tuneBufferSize(int64_t nanoTime);
+
+    bool isBufferSizeTuningEnabled() const { return mBufferSizeTuningEnabled; }
+
     IsochronousClockModel    mClockModel;      // timing model for chasing the HAL
 
     std::unique_ptr<AudioEndpoint> mAudioEndpoint;   // source for reads or sink for writes
@@ -193,11 +223,19 @@ private:
     // Adjust timing model based on timestamp from service.
     void processTimestamp(uint64_t position, int64_t time);
 
+    // Set mBufferSizeInFrames without changing the lower limit of the tuner.
+    aaudio_result_t applyBufferSize(int32_t requestedFrames);
+
     aaudio_result_t configureDataInformation(int32_t callbackFrames);
 
     // Thread on other side of FIFO will have wakeup jitter.
     // By delaying slightly we can avoid waking up before other side is ready.
     const int32_t            mWakeupDelayNanos; // delay past typical wakeup jitter
+    // Margin added to the wakeup time, only used by the thread that processes the data.
+    // Starts from mWakeupDelayNanos, or 0 if free running, and adapts if
+    // AAUDIO_PROP_WAKEUP_TUNING is set.
+    WakeupController         mWakeupController;
+    AtomicRequestor          mNeedWakeupControllerReset; // stream started
     const int32_t            mMinimumSleepNanos; // minimum sleep while polling
     int32_t                  mTimeOffsetNanos = 0; // add to time part of an MMAP timestamp
 
@@ -210,9 +248,15 @@ private:
     // Then we require conversion in AAudio.
     int32_t                  mDeviceChannelCount = 0;
 
-    int32_t                  mBufferSizeInFrames = 0; // local threshold to control latency
+    std::atomic<int32_t>     mBufferSizeInFrames{0}; // local threshold to control latency
     int32_t                  mBufferCapacityInFrames = 0;
 
+    // Buffer size tuning, only used by the thread that writes the data.
+    BufferSizeTuner          mBufferSizeTuner;
+    std::atomic<bool>        mBufferSizeTuningEnabled{false};
+    std::atomic<int32_t>     mBufferSizeFloorFrames{0}; // last application size, or 0
+    AtomicRequestor          mNeedBufferSizeTunerReset; // limits or size changed
+
 
 };
 
@@ -174,6 +174,11 @@ aaudio_result_t AudioStreamInternalPlay::processDataNow(void *buffer, int32_t nu
         }
     }
 
+    if (isBufferSizeTuningEnabled() && mClockModel.isRunning()
+            && getState() == AAUDIO_STREAM_STATE_STARTED) {
+        tuneBufferSize(currentNanoTime);
+    }
+
     // Write some data to the buffer.
     //ALOGD("AudioStreamInternal::processDataNow() - writeNowWithConversion(%d)", numFrames);
     int32_t framesWritten = writeNowWithConversion(buffer, numFrames);
@@ -0,0 +1,82 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "BufferSizeTuner"
+//#define LOG_NDEBUG 0
+#include <log/log.h>
+
+#include <algorithm>
+
+#include "BufferSizeTuner.h"
+
+using namespace aaudio;
+
+void BufferSizeTuner::configure(int32_t framesPerBurst,
+                                int32_t minimumFrames,
+                                int32_t maximumFrames) {
+    mFramesPerBurst = std::max(1, framesPerBurst);
+    // Keep the limits on burst boundaries, with at least one burst.
+    mMaximumFrames = std::max(mFramesPerBurst,
+                              maximumFrames / mFramesPerBurst * mFramesPerBurst);
+    const int32_t minimumBursts = (minimumFrames + mFramesPerBurst - 1) / mFramesPerBurst;
+    mMinimumFrames = std::clamp(minimumBursts * mFramesPerBurst, mFramesPerBurst,
+                                mMaximumFrames);
+    mBufferSizeFrames = clip(mBufferSizeFrames);
+}
+
+void BufferSizeTuner::reset(int32_t bufferSizeFrames, int32_t xRunCount, int64_t nanoTime) {
+    mBufferSizeFrames = clip(bufferSizeFrames);
+    mXRunCount = xRunCount;
+    mLastGrowNanos = nanoTime - kGrowIntervalNanos; // the first underrun may grow immediately
+    mQuietStartNanos = nanoTime;
+    mMaxLatenessFrames = 0;
+}
+
+int32_t BufferSizeTuner::update(int64_t nanoTime, int32_t xRunCount, int64_t latenessFrames) {
+    mMaxLatenessFrames = std::max(mMaxLatenessFrames, latenessFrames);
+
+    if (xRunCount != mXRunCount) {
+        mXRunCount = xRunCount;
+        if (nanoTime - mLastGrowNanos >= kGrowIntervalNanos
+                && mBufferSizeFrames < mMaximumFrames) {
+            mBufferSizeFrames = clip(mBufferSizeFrames + mFramesPerBurst);
+            mLastGrowNanos = nanoTime;
+            ALOGD("%s() underrun, buffer size grows to %d", __func__, mBufferSizeFrames);
+        }
+        mQuietStartNanos = nanoTime;
+        mMaxLatenessFrames = 0;
+    } else if (nanoTime - mQuietStartNanos >= kQuietNanosBeforeShrink) {
+        // Keep one burst plus the worst lateness of the quiet period.
+        const int32_t smaller = mBufferSizeFrames - mFramesPerBurst;
+        if (smaller >= mMinimumFrames
+                && smaller >= mFramesPerBurst + mMaxLatenessFrames) {
+            mBufferSizeFrames = smaller;
+            ALOGD("%s() quiet, max lateness %lld frames, buffer size shrinks to %d",
+                  __func__, (long long) mMaxLatenessFrames, mBufferSizeFrames);
+        }
+        mQuietStartNanos = nanoTime;
+        mMaxLatenessFrames = 0;
+    }
+    return mBufferSizeFrames;
+}
+
+int32_t BufferSizeTuner::clip(int32_t frames) const {
+    if (mFramesPerBurst <= 0) {
+        return frames;
+    }
+    const int32_t bursts = (frames + mFramesPerBurst - 1) / mFramesPerBurst;
+    return std::clamp(bursts * mFramesPerBurst, mMinimumFrames, mMaximumFrames);
+}
@@ -0,0 +1,87 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_AAUDIO_BUFFER_SIZE_TUNER_H
+#define ANDROID_AAUDIO_BUFFER_SIZE_TUNER_H
+
+#include <stdint.h>
+
+#include "utility/AudioClock.h"
+
+namespace aaudio {
+
+/**
+ * Feedback controller for the effective buffer size of an output stream.
+ *
+ * The buffer grows by one burst when the underrun count increases, and shrinks by one
+ * burst after a quiet period if the measured timing lateness leaves enough headroom.
+ * The size always stays between the configured minimum and maximum, and is a multiple
+ * of the burst size.
+ *
+ * This class is not thread safe and should only be called from one thread.
+ */
+class BufferSizeTuner {
+public:
+    /**
+     * @param framesPerBurst size of one burst in frames, must be > 0
+     * @param minimumFrames lower limit for the buffer size
+     * @param maximumFrames upper limit for the buffer size
+     */
+    void configure(int32_t framesPerBurst, int32_t minimumFrames, int32_t maximumFrames);
+
+    /**
+     * Restart tuning from the given buffer size, e.g. after a start or after
+     * the application sets the buffer size.
+     */
+    void reset(int32_t bufferSizeFrames, int32_t xRunCount, int64_t nanoTime);
+
+    /**
+     * @param nanoTime current time
+     * @param xRunCount cumulative underrun count of the stream
+     * @param latenessFrames recent maximum lateness of the hardware position, in frames,
+     *                       measured since the last call
+     * @return the buffer size to use, which may be unchanged
+     */
+    int32_t update(int64_t nanoTime, int32_t xRunCount, int64_t latenessFrames);
+
+    int32_t getBufferSize() const { return mBufferSizeFrames; }
+
+    int32_t getMinimumSize() const { return mMinimumFrames; }
+
+    int32_t getMaximumSize() const { return mMaximumFrames; }
+
+private:
+    int32_t clip(int32_t frames) const;
+
+    // Time without underruns before the buffer may shrink.
+    static constexpr int64_t kQuietNanosBeforeShrink = 5 * AAUDIO_NANOS_PER_SECOND;
+    // Underruns often arrive in clusters; grow at most once during this interval.
+    static constexpr int64_t kGrowIntervalNanos      = 100 * AAUDIO_NANOS_PER_MILLISECOND;
+
+    int32_t mFramesPerBurst = 0;
+    int32_t mMinimumFrames = 0;
+    int32_t mMaximumFrames = 0;
+
+    int32_t mBufferSizeFrames = 0;
+    int32_t mXRunCount = 0;              // underrun count at the last update
+    int64_t mLastGrowNanos = 0;          // time the buffer last grew
+    int64_t mQuietStartNanos = 0;        // time of the last underrun or shrink evaluation
+    int64_t mMaxLatenessFrames = 0;      // since mQuietStartNanos
+};
+
+} /* namespace aaudio */
+
+#endif //ANDROID_AAUDIO_BUFFER_SIZE_TUNER_H
@@ -197,6 +197,7 @@ void IsochronousClockModel::processTimestamp(int64_t framePosition, int64_t nano
 #endif
             mMaxMeasuredLatenessNanos = (int32_t) latenessNanos;
         }
+        mRecentMaxLatenessNanos = std::max(mRecentMaxLatenessNanos, latenessNanos);
 
         break;
     default:
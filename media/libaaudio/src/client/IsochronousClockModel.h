@@ -123,6 +123,19 @@ public:
      */
     int64_t convertDeltaTimeToPosition(int64_t nanosDelta) const;
 
+    /**
+     * @return the maximum lateness of a timestamp, relative to the start of the expected
+     *         window, since the last call to resetRecentMaxLateness(), or 0 if none was late.
+     *         This includes the normal wakeup variation of up to one burst period.
+     */
+    int64_t getRecentMaxLatenessNanos() const {
+        return mRecentMaxLatenessNanos;
+    }
+
+    void resetRecentMaxLateness() {
+        mRecentMaxLatenessNanos = 0;
+    }
+
     void dump() const;
 
     void dumpHistogram() const;
@@ -166,6 +179,8 @@ private:
     int64_t             mBurstPeriodNanos{0};    // Time between HW bursts.
     // Includes mBurstPeriodNanos because we sample randomly over time.
     int64_t             mMaxMeasuredLatenessNanos{0};
+    // Like mMaxMeasuredLatenessNanos but can be reset, for tuning.
+    int64_t             mRecentMaxLatenessNanos{0};
     // Threshold for lateness that triggers a drift later in time.
     int64_t             mLatenessForDriftNanos{0}; // Set in update()
     // Based on the observed lateness when the DSP is paused for playing a touch sound.
@@ -0,0 +1,130 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "WakeupController"
+//#define LOG_NDEBUG 0
+#include <log/log.h>
+
+#include <stdlib.h>
+#include <algorithm>
+
+#include <aaudio/AAudio.h>
+
+#include "WakeupController.h"
+
+using namespace aaudio;
+
+void WakeupController::configure(int64_t burstNanos, int64_t initialMarginNanos) {
+    mBurstNanos = std::max<int64_t>(1, burstNanos);
+    mInitialMarginNanos = std::max<int64_t>(0, initialMarginNanos);
+    mLimitNanos = mBurstNanos / 2;
+    update();
+}
+
+void WakeupController::reset(int32_t xRunCount, int64_t nanoTime) {
+    mLatenessMeanNanos = 0;
+    mLatenessDevNanos = 0;
+    mSchedulingMeanNanos = 0;
+    mSchedulingDevNanos = 0;
+    mBiasNanos = 0;
+    mLimitNanos = mBurstNanos / 2;
+    mTimestampCount = 0;
+    mXRunCount = xRunCount;
+    mQuietStartNanos = nanoTime;
+    update();
+}
+
+void WakeupController::onTimestamp(int64_t latenessNanos) {
+    mHistograms[HISTOGRAM_TIMESTAMP_LATENESS].add(latenessNanos);
+    const int64_t delta = latenessNanos - mLatenessMeanNanos;
+    mLatenessMeanNanos += delta / (1 << kShifterForMean);
+    mLatenessDevNanos += (llabs(delta) - mLatenessDevNanos) / (1 << kShifterForMean);
+    if (mTimestampCount < kTimestampsBeforeAdapting) {
+        mTimestampCount++;
+    }
+    update();
+}
+
+void WakeupController::onWakeup(int64_t requestedNanos, int64_t actualNanos,
+                                int32_t framesProcessed, int32_t xRunCount) {
+    const int64_t latencyNanos = std::max<int64_t>(0, actualNanos - requestedNanos);
+    mHistograms[HISTOGRAM_SCHEDULING_LATENCY].add(latencyNanos);
+    const int64_t delta = latencyNanos - mSchedulingMeanNanos;
+    mSchedulingMeanNanos += delta / (1 << kShifterForMean);
+    mSchedulingDevNanos += (llabs(delta) - mSchedulingDevNanos) / (1 << kShifterForMean);
+
+    mWakeupCount.fetch_add(1, std::memory_order_relaxed);
+    if (framesProcessed == 0) {
+        // Woke up before the DSP, so wake up a little later next time.
+        mEmptyWakeupCount.fetch_add(1, std::memory_order_relaxed);
+        mBiasNanos = std::min(mBiasNanos + kEmptyWakeupBiasNanos, mBurstNanos / 2);
+    } else {
+        mBiasNanos = std::max<int64_t>(0,
+                mBiasNanos - (kEmptyWakeupBiasNanos >> kBiasDecayShift));
+    }
+
+    if (xRunCount != mXRunCount) {
+        mXRunCount = xRunCount;
+        mLimitNanos /= 2;
+        mBiasNanos = 0;
+        mQuietStartNanos = actualNanos;
+        ALOGD("%s() xrun, margin limited to %d micros", __func__,
+              (int) (mLimitNanos / AAUDIO_NANOS_PER_MICROSECOND));
+    } else if (actualNanos - mQuietStartNanos >= kQuietNanosBeforeRelax) {
+        mLimitNanos = std::min(std::max<int64_t>(2 * mLimitNanos,
+                                                 kEmptyWakeupBiasNanos),
+                               mBurstNanos / 2);
+        mQuietStartNanos = actualNanos;
+    }
+    update();
+}
+
+void WakeupController::update() {
+    int64_t marginNanos = mInitialMarginNanos;
+    if (mAdaptive) {
+        // A late wakeup must still leave half a burst.
+        const int64_t limitNanos = std::max<int64_t>(0, std::min(mLimitNanos,
+                mBurstNanos / 2 - (mSchedulingMeanNanos + 2 * mSchedulingDevNanos)));
+        if (mTimestampCount >= kTimestampsBeforeAdapting) {
+            marginNanos = mLatenessMeanNanos + 2 * mLatenessDevNanos
+                    - mSchedulingMeanNanos + mBiasNanos;
+        }
+        marginNanos = std::clamp<int64_t>(marginNanos, 0, limitNanos);
+    }
+    mMarginNanos.store(marginNanos, std::memory_order_relaxed);
+}
+
+int32_t WakeupController::getHistogram(int32_t which, int32_t *counts,
+                                       int32_t numCounts) const {
+    if (which < 0 || which >= HISTOGRAM_COUNT || counts == nullptr || numCounts < 0) {
+        return AAUDIO_ERROR_ILLEGAL_ARGUMENT;
+    }
+    return mHistograms[which].copy(counts, numCounts);
+}
+
+void WakeupController::Histogram::add(int64_t nanos) {
+    const int64_t bin = nanos / (kHistogramBinWidthMicros * AAUDIO_NANOS_PER_MICROSECOND);
+    mCounts[std::clamp<int64_t>(bin, 0, kHistogramBinCount - 1)]
+            .fetch_add(1, std::memory_order_relaxed);
+}
+
+int32_t WakeupController::Histogram::copy(int32_t *counts, int32_t numCounts) const {
+    const int32_t numBins = std::min(numCounts, kHistogramBinCount);
+    for (int32_t i = 0; i < numBins; i++) {
+        counts[i] = mCounts[i].load(std::memory_order_relaxed);
+    }
+    return numBins;
+}
@@ -0,0 +1,156 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_AAUDIO_WAKEUP_CONTROLLER_H
+#define ANDROID_AAUDIO_WAKEUP_CONTROLLER_H
+
+#include <stdint.h>
+#include <array>
+#include <atomic>
+
+#include "utility/AudioClock.h"
+
+namespace aaudio {
+
+/**
+ * Controller for the margin that the data thread adds to its predicted wakeup time.
+ *
+ * The wakeup time predicted by the clock model is the earliest time the DSP can be at a
+ * position. Timestamps usually arrive later than that, so waking up at the prediction
+ * often finds no room or no data, which costs a CPU-only wakeup. The thread also wakes
+ * up later than requested because of scheduling latency, which already covers part of
+ * the DSP lateness.
+ *
+ * The margin is the recent DSP lateness (mean plus two mean deviations) minus the mean
+ * scheduling latency, plus a bias that grows with CPU-only wakeups. It is limited so that
+ * a late wakeup still leaves half a burst. An underrun halves that limit, which recovers
+ * after a quiet period.
+ *
+ * Histograms of the scheduling latency and the DSP lateness are kept for each stream.
+ *
+ * This class is not thread safe and should only be called from one thread,
+ * except for getHistogram() and getMarginNanos().
+ */
+class WakeupController {
+public:
+    enum histogram_t {
+        HISTOGRAM_SCHEDULING_LATENCY = 0,
+        HISTOGRAM_TIMESTAMP_LATENESS,
+        HISTOGRAM_COUNT
+    };
+
+    static constexpr int32_t kHistogramBinWidthMicros = 50;
+    // The last bin counts everything beyond the range of the other bins.
+    static constexpr int32_t kHistogramBinCount       = 64;
+
+    /**
+     * @param burstNanos duration of one burst, must be > 0
+     * @param initialMarginNanos margin to use until the timing has been measured
+     */
+    void configure(int64_t burstNanos, int64_t initialMarginNanos);
+
+    /**
+     * Restart the estimates, e.g. when the stream starts.
+     * The histograms are kept for the life of the stream.
+     */
+    void reset(int32_t xRunCount, int64_t nanoTime);
+
+    /**
+     * @param latenessNanos time of a timestamp minus the earliest time predicted for its
+     *                      position by the clock model
+     */
+    void onTimestamp(int64_t latenessNanos);
+
+    /**
+     * Call after the data thread slept and then processed data, or tried to.
+     *
+     * @param requestedNanos wakeup time passed to the sleep
+     * @param actualNanos time the thread woke up
+     * @param framesProcessed frames read or written after waking up
+     * @param xRunCount cumulative xrun count of the stream
+     */
+    void onWakeup(int64_t requestedNanos, int64_t actualNanos, int32_t framesProcessed,
+                  int32_t xRunCount);
+
+    /**
+     * @param enabled if false then the initial margin is always used,
+     *                but the timing is still measured
+     */
+    void setAdaptive(bool enabled) { mAdaptive = enabled; }
+
+    int64_t getMarginNanos() const { return mMarginNanos.load(std::memory_order_relaxed); }
+
+    int32_t getWakeupCount() const { return mWakeupCount.load(std::memory_order_relaxed); }
+
+    int32_t getEmptyWakeupCount() const {
+        return mEmptyWakeupCount.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Copy a histogram. Bin i counts values from i to i + 1 times
+     * kHistogramBinWidthMicros, negative values are counted in bin 0.
+     *
+     * @param which HISTOGRAM_SCHEDULING_LATENCY or HISTOGRAM_TIMESTAMP_LATENESS
+     * @param counts array that receives the counts
+     * @param numCounts size of the array
+     * @return number of bins copied or a negative error
+     */
+    int32_t getHistogram(int32_t which, int32_t *counts, int32_t numCounts) const;
+
+private:
+    class Histogram {
+    public:
+        void add(int64_t nanos);
+        int32_t copy(int32_t *counts, int32_t numCounts) const;
+    private:
+        std::array<std::atomic<int32_t>, kHistogramBinCount> mCounts{};
+    };
+
+    // Mean estimates use 1/2^N of each new sample.
+    static constexpr int32_t kShifterForMean = 4;
+    // Samples needed before the estimates replace the initial margin.
+    static constexpr int32_t kTimestampsBeforeAdapting = 16;
+    // Added to the bias for each CPU-only wakeup, and removed for 8 useful wakeups.
+    static constexpr int64_t kEmptyWakeupBiasNanos = 50 * AAUDIO_NANOS_PER_MICROSECOND;
+    static constexpr int32_t kBiasDecayShift = 3;
+    // Time without xruns before the limit of the margin doubles again.
+    static constexpr int64_t kQuietNanosBeforeRelax = 5 * AAUDIO_NANOS_PER_SECOND;
+
+    void update();
+
+    int64_t mBurstNanos = 0;
+    int64_t mInitialMarginNanos = 0;
+    bool mAdaptive = false;
+
+    int64_t mLatenessMeanNanos = 0;     // DSP lateness
+    int64_t mLatenessDevNanos = 0;
+    int64_t mSchedulingMeanNanos = 0;   // wakeup latency of this thread
+    int64_t mSchedulingDevNanos = 0;
+    int64_t mBiasNanos = 0;             // from CPU-only wakeups
+    int64_t mLimitNanos = 0;            // halved on xruns
+    int32_t mTimestampCount = 0;
+    int32_t mXRunCount = 0;
+    int64_t mQuietStartNanos = 0;
+
+    std::atomic<int64_t> mMarginNanos{0};
+    std::atomic<int32_t> mWakeupCount{0};
+    std::atomic<int32_t> mEmptyWakeupCount{0};
+    std::array<Histogram, HISTOGRAM_COUNT> mHistograms;
+};
+
+} /* namespace aaudio */
+
+#endif //ANDROID_AAUDIO_WAKEUP_CONTROLLER_H
@@ -609,6 +609,27 @@ AAUDIO_API bool AAudioStream_isMMapUsed(AAudioStream* stream)
     return audioStream->isMMap();
 }
 
+static_assert(AAUDIO_WAKEUP_HISTOGRAM_SCHEDULING_LATENCY
+              == WakeupController::HISTOGRAM_SCHEDULING_LATENCY);
+static_assert(AAUDIO_WAKEUP_HISTOGRAM_TIMESTAMP_LATENESS
+              == WakeupController::HISTOGRAM_TIMESTAMP_LATENESS);
+static_assert(AAUDIO_WAKEUP_HISTOGRAM_BIN_WIDTH_MICROS
+              == WakeupController::kHistogramBinWidthMicros);
+static_assert(AAUDIO_WAKEUP_HISTOGRAM_BIN_COUNT == WakeupController::kHistogramBinCount);
+
+AAUDIO_API int32_t AAudioStream_getWakeupHistogram(AAudioStream* stream,
+        aaudio_wakeup_histogram_t histogram, int32_t* counts, int32_t numCounts)
+{
+    AudioStream *audioStream = convertAAudioStreamToAudioStream(stream);
+    return audioStream->getWakeupHistogram(histogram, counts, numCounts);
+}
+
+AAUDIO_API int32_t AAudioStream_getWakeupMarginMicros(AAudioStream* stream)
+{
+    AudioStream *audioStream = convertAAudioStreamToAudioStream(stream);
+    return audioStream->getWakeupMarginMicros();
+}
+
 AAUDIO_API bool AAudioStream_isPrivacySensitive(AAudioStream* stream)
 {
     AudioStream *audioStream = convertAAudioStreamToAudioStream(stream);
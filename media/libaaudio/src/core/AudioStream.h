@@ -212,6 +212,19 @@ public:
         return AAUDIO_ERROR_UNIMPLEMENTED;
     }
 
+    /**
+     * Copy a histogram of the wakeup timing of the data thread.
+     * See AAudioStream_getWakeupHistogram().
+     */
+    virtual int32_t getWakeupHistogram(int32_t which __unused, int32_t *counts __unused,
+                                       int32_t numCounts __unused) const {
+        return AAUDIO_ERROR_UNIMPLEMENTED;
+    }
+
+    virtual int32_t getWakeupMarginMicros() const {
+        return AAUDIO_ERROR_UNIMPLEMENTED;
+    }
+
     bool isActive() const {
         return mState == AAUDIO_STREAM_STATE_STARTING || mState == AAUDIO_STREAM_STATE_STARTED;
     }
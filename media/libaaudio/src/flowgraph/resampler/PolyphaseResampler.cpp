@@ -18,6 +18,7 @@
 #include <math.h>
 #include "IntegerRatio.h"
 #include "PolyphaseResampler.h"
+#include "ResamplerSimd.h"
 
 using namespace RESAMPLER_OUTER_NAMESPACE::resampler;
 
@@ -37,12 +38,19 @@ PolyphaseResampler::PolyphaseResampler(const MultiChannelResampler::Builder &bui
 }
 
 void PolyphaseResampler::readFrame(float *frame) {
+    float *coefficients = &mCoefficients[mCoefficientCursor];
+    float *xFrame = &mX[static_cast<size_t>(mCursor) * static_cast<size_t>(getChannelCount())];
+
+    // Use an explicit SIMD kernel for the common channel counts.
+    if (convolveFrameSimd(getChannelCount(), frame, xFrame, coefficients, mNumTaps)) {
+        mCoefficientCursor = (mCoefficientCursor + mNumTaps) % mCoefficients.size();
+        return;
+    }
+
     // Clear accumulator for mixing.
     std::fill(mSingleFrame.begin(), mSingleFrame.end(), 0.0);
 
     // Multiply input times windowed sinc function.
-    float *coefficients = &mCoefficients[mCoefficientCursor];
-    float *xFrame = &mX[static_cast<size_t>(mCursor) * static_cast<size_t>(getChannelCount())];
     for (int i = 0; i < mNumTaps; i++) {
         float coefficient = *coefficients++;
         for (int channel = 0; channel < getChannelCount(); channel++) {
@@ -16,6 +16,7 @@
 
 #include <cassert>
 #include "PolyphaseResamplerMono.h"
+#include "ResamplerSimd.h"
 
 using namespace RESAMPLER_OUTER_NAMESPACE::resampler;
 
@@ -41,23 +42,10 @@ void PolyphaseResamplerMono::writeFrame(const float *frame) {
 }
 
 void PolyphaseResamplerMono::readFrame(float *frame) {
-    // Clear accumulator.
-    float sum = 0.0;
-
     // Multiply input times precomputed windowed sinc function.
     const float *coefficients = &mCoefficients[mCoefficientCursor];
-    float *xFrame = &mX[mCursor * MONO];
-    const int numLoops = mNumTaps >> 2; // n/4
-    for (int i = 0; i < numLoops; i++) {
-        // Manual loop unrolling, might get converted to SIMD.
-        sum += *xFrame++ * *coefficients++;
-        sum += *xFrame++ * *coefficients++;
-        sum += *xFrame++ * *coefficients++;
-        sum += *xFrame++ * *coefficients++;
-    }
+    const float *xFrame = &mX[mCursor * MONO];
+    convolveFrame<MONO>(frame, xFrame, coefficients, mNumTaps);
 
     mCoefficientCursor = (mCoefficientCursor + mNumTaps) % mCoefficients.size();
-
-    // Copy accumulator to output.
-    frame[0] = sum;
 }
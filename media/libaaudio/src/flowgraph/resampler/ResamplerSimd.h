@@ -0,0 +1,214 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef RESAMPLER_RESAMPLER_SIMD_H
+#define RESAMPLER_RESAMPLER_SIMD_H
+
+#include <stdint.h>
+
+#include "ResamplerDefinitions.h"
+
+// Explicit SIMD kernels for the FIR of the polyphase and sinc resamplers.
+//
+// To disable for benchmarking, compile with -DUSE_NEON=false (arm) or -DUSE_SSE=false (x86).
+
+#if (defined(__aarch64__) || defined(__ARM_NEON)) && !(defined(USE_NEON) && !USE_NEON)
+#define RESAMPLER_USE_NEON 1
+#include <arm_neon.h>
+#else
+#define RESAMPLER_USE_NEON 0
+#endif
+
+#if defined(__SSE2__) && !(defined(USE_SSE) && !USE_SSE)
+#define RESAMPLER_USE_SSE 1
+#include <immintrin.h>
+#else
+#define RESAMPLER_USE_SSE 0
+#endif
+
+namespace RESAMPLER_OUTER_NAMESPACE::resampler {
+
+#if RESAMPLER_USE_NEON
+
+using fvec_t = float32x4_t;
+
+inline fvec_t fvecLoad(const float *p) { return vld1q_f32(p); }
+inline fvec_t fvecSet(float a) { return vdupq_n_f32(a); }
+inline fvec_t fvecSet2(float a, float b) { return vcombine_f32(vdup_n_f32(a), vdup_n_f32(b)); }
+// multiply and add are kept separate (no fused multiply-add) as in the scalar code.
+inline fvec_t fvecMulAdd(fvec_t acc, fvec_t a, fvec_t b) {
+    return vaddq_f32(acc, vmulq_f32(a, b));
+}
+inline void fvecStore(float *p, fvec_t v) { vst1q_f32(p, v); }
+// {a0, a0, a1, a1} and {a2, a2, a3, a3}
+inline fvec_t fvecDupLow(fvec_t a) { return vzipq_f32(a, a).val[0]; }
+inline fvec_t fvecDupHigh(fvec_t a) { return vzipq_f32(a, a).val[1]; }
+
+#elif RESAMPLER_USE_SSE
+
+using fvec_t = __m128;
+
+inline fvec_t fvecLoad(const float *p) { return _mm_loadu_ps(p); }
+inline fvec_t fvecSet(float a) { return _mm_set1_ps(a); }
+inline fvec_t fvecSet2(float a, float b) { return _mm_setr_ps(a, a, b, b); }
+inline fvec_t fvecMulAdd(fvec_t acc, fvec_t a, fvec_t b) {
+    return _mm_add_ps(acc, _mm_mul_ps(a, b));
+}
+inline void fvecStore(float *p, fvec_t v) { _mm_storeu_ps(p, v); }
+inline fvec_t fvecDupLow(fvec_t a) { return _mm_unpacklo_ps(a, a); }
+inline fvec_t fvecDupHigh(fvec_t a) { return _mm_unpackhi_ps(a, a); }
+
+#endif
+
+constexpr bool kResamplerSimd = RESAMPLER_USE_NEON || RESAMPLER_USE_SSE;
+
+/**
+ * Multiply numTaps frames of CHANNELS interleaved samples by numTaps coefficients:
+ *
+ *   frame[c] = sum of x[t * CHANNELS + c] * coefficients[t] for 0 <= t < numTaps
+ *
+ * numTaps must be a multiple of 4.
+ * With SIMD, mono, stereo and 4, 6 or 8 channels use explicit kernels; the sums are
+ * computed in a different order than the scalar loop, so the results may differ in the
+ * last bits.
+ */
+template <int CHANNELS>
+inline void convolveFrame(float *frame, const float *x, const float *coefficients,
+                          int numTaps) {
+#if RESAMPLER_USE_NEON || RESAMPLER_USE_SSE
+    if constexpr (CHANNELS == 1) {
+        // four taps per vector
+        fvec_t acc = fvecSet(0.0f);
+        for (int t = 0; t < numTaps; t += 4) {
+            acc = fvecMulAdd(acc, fvecLoad(x + t), fvecLoad(coefficients + t));
+        }
+        float sums[4];
+        fvecStore(sums, acc);
+        frame[0] = (sums[0] + sums[1]) + (sums[2] + sums[3]);
+        return;
+    } else if constexpr (CHANNELS == 2) {
+        // two taps per vector, with each coefficient duplicated for left and right
+        fvec_t acc = fvecSet(0.0f);
+        for (int t = 0; t < numTaps; t += 4) {
+            const fvec_t c = fvecLoad(coefficients + t);
+            acc = fvecMulAdd(acc, fvecLoad(x + 2 * t), fvecDupLow(c));
+            acc = fvecMulAdd(acc, fvecLoad(x + 2 * t + 4), fvecDupHigh(c));
+        }
+        float sums[4];
+        fvecStore(sums, acc);
+        frame[0] = sums[0] + sums[2];
+        frame[1] = sums[1] + sums[3];
+        return;
+    } else if constexpr (CHANNELS == 4 || CHANNELS == 8) {
+        // one tap per CHANNELS / 4 vectors, with separate accumulators for even and odd taps
+        // to shorten the dependency chain of the adds.
+        constexpr int kVectors = CHANNELS / 4;
+        fvec_t even[kVectors];
+        fvec_t odd[kVectors];
+        for (int v = 0; v < kVectors; v++) {
+            even[v] = fvecSet(0.0f);
+            odd[v] = fvecSet(0.0f);
+        }
+        for (int t = 0; t < numTaps; t += 2) {
+            const fvec_t c0 = fvecSet(coefficients[t]);
+            const fvec_t c1 = fvecSet(coefficients[t + 1]);
+            const float *xt = x + t * CHANNELS;
+            for (int v = 0; v < kVectors; v++) {
+                even[v] = fvecMulAdd(even[v], fvecLoad(xt + v * 4), c0);
+                odd[v] = fvecMulAdd(odd[v], fvecLoad(xt + CHANNELS + v * 4), c1);
+            }
+        }
+        for (int v = 0; v < kVectors; v++) {
+            float sumEven[4], sumOdd[4];
+            fvecStore(sumEven, even[v]);
+            fvecStore(sumOdd, odd[v]);
+            for (int i = 0; i < 4; i++) {
+                frame[v * 4 + i] = sumEven[i] + sumOdd[i];
+            }
+        }
+        return;
+    } else if constexpr (CHANNELS == 6) {
+        // two taps per three vectors:
+        //   a = {t0c0 t0c1 t0c2 t0c3}, b = {t0c4 t0c5 t1c0 t1c1}, c = {t1c2 t1c3 t1c4 t1c5}
+        fvec_t a = fvecSet(0.0f);
+        fvec_t b = fvecSet(0.0f);
+        fvec_t c = fvecSet(0.0f);
+        for (int t = 0; t < numTaps; t += 2) {
+            const float c0 = coefficients[t];
+            const float c1 = coefficients[t + 1];
+            const float *xt = x + t * CHANNELS;
+            a = fvecMulAdd(a, fvecLoad(xt), fvecSet(c0));
+            b = fvecMulAdd(b, fvecLoad(xt + 4), fvecSet2(c0, c1));
+            c = fvecMulAdd(c, fvecLoad(xt + 8), fvecSet(c1));
+        }
+        float sa[4], sb[4], sc[4];
+        fvecStore(sa, a);
+        fvecStore(sb, b);
+        fvecStore(sc, c);
+        frame[0] = sa[0] + sb[2];
+        frame[1] = sa[1] + sb[3];
+        frame[2] = sa[2] + sc[0];
+        frame[3] = sa[3] + sc[1];
+        frame[4] = sb[0] + sc[2];
+        frame[5] = sb[1] + sc[3];
+        return;
+    }
+#endif
+    for (int channel = 0; channel < CHANNELS; channel++) {
+        frame[channel] = 0.0f;
+    }
+    for (int t = 0; t < numTaps; t++) {
+        const float coefficient = coefficients[t];
+        for (int channel = 0; channel < CHANNELS; channel++) {
+            frame[channel] += *x++ * coefficient;
+        }
+    }
+}
+
+/**
+ * Calls convolveFrame<channelCount>() if there is an explicit SIMD kernel for channelCount.
+ *
+ * @return false if there is no kernel for channelCount, and frame is not written
+ */
+inline bool convolveFrameSimd(int channelCount, float *frame, const float *x,
+                              const float *coefficients, int numTaps) {
+    if (!kResamplerSimd) {
+        return false;
+    }
+    switch (channelCount) {
+        case 1:
+            convolveFrame<1>(frame, x, coefficients, numTaps);
+            return true;
+        case 2:
+            convolveFrame<2>(frame, x, coefficients, numTaps);
+            return true;
+        case 4:
+            convolveFrame<4>(frame, x, coefficients, numTaps);
+            return true;
+        case 6:
+            convolveFrame<6>(frame, x, coefficients, numTaps);
+            return true;
+        case 8:
+            convolveFrame<8>(frame, x, coefficients, numTaps);
+            return true;
+        default:
+            return false;
+    }
+}
+
+} /* namespace RESAMPLER_OUTER_NAMESPACE::resampler */
+
+#endif //RESAMPLER_RESAMPLER_SIMD_H
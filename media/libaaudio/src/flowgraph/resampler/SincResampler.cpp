@@ -16,6 +16,7 @@
 
 #include <cassert>
 #include <math.h>
+#include "ResamplerSimd.h"
 #include "SincResampler.h"
 
 using namespace RESAMPLER_OUTER_NAMESPACE::resampler;
@@ -51,13 +52,20 @@ void SincResampler::readFrame(float *frame) {
                                              * static_cast<size_t>(getNumTaps())];
 
     float *xFrame = &mX[static_cast<size_t>(mCursor) * static_cast<size_t>(getChannelCount())];
-    for (int tap = 0; tap < mNumTaps; tap++) {
-        const float coefficientLow = *coefficientsLow++;
-        const float coefficientHigh = *coefficientsHigh++;
-        for (int channel = 0; channel < getChannelCount(); channel++) {
-            const float sample = *xFrame++;
-            mSingleFrame[channel] += sample * coefficientLow;
-            mSingleFrame2[channel] += sample * coefficientHigh;
+    // Use an explicit SIMD kernel for the common channel counts, one pass per row.
+    if (convolveFrameSimd(getChannelCount(), mSingleFrame.data(), xFrame,
+                          coefficientsLow, mNumTaps)) {
+        convolveFrameSimd(getChannelCount(), mSingleFrame2.data(), xFrame,
+                          coefficientsHigh, mNumTaps);
+    } else {
+        for (int tap = 0; tap < mNumTaps; tap++) {
+            const float coefficientLow = *coefficientsLow++;
+            const float coefficientHigh = *coefficientsHigh++;
+            for (int channel = 0; channel < getChannelCount(); channel++) {
+                const float sample = *xFrame++;
+                mSingleFrame[channel] += sample * coefficientLow;
+                mSingleFrame2[channel] += sample * coefficientHigh;
+            }
         }
     }
 
@@ -632,6 +632,29 @@ int32_t AAudioProperty_getOutputMMapOffsetMicros() {
     return AAudioProperty_getMMapOffsetMicros(__func__, AAUDIO_PROP_OUTPUT_MMAP_OFFSET_USEC);
 }
 
+bool AAudioProperty_isBufferTuningEnabled() {
+    return property_get_bool(AAUDIO_PROP_BUFFER_TUNING, false);
+}
+
+bool AAudioProperty_isWakeupTuningEnabled() {
+    return property_get_bool(AAUDIO_PROP_WAKEUP_TUNING, false);
+}
+
+int32_t AAudioProperty_getMixerHelperThreads() {
+    const int32_t minThreads = 0;
+    const int32_t defaultThreads = 0;
+    const int32_t maxThreads = 2; // arbitrary
+    int32_t prop = property_get_int32(AAUDIO_PROP_MIXER_HELPER_THREADS, defaultThreads);
+    if (prop < minThreads) {
+        ALOGW("AAudioProperty_getMixerHelperThreads: clipped %d to %d", prop, minThreads);
+        prop = minThreads;
+    } else if (prop > maxThreads) {
+        ALOGW("AAudioProperty_getMixerHelperThreads: clipped %d to %d", prop, maxThreads);
+        prop = maxThreads;
+    }
+    return prop;
+}
+
 int32_t AAudioProperty_getLogMask() {
     return property_get_int32(AAUDIO_PROP_LOG_MASK, 0);
 }
@@ -166,6 +166,38 @@ int32_t AAudioProperty_getInputMMapOffsetMicros();
 int32_t AAudioProperty_getOutputMMapOffsetMicros();
 #define AAUDIO_PROP_OUTPUT_MMAP_OFFSET_USEC   "aaudio.out_mmap_offset_usec"
 
+/**
+ * Read a system property that enables runtime tuning of the buffer size of output streams.
+ * The buffer grows by a burst when there are underruns and shrinks when the timing is stable,
+ * between a lower limit set by AAudioStream_setBufferSizeInFrames(), or one burst, and the
+ * buffer capacity.
+ *
+ * @return true if buffer size tuning is enabled
+ */
+bool AAudioProperty_isBufferTuningEnabled();
+#define AAUDIO_PROP_BUFFER_TUNING   "aaudio.buffer_tuning"
+
+/**
+ * Read a system property that enables adaptive wakeup timing of the data thread.
+ * The margin added to the predicted wakeup time then follows the measured timestamp lateness,
+ * scheduling latency, wakeups without data and xruns, instead of the fixed
+ * AAUDIO_PROP_WAKEUP_DELAY_USEC, or no margin for EXCLUSIVE streams.
+ *
+ * @return true if wakeup tuning is enabled
+ */
+bool AAudioProperty_isWakeupTuningEnabled();
+#define AAUDIO_PROP_WAKEUP_TUNING   "aaudio.wakeup_tuning"
+
+/**
+ * Read a system property that specifies the number of helper threads used by the
+ * AAudio service to mix the streams of a shared output endpoint.
+ * Zero means that all of the streams are mixed on the endpoint thread.
+ *
+ * @return number of helper threads, between 0 and 2
+ */
+int32_t AAudioProperty_getMixerHelperThreads();
+#define AAUDIO_PROP_MIXER_HELPER_THREADS   "aaudio.mixer_helper_threads"
+
 // These are powers of two that can be combined as a bit mask.
 // AAUDIO_LOG_CLOCK_MODEL_HISTOGRAM must be enabled before the stream is opened.
 #define AAUDIO_LOG_CLOCK_MODEL_HISTOGRAM   1
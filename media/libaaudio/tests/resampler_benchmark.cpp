@@ -0,0 +1,67 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Benchmark the FIR kernels of the flowgraph resampler.
+ *
+ * Build as resampler_benchmark for the explicit SIMD kernels and as
+ * resampler_benchmark_scalar for the scalar loops, and compare.
+ */
+
+#include <math.h>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "../src/flowgraph/resampler/ResamplerSimd.h"
+
+using namespace RESAMPLER_OUTER_NAMESPACE::resampler;
+
+// Convolve one frame for each of FRAME_COUNT consecutive positions of the input,
+// as the polyphase resampler does when converting FRAME_COUNT output frames.
+template <int CHANNELS>
+static void BM_ConvolveFrame(benchmark::State& state) {
+    constexpr int FRAME_COUNT = 1000;
+    const int numTaps = state.range(0);
+    std::vector<float> x((FRAME_COUNT + numTaps) * CHANNELS);
+    std::vector<float> coefficients(numTaps);
+    std::vector<float> out(FRAME_COUNT * CHANNELS);
+    for (size_t i = 0; i < x.size(); i++) {
+        x[i] = sinf(i * 0.01f);
+    }
+    for (int i = 0; i < numTaps; i++) {
+        coefficients[i] = cosf(i * 0.1f);
+    }
+
+    while (state.KeepRunning()) {
+        for (int f = 0; f < FRAME_COUNT; f++) {
+            convolveFrame<CHANNELS>(&out[f * CHANNELS], &x[f * CHANNELS],
+                                    coefficients.data(), numTaps);
+        }
+        benchmark::DoNotOptimize(out.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetLabel(kResamplerSimd ? "simd" : "scalar");
+}
+
+// Number of taps for Quality::Medium, High and Best.
+BENCHMARK_TEMPLATE(BM_ConvolveFrame, 1)->Arg(8)->Arg(16)->Arg(32);
+BENCHMARK_TEMPLATE(BM_ConvolveFrame, 2)->Arg(8)->Arg(16)->Arg(32);
+BENCHMARK_TEMPLATE(BM_ConvolveFrame, 4)->Arg(8)->Arg(16)->Arg(32);
+BENCHMARK_TEMPLATE(BM_ConvolveFrame, 6)->Arg(8)->Arg(16)->Arg(32);
+BENCHMARK_TEMPLATE(BM_ConvolveFrame, 8)->Arg(8)->Arg(16)->Arg(32);
+
+BENCHMARK_MAIN();
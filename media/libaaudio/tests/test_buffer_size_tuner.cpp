@@ -0,0 +1,88 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Unit tests for the buffer size tuner
+
+#include <aaudio/AAudio.h>
+#include <client/BufferSizeTuner.h>
+#include <gtest/gtest.h>
+
+using namespace aaudio;
+
+// We can use arbitrary values here because we are not opening a real audio stream.
+#define FRAMES_PER_BURST     96
+#define MINIMUM_FRAMES       (1 * FRAMES_PER_BURST)
+#define MAXIMUM_FRAMES       (7 * FRAMES_PER_BURST)
+#define NANOS_PER_BURST      (2 * AAUDIO_NANOS_PER_MILLISECOND)
+
+class BufferSizeTunerTest : public ::testing::Test {
+public:
+    void SetUp() override {
+        tuner.configure(FRAMES_PER_BURST, MINIMUM_FRAMES, MAXIMUM_FRAMES);
+        tuner.reset(2 * FRAMES_PER_BURST, 0 /* xRunCount */, mNanoTime);
+    }
+
+    // Run for the given time, one update per burst.
+    int32_t run(int64_t durationNanos, int32_t xRunCount, int64_t latenessFrames) {
+        int32_t bufferSize = tuner.getBufferSize();
+        for (int64_t end = mNanoTime + durationNanos; mNanoTime < end;
+                mNanoTime += NANOS_PER_BURST) {
+            bufferSize = tuner.update(mNanoTime, xRunCount, latenessFrames);
+        }
+        return bufferSize;
+    }
+
+    BufferSizeTuner tuner;
+
+private:
+    int64_t mNanoTime = 1000 * AAUDIO_NANOS_PER_MILLISECOND; // arbitrary
+};
+
+TEST_F(BufferSizeTunerTest, LimitsAreRoundedToBursts) {
+    tuner.configure(FRAMES_PER_BURST, FRAMES_PER_BURST + 1, MAXIMUM_FRAMES + 1);
+    EXPECT_EQ(2 * FRAMES_PER_BURST, tuner.getMinimumSize());
+    EXPECT_EQ(MAXIMUM_FRAMES, tuner.getMaximumSize());
+    tuner.reset(0 /* bufferSizeFrames */, 0 /* xRunCount */, 0 /* nanoTime */);
+    EXPECT_EQ(2 * FRAMES_PER_BURST, tuner.getBufferSize());
+}
+
+TEST_F(BufferSizeTunerTest, StableTimingShrinksToMinimum) {
+    EXPECT_EQ(2 * FRAMES_PER_BURST, run(AAUDIO_NANOS_PER_SECOND, 0, 0));
+    EXPECT_EQ(MINIMUM_FRAMES, run(10 * AAUDIO_NANOS_PER_SECOND, 0, 0));
+}
+
+TEST_F(BufferSizeTunerTest, LatenessLimitsShrinking) {
+    // One burst of lateness needs two bursts of buffer.
+    EXPECT_EQ(2 * FRAMES_PER_BURST, run(20 * AAUDIO_NANOS_PER_SECOND, 0, FRAMES_PER_BURST));
+}
+
+TEST_F(BufferSizeTunerTest, UnderrunsGrowToMaximum) {
+    int32_t xRunCount = 0;
+    int32_t bufferSize = 0;
+    for (int i = 0; i < 20; i++) {
+        bufferSize = run(200 * AAUDIO_NANOS_PER_MILLISECOND, ++xRunCount, 0);
+    }
+    EXPECT_EQ(MAXIMUM_FRAMES, bufferSize);
+}
+
+TEST_F(BufferSizeTunerTest, UnderrunClusterGrowsOnce) {
+    int32_t xRunCount = 0;
+    int32_t bufferSize = 0;
+    for (int i = 0; i < 10; i++) { // ten underruns within 20 msec
+        bufferSize = run(NANOS_PER_BURST, ++xRunCount, 0);
+    }
+    EXPECT_EQ(3 * FRAMES_PER_BURST, bufferSize);
+}
@@ -21,11 +21,15 @@
  * sometimes that have caused compiler bugs.
  */
 
+#include <algorithm>
 #include <iostream>
+#include <memory>
+#include <vector>
 
 #include <gtest/gtest.h>
 
 #include "flowgraph/resampler/MultiChannelResampler.h"
+#include "flowgraph/resampler/ResamplerSimd.h"
 
 using namespace RESAMPLER_OUTER_NAMESPACE::resampler;
 
@@ -219,3 +223,83 @@ TEST(test_resampler, resampler_48000_44100_best) {
 TEST(test_resampler, resampler_44100_11025_best) {
     checkResampler(44100, 11025, MultiChannelResampler::Quality::Best);
 }
+
+// Compare the FIR kernels with a plain scalar convolution.
+template <int CHANNELS>
+static void checkConvolveFrame() {
+    constexpr int kMaxTaps = 32;
+    float x[kMaxTaps * CHANNELS];
+    float coefficients[kMaxTaps];
+    for (int i = 0; i < kMaxTaps * CHANNELS; i++) {
+        x[i] = sinf(i * 0.37f);
+    }
+    for (int i = 0; i < kMaxTaps; i++) {
+        coefficients[i] = cosf(i * 0.21f);
+    }
+    for (int numTaps = 4; numTaps <= kMaxTaps; numTaps += 4) {
+        float frame[CHANNELS];
+        convolveFrame<CHANNELS>(frame, x, coefficients, numTaps);
+        for (int channel = 0; channel < CHANNELS; channel++) {
+            float expected = 0.0f;
+            for (int tap = 0; tap < numTaps; tap++) {
+                expected += x[tap * CHANNELS + channel] * coefficients[tap];
+            }
+            EXPECT_NEAR(expected, frame[channel], 1e-5f)
+                    << "numTaps " << numTaps << ", channel " << channel;
+        }
+    }
+}
+
+TEST(test_resampler, convolve_frame) {
+    checkConvolveFrame<1>();
+    checkConvolveFrame<2>();
+    checkConvolveFrame<3>();
+    checkConvolveFrame<4>();
+    checkConvolveFrame<6>();
+    checkConvolveFrame<8>();
+}
+
+// Each channel of a multichannel resampler must give the same output as a mono resampler.
+static void checkChannelsMatchMono(int32_t sourceRate, int32_t sinkRate,
+        MultiChannelResampler::Quality quality) {
+    constexpr int kNumInputFrames = 2000;
+    for (int channelCount = 2; channelCount <= 8; channelCount++) {
+        std::unique_ptr<MultiChannelResampler> mono(
+                MultiChannelResampler::make(1, sourceRate, sinkRate, quality));
+        std::unique_ptr<MultiChannelResampler> multi(
+                MultiChannelResampler::make(channelCount, sourceRate, sinkRate, quality));
+        std::vector<float> inputFrame(channelCount);
+        std::vector<float> outputFrame(channelCount);
+        float monoFrame;
+        int numOutputFrames = 0;
+        for (int i = 0; i < kNumInputFrames;) {
+            ASSERT_EQ(mono->isWriteNeeded(), multi->isWriteNeeded());
+            if (mono->isWriteNeeded()) {
+                const float sample = sinf(i * 0.05f);
+                std::fill(inputFrame.begin(), inputFrame.end(), sample);
+                mono->writeNextFrame(&sample);
+                multi->writeNextFrame(inputFrame.data());
+                i++;
+            } else {
+                mono->readNextFrame(&monoFrame);
+                multi->readNextFrame(outputFrame.data());
+                for (int channel = 0; channel < channelCount; channel++) {
+                    ASSERT_NEAR(monoFrame, outputFrame[channel], 1e-5f)
+                            << "channelCount " << channelCount << ", frame " << numOutputFrames
+                            << ", channel " << channel;
+                }
+                numOutputFrames++;
+            }
+        }
+        EXPECT_GT(numOutputFrames, 0);
+    }
+}
+
+TEST(test_resampler, resampler_channels_polyphase) {
+    checkChannelsMatchMono(44100, 48000, MultiChannelResampler::Quality::High);
+}
+
+TEST(test_resampler, resampler_channels_sinc) {
+    // The reduced ratio is too large for a polyphase table, so this uses the sinc resampler.
+    checkChannelsMatchMono(44101, 48000, MultiChannelResampler::Quality::High);
+}
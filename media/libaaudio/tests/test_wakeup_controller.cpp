@@ -0,0 +1,112 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Unit tests for the wakeup controller
+
+#include <aaudio/AAudio.h>
+#include <client/WakeupController.h>
+#include <gtest/gtest.h>
+
+using namespace aaudio;
+
+// We can use arbitrary values here because we are not opening a real audio stream.
+#define NANOS_PER_BURST      (2 * AAUDIO_NANOS_PER_MILLISECOND)
+#define INITIAL_MARGIN_NANOS (200 * AAUDIO_NANOS_PER_MICROSECOND)
+#define MICROS               AAUDIO_NANOS_PER_MICROSECOND
+
+class WakeupControllerTest : public ::testing::Test {
+public:
+    void SetUp() override {
+        controller.configure(NANOS_PER_BURST, INITIAL_MARGIN_NANOS);
+        controller.setAdaptive(true);
+        controller.reset(0 /* xRunCount */, mNanoTime);
+    }
+
+    // Run for the given number of bursts, with one timestamp and one wakeup per burst.
+    int64_t run(int32_t bursts, int64_t latenessNanos, int64_t schedulingNanos,
+                int32_t framesProcessed = 96, int32_t xRunCount = 0) {
+        for (int32_t i = 0; i < bursts; i++) {
+            mNanoTime += NANOS_PER_BURST;
+            controller.onTimestamp(latenessNanos);
+            controller.onWakeup(mNanoTime, mNanoTime + schedulingNanos, framesProcessed,
+                                xRunCount);
+        }
+        return controller.getMarginNanos();
+    }
+
+    WakeupController controller;
+
+private:
+    int64_t mNanoTime = 1000 * AAUDIO_NANOS_PER_MILLISECOND; // arbitrary
+};
+
+TEST_F(WakeupControllerTest, InitialMarginUntilMeasured) {
+    EXPECT_EQ(INITIAL_MARGIN_NANOS, controller.getMarginNanos());
+    EXPECT_EQ(INITIAL_MARGIN_NANOS, run(4, 0, 0));
+}
+
+TEST_F(WakeupControllerTest, FixedWhenNotAdaptive) {
+    controller.setAdaptive(false);
+    EXPECT_EQ(INITIAL_MARGIN_NANOS, run(100, 600 * MICROS, 0));
+}
+
+TEST_F(WakeupControllerTest, StableTimingNeedsNoMargin) {
+    EXPECT_EQ(0, run(100, 0, 50 * MICROS));
+}
+
+TEST_F(WakeupControllerTest, MarginFollowsLateness) {
+    // Steady lateness minus the scheduling latency that already covers part of it.
+    EXPECT_NEAR(300 * MICROS, run(200, 400 * MICROS, 100 * MICROS), 10 * MICROS);
+}
+
+TEST_F(WakeupControllerTest, MarginLeavesHalfABurst) {
+    EXPECT_NEAR(NANOS_PER_BURST / 2 - 200 * MICROS, run(200, 5000 * MICROS, 200 * MICROS),
+                1 * MICROS);
+}
+
+TEST_F(WakeupControllerTest, EmptyWakeupsDelayWakeup) {
+    const int64_t margin = run(100, 0, 0, 0 /* framesProcessed */);
+    EXPECT_GT(margin, 0);
+    EXPECT_EQ(100, controller.getEmptyWakeupCount());
+    // Useful wakeups remove the bias again.
+    EXPECT_EQ(0, run(2000, 0, 0));
+}
+
+TEST_F(WakeupControllerTest, XRunHalvesLimit) {
+    EXPECT_EQ(NANOS_PER_BURST / 2, run(200, 5000 * MICROS, 0));
+    EXPECT_EQ(NANOS_PER_BURST / 4, run(1, 5000 * MICROS, 0, 96, 1 /* xRunCount */));
+    // Recovers after a quiet period.
+    EXPECT_EQ(NANOS_PER_BURST / 2, run(5000, 5000 * MICROS, 0, 96, 1));
+}
+
+TEST_F(WakeupControllerTest, Histograms) {
+    run(10, 120 * MICROS, 60 * MICROS);
+    run(5, -100 * MICROS, 10000 * MICROS);
+    int32_t counts[WakeupController::kHistogramBinCount + 1] = {};
+    EXPECT_EQ(WakeupController::kHistogramBinCount,
+              controller.getHistogram(WakeupController::HISTOGRAM_SCHEDULING_LATENCY,
+                                      counts, WakeupController::kHistogramBinCount + 1));
+    EXPECT_EQ(10, counts[1]);
+    EXPECT_EQ(5, counts[WakeupController::kHistogramBinCount - 1]);
+    EXPECT_EQ(3, controller.getHistogram(WakeupController::HISTOGRAM_TIMESTAMP_LATENESS,
+                                         counts, 3));
+    EXPECT_EQ(5, counts[0]);
+    EXPECT_EQ(0, counts[1]);
+    EXPECT_EQ(10, counts[2]);
+    EXPECT_EQ(15, controller.getWakeupCount());
+    EXPECT_EQ(AAUDIO_ERROR_ILLEGAL_ARGUMENT,
+              controller.getHistogram(WakeupController::HISTOGRAM_COUNT, counts, 3));
+}
@@ -32,6 +32,9 @@
 #include <media/TypeConverter.h>
 #include <math.h>
 
+#include <deque>
+#include <map>
+
 #include <system/audio.h>
 #include <android/media/GetInputForAttrResponse.h>
 #include <android/media/AudioMixerAttributesInternal.h>
@@ -98,12 +101,145 @@ void AudioSystem::setAudioFlingerBinder(const sp<IBinder>& audioFlinger) {
     gAudioFlingerBinder = audioFlinger;
 }
 
+// Process local cache of AudioFlinger and AudioPolicyService query results, which are
+// otherwise fetched over binder on every call.
+// All entries are dropped on ioConfigChanged() and onRoutingUpdated() notifications and when
+// either service dies. A result fetched while the cache is invalidated is not stored.
+// The cache is disabled in audioserver, which is notified asynchronously of its own changes.
+class QueryCache {
+public:
+    static constexpr size_t kMaxDevicesForAttributes = 16;
+
+    void disable() {
+        Mutex::Autolock _l(mLock);
+        mEnabled = false;
+        clear_l();
+    }
+
+    void invalidate() {
+        Mutex::Autolock _l(mLock);
+        clear_l();
+    }
+
+    // Returns the generation to pass to the put methods after the result is fetched.
+    uint64_t generation() {
+        Mutex::Autolock _l(mLock);
+        return mGeneration;
+    }
+
+    bool getOutput(audio_stream_type_t stream, audio_io_handle_t* output) {
+        Mutex::Autolock _l(mLock);
+        const auto it = mOutputForStream.find(stream);
+        if (it == mOutputForStream.end()) return false;
+        *output = it->second;
+        return true;
+    }
+
+    void putOutput(uint64_t generation, audio_stream_type_t stream, audio_io_handle_t output) {
+        Mutex::Autolock _l(mLock);
+        if (!canPut_l(generation)) return;
+        mOutputForStream[stream] = output;
+    }
+
+    bool getStrategyForStream(audio_stream_type_t stream, product_strategy_t* strategy) {
+        Mutex::Autolock _l(mLock);
+        const auto it = mStrategyForStream.find(stream);
+        if (it == mStrategyForStream.end()) return false;
+        *strategy = it->second;
+        return true;
+    }
+
+    void putStrategyForStream(uint64_t generation, audio_stream_type_t stream,
+            product_strategy_t strategy) {
+        Mutex::Autolock _l(mLock);
+        if (!canPut_l(generation)) return;
+        mStrategyForStream[stream] = strategy;
+    }
+
+    bool getDevicesForAttributes(const audio_attributes_t& aa, bool forVolume,
+            AudioDeviceTypeAddrVector* devices) {
+        Mutex::Autolock _l(mLock);
+        for (const auto& entry : mDevicesForAttributes) {
+            if (entry.forVolume == forVolume && entry.attributes == aa) {
+                *devices = entry.devices;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void putDevicesForAttributes(uint64_t generation, const audio_attributes_t& aa,
+            bool forVolume, const AudioDeviceTypeAddrVector& devices) {
+        Mutex::Autolock _l(mLock);
+        if (!canPut_l(generation)) return;
+        if (mDevicesForAttributes.size() == kMaxDevicesForAttributes) {
+            mDevicesForAttributes.pop_front();
+        }
+        mDevicesForAttributes.push_back({aa, forVolume, devices});
+    }
+
+    // A value of 0 is not cached.
+    uint32_t getPrimaryOutputSamplingRate() {
+        Mutex::Autolock _l(mLock);
+        return mPrimaryOutputSamplingRate;
+    }
+
+    void putPrimaryOutputSamplingRate(uint64_t generation, uint32_t samplingRate) {
+        Mutex::Autolock _l(mLock);
+        if (!canPut_l(generation)) return;
+        mPrimaryOutputSamplingRate = samplingRate;
+    }
+
+    size_t getPrimaryOutputFrameCount() {
+        Mutex::Autolock _l(mLock);
+        return mPrimaryOutputFrameCount;
+    }
+
+    void putPrimaryOutputFrameCount(uint64_t generation, size_t frameCount) {
+        Mutex::Autolock _l(mLock);
+        if (!canPut_l(generation)) return;
+        mPrimaryOutputFrameCount = frameCount;
+    }
+
+private:
+    struct DevicesForAttributes {
+        audio_attributes_t attributes;
+        bool forVolume;
+        AudioDeviceTypeAddrVector devices;
+    };
+
+    bool canPut_l(uint64_t generation) const REQUIRES(mLock) {
+        return mEnabled && generation == mGeneration;
+    }
+
+    void clear_l() REQUIRES(mLock) {
+        ++mGeneration;
+        mOutputForStream.clear();
+        mStrategyForStream.clear();
+        mDevicesForAttributes.clear();
+        mPrimaryOutputSamplingRate = 0;
+        mPrimaryOutputFrameCount = 0;
+    }
+
+    Mutex mLock;
+    bool mEnabled GUARDED_BY(mLock) = true;
+    uint64_t mGeneration GUARDED_BY(mLock) = 0;
+    std::map<audio_stream_type_t, audio_io_handle_t> mOutputForStream GUARDED_BY(mLock);
+    std::map<audio_stream_type_t, product_strategy_t> mStrategyForStream GUARDED_BY(mLock);
+    std::deque<DevicesForAttributes> mDevicesForAttributes GUARDED_BY(mLock);  // oldest first
+    uint32_t mPrimaryOutputSamplingRate GUARDED_BY(mLock) = 0;
+    size_t mPrimaryOutputFrameCount GUARDED_BY(mLock) = 0;
+};
+
+static QueryCache gQueryCache;
+
 static sp<IAudioFlinger> gLocalAudioFlinger; // set if we are local.
 
 status_t AudioSystem::setLocalAudioFlinger(const sp<IAudioFlinger>& af) {
     Mutex::Autolock _l(gLock);
     if (gAudioFlinger != nullptr) return INVALID_OPERATION;
     gLocalAudioFlinger = af;
+    gQueryCache.disable();
     return OK;
 }
 
@@ -553,6 +689,7 @@ void AudioSystem::AudioFlingerClient::binderDied(const wp<IBinder>& who __unused
 
     // clear output handles and stream to output map caches
     clearIoCache();
+    gQueryCache.invalidate();
 
     reportError(DEAD_OBJECT);
 
@@ -572,6 +709,9 @@ Status AudioSystem::AudioFlingerClient::ioConfigChanged(
 
     if (ioDesc->getIoHandle() == AUDIO_IO_HANDLE_NONE) return Status::ok();
 
+    // Starting a client does not change the configuration of the io handle.
+    if (event != AUDIO_CLIENT_STARTED) gQueryCache.invalidate();
+
     audio_port_handle_t deviceId = AUDIO_PORT_HANDLE_NONE;
     std::vector<sp<AudioDeviceCallback>> callbacksToCall;
     {
@@ -1018,6 +1158,10 @@ audio_io_handle_t AudioSystem::getOutput(audio_stream_type_t stream) {
     const sp<IAudioPolicyService>& aps = AudioSystem::get_audio_policy_service();
     if (aps == 0) return AUDIO_IO_HANDLE_NONE;
 
+    audio_io_handle_t output;
+    if (gQueryCache.getOutput(stream, &output)) return output;
+    const uint64_t generation = gQueryCache.generation();
+
     auto result = [&]() -> ConversionResult<audio_io_handle_t> {
         AudioStreamType streamAidl = VALUE_OR_RETURN(
                 legacy2aidl_audio_stream_type_t_AudioStreamType(stream));
@@ -1027,7 +1171,9 @@ audio_io_handle_t AudioSystem::getOutput(audio_stream_type_t stream) {
         return aidl2legacy_int32_t_audio_io_handle_t(outputAidl);
     }();
 
-    return result.value_or(AUDIO_IO_HANDLE_NONE);
+    output = result.value_or(AUDIO_IO_HANDLE_NONE);
+    if (output != AUDIO_IO_HANDLE_NONE) gQueryCache.putOutput(generation, stream, output);
+    return output;
 }
 
 status_t AudioSystem::getOutputForAttr(audio_attributes_t* attr,
@@ -1349,6 +1495,10 @@ product_strategy_t AudioSystem::getStrategyForStream(audio_stream_type_t stream)
     const sp<IAudioPolicyService>& aps = AudioSystem::get_audio_policy_service();
     if (aps == 0) return PRODUCT_STRATEGY_NONE;
 
+    product_strategy_t strategy;
+    if (gQueryCache.getStrategyForStream(stream, &strategy)) return strategy;
+    const uint64_t generation = gQueryCache.generation();
+
     auto result = [&]() -> ConversionResult<product_strategy_t> {
         AudioStreamType streamAidl = VALUE_OR_RETURN(
                 legacy2aidl_audio_stream_type_t_AudioStreamType(stream));
@@ -1357,7 +1507,11 @@ product_strategy_t AudioSystem::getStrategyForStream(audio_stream_type_t stream)
                 aps->getStrategyForStream(streamAidl, &resultAidl)));
         return aidl2legacy_int32_t_product_strategy_t(resultAidl);
     }();
-    return result.value_or(PRODUCT_STRATEGY_NONE);
+    strategy = result.value_or(PRODUCT_STRATEGY_NONE);
+    if (strategy != PRODUCT_STRATEGY_NONE) {
+        gQueryCache.putStrategyForStream(generation, stream, strategy);
+    }
+    return strategy;
 }
 
 status_t AudioSystem::getDevicesForAttributes(const audio_attributes_t& aa,
@@ -1369,6 +1523,9 @@ status_t AudioSystem::getDevicesForAttributes(const audio_attributes_t& aa,
     const sp<IAudioPolicyService>& aps = AudioSystem::get_audio_policy_service();
     if (aps == 0) return PERMISSION_DENIED;
 
+    if (gQueryCache.getDevicesForAttributes(aa, forVolume, devices)) return OK;
+    const uint64_t generation = gQueryCache.generation();
+
     media::audio::common::AudioAttributes aaAidl = VALUE_OR_RETURN_STATUS(
              legacy2aidl_audio_attributes_t_AudioAttributes(aa));
     std::vector<AudioDevice> retAidl;
@@ -1378,6 +1535,7 @@ status_t AudioSystem::getDevicesForAttributes(const audio_attributes_t& aa,
             convertContainer<AudioDeviceTypeAddrVector>(
                     retAidl,
                     aidl2legacy_AudioDeviceTypeAddress));
+    gQueryCache.putDevicesForAttributes(generation, aa, forVolume, *devices);
     return OK;
 }
 
@@ -1486,13 +1644,23 @@ status_t AudioSystem::isSourceActive(audio_source_t stream, bool* state) {
 uint32_t AudioSystem::getPrimaryOutputSamplingRate() {
     const sp<IAudioFlinger>& af = AudioSystem::get_audio_flinger();
     if (af == 0) return 0;
-    return af->getPrimaryOutputSamplingRate();
+    uint32_t samplingRate = gQueryCache.getPrimaryOutputSamplingRate();
+    if (samplingRate != 0) return samplingRate;
+    const uint64_t generation = gQueryCache.generation();
+    samplingRate = af->getPrimaryOutputSamplingRate();
+    gQueryCache.putPrimaryOutputSamplingRate(generation, samplingRate);
+    return samplingRate;
 }
 
 size_t AudioSystem::getPrimaryOutputFrameCount() {
     const sp<IAudioFlinger>& af = AudioSystem::get_audio_flinger();
     if (af == 0) return 0;
-    return af->getPrimaryOutputFrameCount();
+    size_t frameCount = gQueryCache.getPrimaryOutputFrameCount();
+    if (frameCount != 0) return frameCount;
+    const uint64_t generation = gQueryCache.generation();
+    frameCount = af->getPrimaryOutputFrameCount();
+    gQueryCache.putPrimaryOutputFrameCount(generation, frameCount);
+    return frameCount;
 }
 
 status_t AudioSystem::setLowRamDevice(bool isLowRamDevice, int64_t totalMemory) {
@@ -1504,6 +1672,7 @@ status_t AudioSystem::setLowRamDevice(bool isLowRamDevice, int64_t totalMemory)
 void AudioSystem::clearAudioConfigCache() {
     // called by restoreTrack_l(), which needs new IAudioFlinger and IAudioPolicyService instances
     ALOGV("clearAudioConfigCache()");
+    gQueryCache.invalidate();
     {
         Mutex::Autolock _l(gLock);
         if (gAudioFlingerClient != 0) {
@@ -2854,6 +3023,8 @@ Status AudioSystem::AudioPolicyServiceClient::onRecordingConfigurationUpdate(
 }
 
 Status AudioSystem::AudioPolicyServiceClient::onRoutingUpdated() {
+    gQueryCache.invalidate();
+
     routing_callback cb = NULL;
     {
         Mutex::Autolock _l(AudioSystem::gLock);
@@ -2890,6 +3061,7 @@ void AudioSystem::AudioPolicyServiceClient::binderDied(const wp<IBinder>& who __
         }
     }
     AudioSystem::clearAudioPolicyService();
+    gQueryCache.invalidate();
 
     ALOGW("AudioPolicyService server died!");
 }
@@ -404,6 +404,10 @@ AudioTrack::~AudioTrack()
     stopAndJoinCallbacks(); // checks mStatus
 
     if (mStatus == NO_ERROR) {
+        {
+            AutoMutex lock(mLock);
+            retractTimestampProxy_l();
+        }
         IInterface::asBinder(mAudioTrack)->unlinkToDeath(mDeathNotifier, this);
         mAudioTrack.clear();
         mCblkMemory.clear();
@@ -793,6 +797,10 @@ status_t AudioTrack::set(
     mFramesWrittenServerOffset = 0;
     mFramesWrittenAtRestore = -1; // -1 is a unique initializer.
     mVolumeHandler = new media::VolumeHandler();
+    {
+        AutoMutex lock(mLock);
+        publishTimestampProxy_l();
+    }
 
 error:
     if (status != NO_ERROR) {
@@ -895,6 +903,8 @@ status_t AudioTrack::start()
     }
     mStartNs = systemTime(); // save this for timestamp adjustment after starting.
     if (previousState == STATE_STOPPED || previousState == STATE_FLUSHED) {
+        // mFramesWrittenServerOffset and the proxy timestamp change below.
+        retractTimestampProxy_l();
         // reset current position as seen by client to 0
         mPosition = 0;
         mPreviousTimestampValid = false;
@@ -921,6 +931,7 @@ status_t AudioTrack::start()
         }
         mFramesWritten = 0;
         mProxy->clearTimestamp(); // need new server push for valid timestamp
+        publishTimestampProxy_l();
         mMarkerReached = false;
 
         // For offloaded tracks, we don't know if the hardware counters are really zero here,
@@ -1888,6 +1899,9 @@ status_t AudioTrack::createTrack_l()
     bool callbackAdded = false;
     std::string errorMessage;
 
+    // mProxy and mCblk are replaced below.
+    retractTimestampProxy_l();
+
     const sp<IAudioFlinger>& audioFlinger = AudioSystem::get_audio_flinger();
     if (audioFlinger == 0) {
         errorMessage = StringPrintf("%s(%d): Could not get audioflinger",
@@ -2016,10 +2030,14 @@ status_t AudioTrack::createTrack_l()
     // AudioFlinger now owns the reference to the I/O handle,
     // so we are no longer responsible for releasing it.
 
-    // FIXME compare to AudioRecord
-    std::optional<media::SharedFileRegion> sfr;
-    output.audioTrack->getCblk(&sfr);
-    sp<IMemory> iMem = VALUE_OR_FATAL(aidl2legacy_NullableSharedFileRegion_IMemory(sfr));
+    // The control block is returned by createTrack(), so no extra binder call is needed.
+    // Fall back to IAudioTrack::getCblk() for a server that does not return it.
+    sp<IMemory> iMem = output.cblk;
+    if (iMem == 0) {
+        std::optional<media::SharedFileRegion> sfr;
+        output.audioTrack->getCblk(&sfr);
+        iMem = VALUE_OR_FATAL(aidl2legacy_NullableSharedFileRegion_IMemory(sfr));
+    }
     if (iMem == 0) {
         errorMessage = StringPrintf("%s(%d): Could not get control block", __func__, mPortId);
         status = FAILED_TRANSACTION;
@@ -3060,6 +3078,7 @@ retry:
         mFramesWrittenServerOffset =
                 mStaticProxy.get() != nullptr ? staticPosition : mFramesWritten;
         mFramesWrittenAtRestore = mFramesWrittenServerOffset;
+        publishTimestampProxy_l();
     }
     if (result != NO_ERROR) {
         ALOGW("%s(%d): failed status %d, retries %d", __func__, mPortId, result, retries);
@@ -3202,10 +3221,55 @@ status_t AudioTrack::getTimestamp(ExtendedTimestamp *timestamp)
     if (timestamp == nullptr) {
         return BAD_VALUE;
     }
+    // Media players query the timestamp at a high rate for A/V sync; avoid mLock
+    // for the common case where the server has published a timestamp.
+    if (getTimestampLockFree(timestamp)) {
+        return OK;
+    }
     AutoMutex lock(mLock);
     return getTimestamp_l(timestamp);
 }
 
+bool AudioTrack::getTimestampLockFree(ExtendedTimestamp *timestamp)
+{
+    bool found = false;
+    mTimestampReaders.fetch_add(1);
+    const AudioTrackClientProxy *proxy = mTimestampProxy.load();
+    if (proxy != nullptr && proxy->peekTimestamp(timestamp)) {
+        const int64_t serverOffset = mTimestampServerOffset.load(std::memory_order_relaxed);
+        // same as getTimestamp_l() below.
+        timestamp->mPosition[ExtendedTimestamp::LOCATION_CLIENT] = mFramesWritten;
+        timestamp->mTimeNs[ExtendedTimestamp::LOCATION_CLIENT] = 0;
+        for (int i = ExtendedTimestamp::LOCATION_SERVER;
+                i < ExtendedTimestamp::LOCATION_MAX; ++i) {
+            if (timestamp->mTimeNs[i] >= 0) {
+                timestamp->mPosition[i] += serverOffset;
+                found = true;
+            }
+        }
+    }
+    mTimestampReaders.fetch_sub(1);
+    return found;
+}
+
+void AudioTrack::publishTimestampProxy_l()
+{
+    if (isOffloadedOrDirect_l() || mProxy == nullptr) {
+        return;
+    }
+    mTimestampServerOffset.store(mFramesWrittenServerOffset, std::memory_order_relaxed);
+    mTimestampProxy.store(mProxy.get());
+}
+
+void AudioTrack::retractTimestampProxy_l()
+{
+    mTimestampProxy.store(nullptr);
+    // readers only copy from shared memory, so this does not wait long.
+    while (mTimestampReaders.load() != 0) {
+        std::this_thread::yield();
+    }
+}
+
 status_t AudioTrack::getTimestamp_l(ExtendedTimestamp *timestamp)
 {
     if (mCblk->mFlags & CBLK_INVALID) {
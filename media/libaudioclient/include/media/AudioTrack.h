@@ -29,6 +29,7 @@
 #include <utils/threads.h>
 #include <android/content/AttributionSourceState.h>
 
+#include <atomic>
 #include <chrono>
 #include <string>
 
@@ -1062,6 +1063,10 @@ public:
             status_t getTimestamp(ExtendedTimestamp *timestamp);
 private:
             status_t getTimestamp_l(ExtendedTimestamp *timestamp);
+            // Lock-free common case of getTimestamp(ExtendedTimestamp *).  Returns true and
+            // fills in timestamp if a server timestamp was found, otherwise false and the caller
+            // must use getTimestamp_l().
+            bool     getTimestampLockFree(ExtendedTimestamp *timestamp);
 public:
 
     /* Add an AudioDeviceCallback. The caller will be notified when the audio device to which this
@@ -1223,6 +1228,13 @@ public:
             // FIXME enum is faster than strcmp() for parameter 'from'
             status_t restoreTrack_l(const char *from);
 
+            // Enable getTimestampLockFree() with the current mProxy and
+            // mFramesWrittenServerOffset, if the track uses proxy timestamps.
+            void     publishTimestampProxy_l();
+            // Disable getTimestampLockFree() and wait for concurrent readers to finish;
+            // must be called before mProxy or mFramesWrittenServerOffset is modified.
+            void     retractTimestampProxy_l();
+
             uint32_t    getUnderrunCount_l() const;
 
             bool     isOffloaded() const;
@@ -1426,6 +1438,14 @@ public:
                                                     // delivered for static tracks).
                                                     // -1 indicates no previous restore point.
 
+    // State for getTimestampLockFree(), published by publishTimestampProxy_l().
+    // mTimestampProxy is nullptr when the lock-free path is disabled; it is not a strong
+    // reference, so retractTimestampProxy_l() waits for mTimestampReaders to drop to zero
+    // before mProxy may be released.
+    std::atomic<AudioTrackClientProxy *> mTimestampProxy{nullptr};
+    std::atomic<int64_t>    mTimestampServerOffset{0}; // copy of mFramesWrittenServerOffset
+    std::atomic<int32_t>    mTimestampReaders{0};   // threads in getTimestampLockFree()
+
     audio_output_flags_t    mFlags;                 // same as mOrigFlags, except for bits that may
                                                     // be denied by client or server, such as
                                                     // AUDIO_OUTPUT_FLAG_FAST.  mLock must be
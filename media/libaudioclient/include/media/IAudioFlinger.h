@@ -121,6 +121,7 @@ public:
         audio_format_t afFormat;
         audio_io_handle_t outputId;
         audio_port_handle_t portId;
+        sp<IMemory> cblk;
         sp<media::IAudioTrack> audioTrack;
 
         ConversionResult<media::CreateTrackResponse> toAidl() const;
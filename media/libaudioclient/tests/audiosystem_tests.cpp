@@ -136,6 +136,34 @@ TEST_F(AudioSystemTest, CheckServerSideValues) {
     EXPECT_GT(AudioSystem::getPrimaryOutputFrameCount(), 0);    // fast mixer frame count
 }
 
+TEST_F(AudioSystemTest, CachedQueriesMatchServerSideValues) {
+    uint32_t samplingRate;
+    size_t frameCount;
+    ASSERT_EQ(OK, AudioSystem::getOutputSamplingRate(&samplingRate, AUDIO_STREAM_MUSIC));
+    ASSERT_EQ(OK, AudioSystem::getOutputFrameCount(&frameCount, AUDIO_STREAM_MUSIC));
+    // the second queries are answered from the client side cache
+    uint32_t samplingRateCache;
+    size_t frameCountCache;
+    EXPECT_EQ(OK, AudioSystem::getOutputSamplingRate(&samplingRateCache, AUDIO_STREAM_MUSIC));
+    EXPECT_EQ(OK, AudioSystem::getOutputFrameCount(&frameCountCache, AUDIO_STREAM_MUSIC));
+    EXPECT_EQ(samplingRate, samplingRateCache);
+    EXPECT_EQ(frameCount, frameCountCache);
+
+    EXPECT_EQ(mAF->getPrimaryOutputSamplingRate(), AudioSystem::getPrimaryOutputSamplingRate());
+    EXPECT_EQ(mAF->getPrimaryOutputSamplingRate(), AudioSystem::getPrimaryOutputSamplingRate());
+    EXPECT_EQ(mAF->getPrimaryOutputFrameCount(), AudioSystem::getPrimaryOutputFrameCount());
+    EXPECT_EQ(mAF->getPrimaryOutputFrameCount(), AudioSystem::getPrimaryOutputFrameCount());
+
+    audio_attributes_t attributes = AUDIO_ATTRIBUTES_INITIALIZER;
+    attributes.usage = AUDIO_USAGE_MEDIA;
+    AudioDeviceTypeAddrVector devices, devicesCache;
+    ASSERT_EQ(OK, AudioSystem::getDevicesForAttributes(attributes, &devices, false));
+    EXPECT_EQ(OK, AudioSystem::getDevicesForAttributes(attributes, &devicesCache, false));
+    EXPECT_EQ(devices, devicesCache);
+    EXPECT_EQ(AudioSystem::getStrategyForStream(AUDIO_STREAM_MUSIC),
+              AudioSystem::getStrategyForStream(AUDIO_STREAM_MUSIC));
+}
+
 TEST_F(AudioSystemTest, GetSetMasterVolume) {
     ASSERT_NO_FATAL_FAILURE(createPlaybackSession());
     float origVol, tstVol;
@@ -500,6 +500,8 @@ status_t StreamHalAidl::sendCommand(
     {
         std::lock_guard l(mLock);
         mLastReply = *reply;
+        mLastStatusReplyNs = command.getTag() == HalCommand::Tag::getStatus &&
+                reply->status == STATUS_OK ? systemTime() : 0;
     }
     switch (reply->status) {
         case STATUS_OK: return OK;
@@ -519,7 +521,15 @@ status_t StreamHalAidl::updateCountersIfNeeded(
         if (const auto state = getState(); state != StreamDescriptor::State::ACTIVE &&
                 state != StreamDescriptor::State::DRAINING &&
                 state != StreamDescriptor::State::TRANSFERRING) {
-            return sendCommand(makeHalCommand<HalCommand::Tag::getStatus>(), reply);
+            bool reuseStatusReply;
+            {
+                std::lock_guard l(mLock);
+                reuseStatusReply = mLastStatusReplyNs != 0 &&
+                        systemTime() - mLastStatusReplyNs < kStatusReplyReuseNs;
+            }
+            if (!reuseStatusReply) {
+                return sendCommand(makeHalCommand<HalCommand::Tag::getStatus>(), reply);
+            }
         }
     }
     if (reply != nullptr) {
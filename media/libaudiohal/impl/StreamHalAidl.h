@@ -32,6 +32,7 @@
 #include <media/audiohal/StreamHalInterface.h>
 #include <media/AidlConversionUtil.h>
 #include <media/AudioParameter.h>
+#include <utils/Timers.h>
 
 #include "ConversionHelperAidl.h"
 #include "StreamPowerLog.h"
@@ -252,10 +253,17 @@ class StreamHalAidl : public virtual StreamHalInterface, public ConversionHelper
     status_t updateCountersIfNeeded(
             ::aidl::android::hardware::audio::core::StreamDescriptor::Reply* reply = nullptr);
 
+    // Outside of the active states the counters are obtained with a 'getStatus' command.
+    // Its reply is reused by the queries following it within this time, so that the position,
+    // latency and xrun queries of one thread loop cycle share a single command exchange.
+    static constexpr nsecs_t kStatusReplyReuseNs = 2 * 1000 * 1000;
+
     const std::shared_ptr<::aidl::android::hardware::audio::core::IStreamCommon> mStream;
     const std::shared_ptr<::aidl::android::media::audio::IHalAdapterVendorExtension> mVendorExt;
     std::mutex mLock;
     ::aidl::android::hardware::audio::core::StreamDescriptor::Reply mLastReply GUARDED_BY(mLock);
+    // Time of mLastReply if it is a successful reply to 'getStatus', otherwise 0.
+    nsecs_t mLastStatusReplyNs GUARDED_BY(mLock) = 0;
     // mStreamPowerLog is used for audio signal power logging.
     StreamPowerLog mStreamPowerLog;
     std::atomic<pid_t> mWorkerTid = -1;
@@ -26,6 +26,7 @@
 #include <cutils/compiler.h>
 #include <media/AudioMixerBase.h>
 #include <utils/Log.h>
+#include <utils/Timers.h>
 
 #include "AudioMixerOps.h"
 
@@ -628,6 +629,92 @@ std::string AudioMixerBase::trackNames() const
     return ss.str();
 }
 
+void AudioMixerBase::setParallelMix(size_t workerCount, size_t minTracksPerJob,
+        int64_t deadlineNs, const std::vector<int>& cpus)
+{
+    mParallelMinTracksPerJob = std::max(minTracksPerJob, (size_t)1);
+    mParallelDeadlineNs = deadlineNs;
+    mParallelHoldoff = 0;
+    const size_t currentWorkerCount = mWorkerPool != nullptr ? mWorkerPool->workerCount() : 0;
+    if (workerCount != currentWorkerCount) {
+        mParallelGroups.clear(); // refers to the old configuration
+        mParallelJobBuffers.clear();
+        mWorkerPool.reset(workerCount > 0 ? new AudioMixerWorkerPool(workerCount, cpus) : nullptr);
+    }
+    ALOGV("%s: workerCount=%zu minTracksPerJob=%zu deadlineNs=%lld",
+            __func__, workerCount, mParallelMinTracksPerJob, (long long)deadlineNs);
+    invalidate();
+}
+
+std::string AudioMixerBase::parallelMixToString() const
+{
+    if (mWorkerPool == nullptr) {
+        return "disabled\n";
+    }
+    std::stringstream ss;
+    ss << "workers: " << mWorkerPool->workerCount()
+            << " min tracks per job: " << mParallelMinTracksPerJob
+            << " deadline(us): " << mParallelDeadlineNs / 1000
+            << " parallel cycles: " << mParallelCycles.load(std::memory_order_relaxed)
+            << " fallbacks: " << mParallelFallbacks.load(std::memory_order_relaxed)
+            << "\n";
+    ss << mWorkerPool->toString();
+    return ss.str();
+}
+
+void AudioMixerBase::validateParallel()
+{
+    mParallelGroups.clear();
+    if (mWorkerPool == nullptr
+            || (mHook != &AudioMixerBase::process__genericResampling
+                    && mHook != &AudioMixerBase::process__genericNoResampling)) {
+        return;
+    }
+
+    // A resampled track costs roughly twice as much as a track that is not resampled.
+    static constexpr size_t kResampleWeight = 2;
+    const size_t maxJobs = mWorkerPool->workerCount() + 1;
+    bool split = false;
+    for (const auto &pair : mGroups) {
+        const auto &group = pair.second;
+        ParallelGroup &parallelGroup = mParallelGroups.emplace_back();
+        parallelGroup.mainBuffer = pair.first;
+        parallelGroup.leader = mTracks[group[0]].get();
+        const size_t jobCount =
+                std::max(std::min(maxJobs, group.size() / mParallelMinTracksPerJob), (size_t)1);
+        parallelGroup.jobs.resize(jobCount);
+
+        // greedy assignment of each track to the least loaded job.
+        std::vector<size_t> weights(jobCount);
+        for (const int name : group) {
+            TrackBase * const t = mTracks[name].get();
+            size_t job = 0;
+            // Tracks with an aux send accumulate into a shared aux buffer,
+            // so they are mixed sequentially on the calling thread.
+            if ((t->needs & NEEDS_AUX) == 0) {
+                job = std::min_element(weights.begin(), weights.end()) - weights.begin();
+            }
+            parallelGroup.jobs[job].push_back(t);
+            weights[job] += (t->needs & NEEDS_RESAMPLE) ? kResampleWeight : 1;
+        }
+        split |= jobCount > 1;
+    }
+    if (!split) {
+        mParallelGroups.clear();
+        return;
+    }
+
+    if (mParallelJobBuffers.size() != maxJobs) {
+        mParallelJobBuffers.resize(maxJobs);
+        for (auto &buffers : mParallelJobBuffers) {
+            buffers.outTemp.reset(new int32_t[MAX_NUM_CHANNELS * mFrameCount]);
+            buffers.resampleTemp.reset(new int32_t[MAX_NUM_CHANNELS * mFrameCount]);
+        }
+    }
+    mInlineHook = mHook;
+    mHook = &AudioMixerBase::process__parallel;
+}
+
 void AudioMixerBase::process__validate()
 {
     // TODO: fix all16BitsStereNoResample logic to
@@ -745,6 +832,7 @@ void AudioMixerBase::process__validate()
             }
         }
     }
+    validateParallel();
 
     ALOGV("mixer configuration change: %zu "
         "all16BitsStereoNoResample=%d, resampling=%d, volumeRamp=%d",
@@ -1195,41 +1283,102 @@ void AudioMixerBase::process__genericResampling()
         // clear temp buffer
         memset(outTemp, 0, sizeof(*outTemp) * t1->mMixerChannelCount * mFrameCount);
         for (const int name : group) {
-            const std::shared_ptr<TrackBase> &t = mTracks[name];
-            int32_t *aux = NULL;
-            if (CC_UNLIKELY(t->needs & NEEDS_AUX)) {
-                aux = t->auxBuffer;
-            }
+            mixTrack(mTracks[name].get(), outTemp, mResampleTemp.get() /* naked ptr */);
+        }
+        convertMixerFormat(t1->mainBuffer, t1->mMixerFormat,
+                outTemp, t1->mMixerInFormat, numFrames * t1->mMixerChannelCount);
+    }
+}
 
-            // this is a little goofy, on the resampling case we don't
-            // acquire/release the buffers because it's done by
-            // the resampler.
-            if (t->needs & NEEDS_RESAMPLE) {
-                (t.get()->*t->hook)(outTemp, numFrames, mResampleTemp.get() /* naked ptr */, aux);
-            } else {
+void AudioMixerBase::mixTrack(TrackBase *t, int32_t *out, int32_t *resampleTemp)
+{
+    const size_t numFrames = mFrameCount;
+    int32_t *aux = NULL;
+    if (CC_UNLIKELY(t->needs & NEEDS_AUX)) {
+        aux = t->auxBuffer;
+    }
 
-                size_t outFrames = 0;
+    // this is a little goofy, on the resampling case we don't
+    // acquire/release the buffers because it's done by
+    // the resampler.
+    if (t->needs & NEEDS_RESAMPLE) {
+        (t->*t->hook)(out, numFrames, resampleTemp, aux);
+    } else {
 
-                while (outFrames < numFrames) {
-                    t->buffer.frameCount = numFrames - outFrames;
-                    t->bufferProvider->getNextBuffer(&t->buffer);
-                    t->mIn = t->buffer.raw;
-                    // t->mIn == nullptr can happen if the track was flushed just after having
-                    // been enabled for mixing.
-                    if (t->mIn == nullptr) break;
+        size_t outFrames = 0;
+
+        while (outFrames < numFrames) {
+            t->buffer.frameCount = numFrames - outFrames;
+            t->bufferProvider->getNextBuffer(&t->buffer);
+            t->mIn = t->buffer.raw;
+            // t->mIn == nullptr can happen if the track was flushed just after having
+            // been enabled for mixing.
+            if (t->mIn == nullptr) break;
+
+            (t->*t->hook)(
+                    out + outFrames * t->mMixerChannelCount, t->buffer.frameCount,
+                    resampleTemp,
+                    aux != nullptr ? aux + outFrames : nullptr);
+            outFrames += t->buffer.frameCount;
+
+            t->bufferProvider->releaseBuffer(&t->buffer);
+        }
+    }
+}
 
-                    (t.get()->*t->hook)(
-                            outTemp + outFrames * t->mMixerChannelCount, t->buffer.frameCount,
-                            mResampleTemp.get() /* naked ptr */,
-                            aux != nullptr ? aux + outFrames : nullptr);
-                    outFrames += t->buffer.frameCount;
+// parallel code, tracks of large groups are mixed into per job buffers then summed.
+void AudioMixerBase::process__parallel()
+{
+    ALOGVV("process__parallel\n");
+    if (mParallelHoldoff > 0) {
+        // a recent parallel cycle missed the deadline, mix inline for a while.
+        --mParallelHoldoff;
+        (this->*mInlineHook)();
+        return;
+    }
 
-                    t->bufferProvider->releaseBuffer(&t->buffer);
+    const nsecs_t startNs = systemTime();
+    for (const auto &group : mParallelGroups) {
+        const TrackBase * const t1 = group.leader;
+        const size_t sampleCount = t1->mMixerChannelCount * mFrameCount;
+        auto mixJob = [this, &group, sampleCount](size_t index) {
+            ParallelJobBuffers &buffers = mParallelJobBuffers[index];
+            int32_t * const out = buffers.outTemp.get();
+            memset(out, 0, sizeof(*out) * sampleCount);
+            for (TrackBase * const t : group.jobs[index]) {
+                mixTrack(t, out, buffers.resampleTemp.get());
+            }
+        };
+        mWorkerPool->run(group.jobs.size(), mixJob);
+
+        // reduction: all tracks of a group share the same mixer internal format.
+        int32_t * const sum = mParallelJobBuffers[0].outTemp.get();
+        for (size_t i = 1; i < group.jobs.size(); ++i) {
+            if (group.jobs[i].empty()) continue;
+            const int32_t * const in = mParallelJobBuffers[i].outTemp.get();
+            if (t1->mMixerInFormat == AUDIO_FORMAT_PCM_FLOAT) {
+                float * const fsum = reinterpret_cast<float *>(sum);
+                const float * const fin = reinterpret_cast<const float *>(in);
+                for (size_t j = 0; j < sampleCount; ++j) {
+                    fsum[j] += fin[j];
+                }
+            } else {
+                for (size_t j = 0; j < sampleCount; ++j) {
+                    sum[j] += in[j];
                 }
             }
         }
-        convertMixerFormat(t1->mainBuffer, t1->mMixerFormat,
-                outTemp, t1->mMixerInFormat, numFrames * t1->mMixerChannelCount);
+        convertMixerFormat(group.mainBuffer, t1->mMixerFormat,
+                sum, t1->mMixerInFormat, sampleCount);
+    }
+
+    const nsecs_t elapsedNs = systemTime() - startNs;
+    mParallelCycles.fetch_add(1, std::memory_order_relaxed);
+    if (mParallelDeadlineNs > 0 && elapsedNs > mParallelDeadlineNs) {
+        ALOGV("%s: parallel mix took %lld ns, deadline %lld ns, falling back to inline",
+                __func__, (long long)elapsedNs, (long long)mParallelDeadlineNs);
+        mParallelFallbacks.fetch_add(1, std::memory_order_relaxed);
+        mParallelHoldoff = kParallelHoldoffCycles;
     }
 }
 
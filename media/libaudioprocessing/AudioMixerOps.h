@@ -21,6 +21,8 @@
 #include <audio_utils/primitives.h>
 #include <system/audio.h>
 
+#include "AudioMixerOpsSimd.h"
+
 namespace android {
 
 // Hack to make static_assert work in a constexpr
@@ -372,6 +374,126 @@ void stereoVolumeHelper(TO*& out, const TI*& in, const TV *vol, F f) {
     stereoVolumeHelperWithChannelMask<MIXTYPE, MASK, TO, TI, TV, F>(out, in, vol, f);
 }
 
+// compile-time function.
+// Returns the stereo volume index applied to the channelIdx-th channel present in mask,
+// 0 for left, 1 for right and 2 for center (mean of left and right).
+// This must match the channel position assignment in stereoVolumeHelperWithChannelMask().
+constexpr inline int stereoVolumeIndex(audio_channel_mask_t mask, size_t channelIdx) {
+    using namespace audio_utils::channels;
+    constexpr unsigned LFE_LFE2 =
+             AUDIO_CHANNEL_OUT_LOW_FREQUENCY | AUDIO_CHANNEL_OUT_LOW_FREQUENCY_2;
+    const bool has_LFE_LFE2 = (mask & LFE_LFE2) == LFE_LFE2;
+    for (size_t i = 0; i < std::size(kSideFromChannelIdx); ++i) {
+        if ((mask & (1 << i)) == 0) continue;
+        if (channelIdx-- != 0) continue;
+        const auto side = kSideFromChannelIdx[i];
+        if (side == AUDIO_GEOMETRY_SIDE_LEFT
+                || (has_LFE_LFE2 && (1 << i) == AUDIO_CHANNEL_OUT_LOW_FREQUENCY)) {
+            return 0;
+        } else if (side == AUDIO_GEOMETRY_SIDE_RIGHT
+                || (has_LFE_LFE2 && (1 << i) == AUDIO_CHANNEL_OUT_LOW_FREQUENCY_2)) {
+            return 1;
+        }
+        return 2;
+    }
+    return 2;
+}
+
+/*
+ * useMixerOpsSimd() selects the explicit SIMD implementation (see AudioMixerOpsSimd.h)
+ * of volumeRampMulti and volumeMulti at compile time.
+ *
+ * Only the float output path with float volume is accelerated, for float or int16_t input,
+ * and for the MIXTYPEs that apply one volume per output channel with an identical input
+ * and output channel count (MONOVOL and STEREOVOL).  Everything else uses the scalar code.
+ */
+template <int MIXTYPE, int NCHAN,
+        typename TO, typename TI, typename TV, typename TA, typename TAV>
+constexpr inline bool useMixerOpsSimd() {
+    if constexpr (!kMixerOpsSimd
+            || !std::is_same_v<TO, float>
+            || !std::is_same_v<std::remove_const_t<TV>, float>
+            || !(std::is_same_v<TI, float> || std::is_same_v<TI, int16_t>)
+            || !std::is_same_v<TA, float>
+            || !std::is_same_v<std::remove_const_t<TAV>, float>) {
+        return false;
+    } else if constexpr (MIXTYPE == MIXTYPE_MULTI_MONOVOL
+            || MIXTYPE == MIXTYPE_MULTI_SAVEONLY_MONOVOL) {
+        return NCHAN > 0 && NCHAN <= FCC_LIMIT;
+    } else if constexpr (MIXTYPE == MIXTYPE_MULTI_STEREOVOL
+            || MIXTYPE == MIXTYPE_MULTI_SAVEONLY_STEREOVOL) {
+        return NCHAN > 0 && NCHAN <= FCC_LIMIT
+                && canonicalChannelMaskFromCount(NCHAN) != AUDIO_CHANNEL_NONE;
+    } else {
+        return false;
+    }
+}
+
+#if MIXER_OPS_USE_NEON || MIXER_OPS_USE_SSE
+
+/*
+ * SIMD version of volumeRampMulti (RAMP true) and volumeMulti (RAMP false)
+ * for the configurations accepted by useMixerOpsSimd().
+ *
+ * The output is identical to the scalar version for constant volume.  With a volume ramp
+ * the per frame volume is computed as vol + frame * volinc instead of by accumulation,
+ * which may differ in the last bit; the final vol and vola state is accumulated as in
+ * the scalar version.
+ */
+template <int MIXTYPE, int NCHAN, bool RAMP, typename TI>
+inline void volumeMultiSimd(float* out, size_t frameCount,
+        const TI* in, float* aux, float *vol, const float *volinc, float *vola, float volainc)
+{
+    constexpr bool ACCUMULATE = MIXTYPE == MIXTYPE_MULTI_MONOVOL
+            || MIXTYPE == MIXTYPE_MULTI_STEREOVOL;
+    constexpr bool MONOVOL = MIXTYPE == MIXTYPE_MULTI_MONOVOL
+            || MIXTYPE == MIXTYPE_MULTI_SAVEONLY_MONOVOL;
+    constexpr audio_channel_mask_t MASK{canonicalChannelMaskFromCount(NCHAN)};
+
+    // The aux send is the mean of the input channels, prior to volume, scaled by vola.
+    if (aux != NULL) {
+        const TI *auxin = in;
+        for (size_t i = 0; i < frameCount; ++i) {
+            float auxaccum = 0;
+            for (int j = 0; j < NCHAN; ++j) {
+                MixAccum<float, TI>(&auxaccum, *auxin++);
+            }
+            auxaccum /= NCHAN;
+            *aux++ += MixMul<float, float, float>(auxaccum, *vola);
+            if constexpr (RAMP) {
+                *vola += volainc;
+            }
+        }
+    }
+
+    // Q0.15 normalization is a power of 2, so folding it into the gain is exact.
+    constexpr float norm = std::is_same_v<TI, int16_t> ? 1.f / (1 << 15) : 1.f;
+    float gain[NCHAN];
+    float gainInc[NCHAN];
+    for (int j = 0; j < NCHAN; ++j) {
+        const int index = MONOVOL ? 0 : stereoVolumeIndex(MASK, j);
+        if (index == 2) {
+            gain[j] = (vol[0] + vol[1]) * 0.5f * norm;
+            gainInc[j] = RAMP ? (volinc[0] + volinc[1]) * 0.5f * norm : 0.f;
+        } else {
+            gain[j] = vol[index] * norm;
+            gainInc[j] = RAMP ? volinc[index] * norm : 0.f;
+        }
+    }
+    mixVolumeSimd<NCHAN, ACCUMULATE, RAMP>(out, frameCount, in, gain, gainInc);
+
+    if constexpr (RAMP) {
+        for (size_t i = 0; i < frameCount; ++i) {
+            vol[0] += volinc[0];
+            if constexpr (!MONOVOL) {
+                vol[1] += volinc[1];
+            }
+        }
+    }
+}
+
+#endif // MIXER_OPS_USE_NEON || MIXER_OPS_USE_SSE
+
 /*
  * The volumeRampMulti and volumeRamp functions take a MIXTYPE
  * which indicates the per-frame mixing and accumulation strategy.
@@ -435,6 +557,13 @@ inline void volumeRampMulti(TO* out, size_t frameCount,
 {
 #ifdef ALOGVV
     ALOGVV("volumeRampMulti, MIXTYPE:%d\n", MIXTYPE);
+#endif
+#if MIXER_OPS_USE_NEON || MIXER_OPS_USE_SSE
+    if constexpr (useMixerOpsSimd<MIXTYPE, NCHAN, TO, TI, TV, TA, TAV>()) {
+        volumeMultiSimd<MIXTYPE, NCHAN, true /* RAMP */>(
+                out, frameCount, in, aux, vol, volinc, vola, volainc);
+        return;
+    }
 #endif
     if (aux != NULL) {
         do {
@@ -529,6 +658,14 @@ inline void volumeMulti(TO* out, size_t frameCount,
 {
 #ifdef ALOGVV
     ALOGVV("volumeMulti MIXTYPE:%d\n", MIXTYPE);
+#endif
+#if MIXER_OPS_USE_NEON || MIXER_OPS_USE_SSE
+    if constexpr (useMixerOpsSimd<MIXTYPE, NCHAN, TO, TI, TV, TA, TAV>()) {
+        // the volume is not modified without RAMP.
+        volumeMultiSimd<MIXTYPE, NCHAN, false /* RAMP */>(out, frameCount, in, aux,
+                const_cast<float *>(vol), nullptr /* volinc */, &vola, 0.f /* volainc */);
+        return;
+    }
 #endif
     if (aux != NULL) {
         do {
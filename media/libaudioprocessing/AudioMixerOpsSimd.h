@@ -0,0 +1,170 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_AUDIO_MIXER_OPS_SIMD_H
+#define ANDROID_AUDIO_MIXER_OPS_SIMD_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Explicit SIMD kernels for the float output volume helpers in AudioMixerOps.h.
+//
+// To disable for benchmarking, compile with -DUSE_NEON=false (arm) or -DUSE_SSE=false (x86),
+// as for the resampler in AudioResamplerFirOps.h.
+
+#if (defined(__aarch64__) || defined(__ARM_NEON__)) && !(defined(USE_NEON) && !USE_NEON)
+#define MIXER_OPS_USE_NEON (true)
+#include <arm_neon.h>
+#else
+#define MIXER_OPS_USE_NEON (false)
+#endif
+
+#if defined(__SSE2__) && !(defined(USE_SSE) && !USE_SSE)
+#define MIXER_OPS_USE_SSE (true)
+#include <immintrin.h>
+#else
+#define MIXER_OPS_USE_SSE (false)
+#endif
+
+namespace android {
+
+#if MIXER_OPS_USE_NEON
+
+using mixvec_t = float32x4_t;
+constexpr size_t kMixVecWidth = 4;
+
+inline mixvec_t mixvec_load(const float *p) { return vld1q_f32(p); }
+inline mixvec_t mixvec_load(const int16_t *p) {
+    return vcvtq_f32_s32(vmovl_s16(vld1_s16(p)));
+}
+inline void mixvec_store(float *p, mixvec_t v) { vst1q_f32(p, v); }
+// multiply and add are kept separate (no fused multiply-add) to match the scalar code.
+inline mixvec_t mixvec_mul(mixvec_t a, mixvec_t b) { return vmulq_f32(a, b); }
+inline mixvec_t mixvec_add(mixvec_t a, mixvec_t b) { return vaddq_f32(a, b); }
+
+#elif MIXER_OPS_USE_SSE && defined(__AVX2__)
+
+using mixvec_t = __m256;
+constexpr size_t kMixVecWidth = 8;
+
+inline mixvec_t mixvec_load(const float *p) { return _mm256_loadu_ps(p); }
+inline mixvec_t mixvec_load(const int16_t *p) {
+    return _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(
+            _mm_loadu_si128(reinterpret_cast<const __m128i *>(p))));
+}
+inline void mixvec_store(float *p, mixvec_t v) { _mm256_storeu_ps(p, v); }
+inline mixvec_t mixvec_mul(mixvec_t a, mixvec_t b) { return _mm256_mul_ps(a, b); }
+inline mixvec_t mixvec_add(mixvec_t a, mixvec_t b) { return _mm256_add_ps(a, b); }
+
+#elif MIXER_OPS_USE_SSE
+
+using mixvec_t = __m128;
+constexpr size_t kMixVecWidth = 4;
+
+inline mixvec_t mixvec_load(const float *p) { return _mm_loadu_ps(p); }
+inline mixvec_t mixvec_load(const int16_t *p) {
+    // SSE2 only: sign extend by unpacking into the high half and arithmetic shift.
+    const __m128i x = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(p));
+    return _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16));
+}
+inline void mixvec_store(float *p, mixvec_t v) { _mm_storeu_ps(p, v); }
+inline mixvec_t mixvec_mul(mixvec_t a, mixvec_t b) { return _mm_mul_ps(a, b); }
+inline mixvec_t mixvec_add(mixvec_t a, mixvec_t b) { return _mm_add_ps(a, b); }
+
+#endif
+
+constexpr bool kMixerOpsSimd = MIXER_OPS_USE_NEON || MIXER_OPS_USE_SSE;
+
+#if MIXER_OPS_USE_NEON || MIXER_OPS_USE_SSE
+
+/*
+ * Interleaved multichannel volume kernel:
+ *
+ *   out[f * NCHAN + c] (+)= in[f * NCHAN + c] * (gain[c] + f * gainInc[c])
+ *
+ * for 0 <= f < frameCount.  gainInc is only used if RAMP is true.
+ *
+ * Any NCHAN is handled without shuffles: kMixVecWidth frames of NCHAN channels are exactly
+ * NCHAN vectors, and the per-lane gains for those NCHAN vectors repeat every kMixVecWidth frames.
+ * Input of type int16_t is converted to float; the caller folds the Q0.15 normalization
+ * into the gain.
+ */
+template <int NCHAN, bool ACCUMULATE, bool RAMP, typename TI>
+inline void mixVolumeSimd(float *out, size_t frameCount, const TI *in,
+        const float *gain, const float *gainInc)
+{
+    constexpr size_t W = kMixVecWidth;
+    constexpr size_t BLOCK = NCHAN * W; // samples per block of W frames
+
+    // per sample gains for the current block, and their increment for the next block.
+    float blockGain[BLOCK] __attribute__((aligned(32)));
+    float blockInc[BLOCK] __attribute__((aligned(32)));
+    for (size_t s = 0; s < BLOCK; ++s) {
+        const size_t c = s % NCHAN;
+        if constexpr (RAMP) {
+            blockGain[s] = gain[c] + (s / NCHAN) * gainInc[c];
+            blockInc[s] = W * gainInc[c];
+        } else {
+            blockGain[s] = gain[c];
+        }
+    }
+
+    mixvec_t g[NCHAN];
+    mixvec_t ginc[NCHAN];
+    for (size_t k = 0; k < NCHAN; ++k) {
+        g[k] = mixvec_load(blockGain + k * W);
+        if constexpr (RAMP) {
+            ginc[k] = mixvec_load(blockInc + k * W);
+        }
+    }
+
+    size_t frames = frameCount;
+    for (; frames >= W; frames -= W) {
+        for (size_t k = 0; k < NCHAN; ++k) {
+            mixvec_t v = mixvec_mul(mixvec_load(in), g[k]);
+            if constexpr (ACCUMULATE) {
+                v = mixvec_add(mixvec_load(out), v);
+            }
+            mixvec_store(out, v);
+            if constexpr (RAMP) {
+                g[k] = mixvec_add(g[k], ginc[k]);
+            }
+            in += W;
+            out += W;
+        }
+    }
+
+    // remaining frames (< W) use the gains of the next block, sample by sample.
+    if (frames > 0) {
+        for (size_t k = 0; k < NCHAN; ++k) {
+            mixvec_store(blockGain + k * W, g[k]);
+        }
+        for (size_t s = 0; s < frames * NCHAN; ++s) {
+            const float v = static_cast<float>(in[s]) * blockGain[s];
+            if constexpr (ACCUMULATE) {
+                out[s] += v;
+            } else {
+                out[s] = v;
+            }
+        }
+    }
+}
+
+#endif // MIXER_OPS_USE_NEON || MIXER_OPS_USE_SSE
+
+} // namespace android
+
+#endif /* ANDROID_AUDIO_MIXER_OPS_SIMD_H */
@@ -0,0 +1,160 @@
+/*
+**
+** Copyright 2023, The Android Open Source Project
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+#define LOG_TAG "AudioMixerWorkerPool"
+//#define LOG_NDEBUG 0
+
+#include <algorithm>
+#include <sched.h>
+#include <sstream>
+
+#include <media/AudioMixerWorkerPool.h>
+#include <utils/Log.h>
+#include <utils/ThreadDefs.h>
+#include <utils/Timers.h>
+#include <utils/threads.h>
+
+namespace android {
+
+AudioMixerWorkerPool::AudioMixerWorkerPool(size_t workerCount, const std::vector<int>& cpus)
+{
+    mWorkers.reserve(workerCount);
+    for (size_t i = 0; i < workerCount; ++i) {
+        auto worker = std::make_unique<Worker>();
+        worker->cpu = cpus.empty() ? -1 : cpus[i % cpus.size()];
+        mWorkers.emplace_back(std::move(worker));
+    }
+    // start threads only after mWorkers is fully built, so that no worker observes
+    // the vector while it is being resized.
+    for (size_t i = 0; i < mWorkers.size(); ++i) {
+        mWorkers[i]->thread = std::thread(
+                &AudioMixerWorkerPool::threadLoop, this, i, mWorkers[i]->cpu);
+    }
+}
+
+AudioMixerWorkerPool::~AudioMixerWorkerPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mLock);
+        mExit = true;
+    }
+    mWorkCv.notify_all();
+    for (auto &worker : mWorkers) {
+        worker->thread.join();
+    }
+}
+
+void AudioMixerWorkerPool::Stats::add(int64_t ns)
+{
+    // Single writer per Stats instance; atomics only make the values safe to dump.
+    count.store(count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    lastNs.store(ns, std::memory_order_relaxed);
+    totalNs.store(totalNs.load(std::memory_order_relaxed) + ns, std::memory_order_relaxed);
+    if (ns > maxNs.load(std::memory_order_relaxed)) {
+        maxNs.store(ns, std::memory_order_relaxed);
+    }
+}
+
+void AudioMixerWorkerPool::runJobs(size_t jobCount, job_fn_t fn, void *cookie)
+{
+    jobCount = std::min(jobCount, mWorkers.size() + 1);
+    if (jobCount == 0) return;
+    if (jobCount > 1) {
+        {
+            std::lock_guard<std::mutex> lock(mLock);
+            mFn = fn;
+            mCookie = cookie;
+            mJobCount = jobCount;
+            mPending = jobCount - 1;
+            ++mGeneration;
+        }
+        mWorkCv.notify_all();
+    }
+
+    const nsecs_t start = systemTime();
+    fn(cookie, 0 /* index */);
+    const nsecs_t callerDone = systemTime();
+    mCallerStats.add(callerDone - start);
+
+    if (jobCount > 1) {
+        std::unique_lock<std::mutex> lock(mLock);
+        mDoneCv.wait(lock, [this] { return mPending == 0; });
+        lock.unlock();
+        mWaitStats.add(systemTime() - callerDone);
+    }
+}
+
+void AudioMixerWorkerPool::threadLoop(size_t index, int cpu)
+{
+    if (cpu >= 0) {
+        cpu_set_t cpuSet;
+        CPU_ZERO(&cpuSet);
+        CPU_SET(cpu, &cpuSet);
+        if (sched_setaffinity(0 /* pid */, sizeof(cpuSet), &cpuSet) != 0) {
+            ALOGW("%s: worker %zu cannot be pinned to cpu %d", __func__, index, cpu);
+        }
+    }
+    androidSetThreadPriority(0 /* tid (0 = current) */, ANDROID_PRIORITY_URGENT_AUDIO);
+
+    Worker &worker = *mWorkers[index];
+    const size_t jobIndex = index + 1; // job 0 runs on the calling thread
+    uint64_t generation = 0;
+    std::unique_lock<std::mutex> lock(mLock);
+    for (;;) {
+        mWorkCv.wait(lock, [this, generation] { return mExit || mGeneration != generation; });
+        if (mExit) return;
+        generation = mGeneration;
+        if (jobIndex >= mJobCount) continue;
+        const job_fn_t fn = mFn;
+        void * const cookie = mCookie;
+        lock.unlock();
+
+        const nsecs_t start = systemTime();
+        fn(cookie, jobIndex);
+        worker.stats.add(systemTime() - start);
+
+        lock.lock();
+        if (--mPending == 0) {
+            mDoneCv.notify_one();
+        }
+    }
+}
+
+std::string AudioMixerWorkerPool::toString() const
+{
+    std::stringstream ss;
+    const auto dumpStats = [&ss](const char *name, const Stats &stats) {
+        const int64_t count = stats.count.load(std::memory_order_relaxed);
+        const int64_t total = stats.totalNs.load(std::memory_order_relaxed);
+        ss << "    " << name
+                << " count: " << count
+                << " last(us): " << stats.lastNs.load(std::memory_order_relaxed) / 1000
+                << " mean(us): " << (count > 0 ? total / count / 1000 : 0)
+                << " max(us): " << stats.maxNs.load(std::memory_order_relaxed) / 1000
+                << "\n";
+    };
+    dumpStats("caller", mCallerStats);
+    dumpStats("join wait", mWaitStats);
+    for (size_t i = 0; i < mWorkers.size(); ++i) {
+        const std::string name = "worker " + std::to_string(i)
+                + " (cpu " + std::to_string(mWorkers[i]->cpu) + ")";
+        dumpStats(name.c_str(), mWorkers[i]->stats);
+    }
+    return ss.str();
+}
+
+}  // namespace android
@@ -23,6 +23,10 @@
 #include <dlfcn.h>
 #include <math.h>
 
+#include <map>
+#include <mutex>
+#include <tuple>
+
 #include <cutils/compiler.h>
 #include <cutils/properties.h>
 #include <utils/Log.h>
@@ -181,8 +185,7 @@ template<typename TC, typename TI, typename TO>
 AudioResamplerDyn<TC, TI, TO>::AudioResamplerDyn(
         int inChannelCount, int32_t sampleRate, src_quality quality)
     : AudioResampler(inChannelCount, sampleRate, quality),
-      mResampleFunc(0), mFilterSampleRate(0), mFilterQuality(DEFAULT_QUALITY),
-    mCoefBuffer(NULL)
+      mResampleFunc(0), mFilterSampleRate(0), mFilterQuality(DEFAULT_QUALITY)
 {
     mVolumeSimd[0] = mVolumeSimd[1] = 0;
     // The AudioResampler base class assumes we are always ready for 1:1 resampling.
@@ -207,7 +210,6 @@ AudioResamplerDyn<TC, TI, TO>::AudioResamplerDyn(
 template<typename TC, typename TI, typename TO>
 AudioResamplerDyn<TC, TI, TO>::~AudioResamplerDyn()
 {
-    free(mCoefBuffer);
 }
 
 template<typename TC, typename TI, typename TO>
@@ -238,6 +240,82 @@ template<typename T> T max(T a, T b) {return a > b ? a : b;}
 
 template<typename T> T absdiff(T a, T b) {return a > b ? a - b : b - a;}
 
+/* KaiserFirCache is a process-wide cache of polyphase filter banks.
+ *
+ * Tracks at common rates (e.g. 44.1kHz to 48kHz) are resampled with identical filters,
+ * so each filter bank is designed once and shared by reference count instead of
+ * being rebuilt and stored per track.  The cache holds weak references only:
+ * a filter bank is freed when the last resampler using it is destroyed or redesigned.
+ *
+ * The key is the complete firKaiserGen() design, which is a function of the
+ * input rate, output rate and quality; there is one cache per coefficient type TC.
+ */
+template<typename TC>
+class KaiserFirCache {
+public:
+    using Key = std::tuple<int /* phases */, int /* halfLength */,
+            double /* stopBandAtten */, double /* fcr */, double /* attenuation */>;
+
+    static std::shared_ptr<const TC> get(const Key& key) {
+        Cache& cache = getCache();
+        {
+            std::lock_guard<std::mutex> lock(cache.mLock);
+            auto it = cache.mFilters.find(key);
+            if (it != cache.mFilters.end()) {
+                std::shared_ptr<const TC> coefs = it->second.lock();
+                if (coefs != nullptr) {
+                    ALOGV("%s: reusing filter phases:%d halfLength:%d",
+                            __func__, std::get<0>(key), std::get<1>(key));
+                    return coefs;
+                }
+            }
+        }
+
+        // design outside of the lock, filter generation may take several milliseconds.
+        std::shared_ptr<const TC> coefs = design(key);
+
+        std::lock_guard<std::mutex> lock(cache.mLock);
+        std::weak_ptr<const TC>& entry = cache.mFilters[key];
+        std::shared_ptr<const TC> existing = entry.lock();
+        if (existing != nullptr) {
+            return existing; // another resampler designed the same filter concurrently.
+        }
+        entry = coefs;
+        // prune filters that are no longer in use.
+        for (auto it = cache.mFilters.begin(); it != cache.mFilters.end(); ) {
+            if (it->second.expired()) {
+                it = cache.mFilters.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        return coefs;
+    }
+
+private:
+    struct Cache {
+        std::mutex mLock;
+        std::map<Key, std::weak_ptr<const TC>> mFilters; // guarded by mLock
+    };
+
+    static Cache& getCache() {
+        static Cache cache;
+        return cache;
+    }
+
+    static std::shared_ptr<const TC> design(const Key& key) {
+        const auto [phases, halfLength, stopBandAtten, fcr, attenuation] = key;
+        TC *coefs = nullptr;
+        int ret = posix_memalign(
+                reinterpret_cast<void **>(&coefs),
+                CACHE_LINE_SIZE /* alignment */,
+                (phases + 1) * halfLength * sizeof(TC));
+        LOG_ALWAYS_FATAL_IF(ret != 0, "Cannot allocate buffer memory, ret %d", ret);
+        firKaiserGen(coefs, phases, halfLength, stopBandAtten, fcr, attenuation);
+        return std::shared_ptr<const TC>(coefs, [](const TC *p) { free(const_cast<TC *>(p)); });
+    }
+};
+
 template<typename TC, typename TI, typename TO>
 void AudioResamplerDyn<TC, TI, TO>::createKaiserFir(Constants &c,
         double stopBandAtten, int inSampleRate, int outSampleRate, double tbwCheat)
@@ -263,24 +341,15 @@ void AudioResamplerDyn<TC, TI, TO>::createKaiserFir(Constants &c,
     const int phases = c.mL;
     const int halfLength = c.mHalfNumCoefs;
 
-    // create buffer
-    TC *coefs = nullptr;
-    int ret = posix_memalign(
-            reinterpret_cast<void **>(&coefs),
-            CACHE_LINE_SIZE /* alignment */,
-            (phases + 1) * halfLength * sizeof(TC));
-    LOG_ALWAYS_FATAL_IF(ret != 0, "Cannot allocate buffer memory, ret %d", ret);
-    c.mFirCoefs = coefs;
-    free(mCoefBuffer);
-    mCoefBuffer = coefs;
-
     // square the computed minimum passband value (extra safety).
     double attenuation =
             computeWindowedSincMinimumPassbandValue(stopBandAtten);
     attenuation *= attenuation;
 
-    // design filter
-    firKaiserGen(coefs, phases, halfLength, stopBandAtten, fcr, attenuation);
+    // design filter, or share an identical one designed for another resampler.
+    mCoefBuffer = KaiserFirCache<TC>::get(
+            {phases, halfLength, stopBandAtten, fcr, attenuation});
+    c.mFirCoefs = mCoefBuffer.get();
 
     // update the design criteria
     mNormalizedCutoffFrequency = fcr;
@@ -306,7 +375,8 @@ void AudioResamplerDyn<TC, TI, TO>::createKaiserFir(Constants &c,
 
     const int32_t passSteps = 1000;
 
-    testFir(coefs, c.mL, c.mHalfNumCoefs, fp, fs, passSteps, passSteps * c.mL /*stopSteps*/,
+    testFir(c.mFirCoefs, c.mL, c.mHalfNumCoefs, fp, fs,
+            passSteps, passSteps * c.mL /*stopSteps*/,
             passMin, passMax, passRipple, stopMax, stopRipple);
     ALOGD("passband(%lf, %lf): %.8lf %.8lf %.8lf\n", 0., fp, passMin, passMax, passRipple);
     ALOGD("stopband(%lf, %lf): %.8lf %.3lf\n", fs, 0.5, stopMax, stopRipple);
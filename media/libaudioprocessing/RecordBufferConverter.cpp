@@ -37,6 +37,77 @@ static inline T max(const T& a, const T& b)
 
 namespace android {
 
+// Fused conversion kernels.
+// The channel counts are compile-time constants so that the compiler can vectorize the loops.
+// Each kernel uses the same sample conversions as the audio_utils functions of the generic path,
+// float_from_i16() and clamp16_from_float(), so the results are bit exact.
+
+template <typename T>
+static inline T sampleFromFloat(float f);
+
+template <>
+inline float sampleFromFloat<float>(float f) { return f; }
+
+template <>
+inline int16_t sampleFromFloat<int16_t>(float f) { return clamp16_from_float(f); }
+
+template <typename TO, typename TI>
+static inline TO convertSample(TI sample);
+
+template <>
+inline float convertSample<float, int16_t>(int16_t sample) { return float_from_i16(sample); }
+
+template <>
+inline int16_t convertSample<int16_t, float>(float sample) { return clamp16_from_float(sample); }
+
+template <>
+inline float convertSample<float, float>(float sample) { return sample; }
+
+template <>
+inline int16_t convertSample<int16_t, int16_t>(int16_t sample) { return sample; }
+
+// Replaces: ReformatBufferProvider to float, downmix_to_mono_float_from_stereo_float(),
+// and the copy out of the staging buffer.
+// (a + b) is exact in float, and scaling by a power of 2 is exact, so this is bit exact.
+static void downmixToMonoFloatFromStereoI16(
+        float * __restrict dst, const int16_t * __restrict src, size_t frames)
+{
+    constexpr float kScale = 0.5f / (1 << 15);
+    for (size_t i = 0; i < frames; ++i) {
+        dst[i] = (float)(src[2 * i] + src[2 * i + 1]) * kScale;
+    }
+}
+
+// Replaces: memcpy_by_index_array() to a staging buffer followed by memcpy_by_audio_format().
+template <size_t SRC_CHANNELS, size_t DST_CHANNELS, typename TO, typename TI>
+static void remapAndConvert(TO * __restrict dst, const TI * __restrict src,
+        const int8_t *idxAry, size_t frames)
+{
+    int8_t idx[DST_CHANNELS];
+    for (size_t c = 0; c < DST_CHANNELS; ++c) {
+        idx[c] = idxAry[c];
+    }
+    for (size_t i = 0; i < frames; ++i) {
+        for (size_t c = 0; c < DST_CHANNELS; ++c) {
+            // a negative index fills with zero, as memcpy_by_index_array().
+            dst[c] = idx[c] < 0 ? TO{} : convertSample<TO, TI>(src[idx[c]]);
+        }
+        dst += DST_CHANNELS;
+        src += SRC_CHANNELS;
+    }
+}
+
+// Replaces: in place downmix_to_mono_float_from_stereo_float() of the resampler output
+// followed by memcpy_by_audio_format() to the destination format.
+template <typename TO>
+static void downmixToMonoFromStereoFloat(
+        TO * __restrict dst, const float * __restrict src, size_t frames)
+{
+    for (size_t i = 0; i < frames; ++i) {
+        dst[i] = sampleFromFloat<TO>((src[2 * i] + src[2 * i + 1]) * 0.5f);
+    }
+}
+
 RecordBufferConverter::RecordBufferConverter(
         audio_channel_mask_t srcChannelMask, audio_format_t srcFormat,
         uint32_t srcSampleRate,
@@ -56,7 +127,8 @@ RecordBufferConverter::RecordBufferConverter(
             mIsLegacyDownmix(false),
             mIsLegacyUpmix(false),
             mRequiresFloat(false),
-            mInputConverterProvider(NULL)
+            mInputConverterProvider(NULL),
+            mFusedPath(FUSED_NONE)
 {
     (void)updateParameters(srcChannelMask, srcFormat, srcSampleRate,
             dstChannelMask, dstFormat, dstSampleRate);
@@ -185,14 +257,38 @@ status_t RecordBufferConverter::updateParameters(
                    && (mDstChannelMask == AUDIO_CHANNEL_IN_STEREO
                             || mDstChannelMask == AUDIO_CHANNEL_IN_FRONT_BACK);
 
+    // can we use a fused single pass kernel?
+    const auto isI16OrFloat = [](audio_format_t format) {
+        return format == AUDIO_FORMAT_PCM_16_BIT || format == AUDIO_FORMAT_PCM_FLOAT;
+    };
+    mFusedPath = FUSED_NONE;
+    if (mResampler == NULL) {
+        if (mIsLegacyDownmix
+                && mSrcFormat == AUDIO_FORMAT_PCM_16_BIT && mDstFormat == AUDIO_FORMAT_PCM_FLOAT) {
+            mFusedPath = FUSED_STEREO_I16_TO_MONO_FLOAT;
+        } else if (!mIsLegacyDownmix && !mIsLegacyUpmix
+                && mSrcChannelCount == 4 && mDstChannelCount == 2
+                && isI16OrFloat(mSrcFormat) && isI16OrFloat(mDstFormat)) {
+            mFusedPath = FUSED_REMAP_4_TO_2;
+        }
+    } else if ((mIsLegacyDownmix
+                    || (mSrcChannelMask == mDstChannelMask && mSrcChannelCount == 1))
+            && isI16OrFloat(mDstFormat)) {
+        mFusedPath = FUSED_RESAMPLED_TO_MONO;
+    }
+
     // do we need to process in float?
-    mRequiresFloat = mResampler != NULL || mIsLegacyDownmix || mIsLegacyUpmix;
+    mRequiresFloat = mResampler != NULL
+            || ((mIsLegacyDownmix || mIsLegacyUpmix)
+                    && mFusedPath != FUSED_STEREO_I16_TO_MONO_FLOAT);
 
     // do we need a staging buffer to convert for destination (we can still optimize this)?
     // we use mBufFrameSize > 0 to indicate both frame size as well as buffer necessity
     if (mResampler != NULL) {
         mBufFrameSize = max(mSrcChannelCount, (uint32_t)FCC_2)
                 * audio_bytes_per_sample(AUDIO_FORMAT_PCM_FLOAT);
+    } else if (mFusedPath != FUSED_NONE) { // the fused kernels write directly to dst
+        mBufFrameSize = 0;
     } else if (mIsLegacyUpmix || mIsLegacyDownmix) { // legacy modes always float
         mBufFrameSize = mDstChannelCount * audio_bytes_per_sample(AUDIO_FORMAT_PCM_FLOAT);
     } else if (mSrcChannelMask != mDstChannelMask && mDstFormat != mSrcFormat) {
@@ -221,9 +317,46 @@ status_t RecordBufferConverter::updateParameters(
     return NO_ERROR;
 }
 
+bool RecordBufferConverter::convertFused(void *dst, const void *src, size_t frames)
+{
+    switch (mFusedPath) {
+    case FUSED_STEREO_I16_TO_MONO_FLOAT:
+        downmixToMonoFloatFromStereoI16((float *)dst, (const int16_t *)src, frames);
+        return true;
+    case FUSED_REMAP_4_TO_2:
+        if (mSrcFormat == AUDIO_FORMAT_PCM_16_BIT) {
+            if (mDstFormat == AUDIO_FORMAT_PCM_16_BIT) {
+                remapAndConvert<4, 2>((int16_t *)dst, (const int16_t *)src, mIdxAry, frames);
+            } else {
+                remapAndConvert<4, 2>((float *)dst, (const int16_t *)src, mIdxAry, frames);
+            }
+        } else {
+            if (mDstFormat == AUDIO_FORMAT_PCM_16_BIT) {
+                remapAndConvert<4, 2>((int16_t *)dst, (const float *)src, mIdxAry, frames);
+            } else {
+                remapAndConvert<4, 2>((float *)dst, (const float *)src, mIdxAry, frames);
+            }
+        }
+        return true;
+    case FUSED_RESAMPLED_TO_MONO:
+        if (mDstFormat == AUDIO_FORMAT_PCM_16_BIT) {
+            downmixToMonoFromStereoFloat((int16_t *)dst, (const float *)src, frames);
+        } else {
+            downmixToMonoFromStereoFloat((float *)dst, (const float *)src, frames);
+        }
+        return true;
+    case FUSED_NONE:
+    default:
+        return false;
+    }
+}
+
 void RecordBufferConverter::convertNoResampler(
         void *dst, const void *src, size_t frames)
 {
+    if (convertFused(dst, src, frames)) {
+        return;
+    }
     // src is native type unless there is legacy upmix or downmix, whereupon it is float.
     if (mBufFrameSize != 0 && mBufFrames < frames) {
         free(mBuf);
@@ -265,6 +398,9 @@ void RecordBufferConverter::convertResampler(
         void *dst, /*not-a-const*/ void *src, size_t frames)
 {
     // src buffer format is ALWAYS float when entering this routine
+    if (convertFused(dst, src, frames)) {
+        return;
+    }
     if (mIsLegacyUpmix) {
         ; // mono to stereo already handled by resampler
     } else if (mIsLegacyDownmix
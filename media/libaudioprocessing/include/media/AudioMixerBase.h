@@ -18,6 +18,7 @@
 #ifndef ANDROID_AUDIO_MIXER_BASE_H
 #define ANDROID_AUDIO_MIXER_BASE_H
 
+#include <atomic>
 #include <map>
 #include <memory>
 #include <string>
@@ -25,6 +26,7 @@
 #include <vector>
 
 #include <media/AudioBufferProvider.h>
+#include <media/AudioMixerWorkerPool.h>
 #include <media/AudioResampler.h>
 #include <media/AudioResamplerPublic.h>
 #include <system/audio.h>
@@ -139,6 +141,27 @@ public:
 
     std::string trackNames() const;
 
+    // Enable or disable parallel mixing.
+    //
+    // When enabled, each group of tracks sharing a main buffer with at least
+    // 2 * minTracksPerJob enabled tracks is split into up to (workerCount + 1) jobs.
+    // Each job mixes its tracks into a private sub-buffer, on a worker thread or on the
+    // calling thread, and the sub-buffers are summed into the main buffer afterwards.
+    // Tracks with an aux send are always mixed on the calling thread.
+    //
+    // \param workerCount     number of worker threads; 0 disables parallel mixing.
+    // \param minTracksPerJob minimum number of tracks assigned to a job.
+    // \param deadlineNs      if a parallel mix takes longer than this (0 for no deadline),
+    //                        mixing falls back to inline for kParallelHoldoffCycles cycles.
+    // \param cpus            optional CPUs the workers are pinned to.
+    void        setParallelMix(size_t workerCount, size_t minTracksPerJob, int64_t deadlineNs,
+                        const std::vector<int>& cpus = {});
+
+    bool        isParallelMixEnabled() const { return mWorkerPool != nullptr; }
+
+    // Parallel mix configuration, fallback count and per-worker timings, for dumpsys.
+    std::string parallelMixToString() const;
+
   protected:
     // Set kUseNewMixer to true to use the new mixer engine always. Otherwise the
     // original code will be used for stereo sinks, the new mixer for everything else.
@@ -351,6 +374,15 @@ public:
     void process__genericNoResampling();
     void process__genericResampling();
     void process__oneTrack16BitsStereoNoResampling();
+    void process__parallel();
+
+    // Mixes the full mFrameCount of track t into out, acquiring and releasing
+    // the track buffers as needed.  Used by the generic resampling and the parallel paths.
+    void mixTrack(TrackBase *t, int32_t *out, int32_t *resampleTemp);
+
+    // Partitions mGroups into mParallelGroups and selects process__parallel
+    // if any group is large enough to be worth splitting.
+    void validateParallel();
 
     template <int MIXTYPE, typename TO, typename TI, typename TA>
     void process__noResampleOneTrack();
@@ -382,6 +414,34 @@ public:
 
     // track smart pointers, by name, in increasing order of name.
     std::map<int /* name */, std::shared_ptr<TrackBase>> mTracks;
+
+    // Parallel mixing, see setParallelMix().
+    // Number of cycles mixed inline after a parallel cycle misses the deadline.
+    static constexpr int32_t kParallelHoldoffCycles = 100;
+
+    // Per-job private mix buffers, indexed by job, workerCount + 1 entries.
+    struct ParallelJobBuffers {
+        std::unique_ptr<int32_t[]> outTemp;      // MAX_NUM_CHANNELS * mFrameCount
+        std::unique_ptr<int32_t[]> resampleTemp; // MAX_NUM_CHANNELS * mFrameCount
+    };
+
+    struct ParallelGroup {
+        void *mainBuffer;
+        // track names per job; a group with a single job is mixed inline.
+        // Tracks that need an aux send are always in job 0.
+        std::vector<std::vector<TrackBase *>> jobs;
+        TrackBase *leader; // first track of the group, determines the group formats
+    };
+
+    std::unique_ptr<AudioMixerWorkerPool> mWorkerPool;
+    size_t mParallelMinTracksPerJob = 0;
+    int64_t mParallelDeadlineNs = 0;
+    process_hook_t mInlineHook = &AudioMixerBase::process__nop; // used on fallback
+    std::vector<ParallelJobBuffers> mParallelJobBuffers;
+    std::vector<ParallelGroup> mParallelGroups;
+    int32_t mParallelHoldoff = 0;
+    std::atomic<int64_t> mParallelCycles = 0;    // read by parallelMixToString()
+    std::atomic<int64_t> mParallelFallbacks = 0; // read by parallelMixToString()
 };
 
 }  // namespace android
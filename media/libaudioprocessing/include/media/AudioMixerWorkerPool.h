@@ -0,0 +1,106 @@
+/*
+**
+** Copyright 2023, The Android Open Source Project
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+#ifndef ANDROID_AUDIO_MIXER_WORKER_POOL_H
+#define ANDROID_AUDIO_MIXER_WORKER_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace android {
+
+// ----------------------------------------------------------------------------
+
+// AudioMixerWorkerPool is a small fixed-size pool of threads used by AudioMixerBase
+// to mix disjoint subsets of tracks concurrently.
+//
+// run() must only be called from a single thread (the mixer thread).  The calling
+// thread executes job 0 itself, so a pool of N workers runs up to N + 1 jobs per call.
+// Workers are optionally pinned to a CPU and are raised to audio priority on start.
+class AudioMixerWorkerPool {
+public:
+    // \param workerCount number of threads to create, not counting the calling thread.
+    // \param cpus        optional list of CPUs; worker i is pinned to cpus[i % cpus.size()].
+    explicit AudioMixerWorkerPool(size_t workerCount, const std::vector<int>& cpus = {});
+    ~AudioMixerWorkerPool();
+
+    AudioMixerWorkerPool(const AudioMixerWorkerPool&) = delete;
+    AudioMixerWorkerPool& operator=(const AudioMixerWorkerPool&) = delete;
+
+    size_t workerCount() const { return mWorkers.size(); }
+
+    // Runs job(0) on the calling thread and job(i) on worker (i - 1) for 0 < i < jobCount,
+    // and returns once all of the jobs have completed.
+    // jobCount is clamped to workerCount() + 1.  Does not allocate.
+    template <typename F>
+    void run(size_t jobCount, F& job) {
+        runJobs(jobCount, &trampoline<std::remove_reference_t<F>>, &job);
+    }
+
+    // Returns the per-worker timing statistics as a human readable string for dumpsys.
+    std::string toString() const;
+
+private:
+    using job_fn_t = void (*)(void *cookie, size_t index);
+
+    template <typename F>
+    static void trampoline(void *cookie, size_t index) {
+        (*static_cast<F*>(cookie))(index);
+    }
+
+    void runJobs(size_t jobCount, job_fn_t fn, void *cookie);
+    void threadLoop(size_t index, int cpu);
+
+    struct Stats {
+        std::atomic<int64_t> count{0};
+        std::atomic<int64_t> lastNs{0};
+        std::atomic<int64_t> maxNs{0};
+        std::atomic<int64_t> totalNs{0};
+
+        void add(int64_t ns);
+    };
+
+    struct Worker {
+        std::thread thread;
+        int cpu = -1;
+        Stats stats;
+    };
+
+    std::vector<std::unique_ptr<Worker>> mWorkers;
+    Stats mCallerStats;     // job 0, executed on the calling thread
+    Stats mWaitStats;       // time the calling thread waited for workers after job 0
+
+    std::mutex mLock;
+    std::condition_variable mWorkCv;   // signalled when a new generation of jobs is posted
+    std::condition_variable mDoneCv;   // signalled when the last worker job completes
+    uint64_t mGeneration = 0;          // guarded by mLock
+    size_t mJobCount = 0;              // guarded by mLock
+    size_t mPending = 0;               // guarded by mLock
+    job_fn_t mFn = nullptr;            // guarded by mLock
+    void *mCookie = nullptr;           // guarded by mLock
+    bool mExit = false;                // guarded by mLock
+};
+
+}  // namespace android
+
+#endif  // ANDROID_AUDIO_MIXER_WORKER_POOL_H
@@ -85,6 +85,18 @@ private:
     // format conversion when using resampler; modifies src in-place
     void convertResampler(void *dst, /*not-a-const*/ void *src, size_t frames);
 
+    // Single pass kernels for common capture configurations, selected by updateParameters().
+    // Each gives the same result as the generic multi pass conversion it replaces.
+    enum FusedPath {
+        FUSED_NONE,
+        FUSED_STEREO_I16_TO_MONO_FLOAT, // legacy downmix with format conversion
+        FUSED_REMAP_4_TO_2,             // 4 to 2 channel mask conversion, with format conversion
+        FUSED_RESAMPLED_TO_MONO,        // resampler stereo float output to mono (e.g. 48k to 16k)
+    };
+
+    // returns true if the fused path handled the conversion
+    bool convertFused(void *dst, const void *src, size_t frames);
+
     // user provided information
     audio_channel_mask_t mSrcChannelMask;
     audio_format_t       mSrcFormat;
@@ -110,6 +122,7 @@ private:
     bool                 mIsLegacyUpmix;    // legacy mono to stereo conversion needed
     bool                 mRequiresFloat;    // data processing requires float (e.g. resampler)
     PassthruBufferProvider *mInputConverterProvider;    // converts input to float
+    FusedPath            mFusedPath;
     int8_t               mIdxAry[sizeof(uint32_t) * 8]; // used for channel mask conversion
 };
 
@@ -0,0 +1,126 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "mixer_parallel_tests"
+#include <log/log.h>
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <media/AudioMixer.h>
+#include <media/AudioMixerWorkerPool.h>
+
+using namespace android;
+
+namespace {
+
+constexpr size_t kFrameCount = 480;
+constexpr uint32_t kSampleRate = 48000;
+constexpr uint32_t kChannelCount = 2;
+
+// Provides an endless stream of a constant float value per track.
+class ConstantBufferProvider : public AudioBufferProvider {
+public:
+    explicit ConstantBufferProvider(float value)
+        : mData(kFrameCount * kChannelCount, value) {}
+
+    status_t getNextBuffer(Buffer* buffer) override {
+        buffer->frameCount = std::min(buffer->frameCount, kFrameCount);
+        buffer->raw = mData.data();
+        return OK;
+    }
+
+    void releaseBuffer(Buffer* buffer) override {
+        buffer->raw = nullptr;
+        buffer->frameCount = 0;
+    }
+
+private:
+    std::vector<float> mData;
+};
+
+// Mixes trackCount tracks where track i has the value (i + 1) / 1024.
+std::vector<float> mix(size_t trackCount, size_t workerCount, uint32_t trackSampleRate) {
+    AudioMixer mixer(kFrameCount, kSampleRate);
+    if (workerCount > 0) {
+        mixer.setParallelMix(workerCount, 2 /* minTracksPerJob */, 0 /* deadlineNs */);
+    }
+    std::vector<float> out(kFrameCount * kChannelCount);
+    std::vector<std::unique_ptr<ConstantBufferProvider>> providers;
+    for (size_t i = 0; i < trackCount; ++i) {
+        const int name = i;
+        EXPECT_EQ(OK, mixer.create(name, AUDIO_CHANNEL_OUT_STEREO, AUDIO_FORMAT_PCM_FLOAT,
+                AUDIO_SESSION_OUTPUT_MIX));
+        providers.emplace_back(new ConstantBufferProvider((i + 1) / 1024.f));
+        mixer.setBufferProvider(name, providers.back().get());
+        mixer.setParameter(name, AudioMixer::TRACK, AudioMixer::MAIN_BUFFER, out.data());
+        mixer.setParameter(name, AudioMixer::TRACK, AudioMixer::MIXER_FORMAT,
+                (void *)(uintptr_t)AUDIO_FORMAT_PCM_FLOAT);
+        mixer.setParameter(name, AudioMixer::TRACK, AudioMixer::MIXER_CHANNEL_MASK,
+                (void *)(uintptr_t)AUDIO_CHANNEL_OUT_STEREO);
+        if (trackSampleRate != kSampleRate) {
+            mixer.setParameter(name, AudioMixer::RESAMPLE, AudioMixer::SAMPLE_RATE,
+                    (void *)(uintptr_t)trackSampleRate);
+        }
+        float volume = 1.f;
+        mixer.setParameter(name, AudioMixer::VOLUME, AudioMixer::VOLUME0, &volume);
+        mixer.setParameter(name, AudioMixer::VOLUME, AudioMixer::VOLUME1, &volume);
+        mixer.enable(name);
+    }
+    for (int i = 0; i < 4; ++i) {
+        mixer.process();
+    }
+    EXPECT_EQ(workerCount > 0, mixer.isParallelMixEnabled());
+    return out;
+}
+
+} // namespace
+
+TEST(AudioMixerWorkerPoolTest, RunsEveryJobOnce) {
+    AudioMixerWorkerPool pool(3);
+    for (size_t jobCount = 0; jobCount <= 5; ++jobCount) {
+        std::atomic<int> mask = 0;
+        auto job = [&mask](size_t index) { mask.fetch_or(1 << index); };
+        pool.run(jobCount, job);
+        // jobCount is clamped to workerCount() + 1.
+        EXPECT_EQ((1 << std::min(jobCount, (size_t)4)) - 1, mask.load());
+    }
+}
+
+TEST(AudioMixerParallelTest, MatchesInlineMix) {
+    constexpr size_t kTrackCount = 24;
+    const std::vector<float> expected = mix(kTrackCount, 0 /* workerCount */, kSampleRate);
+    const std::vector<float> actual = mix(kTrackCount, 3 /* workerCount */, kSampleRate);
+    ASSERT_EQ(expected.size(), actual.size());
+    for (size_t i = 0; i < expected.size(); ++i) {
+        // summation order differs between the inline and parallel mix.
+        EXPECT_NEAR(expected[i], actual[i], 1e-5f) << "sample " << i;
+    }
+}
+
+TEST(AudioMixerParallelTest, MatchesInlineMixWithResampling) {
+    constexpr size_t kTrackCount = 16;
+    const std::vector<float> expected = mix(kTrackCount, 0 /* workerCount */, 44100);
+    const std::vector<float> actual = mix(kTrackCount, 2 /* workerCount */, 44100);
+    ASSERT_EQ(expected.size(), actual.size());
+    for (size_t i = 0; i < expected.size(); ++i) {
+        EXPECT_NEAR(expected[i], actual[i], 1e-4f) << "sample " << i;
+    }
+}
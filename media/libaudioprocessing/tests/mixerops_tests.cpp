@@ -173,3 +173,53 @@ TEST(mixerops, channel_equivalence) {
         EXPECT_EQ(system, actual);
     }
 }
+
+// Verifies volumeRampMulti with int16_t input against a per frame reference computation.
+// This exercises the SIMD kernels of AudioMixerOpsSimd.h where available, including the
+// partial block at the end of the buffer (FRAME_COUNT is not a multiple of the vector width).
+template <int NCHAN>
+static void testVolumeRampInt16() {
+    constexpr size_t FRAME_COUNT = 1001;
+    constexpr size_t SAMPLE_COUNT = FRAME_COUNT * NCHAN;
+    constexpr audio_channel_mask_t MASK = canonicalChannelMaskFromCount(NCHAN);
+
+    int16_t in[SAMPLE_COUNT];
+    for (size_t i = 0; i < SAMPLE_COUNT; ++i) {
+        in[i] = (i * 7919) % 32768 - 16384;
+    }
+    float out[SAMPLE_COUNT]{};
+    float aux[FRAME_COUNT]{};
+    float vol[2] = {0.f, 1.f};
+    const float volinc[2] = {1.f / FRAME_COUNT, -1.f / FRAME_COUNT};
+    float vola = 0.5f;
+    const float volainc = 0.f;
+
+    volumeRampMulti<MIXTYPE_MULTI_STEREOVOL, NCHAN>(
+            out, FRAME_COUNT, in, aux, vol, volinc, &vola, volainc);
+
+    for (size_t i = 0; i < FRAME_COUNT; ++i) {
+        const float left = i * volinc[0];
+        const float right = 1.f + i * volinc[1];
+        float auxaccum = 0.f;
+        for (size_t j = 0; j < NCHAN; ++j) {
+            const float value = in[i * NCHAN + j] / 32768.f;
+            const int index = stereoVolumeIndex(MASK, j);
+            const float volume = index == 0 ? left : index == 1 ? right : (left + right) * 0.5f;
+            EXPECT_NEAR(value * volume, out[i * NCHAN + j], 1e-5f) << "frame " << i;
+            auxaccum += value;
+        }
+        EXPECT_NEAR(auxaccum / NCHAN * 0.5f, aux[i], 1e-5f) << "frame " << i;
+    }
+    EXPECT_NEAR(1.f, vol[0], 1e-4f);
+    EXPECT_NEAR(0.f, vol[1], 1e-4f);
+}
+
+TEST(mixerops, volumeramp_int16_2) {
+    testVolumeRampInt16<2>();
+}
+TEST(mixerops, volumeramp_int16_6) {
+    testVolumeRampInt16<6>();
+}
+TEST(mixerops, volumeramp_int16_8) {
+    testVolumeRampInt16<8>();
+}
@@ -0,0 +1,172 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "record_buffer_converter_tests"
+#include <log/log.h>
+
+#include <algorithm>
+#include <string.h>
+#include <vector>
+
+#include <audio_utils/primitives.h>
+#include <gtest/gtest.h>
+#include <media/RecordBufferConverter.h>
+
+using namespace android;
+
+namespace {
+
+constexpr size_t kFrameCount = 999; // not a multiple of any vector width
+
+// Provides the given interleaved samples once, in chunks of at most kChunkFrames.
+class DataBufferProvider : public AudioBufferProvider {
+public:
+    static constexpr size_t kChunkFrames = 160;
+
+    DataBufferProvider(const void *data, size_t frames, size_t frameSize)
+        : mData((const uint8_t *)data), mFrames(frames), mFrameSize(frameSize) {}
+
+    status_t getNextBuffer(Buffer* buffer) override {
+        buffer->frameCount = std::min({buffer->frameCount, kChunkFrames, mFrames - mPosition});
+        buffer->raw = buffer->frameCount > 0
+                ? (void *)(mData + mPosition * mFrameSize) : nullptr;
+        return buffer->frameCount > 0 ? OK : NOT_ENOUGH_DATA;
+    }
+
+    void releaseBuffer(Buffer* buffer) override {
+        mPosition += buffer->frameCount;
+        buffer->raw = nullptr;
+        buffer->frameCount = 0;
+    }
+
+private:
+    const uint8_t * const mData;
+    const size_t mFrames;
+    const size_t mFrameSize;
+    size_t mPosition = 0;
+};
+
+// A full scale sawtooth with a different phase per channel, including the extreme values.
+std::vector<int16_t> makeI16(size_t channels) {
+    std::vector<int16_t> data(kFrameCount * channels);
+    for (size_t i = 0; i < data.size(); ++i) {
+        data[i] = (int16_t)((i * 0x1357 + (i % channels) * 0x4000) & 0xffff);
+    }
+    data[0] = INT16_MIN;
+    data[1] = INT16_MAX;
+    return data;
+}
+
+// Float samples slightly beyond full scale so that the clamp in conversion to int16 is tested.
+std::vector<float> makeFloat(size_t channels) {
+    const std::vector<int16_t> i16 = makeI16(channels);
+    std::vector<float> data(i16.size());
+    for (size_t i = 0; i < data.size(); ++i) {
+        data[i] = float_from_i16(i16[i]) * 1.01f;
+    }
+    return data;
+}
+
+template <typename TO>
+std::vector<TO> convert(const void *src, size_t srcFrameSize,
+        audio_channel_mask_t srcMask, audio_format_t srcFormat, uint32_t srcRate,
+        audio_channel_mask_t dstMask, audio_format_t dstFormat, uint32_t dstRate,
+        size_t *frames) {
+    RecordBufferConverter converter(srcMask, srcFormat, srcRate, dstMask, dstFormat, dstRate);
+    EXPECT_EQ(NO_ERROR, converter.initCheck());
+    DataBufferProvider provider(src, kFrameCount, srcFrameSize);
+    std::vector<TO> dst(kFrameCount * audio_channel_count_from_in_mask(dstMask));
+    *frames = converter.convert(dst.data(), &provider, kFrameCount);
+    return dst;
+}
+
+} // namespace
+
+TEST(RecordBufferConverterTest, DownmixStereoI16ToMonoFloat) {
+    const std::vector<int16_t> src = makeI16(2);
+    size_t frames;
+    const std::vector<float> actual = convert<float>(src.data(), 2 * sizeof(int16_t),
+            AUDIO_CHANNEL_IN_STEREO, AUDIO_FORMAT_PCM_16_BIT, 48000,
+            AUDIO_CHANNEL_IN_MONO, AUDIO_FORMAT_PCM_FLOAT, 48000, &frames);
+    ASSERT_EQ(kFrameCount, frames);
+
+    std::vector<float> expected(src.size());
+    memcpy_to_float_from_i16(expected.data(), src.data(), src.size());
+    downmix_to_mono_float_from_stereo_float(expected.data(), expected.data(), kFrameCount);
+    for (size_t i = 0; i < kFrameCount; ++i) {
+        EXPECT_EQ(expected[i], actual[i]) << "frame " << i;
+    }
+}
+
+template <typename TI, typename TO>
+void testRemap4To2(const std::vector<TI>& src,
+        audio_format_t srcFormat, audio_format_t dstFormat) {
+    constexpr audio_channel_mask_t kSrcMask = AUDIO_CHANNEL_INDEX_MASK_4;
+    constexpr audio_channel_mask_t kDstMask = AUDIO_CHANNEL_INDEX_MASK_2;
+    size_t frames;
+    const std::vector<TO> actual = convert<TO>(src.data(), 4 * sizeof(TI),
+            kSrcMask, srcFormat, 48000, kDstMask, dstFormat, 48000, &frames);
+    ASSERT_EQ(kFrameCount, frames);
+
+    int8_t idxAry[sizeof(uint32_t) * 8];
+    (void)memcpy_by_index_array_initialization_from_channel_mask(
+            idxAry, sizeof(idxAry), kDstMask, kSrcMask);
+    std::vector<TI> remapped(kFrameCount * 2);
+    memcpy_by_index_array(remapped.data(), 2, src.data(), 4, idxAry, sizeof(TI), kFrameCount);
+    std::vector<TO> expected(remapped.size());
+    memcpy_by_audio_format(expected.data(), dstFormat, remapped.data(), srcFormat,
+            remapped.size());
+    for (size_t i = 0; i < expected.size(); ++i) {
+        EXPECT_EQ(expected[i], actual[i]) << "sample " << i;
+    }
+}
+
+TEST(RecordBufferConverterTest, Remap4To2) {
+    testRemap4To2<int16_t, int16_t>(makeI16(4), AUDIO_FORMAT_PCM_16_BIT, AUDIO_FORMAT_PCM_16_BIT);
+    testRemap4To2<int16_t, float>(makeI16(4), AUDIO_FORMAT_PCM_16_BIT, AUDIO_FORMAT_PCM_FLOAT);
+    testRemap4To2<float, int16_t>(makeFloat(4), AUDIO_FORMAT_PCM_FLOAT, AUDIO_FORMAT_PCM_16_BIT);
+    testRemap4To2<float, float>(makeFloat(4), AUDIO_FORMAT_PCM_FLOAT, AUDIO_FORMAT_PCM_FLOAT);
+}
+
+template <typename TO>
+void testResampledToMono(audio_format_t dstFormat) {
+    const std::vector<int16_t> src = makeI16(2);
+    size_t frames;
+    const std::vector<TO> actual = convert<TO>(src.data(), 2 * sizeof(int16_t),
+            AUDIO_CHANNEL_IN_STEREO, AUDIO_FORMAT_PCM_16_BIT, 48000,
+            AUDIO_CHANNEL_IN_MONO, dstFormat, 16000, &frames);
+
+    // the stereo to stereo conversion does not use a fused path; downmix it here.
+    size_t stereoFrames;
+    std::vector<float> stereo = convert<float>(src.data(), 2 * sizeof(int16_t),
+            AUDIO_CHANNEL_IN_STEREO, AUDIO_FORMAT_PCM_16_BIT, 48000,
+            AUDIO_CHANNEL_IN_STEREO, AUDIO_FORMAT_PCM_FLOAT, 16000, &stereoFrames);
+    ASSERT_EQ(stereoFrames, frames);
+    ASSERT_GT(frames, 0u);
+    downmix_to_mono_float_from_stereo_float(stereo.data(), stereo.data(), frames);
+    std::vector<TO> expected(frames);
+    memcpy_by_audio_format(expected.data(), dstFormat, stereo.data(), AUDIO_FORMAT_PCM_FLOAT,
+            frames);
+    for (size_t i = 0; i < frames; ++i) {
+        EXPECT_EQ(expected[i], actual[i]) << "frame " << i;
+    }
+}
+
+TEST(RecordBufferConverterTest, ResampledDownmixToMono) {
+    testResampledToMono<float>(AUDIO_FORMAT_PCM_FLOAT);
+    testResampledToMono<int16_t>(AUDIO_FORMAT_PCM_16_BIT);
+}
@@ -601,3 +601,32 @@ TEST(audioflinger_resampler, generalresponse) {
         }
     }
 }
+
+TEST(audioflinger_resampler, sharedfilterbank) {
+    using ResamplerType = android::AudioResamplerDyn<float, float, float>;
+    auto create = [](int32_t outputFreq) {
+        return std::unique_ptr<ResamplerType>(static_cast<ResamplerType *>(
+                android::AudioResampler::create(AUDIO_FORMAT_PCM_FLOAT, 2 /* channels */,
+                        outputFreq, android::AudioResampler::DYN_HIGH_QUALITY)));
+    };
+
+    // identical designs share one filter bank.
+    std::unique_ptr<ResamplerType> r1 = create(48000);
+    std::unique_ptr<ResamplerType> r2 = create(48000);
+    r1->setSampleRate(44100);
+    r2->setSampleRate(44100);
+    ASSERT_NE(nullptr, r1->getFilterCoefs());
+    EXPECT_EQ(r1->getFilterCoefs(), r2->getFilterCoefs());
+
+    // a different design does not.
+    r2->setSampleRate(32000);
+    EXPECT_NE(r1->getFilterCoefs(), r2->getFilterCoefs());
+
+    // the shared filter bank remains valid after one of its users is destroyed.
+    std::unique_ptr<ResamplerType> r3 = create(48000);
+    r3->setSampleRate(44100);
+    const float *coefs = r1->getFilterCoefs();
+    EXPECT_EQ(coefs, r3->getFilterCoefs());
+    r1.reset();
+    EXPECT_EQ(coefs, r3->getFilterCoefs());
+}
@@ -54,7 +54,7 @@ sp<ARTSPConnection> AVMediaServiceFactory::createARTSPConnection(
 }
 
 sp<ARTPConnection> AVMediaServiceFactory::createARTPConnection() {
-    return new ARTPConnection();
+    return new ARTPConnection(ARTPConnection::kStreamPerLooper);
 }
 
 // ----- NO TRESSPASSING BEYOND THIS LINE ------
@@ -33,7 +33,10 @@ FileSource::FileSource(const char *filename)
     : mFd(-1),
       mOffset(0),
       mLength(-1),
-      mName("<null>") {
+      mName("<null>"),
+      mReadAhead(NULL),
+      mReadAheadOffset(0),
+      mReadAheadSize(0) {
 
     if (filename) {
         mName = String8::format("FileSource(%s)", filename);
@@ -52,7 +55,10 @@ FileSource::FileSource(int fd, int64_t offset, int64_t length)
     : mFd(fd),
       mOffset(offset),
       mLength(length),
-      mName("<null>") {
+      mName("<null>"),
+      mReadAhead(NULL),
+      mReadAheadOffset(0),
+      mReadAheadSize(0) {
     ALOGV("fd=%d (%s), offset=%lld, length=%lld",
             fd, nameForFd(fd).c_str(), (long long) offset, (long long) length);
 
@@ -90,6 +96,9 @@ FileSource::FileSource(int fd, int64_t offset, int64_t length)
 }
 
 FileSource::~FileSource() {
+    delete[] mReadAhead;
+    mReadAhead = NULL;
+
     if (mFd >= 0) {
         ::close(mFd);
         mFd = -1;
@@ -122,13 +131,42 @@ ssize_t FileSource::readAt(off64_t offset, void *data, size_t size) {
 }
 
 ssize_t FileSource::readAt_l(off64_t offset, void *data, size_t size) {
-    off64_t result = lseek64(mFd, offset + mOffset, SEEK_SET);
-    if (result == -1) {
-        ALOGE("seek to %lld failed", (long long)(offset + mOffset));
+    if (offset >= mReadAheadOffset
+            && offset + size <= mReadAheadOffset + mReadAheadSize) {
+        memcpy(data, mReadAhead + (offset - mReadAheadOffset), size);
+        return size;
+    }
+
+    if (size >= kReadAheadSize) {
+        ssize_t n = pread64(mFd, data, size, offset + mOffset);
+        if (n < 0) {
+            ALOGE("read at %lld failed (%s)", (long long)(offset + mOffset), strerror(errno));
+            return UNKNOWN_ERROR;
+        }
+        return n;
+    }
+
+    if (mReadAhead == NULL) {
+        mReadAhead = new uint8_t[kReadAheadSize];
+    }
+    size_t readAheadSize = kReadAheadSize;
+    if (mLength >= 0 && (uint64_t)readAheadSize > (uint64_t)(mLength - offset)) {
+        readAheadSize = mLength - offset;
+    }
+    ssize_t n = pread64(mFd, mReadAhead, readAheadSize, offset + mOffset);
+    if (n < 0) {
+        ALOGE("read at %lld failed (%s)", (long long)(offset + mOffset), strerror(errno));
+        mReadAheadSize = 0;
         return UNKNOWN_ERROR;
     }
+    mReadAheadOffset = offset;
+    mReadAheadSize = n;
 
-    return ::read(mFd, data, size);
+    if (size > (size_t)n) {
+        size = n;
+    }
+    memcpy(data, mReadAhead, size);
+    return size;
 }
 
 status_t FileSource::getSize(off64_t *size) {
@@ -51,6 +51,9 @@ struct PageCache {
 
     void copy(size_t from, void *data, size_t size);
 
+    // Frees the pages kept around for reuse.
+    void releaseFreePages();
+
 private:
     size_t mPageSize;
     size_t mTotalSize;
@@ -86,6 +89,11 @@ void PageCache::freePages(List<Page *> *list) {
     }
 }
 
+void PageCache::releaseFreePages() {
+    freePages(&mFreePages);
+    mFreePages.clear();
+}
+
 PageCache::Page *PageCache::acquirePage() {
     if (!mFreePages.empty()) {
         List<Page *>::iterator it = mFreePages.begin();
@@ -188,6 +196,7 @@ NuCachedSource2::NuCachedSource2(
       mLooper(new ALooper),
       mCache(new PageCache(kPageSize)),
       mCacheOffset(0),
+      mRetainedBytes(0),
       mFinalStatus(OK),
       mLastAccessPos(0),
       mFetching(true),
@@ -234,6 +243,11 @@ NuCachedSource2::~NuCachedSource2() {
 
     delete mCache;
     mCache = NULL;
+
+    for (List<RetainedRange>::iterator it = mRetainedRanges.begin();
+            it != mRetainedRanges.end(); ++it) {
+        delete it->mCache;
+    }
 }
 
 // static
@@ -537,6 +551,12 @@ ssize_t NuCachedSource2::readAt(off64_t offset, void *data, size_t size) {
         return size;
     }
 
+    if (readRetainedRange_l(offset, data, size)) {
+        mLastAccessPos = offset + size;
+
+        return size;
+    }
+
     sp<AMessage> msg = new AMessage(kWhatRead, mReflector);
     msg->setInt64("offset", offset);
     msg->setPointer("data", data);
@@ -622,6 +642,14 @@ ssize_t NuCachedSource2::readInternal(off64_t offset, void *data, size_t size) {
 
     if (offset < mCacheOffset
             || offset >= (off64_t)(mCacheOffset + mCache->totalSize())) {
+        if (readRetainedRange_l(offset, data, size)) {
+            return size;
+        }
+    }
+
+    if ((offset < mCacheOffset
+            || offset >= (off64_t)(mCacheOffset + mCache->totalSize()))
+            && !resumeRetainedRange_l(offset)) {
         static const off64_t kPadding = 256 * 1024;
 
         // In the presence of multiple decoded streams, once of them will
@@ -672,17 +700,87 @@ status_t NuCachedSource2::seekInternal_l(off64_t offset) {
 
     ALOGI("new range: offset= %lld", (long long)offset);
 
+    retainActiveRange_l();
     mCacheOffset = offset;
 
-    size_t totalSize = mCache->totalSize();
-    CHECK_EQ(mCache->releaseFromStart(totalSize), totalSize);
-
     mNumRetriesLeft = kMaxNumRetries;
     mFetching = true;
 
     return OK;
 }
 
+void NuCachedSource2::retainActiveRange_l() {
+    size_t totalSize = mCache->totalSize();
+    if (totalSize == 0) {
+        return;
+    }
+
+    RetainedRange range;
+    range.mOffset = mCacheOffset;
+    range.mCache = mCache;
+    mRetainedRanges.push_front(range);
+    mRetainedBytes += totalSize;
+    range.mCache->releaseFreePages();
+
+    mCache = new PageCache(kPageSize);
+
+    // Trim the least recently used ranges from their start, dropping them
+    // once less than a page is left to release.
+    while (mRetainedBytes > kMaxRetainedBytes) {
+        List<RetainedRange>::iterator oldest = --mRetainedRanges.end();
+        size_t excess = mRetainedBytes - kMaxRetainedBytes;
+        size_t released = oldest->mCache->releaseFromStart(excess);
+        oldest->mCache->releaseFreePages();
+        oldest->mOffset += released;
+        mRetainedBytes -= released;
+
+        if (released < excess || oldest->mCache->totalSize() == 0) {
+            mRetainedBytes -= oldest->mCache->totalSize();
+            delete oldest->mCache;
+            mRetainedRanges.erase(oldest);
+        }
+    }
+}
+
+bool NuCachedSource2::readRetainedRange_l(off64_t offset, void *data, size_t size) {
+    for (List<RetainedRange>::iterator it = mRetainedRanges.begin();
+            it != mRetainedRanges.end(); ++it) {
+        if (offset >= it->mOffset
+                && offset + size <= it->mOffset + it->mCache->totalSize()) {
+            it->mCache->copy(offset - it->mOffset, data, size);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool NuCachedSource2::resumeRetainedRange_l(off64_t offset) {
+    for (List<RetainedRange>::iterator it = mRetainedRanges.begin();
+            it != mRetainedRanges.end(); ++it) {
+        if (offset < it->mOffset
+                || offset >= (off64_t)(it->mOffset + it->mCache->totalSize())) {
+            continue;
+        }
+
+        RetainedRange range = *it;
+        mRetainedRanges.erase(it);
+        mRetainedBytes -= range.mCache->totalSize();
+
+        ALOGI("resuming cached range: offset= %lld", (long long)range.mOffset);
+
+        retainActiveRange_l();
+        delete mCache;
+        mCache = range.mCache;
+        mCacheOffset = range.mOffset;
+        mLastAccessPos = offset;
+
+        mNumRetriesLeft = kMaxNumRetries;
+        mFetching = true;
+        return true;
+    }
+    return false;
+}
+
 void NuCachedSource2::resumeFetchingIfNecessary() {
     Mutex::Autolock autoLock(mLock);
 
@@ -56,7 +56,16 @@ protected:
     Mutex mLock;
 
 private:
+    // Reads smaller than this are served from a block read ahead of them,
+    // extractors issue many small reads for headers and tables.
+    enum {
+        kReadAheadSize = 32 * 1024,
+    };
+
     String8 mName;
+    uint8_t *mReadAhead;
+    off64_t mReadAheadOffset;
+    size_t mReadAheadSize;
 
     FileSource(const FileSource &);
     FileSource &operator=(const FileSource &);
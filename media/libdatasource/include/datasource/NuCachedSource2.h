@@ -21,6 +21,7 @@
 #include <media/DataSource.h>
 #include <media/stagefright/foundation/ABase.h>
 #include <media/stagefright/foundation/AHandlerReflector.h>
+#include <utils/List.h>
 
 namespace android {
 
@@ -88,6 +89,9 @@ private:
         kDefaultHighWaterThreshold      = 20 * 1024 * 1024,
         kDefaultLowWaterThreshold       = 4 * 1024 * 1024,
 
+        // Upper bound on the data kept from ranges cached before a seek.
+        kMaxRetainedBytes               = 8 * 1024 * 1024,
+
         // Read data after a 15 sec timeout whether we're actively
         // fetching or not.
         kDefaultKeepAliveIntervalUs     = 15000000,
@@ -113,6 +117,16 @@ private:
 
     PageCache *mCache;
     off64_t mCacheOffset;
+
+    // Ranges cached before a seek, most recently used first. Reads that fall
+    // inside one are served from it, and seeking into one resumes fetching
+    // at its end instead of refetching it.
+    struct RetainedRange {
+        off64_t mOffset;
+        PageCache *mCache;
+    };
+    List<RetainedRange> mRetainedRanges;
+    size_t mRetainedBytes;
     status_t mFinalStatus;
     off64_t mLastAccessPos;
     sp<AMessage> mAsyncResult;
@@ -138,6 +152,10 @@ private:
     ssize_t readInternal(off64_t offset, void *data, size_t size);
     status_t seekInternal_l(off64_t offset);
 
+    void retainActiveRange_l();
+    bool readRetainedRange_l(off64_t offset, void *data, size_t size);
+    bool resumeRetainedRange_l(off64_t offset);
+
     size_t approxDataRemaining_l(off64_t offset, status_t *finalStatus) const;
 
     void restartPrefetcherIfNecessary_l(
@@ -343,8 +343,6 @@ static int32_t Downmix_Process(effect_handle_t self,
 
     const bool accumulate =
             (pDwmModule->config.outputCfg.accessMode == EFFECT_BUFFER_ACCESS_ACCUMULATE);
-    const audio_channel_mask_t downmixInputChannelMask =
-            (audio_channel_mask_t)pDwmModule->config.inputCfg.channels;
 
     switch(pDownmixer->type) {
 
@@ -369,10 +367,10 @@ static int32_t Downmix_Process(effect_handle_t self,
           break;
 
       case DOWNMIX_TYPE_FOLD: {
-            if (!pDownmixer->channelMix.process(
-                    pSrc, pDst, numFrames, accumulate, downmixInputChannelMask)) {
+            // the fold kernel for the input channel mask is selected in Downmix_Configure()
+            if (!pDownmixer->channelMix.process(pSrc, pDst, numFrames, accumulate)) {
                 ALOGE("Multichannel configuration %#x is not supported",
-                      downmixInputChannelMask);
+                      pDwmModule->config.inputCfg.channels);
                 return -EINVAL;
             }
         }
@@ -655,6 +653,13 @@ static int Downmix_Configure(downmix_module_t *pDwmModule, effect_config_t *pCon
                                                     pConfig->inputCfg.channels);
         return -EINVAL;
     }
+    // select the fold matrix and kernel once here rather than on every process call
+    if (!pDownmixer->channelMix.setInputChannelMask(
+            (audio_channel_mask_t)pConfig->inputCfg.channels)) {
+        ALOGE("Downmix_Configure error: no fold for input channel mask(0x%x)",
+                                                    pConfig->inputCfg.channels);
+        return -EINVAL;
+    }
 
     if (&pDwmModule->config != pConfig) {
         memcpy(&pDwmModule->config, pConfig, sizeof(effect_config_t));
@@ -98,8 +98,8 @@ IEffect::Status DownmixContext::lvmProcess(float* in, float* out, int samples) {
             frames--;
         }
     } else {
-        int chMask = mChMask.get<AudioChannelLayout::layoutMask>();
-        if (!mChannelMix.process(in, out, frames, accumulate, (audio_channel_mask_t)chMask)) {
+        // the fold kernel for mChMask is selected in init_params()
+        if (!mChannelMix.process(in, out, frames, accumulate)) {
             LOG(ERROR) << "Multichannel configuration " << mChMask.toString()
                        << " is not supported";
             return status;
@@ -115,6 +115,10 @@ void DownmixContext::init_params(const Parameter::Common& common) {
     if (isChannelMaskValid(channelMask)) {
         LOG(ERROR) << "Downmix_Configure error: input channel mask " << channelMask.toString()
                    << " not supported";
+    } else if (!mChannelMix.setInputChannelMask(
+                       (audio_channel_mask_t)channelMask.get<AudioChannelLayout::layoutMask>())) {
+        LOG(ERROR) << "Downmix_Configure error: no fold for input channel mask "
+                   << channelMask.toString();
     } else {
         mType = Downmix::Type::FOLD;
         mChMask = channelMask;
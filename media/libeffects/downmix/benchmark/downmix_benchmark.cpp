@@ -15,6 +15,7 @@
  */
 
 #include <random>
+#include <string>
 #include <vector>
 
 #include <audio_effects/effect_downmix.h>
@@ -91,25 +92,23 @@ downmix_benchmark:
   #BM_Downmix/21    6332 ns    6301 ns       111134
 */
 
-static void BM_Downmix(benchmark::State& state) {
-    const audio_channel_mask_t channelMask = kChannelPositionMasks[state.range(0)];
-    const size_t channelCount = audio_channel_count_from_out_mask(channelMask);
-    const int sampleRate = 48000;
+// Multichannel layouts commonly folded for spatial audio content on stereo devices.
+static constexpr audio_channel_mask_t kSpatialChannelMasks[] = {
+    AUDIO_CHANNEL_OUT_5POINT1,
+    AUDIO_CHANNEL_OUT_7POINT1,
+    AUDIO_CHANNEL_OUT_7POINT1POINT4,
+    AUDIO_CHANNEL_OUT_22POINT2,
+};
 
-    // Initialize input buffer with deterministic pseudo-random values
-    std::minstd_rand gen(channelMask);
-    std::uniform_real_distribution<> dis(-1.0f, 1.0f);
-    std::vector<float> input(kFrameCount * channelCount);
-    std::vector<float> output(kFrameCount * FCC_2);
-    for (auto& in : input) {
-        in = dis(gen);
-    }
+static effect_handle_t createDownmix(audio_channel_mask_t channelMask,
+        downmix_type_t type, bool accumulate) {
+    const int sampleRate = 48000;
     effect_handle_t effectHandle = nullptr;
     if (int status = AUDIO_EFFECT_LIBRARY_INFO_SYM.create_effect(
             &downmix_uuid, 1, 1, &effectHandle);
         status != 0) {
         ALOGE("create_effect returned an error = %d\n", status);
-        return;
+        return nullptr;
     }
 
     effect_config_t config{};
@@ -120,7 +119,8 @@ static void BM_Downmix(benchmark::State& state) {
     config.inputCfg.bufferProvider.cookie = nullptr;
     config.inputCfg.mask = EFFECT_CONFIG_ALL;
 
-    config.outputCfg.accessMode = EFFECT_BUFFER_ACCESS_WRITE;
+    config.outputCfg.accessMode =
+            accumulate ? EFFECT_BUFFER_ACCESS_ACCUMULATE : EFFECT_BUFFER_ACCESS_WRITE;
     config.outputCfg.format = AUDIO_FORMAT_PCM_FLOAT;
     config.outputCfg.bufferProvider.getBuffer = nullptr;
     config.outputCfg.bufferProvider.releaseBuffer = nullptr;
@@ -138,15 +138,54 @@ static void BM_Downmix(benchmark::State& state) {
     if (int status = (*effectHandle)
             ->command(effectHandle, EFFECT_CMD_SET_CONFIG, sizeof(effect_config_t),
                     &config, &replySize, &reply);
-        status != 0) {
-        ALOGE("command returned an error = %d\n", status);
-        return;
+        status != 0 || reply != 0) {
+        ALOGE("command returned an error = %d reply %d\n", status, reply);
+        AUDIO_EFFECT_LIBRARY_INFO_SYM.release_effect(effectHandle);
+        return nullptr;
+    }
+
+    uint32_t paramBuf[(sizeof(effect_param_t) + sizeof(int32_t) + sizeof(downmix_type_t))
+            / sizeof(uint32_t)];
+    effect_param_t* param = (effect_param_t*)paramBuf;
+    param->psize = sizeof(int32_t);
+    param->vsize = sizeof(downmix_type_t);
+    *(int32_t*)param->data = DOWNMIX_PARAM_TYPE;
+    *(downmix_type_t*)(param->data + sizeof(int32_t)) = type;
+    if (int status = (*effectHandle)
+            ->command(effectHandle, EFFECT_CMD_SET_PARAM, sizeof(paramBuf), param,
+                    &replySize, &reply);
+        status != 0 || reply != 0) {
+        ALOGE("set type returned an error = %d reply %d\n", status, reply);
+        AUDIO_EFFECT_LIBRARY_INFO_SYM.release_effect(effectHandle);
+        return nullptr;
     }
 
     if (int status = (*effectHandle)
             ->command(effectHandle, EFFECT_CMD_ENABLE, 0, nullptr, &replySize, &reply);
         status != 0) {
         ALOGE("Command enable call returned error %d\n", reply);
+        AUDIO_EFFECT_LIBRARY_INFO_SYM.release_effect(effectHandle);
+        return nullptr;
+    }
+    return effectHandle;
+}
+
+static void runDownmix(benchmark::State& state, audio_channel_mask_t channelMask,
+        downmix_type_t type, bool accumulate, size_t frameCount) {
+    const size_t channelCount = audio_channel_count_from_out_mask(channelMask);
+
+    // Initialize input buffer with deterministic pseudo-random values
+    std::minstd_rand gen(channelMask);
+    std::uniform_real_distribution<> dis(-1.0f, 1.0f);
+    std::vector<float> input(frameCount * channelCount);
+    std::vector<float> output(frameCount * FCC_2);
+    for (auto& in : input) {
+        in = dis(gen);
+    }
+
+    effect_handle_t effectHandle = createDownmix(channelMask, type, accumulate);
+    if (effectHandle == nullptr) {
+        state.SkipWithError("cannot create downmix");
         return;
     }
 
@@ -155,28 +194,55 @@ static void BM_Downmix(benchmark::State& state) {
         benchmark::DoNotOptimize(input.data());
         benchmark::DoNotOptimize(output.data());
 
-        audio_buffer_t inBuffer = {.frameCount = kFrameCount, .f32 = input.data()};
-        audio_buffer_t outBuffer = {.frameCount = kFrameCount, .f32 = output.data()};
+        audio_buffer_t inBuffer = {.frameCount = frameCount, .f32 = input.data()};
+        audio_buffer_t outBuffer = {.frameCount = frameCount, .f32 = output.data()};
         (*effectHandle)->process(effectHandle, &inBuffer, &outBuffer);
 
         benchmark::ClobberMemory();
     }
 
     state.SetComplexityN(channelCount);
-    state.SetLabel(audio_channel_out_mask_to_string(channelMask));
+    state.SetItemsProcessed(state.iterations() * frameCount);
+    state.SetLabel(std::string(audio_channel_out_mask_to_string(channelMask))
+            + (type == DOWNMIX_TYPE_STRIP ? " strip" : " fold")
+            + (accumulate ? " accumulate" : ""));
 
     if (int status = AUDIO_EFFECT_LIBRARY_INFO_SYM.release_effect(effectHandle); status != 0) {
         ALOGE("release_effect returned an error = %d\n", status);
-        return;
     }
 }
 
+// Args: channel mask index, accumulate.
+static void BM_Downmix(benchmark::State& state) {
+    runDownmix(state, kChannelPositionMasks[state.range(0)], DOWNMIX_TYPE_FOLD,
+            state.range(1) != 0, kFrameCount);
+}
+
+// Args: spatial channel mask index, downmix type, frame count.
+static void BM_Downmix_Spatial(benchmark::State& state) {
+    runDownmix(state, kSpatialChannelMasks[state.range(0)], (downmix_type_t)state.range(1),
+            false /* accumulate */, state.range(2));
+}
+
 static void DownmixArgs(benchmark::internal::Benchmark* b) {
     for (int i = 0; i < (int)std::size(kChannelPositionMasks); i++) {
-        b->Args({i});
+        for (int accumulate : {0, 1}) {
+            b->Args({i, accumulate});
+        }
+    }
+}
+
+static void DownmixSpatialArgs(benchmark::internal::Benchmark* b) {
+    for (int i = 0; i < (int)std::size(kSpatialChannelMasks); i++) {
+        for (int type : {DOWNMIX_TYPE_FOLD, DOWNMIX_TYPE_STRIP}) {
+            for (int frameCount : {48, 192, 960, 4096}) {
+                b->Args({i, type, frameCount});
+            }
+        }
     }
 }
 
 BENCHMARK(BM_Downmix)->Apply(DownmixArgs);
+BENCHMARK(BM_Downmix_Spatial)->Apply(DownmixSpatialArgs);
 
 BENCHMARK_MAIN();
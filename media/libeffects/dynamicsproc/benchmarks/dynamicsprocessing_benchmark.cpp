@@ -0,0 +1,118 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <random>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "DPFrequency.h"
+
+constexpr int kSampleRate = 48000;
+constexpr size_t kFrameCount = 960;  // 20 ms, a typical mixer period
+constexpr uint32_t kEqBandCount = 5;
+
+// Sets up every channel with pre EQ, MBC, post EQ and limiter enabled, with band cutoffs
+// spread logarithmically up to Nyquist.
+static void configureChannels(dp_fx::DPFrequency& dp, uint32_t channelCount,
+                              uint32_t mbcBandCount) {
+    auto cutoff = [](uint32_t band, uint32_t bandCount) {
+        return 20.f * powf(kSampleRate / 2 / 20.f, (float)(band + 1) / bandCount);
+    };
+    for (uint32_t ch = 0; ch < channelCount; ch++) {
+        dp_fx::DPChannel* channel = dp.getChannel(ch);
+        channel->setInputGain(-3.f);
+        channel->getPreEq()->setEnabled(true);
+        channel->getPostEq()->setEnabled(true);
+        for (uint32_t b = 0; b < kEqBandCount; b++) {
+            dp_fx::DPEqBand* preEqBand = channel->getPreEq()->getBand(b);
+            preEqBand->setEnabled(true);
+            preEqBand->setCutoffFrequency(cutoff(b, kEqBandCount));
+            preEqBand->setGain(b % 2 ? 2.f : -2.f);
+            dp_fx::DPEqBand* postEqBand = channel->getPostEq()->getBand(b);
+            postEqBand->setEnabled(true);
+            postEqBand->setCutoffFrequency(cutoff(b, kEqBandCount));
+            postEqBand->setGain(b % 2 ? -1.f : 1.f);
+        }
+        channel->getMbc()->setEnabled(true);
+        for (uint32_t b = 0; b < mbcBandCount; b++) {
+            dp_fx::DPMbcBand* mbcBand = channel->getMbc()->getBand(b);
+            mbcBand->setEnabled(true);
+            mbcBand->setCutoffFrequency(cutoff(b, mbcBandCount));
+            mbcBand->setThreshold(-30.f);
+            mbcBand->setRatio(4.f);
+            mbcBand->setKneeWidth(6.f);
+        }
+        dp_fx::DPLimiter* limiter = channel->getLimiter();
+        limiter->setEnabled(true);
+        limiter->setLinkGroup(0);
+        limiter->setAttackTime(1.f);
+        limiter->setReleaseTime(60.f);
+        limiter->setRatio(10.f);
+        limiter->setThreshold(-2.f);
+    }
+}
+
+/*******************************************************************
+ * Args: channel count, MBC band count, block size.
+ * The block size is the FFT size; DynamicsProcessing picks the power of 2
+ * at or above the preferred frame duration, e.g. 512 for 10 ms at 48 kHz.
+ *******************************************************************/
+static void BM_DYNAMICS_PROCESSING(benchmark::State& state) {
+    const uint32_t channelCount = state.range(0);
+    const uint32_t mbcBandCount = state.range(1);
+    const size_t blockSize = state.range(2);
+
+    dp_fx::DPFrequency dp;
+    dp.init(channelCount, true /* preEqInUse */, kEqBandCount, true /* mbcInUse */, mbcBandCount,
+            true /* postEqInUse */, kEqBandCount, true /* limiterInUse */);
+    dp.configure(blockSize, blockSize / 2, kSampleRate);
+    configureChannels(dp, channelCount, mbcBandCount);
+
+    // Initialize input buffer with deterministic pseudo-random values
+    std::minstd_rand gen(channelCount);
+    std::uniform_real_distribution<> dis(-1.0f, 1.0f);
+    std::vector<float> input(kFrameCount * channelCount);
+    std::vector<float> output(kFrameCount * channelCount);
+    for (auto& in : input) {
+        in = dis(gen);
+    }
+
+    // Run the test
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(input.data());
+        benchmark::DoNotOptimize(output.data());
+        dp.processSamples(input.data(), output.data(), input.size());
+        benchmark::ClobberMemory();
+    }
+
+    state.SetComplexityN(channelCount);
+    state.SetItemsProcessed(state.iterations() * kFrameCount);
+}
+
+static void DynamicsProcessingArgs(benchmark::internal::Benchmark* b) {
+    for (int channelCount : {1, 2, 6, 8}) {
+        for (int mbcBandCount : {3, 6, 10}) {
+            for (int blockSize : {256, 512, 1024}) {
+                b->Args({channelCount, mbcBandCount, blockSize});
+            }
+        }
+    }
+}
+
+BENCHMARK(BM_DYNAMICS_PROCESSING)->Apply(DynamicsProcessingArgs);
+
+BENCHMARK_MAIN();
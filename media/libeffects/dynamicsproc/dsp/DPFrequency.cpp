@@ -337,6 +337,17 @@ void DPFrequency::updateParameters(ChannelBuffer &cb, int channelIndex) {
                     binNext = pMbcBandParams->binStop + 1;
                 }
             }
+
+            //bands only share bins if a cutoff frequency is below the previous one
+            size_t binEnd = 0;
+            cb.mMbcBandsContiguous = true;
+            for (const ChannelBuffer::MbcBandParams &mbcBandParams : cb.mMbcBands) {
+                if (mbcBandParams.binStart != binEnd) {
+                    cb.mMbcBandsContiguous = false;
+                    break;
+                }
+                binEnd = std::max(binEnd, mbcBandParams.binStop + 1);
+            }
         }
     }
 
@@ -490,104 +501,84 @@ size_t DPFrequency::processFirstStages(ChannelBuffer &cb) {
 
     size_t cSize = cb.complexTemp.size();
     size_t maxBin = std::min(cSize/2, mHalfFFTSize);
-
-    //== EqPre (always runs)
-    for (size_t k = 0; k < maxBin; k++) {
-        cb.complexTemp[k] *= cb.mPreEqFactorVector[k];
-    }
-
-    //== MBC
-    if (cb.mMbcInUse && cb.mMbcEnabled) {
-        for (size_t band = 0; band < cb.mMbcBands.size(); band++) {
-            ChannelBuffer::MbcBandParams *pMbcBandParams = &cb.mMbcBands[band];
-            float fEnergySum = 0;
-
+    std::complex<float> *spectrum = cb.complexTemp.data();
+
+    const bool mbcEnabled = cb.mMbcInUse && cb.mMbcEnabled;
+    const bool postEqEnabled = cb.mPostEqInUse && cb.mPostEqEnabled;
+    const bool limiterEnabled = cb.mLimiterInUse && cb.mLimiterEnabled;
+    //contiguous bands are measured and scaled in the same passes as the EQs.
+    const bool mbcFused = mbcEnabled && cb.mMbcBandsContiguous;
+
+    //== EqPre (always runs), with the MBC band energy
+    size_t k = 0;
+    if (mbcFused) {
+        for (ChannelBuffer::MbcBandParams &mbcBandParams : cb.mMbcBands) {
             //apply pre gain.
-            float preGainFactor = dBtoLinear(pMbcBandParams->gainPreDb);
+            float preGainFactor = dBtoLinear(mbcBandParams.gainPreDb);
             float preGainSquared = preGainFactor * preGainFactor;
 
-            for (size_t k = pMbcBandParams->binStart; k <= pMbcBandParams->binStop; k++) {
-                fEnergySum += std::norm(cb.complexTemp[k]) * preGainSquared; //mag squared
+            const size_t binEnd = mbcBandParams.binStop + 1;
+            float fEnergySum = 0;
+            for (; k < std::min(binEnd, maxBin); k++) {
+                spectrum[k] *= cb.mPreEqFactorVector[k];
+                fEnergySum += std::norm(spectrum[k]) * preGainSquared; //mag squared
             }
-
-            //Eigen FFT is full spectrum, even if the source was real data.
-            // Each half spectrum has half the energy. This is taken into account with the * 2
-            // factor in the energy computations.
-            // energy = sqrt(sum_components_squared) number_points
-            // in here, the fEnergySum is duplicated to account for the second half spectrum,
-            // and the windowRms is used to normalize by the expected energy reduction
-            // caused by the window used (expected for steady state signals)
-            fEnergySum = sqrt(fEnergySum * 2) / (mBlockSize * mWindowRms);
-
-            // updates computed per frame advance.
-            float fTheta = 0.0;
-            float fFAttSec = pMbcBandParams->attackTimeMs / 1000; //in seconds
-            float fFRelSec = pMbcBandParams->releaseTimeMs / 1000; //in seconds
-
-            if (fEnergySum > pMbcBandParams->previousEnvelope) {
-                fTheta = exp(-1.0 / (fFAttSec * mBlocksPerSecond));
-            } else {
-                fTheta = exp(-1.0 / (fFRelSec * mBlocksPerSecond));
+            for (; k < binEnd; k++) {
+                fEnergySum += std::norm(spectrum[k]) * preGainSquared;
             }
+            mbcBandParams.newFactor = computeMbcBandFactor(mbcBandParams, fEnergySum);
+        }
+    }
+    for (; k < maxBin; k++) {
+        spectrum[k] *= cb.mPreEqFactorVector[k];
+    }
 
-            float fEnv = (1.0 - fTheta) * fEnergySum + fTheta * pMbcBandParams->previousEnvelope;
-            //preserve for next iteration
-            pMbcBandParams->previousEnvelope = fEnv;
+    //== MBC, bands sharing bins are measured after the previous band is applied
+    if (mbcEnabled && !mbcFused) {
+        for (ChannelBuffer::MbcBandParams &mbcBandParams : cb.mMbcBands) {
+            float preGainFactor = dBtoLinear(mbcBandParams.gainPreDb);
+            float preGainSquared = preGainFactor * preGainFactor;
 
-            if (fEnv < MIN_ENVELOPE) {
-                fEnv = MIN_ENVELOPE;
+            float fEnergySum = 0;
+            for (k = mbcBandParams.binStart; k <= mbcBandParams.binStop; k++) {
+                fEnergySum += std::norm(spectrum[k]) * preGainSquared;
             }
-            const float envDb = linearToDb(fEnv);
-            float newLevelDb = envDb;
-            //using shorter variables for code clarity
-            const float thresholdDb = pMbcBandParams->thresholdDb;
-            const float ratio = pMbcBandParams->ratio;
-            const float kneeWidthDbHalf = pMbcBandParams->kneeWidthDb / 2;
-            const float noiseGateThresholdDb = pMbcBandParams->noiseGateThresholdDb;
-            const float expanderRatio = pMbcBandParams->expanderRatio;
-
-            //find segment
-            if (envDb > thresholdDb + kneeWidthDbHalf) {
-                //compression segment
-                newLevelDb = envDb + ((1 / ratio) - 1) * (envDb - thresholdDb);
-            } else if (envDb > thresholdDb - kneeWidthDbHalf) {
-                //knee-compression segment
-                float temp = (envDb - thresholdDb + kneeWidthDbHalf);
-                newLevelDb = envDb + ((1 / ratio) - 1) *
-                        temp * temp / (kneeWidthDbHalf * 4);
-            } else if (envDb < noiseGateThresholdDb) {
-                //expander segment
-                newLevelDb = noiseGateThresholdDb -
-                        expanderRatio * (noiseGateThresholdDb - envDb);
+            const float newFactor = computeMbcBandFactor(mbcBandParams, fEnergySum);
+            for (k = mbcBandParams.binStart; k <= mbcBandParams.binStop; k++) {
+                spectrum[k] *= newFactor;
             }
+        }
+    }
 
-            float newFactor = dBtoLinear(newLevelDb - envDb);
-
-            //apply post gain.
-            newFactor *= dBtoLinear(pMbcBandParams->gainPostDb);
-
-            //apply to this band
-            for (size_t k = pMbcBandParams->binStart; k <= pMbcBandParams->binStop; k++) {
-                cb.complexTemp[k] *= newFactor;
+    //== MBC band factors, EqPost and the limiter energy in one pass
+    float fLimiterEnergySum = 0;
+    auto applyBins = [&](size_t binEnd, float factor) {
+        for (; k < std::min(binEnd, maxBin); k++) {
+            spectrum[k] *= factor;
+            if (postEqEnabled) {
+                spectrum[k] *= cb.mPostEqFactorVector[k];
             }
-
-        } //end per band process
-
-    } //end MBC
-
-    //== EqPost
-    if (cb.mPostEqInUse && cb.mPostEqEnabled) {
-        for (size_t k = 0; k < maxBin; k++) {
-            cb.complexTemp[k] *= cb.mPostEqFactorVector[k];
+            if (limiterEnabled) {
+                fLimiterEnergySum += std::norm(spectrum[k]);
+            }
+        }
+        for (; k < binEnd; k++) {
+            spectrum[k] *= factor;
         }
+    };
+    k = 0;
+    if (mbcFused) {
+        for (const ChannelBuffer::MbcBandParams &mbcBandParams : cb.mMbcBands) {
+            applyBins(mbcBandParams.binStop + 1, mbcBandParams.newFactor);
+        }
+    }
+    if (postEqEnabled || limiterEnabled) {
+        applyBins(maxBin, 1.0f);
     }
 
     //== Limiter. First Pass
-    if (cb.mLimiterInUse && cb.mLimiterEnabled) {
-        float fEnergySum = 0;
-        for (size_t k = 0; k < maxBin; k++) {
-            fEnergySum += std::norm(cb.complexTemp[k]);
-        }
+    if (limiterEnabled) {
+        float fEnergySum = fLimiterEnergySum;
 
         //see explanation above for energy computation logic
         fEnergySum = sqrt(fEnergySum * 2) / (mBlockSize * mWindowRms);
@@ -624,6 +615,67 @@ size_t DPFrequency::processFirstStages(ChannelBuffer &cb) {
     return mBlockSize;
 }
 
+// Envelope follower and gain computer for one MBC band, returns the band gain factor
+// (including post gain) given the band energy of the current block.
+float DPFrequency::computeMbcBandFactor(ChannelBuffer::MbcBandParams &bp, float fEnergySum) {
+    //Eigen FFT is full spectrum, even if the source was real data.
+    // Each half spectrum has half the energy. This is taken into account with the * 2
+    // factor in the energy computations.
+    // energy = sqrt(sum_components_squared) number_points
+    // in here, the fEnergySum is duplicated to account for the second half spectrum,
+    // and the windowRms is used to normalize by the expected energy reduction
+    // caused by the window used (expected for steady state signals)
+    fEnergySum = sqrt(fEnergySum * 2) / (mBlockSize * mWindowRms);
+
+    // updates computed per frame advance.
+    float fTheta = 0.0;
+    float fFAttSec = bp.attackTimeMs / 1000; //in seconds
+    float fFRelSec = bp.releaseTimeMs / 1000; //in seconds
+
+    if (fEnergySum > bp.previousEnvelope) {
+        fTheta = exp(-1.0 / (fFAttSec * mBlocksPerSecond));
+    } else {
+        fTheta = exp(-1.0 / (fFRelSec * mBlocksPerSecond));
+    }
+
+    float fEnv = (1.0 - fTheta) * fEnergySum + fTheta * bp.previousEnvelope;
+    //preserve for next iteration
+    bp.previousEnvelope = fEnv;
+
+    if (fEnv < MIN_ENVELOPE) {
+        fEnv = MIN_ENVELOPE;
+    }
+    const float envDb = linearToDb(fEnv);
+    float newLevelDb = envDb;
+    //using shorter variables for code clarity
+    const float thresholdDb = bp.thresholdDb;
+    const float ratio = bp.ratio;
+    const float kneeWidthDbHalf = bp.kneeWidthDb / 2;
+    const float noiseGateThresholdDb = bp.noiseGateThresholdDb;
+    const float expanderRatio = bp.expanderRatio;
+
+    //find segment
+    if (envDb > thresholdDb + kneeWidthDbHalf) {
+        //compression segment
+        newLevelDb = envDb + ((1 / ratio) - 1) * (envDb - thresholdDb);
+    } else if (envDb > thresholdDb - kneeWidthDbHalf) {
+        //knee-compression segment
+        float temp = (envDb - thresholdDb + kneeWidthDbHalf);
+        newLevelDb = envDb + ((1 / ratio) - 1) *
+                temp * temp / (kneeWidthDbHalf * 4);
+    } else if (envDb < noiseGateThresholdDb) {
+        //expander segment
+        newLevelDb = noiseGateThresholdDb -
+                expanderRatio * (noiseGateThresholdDb - envDb);
+    }
+
+    float newFactor = dBtoLinear(newLevelDb - envDb);
+
+    //apply post gain.
+    newFactor *= dBtoLinear(bp.gainPostDb);
+    return newFactor;
+}
+
 void DPFrequency::processLinkedLimiters(CBufferVector &channelBuffers) {
 
     const int channelCount = channelBuffers.size();
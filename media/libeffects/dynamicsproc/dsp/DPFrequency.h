@@ -66,6 +66,7 @@ public:
 
         //Historic values
         float previousEnvelope;
+        float newFactor;
     };
     struct LimiterParams {
         int32_t linkGroup;
@@ -87,6 +88,7 @@ public:
 
     bool mMbcInUse;
     bool mMbcEnabled;
+    bool mMbcBandsContiguous; // each band starts where the previous ones end
     std::vector<MbcBandParams> mMbcBands;
 
     bool mPostEqInUse;
@@ -136,6 +138,7 @@ private:
     size_t processChannelBuffers(CBufferVector &channelBuffers);
     size_t processFirstStages(ChannelBuffer &cb);
     size_t processLastStages(ChannelBuffer &cb);
+    float computeMbcBandFactor(ChannelBuffer::MbcBandParams &bp, float fEnergySum);
     void processLinkedLimiters(CBufferVector &channelBuffers);
 
     size_t mBlockSize;
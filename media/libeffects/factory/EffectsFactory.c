@@ -292,6 +292,12 @@ int doEffectCreate(const effect_uuid_t *uuid, int32_t sessionId, int32_t ioId, i
         }
     }
 
+    ret = EffectOpenDeferredLibrary(l);
+    if (ret < 0) {
+        ALOGW("EffectCreate() could not open library %s for fx %s", l->name, d->name);
+        goto exit;
+    }
+
     // create effect in library
     if (sessionId == AUDIO_SESSION_DEVICE) {
         if (l->desc->version >= EFFECT_LIBRARY_API_VERSION_3_1) {
@@ -435,6 +441,11 @@ int EffectGetSubEffects(const effect_uuid_t *uuid, sub_effect_entry_t **pSube,
            list_elem_t *subefx = e->sub_elem;
            while (subefx != NULL) {
                subeffect = (sub_effect_entry_t*)subefx->object;
+               // The proxy uses the sub effect libraries directly. gLibLock is already held
+               // as this is called by the proxy library while its effect is being created.
+               if (EffectOpenDeferredLibrary(subeffect->lib) < 0) {
+                   return -ENODEV;
+               }
                pSube[count++] = subeffect;
                subefx = subefx->next;
            }
@@ -579,7 +590,7 @@ int EffectDumpEffects(int fd) {
         l = (lib_entry_t *)e->object;
         list_elem_t *efx = l->effects;
         dprintf(fd, " Library %s\n", l->name);
-        dprintf(fd, "  path: %s\n", l->path);
+        dprintf(fd, "  path: %s%s\n", l->path, l->handle == NULL ? " (not opened yet)" : "");
         if (!efx) {
             dprintf(fd, "  (no effects)\n");
         }
@@ -30,6 +30,9 @@ extern "C" {
 #define EFFECT_LIBRARY_API_VERSION_CURRENT EFFECT_LIBRARY_API_VERSION_3_1
 
 #define PROPERTY_IGNORE_EFFECTS "ro.audio.ignore_effects"
+// Set to false to always open every effect library at initialization.
+#define PROPERTY_EFFECTS_DESCRIPTOR_CACHE "ro.audio.effects_descriptor_cache"
+#define EFFECTS_DESCRIPTOR_CACHE_PATH "/data/vendor/audio/effects_descriptor_cache.bin"
 
 typedef struct list_elem_s {
     void *object;
@@ -45,6 +48,8 @@ typedef struct list_sub_elem_s {
     struct list_sub_elem_s *next;
 } list_sub_elem_t;
 
+// desc and handle are NULL until the library is opened: libraries whose effect descriptors
+// were read from the descriptor cache are only opened when one of their effects is created.
 typedef struct lib_entry_s {
     audio_effect_library_t *desc;
     char *name;
@@ -18,10 +18,16 @@
 //#define LOG_NDEBUG 0
 
 #include <dlfcn.h>
+#include <errno.h>
 #include <set>
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <string>
+#include <sys/stat.h>
+#include <vector>
 
+#include <cutils/properties.h>
 #include <log/log.h>
 
 #include <media/EffectsConfig.h>
@@ -55,21 +61,12 @@ bool resolveLibrary(const std::string& path, std::string* resolvedPath) {
     return false;
 }
 
-/** Loads a library given its relative path and stores the result in libEntry.
- * @return true on success with libEntry's path, handle and desc filled
- *         false on success with libEntry's path filled with the path of the failed lib
- * The caller MUST free the resources path (free) and handle (dlclose) if filled.
+/** Opens the library at libEntry's path and stores its handle and desc in libEntry.
+ * @return true on success with libEntry's handle and desc filled
+ *         false on failure, libEntry is unchanged
  */
-bool loadLibrary(const char* relativePath, lib_entry_t* libEntry) noexcept {
-
-    std::string absolutePath;
-    if (!resolveLibrary(relativePath, &absolutePath)) {
-        ALOGE("%s Could not find library in effect directories: %s", __func__, relativePath);
-        libEntry->path = strdup(relativePath);
-        return false;
-    }
-    const char* path = absolutePath.c_str();
-    libEntry->path = strdup(path);
+bool openLibrary(lib_entry_t* libEntry) noexcept {
+    const char* path = libEntry->path;
 
     // Make sure the lib is closed on early return
     std::unique_ptr<void, decltype(dlclose)*> libHandle(dlopen(path, RTLD_NOW),
@@ -106,6 +103,24 @@ bool loadLibrary(const char* relativePath, lib_entry_t* libEntry) noexcept {
     return true;
 }
 
+/** Loads a library given its relative path and stores the result in libEntry.
+ * @param[in] deferred if true, only resolve the path, the library is opened on first use.
+ * @return true on success with libEntry's path, and unless deferred, handle and desc filled
+ *         false on success with libEntry's path filled with the path of the failed lib
+ * The caller MUST free the resources path (free) and handle (dlclose) if filled.
+ */
+bool loadLibrary(const char* relativePath, lib_entry_t* libEntry, bool deferred) noexcept {
+
+    std::string absolutePath;
+    if (!resolveLibrary(relativePath, &absolutePath)) {
+        ALOGE("%s Could not find library in effect directories: %s", __func__, relativePath);
+        libEntry->path = strdup(relativePath);
+        return false;
+    }
+    libEntry->path = strdup(absolutePath.c_str());
+    return deferred || openLibrary(libEntry);
+}
+
 /** Because the structures will be destroyed by c code, using new to allocate shared structure
  * is not possible. Provide a equivalent of unique_ptr for malloc/freed structure to make sure
  * they are not leaked in the c++ code.
@@ -149,9 +164,225 @@ void listPush(UniqueCPtr<T>&& object, ListElem** list, pthread_mutex_t* mutex =
     listPush(object.release(), list, mutex);
 }
 
+/** Identifies a version of a file: if any field changes, the file is considered modified. */
+struct FileFingerprint {
+    uint64_t size = 0;
+    int64_t mtimeNs = 0;
+    uint64_t inode = 0;
+
+    bool operator==(const FileFingerprint& other) const {
+        return size == other.size && mtimeNs == other.mtimeNs && inode == other.inode;
+    }
+};
+
+bool getFingerprint(const std::string& path, FileFingerprint* fingerprint) {
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0) {
+        return false;
+    }
+    fingerprint->size = st.st_size;
+    fingerprint->mtimeNs = st.st_mtim.tv_sec * 1000000000LL + st.st_mtim.tv_nsec;
+    fingerprint->inode = st.st_ino;
+    return true;
+}
+
+/** Effect descriptors of the platform configuration, as returned by their libraries.
+ *
+ * Opening every library to query its descriptors dominates the factory initialization.
+ * After a load without error, the descriptors are saved to EFFECTS_DESCRIPTOR_CACHE_PATH
+ * together with the fingerprints of the configuration file and of the libraries.
+ * While none of these files changes, the next initialization reads the descriptors from the
+ * cache and defers opening each library until one of its effects is created.
+ */
+struct DescriptorCache {
+    struct CachedLibrary {
+        std::string name;
+        std::string path;
+        FileFingerprint fingerprint;
+    };
+    struct CachedDescriptor {
+        std::string library;
+        effect_uuid_t uuid;
+        effect_descriptor_t desc;
+    };
+
+    std::string configPath;
+    FileFingerprint configFingerprint;
+    std::vector<CachedLibrary> libraries; //< In configuration order
+    std::vector<CachedDescriptor> descriptors;
+    /** true if read from disk and up to date: the libraries must not be queried. */
+    bool valid = false;
+
+    const effect_descriptor_t* find(const char* library, const effect_uuid_t& uuid) const {
+        for (auto& cached : descriptors) {
+            if (cached.library == library &&
+                    memcmp(&cached.uuid, &uuid, sizeof(effect_uuid_t)) == 0) {
+                return &cached.desc;
+            }
+        }
+        return nullptr;
+    }
+};
+
+constexpr uint32_t kDescriptorCacheMagic = 0x43445845; // "EXDC"
+/** Bumped whenever the serialized layout changes. */
+constexpr uint32_t kDescriptorCacheVersion = 1;
+
+template <class T>
+void writePod(std::string* out, const T& value) {
+    out->append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+void writeString(std::string* out, const std::string& str) {
+    writePod(out, static_cast<uint32_t>(str.size()));
+    out->append(str);
+}
+
+struct CacheReader {
+    const char* cur;
+    const char* end;
+
+    template <class T>
+    bool readPod(T* value) {
+        if (static_cast<size_t>(end - cur) < sizeof(T)) {
+            return false;
+        }
+        memcpy(value, cur, sizeof(T));
+        cur += sizeof(T);
+        return true;
+    }
+
+    bool readString(std::string* str) {
+        uint32_t size;
+        if (!readPod(&size) || static_cast<size_t>(end - cur) < size) {
+            return false;
+        }
+        str->assign(cur, size);
+        cur += size;
+        return true;
+    }
+};
+
+bool readFile(const char* path, std::string* content) {
+    std::unique_ptr<FILE, decltype(fclose)*> file(fopen(path, "rbe"), fclose);
+    if (file == nullptr) {
+        return false;
+    }
+    char buffer[4096];
+    size_t size;
+    while ((size = fread(buffer, 1, sizeof(buffer), file.get())) > 0) {
+        content->append(buffer, size);
+    }
+    return ferror(file.get()) == 0;
+}
+
+/** Reads the descriptor cache and checks that it matches the configuration and libraries.
+ * @return true if the cache is valid for this configuration.
+ */
+bool readDescriptorCache(const std::string& configPath, const Libraries& libs,
+                         DescriptorCache* cache) {
+    std::string content;
+    if (!readFile(EFFECTS_DESCRIPTOR_CACHE_PATH, &content)) {
+        ALOGV("%s No descriptor cache", __func__);
+        return false;
+    }
+    CacheReader reader{content.data(), content.data() + content.size()};
+    uint32_t magic, version, descriptorSize, nbLibraries, nbDescriptors;
+    if (!reader.readPod(&magic) || magic != kDescriptorCacheMagic ||
+            !reader.readPod(&version) || version != kDescriptorCacheVersion ||
+            !reader.readPod(&descriptorSize) || descriptorSize != sizeof(effect_descriptor_t) ||
+            !reader.readString(&cache->configPath) ||
+            !reader.readPod(&cache->configFingerprint) ||
+            !reader.readPod(&nbLibraries)) {
+        ALOGW("%s Ignoring invalid descriptor cache", __func__);
+        return false;
+    }
+
+    FileFingerprint configFingerprint;
+    if (cache->configPath != configPath || !getFingerprint(configPath, &configFingerprint) ||
+            !(cache->configFingerprint == configFingerprint) || nbLibraries != libs.size()) {
+        ALOGI("%s Configuration %s changed, descriptor cache is stale",
+              __func__, configPath.c_str());
+        return false;
+    }
+
+    cache->libraries.resize(nbLibraries);
+    for (size_t i = 0; i < nbLibraries; ++i) {
+        auto& cached = cache->libraries[i];
+        if (!reader.readString(&cached.name) || !reader.readString(&cached.path) ||
+                !reader.readPod(&cached.fingerprint)) {
+            ALOGW("%s Ignoring invalid descriptor cache", __func__);
+            return false;
+        }
+        std::string absolutePath;
+        FileFingerprint fingerprint;
+        if (cached.name != libs[i]->name ||
+                !resolveLibrary(libs[i]->path, &absolutePath) || absolutePath != cached.path ||
+                !getFingerprint(absolutePath, &fingerprint) ||
+                !(cached.fingerprint == fingerprint)) {
+            ALOGI("%s Library %s changed, descriptor cache is stale",
+                  __func__, libs[i]->name.c_str());
+            return false;
+        }
+    }
+
+    if (!reader.readPod(&nbDescriptors)) {
+        ALOGW("%s Ignoring invalid descriptor cache", __func__);
+        return false;
+    }
+    cache->descriptors.resize(nbDescriptors);
+    for (auto& cached : cache->descriptors) {
+        if (!reader.readString(&cached.library) || !reader.readPod(&cached.uuid) ||
+                !reader.readPod(&cached.desc)) {
+            ALOGW("%s Ignoring invalid descriptor cache", __func__);
+            return false;
+        }
+    }
+    cache->valid = true;
+    return true;
+}
+
+/** Atomically replaces the descriptor cache with the provided one. */
+void writeDescriptorCache(const DescriptorCache& cache) {
+    std::string content;
+    writePod(&content, kDescriptorCacheMagic);
+    writePod(&content, kDescriptorCacheVersion);
+    writePod(&content, static_cast<uint32_t>(sizeof(effect_descriptor_t)));
+    writeString(&content, cache.configPath);
+    writePod(&content, cache.configFingerprint);
+    writePod(&content, static_cast<uint32_t>(cache.libraries.size()));
+    for (auto& cached : cache.libraries) {
+        writeString(&content, cached.name);
+        writeString(&content, cached.path);
+        writePod(&content, cached.fingerprint);
+    }
+    writePod(&content, static_cast<uint32_t>(cache.descriptors.size()));
+    for (auto& cached : cache.descriptors) {
+        writeString(&content, cached.library);
+        writePod(&content, cached.uuid);
+        writePod(&content, cached.desc);
+    }
+
+    const std::string tmpPath = std::string(EFFECTS_DESCRIPTOR_CACHE_PATH) + ".tmp";
+    FILE* file = fopen(tmpPath.c_str(), "wbe");
+    if (file == nullptr) {
+        ALOGW("%s Could not create %s: %s", __func__, tmpPath.c_str(), strerror(errno));
+        return;
+    }
+    bool success = fwrite(content.data(), 1, content.size(), file) == content.size();
+    success = fclose(file) == 0 && success;
+    if (!success || rename(tmpPath.c_str(), EFFECTS_DESCRIPTOR_CACHE_PATH) != 0) {
+        ALOGW("%s Could not write %s: %s", __func__, EFFECTS_DESCRIPTOR_CACHE_PATH,
+              strerror(errno));
+        unlink(tmpPath.c_str());
+        return;
+    }
+    ALOGV("%s Saved %zu descriptors", __func__, cache.descriptors.size());
+}
+
 size_t loadLibraries(const effectsConfig::Libraries& libs,
                      list_elem_t** libList, pthread_mutex_t* libListLock,
-                     list_elem_t** libFailedList)
+                     list_elem_t** libFailedList, DescriptorCache* cache)
 {
     size_t nbSkippedElement = 0;
     for (auto& library : libs) {
@@ -161,12 +392,18 @@ size_t loadLibraries(const effectsConfig::Libraries& libs,
         libEntry->effects = nullptr;
         pthread_mutex_init(&libEntry->lock, nullptr);
 
-        if (!loadLibrary(library->path.c_str(), libEntry.get())) {
+        if (!loadLibrary(library->path.c_str(), libEntry.get(), cache->valid)) {
             // Register library load failure
             listPush(std::move(libEntry), libFailedList);
             ++nbSkippedElement;
             continue;
         }
+        if (!cache->valid) {
+            DescriptorCache::CachedLibrary cached{library->name, libEntry->path, {}};
+            if (getFingerprint(cached.path, &cached.fingerprint)) {
+                cache->libraries.push_back(std::move(cached));
+            }
+        }
         listPush(std::move(libEntry), libList, libListLock);
     }
     return nbSkippedElement;
@@ -209,7 +446,8 @@ struct LoadEffectResult {
 };
 
 LoadEffectResult loadEffect(const std::shared_ptr<const EffectImpl>& effect,
-                            const std::string& name, list_elem_t* libList) {
+                            const std::string& name, list_elem_t* libList,
+                            DescriptorCache* cache) {
     LoadEffectResult result;
 
     // Find the effect library
@@ -222,12 +460,23 @@ LoadEffectResult loadEffect(const std::shared_ptr<const EffectImpl>& effect,
 
     result.effectDesc = makeUniqueC<effect_descriptor_t>();
 
-    // Get the effect descriptor
-    if (result.lib->desc->get_descriptor(&effect->uuid, result.effectDesc.get()) != 0) {
+    // Get the effect descriptor, from the cache if the library is not open
+    if (cache->valid) {
+        const effect_descriptor_t* cachedDesc = cache->find(result.lib->name, effect->uuid);
+        if (cachedDesc == nullptr) {
+            ALOGE("Effect %s of lib %s missing from descriptor cache",
+                  uuidToString(effect->uuid), result.lib->name);
+            result.effectDesc.reset();
+            return result;
+        }
+        *result.effectDesc = *cachedDesc;
+    } else if (result.lib->desc->get_descriptor(&effect->uuid, result.effectDesc.get()) != 0) {
         ALOGE("Error querying effect %s on lib %s",
               uuidToString(effect->uuid), result.lib->name);
         result.effectDesc.reset();
         return result;
+    } else {
+        cache->descriptors.push_back({result.lib->name, effect->uuid, *result.effectDesc});
     }
 
     // Dump effect for debug
@@ -257,7 +506,7 @@ LoadEffectResult loadEffect(const std::shared_ptr<const EffectImpl>& effect,
 }
 
 size_t loadEffects(const Effects& effects, list_elem_t* libList, list_elem_t** skippedEffects,
-                   list_sub_elem_t** subEffectList) {
+                   list_sub_elem_t** subEffectList, DescriptorCache* cache) {
     size_t nbSkippedElement = 0;
 
     for (auto& effect : effects) {
@@ -265,7 +514,7 @@ size_t loadEffects(const Effects& effects, list_elem_t* libList, list_elem_t** s
             continue;
         }
 
-        auto effectLoadResult = loadEffect(effect, effect->name, libList);
+        auto effectLoadResult = loadEffect(effect, effect->name, libList, cache);
         if (!effectLoadResult.success) {
             if (effectLoadResult.effectDesc != nullptr) {
                 listPush(std::move(effectLoadResult.effectDesc), skippedEffects);
@@ -275,8 +524,10 @@ size_t loadEffects(const Effects& effects, list_elem_t* libList, list_elem_t** s
         }
 
         if (effect->isProxy) {
-            auto swEffectLoadResult = loadEffect(effect->libSw, effect->name + " libsw", libList);
-            auto hwEffectLoadResult = loadEffect(effect->libHw, effect->name + " libhw", libList);
+            auto swEffectLoadResult =
+                    loadEffect(effect->libSw, effect->name + " libsw", libList, cache);
+            auto hwEffectLoadResult =
+                    loadEffect(effect->libHw, effect->name + " libhw", libList, cache);
             if (!swEffectLoadResult.success || !hwEffectLoadResult.success) {
                 // Push the main effect in the skipped list even if only a subeffect is invalid
                 // as the main effect is not usable without its subeffects.
@@ -324,10 +575,33 @@ extern "C" ssize_t EffectLoadXmlEffectConfig(const char* path)
         ALOGE("Failed to parse XML configuration file");
         return -1;
     }
+
+    // Only the platform configuration is cached
+    const bool useCache = path == nullptr && !result.configPath.empty() &&
+                          property_get_bool(PROPERTY_EFFECTS_DESCRIPTOR_CACHE, true);
+    DescriptorCache cache;
+    if (useCache && readDescriptorCache(result.configPath, result.parsedConfig->libraries,
+                                        &cache)) {
+        ALOGI("%s Using descriptor cache, effect libraries are opened on first use", __func__);
+    } else {
+        cache = DescriptorCache{};
+        cache.configPath = result.configPath;
+    }
+    const bool fillCache = useCache && !cache.valid &&
+                           getFingerprint(cache.configPath, &cache.configFingerprint);
+
     result.nbSkippedElement += loadLibraries(result.parsedConfig->libraries,
-                                             &gLibraryList, &gLibLock, &gLibraryFailedList) +
+                                             &gLibraryList, &gLibLock, &gLibraryFailedList,
+                                             &cache) +
                                loadEffects(result.parsedConfig->effects, gLibraryList,
-                                           &gSkippedEffects, &gSubEffectList);
+                                           &gSkippedEffects, &gSubEffectList, &cache);
+
+    // Do not cache a partially invalid configuration, so that its errors are reported on
+    // every initialization.
+    if (fillCache && result.nbSkippedElement == 0 &&
+            cache.libraries.size() == result.parsedConfig->libraries.size()) {
+        writeDescriptorCache(cache);
+    }
 
     ALOGE_IF(result.nbSkippedElement != 0, "%s %zu errors during loading of configuration: %s",
              __func__, result.nbSkippedElement,
@@ -336,4 +610,13 @@ extern "C" ssize_t EffectLoadXmlEffectConfig(const char* path)
     return result.nbSkippedElement;
 }
 
+extern "C" int EffectOpenDeferredLibrary(lib_entry_t* lib)
+{
+    if (lib->handle != nullptr) {
+        return 0;
+    }
+    ALOGV("%s Opening library %s", __func__, lib->name);
+    return openLibrary(lib) ? 0 : -ENODEV;
+}
+
 } // namespace android
@@ -160,24 +160,13 @@ constexpr int kSampleRate = 44100;
  * BM_LVM/24/3     183192 ns       182634 ns         3824
  *******************************************************************/
 
-static void BM_LVM(benchmark::State& state) {
-    const size_t chMask = kChMasks[state.range(0) - 1];
-    const effect_uuid_t uuid = kEffectUuids[state.range(1)];
-    const size_t channelCount = audio_channel_count_from_out_mask(chMask);
-
-    // Initialize input buffer with deterministic pseudo-random values
-    std::minstd_rand gen(chMask);
-    std::uniform_real_distribution<> dis(-1.0f, 1.0f);
-    std::vector<float> input(kFrameCount * channelCount);
-    for (auto& in : input) {
-        in = dis(gen);
-    }
-
+// Creates, configures and enables an effect of the bundle in session 1.
+static effect_handle_t createEffect(const effect_uuid_t& uuid, audio_channel_mask_t chMask) {
     effect_handle_t effectHandle = nullptr;
     if (int status = AUDIO_EFFECT_LIBRARY_INFO_SYM.create_effect(&uuid, 1, 1, &effectHandle);
         status != 0) {
         ALOGE("create_effect returned an error = %d\n", status);
-        return;
+        return nullptr;
     }
 
     effect_config_t config{};
@@ -192,7 +181,8 @@ static void BM_LVM(benchmark::State& state) {
                                        &config, &replySize, &reply);
         status != 0) {
         ALOGE("command returned an error = %d\n", status);
-        return;
+        AUDIO_EFFECT_LIBRARY_INFO_SYM.release_effect(effectHandle);
+        return nullptr;
     }
 
     if (int status =
@@ -200,29 +190,69 @@ static void BM_LVM(benchmark::State& state) {
                         ->command(effectHandle, EFFECT_CMD_ENABLE, 0, nullptr, &replySize, &reply);
         status != 0) {
         ALOGE("Command enable call returned error %d\n", reply);
-        return;
+        AUDIO_EFFECT_LIBRARY_INFO_SYM.release_effect(effectHandle);
+        return nullptr;
+    }
+    return effectHandle;
+}
+
+// Processes frameCount frames through the given effects of one bundle, which run the
+// bundle once per set of enabled effects.
+static void runEffects(benchmark::State& state, const std::vector<effect_uuid_t>& uuids,
+                       audio_channel_mask_t chMask, size_t frameCount) {
+    const size_t channelCount = audio_channel_count_from_out_mask(chMask);
+
+    // Initialize input buffer with deterministic pseudo-random values
+    std::minstd_rand gen(chMask);
+    std::uniform_real_distribution<> dis(-1.0f, 1.0f);
+    std::vector<float> input(frameCount * channelCount);
+    for (auto& in : input) {
+        in = dis(gen);
+    }
+    std::vector<float> output(frameCount * channelCount);
+
+    std::vector<effect_handle_t> effectHandles;
+    for (const auto& uuid : uuids) {
+        effect_handle_t effectHandle = createEffect(uuid, chMask);
+        if (effectHandle == nullptr) {
+            state.SkipWithError("failed to create effect");
+            break;
+        }
+        effectHandles.push_back(effectHandle);
     }
 
     // Run the test
-    for (auto _ : state) {
-        std::vector<float> output(kFrameCount * channelCount);
+    if (effectHandles.size() == uuids.size()) {
+        for (auto _ : state) {
+            benchmark::DoNotOptimize(input.data());
+            benchmark::DoNotOptimize(output.data());
 
-        benchmark::DoNotOptimize(input.data());
-        benchmark::DoNotOptimize(output.data());
+            for (effect_handle_t effectHandle : effectHandles) {
+                audio_buffer_t inBuffer = {.frameCount = frameCount, .f32 = input.data()};
+                audio_buffer_t outBuffer = {.frameCount = frameCount, .f32 = output.data()};
+                (*effectHandle)->process(effectHandle, &inBuffer, &outBuffer);
+            }
 
-        audio_buffer_t inBuffer = {.frameCount = kFrameCount, .f32 = input.data()};
-        audio_buffer_t outBuffer = {.frameCount = kFrameCount, .f32 = output.data()};
-        (*effectHandle)->process(effectHandle, &inBuffer, &outBuffer);
+            benchmark::ClobberMemory();
+        }
+        state.SetItemsProcessed(state.iterations() * frameCount);
+    }
 
-        benchmark::ClobberMemory();
+    for (effect_handle_t effectHandle : effectHandles) {
+        if (int status = AUDIO_EFFECT_LIBRARY_INFO_SYM.release_effect(effectHandle);
+            status != 0) {
+            ALOGE("release_effect returned an error = %d\n", status);
+        }
     }
+}
 
-    state.SetComplexityN(state.range(0));
+static void BM_LVM(benchmark::State& state) {
+    const audio_channel_mask_t chMask = kChMasks[state.range(0) - 1];
+    const effect_uuid_t uuid = kEffectUuids[state.range(1)];
 
-    if (int status = AUDIO_EFFECT_LIBRARY_INFO_SYM.release_effect(effectHandle); status != 0) {
-        ALOGE("release_effect returned an error = %d\n", status);
-        return;
-    }
+    runEffects(state, {uuid}, chMask, kFrameCount);
+
+    state.SetComplexityN(state.range(0));
 }
 
 static void LVMArgs(benchmark::internal::Benchmark* b) {
@@ -235,4 +265,54 @@ static void LVMArgs(benchmark::internal::Benchmark* b) {
 
 BENCHMARK(BM_LVM)->Apply(LVMArgs);
 
+/*******************************************************************
+ * Frame count sweep, for the channel counts and buffer sizes seen
+ * in playback: the first parameter indicates the number of channels,
+ * the second the effect as for BM_LVM, the third the frame count.
+ *******************************************************************/
+
+constexpr int kSweepChannelCounts[] = {FCC_1, FCC_2, 6 /* 5.1 */, FCC_8, FCC_12};
+constexpr int kSweepFrameCounts[] = {48, 192, 480, 960, 2048};
+
+static void BM_LVM_FrameCount(benchmark::State& state) {
+    const audio_channel_mask_t chMask = kChMasks[state.range(0) - 1];
+    const effect_uuid_t uuid = kEffectUuids[state.range(1)];
+
+    runEffects(state, {uuid}, chMask, state.range(2));
+}
+
+static void LVMFrameCountArgs(benchmark::internal::Benchmark* b) {
+    for (int channelCount : kSweepChannelCounts) {
+        for (int j = 0; j < kNumEffectUuids; ++j) {
+            for (int frameCount : kSweepFrameCounts) {
+                b->Args({channelCount, j, frameCount});
+            }
+        }
+    }
+}
+
+BENCHMARK(BM_LVM_FrameCount)->Apply(LVMFrameCountArgs);
+
+/*******************************************************************
+ * Equalizer and virtualizer enabled together on one bundle, the
+ * common music playback configuration: the first parameter indicates
+ * the number of channels, the second the frame count.
+ *******************************************************************/
+
+static void BM_LVM_EqVirtualizer(benchmark::State& state) {
+    const audio_channel_mask_t chMask = kChMasks[state.range(0) - 1];
+
+    runEffects(state, {kEffectUuids[2], kEffectUuids[1]}, chMask, state.range(1));
+}
+
+static void LVMEqVirtualizerArgs(benchmark::internal::Benchmark* b) {
+    for (int channelCount : kSweepChannelCounts) {
+        for (int frameCount : kSweepFrameCounts) {
+            b->Args({channelCount, frameCount});
+        }
+    }
+}
+
+BENCHMARK(BM_LVM_EqVirtualizer)->Apply(LVMEqVirtualizerArgs);
+
 BENCHMARK_MAIN();
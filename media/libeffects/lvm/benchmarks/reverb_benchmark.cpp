@@ -37,8 +37,23 @@ constexpr effect_uuid_t kEffectUuids[] = {
          0x11df,
          0x8ddc,
          {0x00, 0x02, 0xa5, 0xd5, 0xc5, 0x1b}},  // preset-aux mode
+        {0xc7a511a0,
+         0xa3bb,
+         0x11df,
+         0x860e,
+         {0x00, 0x02, 0xa5, 0xd5, 0xc5, 0x1b}},  // environmental-insert mode
+        {0x4a387fc0,
+         0x8ab3,
+         0x11df,
+         0x8bad,
+         {0x00, 0x02, 0xa5, 0xd5, 0xc5, 0x1b}},  // environmental-aux mode
 };
 
+// Whether kEffectUuids[i] is an auxiliary effect, which takes a mono send as input.
+constexpr bool kEffectIsAux[] = {false, true, false, true};
+// Whether kEffectUuids[i] is a preset reverb.
+constexpr bool kEffectIsPreset[] = {true, true, false, false};
+
 constexpr size_t kNumEffectUuids = std::size(kEffectUuids);
 
 constexpr size_t kFrameCount = 2048;
@@ -77,7 +92,8 @@ int reverbSetConfigParam(uint32_t paramType, uint32_t paramValue, effect_handle_
  * A test result running on Pixel 3 with for comparison.
  * The first parameter indicates the preset level id.
  * The second parameter indicates the effect.
- * 0: preset-insert mode, 1: preset-aux mode
+ * 0: preset-insert mode, 1: preset-aux mode, 2: environmental-insert mode,
+ * 3: environmental-aux mode (the environmental modes ignore the preset)
  * --------------------------------------------------------
  * Benchmark              Time             CPU   Iterations
  * --------------------------------------------------------
@@ -97,41 +113,34 @@ int reverbSetConfigParam(uint32_t paramType, uint32_t paramValue, effect_handle_
  * BM_REVERB/6/1     589686 ns       587871 ns         1161
  *******************************************************************/
 
-static void BM_REVERB(benchmark::State& state) {
-    const size_t chMask = AUDIO_CHANNEL_OUT_STEREO;
-    const size_t preset = kPresets[state.range(0)];
-    const effect_uuid_t uuid = kEffectUuids[state.range(1)];
-    const size_t channelCount = audio_channel_count_from_out_mask(chMask);
-
-    // Initialize input buffer with deterministic pseudo-random values
-    std::minstd_rand gen(chMask);
-    std::uniform_real_distribution<> dis(-1.0f, 1.0f);
-    std::vector<float> input(kFrameCount * channelCount);
-    std::vector<float> output(kFrameCount * channelCount);
-    for (auto& in : input) {
-        in = dis(gen);
-    }
-
+// Creates, configures and enables the reverb kEffectUuids[effect] with the given preset.
+static effect_handle_t createReverb(size_t effect, int preset) {
+    const effect_uuid_t uuid = kEffectUuids[effect];
     effect_handle_t effectHandle = nullptr;
     if (int status = AUDIO_EFFECT_LIBRARY_INFO_SYM.create_effect(&uuid, 1, 1, &effectHandle);
         status != 0) {
         ALOGE("create_effect returned an error = %d\n", status);
-        return;
+        return nullptr;
     }
 
     effect_config_t config{};
     config.inputCfg.samplingRate = config.outputCfg.samplingRate = kSampleRate;
-    config.inputCfg.channels = config.outputCfg.channels = chMask;
+    config.inputCfg.channels =
+            kEffectIsAux[effect] ? AUDIO_CHANNEL_OUT_MONO : AUDIO_CHANNEL_OUT_STEREO;
+    config.outputCfg.channels = AUDIO_CHANNEL_OUT_STEREO;
     config.inputCfg.format = config.outputCfg.format = AUDIO_FORMAT_PCM_FLOAT;
+    config.outputCfg.accessMode = kEffectIsAux[effect] ? EFFECT_BUFFER_ACCESS_ACCUMULATE
+                                                        : EFFECT_BUFFER_ACCESS_WRITE;
 
     int reply = 0;
     uint32_t replySize = sizeof(reply);
     if (int status = (*effectHandle)
                              ->command(effectHandle, EFFECT_CMD_SET_CONFIG, sizeof(effect_config_t),
                                        &config, &replySize, &reply);
-        status != 0) {
-        ALOGE("command returned an error = %d\n", status);
-        return;
+        status != 0 || reply != 0) {
+        ALOGE("command returned an error = %d, reply %d\n", status, reply);
+        AUDIO_EFFECT_LIBRARY_INFO_SYM.release_effect(effectHandle);
+        return nullptr;
     }
 
     if (int status =
@@ -139,34 +148,77 @@ static void BM_REVERB(benchmark::State& state) {
                         ->command(effectHandle, EFFECT_CMD_ENABLE, 0, nullptr, &replySize, &reply);
         status != 0) {
         ALOGE("Command enable call returned error %d\n", reply);
-        return;
+        AUDIO_EFFECT_LIBRARY_INFO_SYM.release_effect(effectHandle);
+        return nullptr;
     }
 
-    if (int status = reverbSetConfigParam(REVERB_PARAM_PRESET, preset, effectHandle); status != 0) {
-        ALOGE("Invalid reverb preset. Error %d\n", status);
-        return;
+    if (kEffectIsPreset[effect]) {
+        if (int status = reverbSetConfigParam(REVERB_PARAM_PRESET, preset, effectHandle);
+            status != 0) {
+            ALOGE("Invalid reverb preset. Error %d\n", status);
+            AUDIO_EFFECT_LIBRARY_INFO_SYM.release_effect(effectHandle);
+            return nullptr;
+        }
     }
+    return effectHandle;
+}
 
-    // Run the test
-    for (auto _ : state) {
-        benchmark::DoNotOptimize(input.data());
-        benchmark::DoNotOptimize(output.data());
+// Processes frameCount frames through instanceCount reverbs kEffectUuids[effect], each
+// with its own input, as when several sessions use reverb on one output.
+static void runReverb(benchmark::State& state, size_t effect, int preset, size_t frameCount,
+                      size_t instanceCount = 1) {
+    const size_t inChannelCount = kEffectIsAux[effect] ? FCC_1 : FCC_2;
 
-        audio_buffer_t inBuffer = {.frameCount = kFrameCount, .f32 = input.data()};
-        audio_buffer_t outBuffer = {.frameCount = kFrameCount, .f32 = output.data()};
-        (*effectHandle)->process(effectHandle, &inBuffer, &outBuffer);
+    // Initialize input buffer with deterministic pseudo-random values
+    std::minstd_rand gen(AUDIO_CHANNEL_OUT_STEREO);
+    std::uniform_real_distribution<> dis(-1.0f, 1.0f);
+    std::vector<float> input(frameCount * inChannelCount);
+    std::vector<float> output(frameCount * FCC_2);
+    for (auto& in : input) {
+        in = dis(gen);
+    }
 
-        benchmark::ClobberMemory();
+    std::vector<effect_handle_t> effectHandles;
+    for (size_t i = 0; i < instanceCount; ++i) {
+        effect_handle_t effectHandle = createReverb(effect, preset);
+        if (effectHandle == nullptr) {
+            state.SkipWithError("failed to create reverb");
+            break;
+        }
+        effectHandles.push_back(effectHandle);
     }
 
-    state.SetComplexityN(state.range(0));
+    // Run the test
+    if (effectHandles.size() == instanceCount) {
+        for (auto _ : state) {
+            benchmark::DoNotOptimize(input.data());
+            benchmark::DoNotOptimize(output.data());
+
+            for (effect_handle_t effectHandle : effectHandles) {
+                audio_buffer_t inBuffer = {.frameCount = frameCount, .f32 = input.data()};
+                audio_buffer_t outBuffer = {.frameCount = frameCount, .f32 = output.data()};
+                (*effectHandle)->process(effectHandle, &inBuffer, &outBuffer);
+            }
 
-    if (int status = AUDIO_EFFECT_LIBRARY_INFO_SYM.release_effect(effectHandle); status != 0) {
-        ALOGE("release_effect returned an error = %d\n", status);
-        return;
+            benchmark::ClobberMemory();
+        }
+        state.SetItemsProcessed(state.iterations() * frameCount * instanceCount);
+    }
+
+    for (effect_handle_t effectHandle : effectHandles) {
+        if (int status = AUDIO_EFFECT_LIBRARY_INFO_SYM.release_effect(effectHandle);
+            status != 0) {
+            ALOGE("release_effect returned an error = %d\n", status);
+        }
     }
 }
 
+static void BM_REVERB(benchmark::State& state) {
+    runReverb(state, state.range(1), kPresets[state.range(0)], kFrameCount);
+
+    state.SetComplexityN(state.range(0));
+}
+
 static void REVERBArgs(benchmark::internal::Benchmark* b) {
     for (int i = 0; i < kNumPresets; i++) {
         for (int j = 0; j < kNumEffectUuids; ++j) {
@@ -177,4 +229,47 @@ static void REVERBArgs(benchmark::internal::Benchmark* b) {
 
 BENCHMARK(BM_REVERB)->Apply(REVERBArgs);
 
+/*******************************************************************
+ * Frame count sweep with the large hall preset: the first parameter
+ * indicates the effect as for BM_REVERB, the second the frame count.
+ *******************************************************************/
+
+constexpr int kSweepFrameCounts[] = {48, 192, 480, 960, 2048};
+
+static void BM_REVERB_FrameCount(benchmark::State& state) {
+    runReverb(state, state.range(0), REVERB_PRESET_LARGEHALL, state.range(1));
+}
+
+static void REVERBFrameCountArgs(benchmark::internal::Benchmark* b) {
+    for (int j = 0; j < kNumEffectUuids; ++j) {
+        for (int frameCount : kSweepFrameCounts) {
+            b->Args({j, frameCount});
+        }
+    }
+}
+
+BENCHMARK(BM_REVERB_FrameCount)->Apply(REVERBFrameCountArgs);
+
+/*******************************************************************
+ * Several reverb instances on one output with the large hall preset,
+ * as when a game attaches reverb to many sessions: the first
+ * parameter indicates the effect as for BM_REVERB, the second the
+ * number of instances. Each instance processes 960 frames.
+ *******************************************************************/
+
+static void BM_REVERB_Instances(benchmark::State& state) {
+    runReverb(state, state.range(0), REVERB_PRESET_LARGEHALL, 960 /* frameCount */,
+              state.range(1));
+}
+
+static void REVERBInstancesArgs(benchmark::internal::Benchmark* b) {
+    for (int j = 0; j < kNumEffectUuids; ++j) {
+        for (int instanceCount : {1, 2, 4, 8}) {
+            b->Args({j, instanceCount});
+        }
+    }
+}
+
+BENCHMARK(BM_REVERB_Instances)->Apply(REVERBInstancesArgs);
+
 BENCHMARK_MAIN();
@@ -20,10 +20,18 @@
 ***********************************************************************************/
 #include "ScalarArithmetic.h"
 #include "VectorArithmetic.h"
+#include "LVM_Simd.h"
 
 void Add2_Sat_Float(const LVM_FLOAT* src, LVM_FLOAT* dst, LVM_INT16 n) {
     LVM_FLOAT Temp;
     LVM_INT16 ii;
+#if LVM_SIMD_WIDTH > 1
+    for (; n >= LVM_SIMD_WIDTH; n -= LVM_SIMD_WIDTH) {
+        LVM_Simd_Store(dst, LVM_Simd_Clamp(LVM_Simd_Add(LVM_Simd_Load(src), LVM_Simd_Load(dst))));
+        src += LVM_SIMD_WIDTH;
+        dst += LVM_SIMD_WIDTH;
+    }
+#endif
     for (ii = n; ii != 0; ii--) {
         Temp = *src++ + *dst;
         *dst++ = LVM_Clamp(Temp);
@@ -21,15 +21,42 @@
 #include "LVC_Mixer_Private.h"
 #include "LVM_Macros.h"
 #include "ScalarArithmetic.h"
+#include "LVM_Simd.h"
 
 void LVC_Core_MixHard_1St_MC_float_SAT(Mix_Private_FLOAT_st** ptrInstance, const LVM_FLOAT* src,
                                        LVM_FLOAT* dst, LVM_INT16 NrFrames, LVM_INT16 NrChannels) {
     LVM_FLOAT Temp;
     LVM_INT16 ii, jj;
+    LVM_FLOAT Gain[LVM_MAX_CHANNELS];
+    for (jj = 0; jj < NrChannels; jj++) {
+        Gain[jj] = ptrInstance[jj]->Current;
+    }
+#if LVM_SIMD_WIDTH > 1
+    /*
+     * LVM_SIMD_WIDTH frames of NrChannels samples are exactly NrChannels vectors, and the
+     * per lane gains of those vectors repeat every LVM_SIMD_WIDTH frames.
+     */
+    LVM_Simd_t BlockGain[LVM_MAX_CHANNELS];
+    {
+        LVM_FLOAT LaneGain[LVM_SIMD_WIDTH];
+        for (jj = 0; jj < NrChannels; jj++) {
+            for (LVM_INT16 lane = 0; lane < LVM_SIMD_WIDTH; lane++) {
+                LaneGain[lane] = Gain[(jj * LVM_SIMD_WIDTH + lane) % NrChannels];
+            }
+            BlockGain[jj] = LVM_Simd_Load(LaneGain);
+        }
+    }
+    for (; NrFrames >= LVM_SIMD_WIDTH; NrFrames -= LVM_SIMD_WIDTH) {
+        for (jj = 0; jj < NrChannels; jj++) {
+            LVM_Simd_Store(dst, LVM_Simd_Clamp(LVM_Simd_Mul(LVM_Simd_Load(src), BlockGain[jj])));
+            src += LVM_SIMD_WIDTH;
+            dst += LVM_SIMD_WIDTH;
+        }
+    }
+#endif
     for (ii = NrFrames; ii != 0; ii--) {
         for (jj = 0; jj < NrChannels; jj++) {
-            Mix_Private_FLOAT_st* pInstance1 = (Mix_Private_FLOAT_st*)(ptrInstance[jj]);
-            Temp =  *src++ * pInstance1->Current;
+            Temp = *src++ * Gain[jj];
             *dst++ = LVM_Clamp(Temp);
         }
     }
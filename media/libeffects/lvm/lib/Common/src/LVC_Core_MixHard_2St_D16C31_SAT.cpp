@@ -20,6 +20,7 @@
 ***********************************************************************************/
 #include "LVC_Mixer_Private.h"
 #include "ScalarArithmetic.h"
+#include "LVM_Simd.h"
 
 /**********************************************************************************
    FUNCTION LVCore_MIXHARD_2ST_D16C31_SAT
@@ -37,6 +38,17 @@ void LVC_Core_MixHard_2St_D16C31_SAT(LVMixer3_FLOAT_st* ptrInstance1,
     Current1 = pInstance1->Current;
     Current2 = pInstance2->Current;
 
+#if LVM_SIMD_WIDTH > 1
+    const LVM_Simd_t gain1 = LVM_Simd_Dup(Current1);
+    const LVM_Simd_t gain2 = LVM_Simd_Dup(Current2);
+    for (; n >= LVM_SIMD_WIDTH; n -= LVM_SIMD_WIDTH) {
+        LVM_Simd_Store(dst, LVM_Simd_Clamp(LVM_Simd_Add(LVM_Simd_Mul(LVM_Simd_Load(src1), gain1),
+                                                        LVM_Simd_Mul(LVM_Simd_Load(src2), gain2))));
+        src1 += LVM_SIMD_WIDTH;
+        src2 += LVM_SIMD_WIDTH;
+        dst += LVM_SIMD_WIDTH;
+    }
+#endif
     for (ii = n; ii != 0; ii--) {
         Temp =  *src1++ * Current1 + *src2++ * Current2;
         *dst++ = LVM_Clamp(Temp);
@@ -21,6 +21,23 @@
 #include "LVC_Mixer_Private.h"
 #include "LVM_Macros.h"
 #include "ScalarArithmetic.h"
+#include "LVM_Simd.h"
+
+/* Scales n samples by Gain, advancing src and dst */
+static inline void ScaleSamples(const LVM_FLOAT*& src, LVM_FLOAT*& dst, LVM_FLOAT Gain,
+                                LVM_INT32 n) {
+#if LVM_SIMD_WIDTH > 1
+    const LVM_Simd_t GainVec = LVM_Simd_Dup(Gain);
+    for (; n >= LVM_SIMD_WIDTH; n -= LVM_SIMD_WIDTH) {
+        LVM_Simd_Store(dst, LVM_Simd_Mul(LVM_Simd_Load(src), GainVec));
+        src += LVM_SIMD_WIDTH;
+        dst += LVM_SIMD_WIDTH;
+    }
+#endif
+    for (; n != 0; n--) {
+        *(dst++) = *(src++) * Gain;
+    }
+}
 
 /**********************************************************************************
    FUNCTION LVCore_MIXSOFT_1ST_D16C31_WRA
@@ -102,7 +119,7 @@ void LVC_Core_MixSoft_Mc_D16C31_WRA(LVMixer3_FLOAT_st* ptrInstance, const LVM_FL
                                     LVM_FLOAT* dst, LVM_INT16 NrFrames, LVM_INT16 NrChannels) {
     LVM_INT16 OutLoop;
     LVM_INT16 InLoop;
-    LVM_INT32 ii, jj;
+    LVM_INT32 ii;
     Mix_Private_FLOAT_st* pInstance = (Mix_Private_FLOAT_st*)(ptrInstance->PrivateParams);
     LVM_FLOAT Delta = (LVM_FLOAT)pInstance->Delta;
     LVM_FLOAT Current = (LVM_FLOAT)pInstance->Current;
@@ -122,42 +139,28 @@ void LVC_Core_MixSoft_Mc_D16C31_WRA(LVMixer3_FLOAT_st* ptrInstance, const LVM_FL
             Current = LVM_Clamp(Current + Delta);
             if (Current > Target) Current = Target;
 
-            for (ii = OutLoop; ii != 0; ii--) {
-                for (jj = NrChannels; jj != 0; jj--) {
-                    *(dst++) = (((LVM_FLOAT) * (src++) * (LVM_FLOAT)Current));
-                }
-            }
+            ScaleSamples(src, dst, Current, OutLoop * NrChannels);
         }
 
         for (ii = InLoop; ii != 0; ii--) {
             Current = LVM_Clamp(Current + Delta);
             if (Current > Target) Current = Target;
 
-            for (jj = NrChannels; jj != 0; jj--) {
-                *(dst++) = (((LVM_FLOAT) * (src++) * Current));
-                *(dst++) = (((LVM_FLOAT) * (src++) * Current));
-            }
+            ScaleSamples(src, dst, Current, 2 * NrChannels);
         }
     } else {
         if (OutLoop) {
             Current -= Delta;
             if (Current < Target) Current = Target;
 
-            for (ii = OutLoop; ii != 0; ii--) {
-                for (jj = NrChannels; jj != 0; jj--) {
-                    *(dst++) = (((LVM_FLOAT) * (src++) * (LVM_FLOAT)Current));
-                }
-            }
+            ScaleSamples(src, dst, Current, OutLoop * NrChannels);
         }
 
         for (ii = InLoop; ii != 0; ii--) {
             Current -= Delta;
             if (Current < Target) Current = Target;
 
-            for (jj = NrChannels; jj != 0; jj--) {
-                *(dst++) = (((LVM_FLOAT) * (src++) * Current));
-                *(dst++) = (((LVM_FLOAT) * (src++) * Current));
-            }
+            ScaleSamples(src, dst, Current, 2 * NrChannels);
         }
     }
     pInstance->Current = Current;
@@ -0,0 +1,102 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __LVM_SIMD_H__
+#define __LVM_SIMD_H__
+
+/**********************************************************************************
+   INCLUDE FILES
+***********************************************************************************/
+
+#include "LVM_Types.h"
+
+/*
+ * Explicit SIMD primitives for the float vector and mixer routines of the Common library.
+ *
+ * LVM_SIMD_WIDTH is the number of floats per vector, or 1 when no SIMD is available;
+ * callers then fall through to their scalar loop.
+ *
+ * LVM_Simd_Clamp() matches LVM_Clamp(): a NaN input is clamped to -1.  NEON is only
+ * enabled on aarch64, where vmaxnm/vminnm provide that behaviour.
+ *
+ * To disable for benchmarking, compile with -DUSE_NEON=false (arm) or -DUSE_SSE=false (x86).
+ */
+
+#if defined(__aarch64__) && !(defined(USE_NEON) && !USE_NEON)
+#define LVM_SIMD_USE_NEON (true)
+#include <arm_neon.h>
+#else
+#define LVM_SIMD_USE_NEON (false)
+#endif
+
+#if defined(__SSE2__) && !(defined(USE_SSE) && !USE_SSE)
+#define LVM_SIMD_USE_SSE (true)
+#include <immintrin.h>
+#else
+#define LVM_SIMD_USE_SSE (false)
+#endif
+
+#if LVM_SIMD_USE_NEON
+
+#define LVM_SIMD_WIDTH 4
+typedef float32x4_t LVM_Simd_t;
+
+static inline LVM_Simd_t LVM_Simd_Load(const LVM_FLOAT* p) { return vld1q_f32(p); }
+static inline void LVM_Simd_Store(LVM_FLOAT* p, LVM_Simd_t v) { vst1q_f32(p, v); }
+static inline LVM_Simd_t LVM_Simd_Dup(LVM_FLOAT f) { return vdupq_n_f32(f); }
+static inline LVM_Simd_t LVM_Simd_Add(LVM_Simd_t a, LVM_Simd_t b) { return vaddq_f32(a, b); }
+static inline LVM_Simd_t LVM_Simd_Mul(LVM_Simd_t a, LVM_Simd_t b) { return vmulq_f32(a, b); }
+static inline LVM_Simd_t LVM_Simd_Clamp(LVM_Simd_t v) {
+    return vminnmq_f32(vmaxnmq_f32(v, vdupq_n_f32(-1.0f)), vdupq_n_f32(1.0f));
+}
+
+#elif LVM_SIMD_USE_SSE && defined(__AVX__)
+
+#define LVM_SIMD_WIDTH 8
+typedef __m256 LVM_Simd_t;
+
+static inline LVM_Simd_t LVM_Simd_Load(const LVM_FLOAT* p) { return _mm256_loadu_ps(p); }
+static inline void LVM_Simd_Store(LVM_FLOAT* p, LVM_Simd_t v) { _mm256_storeu_ps(p, v); }
+static inline LVM_Simd_t LVM_Simd_Dup(LVM_FLOAT f) { return _mm256_set1_ps(f); }
+static inline LVM_Simd_t LVM_Simd_Add(LVM_Simd_t a, LVM_Simd_t b) { return _mm256_add_ps(a, b); }
+static inline LVM_Simd_t LVM_Simd_Mul(LVM_Simd_t a, LVM_Simd_t b) { return _mm256_mul_ps(a, b); }
+static inline LVM_Simd_t LVM_Simd_Clamp(LVM_Simd_t v) {
+    // max/min return the second operand if either is NaN.
+    return _mm256_min_ps(_mm256_max_ps(v, _mm256_set1_ps(-1.0f)), _mm256_set1_ps(1.0f));
+}
+
+#elif LVM_SIMD_USE_SSE
+
+#define LVM_SIMD_WIDTH 4
+typedef __m128 LVM_Simd_t;
+
+static inline LVM_Simd_t LVM_Simd_Load(const LVM_FLOAT* p) { return _mm_loadu_ps(p); }
+static inline void LVM_Simd_Store(LVM_FLOAT* p, LVM_Simd_t v) { _mm_storeu_ps(p, v); }
+static inline LVM_Simd_t LVM_Simd_Dup(LVM_FLOAT f) { return _mm_set1_ps(f); }
+static inline LVM_Simd_t LVM_Simd_Add(LVM_Simd_t a, LVM_Simd_t b) { return _mm_add_ps(a, b); }
+static inline LVM_Simd_t LVM_Simd_Mul(LVM_Simd_t a, LVM_Simd_t b) { return _mm_mul_ps(a, b); }
+static inline LVM_Simd_t LVM_Simd_Clamp(LVM_Simd_t v) {
+    // max/min return the second operand if either is NaN.
+    return _mm_min_ps(_mm_max_ps(v, _mm_set1_ps(-1.0f)), _mm_set1_ps(1.0f));
+}
+
+#else
+
+#define LVM_SIMD_WIDTH 1
+
+#endif
+
+#endif /* __LVM_SIMD_H__ */
@@ -21,11 +21,20 @@
 
 #include "VectorArithmetic.h"
 #include "LVM_Macros.h"
+#include "LVM_Simd.h"
 
 void Mult3s_Float(const LVM_FLOAT* src, const LVM_FLOAT val, LVM_FLOAT* dst, LVM_INT16 n) {
     LVM_INT16 ii;
     LVM_FLOAT temp;
 
+#if LVM_SIMD_WIDTH > 1
+    const LVM_Simd_t gain = LVM_Simd_Dup(val);
+    for (; n >= LVM_SIMD_WIDTH; n -= LVM_SIMD_WIDTH) {
+        LVM_Simd_Store(dst, LVM_Simd_Mul(LVM_Simd_Load(src), gain));
+        src += LVM_SIMD_WIDTH;
+        dst += LVM_SIMD_WIDTH;
+    }
+#endif
     for (ii = n; ii != 0; ii--) {
         temp = (*src) * val;
         src++;
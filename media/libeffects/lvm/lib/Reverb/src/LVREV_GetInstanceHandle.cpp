@@ -94,8 +94,11 @@ LVREV_ReturnStatus_en LVREV_GetInstanceHandle(LVREV_Handle_t* phInstance,
     /*
      * Set the data, coefficient and temporary memory pointers
      */
+    pLVREV_Private->DelaySlack = LVREV_DELAY_SLACK_BLOCKS * MaxBlockSize;
     for (size_t i = 0; i < pInstanceParams->NumDelays; i++) {
-        pLVREV_Private->pDelay_T[i] = (LVM_FLOAT*)calloc(LVREV_MAX_T_DELAY[i], sizeof(LVM_FLOAT));
+        pLVREV_Private->pDelayBuffer[i] = (LVM_FLOAT*)calloc(
+                LVREV_MAX_T_DELAY[i] + pLVREV_Private->DelaySlack, sizeof(LVM_FLOAT));
+        pLVREV_Private->pDelay_T[i] = pLVREV_Private->pDelayBuffer[i];
         /* Scratch for each delay line output */
         pLVREV_Private->pScratchDelayLine[i] = (LVM_FLOAT*)calloc(MaxBlockSize, sizeof(LVM_FLOAT));
     }
@@ -246,8 +249,9 @@ LVREV_ReturnStatus_en LVREV_FreeInstance(LVREV_Handle_t hInstance) {
     LVREV_Instance_st* pLVREV_Private = (LVREV_Instance_st*)hInstance;
 
     for (size_t i = 0; i < pLVREV_Private->InstanceParams.NumDelays; i++) {
-        if (pLVREV_Private->pDelay_T[i]) {
-            free(pLVREV_Private->pDelay_T[i]);
+        if (pLVREV_Private->pDelayBuffer[i]) {
+            free(pLVREV_Private->pDelayBuffer[i]);
+            pLVREV_Private->pDelayBuffer[i] = LVM_NULL;
             pLVREV_Private->pDelay_T[i] = LVM_NULL;
         }
         if (pLVREV_Private->pScratchDelayLine[i]) {
@@ -82,6 +82,7 @@
 #define LVREV_ALLPASS_TAP_TC 10000 /* All-pass filter dely tap change */
 #define LVREV_FEEDBACKMIXER_TC 100 /* Feedback mixer time constant*/
 #define LVREV_OUTPUTGAIN_SHIFT 5   /* Bits shift for output gain correction */
+#define LVREV_DELAY_SLACK_BLOCKS 8 /* Blocks a delay line advances before it is re-aligned */
 
 /* Parameter limits */
 #define LVREV_NUM_FS 13 /* Number of supported sample rates */
@@ -137,7 +138,12 @@ typedef struct {
 
     /* All-Pass Filter */
     LVM_INT32 T[LVREV_DELAYLINES_4];                          /* Maximum delay size of buffer */
-    LVM_FLOAT* pDelay_T[LVREV_DELAYLINES_4];                  /* Pointer to delay buffers */
+    LVM_FLOAT* pDelay_T[LVREV_DELAYLINES_4];                  /* Current window of the delay \
+                                                                 buffers, T samples long */
+    LVM_FLOAT* pDelayBuffer[LVREV_DELAYLINES_4];              /* Delay buffer allocations, \
+                                                                 T + DelaySlack samples long */
+    LVM_INT32 DelaySlack;                                     /* Samples the windows may \
+                                                                 advance before re-alignment */
     LVM_INT32 Delay_AP[LVREV_DELAYLINES_4];                   /* Offset to AP delay buffer start */
     LVM_INT16 AB_Selection;                     /* Smooth from tap A to B when 1 \
                                                    otherwise B to A */
@@ -166,6 +172,7 @@ typedef struct {
 LVREV_ReturnStatus_en LVREV_ApplyNewSettings(LVREV_Instance_st* pPrivate);
 void ReverbBlock(LVM_FLOAT* pInput, LVM_FLOAT* pOutput, LVREV_Instance_st* pPrivate,
                  LVM_UINT16 NumSamples);
+void AdvanceDelayLine(LVREV_Instance_st* pPrivate, LVM_INT16 DelayLine, LVM_UINT16 NumSamples);
 LVM_INT32 BypassMixer_Callback(void* pCallbackData, void* pGeneralPurpose,
                                LVM_INT16 GeneralPurpose);
 
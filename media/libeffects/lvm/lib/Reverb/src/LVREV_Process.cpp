@@ -224,10 +224,9 @@ void ReverbBlock(LVM_FLOAT* pInput, LVM_FLOAT* pOutput, LVREV_Instance_st* pPriv
         /* Get the smoothed, delayed output. Put it in the output buffer */
         MixSoft_2St_D32C31_SAT(&pPrivate->Mixer_APTaps[j], pPrivate->pOffsetA[j],
                                pPrivate->pOffsetB[j], pDelayLine, (LVM_INT16)NumSamples);
-        /* Re-align the all pass filter delay buffer and copying the fixed delay data \
+        /* Advance the all pass filter delay buffer, moving the fixed delay data \
            to the AP delay in the process */
-        Copy_Float(&pPrivate->pDelay_T[j][NumSamples], pPrivate->pDelay_T[j],
-                   (LVM_INT16)(pPrivate->T[j] - NumSamples)); /* 32-bit data */
+        AdvanceDelayLine(pPrivate, j, NumSamples);
         /* Apply the smoothed feedback and save to fixed delay input (currently empty) */
         MixSoft_1St_D32C31_WRA(&pPrivate->Mixer_SGFeedback[j], pDelayLine,
                                &pPrivate->pDelay_T[j][pPrivate->T[j] - NumSamples],
@@ -394,4 +393,38 @@ void ReverbBlock(LVM_FLOAT* pInput, LVM_FLOAT* pOutput, LVREV_Instance_st* pPriv
 
     return;
 }
+/****************************************************************************************/
+/*                                                                                      */
+/* FUNCTION:                AdvanceDelayLine                                            */
+/*                                                                                      */
+/* DESCRIPTION:                                                                         */
+/*  Shifts the contents of a delay line by NumSamples towards its start, leaving the    */
+/*  last NumSamples samples to be written.                                              */
+/*                                                                                      */
+/*  The window of T samples slides along a buffer which is DelaySlack samples longer,   */
+/*  together with the delay taps, and the data is only copied back to the start of the */
+/*  buffer when the window reaches its end.  This replaces copying the whole delay line */
+/*  on every block.                                                                     */
+/*                                                                                      */
+/* PARAMETERS:                                                                          */
+/*  pPrivate                Pointer to the instance                                     */
+/*  DelayLine               Index of the delay line                                     */
+/*  NumSamples              Number of samples in the block, at most DelaySlack          */
+/*                                                                                      */
+/****************************************************************************************/
+void AdvanceDelayLine(LVREV_Instance_st* pPrivate, LVM_INT16 DelayLine, LVM_UINT16 NumSamples) {
+    LVM_FLOAT* pDelay = pPrivate->pDelay_T[DelayLine];
+    LVM_FLOAT* pNewDelay = pDelay + NumSamples;
+
+    if (pNewDelay + pPrivate->T[DelayLine] >
+        pPrivate->pDelayBuffer[DelayLine] + pPrivate->T[DelayLine] + pPrivate->DelaySlack) {
+        pNewDelay = pPrivate->pDelayBuffer[DelayLine];
+        Copy_Float(&pDelay[NumSamples], pNewDelay,
+                   (LVM_INT16)(pPrivate->T[DelayLine] - NumSamples)); /* 32-bit data */
+    }
+
+    pPrivate->pOffsetA[DelayLine] = pNewDelay + (pPrivate->pOffsetA[DelayLine] - pDelay);
+    pPrivate->pOffsetB[DelayLine] = pNewDelay + (pPrivate->pOffsetB[DelayLine] - pDelay);
+    pPrivate->pDelay_T[DelayLine] = pNewDelay;
+}
 /* End of file */
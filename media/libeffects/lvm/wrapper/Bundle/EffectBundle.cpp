@@ -250,7 +250,7 @@ extern "C" int EffectCreate(const effect_uuid_t* uuid, int32_t sessionId,
         pContext->pBundledContext->bStereoPositionEnabled = LVM_FALSE;
         pContext->pBundledContext->positionSaved = 0;
         pContext->pBundledContext->workBuffer = NULL;
-        pContext->pBundledContext->frameCount = -1;
+        pContext->pBundledContext->workBufferSamples = 0;
         pContext->pBundledContext->SamplesToExitCountVirt = 0;
         pContext->pBundledContext->SamplesToExitCountBb = 0;
         pContext->pBundledContext->SamplesToExitCountEq = 0;
@@ -638,16 +638,19 @@ int LvmBundle_process(effect_buffer_t* pIn, effect_buffer_t* pOut, int frameCoun
     if (pContext->config.outputCfg.accessMode == EFFECT_BUFFER_ACCESS_WRITE) {
         pOutTmp = pOut;
     } else if (pContext->config.outputCfg.accessMode == EFFECT_BUFFER_ACCESS_ACCUMULATE) {
-        if (pContext->pBundledContext->frameCount != frameCount) {
+        // The work buffer only grows, so that varying frame counts and channel
+        // reconfiguration don't reallocate on the audio thread.
+        if (pContext->pBundledContext->workBufferSamples < frameCount * NrChannels) {
             if (pContext->pBundledContext->workBuffer != NULL) {
                 free(pContext->pBundledContext->workBuffer);
             }
             pContext->pBundledContext->workBuffer =
                     (effect_buffer_t*)calloc(frameCount, sizeof(effect_buffer_t) * NrChannels);
             if (pContext->pBundledContext->workBuffer == NULL) {
+                pContext->pBundledContext->workBufferSamples = 0;
                 return -ENOMEM;
             }
-            pContext->pBundledContext->frameCount = frameCount;
+            pContext->pBundledContext->workBufferSamples = frameCount * NrChannels;
         }
         pOutTmp = pContext->pBundledContext->workBuffer;
     } else {
@@ -3047,7 +3050,7 @@ int Effect_process(effect_handle_t self, audio_buffer_t* inBuffer, audio_buffer_
             }
         } else if (outBuffer->raw != inBuffer->raw) {
             memcpy(outBuffer->raw, inBuffer->raw,
-                   outBuffer->frameCount * sizeof(effect_buffer_t) * FCC_2);
+                   outBuffer->frameCount * sizeof(effect_buffer_t) * NrChannels);
         }
     }
 
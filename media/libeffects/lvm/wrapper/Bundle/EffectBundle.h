@@ -85,7 +85,7 @@ struct BundledEffectContext {
     int SamplesToExitCountBb;
     int SamplesToExitCountVirt;
     effect_buffer_t* workBuffer;
-    int frameCount;
+    int workBufferSamples; /* capacity of workBuffer in samples */
     int32_t bandGaindB[FIVEBAND_NUMBANDS];
     int volume;
     LVM_INT32 ChMask;
@@ -21,6 +21,7 @@ typedef float LVM_FLOAT;
 #define ARRAY_SIZE(array) (sizeof(array) / sizeof(array)[0])
 //#define LOG_NDEBUG 0
 
+#include <algorithm>
 #include <assert.h>
 #include <inttypes.h>
 #include <new>
@@ -342,7 +343,9 @@ int process(effect_buffer_t* pIn, effect_buffer_t* pOut, int frameCount, ReverbC
         return -EINVAL;
     }
 
-    size_t inSize = frameCount * sizeof(process_buffer_t) * channels;
+    // the insert send is at least stereo, as mono input is duplicated.
+    size_t inSize = frameCount * sizeof(process_buffer_t) *
+                    (pContext->auxiliary ? channels : std::max(channels, (int)FCC_2));
     size_t outSize = frameCount * sizeof(process_buffer_t) * FCC_2;
     if (pContext->InFrames == NULL || pContext->bufferSizeIn < inSize) {
         free(pContext->InFrames);
@@ -365,10 +368,12 @@ int process(effect_buffer_t* pIn, effect_buffer_t* pOut, int frameCount, ReverbC
         Reverb_LoadPreset(pContext);
     }
 
+    const process_buffer_t* pReverbIn = pContext->InFrames;
     if (pContext->auxiliary) {
         static_assert(std::is_same<decltype(*pIn), decltype(*pContext->InFrames)>::value,
                       "pIn and InFrames must be same type");
-        memcpy(pContext->InFrames, pIn, frameCount * channels * sizeof(*pIn));
+        // LVREV_Process does not modify its input, so the aux send is read in place.
+        pReverbIn = pIn;
     } else {
         // mono input is duplicated
         if (channels >= FCC_2) {
@@ -391,13 +396,16 @@ int process(effect_buffer_t* pIn, effect_buffer_t* pOut, int frameCount, ReverbC
                frameCount * sizeof(*pContext->OutFrames) * FCC_2);  // always stereo here
     } else {
         if (pContext->bEnabled == LVM_FALSE && pContext->SamplesToExitCount > 0) {
-            memset(pContext->InFrames, 0, frameCount * sizeof(*pContext->OutFrames) * channels);
-            ALOGV("\tZeroing %d samples per frame at the end of call", channels);
+            const int reverbChannels = pContext->auxiliary ? channels : FCC_2;
+            memset(pContext->InFrames, 0,
+                   frameCount * sizeof(*pContext->InFrames) * reverbChannels);
+            pReverbIn = pContext->InFrames;
+            ALOGV("\tZeroing %d samples per frame at the end of call", reverbChannels);
         }
 
         /* Process the samples, producing a stereo output */
         LvmStatus = LVREV_Process(pContext->hInstance, /* Instance handle */
-                                  pContext->InFrames,  /* Input buffer */
+                                  pReverbIn,           /* Input buffer */
                                   pContext->OutFrames, /* Output buffer */
                                   frameCount);         /* Number of samples to read */
     }
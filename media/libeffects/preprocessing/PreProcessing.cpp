@@ -106,7 +106,8 @@ struct preproc_session_s {
             apm;  // handle on webRTC audio processing module (APM)
     // Audio Processing module builder
     webrtc::AudioProcessingBuilder ap_builder;
-    // frameCount represents the size of the buffers used for processing, and must represent 10ms.
+    // frameCount is the size of one APM frame and represents 10ms. Process buffers must hold
+    // a whole number of APM frames.
     size_t frameCount;
     uint32_t samplingRate;     // sampling rate at effect process interface
     uint32_t inChannelCount;   // input channel count
@@ -965,6 +966,33 @@ void Session_GetReverseConfig(preproc_session_t* session, effect_config_t* confi
             (EFFECT_CONFIG_SMP_RATE | EFFECT_CONFIG_CHANNELS | EFFECT_CONFIG_FORMAT);
 }
 
+// Runs the APM over a buffer holding a whole number of 10 ms frames. The APM reads and
+// writes interleaved int16 for any channel count, so each 10 ms frame is processed in place
+// from the caller's buffers without staging copies or per channel deinterleaving.
+int Session_ProcessFrames(preproc_session_t* session, const int16_t* in, int16_t* out,
+                          size_t frameCount, bool reverse) {
+    const webrtc::StreamConfig& inConfig = reverse ? session->revConfig : session->inputConfig;
+    const webrtc::StreamConfig& outConfig = reverse ? session->revConfig : session->outputConfig;
+    const size_t inStride = session->frameCount * inConfig.num_channels();
+    const size_t outStride = session->frameCount * outConfig.num_channels();
+    // The APM clears the echo delay after each capture frame, the delay set for this buffer
+    // applies to all of its 10 ms frames.
+    const bool keepDelay = !reverse && (session->enabledMsk & (1 << PREPROC_AEC)) != 0;
+    for (size_t frames = 0; frames < frameCount; frames += session->frameCount) {
+        if (keepDelay && frames != 0) {
+            session->apm->set_stream_delay_ms(session->apm->stream_delay_ms());
+        }
+        if (int status = reverse ? session->apm->ProcessReverseStream(in, inConfig, outConfig, out)
+                                 : session->apm->ProcessStream(in, inConfig, outConfig, out);
+            status != 0) {
+            return status;
+        }
+        in += inStride;
+        out += outStride;
+    }
+    return 0;
+}
+
 void Session_SetProcEnabled(preproc_session_t* session, uint32_t procId, bool enabled) {
     if (enabled) {
         session->enabledMsk |= (1 << procId);
@@ -1063,8 +1091,9 @@ int PreProcessingFx_Process(effect_handle_t self, audio_buffer_t* inBuffer,
         return -EINVAL;
     }
 
-    if (inBuffer->frameCount != session->frameCount) {
-        ALOGW("inBuffer->frameCount %zu != %zu representing 10ms at sampling rate %d",
+    if (inBuffer->frameCount == 0 || inBuffer->frameCount % session->frameCount != 0) {
+        ALOGW("inBuffer->frameCount %zu is not a multiple of %zu representing 10ms at "
+              "sampling rate %d",
               inBuffer->frameCount, session->frameCount, session->samplingRate);
         return -EINVAL;
     }
@@ -1075,11 +1104,8 @@ int PreProcessingFx_Process(effect_handle_t self, audio_buffer_t* inBuffer,
     //         inBuffer->frameCount, session->enabledMsk, session->processedMsk);
     if ((session->processedMsk & session->enabledMsk) == session->enabledMsk) {
         effect->session->processedMsk = 0;
-        if (int status = effect->session->apm->ProcessStream(
-                    (const int16_t* const)inBuffer->s16,
-                    (const webrtc::StreamConfig)effect->session->inputConfig,
-                    (const webrtc::StreamConfig)effect->session->outputConfig,
-                    (int16_t* const)outBuffer->s16);
+        if (int status = Session_ProcessFrames(session, inBuffer->s16, outBuffer->s16,
+                                               inBuffer->frameCount, false /* reverse */);
             status != 0) {
             ALOGE("Process Stream failed with error %d\n", status);
             return status;
@@ -1464,8 +1490,9 @@ int PreProcessingFx_ProcessReverse(effect_handle_t self, audio_buffer_t* inBuffe
         return -EINVAL;
     }
 
-    if (inBuffer->frameCount != session->frameCount) {
-        ALOGW("inBuffer->frameCount %zu != %zu representing 10ms at sampling rate %d",
+    if (inBuffer->frameCount == 0 || inBuffer->frameCount % session->frameCount != 0) {
+        ALOGW("inBuffer->frameCount %zu is not a multiple of %zu representing 10ms at "
+              "sampling rate %d",
               inBuffer->frameCount, session->frameCount, session->samplingRate);
         return -EINVAL;
     }
@@ -1478,11 +1505,8 @@ int PreProcessingFx_ProcessReverse(effect_handle_t self, audio_buffer_t* inBuffe
 
     if ((session->revProcessedMsk & session->revEnabledMsk) == session->revEnabledMsk) {
         effect->session->revProcessedMsk = 0;
-        if (int status = effect->session->apm->ProcessReverseStream(
-                    (const int16_t* const)inBuffer->s16,
-                    (const webrtc::StreamConfig)effect->session->revConfig,
-                    (const webrtc::StreamConfig)effect->session->revConfig,
-                    (int16_t* const)outBuffer->s16);
+        if (int status = Session_ProcessFrames(session, inBuffer->s16, outBuffer->s16,
+                                               inBuffer->frameCount, true /* reverse */);
             status != 0) {
             ALOGE("Process Reverse Stream failed with error %d\n", status);
             return status;
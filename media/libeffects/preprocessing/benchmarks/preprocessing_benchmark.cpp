@@ -126,6 +126,7 @@
 #include <audio_effects/effect_aec.h>
 #include <audio_effects/effect_agc.h>
 #include <array>
+#include <cerrno>
 #include <climits>
 #include <cstdlib>
 #include <random>
@@ -317,6 +318,123 @@ static void preprocessingArgs(benchmark::internal::Benchmark* b) {
     }
 }
 
+// Fused capture chain as used for voice communication: AEC, NS and AGC2 enabled on the same
+// session so a single APM pass runs per buffer. The first parameter is the channel mask index,
+// the second the sampling rate and the third the buffer duration in multiples of 10 ms.
+static void BM_PREPROCESSING_FUSED(benchmark::State& state) {
+    const size_t chMask = kChMasks[state.range(0) - 1];
+    const size_t channelCount = audio_channel_count_from_in_mask(chMask);
+    const int sampleRate = state.range(1);
+    const size_t frameLength = (size_t)(sampleRate * kTenMilliSecVal) * state.range(2);
+    constexpr PreProcId kFusedEffects[] = {PREPROC_AEC, PREPROC_NS, PREPROC_AGC2};
+
+    int32_t sessionId = 1;
+    int32_t ioId = 1;
+    effect_config_t config{};
+    config.inputCfg.samplingRate = config.outputCfg.samplingRate = sampleRate;
+    config.inputCfg.channels = config.outputCfg.channels = chMask;
+    config.inputCfg.format = config.outputCfg.format = AUDIO_FORMAT_PCM_16_BIT;
+
+    std::array<effect_handle_t, std::size(kFusedEffects)> effectHandles{};
+    auto releaseEffects = [&effectHandles]() {
+        for (auto& effectHandle : effectHandles) {
+            if (effectHandle != nullptr) {
+                AUDIO_EFFECT_LIBRARY_INFO_SYM.release_effect(effectHandle);
+                effectHandle = nullptr;
+            }
+        }
+    };
+    for (size_t i = 0; i < std::size(kFusedEffects); i++) {
+        if (int status = preProcCreateEffect(&effectHandles[i], kFusedEffects[i], &config,
+                                             sessionId, ioId);
+            status != 0) {
+            ALOGE("Create effect call returned error %i", status);
+            releaseEffects();
+            state.SkipWithError("cannot create effect");
+            return;
+        }
+        int reply = 0;
+        uint32_t replySize = sizeof(reply);
+        if (int status = (*effectHandles[i])
+                                 ->command(effectHandles[i], EFFECT_CMD_ENABLE, 0, nullptr,
+                                           &replySize, &reply);
+            status != 0) {
+            ALOGE("Command enable call returned error %d\n", reply);
+            releaseEffects();
+            state.SkipWithError("cannot enable effect");
+            return;
+        }
+    }
+
+    // Initialize input buffer with deterministic pseudo-random values
+    std::minstd_rand gen(chMask);
+    std::uniform_real_distribution<> dis(-1.0f, 1.0f);
+    std::vector<short> in(frameLength * channelCount);
+    for (auto& i : in) {
+        i = preProcGetShortVal(dis(gen));
+    }
+    std::vector<short> farIn(frameLength * channelCount);
+    for (auto& i : farIn) {
+        i = preProcGetShortVal(dis(gen));
+    }
+    std::vector<short> out(frameLength * channelCount);
+
+    // Run the test
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(in.data());
+        benchmark::DoNotOptimize(out.data());
+        benchmark::DoNotOptimize(farIn.data());
+
+        audio_buffer_t inBuffer = {.frameCount = frameLength, .s16 = in.data()};
+        audio_buffer_t outBuffer = {.frameCount = frameLength, .s16 = out.data()};
+        audio_buffer_t farInBuffer = {.frameCount = frameLength, .s16 = farIn.data()};
+
+        // The APM runs once all enabled effects of the session have been called.
+        if (int status =
+                    preProcSetConfigParam(effectHandles[0], AEC_PARAM_ECHO_DELAY, kStreamDelayMs);
+            status != 0) {
+            ALOGE("preProcSetConfigParam returned Error %d\n", status);
+            state.SkipWithError("cannot set echo delay");
+            break;
+        }
+        int status = 0;
+        for (size_t i = 0; i < effectHandles.size(); i++) {
+            status = (*effectHandles[i])->process(effectHandles[i], &inBuffer, &outBuffer);
+            if (status != 0 && !(status == -ENODATA && i + 1 < effectHandles.size())) {
+                ALOGE("\nError: Process i = %zu returned with error %d\n", i, status);
+                break;
+            }
+        }
+        if (status != 0) {
+            state.SkipWithError("process failed");
+            break;
+        }
+        if (int status =
+                    (*effectHandles[0])->process_reverse(effectHandles[0], &farInBuffer, &outBuffer);
+            status != 0) {
+            ALOGE("\nError: Process reverse returned with error %d\n", status);
+            state.SkipWithError("process reverse failed");
+            break;
+        }
+    }
+    benchmark::ClobberMemory();
+
+    state.SetComplexityN(state.range(0));
+    state.SetItemsProcessed(state.iterations() * frameLength);
+    releaseEffects();
+}
+
+static void preprocessingFusedArgs(benchmark::internal::Benchmark* b) {
+    for (int i : {1, 2, 4}) {
+        for (int sampleRate : {16000, 48000}) {
+            for (int tenMsFrames : {1, 2, 4}) {
+                b->Args({i, sampleRate, tenMsFrames});
+            }
+        }
+    }
+}
+
 BENCHMARK(BM_PREPROCESSING)->Apply(preprocessingArgs);
+BENCHMARK(BM_PREPROCESSING_FUSED)->Apply(preprocessingFusedArgs);
 
 BENCHMARK_MAIN();
@@ -15,13 +15,16 @@
  */
 
 #include <array>
+#include <cmath>
 #include <dlfcn.h>
 #include <random>
+#include <string.h>
 #include <vector>
 
 #include <benchmark/benchmark.h>
 #include <hardware/audio_effect.h>
 #include <log/log.h>
+#include <system/audio_effects/effect_spatializer.h>
 
 audio_effect_library_t AUDIO_EFFECT_LIBRARY_INFO_SYM = [] {
     audio_effect_library_t symbol{};
@@ -56,6 +59,22 @@ constexpr size_t kNumSampleRates = std::size(kSampleRates);
 constexpr size_t kDurations[] = {2, 5, 10};
 constexpr size_t kNumDurations = std::size(kDurations);
 
+// channel masks for BM_SPATIALIZER_BLOCK
+constexpr audio_channel_mask_t kBlockChMasks[] = {
+        AUDIO_CHANNEL_OUT_QUAD,
+        AUDIO_CHANNEL_OUT_5POINT1,
+        AUDIO_CHANNEL_OUT_7POINT1,
+        AUDIO_CHANNEL_OUT_7POINT1POINT4,
+};
+constexpr size_t kNumBlockChMasks = std::size(kBlockChMasks);
+
+// block sizes in frames for BM_SPATIALIZER_BLOCK, at kBlockSampleRate
+// The spatializer does not handle blocks smaller than 80 frames, see SpatializerTest.
+constexpr size_t kBlockFrameCounts[] = {96, 128, 192, 256, 480, 512, 960};
+constexpr size_t kNumBlockFrameCounts = std::size(kBlockFrameCounts);
+
+constexpr size_t kBlockSampleRate = 48000;
+
 // effect uuids
 constexpr effect_uuid_t kEffectUuid = {
         0xcc4677de, 0xff72, 0x11eb, 0x9a03, {0x02, 0x42, 0xac, 0x13, 0x00, 0x03}};
@@ -161,4 +180,142 @@ static void SPATIALIZERArgs(benchmark::internal::Benchmark* b) {
 
 BENCHMARK(BM_SPATIALIZER)->Apply(SPATIALIZERArgs);
 
+template <typename T>
+static int setParam(effect_handle_t effectHandle, uint32_t type, const T* values, size_t count) {
+    uint32_t cmd[sizeof(effect_param_t) / sizeof(uint32_t) + 1 +
+                 (sizeof(T) * count + sizeof(uint32_t) - 1) / sizeof(uint32_t)];
+    effect_param_t* p = (effect_param_t*)cmd;
+    p->psize = sizeof(uint32_t);
+    p->vsize = sizeof(T) * count;
+    *(uint32_t*)p->data = type;
+    memcpy((uint32_t*)p->data + 1, values, sizeof(T) * count);
+
+    int reply = 0;
+    uint32_t replySize = sizeof(reply);
+    int status = (*effectHandle)
+                         ->command(effectHandle, EFFECT_CMD_SET_PARAM,
+                                   sizeof(effect_param_t) + p->psize + p->vsize, p, &replySize,
+                                   &reply);
+    return status != 0 ? status : reply;
+}
+
+/*******************************************************************
+ * BM_SPATIALIZER_BLOCK processes one block per iteration at 48 kHz.
+ * The first parameter indicates the input channel mask.
+ * 0: quad, 1: 5.1, 2: 7.1, 3: 7.1.4
+ * The second parameter indicates the block size in frames.
+ * 0: 96, 1: 128, 2: 192, 3: 256, 4: 480, 5: 512, 6: 960
+ * The third parameter indicates head tracking off (0) or on (1). With head tracking on,
+ * a new head-to-stage pose is set before every block, as the pose controller does when
+ * the head tracker is moving.
+ *
+ * The "realtime" counter is the processing speed relative to real time, so 1 / realtime is
+ * the CPU load of the spatializer at that block size. Compare it against the latency of one
+ * block when choosing af.spatializer.block_frames for a device.
+ *******************************************************************/
+
+static void BM_SPATIALIZER_BLOCK(benchmark::State& state) {
+    const audio_channel_mask_t inputChMask = kBlockChMasks[state.range(0)];
+    const size_t frameCount = kBlockFrameCounts[state.range(1)];
+    const bool headTracking = state.range(2) != 0;
+    const size_t sampleRate = kBlockSampleRate;
+    const size_t inputChannelCount = audio_channel_count_from_out_mask(inputChMask);
+    const size_t outputChannelCount = audio_channel_count_from_out_mask(AUDIO_CHANNEL_OUT_STEREO);
+
+    // Initialize input buffer with deterministic pseudo-random values
+    std::minstd_rand gen(inputChMask);
+    std::uniform_real_distribution<> dis(kMinAmplitude, kMaxAmplitude);
+    std::vector<float> input(frameCount * inputChannelCount);
+    for (auto& in : input) {
+        in = dis(gen);
+    }
+
+    effect_handle_t effectHandle = nullptr;
+    if (int status = AUDIO_EFFECT_LIBRARY_INFO_SYM.create_effect(&kEffectUuid, 1 /* sessionId */,
+                                                                 1 /* ioId */, &effectHandle);
+        status != 0) {
+        state.SkipWithError("create_effect returned an error");
+        return;
+    }
+
+    effect_config_t config{};
+    config.inputCfg.samplingRate = config.outputCfg.samplingRate = sampleRate;
+    config.inputCfg.channels = inputChMask;
+    config.outputCfg.channels = AUDIO_CHANNEL_OUT_STEREO;
+    config.inputCfg.format = config.outputCfg.format = AUDIO_FORMAT_PCM_FLOAT;
+
+    int reply = 0;
+    uint32_t replySize = sizeof(reply);
+    if (int status = (*effectHandle)
+                             ->command(effectHandle, EFFECT_CMD_SET_CONFIG, sizeof(effect_config_t),
+                                       &config, &replySize, &reply);
+        status != 0 || reply != 0) {
+        // not all channel masks are supported by all spatializer implementations
+        state.SkipWithError("channel mask not supported");
+        AUDIO_EFFECT_LIBRARY_INFO_SYM.release_effect(effectHandle);
+        return;
+    }
+
+    if (headTracking) {
+        // Implementations without head tracking modes still apply the head-to-stage pose.
+        const int8_t mode = 2;  // RELATIVE_WORLD
+        (void)setParam(effectHandle, SPATIALIZER_PARAM_HEADTRACKING_MODE, &mode, 1);
+    }
+
+    if (int status = (*effectHandle)
+                             ->command(effectHandle, EFFECT_CMD_ENABLE, 0, nullptr, &replySize,
+                                       &reply);
+        status != 0) {
+        state.SkipWithError("EFFECT_CMD_ENABLE returned an error");
+        AUDIO_EFFECT_LIBRARY_INFO_SYM.release_effect(effectHandle);
+        return;
+    }
+
+    // Run the test
+    std::vector<float> output(frameCount * outputChannelCount);
+    // head yaw advances by 90 degrees per second of audio
+    const float yawPerBlock = (float)M_PI_2 * frameCount / sampleRate;
+    float yaw = 0.f;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(input.data());
+        benchmark::DoNotOptimize(output.data());
+
+        if (headTracking) {
+            // x, y, z translation, then rotation vector (radians)
+            const float headToStage[6] = {0.f, 0.f, 0.f, 0.f, yaw, 0.f};
+            (void)setParam(effectHandle, SPATIALIZER_PARAM_HEAD_TO_STAGE, headToStage,
+                           std::size(headToStage));
+            yaw = std::remainder(yaw + yawPerBlock, 2.f * (float)M_PI);
+        }
+
+        audio_buffer_t inBuffer = {.frameCount = frameCount, .f32 = input.data()};
+        audio_buffer_t outBuffer = {.frameCount = frameCount, .f32 = output.data()};
+        (*effectHandle)->process(effectHandle, &inBuffer, &outBuffer);
+
+        benchmark::ClobberMemory();
+    }
+
+    state.counters["blockMs"] = (double)frameCount * 1000 / sampleRate;
+    state.counters["realtime"] = benchmark::Counter((double)frameCount / sampleRate,
+                                                    benchmark::Counter::kIsIterationInvariantRate);
+    state.SetComplexityN(frameCount);
+
+    if (int status = AUDIO_EFFECT_LIBRARY_INFO_SYM.release_effect(effectHandle); status != 0) {
+        ALOGE("release_effect returned an error = %d\n", status);
+        return;
+    }
+}
+
+static void SPATIALIZERBlockArgs(benchmark::internal::Benchmark* b) {
+    for (int i = 0; i < kNumBlockChMasks; i++) {
+        for (int j = 0; j < kNumBlockFrameCounts; ++j) {
+            for (int k = 0; k < 2; ++k) {
+                b->Args({i, j, k});
+            }
+        }
+    }
+}
+
+BENCHMARK(BM_SPATIALIZER_BLOCK)->Apply(SPATIALIZERBlockArgs);
+
 BENCHMARK_MAIN();
@@ -25,6 +25,7 @@
 #include <time.h>
 
 #include <algorithm> // max
+#include <atomic>
 #include <new>
 
 #include <log/log.h>
@@ -78,6 +79,10 @@ enum visualizer_state_e {
 // maximum number of buffers for which we keep track of the measurements
 #define MEASUREMENT_WINDOW_MAX_SIZE_IN_BUFFERS 25 // note: buffer index is stored in uint8_t
 
+// maximum number of times a capture is copied again because process() updated the buffer
+// meanwhile; after that the last copy is returned, a torn capture only affects display.
+#define MAX_CAPTURE_RETRIES 4
+
 
 struct BufferStats {
     bool mIsValid;
@@ -94,6 +99,9 @@ struct VisualizerContext {
     uint8_t mState;
     uint32_t mLastCaptureIdx;
     uint32_t mLatency;
+    // sequence lock for mCaptureIdx, mBufferUpdateTime and mCaptureBuf written by
+    // Visualizer_process(): odd while an update is in progress.
+    std::atomic<uint32_t> mCaptureSeq{0};
     struct timespec mBufferUpdateTime;
     uint8_t mCaptureBuf[CAPTURE_BUF_SIZE];
     // for measurements
@@ -125,6 +133,67 @@ uint32_t Visualizer_getDeltaTimeMsFromUpdatedTime(VisualizerContext* pContext) {
 }
 
 
+//----------------------------------------------------------------------------
+// Visualizer_copyCapture()
+//----------------------------------------------------------------------------
+// Purpose: Copy the latest captureSize samples, offset by the latency, into dst.
+//  Returns the capture index the copy was made at.
+//  Called without synchronization with Visualizer_process(), the caller must check
+//  mCaptureSeq to detect a concurrent update.
+//----------------------------------------------------------------------------
+
+uint32_t Visualizer_copyCapture(VisualizerContext *pContext, uint8_t *dst, uint32_t captureSize)
+{
+    const uint32_t captureIdx = pContext->mCaptureIdx;
+    const uint32_t deltaMs = Visualizer_getDeltaTimeMsFromUpdatedTime(pContext);
+
+    // if audio framework has stopped playing audio although the effect is still
+    // active we must clear the capture buffer to return silence
+    if ((pContext->mLastCaptureIdx == captureIdx) &&
+            (pContext->mBufferUpdateTime.tv_sec != 0) &&
+            (deltaMs > MAX_STALL_TIME_MS)) {
+            ALOGV("capture going to idle");
+            pContext->mBufferUpdateTime.tv_sec = 0;
+            memset(dst, 0x80, captureSize);
+    } else {
+        int32_t latencyMs = pContext->mLatency;
+        latencyMs -= deltaMs;
+        if (latencyMs < 0) {
+            latencyMs = 0;
+        }
+        uint32_t deltaSmpl = captureSize
+                + pContext->mConfig.inputCfg.samplingRate * latencyMs / 1000;
+
+        // large sample rate, latency, or capture size, could cause overflow.
+        // do not offset more than the size of buffer.
+        if (deltaSmpl > CAPTURE_BUF_SIZE) {
+            android_errorWriteLog(0x534e4554, "31781965");
+            deltaSmpl = CAPTURE_BUF_SIZE;
+        }
+
+        int32_t capturePoint;
+        //capturePoint = (int32_t)captureIdx - deltaSmpl;
+        __builtin_sub_overflow((int32_t)captureIdx, deltaSmpl, &capturePoint);
+        // a negative capturePoint means we wrap the buffer.
+        if (capturePoint < 0) {
+            uint32_t size = -capturePoint;
+            if (size > captureSize) {
+                size = captureSize;
+            }
+            memcpy(dst,
+                   pContext->mCaptureBuf + CAPTURE_BUF_SIZE + capturePoint,
+                   size);
+            dst += size;
+            captureSize -= size;
+            capturePoint = 0;
+        }
+        memcpy(dst,
+               pContext->mCaptureBuf + capturePoint,
+               captureSize);
+    }
+    return captureIdx;
+}
+
 void Visualizer_reset(VisualizerContext *pContext)
 {
     pContext->mCaptureIdx = 0;
@@ -342,10 +411,27 @@ int Visualizer_process(
         float rmsSqAcc = 0;
 
 #ifdef BUILD_FLOAT
+        // independent partial peaks and sums so that the loop can be vectorized.
+        constexpr size_t kLanes = 8;
+        float maxLanes[kLanes] = {};
+        float rmsSqLanes[kLanes] = {};
+        size_t inIdx = 0;
+        for (; inIdx + kLanes <= sampleLen; inIdx += kLanes) {
+            for (size_t i = 0; i < kLanes; ++i) {
+                const float smp = inBuffer->f32[inIdx + i];
+                maxLanes[i] = std::max(maxLanes[i], fabsf(smp)); // ignores NaN like fmax
+                rmsSqLanes[i] += smp * smp;
+            }
+        }
+        for (; inIdx < sampleLen; ++inIdx) {
+            const float smp = inBuffer->f32[inIdx];
+            maxLanes[0] = std::max(maxLanes[0], fabsf(smp));
+            rmsSqLanes[0] += smp * smp;
+        }
         float maxSample = 0.f;
-        for (size_t inIdx = 0; inIdx < sampleLen; ++inIdx) {
-            maxSample = fmax(maxSample, fabs(inBuffer->f32[inIdx]));
-            rmsSqAcc += inBuffer->f32[inIdx] * inBuffer->f32[inIdx];
+        for (size_t i = 0; i < kLanes; ++i) {
+            maxSample = std::max(maxSample, maxLanes[i]);
+            rmsSqAcc += rmsSqLanes[i];
         }
         maxSample *= 1 << 15; // scale to int16_t, with exactly 1 << 15 representing positive num.
         rmsSqAcc *= 1 << 30; // scale to int16_t * 2
@@ -427,6 +513,11 @@ int Visualizer_process(
 #endif // BUILD_FLOAT
     }
 
+    // readers retry if the sequence is odd or has changed while they copied the capture.
+    const uint32_t captureSeq = pContext->mCaptureSeq.load(std::memory_order_relaxed);
+    pContext->mCaptureSeq.store(captureSeq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
     uint32_t captIdx;
     uint32_t inIdx;
     uint8_t *buf = pContext->mCaptureBuf;
@@ -448,13 +539,12 @@ int Visualizer_process(
 #endif // BUILD_FLOAT
     }
 
-    // XXX the following two should really be atomic, though it probably doesn't
-    // matter much for visualization purposes
     pContext->mCaptureIdx = captIdx;
     // update last buffer update time stamp
     if (clock_gettime(CLOCK_MONOTONIC, &pContext->mBufferUpdateTime) < 0) {
         pContext->mBufferUpdateTime.tv_sec = 0;
     }
+    pContext->mCaptureSeq.store(captureSeq + 2, std::memory_order_release);
 
     if (inBuffer->raw != outBuffer->raw) {
 #ifdef BUILD_FLOAT
@@ -635,54 +725,19 @@ int Visualizer_command(effect_handle_t self, uint32_t cmdCode, uint32_t cmdSize,
             return -EINVAL;
         }
         if (pContext->mState == VISUALIZER_STATE_ACTIVE) {
-            const uint32_t deltaMs = Visualizer_getDeltaTimeMsFromUpdatedTime(pContext);
-
-            // if audio framework has stopped playing audio although the effect is still
-            // active we must clear the capture buffer to return silence
-            if ((pContext->mLastCaptureIdx == pContext->mCaptureIdx) &&
-                    (pContext->mBufferUpdateTime.tv_sec != 0) &&
-                    (deltaMs > MAX_STALL_TIME_MS)) {
-                    ALOGV("capture going to idle");
-                    pContext->mBufferUpdateTime.tv_sec = 0;
-                    memset(pReplyData, 0x80, captureSize);
-            } else {
-                int32_t latencyMs = pContext->mLatency;
-                latencyMs -= deltaMs;
-                if (latencyMs < 0) {
-                    latencyMs = 0;
-                }
-                uint32_t deltaSmpl = captureSize
-                        + pContext->mConfig.inputCfg.samplingRate * latencyMs / 1000;
-
-                // large sample rate, latency, or capture size, could cause overflow.
-                // do not offset more than the size of buffer.
-                if (deltaSmpl > CAPTURE_BUF_SIZE) {
-                    android_errorWriteLog(0x534e4554, "31781965");
-                    deltaSmpl = CAPTURE_BUF_SIZE;
-                }
-
-                int32_t capturePoint;
-                //capturePoint = (int32_t)pContext->mCaptureIdx - deltaSmpl;
-                __builtin_sub_overflow((int32_t)pContext->mCaptureIdx, deltaSmpl, &capturePoint);
-                // a negative capturePoint means we wrap the buffer.
-                if (capturePoint < 0) {
-                    uint32_t size = -capturePoint;
-                    if (size > captureSize) {
-                        size = captureSize;
-                    }
-                    memcpy(pReplyData,
-                           pContext->mCaptureBuf + CAPTURE_BUF_SIZE + capturePoint,
-                           size);
-                    pReplyData = (char *)pReplyData + size;
-                    captureSize -= size;
-                    capturePoint = 0;
+            // copy without blocking Visualizer_process(), see mCaptureSeq.
+            uint32_t captureIdx;
+            for (int retry = 0; ; ++retry) {
+                const uint32_t captureSeq = pContext->mCaptureSeq.load(std::memory_order_acquire);
+                captureIdx = Visualizer_copyCapture(pContext, (uint8_t *)pReplyData, captureSize);
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (((captureSeq & 1) == 0 &&
+                        captureSeq == pContext->mCaptureSeq.load(std::memory_order_relaxed))
+                        || retry >= MAX_CAPTURE_RETRIES) {
+                    break;
                 }
-                memcpy(pReplyData,
-                       pContext->mCaptureBuf + capturePoint,
-                       captureSize);
             }
-
-            pContext->mLastCaptureIdx = pContext->mCaptureIdx;
+            pContext->mLastCaptureIdx = captureIdx;
         } else {
             memset(pReplyData, 0x80, captureSize);
         }
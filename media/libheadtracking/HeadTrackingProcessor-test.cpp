@@ -141,6 +141,32 @@ TEST(HeadTrackingProcessor, SmoothModeSwitch) {
     EXPECT_EQ(processor->getHeadToStagePose(), Pose3f());
 }
 
+TEST(HeadTrackingProcessor, UnchangedInputs) {
+    const Pose3f worldToHead{{1, 2, 3}, Quaternionf::UnitRandom()};
+    const Pose3f worldToScreen{{4, 5, 6}, Quaternionf::UnitRandom()};
+
+    std::unique_ptr<HeadTrackingProcessor> processor =
+            createHeadTrackingProcessor(Options{}, HeadTrackingMode::SCREEN_RELATIVE);
+
+    processor->setWorldToHeadPose(0, worldToHead, Twist3f());
+    processor->setWorldToScreenPose(0, worldToScreen);
+    processor->calculate(0);
+    ASSERT_EQ(processor->getActualMode(), HeadTrackingMode::SCREEN_RELATIVE);
+    const Pose3f headToStage = processor->getHeadToStagePose();
+    EXPECT_EQ(headToStage, worldToHead.inverse() * worldToScreen);
+
+    // No new samples: the screen-head fusion is skipped and the output is unchanged.
+    processor->calculate(1);
+    EXPECT_EQ(processor->getHeadToStagePose(), headToStage);
+    EXPECT_NE(std::string::npos,
+              processor->toString_l(0).find("ScreenHeadFusion: count 1 skipped 1 "));
+
+    // A new head sample is used by the next calculation.
+    processor->setWorldToHeadPose(2, Pose3f(), Twist3f());
+    processor->calculate(2);
+    EXPECT_EQ(processor->getHeadToStagePose(), worldToScreen);
+}
+
 }  // namespace
 }  // namespace media
 }  // namespace android
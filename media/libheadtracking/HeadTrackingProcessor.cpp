@@ -15,6 +15,9 @@
  */
 #include <inttypes.h>
 
+#include <array>
+#include <chrono>
+
 #include <android-base/stringprintf.h>
 #include <audio_utils/SimpleLog.h>
 #include "media/HeadTrackingProcessor.h"
@@ -34,6 +37,52 @@ using android::base::StringAppendF;
 using Eigen::Quaternionf;
 using Eigen::Vector3f;
 
+// Stages of the pose processing graph, timed separately for dump.
+enum Stage {
+    kPredictor,        // PosePredictor, once per head sample
+    kScreenStillness,  // screen PoseBias and StillnessDetector
+    kHeadStillness,    // head PoseBias and StillnessDetector, auto-recenter
+    kScreenHeadFusion,
+    kModeSelector,
+    kRateLimiter,
+    kNumStages,
+};
+
+constexpr const char* kStageNames[kNumStages] = {
+        "PosePredictor", "ScreenStillness", "HeadStillness",
+        "ScreenHeadFusion", "ModeSelector", "PoseRateLimiter",
+};
+
+struct StageTiming {
+    int64_t count = 0;
+    int64_t skipped = 0;  // calls where the inputs were unchanged and the stage was not run
+    int64_t totalNs = 0;
+    int64_t maxNs = 0;
+
+    void add(int64_t ns) {
+        ++count;
+        totalNs += ns;
+        maxNs = std::max(maxNs, ns);
+    }
+};
+
+// Adds the time until the end of the enclosing scope to a StageTiming.
+class ScopedStageTimer {
+  public:
+    explicit ScopedStageTimer(StageTiming& timing) : mTiming(timing), mStart(now()) {}
+    ~ScopedStageTimer() { mTiming.add(now() - mStart); }
+
+  private:
+    static int64_t now() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                       std::chrono::steady_clock::now().time_since_epoch())
+                .count();
+    }
+
+    StageTiming& mTiming;
+    const int64_t mStart;
+};
+
 class HeadTrackingProcessorImpl : public HeadTrackingProcessor {
   public:
     HeadTrackingProcessorImpl(const Options& options, HeadTrackingMode initialMode)
@@ -60,11 +109,16 @@ class HeadTrackingProcessorImpl : public HeadTrackingProcessor {
 
     void setWorldToHeadPose(int64_t timestamp, const Pose3f& worldToHead,
                             const Twist3f& headTwist) override {
-        const Pose3f predictedWorldToHead = mPosePredictor.predict(
-                timestamp, worldToHead, headTwist, mOptions.predictionDuration);
+        Pose3f predictedWorldToHead;
+        {
+            ScopedStageTimer timer(mStageTimings[kPredictor]);
+            predictedWorldToHead = mPosePredictor.predict(
+                    timestamp, worldToHead, headTwist, mOptions.predictionDuration);
+        }
         mHeadPoseBias.setInput(predictedWorldToHead);
         mHeadStillnessDetector.setInput(timestamp, predictedWorldToHead);
         mWorldToHeadTimestamp = timestamp;
+        mFusionInputChanged = true;
     }
 
     void setWorldToScreenPose(int64_t timestamp, const Pose3f& worldToScreen) override {
@@ -72,12 +126,14 @@ class HeadTrackingProcessorImpl : public HeadTrackingProcessor {
             // We're introducing an artificial discontinuity. Enable the rate limiter.
             mRateLimiter.enable();
             mPhysicalToLogicalAngle = mPendingPhysicalToLogicalAngle;
+            mPhysicalToLogicalScreen = Pose3f(rotateY(-mPhysicalToLogicalAngle));
         }
 
-        Pose3f worldToLogicalScreen = worldToScreen * Pose3f(rotateY(-mPhysicalToLogicalAngle));
+        Pose3f worldToLogicalScreen = worldToScreen * mPhysicalToLogicalScreen;
         mScreenPoseBias.setInput(worldToLogicalScreen);
         mScreenStillnessDetector.setInput(timestamp, worldToLogicalScreen);
         mWorldToScreenTimestamp = timestamp;
+        mFusionInputChanged = true;
     }
 
     void setScreenToStagePose(const Pose3f& screenToStage) override {
@@ -93,6 +149,7 @@ class HeadTrackingProcessorImpl : public HeadTrackingProcessor {
 
         // Handle the screen first, since it might: trigger a recentering of the head.
         if (mWorldToScreenTimestamp.has_value()) {
+            ScopedStageTimer timer(mStageTimings[kScreenStillness]);
             const Pose3f worldToLogicalScreen = mScreenPoseBias.getOutput();
             screenStable = mScreenStillnessDetector.calculate(timestamp);
             mModeSelector.setScreenStable(mWorldToScreenTimestamp.value(), screenStable);
@@ -106,6 +163,7 @@ class HeadTrackingProcessorImpl : public HeadTrackingProcessor {
 
         // Handle head.
         if (mWorldToHeadTimestamp.has_value()) {
+            ScopedStageTimer timer(mStageTimings[kHeadStillness]);
             Pose3f worldToHead = mHeadPoseBias.getOutput();
             // Auto-recenter.
             bool headStable = mHeadStillnessDetector.calculate(timestamp);
@@ -118,20 +176,33 @@ class HeadTrackingProcessorImpl : public HeadTrackingProcessor {
             mModeSelector.setWorldToHeadPose(mWorldToHeadTimestamp.value(), worldToHead);
         }
 
-        auto maybeScreenToHead = mScreenHeadFusion.calculate();
-        if (maybeScreenToHead.has_value()) {
-            mModeSelector.setScreenToHeadPose(maybeScreenToHead->timestamp,
-                                              maybeScreenToHead->pose);
+        // The fusion only depends on the latest head and screen poses, so it is skipped
+        // when neither has changed since the last calculation.
+        if (mFusionInputChanged) {
+            ScopedStageTimer timer(mStageTimings[kScreenHeadFusion]);
+            mScreenToHead = mScreenHeadFusion.calculate();
+            mFusionInputChanged = false;
         } else {
-            mModeSelector.setScreenToHeadPose(timestamp, std::nullopt);
+            ++mStageTimings[kScreenHeadFusion].skipped;
         }
 
-        HeadTrackingMode prevMode = mModeSelector.getActualMode();
-        mModeSelector.calculate(timestamp);
-        if (mModeSelector.getActualMode() != prevMode) {
-            // Mode has changed, enable rate limiting.
-            mRateLimiter.enable();
+        {
+            ScopedStageTimer timer(mStageTimings[kModeSelector]);
+            if (mScreenToHead.has_value()) {
+                mModeSelector.setScreenToHeadPose(mScreenToHead->timestamp, mScreenToHead->pose);
+            } else {
+                mModeSelector.setScreenToHeadPose(timestamp, std::nullopt);
+            }
+
+            HeadTrackingMode prevMode = mModeSelector.getActualMode();
+            mModeSelector.calculate(timestamp);
+            if (mModeSelector.getActualMode() != prevMode) {
+                // Mode has changed, enable rate limiting.
+                mRateLimiter.enable();
+            }
         }
+
+        ScopedStageTimer timer(mStageTimings[kRateLimiter]);
         mRateLimiter.setTarget(mModeSelector.getHeadToStagePose());
         mHeadToStagePose = mRateLimiter.calculatePose(timestamp);
     }
@@ -151,6 +222,9 @@ class HeadTrackingProcessorImpl : public HeadTrackingProcessor {
             mScreenStillnessDetector.reset();
             mLocalLog.log("recenter Screen from %s", source.c_str());
         }
+        if (recenterHead || recenterScreen) {
+            mFusionInputChanged = true;
+        }
 
         // If a sensor being recentered is included in the current mode, apply rate limiting to
         // avoid discontinuities.
@@ -192,6 +266,15 @@ class HeadTrackingProcessorImpl : public HeadTrackingProcessor {
         ss += mModeSelector.toString(level + 1);
         ss += mRateLimiter.toString(level + 1);
         ss += mPosePredictor.toString(level + 1);
+        ss.append(prefixSpace + "StageTiming:\n");
+        for (int stage = 0; stage < kNumStages; ++stage) {
+            const StageTiming& timing = mStageTimings[stage];
+            StringAppendF(&ss, "%s  %s: count %" PRId64 " skipped %" PRId64
+                          " mean %0.3f us max %0.3f us\n",
+                          prefixSpace.c_str(), kStageNames[stage], timing.count, timing.skipped,
+                          timing.count > 0 ? timing.totalNs * 1e-3 / timing.count : 0.,
+                          timing.maxNs * 1e-3);
+        }
         ss.append(prefixSpace + "ReCenterHistory:\n");
         ss += mLocalLog.dumpToString((prefixSpace + " ").c_str(), mMaxLocalLogLine);
         return ss;
@@ -205,6 +288,10 @@ class HeadTrackingProcessorImpl : public HeadTrackingProcessor {
     float mPendingPhysicalToLogicalAngle = 0;
     std::optional<int64_t> mWorldToHeadTimestamp;
     std::optional<int64_t> mWorldToScreenTimestamp;
+    Pose3f mPhysicalToLogicalScreen;  // rotateY(-mPhysicalToLogicalAngle)
+    // Set when an input of mScreenHeadFusion may have changed since mScreenToHead was computed.
+    bool mFusionInputChanged = true;
+    std::optional<ScreenHeadFusion::TimestampedPose> mScreenToHead;
     Pose3f mHeadToStagePose;
     PoseBias mHeadPoseBias;
     PoseBias mScreenPoseBias;
@@ -214,6 +301,7 @@ class HeadTrackingProcessorImpl : public HeadTrackingProcessor {
     ModeSelector mModeSelector;
     PoseRateLimiter mRateLimiter;
     PosePredictor mPosePredictor;
+    std::array<StageTiming, kNumStages> mStageTimings;
     static constexpr std::size_t mMaxLocalLogLine = 10;
     SimpleLog mLocalLog{mMaxLocalLogLine};
 };
@@ -67,11 +67,11 @@ int main() {
 
     std::unique_ptr<SensorPoseProvider> provider =
             SensorPoseProvider::create(kPackageName, &listener);
-    if (!provider->startSensor(headSensor->getHandle(), 500ms)) {
+    if (!provider->startSensor(headSensor->getHandle(), 500ms, 0ms)) {
         std::cout << "Failed to start head sensor" << std::endl;
     }
     sleep(2);
-    if (!provider->startSensor(screenSensor->getHandle(), 500ms)) {
+    if (!provider->startSensor(screenSensor->getHandle(), 500ms, 0ms)) {
         std::cout << "Failed to start screenSensor sensor" << std::endl;
     }
     sleep(2);
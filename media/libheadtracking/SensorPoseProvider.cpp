@@ -19,6 +19,7 @@
 #define LOG_TAG "SensorPoseProvider"
 
 #include <algorithm>
+#include <atomic>
 #include <future>
 #include <inttypes.h>
 #include <limits>
@@ -45,6 +46,9 @@ using android::base::StringAppendF;
 // Note: Instead of a fixed number, the SensorEventQueue's fd could be used instead.
 constexpr int kIdent = 19;
 
+// Maximum number of events read from the queue per wakeup.
+constexpr size_t kMaxEventsPerRead = 16;
+
 static inline Looper* ALooper_to_Looper(ALooper* alooper) {
     return reinterpret_cast<Looper*>(alooper);
 }
@@ -126,7 +130,8 @@ class SensorPoseProviderImpl : public SensorPoseProvider {
         mThread.join();
     }
 
-    bool startSensor(int32_t sensor, std::chrono::microseconds samplingPeriod) override {
+    bool startSensor(int32_t sensor, std::chrono::microseconds samplingPeriod,
+                     std::chrono::microseconds maxReportLatency) override {
         // Figure out the sensor's data format.
         DataFormat format = getSensorFormat(sensor);
         if (format == DataFormat::kUnknown) {
@@ -139,11 +144,13 @@ class SensorPoseProviderImpl : public SensorPoseProvider {
             mEnabledSensorsExtra.emplace(
                     sensor,
                     SensorExtra{.format = format,
-                                .samplingPeriod = static_cast<int32_t>(samplingPeriod.count())});
+                                .samplingPeriod = static_cast<int32_t>(samplingPeriod.count()),
+                                .maxReportLatency =
+                                        static_cast<int32_t>(maxReportLatency.count())});
         }
 
         // Enable the sensor.
-        if (mQueue->enableSensor(sensor, samplingPeriod.count(), 0, 0)) {
+        if (mQueue->enableSensor(sensor, samplingPeriod.count(), maxReportLatency.count(), 0)) {
             ALOGE("%s: Failed to enable sensor %" PRId32, __func__, sensor);
             std::lock_guard lock(mMutex);
             mEnabledSensorsExtra.erase(sensor);
@@ -176,6 +183,11 @@ class SensorPoseProviderImpl : public SensorPoseProvider {
         }
 
         // Enabled sensor information
+        const int64_t wakeups = mWakeupCount.load(std::memory_order_relaxed);
+        const int64_t events = mEventCount.load(std::memory_order_relaxed);
+        StringAppendF(&ss, "%sWakeups %" PRId64 ", events %" PRId64 " (%0.2f per wakeup)\n",
+                      prefixSpace.c_str(), wakeups, events,
+                      wakeups > 0 ? (double)events / wakeups : 0.);
         StringAppendF(&ss, "%sSensors total number %zu:\n", prefixSpace.c_str(),
                       mEnabledSensorsExtra.size());
         for (auto sensor : mEnabledSensorsExtra) {
@@ -184,6 +196,10 @@ class SensorPoseProviderImpl : public SensorPoseProvider {
                           prefixSpace.c_str(), sensor.first, toString(sensor.second.format).c_str(),
                           sensor.second.samplingPeriod, media::nsToFloatMs(sensor.second.maxPeriod),
                           media::nsToFloatMs(sensor.second.minPeriod));
+            if (sensor.second.maxReportLatency > 0) {
+                StringAppendF(&ss, ", MaxReportLatency %0.4f ms",
+                              sensor.second.maxReportLatency * 1e-3);
+            }
             if (sensor.second.discontinuityCount.has_value()) {
                 StringAppendF(&ss, ", DiscontinuityCount: %d",
                               sensor.second.discontinuityCount.value());
@@ -213,6 +229,7 @@ class SensorPoseProviderImpl : public SensorPoseProvider {
     struct SensorExtra {
         DataFormat format = DataFormat::kUnknown;
         int32_t samplingPeriod = 0;
+        int32_t maxReportLatency = 0;  // in microseconds
         int64_t latestTimestamp = 0;
         int64_t maxPeriod = 0;
         int64_t minPeriod = std::numeric_limits<int64_t>::max();
@@ -227,6 +244,9 @@ class SensorPoseProviderImpl : public SensorPoseProvider {
     sp<SensorEventQueue> mQueue;
     std::map<int32_t, SensorEnableGuard> mEnabledSensors;
     std::map<int32_t, SensorExtra> mEnabledSensorsExtra GUARDED_BY(mMutex);
+    // Statistics of the looper thread, for dump.
+    std::atomic<int64_t> mWakeupCount = 0;
+    std::atomic<int64_t> mEventCount = 0;
 
     // We must do some of the initialization operations on the worker thread, because the API relies
     // on the thread-local looper. In addition, as a matter of convenience, we store some of the
@@ -293,15 +313,16 @@ class SensorPoseProviderImpl : public SensorPoseProvider {
                     continue;
             }
 
-            // Process an event.
-            ASensorEvent event;
-            ssize_t actual = mQueue->read(&event, 1);
+            // Process all the events available, which may be a batch when the sensors were
+            // started with a report latency.
+            ASensorEvent events[kMaxEventsPerRead];
+            ssize_t actual = mQueue->read(events, kMaxEventsPerRead);
             if (actual > 0) {
-                mQueue->sendAck(&event, actual);
+                mQueue->sendAck(events, actual);
             }
-            ssize_t size = mQueue->filterEvents(&event, actual);
+            ssize_t size = mQueue->filterEvents(events, actual);
 
-            if (size < 0 || size > 1) {
+            if (size < 0 || size > (ssize_t)kMaxEventsPerRead) {
                 ALOGE("%s: Unexpected return value from SensorEventQueue::filterEvents: %zd",
                         __func__, size);
                 break;
@@ -311,7 +332,11 @@ class SensorPoseProviderImpl : public SensorPoseProvider {
                 continue;
             }
 
-            handleEvent(event);
+            mWakeupCount.fetch_add(1, std::memory_order_relaxed);
+            mEventCount.fetch_add(size, std::memory_order_relaxed);
+            for (ssize_t i = 0; i < size; ++i) {
+                handleEvent(events[i]);
+            }
         }
         ALOGD("%s: Exiting sensor event loop", __func__);
     }
@@ -85,9 +85,13 @@ class SensorPoseProvider {
      * @param sensor The sensor to subscribe to.
      * @param samplingPeriod Sampling interval, in microseconds. Actual rate might be slightly
      * different.
+     * @param maxReportLatency Maximum time the sensor may hold events back to deliver them in
+     * batches, in microseconds. Batching reduces the number of wakeups at the cost of pose
+     * latency. 0 delivers each event as soon as it is available.
      * @return true iff succeeded.
      */
-    virtual bool startSensor(int32_t sensor, std::chrono::microseconds samplingPeriod) = 0;
+    virtual bool startSensor(int32_t sensor, std::chrono::microseconds samplingPeriod,
+                             std::chrono::microseconds maxReportLatency) = 0;
 
     /**
      * Stop a sensor, previously started with startSensor(). It is not required to stop all sensors
@@ -40,6 +40,7 @@ enum {
     GET_FRAME_AT_INDEX,
     EXTRACT_ALBUM_ART,
     EXTRACT_METADATA,
+    GET_FRAMES_AT_TIMES,
 };
 
 class BpMediaMetadataRetriever: public BpInterface<IMediaMetadataRetriever>
@@ -188,6 +189,37 @@ public:
         return interface_cast<IMemory>(reply.readStrongBinder());
     }
 
+    status_t getFramesAtTimes(
+            const std::vector<int64_t> &timesUs, int option, int colorFormat,
+            int maxWidth, int maxHeight, std::vector<sp<IMemory> > *frames)
+    {
+        ALOGV("getFramesAtTimes: %zu frames, option(%d), colorFormat(%d), max %dx%d",
+                timesUs.size(), option, colorFormat, maxWidth, maxHeight);
+        Parcel data, reply;
+        data.writeInterfaceToken(IMediaMetadataRetriever::getInterfaceDescriptor());
+        data.writeInt64Vector(timesUs);
+        data.writeInt32(option);
+        data.writeInt32(colorFormat);
+        data.writeInt32(maxWidth);
+        data.writeInt32(maxHeight);
+        remote()->transact(GET_FRAMES_AT_TIMES, data, &reply);
+        status_t ret = reply.readInt32();
+        if (ret != NO_ERROR) {
+            return ret;
+        }
+        int32_t count = reply.readInt32();
+        if (count < 0 || (size_t)count != timesUs.size()) {
+            return BAD_VALUE;
+        }
+        frames->assign(count, NULL);
+        for (int32_t i = 0; i < count; ++i) {
+            if (reply.readInt32() != 0) {
+                (*frames)[i] = interface_cast<IMemory>(reply.readStrongBinder());
+            }
+        }
+        return NO_ERROR;
+    }
+
     sp<IMemory> extractAlbumArt()
     {
         Parcel data, reply;
@@ -378,6 +410,34 @@ status_t BnMediaMetadataRetriever::onTransact(
             }
             return NO_ERROR;
         } break;
+        case GET_FRAMES_AT_TIMES: {
+            CHECK_INTERFACE(IMediaMetadataRetriever, data, reply);
+            std::vector<int64_t> timesUs;
+            status_t err = data.readInt64Vector(&timesUs);
+            if (err != OK) {
+                return err;
+            }
+            int option = data.readInt32();
+            int colorFormat = data.readInt32();
+            int maxWidth = data.readInt32();
+            int maxHeight = data.readInt32();
+            ALOGV("getFramesAtTimes: %zu frames, option(%d), colorFormat(%d), max %dx%d",
+                    timesUs.size(), option, colorFormat, maxWidth, maxHeight);
+            std::vector<sp<IMemory> > frames;
+            err = getFramesAtTimes(timesUs, option, colorFormat, maxWidth, maxHeight, &frames);
+            reply->writeInt32(err);
+            if (err == NO_ERROR) {
+                reply->writeInt32(frames.size());
+                for (const sp<IMemory> &frame : frames) {
+                    // Don't send NULL across the binder interface
+                    reply->writeInt32(frame != nullptr);
+                    if (frame != nullptr) {
+                        reply->writeStrongBinder(IInterface::asBinder(frame));
+                    }
+                }
+            }
+            return NO_ERROR;
+        } break;
         case EXTRACT_ALBUM_ART: {
             CHECK_INTERFACE(IMediaMetadataRetriever, data, reply);
             sp<IMemory> albumArt = extractAlbumArt();
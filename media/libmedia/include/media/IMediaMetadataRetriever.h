@@ -23,6 +23,8 @@
 #include <utils/KeyedVector.h>
 #include <utils/RefBase.h>
 
+#include <vector>
+
 namespace android {
 class Parcel;
 class IDataSource;
@@ -50,6 +52,12 @@ public:
             int index, int colorFormat, int left, int top, int right, int bottom) = 0;
     virtual sp<IMemory>     getFrameAtIndex(
             int index, int colorFormat, bool metaOnly) = 0;
+    // |frames| gets one entry per requested time, NULL where no frame could be extracted.
+    // Frames may come back smaller than the source, but no smaller than |maxWidth| x
+    // |maxHeight|, when those are set.
+    virtual status_t        getFramesAtTimes(
+            const std::vector<int64_t> &timesUs, int option, int colorFormat,
+            int maxWidth, int maxHeight, std::vector<sp<IMemory> > *frames) = 0;
     virtual sp<IMemory>     extractAlbumArt() = 0;
     virtual const char*     extractMetadata(int keyCode) = 0;
 };
@@ -18,6 +18,9 @@
 #ifndef ANDROID_MEDIAMETADATARETRIEVERINTERFACE_H
 #define ANDROID_MEDIAMETADATARETRIEVERINTERFACE_H
 
+#include <functional>
+#include <vector>
+
 #include <utils/RefBase.h>
 #include <media/mediametadataretriever.h>
 #include <media/mediascanner.h>
@@ -51,6 +54,19 @@ public:
             int index, int colorFormat, int left, int top, int right, int bottom) = 0;
     virtual sp<IMemory> getFrameAtIndex(
             int frameIndex, int colorFormat, bool metaOnly) = 0;
+    // Extracts a frame for each of |timesUs|, passing each to |onFrame| with its index in
+    // |timesUs| as soon as it is ready. Frames may not come in request order, and a frame
+    // that could not be extracted is passed as NULL. When |maxWidth| and |maxHeight| are
+    // set, frames may be extracted at a reduced resolution that still covers them.
+    virtual status_t getFramesAtTimes(
+            const std::vector<int64_t> &timesUs, int option, int colorFormat,
+            int /* maxWidth */, int /* maxHeight */,
+            const std::function<void(size_t, const sp<IMemory> &)> &onFrame) {
+        for (size_t i = 0; i < timesUs.size(); ++i) {
+            onFrame(i, getFrameAtTime(timesUs[i], option, colorFormat, false /* metaOnly */));
+        }
+        return OK;
+    }
     virtual MediaAlbumArt* extractAlbumArt() = 0;
     virtual const char* extractMetadata(int keyCode) = 0;
 };
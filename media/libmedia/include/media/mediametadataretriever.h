@@ -103,6 +103,10 @@ public:
             int index, int colorFormat, int left, int top, int right, int bottom);
     sp<IMemory>  getFrameAtIndex(
             int index, int colorFormat = HAL_PIXEL_FORMAT_RGB_565, bool metaOnly = false);
+    // Extracts thumbnails for several times with a single decoder session.
+    status_t getFramesAtTimes(const std::vector<int64_t> &timesUs, int option,
+            std::vector<sp<IMemory> > *frames, int colorFormat = HAL_PIXEL_FORMAT_RGB_565,
+            int maxWidth = 0, int maxHeight = 0);
     sp<IMemory> extractAlbumArt();
     const char* extractMetadata(int keyCode);
 
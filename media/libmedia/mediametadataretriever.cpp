@@ -191,6 +191,20 @@ sp<IMemory>  MediaMetadataRetriever::getFrameAtIndex(
     return mRetriever->getFrameAtIndex(index, colorFormat, metaOnly);
 }
 
+status_t MediaMetadataRetriever::getFramesAtTimes(
+        const std::vector<int64_t> &timesUs, int option,
+        std::vector<sp<IMemory> > *frames, int colorFormat, int maxWidth, int maxHeight) {
+    ALOGV("getFramesAtTimes: %zu frames, option(%d), colorFormat(%d), max %dx%d",
+            timesUs.size(), option, colorFormat, maxWidth, maxHeight);
+    Mutex::Autolock _l(mLock);
+    if (mRetriever == 0) {
+        ALOGE("retriever is not initialized");
+        return INVALID_OPERATION;
+    }
+    return mRetriever->getFramesAtTimes(
+            timesUs, option, colorFormat, maxWidth, maxHeight, frames);
+}
+
 const char* MediaMetadataRetriever::extractMetadata(int keyCode)
 {
     ALOGV("extractMetadata(%d)", keyCode);
@@ -21,9 +21,13 @@
 #include <string.h>
 #include <sys/types.h>
 
+#include <atomic>
+#include <condition_variable>
 #include <mutex>
 #include <set>
+#include <thread>
 #include <unordered_map>
+#include <vector>
 
 #include <binder/Parcel.h>
 #include <cutils/multiuser.h>
@@ -306,14 +310,14 @@ std::string mediametrics::Item::toString() const {
 
 // for the lazy, we offer methods that finds the service and
 // calls the appropriate daemon
-bool mediametrics::Item::selfrecord() {
+bool mediametrics::Item::selfrecord(bool immediate) {
     ALOGD_IF(DEBUG_API, "%s: delivering %s", __func__, this->toString().c_str());
 
     char *str;
     size_t size;
     status_t status = writeToByteString(&str, &size);
     if (status == NO_ERROR) {
-        status = submitBuffer(str, size);
+        status = submitBufferBatched(str, size, immediate);
         free(str);
     }
     if (status != NO_ERROR) {
@@ -442,6 +446,141 @@ status_t BaseItem::submitBuffer(const char *buffer, size_t size) {
     return status;
 }
 
+/**
+ * Coalesces item byte strings recorded by this process into a single one-way
+ * transaction to the MediaMetrics service.
+ *
+ * Each byte string starts with its total size, so the service unpacks a batch
+ * by walking the concatenated items. Items are queued until kBatchWindowNs has
+ * passed since the first queued item, the batch would exceed kMaxBatchBytes,
+ * or an immediate item is recorded.
+ */
+class ItemBatcher {
+public:
+    static ItemBatcher& getInstance() {
+        // Never destroyed, as the flush thread and atexit() may still use it.
+        static ItemBatcher* instance = [] {
+            ItemBatcher* batcher = new ItemBatcher();
+            atexit([] { getInstance().flush(); });
+            return batcher;
+        }();
+        return *instance;
+    }
+
+    status_t submit(const char *buffer, size_t size, bool immediate) {
+        if (size >= kMaxBatchBytes) {
+            // Too large to batch, keep the order with queued items.
+            flush();
+            return send(buffer, size, 1 /* items */);
+        }
+        {
+            std::unique_lock l(mLock);
+            if (mPending.size() + size > kMaxBatchBytes) {
+                l.unlock();
+                flush();
+                l.lock();
+            }
+            if (mPending.empty()) {
+                mDeadline = systemTime(SYSTEM_TIME_MONOTONIC) + kBatchWindowNs;
+                if (!mThreadStarted) {
+                    mThreadStarted = true;
+                    std::thread(&ItemBatcher::threadLoop, this).detach();
+                }
+                mCondition.notify_one();
+            }
+            mPending.insert(mPending.end(), buffer, buffer + size);
+            ++mPendingItems;
+        }
+        if (immediate) flush();
+        return NO_ERROR;
+    }
+
+    void flush() {
+        std::lock_guard sendLock(mSendLock);  // keeps batches in order.
+        size_t items;
+        {
+            std::lock_guard l(mLock);
+            if (mPending.empty()) return;
+            std::swap(mPending, mSending);  // reuse the allocations.
+            items = mPendingItems;
+            mPendingItems = 0;
+        }
+        (void)send(mSending.data(), mSending.size(), items);
+        mSending.clear();
+    }
+
+    size_t getDroppedCount() const {
+        return mDroppedItems;
+    }
+
+private:
+    static constexpr nsecs_t kBatchWindowNs = 100'000'000;  // 100ms
+    static constexpr size_t kMaxBatchBytes = 16 * 1024;  // keep well within binder async space
+
+    ItemBatcher() {
+        mPending.reserve(kMaxBatchBytes);
+        mSending.reserve(kMaxBatchBytes);
+    }
+
+    status_t send(const char *buffer, size_t size, size_t items) {
+        const status_t status = BaseItem::submitBuffer(buffer, size);
+        if (status != NO_ERROR) {
+            const size_t dropped = (mDroppedItems += items);
+            ALOGW("%s: dropped %zu items (%zu total): %d", __func__, items, dropped, status);
+        }
+        return status;
+    }
+
+    void threadLoop() {
+        pthread_setname_np(pthread_self(), "MediaMetricsBatch");
+        while (true) {
+            {
+                std::unique_lock l(mLock);
+                mCondition.wait(l, [this] { return !mPending.empty(); });
+                const nsecs_t now = systemTime(SYSTEM_TIME_MONOTONIC);
+                if (now < mDeadline) {
+                    mCondition.wait_for(l, std::chrono::nanoseconds(mDeadline - now));
+                    continue;  // recheck, the batch may have been flushed meanwhile.
+                }
+            }
+            flush();
+        }
+    }
+
+    std::mutex mSendLock;
+    std::mutex mLock;
+    std::condition_variable mCondition;
+    bool mThreadStarted = false;
+    nsecs_t mDeadline = 0;
+    std::vector<char> mPending;
+    size_t mPendingItems = 0;
+    std::vector<char> mSending;  // only accessed with mSendLock held
+    std::atomic<size_t> mDroppedItems{};
+};
+
+// static
+status_t BaseItem::submitBufferBatched(const char *buffer, size_t size, bool immediate) {
+    ALOGD_IF(DEBUG_API, "%s: queueing %zu bytes", __func__, size);
+
+    // Validate size, the service reads each item's size from its header.
+    if (size < sizeof(uint32_t) || size > std::numeric_limits<int32_t>::max()) return BAD_VALUE;
+
+    // Don't queue if there is nothing to deliver to.
+    if (getService() == nullptr) return NO_INIT;
+
+    return ItemBatcher::getInstance().submit(buffer, size, immediate);
+}
+
+// static
+void BaseItem::flushBatch() {
+    ItemBatcher::getInstance().flush();
+}
+
+// static
+size_t BaseItem::getDroppedItemCount() {
+    return ItemBatcher::getInstance().getDroppedCount();
+}
+
 //static
 sp<media::IMediaMetricsService> BaseItem::getService() {
     static const char *servicename = "media.metrics";
@@ -85,6 +85,7 @@
 
 // Property prefixes may be applied before a property name to indicate a specific
 // category to which it is associated.
+#define AMEDIAMETRICS_PROP_PREFIX_CYCLE     "cycle."    // thread loop stage, e.g. "cycle.io."
 #define AMEDIAMETRICS_PROP_PREFIX_EFFECTIVE "effective."
 #define AMEDIAMETRICS_PROP_PREFIX_HAL       "hal."
 #define AMEDIAMETRICS_PROP_PREFIX_HAPTIC    "haptic."
@@ -275,6 +275,14 @@ public:
     static sp<media::IMediaMetricsService> getService();
     // submits a raw buffer directly to the MediaMetrics service - this is highly optimized.
     static status_t submitBuffer(const char *buffer, size_t len);
+    // queues a raw item buffer so that items recorded within a short window are sent
+    // to the MediaMetrics service in one transaction. Critical items should set
+    // immediate, which sends the queued items (in order) together with this one.
+    static status_t submitBufferBatched(const char *buffer, size_t len, bool immediate = false);
+    // sends any queued items now.
+    static void flushBatch();
+    // number of items that could not be delivered to the service.
+    static size_t getDroppedItemCount();
 
 protected:
     static constexpr const char * const EnabledProperty = "media.metrics.enabled";
@@ -605,9 +613,9 @@ public:
         return *this;
     }
 
-    bool record() {
+    bool record(bool immediate = false) {
         return updateHeader()
-                && BaseItem::submitBuffer(getBuffer(), getLength()) == OK;
+                && BaseItem::submitBufferBatched(getBuffer(), getLength(), immediate) == OK;
     }
 
     bool isValid () const {
@@ -1066,8 +1074,8 @@ public:
         return prop == nullptr ? nullptr : &prop->get();
     }
 
-        // Deliver the item to MediaMetrics
-        bool selfrecord();
+        // Deliver the item to MediaMetrics, batched with other items unless immediate
+        bool selfrecord(bool immediate = false);
 
     // remove indicated attributes and their values
     // filterNot() could also be called keepOnly()
@@ -0,0 +1,129 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "FrameCache"
+#include <utils/Log.h>
+
+#include "FrameCache.h"
+
+#include <android-base/stringprintf.h>
+#include <binder/MemoryBase.h>
+#include <binder/MemoryHeapBase.h>
+#include <cutils/properties.h>
+#include <inttypes.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+namespace android {
+
+using base::StringPrintf;
+
+// static
+FrameCache &FrameCache::getInstance() {
+    static FrameCache sInstance;
+    return sInstance;
+}
+
+FrameCache::FrameCache()
+    : mBudgetBytes(std::max(
+            property_get_int32("media.stagefright.thumbnail_cache_kb", 0), 0) * 1024LL),
+      mSizeBytes(0),
+      mHits(0),
+      mMisses(0),
+      mEvictions(0) {
+}
+
+// static
+std::string FrameCache::getFileKey(int fd, int64_t offset, int64_t length) {
+    struct stat sb;
+    if (fstat(fd, &sb) != 0 || !S_ISREG(sb.st_mode)) {
+        return std::string();
+    }
+    return StringPrintf("%" PRIu64 ":%" PRIu64 ":%" PRId64 ":%" PRId64 ".%09ld:%" PRId64
+            ":%" PRId64, static_cast<uint64_t>(sb.st_dev), static_cast<uint64_t>(sb.st_ino),
+            static_cast<int64_t>(sb.st_size), static_cast<int64_t>(sb.st_mtim.tv_sec),
+            sb.st_mtim.tv_nsec, offset, length);
+}
+
+sp<IMemory> FrameCache::get(const std::string &key) {
+    Mutex::Autolock autoLock(mLock);
+    auto it = mIndex.find(key);
+    if (it == mIndex.end()) {
+        ++mMisses;
+        return NULL;
+    }
+    ++mHits;
+    mEntries.splice(mEntries.begin(), mEntries, it->second);
+
+    // Hand out a copy, the client maps the memory it receives.
+    const std::vector<uint8_t> &data = it->second->mData;
+    sp<MemoryHeapBase> heap = new MemoryHeapBase(data.size(), 0, "MetadataRetrieverClient");
+    sp<IMemory> frame = new MemoryBase(heap, 0, data.size());
+    if (frame->unsecurePointer() == NULL) {
+        ALOGE("not enough memory for cached frame size=%zu", data.size());
+        return NULL;
+    }
+    memcpy(frame->unsecurePointer(), data.data(), data.size());
+    return frame;
+}
+
+void FrameCache::put(const std::string &key, const sp<IMemory> &frame) {
+    if (frame == NULL || frame->unsecurePointer() == NULL || frame->size() > mBudgetBytes) {
+        return;
+    }
+    Mutex::Autolock autoLock(mLock);
+    if (mIndex.count(key) > 0) {
+        return;
+    }
+    evict_l(mBudgetBytes - frame->size());
+
+    const uint8_t *data = static_cast<const uint8_t *>(frame->unsecurePointer());
+    mEntries.push_front({key, std::vector<uint8_t>(data, data + frame->size())});
+    mIndex[key] = mEntries.begin();
+    mSizeBytes += frame->size();
+}
+
+void FrameCache::evict_l(size_t budgetBytes) {
+    while (mSizeBytes > budgetBytes && !mEntries.empty()) {
+        const Entry &entry = mEntries.back();
+        ALOGV("evicting %s (%zu bytes)", entry.mKey.c_str(), entry.mData.size());
+        mSizeBytes -= entry.mData.size();
+        mIndex.erase(entry.mKey);
+        mEntries.pop_back();
+        ++mEvictions;
+    }
+}
+
+void FrameCache::dump(int fd) {
+    Mutex::Autolock autoLock(mLock);
+    std::string result = StringPrintf(" Frame cache: budget %zu KB\n", mBudgetBytes / 1024);
+    if (isEnabled()) {
+        int64_t lookups = mHits + mMisses;
+        result += StringPrintf("  entries(%zu) size(%zu KB)\n",
+                mEntries.size(), mSizeBytes / 1024);
+        result += StringPrintf("  hits(%" PRId64 ") misses(%" PRId64 ") hit-rate(%.1f%%)"
+                " evictions(%" PRId64 ")\n", mHits, mMisses,
+                lookups > 0 ? mHits * 100.0 / lookups : 0.0, mEvictions);
+    }
+    result += "\n";
+    write(fd, result.c_str(), result.size());
+}
+
+}  // namespace android
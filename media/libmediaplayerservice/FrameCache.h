@@ -0,0 +1,78 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_MEDIASERVICE_FRAMECACHE_H
+#define ANDROID_MEDIASERVICE_FRAMECACHE_H
+
+#include <binder/IMemory.h>
+#include <utils/Mutex.h>
+
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace android {
+
+// Process-wide LRU cache of frames extracted by MetadataRetrieverClient, so that
+// repeated thumbnail requests for an unchanged file skip the decode. Entries are keyed
+// by the identity of the file (device, inode, size, mtime and the requested range)
+// plus the request parameters, and bounded by a byte budget taken from
+// "media.stagefright.thumbnail_cache_kb" (0 disables the cache).
+class FrameCache {
+public:
+    static FrameCache &getInstance();
+
+    bool isEnabled() const { return mBudgetBytes > 0; }
+
+    // Returns the identity of the file behind |fd| for use as a key prefix, or an empty
+    // string if it cannot be determined.
+    static std::string getFileKey(int fd, int64_t offset, int64_t length);
+
+    // Returns a private copy of the frame cached for |key|, or NULL.
+    sp<IMemory> get(const std::string &key);
+    void put(const std::string &key, const sp<IMemory> &frame);
+
+    void dump(int fd);
+
+private:
+    FrameCache();
+
+    struct Entry {
+        std::string mKey;
+        std::vector<uint8_t> mData;
+    };
+
+    void evict_l(size_t budgetBytes);
+
+    const size_t mBudgetBytes;
+
+    Mutex mLock;
+    // Most recently used first.
+    std::list<Entry> mEntries;
+    std::unordered_map<std::string, std::list<Entry>::iterator> mIndex;
+    size_t mSizeBytes;
+    int64_t mHits;
+    int64_t mMisses;
+    int64_t mEvictions;
+
+    FrameCache(const FrameCache &) = delete;
+    FrameCache &operator=(const FrameCache &) = delete;
+};
+
+}  // namespace android
+
+#endif  // ANDROID_MEDIASERVICE_FRAMECACHE_H
@@ -66,6 +66,7 @@
 #include <media/stagefright/MediaErrors.h>
 #include <media/stagefright/Utils.h>
 #include <media/stagefright/FoundationUtils.h>
+#include <media/stagefright/foundation/ABuffer.h>
 #include <media/stagefright/foundation/ADebug.h>
 #include <media/stagefright/foundation/ALooperRoster.h>
 #include <media/stagefright/SurfaceUtils.h>
@@ -79,6 +80,7 @@
 #include "ActivityManager.h"
 #include "MediaRecorderClient.h"
 #include "MediaPlayerService.h"
+#include "FrameCache.h"
 #include "MetadataRetrieverClient.h"
 #include "MediaPlayerFactory.h"
 
@@ -654,6 +656,9 @@ status_t MediaPlayerService::dump(int fd, const Vector<String16>& args)
 
             }
         }
+        write(fd, result.string(), result.size());
+        result.clear();
+        FrameCache::getInstance().dump(fd);
 
         result.append(" Files opened and/or mapped:\n");
         snprintf(buffer, SIZE - 1, "/proc/%d/maps", getpid());
@@ -724,6 +729,7 @@ status_t MediaPlayerService::dump(int fd, const Vector<String16>& args)
         }
 
         gLooperRoster.dump(fd, args);
+        ABuffer::dumpAllocatorStats(fd);
 
         sp<IMediaCodecList> codecList = getCodecList();
         dumpCodecDetails(fd, codecList, true /* decoders */);
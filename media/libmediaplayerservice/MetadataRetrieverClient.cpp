@@ -31,6 +31,7 @@
 #include <unistd.h>
 
 #include <string.h>
+#include <android-base/stringprintf.h>
 #include <cutils/atomic.h>
 #include <cutils/properties.h>
 #include <binder/MemoryBase.h>
@@ -45,12 +46,15 @@
 #include <media/stagefright/Utils.h>
 #include <media/stagefright/FoundationUtils.h>
 #include <private/media/VideoFrame.h>
+#include "FrameCache.h"
 #include "MetadataRetrieverClient.h"
 #include "StagefrightMetadataRetriever.h"
 #include "MediaPlayerFactory.h"
 
 namespace android {
 
+using base::StringPrintf;
+
 MetadataRetrieverClient::MetadataRetrieverClient(pid_t pid)
 {
     ALOGV("MetadataRetrieverClient constructor pid(%d)", pid);
@@ -88,6 +92,7 @@ void MetadataRetrieverClient::disconnect()
     Mutex::Autolock lock(mLock);
     mRetriever.clear();
     mAlbumArt.clear();
+    mCacheKey.clear();
     IPCThreadState::self()->flushCommands();
 }
 
@@ -139,6 +144,7 @@ status_t MetadataRetrieverClient::setDataSource(
     if (p == NULL) return NO_INIT;
     status_t ret = p->setDataSource(httpService, url, headers);
     if (ret == NO_ERROR) mRetriever = p;
+    mCacheKey.clear();
     return ret;
 }
 
@@ -179,6 +185,10 @@ status_t MetadataRetrieverClient::setDataSource(int fd, int64_t offset, int64_t
     }
     status_t status = p->setDataSource(fd, offset, length);
     if (status == NO_ERROR) mRetriever = p;
+    mCacheKey.clear();
+    if (status == NO_ERROR && FrameCache::getInstance().isEnabled()) {
+        mCacheKey = FrameCache::getFileKey(fd, offset, length);
+    }
     return status;
 }
 
@@ -196,6 +206,7 @@ status_t MetadataRetrieverClient::setDataSource(
     if (p == NULL) return NO_INIT;
     status_t ret = p->setDataSource(dataSource, mime);
     if (ret == NO_ERROR) mRetriever = p;
+    mCacheKey.clear();
     return ret;
 }
 
@@ -207,16 +218,28 @@ sp<IMemory> MetadataRetrieverClient::getFrameAtTime(
     ALOGV("getFrameAtTime: time(%" PRId64 "us) option(%d) colorFormat(%d), metaOnly(%d)",
             timeUs, option, colorFormat, metaOnly);
     Mutex::Autolock lock(mLock);
-    Mutex::Autolock glock(sLock);
     if (mRetriever == NULL) {
         ALOGE("retriever is not initialized");
         return NULL;
     }
+    std::string cacheKey;
+    if (!metaOnly && !mCacheKey.empty()) {
+        cacheKey = mCacheKey + StringPrintf(
+                "/frame:%" PRId64 ":%d:%d", timeUs, option, colorFormat);
+        sp<IMemory> frame = FrameCache::getInstance().get(cacheKey);
+        if (frame != NULL) {
+            return frame;
+        }
+    }
+    Mutex::Autolock glock(sLock);
     sp<IMemory> frame = mRetriever->getFrameAtTime(timeUs, option, colorFormat, metaOnly);
     if (frame == NULL) {
         ALOGE("failed to capture a video frame");
         return NULL;
     }
+    if (!cacheKey.empty()) {
+        FrameCache::getInstance().put(cacheKey, frame);
+    }
     return frame;
 }
 
@@ -225,16 +248,27 @@ sp<IMemory> MetadataRetrieverClient::getImageAtIndex(
     ALOGV("getImageAtIndex: index(%d) colorFormat(%d), metaOnly(%d) thumbnail(%d)",
             index, colorFormat, metaOnly, thumbnail);
     Mutex::Autolock lock(mLock);
-    Mutex::Autolock glock(sLock);
     if (mRetriever == NULL) {
         ALOGE("retriever is not initialized");
         return NULL;
     }
+    std::string cacheKey;
+    if (!metaOnly && !mCacheKey.empty()) {
+        cacheKey = mCacheKey + StringPrintf("/image:%d:%d:%d", index, colorFormat, thumbnail);
+        sp<IMemory> frame = FrameCache::getInstance().get(cacheKey);
+        if (frame != NULL) {
+            return frame;
+        }
+    }
+    Mutex::Autolock glock(sLock);
     sp<IMemory> frame = mRetriever->getImageAtIndex(index, colorFormat, metaOnly, thumbnail);
     if (frame == NULL) {
         ALOGE("failed to extract image");
         return NULL;
     }
+    if (!cacheKey.empty()) {
+        FrameCache::getInstance().put(cacheKey, frame);
+    }
     return frame;
 }
 
@@ -274,6 +308,24 @@ sp<IMemory> MetadataRetrieverClient::getFrameAtIndex(
     return frame;
 }
 
+status_t MetadataRetrieverClient::getFramesAtTimes(
+        const std::vector<int64_t> &timesUs, int option, int colorFormat,
+        int maxWidth, int maxHeight, std::vector<sp<IMemory> > *frames) {
+    ALOGV("getFramesAtTimes: %zu frames, option(%d), colorFormat(%d), max %dx%d",
+            timesUs.size(), option, colorFormat, maxWidth, maxHeight);
+    Mutex::Autolock lock(mLock);
+    Mutex::Autolock glock(sLock);
+    if (mRetriever == NULL) {
+        ALOGE("retriever is not initialized");
+        return INVALID_OPERATION;
+    }
+    frames->assign(timesUs.size(), NULL);
+    return mRetriever->getFramesAtTimes(timesUs, option, colorFormat, maxWidth, maxHeight,
+            [frames](size_t index, const sp<IMemory> &frame) {
+                (*frames)[index] = frame;
+            });
+}
+
 sp<IMemory> MetadataRetrieverClient::extractAlbumArt()
 {
     ALOGV("extractAlbumArt");
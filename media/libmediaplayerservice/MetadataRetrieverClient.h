@@ -32,6 +32,8 @@
 #include <media/MediaMetadataRetrieverInterface.h>
 #include "mpctl/PerfBoost.h"
 
+#include <string>
+
 
 namespace android {
 
@@ -63,6 +65,9 @@ public:
             int index, int colorFormat, int left, int top, int right, int bottom);
     virtual sp<IMemory>             getFrameAtIndex(
             int index, int colorFormat, bool metaOnly);
+    virtual status_t                getFramesAtTimes(
+            const std::vector<int64_t> &timesUs, int option, int colorFormat,
+            int maxWidth, int maxHeight, std::vector<sp<IMemory> > *frames);
     virtual sp<IMemory>             extractAlbumArt();
     virtual const char*             extractMetadata(int keyCode);
 
@@ -78,6 +83,8 @@ private:
     static  Mutex                          sLock;
     sp<MediaMetadataRetrieverBase>         mRetriever;
     pid_t                                  mPid;
+    // Identity of the file set with setDataSource(fd), empty if frames can't be cached.
+    std::string                            mCacheKey;
 
     // Keep the shared memory copy of album art
     sp<IMemory>                            mAlbumArt;
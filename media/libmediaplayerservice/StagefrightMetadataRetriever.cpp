@@ -18,6 +18,8 @@
 #define LOG_TAG "StagefrightMetadataRetriever"
 
 #include <inttypes.h>
+#include <algorithm>
+#include <numeric>
 
 #include <utils/Log.h>
 #include <cutils/properties.h>
@@ -337,6 +339,62 @@ sp<IMemory> StagefrightMetadataRetriever::getFrameInternal(
     mDecoder.clear();
     mLastDecodedIndex = -1;
 
+    sp<IMemory> frame;
+    sp<VideoFrameDecoder> decoder =
+            initVideoFrameDecoder(timeUs, option, colorFormat, metaOnly, &frame);
+    // keep the decoder if seeking by frame index
+    if (decoder != NULL && option == MediaSource::ReadOptions::SEEK_FRAME_INDEX) {
+        mDecoder = decoder;
+        mLastDecodedIndex = timeUs;
+    }
+    return frame;
+}
+
+status_t StagefrightMetadataRetriever::getFramesAtTimes(
+        const std::vector<int64_t> &timesUs, int option, int colorFormat,
+        int maxWidth, int maxHeight,
+        const std::function<void(size_t, const sp<IMemory> &)> &onFrame) {
+    ALOGV("getFramesAtTimes: %zu frames option: %d colorFormat: %d max: %dx%d",
+            timesUs.size(), option, colorFormat, maxWidth, maxHeight);
+    mDecoder.clear();
+    mLastDecodedIndex = -1;
+
+    if (option == MediaSource::ReadOptions::SEEK_FRAME_INDEX) {
+        return BAD_VALUE;
+    }
+
+    // Decode in presentation order, so the decoder only ever moves forward and requests
+    // that resolve to the same sync frame come one after the other.
+    std::vector<size_t> order(timesUs.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(),
+            [&timesUs](size_t a, size_t b) { return timesUs[a] < timesUs[b]; });
+
+    sp<VideoFrameDecoder> decoder;
+    sp<IMemory> frame;
+    for (size_t index : order) {
+        if (decoder == NULL) {
+            decoder = initVideoFrameDecoder(
+                    timesUs[index], option, colorFormat, false /* metaOnly */, &frame,
+                    maxWidth, maxHeight);
+        } else {
+            bool sameFrame;
+            status_t err = decoder->seekTo(timesUs[index], option, &sameFrame);
+            if (err != OK) {
+                ALOGW("failed to seek to %" PRId64 " us: %d", timesUs[index], err);
+                frame.clear();
+            } else if (!sameFrame) {
+                frame = decoder->extractFrame();
+            }
+        }
+        onFrame(index, frame);
+    }
+    return OK;
+}
+
+sp<VideoFrameDecoder> StagefrightMetadataRetriever::initVideoFrameDecoder(
+        int64_t timeUs, int option, int colorFormat, bool metaOnly, sp<IMemory> *frame,
+        int32_t maxWidth, int32_t maxHeight) {
     if (mExtractor.get() == NULL) {
         ALOGE("no extractor.");
         return NULL;
@@ -379,7 +437,8 @@ sp<IMemory> StagefrightMetadataRetriever::getFrameInternal(
     }
 
     if (metaOnly) {
-        return FrameDecoder::getMetadataOnly(trackMeta, colorFormat);
+        *frame = FrameDecoder::getMetadataOnly(trackMeta, colorFormat);
+        return NULL;
     }
 
     sp<IMediaSource> source = mExtractor->getTrack(i);
@@ -424,15 +483,11 @@ sp<IMemory> StagefrightMetadataRetriever::getFrameInternal(
     for (size_t i = 0; i < matchingCodecs.size(); ++i) {
         const AString &componentName = matchingCodecs[i];
         sp<VideoFrameDecoder> decoder = new VideoFrameDecoder(componentName, trackMeta, source);
+        decoder->setMaxOutputSize(maxWidth, maxHeight);
         if (decoder->init(timeUs, option, colorFormat) == OK) {
-            sp<IMemory> frame = decoder->extractFrame();
-            if (frame != nullptr) {
-                // keep the decoder if seeking by frame index
-                if (option == MediaSource::ReadOptions::SEEK_FRAME_INDEX) {
-                    mDecoder = decoder;
-                    mLastDecodedIndex = timeUs;
-                }
-                return frame;
+            *frame = decoder->extractFrame();
+            if (*frame != nullptr) {
+                return decoder;
             }
         }
         ALOGV("%s failed to extract frame, trying next decoder.", componentName.c_str());
@@ -28,6 +28,7 @@ namespace android {
 class DataSource;
 struct FrameDecoder;
 struct FrameRect;
+struct VideoFrameDecoder;
 
 struct StagefrightMetadataRetriever : public MediaMetadataRetrieverBase {
     StagefrightMetadataRetriever();
@@ -49,6 +50,10 @@ struct StagefrightMetadataRetriever : public MediaMetadataRetrieverBase {
             int index, int colorFormat, int left, int top, int right, int bottom);
     virtual sp<IMemory> getFrameAtIndex(
             int index, int colorFormat, bool metaOnly);
+    virtual status_t getFramesAtTimes(
+            const std::vector<int64_t> &timesUs, int option, int colorFormat,
+            int maxWidth, int maxHeight,
+            const std::function<void(size_t, const sp<IMemory> &)> &onFrame);
 
     virtual MediaAlbumArt *extractAlbumArt();
     virtual const char *extractMetadata(int keyCode);
@@ -71,6 +76,12 @@ private:
     sp<IMemory> getFrameInternal(
             int64_t timeUs, int option, int colorFormat, bool metaOnly);
 
+    // Finds the video track and returns a decoder that has extracted the frame at |timeUs|
+    // into |frame|, trying each matching codec in turn.
+    sp<VideoFrameDecoder> initVideoFrameDecoder(
+            int64_t timeUs, int option, int colorFormat, bool metaOnly, sp<IMemory> *frame,
+            int32_t maxWidth = 0, int32_t maxHeight = 0);
+
     sp<IMemory> getImageInternal(
             int index, int colorFormat, bool metaOnly, bool thumbnail, FrameRect* rect);
 
@@ -139,6 +139,7 @@ StagefrightRecorder::StagefrightRecorder(const AttributionSourceState& client)
       mRTPCVODegrees(0),
       mRTPSockDscp(0),
       mRTPSockOptEcn(0),
+      mRTPPacing(false),
       mRTPSockNetwork(0),
       mLastSeqNo(0),
       mStarted(false),
@@ -802,6 +803,16 @@ status_t StagefrightRecorder::setParamCaptureFpsEnable(int32_t captureFpsEnable)
     return OK;
 }
 
+status_t StagefrightRecorder::setParamLowLatency(int32_t lowLatency) {
+    ALOGV("setParamLowLatency: %d", lowLatency);
+
+    if (lowLatency != 0 && lowLatency != 1) {
+        return BAD_VALUE;
+    }
+    mLowLatency = lowLatency;
+    return OK;
+}
+
 status_t StagefrightRecorder::setParamCaptureFps(double fps) {
     ALOGV("setParamCaptureFps: %.2f", fps);
 
@@ -912,6 +923,13 @@ status_t StagefrightRecorder::setParamRtpDscp(int32_t dscp) {
     return OK;
 }
 
+status_t StagefrightRecorder::setParamRtpPacing(int32_t pacing) {
+    ALOGV("setParamRtpPacing: %d", pacing);
+
+    mRTPPacing = pacing != 0;
+    return OK;
+}
+
 status_t StagefrightRecorder::setSocketNetwork(int64_t networkHandle) {
     ALOGV("setSocketNetwork: %llu", (unsigned long long) networkHandle);
 
@@ -1055,6 +1073,11 @@ status_t StagefrightRecorder::setParameter(
         if (safe_strtoi32(value.string(), &captureFpsEnable)) {
             return setParamCaptureFpsEnable(captureFpsEnable);
         }
+    } else if (key == "low-latency") {
+        int32_t lowLatency;
+        if (safe_strtoi32(value.string(), &lowLatency)) {
+            return setParamLowLatency(lowLatency);
+        }
     } else if (key == "time-lapse-fps") {
         double fps;
         if (safe_strtod(value.string(), &fps)) {
@@ -1115,6 +1138,11 @@ status_t StagefrightRecorder::setParameter(
         if (safe_strtoi32(value.string(), &targetEcn)) {
             return setParamRtpEcn(targetEcn);
         }
+    } else if (key == "rtp-param-set-pacing") {
+        int32_t pacing;
+        if (safe_strtoi32(value.string(), &pacing)) {
+            return setParamRtpPacing(pacing);
+        }
     } else if (key == "rtp-param-set-socket-network") {
         int64_t networkHandle;
         if (safe_strtoi64(value.string(), &networkHandle)) {
@@ -1297,6 +1325,9 @@ status_t StagefrightRecorder::start() {
             if (mRTPSockOptEcn > 0) {
                 meta->setInt32(kKeyRtpEcn, mRTPSockOptEcn);
             }
+            if (mRTPPacing) {
+                meta->setInt32(kKeyRtpPacing, 1);
+            }
 
             status = mWriter->start(meta.get());
             break;
@@ -1447,6 +1478,21 @@ sp<MediaCodecSource> StagefrightRecorder::createAudioSource() {
         }
     }
 
+    // Hand the encoder whole frames instead of one AudioRecord callback at a time,
+    // unless latency matters more than per-buffer overhead.
+    if (!mLowLatency) {
+        size_t batchFrameCount = 0;
+        if (mAudioEncoder == AUDIO_ENCODER_AAC) {
+            batchFrameCount = 1024;
+        } else if (mAudioEncoder == AUDIO_ENCODER_HE_AAC
+                || mAudioEncoder == AUDIO_ENCODER_HE_AAC_PS) {
+            batchFrameCount = 2048;
+        }
+        if (batchFrameCount > 0 && audioSource->setBatchFrameCount(batchFrameCount) != OK) {
+            ALOGW("Failed to batch audio source reads");
+        }
+    }
+
     int32_t maxInputSize;
     CHECK(audioSource->getFormat()->findInt32(
                 kKeyMaxInputSize, &maxInputSize));
@@ -1460,8 +1506,9 @@ sp<MediaCodecSource> StagefrightRecorder::createAudioSource() {
     }
     format->setInt32("priority", 0 /* realtime */);
 
-    sp<MediaCodecSource> audioEncoder =
-            MediaCodecSource::Create(mLooper, format, audioSource);
+    sp<MediaCodecSource> audioEncoder = MediaCodecSource::Create(
+            mLooper, format, audioSource, NULL /* persistentSurface */,
+            mLowLatency ? MediaCodecSource::FLAG_LOW_LATENCY : 0);
     if (audioEncoder == NULL) {
         ALOGE("Failed to create audio encoder");
     } else {
@@ -2169,6 +2216,9 @@ status_t StagefrightRecorder::setupVideoEncoder(
     format->setInt32("isNativeRecorder", 1);
 
     uint32_t flags = 0;
+    if (mLowLatency) {
+        flags |= MediaCodecSource::FLAG_LOW_LATENCY;
+    }
     if (cameraSource == NULL) {
         flags |= MediaCodecSource::FLAG_USE_SURFACE_INPUT;
     } else {
@@ -2602,6 +2652,7 @@ status_t StagefrightRecorder::reset() {
     mTrackEveryTimeDurationUs = 0;
     mCaptureFpsEnable = false;
     mCaptureFps = -1.0;
+    mLowLatency = false;
     mCameraSourceTimeLapse = NULL;
     mMetaDataStoredInVideoBuffers = kMetadataBufferTypeInvalid;
     mEncoderProfiles = MediaProfiles::getInstance();
@@ -2802,6 +2853,19 @@ status_t StagefrightRecorder::dump(
     result.append(buffer);
     snprintf(buffer, SIZE, "     Bit rate (bps): %d\n", mVideoBitRate);
     result.append(buffer);
+    snprintf(buffer, SIZE, "   Low latency: %s\n", mLowLatency ? "yes" : "no");
+    result.append(buffer);
+    for (const auto &source : { mAudioEncoderSource, mVideoEncoderSource }) {
+        if (source == NULL) {
+            continue;
+        }
+        int64_t count, avgUs, maxUs;
+        source->getLatencyStats(&count, &avgUs, &maxUs);
+        snprintf(buffer, SIZE, "   %s encode latency: %" PRId64 " frames, avg %" PRId64
+                " us, max %" PRId64 " us\n", source->isVideo() ? "Video" : "Audio",
+                count, avgUs, maxUs);
+        result.append(buffer);
+    }
     ::write(fd, result.string(), result.size());
     return OK;
 }
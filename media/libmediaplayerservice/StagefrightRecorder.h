@@ -156,6 +156,7 @@ protected:
     int32_t mRTPCVODegrees;
     int32_t mRTPSockDscp;
     int32_t mRTPSockOptEcn;
+    bool mRTPPacing;
     int64_t mRTPSockNetwork;
     uint32_t mLastSeqNo;
 
@@ -166,6 +167,7 @@ protected:
 
     bool mCaptureFpsEnable;
     double mCaptureFps;
+    bool mLowLatency;
     int64_t mTimeBetweenCaptureUs;
     sp<CameraSourceTimeLapse> mCameraSourceTimeLapse;
     sp<CameraSource> mCameraSource;
@@ -226,6 +228,7 @@ protected:
     status_t setParamAudioSamplingRate(int32_t sampleRate);
     status_t setParamAudioTimeScale(int32_t timeScale);
     status_t setParamCaptureFpsEnable(int32_t timeLapseEnable);
+    status_t setParamLowLatency(int32_t lowLatency);
     status_t setParamCaptureFps(double fps);
     status_t setParamVideoEncodingBitRate(int32_t bitRate);
     status_t setParamVideoBitRateMode(int32_t bitRateMode);
@@ -254,6 +257,7 @@ protected:
     status_t setRTPCVODegrees(int32_t cvoDegrees);
     status_t setParamRtpDscp(int32_t dscp);
     status_t setParamRtpEcn(int32_t ecn);
+    status_t setParamRtpPacing(int32_t pacing);
     status_t setSocketNetwork(int64_t networkHandle);
     status_t requestIDRFrame();
     void clipVideoBitRate();
@@ -53,6 +53,22 @@ static const int kInitialMarkMs        = 5000;  // 5secs
 //static const int kPausePlaybackMarkMs  = 2000;  // 2secs
 static const int kResumePlaybackMarkMs = 15000;  // 15secs
 
+/*
+   #Read audio and video samples on separate loopers
+   adb shell setprop media.stagefright.generic.parallel_read 1
+
+   #Keep this much audio and video read ahead of the decoders (example: 2000 msec)
+   adb shell setprop media.stagefright.generic.prefetch_ms 2000
+ */
+static inline bool getParallelReadSetting() {
+    return property_get_bool("media.stagefright.generic.parallel_read", false /* default_value */);
+}
+
+static inline int64_t getPrefetchUsSetting() {
+    return std::max(0, property_get_int32(
+            "media.stagefright.generic.prefetch_ms", 0 /* default_value */)) * 1000LL;
+}
+
 NuPlayer::GenericSource::GenericSource(
         const sp<AMessage> &notify,
         bool uidValid,
@@ -78,7 +94,11 @@ NuPlayer::GenericSource::GenericSource(
       mUID(uid),
       mMediaClock(mediaClock),
       mBitrate(-1LL),
-      mPendingReadBufferTypes(0) {
+      mPendingReadBufferTypes(0),
+      mReadingTrackTypes(0),
+      mScrubbing(false),
+      mParallelReads(getParallelReadSetting()),
+      mPrefetchUs(getPrefetchUsSetting()) {
     ALOGV("GenericSource");
     CHECK(mediaClock != NULL);
 
@@ -335,6 +355,11 @@ int64_t NuPlayer::GenericSource::getLastReadPosition() {
     }
 }
 
+void NuPlayer::GenericSource::setScrubbing(bool scrubbing) {
+    Mutex::Autolock _l(mLock);
+    mScrubbing = scrubbing;
+}
+
 bool NuPlayer::GenericSource::isStreaming() const {
     Mutex::Autolock _l(mLock);
     return mIsStreaming;
@@ -346,6 +371,14 @@ NuPlayer::GenericSource::~GenericSource() {
         mLooper->unregisterHandler(id());
         mLooper->stop();
     }
+    if (mAudioReadLooper != NULL) {
+        mAudioReadLooper->unregisterHandler(mAudioReader->id());
+        mAudioReadLooper->stop();
+    }
+    if (mVideoReadLooper != NULL) {
+        mVideoReadLooper->unregisterHandler(mVideoReader->id());
+        mVideoReadLooper->stop();
+    }
     resetDataSource();
 }
 
@@ -361,6 +394,20 @@ void NuPlayer::GenericSource::prepareAsync() {
         mLooper->registerHandler(this);
     }
 
+    if (mParallelReads && mAudioReadLooper == NULL) {
+        mAudioReadLooper = new ALooper;
+        mAudioReadLooper->setName("generic-audio");
+        mAudioReadLooper->start();
+        mAudioReader = new AHandlerReflector<GenericSource>(this);
+        mAudioReadLooper->registerHandler(mAudioReader);
+
+        mVideoReadLooper = new ALooper;
+        mVideoReadLooper->setName("generic-video");
+        mVideoReadLooper->start();
+        mVideoReader = new AHandlerReflector<GenericSource>(this);
+        mVideoReadLooper->registerHandler(mVideoReader);
+    }
+
     sp<AMessage> msg = new AMessage(kWhatPrepareAsync, this);
     msg->post();
 }
@@ -663,7 +710,10 @@ void NuPlayer::GenericSource::onMessageReceived(const sp<AMessage> &msg) {
               counterpartType = MEDIA_TRACK_TYPE_AUDIO;;
           }
 
-
+          // Let an in-flight read on the track's reader looper finish with the old source.
+          while (mReadingTrackTypes & (1 << trackType)) {
+              mReadCondition.wait(mLock);
+          }
           if (track->mSource != NULL) {
               track->mSource->stop();
           }
@@ -867,7 +917,9 @@ status_t NuPlayer::GenericSource::dequeueAccessUnit(
     // start pulling in more buffers if cache is running low
     // so that decoder has less chance of being starved
     if (!mIsStreaming) {
-        if (track->mPackets->getAvailableBufferCount(&finalResult) < 2) {
+        if (track->mPackets->getAvailableBufferCount(&finalResult) < 2
+                || (mPrefetchUs > 0 && finalResult == OK
+                        && track->mPackets->getBufferedDurationUs(&finalResult) < mPrefetchUs)) {
             postReadBuffer(audio? MEDIA_TRACK_TYPE_AUDIO : MEDIA_TRACK_TYPE_VIDEO);
         }
     } else {
@@ -1317,10 +1369,19 @@ int32_t NuPlayer::GenericSource::getDataGeneration(media_track_type type) const
     return generation;
 }
 
+sp<AHandler> NuPlayer::GenericSource::getReadHandler(media_track_type trackType) {
+    if (trackType == MEDIA_TRACK_TYPE_AUDIO && mAudioReader != NULL) {
+        return mAudioReader;
+    } else if (trackType == MEDIA_TRACK_TYPE_VIDEO && mVideoReader != NULL) {
+        return mVideoReader;
+    }
+    return this;
+}
+
 void NuPlayer::GenericSource::postReadBuffer(media_track_type trackType) {
     if ((mPendingReadBufferTypes & (1 << trackType)) == 0) {
         mPendingReadBufferTypes |= (1 << trackType);
-        sp<AMessage> msg = new AMessage(kWhatReadBuffer, this);
+        sp<AMessage> msg = new AMessage(kWhatReadBuffer, getReadHandler(trackType));
         msg->setInt32("trackType", trackType);
         msg->post();
     }
@@ -1380,12 +1441,31 @@ void NuPlayer::GenericSource::readBuffer(
         options.setNonBlocking();
     }
 
+    ReadStats *stats = NULL;
+    if (trackType == MEDIA_TRACK_TYPE_AUDIO) {
+        stats = &mAudioReadStats;
+    } else if (trackType == MEDIA_TRACK_TYPE_VIDEO) {
+        stats = &mVideoReadStats;
+    }
+
     int32_t generation = getDataGeneration(trackType);
-    for (size_t numBuffers = 0; numBuffers < maxBuffers; ) {
+    size_t numBuffers = 0;
+    while (numBuffers < maxBuffers) {
         Vector<MediaBufferBase *> mediaBuffers;
         status_t err = NO_ERROR;
 
+        // IMediaSource is not thread safe. With parallel reads, a seek on |mLooper| may
+        // find the track's reader looper in the middle of a read.
+        while (mReadingTrackTypes & (1 << trackType)) {
+            mReadCondition.wait(mLock);
+        }
+        if (generation != getDataGeneration(trackType) || track->mSource == NULL) {
+            break;
+        }
+        mReadingTrackTypes |= (1 << trackType);
+
         sp<IMediaSource> source = track->mSource;
+        const int64_t readStartUs = ALooper::GetNowUs();
         mLock.unlock();
         if (couldReadMultiple) {
             err = source->readMultiple(
@@ -1397,8 +1477,17 @@ void NuPlayer::GenericSource::readBuffer(
                 mediaBuffers.push_back(mbuf);
             }
         }
+        const int64_t readTimeUs = ALooper::GetNowUs() - readStartUs;
         mLock.lock();
 
+        mReadingTrackTypes &= ~(1 << trackType);
+        mReadCondition.broadcast();
+        if (stats != NULL) {
+            ++stats->mNumReads;
+            stats->mTotalReadTimeUs += readTimeUs;
+            stats->mMaxReadTimeUs = std::max(stats->mMaxReadTimeUs, readTimeUs);
+        }
+
         options.clearNonPersistent();
 
         size_t id = 0;
@@ -1420,6 +1509,13 @@ void NuPlayer::GenericSource::readBuffer(
                 track->mPackets->signalEOS(ERROR_MALFORMED);
                 break;
             }
+            int32_t isSync = 0;
+            if (mScrubbing && trackType == MEDIA_TRACK_TYPE_VIDEO && !seeking
+                    && (!mbuf->meta_data().findInt32(kKeyIsSyncFrame, &isSync) || !isSync)) {
+                // Only sync samples are decoded while scrubbing.
+                mbuf->release();
+                continue;
+            }
             if (trackType == MEDIA_TRACK_TYPE_AUDIO) {
                 mAudioTimeUs = timeUs;
             } else if (trackType == MEDIA_TRACK_TYPE_VIDEO) {
@@ -1471,6 +1567,15 @@ void NuPlayer::GenericSource::readBuffer(
         }
     }
 
+    if (!mIsStreaming && mPrefetchUs > 0 && numBuffers > 0 && stats != NULL
+            && generation == getDataGeneration(trackType)) {
+        status_t finalResult;
+        int64_t durationUs = track->mPackets->getBufferedDurationUs(&finalResult);
+        if (finalResult == OK && durationUs < mPrefetchUs) {
+            postReadBuffer(trackType);
+        }
+    }
+
     if (mIsStreaming
         && (trackType == MEDIA_TRACK_TYPE_VIDEO || trackType == MEDIA_TRACK_TYPE_AUDIO)) {
         status_t finalResult;
@@ -1507,6 +1612,41 @@ void NuPlayer::GenericSource::readBuffer(
     }
 }
 
+sp<AMessage> NuPlayer::GenericSource::getStats() const {
+    // Do not hold up dumpsys behind a long prepare.
+    if (mLock.tryLock() != NO_ERROR) {
+        return NULL;
+    }
+
+    sp<AMessage> stats = new AMessage;
+    stats->setInt32("parallel-reads", mParallelReads);
+    stats->setInt64("prefetch-us", mPrefetchUs);
+
+    status_t finalResult;
+    if (mAudioTrack.mSource != NULL) {
+        stats->setInt64("audio-buffered-us",
+                mAudioTrack.mPackets->getBufferedDurationUs(&finalResult));
+        stats->setInt64("audio-reads", mAudioReadStats.mNumReads);
+        stats->setInt64("audio-read-time-us", mAudioReadStats.mTotalReadTimeUs);
+        stats->setInt64("audio-max-read-us", mAudioReadStats.mMaxReadTimeUs);
+    }
+    if (mVideoTrack.mSource != NULL) {
+        stats->setInt64("video-buffered-us",
+                mVideoTrack.mPackets->getBufferedDurationUs(&finalResult));
+        stats->setInt64("video-reads", mVideoReadStats.mNumReads);
+        stats->setInt64("video-read-time-us", mVideoReadStats.mTotalReadTimeUs);
+        stats->setInt64("video-max-read-us", mVideoReadStats.mMaxReadTimeUs);
+    }
+
+    int32_t kbps;
+    if (mCachedSource != NULL && mCachedSource->getEstimatedBandwidthKbps(&kbps) == OK) {
+        stats->setInt32("cache-bandwidth-kbps", kbps);
+    }
+
+    mLock.unlock();
+    return stats;
+}
+
 void NuPlayer::GenericSource::queueDiscontinuityIfNeeded(
         bool seeking, bool formatChange, media_track_type trackType, Track *track) {
     // formatChange && seeking: track whose source is changed during selection
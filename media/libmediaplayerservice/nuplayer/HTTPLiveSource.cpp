@@ -195,6 +195,13 @@ ssize_t NuPlayer::HTTPLiveSource::getSelectedTrack(media_track_type type) const
     }
 }
 
+sp<AMessage> NuPlayer::HTTPLiveSource::getStats() const {
+    if (mLiveSession == NULL) {
+        return NULL;
+    }
+    return mLiveSession->getStats();
+}
+
 status_t NuPlayer::HTTPLiveSource::selectTrack(size_t trackIndex, bool select, int64_t /*timeUs*/) {
     if (mLiveSession == NULL) {
         return INVALID_OPERATION;
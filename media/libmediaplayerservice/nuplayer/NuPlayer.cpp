@@ -232,7 +232,9 @@ NuPlayer::NuPlayer(pid_t pid, const sp<MediaClock> &mediaClock)
       mPausedByClient(true),
       mPausedForBuffering(false),
       mIsDrmProtected(false),
-      mDataSourceType(DATA_SOURCE_TYPE_NONE) {
+      mDataSourceType(DATA_SOURCE_TYPE_NONE),
+      mScrubbing(false),
+      mSeekGeneration(0) {
     CHECK(mediaClock != NULL);
     clearFlushComplete();
 }
@@ -537,6 +539,7 @@ void NuPlayer::seekToAsync(int64_t seekTimeUs, MediaPlayerSeekMode mode, bool ne
     msg->setInt64("seekTimeUs", seekTimeUs);
     msg->setInt32("mode", mode);
     msg->setInt32("needNotify", needNotify);
+    msg->setInt32("generation", ++mSeekGeneration);
     msg->post();
 }
 
@@ -1477,6 +1480,24 @@ void NuPlayer::onMessageReceived(const sp<AMessage> &msg) {
             ALOGV("kWhatSeek seekTimeUs=%lld us, mode=%d, needNotify=%d",
                     (long long)seekTimeUs, mode, needNotify);
 
+            if (mScrubbing && mStarted) {
+                int32_t generation;
+                CHECK(msg->findInt32("generation", &generation));
+                if (generation != mSeekGeneration) {
+                    // A newer seek is already queued, it will take us there.
+                    ALOGV("kWhatSeek dropping stale scrub seek to %lld us",
+                            (long long)seekTimeUs);
+                    if (needNotify) {
+                        notifyDriverSeekComplete();
+                    }
+                    break;
+                }
+                // Decoding up to the exact target is what makes scrubbing slow.
+                if (mode == MediaPlayerSeekMode::SEEK_CLOSEST) {
+                    mode = MediaPlayerSeekMode::SEEK_PREVIOUS_SYNC;
+                }
+            }
+
             if (!mStarted) {
                 // Seek before the player is started. In order to preview video,
                 // need to start the player and pause it. This branch is called
@@ -1815,6 +1836,13 @@ void NuPlayer::setTargetBitrate(int bitrate) {
     }
 }
 
+void NuPlayer::setScrubbing(bool scrubbing) {
+    mScrubbing = scrubbing;
+    if (mSource != NULL) {
+        mSource->setScrubbing(scrubbing);
+    }
+}
+
 void NuPlayer::onPause() {
 
     updatePlaybackTimer(true /* stopping */, "onPause");
@@ -2402,6 +2430,12 @@ void NuPlayer::getStats(Vector<sp<AMessage> > *trackStats) {
     if (mAudioDecoder != NULL) {
         trackStats->push_back(mAudioDecoder->getStats());
     }
+    if (mSource != NULL) {
+        sp<AMessage> sourceStats = mSource->getStats();
+        if (sourceStats != NULL) {
+            trackStats->push_back(sourceStats);
+        }
+    }
 }
 
 sp<MetaData> NuPlayer::getFileMeta() {
@@ -70,6 +70,12 @@ static const char *kPlayerDataSourceType = "android.media.mediaplayer.dataSource
 static const char *kPlayerRebuffering = "android.media.mediaplayer.rebufferingMs";
 static const char *kPlayerRebufferingCount = "android.media.mediaplayer.rebuffers";
 static const char *kPlayerRebufferingAtExit = "android.media.mediaplayer.rebufferExit";
+//
+static const char *kPlayerBandwidth = "android.media.mediaplayer.bandwidthBps";
+static const char *kPlayerBandwidthEwma = "android.media.mediaplayer.bandwidthEwmaBps";
+static const char *kPlayerUpSwitches = "android.media.mediaplayer.upSwitches";
+static const char *kPlayerDownSwitches = "android.media.mediaplayer.downSwitches";
+static const char *kPlayerDeferredUpSwitches = "android.media.mediaplayer.deferredUpSwitches";
 
 
 NuPlayerDriver::NuPlayerDriver(pid_t pid)
@@ -655,6 +661,24 @@ void NuPlayerDriver::updateMetrics(const char *where) {
                 if (!name.empty()) {
                     mMetricsItem->setCString(kPlayerACodec, name.c_str());
                 }
+            } else if (mime.empty()) {
+                // statistics of an adaptive streaming source
+                int32_t value;
+                if (stats->findInt32("bandwidth-bps", &value) && value >= 0) {
+                    mMetricsItem->setInt32(kPlayerBandwidth, value);
+                }
+                if (stats->findInt32("bandwidth-ewma-bps", &value) && value >= 0) {
+                    mMetricsItem->setInt32(kPlayerBandwidthEwma, value);
+                }
+                if (stats->findInt32("up-switches", &value)) {
+                    mMetricsItem->setInt32(kPlayerUpSwitches, value);
+                }
+                if (stats->findInt32("down-switches", &value)) {
+                    mMetricsItem->setInt32(kPlayerDownSwitches, value);
+                }
+                if (stats->findInt32("deferred-up-switches", &value)) {
+                    mMetricsItem->setInt32(kPlayerDeferredUpSwitches, value);
+                }
             }
         }
     }
@@ -841,6 +865,11 @@ status_t NuPlayerDriver::setParameter(
         mPlayer->setTargetBitrate(request.readInt32());
         return OK;
     }
+    if (key == FOURCC('s','c','r','b')) {
+        // scrb -- non-zero while the user drags the seek bar
+        mPlayer->setScrubbing(request.readInt32() != 0);
+        return OK;
+    }
     return INVALID_OPERATION;
 }
 
@@ -1021,6 +1050,48 @@ status_t NuPlayerDriver::dump(
                             ? 0.0 : (double)(numFramesDropped * 100) / numFramesTotal);
             logString.append(buf);
         }
+
+        int32_t bandwidthBps, upSwitches, downSwitches;
+        if (stats->findInt32("bandwidth-bps", &bandwidthBps)
+                && stats->findInt32("up-switches", &upSwitches)
+                && stats->findInt32("down-switches", &downSwitches)) {
+            snprintf(buf, sizeof(buf), "  bandwidth(%d bps), switches up(%d) down(%d)\n",
+                     bandwidthBps, upSwitches, downSwitches);
+            logString.append(buf);
+        }
+
+        int32_t parallelReads;
+        int64_t prefetchUs;
+        if (stats->findInt32("parallel-reads", &parallelReads)
+                && stats->findInt64("prefetch-us", &prefetchUs)) {
+            snprintf(buf, sizeof(buf), "  source reads parallel(%d), prefetch(%lld us)\n",
+                     parallelReads, (long long)prefetchUs);
+            logString.append(buf);
+
+            static const char * const kTracks[] = { "audio", "video" };
+            for (const char *track : kTracks) {
+                int64_t bufferedUs, numReads, readTimeUs, maxReadUs;
+                if (stats->findInt64(AStringPrintf("%s-buffered-us", track).c_str(), &bufferedUs)
+                        && stats->findInt64(AStringPrintf("%s-reads", track).c_str(), &numReads)
+                        && stats->findInt64(
+                                AStringPrintf("%s-read-time-us", track).c_str(), &readTimeUs)
+                        && stats->findInt64(
+                                AStringPrintf("%s-max-read-us", track).c_str(), &maxReadUs)) {
+                    snprintf(buf, sizeof(buf), "    %s buffered(%lld us), reads(%lld), "
+                             "avgRead(%lld us), maxRead(%lld us)\n",
+                             track, (long long)bufferedUs, (long long)numReads,
+                             numReads == 0 ? 0LL : (long long)(readTimeUs / numReads),
+                             (long long)maxReadUs);
+                    logString.append(buf);
+                }
+            }
+
+            int32_t cacheKbps;
+            if (stats->findInt32("cache-bandwidth-kbps", &cacheKbps)) {
+                snprintf(buf, sizeof(buf), "    cache bandwidth(%d kbps)\n", cacheKbps);
+                logString.append(buf);
+            }
+        }
     }
 
     ALOGI("%s", logString.c_str());
@@ -25,6 +25,7 @@
 #include <media/stagefright/foundation/ADebug.h>
 #include <media/stagefright/foundation/AMessage.h>
 #include <media/stagefright/foundation/AUtils.h>
+#include <media/stagefright/foundation/MediaTrace.h>
 #include <media/stagefright/MediaClock.h>
 #include <media/stagefright/MediaCodecConstants.h>
 #include <media/stagefright/MediaDefs.h>
@@ -59,6 +60,12 @@ namespace android {
    #Set size of buffers for pcm audio sink in msec (example: 1000 msec)
    adb shell setprop media.stagefright.audio.sink 1000
 
+   #Defer PCM writes until the audio sink has only this much left to play (example: 100 msec)
+   adb shell setprop media.stagefright.audio.batch_ms 100
+
+   #Release up to this many video frames per renderer wake-up (example: 2 frames)
+   adb shell setprop media.stagefright.video.release_batch 2
+
  * These configurations take effect for the next track played (not the current track).
  */
 
@@ -71,10 +78,24 @@ static inline int32_t getAudioSinkPcmMsSetting() {
             "media.stagefright.audio.sink", 500 /* default_value */);
 }
 
+static inline int32_t getAudioDrainBatchMsSetting() {
+    return std::max(0, property_get_int32(
+            "media.stagefright.audio.batch_ms", 0 /* default_value */));
+}
+
+static inline int32_t getVideoReleaseBatchSetting() {
+    return std::max(1, property_get_int32(
+            "media.stagefright.video.release_batch", 1 /* default_value */));
+}
+
 // Maximum time in paused state when offloading audio decompression. When elapsed, the AudioSink
 // is closed to allow the audio DSP to power down.
 static const int64_t kOffloadPauseMaxUs = 10000000LL;
 
+// ITU max-allowed video-lead-time. Video frames are released to the surface this early, with
+// their presentation timestamps, so the display can pick them up on time.
+static const int64_t kMaxVideoLeadTimeUs = 45000LL;
+
 // Additional delay after teardown before releasing the wake lock to allow time for the audio path
 // to be completely released
 static const int64_t kWakelockReleaseDelayUs = 2000000LL;
@@ -167,7 +188,11 @@ NuPlayer::Renderer::Renderer(
       mWakeLock(new AWakeLock()),
       mNeedVideoClearAnchor(false),
       mIsSeekonPause(false),
-      mVideoRenderFps(0.0f) {
+      mVideoRenderFps(0.0f),
+      mVideoReleaseBatch(getVideoReleaseBatchSetting()),
+      mAudioDrainBatchUs(getAudioDrainBatchMsSetting() * 1000LL),
+      mAudioDrainWakeups(0),
+      mAudioBuffersDrained(0) {
     CHECK(mediaClock != NULL);
     mPlaybackRate = mPlaybackSettings.mSpeed;
     mMediaClock->setPlaybackRate(mPlaybackRate);
@@ -507,6 +532,10 @@ void NuPlayer::Renderer::dump(AString& logString) {
     mWakelockReleaseEvent.dump(logString);
     logString.append(", cancel=");
     mWakelockCancelEvent.dump(logString);
+    logString.append("), audioDrain(wakeups=");
+    logString.append((long long)mAudioDrainWakeups.load());
+    logString.append(", buffers=");
+    logString.append((long long)mAudioBuffersDrained.load());
     logString.append(")");
 }
 
@@ -626,6 +655,7 @@ void NuPlayer::Renderer::onMessageReceived(const sp<AMessage> &msg) {
                 break;
             }
 
+            ++mAudioDrainWakeups;
             if (onDrainAudioQueue()) {
                 uint32_t numFramesPlayed;
                 if (mAudioSink->getPosition(&numFramesPlayed) != OK) {
@@ -904,6 +934,22 @@ void NuPlayer::Renderer::postDrainAudioQueue_l(int64_t delayUs) {
     msg->post(delayUs);
 }
 
+// When audio drain batching is enabled, a newly queued PCM buffer does not wake the renderer up
+// right away while the sink still has plenty to play. The drain runs once the sink is down to
+// mAudioDrainBatchUs of pending playout and writes every buffer queued in the meantime.
+int64_t NuPlayer::Renderer::getAudioDrainBatchDelayUs_l() {
+    if (mAudioDrainBatchUs <= 0 || offloadingAudio() || mUseVirtualAudioSink
+            || mPaused || mNumFramesWritten == 0) {
+        return 0;
+    }
+
+    int64_t pendingUs = getPendingAudioPlayoutDurationUs(ALooper::GetNowUs());
+    if (mPlaybackRate > 1.0f) {
+        pendingUs /= mPlaybackRate;
+    }
+    return std::max(pendingUs - mAudioDrainBatchUs, (int64_t)0);
+}
+
 void NuPlayer::Renderer::prepareForMediaRenderingStart_l() {
     mAudioRenderingStartGeneration = mAudioDrainGeneration;
     mVideoRenderingStartGeneration = mVideoDrainGeneration;
@@ -1182,6 +1228,7 @@ bool NuPlayer::Renderer::onDrainAudioQueue() {
             CHECK(entry->mBuffer->meta()->findInt64("timeUs", &mediaTimeUs));
             ALOGV("onDrainAudioQueue: rendering audio at media time %.2f secs",
                     mediaTimeUs / 1E6);
+            MEDIA_TRACE_RENDER("NuPlayerRenderer::writeAudio", "audio", mediaTimeUs, -1);
             onNewAudioMediaTime(mediaTimeUs);
         }
 
@@ -1214,6 +1261,7 @@ bool NuPlayer::Renderer::onDrainAudioQueue() {
 
             entry->mNotifyConsumed->post();
             mAudioQueue.erase(mAudioQueue.begin());
+            ++mAudioBuffersDrained;
 
             entry = NULL;
         }
@@ -1460,7 +1508,8 @@ void NuPlayer::Renderer::postDrainVideoQueue() {
         msg->post();
     } else {
         int64_t vsyncPeriodUs = mVideoScheduler->getVsyncPeriod() / 1000;
-        int64_t preVsyncsUs = vsyncPeriodUs ? (45000 / vsyncPeriodUs) * vsyncPeriodUs : 0ll;
+        int64_t preVsyncsUs =
+                vsyncPeriodUs ? (kMaxVideoLeadTimeUs / vsyncPeriodUs) * vsyncPeriodUs : 0ll;
 
         // post "45 ms / vsyncPeriod" display refreshes before rendering is due
         // (ITU max-allowed video-lead-time is 45 ms)
@@ -1540,6 +1589,8 @@ void NuPlayer::Renderer::onDrainVideoQueue() {
         tooLate = false;
     }
 
+    MEDIA_TRACE_RENDER("NuPlayerRenderer::drainVideo", tooLate ? "late" : "video",
+            mediaTimeUs, -1);
     entry->mNotifyConsumed->setInt64("timestampNs", realTimeUs * 1000LL);
     entry->mNotifyConsumed->setInt32("render", !tooLate);
     entry->mNotifyConsumed->post();
@@ -1553,8 +1604,59 @@ void NuPlayer::Renderer::onDrainVideoQueue() {
             mVideoRenderingStarted = true;
             notifyVideoRenderingStart();
         }
-        Mutex::Autolock autoLock(mLock);
-        notifyIfMediaRenderingStarted_l();
+        {
+            Mutex::Autolock autoLock(mLock);
+            notifyIfMediaRenderingStarted_l();
+        }
+
+        if (!tooLate && mVideoReleaseBatch > 1 && !(mFlags & FLAG_REAL_TIME)) {
+            releaseVideoFramesAhead(nowUs);
+        }
+    }
+}
+
+// Releases the frames following the one just rendered that are due within the next
+// (mVideoReleaseBatch - 1) vsyncs after the usual lead time. Their timers would fire within a few
+// vsyncs anyway, and since each frame carries its presentation timestamp, the display still shows
+// it on time. This saves looper wake-ups at high frame rates, where wake-up jitter matters most.
+void NuPlayer::Renderer::releaseVideoFramesAhead(int64_t nowUs) {
+    int64_t vsyncPeriodUs = mVideoScheduler->getVsyncPeriod() / 1000;
+    if (vsyncPeriodUs <= 0) {
+        return;
+    }
+    int64_t windowUs =
+            (kMaxVideoLeadTimeUs / vsyncPeriodUs + mVideoReleaseBatch - 1) * vsyncPeriodUs;
+
+    for (int32_t released = 1; released < mVideoReleaseBatch && !mVideoQueue.empty(); ++released) {
+        QueueEntry *entry = &*mVideoQueue.begin();
+        if (entry->mBuffer == NULL) {
+            // EOS is notified on its own drain.
+            break;
+        }
+
+        int64_t mediaTimeUs;
+        CHECK(entry->mBuffer->meta()->findInt64("timeUs", &mediaTimeUs));
+        if (mediaTimeUs < mAudioFirstAnchorTimeMediaUs) {
+            break;
+        }
+        int64_t realTimeUs = getRealTimeUs(mediaTimeUs, nowUs);
+        if (realTimeUs - nowUs > windowUs) {
+            break;
+        }
+        realTimeUs = mVideoScheduler->schedule(realTimeUs * 1000) / 1000;
+
+        if (mLastAudioMediaTimeUs != -1 && mediaTimeUs > mLastAudioMediaTimeUs) {
+            // If audio ends before video, video continues to drive media clock.
+            mMediaClock->updateMaxTimeMedia(mediaTimeUs + kDefaultVideoFrameIntervalUs);
+        }
+
+        ALOGV("releasing video frame at media time %.2f secs %lld us ahead",
+                mediaTimeUs / 1E6, (long long)(realTimeUs - nowUs));
+        MEDIA_TRACE_RENDER("NuPlayerRenderer::drainVideo", "video", mediaTimeUs, -1);
+        entry->mNotifyConsumed->setInt64("timestampNs", realTimeUs * 1000LL);
+        entry->mNotifyConsumed->setInt32("render", true);
+        entry->mNotifyConsumed->post();
+        mVideoQueue.erase(mVideoQueue.begin());
     }
 }
 
@@ -1670,7 +1772,7 @@ void NuPlayer::Renderer::onQueueBuffer(const sp<AMessage> &msg) {
     if (audio) {
         Mutex::Autolock autoLock(mLock);
         mAudioQueue.push_back(entry);
-        postDrainAudioQueue_l();
+        postDrainAudioQueue_l(getAudioDrainBatchDelayUs_l());
     } else {
         mVideoQueue.push_back(entry);
         postDrainVideoQueue();
@@ -24,6 +24,7 @@
 #include <android-base/unique_fd.h>
 #include <media/mediaplayer.h>
 #include <media/stagefright/MediaBuffer.h>
+#include <media/stagefright/foundation/AHandlerReflector.h>
 #include <mpeg2ts/ATSParser.h>
 
 namespace android {
@@ -85,6 +86,10 @@ struct NuPlayer::GenericSource : public NuPlayer::Source,
 
     virtual bool isStreaming() const;
 
+    virtual void setScrubbing(bool scrubbing);
+
+    virtual sp<AMessage> getStats() const;
+
     // Modular DRM
     virtual void signalBufferReturned(MediaBufferBase *buffer);
 
@@ -124,6 +129,12 @@ private:
         sp<AnotherPacketSource> mPackets;
     };
 
+    struct ReadStats {
+        int64_t mNumReads = 0;
+        int64_t mTotalReadTimeUs = 0;
+        int64_t mMaxReadTimeUs = 0;
+    };
+
     Vector<sp<IMediaSource> > mSources;
     Track mAudioTrack;
     int64_t mAudioTimeUs;
@@ -167,12 +178,28 @@ private:
     bool mPreparing;
     int64_t mBitrate;
     uint32_t mPendingReadBufferTypes;
+    // Track types whose IMediaSource is being read, by any looper.
+    uint32_t mReadingTrackTypes;
+    Condition mReadCondition;
+    bool mScrubbing;
+    ReadStats mAudioReadStats;
+    ReadStats mVideoReadStats;
     sp<ABuffer> mGlobalTimedText;
 
+    // Audio and video are read on their own loopers, so that a slow read on one track
+    // does not hold back the other.
+    const bool mParallelReads;
+    // When non-zero, audio and video packets are read ahead until this much is queued.
+    const int64_t mPrefetchUs;
+
     mutable Mutex mLock;
     mutable Mutex mDisconnectLock; // Protects mDataSource, mHttpSource and mDisconnected
 
     sp<ALooper> mLooper;
+    sp<ALooper> mAudioReadLooper;
+    sp<ALooper> mVideoReadLooper;
+    sp<AHandlerReflector<GenericSource> > mAudioReader;
+    sp<AHandlerReflector<GenericSource> > mVideoReader;
 
     void resetDataSource();
 
@@ -205,6 +232,7 @@ private:
             MediaBufferBase *mbuf,
             media_track_type trackType);
 
+    sp<AHandler> getReadHandler(media_track_type trackType);
     void postReadBuffer(media_track_type trackType);
     void onReadBuffer(const sp<AMessage>& msg);
     // When |mode| is MediaPlayerSeekMode::SEEK_CLOSEST, the buffer read shall
@@ -239,6 +267,8 @@ private:
 
     status_t checkDrmInfo();
 
+    friend struct AHandlerReflector<GenericSource>;
+
     DISALLOW_EVIL_CONSTRUCTORS(GenericSource);
 };
 
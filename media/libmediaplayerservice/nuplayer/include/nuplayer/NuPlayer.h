@@ -104,6 +104,10 @@ struct NuPlayer : public AHandler {
 
     void setTargetBitrate(int bitrate /* bps */);
 
+    // While scrubbing, seeks land on sync samples only and a seek that is
+    // superseded by a newer one before it is handled is dropped.
+    void setScrubbing(bool scrubbing);
+
     void dump(AString& logString);
     void logLatencyBegin(std::string strId);
     void logLatencyEnd(std::string strId);
@@ -284,6 +288,9 @@ protected:
 
     std::atomic<DATA_SOURCE_TYPE> mDataSourceType;
 
+    std::atomic<bool> mScrubbing;
+    std::atomic<int32_t> mSeekGeneration;
+
     inline const sp<DecoderBase> &getDecoder(bool audio) {
         return audio ? mAudioDecoder : mVideoDecoder;
     }
@@ -274,6 +274,7 @@ protected:
     void drainAudioQueueUntilLastEOS();
     int64_t getPendingAudioPlayoutDurationUs(int64_t nowUs);
     void postDrainAudioQueue_l(int64_t delayUs = 0);
+    int64_t getAudioDrainBatchDelayUs_l();
 
     void clearAnchorTime();
     void clearAudioFirstAnchorTime_l();
@@ -285,6 +286,7 @@ protected:
 
     void onDrainVideoQueue();
     void postDrainVideoQueue();
+    void releaseVideoFramesAhead(int64_t nowUs);
 
     void prepareForMediaRenderingStart_l();
     void notifyIfMediaRenderingStarted_l();
@@ -341,6 +343,11 @@ private:
     bool mNeedVideoClearAnchor;
     bool mIsSeekonPause;
     float mVideoRenderFps;
+    int32_t mVideoReleaseBatch;
+    const int64_t mAudioDrainBatchUs;
+    // Audio drain wake-ups and PCM buffers they consumed, reported by dump().
+    std::atomic<int64_t> mAudioDrainWakeups;
+    std::atomic<int64_t> mAudioBuffersDrained;
 };
 
 } // namespace android
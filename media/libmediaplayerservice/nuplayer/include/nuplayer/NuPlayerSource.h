@@ -135,6 +135,14 @@ struct NuPlayer::Source : public AHandler {
 
     virtual void setTargetBitrate(int32_t) {}
 
+    // When scrubbing, the source only delivers video sync samples.
+    virtual void setScrubbing(bool /* scrubbing */) {}
+
+    // Statistics of the source for media metrics, if it keeps any.
+    virtual sp<AMessage> getStats() const {
+        return NULL;
+    }
+
     // Modular DRM
     virtual status_t prepareDrm(
             const uint8_t /*uuid*/[16], const Vector<uint8_t> &/*drmSessionId*/,
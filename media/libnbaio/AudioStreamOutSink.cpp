@@ -17,6 +17,9 @@
 #define LOG_TAG "AudioStreamOutSink"
 //#define LOG_NDEBUG 0
 
+#include <algorithm>
+#include <string.h>
+
 #include <utils/Log.h>
 #include <audio_utils/clock.h>
 #include <media/audiohal/StreamHalInterface.h>
@@ -51,6 +54,10 @@ ssize_t AudioStreamOutSink::negotiate(const NBAIO_Format offers[], size_t numOff
                 audio_channel_count_from_out_mask(config.channel_mask), config.format);
         mFrameSize = Format_frameSize(mFormat);
 
+        // pending MEL data was in the previous format
+        mMelBufferBytes = 0;
+        mMelBuffer.resize(config.sample_rate * kMelBlockMs / 1000 * mFrameSize);
+
         // update format for MEL computation
         auto processor = mMelProcessor.load();
         if (processor) {
@@ -72,10 +79,7 @@ ssize_t AudioStreamOutSink::write(const void *buffer, size_t count)
     status_t ret = mStream->write(buffer, count * mFrameSize, &written);
     if (ret == OK && written > 0) {
         // Send to MelProcessor for sound dose measurement.
-        auto processor = mMelProcessor.load();
-        if (processor) {
-            processor->process(buffer, written);
-        }
+        processMel(mMelProcessor.load(), buffer, written);
 
         written /= mFrameSize;
         mFramesWritten += written;
@@ -100,9 +104,51 @@ status_t AudioStreamOutSink::getTimestamp(ExtendedTimestamp &timestamp)
     return OK;
 }
 
+void AudioStreamOutSink::processMel(const sp<audio_utils::MelProcessor>& processor,
+                                    const void *buffer, size_t bytes)
+{
+    if (processor != mMelBufferProcessor) {
+        // the pending data belongs to the previous processor
+        flushMel();
+        mMelBufferProcessor = processor;
+    }
+    if (processor == nullptr) {
+        return;
+    }
+
+    const uint8_t *data = static_cast<const uint8_t *>(buffer);
+    if (mMelBufferBytes > 0) {
+        const size_t toCopy = std::min(bytes, mMelBuffer.size() - mMelBufferBytes);
+        memcpy(mMelBuffer.data() + mMelBufferBytes, data, toCopy);
+        mMelBufferBytes += toCopy;
+        data += toCopy;
+        bytes -= toCopy;
+        if (mMelBufferBytes < mMelBuffer.size()) {
+            return;
+        }
+        processor->process(mMelBuffer.data(), mMelBufferBytes);
+        mMelBufferBytes = 0;
+    }
+    if (bytes >= mMelBuffer.size()) {
+        processor->process(data, bytes);
+    } else if (bytes > 0) {
+        memcpy(mMelBuffer.data(), data, bytes);
+        mMelBufferBytes = bytes;
+    }
+}
+
+void AudioStreamOutSink::flushMel()
+{
+    if (mMelBufferBytes > 0 && mMelBufferProcessor != nullptr) {
+        mMelBufferProcessor->process(mMelBuffer.data(), mMelBufferBytes);
+    }
+    mMelBufferBytes = 0;
+}
+
 void AudioStreamOutSink::startMelComputation(const sp<audio_utils::MelProcessor>& processor)
 {
-    ALOGV("%s start mel computation for device %d", __func__, processor->getDeviceId());
+    ALOGV("%s start mel computation for device %d", __func__,
+          processor ? processor->getDeviceId() : AUDIO_PORT_HANDLE_NONE);
 
     mMelProcessor.store(processor);
     if (processor) {
@@ -0,0 +1,132 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "FanInPipe"
+//#define LOG_NDEBUG 0
+
+#include <cutils/compiler.h>
+#include <utils/Log.h>
+#include <media/nbaio/FanInPipe.h>
+#include <audio_utils/roundup.h>
+
+namespace android {
+
+FanInPipe::Lane::Lane(size_t frameCount, size_t frameSize) :
+        mBuffer(malloc(frameCount * frameSize)),
+        mFifo(frameCount, frameSize, mBuffer, true /*throttlesWriter*/),
+        mFifoWriter(mFifo),
+        mFifoReader(mFifo, true /*throttlesWriter*/, false /*flush*/)
+{
+}
+
+FanInPipe::Lane::~Lane()
+{
+    free(mBuffer);
+}
+
+FanInPipe::FanInPipe(size_t maxWriters, size_t framesPerWriter, const NBAIO_Format& format) :
+        mFormat(format),
+        mFramesPerWriter(roundup(framesPerWriter))
+{
+    mLanes.reserve(maxWriters);
+    for (size_t i = 0; i < maxWriters; ++i) {
+        mLanes.emplace_back(new Lane(mFramesPerWriter, Format_frameSize(format)));
+    }
+}
+
+FanInPipe::~FanInPipe()
+{
+    ALOG_ASSERT(mReaders.load() == 0);
+    for (const auto &lane : mLanes) {
+        ALOG_ASSERT(!lane->mAttached.load());
+        (void)lane;
+    }
+}
+
+FanInPipe::Lane* FanInPipe::attach()
+{
+    for (const auto &lane : mLanes) {
+        bool expected = false;
+        if (lane->mAttached.compare_exchange_strong(expected, true)) {
+            return lane.get();
+        }
+    }
+    ALOGW("%s: all %zu lanes are in use", __func__, mLanes.size());
+    return nullptr;
+}
+
+void FanInPipe::detach(Lane *lane)
+{
+    // Frames already written remain in the lane, and are read by the reader.
+    lane->mAttached.store(false);
+}
+
+FanInPipeWriter::FanInPipeWriter(FanInPipe& pipe) :
+        NBAIO_Sink(pipe.mFormat),
+        mPipe(pipe),
+        mLane(pipe.attach())
+{
+}
+
+FanInPipeWriter::~FanInPipeWriter()
+{
+    if (mLane != nullptr) {
+        mPipe.detach(mLane);
+    }
+}
+
+ssize_t FanInPipeWriter::availableToWrite()
+{
+    if (CC_UNLIKELY(!mNegotiated)) {
+        return NEGOTIATE;
+    }
+    if (CC_UNLIKELY(mLane == nullptr)) {
+        return NO_INIT;
+    }
+    return mLane->mFifoWriter.available();
+}
+
+ssize_t FanInPipeWriter::write(const void *buffer, size_t count)
+{
+    // count == 0 is unlikely and not worth checking for
+    if (CC_UNLIKELY(!mNegotiated)) {
+        return NEGOTIATE;
+    }
+    if (CC_UNLIKELY(mLane == nullptr)) {
+        return NO_INIT;
+    }
+    // non-blocking: the fifo returns a short count if the lane is full.
+    ssize_t actual = mLane->mFifoWriter.write(buffer, count);
+    ALOG_ASSERT(actual <= (ssize_t)count);
+    if (actual < 0) {
+        return actual;
+    }
+    const size_t lost = count - actual;
+    if (lost > 0) {
+        mFramesOverrun += lost;
+        if (!mOverrunning) {
+            ++mOverruns;
+            mOverrunning = true;
+        }
+        mPipe.mFramesOverrun.fetch_add(lost, std::memory_order_relaxed);
+    } else {
+        mOverrunning = false;
+    }
+    mFramesWritten += (size_t) actual;
+    return count;
+}
+
+}   // namespace android
@@ -0,0 +1,95 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "FanInPipeReader"
+//#define LOG_NDEBUG 0
+
+#include <cutils/compiler.h>
+#include <utils/Log.h>
+#include <media/nbaio/FanInPipeReader.h>
+
+namespace android {
+
+FanInPipeReader::FanInPipeReader(FanInPipe& pipe) :
+        NBAIO_Source(pipe.mFormat),
+        mPipe(pipe),
+        mFrameSize(Format_frameSize(pipe.mFormat))
+{
+    const int32_t readers = mPipe.mReaders.fetch_add(1);
+    LOG_ALWAYS_FATAL_IF(readers != 0, "FanInPipe supports a single reader");
+}
+
+FanInPipeReader::~FanInPipeReader()
+{
+    mPipe.mReaders.fetch_sub(1);
+}
+
+ssize_t FanInPipeReader::availableToRead()
+{
+    if (CC_UNLIKELY(!mNegotiated)) {
+        return NEGOTIATE;
+    }
+    ssize_t total = 0;
+    for (const auto &lane : mPipe.mLanes) {
+        // lanes throttle their writer, so frames are never lost on the read side.
+        const ssize_t avail = lane->mFifoReader.available();
+        if (avail > 0) {
+            total += avail;
+        }
+    }
+    return total;
+}
+
+ssize_t FanInPipeReader::read(void *buffer, size_t count)
+{
+    if (CC_UNLIKELY(!mNegotiated)) {
+        return NEGOTIATE;
+    }
+    const size_t laneCount = mPipe.mLanes.size();
+    size_t total = 0;
+    for (size_t i = 0; i < laneCount && total < count; ++i) {
+        FanInPipe::Lane &lane = *mPipe.mLanes[(mNextLane + i) % laneCount];
+        const ssize_t actual = lane.mFifoReader.read(
+                (char *) buffer + total * mFrameSize, count - total);
+        if (actual > 0) {
+            total += actual;
+        }
+    }
+    // start with the next lane next time, so that all writers make progress.
+    if (laneCount > 0) {
+        mNextLane = (mNextLane + 1) % laneCount;
+    }
+    mFramesRead += total;
+    return total;
+}
+
+ssize_t FanInPipeReader::flush()
+{
+    if (CC_UNLIKELY(!mNegotiated)) {
+        return NEGOTIATE;
+    }
+    ssize_t total = 0;
+    for (const auto &lane : mPipe.mLanes) {
+        const ssize_t flushed = lane->mFifoReader.flush();
+        if (flushed > 0) {
+            total += flushed;
+        }
+    }
+    mFramesRead += total;  // we consider flushed frames as read, as PipeReader does
+    return total;
+}
+
+}   // namespace android
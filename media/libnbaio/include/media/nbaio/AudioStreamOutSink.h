@@ -17,6 +17,8 @@
 #ifndef ANDROID_AUDIO_STREAM_OUT_SINK_H
 #define ANDROID_AUDIO_STREAM_OUT_SINK_H
 
+#include <vector>
+
 #include <audio_utils/MelProcessor.h>
 #include <media/nbaio/NBAIO.h>
 #include <mediautils/Synchronization.h>
@@ -59,9 +61,23 @@ public:
 #endif
 
 private:
+    // Passes the written data to the MEL processor in blocks of at least kMelBlockMs.
+    // This amortizes the per-call cost of MelProcessor::process() over several small writes,
+    // e.g. from the FastMixer. Larger writes are passed through without a copy.
+    void processMel(const sp<audio_utils::MelProcessor>& processor,
+                    const void *buffer, size_t bytes);
+    void flushMel();
+
+    static constexpr uint32_t kMelBlockMs = 10;
+
     sp<StreamOutHalInterface> mStream;
     size_t              mStreamBufferSizeBytes; // as reported by get_buffer_size()
     mediautils::atomic_sp<audio_utils::MelProcessor> mMelProcessor;
+
+    // Only accessed by the writer thread.
+    std::vector<uint8_t> mMelBuffer;            // one MEL block
+    size_t              mMelBufferBytes = 0;    // pending bytes in mMelBuffer
+    sp<audio_utils::MelProcessor> mMelBufferProcessor; // processor of the pending bytes
 };
 
 }   // namespace android
@@ -0,0 +1,121 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_AUDIO_FAN_IN_PIPE_H
+#define ANDROID_AUDIO_FAN_IN_PIPE_H
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include <audio_utils/fifo.h>
+#include <media/nbaio/NBAIO.h>
+
+namespace android {
+
+// FanInPipe is a multiple producer, single consumer pipe.
+//
+// Each producer thread writes through its own FanInPipeWriter, and a single FanInPipeReader
+// reads the frames of all of the writers.  Every writer is attached to a private lane, which is
+// a single writer, single reader audio_utils_fifo, so writers never contend with each other
+// and write() is wait-free.  When a lane is full the excess frames are dropped and counted as
+// an overrun of that writer, see FanInPipeWriter::framesOverrun().
+//
+// Frames of one writer are read in the order written; there is no ordering between writers.
+// The reader visits the lanes round robin, so one busy writer cannot starve the others.
+//
+// FanInPipe itself is not an NBAIO port; it only owns the lanes and must outlive
+// all of its writers and its reader.
+class FanInPipe {
+
+    friend class FanInPipeWriter;
+    friend class FanInPipeReader;
+
+public:
+    // maxWriters is the number of lanes, that is the maximum number of attached writers.
+    // framesPerWriter is the capacity of each lane, and will be rounded up to a power of 2.
+    FanInPipe(size_t maxWriters, size_t framesPerWriter, const NBAIO_Format& format);
+    virtual ~FanInPipe();
+
+    FanInPipe(const FanInPipe&) = delete;
+    FanInPipe& operator=(const FanInPipe&) = delete;
+
+    size_t maxWriters() const { return mLanes.size(); }
+    size_t framesPerWriter() const { return mFramesPerWriter; }
+
+    // Total number of frames dropped on write because a lane was full, for all writers.
+    int64_t framesOverrun() const { return mFramesOverrun.load(std::memory_order_relaxed); }
+
+private:
+    struct Lane {
+        Lane(size_t frameCount, size_t frameSize);
+        ~Lane();
+
+        void * const            mBuffer;
+        audio_utils_fifo        mFifo;
+        audio_utils_fifo_writer mFifoWriter;    // used only by the attached FanInPipeWriter
+        audio_utils_fifo_reader mFifoReader;    // used only by the FanInPipeReader
+        std::atomic<bool>       mAttached{false};
+    };
+
+    // Returns a free lane, marked attached, or nullptr if all lanes are in use.
+    Lane* attach();
+    void detach(Lane *lane);
+
+    const NBAIO_Format      mFormat;
+    const size_t            mFramesPerWriter;   // always a power of 2
+    // fixed at construction, so the reader can iterate without synchronization.
+    std::vector<std::unique_ptr<Lane>> mLanes;
+    std::atomic<int32_t>    mReaders{0};        // at most one FanInPipeReader
+    std::atomic<int64_t>    mFramesOverrun{0};
+};
+
+// FanInPipeWriter is the sink of one producer.  It is safe for only a single writer thread,
+// but any number of FanInPipeWriters of the same FanInPipe can be used concurrently.
+class FanInPipeWriter : public NBAIO_Sink {
+
+public:
+    // Attaches to a free lane of the pipe.  Check initCheck() before use.
+    explicit FanInPipeWriter(FanInPipe& pipe);
+    virtual ~FanInPipeWriter();
+
+    // NO_ERROR if attached to a lane, or NO_INIT if the pipe already has maxWriters() writers.
+    status_t initCheck() const { return mLane != nullptr ? NO_ERROR : NO_INIT; }
+
+    // NBAIO_Sink interface
+
+    //virtual int64_t framesWritten() const;
+    int64_t framesOverrun() const override { return mFramesOverrun; }
+    int64_t overruns() const override { return mOverruns; }
+
+    ssize_t availableToWrite() override;
+
+    // Never blocks.  Writes as many frames as fit in the lane, and drops the rest.
+    // Returns count, including the dropped frames, or a negative status_t.
+    ssize_t write(const void *buffer, size_t count) override;
+    //virtual ssize_t writeVia(writeVia_t via, size_t total, void *user, size_t block);
+
+private:
+    FanInPipe&          mPipe;
+    FanInPipe::Lane * const mLane;
+    int64_t             mFramesOverrun = 0;
+    int64_t             mOverruns = 0;
+    bool                mOverrunning = false;   // last write() dropped frames
+};
+
+}   // namespace android
+
+#endif  // ANDROID_AUDIO_FAN_IN_PIPE_H
@@ -0,0 +1,55 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_AUDIO_FAN_IN_PIPE_READER_H
+#define ANDROID_AUDIO_FAN_IN_PIPE_READER_H
+
+#include "FanInPipe.h"
+
+namespace android {
+
+// FanInPipeReader is the single consumer of a FanInPipe, and is safe for only a single thread.
+class FanInPipeReader : public NBAIO_Source {
+
+public:
+    // Construct a FanInPipeReader and associate it with a FanInPipe.
+    // There must be at most one reader per pipe.
+    explicit FanInPipeReader(FanInPipe& pipe);
+    virtual ~FanInPipeReader();
+
+    // NBAIO_Source interface
+
+    //virtual size_t framesRead() const;
+
+    // Sum of the frames available in all lanes.
+    ssize_t availableToRead() override;
+
+    // Reads up to count frames, visiting the lanes round robin.
+    ssize_t read(void *buffer, size_t count) override;
+
+    ssize_t flush() override;
+
+    // NBAIO_Source end
+
+private:
+    FanInPipe&  mPipe;
+    const size_t mFrameSize;
+    size_t      mNextLane = 0;  // first lane visited by the next read()
+};
+
+}   // namespace android
+
+#endif  // ANDROID_AUDIO_FAN_IN_PIPE_READER_H
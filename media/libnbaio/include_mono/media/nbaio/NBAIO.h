@@ -156,6 +156,13 @@ public:
     // Number of underruns since construction, where a set of contiguous lost frames is one event.
     virtual int64_t underruns() const { return 0; }
 
+    // Number of frames dropped by write() since construction because the sink was full.
+    // Only sinks that neither block nor overwrite unread data when full can overrun.
+    virtual int64_t framesOverrun() const { return 0; }
+
+    // Number of overruns since construction, where a set of contiguous lost frames is one event.
+    virtual int64_t overruns() const { return 0; }
+
     // Estimate of number of frames that could be written successfully now without blocking.
     // When a write() is actually attempted, the implementation is permitted to return a smaller or
     // larger transfer count, however it will make a good faith effort to give an accurate estimate.
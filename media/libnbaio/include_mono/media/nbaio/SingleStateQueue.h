@@ -153,6 +153,35 @@ private:
             }
         }
 
+        // Read the last value pushed without acknowledging it to the Mutator.
+        // Unlike poll(), this does not modify the Observer or the shared state, so it may be
+        // called concurrently by any number of readers, in addition to the owner of poll().
+        // Returns false if a consistent value could not be read (e.g. the Mutator was busy);
+        // value is not modified in that case.
+        bool peek(T& value) const
+        {
+            const Shared *shared = mShared;
+            int32_t before = android_atomic_acquire_load(&shared->mSequence);
+            for (int tries = 0; ; ) {
+                const int MAX_TRIES = 5;
+                if (!(before & 1)) {
+                    T temp = shared->mValue;
+                    android_memory_barrier();
+                    const int32_t after = shared->mSequence;
+                    if (after == before) {
+                        value = temp;
+                        return true;
+                    }
+                    before = after;
+                } else {
+                    before = android_atomic_acquire_load(&shared->mSequence);
+                }
+                if (++tries >= MAX_TRIES) {
+                    return false;
+                }
+            }
+        }
+
         // (optional) used to indicate to the Mutator that the state that has been polled
         // has also been acted upon.
         void done()
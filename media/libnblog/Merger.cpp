@@ -17,8 +17,9 @@
 #define LOG_TAG "NBLog"
 //#define LOG_NDEBUG 0
 
+#include <algorithm>
+#include <functional>
 #include <memory>
-#include <queue>
 #include <stddef.h>
 #include <stdint.h>
 #include <vector>
@@ -59,7 +60,7 @@ void Merger::addReader(const sp<Reader> &reader)
     mReaders.push_back(reader);
 }
 
-// items placed in priority queue during merge
+// items placed in the merge heap
 // composed by a timestamp and the index of the snapshot where the timestamp came from
 struct MergeItem
 {
@@ -73,11 +74,42 @@ bool operator>(const struct MergeItem &i1, const struct MergeItem &i2)
     return i1.ts > i2.ts || (i1.ts == i2.ts && i1.index > i2.index);
 }
 
+// Reads the timestamp of the raw entry at it, without building an AbstractEntry.
+// Returns false if the entry does not start a mergeable item.
+static bool getEntryTimestamp(const EntryIterator &it, int64_t *ts)
+{
+    switch (it->type) {
+    case EVENT_FMT_START:
+        *ts = it.next().payload<int64_t>(); // timestamp follows fmt start
+        return true;
+    case EVENT_AUDIO_STATE:
+    case EVENT_HISTOGRAM_ENTRY_TS:
+        *ts = it.payload<HistTsEntry>().ts;
+        return true;
+    default:
+        return false;
+    }
+}
+
+// Advances it to the next mergeable entry before end, reading its timestamp.
+// Returns false if there is none.
+static bool findMergeableEntry(EntryIterator &it, const EntryIterator &end, int64_t *ts)
+{
+    for (; it != end; ++it) {
+        if (getEntryTimestamp(it, ts)) {
+            return true;
+        }
+        ALOGW("Tried to merge entry of type %d", it->type);
+    }
+    return false;
+}
+
 // Merge registered readers, sorted by timestamp, and write data to a single FIFO in local memory
 void Merger::merge()
 {
-    if (true) return; // Merging is not necessary at the moment, so this is to disable it
-                      // and bypass compiler warnings about member variables not being used.
+    if (!kMergeEnabled) {
+        return;
+    }
     const int nLogs = mReaders.size();
     std::vector<std::unique_ptr<Snapshot>> snapshots(nLogs);
     std::vector<EntryIterator> offsets;
@@ -86,31 +118,35 @@ void Merger::merge()
         snapshots[i] = mReaders[i]->getSnapshot();
         offsets.push_back(snapshots[i]->begin());
     }
-    // initialize offsets
-    // TODO custom heap implementation could allow to update top, improving performance
-    // for bursty buffers
-    std::priority_queue<MergeItem, std::vector<MergeItem>, std::greater<MergeItem>> timestamps;
-    for (int i = 0; i < nLogs; ++i)
-    {
-        if (offsets[i] != snapshots[i]->end()) {
-            std::unique_ptr<AbstractEntry> abstractEntry = AbstractEntry::buildEntry(offsets[i]);
-            if (abstractEntry == nullptr) {
-                continue;
-            }
-            timestamps.emplace(abstractEntry->timestamp(), i);
+
+    // k-way merge of the raw entries with a min heap of the next timestamp of each log.
+    // Entries are copied as is, only the timestamp is read.
+    std::vector<MergeItem> heap;
+    heap.reserve(nLogs);
+    for (int i = 0; i < nLogs; ++i) {
+        int64_t ts;
+        if (findMergeableEntry(offsets[i], snapshots[i]->end(), &ts)) {
+            heap.emplace_back(ts, i);
         }
     }
+    std::make_heap(heap.begin(), heap.end(), std::greater<MergeItem>());
 
-    while (!timestamps.empty()) {
-        int index = timestamps.top().index;     // find minimum timestamp
+    while (!heap.empty()) {
+        // move the minimum timestamp to the back
+        std::pop_heap(heap.begin(), heap.end(), std::greater<MergeItem>());
+        const int index = heap.back().index;
         // copy it to the log, increasing offset
-        offsets[index] = AbstractEntry::buildEntry(offsets[index])->
-            copyWithAuthor(mFifoWriter, index);
-        // update data structures
-        timestamps.pop();
-        if (offsets[index] != snapshots[index]->end()) {
-            int64_t ts = AbstractEntry::buildEntry(offsets[index])->timestamp();
-            timestamps.emplace(ts, index);
+        EntryIterator &offset = offsets[index];
+        offset = offset->type == EVENT_FMT_START
+                ? FormatEntry(offset).copyWithAuthor(mFifoWriter, index)
+                : HistogramEntry(offset).copyWithAuthor(mFifoWriter, index);
+        // replace the item with the next entry of the same log, if any
+        int64_t ts;
+        if (findMergeableEntry(offset, snapshots[index]->end(), &ts)) {
+            heap.back().ts = ts;
+            std::push_heap(heap.begin(), heap.end(), std::greater<MergeItem>());
+        } else {
+            heap.pop_back();
         }
     }
 }
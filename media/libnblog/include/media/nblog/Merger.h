@@ -59,6 +59,10 @@ public:
     const std::vector<sp<Reader>>& getReaders() const;
 
 private:
+    // Merging is not necessary at the moment, as MergeReader processes the snapshots
+    // of the readers directly and nothing reads the merged FIFO.
+    static constexpr bool kMergeEnabled = false;
+
     // vector of the readers the merger is supposed to merge from.
     // every reader reads from a writer's buffer
     // FIXME Needs to be protected by a lock
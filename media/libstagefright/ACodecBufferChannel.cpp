@@ -76,14 +76,18 @@ static BufferInfoIterator findBufferId(
 ACodecBufferChannel::BufferInfo::BufferInfo(
         const sp<MediaCodecBuffer> &buffer,
         IOMX::buffer_id bufferId,
-        const sp<IMemory> &sharedEncryptedBuffer)
+        const sp<IMemory> &sharedEncryptedBuffer,
+        const sp<AMessage> &returnTemplate)
     : mClientBuffer(
           (sharedEncryptedBuffer == nullptr)
           ? buffer
           : new SharedMemoryBuffer(buffer->format(), sharedEncryptedBuffer)),
       mCodecBuffer(buffer),
       mBufferId(bufferId),
-      mSharedEncryptedBuffer(sharedEncryptedBuffer) {
+      mSharedEncryptedBuffer(sharedEncryptedBuffer),
+      mReturnMsg(returnTemplate->dup()) {
+    mReturnMsg->setObject("buffer", mCodecBuffer);
+    mReturnMsg->setInt32("buffer-id", mBufferId);
 }
 
 ACodecBufferChannel::ACodecBufferChannel(
@@ -120,9 +124,8 @@ status_t ACodecBufferChannel::queueInputBuffer(const sp<MediaCodecBuffer> &buffe
         }
     }
     ALOGV("queueInputBuffer #%d", it->mBufferId);
-    sp<AMessage> msg = mInputBufferFilled->dup();
-    msg->setObject("buffer", it->mCodecBuffer);
-    msg->setInt32("buffer-id", it->mBufferId);
+    const sp<AMessage> &msg = it->mReturnMsg;
+    msg->setInt32("discarded", false);
     msg->post();
     return OK;
 }
@@ -273,9 +276,8 @@ status_t ACodecBufferChannel::queueSecureInputBuffer(
     }
 
     ALOGV("queueSecureInputBuffer #%d", it->mBufferId);
-    sp<AMessage> msg = mInputBufferFilled->dup();
-    msg->setObject("buffer", it->mCodecBuffer);
-    msg->setInt32("buffer-id", it->mBufferId);
+    const sp<AMessage> &msg = it->mReturnMsg;
+    msg->setInt32("discarded", false);
     msg->post();
     return OK;
 }
@@ -478,9 +480,8 @@ status_t ACodecBufferChannel::renderOutputBuffer(
     }
 
     ALOGV("renderOutputBuffer #%d", it->mBufferId);
-    sp<AMessage> msg = mOutputBufferDrained->dup();
-    msg->setObject("buffer", buffer);
-    msg->setInt32("buffer-id", it->mBufferId);
+    const sp<AMessage> &msg = it->mReturnMsg;
+    msg->setInt32("discarded", false);
     msg->setInt32("render", true);
     msg->setInt64("timestampNs", timestampNs);
     msg->post();
@@ -505,10 +506,11 @@ status_t ACodecBufferChannel::discardBuffer(const sp<MediaCodecBuffer> &buffer)
         }
     }
     ALOGV("discardBuffer #%d", it->mBufferId);
-    sp<AMessage> msg = input ? mInputBufferFilled->dup() : mOutputBufferDrained->dup();
-    msg->setObject("buffer", it->mCodecBuffer);
-    msg->setInt32("buffer-id", it->mBufferId);
+    const sp<AMessage> &msg = it->mReturnMsg;
     msg->setInt32("discarded", true);
+    if (!input) {
+        msg->setInt32("render", false);
+    }
     msg->post();
     return OK;
 }
@@ -586,7 +588,8 @@ void ACodecBufferChannel::setInputBufferArray(const std::vector<BufferAndId> &ar
         if (hasCryptoOrDescrambler()) {
             sharedEncryptedBuffer = mDealer->allocate(elem.mBuffer->capacity());
         }
-        inputBuffers.emplace_back(elem.mBuffer, elem.mBufferId, sharedEncryptedBuffer);
+        inputBuffers.emplace_back(
+                elem.mBuffer, elem.mBufferId, sharedEncryptedBuffer, mInputBufferFilled);
     }
     std::atomic_store(
             &mInputBuffers,
@@ -596,7 +599,8 @@ void ACodecBufferChannel::setInputBufferArray(const std::vector<BufferAndId> &ar
 void ACodecBufferChannel::setOutputBufferArray(const std::vector<BufferAndId> &array) {
     std::vector<const BufferInfo> outputBuffers;
     for (const BufferAndId &elem : array) {
-        outputBuffers.emplace_back(elem.mBuffer, elem.mBufferId, nullptr);
+        outputBuffers.emplace_back(
+                elem.mBuffer, elem.mBufferId, nullptr, mOutputBufferDrained);
     }
     std::atomic_store(
             &mOutputBuffers,
@@ -17,6 +17,8 @@
 #include <inttypes.h>
 #include <stdlib.h>
 
+#include <algorithm>
+
 //#define LOG_NDEBUG 0
 #define LOG_TAG "AudioSource"
 #include <utils/Log.h>
@@ -40,6 +42,7 @@ using content::AttributionSourceState;
 
 
 void AudioSource::onOverrun() {
+    ++mNumOverruns;
     ALOGW("AudioRecord reported overrun!");
 }
 
@@ -93,6 +96,7 @@ void AudioSource::set(
    mNumFramesLost = 0;
    mNumClientOwnedBuffers = 0;
    mNoMoreFramesToRead = false;
+   mMaxBufferSize = kMaxBufferSize;
   ALOGV("sampleRate: %u, outSampleRate: %u, channelCount: %u",
         sampleRate, outSampleRate, channelCount);
   CHECK(channelCount == 1 || channelCount == 2 || channelCount == 6);
@@ -150,6 +154,8 @@ AudioSource::~AudioSource() {
     if (mStarted) {
         reset();
     }
+    Mutex::Autolock autoLock(mLock);
+    releaseFreeBuffers_l();
 }
 
 status_t AudioSource::initCheck() const {
@@ -185,6 +191,27 @@ status_t AudioSource::start(MetaData *params) {
     return err;
 }
 
+status_t AudioSource::setBatchFrameCount(size_t frameCount) {
+    Mutex::Autolock autoLock(mLock);
+    if (mInitCheck != OK) {
+        return NO_INIT;
+    }
+    if (mStarted) {
+        return INVALID_OPERATION;
+    }
+    // Anything longer than a second only adds latency.
+    if (frameCount > (size_t)mSampleRate) {
+        ALOGE("Invalid batch size: %zu frames", frameCount);
+        return BAD_VALUE;
+    }
+
+    releaseFreeBuffers_l();
+    mBatchSize = frameCount * mRecord->frameSize();
+    mMaxBufferSize = std::max((size_t)kMaxBufferSize, mBatchSize);
+    ALOGV("batch size: %zu bytes", mBatchSize);
+    return OK;
+}
+
 void AudioSource::releaseQueuedFrames_l() {
     ALOGV("releaseQueuedFrames_l");
     List<MediaBuffer *>::iterator it;
@@ -193,6 +220,18 @@ void AudioSource::releaseQueuedFrames_l() {
         (*it)->release();
         mBuffersReceived.erase(it);
     }
+    if (mPendingBuffer != NULL) {
+        mPendingBuffer->release();
+        mPendingBuffer = NULL;
+    }
+    mNumFramesPending = 0;
+}
+
+void AudioSource::releaseFreeBuffers_l() {
+    for (MediaBuffer *buffer : mFreeBuffers) {
+        buffer->release();
+    }
+    mFreeBuffers.clear();
 }
 
 void AudioSource::waitOutstandingEncodingFrames_l() {
@@ -220,6 +259,10 @@ status_t AudioSource::reset() {
     mRecord->stop();
     waitOutstandingEncodingFrames_l();
     releaseQueuedFrames_l();
+    releaseFreeBuffers_l();
+
+    ALOGI("Captured %" PRId64 " frames, %" PRId64 " lost, %" PRId64 " overruns",
+            mNumFramesReceived, mNumFramesLost, mNumOverruns.exchange(0));
 
     return OK;
 }
@@ -283,7 +326,7 @@ status_t AudioSource::read(
 
     while (mStarted && mBuffersReceived.empty()) {
         mFrameAvailableCondition.wait(mLock);
-        if (mNoMoreFramesToRead) {
+        if (mNoMoreFramesToRead && mBuffersReceived.empty()) {
             return OK;
         }
     }
@@ -349,7 +392,12 @@ void AudioSource::signalBufferReturned(MediaBufferBase *buffer) {
     Mutex::Autolock autoLock(mLock);
     --mNumClientOwnedBuffers;
     buffer->setObserver(0);
-    buffer->release();
+    if (buffer->size() == mMaxBufferSize && mFreeBuffers.size() < kMaxFreeBuffers) {
+        buffer->reset();
+        mFreeBuffers.push_back(static_cast<MediaBuffer *>(buffer));
+    } else {
+        buffer->release();
+    }
     mFrameEncodingCompletionCondition.signal();
     return;
 }
@@ -365,8 +413,8 @@ size_t AudioSource::onMoreData(const AudioRecord::Buffer& audioBuffer) {
             &location) == OK) {
         // Use audio timestamp.
         timeUs = timeNs / 1000 -
-                (position - mNumFramesSkipped -
-                mNumFramesReceived + mNumFramesLost) * usPerSec / mSampleRate;
+                (position - mNumFramesSkipped - mNumFramesReceived -
+                mNumFramesPending + mNumFramesLost) * usPerSec / mSampleRate;
     } else {
         // This should not happen in normal case.
         ALOGW("Failed to get audio timestamp, fallback to use systemclock");
@@ -386,8 +434,11 @@ size_t AudioSource::onMoreData(const AudioRecord::Buffer& audioBuffer) {
     }
 
 
+    // Frames still batching in mPendingBuffer count as received.
+    const int64_t numFramesReceived = mNumFramesReceived + mNumFramesPending;
+
     // Drop retrieved and previously lost audio data.
-    if (mNumFramesReceived == 0 && timeUs < mStartTimeUs) {
+    if (numFramesReceived == 0 && timeUs < mStartTimeUs) {
         (void) mRecord->getInputFramesLost();
         int64_t receievedFrames = audioBuffer.size() / mRecord->frameSize();
         ALOGV("Drop audio data(%" PRId64 " frames) at %" PRId64 "/%" PRId64 " us",
@@ -399,12 +450,13 @@ size_t AudioSource::onMoreData(const AudioRecord::Buffer& audioBuffer) {
     if (mStopSystemTimeUs != -1 && timeUs >= mStopSystemTimeUs) {
         ALOGV("Drop Audio frame at %lld  stop time: %lld us",
                 (long long)timeUs, (long long)mStopSystemTimeUs);
+        flushPendingBuffer_l();
         mNoMoreFramesToRead = true;
         mFrameAvailableCondition.signal();
         return audioBuffer.size();
     }
 
-    if (mNumFramesReceived == 0 && mPrevSampleTimeUs == 0) {
+    if (numFramesReceived == 0 && mPrevSampleTimeUs == 0) {
         mInitialReadTimeUs = timeUs;
         // Initial delay
         if (mStartTimeUs > 0) {
@@ -415,7 +467,7 @@ size_t AudioSource::onMoreData(const AudioRecord::Buffer& audioBuffer) {
     mLastFrameTimestampUs = timeUs;
 
     uint64_t numLostBytes = 0; // AudioRecord::getInputFramesLost() returns uint32_t
-    if (mNumFramesReceived > 0) {  // Ignore earlier frame lost
+    if (numFramesReceived > 0) {  // Ignore earlier frame lost
         // getInputFramesLost() returns the number of lost frames.
         // Convert number of frames lost to number of bytes lost.
         numLostBytes = (uint64_t)mRecord->getInputFramesLost() * mRecord->frameSize();
@@ -429,19 +481,9 @@ size_t AudioSource::onMoreData(const AudioRecord::Buffer& audioBuffer) {
         ALOGW("Lost audio record data: %" PRIu64 " bytes", numLostBytes);
     }
 
-    while (numLostBytes > 0) {
-        uint64_t bufferSize = numLostBytes;
-        if (numLostBytes > mMaxBufferSize) {
-            numLostBytes -= mMaxBufferSize;
-            bufferSize = mMaxBufferSize;
-        } else {
-            numLostBytes = 0;
-        }
-        MediaBuffer *lostAudioBuffer = new MediaBuffer(bufferSize);
-        memset(lostAudioBuffer->data(), 0, bufferSize);
-        lostAudioBuffer->set_range(0, bufferSize);
-        mNumFramesLost += bufferSize / mRecord->frameSize();
-        queueInputBuffer_l(lostAudioBuffer, timeUs);
+    if (numLostBytes > 0) {
+        mNumFramesLost += numLostBytes / mRecord->frameSize();
+        queueData_l(NULL, numLostBytes, timeUs);
     }
 
     if (audioBuffer.size() == 0) {
@@ -449,14 +491,71 @@ size_t AudioSource::onMoreData(const AudioRecord::Buffer& audioBuffer) {
         return audioBuffer.size();
     }
 
-    MediaBuffer *buffer = new MediaBuffer(audioBuffer.size());
-    memcpy((uint8_t *) buffer->data(),
-            audioBuffer.data(), audioBuffer.size());
-    buffer->set_range(0, audioBuffer.size());
-    queueInputBuffer_l(buffer, timeUs);
+    queueData_l((const uint8_t *) audioBuffer.data(), audioBuffer.size(), timeUs);
     return audioBuffer.size();
 }
 
+void AudioSource::queueData_l(const uint8_t *data, size_t size, int64_t timeUs) {
+    const size_t frameSize = mRecord->frameSize();
+    while (size > 0) {
+        MediaBuffer *buffer;
+        size_t offset = 0;
+        size_t chunkSize;
+        if (mBatchSize == 0) {
+            chunkSize = std::min(size, mMaxBufferSize);
+            buffer = acquireBuffer_l(chunkSize);
+        } else {
+            if (mPendingBuffer == NULL) {
+                mPendingBuffer = acquireBuffer_l(mBatchSize);
+                mPendingBuffer->set_range(0, 0);
+                mPendingTimeUs = timeUs;
+            }
+            buffer = mPendingBuffer;
+            offset = buffer->range_length();
+            chunkSize = std::min(size, mBatchSize - offset);
+        }
+
+        uint8_t *dst = (uint8_t *) buffer->data() + offset;
+        if (data != NULL) {
+            memcpy(dst, data, chunkSize);
+            data += chunkSize;
+        } else {
+            memset(dst, 0, chunkSize);
+        }
+        buffer->set_range(0, offset + chunkSize);
+        size -= chunkSize;
+
+        if (mBatchSize == 0) {
+            queueInputBuffer_l(buffer, timeUs);
+        } else {
+            mNumFramesPending += chunkSize / frameSize;
+            if (offset + chunkSize == mBatchSize) {
+                flushPendingBuffer_l();
+            }
+        }
+    }
+}
+
+void AudioSource::flushPendingBuffer_l() {
+    if (mPendingBuffer == NULL) {
+        return;
+    }
+    MediaBuffer *buffer = mPendingBuffer;
+    mPendingBuffer = NULL;
+    mNumFramesPending = 0;
+    queueInputBuffer_l(buffer, mPendingTimeUs);
+}
+
+MediaBuffer *AudioSource::acquireBuffer_l(size_t size) {
+    if (size <= mMaxBufferSize && !mFreeBuffers.empty()) {
+        MediaBuffer *buffer = mFreeBuffers.back();
+        mFreeBuffers.pop_back();
+        return buffer;
+    }
+    // Allocate at full size so the buffer can be recycled once returned.
+    return new MediaBuffer(std::max(size, mMaxBufferSize));
+}
+
 void AudioSource::queueInputBuffer_l(MediaBuffer *buffer, int64_t timeUs) {
     const size_t bufferSize = buffer->range_length();
     const size_t frameSize = mRecord->frameSize();
@@ -19,10 +19,13 @@
 
 #include <log/log.h>
 
+#include <algorithm>
+
 #include "hidl/HidlSupport.h"
 #include <media/stagefright/foundation/AMessage.h>
 #include <media/stagefright/foundation/ABuffer.h>
 #include <media/stagefright/foundation/ADebug.h>
+#include <media/stagefright/foundation/ALooper.h>
 
 #include <media/MediaCodecBuffer.h>
 #include <media/stagefright/MediaCodec.h>
@@ -47,7 +50,12 @@ status_t CryptoAsync::decrypt(sp<AMessage> &msg) {
        return -ENOSYS;
     }
     shouldPost = pendingBuffers->size() == 0 ? true : false;
+    msg->setInt64("enqueueTimeUs", ALooper::GetNowUs());
     pendingBuffers->push_back(std::move(msg));
+    {
+        Mutexed<Stats>::Locked stats(mStats);
+        stats->mMaxPending = std::max(stats->mMaxPending, pendingBuffers->size());
+    }
     if (shouldPost) {
        sp<AMessage> decryptMsg = new AMessage(kWhatDecrypt, this);
        decryptMsg->post();
@@ -55,6 +63,25 @@ status_t CryptoAsync::decrypt(sp<AMessage> &msg) {
     return OK;
 }
 
+CryptoAsync::Stats CryptoAsync::getStats() const {
+    Mutexed<Stats>::Locked stats(mStats);
+    return *stats;
+}
+
+void CryptoAsync::recordDecrypt(const sp<AMessage> &msg, int64_t startUs) {
+    const int64_t nowUs = ALooper::GetNowUs();
+    int64_t enqueueTimeUs = startUs;
+    msg->findInt64("enqueueTimeUs", &enqueueTimeUs);
+    const int64_t decryptUs = nowUs - startUs;
+    const int64_t latencyUs = nowUs - enqueueTimeUs;
+    Mutexed<Stats>::Locked stats(mStats);
+    stats->mCount++;
+    stats->mDecryptSumUs += decryptUs;
+    stats->mDecryptMaxUs = std::max(stats->mDecryptMaxUs, decryptUs);
+    stats->mLatencySumUs += latencyUs;
+    stats->mLatencyMaxUs = std::max(stats->mLatencyMaxUs, latencyUs);
+}
+
 void CryptoAsync::stop(std::list<sp<AMessage>> * const buffers) {
     sp<AMessage>  stopMsg = new AMessage(kWhatStop, this);
     stopMsg->setPointer("remaining", static_cast<void*>(buffers));
@@ -94,9 +121,12 @@ status_t CryptoAsync::decryptAndQueue(sp<AMessage> & msg) {
     const CryptoPlugin::SubSample * subSamples =
        (CryptoPlugin::SubSample *)(subSamplesBuffer.get()->data());
     sp<MediaCodecBuffer> buffer = static_cast<MediaCodecBuffer *>(obj.get());
+    const int64_t startUs = ALooper::GetNowUs();
     err = channel->queueSecureInputBuffer(buffer, secure, key, iv, mode,
         pattern, subSamples, numSubSamples, &errorDetailMsg);
-    if (err != OK) {
+    if (err == OK) {
+        recordDecrypt(msg, startUs);
+    } else {
         std::list<sp<AMessage>> errorList;
         msg->removeEntryByName("buffer");
         msg->setInt32("err", err);
@@ -151,6 +181,7 @@ status_t CryptoAsync::attachEncryptedBufferAndQueue(sp<AMessage> & msg) {
         (mem_obj.get())->value;
 
     // attach buffer
+    const int64_t startUs = ALooper::GetNowUs();
     err = channel->attachEncryptedBuffer(
         memory, secure, key, iv, mode, pattern,
         offset, subSamples, numSubSamples, buffer, &errorDetailMsg);
@@ -182,6 +213,7 @@ status_t CryptoAsync::attachEncryptedBufferAndQueue(sp<AMessage> & msg) {
         handleError();
         return err;
     }
+    recordDecrypt(msg, startUs);
    return err;
 }
 
@@ -211,36 +243,45 @@ void CryptoAsync::onMessageReceived(const sp<AMessage> & msg) {
     switch(msg->what()) {
         case kWhatDecrypt:
         {
-            sp<AMessage> thisMsg;
+            // Buffers are decrypted in the order they were queued. Decrypt a
+            // few of them per message, so that decryption keeps ahead of the
+            // codec without a looper round trip for every buffer.
             uint32_t nextTask = kWhatDoNothing;
-            if(OK != getCurrentAndNextTask(&thisMsg, nextTask)) {
-                return;
-            }
-            if (thisMsg != nullptr) {
-                int32_t action;
-                err = OK;
-                CHECK(thisMsg->findInt32("action", &action));
-                switch(action) {
-                    case kActionDecrypt:
-                    {
-                        err = decryptAndQueue(thisMsg);
-                        break;
-                    }
+            for (size_t i = 0; i < kMaxDecryptsPerMessage; ++i) {
+                sp<AMessage> thisMsg;
+                nextTask = kWhatDoNothing;
+                if(OK != getCurrentAndNextTask(&thisMsg, nextTask)) {
+                    return;
+                }
+                if (thisMsg != nullptr) {
+                    int32_t action;
+                    err = OK;
+                    CHECK(thisMsg->findInt32("action", &action));
+                    switch(action) {
+                        case kActionDecrypt:
+                        {
+                            err = decryptAndQueue(thisMsg);
+                            break;
+                        }
 
-                    case kActionAttachEncryptedBuffer:
-                    {
-                        err = attachEncryptedBufferAndQueue(thisMsg);
-                        break;
-                    }
+                        case kActionAttachEncryptedBuffer:
+                        {
+                            err = attachEncryptedBufferAndQueue(thisMsg);
+                            break;
+                        }
 
-                    default:
-                    {
-                        ALOGE("Unrecognized action in decrypt");
+                        default:
+                        {
+                            ALOGE("Unrecognized action in decrypt");
+                        }
+                    }
+                    if (err != OK) {
+                        Mutexed<std::list<sp<AMessage>>>::Locked pendingBuffers(mPendingBuffers);
+                        mState = kCryptoAsyncError;
                     }
                 }
-                if (err != OK) {
-                    Mutexed<std::list<sp<AMessage>>>::Locked pendingBuffers(mPendingBuffers);
-                    mState = kCryptoAsyncError;
+                if (mState != kCryptoAsyncActive || nextTask == kWhatDoNothing) {
+                    break;
                 }
             }
             // we won't take  next buffers if buffer caused
@@ -17,6 +17,7 @@
 //#define LOG_NDEBUG 0
 #define LOG_TAG "FrameCaptureProcessor"
 
+#include <cutils/properties.h>
 #include <media/stagefright/foundation/ADebug.h>
 #include <media/stagefright/foundation/AMessage.h>
 #include <media/stagefright/FrameCaptureProcessor.h>
@@ -117,6 +118,10 @@ status_t FrameCaptureProcessor::capture(
 }
 
 status_t FrameCaptureProcessor::onCreate() {
+    // Linked shaders can be persisted so that later processes skip compiling them.
+    char cacheDir[PROPERTY_VALUE_MAX];
+    property_get("media.stagefright.shader_cache_dir", cacheDir, "");
+
     mRE = renderengine::RenderEngine::create(
             renderengine::RenderEngineCreationArgs::Builder()
                 .setPixelFormat(static_cast<int>(ui::PixelFormat::RGBA_8888))
@@ -124,6 +129,8 @@ status_t FrameCaptureProcessor::onCreate() {
                 .setUseColorManagerment(true)
                 .setEnableProtectedContext(false)
                 .setPrecacheToneMapperShaderOnly(true)
+                .setPrecacheInBackground(true)
+                .setProgramBinaryCacheDir(cacheDir)
                 .setContextPriority(renderengine::RenderEngine::ContextPriority::LOW)
                 .build());
 
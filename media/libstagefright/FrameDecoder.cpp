@@ -24,6 +24,8 @@
 #include <binder/MemoryHeapBase.h>
 #include <gui/Surface.h>
 #include <inttypes.h>
+#include <algorithm>
+#include <thread>
 #include <mediadrm/ICrypto.h>
 #include <media/IMediaSource.h>
 #include <media/MediaCodecBuffer.h>
@@ -263,6 +265,7 @@ FrameDecoder::FrameDecoder(
     : mIDRSent(false),
       mHaveMoreInputs(true),
       mFirstSample(true),
+      mPendingSample(NULL),
       mSource(source),
       mComponentName(componentName),
       mTrackMeta(trackMeta),
@@ -272,6 +275,9 @@ FrameDecoder::FrameDecoder(
 }
 
 FrameDecoder::~FrameDecoder() {
+    if (mPendingSample != NULL) {
+        mPendingSample->release();
+    }
     if (mDecoder != NULL) {
         mDecoder->release();
         mSource->stop();
@@ -388,7 +394,13 @@ status_t FrameDecoder::extractInternal() {
 
             MediaBufferBase *mediaBuffer = NULL;
 
-            err = mSource->read(&mediaBuffer, &mReadOptions);
+            if (mPendingSample != NULL) {
+                mediaBuffer = mPendingSample;
+                mPendingSample = NULL;
+                err = OK;
+            } else {
+                err = mSource->read(&mediaBuffer, &mReadOptions);
+            }
             mReadOptions.clearSeekTo();
             if (err != OK) {
                 mHaveMoreInputs = false;
@@ -510,7 +522,83 @@ VideoFrameDecoder::VideoFrameDecoder(
       mIsHevc(false),
       mSeekMode(MediaSource::ReadOptions::SEEK_PREVIOUS_SYNC),
       mTargetTimeUs(-1LL),
-      mDefaultSampleDurationUs(0) {
+      mFirstSampleTimeUs(-1LL),
+      mDefaultSampleDurationUs(0),
+      mMaxOutputWidth(0),
+      mMaxOutputHeight(0) {
+}
+
+int32_t VideoFrameDecoder::getDownscaleFactor(int32_t width, int32_t height) {
+    if (mCaptureLayer == nullptr || mMaxOutputWidth <= 0 || mMaxOutputHeight <= 0) {
+        return 1;
+    }
+    int32_t maxWidth = mMaxOutputWidth;
+    int32_t maxHeight = mMaxOutputHeight;
+    int32_t rotationAngle;
+    if (trackMeta()->findInt32(kKeyRotation, &rotationAngle)
+            && (rotationAngle == 90 || rotationAngle == 270)) {
+        std::swap(maxWidth, maxHeight);
+    }
+    // Halve while the result still covers the requested box, so the caller only ever
+    // scales down further.
+    int32_t factor = 1;
+    while (width / (factor * 2) >= maxWidth && height / (factor * 2) >= maxHeight) {
+        factor *= 2;
+    }
+    return factor;
+}
+
+status_t VideoFrameDecoder::seekTo(int64_t frameTimeUs, int option, bool *sameFrame) {
+    *sameFrame = false;
+    if (mDecoder == NULL) {
+        return NO_INIT;
+    }
+    if (option != mSeekMode) {
+        // The codec was configured for the seek mode, e.g. with a single buffer per port.
+        return INVALID_OPERATION;
+    }
+
+    MediaSource::ReadOptions options;
+    options.setSeekTo(frameTimeUs < 0 ? 0 : frameTimeUs, mSeekMode);
+
+    bool isSeekingClosest = (mSeekMode == MediaSource::ReadOptions::SEEK_CLOSEST)
+            || (mSeekMode == MediaSource::ReadOptions::SEEK_FRAME_INDEX);
+    if (!isSeekingClosest) {
+        // Only the sync frame is decoded, so the seek resolves to the same frame whenever
+        // it lands on the same sample. Seeking the source is cheap compared to decoding.
+        MediaBufferBase *sample = NULL;
+        status_t err = mSource->read(&sample, &options);
+        if (err != OK) {
+            return err;
+        }
+        int64_t timeUs;
+        if (sample->meta_data().findInt64(kKeyTime, &timeUs) && timeUs == mFirstSampleTimeUs) {
+            sample->release();
+            *sameFrame = true;
+            return OK;
+        }
+        if (mPendingSample != NULL) {
+            mPendingSample->release();
+        }
+        mPendingSample = sample;
+        options.clearSeekTo();
+    }
+
+    status_t err = mDecoder->flush();
+    if (err != OK) {
+        ALOGW("flush returned error %d (%s)", err, asString(err));
+        return err;
+    }
+
+    mReadOptions = options;
+    mHaveMoreInputs = true;
+    mFirstSample = true;
+    mIDRSent = false;
+    mTargetTimeUs = -1LL;
+    mSampleDurations.clear();
+    // Every extraction gets its own frame memory, the previous one belongs to the caller.
+    mFrame = NULL;
+    return OK;
 }
 
 sp<AMessage> VideoFrameDecoder::onGetFormatAndSeekOptions(
@@ -596,6 +684,10 @@ status_t VideoFrameDecoder::onInputReceived(
     bool isSeekingClosest = (mSeekMode == MediaSource::ReadOptions::SEEK_CLOSEST)
             || (mSeekMode == MediaSource::ReadOptions::SEEK_FRAME_INDEX);
 
+    if (firstSample) {
+        sampleMeta.findInt64(kKeyTime, &mFirstSampleTimeUs);
+    }
+
     if (firstSample && isSeekingClosest) {
         sampleMeta.findInt64(kKeyTargetTime, &mTargetTimeUs);
         ALOGV("Seeking closest: targetTimeUs=%lld", (long long)mTargetTimeUs);
@@ -680,10 +772,14 @@ status_t VideoFrameDecoder::onOutputReceived(
     }
 
     if (mFrame == NULL) {
+        int32_t cropWidth = crop_right - crop_left + 1;
+        int32_t cropHeight = crop_bottom - crop_top + 1;
+        // The capture renders the whole crop into a frame of the allocated size.
+        int32_t factor = getDownscaleFactor(cropWidth, cropHeight);
         sp<IMemory> frameMem = allocVideoFrame(
                 trackMeta(),
-                (crop_right - crop_left + 1),
-                (crop_bottom - crop_top + 1),
+                cropWidth / factor,
+                cropHeight / factor,
                 0,
                 0,
                 dstBpp(),
@@ -694,6 +790,14 @@ status_t VideoFrameDecoder::onOutputReceived(
         }
 
         mFrame = static_cast<VideoFrame*>(frameMem->unsecurePointer());
+        int32_t sarWidth, sarHeight;
+        if (factor > 1 && !(trackMeta()->findInt32(kKeySARWidth, &sarWidth)
+                && trackMeta()->findInt32(kKeySARHeight, &sarHeight) && sarHeight != 0)) {
+            // A display size from the container is in source pixels; one derived from
+            // the sample aspect ratio is already relative to the scaled frame.
+            mFrame->mDisplayWidth /= factor;
+            mFrame->mDisplayHeight /= factor;
+        }
 
         setFrame(frameMem);
     }
@@ -835,10 +939,16 @@ MediaImageDecoder::MediaImageDecoder(
       mTilesDecoded(0),
       mTargetTiles(0),
       mThread(NULL),
-      mUseMultiThread(false) {
+      mUseMultiThread(false),
+      mDecodeTilesInParallel(false) {
 }
 
 MediaImageDecoder::~MediaImageDecoder() {
+    // mDecoder is released by FrameDecoder.
+    for (size_t i = 1; i < mTileDecoders.size(); ++i) {
+        mTileDecoders[i]->release();
+    }
+
     if (mThread != NULL) {
         {
             ALOGI("Signalling ImageOutputThread to exit");
@@ -942,6 +1052,8 @@ sp<AMessage> MediaImageDecoder::onGetFormatAndSeekOptions(
     } else {
         ALOGD("Enable multi-thread for Heif");
         mUseMultiThread = true;
+        mDecodeTilesInParallel = true;
+        mTileFormat = videoFormat;
     }
     return videoFormat;
 }
@@ -988,6 +1100,14 @@ status_t MediaImageDecoder::onExtractRect(FrameRect *rect) {
 status_t MediaImageDecoder::onOutputReceived(
         const sp<MediaCodecBuffer> &videoFrameBuffer,
         const sp<AMessage> &outputFormat, int64_t /*timeUs*/, bool *done) {
+    int32_t tileIndex = mTilesDecoded;
+    *done = (++mTilesDecoded >= mTargetTiles);
+    return convertTile(videoFrameBuffer, outputFormat, tileIndex);
+}
+
+status_t MediaImageDecoder::convertTile(
+        const sp<MediaCodecBuffer> &videoFrameBuffer,
+        const sp<AMessage> &outputFormat, int32_t tileIndex) {
     if (outputFormat == NULL) {
         return ERROR_MALFORMED;
     }
@@ -1019,17 +1139,20 @@ status_t MediaImageDecoder::onOutputReceived(
         return ERROR_MALFORMED;
     }
 
-    if (mFrame == NULL) {
-        sp<IMemory> frameMem = allocVideoFrame(
-                trackMeta(), mWidth, mHeight, mTileWidth, mTileHeight, dstBpp(), bitDepth);
+    {
+        Mutex::Autolock autoLock(mFrameLock);
+        if (mFrame == NULL) {
+            sp<IMemory> frameMem = allocVideoFrame(
+                    trackMeta(), mWidth, mHeight, mTileWidth, mTileHeight, dstBpp(), bitDepth);
 
-        if (frameMem == nullptr) {
-            return NO_MEMORY;
-        }
+            if (frameMem == nullptr) {
+                return NO_MEMORY;
+            }
 
-        mFrame = static_cast<VideoFrame*>(frameMem->unsecurePointer());
+            mFrame = static_cast<VideoFrame*>(frameMem->unsecurePointer());
 
-        setFrame(frameMem);
+            setFrame(frameMem);
+        }
     }
 
     ColorConverter converter((OMX_COLOR_FORMATTYPE)srcFormat, dstFormat());
@@ -1073,8 +1196,8 @@ status_t MediaImageDecoder::onOutputReceived(
     crop_height = crop_bottom - crop_top + 1;
 
     int32_t dstLeft, dstTop, dstRight, dstBottom;
-    dstLeft = mTilesDecoded % mGridCols * crop_width;
-    dstTop = mTilesDecoded / mGridCols * crop_height;
+    dstLeft = tileIndex % mGridCols * crop_width;
+    dstTop = tileIndex / mGridCols * crop_height;
     dstRight = dstLeft + crop_width - 1;
     dstBottom = dstTop + crop_height - 1;
 
@@ -1089,8 +1212,6 @@ status_t MediaImageDecoder::onOutputReceived(
         dstBottom = mHeight - 1;
     }
 
-    *done = (++mTilesDecoded >= mTargetTiles);
-
     if (converter.isValid()) {
         converter.convert(
                 (const uint8_t *)videoFrameBuffer->data(),
@@ -1217,6 +1338,13 @@ status_t MediaImageDecoder::extractInternal() {
         outInfo->mSignalType = NONE;
     }
 
+    if (mDecodeTilesInParallel) {
+        if (initTileDecoders() == OK) {
+            return extractTilesInParallel();
+        }
+        mDecodeTilesInParallel = false;
+    }
+
     if (mUseMultiThread && mThread == NULL) {
         mThread = new ImageOutputThread(this);
         err = mThread->run("ImageDecoderOutput");
@@ -1387,4 +1515,181 @@ status_t MediaImageDecoder::extractInternal() {
     return err;
 }
 
+status_t MediaImageDecoder::initTileDecoders() {
+    if (!mTileDecoders.empty()) {
+        return OK;
+    }
+
+    size_t numDecoders = std::min(kMaxTileDecoders, (size_t)(mGridRows * mGridCols));
+    mTileDecoders.push_back(mDecoder);
+    for (size_t i = 1; i < numDecoders; ++i) {
+        status_t err;
+        sp<ALooper> looper = new ALooper;
+        looper->start();
+        sp<MediaCodec> decoder = MediaCodec::CreateByComponentName(
+                looper, componentName(), &err);
+        if (decoder.get() == NULL || err != OK) {
+            ALOGW("Failed to instantiate tile decoder %zu [%s]", i, componentName().c_str());
+            break;
+        }
+        err = decoder->configure(mTileFormat, NULL /* surface */, NULL /* crypto */, 0);
+        if (err == OK) {
+            err = decoder->start();
+        }
+        if (err != OK) {
+            ALOGW("Failed to start tile decoder %zu: %d (%s)", i, err, asString(err));
+            decoder->release();
+            break;
+        }
+        mTileDecoders.push_back(decoder);
+    }
+
+    if (mTileDecoders.size() < 2) {
+        mTileDecoders.clear();
+        return ERROR_UNSUPPORTED;
+    }
+    ALOGV("decoding %dx%d tiles with %zu decoders", mGridCols, mGridRows, mTileDecoders.size());
+    mTileOutputFormats.resize(mTileDecoders.size());
+    return OK;
+}
+
+status_t MediaImageDecoder::extractTilesInParallel() {
+    const size_t numDecoders = mTileDecoders.size();
+
+    // Tile i is decoded by decoder i % numDecoders. Each decoder is drained by its own
+    // thread, which converts the tiles straight into their place in the frame.
+    std::vector<int32_t> numTiles(numDecoders, 0);
+    for (int32_t tile = mTilesDecoded; tile < mTargetTiles; ++tile) {
+        ++numTiles[tile % numDecoders];
+    }
+
+    std::atomic<status_t> error(OK);
+    std::vector<std::thread> drainThreads;
+    for (size_t i = 0; i < numDecoders; ++i) {
+        if (numTiles[i] > 0) {
+            drainThreads.emplace_back([this, i, &numTiles, &error]() {
+                drainTileDecoder(i, numTiles[i], &error);
+            });
+        }
+    }
+
+    for (int32_t tile = mTilesDecoded; tile < mTargetTiles && error == OK; ++tile) {
+        status_t err = queueTile(mTileDecoders[tile % numDecoders], tile, error);
+        if (err != OK) {
+            status_t expected = OK;
+            error.compare_exchange_strong(expected, err);
+        }
+    }
+
+    for (std::thread &thread : drainThreads) {
+        thread.join();
+    }
+    mTilesDecoded = mTargetTiles;
+
+    status_t err = error;
+    if (err != OK) {
+        ALOGE("failed to get video frame (err %d)", err);
+    }
+    return err;
+}
+
+status_t MediaImageDecoder::queueTile(
+        const sp<MediaCodec> &decoder, int32_t tileIndex, const std::atomic<status_t> &error) {
+    size_t index;
+    size_t retriesLeft = kRetryCount;
+    status_t err;
+    do {
+        err = decoder->dequeueInputBuffer(&index, kBufferTimeOutUs);
+    } while (err == -EAGAIN && --retriesLeft > 0 && error == OK);
+    if (err != OK) {
+        ALOGW("Timed out waiting for input");
+        return err;
+    }
+
+    sp<MediaCodecBuffer> codecBuffer;
+    err = decoder->getInputBuffer(index, &codecBuffer);
+    if (err != OK) {
+        ALOGE("failed to get input buffer %zu", index);
+        return err;
+    }
+
+    MediaBufferBase *mediaBuffer = NULL;
+    err = mSource->read(&mediaBuffer, &mReadOptions);
+    mReadOptions.clearSeekTo();
+    if (err != OK) {
+        ALOGW("Input Error: err=%d", err);
+        return err;
+    }
+
+    if (mediaBuffer->range_length() > codecBuffer->capacity()) {
+        ALOGE("buffer size (%zu) too large for codec input size (%zu)",
+                mediaBuffer->range_length(), codecBuffer->capacity());
+        mediaBuffer->release();
+        return BAD_VALUE;
+    }
+    codecBuffer->setRange(0, mediaBuffer->range_length());
+    memcpy(codecBuffer->data(),
+            (const uint8_t*)mediaBuffer->data() + mediaBuffer->range_offset(),
+            mediaBuffer->range_length());
+    mediaBuffer->release();
+    mFirstSample = false;
+
+    // The tile index is passed as the timestamp, so that outputs can be placed without
+    // relying on the order in which the decoders return them.
+    ALOGV("QueueInput: tile %d size=%zu", tileIndex, codecBuffer->size());
+    return decoder->queueInputBuffer(
+            index, codecBuffer->offset(), codecBuffer->size(), tileIndex, 0 /* flags */);
+}
+
+void MediaImageDecoder::drainTileDecoder(
+        size_t decoderIndex, int32_t numTiles, std::atomic<status_t> *error) {
+    const sp<MediaCodec> &decoder = mTileDecoders[decoderIndex];
+    size_t retriesLeft = kRetryCount;
+    status_t err = OK;
+
+    while (numTiles > 0 && err == OK && *error == OK) {
+        size_t index, offset, size;
+        int64_t ptsUs;
+        uint32_t flags;
+        err = decoder->dequeueOutputBuffer(
+                &index, &offset, &size, &ptsUs, &flags, kBufferTimeOutUs);
+
+        if (err == INFO_FORMAT_CHANGED) {
+            ALOGV("Received format change from tile decoder %zu", decoderIndex);
+            err = decoder->getOutputFormat(&mTileOutputFormats[decoderIndex]);
+        } else if (err == INFO_OUTPUT_BUFFERS_CHANGED) {
+            err = OK;
+        } else if (err == -EAGAIN) {
+            if (--retriesLeft > 0) {
+                err = OK;
+            }
+        } else if (err == OK) {
+            sp<MediaCodecBuffer> videoFrameBuffer;
+            err = decoder->getOutputBuffer(index, &videoFrameBuffer);
+            if (err == OK) {
+                if (ptsUs < 0 || ptsUs >= mGridRows * mGridCols) {
+                    ALOGE("tile decoder %zu returned bad tile index %" PRId64,
+                            decoderIndex, ptsUs);
+                    err = ERROR_MALFORMED;
+                } else {
+                    err = convertTile(
+                            videoFrameBuffer, mTileOutputFormats[decoderIndex], ptsUs);
+                }
+            } else {
+                ALOGE("failed to get output buffer %zu", index);
+            }
+            decoder->releaseOutputBuffer(index);
+            --numTiles;
+            retriesLeft = kRetryCount;
+        } else {
+            ALOGW("Received error %d (%s) instead of output", err, asString(err));
+        }
+    }
+
+    if (err != OK) {
+        status_t expected = OK;
+        error->compare_exchange_strong(expected, err);
+    }
+}
+
 }  // namespace android
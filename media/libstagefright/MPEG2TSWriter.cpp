@@ -21,6 +21,7 @@
 #include <media/stagefright/foundation/ADebug.h>
 #include <media/stagefright/foundation/hexdump.h>
 #include <media/stagefright/foundation/ABuffer.h>
+#include <media/stagefright/foundation/ALooper.h>
 #include <media/stagefright/foundation/AMessage.h>
 #include <media/stagefright/foundation/ByteUtils.h>
 #include <media/stagefright/MPEG2TSWriter.h>
@@ -29,11 +30,16 @@
 #include <media/stagefright/MediaErrors.h>
 #include <media/stagefright/MetaData.h>
 #include <arpa/inet.h>
+#include <unistd.h>
+#include <utils/String8.h>
 
 #include <media/esds/ESDS.h>
 
 namespace android {
 
+static const size_t kFileBufferSize = 256 * 1024;
+static const int64_t kStalledWriteTimeUs = 100000;
+
 struct MPEG2TSWriter::SourceInfo : public AHandler {
     explicit SourceInfo(const sp<MediaSource> &source);
 
@@ -452,7 +458,10 @@ MPEG2TSWriter::MPEG2TSWriter(int fd)
       mNumTSPacketsWritten(0),
       mNumTSPacketsBeforeMeta(0),
       mPATContinuityCounter(0),
-      mPMTContinuityCounter(0) {
+      mPMTContinuityCounter(0),
+      mTotalWriteTimeUs(0),
+      mMaxWriteTimeUs(0),
+      mNumStalledWrites(0) {
     init();
 }
 
@@ -467,13 +476,21 @@ MPEG2TSWriter::MPEG2TSWriter(
       mNumTSPacketsWritten(0),
       mNumTSPacketsBeforeMeta(0),
       mPATContinuityCounter(0),
-      mPMTContinuityCounter(0) {
+      mPMTContinuityCounter(0),
+      mTotalWriteTimeUs(0),
+      mMaxWriteTimeUs(0),
+      mNumStalledWrites(0) {
     init();
 }
 
 void MPEG2TSWriter::init() {
     CHECK(mFile != NULL || mWriteFunc != NULL);
 
+    if (mFile != NULL) {
+        // Let a whole access unit or more through per write().
+        setvbuf(mFile, NULL, _IOFBF, kFileBufferSize);
+    }
+
     initCrcTable();
 
     mLooper = new ALooper;
@@ -525,6 +542,9 @@ status_t MPEG2TSWriter::start(MetaData *param ) {
     mNumSourcesDone = 0;
     mNumTSPacketsWritten = 0;
     mNumTSPacketsBeforeMeta = 0;
+    mTotalWriteTimeUs = 0;
+    mMaxWriteTimeUs = 0;
+    mNumStalledWrites = 0;
 
     for (size_t i = 0; i < mSources.size(); ++i) {
         sp<AMessage> notify =
@@ -560,7 +580,20 @@ bool MPEG2TSWriter::reachedEOS() {
 }
 
 status_t MPEG2TSWriter::dump(
-        int /* fd */, const Vector<String16> & /* args */) {
+        int fd, const Vector<String16> & /* args */) {
+    const size_t SIZE = 256;
+    char buffer[SIZE];
+    String8 result;
+    snprintf(buffer, SIZE, "   MPEG2TSWriter %p\n", this);
+    result.append(buffer);
+    snprintf(buffer, SIZE, "     mStarted: %s\n", mStarted ? "true" : "false");
+    result.append(buffer);
+    snprintf(buffer, SIZE, "     TS packets written: %lld\n", (long long)mNumTSPacketsWritten);
+    result.append(buffer);
+    snprintf(buffer, SIZE, "     write time: %lld us total, %lld us max, %d stalled\n",
+            (long long)mTotalWriteTimeUs, (long long)mMaxWriteTimeUs, mNumStalledWrites);
+    result.append(buffer);
+    ::write(fd, result.string(), result.size());
     return OK;
 }
 
@@ -826,7 +859,12 @@ void MPEG2TSWriter::writeAccessUnit(
     // reserved = b1
     // the first fragment of "buffer" follows
 
-    sp<ABuffer> buffer = new ABuffer(188);
+    // All the TS packets of the access unit are built next to each other and
+    // handed to the output in one go, rather than 188 bytes at a time.
+    sp<ABuffer> packets = new ABuffer(188 * (accessUnit->size() / 184 + 2));
+    size_t numPackets = 0;
+
+    sp<ABuffer> buffer = new ABuffer(packets->data() + 188 * numPackets++, 188);
     memset(buffer->data(), 0xff, buffer->size());
 
     const unsigned PID = 0x1e0 + sourceIndex + 1;
@@ -891,8 +929,6 @@ void MPEG2TSWriter::writeAccessUnit(
 
     memcpy(ptr, accessUnit->data(), copy);
 
-    CHECK_EQ(internalWrite(buffer->data(), buffer->size()), (ssize_t)buffer->size());
-
     size_t offset = copy;
     while (offset < accessUnit->size()) {
         bool lastAccessUnit = ((accessUnit->size() - offset) < 184);
@@ -907,6 +943,8 @@ void MPEG2TSWriter::writeAccessUnit(
         // continuity_counter = b????
         // the fragment of "buffer" follows.
 
+        CHECK_LT(188 * numPackets, packets->capacity());
+        buffer = new ABuffer(packets->data() + 188 * numPackets++, 188);
         memset(buffer->data(), 0xff, buffer->size());
 
         const unsigned continuity_counter =
@@ -936,11 +974,11 @@ void MPEG2TSWriter::writeAccessUnit(
         }
 
         memcpy(ptr, accessUnit->data() + offset, copy);
-        CHECK_EQ(internalWrite(buffer->data(), buffer->size()),
-                 (ssize_t)buffer->size());
 
         offset += copy;
     }
+
+    CHECK_EQ(internalWrite(packets->data(), 188 * numPackets), (ssize_t)(188 * numPackets));
 }
 
 void MPEG2TSWriter::writeTS() {
@@ -980,11 +1018,26 @@ uint32_t MPEG2TSWriter::crc32(const uint8_t *p_start, size_t length) {
 }
 
 ssize_t MPEG2TSWriter::internalWrite(const void *data, size_t size) {
+    mNumTSPacketsWritten += size / 188;
+
+    int64_t startUs = ALooper::GetNowUs();
+    ssize_t n;
     if (mFile != NULL) {
-        return fwrite(data, 1, size, mFile);
+        n = fwrite(data, 1, size, mFile);
+    } else {
+        n = (*mWriteFunc)(mWriteCookie, data, size);
     }
+    int64_t writeTimeUs = ALooper::GetNowUs() - startUs;
 
-    return (*mWriteFunc)(mWriteCookie, data, size);
+    mTotalWriteTimeUs += writeTimeUs;
+    if (writeTimeUs > mMaxWriteTimeUs) {
+        mMaxWriteTimeUs = writeTimeUs;
+    }
+    if (writeTimeUs >= kStalledWriteTimeUs) {
+        ++mNumStalledWrites;
+        ALOGW("writing %zu bytes took %lld us", size, (long long)writeTimeUs);
+    }
+    return n;
 }
 
 }  // namespace android
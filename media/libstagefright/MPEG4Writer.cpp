@@ -31,6 +31,7 @@
 #include <utils/Log.h>
 
 #include <functional>
+#include <vector>
 #include <fcntl.h>
 
 #include <media/stagefright/MediaSource.h>
@@ -76,6 +77,7 @@ static const int64_t kInitialDelayTimeUs     = 700000LL;
 static const int64_t kMaxMetadataSize = 0x4000000LL;   // 64MB max per-frame metadata size
 static const int64_t kMaxCttsOffsetTimeUs = 30 * 60 * 1000000LL;  // 30 minutes
 static const size_t kESDSScratchBufferSize = 10;  // kMaxAtomSize in Mpeg4Extractor 64MB
+static const size_t kWriteBufferSize = 256 * 1024;  // Coalesces writes to the output file
 
 static const char kMetaKey_Version[]    = "com.android.version";
 static const char kMetaKey_Manufacturer[]      = "com.android.manufacturer";
@@ -154,6 +156,11 @@ public:
     int64_t getEstimatedTrackSizeBytes() const;
     int32_t getMetaSizeIncrease(int32_t angle, int32_t trackCount) const;
     void writeTrackHeader();
+    // Write the description of the given samples of a movie fragment, whose data
+    // starts |dataOffset| bytes after the start of the 'moof' box.
+    void writeTrafBox(const std::vector<MediaBuffer *> &samples,
+            const std::vector<uint32_t> &sampleSizes, uint32_t dataOffset,
+            int64_t movieStartTimeUs);
     int64_t getMinCttsOffsetTimeUs();
     void bufferChunk(int64_t timestampUs);
     bool isAvc() const { return mIsAvc; }
@@ -188,7 +195,8 @@ private:
             : mElementCapacity(elementCapacity),
             mTotalNumTableEntries(0),
             mNumValuesInCurrEntry(0),
-            mCurrTableEntriesElement(NULL) {
+            mCurrTableEntriesElement(NULL),
+            mCountOnly(false) {
             CHECK_GT(mElementCapacity, 0u);
             // Ensure no integer overflow on allocation in add().
             CHECK_LT(ENTRY_SIZE, UINT32_MAX / mElementCapacity);
@@ -259,20 +267,26 @@ private:
             }
         }
 
+        // Only count the values added from now on, without storing them.
+        // The table can no longer be written out afterwards.
+        void setCountOnly() { mCountOnly = true; }
+
         // Store a single value.
         // @arg value must be in network byte order.
         void add(const TYPE& value) {
             CHECK_LT(mNumValuesInCurrEntry, mElementCapacity);
             uint32_t nEntries = mTotalNumTableEntries % mElementCapacity;
             uint32_t nValues  = mNumValuesInCurrEntry % ENTRY_SIZE;
-            if (nEntries == 0 && nValues == 0) {
-                mCurrTableEntriesElement = new TYPE[ENTRY_SIZE * mElementCapacity];
-                CHECK(mCurrTableEntriesElement != NULL);
-                mTableEntryList.push_back(mCurrTableEntriesElement);
-            }
+            if (!mCountOnly) {
+                if (nEntries == 0 && nValues == 0) {
+                    mCurrTableEntriesElement = new TYPE[ENTRY_SIZE * mElementCapacity];
+                    CHECK(mCurrTableEntriesElement != NULL);
+                    mTableEntryList.push_back(mCurrTableEntriesElement);
+                }
 
-            uint32_t pos = nEntries * ENTRY_SIZE + nValues;
-            mCurrTableEntriesElement[pos] = value;
+                uint32_t pos = nEntries * ENTRY_SIZE + nValues;
+                mCurrTableEntriesElement[pos] = value;
+            }
 
             ++mNumValuesInCurrEntry;
             if ((mNumValuesInCurrEntry % ENTRY_SIZE) == 0) {
@@ -286,6 +300,7 @@ private:
         // 2. followed by the values in the table enties in order
         // @arg writer the writer to actual write to the storage
         void write(MPEG4Writer *writer) const {
+            CHECK(!mCountOnly);
             CHECK_EQ(mNumValuesInCurrEntry % ENTRY_SIZE, 0u);
             uint32_t nEntries = mTotalNumTableEntries;
             writer->writeInt32(nEntries);
@@ -310,6 +325,7 @@ private:
         uint32_t         mTotalNumTableEntries;
         uint32_t         mNumValuesInCurrEntry;  // up to ENTRY_SIZE
         TYPE             *mCurrTableEntriesElement;
+        bool             mCountOnly;
         mutable List<TYPE *>     mTableEntryList;
 
         DISALLOW_EVIL_CONSTRUCTORS(ListTableEntries);
@@ -396,6 +412,8 @@ private:
     bool mReachedEOS;
     int64_t mStartTimestampUs;
     int64_t mStartTimeRealUs;
+    // Duration of the last sample written in a movie fragment.
+    int64_t mLastFragmentSampleDurationTicks;
     int64_t mFirstSampleTimeRealUs;
     // Captures negative start offset of a track(track starttime < 0).
     int64_t mFirstSampleStartOffsetUs;
@@ -556,8 +574,12 @@ void MPEG4Writer::initInternal(int fd, bool isFirstSession) {
     mInMemoryCache = NULL;
     mInMemoryCacheOffset = 0;
     mInMemoryCacheSize = 0;
+    mWriteBuffer = NULL;
+    mWriteBufferOffset = 0;
     mWriteBoxToMemory = false;
     mFreeBoxOffset = 0;
+    mFragmentDurationUs = 0;
+    mFragmentSequenceNumber = 0;
     mStreamableFile = false;
     mTimeScale = -1;
     mHasFileLevelMeta = false;
@@ -960,6 +982,18 @@ status_t MPEG4Writer::start(MetaData *param) {
         return OK;
     }
 
+    int64_t fragmentDurationUs;
+    if (param && param->findInt64(kKeyFragmentDurationUs, &fragmentDurationUs)
+            && fragmentDurationUs > 0) {
+        if (mHasFileLevelMeta || !mHasMoovBox) {
+            ALOGW("Fragmented recording is not supported for image tracks");
+        } else {
+            mFragmentDurationUs = fragmentDurationUs;
+            ALOGI("Writing a movie fragment every %" PRId64 " us", mFragmentDurationUs);
+        }
+    }
+    mFragmentSequenceNumber = 0;
+
     if (!param ||
         !param->findInt32(kKeyTimeScale, &mTimeScale)) {
         // Increased by a factor of 10 to improve precision of segment duration in edit list entry.
@@ -976,7 +1010,8 @@ status_t MPEG4Writer::start(MetaData *param) {
      */
     mStreamableFile =
         (mMaxFileSizeLimitBytes != 0 &&
-         mMaxFileSizeLimitBytes >= kMinStreamableFileSizeInBytes);
+         mMaxFileSizeLimitBytes >= kMinStreamableFileSizeInBytes &&
+         !isFragmented());
 
     /*
      * mWriteBoxToMemory is true if the amount of data in a file-level meta or
@@ -1083,7 +1118,10 @@ status_t MPEG4Writer::start(MetaData *param) {
 
     mOffset = mMdatOffset;
     seekOrPostError(mFd, mMdatOffset, SEEK_SET);
-    write("\x00\x00\x00\x01mdat????????", 16);
+    if (!isFragmented()) {
+        // Movie fragments come with 'mdat' boxes of their own.
+        write("\x00\x00\x00\x01mdat????????", 16);
+    }
 
     /* Confirm whether the writing of the initial file atoms, ftyp and free,
      * are written to the file properly by posting kWhatNoIOErrorSoFar to the
@@ -1218,6 +1256,7 @@ void MPEG4Writer::printWriteDurations() {
 status_t MPEG4Writer::release() {
     ALOGD("release()");
     status_t err = OK;
+    flushWriteBuffer();
     if (!truncatePreAllocation()) {
         if (err == OK) { err = ERROR_IO; }
     }
@@ -1256,6 +1295,9 @@ status_t MPEG4Writer::release() {
     mStarted = false;
     free(mInMemoryCache);
     mInMemoryCache = NULL;
+    free(mWriteBuffer);
+    mWriteBuffer = NULL;
+    mWriteBufferOffset = 0;
 
     printWriteDurations();
 
@@ -1379,6 +1421,23 @@ status_t MPEG4Writer::reset(bool stopSource, bool waitForAnyPreviousCallToComple
         return mResetStatus;
     }
 
+    if (isFragmented()) {
+        // Every movie fragment is complete on its own, there is nothing to fix up
+        // unless not a single fragment was written.
+        if (mFragmentSequenceNumber == 0) {
+            writeFragmentedMoovBox();
+        }
+        mMdatEndOffset = mOffset;
+        CHECK(mBoxes.empty());
+
+        status_t errRelease = release();
+        if (err == OK) {
+            err = errRelease;
+        }
+        mResetStatus = err;
+        return mResetStatus;
+    }
+
     // Fix up the size of the 'mdat' chunk.
     seekOrPostError(mFd, mMdatOffset + 8, SEEK_SET);
     uint64_t size = mOffset - mMdatOffset;
@@ -1792,6 +1851,60 @@ void MPEG4Writer::writeOrPostError(int fd, const void* buf, size_t count) {
     if (mWriteSeekErr == true)
         return;
 
+    if (fd != mFd) {
+        writeToFileOrPostError(fd, buf, count);
+        return;
+    }
+
+    if (mWriteBuffer == NULL) {
+        mWriteBuffer = (uint8_t *) malloc(kWriteBufferSize);
+        if (mWriteBuffer == NULL) {
+            writeToFileOrPostError(fd, buf, count);
+            return;
+        }
+        mWriteBufferOffset = 0;
+    }
+
+    /* Fill the write buffer up and hand it to the file system whole, so that, between two
+     * seeks, the data reaches the file in kWriteBufferSize sized and aligned writes rather
+     * than one small write per box field, sample or length prefix.
+     */
+    const uint8_t *data = (const uint8_t *) buf;
+    size_t copy = std::min(count, kWriteBufferSize - mWriteBufferOffset);
+    memcpy(mWriteBuffer + mWriteBufferOffset, data, copy);
+    mWriteBufferOffset += copy;
+    data += copy;
+    count -= copy;
+    if (mWriteBufferOffset < kWriteBufferSize) {
+        return;
+    }
+    flushWriteBuffer();
+
+    // Large samples go to the file directly, except for the tail.
+    size_t direct = count - count % kWriteBufferSize;
+    if (direct > 0) {
+        writeToFileOrPostError(fd, data, direct);
+        data += direct;
+        count -= direct;
+    }
+    if (count > 0 && mWriteSeekErr == false) {
+        memcpy(mWriteBuffer, data, count);
+        mWriteBufferOffset = count;
+    }
+}
+
+void MPEG4Writer::flushWriteBuffer() {
+    if (mWriteBufferOffset == 0)
+        return;
+    size_t count = mWriteBufferOffset;
+    mWriteBufferOffset = 0;
+    writeToFileOrPostError(mFd, mWriteBuffer, count);
+}
+
+void MPEG4Writer::writeToFileOrPostError(int fd, const void* buf, size_t count) {
+    if (mWriteSeekErr == true)
+        return;
+
     auto beforeTP = std::chrono::high_resolution_clock::now();
     ssize_t bytesWritten = ::write(fd, buf, count);
     auto afterTP = std::chrono::high_resolution_clock::now();
@@ -1819,6 +1932,7 @@ void MPEG4Writer::writeOrPostError(int fd, const void* buf, size_t count) {
 }
 
 void MPEG4Writer::seekOrPostError(int fd, off64_t offset, int whence) {
+    flushWriteBuffer();
     if (mWriteSeekErr == true)
         return;
     off64_t resOffset = lseek64(fd, offset, whence);
@@ -1867,6 +1981,11 @@ void MPEG4Writer::endBox() {
     if (mWriteBoxToMemory) {
         int32_t x = htonl(mInMemoryCacheOffset - offset);
         memcpy(mInMemoryCache + offset, &x, 4);
+    } else if (mWriteBuffer != NULL && offset >= mOffset - (off64_t)mWriteBufferOffset) {
+        // The box header has not reached the file yet, fix it up in the write buffer.
+        int32_t x = htonl(mOffset - offset);
+        memcpy(mWriteBuffer + (offset - (mOffset - mWriteBufferOffset)), &x, 4);
+        ALOGV("box size:%" PRIu64, mOffset - offset);
     } else {
         seekOrPostError(mFd, offset, SEEK_SET);
         writeInt32(mOffset - offset);
@@ -2251,6 +2370,7 @@ MPEG4Writer::Track::Track(
       mGotAllCodecSpecificData(false),
       mReachedEOS(false),
       mStartTimestampUs(-1),
+      mLastFragmentSampleDurationTicks(0),
       mFirstSampleTimeRealUs(0),
       mFirstSampleStartOffsetUs(0),
       mRotation(0),
@@ -2357,6 +2477,7 @@ void MPEG4Writer::Track::resetInternal() {
         mElstTableEntries = new ListTableEntries<uint32_t, 3>(3);
     }
     mReachedEOS = false;
+    mLastFragmentSampleDurationTicks = 0;
 }
 
 int64_t MPEG4Writer::Track::trackMetaDataSize() {
@@ -2911,6 +3032,11 @@ void MPEG4Writer::threadFunc() {
         androidSetThreadPriority(0 /* tid (0 = current) */, ANDROID_PRIORITY_BACKGROUND);
     }
 
+    if (isFragmented()) {
+        writeFragments();
+        return;
+    }
+
     Mutex::Autolock autoLock(mLock);
     while (!mDone) {
         Chunk chunk;
@@ -2941,6 +3067,145 @@ void MPEG4Writer::threadFunc() {
     mOffset = std::max(mOffset, mMaxOffsetAppend);
 }
 
+bool MPEG4Writer::isFragmentReady_l() {
+    int64_t minTimestampUs = INT64_MAX;
+    int64_t maxTimestampUs = INT64_MIN;
+    bool allTracksBuffered = true;
+    for (List<ChunkInfo>::iterator it = mChunkInfos.begin();
+         it != mChunkInfos.end(); ++it) {
+        if (it->mChunks.empty()) {
+            allTracksBuffered = false;
+            continue;
+        }
+        minTimestampUs = std::min(minTimestampUs, it->mChunks.begin()->mTimeStampUs);
+        maxTimestampUs = std::max(maxTimestampUs, (--it->mChunks.end())->mTimeStampUs);
+    }
+    if (minTimestampUs > maxTimestampUs) {
+        return false;
+    }
+
+    int64_t bufferedDurationUs = maxTimestampUs - minTimestampUs;
+    if (mFragmentSequenceNumber == 0 && !allTracksBuffered) {
+        // The 'moov' box goes out with the first fragment and needs the codec specific
+        // data of every track, so give the tracks that have not started yet some time.
+        return bufferedDurationUs >= 4 * mFragmentDurationUs;
+    }
+    return bufferedDurationUs >= mFragmentDurationUs;
+}
+
+void MPEG4Writer::writeFragments() {
+    ALOGV("writeFragments");
+    bool done = false;
+    while (!done) {
+        List<Chunk> chunks;
+        int64_t movieStartTimeUs;
+        {
+            Mutex::Autolock autoLock(mLock);
+            while (!mDone && !isFragmentReady_l()) {
+                mChunkReadyCondition.wait(mLock);
+            }
+            done = mDone;
+
+            for (List<ChunkInfo>::iterator it = mChunkInfos.begin();
+                 it != mChunkInfos.end(); ++it) {
+                for (List<Chunk>::iterator chunkIt = it->mChunks.begin();
+                     chunkIt != it->mChunks.end(); ++chunkIt) {
+                    chunks.push_back(*chunkIt);
+                }
+                it->mChunks.clear();
+            }
+            movieStartTimeUs = mStartTimestampUs;
+        }
+
+        // Write without holding the lock, so that the track threads keep buffering
+        // samples for the next fragment.
+        if (!chunks.empty()) {
+            writeFragment(chunks, movieStartTimeUs);
+        }
+    }
+
+    Mutex::Autolock autoLock(mLock);
+    sendSessionSummary();
+    mChunkInfos.clear();
+    ALOGD("%u movie fragments are written", mFragmentSequenceNumber);
+}
+
+void MPEG4Writer::writeFragment(List<Chunk> &chunks, int64_t movieStartTimeUs) {
+    if (mFragmentSequenceNumber == 0) {
+        writeFragmentedMoovBox();
+    }
+    ++mFragmentSequenceNumber;
+
+    // One run of samples per track, the chunks of each track being consecutive.
+    struct TrackRun {
+        Track *mTrack;
+        std::vector<MediaBuffer *> mSamples;
+        std::vector<uint32_t> mSampleSizes;
+        uint32_t mDataOffset;
+    };
+    std::vector<TrackRun> runs;
+    for (List<Chunk>::iterator it = chunks.begin(); it != chunks.end(); ++it) {
+        if (runs.empty() || runs.back().mTrack != it->mTrack) {
+            runs.push_back(TrackRun());
+            runs.back().mTrack = it->mTrack;
+            runs.back().mDataOffset = 0;
+        }
+        for (List<MediaBuffer *>::iterator sampleIt = it->mSamples.begin();
+             sampleIt != it->mSamples.end(); ++sampleIt) {
+            runs.back().mSamples.push_back(*sampleIt);
+        }
+    }
+    chunks.clear();
+
+    // The sample data goes first, after the space left for the 'moof' box and the
+    // header of the 'mdat' box, whose sizes are known up front.
+    off64_t moofOffset = mOffset;
+    off64_t moofSize = 8 + 16;  // moof, mfhd
+    for (const TrackRun &run : runs) {
+        moofSize += 8 + 16 + 20 + 20 + 16 * run.mSamples.size();  // traf, tfhd, tfdt, trun
+    }
+    mOffset = moofOffset + moofSize + 8;
+    seekOrPostError(mFd, mOffset, SEEK_SET);
+    for (TrackRun &run : runs) {
+        run.mDataOffset = mOffset - moofOffset;
+        bool usePrefix = run.mTrack->usePrefix();
+        for (MediaBuffer *sample : run.mSamples) {
+            size_t bytesWritten;
+            addSample_l(sample, usePrefix, 0 /* tiffHdrOffset */, &bytesWritten);
+            run.mSampleSizes.push_back(bytesWritten);
+        }
+    }
+    off64_t mdatEndOffset = mOffset;
+
+    seekOrPostError(mFd, moofOffset, SEEK_SET);
+    mOffset = moofOffset;
+    beginBox("moof");
+    beginBox("mfhd");
+    writeInt32(0);             // version=0, flags=0
+    writeInt32(mFragmentSequenceNumber);
+    endBox();  // mfhd
+    for (const TrackRun &run : runs) {
+        run.mTrack->writeTrafBox(run.mSamples, run.mSampleSizes, run.mDataOffset,
+                movieStartTimeUs);
+    }
+    endBox();  // moof
+    CHECK_EQ(mOffset, moofOffset + moofSize);
+
+    CHECK_LE(mdatEndOffset - mOffset, (off64_t)UINT32_MAX);
+    writeInt32(mdatEndOffset - mOffset);
+    write("mdat", 4);
+    mOffset = mdatEndOffset;
+    seekOrPostError(mFd, mOffset, SEEK_SET);
+
+    for (TrackRun &run : runs) {
+        for (MediaBuffer *sample : run.mSamples) {
+            sample->release();
+        }
+    }
+    ALOGV("movie fragment #%u: %" PRId64 " bytes", mFragmentSequenceNumber,
+            (int64_t)(mdatEndOffset - moofOffset));
+}
+
 status_t MPEG4Writer::startWriterThread() {
     ALOGV("startWriterThread");
 
@@ -3046,6 +3311,17 @@ status_t MPEG4Writer::Track::start(MetaData *params) {
     mMaxChunkDurationUs = 0;
     mLastDecodingTimeUs = -1;
 
+    if (mOwner->isFragmented()) {
+        // The samples are described in the movie fragments. Only keep count of
+        // them, so that the memory used does not grow with the recording length.
+        mStszTableEntries->setCountOnly();
+        mCo64TableEntries->setCountOnly();
+        mStscTableEntries->setCountOnly();
+        mStssTableEntries->setCountOnly();
+        mSttsTableEntries->setCountOnly();
+        mCttsTableEntries->setCountOnly();
+    }
+
     pthread_create(&mThread, &attr, ThreadWrapper, this);
     pthread_attr_destroy(&attr);
 
@@ -3798,19 +4074,28 @@ status_t MPEG4Writer::Track::threadEntry() {
 
         ++nActualFrames;
 
-        // Make a deep copy of the MediaBuffer and Metadata and release
-        // the original as soon as we can
-        MediaBuffer *copy = new MediaBuffer(buffer->range_length());
-        if (sampleFileOffset != -1) {
-            copy->meta_data().setInt64(kKeySampleFileOffset, sampleFileOffset);
+        meta_data = new MetaData(buffer->meta_data());
+        MediaBuffer *copy;
+        int32_t holdUntilWritten;
+        if (sampleFileOffset == -1
+                && buffer->meta_data().findInt32(kKeyHoldUntilWritten, &holdUntilWritten)
+                && holdUntilWritten) {
+            // The source lets us keep its buffer until the sample is written
+            // (MediaMuxer::writeSampleDataNoCopy), so skip the copy.
+            copy = static_cast<MediaBuffer *>(buffer);
         } else {
-            memcpy(copy->data(), (uint8_t*)buffer->data() + buffer->range_offset(),
-                   buffer->range_length());
+            // Make a deep copy of the MediaBuffer and Metadata and release
+            // the original as soon as we can
+            copy = new MediaBuffer(buffer->range_length());
+            if (sampleFileOffset != -1) {
+                copy->meta_data().setInt64(kKeySampleFileOffset, sampleFileOffset);
+            } else {
+                memcpy(copy->data(), (uint8_t*)buffer->data() + buffer->range_offset(),
+                       buffer->range_length());
+            }
+            copy->set_range(0, buffer->range_length());
+            buffer->release();
         }
-        copy->set_range(0, buffer->range_length());
-
-        meta_data = new MetaData(buffer->meta_data());
-        buffer->release();
         buffer = NULL;
         if (isExif) {
             copy->meta_data().setInt32(kKeyExifTiffOffset, tiffHdrOffset);
@@ -4090,7 +4375,7 @@ status_t MPEG4Writer::Track::threadEntry() {
                 trackProgressStatus(timestampUs);
             }
         }
-        if (!hasMultipleTracks) {
+        if (!hasMultipleTracks && !mOwner->isFragmented()) {
             size_t bytesWritten;
             off64_t offset = mOwner->addSample_l(
                     copy, usePrefix, tiffHdrOffset, &bytesWritten);
@@ -4107,6 +4392,14 @@ status_t MPEG4Writer::Track::threadEntry() {
             continue;
         }
 
+        if (mOwner->isFragmented()) {
+            // Keep the timing of the sample for the movie fragment it goes in.
+            copy->meta_data().setInt64(kKeyDecodingTime, timestampUs);
+            copy->meta_data().setInt64(kKeyTime, mIsVideo ?
+                    timestampUs + cttsOffsetTimeUs - kMaxCttsOffsetTimeUs : timestampUs);
+            copy->meta_data().setInt32(kKeyIsSyncFrame, !mIsVideo || isSync);
+        }
+
         mChunkSamples.push_back(copy);
         if (mIsHeif) {
             bufferChunk(0 /*timestampUs*/);
@@ -4467,7 +4760,9 @@ void MPEG4Writer::Track::writeTrackHeader() {
     uint32_t now = getMpeg4Time();
     mOwner->beginBox("trak");
         writeTkhdBox(now);
-        writeEdtsBox();
+        if (!mOwner->isFragmented()) {
+            writeEdtsBox();
+        }
         mOwner->beginBox("mdia");
             writeMdhdBox(now);
             writeHdlrBox();
@@ -4486,6 +4781,65 @@ void MPEG4Writer::Track::writeTrackHeader() {
     mOwner->endBox();  // trak
 }
 
+void MPEG4Writer::Track::writeTrafBox(const std::vector<MediaBuffer *> &samples,
+        const std::vector<uint32_t> &sampleSizes, uint32_t dataOffset,
+        int64_t movieStartTimeUs) {
+    CHECK(!samples.empty());
+    CHECK_EQ(samples.size(), sampleSizes.size());
+
+    // Sample times are relative to the start of the track, while the decode
+    // times of the fragments are relative to the start of the movie.
+    int64_t trackStartTimeOffsetUs = mStartTimestampUs - movieStartTimeUs;
+    std::vector<int64_t> decodingTimeTicks(samples.size());
+    for (size_t i = 0; i < samples.size(); ++i) {
+        int64_t decodingTimeUs;
+        CHECK(samples[i]->meta_data().findInt64(kKeyDecodingTime, &decodingTimeUs));
+        decodingTimeTicks[i] =
+            ((trackStartTimeOffsetUs + decodingTimeUs) * mTimeScale + 500000LL) / 1000000LL;
+    }
+
+    mOwner->beginBox("traf");
+    mOwner->beginBox("tfhd");
+    mOwner->writeInt32(0x020000);      // version=0, flags=default-base-is-moof
+    mOwner->writeInt32(mTrackId.getId());
+    mOwner->endBox();  // tfhd
+
+    mOwner->beginBox("tfdt");
+    mOwner->writeInt32(1 << 24);       // version=1, flags=0
+    mOwner->writeInt64(decodingTimeTicks[0]);
+    mOwner->endBox();  // tfdt
+
+    mOwner->beginBox("trun");
+    // version=1 for signed composition time offsets, flags=data offset, sample
+    // duration, sample size, sample flags and sample composition time offset present
+    mOwner->writeInt32((1 << 24) | 0x000f01);
+    mOwner->writeInt32(samples.size());
+    mOwner->writeInt32(dataOffset);
+    for (size_t i = 0; i < samples.size(); ++i) {
+        // The duration of the last sample is not known until the next one comes,
+        // so it is assumed to be that of the sample before it. The decode time of
+        // the next fragment corrects any difference.
+        if (i + 1 < samples.size()) {
+            mLastFragmentSampleDurationTicks = decodingTimeTicks[i + 1] - decodingTimeTicks[i];
+        }
+        int64_t timeUs;
+        CHECK(samples[i]->meta_data().findInt64(kKeyTime, &timeUs));
+        int64_t timeTicks =
+            ((trackStartTimeOffsetUs + timeUs) * mTimeScale + 500000LL) / 1000000LL;
+        int32_t isSync = false;
+        samples[i]->meta_data().findInt32(kKeyIsSyncFrame, &isSync);
+
+        mOwner->writeInt32(mLastFragmentSampleDurationTicks);
+        mOwner->writeInt32(sampleSizes[i]);
+        // sample_depends_on=2 for sync samples, sample_depends_on=1 and
+        // sample_is_non_sync_sample=1 for the others.
+        mOwner->writeInt32(isSync ? 0x02000000 : 0x01010000);
+        mOwner->writeInt32(timeTicks - decodingTimeTicks[i]);
+    }
+    mOwner->endBox();  // trun
+    mOwner->endBox();  // traf
+}
+
 int64_t MPEG4Writer::Track::getMinCttsOffsetTimeUs() {
     // For video tracks with ctts table, this should return the minimum ctts
     // offset in the table. For non-video tracks or video tracks without ctts
@@ -4511,14 +4865,35 @@ void MPEG4Writer::Track::writeStblBox() {
             writeMetadataFourCCBox();
         }
         mOwner->endBox();  // stsd
-        writeSttsBox();
-        if (mIsVideo) {
-            writeCttsBox();
-            writeStssBox();
+        if (mOwner->isFragmented()) {
+            // The samples are all in movie fragments.
+            mOwner->beginBox("stts");
+            mOwner->writeInt32(0);  // version=0, flags=0
+            mOwner->writeInt32(0);  // entry count
+            mOwner->endBox();  // stts
+            mOwner->beginBox("stsz");
+            mOwner->writeInt32(0);  // version=0, flags=0
+            mOwner->writeInt32(0);  // sample size
+            mOwner->writeInt32(0);  // sample count
+            mOwner->endBox();  // stsz
+            mOwner->beginBox("stsc");
+            mOwner->writeInt32(0);  // version=0, flags=0
+            mOwner->writeInt32(0);  // entry count
+            mOwner->endBox();  // stsc
+            mOwner->beginBox("stco");
+            mOwner->writeInt32(0);  // version=0, flags=0
+            mOwner->writeInt32(0);  // entry count
+            mOwner->endBox();  // stco
+        } else {
+            writeSttsBox();
+            if (mIsVideo) {
+                writeCttsBox();
+                writeStssBox();
+            }
+            writeStszBox();
+            writeStscBox();
+            writeCo64Box();
         }
-        writeStszBox();
-        writeStscBox();
-        writeCo64Box();
     }
     mOwner->endBox();  // stbl
 }
@@ -4899,7 +5274,8 @@ void MPEG4Writer::Track::writeTkhdBox(uint32_t now) {
     mOwner->writeInt32(now);           // modification time
     mOwner->writeInt32(mTrackId.getId()); // track id starts with 1
     mOwner->writeInt32(0);             // reserved
-    int64_t trakDurationUs = getDurationUs();
+    // The duration of a fragmented track is that of its movie fragments.
+    int64_t trakDurationUs = mOwner->isFragmented() ? 0 : getDurationUs();
     int32_t mvhdTimeScale = mOwner->getTimeScale();
     int32_t tkhdDuration =
         (trakDurationUs * mvhdTimeScale + 5E5) / 1E6;
@@ -5102,7 +5478,7 @@ void MPEG4Writer::Track::writeEdtsBox() {
 }
 
 void MPEG4Writer::Track::writeMdhdBox(uint32_t now) {
-    int64_t trakDurationUs = getDurationUs();
+    int64_t trakDurationUs = mOwner->isFragmented() ? 0 : getDurationUs();
     int64_t mdhdDuration = (trakDurationUs * mTimeScale + 5E5) / 1E6;
     mOwner->beginBox("mdhd");
 
@@ -5421,6 +5797,33 @@ void MPEG4Writer::writeIlst() {
     endBox(); // ilst
 }
 
+void MPEG4Writer::writeFragmentedMoovBox() {
+    beginBox("moov");
+    writeMvhdBox(0);
+    if (mAreGeoTagsAvailable) {
+        writeUdtaBox();
+    }
+    writeMoovLevelMetaBox();
+    for (List<Track *>::iterator it = mTracks.begin();
+        it != mTracks.end(); ++it) {
+        (*it)->writeTrackHeader();
+    }
+    beginBox("mvex");
+    for (List<Track *>::iterator it = mTracks.begin();
+        it != mTracks.end(); ++it) {
+        beginBox("trex");
+        writeInt32(0);             // version=0, flags=0
+        writeInt32((*it)->getTrackId().getId());
+        writeInt32(1);             // default sample description index
+        writeInt32(0);             // default sample duration
+        writeInt32(0);             // default sample size
+        writeInt32(0);             // default sample flags
+        endBox();  // trex
+    }
+    endBox();  // mvex
+    endBox();  // moov
+}
+
 void MPEG4Writer::writeMoovLevelMetaBox() {
     size_t count = mMetaKeys->countEntries();
     if (count == 0) {
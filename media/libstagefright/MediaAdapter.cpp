@@ -58,6 +58,7 @@ status_t MediaAdapter::stop() {
 
             // While read() is still waiting, we should signal it to finish.
             mBufferReadCond.signal();
+            mBufferTakenCond.signal();
         }
     }
     if (currentBuffer != NULL) {
@@ -73,12 +74,26 @@ sp<MetaData> MediaAdapter::getFormat() {
 }
 
 void MediaAdapter::signalBufferReturned(MediaBufferBase *buffer) {
-    Mutex::Autolock autoLock(mAdapterLock);
-    CHECK(buffer != NULL);
-    buffer->setObserver(0);
-    buffer->release();
-    ALOGV("buffer returned %p", buffer);
-    mBufferReturnedCond.signal();
+    std::function<void()> onReleased;
+    {
+        Mutex::Autolock autoLock(mAdapterLock);
+        CHECK(buffer != NULL);
+        auto it = mReleaseCallbacks.find(buffer);
+        if (it != mReleaseCallbacks.end()) {
+            onReleased = std::move(it->second);
+            mReleaseCallbacks.erase(it);
+        }
+        buffer->setObserver(0);
+        buffer->release();
+        ALOGV("buffer returned %p", buffer);
+        if (!onReleased) {
+            mBufferReturnedCond.signal();
+        }
+    }
+    // Notify the client without the lock, it may push the next buffer.
+    if (onReleased) {
+        onReleased();
+    }
 }
 
 status_t MediaAdapter::read(
@@ -104,6 +119,7 @@ status_t MediaAdapter::read(
 
     *buffer = mCurrentMediaBuffer;
     mCurrentMediaBuffer = NULL;
+    mBufferTakenCond.signal();
 
     return OK;
 }
@@ -136,5 +152,33 @@ status_t MediaAdapter::pushBuffer(MediaBuffer *buffer) {
     return OK;
 }
 
+status_t MediaAdapter::pushBuffer(
+        MediaBuffer *buffer, const std::function<void()> &onReleased) {
+    if (buffer == NULL) {
+        ALOGE("pushBuffer get an NULL buffer");
+        return -EINVAL;
+    }
+
+    std::unique_lock<std::mutex> lk(mBufferGatingMutex);
+
+    Mutex::Autolock autoLock(mAdapterLock);
+    if (!mStarted) {
+        ALOGE("pushBuffer called before start");
+        return INVALID_OPERATION;
+    }
+    mReleaseCallbacks[buffer] = onReleased;
+    mCurrentMediaBuffer = buffer;
+    mCurrentMediaBuffer->setObserver(this);
+    mBufferReadCond.signal();
+
+    // stop() releases a buffer that was never read, which runs onReleased.
+    ALOGV("wait for the buffer taken @ pushBuffer! %p", buffer);
+    while (mCurrentMediaBuffer == buffer && mStarted) {
+        mBufferTakenCond.wait(mAdapterLock);
+    }
+
+    return OK;
+}
+
 }  // namespace android
 
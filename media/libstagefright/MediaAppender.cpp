@@ -422,6 +422,14 @@ status_t MediaAppender::writeSampleData(const sp<ABuffer>& buffer, size_t trackI
     return mMuxer->writeSampleData(buffer, trackIndex, timeUs, flags);
 }
 
+status_t MediaAppender::writeSampleDataNoCopy(const sp<ABuffer>& buffer, size_t trackIndex,
+                                              int64_t timeUs, uint32_t flags,
+                                              const std::function<void()> &onReleased) {
+    std::scoped_lock lock(mMutex);
+    ALOGV("writeSampleDataNoCopy:trackIndex:%zu, time:%" PRId64 "", trackIndex, timeUs);
+    return mMuxer->writeSampleDataNoCopy(buffer, trackIndex, timeUs, flags, onReleased);
+}
+
 status_t MediaAppender::setOrientationHint([[maybe_unused]] int degrees) {
     ALOGE("setOrientationHint not supported. Has to be called prior to start on initial muxer");
     return ERROR_UNSUPPORTED;
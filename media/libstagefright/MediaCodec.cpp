@@ -19,12 +19,18 @@
 #define LOG_TAG "MediaCodec"
 #include <utils/Log.h>
 
+#include <algorithm>
+#include <deque>
 #include <dlfcn.h>
 #include <inttypes.h>
+#include <map>
+#include <mutex>
 #include <random>
 #include <set>
 #include <stdlib.h>
 #include <string>
+#include <thread>
+#include <unistd.h>
 
 #include <C2Buffer.h>
 
@@ -64,6 +70,7 @@
 #include <media/stagefright/foundation/AMessage.h>
 #include <media/stagefright/foundation/AString.h>
 #include <media/stagefright/foundation/AUtils.h>
+#include <media/stagefright/foundation/MediaTrace.h>
 #include <media/stagefright/foundation/avc_utils.h>
 #include <media/stagefright/foundation/hexdump.h>
 #include <media/stagefright/ACodec.h>
@@ -158,9 +165,19 @@ static const char *kCodecLatencyAvg = "android.media.mediacodec.latency.avg";
 static const char *kCodecLatencyCount = "android.media.mediacodec.latency.n";
 static const char *kCodecLatencyHist = "android.media.mediacodec.latency.hist"; /* in us */
 static const char *kCodecLatencyUnknown = "android.media.mediacodec.latency.unknown";
+// per stage latencies, as android.media.mediacodec.latency.<stage>.avg etc, in us
+static const char *kCodecLatencyPrefix = "android.media.mediacodec.latency.";
+static const char *kCodecLatencyStageNames[] = {"queue", "codec", "dispatch", "client"};
 static const char *kCodecQueueSecureInputBufferError = "android.media.mediacodec.queueSecureInputBufferError";
 static const char *kCodecQueueInputBufferError = "android.media.mediacodec.queueInputBufferError";
 static const char *kCodecComponentColorFormat = "android.media.mediacodec.component-color-format";
+// asynchronous decryption (CONFIGURE_FLAG_USE_CRYPTO_ASYNC)
+static const char *kCodecCryptoAsyncCount = "android.media.mediacodec.crypto-async.n";
+static const char *kCodecCryptoAsyncDecryptAvg = "android.media.mediacodec.crypto-async.decrypt.avg"; /* in us */
+static const char *kCodecCryptoAsyncDecryptMax = "android.media.mediacodec.crypto-async.decrypt.max"; /* in us */
+static const char *kCodecCryptoAsyncLatencyAvg = "android.media.mediacodec.crypto-async.latency.avg"; /* in us */
+static const char *kCodecCryptoAsyncLatencyMax = "android.media.mediacodec.crypto-async.latency.max"; /* in us */
+static const char *kCodecCryptoAsyncPendingMax = "android.media.mediacodec.crypto-async.pending.max";
 
 static const char *kCodecNumLowLatencyModeOn = "android.media.mediacodec.low-latency.on";  /* 0..n */
 static const char *kCodecNumLowLatencyModeOff = "android.media.mediacodec.low-latency.off";  /* 0..n */
@@ -202,6 +219,8 @@ static const char *kCodecRecentLatencyMin = "android.media.mediacodec.recent.min
 static const char *kCodecRecentLatencyAvg = "android.media.mediacodec.recent.avg";      /* in us */
 static const char *kCodecRecentLatencyCount = "android.media.mediacodec.recent.n";
 static const char *kCodecRecentLatencyHist = "android.media.mediacodec.recent.hist";    /* in us */
+// per stage, as android.media.mediacodec.recent.<stage>.avg etc, in us
+static const char *kCodecRecentLatencyPrefix = "android.media.mediacodec.recent.";
 
 /* -1: shaper disabled
    >=0: number of fields changed */
@@ -604,7 +623,8 @@ void MediaCodec::ResourceManagerServiceProxy::notifyClientConfigChanged(
 
 ////////////////////////////////////////////////////////////////////////////////
 
-MediaCodec::BufferInfo::BufferInfo() : mOwnedByClient(false) {}
+MediaCodec::BufferInfo::BufferInfo()
+    : mOwnedByClient(false), mAvailableNs(0), mDispatchedNs(0), mLatencySlot(-1) {}
 
 ////////////////////////////////////////////////////////////////////////////////
 
@@ -920,10 +940,177 @@ static const char * toCodecMode(MediaCodec::Domain domain) {
     }
 }
 
+// Gets the capacity advertised by the codec for the media type: the largest
+// performance point in macroblocks per second, and the max concurrent instances.
+// Values that aren't advertised are set to 0.
+static void getAdvertisedCapacity(const sp<MediaCodecInfo> &codecInfo, const AString &mediaType,
+        int64_t *maxMacroblocksPerSecond, int32_t *maxConcurrentInstances) {
+    *maxMacroblocksPerSecond = 0;
+    *maxConcurrentInstances = 0;
+    const sp<MediaCodecInfo::Capabilities> caps = codecInfo->getCapabilitiesFor(mediaType.c_str());
+    if (caps == nullptr) {
+        return;
+    }
+    const sp<AMessage> details = caps->getDetails();
+    AString value;
+    if (details->findString("max-concurrent-instances", &value)) {
+        *maxConcurrentInstances = std::max(atoi(value.c_str()), 0);
+    }
+    for (size_t i = 0; i < details->countEntries(); ++i) {
+        AMessage::Type type;
+        const char *name = details->getEntryNameAt(i, &type);
+        int32_t width = 0, height = 0, minRate = 0, maxRate = 0;
+        // e.g. "performance-point-1920x1080-range" = "30-30"
+        if (type != AMessage::kTypeString
+                || sscanf(name, "performance-point-%dx%d-range", &width, &height) != 2
+                || !details->findString(name, &value)
+                || sscanf(value.c_str(), "%d-%d", &minRate, &maxRate) != 2
+                || width <= 0 || height <= 0 || maxRate <= 0) {
+            continue;
+        }
+        const int64_t macroblocksPerSecond =
+                ((width + 15) / 16) * (int64_t)((height + 15) / 16) * maxRate;
+        *maxMacroblocksPerSecond = std::max(*maxMacroblocksPerSecond, macroblocksPerSecond);
+    }
+}
+
 }  // namespace
 
 ////////////////////////////////////////////////////////////////////////////////
 
+// Idle codecs created ahead of time, so that CreateByType() does not pay for the component
+// allocation at playback start. The pool is configured by the global settings of the codec
+// list (the <Settings> of media_codecs.xml):
+//   warm-pool-size            idle codecs kept per component, 0 (the default) disables the pool
+//   warm-pool-decoder-types   comma separated media types whose preferred decoder is kept
+//   warm-pool-encoder-types   same for encoders
+//
+// The pooled codecs are regular clients of the resource manager in this process. They count
+// against its resources, are allocated without reclaiming other clients, and can be reclaimed
+// while they are idle, in which case the pool drops them. A codec handed out keeps running on
+// the looper it was created on, and is only handed to callers acting for this process.
+struct MediaCodec::WarmPool {
+    static WarmPool &Get() {
+        static WarmPool sPool;
+        return sPool;
+    }
+
+    // Returns an idle codec for the component, or NULL. The pool is refilled asynchronously.
+    sp<MediaCodec> take(const AString &name, pid_t pid, uid_t uid) {
+        if (mSize == 0
+                || (pid != kNoPid && pid != getpid())
+                || (uid != kNoUid && uid != getuid())) {
+            return nullptr;
+        }
+        sp<MediaCodec> codec;
+        {
+            std::lock_guard<std::mutex> lock(mLock);
+            auto it = mIdle.find(name.c_str());
+            if (it == mIdle.end()) {
+                return nullptr;
+            }
+            std::deque<sp<MediaCodec>> &idle = it->second;
+            while (!idle.empty() && codec == nullptr) {
+                codec = idle.front();
+                idle.pop_front();
+                if (codec->mReleasedByResourceManager) {
+                    codec.clear();
+                }
+            }
+        }
+        refill(name.c_str());
+        return codec;
+    }
+
+private:
+    WarmPool() : mSize(0) {
+        const sp<IMediaCodecList> mcl = MediaCodecList::getInstance();
+        if (mcl == nullptr) {
+            return;
+        }
+        const sp<AMessage> settings = mcl->getGlobalSettings();
+        AString value;
+        if (settings == nullptr || !settings->findString("warm-pool-size", &value)) {
+            return;
+        }
+        mSize = std::max(0, atoi(value.c_str()));
+        if (mSize == 0) {
+            return;
+        }
+        for (bool encoder : { false, true }) {
+            if (!settings->findString(
+                    encoder ? "warm-pool-encoder-types" : "warm-pool-decoder-types", &value)) {
+                continue;
+            }
+            std::string types = value.c_str();
+            for (size_t start = 0; start < types.size(); ) {
+                size_t end = types.find(',', start);
+                if (end == std::string::npos) {
+                    end = types.size();
+                }
+                const std::string mime = types.substr(start, end - start);
+                start = end + 1;
+                Vector<AString> matchingCodecs;
+                MediaCodecList::findMatchingCodecs(
+                        mime.c_str(), encoder, 0, nullptr /* format */, &matchingCodecs);
+                if (matchingCodecs.empty()) {
+                    ALOGW("no %s for warm pool type '%s'",
+                            encoder ? "encoder" : "decoder", mime.c_str());
+                    continue;
+                }
+                mIdle[matchingCodecs[0].c_str()];
+            }
+        }
+        for (const auto &[name, idle] : mIdle) {
+            refill(name);
+        }
+    }
+
+    // Tops the pool of a component up on a thread of its own, so that the pools of different
+    // components are filled in parallel, and never block the caller.
+    void refill(const std::string &name) {
+        {
+            std::lock_guard<std::mutex> lock(mLock);
+            if (mRefilling.count(name) != 0 || mIdle[name].size() >= mSize) {
+                return;
+            }
+            mRefilling.insert(name);
+        }
+        std::thread([this, name] {
+            for (;;) {
+                {
+                    std::lock_guard<std::mutex> lock(mLock);
+                    if (mIdle[name].size() >= mSize) {
+                        break;
+                    }
+                }
+                sp<ALooper> looper = new ALooper;
+                looper->setName("CodecWarmPool");
+                if (looper->start(false, false, ANDROID_PRIORITY_AUDIO) != OK) {
+                    break;
+                }
+                sp<MediaCodec> codec = new MediaCodec(looper, kNoPid, kNoUid);
+                status_t err = codec->init(name.c_str(), true /* nameIsType */,
+                        false /* reclaim */);
+                if (err != OK) {
+                    // most likely out of resources, try again at the next take()
+                    ALOGD("warm pool cannot allocate '%s' (%d)", name.c_str(), err);
+                    break;
+                }
+                std::lock_guard<std::mutex> lock(mLock);
+                mIdle[name].push_back(codec);
+            }
+            std::lock_guard<std::mutex> lock(mLock);
+            mRefilling.erase(name);
+        }).detach();
+    }
+
+    size_t mSize;
+    std::mutex mLock;
+    std::map<std::string, std::deque<sp<MediaCodec>>> mIdle;    // by component name
+    std::set<std::string> mRefilling;
+};
+
 // static
 sp<MediaCodec> MediaCodec::CreateByType(
         const sp<ALooper> &looper, const AString &mime, bool encoder, status_t *err, pid_t pid,
@@ -947,6 +1134,15 @@ sp<MediaCodec> MediaCodec::CreateByType(
     if (err != NULL) {
         *err = NAME_NOT_FOUND;
     }
+    if (!matchingCodecs.empty()) {
+        sp<MediaCodec> codec = WarmPool::Get().take(matchingCodecs[0], pid, uid);
+        if (codec != nullptr) {
+            if (err != NULL) {
+                *err = OK;
+            }
+            return codec;
+        }
+    }
     for (size_t i = 0; i < matchingCodecs.size(); ++i) {
         sp<MediaCodec> codec = new MediaCodec(looper, pid, uid);
         AString componentName = matchingCodecs[i];
@@ -1035,6 +1231,9 @@ MediaCodec::MediaCodec(
       mDomain(DOMAIN_UNKNOWN),
       mWidth(0),
       mHeight(0),
+      mFrameRate(0),
+      mMaxMacroblocksPerSecond(0),
+      mMaxConcurrentInstances(0),
       mRotationDegrees(0),
       mDequeueInputTimeoutGeneration(0),
       mDequeueInputReplyID(0),
@@ -1130,12 +1329,20 @@ void MediaCodec::initMediametrics() {
         Mutex::Autolock al(mRecentLock);
         for (int i = 0; i<kRecentLatencyFrames; i++) {
             mRecentSamples[i] = kRecentSampleInvalid;
+            mRecentStages[i].presentationUs = kRecentSampleInvalid;
+            for (int64_t &stageUs : mRecentStages[i].stageUs) {
+                stageUs = kRecentSampleInvalid;
+            }
         }
         mRecentHead = 0;
+        mRecentStagesHead = 0;
     }
 
     {
         Mutex::Autolock al(mLatencyLock);
+        for (MediaHistogram<int64_t> &hist : mStageLatencyHist) {
+            hist.setup(kLatencyHistBuckets, kLatencyHistWidth, kLatencyHistFloor);
+        }
         mBuffersInFlight.clear();
         mNumLowLatencyEnables = 0;
         mNumLowLatencyDisables = 0;
@@ -1236,6 +1443,23 @@ void MediaCodec::updateMediametrics() {
         }
     }
 
+    if (sp<CryptoAsync> cryptoAsync = mCryptoAsync; cryptoAsync != nullptr) {
+        const CryptoAsync::Stats stats = cryptoAsync->getStats();
+        if (stats.mCount > 0) {
+            mediametrics_setInt64(mMetricsHandle, kCodecCryptoAsyncCount, stats.mCount);
+            mediametrics_setInt64(mMetricsHandle, kCodecCryptoAsyncDecryptAvg,
+                    stats.mDecryptSumUs / stats.mCount);
+            mediametrics_setInt64(mMetricsHandle, kCodecCryptoAsyncDecryptMax,
+                    stats.mDecryptMaxUs);
+            mediametrics_setInt64(mMetricsHandle, kCodecCryptoAsyncLatencyAvg,
+                    stats.mLatencySumUs / stats.mCount);
+            mediametrics_setInt64(mMetricsHandle, kCodecCryptoAsyncLatencyMax,
+                    stats.mLatencyMaxUs);
+            mediametrics_setInt64(mMetricsHandle, kCodecCryptoAsyncPendingMax,
+                    stats.mMaxPending);
+        }
+    }
+
     if (mLatencyHist.getCount() != 0 ) {
         mediametrics_setInt64(mMetricsHandle, kCodecLatencyMax, mLatencyHist.getMax());
         mediametrics_setInt64(mMetricsHandle, kCodecLatencyMin, mLatencyHist.getMin());
@@ -1248,6 +1472,24 @@ void MediaCodec::updateMediametrics() {
             mediametrics_setCString(mMetricsHandle, kCodecLatencyHist, hist.c_str());
         }
     }
+    {
+        Mutex::Autolock al(mLatencyLock);
+        for (int stage = 0; stage < kLatencyStageCount; ++stage) {
+            const MediaHistogram<int64_t> &hist = mStageLatencyHist[stage];
+            if (hist.getCount() == 0) {
+                continue;
+            }
+            const std::string key =
+                    std::string(kCodecLatencyPrefix) + kCodecLatencyStageNames[stage];
+            mediametrics_setInt64(mMetricsHandle, (key + ".max").c_str(), hist.getMax());
+            mediametrics_setInt64(mMetricsHandle, (key + ".avg").c_str(), hist.getAvg());
+            mediametrics_setInt64(mMetricsHandle, (key + ".n").c_str(), hist.getCount());
+            if (kEmitHistogram) {
+                mediametrics_setCString(mMetricsHandle, (key + ".hist").c_str(),
+                        hist.emit().c_str());
+            }
+        }
+    }
     if (mLatencyUnknown > 0) {
         mediametrics_setInt64(mMetricsHandle, kCodecLatencyUnknown, mLatencyUnknown);
     }
@@ -1445,6 +1687,10 @@ void MediaCodec::updateEphemeralMediametrics(mediametrics_handle_t item) {
     // build an empty histogram
     MediaHistogram<int64_t> recentHist;
     recentHist.setup(kLatencyHistBuckets, kLatencyHistWidth, kLatencyHistFloor);
+    MediaHistogram<int64_t> recentStageHist[kLatencyStageCount];
+    for (MediaHistogram<int64_t> &hist : recentStageHist) {
+        hist.setup(kLatencyHistBuckets, kLatencyHistWidth, kLatencyHistFloor);
+    }
 
     // stuff it with the samples in the ring buffer
     {
@@ -1454,6 +1700,26 @@ void MediaCodec::updateEphemeralMediametrics(mediametrics_handle_t item) {
             if (mRecentSamples[i] != kRecentSampleInvalid) {
                 recentHist.insert(mRecentSamples[i]);
             }
+            for (int stage = 0; stage < kLatencyStageCount; ++stage) {
+                if (mRecentStages[i].stageUs[stage] != kRecentSampleInvalid) {
+                    recentStageHist[stage].insert(mRecentStages[i].stageUs[stage]);
+                }
+            }
+        }
+    }
+
+    for (int stage = 0; stage < kLatencyStageCount; ++stage) {
+        const MediaHistogram<int64_t> &hist = recentStageHist[stage];
+        if (hist.getCount() == 0) {
+            continue;
+        }
+        const std::string key =
+                std::string(kCodecRecentLatencyPrefix) + kCodecLatencyStageNames[stage];
+        mediametrics_setInt64(item, (key + ".max").c_str(), hist.getMax());
+        mediametrics_setInt64(item, (key + ".avg").c_str(), hist.getAvg());
+        mediametrics_setInt64(item, (key + ".n").c_str(), hist.getCount());
+        if (kEmitHistogram) {
+            mediametrics_setCString(item, (key + ".hist").c_str(), hist.emit().c_str());
         }
     }
 
@@ -1529,6 +1795,8 @@ void MediaCodec::flushMediametrics() {
     // ensure mutex while we do our own work
     Mutex::Autolock _lock(mMetricsLock);
     if (mMetricsHandle != 0) {
+        // let the format shaper learn from the session it shaped
+        reportShapedEncoding(mMetricsHandle);
         if (mMetricsToUpload && mediametrics_count(mMetricsHandle) > 0) {
             mediametrics_selfRecord(mMetricsHandle);
         }
@@ -1666,7 +1934,10 @@ void MediaCodec::processRenderedFrames(const sp<AMessage> &msg) {
 }
 
 // when we send a buffer to the codec;
-void MediaCodec::statsBufferSent(int64_t presentationUs, const sp<MediaCodecBuffer> &buffer) {
+void MediaCodec::statsBufferSent(int64_t presentationUs, const sp<MediaCodecBuffer> &buffer,
+        int64_t queuedNs) {
+
+    MEDIA_TRACE_CODEC("MediaCodec::queueInput", mComponentName.c_str(), presentationUs, -1);
 
     // only enqueue if we have a legitimate time
     if (presentationUs <= 0) {
@@ -1686,7 +1957,7 @@ void MediaCodec::statsBufferSent(int64_t presentationUs, const sp<MediaCodecBuff
     }
 
     const int64_t nowNs = systemTime(SYSTEM_TIME_MONOTONIC);
-    BufferFlightTiming_t startdata = { presentationUs, nowNs };
+    BufferFlightTiming_t startdata = { presentationUs, nowNs, queuedNs };
 
     {
         // mutex access to mBuffersInFlight and other stats
@@ -1705,10 +1976,13 @@ void MediaCodec::statsBufferSent(int64_t presentationUs, const sp<MediaCodecBuff
 }
 
 // when we get a buffer back from the codec
-void MediaCodec::statsBufferReceived(int64_t presentationUs, const sp<MediaCodecBuffer> &buffer) {
+void MediaCodec::statsBufferReceived(int64_t presentationUs, const sp<MediaCodecBuffer> &buffer,
+        size_t index) {
 
     CHECK_NE(mState, UNINITIALIZED);
 
+    MEDIA_TRACE_CODEC("MediaCodec::outputAvailable", mComponentName.c_str(), presentationUs, -1);
+
     if (mDomain == DOMAIN_VIDEO && (mFlags & kFlagIsEncoder)) {
         int32_t flags = 0;
         (void) buffer->meta()->findInt32("flags", &flags);
@@ -1733,6 +2007,12 @@ void MediaCodec::statsBufferReceived(int64_t presentationUs, const sp<MediaCodec
         }
     }
 
+    // the buffer is handed to the client now
+    BufferInfo *info = &mPortBuffers[kPortIndexOutput][index];
+    const int64_t dispatchedNs = systemTime(SYSTEM_TIME_MONOTONIC);
+    info->mDispatchedNs = dispatchedNs;
+    info->mLatencySlot = -1;
+
     // mutex access to mBuffersInFlight and other stats
     Mutex::Autolock al(mLatencyLock);
 
@@ -1802,6 +2082,61 @@ void MediaCodec::statsBufferReceived(int64_t presentationUs, const sp<MediaCodec
             mRecentHead = 0;
         }
         mRecentSamples[mRecentHead++] = latencyUs;
+
+        // and start the stage record of this frame, the client stage comes at release
+        if (mRecentStagesHead >= kRecentLatencyFrames) {
+            mRecentStagesHead = 0;
+        }
+        info->mLatencySlot = mRecentStagesHead++;
+        FrameStageLatency_t &frame = mRecentStages[info->mLatencySlot];
+        frame.presentationUs = presentationUs;
+        for (int64_t &stageUs : frame.stageUs) {
+            stageUs = kRecentSampleInvalid;
+        }
+    }
+
+    const int64_t availableNs = info->mAvailableNs > 0 ? info->mAvailableNs : nowNs;
+    addStageLatency(info->mLatencySlot, kLatencyStageQueue,
+            (startdata.startedNs - startdata.queuedNs + 500) / 1000, presentationUs);
+    addStageLatency(info->mLatencySlot, kLatencyStageCodec,
+            (availableNs - startdata.startedNs + 500) / 1000, presentationUs);
+    addStageLatency(info->mLatencySlot, kLatencyStageDispatch,
+            (dispatchedNs - availableNs + 500) / 1000, presentationUs);
+}
+
+// when the client releases or renders an output buffer
+void MediaCodec::statsBufferReleased(size_t index) {
+    BufferInfo *info = &mPortBuffers[kPortIndexOutput][index];
+    if (info->mDispatchedNs <= 0) {
+        return;
+    }
+    const int64_t latencyUs =
+            (systemTime(SYSTEM_TIME_MONOTONIC) - info->mDispatchedNs + 500) / 1000;
+    info->mDispatchedNs = 0;
+    int64_t presentationUs = kRecentSampleInvalid;
+    if (info->mData != nullptr) {
+        info->mData->meta()->findInt64("timeUs", &presentationUs);
+    }
+
+    Mutex::Autolock al(mLatencyLock);
+    addStageLatency(info->mLatencySlot, kLatencyStageClient, latencyUs, presentationUs);
+    info->mLatencySlot = -1;
+}
+
+// with mLatencyLock held
+void MediaCodec::addStageLatency(int slot, LatencyStage stage, int64_t latencyUs,
+        int64_t presentationUs) {
+    if (latencyUs < 0) {
+        return;
+    }
+    mStageLatencyHist[stage].insert(latencyUs);
+
+    if (slot >= 0) {
+        Mutex::Autolock al(mRecentLock);
+        // the slot may have been reused by a later frame while the client held the buffer
+        if (mRecentStages[slot].presentationUs == presentationUs) {
+            mRecentStages[slot].stageUs[stage] = latencyUs;
+        }
     }
 }
 
@@ -1900,7 +2235,7 @@ static const CodecListCache &GetCodecListCache() {
     return sCache;
 }
 
-status_t MediaCodec::init(const AString &name, bool nameIsType) {
+status_t MediaCodec::init(const AString &name, bool nameIsType, bool reclaim) {
     status_t err = mResourceManagerProxy->init();
     if (err != OK) {
         mErrorLog.log(LOG_TAG, base::StringPrintf(
@@ -2023,7 +2358,7 @@ status_t MediaCodec::init(const AString &name, bool nameIsType) {
     for (int i = 0; i <= kMaxRetry; ++i) {
         if (i > 0) {
             // Don't try to reclaim resource for the first time.
-            if (!mResourceManagerProxy->reclaimResource(resources)) {
+            if (!reclaim || !mResourceManagerProxy->reclaimResource(resources)) {
                 break;
             }
         }
@@ -2168,6 +2503,21 @@ status_t MediaCodec::configure(
             return BAD_VALUE;
         }
 
+        // The frame rate and the advertised capacity feed the codec capacity
+        // model of the resource manager.
+        float frameRate = 0;
+        int32_t intFrameRate = 0;
+        if (format->findFloat("frame-rate", &frameRate)) {
+            mFrameRate = static_cast<int32_t>(frameRate);
+        } else if (format->findInt32("frame-rate", &intFrameRate)) {
+            mFrameRate = intFrameRate;
+        }
+        AString mediaType;
+        if (mCodecInfo != nullptr && format->findString("mime", &mediaType)) {
+            getAdvertisedCapacity(mCodecInfo, mediaType,
+                    &mMaxMacroblocksPerSecond, &mMaxConcurrentInstances);
+        }
+
     } else {
         if (nextMetricsHandle != 0) {
             int32_t channelCount;
@@ -2367,7 +2717,8 @@ static bool connectFormatShaper() {
         }
 
         if (sShaperOps != nullptr
-            && sShaperOps->version != android::mediaformatshaper::SHAPER_VERSION_V1) {
+            && sShaperOps->version != android::mediaformatshaper::SHAPER_VERSION_V1
+            && sShaperOps->version != android::mediaformatshaper::SHAPER_VERSION_V2) {
             ALOGW("connectFormatShaper: unhandled version ShaperOps: %d, DISABLED",
                   sShaperOps->version);
             sShaperOps = nullptr;
@@ -2683,6 +3034,49 @@ status_t MediaCodec::shapeMediaFormat(
     return OK;
 }
 
+void MediaCodec::reportShapedEncoding(mediametrics_handle_t handle) {
+    if (!(mFlags & kFlagIsEncoder) || handle == 0) {
+        return;
+    }
+    int32_t shaped = 0;
+    if (!mediametrics_getInt32(handle, kCodecShapingEnhanced, &shaped) || shaped <= 0) {
+        return;
+    }
+
+    std::string mediaType;
+    int32_t width = 0;
+    int32_t height = 0;
+    int32_t bitrate = 0;
+    int64_t bytes = 0;
+    int64_t durationUs = 0;
+    if (!mediametrics_getString(handle, kCodecMime, &mediaType)
+            || !mediametrics_getInt32(handle, kCodecWidth, &width)
+            || !mediametrics_getInt32(handle, kCodecHeight, &height)
+            || !mediametrics_getInt32(handle, kCodecBitrate, &bitrate)
+            || !mediametrics_getInt64(handle, kCodecVideoEncodedBytes, &bytes)
+            || !mediametrics_getInt64(handle, kCodecVideoEncodedDurationUs, &durationUs)
+            || durationUs <= 0) {
+        return;
+    }
+
+    // connected when the format was shaped during configure()
+    if (sShaperOps == nullptr
+            || sShaperOps->version < android::mediaformatshaper::SHAPER_VERSION_V2) {
+        return;
+    }
+    mediaformatshaper::shaperHandle_t shaperHandle =
+            sShaperOps->findShaper(mComponentName.c_str(), mediaType.c_str());
+    if (shaperHandle == nullptr) {
+        return;
+    }
+
+    int64_t achievedBitrate = bytes * 8 * 1000000 / durationUs;
+    ALOGV("reportShapedEncoding: %s %dx%d configured %d achieved %" PRId64 " bps",
+          mComponentName.c_str(), width, height, bitrate, achievedBitrate);
+    (void) sShaperOps->reportEncoding(shaperHandle, width, height, bitrate, achievedBitrate,
+                                      durationUs);
+}
+
 static void mapFormat(AString componentName, const sp<AMessage> &format, const char *kind,
                       bool reverse) {
     AString mediaType;
@@ -3006,6 +3400,7 @@ status_t MediaCodec::queueInputBuffer(
 
     sp<AMessage> msg = new AMessage(kWhatQueueInputBuffer, this);
     msg->setSize("index", index);
+    msg->setInt64("queuedNs", systemTime(SYSTEM_TIME_MONOTONIC));
     msg->setSize("offset", offset);
     msg->setSize("size", size);
     msg->setInt64("timeUs", presentationTimeUs);
@@ -3034,6 +3429,7 @@ status_t MediaCodec::queueSecureInputBuffer(
 
     sp<AMessage> msg = new AMessage(kWhatQueueInputBuffer, this);
     msg->setSize("index", index);
+    msg->setInt64("queuedNs", systemTime(SYSTEM_TIME_MONOTONIC));
     msg->setSize("offset", offset);
     msg->setPointer("subSamples", (void *)subSamples);
     msg->setSize("numSubSamples", numSubSamples);
@@ -3065,6 +3461,7 @@ status_t MediaCodec::queueBuffer(
 
     sp<AMessage> msg = new AMessage(kWhatQueueInputBuffer, this);
     msg->setSize("index", index);
+    msg->setInt64("queuedNs", systemTime(SYSTEM_TIME_MONOTONIC));
     sp<WrapperObject<std::shared_ptr<C2Buffer>>> obj{
         new WrapperObject<std::shared_ptr<C2Buffer>>{buffer}};
     msg->setObject("c2buffer", obj);
@@ -3101,6 +3498,7 @@ status_t MediaCodec::queueEncryptedBuffer(
 
     sp<AMessage> msg = new AMessage(kWhatQueueInputBuffer, this);
     msg->setSize("index", index);
+    msg->setInt64("queuedNs", systemTime(SYSTEM_TIME_MONOTONIC));
     sp<WrapperObject<sp<hardware::HidlMemory>>> memory{
         new WrapperObject<sp<hardware::HidlMemory>>{buffer}};
     msg->setObject("memory", memory);
@@ -3615,7 +4013,7 @@ MediaCodec::DequeueOutputResult MediaCodec::handleDequeueOutputBuffer(
 
         response->setInt32("flags", flags);
 
-        statsBufferReceived(timeUs, buffer);
+        statsBufferReceived(timeUs, buffer, index);
 
         response->postReply(replyID);
         return DequeueOutputResult::kSuccess;
@@ -3631,6 +4029,9 @@ inline void MediaCodec::initClientConfigParcel(ClientConfigParcel& clientConfig)
     clientConfig.isHardware = !MediaCodecList::isSoftwareCodec(mComponentName);
     clientConfig.width = mWidth;
     clientConfig.height = mHeight;
+    clientConfig.frameRate = mFrameRate;
+    clientConfig.maxMacroblocksPerSecond = mMaxMacroblocksPerSecond;
+    clientConfig.maxConcurrentInstances = mMaxConcurrentInstances;
     clientConfig.timeStamp = systemTime(SYSTEM_TIME_MONOTONIC) / 1000LL;
     clientConfig.id = mCodecId;
 }
@@ -4623,8 +5024,7 @@ void MediaCodec::onMessageReceived(const sp<AMessage> &msg) {
 
             mDescrambler = static_cast<IDescrambler *>(descrambler);
             mBufferChannel->setDescrambler(mDescrambler);
-            if ((mFlags & kFlagUseCryptoAsync) &&
-                mCrypto  && (mDomain == DOMAIN_VIDEO)) {
+            if ((mFlags & kFlagUseCryptoAsync) && mCrypto) {
                 // set kFlagUseCryptoAsync but do-not use this for block model
                 // this is to propagate the error in onCryptoError()
                 // TODO (b/274628160): Enable Use of CONFIG_FLAG_USE_CRYPTO_ASYNC
@@ -5734,6 +6134,12 @@ size_t MediaCodec::updateBuffers(
         }
         mPortBuffers[portIndex][index].mData = buffer;
     }
+    if (portIndex == kPortIndexOutput) {
+        BufferInfo *info = &mPortBuffers[portIndex][index];
+        info->mAvailableNs = systemTime(SYSTEM_TIME_MONOTONIC);
+        info->mDispatchedNs = 0;
+        info->mLatencySlot = -1;
+    }
     mAvailPortBuffers[portIndex].push_back(index);
 
     return index;
@@ -6026,7 +6432,11 @@ status_t MediaCodec::onQueueInputBuffer(const sp<AMessage> &msg) {
         info->mOwnedByClient = false;
         info->mData.clear();
 
-        statsBufferSent(timeUs, buffer);
+        int64_t queuedNs;
+        if (!msg->findInt64("queuedNs", &queuedNs)) {
+            queuedNs = systemTime(SYSTEM_TIME_MONOTONIC);
+        }
+        statsBufferSent(timeUs, buffer, queuedNs);
     }
 
     return err;
@@ -6093,6 +6503,8 @@ status_t MediaCodec::onReleaseOutputBuffer(const sp<AMessage> &msg) {
         return -EACCES;
     }
 
+    statsBufferReleased(index);
+
     // synchronization boundary for getBufferAndFormat
     sp<MediaCodecBuffer> buffer;
     {
@@ -6105,6 +6517,7 @@ status_t MediaCodec::onReleaseOutputBuffer(const sp<AMessage> &msg) {
     if (render && buffer->size() != 0) {
         int64_t mediaTimeUs = INT64_MIN;
         buffer->meta()->findInt64("timeUs", &mediaTimeUs);
+        MEDIA_TRACE_RENDER("MediaCodec::renderOutput", mComponentName.c_str(), mediaTimeUs, -1);
 
         bool noRenderTime = false;
         int64_t renderTimeNs = 0;
@@ -6343,7 +6756,7 @@ void MediaCodec::onOutputBufferAvailable() {
 
         msg->setInt32("flags", flags);
 
-        statsBufferReceived(timeUs, buffer);
+        statsBufferReceived(timeUs, buffer, index);
 
         msg->post();
     }
@@ -19,6 +19,7 @@
 #include <utils/Log.h>
 
 #include <binder/IServiceManager.h>
+#include <binder/Parcel.h>
 
 #include <media/IMediaCodecList.h>
 #include <media/IMediaPlayerService.h>
@@ -38,13 +39,18 @@
 #include <media/stagefright/OmxInfoBuilder.h>
 #include <media/stagefright/PersistentSurface.h>
 
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
+#include <unistd.h>
 #include <utils/threads.h>
 
 #include <cutils/properties.h>
 
 #include <algorithm>
 #include <regex>
+#include <string>
 
 #include <stagefright/AVExtensions.h>
 
@@ -82,6 +88,138 @@ bool isProfilingNeeded() {
     return profilingNeeded;
 }
 
+// Serialized codec list written by the media.player service and mapped by the other processes,
+// so that they neither parse the XML files and query the plugins nor fetch every codec info
+// over binder. The fingerprint covers everything the list is built from.
+constexpr const char* kCodecListCache = "/data/misc/media/media_codecs_cache.bin";
+constexpr uint32_t kCodecListCacheMagic = 0x434c434d;   // "MCLC"
+constexpr uint32_t kCodecListCacheVersion = 1;
+
+struct CodecListCacheHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t dataSize;  // of the parcel following the header
+};
+
+std::string getCodecListFingerprint() {
+    std::string fingerprint;
+    char value[PROPERTY_VALUE_MAX];
+    for (const char *key : { "ro.build.fingerprint", "ro.vendor.build.fingerprint",
+                             "debug.stagefright.ccodec", "debug.stagefright.dedupe-codecs" }) {
+        property_get(key, value, "");
+        fingerprint.append(value).append(";");
+    }
+
+    // the codec XML files of every search directory, and the profiling results
+    std::vector<std::string> files = { kProfilingResults };
+    std::vector<std::string> dirs = MediaCodecsXmlParser::getDefaultSearchDirs();
+    dirs.push_back("/apex/com.android.media.swcodec/etc");
+    for (const std::string &dir : dirs) {
+        DIR *d = opendir(dir.c_str());
+        if (d == nullptr) {
+            continue;
+        }
+        std::vector<std::string> names;
+        struct dirent *entry;
+        while ((entry = readdir(d)) != nullptr) {
+            const std::string name = entry->d_name;
+            if (name.compare(0, 12, "media_codecs") == 0
+                    && name.size() > 4 && name.compare(name.size() - 4, 4, ".xml") == 0) {
+                names.push_back(dir + "/" + name);
+            }
+        }
+        closedir(d);
+        std::sort(names.begin(), names.end());
+        files.insert(files.end(), names.begin(), names.end());
+    }
+    for (const std::string &file : files) {
+        struct stat st;
+        if (stat(file.c_str(), &st) == 0) {
+            fingerprint.append(file).append(":")
+                    .append(std::to_string(st.st_size)).append(":")
+                    .append(std::to_string(st.st_mtim.tv_sec)).append(".")
+                    .append(std::to_string(st.st_mtim.tv_nsec)).append(";");
+        }
+    }
+    return fingerprint;
+}
+
+void writeCodecListCache(
+        const sp<AMessage> &globalSettings, const std::vector<sp<MediaCodecInfo>> &infos) {
+    Parcel parcel;
+    parcel.writeCString(getCodecListFingerprint().c_str());
+    globalSettings->writeToParcel(&parcel);
+    parcel.writeUint32(infos.size());
+    for (const sp<MediaCodecInfo> &info : infos) {
+        info->writeToParcel(&parcel);
+    }
+    const CodecListCacheHeader header = {
+        kCodecListCacheMagic, kCodecListCacheVersion, static_cast<uint32_t>(parcel.dataSize()) };
+
+    // write aside and rename, so that readers never map a partial file
+    const std::string tmp = std::string(kCodecListCache) + ".tmp";
+    int fd = open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        ALOGV("cannot create codec list cache: %s", strerror(errno));
+        return;
+    }
+    const bool written = write(fd, &header, sizeof(header)) == sizeof(header)
+            && write(fd, parcel.data(), parcel.dataSize()) == (ssize_t)parcel.dataSize();
+    close(fd);
+    if (!written || rename(tmp.c_str(), kCodecListCache) != 0) {
+        ALOGW("failed to write codec list cache");
+        unlink(tmp.c_str());
+    }
+}
+
+// Returns false if there is no cache or if it is stale or invalid.
+bool readCodecListCache(sp<AMessage> *globalSettings, std::vector<sp<MediaCodecInfo>> *infos) {
+    int fd = open(kCodecListCache, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    void *map = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && (size_t)st.st_size > sizeof(CodecListCacheHeader)) {
+        map = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    close(fd);
+    if (map == MAP_FAILED) {
+        return false;
+    }
+
+    bool valid = false;
+    const CodecListCacheHeader *header = static_cast<const CodecListCacheHeader *>(map);
+    if (header->magic == kCodecListCacheMagic
+            && header->version == kCodecListCacheVersion
+            && (off_t)(sizeof(CodecListCacheHeader) + header->dataSize) == st.st_size) {
+        Parcel parcel;
+        parcel.setData(static_cast<const uint8_t *>(map) + sizeof(CodecListCacheHeader),
+                       header->dataSize);
+        const char *fingerprint = parcel.readCString();
+        if (fingerprint != nullptr && getCodecListFingerprint() == fingerprint) {
+            *globalSettings = AMessage::FromParcel(parcel);
+            const uint32_t count = parcel.readUint32();
+            infos->clear();
+            for (uint32_t i = 0; i < count && parcel.dataAvail() > 0; ++i) {
+                sp<MediaCodecInfo> info = MediaCodecInfo::FromParcel(parcel);
+                if (info == nullptr) {
+                    break;
+                }
+                infos->push_back(info);
+            }
+            valid = *globalSettings != nullptr && infos->size() == count
+                    && parcel.dataAvail() == 0;
+        }
+    }
+    munmap(map, st.st_size);
+    if (!valid) {
+        ALOGD("ignoring stale or invalid codec list cache");
+        infos->clear();
+    }
+    return valid;
+}
+
 OmxInfoBuilder sOmxInfoBuilder{true /* allowSurfaceEncoders */};
 OmxInfoBuilder sOmxNoSurfaceEncoderInfoBuilder{false /* allowSurfaceEncoders */};
 
@@ -138,6 +276,8 @@ void *MediaCodecList::profilerThreadWrapper(void * /*arg*/) {
         return nullptr;
     }
 
+    writeCodecListCache(codecList->mGlobalSettings, codecList->mCodecInfos);
+
     {
         Mutex::Autolock autoLock(sInitMutex);
         sCodecList = codecList;
@@ -149,10 +289,14 @@ void *MediaCodecList::profilerThreadWrapper(void * /*arg*/) {
 sp<IMediaCodecList> MediaCodecList::getLocalInstance() {
     Mutex::Autolock autoLock(sInitMutex);
 
+    if (sCodecList == nullptr) {
+        sCodecList = getCachedInstance();
+    }
     if (sCodecList == nullptr) {
         MediaCodecList *codecList = new MediaCodecList(GetBuilders());
         if (codecList->initCheck() == OK) {
             sCodecList = codecList;
+            writeCodecListCache(codecList->mGlobalSettings, codecList->mCodecInfos);
 
             if (isProfilingNeeded()) {
                 ALOGV("Codec profiling needed, will be run in separated thread.");
@@ -181,9 +325,22 @@ void MediaCodecList::BinderDeathObserver::binderDied(const wp<IBinder> &who __un
     sBinderDeathObserver.clear();
 }
 
+// static
+sp<IMediaCodecList> MediaCodecList::getCachedInstance() {
+    sp<AMessage> globalSettings;
+    std::vector<sp<MediaCodecInfo>> infos;
+    if (!readCodecListCache(&globalSettings, &infos)) {
+        return nullptr;
+    }
+    return new MediaCodecList(globalSettings, std::move(infos));
+}
+
 // static
 sp<IMediaCodecList> MediaCodecList::getInstance() {
     Mutex::Autolock _l(sRemoteInitMutex);
+    if (sRemoteList == nullptr) {
+        sRemoteList = getCachedInstance();
+    }
     if (sRemoteList == nullptr) {
         sMediaPlayer = defaultServiceManager()->getService(String16("media.player"));
         sp<IMediaPlayerService> service =
@@ -247,6 +404,13 @@ MediaCodecList::MediaCodecList(std::vector<MediaCodecListBuilderBase*> builders)
     }
 }
 
+MediaCodecList::MediaCodecList(
+        const sp<AMessage> &globalSettings, std::vector<sp<MediaCodecInfo>> &&codecInfos)
+    : mInitCheck(OK),
+      mGlobalSettings(globalSettings),
+      mCodecInfos(std::move(codecInfos)) {
+}
+
 MediaCodecList::~MediaCodecList() {
 }
 
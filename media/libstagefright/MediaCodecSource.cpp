@@ -20,6 +20,8 @@
 
 #include <inttypes.h>
 
+#include <algorithm>
+
 #include <gui/IGraphicBufferProducer.h>
 #include <gui/Surface.h>
 #include <mediadrm/ICrypto.h>
@@ -52,6 +54,9 @@ const int kStopTimeoutUs = 300000; // allow 1 sec for shutting down encoder
 // allow maximum 1 sec for stop time offset. This limits the the delay in the
 // input source.
 const int kMaxStopTimeOffsetUs = 1000000;
+// inputs whose output never shows up (e.g. dropped by the encoder) are forgotten
+// once this many are pending
+const size_t kMaxPendingLatencySamples = 64;
 
 struct MediaCodecSource::Puller : public AHandler {
     explicit Puller(const sp<MediaSource> &source);
@@ -63,7 +68,7 @@ struct MediaCodecSource::Puller : public AHandler {
     void pause();
     void resume();
     status_t setStopTimeUs(int64_t stopTimeUs);
-    bool readBuffer(MediaBufferBase **buffer);
+    bool readBuffer(MediaBufferBase **buffer, int64_t *readTimeUs = NULL);
 
 protected:
     virtual void onMessageReceived(const sp<AMessage> &msg);
@@ -91,11 +96,13 @@ private:
         bool mPaused;
         bool mPulling;
         Vector<MediaBufferBase *> mReadBuffers;
+        // system time (us) at which each of mReadBuffers was read from the source
+        Vector<int64_t> mReadTimesUs;
 
         void flush();
         // if queue is empty, return false and set *|buffer| to NULL . Otherwise, pop
         // buffer from front of the queue, place it into *|buffer| and return true.
-        bool readBuffer(MediaBufferBase **buffer);
+        bool readBuffer(MediaBufferBase **buffer, int64_t *readTimeUs = NULL);
         // add a buffer to the back of the queue
         void pushBuffer(MediaBufferBase *mbuf);
     };
@@ -129,15 +136,20 @@ MediaCodecSource::Puller::~Puller() {
 
 void MediaCodecSource::Puller::Queue::pushBuffer(MediaBufferBase *mbuf) {
     mReadBuffers.push_back(mbuf);
+    mReadTimesUs.push_back(ALooper::GetNowUs());
 }
 
-bool MediaCodecSource::Puller::Queue::readBuffer(MediaBufferBase **mbuf) {
+bool MediaCodecSource::Puller::Queue::readBuffer(MediaBufferBase **mbuf, int64_t *readTimeUs) {
     if (mReadBuffers.empty()) {
         *mbuf = NULL;
         return false;
     }
     *mbuf = *mReadBuffers.begin();
     mReadBuffers.erase(mReadBuffers.begin());
+    if (readTimeUs != NULL) {
+        *readTimeUs = *mReadTimesUs.begin();
+    }
+    mReadTimesUs.erase(mReadTimesUs.begin());
     return true;
 }
 
@@ -149,9 +161,9 @@ void MediaCodecSource::Puller::Queue::flush() {
     }
 }
 
-bool MediaCodecSource::Puller::readBuffer(MediaBufferBase **mbuf) {
+bool MediaCodecSource::Puller::readBuffer(MediaBufferBase **mbuf, int64_t *readTimeUs) {
     Mutexed<Queue>::Locked queue(mQueue);
-    return queue->readBuffer(mbuf);
+    return queue->readBuffer(mbuf, readTimeUs);
 }
 
 status_t MediaCodecSource::Puller::postSynchronouslyAndReturnError(
@@ -362,6 +374,13 @@ status_t MediaCodecSource::setInputBufferTimeOffset(int64_t timeOffsetUs) {
     return postSynchronouslyAndReturnError(msg);
 }
 
+void MediaCodecSource::getLatencyStats(int64_t *count, int64_t *avgUs, int64_t *maxUs) {
+    Mutexed<LatencyStats>::Locked stats(mLatencyStats);
+    *count = stats->mCount;
+    *avgUs = stats->mCount > 0 ? stats->mTotalUs / stats->mCount : 0;
+    *maxUs = stats->mMaxUs;
+}
+
 int64_t MediaCodecSource::getFirstSampleSystemTimeUs() {
     sp<AMessage> msg = new AMessage(kWhatGetFirstSampleSystemTimeUs, mReflector);
     sp<AMessage> response;
@@ -481,6 +500,16 @@ MediaCodecSource::MediaCodecSource(
       mBatchSize(0){
     CHECK(mLooper != NULL);
 
+    if (mFlags & FLAG_LOW_LATENCY) {
+        // Don't queue behind other sources sharing the caller's looper.
+        mLooper = new ALooper;
+        mLooper->setName("codec_source_looper");
+        mLooper->start(
+                false /* runOnCallingThread */,
+                false /* canCallJava */,
+                PRIORITY_AUDIO);
+    }
+
     if (!(mFlags & FLAG_USE_SURFACE_INPUT)) {
         mPuller = new Puller(source);
     }
@@ -491,6 +520,9 @@ MediaCodecSource::~MediaCodecSource() {
 
     mCodecLooper->stop();
     mLooper->unregisterHandler(mReflector->id());
+    if (mFlags & FLAG_LOW_LATENCY) {
+        mLooper->stop();
+    }
 }
 
 status_t MediaCodecSource::init() {
@@ -516,6 +548,12 @@ status_t MediaCodecSource::initEncoder() {
         mOutputFormat->setInt32(KEY_CREATE_INPUT_SURFACE_SUSPENDED, 1);
     }
 
+    if (mFlags & FLAG_LOW_LATENCY) {
+        // Output each frame as soon as it is encoded, at realtime priority.
+        mOutputFormat->setInt32(KEY_LATENCY, 1);
+        mOutputFormat->setInt32(KEY_PRIORITY, 0);
+    }
+
     AString outputMIME;
     CHECK(mOutputFormat->findString("mime", &outputMIME));
     mIsVideo = outputMIME.startsWithIgnoreCase("video/");
@@ -729,7 +767,8 @@ void MediaCodecSource::resume(int64_t resumeStartTimeUs) {
 
 status_t MediaCodecSource::feedEncoderInputBuffers() {
     MediaBufferBase* mbuf = NULL;
-    while (!mAvailEncoderInputIndices.empty() && mPuller->readBuffer(&mbuf)) {
+    int64_t readTimeUs = 0;
+    while (!mAvailEncoderInputIndices.empty() && mPuller->readBuffer(&mbuf, &readTimeUs)) {
         if (!mEncoder) {
             return BAD_VALUE;
         }
@@ -756,6 +795,11 @@ status_t MediaCodecSource::feedEncoderInputBuffers() {
                 mInputBufferTimeOffsetUs, &mPrevBufferTimestampUs, timeUs, mBatchSize);
             timeUs += mInputBufferTimeOffsetUs;
 
+            mInputReadTimesUs[timeUs] = readTimeUs;
+            if (mInputReadTimesUs.size() > kMaxPendingLatencySamples) {
+                mInputReadTimesUs.erase(mInputReadTimesUs.begin());
+            }
+
             // push decoding time for video, or drift time for audio
             if (mIsVideo) {
                 mDecodingTimeQueue.push_back(timeUs);
@@ -1035,6 +1079,16 @@ void MediaCodecSource::onMessageReceived(const sp<AMessage> &msg) {
                             timeUs, timeUs / 1E6, driftTimeUs);
                 }
                 mbuf->meta_data().setInt64(kKeyTime, timeUs);
+
+                auto it = mInputReadTimesUs.find(timeUs);
+                if (it != mInputReadTimesUs.end()) {
+                    int64_t latencyUs = ALooper::GetNowUs() - it->second;
+                    mInputReadTimesUs.erase(it);
+                    Mutexed<LatencyStats>::Locked stats(mLatencyStats);
+                    ++stats->mCount;
+                    stats->mTotalUs += latencyUs;
+                    stats->mMaxUs = std::max(stats->mMaxUs, latencyUs);
+                }
             } else {
                 mbuf->meta_data().setInt64(kKeyTime, 0LL);
                 mbuf->meta_data().setInt32(kKeyIsCodecConfig, true);
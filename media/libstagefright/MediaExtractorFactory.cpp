@@ -24,6 +24,7 @@
 #include <binder/PermissionCache.h>
 #include <binder/IServiceManager.h>
 #include <media/DataSource.h>
+#include <media/stagefright/foundation/ABase.h>
 #include <media/stagefright/InterfaceUtils.h>
 #include <media/stagefright/MediaExtractor.h>
 #include <media/stagefright/MediaExtractorFactory.h>
@@ -33,10 +34,16 @@
 #include <private/android_filesystem_config.h>
 #include <cutils/properties.h>
 #include <utils/String8.h>
+#include <utils/Timers.h>
 
 #include <dirent.h>
 #include <dlfcn.h>
 
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
 namespace android {
 
 // static
@@ -109,8 +116,12 @@ struct ExtractorPlugin : public RefBase {
     String8 libPath;
     String8 uuidString;
 
+    // Sniffing statistics, reported by dump().
+    std::atomic<uint32_t> sniffCount;
+    std::atomic<int64_t> sniffTimeNs;
+
     ExtractorPlugin(ExtractorDef definition, void *handle, String8 &path)
-        : def(definition), libHandle(handle), libPath(path) {
+        : def(definition), libHandle(handle), libPath(path), sniffCount(0), sniffTimeNs(0) {
         for (size_t i = 0; i < sizeof ExtractorDef::extractor_uuid; i++) {
             uuidString.appendFormat("%02x", def.extractor_uuid.b[i]);
         }
@@ -128,6 +139,59 @@ std::shared_ptr<std::list<sp<ExtractorPlugin>>> MediaExtractorFactory::gPlugins;
 bool MediaExtractorFactory::gPluginsRegistered = false;
 bool MediaExtractorFactory::gIgnoreVersion = false;
 
+// Serves the start of a source from a buffer read once, so that the sniffers
+// can run concurrently. Reads outside of it go to the source one at a time.
+class SniffDataSource : public DataSource {
+public:
+    explicit SniffDataSource(const sp<DataSource> &source)
+        : mSource(source), mHeader(kHeaderSize) {
+        ssize_t n = mSource->readAt(0, mHeader.data(), mHeader.size());
+        mHeader.resize(n > 0 ? n : 0);
+    }
+
+    virtual status_t initCheck() const {
+        return mSource->initCheck();
+    }
+
+    virtual ssize_t readAt(off64_t offset, void *data, size_t size) {
+        if (offset >= 0 && (size_t)offset <= mHeader.size()
+                && size <= mHeader.size() - offset) {
+            memcpy(data, mHeader.data() + offset, size);
+            return size;
+        }
+        Mutex::Autolock autoLock(mLock);
+        return mSource->readAt(offset, data, size);
+    }
+
+    virtual status_t getSize(off64_t *size) {
+        Mutex::Autolock autoLock(mLock);
+        return mSource->getSize(size);
+    }
+
+    virtual uint32_t flags() {
+        Mutex::Autolock autoLock(mLock);
+        return mSource->flags();
+    }
+
+    virtual String8 getUri() {
+        return mSource->getUri();
+    }
+
+    virtual String8 toString() {
+        return mSource->toString();
+    }
+
+private:
+    // Covers the headers most sniffers look at.
+    static const size_t kHeaderSize = 64 * 1024;
+
+    sp<DataSource> mSource;
+    std::vector<uint8_t> mHeader;
+    Mutex mLock;
+
+    DISALLOW_EVIL_CONSTRUCTORS(SniffDataSource);
+};
+
 // static
 void *MediaExtractorFactory::sniff(
         const sp<DataSource> &source, float *confidence, void **meta,
@@ -144,38 +208,74 @@ void *MediaExtractorFactory::sniff(
         plugins = gPlugins;
     }
 
-    void *bestCreator = NULL;
-    for (auto it = plugins->begin(); it != plugins->end(); ++it) {
-        ALOGV("sniffing %s", (*it)->def.extractor_name);
-        float newConfidence;
-        void *newMeta = nullptr;
-        FreeMetaFunc newFreeMeta = nullptr;
-
-        void *curCreator = NULL;
-        if ((*it)->def.def_version == EXTRACTORDEF_VERSION_NDK_V1) {
-            curCreator = (void*) (*it)->def.u.v2.sniff(
-                    source->wrap(), &newConfidence, &newMeta, &newFreeMeta);
-        } else if ((*it)->def.def_version == EXTRACTORDEF_VERSION_NDK_V2) {
-            curCreator = (void*) (*it)->def.u.v3.sniff(
-                    source->wrap(), &newConfidence, &newMeta, &newFreeMeta);
+    // A sniffer this confident wins outright, sniffers not started yet are skipped.
+    static const float kConclusiveConfidence = 0.8f;
+    static const size_t kMaxSniffThreads = 4;
+
+    struct SniffResult {
+        void *creator = NULL;
+        float confidence = 0.0f;
+        void *meta = nullptr;
+        FreeMetaFunc freeMeta = nullptr;
+    };
+
+    std::vector<sp<ExtractorPlugin>> candidates(plugins->begin(), plugins->end());
+    std::vector<SniffResult> results(candidates.size());
+    sp<SniffDataSource> sniffSource = new SniffDataSource(source);
+    CDataSource *wrapper = sniffSource->wrap();
+    std::atomic<size_t> nextCandidate(0);
+    std::atomic<bool> conclusive(false);
+
+    auto sniffCandidates = [&]() {
+        size_t i;
+        while (!conclusive && (i = nextCandidate++) < candidates.size()) {
+            const sp<ExtractorPlugin> &candidate = candidates[i];
+            SniffResult &result = results[i];
+            ALOGV("sniffing %s", candidate->def.extractor_name);
+
+            nsecs_t startNs = systemTime();
+            if (candidate->def.def_version == EXTRACTORDEF_VERSION_NDK_V1) {
+                result.creator = (void*) candidate->def.u.v2.sniff(
+                        wrapper, &result.confidence, &result.meta, &result.freeMeta);
+            } else if (candidate->def.def_version == EXTRACTORDEF_VERSION_NDK_V2) {
+                result.creator = (void*) candidate->def.u.v3.sniff(
+                        wrapper, &result.confidence, &result.meta, &result.freeMeta);
+            }
+            candidate->sniffTimeNs += systemTime() - startNs;
+            ++candidate->sniffCount;
+
+            if (result.creator && result.confidence >= kConclusiveConfidence) {
+                conclusive = true;
+            }
         }
+    };
 
-        if (curCreator) {
-            if (newConfidence > *confidence) {
-                *confidence = newConfidence;
-                if (*meta != nullptr && *freeMeta != nullptr) {
-                    (*freeMeta)(*meta);
-                }
-                *meta = newMeta;
-                *freeMeta = newFreeMeta;
-                plugin = *it;
-                bestCreator = curCreator;
-                *creatorVersion = (*it)->def.def_version;
-            } else {
-                if (newMeta != nullptr && newFreeMeta != nullptr) {
-                    newFreeMeta(newMeta);
-                }
+    std::vector<std::thread> threads;
+    size_t numThreads = std::min(kMaxSniffThreads, candidates.size());
+    for (size_t i = 1; i < numThreads; ++i) {
+        threads.emplace_back(sniffCandidates);
+    }
+    sniffCandidates();
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+
+    // Ties go to the plugin registered first, as when sniffing in turn.
+    void *bestCreator = NULL;
+    for (size_t i = 0; i < candidates.size(); ++i) {
+        SniffResult &result = results[i];
+        if (result.creator && result.confidence > *confidence) {
+            *confidence = result.confidence;
+            if (*meta != nullptr && *freeMeta != nullptr) {
+                (*freeMeta)(*meta);
             }
+            *meta = result.meta;
+            *freeMeta = result.freeMeta;
+            plugin = candidates[i];
+            bestCreator = result.creator;
+            *creatorVersion = candidates[i]->def.def_version;
+        } else if (result.meta != nullptr && result.freeMeta != nullptr) {
+            result.freeMeta(result.meta);
         }
     }
 
@@ -370,6 +470,11 @@ status_t MediaExtractorFactory::dump(int fd, const Vector<String16>&) {
                         (*it)->uuidString.c_str(),
                         (*it)->def.extractor_version,
                         (*it)->libPath.c_str());
+                uint32_t sniffCount = (*it)->sniffCount;
+                if (sniffCount > 0) {
+                    out.appendFormat(", sniffs(%u), avg sniff time(%.2f ms)", sniffCount,
+                            (*it)->sniffTimeNs / 1E6 / sniffCount);
+                }
                 if ((*it)->def.def_version == EXTRACTORDEF_VERSION_NDK_V2) {
                     out.append(", supports: ");
                     for (size_t i = 0;; i++) {
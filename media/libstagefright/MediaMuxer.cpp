@@ -205,6 +205,18 @@ status_t MediaMuxer::stop() {
 
 status_t MediaMuxer::writeSampleData(const sp<ABuffer> &buffer, size_t trackIndex,
                                      int64_t timeUs, uint32_t flags) {
+    return pushSampleData(buffer, trackIndex, timeUs, flags, NULL /* onReleased */);
+}
+
+status_t MediaMuxer::writeSampleDataNoCopy(const sp<ABuffer> &buffer, size_t trackIndex,
+                                           int64_t timeUs, uint32_t flags,
+                                           const std::function<void()> &onReleased) {
+    return pushSampleData(buffer, trackIndex, timeUs, flags, &onReleased);
+}
+
+status_t MediaMuxer::pushSampleData(const sp<ABuffer> &buffer, size_t trackIndex,
+                                    int64_t timeUs, uint32_t flags,
+                                    const std::function<void()> *onReleased) {
     if (buffer.get() == NULL) {
         ALOGE("WriteSampleData() get an NULL buffer.");
         return -EINVAL;
@@ -264,6 +276,11 @@ status_t MediaMuxer::writeSampleData(const sp<ABuffer> &buffer, size_t trackInde
     }
 
     sp<MediaAdapter> currentTrack = mTrackList[trackIndex];
+    if (onReleased != NULL) {
+        sampleMetaData.setInt32(kKeyHoldUntilWritten, 1);
+        // This pushBuffer only waits until the writer has taken the mediaBuffer.
+        return currentTrack->pushBuffer(mediaBuffer, *onReleased);
+    }
     // This pushBuffer will wait until the mediaBuffer is consumed.
     return currentTrack->pushBuffer(mediaBuffer);
 }
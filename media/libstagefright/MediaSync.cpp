@@ -18,6 +18,8 @@
 #define LOG_TAG "MediaSync"
 #include <inttypes.h>
 
+#include <algorithm>
+
 #include <gui/BufferQueue.h>
 #include <gui/IGraphicBufferConsumer.h>
 #include <gui/IGraphicBufferProducer.h>
@@ -38,6 +40,16 @@
 // frame arrives later than this number, it will be discarded without rendering.
 static const int64_t kMaxAllowedVideoLateTimeUs = 40000LL;
 
+// Video frames are queued to the output with their desired present time at least this long
+// before they are due. SurfaceFlinger holds them until then, so a decoder that runs ahead does
+// not need a looper wakeup for every frame.
+static const int64_t kRenderAheadUs = 50000LL;
+
+// Buckets of the A/V sync error histogram, in microseconds.
+static const int kSyncErrorHistogramBuckets = 40;
+static const int64_t kSyncErrorHistogramWidthUs = 2000LL;
+static const int64_t kSyncErrorHistogramFloorUs = -40000LL;
+
 namespace android {
 
 // static
@@ -59,10 +71,14 @@ MediaSync::MediaSync()
         mNumFramesWritten(0),
         mHasAudio(false),
         mNextBufferItemMediaUs(-1),
-        mPlaybackRate(0.0) {
+        mPlaybackRate(0.0),
+        mNumFramesDroppedLate(0) {
     mMediaClock = new MediaClock;
     mMediaClock->init();
 
+    mSyncErrorHistogram.setup(kSyncErrorHistogramBuckets, kSyncErrorHistogramWidthUs,
+                              kSyncErrorHistogramFloorUs);
+
     // initialize settings
     mPlaybackSettings = AUDIO_PLAYBACK_RATE_DEFAULT;
     mPlaybackSettings.mSpeed = mPlaybackRate;
@@ -259,22 +275,32 @@ sp<const MediaClock> MediaSync::getMediaClock() {
 }
 
 status_t MediaSync::getPlayTimeForPendingAudioFrames(int64_t *outTimeUs) {
-    Mutex::Autolock lock(mMutex);
-    // User should check the playback rate if it doesn't want to receive a
-    // huge number for play time.
-    if (mPlaybackRate == 0.0f) {
-        *outTimeUs = INT64_MAX;
-        return OK;
+    sp<AudioTrack> audioTrack;
+    {
+        Mutex::Autolock lock(mMutex);
+        // User should check the playback rate if it doesn't want to receive a
+        // huge number for play time.
+        if (mPlaybackRate == 0.0f) {
+            *outTimeUs = INT64_MAX;
+            return OK;
+        }
+        audioTrack = mAudioTrack;
     }
 
     uint32_t numFramesPlayed = 0;
-    if (mAudioTrack != NULL) {
-        status_t res = mAudioTrack->getPosition(&numFramesPlayed);
+    if (audioTrack != NULL) {
+        status_t res = audioTrack->getPosition(&numFramesPlayed);
         if (res != OK) {
             return res;
         }
     }
 
+    Mutex::Autolock lock(mMutex);
+    if (mPlaybackRate == 0.0f) {
+        *outTimeUs = INT64_MAX;
+        return OK;
+    }
+
     int64_t numPendingFrames = mNumFramesWritten - numFramesPlayed;
     if (numPendingFrames < 0) {
         numPendingFrames = 0;
@@ -294,27 +320,51 @@ status_t MediaSync::getPlayTimeForPendingAudioFrames(int64_t *outTimeUs) {
     return OK;
 }
 
+status_t MediaSync::getAVSyncErrorHistogram(
+        std::string *outHistogram, int64_t *outNumDroppedFrames) {
+    if (outHistogram == NULL || outNumDroppedFrames == NULL) {
+        return BAD_VALUE;
+    }
+
+    Mutex::Autolock lock(mMutex);
+    *outHistogram = mSyncErrorHistogram.emit();
+    *outNumDroppedFrames = mNumFramesDroppedLate;
+    return OK;
+}
+
 status_t MediaSync::updateQueuedAudioData(
         size_t sizeInBytes, int64_t presentationTimeUs) {
     if (sizeInBytes == 0) {
         return OK;
     }
 
-    Mutex::Autolock lock(mMutex);
+    // The audio track is only ever set once, so it can be queried without holding the lock,
+    // which would otherwise stall the rendering of video.
+    sp<AudioTrack> audioTrack;
+    {
+        Mutex::Autolock lock(mMutex);
+        audioTrack = mAudioTrack;
+    }
 
-    if (mAudioTrack == NULL) {
+    if (audioTrack == NULL) {
         ALOGW("updateQueuedAudioData: audioTrack has NOT been configured.");
         return INVALID_OPERATION;
     }
 
-    int64_t numFrames = sizeInBytes / mAudioTrack->frameSize();
+    int64_t nowUs = ALooper::GetNowUs();
+    uint32_t numFramesPlayed;
+    int64_t numFramesPlayedAtUs;
+    getAudioPosition(audioTrack, nowUs, &numFramesPlayed, &numFramesPlayedAtUs);
+
+    Mutex::Autolock lock(mMutex);
+
+    int64_t numFrames = sizeInBytes / audioTrack->frameSize();
     int64_t maxMediaTimeUs = presentationTimeUs
             + getDurationIfPlayedAtNativeSampleRate_l(numFrames);
 
-    int64_t nowUs = ALooper::GetNowUs();
     int64_t nowMediaUs = presentationTimeUs
             - getDurationIfPlayedAtNativeSampleRate_l(mNumFramesWritten)
-            + getPlayedOutAudioDurationMedia_l(nowUs);
+            + getPlayedOutAudioDurationMedia_l(numFramesPlayed, numFramesPlayedAtUs, nowUs);
 
     mNumFramesWritten += numFrames;
 
@@ -477,35 +527,36 @@ int64_t MediaSync::getDurationIfPlayedAtNativeSampleRate_l(int64_t numFrames) {
     return (numFrames * 1000000LL / mNativeSampleRateInHz);
 }
 
-int64_t MediaSync::getPlayedOutAudioDurationMedia_l(int64_t nowUs) {
-    CHECK(mAudioTrack != NULL);
-
-    uint32_t numFramesPlayed;
-    int64_t numFramesPlayedAtUs;
+// static
+void MediaSync::getAudioPosition(const sp<AudioTrack> &audioTrack, int64_t nowUs,
+        uint32_t *numFramesPlayed, int64_t *numFramesPlayedAtUs) {
     AudioTimestamp ts;
 
-    status_t res = mAudioTrack->getTimestamp(ts);
+    status_t res = audioTrack->getTimestamp(ts);
     if (res == OK) {
         // case 1: mixing audio tracks.
-        numFramesPlayed = ts.mPosition;
-        numFramesPlayedAtUs = ts.mTime.tv_sec * 1000000LL + ts.mTime.tv_nsec / 1000;
+        *numFramesPlayed = ts.mPosition;
+        *numFramesPlayedAtUs = ts.mTime.tv_sec * 1000000LL + ts.mTime.tv_nsec / 1000;
         //ALOGD("getTimestamp: OK %d %lld",
-        //      numFramesPlayed, (long long)numFramesPlayedAtUs);
+        //      *numFramesPlayed, (long long)*numFramesPlayedAtUs);
     } else if (res == WOULD_BLOCK) {
         // case 2: transitory state on start of a new track
-        numFramesPlayed = 0;
-        numFramesPlayedAtUs = nowUs;
+        *numFramesPlayed = 0;
+        *numFramesPlayedAtUs = nowUs;
         //ALOGD("getTimestamp: WOULD_BLOCK %d %lld",
-        //      numFramesPlayed, (long long)numFramesPlayedAtUs);
+        //      *numFramesPlayed, (long long)*numFramesPlayedAtUs);
     } else {
         // case 3: transitory at new track or audio fast tracks.
-        res = mAudioTrack->getPosition(&numFramesPlayed);
+        res = audioTrack->getPosition(numFramesPlayed);
         CHECK_EQ(res, (status_t)OK);
-        numFramesPlayedAtUs = nowUs;
-        numFramesPlayedAtUs += 1000LL * mAudioTrack->latency() / 2; /* XXX */
-        //ALOGD("getPosition: %d %lld", numFramesPlayed, (long long)numFramesPlayedAtUs);
+        *numFramesPlayedAtUs = nowUs;
+        *numFramesPlayedAtUs += 1000LL * audioTrack->latency() / 2; /* XXX */
+        //ALOGD("getPosition: %d %lld", *numFramesPlayed, (long long)*numFramesPlayedAtUs);
     }
+}
 
+int64_t MediaSync::getPlayedOutAudioDurationMedia_l(
+        uint32_t numFramesPlayed, int64_t numFramesPlayedAtUs, int64_t nowUs) {
     //can't be negative until 12.4 hrs, test.
     //CHECK_EQ(numFramesPlayed & (1 << 31), 0);
     int64_t durationUs =
@@ -532,23 +583,31 @@ int64_t MediaSync::getPlayedOutAudioDurationMedia_l(int64_t nowUs) {
     return durationUs;
 }
 
+int64_t MediaSync::getRenderAheadUs_l() {
+    // at least 2 display refreshes
+    int64_t twoVsyncsUs = 0;
+    if (mFrameScheduler != NULL) {
+        twoVsyncsUs = 2 * (mFrameScheduler->getVsyncPeriod() / 1000);
+    }
+    return std::max(twoVsyncsUs, kRenderAheadUs);
+}
+
 void MediaSync::onDrainVideo_l() {
     if (!isPlaying()) {
         return;
     }
 
+    int64_t renderAheadUs = getRenderAheadUs_l();
     while (!mBufferItems.empty()) {
         int64_t nowUs = ALooper::GetNowUs();
         BufferItem *bufferItem = &*mBufferItems.begin();
         int64_t itemMediaUs = bufferItem->mTimestamp / 1000;
-        int64_t itemRealUs = getRealTime(itemMediaUs, nowUs);
+        int64_t itemClockRealUs = getRealTime(itemMediaUs, nowUs);
 
         // adjust video frame PTS based on vsync
-        itemRealUs = mFrameScheduler->schedule(itemRealUs * 1000) / 1000;
-        int64_t twoVsyncsUs = 2 * (mFrameScheduler->getVsyncPeriod() / 1000);
+        int64_t itemRealUs = mFrameScheduler->schedule(itemClockRealUs * 1000) / 1000;
 
-        // post 2 display refreshes before rendering is due
-        if (itemRealUs <= nowUs + twoVsyncsUs) {
+        if (itemRealUs <= nowUs + renderAheadUs) {
             ALOGV("adjusting PTS from %lld to %lld",
                     (long long)bufferItem->mTimestamp / 1000, (long long)itemRealUs);
             bufferItem->mTimestamp = itemRealUs * 1000;
@@ -557,19 +616,22 @@ void MediaSync::onDrainVideo_l() {
             if (mHasAudio) {
                 if (nowUs - itemRealUs <= kMaxAllowedVideoLateTimeUs) {
                     renderOneBufferItem_l(*bufferItem);
+                    mSyncErrorHistogram.insert(std::max(itemRealUs, nowUs) - itemClockRealUs);
                 } else {
                     // too late.
                     returnBufferToInput_l(
                             bufferItem->mGraphicBuffer, bufferItem->mFence);
                     mFrameScheduler->restart();
+                    ++mNumFramesDroppedLate;
                 }
             } else {
                 // always render video buffer in video-only mode.
                 renderOneBufferItem_l(*bufferItem);
 
-                // smooth out videos >= 10fps
+                // smooth out videos >= 10fps, anchoring the clock at the time the
+                // frame is displayed, as it can be queued ahead of time.
                 mMediaClock->updateAnchor(
-                        itemMediaUs, nowUs, itemMediaUs + 100000);
+                        itemMediaUs, std::max(itemRealUs, nowUs), itemMediaUs + 100000);
             }
 
             mBufferItems.erase(mBufferItems.begin());
@@ -578,7 +640,7 @@ void MediaSync::onDrainVideo_l() {
             if (mNextBufferItemMediaUs == -1
                     || mNextBufferItemMediaUs > itemMediaUs) {
                 sp<AMessage> msg = new AMessage(kWhatDrainVideo, this);
-                msg->post(itemRealUs - nowUs - twoVsyncsUs);
+                msg->post(itemRealUs - nowUs - renderAheadUs);
                 mNextBufferItemMediaUs = itemMediaUs;
             }
             break;
@@ -792,8 +854,9 @@ void MediaSync::onMessageReceived(const sp<AMessage> &msg) {
                 // various reasons, e.g., media clock has been changed because
                 // of new anchor time or playback rate. In such cases, the
                 // message needs to be re-posted.
-                if (itemRealUs > nowUs) {
-                    msg->post(itemRealUs - nowUs);
+                int64_t renderAheadUs = getRenderAheadUs_l();
+                if (itemRealUs > nowUs + renderAheadUs) {
+                    msg->post(itemRealUs - nowUs - renderAheadUs);
                     break;
                 }
             }
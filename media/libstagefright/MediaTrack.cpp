@@ -206,6 +206,18 @@ status_t MediaTrackCUnwrapper::read(MediaBufferBase **buffer, const ReadOptions
     return reverse_translate_error(ret);
 }
 
+status_t MediaTrackCUnwrapper::readInto(void *data, size_t size,
+        MediaBufferBase **buffer, const ReadOptions *options) {
+    if (bufferGroup == nullptr) {
+        return read(buffer, options);
+    }
+    // The extractor acquires its buffer from our group, have it hand out data.
+    bufferGroup->setDestination(data, size);
+    status_t err = read(buffer, options);
+    bufferGroup->clearDestination();
+    return err;
+}
+
 bool MediaTrackCUnwrapper::supportNonblockingRead() {
     return wrapper->supportsNonBlockingRead(wrapper->data);
 }
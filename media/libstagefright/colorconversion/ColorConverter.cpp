@@ -30,8 +30,11 @@
 #include "libyuv/convert_argb.h"
 #include "libyuv/planar_functions.h"
 #include "libyuv/video_common.h"
+#include <algorithm>
 #include <functional>
 #include <sys/time.h>
+#include <thread>
+#include <vector>
 
 #define PERF_PROFILING 0
 
@@ -456,6 +459,39 @@ constexpr int CLIP_RANGE_MAX_8BIT = 552;
 constexpr int CLIP_RANGE_MIN_10BIT = -1175;
 constexpr int CLIP_RANGE_MAX_10BIT = 2218;
 
+// Frames of at least this many pixels are converted on several threads by the
+// per-pixel paths.
+constexpr size_t kMinPixelsForThreadedConversion = 1280 * 720;
+constexpr size_t kMaxConversionThreads = 4;
+
+/**
+ * Runs |convertRows| over [0, height) in bands of rows, one band per thread for large
+ * frames. Bands start on even rows so that a band never begins in the middle of a
+ * vertically subsampled chroma row. The first band runs on the calling thread.
+ */
+void forEachRowBand(size_t width, size_t height,
+        const std::function<void(size_t, size_t)> &convertRows) {
+    size_t numThreads = 1;
+    if (width * height >= kMinPixelsForThreadedConversion) {
+        numThreads = std::clamp<size_t>(
+                std::thread::hardware_concurrency(), 1, kMaxConversionThreads);
+    }
+    size_t bandHeight = ((height + numThreads - 1) / numThreads + 1) & ~(size_t)1;
+    if (numThreads == 1 || bandHeight >= height) {
+        convertRows(0, height);
+        return;
+    }
+
+    std::vector<std::thread> threads;
+    for (size_t y = bandHeight; y < height; y += bandHeight) {
+        threads.emplace_back(convertRows, y, std::min(y + bandHeight, height));
+    }
+    convertRows(0, bandHeight);
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+}
+
 }
 
 ColorConverter::ColorConverter(
@@ -786,54 +822,56 @@ status_t ColorConverter::convertCbYCrY(
 
     uint8_t *kAdjustedClip = initClip();
 
-    uint16_t *dst_ptr = (uint16_t *)dst.mBits
-        + dst.mCropTop * dst.mWidth + dst.mCropLeft;
+    forEachRowBand(src.cropWidth(), src.cropHeight(), [&](size_t yStart, size_t yEnd) {
+        uint16_t *dst_ptr = (uint16_t *)dst.mBits
+            + (dst.mCropTop + yStart) * dst.mWidth + dst.mCropLeft;
 
-    const uint8_t *src_ptr = (const uint8_t *)src.mBits
-        + (src.mCropTop * src.mWidth + src.mCropLeft) * 2;
+        const uint8_t *src_ptr = (const uint8_t *)src.mBits
+            + ((src.mCropTop + yStart) * src.mWidth + src.mCropLeft) * 2;
 
-    for (size_t y = 0; y < src.cropHeight(); ++y) {
-        for (size_t x = 0; x < src.cropWidth() - 1; x += 2) {
-            signed y1 = (signed)src_ptr[2 * x + 1] - _c16;
-            signed y2 = (signed)src_ptr[2 * x + 3] - _c16;
-            signed u = (signed)src_ptr[2 * x] - 128;
-            signed v = (signed)src_ptr[2 * x + 2] - 128;
+        for (size_t y = yStart; y < yEnd; ++y) {
+            for (size_t x = 0; x < src.cropWidth() - 1; x += 2) {
+                signed y1 = (signed)src_ptr[2 * x + 1] - _c16;
+                signed y2 = (signed)src_ptr[2 * x + 3] - _c16;
+                signed u = (signed)src_ptr[2 * x] - 128;
+                signed v = (signed)src_ptr[2 * x + 2] - 128;
 
-            signed u_b = u * _b_u;
-            signed u_g = u * _neg_g_u;
-            signed v_g = v * _neg_g_v;
-            signed v_r = v * _r_v;
+                signed u_b = u * _b_u;
+                signed u_g = u * _neg_g_u;
+                signed v_g = v * _neg_g_v;
+                signed v_r = v * _r_v;
 
-            signed tmp1 = y1 * _y + 128;
-            signed b1 = (tmp1 + u_b) / 256;
-            signed g1 = (tmp1 + v_g + u_g) / 256;
-            signed r1 = (tmp1 + v_r) / 256;
+                signed tmp1 = y1 * _y + 128;
+                signed b1 = (tmp1 + u_b) / 256;
+                signed g1 = (tmp1 + v_g + u_g) / 256;
+                signed r1 = (tmp1 + v_r) / 256;
 
-            signed tmp2 = y2 * _y + 128;
-            signed b2 = (tmp2 + u_b) / 256;
-            signed g2 = (tmp2 + v_g + u_g) / 256;
-            signed r2 = (tmp2 + v_r) / 256;
+                signed tmp2 = y2 * _y + 128;
+                signed b2 = (tmp2 + u_b) / 256;
+                signed g2 = (tmp2 + v_g + u_g) / 256;
+                signed r2 = (tmp2 + v_r) / 256;
 
-            uint32_t rgb1 =
-                ((kAdjustedClip[r1] >> 3) << 11)
-                | ((kAdjustedClip[g1] >> 2) << 5)
-                | (kAdjustedClip[b1] >> 3);
-
-            uint32_t rgb2 =
-                ((kAdjustedClip[r2] >> 3) << 11)
-                | ((kAdjustedClip[g2] >> 2) << 5)
-                | (kAdjustedClip[b2] >> 3);
+                uint32_t rgb1 =
+                    ((kAdjustedClip[r1] >> 3) << 11)
+                    | ((kAdjustedClip[g1] >> 2) << 5)
+                    | (kAdjustedClip[b1] >> 3);
 
-            if (x + 1 < src.cropWidth()) {
-                *(uint32_t *)(&dst_ptr[x]) = (rgb2 << 16) | rgb1;
-            } else {
-                dst_ptr[x] = rgb1;
+                uint32_t rgb2 =
+                    ((kAdjustedClip[r2] >> 3) << 11)
+                    | ((kAdjustedClip[g2] >> 2) << 5)
+                    | (kAdjustedClip[b2] >> 3);
+
+                if (x + 1 < src.cropWidth()) {
+                    *(uint32_t *)(&dst_ptr[x]) = (rgb2 << 16) | rgb1;
+                } else {
+                    dst_ptr[x] = rgb1;
+                }
             }
-        }
 
-        src_ptr += src.mWidth * 2;
-        dst_ptr += dst.mWidth;
-    }
+            src_ptr += src.mWidth * 2;
+            dst_ptr += dst.mWidth;
+        }
+    });
 
     return OK;
 }
@@ -1260,7 +1298,7 @@ status_t ColorConverter::convertYUVMediaImage(
     signed _y = matrix->_y;
     signed _c16 = matrix->_c16;
 
-    uint8_t *dst_ptr = (uint8_t *)dst.mBits
+    uint8_t *dst_base = (uint8_t *)dst.mBits
             + dst.mCropTop * dst.mStride + dst.mCropLeft * dst.mBpp;
 
 
@@ -1286,9 +1324,15 @@ status_t ColorConverter::convertYUVMediaImage(
     kAdjustedClip = initClip();
 
     auto writeToDst = getWriteToDst(mDstFormat, (void *)kAdjustedClip);
-    uint8_t *src_y = (uint8_t *)src.mBits + y_offset;
-    uint8_t *src_u = (uint8_t *)src.mBits + u_offset;
-    uint8_t *src_v = (uint8_t *)src.mBits + v_offset;
+
+    // Positions the plane pointers at row |yStart| of the crop.
+    auto seekToRow = [&](size_t yStart, uint8_t **src_y, uint8_t **src_u, uint8_t **src_v,
+            uint8_t **dst_ptr) {
+        *src_y = (uint8_t *)src.mBits + y_offset + yStart * src_stride_y;
+        *src_u = (uint8_t *)src.mBits + u_offset + (yStart / uVertSubsampling) * src_stride_u;
+        *src_v = (uint8_t *)src.mBits + v_offset + (yStart / vVertSubsampling) * src_stride_v;
+        *dst_ptr = dst_base + yStart * dst.mStride;
+    };
 
     switch (mSrcImage->getSampling()) {
 
@@ -1302,37 +1346,41 @@ status_t ColorConverter::convertYUVMediaImage(
                 ALOGE("Cannot get a read function for this MediaImage2");
                 return ERROR_UNSUPPORTED;
             }
-            for (size_t y = 0; y < src.cropHeight(); ++y) {
-                for (size_t x = 0; x < src.cropWidth(); x += 2) {
-                    signed y1, y2, u, v;
-                    readFromSrcImage(src_y, src_u, src_v, x, &y1, &y2, &u, &v);
-
-                    signed u_b = u * _b_u;
-                    signed u_g = u * _neg_g_u;
-                    signed v_g = v * _neg_g_v;
-                    signed v_r = v * _r_v;
-
-                    y1 = y1 - _c16;
-                    signed tmp1 = y1 * _y + 128;
-                    signed b1 = (tmp1 + u_b) / 256;
-                    signed g1 = (tmp1 + v_g + u_g) / 256;
-                    signed r1 = (tmp1 + v_r) / 256;
-
-                    y2 = y2 - _c16;
-                    signed tmp2 = y2 * _y + 128;
-                    signed b2 = (tmp2 + u_b) / 256;
-                    signed g2 = (tmp2 + v_g + u_g) / 256;
-                    signed r2 = (tmp2 + v_r) / 256;
-
-                    bool uncropped = x + 1 < src.cropWidth();
-                    writeToDst(dst_ptr + x * dst.mBpp, uncropped, r1, g1, b1, r2, g2, b2);
-                }
-                src_y += src_stride_y;
-                src_u += (((y + 1) % uVertSubsampling) == 0) ? src_stride_u : 0;
-                src_v += (((y + 1) % vVertSubsampling) == 0) ? src_stride_v : 0;
+            forEachRowBand(src.cropWidth(), src.cropHeight(), [&](size_t yStart, size_t yEnd) {
+                uint8_t *src_y, *src_u, *src_v, *dst_ptr;
+                seekToRow(yStart, &src_y, &src_u, &src_v, &dst_ptr);
+                for (size_t y = yStart; y < yEnd; ++y) {
+                    for (size_t x = 0; x < src.cropWidth(); x += 2) {
+                        signed y1, y2, u, v;
+                        readFromSrcImage(src_y, src_u, src_v, x, &y1, &y2, &u, &v);
+
+                        signed u_b = u * _b_u;
+                        signed u_g = u * _neg_g_u;
+                        signed v_g = v * _neg_g_v;
+                        signed v_r = v * _r_v;
+
+                        y1 = y1 - _c16;
+                        signed tmp1 = y1 * _y + 128;
+                        signed b1 = (tmp1 + u_b) / 256;
+                        signed g1 = (tmp1 + v_g + u_g) / 256;
+                        signed r1 = (tmp1 + v_r) / 256;
+
+                        y2 = y2 - _c16;
+                        signed tmp2 = y2 * _y + 128;
+                        signed b2 = (tmp2 + u_b) / 256;
+                        signed g2 = (tmp2 + v_g + u_g) / 256;
+                        signed r2 = (tmp2 + v_r) / 256;
+
+                        bool uncropped = x + 1 < src.cropWidth();
+                        writeToDst(dst_ptr + x * dst.mBpp, uncropped, r1, g1, b1, r2, g2, b2);
+                    }
+                    src_y += src_stride_y;
+                    src_u += (((y + 1) % uVertSubsampling) == 0) ? src_stride_u : 0;
+                    src_v += (((y + 1) % vVertSubsampling) == 0) ? src_stride_v : 0;
 
-                dst_ptr += dst.mStride;
-            }
+                    dst_ptr += dst.mStride;
+                }
+            });
             break;
         }
 
@@ -1344,30 +1392,34 @@ status_t ColorConverter::convertYUVMediaImage(
                 ALOGE("Cannot get a read function for this MediaImage2");
                 return ERROR_UNSUPPORTED;
             }
-            for (size_t y = 0; y < src.cropHeight(); ++y) {
-                for (size_t x = 0; x < src.cropWidth(); x += 1) {
-                    signed y1, y2, u, v;
-                    readFromSrcImage(src_y, src_u, src_v, x, &y1, &u, &v);
-
-                    signed u_b = u * _b_u;
-                    signed u_g = u * _neg_g_u;
-                    signed v_g = v * _neg_g_v;
-                    signed v_r = v * _r_v;
-
-                    y1 = y1 - _c16;
-                    signed tmp1 = y1 * _y + 128;
-                    signed b1 = (tmp1 + u_b) / 256;
-                    signed g1 = (tmp1 + v_g + u_g) / 256;
-                    signed r1 = (tmp1 + v_r) / 256;
-
-                    writeToDst(dst_ptr + x * dst.mBpp, false, r1, g1, b1, 0, 0, 0);
-                }
-                src_y += src_stride_y;
-                src_u += (((y + 1) % uVertSubsampling) == 0) ? src_stride_u : 0;
-                src_v += (((y + 1) % vVertSubsampling) == 0) ? src_stride_v : 0;
+            forEachRowBand(src.cropWidth(), src.cropHeight(), [&](size_t yStart, size_t yEnd) {
+                uint8_t *src_y, *src_u, *src_v, *dst_ptr;
+                seekToRow(yStart, &src_y, &src_u, &src_v, &dst_ptr);
+                for (size_t y = yStart; y < yEnd; ++y) {
+                    for (size_t x = 0; x < src.cropWidth(); x += 1) {
+                        signed y1, y2, u, v;
+                        readFromSrcImage(src_y, src_u, src_v, x, &y1, &u, &v);
+
+                        signed u_b = u * _b_u;
+                        signed u_g = u * _neg_g_u;
+                        signed v_g = v * _neg_g_v;
+                        signed v_r = v * _r_v;
+
+                        y1 = y1 - _c16;
+                        signed tmp1 = y1 * _y + 128;
+                        signed b1 = (tmp1 + u_b) / 256;
+                        signed g1 = (tmp1 + v_g + u_g) / 256;
+                        signed r1 = (tmp1 + v_r) / 256;
+
+                        writeToDst(dst_ptr + x * dst.mBpp, false, r1, g1, b1, 0, 0, 0);
+                    }
+                    src_y += src_stride_y;
+                    src_u += (((y + 1) % uVertSubsampling) == 0) ? src_stride_u : 0;
+                    src_v += (((y + 1) % vVertSubsampling) == 0) ? src_stride_v : 0;
 
-                dst_ptr += dst.mStride;
-            }
+                    dst_ptr += dst.mStride;
+                }
+            });
         }
     }
     return OK;
@@ -1396,50 +1448,52 @@ status_t ColorConverter::convertYUV420Planar16(
     auto readFromSrc = getReadFromChromaHorizSubsampled2Image8b(std::nullopt, mSrcFormat);
     auto writeToDst = getWriteToDst(mDstFormat, (void *)kAdjustedClip);
 
-    uint8_t *dst_ptr = (uint8_t *)dst.mBits
-            + dst.mCropTop * dst.mStride + dst.mCropLeft * dst.mBpp;
+    forEachRowBand(src.cropWidth(), src.cropHeight(), [&](size_t yStart, size_t yEnd) {
+        uint8_t *dst_ptr = (uint8_t *)dst.mBits
+                + (dst.mCropTop + yStart) * dst.mStride + dst.mCropLeft * dst.mBpp;
 
-    uint8_t *src_y = (uint8_t *)src.mBits
-            + src.mCropTop * src.mStride + src.mCropLeft * src.mBpp;
+        uint8_t *src_y = (uint8_t *)src.mBits
+                + (src.mCropTop + yStart) * src.mStride + src.mCropLeft * src.mBpp;
 
-    uint8_t *src_u = (uint8_t *)src.mBits + src.mStride * src.mHeight
-            + (src.mCropTop / 2) * (src.mStride / 2) + src.mCropLeft / 2 * src.mBpp;
+        uint8_t *src_u = (uint8_t *)src.mBits + src.mStride * src.mHeight
+                + ((src.mCropTop + yStart) / 2) * (src.mStride / 2) + src.mCropLeft / 2 * src.mBpp;
 
-    uint8_t *src_v = src_u + (src.mStride / 2) * (src.mHeight / 2);
+        uint8_t *src_v = src_u + (src.mStride / 2) * (src.mHeight / 2);
 
-    for (size_t y = 0; y < src.cropHeight(); ++y) {
-        for (size_t x = 0; x < src.cropWidth(); x += 2) {
-            signed y1, y2, u, v;
-            readFromSrc(src_y, src_u, src_v, x, &y1, &y2, &u, &v);
+        for (size_t y = yStart; y < yEnd; ++y) {
+            for (size_t x = 0; x < src.cropWidth(); x += 2) {
+                signed y1, y2, u, v;
+                readFromSrc(src_y, src_u, src_v, x, &y1, &y2, &u, &v);
 
-            signed u_b = u * _b_u;
-            signed u_g = u * _neg_g_u;
-            signed v_g = v * _neg_g_v;
-            signed v_r = v * _r_v;
+                signed u_b = u * _b_u;
+                signed u_g = u * _neg_g_u;
+                signed v_g = v * _neg_g_v;
+                signed v_r = v * _r_v;
 
-            signed tmp1 = (y1 - _c16) * _y + 128;
-            signed b1 = (tmp1 + u_b) / 256;
-            signed g1 = (tmp1 + v_g + u_g) / 256;
-            signed r1 = (tmp1 + v_r) / 256;
+                signed tmp1 = (y1 - _c16) * _y + 128;
+                signed b1 = (tmp1 + u_b) / 256;
+                signed g1 = (tmp1 + v_g + u_g) / 256;
+                signed r1 = (tmp1 + v_r) / 256;
 
-            signed tmp2 = (y2 - _c16) * _y + 128;
-            signed b2 = (tmp2 + u_b) / 256;
-            signed g2 = (tmp2 + v_g + u_g) / 256;
-            signed r2 = (tmp2 + v_r) / 256;
+                signed tmp2 = (y2 - _c16) * _y + 128;
+                signed b2 = (tmp2 + u_b) / 256;
+                signed g2 = (tmp2 + v_g + u_g) / 256;
+                signed r2 = (tmp2 + v_r) / 256;
 
-            bool uncropped = x + 1 < src.cropWidth();
-            writeToDst(dst_ptr + x * dst.mBpp, uncropped, r1, g1, b1, r2, g2, b2);
-        }
+                bool uncropped = x + 1 < src.cropWidth();
+                writeToDst(dst_ptr + x * dst.mBpp, uncropped, r1, g1, b1, r2, g2, b2);
+            }
 
-        src_y += src.mStride;
+            src_y += src.mStride;
 
-        if (y & 1) {
-            src_u += src.mStride / 2;
-            src_v += src.mStride / 2;
-        }
+            if (y & 1) {
+                src_u += src.mStride / 2;
+                src_v += src.mStride / 2;
+            }
 
-        dst_ptr += dst.mStride;
-    }
+            dst_ptr += dst.mStride;
+        }
+    });
     return OK;
 }
 
@@ -1471,52 +1525,54 @@ status_t ColorConverter::convertYUVP010ToRGBA1010102(
 //    auto readFromSrc = getReadFromSrc(mSrcFormat);
     auto writeToDst = getWriteToDst(mDstFormat, (void *)kAdjustedClip10bit);
 
-    uint8_t *dst_ptr = (uint8_t *)dst.mBits
-            + dst.mCropTop * dst.mStride + dst.mCropLeft * dst.mBpp;
+    forEachRowBand(src.cropWidth(), src.cropHeight(), [&](size_t yStart, size_t yEnd) {
+        uint8_t *dst_ptr = (uint8_t *)dst.mBits
+                + (dst.mCropTop + yStart) * dst.mStride + dst.mCropLeft * dst.mBpp;
 
-    uint16_t *src_y = (uint16_t *)((uint8_t *)src.mBits
-            + src.mCropTop * src.mStride + src.mCropLeft * src.mBpp);
+        uint16_t *src_y = (uint16_t *)((uint8_t *)src.mBits
+                + (src.mCropTop + yStart) * src.mStride + src.mCropLeft * src.mBpp);
 
-    uint16_t *src_uv = (uint16_t *)((uint8_t *)src.mBits
-            + src.mStride * src.mHeight
-            + (src.mCropTop / 2) * src.mStride + src.mCropLeft * src.mBpp);
+        uint16_t *src_uv = (uint16_t *)((uint8_t *)src.mBits
+                + src.mStride * src.mHeight
+                + ((src.mCropTop + yStart) / 2) * src.mStride + src.mCropLeft * src.mBpp);
 
-    for (size_t y = 0; y < src.cropHeight(); ++y) {
-        for (size_t x = 0; x < src.cropWidth(); x += 2) {
-            signed y1, y2, u, v;
-            y1 = (src_y[x] >> 6) - _c64;
-            y2 = (src_y[x + 1] >> 6) - _c64;
-            u = int(src_uv[x] >> 6) - 512;
-            v = int(src_uv[x + 1] >> 6) - 512;
+        for (size_t y = yStart; y < yEnd; ++y) {
+            for (size_t x = 0; x < src.cropWidth(); x += 2) {
+                signed y1, y2, u, v;
+                y1 = (src_y[x] >> 6) - _c64;
+                y2 = (src_y[x + 1] >> 6) - _c64;
+                u = int(src_uv[x] >> 6) - 512;
+                v = int(src_uv[x + 1] >> 6) - 512;
 
-            signed u_b = u * _b_u;
-            signed u_g = u * _neg_g_u;
-            signed v_g = v * _neg_g_v;
-            signed v_r = v * _r_v;
+                signed u_b = u * _b_u;
+                signed u_g = u * _neg_g_u;
+                signed v_g = v * _neg_g_v;
+                signed v_r = v * _r_v;
 
-            signed tmp1 = y1 * _y + 128;
-            signed b1 = (tmp1 + u_b) / 256;
-            signed g1 = (tmp1 + v_g + u_g) / 256;
-            signed r1 = (tmp1 + v_r) / 256;
+                signed tmp1 = y1 * _y + 128;
+                signed b1 = (tmp1 + u_b) / 256;
+                signed g1 = (tmp1 + v_g + u_g) / 256;
+                signed r1 = (tmp1 + v_r) / 256;
 
-            signed tmp2 = y2 * _y + 128;
-            signed b2 = (tmp2 + u_b) / 256;
-            signed g2 = (tmp2 + v_g + u_g) / 256;
-            signed r2 = (tmp2 + v_r) / 256;
+                signed tmp2 = y2 * _y + 128;
+                signed b2 = (tmp2 + u_b) / 256;
+                signed g2 = (tmp2 + v_g + u_g) / 256;
+                signed r2 = (tmp2 + v_r) / 256;
 
-            bool uncropped = x + 1 < src.cropWidth();
+                bool uncropped = x + 1 < src.cropWidth();
 
-            writeToDst(dst_ptr + x * dst.mBpp, uncropped, r1, g1, b1, r2, g2, b2);
-        }
+                writeToDst(dst_ptr + x * dst.mBpp, uncropped, r1, g1, b1, r2, g2, b2);
+            }
 
-        src_y += src.mStride / 2;
+            src_y += src.mStride / 2;
 
-        if (y & 1) {
-            src_uv += src.mStride / 2;
-        }
+            if (y & 1) {
+                src_uv += src.mStride / 2;
+            }
 
-        dst_ptr += dst.mStride;
-    }
+            dst_ptr += dst.mStride;
+        }
+    });
 
     return OK;
 }
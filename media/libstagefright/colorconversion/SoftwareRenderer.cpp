@@ -29,8 +29,14 @@
 #include <ui/GraphicBuffer.h>
 #include <ui/Rect.h>
 
+#include "libyuv/planar_functions.h"
+
 namespace android {
 
+// Reorders ARGB bytes to RGBA for libyuv::ARGBShuffle().
+static const uint8_t kShuffleARGBToRGBA[16] =
+        {1, 2, 3, 0, 5, 6, 7, 4, 9, 10, 11, 8, 13, 14, 15, 12};
+
 inline void initDstYUV(
         const android_ycbcr &ycbcr, int32_t cropTop, int32_t cropLeft,
         uint8_t **dst_y, uint8_t **dst_u, uint8_t **dst_v) {
@@ -308,22 +314,12 @@ std::list<FrameRenderTracker::Info> SoftwareRenderer::render(
         uint8_t *dst_y, *dst_u, *dst_v;
         initDstYUV(ycbcr, mCropTop, mCropLeft, &dst_y, &dst_u, &dst_v);
 
-        for (int y = 0; y < mCropHeight; ++y) {
-            memcpy(dst_y, src_y, mCropWidth);
-
-            src_y += mStride;
-            dst_y += ycbcr.ystride;
-        }
-
-        for (int y = 0; y < (mCropHeight + 1) / 2; ++y) {
-            memcpy(dst_u, src_u, (mCropWidth + 1) / 2);
-            memcpy(dst_v, src_v, (mCropWidth + 1) / 2);
-
-            src_u += mStride / 2;
-            src_v += mStride / 2;
-            dst_u += ycbcr.cstride;
-            dst_v += ycbcr.cstride;
-        }
+        // CopyPlane() collapses the rows into one copy when the strides match.
+        libyuv::CopyPlane(src_y, mStride, dst_y, ycbcr.ystride, mCropWidth, mCropHeight);
+        libyuv::CopyPlane(src_u, mStride / 2, dst_u, ycbcr.cstride,
+                (mCropWidth + 1) / 2, (mCropHeight + 1) / 2);
+        libyuv::CopyPlane(src_v, mStride / 2, dst_v, ycbcr.cstride,
+                (mCropWidth + 1) / 2, (mCropHeight + 1) / 2);
     } else if (mColorFormat == OMX_COLOR_FormatYUV420Planar16) {
         const uint8_t *src_y = (const uint8_t *)data + mCropTop * mStride + mCropLeft * 2;
         const uint8_t *src_u = (const uint8_t *)data + mStride * mHeight + mCropTop * mStride / 4;
@@ -332,26 +328,13 @@ std::list<FrameRenderTracker::Info> SoftwareRenderer::render(
         uint8_t *dst_y, *dst_u, *dst_v;
         initDstYUV(ycbcr, mCropTop, mCropLeft, &dst_y, &dst_u, &dst_v);
 
-        for (int y = 0; y < mCropHeight; ++y) {
-            for (int x = 0; x < mCropWidth; ++x) {
-                dst_y[x] = (uint8_t)(((uint16_t *)src_y)[x] >> 2);
-            }
-
-            src_y += mStride;
-            dst_y += ycbcr.ystride;
-        }
-
-        for (int y = 0; y < (mCropHeight + 1) / 2; ++y) {
-            for (int x = 0; x < (mCropWidth + 1) / 2; ++x) {
-                dst_u[x] = (uint8_t)(((uint16_t *)src_u)[x] >> 2);
-                dst_v[x] = (uint8_t)(((uint16_t *)src_v)[x] >> 2);
-            }
-
-            src_u += mStride / 2;
-            src_v += mStride / 2;
-            dst_u += ycbcr.cstride;
-            dst_v += ycbcr.cstride;
-        }
+        // A scale of 1 << 14 keeps the top 8 of 10 bits.
+        libyuv::Convert16To8Plane((const uint16_t *)src_y, mStride / 2,
+                dst_y, ycbcr.ystride, 1 << 14, mCropWidth, mCropHeight);
+        libyuv::Convert16To8Plane((const uint16_t *)src_u, mStride / 4,
+                dst_u, ycbcr.cstride, 1 << 14, (mCropWidth + 1) / 2, (mCropHeight + 1) / 2);
+        libyuv::Convert16To8Plane((const uint16_t *)src_v, mStride / 4,
+                dst_v, ycbcr.cstride, 1 << 14, (mCropWidth + 1) / 2, (mCropHeight + 1) / 2);
     } else if (mColorFormat == OMX_TI_COLOR_FormatYUV420PackedSemiPlanar
             || mColorFormat == OMX_COLOR_FormatYUV420SemiPlanar) {
         const uint8_t *src_y = (const uint8_t *)data;
@@ -364,24 +347,10 @@ std::list<FrameRenderTracker::Info> SoftwareRenderer::render(
         uint8_t *dst_y, *dst_u, *dst_v;
         initDstYUV(ycbcr, mCropTop, mCropLeft, &dst_y, &dst_u, &dst_v);
 
-        for (int y = 0; y < mCropHeight; ++y) {
-            memcpy(dst_y, src_y, mCropWidth);
-
-            src_y += mWidth;
-            dst_y += ycbcr.ystride;
-        }
-
-        for (int y = 0; y < (mCropHeight + 1) / 2; ++y) {
-            size_t tmp = (mCropWidth + 1) / 2;
-            for (size_t x = 0; x < tmp; ++x) {
-                dst_u[x] = src_uv[2 * x];
-                dst_v[x] = src_uv[2 * x + 1];
-            }
+        libyuv::CopyPlane(src_y, mWidth, dst_y, ycbcr.ystride, mCropWidth, mCropHeight);
 
-            src_uv += mWidth;
-            dst_u += ycbcr.cstride;
-            dst_v += ycbcr.cstride;
-        }
+        libyuv::SplitUVPlane(src_uv, mWidth, dst_u, ycbcr.cstride, dst_v, ycbcr.cstride,
+                (mCropWidth + 1) / 2, (mCropHeight + 1) / 2);
     } else if (mColorFormat == OMX_COLOR_Format24bitRGB888) {
         uint8_t* srcPtr = (uint8_t*)data + mWidth * mCropTop * 3 + mCropLeft * 3;
         uint8_t* dstPtr = (uint8_t*)dst + buf->stride * mCropTop * 3 + mCropLeft * 3;
@@ -392,19 +361,12 @@ std::list<FrameRenderTracker::Info> SoftwareRenderer::render(
             dstPtr += buf->stride * 3;
         }
     } else if (mColorFormat == OMX_COLOR_Format32bitARGB8888) {
-        uint8_t *srcPtr, *dstPtr;
+        uint8_t* srcPtr = (uint8_t*)data + mWidth * 4 * mCropTop + mCropLeft * 4;
+        uint8_t* dstPtr = (uint8_t*)dst + buf->stride * 4 * mCropTop + mCropLeft * 4;
 
-        for (size_t y = 0; y < (size_t)mCropHeight; ++y) {
-            srcPtr = (uint8_t*)data + mWidth * 4 * (y + mCropTop) + mCropLeft * 4;
-            dstPtr = (uint8_t*)dst + buf->stride * 4 * (y + mCropTop) + mCropLeft * 4;
-            for (size_t x = 0; x < (size_t)mCropWidth; ++x) {
-                uint8_t a = *srcPtr++;
-                for (size_t i = 0; i < 3; ++i) {   // copy RGB
-                    *dstPtr++ = *srcPtr++;
-                }
-                *dstPtr++ = a;  // alpha last (ARGB to RGBA)
-            }
-        }
+        // alpha last (ARGB to RGBA)
+        libyuv::ARGBShuffle(srcPtr, mWidth * 4, dstPtr, buf->stride * 4,
+                kShuffleARGBToRGBA, mCropWidth, mCropHeight);
     } else if (mColorFormat == OMX_COLOR_Format32BitRGBA8888) {
         uint8_t* srcPtr = (uint8_t*)data + mWidth * mCropTop * 4 + mCropLeft * 4;
         uint8_t* dstPtr = (uint8_t*)dst + buf->stride * mCropTop * 4 + mCropLeft * 4;
@@ -0,0 +1,116 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+#include <media/stagefright/ColorConverter.h>
+#include <media/stagefright/MediaCodecConstants.h>
+#include <media/stagefright/foundation/ColorUtils.h>
+
+#include <iterator>
+#include <string>
+#include <vector>
+
+using namespace android;
+
+struct FormatPair {
+    OMX_COLOR_FORMATTYPE src;
+    OMX_COLOR_FORMATTYPE dst;
+};
+
+// Every source/destination pair ColorConverter::isValid() accepts without a MediaImage2.
+static const FormatPair kFormatPairs[] = {
+    {OMX_COLOR_FormatYUV420Planar, OMX_COLOR_Format16bitRGB565},
+    {OMX_COLOR_FormatYUV420Planar, OMX_COLOR_Format32BitRGBA8888},
+    {OMX_COLOR_FormatYUV420Planar, OMX_COLOR_Format32bitBGRA8888},
+    {OMX_COLOR_FormatYUV420Planar16, OMX_COLOR_Format16bitRGB565},
+    {OMX_COLOR_FormatYUV420Planar16, OMX_COLOR_Format32BitRGBA8888},
+    {OMX_COLOR_FormatYUV420Planar16, OMX_COLOR_Format32bitBGRA8888},
+    {OMX_COLOR_FormatYUV420Planar16, OMX_COLOR_FormatYUV444Y410},
+    {OMX_COLOR_FormatCbYCrY, OMX_COLOR_Format16bitRGB565},
+    {OMX_COLOR_FormatYUV420SemiPlanar, OMX_COLOR_Format16bitRGB565},
+    {OMX_COLOR_FormatYUV420SemiPlanar, OMX_COLOR_Format32BitRGBA8888},
+    {OMX_COLOR_FormatYUV420SemiPlanar, OMX_COLOR_Format32bitBGRA8888},
+    {(OMX_COLOR_FORMATTYPE)OMX_QCOM_COLOR_FormatYVU420SemiPlanar, OMX_COLOR_Format16bitRGB565},
+    {(OMX_COLOR_FORMATTYPE)OMX_QCOM_COLOR_FormatYVU420SemiPlanar, OMX_COLOR_Format32BitRGBA8888},
+    {(OMX_COLOR_FORMATTYPE)COLOR_FormatYUVP010,
+            (OMX_COLOR_FORMATTYPE)COLOR_Format32bitABGR2101010},
+};
+
+static size_t bytesPerPixel(OMX_COLOR_FORMATTYPE format) {
+    switch ((int32_t)format) {
+        case OMX_COLOR_FormatYUV420Planar16:
+        case OMX_COLOR_FormatCbYCrY:
+        case OMX_COLOR_Format16bitRGB565:
+        case COLOR_FormatYUVP010:
+            return 2;
+        case OMX_COLOR_Format32BitRGBA8888:
+        case OMX_COLOR_Format32bitBGRA8888:
+        case OMX_COLOR_FormatYUV444Y410:
+        case COLOR_Format32bitABGR2101010:
+            return 4;
+        default:
+            return 1;
+    }
+}
+
+// Args: index into kFormatPairs, frame width, frame height.
+static void BM_ColorConvert(benchmark::State &state) {
+    const FormatPair &pair = kFormatPairs[state.range(0)];
+    const size_t width = state.range(1);
+    const size_t height = state.range(2);
+
+    ColorConverter converter(pair.src, pair.dst);
+    if (!converter.isValid()) {
+        state.SkipWithError("conversion not supported");
+        return;
+    }
+    converter.setSrcColorSpace(ColorUtils::kColorStandardBT709, ColorUtils::kColorRangeLimited,
+            ColorUtils::kColorTransferSMPTE_170M);
+
+    const size_t srcStride = width * bytesPerPixel(pair.src);
+    const size_t dstStride = width * bytesPerPixel(pair.dst);
+    // Large enough for a luma plane plus any chroma layout.
+    std::vector<uint8_t> srcBits(srcStride * height * 2, 0x80);
+    std::vector<uint8_t> dstBits(dstStride * height);
+
+    for (auto _ : state) {
+        status_t err = converter.convert(
+                srcBits.data(), width, height, srcStride, 0, 0, width - 1, height - 1,
+                dstBits.data(), width, height, dstStride, 0, 0, width - 1, height - 1);
+        if (err != OK) {
+            state.SkipWithError("conversion failed");
+            return;
+        }
+        benchmark::DoNotOptimize(dstBits.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * width * height);
+    state.SetLabel(std::string(asString_ColorFormat(pair.src, "?")) + " -> "
+            + asString_ColorFormat(pair.dst, "?"));
+}
+
+static void ColorConvertArgs(benchmark::internal::Benchmark *b) {
+    for (int64_t pair = 0; pair < (int64_t)std::size(kFormatPairs); ++pair) {
+        // Below and above the size at which the per-pixel paths go multi-threaded.
+        b->Args({pair, 640, 480});
+        b->Args({pair, 1920, 1080});
+        b->Args({pair, 3840, 2160});
+    }
+}
+
+BENCHMARK(BM_ColorConvert)->Apply(ColorConvertArgs);
+
+BENCHMARK_MAIN();
@@ -40,6 +40,7 @@
 
 #include <ctype.h>
 #include <inttypes.h>
+#include <math.h>
 
 namespace android {
 
@@ -61,7 +62,8 @@ struct LiveSession::BandwidthEstimator : public LiveSession::BandwidthBaseEstima
     bool estimateBandwidth(
             int32_t *bandwidth,
             bool *isStable = NULL,
-            int32_t *shortTermBps = NULL);
+            int32_t *shortTermBps = NULL,
+            int32_t *ewmaBps = NULL);
 
 private:
     // Bandwidth estimation parameters
@@ -70,6 +72,9 @@ private:
     static const int64_t kMinBandwidthHistoryWindowUs = 5000000LL; // 5 sec
     static const int64_t kMaxBandwidthHistoryWindowUs = 30000000LL; // 30 sec
     static const int64_t kMaxBandwidthHistoryAgeUs = 60000000LL; // 60 sec
+    // Half-lives of the exponentially weighted moving averages, in seconds of transfer
+    static constexpr double kFastEwmaHalfLifeSecs = 2.0;
+    static constexpr double kSlowEwmaHalfLifeSecs = 8.0;
 
     struct BandwidthEntry {
         int64_t mTimestampUs;
@@ -85,6 +90,12 @@ private:
     bool mIsStable;
     int64_t mTotalTransferTimeUs;
     size_t mTotalTransferBytes;
+    double mFastEwmaBps;
+    double mSlowEwmaBps;
+    double mEwmaTransferSecs;
+
+    static void updateEwma(double *ewmaBps, double halfLifeSecs, double secs, double bps);
+    int32_t getEwmaEstimate_l() const;
 
     DISALLOW_EVIL_CONSTRUCTORS(BandwidthEstimator);
 };
@@ -94,7 +105,26 @@ LiveSession::BandwidthEstimator::BandwidthEstimator() :
     mHasNewSample(false),
     mIsStable(true),
     mTotalTransferTimeUs(0),
-    mTotalTransferBytes(0) {
+    mTotalTransferBytes(0),
+    mFastEwmaBps(0),
+    mSlowEwmaBps(0),
+    mEwmaTransferSecs(0) {
+}
+
+// static
+void LiveSession::BandwidthEstimator::updateEwma(
+        double *ewmaBps, double halfLifeSecs, double secs, double bps) {
+    // weigh each sample by its transfer time
+    double alpha = pow(0.5, secs / halfLifeSecs);
+    *ewmaBps = alpha * *ewmaBps + (1 - alpha) * bps;
+}
+
+int32_t LiveSession::BandwidthEstimator::getEwmaEstimate_l() const {
+    // Both averages start at zero; scale them up until enough transfer time
+    // has been seen. The lower of the two follows drops quickly and rises slowly.
+    double fastBps = mFastEwmaBps / (1 - pow(0.5, mEwmaTransferSecs / kFastEwmaHalfLifeSecs));
+    double slowBps = mSlowEwmaBps / (1 - pow(0.5, mEwmaTransferSecs / kSlowEwmaHalfLifeSecs));
+    return (int32_t)(fastBps < slowBps ? fastBps : slowBps);
 }
 
 void LiveSession::BandwidthEstimator::addBandwidthMeasurement(
@@ -111,6 +141,14 @@ void LiveSession::BandwidthEstimator::addBandwidthMeasurement(
     mBandwidthHistory.push_back(entry);
     mHasNewSample = true;
 
+    if (delayUs > 0) {
+        double secs = delayUs / 1E6;
+        double bps = numBytes * 8E6 / delayUs;
+        updateEwma(&mFastEwmaBps, kFastEwmaHalfLifeSecs, secs, bps);
+        updateEwma(&mSlowEwmaBps, kSlowEwmaHalfLifeSecs, secs, bps);
+        mEwmaTransferSecs += secs;
+    }
+
     // Remove no more than 10% of total transfer time at a time
     // to avoid sudden jump on bandwidth estimation. There might
     // be long blocking reads that takes up signification time,
@@ -138,13 +176,17 @@ void LiveSession::BandwidthEstimator::addBandwidthMeasurement(
 }
 
 bool LiveSession::BandwidthEstimator::estimateBandwidth(
-        int32_t *bandwidthBps, bool *isStable, int32_t *shortTermBps) {
+        int32_t *bandwidthBps, bool *isStable, int32_t *shortTermBps, int32_t *ewmaBps) {
     AutoMutex autoLock(mLock);
 
-    if (mBandwidthHistory.size() < 2) {
+    if (mBandwidthHistory.size() < 2 || mEwmaTransferSecs <= 0) {
         return false;
     }
 
+    if (ewmaBps) {
+        *ewmaBps = getEwmaEstimate_l();
+    }
+
     if (!mHasNewSample) {
         *bandwidthBps = *(--mPrevEstimates.end());
         if (isStable) {
@@ -302,6 +344,13 @@ LiveSession::LiveSession(
       mUpSwitchMark(kUpSwitchMarkUs),
       mDownSwitchMark(kDownSwitchMarkUs),
       mUpSwitchMargin(kUpSwitchMarginUs),
+      mTargetDurationUs(-1LL),
+      mMinBufferedDurationUs(-1LL),
+      mStatsBandwidthBps(-1),
+      mStatsEwmaBandwidthBps(-1),
+      mNumUpSwitches(0),
+      mNumDownSwitches(0),
+      mNumDeferredUpSwitches(0),
       mFirstTimeUsValid(false),
       mFirstTimeUs(0),
       mLastSeekTimeUs(0),
@@ -736,6 +785,7 @@ void LiveSession::onMessageReceived(const sp<AMessage> &msg) {
                     mUpSwitchMark = min(kUpSwitchMarkUs, targetDurationUs * 7 / 4);
                     mDownSwitchMark = min(kDownSwitchMarkUs, targetDurationUs * 9 / 4);
                     mUpSwitchMargin = min(kUpSwitchMarginUs, targetDurationUs);
+                    mTargetDurationUs = targetDurationUs;
                     break;
                 }
 
@@ -1333,6 +1383,10 @@ void LiveSession::addBandwidthMeasurement(size_t numBytes, int64_t delayUs) {
     mBandwidthEstimator->addBandwidthMeasurement(numBytes, delayUs);
 }
 
+bool LiveSession::estimateBandwidth(int32_t *bandwidthBps) {
+    return mBandwidthEstimator->estimateBandwidth(bandwidthBps);
+}
+
 ssize_t LiveSession::getLowestValidBandwidthIndex() const {
     for (size_t index = 0; index < mBandwidthItems.size(); index++) {
         if (isBandwidthValid(mBandwidthItems[index])) {
@@ -1343,6 +1397,31 @@ ssize_t LiveSession::getLowestValidBandwidthIndex() const {
     return 0;
 }
 
+// Fetching restarts at the new variant after an up switch, and its first segment
+// adds nothing to the buffer until it is downloaded. Only switch if the buffer
+// holds enough to download that segment at the estimated bandwidth.
+bool LiveSession::canAffordUpSwitch(ssize_t bandwidthIndex, int32_t bandwidthBps) const {
+    if (mMinBufferedDurationUs < 0 || bandwidthBps <= 0) {
+        return true;
+    }
+    int64_t segmentDurationUs =
+            mTargetDurationUs > 0 ? mTargetDurationUs : kUpSwitchMarginUs;
+    int64_t downloadTimeUs = segmentDurationUs
+            * (int64_t)mBandwidthItems.itemAt(bandwidthIndex).mBandwidth / bandwidthBps;
+    return mMinBufferedDurationUs - downloadTimeUs > mUpSwitchMargin;
+}
+
+sp<AMessage> LiveSession::getStats() const {
+    sp<AMessage> stats = new AMessage;
+    Mutex::Autolock autoLock(mStatsLock);
+    stats->setInt32("bandwidth-bps", mStatsBandwidthBps);
+    stats->setInt32("bandwidth-ewma-bps", mStatsEwmaBandwidthBps);
+    stats->setInt32("up-switches", mNumUpSwitches);
+    stats->setInt32("down-switches", mNumDownSwitches);
+    stats->setInt32("deferred-up-switches", mNumDeferredUpSwitches);
+    return stats;
+}
+
 size_t LiveSession::getBandwidthIndex(int32_t bandwidthBps) {
     if (mBandwidthItems.size() < 2) {
         // shouldn't be here if we only have 1 bandwidth, check
@@ -2160,6 +2239,7 @@ void LiveSession::cancelBandwidthSwitch(bool resume) {
 bool LiveSession::checkBuffering(
         bool &underflow, bool &ready, bool &down, bool &up) {
     underflow = ready = down = up = false;
+    mMinBufferedDurationUs = -1LL;
 
     if (mReconfigurationInProgress) {
         ALOGV("Switch/Reconfig in progress, defer buffer polling");
@@ -2215,6 +2295,9 @@ bool LiveSession::checkBuffering(
             ++readyCount;
         }
         if (!mPacketSources[i]->isFinished(0)) {
+            if (mMinBufferedDurationUs < 0 || bufferedDurationUs < mMinBufferedDurationUs) {
+                mMinBufferedDurationUs = bufferedDurationUs;
+            }
             if (bufferedDurationUs < kUnderflowMarkMs * 1000LL) {
                 ++underflowCount;
             }
@@ -2326,15 +2409,20 @@ bool LiveSession::switchBandwidthIfNeeded(bool bufferHigh, bool bufferLow) {
         return false;
     }
 
-    int32_t bandwidthBps, shortTermBps;
+    int32_t bandwidthBps, shortTermBps, ewmaBps;
     bool isStable;
     if (mBandwidthEstimator->estimateBandwidth(
-            &bandwidthBps, &isStable, &shortTermBps)) {
+            &bandwidthBps, &isStable, &shortTermBps, &ewmaBps)) {
         ALOGV("bandwidth estimated at %.2f kbps, "
-                "stable %d, shortTermBps %.2f kbps",
-                bandwidthBps / 1024.0f, isStable, shortTermBps / 1024.0f);
+                "stable %d, shortTermBps %.2f kbps, ewmaBps %.2f kbps",
+                bandwidthBps / 1024.0f, isStable, shortTermBps / 1024.0f,
+                ewmaBps / 1024.0f);
         mLastBandwidthBps = bandwidthBps;
         mLastBandwidthStable = isStable;
+
+        Mutex::Autolock autoLock(mStatsLock);
+        mStatsBandwidthBps = bandwidthBps;
+        mStatsEwmaBandwidthBps = ewmaBps;
     } else {
         ALOGV("no bandwidth estimate.");
         return false;
@@ -2342,14 +2430,21 @@ bool LiveSession::switchBandwidthIfNeeded(bool bufferHigh, bool bufferLow) {
 
     int32_t curBandwidth = mBandwidthItems.itemAt(mCurBandwidthIndex).mBandwidth;
     // canSwithDown and canSwitchUp can't both be true.
-    // we only want to switch up when measured bw is 120% higher than current variant,
-    // and we only want to switch down when measured bw is below current variant.
+    // we only want to switch up when both the windowed average and the moving
+    // average are 120% higher than current variant, and we want to switch down
+    // when either of them is below current variant.
     bool canSwitchDown = bufferLow
-            && (bandwidthBps < (int32_t)curBandwidth);
+            && (bandwidthBps < (int32_t)curBandwidth || ewmaBps < (int32_t)curBandwidth);
     bool canSwitchUp = bufferHigh
-            && (bandwidthBps > (int32_t)curBandwidth * 12 / 10);
+            && (bandwidthBps > (int32_t)curBandwidth * 12 / 10)
+            && (ewmaBps > (int32_t)curBandwidth * 12 / 10);
 
     if (canSwitchDown || canSwitchUp) {
+        // pick the variant from the lower estimate, the moving average follows
+        // drops faster than the windowed one.
+        if (ewmaBps < bandwidthBps) {
+            bandwidthBps = ewmaBps;
+        }
         // bandwidth estimating has some delay, if we have to downswitch when
         // it hasn't stabilized, use the short term to guess real bandwidth,
         // since it may be dropping too fast.
@@ -2362,12 +2457,29 @@ bool LiveSession::switchBandwidthIfNeeded(bool bufferHigh, bool bufferLow) {
 
         ssize_t bandwidthIndex = getBandwidthIndex(bandwidthBps);
 
+        if (canSwitchUp && bandwidthIndex > mCurBandwidthIndex
+                && !canAffordUpSwitch(bandwidthIndex, bandwidthBps)) {
+            ALOGV("deferring up switch to %zd, buffer too low to fetch a segment",
+                    bandwidthIndex);
+            Mutex::Autolock autoLock(mStatsLock);
+            ++mNumDeferredUpSwitches;
+            return false;
+        }
+
         // it's possible that we're checking for canSwitchUp case, but the returned
         // bandwidthIndex is < mCurBandwidthIndex, as getBandwidthIndex() only uses 70%
         // of measured bw. In that case we don't want to do anything, since we have
         // both enough buffer and enough bw.
         if ((canSwitchUp && bandwidthIndex > mCurBandwidthIndex)
          || (canSwitchDown && bandwidthIndex < mCurBandwidthIndex)) {
+            {
+                Mutex::Autolock autoLock(mStatsLock);
+                if (canSwitchUp) {
+                    ++mNumUpSwitches;
+                } else {
+                    ++mNumDownSwitches;
+                }
+            }
             // if not yet prepared, just restart again with new bw index.
             // this is faster and playback experience is cleaner.
             changeConfiguration(
@@ -22,6 +22,7 @@
 #include <media/stagefright/foundation/AHandler.h>
 #include <media/mediaplayer.h>
 
+#include <utils/Mutex.h>
 #include <utils/String8.h>
 
 #include <mpeg2ts/ATSParser.h>
@@ -100,6 +101,9 @@ struct LiveSession : public AHandler {
     bool isSeekable() const;
     bool hasDynamicDuration() const;
 
+    // Returns the bandwidth estimates and variant switch counts of the session.
+    sp<AMessage> getStats() const;
+
     static const char *getKeyForStream(StreamType type);
     static const char *getNameForStream(StreamType type);
     static ATSParser::SourceType getSourceTypeForStream(StreamType type);
@@ -148,7 +152,8 @@ protected:
         virtual bool estimateBandwidth(
                 int32_t *bandwidth,
                 bool *isStable = NULL,
-                int32_t *shortTermBps = NULL) = 0;
+                int32_t *shortTermBps = NULL,
+                int32_t *ewmaBps = NULL) = 0;
     };
 
     struct BandwidthEstimator;
@@ -248,6 +253,18 @@ protected:
     int64_t mUpSwitchMark;
     int64_t mDownSwitchMark;
     int64_t mUpSwitchMargin;
+    int64_t mTargetDurationUs;
+    // Lowest buffered duration of the active audio/video streams at the last buffer
+    // poll, or -1 if none is buffering.
+    int64_t mMinBufferedDurationUs;
+
+    // Bandwidth adaptation statistics, read by getStats() from other threads.
+    mutable Mutex mStatsLock;
+    int32_t mStatsBandwidthBps;
+    int32_t mStatsEwmaBandwidthBps;
+    int32_t mNumUpSwitches;
+    int32_t mNumDownSwitches;
+    int32_t mNumDeferredUpSwitches;
 
     sp<AReplyToken> mDisconnectReplyID;
     sp<AReplyToken> mSeekReplyID;
@@ -278,6 +295,7 @@ protected:
     float getAbortThreshold(
             ssize_t currentBWIndex, ssize_t targetBWIndex) const;
     void addBandwidthMeasurement(size_t numBytes, int64_t delayUs);
+    bool estimateBandwidth(int32_t *bandwidthBps);
     virtual size_t getBandwidthIndex(int32_t bandwidthBps);
     ssize_t getLowestValidBandwidthIndex() const;
     HLSTime latestMediaSegmentStartTime() const;
@@ -300,6 +318,7 @@ protected:
             sp<AMessage> &msg, int64_t delayUs, bool *needResumeUntil);
 
     bool switchBandwidthIfNeeded(bool bufferHigh, bool bufferLow);
+    bool canAffordUpSwitch(ssize_t bandwidthIndex, int32_t bandwidthBps) const;
     bool tryBandwidthFallback();
 
     void schedulePollBuffering();
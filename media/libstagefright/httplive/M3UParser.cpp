@@ -17,6 +17,7 @@
 //#define LOG_NDEBUG 0
 #define LOG_TAG "M3UParser"
 #include <utils/Log.h>
+#include <utils/misc.h>
 
 #include "M3UParser.h"
 #include <binder/Parcel.h>
@@ -250,7 +251,8 @@ bool M3UParser::MediaGroup::getActiveURI(AString *uri, const char *baseURL) cons
 ////////////////////////////////////////////////////////////////////////////////
 
 M3UParser::M3UParser(
-        const char *baseURI, const void *data, size_t size)
+        const char *baseURI, const void *data, size_t size,
+        const sp<M3UParser> &previous)
     : mInitCheck(NO_INIT),
       mBaseURI(baseURI),
       mIsExtM3U(false),
@@ -262,8 +264,12 @@ M3UParser::M3UParser(
       mTargetDurationUs(-1LL),
       mDiscontinuitySeq(0),
       mDiscontinuityCount(0),
+      mCanBlockReload(false),
+      mCanSkipUntilUs(-1LL),
+      mPartTargetDurationUs(-1LL),
+      mSkippedSegments(0),
       mSelectedIndex(-1) {
-    mInitCheck = parse(data, size);
+    mInitCheck = parse(data, size, previous);
 }
 
 M3UParser::~M3UParser() {
@@ -306,6 +312,66 @@ void M3UParser::getSeqNumberRange(int32_t *firstSeq, int32_t *lastSeq) const {
     *lastSeq = mLastSeqNumber;
 }
 
+bool M3UParser::canBlockReload() const {
+    return mCanBlockReload;
+}
+
+int64_t M3UParser::getCanSkipUntilUs() const {
+    return mCanSkipUntilUs;
+}
+
+int64_t M3UParser::getPartTargetDurationUs() const {
+    return mPartTargetDurationUs;
+}
+
+int32_t M3UParser::getSkippedSegments() const {
+    return mSkippedSegments;
+}
+
+bool M3UParser::applyDeltaUpdate(const sp<M3UParser> &previous) {
+    if (mSkippedSegments == 0) {
+        return true;
+    }
+    if (previous == NULL || previous->mIsVariantPlaylist) {
+        return false;
+    }
+
+    int32_t firstSkippedSeq = mFirstSeqNumber - mSkippedSegments;
+    if (firstSkippedSeq < previous->mFirstSeqNumber
+            || mFirstSeqNumber - 1 > previous->mLastSeqNumber) {
+        ALOGW("previous playlist (%d .. %d) does not cover skipped segments (%d .. %d)",
+                previous->mFirstSeqNumber, previous->mLastSeqNumber,
+                firstSkippedSeq, mFirstSeqNumber - 1);
+        return false;
+    }
+
+    Vector<Item> items;
+    for (int32_t seq = firstSkippedSeq; seq < mFirstSeqNumber; ++seq) {
+        items.push(previous->mItems.itemAt(seq - previous->mFirstSeqNumber));
+    }
+
+    // The discontinuities of the skipped segments are not in this playlist, so
+    // continue numbering from the last skipped segment.
+    int32_t lastSkippedDiscontinuitySeq;
+    CHECK(items.top().mMeta->findInt32(
+            "discontinuity-sequence", &lastSkippedDiscontinuitySeq));
+    int32_t shift = lastSkippedDiscontinuitySeq - (int32_t)mDiscontinuitySeq;
+    for (size_t i = 0; shift != 0 && i < mItems.size(); ++i) {
+        // entries may be shared with the previous playlist
+        sp<AMessage> meta = mItems.itemAt(i).mMeta->dup();
+        int32_t discontinuitySeq;
+        CHECK(meta->findInt32("discontinuity-sequence", &discontinuitySeq));
+        meta->setInt32("discontinuity-sequence", discontinuitySeq + shift);
+        mItems.editItemAt(i).mMeta = meta;
+    }
+
+    items.appendVector(mItems);
+    mItems = items;
+    mFirstSeqNumber = firstSkippedSeq;
+    mSkippedSegments = 0;
+    return true;
+}
+
 sp<AMessage> M3UParser::meta() {
     return mMeta;
 }
@@ -566,7 +632,79 @@ AString M3UParser::MediaGroup::Media::makeURL(const char *baseURL) const {
     return out;
 }
 
-status_t M3UParser::parse(const void *_data, size_t size) {
+const M3UParser::Item *M3UParser::findReusableItem(const sp<M3UParser> &previous) const {
+    int32_t mediaSequence;
+    if (previous == NULL || previous->mIsVariantPlaylist || mIsVariantPlaylist
+            || mMeta == NULL || !mMeta->findInt32("media-sequence", &mediaSequence)) {
+        return NULL;
+    }
+    int32_t seq = mediaSequence + mSkippedSegments + (int32_t)mItems.size();
+    if (seq < previous->mFirstSeqNumber || seq > previous->mLastSeqNumber) {
+        return NULL;
+    }
+    return &previous->mItems.itemAt(seq - previous->mFirstSeqNumber);
+}
+
+// static
+bool M3UParser::isReusableItemMatch(
+        const Item &item, const AString &uri, const sp<AMessage> &itemMeta,
+        int32_t discontinuitySeq) {
+    int32_t itemDiscontinuitySeq;
+    if (item.mURI != uri
+            || !item.mMeta->findInt32("discontinuity-sequence", &itemDiscontinuitySeq)
+            || itemDiscontinuitySeq != discontinuitySeq) {
+        return false;
+    }
+
+    // |itemMeta| holds what was parsed of the entry outside of its #EXTINF.
+    static const char *kInt32Keys[] = { "discontinuity" };
+    static const char *kInt64Keys[] = { "range-offset", "range-length" };
+    static const char *kStringKeys[] = { "cipher-method", "cipher-uri", "cipher-iv" };
+    for (size_t i = 0; i < NELEM(kInt32Keys); ++i) {
+        int32_t x, y;
+        bool hasX = item.mMeta->findInt32(kInt32Keys[i], &x);
+        bool hasY = itemMeta != NULL && itemMeta->findInt32(kInt32Keys[i], &y);
+        if (hasX != hasY || (hasX && x != y)) {
+            return false;
+        }
+    }
+    for (size_t i = 0; i < NELEM(kInt64Keys); ++i) {
+        int64_t x, y;
+        bool hasX = item.mMeta->findInt64(kInt64Keys[i], &x);
+        bool hasY = itemMeta != NULL && itemMeta->findInt64(kInt64Keys[i], &y);
+        if (hasX != hasY || (hasX && x != y)) {
+            return false;
+        }
+    }
+    for (size_t i = 0; i < NELEM(kStringKeys); ++i) {
+        AString x, y;
+        bool hasX = item.mMeta->findString(kStringKeys[i], &x);
+        bool hasY = itemMeta != NULL && itemMeta->findString(kStringKeys[i], &y);
+        if (hasX != hasY || (hasX && x != y)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// static
+bool M3UParser::isParsedTag(const AString &line) {
+    static const char *kTags[] = {
+        "#EXT-X-TARGETDURATION", "#EXT-X-MEDIA-SEQUENCE", "#EXT-X-KEY",
+        "#EXT-X-ENDLIST", "#EXT-X-PLAYLIST-TYPE", "#EXTINF", "#EXT-X-DISCONTINUITY",
+        "#EXT-X-STREAM-INF", "#EXT-X-BYTERANGE", "#EXT-X-MEDIA",
+        "#EXT-X-SERVER-CONTROL", "#EXT-X-PART-INF", "#EXT-X-SKIP",
+    };
+    for (size_t i = 0; i < NELEM(kTags); ++i) {
+        if (line.startsWith(kTags[i])) {
+            return true;
+        }
+    }
+    return false;
+}
+
+status_t M3UParser::parse(
+        const void *_data, size_t size, const sp<M3UParser> &previous) {
     int32_t lineNo = 0;
 
     sp<AMessage> itemMeta;
@@ -574,6 +712,16 @@ status_t M3UParser::parse(const void *_data, size_t size) {
     const char *data = (const char *)_data;
     size_t offset = 0;
     uint64_t segmentRangeOffset = 0;
+
+    // While |reusedItem| is set, the entry being read is expected to be the same as
+    // in |previous| and its #EXTINF is not parsed. If it turns out to differ, parsing
+    // resumes at the #EXTINF line, at |reuseOffset|.
+    const Item *reusedItem = NULL;
+    size_t reuseOffset = 0;
+    int32_t reuseLineNo = 0;
+    uint64_t reuseRangeOffset = 0;
+    ssize_t reparseOffset = -1;
+
     while (offset < size) {
         size_t offsetLF = offset;
         while (offsetLF < size && data[offsetLF] != '\n') {
@@ -598,6 +746,27 @@ status_t M3UParser::parse(const void *_data, size_t size) {
             mIsExtM3U = true;
         }
 
+        if (reusedItem != NULL && (!line.startsWith("#")
+                || (isParsedTag(line) && !line.startsWith("#EXT-X-BYTERANGE")))) {
+            if (!line.startsWith("#") && isReusableItemMatch(*reusedItem, line, itemMeta,
+                    mDiscontinuitySeq + mDiscontinuityCount)) {
+                mItems.push(*reusedItem);
+                itemMeta.clear();
+                reusedItem = NULL;
+
+                offset = offsetLF + 1;
+                ++lineNo;
+                continue;
+            }
+
+            offset = reuseOffset;
+            lineNo = reuseLineNo;
+            segmentRangeOffset = reuseRangeOffset;
+            reparseOffset = reuseOffset;
+            reusedItem = NULL;
+            continue;
+        }
+
         if (mIsExtM3U) {
             status_t err = OK;
 
@@ -624,7 +793,14 @@ status_t M3UParser::parse(const void *_data, size_t size) {
                 if (mIsVariantPlaylist) {
                     return ERROR_MALFORMED;
                 }
-                err = parseMetaDataDuration(line, &itemMeta, "durationUs");
+                if ((ssize_t)offset != reparseOffset
+                        && (reusedItem = findReusableItem(previous)) != NULL) {
+                    reuseOffset = offset;
+                    reuseLineNo = lineNo;
+                    reuseRangeOffset = segmentRangeOffset;
+                } else {
+                    err = parseMetaDataDuration(line, &itemMeta, "durationUs");
+                }
             } else if (line.startsWith("#EXT-X-DISCONTINUITY-SEQUENCE")) {
                 if (mIsVariantPlaylist) {
                     return ERROR_MALFORMED;
@@ -672,6 +848,13 @@ status_t M3UParser::parse(const void *_data, size_t size) {
                 }
             } else if (line.startsWith("#EXT-X-MEDIA")) {
                 err = parseMedia(line);
+            } else if (line.startsWith("#EXT-X-SERVER-CONTROL")
+                    || line.startsWith("#EXT-X-PART-INF")
+                    || line.startsWith("#EXT-X-SKIP")) {
+                if (mIsVariantPlaylist) {
+                    return ERROR_MALFORMED;
+                }
+                err = parseLowLatencyInfo(line);
             }
 
             if (err != OK) {
@@ -729,6 +912,8 @@ status_t M3UParser::parse(const void *_data, size_t size) {
         if (mMeta != NULL) {
             mMeta->findInt32("media-sequence", &mFirstSeqNumber);
         }
+        // EXT-X-MEDIA-SEQUENCE numbers the first segment, even if it was skipped.
+        mFirstSeqNumber += mSkippedSegments;
         mLastSeqNumber = mFirstSeqNumber + mItems.size() - 1;
     }
 
@@ -999,6 +1184,66 @@ status_t M3UParser::parseCipherInfo(
     return OK;
 }
 
+status_t M3UParser::parseLowLatencyInfo(const AString &line) {
+    ssize_t colonPos = line.find(":");
+
+    if (colonPos < 0) {
+        return ERROR_MALFORMED;
+    }
+
+    size_t offset = colonPos + 1;
+
+    while (offset < line.size()) {
+        ssize_t end = FindNextUnquoted(line, ',', offset);
+        if (end < 0) {
+            end = line.size();
+        }
+
+        AString attr(line, offset, end - offset);
+        attr.trim();
+
+        offset = end + 1;
+
+        ssize_t equalPos = attr.find("=");
+        if (equalPos < 0) {
+            continue;
+        }
+
+        AString key(attr, 0, equalPos);
+        key.trim();
+
+        AString val(attr, equalPos + 1, attr.size() - equalPos - 1);
+        val.trim();
+
+        ALOGV("key=%s value=%s", key.c_str(), val.c_str());
+
+        key.tolower();
+
+        if (key == "can-block-reload") {
+            mCanBlockReload = !strcasecmp(val.c_str(), "YES");
+        } else if (key == "can-skip-until" || key == "part-target") {
+            double x;
+            if (ParseDouble(val.c_str(), &x) != OK || x < 0) {
+                return ERROR_MALFORMED;
+            }
+            int64_t us = (int64_t)(x * 1E6);
+            if (key == "can-skip-until") {
+                mCanSkipUntilUs = us;
+            } else {
+                mPartTargetDurationUs = us;
+            }
+        } else if (key == "skipped-segments") {
+            int32_t x;
+            if (ParseInt32(val.c_str(), &x) != OK || x < 0) {
+                return ERROR_MALFORMED;
+            }
+            mSkippedSegments = x;
+        }
+    }
+
+    return OK;
+}
+
 AString M3UParser::getFullCipherUri(const AString &partial) {
     AString full;
     if (MakeURL(mBaseURI.c_str(), partial.c_str(), &full)) {
@@ -27,7 +27,10 @@
 namespace android {
 
 struct M3UParser : public RefBase {
-    M3UParser(const char *baseURI, const void *data, size_t size);
+    // If |previous| is an earlier version of the same media playlist, the entries of
+    // segments it already lists are shared with it instead of being parsed again.
+    M3UParser(const char *baseURI, const void *data, size_t size,
+            const sp<M3UParser> &previous = NULL);
 
     status_t initCheck() const;
 
@@ -40,6 +43,17 @@ struct M3UParser : public RefBase {
     int32_t getFirstSeqNumber() const;
     void getSeqNumberRange(int32_t *firstSeq, int32_t *lastSeq) const;
 
+    // Low-latency HLS server control (EXT-X-SERVER-CONTROL, EXT-X-PART-INF).
+    bool canBlockReload() const;
+    int64_t getCanSkipUntilUs() const;      // -1 if delta updates are not supported
+    int64_t getPartTargetDurationUs() const;  // -1 if the playlist has no parts
+
+    // Number of segments left out of a delta update (EXT-X-SKIP). The sequence number
+    // range only covers the segments present until they are filled in from |previous|,
+    // which fails if it does not list all of them.
+    int32_t getSkippedSegments() const;
+    bool applyDeltaUpdate(const sp<M3UParser> &previous);
+
     sp<AMessage> meta();
 
     size_t size();
@@ -81,6 +95,10 @@ private:
     int64_t mTargetDurationUs;
     size_t mDiscontinuitySeq;
     int32_t mDiscontinuityCount;
+    bool mCanBlockReload;
+    int64_t mCanSkipUntilUs;
+    int64_t mPartTargetDurationUs;
+    int32_t mSkippedSegments;
 
     sp<AMessage> mMeta;
     Vector<Item> mItems;
@@ -89,7 +107,12 @@ private:
     // Media groups keyed by group ID.
     KeyedVector<AString, sp<MediaGroup> > mMediaGroups;
 
-    status_t parse(const void *data, size_t size);
+    status_t parse(const void *data, size_t size, const sp<M3UParser> &previous);
+    const Item *findReusableItem(const sp<M3UParser> &previous) const;
+    static bool isReusableItemMatch(
+            const Item &item, const AString &uri, const sp<AMessage> &itemMeta,
+            int32_t discontinuitySeq);
+    static bool isParsedTag(const AString &line);
 
     static status_t parseMetaData(
             const AString &line, sp<AMessage> *meta, const char *key);
@@ -111,6 +134,8 @@ private:
 
     static status_t parseDiscontinuitySequence(const AString &line, size_t *seq);
 
+    status_t parseLowLatencyInfo(const AString &line);
+
     static status_t ParseInt32(const char *s, int32_t *x);
     static status_t ParseDouble(const char *s, double *x);
 
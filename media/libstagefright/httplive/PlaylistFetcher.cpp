@@ -24,6 +24,7 @@
 #include "HTTPDownloader.h"
 #include "LiveSession.h"
 #include "M3UParser.h"
+#include "SegmentPrefetcher.h"
 #include <ID3.h>
 #include <mpeg2ts/AnotherPacketSource.h>
 #include <mpeg2ts/HlsSampleDecryptor.h>
@@ -55,6 +56,7 @@ const int64_t PlaylistFetcher::kMinBufferedDurationUs = 30000000LL;
 const int64_t PlaylistFetcher::kMaxMonitorDelayUs = 3000000LL;
 // LCM of 188 (size of a TS packet) & 1k works well
 const int32_t PlaylistFetcher::kDownloadBlockSize = 47 * 1024;
+const size_t PlaylistFetcher::kMaxPrefetchSegments = 3;
 
 struct PlaylistFetcher::DownloadState : public RefBase {
     DownloadState();
@@ -180,15 +182,22 @@ PlaylistFetcher::PlaylistFetcher(
       mSampleAesKeyItemChanged(false),
       mThresholdRatio(-1.0f),
       mDownloadState(new DownloadState()),
+      mLastSegmentBps(0),
       mHasMetadata(false) {
     memset(mPlaylistHash, 0, sizeof(mPlaylistHash));
     mHTTPDownloader = mSession->getHTTPDownloader();
+    mSegmentPrefetcher = new SegmentPrefetcher(mSession->getHTTPDownloader());
 
     memset(mKeyData, 0, sizeof(mKeyData));
     memset(mAESInitVec, 0, sizeof(mAESInitVec));
 }
 
 PlaylistFetcher::~PlaylistFetcher() {
+    if (mPrefetchLooper != NULL) {
+        mSegmentPrefetcher->cancel();
+        mPrefetchLooper->unregisterHandler(mSegmentPrefetcher->id());
+        mPrefetchLooper->stop();
+    }
 }
 
 int32_t PlaylistFetcher::getFetcherID() const {
@@ -528,6 +537,7 @@ void PlaylistFetcher::setStoppingThreshold(float thresholdRatio, bool disconnect
     }
     if (disconnect) {
         mHTTPDownloader->disconnect();
+        mSegmentPrefetcher->cancel();
     }
 }
 
@@ -538,6 +548,7 @@ void PlaylistFetcher::resetStoppingThreshold(bool disconnect) {
     }
     if (disconnect) {
         mHTTPDownloader->disconnect();
+        mSegmentPrefetcher->cancel();
     } else {
         // allow reconnect
         mHTTPDownloader->reconnect();
@@ -938,11 +949,46 @@ void PlaylistFetcher::onMonitorQueue() {
     }
 }
 
-status_t PlaylistFetcher::refreshPlaylist() {
-    if (delayUsToRefreshPlaylist() <= 0) {
+// Appends an LL-HLS delivery directive to the query of a playlist uri. Directives
+// must be appended in lexical order.
+static void appendDeliveryDirective(AString *uri, const AString &directive) {
+    uri->append(uri->find("?") < 0 ? "?" : "&");
+    uri->append(directive);
+}
+
+status_t PlaylistFetcher::refreshPlaylist(bool blockForNextSegment) {
+    bool blockingReload = false;
+    if (blockForNextSegment && mPlaylist != NULL && mPlaylist->canBlockReload()
+            && !mPlaylist->isComplete() && mRefreshState == INITIAL_MINIMUM_RELOAD_DELAY) {
+        int32_t firstSeqNumberInPlaylist, lastSeqNumberInPlaylist;
+        mPlaylist->getSeqNumberRange(&firstSeqNumberInPlaylist, &lastSeqNumberInPlaylist);
+        blockingReload = mSeqNumber > lastSeqNumberInPlaylist;
+    }
+
+    if (blockingReload || delayUsToRefreshPlaylist() <= 0) {
+        AString uri = mURI;
+        if (blockingReload) {
+            appendDeliveryDirective(&uri, AStringPrintf("_HLS_msn=%d", mSeqNumber));
+        }
+        // ask for a delta update if the playlist we have is recent enough to fill in
+        // the segments the server leaves out
+        bool deltaUpdate = mPlaylist != NULL && !mPlaylist->isComplete()
+                && mPlaylist->getCanSkipUntilUs() > 0
+                && ALooper::GetNowUs() - mLastPlaylistFetchTimeUs
+                        < mPlaylist->getCanSkipUntilUs() / 2;
+        if (deltaUpdate) {
+            appendDeliveryDirective(&uri, AString("_HLS_skip=YES"));
+        }
+
         bool unchanged;
         sp<M3UParser> playlist = mHTTPDownloader->fetchPlaylist(
-                mURI.c_str(), mPlaylistHash, &unchanged);
+                uri.c_str(), mPlaylistHash, &unchanged, mPlaylist);
+
+        if (playlist != NULL && !playlist->applyDeltaUpdate(mPlaylist)) {
+            FLOGV("cannot apply delta update, reloading full playlist");
+            playlist = mHTTPDownloader->fetchPlaylist(
+                    mURI.c_str(), mPlaylistHash, &unchanged, mPlaylist);
+        }
 
         if (playlist == NULL) {
             if (unchanged) {
@@ -1077,7 +1123,7 @@ bool PlaylistFetcher::initDownloadState(
         sp<AMessage> &itemMeta,
         int32_t &firstSeqNumberInPlaylist,
         int32_t &lastSeqNumberInPlaylist) {
-    status_t err = refreshPlaylist();
+    status_t err = refreshPlaylist(true /* blockForNextSegment */);
     firstSeqNumberInPlaylist = 0;
     lastSeqNumberInPlaylist = 0;
     bool discontinuity = false;
@@ -1335,6 +1381,63 @@ bool PlaylistFetcher::initDownloadState(
     return true;
 }
 
+size_t PlaylistFetcher::countSegmentsToPrefetch() {
+    if (mStartup || mStopParams != NULL || mLastSegmentBps <= 0
+            || !(mStreamTypeMask
+                    & (LiveSession::STREAMTYPE_AUDIO | LiveSession::STREAMTYPE_VIDEO))) {
+        return 0;
+    }
+
+    // Prefetching opens a second connection, which only helps while the bandwidth
+    // leaves headroom over the bitrate of the stream; otherwise it takes bandwidth
+    // away from the segment that is needed next.
+    int32_t bandwidthBps;
+    if (!mSession->estimateBandwidth(&bandwidthBps)) {
+        return 0;
+    }
+    int64_t numSegments = bandwidthBps / mLastSegmentBps - 1;
+    if (numSegments <= 0) {
+        return 0;
+    }
+    return numSegments < (int64_t)kMaxPrefetchSegments
+            ? (size_t)numSegments : kMaxPrefetchSegments;
+}
+
+void PlaylistFetcher::prefetchSegments(
+        int32_t firstSeqNumberInPlaylist, int32_t lastSeqNumberInPlaylist) {
+    size_t numSegments = countSegmentsToPrefetch();
+    if (numSegments == 0) {
+        return;
+    }
+
+    if (mPrefetchLooper == NULL) {
+        mPrefetchLooper = new ALooper;
+        mPrefetchLooper->setName("HLSPrefetcher");
+        mPrefetchLooper->start();
+        mPrefetchLooper->registerHandler(mSegmentPrefetcher);
+    }
+
+    for (size_t i = 1; i <= numSegments; ++i) {
+        int32_t seqNumber = mSeqNumber + (int32_t)i;
+        if (seqNumber > lastSeqNumberInPlaylist) {
+            break;
+        }
+
+        AString uri;
+        sp<AMessage> itemMeta;
+        if (!mPlaylist->itemAt(seqNumber - firstSeqNumberInPlaylist, &uri, &itemMeta)) {
+            break;
+        }
+        int64_t rangeOffset, rangeLength;
+        if (!itemMeta->findInt64("range-offset", &rangeOffset)
+                || !itemMeta->findInt64("range-length", &rangeLength)) {
+            rangeOffset = 0;
+            rangeLength = -1;
+        }
+        mSegmentPrefetcher->prefetch(uri, rangeOffset, rangeLength);
+    }
+}
+
 void PlaylistFetcher::onDownloadNext() {
     AString uri;
     sp<AMessage> itemMeta;
@@ -1372,16 +1475,34 @@ void PlaylistFetcher::onDownloadNext() {
         range_length = -1;
     }
 
+    // use the segment if it was downloaded ahead, and keep the following ones coming
+    sp<ABuffer> prefetched;
+    int64_t prefetchTimeUs = 0;
+    if (connectHTTP) {
+        prefetched = mSegmentPrefetcher->take(
+                uri, range_offset, range_length, &prefetchTimeUs);
+        prefetchSegments(firstSeqNumberInPlaylist, lastSeqNumberInPlaylist);
+    }
+
     // block-wise download
     bool shouldPause = false;
     ssize_t bytesRead;
     mLastIDRTimeUs = -1;
     do {
-        int64_t startUs = ALooper::GetNowUs();
-        bytesRead = mHTTPDownloader->fetchBlock(
-                uri.c_str(), &buffer, range_offset, range_length, kDownloadBlockSize,
-                NULL /* actualURL */, connectHTTP);
-        int64_t delayUs = ALooper::GetNowUs() - startUs;
+        bool wholeSegment = prefetched != NULL;
+        int64_t delayUs;
+        if (wholeSegment) {
+            buffer = prefetched;
+            prefetched.clear();
+            bytesRead = buffer->size();
+            delayUs = prefetchTimeUs;
+        } else {
+            int64_t startUs = ALooper::GetNowUs();
+            bytesRead = mHTTPDownloader->fetchBlock(
+                    uri.c_str(), &buffer, range_offset, range_length, kDownloadBlockSize,
+                    NULL /* actualURL */, connectHTTP);
+            delayUs = ALooper::GetNowUs() - startUs;
+        }
 
         if (bytesRead == ERROR_NOT_CONNECTED) {
             return;
@@ -1394,9 +1515,11 @@ void PlaylistFetcher::onDownloadNext() {
         }
 
         // add sample for bandwidth estimation, excluding samples from subtitles (as
-        // its too small), or during startup/resumeUntil (when we could have more than
-        // one connection open which affects bandwidth)
+        // its too small), or during startup/resumeUntil or while segments are being
+        // prefetched (when we could have more than one connection open which affects
+        // bandwidth)
         if (!mStartup && mStopParams == NULL && bytesRead > 0
+                && (wholeSegment || mSegmentPrefetcher->countQueued() == 0)
                 && (mStreamTypeMask
                         & (LiveSession::STREAMTYPE_AUDIO
                         | LiveSession::STREAMTYPE_VIDEO))) {
@@ -1460,6 +1583,10 @@ void PlaylistFetcher::onDownloadNext() {
             notifyError(err);
             return;
         }
+        if (wholeSegment) {
+            // nothing left to fetch, and no connection to resume a pause from
+            bytesRead = 0;
+        }
         // If we're switching, post start notification
         // this should only be posted when the last chunk is full processed by TSParser
         if (mSeekMode != LiveSession::kSeekModeExactPosition && startUp != mStartup) {
@@ -1519,6 +1646,11 @@ void PlaylistFetcher::onDownloadNext() {
         return;
     }
 
+    int64_t segmentDurationUs;
+    if (itemMeta->findInt64("durationUs", &segmentDurationUs) && segmentDurationUs > 0) {
+        mLastSegmentBps = buffer->size() * 8000000LL / segmentDurationUs;
+    }
+
     if (tsBuffer != NULL) {
         AString method;
         CHECK(buffer->meta()->findString("cipher-method", &method));
@@ -1753,15 +1885,10 @@ status_t PlaylistFetcher::extractAndQueueAccessUnitsFromTs(const sp<ABuffer> &bu
         mSampleAesKeyItemChanged = false;
     }
 
-    size_t offset = 0;
-    while (offset + 188 <= buffer->size()) {
-        status_t err = mTSParser->feedTSPacket(buffer->data() + offset, 188);
-
-        if (err != OK) {
-            return err;
-        }
-
-        offset += 188;
+    size_t offset = buffer->size() - buffer->size() % 188;
+    status_t err = mTSParser->feedTSPackets(buffer->data(), offset);
+    if (err != OK) {
+        return err;
     }
     // setRange to indicate consumed bytes.
     buffer->setRange(buffer->offset() + offset, buffer->size() - offset);
@@ -1824,7 +1951,7 @@ status_t PlaylistFetcher::extractAndQueueAccessUnitsFromTs(const sp<ABuffer> &bu
         }
     }
 
-    status_t err = OK;
+    err = OK;
     mLastIDRFound = false;
     bool hasAvcOrHevcSource = false;
     for (size_t i = mPacketSources.size(); i > 0;) {
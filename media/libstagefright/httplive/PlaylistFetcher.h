@@ -32,11 +32,14 @@ class DataSource;
 struct HTTPBase;
 struct LiveDataSource;
 struct M3UParser;
+struct SegmentPrefetcher;
 class String8;
 
 struct PlaylistFetcher : public AHandler {
     static const int64_t kMinBufferedDurationUs;
     static const int32_t kDownloadBlockSize;
+    // Most segments downloaded ahead of the one being fetched.
+    static const size_t kMaxPrefetchSegments;
     static const int64_t kFetcherResumeThreshold;
 
     enum {
@@ -189,6 +192,12 @@ protected:
 
     sp<DownloadState> mDownloadState;
 
+    // Downloads the segments after the current one on its own looper and connection.
+    sp<ALooper> mPrefetchLooper;
+    sp<SegmentPrefetcher> mSegmentPrefetcher;
+    // Bitrate of the last segment downloaded, derived from its size and duration.
+    int64_t mLastSegmentBps;
+
     bool mHasMetadata;
 
     // Set first to true if decrypting the first segment of a playlist segment. When
@@ -212,7 +221,9 @@ protected:
     bool shouldPauseDownload();
 
     int64_t delayUsToRefreshPlaylist() const;
-    status_t refreshPlaylist();
+    // If |blockForNextSegment| is set and the server supports blocking playlist reload,
+    // the request waits for the segment mSeqNumber to be published.
+    status_t refreshPlaylist(bool blockForNextSegment = false);
 
     // Returns the media time in us of the segment specified by seqNumber.
     // This is computed by summing the durations of all segments before it.
@@ -233,6 +244,9 @@ protected:
             sp<AMessage> &itemMeta,
             int32_t &firstSeqNumberInPlaylist,
             int32_t &lastSeqNumberInPlaylist);
+    size_t countSegmentsToPrefetch();
+    void prefetchSegments(
+            int32_t firstSeqNumberInPlaylist, int32_t lastSeqNumberInPlaylist);
 
     // Resume a fetcher to continue until the stopping point stored in msg.
     status_t onResumeUntil(const sp<AMessage> &msg);
@@ -0,0 +1,188 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "SegmentPrefetcher"
+#include <utils/Log.h>
+
+#include "SegmentPrefetcher.h"
+#include "HTTPDownloader.h"
+
+#include <media/stagefright/foundation/ABuffer.h>
+#include <media/stagefright/foundation/ADebug.h>
+#include <media/stagefright/foundation/ALooper.h>
+#include <media/stagefright/foundation/AMessage.h>
+
+namespace android {
+
+SegmentPrefetcher::SegmentPrefetcher(const sp<HTTPDownloader> &downloader)
+    : mDownloader(downloader),
+      mNextID(0),
+      mCancelled(false) {
+}
+
+SegmentPrefetcher::~SegmentPrefetcher() {
+}
+
+void SegmentPrefetcher::prefetch(
+        const AString &uri, int64_t rangeOffset, int64_t rangeLength) {
+    {
+        Mutex::Autolock autoLock(mLock);
+        for (List<Segment>::iterator it = mSegments.begin(); it != mSegments.end(); ++it) {
+            if (it->mURI == uri && it->mRangeOffset == rangeOffset
+                    && it->mRangeLength == rangeLength) {
+                return;
+            }
+        }
+
+        if (mCancelled) {
+            mDownloader->reconnect();
+            mCancelled = false;
+        }
+
+        Segment segment;
+        segment.mID = mNextID++;
+        segment.mURI = uri;
+        segment.mRangeOffset = rangeOffset;
+        segment.mRangeLength = rangeLength;
+        segment.mStarted = false;
+        segment.mDone = false;
+        segment.mStatus = OK;
+        segment.mFetchTimeUs = 0;
+        mSegments.push_back(segment);
+    }
+
+    (new AMessage(kWhatFetch, this))->post();
+}
+
+size_t SegmentPrefetcher::countQueued() {
+    Mutex::Autolock autoLock(mLock);
+    return mSegments.size();
+}
+
+sp<ABuffer> SegmentPrefetcher::take(
+        const AString &uri, int64_t rangeOffset, int64_t rangeLength,
+        int64_t *fetchTimeUs) {
+    Mutex::Autolock autoLock(mLock);
+
+    List<Segment>::iterator it = mSegments.begin();
+    while (it != mSegments.end()
+            && !(it->mURI == uri && it->mRangeOffset == rangeOffset
+                    && it->mRangeLength == rangeLength)) {
+        ++it;
+    }
+    if (it == mSegments.end()) {
+        dropSegments_l();
+        return NULL;
+    }
+    // Segments queued before this one will not be asked for any more.
+    mSegments.erase(mSegments.begin(), it);
+
+    int32_t id = it->mID;
+    for (;;) {
+        it = mSegments.begin();
+        if (it == mSegments.end() || it->mID != id) {
+            // cancelled while waiting
+            return NULL;
+        }
+        if (it->mDone) {
+            break;
+        }
+        mCondition.wait(mLock);
+    }
+
+    sp<ABuffer> buffer = it->mStatus == OK ? it->mBuffer : NULL;
+    *fetchTimeUs = it->mFetchTimeUs;
+    mSegments.erase(it);
+    return buffer;
+}
+
+void SegmentPrefetcher::cancel() {
+    Mutex::Autolock autoLock(mLock);
+    dropSegments_l();
+}
+
+void SegmentPrefetcher::dropSegments_l() {
+    bool started = false;
+    for (List<Segment>::iterator it = mSegments.begin(); it != mSegments.end(); ++it) {
+        started = started || (it->mStarted && !it->mDone);
+    }
+    mSegments.clear();
+    mCondition.broadcast();
+
+    if (started) {
+        // abort the download in progress; the next prefetch reconnects.
+        mDownloader->disconnect();
+        mCancelled = true;
+    }
+}
+
+void SegmentPrefetcher::onMessageReceived(const sp<AMessage> &msg) {
+    switch (msg->what()) {
+        case kWhatFetch:
+        {
+            onFetch();
+            break;
+        }
+
+        default:
+            TRESPASS();
+    }
+}
+
+void SegmentPrefetcher::onFetch() {
+    int32_t id;
+    AString uri;
+    int64_t rangeOffset, rangeLength;
+    {
+        Mutex::Autolock autoLock(mLock);
+        List<Segment>::iterator it = mSegments.begin();
+        while (it != mSegments.end() && it->mStarted) {
+            ++it;
+        }
+        if (it == mSegments.end()) {
+            return;
+        }
+        it->mStarted = true;
+        id = it->mID;
+        uri = it->mURI;
+        rangeOffset = it->mRangeOffset;
+        rangeLength = it->mRangeLength;
+    }
+
+    int64_t startUs = ALooper::GetNowUs();
+    sp<ABuffer> buffer;
+    ssize_t bytesRead = mDownloader->fetchBlock(
+            uri.c_str(), &buffer, rangeOffset, rangeLength, 0 /* block_size */,
+            NULL /* actualURL */, true /* reconnect */);
+    int64_t fetchTimeUs = ALooper::GetNowUs() - startUs;
+
+    Mutex::Autolock autoLock(mLock);
+    for (List<Segment>::iterator it = mSegments.begin(); it != mSegments.end(); ++it) {
+        if (it->mID == id) {
+            it->mDone = true;
+            it->mStatus = bytesRead < 0 ? (status_t)bytesRead : OK;
+            it->mBuffer = buffer;
+            it->mFetchTimeUs = fetchTimeUs;
+            mCondition.broadcast();
+            break;
+        }
+    }
+    ALOGV("prefetched %zd bytes of '%s' in %lld us",
+            bytesRead, uri.c_str(), (long long)fetchTimeUs);
+}
+
+}  // namespace android
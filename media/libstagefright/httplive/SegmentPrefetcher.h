@@ -0,0 +1,93 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SEGMENT_PREFETCHER_H_
+
+#define SEGMENT_PREFETCHER_H_
+
+#include <media/stagefright/foundation/AHandler.h>
+#include <media/stagefright/foundation/AString.h>
+#include <utils/Condition.h>
+#include <utils/List.h>
+#include <utils/Mutex.h>
+
+namespace android {
+
+struct ABuffer;
+struct HTTPDownloader;
+
+// Downloads the segments following the one a PlaylistFetcher is working on, in
+// order, over a connection of its own, so that their requests and transfers
+// overlap with the decryption and parsing of the current segment.
+struct SegmentPrefetcher : public AHandler {
+    explicit SegmentPrefetcher(const sp<HTTPDownloader> &downloader);
+
+    // Queues a download of the given segment range, unless it is already queued.
+    void prefetch(const AString &uri, int64_t rangeOffset, int64_t rangeLength);
+
+    // Returns the number of segments queued and not yet taken.
+    size_t countQueued();
+
+    // Removes the given segment range from the queue, along with any segment queued
+    // before it, and waits for its download to complete. Returns its content, and the
+    // time spent downloading it in |fetchTimeUs|, or NULL if it was not queued or
+    // could not be downloaded. The whole queue is dropped if it was not queued.
+    sp<ABuffer> take(
+            const AString &uri, int64_t rangeOffset, int64_t rangeLength,
+            int64_t *fetchTimeUs);
+
+    // Drops all queued segments and aborts the download in progress.
+    void cancel();
+
+protected:
+    virtual ~SegmentPrefetcher();
+
+    virtual void onMessageReceived(const sp<AMessage> &msg);
+
+private:
+    enum {
+        kWhatFetch = 'ftch',
+    };
+
+    struct Segment {
+        int32_t mID;
+        AString mURI;
+        int64_t mRangeOffset;
+        int64_t mRangeLength;
+        bool mStarted;
+        bool mDone;
+        status_t mStatus;
+        sp<ABuffer> mBuffer;
+        int64_t mFetchTimeUs;
+    };
+
+    sp<HTTPDownloader> mDownloader;
+
+    Mutex mLock;
+    Condition mCondition;
+    List<Segment> mSegments;
+    int32_t mNextID;
+    bool mCancelled;
+
+    void onFetch();
+    void dropSegments_l();
+
+    DISALLOW_EVIL_CONSTRUCTORS(SegmentPrefetcher);
+};
+
+}  // namespace android
+
+#endif  // SEGMENT_PREFETCHER_H_
@@ -48,7 +48,8 @@ public:
         BufferInfo(
                 const sp<MediaCodecBuffer> &buffer,
                 IOMX::buffer_id bufferId,
-                const sp<IMemory> &sharedEncryptedBuffer);
+                const sp<IMemory> &sharedEncryptedBuffer,
+                const sp<AMessage> &returnTemplate);
 
         BufferInfo() = delete;
 
@@ -60,6 +61,10 @@ public:
         const IOMX::buffer_id mBufferId;
         // Encrypted buffer in case of secure input.
         const sp<IMemory> mSharedEncryptedBuffer;
+        // Message returning the buffer to ACodec, with "buffer" and "buffer-id" already set.
+        // A buffer is not returned again before ACodec has handled the previous message, so
+        // the message is reused instead of being allocated for every buffer.
+        const sp<AMessage> mReturnMsg;
     };
 
     ACodecBufferChannel(
@@ -150,8 +155,9 @@ private:
     // Note on thread safety: since the vector and BufferInfo are const, it's
     // safe to read them at any thread once the shared_ptr object is atomically
     // obtained. Inside BufferInfo, mBufferId and mSharedEncryptedBuffer are
-    // immutable objects. We write internal states of mClient/CodecBuffer when
-    // the caller has given up the reference, so that access is also safe.
+    // immutable objects. We write internal states of mClient/CodecBuffer and
+    // mReturnMsg when the caller has given up the reference, so that access is
+    // also safe.
     std::shared_ptr<const std::vector<const BufferInfo>> mInputBuffers;
     std::shared_ptr<const std::vector<const BufferInfo>> mOutputBuffers;
 
@@ -17,6 +17,7 @@
 #ifndef FRAME_DECODER_H_
 #define FRAME_DECODER_H_
 
+#include <atomic>
 #include <memory>
 #include <vector>
 
@@ -84,6 +85,7 @@ protected:
 
     virtual status_t extractInternal();
 
+    const AString &componentName() const    { return mComponentName; }
     sp<MetaData> trackMeta()     const      { return mTrackMeta; }
     OMX_COLOR_FORMATTYPE dstFormat() const  { return mDstFormat; }
     ui::PixelFormat captureFormat() const   { return mCaptureFormat; }
@@ -93,6 +95,8 @@ protected:
 
     bool mHaveMoreInputs;
     bool mFirstSample;
+    // Sample already read from mSource, queued to the decoder before reading any further.
+    MediaBufferBase *mPendingSample;
     MediaSource::ReadOptions mReadOptions;
     sp<IMediaSource> mSource;
     sp<MediaCodec> mDecoder;
@@ -117,6 +121,21 @@ struct VideoFrameDecoder : public FrameDecoder {
             const sp<MetaData> &trackMeta,
             const sp<IMediaSource> &source);
 
+    // Repositions an initialized decoder for the next extractFrame(), reusing the codec.
+    // |option| must be the seek mode the decoder was initialized with. When seeking to a
+    // sync frame that is the one extracted last, |sameFrame| is set and the frame that was
+    // returned for it applies; extractFrame() must not be called in that case.
+    status_t seekTo(int64_t frameTimeUs, int option, bool *sameFrame);
+
+    // Lets frames be returned at a reduced resolution that still covers |maxWidth| x
+    // |maxHeight| in display orientation. Only honored when frames are captured through
+    // a surface, where the scaling is done by the GPU. Must be called before init();
+    // 0 means no limit.
+    void setMaxOutputSize(int32_t maxWidth, int32_t maxHeight) {
+        mMaxOutputWidth = maxWidth;
+        mMaxOutputHeight = maxHeight;
+    }
+
 protected:
     virtual sp<AMessage> onGetFormatAndSeekOptions(
             int64_t frameTimeUs,
@@ -152,11 +171,15 @@ private:
     bool mIsHevc;
     MediaSource::ReadOptions::SeekMode mSeekMode;
     int64_t mTargetTimeUs;
+    int64_t mFirstSampleTimeUs;
     List<int64_t> mSampleDurations;
     int64_t mDefaultSampleDurationUs;
+    int32_t mMaxOutputWidth;
+    int32_t mMaxOutputHeight;
 
     sp<Surface> initSurface();
     status_t captureSurface();
+    int32_t getDownscaleFactor(int32_t width, int32_t height);
 };
 
 struct MediaImageDecoder : public FrameDecoder {
@@ -191,7 +214,11 @@ protected:
     virtual status_t extractInternal() override;
 
 private:
+    // Tiles of a grid are spread over up to this many decoders, mDecoder included.
+    static constexpr size_t kMaxTileDecoders = 4;
+
     VideoFrame *mFrame;
+    Mutex mFrameLock;
     int32_t mWidth;
     int32_t mHeight;
     int32_t mGridRows;
@@ -228,7 +255,22 @@ private:
     };
     Mutexed<OutputInfo> mOutInfo;
 
+    bool mDecodeTilesInParallel;
+    sp<AMessage> mTileFormat;
+    std::vector<sp<MediaCodec>> mTileDecoders;
+    std::vector<sp<AMessage>> mTileOutputFormats;
+
     bool outputLoop();
+    status_t convertTile(
+            const sp<MediaCodecBuffer> &videoFrameBuffer,
+            const sp<AMessage> &outputFormat,
+            int32_t tileIndex);
+    status_t initTileDecoders();
+    status_t extractTilesInParallel();
+    status_t queueTile(const sp<MediaCodec> &decoder, int32_t tileIndex,
+            const std::atomic<status_t> &error);
+    void drainTileDecoder(size_t decoderIndex, int32_t numTiles,
+            std::atomic<status_t> *error);
 };
 
 }  // namespace android
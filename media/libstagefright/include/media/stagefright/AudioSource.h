@@ -26,6 +26,7 @@
 
 #include <system/audio.h>
 
+#include <atomic>
 #include <vector>
 
 namespace android {
@@ -93,12 +94,20 @@ struct AudioSource : public MediaSource,
 
     status_t getPortId(audio_port_handle_t *portId) const;
 
+    // Coalesces captured audio into buffers of |frameCount| frames before
+    // handing them to read(), e.g. to match the encoder's frame size.
+    // Must be called before start(); 0 (the default) disables batching.
+    status_t setBatchFrameCount(size_t frameCount);
+
 protected:
     virtual ~AudioSource();
 
     enum {
         kMaxBufferSize = 2048,
 
+        // Upper bound on buffers kept for reuse once the encoder returns them.
+        kMaxFreeBuffers = 8,
+
         // After the initial mute, we raise the volume linearly
         // over kAutoRampDurationUs.
         kAutoRampDurationUs = 300000,
@@ -134,6 +143,18 @@ protected:
 
     List<MediaBuffer * > mBuffersReceived;
 
+    // Buffers of mMaxBufferSize bytes returned by the encoder, reused for
+    // new capture data instead of allocating per callback.
+    std::vector<MediaBuffer *> mFreeBuffers;
+
+    // Batch being filled when mBatchSize > 0; not yet visible to read().
+    size_t mBatchSize = 0;
+    MediaBuffer *mPendingBuffer = nullptr;
+    int64_t mPendingTimeUs = 0;
+    int64_t mNumFramesPending = 0;
+
+    std::atomic<int64_t> mNumOverruns = 0;
+
     void trackMaxAmplitude(int16_t *data, int nSamples);
 
     // This is used to raise the volume from mute to the
@@ -143,6 +164,12 @@ protected:
         uint8_t *data,   size_t bytes);
 
     void queueInputBuffer_l(MediaBuffer *buffer, int64_t timeUs);
+    // Queues |size| bytes of capture data, or silence if |data| is NULL,
+    // batching it first when mBatchSize > 0.
+    void queueData_l(const uint8_t *data, size_t size, int64_t timeUs);
+    void flushPendingBuffer_l();
+    MediaBuffer *acquireBuffer_l(size_t size);
+    void releaseFreeBuffers_l();
     void releaseQueuedFrames_l();
     void waitOutstandingEncodingFrames_l();
     virtual status_t reset();
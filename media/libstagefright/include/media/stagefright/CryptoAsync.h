@@ -74,6 +74,21 @@ public:
     // for the queue to become operational again. Also acts like a rest.
     void stop(std::list<sp<AMessage>> * const buffers = nullptr);
 
+    // Statistics of the buffers decrypted and queued so far.
+    struct Stats {
+        int64_t mCount = 0;
+        // Time spent decrypting and queueing a buffer to the codec, in us.
+        int64_t mDecryptSumUs = 0;
+        int64_t mDecryptMaxUs = 0;
+        // Time from decrypt() until the buffer is queued to the codec, in us.
+        int64_t mLatencySumUs = 0;
+        int64_t mLatencyMaxUs = 0;
+        // Max number of buffers waiting for decryption.
+        size_t mMaxPending = 0;
+    };
+
+    Stats getStats() const;
+
     // Describes two actions for decrypt();
     // kActionDecrypt - decrypts the buffer and queues to codec
     // kActionAttachEncryptedBuffer - decrypts and attaches the buffer
@@ -100,6 +115,10 @@ protected:
         kWhatDoNothing       = 10
     };
 
+    // Max number of buffers decrypted for one kWhatDecrypt message before
+    // the looper is yielded to other messages (e.g. kWhatStop).
+    static constexpr size_t kMaxDecryptsPerMessage = 8;
+
     // Defines the staste of this thread.
     typedef enum : uint32_t {
         // kCryptoAsyncActive as long as we have not encountered
@@ -123,6 +142,9 @@ protected:
     // Implements the Looper
     void onMessageReceived(const sp<AMessage>& msg) override;
 
+    // Updates the statistics after a buffer was decrypted and queued.
+    void recordDecrypt(const sp<AMessage>& msg, int64_t startUs);
+
     std::unique_ptr<CryptoAsyncCallback> mCallback;
 private:
 
@@ -132,6 +154,8 @@ private:
     Mutexed<std::list<sp<AMessage>>> mPendingBuffers;
 
     std::weak_ptr<BufferChannelBase> mBufferChannel;
+
+    mutable Mutexed<Stats> mStats;
 };
 
 }  // namespace android
@@ -72,6 +72,12 @@ private:
     int mPMTContinuityCounter;
     uint32_t mCrcTable[256];
 
+    // Time spent handing data to the output, and the number of writes that
+    // blocked for kStalledWriteTimeUs or more.
+    int64_t mTotalWriteTimeUs;
+    int64_t mMaxWriteTimeUs;
+    int32_t mNumStalledWrites;
+
     void init();
 
     void writeTS();
@@ -61,10 +61,14 @@ public:
     void writeFourcc(const char *fourcc);
     void write(const void *data, size_t size);
     inline size_t write(const void *ptr, size_t size, size_t nmemb);
-    // Write to file system by calling ::write() or post error message to looper on failure.
+    // Write to file through the write buffer or post error message to looper on failure.
     void writeOrPostError(int fd, const void *buf, size_t count);
     // Seek in the file by calling ::lseek64() or post error message to looper on failure.
     void seekOrPostError(int fd, off64_t offset, int whence);
+    // Hand the writes buffered by writeOrPostError() to the file system.
+    void flushWriteBuffer();
+    // Write to file system by calling ::write() or post error message to looper on failure.
+    void writeToFileOrPostError(int fd, const void *buf, size_t count);
     void endBox();
     uint32_t interleaveDuration() const { return mInterleaveDurationUs; }
     status_t setInterleaveDuration(uint32_t duration);
@@ -114,6 +118,8 @@ protected:
     off64_t mInMemoryCacheOffset;
     off64_t mInMemoryCacheSize;
     bool  mWriteBoxToMemory;
+    uint8_t *mWriteBuffer;  // Data written to mFd but not handed to the file system yet.
+    size_t mWriteBufferOffset;
     off64_t mFreeBoxOffset;
     bool mStreamableFile;
     off64_t mMoovExtraSize;
@@ -264,6 +270,17 @@ protected:
     // Actually write the given chunk to the file.
     void writeChunkToFile(Chunk* chunk);
 
+    // Fragmented recording: instead of interleaving chunks into a single 'mdat'
+    // box described by the 'moov' box at the end, the writer thread writes the
+    // buffered chunks as a 'moof' and 'mdat' box pair every mFragmentDurationUs.
+    int64_t mFragmentDurationUs;
+    uint32_t mFragmentSequenceNumber;
+    bool isFragmented() const { return mFragmentDurationUs > 0; }
+    bool isFragmentReady_l();
+    void writeFragments();
+    void writeFragment(List<Chunk> &chunks, int64_t movieStartTimeUs);
+    void writeFragmentedMoovBox();
+
     // Adjust other track media clock (presumably wall clock)
     // based on audio track media clock with the drift time.
     int64_t mDriftTimeUs;
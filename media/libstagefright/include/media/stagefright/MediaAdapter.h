@@ -23,6 +23,9 @@
 #include <media/stagefright/MetaData.h>
 #include <utils/threads.h>
 
+#include <functional>
+#include <map>
+
 namespace android {
 
 // Convert the MediaMuxer's push model into MPEG4Writer's pull model.
@@ -56,6 +59,11 @@ public:
     // deep copy, such that after pushBuffer return, the buffer can be re-used.
     status_t pushBuffer(MediaBuffer *buffer);
 
+    // This pushBuffer() only waits for read() to take the buffer. The reader
+    // keeps it without copying, and onReleased is called from the thread
+    // that returns it once the buffer can be re-used.
+    status_t pushBuffer(MediaBuffer *buffer, const std::function<void()> &onReleased);
+
 private:
     Mutex mAdapterLock;
     std::mutex mBufferGatingMutex;
@@ -63,6 +71,10 @@ private:
     Condition mBufferReadCond;
     // Make sure the pushBuffer() wait for the current buffer consumed.
     Condition mBufferReturnedCond;
+    // Make sure the non-blocking pushBuffer() waits for read() to take the buffer.
+    Condition mBufferTakenCond;
+    // Callbacks of the buffers pushed without waiting for their return.
+    std::map<MediaBufferBase *, std::function<void()>> mReleaseCallbacks;
 
     MediaBuffer *mCurrentMediaBuffer;
 
@@ -45,6 +45,9 @@ public:
     status_t writeSampleData(const sp<ABuffer>& buffer, size_t trackIndex, int64_t timeUs,
                              uint32_t flags);
 
+    status_t writeSampleDataNoCopy(const sp<ABuffer>& buffer, size_t trackIndex, int64_t timeUs,
+                                   uint32_t flags, const std::function<void()> &onReleased);
+
     status_t setOrientationHint(int degrees);
 
     status_t setLocation(int latitude, int longitude);
@@ -56,9 +56,19 @@ public:
 
     size_t buffers() const;
 
+    // Makes the next acquire_buffer() return a buffer backed by data instead of a buffer
+    // of the group, if size is large enough for the request. A track then reads the sample
+    // straight into the memory of the caller. data must remain valid until that buffer is
+    // released. clearDestination() drops a destination which was not used.
+    void setDestination(void *data, size_t size);
+    void clearDestination();
+
     // If buffer is nullptr, have acquire_buffer() check for remote release.
     virtual void signalBufferReturned(MediaBufferBase *buffer);
 
+    // Writes the buffers per size class and the acquire, allocation and wait counters to fd.
+    void dump(int fd) const;
+
     CMediaBufferGroup *wrap() {
         if (mWrapper) {
             return mWrapper;
@@ -397,6 +397,11 @@ private:
 
         sp<MediaCodecBuffer> mData;
         bool mOwnedByClient;
+
+        // Output buffers only, for the per stage latency.
+        int64_t mAvailableNs;   // the codec returned the buffer
+        int64_t mDispatchedNs;  // the buffer was handed to the client
+        int mLatencySlot;       // entry of the buffer in mRecentStages, or -1
     };
 
     // This type is used to track the tunnel mode video peek state machine:
@@ -432,6 +437,7 @@ private:
     };
 
     struct ResourceManagerServiceProxy;
+    struct WarmPool;
 
     State mState;
     bool mReleasedByResourceManager;
@@ -480,6 +486,9 @@ private:
     AString mLogSessionId;
     int32_t mWidth;
     int32_t mHeight;
+    int32_t mFrameRate;
+    int64_t mMaxMacroblocksPerSecond;
+    int32_t mMaxConcurrentInstances;
     int32_t mRotationDegrees;
     int32_t mAllowFrameDroppingBySurface;
 
@@ -537,6 +546,10 @@ private:
     // for the indicated media type
     status_t setupFormatShaper(AString mediaType);
 
+    // report the outcome of a shaped encoding, as recorded in its metrics, back to
+    // the format shaper library
+    void reportShapedEncoding(mediametrics_handle_t handle);
+
     // Used only to synchronize asynchronous getBufferAndFormat
     // across all the other (synchronous) buffer state change
     // operations, such as de/queueIn/OutputBuffer, start and
@@ -590,7 +603,8 @@ private:
     void PostReplyWithError(const sp<AMessage> &msg, int32_t err);
     void PostReplyWithError(const sp<AReplyToken> &replyID, int32_t err);
 
-    status_t init(const AString &name, bool nameIsType = false);
+    // |reclaim| allows reclaiming the resources of other clients if the allocation fails
+    status_t init(const AString &name, bool nameIsType = false, bool reclaim = true);
 
     void setState(State newState);
     void returnBuffersToCodec(bool isReclaim = false);
@@ -663,6 +677,7 @@ private:
     typedef struct {
             int64_t presentationUs;
             int64_t startedNs;
+            int64_t queuedNs;   // when the client queued the buffer
     } BufferFlightTiming_t;
     std::deque<BufferFlightTiming_t> mBuffersInFlight;
     Mutex mLatencyLock;
@@ -694,8 +709,11 @@ private:
 
     sp<BatteryChecker> mBatteryChecker;
 
-    void statsBufferSent(int64_t presentationUs, const sp<MediaCodecBuffer> &buffer);
-    void statsBufferReceived(int64_t presentationUs, const sp<MediaCodecBuffer> &buffer);
+    void statsBufferSent(int64_t presentationUs, const sp<MediaCodecBuffer> &buffer,
+            int64_t queuedNs);
+    void statsBufferReceived(int64_t presentationUs, const sp<MediaCodecBuffer> &buffer,
+            size_t index);
+    void statsBufferReleased(size_t index);
     bool discardDecodeOnlyOutputBuffer(size_t index);
 
     enum {
@@ -719,6 +737,31 @@ private:
 
     MediaHistogram<int64_t> mLatencyHist;
 
+    // The round trip latency split into the stages of a buffer through MediaCodec. This
+    // applies alike to ACodec and CCodec, as it is measured at the MediaCodec boundaries.
+    enum LatencyStage {
+        kLatencyStageQueue = 0,  // queueInputBuffer() to the codec accepting the input
+        kLatencyStageCodec,      // codec accepting the input to the output being available
+        kLatencyStageDispatch,   // output available to its dequeue or callback by the client
+        kLatencyStageClient,     // output handed to the client to its release or render
+        kLatencyStageCount,
+    };
+
+    // stage latencies in us of one frame, kRecentSampleInvalid when unknown
+    typedef struct {
+        int64_t presentationUs;
+        int64_t stageUs[kLatencyStageCount];
+    } FrameStageLatency_t;
+
+    // under mLatencyLock
+    MediaHistogram<int64_t> mStageLatencyHist[kLatencyStageCount];
+    // ring of the recent frames, under mRecentLock
+    FrameStageLatency_t mRecentStages[kRecentLatencyFrames];
+    int mRecentStagesHead;
+
+    void addStageLatency(int slot, LatencyStage stage, int64_t latencyUs,
+            int64_t presentationUs);
+
     // An unique ID for the codec - Used by the metrics.
     uint64_t mCodecId = 0;
 
@@ -64,6 +64,9 @@ struct MediaCodecList : public BnMediaCodecList {
     // only to be used by getLocalInstance
     static void *profilerThreadWrapper(void * /*arg*/);
 
+    // the list serialized by the media.player service, or NULL if missing or stale
+    static sp<IMediaCodecList> getCachedInstance();
+
     enum Flags {
         kPreferSoftwareCodecs   = 1,
         kHardwareCodecsOnly     = 2,
@@ -107,6 +110,10 @@ private:
      */
     MediaCodecList(std::vector<MediaCodecListBuilderBase*> builders);
 
+    // list read from the cache
+    MediaCodecList(const sp<AMessage> &globalSettings,
+                   std::vector<sp<MediaCodecInfo>> &&codecInfos);
+
     ~MediaCodecList();
 
     status_t initCheck() const;
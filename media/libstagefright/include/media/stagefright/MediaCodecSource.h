@@ -23,6 +23,8 @@
 #include <media/stagefright/foundation/Mutexed.h>
 #include <media/stagefright/PersistentSurface.h>
 
+#include <map>
+
 namespace android {
 
 struct ALooper;
@@ -36,6 +38,9 @@ struct MediaCodecSource : public MediaSource,
     enum FlagBits {
         FLAG_USE_SURFACE_INPUT      = 1,
         FLAG_PREFER_SOFTWARE_CODEC  = 4,  // used for testing only
+        // Run on a dedicated looper instead of the one passed to Create() and
+        // configure the encoder for latency over throughput.
+        FLAG_LOW_LATENCY            = 8,
     };
 
     static sp<MediaCodecSource> Create(
@@ -50,6 +55,10 @@ struct MediaCodecSource : public MediaSource,
     status_t setInputBufferTimeOffset(int64_t timeOffsetUs);
     int64_t getFirstSampleSystemTimeUs();
 
+    // Time from a buffer being read from the source to its encoded output becoming
+    // available. Not measured for surface input.
+    void getLatencyStats(int64_t *count, int64_t *avgUs, int64_t *maxUs);
+
     // MediaSource
     virtual status_t start(MetaData *params = NULL);
     virtual status_t stop();
@@ -167,6 +176,16 @@ private:
     bool mIsHFR;
     int32_t mBatchSize;
 
+    // input time (us) -> system time (us) the buffer was read from the source
+    std::map<int64_t, int64_t> mInputReadTimesUs;
+    struct LatencyStats {
+        LatencyStats() : mCount(0), mTotalUs(0), mMaxUs(0) {}
+        int64_t mCount;
+        int64_t mTotalUs;
+        int64_t mMaxUs;
+    };
+    Mutexed<LatencyStats> mLatencyStats;
+
     DISALLOW_EVIL_CONSTRUCTORS(MediaCodecSource);
 };
 
@@ -116,6 +116,16 @@ public:
     status_t writeSampleData(const sp<ABuffer> &buffer, size_t trackIndex,
                              int64_t timeUs, uint32_t flags) ;
 
+    /**
+     * Send a sample buffer for muxing without copying it. The call returns
+     * once the writer has taken the buffer; onReleased is called when the
+     * sample has been written and the buffer can be reused.
+     * See MediaMuxerBase::writeSampleDataNoCopy().
+     */
+    status_t writeSampleDataNoCopy(const sp<ABuffer> &buffer, size_t trackIndex,
+                                   int64_t timeUs, uint32_t flags,
+                                   const std::function<void()> &onReleased);
+
     /**
      * Gets the number of tracks added successfully.  Should be called in
      * INITIALIZED(after constructor) or STARTED(after start()) state.
@@ -151,6 +161,13 @@ private:
     };
     State mState;
 
+    // Wraps the sample in a MediaBuffer and pushes it to the track's
+    // MediaAdapter. With onReleased set, the writer keeps the buffer
+    // instead of copying it.
+    status_t pushSampleData(const sp<ABuffer> &buffer, size_t trackIndex,
+                            int64_t timeUs, uint32_t flags,
+                            const std::function<void()> *onReleased);
+
     DISALLOW_EVIL_CONSTRUCTORS(MediaMuxer);
 };
 
@@ -17,6 +17,8 @@
 #ifndef MEDIA_MUXER_BASE_H_
 #define MEDIA_MUXER_BASE_H_
 
+#include <functional>
+
 #include <utils/RefBase.h>
 #include "media/stagefright/foundation/ABase.h"
 
@@ -108,6 +110,32 @@ public:
     virtual status_t writeSampleData(const sp<ABuffer> &buffer, size_t trackIndex,
                              int64_t timeUs, uint32_t flags) = 0 ;
 
+    /**
+     * Send a sample buffer for muxing without copying it.
+     * Unlike writeSampleData(), the buffer is referenced by the writer
+     * until the sample has been written to the file, which may be up to
+     * the writer's interleave duration later. onReleased is called once
+     * the buffer can be reused, possibly from the writer's thread, and
+     * must not block. It is not called if an error is returned.
+     * The default implementation copies like writeSampleData().
+     * @param buffer the incoming sample buffer.
+     * @param trackIndex the buffer's track index number.
+     * @param timeUs the buffer's time stamp.
+     * @param flags the only supported flag for now is
+     *              MediaCodec::BUFFER_FLAG_SYNCFRAME.
+     * @param onReleased called when the buffer is no longer referenced.
+     * @return OK if no error.
+     */
+    virtual status_t writeSampleDataNoCopy(const sp<ABuffer> &buffer, size_t trackIndex,
+                                           int64_t timeUs, uint32_t flags,
+                                           const std::function<void()> &onReleased) {
+        status_t err = writeSampleData(buffer, trackIndex, timeUs, flags);
+        if (err == OK) {
+            onReleased();
+        }
+        return err;
+    }
+
     /**
      * Gets the number of tracks added successfully.  Should be called in
      * INITIALIZED(after constructor) or STARTED(after start()) state.
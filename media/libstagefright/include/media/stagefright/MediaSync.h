@@ -22,12 +22,15 @@
 
 #include <media/AudioResamplerPublic.h>
 #include <media/AVSyncSettings.h>
+#include <media/stagefright/MediaHistogram.h>
 #include <media/stagefright/foundation/AHandler.h>
 
 #include <utils/Condition.h>
 #include <utils/KeyedVector.h>
 #include <utils/Mutex.h>
 
+#include <string>
+
 namespace android {
 
 class AudioTrack;
@@ -130,6 +133,11 @@ public:
     // Get the play time for pending audio frames in audio sink.
     status_t getPlayTimeForPendingAudioFrames(int64_t *outTimeUs);
 
+    // Get the A/V sync error of the video frames rendered with audio as a histogram of
+    // microseconds in the MediaHistogram::emit() format. A positive error is a video frame
+    // displayed after its audio. Also get the number of video frames dropped for being late.
+    status_t getAVSyncErrorHistogram(std::string *outHistogram, int64_t *outNumDroppedFrames);
+
 protected:
     virtual void onMessageReceived(const sp<AMessage> &msg);
 
@@ -228,6 +236,9 @@ private:
 
     sp<MediaClock> mMediaClock;
 
+    MediaHistogram<int64_t> mSyncErrorHistogram;
+    int64_t mNumFramesDroppedLate;
+
     MediaSync();
 
     // Must be accessed through RefBase
@@ -235,7 +246,17 @@ private:
 
     int64_t getRealTime(int64_t mediaTimeUs, int64_t nowUs);
     int64_t getDurationIfPlayedAtNativeSampleRate_l(int64_t numFrames);
-    int64_t getPlayedOutAudioDurationMedia_l(int64_t nowUs);
+    int64_t getPlayedOutAudioDurationMedia_l(
+            uint32_t numFramesPlayed, int64_t numFramesPlayedAtUs, int64_t nowUs);
+
+    // Query the position of |audioTrack|. This is called without holding mMutex, as it can
+    // involve a binder call for offloaded and direct tracks.
+    static void getAudioPosition(const sp<AudioTrack> &audioTrack, int64_t nowUs,
+            uint32_t *numFramesPlayed, int64_t *numFramesPlayedAtUs);
+
+    // How long before they are due video frames are queued to the output, with their
+    // desired present time.
+    int64_t getRenderAheadUs_l();
 
     void onDrainVideo_l();
 
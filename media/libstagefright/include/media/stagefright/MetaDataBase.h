@@ -136,6 +136,7 @@ enum {
 
     kKeyRealTimeRecording = 'rtrc',  // bool (int32_t)
     kKeyBackgroundMode = 'bkmd',  // bool (int32_t)
+    kKeyFragmentDurationUs = 'frgd',  // int64_t, write a fragmented file when positive
 
     kKeyNumBuffers        = 'nbbf',  // int32_t
 
@@ -275,6 +276,7 @@ enum {
     kKeyRtpCvoDegrees    = 'cvod', // int32_t, rtp cvo degrees as per 3GPP 26.114.
     kKeyRtpDscp          = 'dscp', // int32_t, DSCP(Differentiated services codepoint) of RFC 2474.
     kKeyRtpEcn           = 'sEcn', // int32_t, ECN (Explicit Congestion Notification) of RFC 3168
+    kKeyRtpPacing        = 'rPac', // bool (int32_t), spread large video frames over the frame interval.
     kKeySocketNetwork    = 'sNet', // int64_t, socket will be bound to network handle.
 
     // Slow-motion markers
@@ -284,6 +286,7 @@ enum {
     kKeySampleFileOffset = 'sfof', // int64_t, sample's offset in a media file.
     kKeyLastSampleIndexInChunk = 'lsic',  //int64_t, index of last sample in a chunk.
     kKeySampleTimeBeforeAppend = 'lsba', // int64_t, timestamp of last sample of a track.
+    kKeyHoldUntilWritten = 'hldw', // int32_t (bool), writer keeps the sample buffer, no copy.
 
     // DVB component tag
     kKeyDvbComponentTag = 'copt', // int32_t, component tag for DVB video/audio/subtitle
@@ -54,6 +54,10 @@ static const OMX_U32 kPortIndexOutput = 1;
 static const OMX_U32 kPortIndexInputExtradata = 2;
 static const OMX_U32 kPortIndexOutputExtradata = 3;
 
+// buffer ids keep the index of their slot in the low bits
+static const uint32_t kBufferIDSlotBits = 16;
+static const uint32_t kBufferIDSlotMask = (1u << kBufferIDSlotBits) - 1;
+
 #define CLOGW(fmt, ...) ALOGW("[%p:%s] " fmt, mHandle, mName, ##__VA_ARGS__)
 
 #define CLOG_ERROR_IF(cond, fn, err, fmt, ...) \
@@ -2576,15 +2580,25 @@ IOMX::buffer_id OMXNodeInstance::makeBufferID(OMX_BUFFERHEADERTYPE *bufferHeader
         return 0;
     }
     Mutex::Autolock autoLock(mBufferIDLock);
-    IOMX::buffer_id buffer;
-    do { // handle the very unlikely case of ID overflow
-        if (++mBufferIDCount == 0) {
-            ++mBufferIDCount;
+    uint32_t slot;
+    if (!mFreeBufferIDSlots.empty()) {
+        slot = mFreeBufferIDSlots.back();
+        mFreeBufferIDSlots.pop_back();
+    } else {
+        if (mBufferIDSlots.size() > kBufferIDSlotMask) {
+            CLOGW("makeBufferID: too many buffers (%zu)", mBufferIDSlots.size());
+            return 0;
         }
-        buffer = (IOMX::buffer_id)mBufferIDCount;
-    } while (mBufferIDToBufferHeader.indexOfKey(buffer) >= 0);
-    mBufferIDToBufferHeader.add(buffer, bufferHeader);
-    mBufferHeaderToBufferID.add(bufferHeader, buffer);
+        slot = mBufferIDSlots.size();
+        mBufferIDSlots.push_back({0, NULL});
+    }
+    // handle the very unlikely case of ID overflow; the high bits are never 0.
+    if (++mBufferIDCount > (UINT32_MAX >> kBufferIDSlotBits)) {
+        mBufferIDCount = 1;
+    }
+    IOMX::buffer_id buffer = (IOMX::buffer_id)((mBufferIDCount << kBufferIDSlotBits) | slot);
+    mBufferIDSlots[slot] = {buffer, bufferHeader};
+    mBufferHeaderToBufferID[bufferHeader] = buffer;
     return buffer;
 }
 
@@ -2594,12 +2608,12 @@ OMX_BUFFERHEADERTYPE *OMXNodeInstance::findBufferHeader(
         return NULL;
     }
     Mutex::Autolock autoLock(mBufferIDLock);
-    ssize_t index = mBufferIDToBufferHeader.indexOfKey(buffer);
-    if (index < 0) {
+    uint32_t slot = buffer & kBufferIDSlotMask;
+    if (slot >= mBufferIDSlots.size() || mBufferIDSlots[slot].mID != buffer) {
         CLOGW("findBufferHeader: buffer %u not found", buffer);
         return NULL;
     }
-    OMX_BUFFERHEADERTYPE *header = mBufferIDToBufferHeader.valueAt(index);
+    OMX_BUFFERHEADERTYPE *header = mBufferIDSlots[slot].mHeader;
     BufferMeta *buffer_meta =
         static_cast<BufferMeta *>(header->pAppPrivate);
     if (buffer_meta->getPortIndex() != portIndex) {
@@ -2615,12 +2629,12 @@ IOMX::buffer_id OMXNodeInstance::findBufferID(OMX_BUFFERHEADERTYPE *bufferHeader
         return 0;
     }
     Mutex::Autolock autoLock(mBufferIDLock);
-    ssize_t index = mBufferHeaderToBufferID.indexOfKey(bufferHeader);
-    if (index < 0) {
+    auto it = mBufferHeaderToBufferID.find(bufferHeader);
+    if (it == mBufferHeaderToBufferID.end()) {
         CLOGW("findBufferID: bufferHeader %p not found", bufferHeader);
         return 0;
     }
-    return mBufferHeaderToBufferID.valueAt(index);
+    return it->second;
 }
 
 void OMXNodeInstance::invalidateBufferID(IOMX::buffer_id buffer) {
@@ -2628,13 +2642,14 @@ void OMXNodeInstance::invalidateBufferID(IOMX::buffer_id buffer) {
         return;
     }
     Mutex::Autolock autoLock(mBufferIDLock);
-    ssize_t index = mBufferIDToBufferHeader.indexOfKey(buffer);
-    if (index < 0) {
+    uint32_t slot = buffer & kBufferIDSlotMask;
+    if (slot >= mBufferIDSlots.size() || mBufferIDSlots[slot].mID != buffer) {
         CLOGW("invalidateBufferID: buffer %u not found", buffer);
         return;
     }
-    mBufferHeaderToBufferID.removeItem(mBufferIDToBufferHeader.valueAt(index));
-    mBufferIDToBufferHeader.removeItemsAt(index);
+    mBufferHeaderToBufferID.erase(mBufferIDSlots[slot].mHeader);
+    mBufferIDSlots[slot] = {0, NULL};
+    mFreeBufferIDSlots.push_back(slot);
 }
 
 }  // namespace android
@@ -19,6 +19,8 @@
 #define OMX_NODE_INSTANCE_H_
 
 #include <atomic>
+#include <unordered_map>
+#include <vector>
 
 #include <media/IOMX.h>
 #include <utils/RefBase.h>
@@ -148,8 +150,15 @@ private:
     // for buffer ptr to buffer id translation
     Mutex mBufferIDLock;
     uint32_t mBufferIDCount;
-    KeyedVector<IOMX::buffer_id, OMX_BUFFERHEADERTYPE *> mBufferIDToBufferHeader;
-    KeyedVector<OMX_BUFFERHEADERTYPE *, IOMX::buffer_id> mBufferHeaderToBufferID;
+    // A buffer id holds the index of its slot in the low bits, so that the header is found
+    // without a search. The high bits tell apart the successive buffers of a slot.
+    struct BufferIDSlot {
+        IOMX::buffer_id mID;
+        OMX_BUFFERHEADERTYPE *mHeader;
+    };
+    std::vector<BufferIDSlot> mBufferIDSlots;
+    std::vector<uint32_t> mFreeBufferIDSlots;
+    std::unordered_map<OMX_BUFFERHEADERTYPE *, IOMX::buffer_id> mBufferHeaderToBufferID;
 
     bool mLegacyAdaptiveExperiment;
     IOMX::PortMode mPortMode[2];
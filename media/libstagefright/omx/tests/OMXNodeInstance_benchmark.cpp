@@ -0,0 +1,230 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Benchmark of the emptyBuffer/fillBuffer round trips of an OMX node, reporting buffers per
+// second. It runs a software G.711 decoder, so that the cost is dominated by the buffer
+// handling of OMXNodeInstance and its IPC rather than by the codec itself.
+//
+// The benchmarks are skipped when the OMX service or the component is not available.
+
+#include <algorithm>
+#include <condition_variable>
+#include <list>
+#include <mutex>
+#include <vector>
+
+#include <android/hidl/allocator/1.0/IAllocator.h>
+#include <benchmark/benchmark.h>
+#include <binder/ProcessState.h>
+#include <media/IOMX.h>
+#include <media/OMXBuffer.h>
+#include <media/stagefright/OMXClient.h>
+#include <OMX_Component.h>
+
+using namespace android;
+
+namespace {
+
+constexpr const char *kComponentName = "OMX.google.g711.alaw.decoder";
+constexpr int64_t kTimeoutUs = 1000000;  // 1s
+constexpr OMX_U32 kInputBytes = 160;  // 20ms of 8kHz audio
+
+class Observer : public BnOMXObserver {
+public:
+    void onMessages(const std::list<omx_message> &messages) override {
+        std::lock_guard lock(mLock);
+        mMessages.insert(mMessages.end(), messages.begin(), messages.end());
+        mCondition.notify_all();
+    }
+
+    // Waits for the next message, or returns false on time out.
+    bool dequeue(omx_message *msg) {
+        std::unique_lock lock(mLock);
+        if (!mCondition.wait_for(lock, std::chrono::microseconds(kTimeoutUs),
+                [this] { return !mMessages.empty(); })) {
+            return false;
+        }
+        *msg = mMessages.front();
+        mMessages.pop_front();
+        return true;
+    }
+
+    bool waitForState(OMX_STATETYPE state) {
+        omx_message msg;
+        while (dequeue(&msg)) {
+            if (msg.type == omx_message::EVENT
+                    && msg.u.event_data.event == OMX_EventCmdComplete
+                    && msg.u.event_data.data1 == OMX_CommandStateSet
+                    && msg.u.event_data.data2 == (OMX_U32)state) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+private:
+    std::mutex mLock;
+    std::condition_variable mCondition;
+    std::list<omx_message> mMessages;
+};
+
+class NodeFixture {
+public:
+    ~NodeFixture() {
+        if (mNode == nullptr) {
+            return;
+        }
+        if (mExecuting) {
+            mNode->sendCommand(OMX_CommandStateSet, OMX_StateIdle);
+            mObserver->waitForState(OMX_StateIdle);
+        }
+        mNode->sendCommand(OMX_CommandStateSet, OMX_StateLoaded);
+        for (IOMX::buffer_id id : mInputBuffers) {
+            mNode->freeBuffer(0, id);
+        }
+        for (IOMX::buffer_id id : mOutputBuffers) {
+            mNode->freeBuffer(1, id);
+        }
+        mObserver->waitForState(OMX_StateLoaded);
+        mNode->freeNode();
+    }
+
+    const char *init() {
+        OMXClient client;
+        if (client.connect() != OK || (mOMX = client.interface()) == nullptr) {
+            return "OMX service not available";
+        }
+        mAllocator = hidl::allocator::V1_0::IAllocator::getService("ashmem");
+        if (mAllocator == nullptr) {
+            return "ashmem allocator not available";
+        }
+        mObserver = new Observer;
+        if (mOMX->allocateNode(kComponentName, mObserver, &mNode) != OK) {
+            mNode.clear();
+            return "component not available";
+        }
+        if (mNode->sendCommand(OMX_CommandStateSet, OMX_StateIdle) != OK
+                || !allocatePortBuffers(0, &mInputBuffers)
+                || !allocatePortBuffers(1, &mOutputBuffers)
+                || !mObserver->waitForState(OMX_StateIdle)) {
+            return "cannot go to idle state";
+        }
+        if (mNode->sendCommand(OMX_CommandStateSet, OMX_StateExecuting) != OK
+                || !mObserver->waitForState(OMX_StateExecuting)) {
+            return "cannot go to executing state";
+        }
+        mExecuting = true;
+        return nullptr;
+    }
+
+    // Queues as many input buffers as the output port can hold, along with one output buffer
+    // for each, and waits for all of them to return.
+    // Returns the number of buffers that went through the node, or 0 on error.
+    size_t roundTrip() {
+        size_t count = std::min(mInputBuffers.size(), mOutputBuffers.size());
+        for (size_t i = 0; i < count; ++i) {
+            if (mNode->fillBuffer(mOutputBuffers[i], OMXBuffer::sPreset) != OK) {
+                return 0;
+            }
+        }
+        for (size_t i = 0; i < count; ++i) {
+            if (mNode->emptyBuffer(
+                    mInputBuffers[i], OMXBuffer(0, kInputBytes), 0, mTimestampUs, -1) != OK) {
+                return 0;
+            }
+            mTimestampUs += 20000;
+        }
+        omx_message msg;
+        for (size_t pending = 2 * count; pending > 0; ) {
+            if (!mObserver->dequeue(&msg)) {
+                return 0;
+            }
+            if (msg.type == omx_message::EMPTY_BUFFER_DONE
+                    || msg.type == omx_message::FILL_BUFFER_DONE) {
+                --pending;
+            }
+        }
+        return 2 * count;
+    }
+
+private:
+    sp<IOMX> mOMX;
+    sp<IOMXNode> mNode;
+    sp<Observer> mObserver;
+    sp<hidl::allocator::V1_0::IAllocator> mAllocator;
+    std::vector<hardware::hidl_memory> mMemories;
+    std::vector<IOMX::buffer_id> mInputBuffers;
+    std::vector<IOMX::buffer_id> mOutputBuffers;
+    bool mExecuting = false;
+    int64_t mTimestampUs = 0;
+
+    bool allocatePortBuffers(OMX_U32 portIndex, std::vector<IOMX::buffer_id> *buffers) {
+        OMX_PARAM_PORTDEFINITIONTYPE def;
+        def.nSize = sizeof(def);
+        def.nVersion.s.nVersionMajor = 1;
+        def.nVersion.s.nVersionMinor = 0;
+        def.nVersion.s.nRevision = 0;
+        def.nVersion.s.nStep = 0;
+        def.nPortIndex = portIndex;
+        if (mNode->getParameter(OMX_IndexParamPortDefinition, &def, sizeof(def)) != OK) {
+            return false;
+        }
+        for (OMX_U32 i = 0; i < def.nBufferCountActual; ++i) {
+            bool success = false;
+            hardware::hidl_memory memory;
+            auto transStatus = mAllocator->allocate(def.nBufferSize,
+                    [&success, &memory](bool s, const hardware::hidl_memory &m) {
+                        success = s;
+                        memory = m;
+                    });
+            IOMX::buffer_id id;
+            if (!transStatus.isOk() || !success
+                    || mNode->useBuffer(portIndex, memory, &id) != OK) {
+                return false;
+            }
+            mMemories.push_back(memory);
+            buffers->push_back(id);
+        }
+        return true;
+    }
+};
+
+}  // namespace
+
+// Round trips of input and output buffers through an executing node.
+static void BM_EmptyAndFillBuffers(benchmark::State &state) {
+    ProcessState::self()->startThreadPool();
+    NodeFixture fixture;
+    if (const char *error = fixture.init()) {
+        state.SkipWithError(error);
+        return;
+    }
+    int64_t buffers = 0;
+    for (auto _ : state) {
+        size_t count = fixture.roundTrip();
+        if (count == 0) {
+            state.SkipWithError("buffer round trip failed");
+            return;
+        }
+        buffers += count;
+    }
+    state.SetItemsProcessed(buffers);
+    state.counters["buffers/s"] = benchmark::Counter(buffers, benchmark::Counter::kIsRate);
+}
+
+BENCHMARK(BM_EmptyAndFillBuffers)->UseRealTime();
+
+BENCHMARK_MAIN();
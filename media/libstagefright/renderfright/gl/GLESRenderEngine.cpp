@@ -20,6 +20,7 @@
 #define ATRACE_TAG ATRACE_TAG_GRAPHICS
 
 #include <sched.h>
+#include <pthread.h>
 #include <cmath>
 #include <fstream>
 #include <sstream>
@@ -349,6 +350,9 @@ GLESRenderEngine::GLESRenderEngine(const RenderEngineCreationArgs& args, EGLDisp
 
     glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
     glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    // Vertex attribute state is per context, so it can't be left to programs
+    // that may have been linked on the prime cache context.
+    glEnableVertexAttribArray(Program::position);
 
     // Initialize protected EGL Context.
     if (mProtectedEGLContext != EGL_NO_CONTEXT) {
@@ -357,6 +361,7 @@ GLESRenderEngine::GLESRenderEngine(const RenderEngineCreationArgs& args, EGLDisp
         ALOGE_IF(!success, "can't make protected context current");
         glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
         glPixelStorei(GL_PACK_ALIGNMENT, 4);
+        glEnableVertexAttribArray(Program::position);
         success = eglMakeCurrent(display, mStubSurface, mStubSurface, mEGLContext);
         LOG_ALWAYS_FATAL_IF(!success, "can't make default context current");
     }
@@ -403,6 +408,11 @@ GLESRenderEngine::GLESRenderEngine(const RenderEngineCreationArgs& args, EGLDisp
         checkErrors("BlurFilter creation");
     }
 
+    ProgramCache::getInstance().setBinaryCacheDir(args.programBinaryCacheDir);
+    if (args.precacheInBackground) {
+        startPrimeCacheThread(args.pixelFormat);
+    }
+
     mImageManager = std::make_unique<ImageManager>(this);
     mImageManager->initThread(args.realtime);
     mDrawingBuffer = createFramebuffer();
@@ -428,6 +438,15 @@ GLESRenderEngine::GLESRenderEngine(const RenderEngineCreationArgs& args, EGLDisp
 GLESRenderEngine::~GLESRenderEngine() {
     // Destroy the image manager first.
     mImageManager = nullptr;
+    if (mPrimeCacheThread.joinable()) {
+        mPrimeCacheThread.join();
+    }
+    if (mPrimeCacheSurface != EGL_NO_SURFACE) {
+        eglDestroySurface(mEGLDisplay, mPrimeCacheSurface);
+    }
+    if (mPrimeCacheContext != EGL_NO_CONTEXT) {
+        eglDestroyContext(mEGLDisplay, mPrimeCacheContext);
+    }
     std::lock_guard<std::mutex> lock(mRenderingMutex);
     unbindFrameBuffer(mDrawingBuffer.get());
     mDrawingBuffer = nullptr;
@@ -454,6 +473,38 @@ Framebuffer* GLESRenderEngine::getFramebufferForDrawing() {
     return mDrawingBuffer.get();
 }
 
+void GLESRenderEngine::startPrimeCacheThread(int hwcFormat) {
+    mPrimeCacheContext = createEglContext(mEGLDisplay, mEGLConfig, mEGLContext,
+                                          /*useContextPriority*/ false, Protection::UNPROTECTED);
+    if (mPrimeCacheContext == EGL_NO_CONTEXT) {
+        ALOGW("Can't create prime cache context, shaders will be compiled on first use");
+        return;
+    }
+    if (!GLExtensions::getInstance().hasSurfacelessContext()) {
+        mPrimeCacheSurface = createStubEglPbufferSurface(mEGLDisplay, mEGLConfig, hwcFormat,
+                                                         Protection::UNPROTECTED);
+        if (mPrimeCacheSurface == EGL_NO_SURFACE) {
+            ALOGW("Can't create prime cache pbuffer, shaders will be compiled on first use");
+            return;
+        }
+    }
+
+    mPrimeCacheThread = std::thread([this]() {
+        ATRACE_NAME("REPrimeCache");
+        if (!eglMakeCurrent(mEGLDisplay, mPrimeCacheSurface, mPrimeCacheSurface,
+                            mPrimeCacheContext)) {
+            ALOGE("Can't make prime cache context current: %#x", eglGetError());
+            return;
+        }
+        // Programs are keyed by the context that will use them; the objects
+        // themselves live in the share group.
+        ProgramCache::getInstance().primeCache(mEGLContext, mArgs.useColorManagement,
+                                               mArgs.precacheToneMapperShaderOnly);
+        eglMakeCurrent(mEGLDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    });
+    pthread_setname_np(mPrimeCacheThread.native_handle(), "REPrimeCache");
+}
+
 void GLESRenderEngine::primeCache() const {
     ProgramCache::getInstance().primeCache(mInProtectedContext ? mProtectedEGLContext : mEGLContext,
                                            mArgs.useColorManagement,
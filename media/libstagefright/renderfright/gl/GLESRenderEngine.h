@@ -126,6 +126,9 @@ private:
     std::unique_ptr<Framebuffer> createFramebuffer();
     std::unique_ptr<Image> createImage();
     void checkErrors() const;
+    // Compiles the known programs on a background thread, using a context that
+    // shares objects with mEGLContext.
+    void startPrimeCacheThread(int hwcFormat);
     void checkErrors(const char* tag) const;
     void setScissor(const Rect& region);
     void disableScissor();
@@ -184,6 +187,9 @@ private:
     EGLSurface mStubSurface;
     EGLContext mProtectedEGLContext;
     EGLSurface mProtectedStubSurface;
+    EGLContext mPrimeCacheContext = EGL_NO_CONTEXT;
+    EGLSurface mPrimeCacheSurface = EGL_NO_SURFACE;
+    std::thread mPrimeCacheThread;
     GLint mMaxViewportDims[2];
     GLint mMaxTextureSize;
     GLuint mVpWidth;
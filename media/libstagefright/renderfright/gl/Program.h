@@ -18,6 +18,7 @@
 #define SF_RENDER_ENGINE_PROGRAM_H
 
 #include <stdint.h>
+#include <vector>
 
 #include <GLES2/gl2.h>
 #include <renderengine/private/Description.h>
@@ -54,6 +55,9 @@ public:
     };
 
     Program(const ProgramCache::Key& needs, const char* vertex, const char* fragment);
+    /* loads a program previously linked and retrieved with getBinary() */
+    Program(const ProgramCache::Key& needs, GLenum binaryFormat, const void* binary,
+            GLsizei length);
     ~Program() = default;
 
     /* whether this object is usable */
@@ -71,8 +75,12 @@ public:
     /* set-up uniforms from the description */
     void setUniforms(const Description& desc);
 
+    /* retrieves the linked program binary, returns false if unsupported */
+    bool getBinary(GLenum* binaryFormat, std::vector<uint8_t>* binary) const;
+
 private:
     GLuint buildShader(const char* source, GLenum type);
+    void initialize(GLuint programId);
 
     // whether the initialization succeeded
     bool mInitialized;
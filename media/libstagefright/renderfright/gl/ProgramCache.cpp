@@ -18,12 +18,21 @@
 
 #include "ProgramCache.h"
 
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 #include <GLES2/gl2.h>
 #include <GLES2/gl2ext.h>
+#include <android-base/file.h>
+#include <android-base/stringprintf.h>
 #include <log/log.h>
 #include <renderengine/private/Description.h>
 #include <utils/String8.h>
 #include <utils/Trace.h>
+#include "GLExtensions.h"
 #include "Program.h"
 
 ANDROID_SINGLETON_STATIC_INSTANCE(android::renderengine::gl::ProgramCache)
@@ -79,8 +88,20 @@ Formatter& dedent(Formatter& f) {
 
 void ProgramCache::primeCache(
         EGLContext context, bool useColorManagement, bool toneMapperShaderOnly) {
-    auto& cache = mCaches[context];
     uint32_t shaderCount = 0;
+    auto cacheProgram = [&](const Key& shaderKey) {
+        std::lock_guard<std::mutex> lock(mMutex);
+        auto& cache = mCaches[context];
+        if (cache.count(shaderKey) != 0) {
+            return;
+        }
+        std::unique_ptr<Program> program = generateProgram(shaderKey);
+        // When priming from a shared context, the link must be complete before
+        // the program can be used from |context|.
+        glFinish();
+        cache.emplace(shaderKey, std::move(program));
+        shaderCount++;
+    };
 
     if (toneMapperShaderOnly) {
         Key shaderKey;
@@ -101,10 +122,7 @@ void ProgramCache::primeCache(
             // Cache Y410 input on or off
             shaderKey.set(Key::Y410_BT2020_MASK, (i & 2) ?
                     Key::Y410_BT2020_ON : Key::Y410_BT2020_OFF);
-            if (cache.count(shaderKey) == 0) {
-                cache.emplace(shaderKey, generateProgram(shaderKey));
-                shaderCount++;
-            }
+            cacheProgram(shaderKey);
         }
         return;
     }
@@ -122,10 +140,7 @@ void ProgramCache::primeCache(
         if (tex != Key::TEXTURE_OFF && tex != Key::TEXTURE_EXT && tex != Key::TEXTURE_2D) {
             continue;
         }
-        if (cache.count(shaderKey) == 0) {
-            cache.emplace(shaderKey, generateProgram(shaderKey));
-            shaderCount++;
-        }
+        cacheProgram(shaderKey);
     }
 
     // Prime for sRGB->P3 conversion
@@ -146,10 +161,7 @@ void ProgramCache::primeCache(
 
             // Cache texture off option for window transition
             shaderKey.set(Key::TEXTURE_MASK, (i & 8) ? Key::TEXTURE_EXT : Key::TEXTURE_OFF);
-            if (cache.count(shaderKey) == 0) {
-                cache.emplace(shaderKey, generateProgram(shaderKey));
-                shaderCount++;
-            }
+            cacheProgram(shaderKey);
         }
     }
 
@@ -769,6 +781,37 @@ String8 ProgramCache::generateFragmentShader(const Key& needs) {
     return fs.getString();
 }
 
+void ProgramCache::setBinaryCacheDir(const std::string& dir) {
+    if (!dir.empty() && mkdir(dir.c_str(), 0700) != 0 && errno != EEXIST) {
+        ALOGW("Unable to create program binary cache %s: %s", dir.c_str(), strerror(errno));
+    }
+    std::lock_guard<std::mutex> lock(mMutex);
+    mBinaryCacheDir = dir;
+}
+
+namespace {
+
+// Each cached binary file starts with this header. The source hash covers the
+// shader sources and the GL implementation, so stale binaries are recompiled.
+struct ProgramBinaryHeader {
+    uint32_t magic;
+    uint32_t binaryFormat;
+    uint64_t sourceHash;
+};
+
+constexpr uint32_t kProgramBinaryMagic = 0x52464250; // 'RFBP'
+
+uint64_t hashProgramSource(const String8& vs, const String8& fs) {
+    const GLExtensions& extensions = GLExtensions::getInstance();
+    std::string source(vs.string());
+    source.append(fs.string());
+    source.append(extensions.getRenderer());
+    source.append(extensions.getVersion());
+    return std::hash<std::string>{}(source);
+}
+
+} // namespace
+
 std::unique_ptr<Program> ProgramCache::generateProgram(const Key& needs) {
     ATRACE_CALL();
 
@@ -778,7 +821,42 @@ std::unique_ptr<Program> ProgramCache::generateProgram(const Key& needs) {
     // fragment shader
     String8 fs = generateFragmentShader(needs);
 
-    return std::make_unique<Program>(needs, vs.string(), fs.string());
+    if (mBinaryCacheDir.empty()) {
+        return std::make_unique<Program>(needs, vs.string(), fs.string());
+    }
+
+    const std::string path =
+            base::StringPrintf("%s/%08x.bin", mBinaryCacheDir.c_str(), needs.mKey);
+    ProgramBinaryHeader header = {kProgramBinaryMagic, 0, hashProgramSource(vs, fs)};
+
+    std::string contents;
+    if (base::ReadFileToString(path, &contents) && contents.size() > sizeof(header)) {
+        ProgramBinaryHeader stored;
+        memcpy(&stored, contents.data(), sizeof(stored));
+        if (stored.magic == header.magic && stored.sourceHash == header.sourceHash) {
+            auto program = std::make_unique<Program>(needs, stored.binaryFormat,
+                                                     contents.data() + sizeof(stored),
+                                                     contents.size() - sizeof(stored));
+            if (program->isValid()) {
+                return program;
+            }
+        }
+    }
+
+    auto program = std::make_unique<Program>(needs, vs.string(), fs.string());
+    std::vector<uint8_t> binary;
+    if (program->isValid() && program->getBinary(&header.binaryFormat, &binary)) {
+        contents.assign(reinterpret_cast<const char*>(&header), sizeof(header));
+        contents.append(reinterpret_cast<const char*>(binary.data()), binary.size());
+        // Write to a private file first so that readers never see a partial binary.
+        const std::string tmpPath = base::StringPrintf("%s.%d", path.c_str(), getpid());
+        if (!base::WriteStringToFile(contents, tmpPath) ||
+            rename(tmpPath.c_str(), path.c_str()) != 0) {
+            ALOGW("Unable to store program binary %s: %s", path.c_str(), strerror(errno));
+            unlink(tmpPath.c_str());
+        }
+    }
+    return program;
 }
 
 void ProgramCache::useProgram(EGLContext context, const Description& description) {
@@ -786,6 +864,7 @@ void ProgramCache::useProgram(EGLContext context, const Description& description
     Key needs(computeKey(description));
 
     // look-up the program in the cache
+    std::lock_guard<std::mutex> lock(mMutex);
     auto& cache = mCaches[context];
     auto it = cache.find(needs);
     if (it == cache.end()) {
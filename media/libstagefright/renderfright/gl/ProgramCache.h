@@ -18,10 +18,13 @@
 #define SF_RENDER_ENGINE_PROGRAMCACHE_H
 
 #include <memory>
+#include <mutex>
+#include <string>
 #include <unordered_map>
 
 #include <EGL/egl.h>
 #include <GLES2/gl2.h>
+#include <android-base/thread_annotations.h>
 #include <renderengine/private/Description.h>
 #include <utils/Singleton.h>
 #include <utils/TypeHelpers.h>
@@ -185,10 +188,18 @@ public:
     ProgramCache() = default;
     ~ProgramCache() = default;
 
-    // Generate shaders to populate the cache
+    // Generate shaders to populate the cache. This may run on a thread whose
+    // current context shares objects with |context|.
     void primeCache(const EGLContext context, bool useColorManagement, bool toneMapperShaderOnly);
 
-    size_t getSize(const EGLContext context) { return mCaches[context].size(); }
+    size_t getSize(const EGLContext context) {
+        std::lock_guard<std::mutex> lock(mMutex);
+        return mCaches[context].size();
+    }
+
+    // Persist linked program binaries in |dir| and load them from there
+    // instead of compiling when possible. An empty |dir| disables this.
+    void setBinaryCacheDir(const std::string& dir);
 
     // useProgram lookup a suitable program in the cache or generates one
     // if none can be found.
@@ -205,17 +216,23 @@ private:
     static void generateOOTF(Formatter& fs, const Key& needs);
     // Generate OETF based from Key.
     static void generateOETF(Formatter& fs, const Key& needs);
-    // generates a program from the Key
-    static std::unique_ptr<Program> generateProgram(const Key& needs);
+    // generates a program from the Key, going through the binary cache if any
+    std::unique_ptr<Program> generateProgram(const Key& needs) REQUIRES(mMutex);
     // generates the vertex shader from the Key
     static String8 generateVertexShader(const Key& needs);
     // generates the fragment shader from the Key
     static String8 generateFragmentShader(const Key& needs);
 
+    // Guards the caches, and serializes program generation so that a program
+    // being primed in the background is never generated twice.
+    std::mutex mMutex;
+
     // Key/Value map used for caching Programs. Currently the cache
     // is never shrunk (and the GL program objects are never deleted).
     std::unordered_map<EGLContext, std::unordered_map<Key, std::unique_ptr<Program>, Key::Hash>>
-            mCaches;
+            mCaches GUARDED_BY(mMutex);
+
+    std::string mBinaryCacheDir GUARDED_BY(mMutex);
 };
 
 } // namespace gl
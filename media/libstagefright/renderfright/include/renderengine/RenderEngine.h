@@ -20,6 +20,7 @@
 #include <stdint.h>
 #include <sys/types.h>
 #include <memory>
+#include <string>
 
 #include <android-base/unique_fd.h>
 #include <math/mat4.h>
@@ -203,6 +204,12 @@ struct RenderEngineCreationArgs {
     bool useColorManagement;
     bool enableProtectedContext;
     bool precacheToneMapperShaderOnly;
+    // Prime the program cache on a background thread with a shared context,
+    // so that the first draw does not have to compile shaders.
+    bool precacheInBackground;
+    // Directory where linked program binaries are persisted across instances.
+    // Empty disables the on-disk cache.
+    std::string programBinaryCacheDir;
     bool supportsBackgroundBlur;
     RenderEngine::ContextPriority contextPriority;
     RenderEngine::RenderEngineType renderEngineType;
@@ -214,6 +221,8 @@ private:
     // must be created by Builder via constructor with full argument list
     RenderEngineCreationArgs(int _pixelFormat, uint32_t _imageCacheSize, bool _useColorManagement,
                              bool _enableProtectedContext, bool _precacheToneMapperShaderOnly,
+                             bool _precacheInBackground,
+                             const std::string& _programBinaryCacheDir,
                              bool _supportsBackgroundBlur,
                              RenderEngine::ContextPriority _contextPriority,
                              RenderEngine::RenderEngineType _renderEngineType,
@@ -223,6 +232,8 @@ private:
             useColorManagement(_useColorManagement),
             enableProtectedContext(_enableProtectedContext),
             precacheToneMapperShaderOnly(_precacheToneMapperShaderOnly),
+            precacheInBackground(_precacheInBackground),
+            programBinaryCacheDir(_programBinaryCacheDir),
             supportsBackgroundBlur(_supportsBackgroundBlur),
             contextPriority(_contextPriority),
             renderEngineType(_renderEngineType),
@@ -253,6 +264,14 @@ struct RenderEngineCreationArgs::Builder {
         this->precacheToneMapperShaderOnly = precacheToneMapperShaderOnly;
         return *this;
     }
+    Builder& setPrecacheInBackground(bool precacheInBackground) {
+        this->precacheInBackground = precacheInBackground;
+        return *this;
+    }
+    Builder& setProgramBinaryCacheDir(const std::string& programBinaryCacheDir) {
+        this->programBinaryCacheDir = programBinaryCacheDir;
+        return *this;
+    }
     Builder& setSupportsBackgroundBlur(bool supportsBackgroundBlur) {
         this->supportsBackgroundBlur = supportsBackgroundBlur;
         return *this;
@@ -272,6 +291,7 @@ struct RenderEngineCreationArgs::Builder {
     RenderEngineCreationArgs build() const {
         return RenderEngineCreationArgs(pixelFormat, imageCacheSize, useColorManagement,
                                         enableProtectedContext, precacheToneMapperShaderOnly,
+                                        precacheInBackground, programBinaryCacheDir,
                                         supportsBackgroundBlur, contextPriority, renderEngineType,
                                         realtime);
     }
@@ -283,6 +303,8 @@ private:
     bool useColorManagement = true;
     bool enableProtectedContext = false;
     bool precacheToneMapperShaderOnly = false;
+    bool precacheInBackground = false;
+    std::string programBinaryCacheDir;
     bool supportsBackgroundBlur = false;
     RenderEngine::ContextPriority contextPriority = RenderEngine::ContextPriority::MEDIUM;
     RenderEngine::RenderEngineType renderEngineType = RenderEngine::RenderEngineType::GLES;
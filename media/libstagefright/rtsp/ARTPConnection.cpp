@@ -31,6 +31,7 @@
 
 #include <media/stagefright/foundation/ABuffer.h>
 #include <media/stagefright/foundation/ADebug.h>
+#include <media/stagefright/foundation/ALooper.h>
 #include <media/stagefright/foundation/AMessage.h>
 #include <media/stagefright/foundation/AString.h>
 #include <media/stagefright/foundation/hexdump.h>
@@ -44,6 +45,10 @@ namespace android {
 
 static const size_t kMaxUDPSize = 1500;
 
+// Largest datagram receive() accepts, and the number it takes per call.
+static const size_t kMaxDatagramSize = 65536;
+static const size_t kMaxReceiveBatch = 8;
+
 static uint16_t u16at(const uint8_t *data) {
     return data[0] << 8 | data[1];
 }
@@ -92,6 +97,7 @@ ARTPConnection::ARTPConnection(uint32_t flags)
       mLastReceiverReportTimeUs(-1),
       mLastBitrateReportTimeUs(-1),
       mLastCongestionNotifyTimeUs(-1),
+      mSelfID(0),
       mTargetBitrate(-1),
       mRtpSockOptEcn(0),
       mIsIPv6(false),
@@ -99,6 +105,9 @@ ARTPConnection::ARTPConnection(uint32_t flags)
 }
 
 ARTPConnection::~ARTPConnection() {
+    while (!mShards.empty()) {
+        removeShard(mShards.begin());
+    }
 }
 
 void ARTPConnection::addStream(
@@ -360,6 +369,11 @@ void ARTPConnection::onMessageReceived(const sp<AMessage> &msg) {
 }
 
 void ARTPConnection::onAddStream(const sp<AMessage> &msg) {
+    if (mFlags & kStreamPerLooper) {
+        addShard(msg);
+        return;
+    }
+
     mStreams.push_back(StreamInfo());
     StreamInfo *info = &*--mStreams.end();
 
@@ -404,7 +418,12 @@ void ARTPConnection::onAddStream(const sp<AMessage> &msg) {
 }
 
 void ARTPConnection::onSeekStream(const sp<AMessage> &msg) {
-    (void)msg; // unused param as of now.
+    for (List<Shard>::iterator it = mShards.begin(); it != mShards.end(); ++it) {
+        sp<AMessage> copy = msg->dup();
+        copy->setTarget(it->mConnection);
+        copy->post();
+    }
+
     List<StreamInfo>::iterator it = mStreams.begin();
     while (it != mStreams.end()) {
         for (size_t i = 0; i < it->mSources.size(); ++i) {
@@ -420,6 +439,12 @@ void ARTPConnection::onRemoveStream(const sp<AMessage> &msg) {
     CHECK(msg->findInt32("rtp-socket", &rtpSocket));
     CHECK(msg->findInt32("rtcp-socket", &rtcpSocket));
 
+    List<Shard>::iterator shard = findShard(rtpSocket);
+    if (shard != mShards.end() && shard->mRTCPSocket == rtcpSocket) {
+        removeShard(shard);
+        return;
+    }
+
     List<StreamInfo>::iterator it = mStreams.begin();
     while (it != mStreams.end()
            && (it->mRTPSocket != rtpSocket || it->mRTCPSocket != rtcpSocket)) {
@@ -433,6 +458,47 @@ void ARTPConnection::onRemoveStream(const sp<AMessage> &msg) {
     mStreams.erase(it);
 }
 
+void ARTPConnection::addShard(const sp<AMessage> &msg) {
+    Shard shard;
+    CHECK(msg->findInt32("rtp-socket", &shard.mRTPSocket));
+    CHECK(msg->findInt32("rtcp-socket", &shard.mRTCPSocket));
+
+    shard.mConnection = new ARTPConnection(mFlags & ~kStreamPerLooper);
+    shard.mConnection->mSelfID = mSelfID;
+    shard.mConnection->mTargetBitrate = mTargetBitrate;
+    shard.mConnection->mRtpSockOptEcn = mRtpSockOptEcn;
+    shard.mConnection->mIsIPv6 = mIsIPv6;
+    shard.mConnection->mStaticJitterTimeMs = mStaticJitterTimeMs;
+
+    shard.mLooper = new ALooper;
+    shard.mLooper->setName("rtp stream");
+    shard.mLooper->start(false /* runOnCallingThread */,
+                         false /* canCallJava */,
+                         PRIORITY_HIGHEST);
+    shard.mLooper->registerHandler(shard.mConnection);
+
+    sp<AMessage> copy = msg->dup();
+    copy->setTarget(shard.mConnection);
+    copy->post();
+
+    mShards.push_back(shard);
+}
+
+List<ARTPConnection::Shard>::iterator ARTPConnection::findShard(int socket) {
+    List<Shard>::iterator it = mShards.begin();
+    while (it != mShards.end() && it->mRTPSocket != socket && it->mRTCPSocket != socket) {
+        ++it;
+    }
+    return it;
+}
+
+void ARTPConnection::removeShard(List<Shard>::iterator it) {
+    // Once the looper has stopped, the sockets of the stream are no longer used.
+    it->mLooper->unregisterHandler(it->mConnection->id());
+    it->mLooper->stop();
+    mShards.erase(it);
+}
+
 void ARTPConnection::postPollEvent() {
     if (mPollEventPending) {
         return;
@@ -621,31 +687,39 @@ status_t ARTPConnection::receive(StreamInfo *s, bool receiveRTP) {
 
     CHECK(!s->mIsInjected);
 
-    sp<ABuffer> buffer = new ABuffer(65536);
-
-    struct msghdr sMsg = {};
-    struct iovec sIov[1] = {};
-
-    sIov[0].iov_base = (char *) buffer->data();
-    sIov[0].iov_len = buffer->capacity();
-
-    sMsg.msg_iov = sIov;
-    sMsg.msg_iovlen = 1;
+    if (mReceiveBuffer == NULL) {
+        mReceiveBuffer = new ABuffer(kMaxReceiveBatch * kMaxDatagramSize);
+    }
 
-    int cMsgSize = sizeof(struct cmsghdr) + sizeof(uint8_t);
-    char buf[CMSG_SPACE(cMsgSize)];
-    sMsg.msg_control = buf;
-    sMsg.msg_controllen = sizeof(buf);
-    sMsg.msg_flags = 0;
+    // Drain up to kMaxReceiveBatch datagrams with a single call, rather than
+    // going through select() again for each of them.
+    struct mmsghdr sMsgs[kMaxReceiveBatch] = {};
+    struct iovec sIovs[kMaxReceiveBatch] = {};
+
+    const int cMsgSize = sizeof(struct cmsghdr) + sizeof(uint8_t);
+    char bufs[kMaxReceiveBatch][CMSG_SPACE(cMsgSize)];
+
+    for (size_t i = 0; i < kMaxReceiveBatch; ++i) {
+        sIovs[i].iov_base = (char *) mReceiveBuffer->data() + i * kMaxDatagramSize;
+        sIovs[i].iov_len = kMaxDatagramSize;
+
+        struct msghdr &sMsg = sMsgs[i].msg_hdr;
+        sMsg.msg_iov = &sIovs[i];
+        sMsg.msg_iovlen = 1;
+        // Used to get the TOS header of incoming packets
+        sMsg.msg_control = bufs[i];
+        sMsg.msg_controllen = sizeof(bufs[i]);
+        sMsg.msg_flags = 0;
+    }
 
-    ssize_t nbytes;
+    int count;
     do {
-        // Used recvmsg to get the TOS header of incoming packet
-        nbytes = recvmsg(receiveRTP ? s->mRTPSocket : s->mRTCPSocket, &sMsg, 0);
-        mCumulativeBytes += nbytes;
-    } while (nbytes < 0 && errno == EINTR);
+        // Waits for the first datagram only and takes whatever else is queued.
+        count = recvmmsg(receiveRTP ? s->mRTPSocket : s->mRTCPSocket,
+                sMsgs, kMaxReceiveBatch, MSG_WAITFORONE, NULL);
+    } while (count < 0 && errno == EINTR);
 
-    if (nbytes <= 0) {
+    if (count <= 0) {
         ALOGW("failed to recv rtp packet. cause=%s", strerror(errno));
         // ECONNREFUSED may happen in next recvfrom() calling if one of
         // outgoing packet can not be delivered to remote by using sendto()
@@ -656,19 +730,33 @@ status_t ARTPConnection::receive(StreamInfo *s, bool receiveRTP) {
         }
     }
 
-    if (nbytes > 0) {
-        handleIpHeadersIfReceived(s, sMsg);
-    }
+    status_t err = OK;
+    for (int i = 0; i < count; ++i) {
+        size_t nbytes = sMsgs[i].msg_len;
+        mCumulativeBytes += nbytes;
+        if (nbytes == 0) {
+            continue;
+        }
 
-    buffer->setRange(0, nbytes);
+        handleIpHeadersIfReceived(s, sMsgs[i].msg_hdr);
 
-    // ALOGI("received %d bytes.", buffer->size());
+        // Copy the datagram out so that the packets held in the jitter buffer
+        // only take the memory they need.
+        sp<ABuffer> buffer = new ABuffer(nbytes);
+        memcpy(buffer->data(), sIovs[i].iov_base, nbytes);
 
-    status_t err;
-    if (receiveRTP) {
-        err = parseRTP(s, buffer);
-    } else {
-        err = parseRTCP(s, buffer);
+        // ALOGI("received %d bytes.", buffer->size());
+
+        status_t parseErr;
+        if (receiveRTP) {
+            parseErr = parseRTP(s, buffer);
+        } else {
+            parseErr = parseRTCP(s, buffer);
+        }
+
+        if (err == OK) {
+            err = parseErr;
+        }
     }
 
     return err;
@@ -1372,6 +1460,14 @@ void ARTPConnection::onInjectPacket(const sp<AMessage> &msg) {
     sp<ABuffer> buffer;
     CHECK(msg->findBuffer("buffer", &buffer));
 
+    List<Shard>::iterator shard = findShard(index);
+    if (shard != mShards.end()) {
+        sp<AMessage> copy = msg->dup();
+        copy->setTarget(shard->mConnection);
+        copy->post();
+        return;
+    }
+
     List<StreamInfo>::iterator it = mStreams.begin();
     while (it != mStreams.end()
            && it->mRTPSocket != index && it->mRTCPSocket != index) {
@@ -340,14 +340,22 @@ bool ARTPSource::queuePacket(const sp<ABuffer> &buffer) {
 
     buffer->setInt32Data(seqNum);
 
-    List<sp<ABuffer> >::iterator it = mQueue.begin();
-    while (it != mQueue.end() && (uint32_t)(*it)->int32Data() < seqNum) {
-        ++it;
-    }
-
-    if (it != mQueue.end() && (uint32_t)(*it)->int32Data() == seqNum) {
-        ALOGW("Discarding duplicate buffer");
-        return false;
+    // Packets mostly arrive in order or only slightly reordered, so search for the
+    // insertion point from the newest end of the queue, which holds up to a jitter
+    // buffer's worth of packets.
+    List<sp<ABuffer> >::iterator it = mQueue.end();
+    while (it != mQueue.begin()) {
+        List<sp<ABuffer> >::iterator prev = it;
+        --prev;
+        uint32_t prevSeqNum = (uint32_t)(*prev)->int32Data();
+        if (prevSeqNum == seqNum) {
+            ALOGW("Discarding duplicate buffer");
+            return false;
+        }
+        if (prevSeqNum < seqNum) {
+            break;
+        }
+        it = prev;
     }
 
     mQueue.insert(it, buffer);
@@ -31,8 +31,16 @@
 #include <utils/ByteOrder.h>
 
 #include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/udp.h>
 #include <strings.h>
 
+#include <algorithm>
+
+#ifndef UDP_SEGMENT
+#define UDP_SEGMENT 103
+#endif
+
 #define PT      97
 #define PT_STR  "97"
 
@@ -68,6 +76,20 @@ static char kCNAME[255] = "someone@somewhere";
 static const size_t kTrafficRecorderMaxEntries = 128;
 static const size_t kTrafficRecorderMaxTimeSpanMs = 2000;
 
+// RTP header with the CVO extension and up to 3 bytes of FU headers.
+static const size_t kMaxRtpHeaderSize = 12 + 8 + 3;
+
+// With pacing, frames of more than this many packets are sent in bursts of this size,
+// spread over half of the frame interval.
+static const size_t kPacingBurstPackets = 8;
+static const int64_t kDefaultFrameIntervalUs = 33333;
+static const int64_t kMinFrameIntervalUs = 5000;
+static const int64_t kMaxFrameIntervalUs = 100000;
+
+// Limits of a UDP GSO send in the kernel.
+static const size_t kMaxGSOSegments = 64;
+static const size_t kMaxGSOBytes = 65000;
+
 static int UniformRand(int limit) {
     return ((double)rand() * limit) / RAND_MAX;
 }
@@ -214,6 +236,13 @@ void ARTPWriter::initState() {
     mRTPCVODegrees = 0;
     mRTPSockNetwork = 0;
 
+    mPendingPackets.clear();
+    mPacketHeaders.clear();
+    mPacing = false;
+    mUseGSO = true;
+    mLastFrameTimeUs = -1;
+    mFrameIntervalUs = kDefaultFrameIntervalUs;
+
     mMode = INVALID;
     mClockRate = 16000;
 }
@@ -285,6 +314,10 @@ status_t ARTPWriter::start(MetaData * params) {
         updateSocketOpt();
     }
 
+    int32_t pacing = 0;
+    if (params->findInt32(kKeyRtpPacing, &pacing))
+        mPacing = pacing != 0;
+
     int64_t sockNetwork = 0;
     if (params->findInt64(kKeySocketNetwork, &sockNetwork))
         updateSocketNetwork(sockNetwork);
@@ -627,6 +660,13 @@ void ARTPWriter::onSendSR(const sp<AMessage> &msg) {
 }
 
 void ARTPWriter::send(const sp<ABuffer> &buffer, bool isRTCP) {
+    struct iovec iov;
+    iov.iov_base = buffer->data();
+    iov.iov_len = buffer->size();
+    send(&iov, 1, isRTCP);
+}
+
+void ARTPWriter::send(const struct iovec *iov, size_t iovCount, bool isRTCP) {
     int sizeSockSt;
     struct sockaddr *remAddr;
 
@@ -644,19 +684,28 @@ void ARTPWriter::send(const sp<ABuffer> &buffer, bool isRTCP) {
             remAddr = (struct sockaddr *)&mRTPAddr;
     }
 
+    size_t size = 0;
+    for (size_t i = 0; i < iovCount; ++i) {
+        size += iov[i].iov_len;
+    }
+
     // Unseal code if moderator is needed (prevent overflow of instant bandwidth)
     // Set limit bits per period through the moderator.
     // ex) 6KByte/10ms = 48KBit/10ms = 4.8MBit/s instant limit
     // ModerateInstantTraffic(10, 6 * 1024);
 
-    ssize_t n = sendto(isRTCP ? mRTCPSocket : mRTPSocket,
-            buffer->data(), buffer->size(), 0, remAddr, sizeSockSt);
+    struct msghdr msg = {};
+    msg.msg_name = remAddr;
+    msg.msg_namelen = sizeSockSt;
+    msg.msg_iov = const_cast<struct iovec *>(iov);
+    msg.msg_iovlen = iovCount;
+    ssize_t n = sendmsg(isRTCP ? mRTCPSocket : mRTPSocket, &msg, 0);
 
-    if (n != (ssize_t)buffer->size()) {
-        ALOGW("packets can not be sent. ret=%d, buf=%d", (int)n, (int)buffer->size());
+    if (n != (ssize_t)size) {
+        ALOGW("packets can not be sent. ret=%d, buf=%d", (int)n, (int)size);
     } else {
         // Record current traffic & Print bits while last 1sec (1000ms)
-        mTrafficRec->writeBytes(buffer->size() +
+        mTrafficRec->writeBytes(size +
                 (mIsIPv6 ? TCPIPV6_HEADER_SIZE : TCPIPV4_HEADER_SIZE));
         mTrafficRec->printAccuBitsForLastPeriod(1000, 1000);
     }
@@ -665,13 +714,166 @@ void ARTPWriter::send(const sp<ABuffer> &buffer, bool isRTCP) {
     int fd = isRTCP ? mRTCPFd : mRTPFd;
 
     uint32_t ms = tolel(ALooper::GetNowUs() / 1000ll);
-    uint32_t length = tolel(buffer->size());
+    uint32_t length = tolel(size);
     write(fd, &ms, sizeof(ms));
     write(fd, &length, sizeof(length));
-    write(fd, buffer->data(), buffer->size());
+    writev(fd, iov, iovCount);
 #endif
 }
 
+void ARTPWriter::queuePacket(const uint8_t *header, size_t headerSize,
+                             const uint8_t *payload, size_t payloadSize) {
+    CHECK_LE(headerSize, kMaxRtpHeaderSize);
+    PendingPacket packet;
+    packet.headerOffset = mPacketHeaders.size();
+    packet.headerSize = headerSize;
+    packet.payload = payload;
+    packet.payloadSize = payloadSize;
+    mPacketHeaders.insert(mPacketHeaders.end(), header, header + headerSize);
+    mPendingPackets.push_back(packet);
+}
+
+// Sends the queued packets of a frame, which must still hold the payloads.
+// With pacing, large frames such as IDR frames are spread over half of the frame interval,
+// so that the network does not see a burst of a whole frame at once.
+void ARTPWriter::flushPackets(int64_t timeUs) {
+    const size_t count = mPendingPackets.size();
+    if (count == 0) {
+        return;
+    }
+
+    // Parameter sets are sent separately with the time of their frame.
+    if (mLastFrameTimeUs >= 0 && timeUs > mLastFrameTimeUs) {
+        mFrameIntervalUs = std::clamp(timeUs - mLastFrameTimeUs,
+                                      kMinFrameIntervalUs, kMaxFrameIntervalUs);
+    }
+    mLastFrameTimeUs = timeUs;
+
+    size_t burst = count;
+    int64_t spreadUs = 0;
+    if (mPacing && count > kPacingBurstPackets) {
+        burst = kPacingBurstPackets;
+        spreadUs = mFrameIntervalUs / 2;
+    }
+    const size_t numBursts = (count + burst - 1) / burst;
+
+    const int64_t startUs = ALooper::GetNowUs();
+    for (size_t i = 0, b = 0; i < count; i += burst, ++b) {
+        if (b > 0) {
+            int64_t waitUs = startUs + spreadUs * (int64_t)b / (int64_t)numBursts
+                    - ALooper::GetNowUs();
+            if (waitUs > 0) {
+                usleep(waitUs);
+            }
+        }
+        const size_t end = std::min(i + burst, count);
+        for (size_t next = i; next < end;) {
+            next += sendPackets(next, end - next);
+        }
+    }
+
+    mPendingPackets.clear();
+    mPacketHeaders.clear();
+}
+
+// Sends the longest run of packets starting at |first| that the kernel can segment from
+// a single buffer, i.e. packets of the same size with an optional smaller one at the end,
+// and returns the number of packets sent.
+size_t ARTPWriter::sendPackets(size_t first, size_t count) {
+    auto packetSize = [this](size_t i) {
+        return mPendingPackets[i].headerSize + mPendingPackets[i].payloadSize;
+    };
+
+    const size_t segmentSize = packetSize(first);
+    size_t segments = 1;
+    size_t bytes = segmentSize;
+    if (mUseGSO) {
+        while (segments < count && segments < kMaxGSOSegments) {
+            const size_t size = packetSize(first + segments);
+            if (size > segmentSize || bytes + size > kMaxGSOBytes) {
+                break;
+            }
+            ++segments;
+            bytes += size;
+            if (size < segmentSize) {
+                break;
+            }
+        }
+    }
+
+    if (segments > 1 && sendSegmented(first, segments, segmentSize)) {
+        return segments;
+    }
+
+    const PendingPacket &packet = mPendingPackets[first];
+    struct iovec iov[2];
+    iov[0].iov_base = &mPacketHeaders[packet.headerOffset];
+    iov[0].iov_len = packet.headerSize;
+    iov[1].iov_base = const_cast<uint8_t *>(packet.payload);
+    iov[1].iov_len = packet.payloadSize;
+    send(iov, 2, false /* isRTCP */);
+    return 1;
+}
+
+// Sends |count| packets with one UDP GSO call, which the kernel splits into datagrams of
+// |segmentSize| bytes. Returns false if GSO is not available, in which case it is not
+// tried again.
+bool ARTPWriter::sendSegmented(size_t first, size_t count, size_t segmentSize) {
+    mPacketIovecs.resize(2 * count);
+    size_t size = 0;
+    for (size_t i = 0; i < count; ++i) {
+        const PendingPacket &packet = mPendingPackets[first + i];
+        mPacketIovecs[2 * i].iov_base = &mPacketHeaders[packet.headerOffset];
+        mPacketIovecs[2 * i].iov_len = packet.headerSize;
+        mPacketIovecs[2 * i + 1].iov_base = const_cast<uint8_t *>(packet.payload);
+        mPacketIovecs[2 * i + 1].iov_len = packet.payloadSize;
+        size += packet.headerSize + packet.payloadSize;
+    }
+
+    char control[CMSG_SPACE(sizeof(uint16_t))] = {};
+    struct msghdr msg = {};
+    msg.msg_name = mIsIPv6 ? (struct sockaddr *)&mRTPAddr6 : (struct sockaddr *)&mRTPAddr;
+    msg.msg_namelen = mIsIPv6 ? sizeof(struct sockaddr_in6) : sizeof(struct sockaddr_in);
+    msg.msg_iov = mPacketIovecs.data();
+    msg.msg_iovlen = mPacketIovecs.size();
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = IPPROTO_UDP;
+    cmsg->cmsg_type = UDP_SEGMENT;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+    const uint16_t gsoSize = segmentSize;
+    memcpy(CMSG_DATA(cmsg), &gsoSize, sizeof(gsoSize));
+
+    ssize_t n = sendmsg(mRTPSocket, &msg, 0);
+    if (n < 0 && (errno == EIO || errno == EINVAL || errno == ENOPROTOOPT
+            || errno == EOPNOTSUPP)) {
+        // Older kernels reject the option, and IPsec transforms do not support GSO.
+        ALOGI("UDP GSO not available (%s), sending packets one by one", strerror(errno));
+        mUseGSO = false;
+        return false;
+    }
+
+    if (n != (ssize_t)size) {
+        ALOGW("packets can not be sent. ret=%d, buf=%d", (int)n, (int)size);
+    } else {
+        const size_t ipHeaderSize = mIsIPv6 ? TCPIPV6_HEADER_SIZE : TCPIPV4_HEADER_SIZE;
+        mTrafficRec->writeBytes(size + count * ipHeaderSize);
+        mTrafficRec->printAccuBitsForLastPeriod(1000, 1000);
+    }
+
+#if LOG_TO_FILES
+    for (size_t i = 0; i < count; ++i) {
+        uint32_t ms = tolel(ALooper::GetNowUs() / 1000ll);
+        uint32_t length = tolel(mPacketIovecs[2 * i].iov_len + mPacketIovecs[2 * i + 1].iov_len);
+        write(mRTPFd, &ms, sizeof(ms));
+        write(mRTPFd, &length, sizeof(length));
+        writev(mRTPFd, &mPacketIovecs[2 * i], 2);
+    }
+#endif
+    return true;
+}
+
 void ARTPWriter::addSR(const sp<ABuffer> &buffer) {
     uint8_t *data = buffer->data() + buffer->size();
 
@@ -1047,11 +1249,11 @@ void ARTPWriter::sendHEVCData(MediaBufferBase *mediaBuf) {
         isNonVCL = 1;
     }
 
-    sp<ABuffer> buffer = new ABuffer(kMaxPacketSize);
+    uint8_t header[kMaxRtpHeaderSize];
     if (mediaBuf->range_length() + TCPIP_HEADER_SIZE + RTP_HEADER_SIZE + RTP_HEADER_EXT_SIZE
-            + RTP_PAYLOAD_ROOM_SIZE <= buffer->capacity()) {
+            + RTP_PAYLOAD_ROOM_SIZE <= kMaxPacketSize) {
         // The data fits into a single packet
-        uint8_t *data = buffer->data();
+        uint8_t *data = header;
         data[0] = 0x80;
         if (mRTPCVOExtMap > 0) {
             data[0] |= 0x10;
@@ -1107,16 +1309,11 @@ void ARTPWriter::sendHEVCData(MediaBufferBase *mediaBuf) {
             rtpExtIndex = 8;
         }
 
-        memcpy(&data[12 + rtpExtIndex],
-               mediaData, mediaBuf->range_length());
-
-        buffer->setRange(0, mediaBuf->range_length() + (12 + rtpExtIndex));
-
-        send(buffer, false /* isRTCP */);
+        queuePacket(data, 12 + rtpExtIndex, mediaData, mediaBuf->range_length());
 
         ++mSeqNo;
         ++mNumRTPSent;
-        mNumRTPOctetsSent += buffer->size() - (12 + rtpExtIndex);
+        mNumRTPOctetsSent += mediaBuf->range_length();
     } else {
         // FU-A
 
@@ -1129,13 +1326,13 @@ void ARTPWriter::sendHEVCData(MediaBufferBase *mediaBuf) {
             size_t size = mediaBuf->range_length() - offset;
             bool lastPacket = true;
             if (size + TCPIP_HEADER_SIZE + RTP_HEADER_SIZE + RTP_HEADER_EXT_SIZE +
-                    RTP_FU_HEADER_SIZE + RTP_PAYLOAD_ROOM_SIZE > buffer->capacity()) {
+                    RTP_FU_HEADER_SIZE + RTP_PAYLOAD_ROOM_SIZE > kMaxPacketSize) {
                 lastPacket = false;
-                size = buffer->capacity() - TCPIP_HEADER_SIZE - RTP_HEADER_SIZE -
+                size = kMaxPacketSize - TCPIP_HEADER_SIZE - RTP_HEADER_SIZE -
                     RTP_HEADER_EXT_SIZE - RTP_FU_HEADER_SIZE - RTP_PAYLOAD_ROOM_SIZE;
             }
 
-            uint8_t *data = buffer->data();
+            uint8_t *data = header;
             data[0] = 0x80;
             if (lastPacket && mRTPCVOExtMap > 0) {
                 data[0] |= 0x10;
@@ -1195,20 +1392,18 @@ void ARTPWriter::sendHEVCData(MediaBufferBase *mediaBuf) {
                 | (nalType & H265_NALU_MASK);
             ALOGV("H265 FU indicator 0x%x", data[14]);
 
-            memcpy(&data[15 + rtpExtIndex], &mediaData[offset], size);
-
-            buffer->setRange(0, 15 + rtpExtIndex + size);
-
-            send(buffer, false /* isRTCP */);
+            queuePacket(data, 15 + rtpExtIndex, &mediaData[offset], size);
 
             ++mSeqNo;
             ++mNumRTPSent;
-            mNumRTPOctetsSent += buffer->size() - (12 + rtpExtIndex);
+            mNumRTPOctetsSent += 3 + size;
 
             firstPacket = false;
             offset += size;
         }
     }
+
+    flushPackets(timeUs);
 }
 
 void ARTPWriter::sendAVCData(MediaBufferBase *mediaBuf) {
@@ -1234,11 +1429,11 @@ void ARTPWriter::sendAVCData(MediaBufferBase *mediaBuf) {
     }
 
     mTrafficRec->updateClock(ALooper::GetNowUs() / 1000);
-    sp<ABuffer> buffer = new ABuffer(kMaxPacketSize);
+    uint8_t header[kMaxRtpHeaderSize];
     if (mediaBuf->range_length() + TCPIP_HEADER_SIZE + RTP_HEADER_SIZE + RTP_HEADER_EXT_SIZE
-            + RTP_PAYLOAD_ROOM_SIZE <= buffer->capacity()) {
+            + RTP_PAYLOAD_ROOM_SIZE <= kMaxPacketSize) {
         // The data fits into a single packet
-        uint8_t *data = buffer->data();
+        uint8_t *data = header;
         data[0] = 0x80;
         if (mRTPCVOExtMap > 0) {
             data[0] |= 0x10;
@@ -1294,16 +1489,11 @@ void ARTPWriter::sendAVCData(MediaBufferBase *mediaBuf) {
             rtpExtIndex = 8;
         }
 
-        memcpy(&data[12 + rtpExtIndex],
-               mediaData, mediaBuf->range_length());
-
-        buffer->setRange(0, mediaBuf->range_length() + (12 + rtpExtIndex));
-
-        send(buffer, false /* isRTCP */);
+        queuePacket(data, 12 + rtpExtIndex, mediaData, mediaBuf->range_length());
 
         ++mSeqNo;
         ++mNumRTPSent;
-        mNumRTPOctetsSent += buffer->size() - (12 + rtpExtIndex);
+        mNumRTPOctetsSent += mediaBuf->range_length();
     } else {
         // FU-A
 
@@ -1316,13 +1506,13 @@ void ARTPWriter::sendAVCData(MediaBufferBase *mediaBuf) {
             size_t size = mediaBuf->range_length() - offset;
             bool lastPacket = true;
             if (size + TCPIP_HEADER_SIZE + RTP_HEADER_SIZE + RTP_HEADER_EXT_SIZE +
-                    RTP_FU_HEADER_SIZE + RTP_PAYLOAD_ROOM_SIZE > buffer->capacity()) {
+                    RTP_FU_HEADER_SIZE + RTP_PAYLOAD_ROOM_SIZE > kMaxPacketSize) {
                 lastPacket = false;
-                size = buffer->capacity() - TCPIP_HEADER_SIZE - RTP_HEADER_SIZE -
+                size = kMaxPacketSize - TCPIP_HEADER_SIZE - RTP_HEADER_SIZE -
                     RTP_HEADER_EXT_SIZE - RTP_FU_HEADER_SIZE - RTP_PAYLOAD_ROOM_SIZE;
             }
 
-            uint8_t *data = buffer->data();
+            uint8_t *data = header;
             data[0] = 0x80;
             if (lastPacket && mRTPCVOExtMap > 0) {
                 data[0] |= 0x10;
@@ -1379,20 +1569,18 @@ void ARTPWriter::sendAVCData(MediaBufferBase *mediaBuf) {
                 | (nalType & H264_NALU_MASK);
             ALOGV("H264 FU header 0x%x", data[13]);
 
-            memcpy(&data[14 + rtpExtIndex], &mediaData[offset], size);
-
-            buffer->setRange(0, 14 + rtpExtIndex + size);
-
-            send(buffer, false /* isRTCP */);
+            queuePacket(data, 14 + rtpExtIndex, &mediaData[offset], size);
 
             ++mSeqNo;
             ++mNumRTPSent;
-            mNumRTPOctetsSent += buffer->size() - (12 + rtpExtIndex);
+            mNumRTPOctetsSent += 2 + size;
 
             firstPacket = false;
             offset += size;
         }
     }
+
+    flushPackets(timeUs);
 }
 
 void ARTPWriter::sendH263Data(MediaBufferBase *mediaBuf) {
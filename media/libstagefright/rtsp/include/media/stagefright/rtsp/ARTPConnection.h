@@ -25,6 +25,7 @@
 namespace android {
 
 struct ABuffer;
+struct ALooper;
 struct ARTPSource;
 struct ASessionDescription;
 
@@ -32,6 +33,10 @@ struct ARTPConnection : public AHandler {
     enum Flags {
         kRegularlyRequestFIR = 2,
         kViLTEConnection = 4,
+        // Serve each stream from a connection on a looper of its own, so that the
+        // depacketization of one track does not delay the others. The settings are
+        // copied to a stream when it is added.
+        kStreamPerLooper = 8,
     };
 
     explicit ARTPConnection(uint32_t flags = 0);
@@ -105,6 +110,22 @@ private:
 
     int32_t mCumulativeBytes;
 
+    // Scratch space receive() reads batches of datagrams into.
+    sp<ABuffer> mReceiveBuffer;
+
+    // With kStreamPerLooper, the connections that serve the streams.
+    struct Shard {
+        int mRTPSocket;
+        int mRTCPSocket;
+        sp<ALooper> mLooper;
+        sp<ARTPConnection> mConnection;
+    };
+    List<Shard> mShards;
+
+    void addShard(const sp<AMessage> &msg);
+    List<Shard>::iterator findShard(int socket);
+    void removeShard(List<Shard>::iterator it);
+
     void onSeekStream(const sp<AMessage> &msg);
     void onRemoveStream(const sp<AMessage> &msg);
     void onPollStreams();
@@ -26,6 +26,9 @@
 
 #include <arpa/inet.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
+
+#include <vector>
 
 #include <android/multinetwork.h>
 #include "TrafficRecorder.h"
@@ -126,6 +129,23 @@ private:
     int32_t mRTPCVOExtMap;
     int32_t mRTPCVODegrees;
 
+    // RTP packets of the current video frame. The payloads point into the media buffer,
+    // the headers are stored in mPacketHeaders.
+    struct PendingPacket {
+        size_t headerOffset;
+        size_t headerSize;
+        const uint8_t *payload;
+        size_t payloadSize;
+    };
+    std::vector<PendingPacket> mPendingPackets;
+    std::vector<uint8_t> mPacketHeaders;
+    std::vector<struct iovec> mPacketIovecs;
+
+    bool mPacing;
+    bool mUseGSO;
+    int64_t mLastFrameTimeUs;
+    int64_t mFrameIntervalUs;
+
     enum {
         INVALID,
         H265,
@@ -158,6 +178,12 @@ private:
     void sendAMRData(MediaBufferBase *mediaBuf);
 
     void send(const sp<ABuffer> &buffer, bool isRTCP);
+    void send(const struct iovec *iov, size_t iovCount, bool isRTCP);
+    void queuePacket(const uint8_t *header, size_t headerSize,
+                     const uint8_t *payload, size_t payloadSize);
+    void flushPackets(int64_t timeUs);
+    size_t sendPackets(size_t first, size_t count);
+    bool sendSegmented(size_t first, size_t count, size_t segmentSize);
     void makeSocketPairAndBind(String8& localIp, int localPort, String8& remoteIp, int remotePort);
 
     void ModerateInstantTraffic(uint32_t samplePeriod, uint32_t limitBytes);
@@ -166,7 +166,7 @@ struct MyHandler : public AHandler {
         mRTPConn = AVMediaServiceFactory::get()->createARTPConnection();
 #else
         mConn = new ARTSPConnection(mUIDValid, mUID);
-        mRTPConn = new ARTPConnection();
+        mRTPConn = new ARTPConnection(ARTPConnection::kStreamPerLooper);
 #endif
         mNetLooper->setName("rtsp net");
         mNetLooper->start(false /* runOnCallingThread */,
@@ -121,6 +121,10 @@ void Accessor::createEvictor() {
     Accessor::Impl::createEvictor();
 }
 
+std::string Accessor::getStatsString() {
+    return Accessor::Impl::getStatsString();
+}
+
 // Methods from ::android::hardware::media::bufferpool::V2_0::IAccessor follow.
 Return<void> Accessor::connect(
         const sp<::android::hardware::media::bufferpool::V2_0::IObserver>& observer,
@@ -25,6 +25,7 @@
 #include "BufferStatus.h"
 
 #include <set>
+#include <string>
 
 namespace android {
 namespace hardware {
@@ -189,6 +190,12 @@ struct Accessor : public IAccessor {
 
     static void createEvictor();
 
+    /**
+     * Returns the buffer status message and eviction counts of all buffer
+     * pools of the process, with their rates since the previous call.
+     */
+    static std::string getStatsString();
+
 private:
     class Impl;
     std::shared_ptr<Impl> mImpl;
@@ -19,10 +19,13 @@
 
 #include <sys/types.h>
 #include <stdint.h>
+#include <stdio.h>
 #include <time.h>
 #include <unistd.h>
 #include <utils/Log.h>
+#include <algorithm>
 #include <thread>
+#include <vector>
 #include "AccessorImpl.h"
 #include "Connection.h"
 
@@ -44,6 +47,11 @@ namespace {
 
     static constexpr nsecs_t kEvictGranularityNs = 1000000000; // 1 sec
     static constexpr nsecs_t kEvictDurationNs = 5000000000; // 5 secs
+
+    // Memory pressure targets for the unused buffers of all buffer pools
+    // of the process. (bytes or pixels)
+    static constexpr size_t kMaxUnusedSizeForAllPools = 1024*1024*64;
+    static constexpr size_t kUnusedSizeTargetForAllPools = 1024*1024*32;
 }
 
 // Buffer structure in bufferpool process
@@ -149,6 +157,9 @@ static constexpr uint32_t kSeqIdVndkBit = 0;
 static constexpr uint32_t kSeqIdMax = 0x7fffffff;
 uint32_t Accessor::Impl::sSeqId = time(nullptr) & kSeqIdMax;
 
+std::atomic<uint64_t> Accessor::Impl::sTotalStatusMessages(0);
+std::atomic<uint64_t> Accessor::Impl::sTotalEvictions(0);
+
 Accessor::Impl::Impl(
         const std::shared_ptr<BufferPoolAllocator> &allocator)
         : mAllocator(allocator), mScheduleEvictTs(0) {}
@@ -261,11 +272,41 @@ ResultStatus Accessor::Impl::fetch(
     return ResultStatus::CRITICAL_ERROR;
 }
 
-void Accessor::Impl::cleanUp(bool clearCache) {
+void Accessor::Impl::cleanUp(bool clearCache, bool periodic) {
     // transaction timeout, buffer cacheing TTL handling
     std::lock_guard<std::mutex> lock(mBufferPool.mMutex);
     mBufferPool.processStatusMessages();
-    mBufferPool.cleanUp(clearCache);
+    mBufferPool.cleanUp(clearCache, periodic);
+}
+
+size_t Accessor::Impl::unusedSize() {
+    std::lock_guard<std::mutex> lock(mBufferPool.mMutex);
+    return mBufferPool.mStats.mSizeCached - mBufferPool.mStats.mSizeInUse;
+}
+
+std::string Accessor::Impl::getStatsString() {
+    static std::mutex sLock;
+    static nsecs_t sLastNs = systemTime();
+    static uint64_t sLastMessages = 0;
+    static uint64_t sLastEvictions = 0;
+
+    std::lock_guard<std::mutex> lock(sLock);
+    nsecs_t now = systemTime();
+    uint64_t messages = sTotalStatusMessages.load(std::memory_order_relaxed);
+    uint64_t evictions = sTotalEvictions.load(std::memory_order_relaxed);
+    double seconds = (now - sLastNs) / 1e9;
+    char buf[256];
+    snprintf(buf, sizeof(buf),
+             "%llu status messages, %llu evictions in total - "
+             "%.1f messages/s, %.1f evictions/s over the last %.1f secs",
+             (unsigned long long)messages, (unsigned long long)evictions,
+             seconds > 0 ? (messages - sLastMessages) / seconds : 0.,
+             seconds > 0 ? (evictions - sLastEvictions) / seconds : 0.,
+             seconds);
+    sLastNs = now;
+    sLastMessages = messages;
+    sLastEvictions = evictions;
+    return buf;
 }
 
 void Accessor::Impl::flush() {
@@ -573,6 +614,7 @@ void Accessor::Impl::BufferPool::processStatusMessages() {
     std::vector<BufferStatusMessage> messages;
     mObserver.getBufferStatusChanges(messages);
     mTimestampUs = getTimestampNow();
+    sTotalStatusMessages.fetch_add(messages.size(), std::memory_order_relaxed);
     for (BufferStatusMessage& message: messages) {
         bool ret = false;
         switch (message.newStatus) {
@@ -725,8 +767,8 @@ ResultStatus Accessor::Impl::BufferPool::addNewBuffer(
     return ResultStatus::NO_MEMORY;
 }
 
-void Accessor::Impl::BufferPool::cleanUp(bool clearCache) {
-    if (clearCache || mTimestampUs > mLastCleanUpUs + kCleanUpDurationUs ||
+void Accessor::Impl::BufferPool::cleanUp(bool clearCache, bool periodic) {
+    if (clearCache || (periodic && mTimestampUs > mLastCleanUpUs + kCleanUpDurationUs) ||
             mStats.buffersNotInUse() > kMaxUnusedBufferCount) {
         mLastCleanUpUs = mTimestampUs;
         if (mTimestampUs > mLastLogUs + kLogDurationUs ||
@@ -908,6 +950,7 @@ void Accessor::Impl::evictorThread(
         std::mutex &mutex,
         std::condition_variable &cv) {
     std::list<const std::weak_ptr<Accessor::Impl>> evictList;
+    std::list<const std::weak_ptr<Accessor::Impl>> activeList;
     while (true) {
         int expired = 0;
         int evicted = 0;
@@ -924,10 +967,40 @@ void Accessor::Impl::evictorThread(
                     evictList.push_back(it->first);
                     it = accessors.erase(it);
                 } else {
+                    activeList.push_back(it->first);
                     ++it;
                 }
             }
         }
+        // periodic cleaning of active accessors, and trimming of the largest
+        // unused caches under memory pressure.
+        {
+            std::vector<std::pair<size_t, std::shared_ptr<Accessor::Impl>>> unused;
+            size_t totalUnused = 0;
+            for (auto it = activeList.begin(); it != activeList.end(); ++it) {
+                const std::shared_ptr<Accessor::Impl> accessor = it->lock();
+                if (accessor) {
+                    accessor->cleanUp(false, true /* periodic */);
+                    size_t size = accessor->unusedSize();
+                    totalUnused += size;
+                    unused.emplace_back(size, accessor);
+                }
+            }
+            if (totalUnused > kMaxUnusedSizeForAllPools) {
+                std::sort(unused.begin(), unused.end(), [](const auto &a, const auto &b) {
+                    return a.first > b.first;
+                });
+                int trimmed = 0;
+                for (auto it = unused.begin();
+                        it != unused.end() && totalUnused > kUnusedSizeTargetForAllPools; ++it) {
+                    it->second->cleanUp(true);
+                    totalUnused -= it->first;
+                    ++trimmed;
+                }
+                ALOGD("evictor trimmed %d accessors under memory pressure", trimmed);
+            }
+        }
+        activeList.clear();
         // evict idle accessors;
         for (auto it = evictList.begin(); it != evictList.end(); ++it) {
             const std::shared_ptr<Accessor::Impl> accessor = it->lock();
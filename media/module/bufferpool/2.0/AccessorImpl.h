@@ -17,8 +17,10 @@
 #ifndef ANDROID_HARDWARE_MEDIA_BUFFERPOOL_V2_0_ACCESSORIMPL_H
 #define ANDROID_HARDWARE_MEDIA_BUFFERPOOL_V2_0_ACCESSORIMPL_H
 
+#include <atomic>
 #include <map>
 #include <set>
+#include <string>
 #include <condition_variable>
 #include <utils/Timers.h>
 #include "Accessor.h"
@@ -64,7 +66,10 @@ public:
 
     void flush();
 
-    void cleanUp(bool clearCache);
+    void cleanUp(bool clearCache, bool periodic = false);
+
+    /** Total size of the cached allocations which are not in use. */
+    size_t unusedSize();
 
     bool isValid();
 
@@ -74,11 +79,21 @@ public:
 
     static void createEvictor();
 
+    /**
+     * Returns the buffer status message and eviction counts of all buffer
+     * pools of the process, with their rates since the previous call.
+     */
+    static std::string getStatsString();
+
 private:
     // ConnectionId = pid : (timestamp_created + seqId)
     // in order to guarantee uniqueness for each connection
     static uint32_t sSeqId;
 
+    // process wide counters for getStatsString()
+    static std::atomic<uint64_t> sTotalStatusMessages;
+    static std::atomic<uint64_t> sTotalEvictions;
+
     const std::shared_ptr<BufferPoolAllocator> mAllocator;
 
     nsecs_t mScheduleEvictTs;
@@ -214,6 +229,7 @@ private:
             void onBufferEvicted(size_t allocSize) {
                 mSizeCached -= allocSize;
                 mBuffersCached--;
+                sTotalEvictions.fetch_add(1, std::memory_order_relaxed);
             }
 
             /// A buffer is recycled on an allocation request.
@@ -365,13 +381,17 @@ private:
                 const native_handle_t **handle);
 
         /**
-         * Processes pending buffer status messages and performs periodic cache
-         * cleaning.
+         * Performs cache cleaning. Without clearCache or periodic, buffers are
+         * only evicted when too many are unused.
          *
          * @param clearCache    if clearCache is true, it frees all buffers
          *                      waiting to be recycled.
+         * @param periodic      if periodic is true, it also evicts buffers
+         *                      when the periodic cleaning is due. This is done
+         *                      by the evictor thread, out of the allocation
+         *                      and transfer paths.
          */
-        void cleanUp(bool clearCache = false);
+        void cleanUp(bool clearCache = false, bool periodic = false);
 
         /**
          * Processes pending buffer status messages and invalidate all current
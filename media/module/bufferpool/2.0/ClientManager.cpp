@@ -561,6 +561,10 @@ void ClientManager::cleanUp() {
     }
 }
 
+std::string ClientManager::getStatsString() {
+    return Accessor::getStatsString();
+}
+
 }  // namespace implementation
 }  // namespace V2_0
 }  // namespace bufferpool
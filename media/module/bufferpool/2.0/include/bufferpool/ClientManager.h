@@ -21,6 +21,7 @@
 #include <hidl/MQDescriptor.h>
 #include <hidl/Status.h>
 #include <memory>
+#include <string>
 #include "BufferPoolTypes.h"
 
 namespace android {
@@ -173,6 +174,13 @@ struct ClientManager : public IClientManager {
      */
     void cleanUp();
 
+    /**
+     * Returns the buffer status message and eviction counts of the buffer
+     * pools of this process, with their rates since the previous call, for
+     * dumps.
+     */
+    static std::string getStatsString();
+
     /** Destructs the manager of buffer pool clients.  */
     ~ClientManager();
 private:
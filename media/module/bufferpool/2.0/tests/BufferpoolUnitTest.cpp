@@ -301,6 +301,38 @@ TEST_F(BufferpoolUnitTest, RecycleBuffer) {
     allocHandle.clear();
 }
 
+// Check whether buffer status messages are counted for dumps.
+TEST_F(BufferpoolUnitTest, StatsString) {
+    std::vector<uint8_t> vecParams;
+    getTestAllocatorParams(&vecParams);
+
+    unsigned long long before = 0, after = 0;
+    ASSERT_EQ(sscanf(ClientManager::getStatsString().c_str(), "%llu status messages", &before),
+              1);
+    std::vector<native_handle_t*> allocHandle{};
+    for (int i = 0; i < kNumIterationCount; ++i) {
+        native_handle_t* handle = nullptr;
+        std::shared_ptr<BufferPoolData> buffer;
+        ResultStatus status = mManager->allocate(mConnectionId, vecParams, &handle, &buffer);
+        ASSERT_EQ(status, ResultStatus::OK) << "allocate failed for " << i << "iteration";
+        if (handle) {
+            allocHandle.push_back(std::move(handle));
+        }
+        buffer.reset();
+    }
+    ASSERT_EQ(sscanf(ClientManager::getStatsString().c_str(), "%llu status messages", &after),
+              1);
+    // every release but the last one is processed by the next allocation
+    EXPECT_GE(after - before, (unsigned long long)(kNumIterationCount - 1));
+
+    // delete the buffer handles
+    for (auto handle : allocHandle) {
+        native_handle_close(handle);
+        native_handle_delete(handle);
+    }
+    allocHandle.clear();
+}
+
 // Validate cache evict and invalidate APIs.
 TEST_F(BufferpoolUnitTest, FlushTest) {
     std::vector<uint8_t> vecParams;
@@ -74,6 +74,10 @@ terms listed above has been obtained from the copyright holder.
 #include "typedef.h"
 #include "cnst.h"
 
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
 /*----------------------------------------------------------------------------
 ; MACROS
 ; Define module specific macros here
@@ -193,6 +197,38 @@ void Residu (
 ------------------------------------------------------------------------------
 */
 
+#if defined(__ARM_NEON)
+
+void Residu(
+    Word16 coef_ptr[],      /* (i)     : prediction coefficients*/
+    Word16 input_ptr[],     /* (i)     : speech signal          */
+    Word16 residual_ptr[],  /* (o)     : residual signal        */
+    Word16 input_len        /* (i)     : size of filtering      */
+)
+{
+    Word16 i, j;
+
+    /*
+     * Filter four samples at a time, each coefficient multiplying four
+     * consecutive input samples. The sums are the same 32-bit sums as in
+     * the C version, so the output is bit-exact.
+     */
+    for (i = 0; i < input_len; i += 4)
+    {
+        int32x4_t acc = vdupq_n_s32(0x0000800L);
+
+        for (j = 0; j <= M; j++)
+        {
+            acc = vmlal_n_s16(acc, vld1_s16(&input_ptr[i - j]), coef_ptr[j]);
+        }
+        vst1_s16(&residual_ptr[i], vshrn_n_s32(acc, 12));
+    }
+
+    return;
+}
+
+#else
+
 void Residu(
     Word16 coef_ptr[],      /* (i)     : prediction coefficients*/
     Word16 input_ptr[],     /* (i)     : speech signal          */
@@ -253,3 +289,5 @@ void Residu(
 
     return;
 }
+
+#endif
@@ -110,6 +110,10 @@ terms listed above has been obtained from the copyright holder.
 #include "oper_32b.h"
 #include "cnst.h"
 
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
 /*----------------------------------------------------------------------------
 ; MACROS
 ; Define module specific macros here
@@ -322,7 +326,9 @@ Word16 Autocorr(
     Word16 *p_x;
     Word16 *p_y;
     Word16 *p_y_1;
+#if !defined(__ARM_NEON)
     Word16 *p_y_ref;
+#endif
     Word16 *p_rh;
     Word16 *p_rl;
     const Word16 *p_wind;
@@ -421,7 +427,9 @@ Word16 Autocorr(
 
     /* r[1] to r[m] */
 
+#if !defined(__ARM_NEON)
     p_y_ref = &y[L_WINDOW - 1 ];
+#endif
     p_rh = &r_h[m];
     p_rl = &r_l[m];
 
@@ -429,6 +437,33 @@ Word16 Autocorr(
     {
         sum  = 0;
 
+#if defined(__ARM_NEON)
+        /* same 32-bit sum, eight products at a time */
+        {
+            int32x4_t acc = vdupq_n_s32(0);
+            int32x2_t acc2;
+
+            p_y   = y;
+            p_y_1 = &y[i];
+
+            for (j = (L_WINDOW - i) >> 3; j != 0; j--)
+            {
+                int16x8_t a = vld1q_s16(p_y);
+                int16x8_t b = vld1q_s16(p_y_1);
+                acc = vmlal_s16(acc, vget_low_s16(a), vget_low_s16(b));
+                acc = vmlal_s16(acc, vget_high_s16(a), vget_high_s16(b));
+                p_y += 8;
+                p_y_1 += 8;
+            }
+            acc2 = vadd_s32(vget_low_s32(acc), vget_high_s32(acc));
+            sum = vget_lane_s32(vpadd_s32(acc2, acc2), 0);
+
+            for (j = (L_WINDOW - i) & 7; j != 0; j--)
+            {
+                sum = amrnb_fxp_mac_16_by_16bb((Word32) * (p_y++), (Word32) * (p_y_1++), sum);
+            }
+        }
+#else
         p_y   = &y[L_WINDOW - i - 1];
         p_y_1 = p_y_ref;
 
@@ -444,6 +479,7 @@ Word16 Autocorr(
         {
             sum = amrnb_fxp_mac_16_by_16bb((Word32) * (p_y--), (Word32) * (p_y_1--), sum);
         }
+#endif
 
         sum  <<= (norm + 1);
 
@@ -84,6 +84,10 @@ terms listed above has been obtained from the copyright holder.
 #include "convolve.h"
 #include "basic_op.h"
 
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
 /*----------------------------------------------------------------------------
 ; MACROS
 ; Define module specific macros here
@@ -215,6 +219,41 @@ void Convolve(
     Word16 i, n;
     Word32 s1, s2;
 
+#if defined(__ARM_NEON)
+    /*
+     * Compute four outputs at a time: for i <= n, x[i] multiplies the four
+     * consecutive taps h[n - i] .. h[n - i + 3]. The remaining terms, with
+     * n < i <= n + 3, form a triangle added separately. The sums are the
+     * same 32-bit sums as below, so the output is bit-exact.
+     */
+    if ((L & 3) == 0)
+    {
+        Word32 s[4];
+
+        for (n = 0; n < L; n += 4)
+        {
+            int32x4_t acc = vdupq_n_s32(0);
+
+            for (i = 0; i <= n; i++)
+            {
+                acc = vmlal_n_s16(acc, vld1_s16(&h[n - i]), x[i]);
+            }
+            vst1q_s32(s, acc);
+
+            s[1] += (Word32) x[n + 1] * h[0];
+            s[2] += (Word32) x[n + 1] * h[1] + (Word32) x[n + 2] * h[0];
+            s[3] += (Word32) x[n + 1] * h[2] + (Word32) x[n + 2] * h[1] +
+                    (Word32) x[n + 3] * h[0];
+
+            y[n] = (Word16)(s[0] >> 12);
+            y[n + 1] = (Word16)(s[1] >> 12);
+            y[n + 2] = (Word16)(s[2] >> 12);
+            y[n + 3] = (Word16)(s[3] >> 12);
+        }
+
+        return;
+    }
+#endif
 
     for (n = 1; n < L; n = n + 2)
     {
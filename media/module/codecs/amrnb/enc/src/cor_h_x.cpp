@@ -75,6 +75,10 @@ terms listed above has been obtained from the copyright holder.
 #include "cor_h_x.h"
 #include "basic_op.h"
 
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
 /*----------------------------------------------------------------------------
 ; MACROS
 ; Define module specific macros here
@@ -273,6 +277,31 @@ void cor_h_x(
             p_x = &x[i];
             p_ptr = h;
 
+#if defined(__ARM_NEON)
+            /* same 32-bit sum, eight products at a time */
+            {
+                int32x4_t acc = vdupq_n_s32(0);
+                int32x2_t acc2;
+
+                for (j = (L_CODE - i) >> 3; j != 0; j--)
+                {
+                    int16x8_t a = vld1q_s16(p_x);
+                    int16x8_t b = vld1q_s16(p_ptr);
+                    acc = vmlal_s16(acc, vget_low_s16(a), vget_low_s16(b));
+                    acc = vmlal_s16(acc, vget_high_s16(a), vget_high_s16(b));
+                    p_x += 8;
+                    p_ptr += 8;
+                }
+                acc2 = vadd_s32(vget_low_s32(acc), vget_high_s32(acc));
+                s = vget_lane_s32(vpadd_s32(acc2, acc2), 0);
+
+                for (j = (L_CODE - i) & 7; j != 0; j--)
+                {
+                    s += (Word32) * (p_x++) * *(p_ptr++);
+                }
+                s <<= 1;
+            }
+#else
             for (j = (L_CODE - i - 1) >> 1; j != 0; j--)
             {
                 s += ((Word32) * (p_x++) * *(p_ptr++)) << 1;
@@ -285,6 +314,7 @@ void cor_h_x(
             {
                 s += ((Word32) * (p_x++) * *(p_ptr++)) << 1;
             }
+#endif
 
             y32[i] = s;
 
@@ -19,8 +19,8 @@
 #include <utils/Log.h>
 
 #include "FLACDecoder.h"
+#include "FLACSampleCopy.h"
 
-#include <audio_utils/primitives.h> // float_from_i32
 #include <media/stagefright/foundation/ADebug.h>
 #include <media/stagefright/foundation/hexdump.h>
 #include <media/stagefright/MediaDefs.h>
@@ -118,47 +118,6 @@ void FLACDecoder::errorCallback(FLAC__StreamDecoderErrorStatus status)
     mErrorStatus = status;
 }
 
-// Copy samples from FLAC native 32-bit non-interleaved to 16-bit signed
-// or 32-bit float interleaved.
-// TODO: Consider moving to audio_utils.  See similar code at FLACExtractor.cpp
-// These are candidates for optimization if needed.
-static void copyTo16Signed(
-        short *dst,
-        const int *const *src,
-        unsigned nSamples,
-        unsigned nChannels,
-        unsigned bitsPerSample) {
-    const int leftShift = 16 - (int)bitsPerSample; // cast to int to prevent unsigned overflow.
-    if (leftShift >= 0) {
-        for (unsigned i = 0; i < nSamples; ++i) {
-            for (unsigned c = 0; c < nChannels; ++c) {
-                *dst++ = src[c][i] << leftShift;
-            }
-        }
-    } else {
-        const int rightShift = -leftShift;
-        for (unsigned i = 0; i < nSamples; ++i) {
-            for (unsigned c = 0; c < nChannels; ++c) {
-                *dst++ = src[c][i] >> rightShift;
-            }
-        }
-    }
-}
-
-static void copyToFloat(
-        float *dst,
-        const int *const *src,
-        unsigned nSamples,
-        unsigned nChannels,
-        unsigned bitsPerSample) {
-    const unsigned leftShift = 32 - bitsPerSample;
-    for (unsigned i = 0; i < nSamples; ++i) {
-        for (unsigned c = 0; c < nChannels; ++c) {
-            *dst++ = float_from_i32(src[c][i] << leftShift);
-        }
-    }
-}
-
 // static
 FLACDecoder *FLACDecoder::Create() {
     FLACDecoder *decoder = new (std::nothrow) FLACDecoder();
@@ -399,17 +358,17 @@ status_t FLACDecoder::decodeOneFrame(const uint8_t *inBuffer, size_t inBufferLen
 
     const unsigned bitsPerSample = getBitsPerSample();
     if (outputFloat) {
-        copyToFloat(reinterpret_cast<float*>(outBuffer),
-                    mWriteBuffer,
-                    blocksize,
-                    channels,
-                    bitsPerSample);
+        flacCopyToFloat(reinterpret_cast<float*>(outBuffer),
+                        mWriteBuffer,
+                        blocksize,
+                        channels,
+                        bitsPerSample);
     } else {
-        copyTo16Signed(reinterpret_cast<short*>(outBuffer),
-                       mWriteBuffer,
-                       blocksize,
-                       channels,
-                       bitsPerSample);
+        flacCopyTo16Signed(reinterpret_cast<short*>(outBuffer),
+                           mWriteBuffer,
+                           blocksize,
+                           channels,
+                           bitsPerSample);
     }
     *outBufferLen = bufferSize;
     return OK;
@@ -0,0 +1,346 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "FLACSampleCopy.h"
+
+#include <audio_utils/primitives.h> // float_from_i32
+
+#include "FLAC/format.h" // FLAC__MAX_CHANNELS
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace android {
+
+namespace {
+
+// TODO: Consider moving to audio_utils.  See similar code at FLACExtractor.cpp
+void copyTo16SignedScalar(
+        short *dst,
+        const int *const *src,
+        unsigned nSamples,
+        unsigned nChannels,
+        int leftShift) {
+    if (leftShift >= 0) {
+        for (unsigned i = 0; i < nSamples; ++i) {
+            for (unsigned c = 0; c < nChannels; ++c) {
+                *dst++ = src[c][i] << leftShift;
+            }
+        }
+    } else {
+        const int rightShift = -leftShift;
+        for (unsigned i = 0; i < nSamples; ++i) {
+            for (unsigned c = 0; c < nChannels; ++c) {
+                *dst++ = src[c][i] >> rightShift;
+            }
+        }
+    }
+}
+
+void copyToFloatScalar(
+        float *dst,
+        const int *const *src,
+        unsigned nSamples,
+        unsigned nChannels,
+        unsigned leftShift) {
+    for (unsigned i = 0; i < nSamples; ++i) {
+        for (unsigned c = 0; c < nChannels; ++c) {
+            *dst++ = float_from_i32(src[c][i] << leftShift);
+        }
+    }
+}
+
+// The kernels below convert several frames at a time and return the number of frames
+// converted. Samples are shifted and truncated to 16 bits like the loops above, and
+// converted to float with the same rounding, so the output is the same.
+//
+// The multichannel kernels handle 4 to 8 channels four channels at a time, transposing
+// 4 frames of 4 channels. With 5 to 7 channels the last group overlaps the previous one.
+#if defined(__ARM_NEON)
+
+inline void transpose4(int32x4_t *v) {
+    int32x4x2_t ab = vtrnq_s32(v[0], v[1]);
+    int32x4x2_t cd = vtrnq_s32(v[2], v[3]);
+    v[0] = vcombine_s32(vget_low_s32(ab.val[0]), vget_low_s32(cd.val[0]));
+    v[1] = vcombine_s32(vget_low_s32(ab.val[1]), vget_low_s32(cd.val[1]));
+    v[2] = vcombine_s32(vget_high_s32(ab.val[0]), vget_high_s32(cd.val[0]));
+    v[3] = vcombine_s32(vget_high_s32(ab.val[1]), vget_high_s32(cd.val[1]));
+}
+
+unsigned copyStereoTo16Signed(
+        short *dst, const int *left, const int *right, unsigned nSamples, int leftShift) {
+    // vshlq_s32() shifts right for a negative count
+    const int32x4_t shift = vdupq_n_s32(leftShift);
+    unsigned i = 0;
+    for (; i + 8 <= nSamples; i += 8) {
+        int16x8x2_t frames;
+        frames.val[0] = vcombine_s16(vmovn_s32(vshlq_s32(vld1q_s32(left + i), shift)),
+                                     vmovn_s32(vshlq_s32(vld1q_s32(left + i + 4), shift)));
+        frames.val[1] = vcombine_s16(vmovn_s32(vshlq_s32(vld1q_s32(right + i), shift)),
+                                     vmovn_s32(vshlq_s32(vld1q_s32(right + i + 4), shift)));
+        vst2q_s16(dst + 2 * i, frames);
+    }
+    return i;
+}
+
+unsigned copyStereoToFloat(
+        float *dst, const int *left, const int *right, unsigned nSamples, unsigned leftShift) {
+    const int32x4_t shift = vdupq_n_s32(leftShift);
+    const float scale = float_from_i32(1);
+    unsigned i = 0;
+    for (; i + 4 <= nSamples; i += 4) {
+        float32x4x2_t frames;
+        frames.val[0] = vmulq_n_f32(vcvtq_f32_s32(vshlq_s32(vld1q_s32(left + i), shift)), scale);
+        frames.val[1] = vmulq_n_f32(vcvtq_f32_s32(vshlq_s32(vld1q_s32(right + i), shift)), scale);
+        vst2q_f32(dst + 2 * i, frames);
+    }
+    return i;
+}
+
+unsigned copyMultiTo16Signed(
+        short *dst, const int *const *src, unsigned nSamples, unsigned nChannels,
+        int leftShift) {
+    const int32x4_t shift = vdupq_n_s32(leftShift);
+    const unsigned frames = nSamples & ~3u;
+    for (unsigned c = 0; c < nChannels; c += 4) {
+        const unsigned first = c + 4 <= nChannels ? c : nChannels - 4;
+        const int *const s[4] = { src[first], src[first + 1], src[first + 2], src[first + 3] };
+        short *d = dst + first;
+        for (unsigned i = 0; i < frames; i += 4) {
+            int32x4_t v[4];
+            for (unsigned k = 0; k < 4; ++k) {
+                v[k] = vshlq_s32(vld1q_s32(s[k] + i), shift);
+            }
+            transpose4(v);
+            for (unsigned k = 0; k < 4; ++k) {
+                vst1_s16(d, vmovn_s32(v[k]));
+                d += nChannels;
+            }
+        }
+    }
+    return frames;
+}
+
+unsigned copyMultiToFloat(
+        float *dst, const int *const *src, unsigned nSamples, unsigned nChannels,
+        unsigned leftShift) {
+    const int32x4_t shift = vdupq_n_s32(leftShift);
+    const float scale = float_from_i32(1);
+    const unsigned frames = nSamples & ~3u;
+    for (unsigned c = 0; c < nChannels; c += 4) {
+        const unsigned first = c + 4 <= nChannels ? c : nChannels - 4;
+        const int *const s[4] = { src[first], src[first + 1], src[first + 2], src[first + 3] };
+        float *d = dst + first;
+        for (unsigned i = 0; i < frames; i += 4) {
+            int32x4_t v[4];
+            for (unsigned k = 0; k < 4; ++k) {
+                v[k] = vshlq_s32(vld1q_s32(s[k] + i), shift);
+            }
+            transpose4(v);
+            for (unsigned k = 0; k < 4; ++k) {
+                vst1q_f32(d, vmulq_n_f32(vcvtq_f32_s32(v[k]), scale));
+                d += nChannels;
+            }
+        }
+    }
+    return frames;
+}
+
+#elif defined(__SSE2__)
+
+inline void transpose4(__m128i *v) {
+    __m128i t0 = _mm_unpacklo_epi32(v[0], v[1]);
+    __m128i t1 = _mm_unpacklo_epi32(v[2], v[3]);
+    __m128i t2 = _mm_unpackhi_epi32(v[0], v[1]);
+    __m128i t3 = _mm_unpackhi_epi32(v[2], v[3]);
+    v[0] = _mm_unpacklo_epi64(t0, t1);
+    v[1] = _mm_unpackhi_epi64(t0, t1);
+    v[2] = _mm_unpacklo_epi64(t2, t3);
+    v[3] = _mm_unpackhi_epi64(t2, t3);
+}
+
+// Shifts, then truncates to 16 bits so that _mm_packs_epi32() does not saturate.
+inline __m128i shiftTo16(__m128i v, __m128i leftCount, __m128i rightCount) {
+    v = _mm_sra_epi32(_mm_sll_epi32(v, leftCount), rightCount);
+    return _mm_srai_epi32(_mm_slli_epi32(v, 16), 16);
+}
+
+inline __m128 toFloat(__m128i v, __m128i count, __m128 scale) {
+    return _mm_mul_ps(_mm_cvtepi32_ps(_mm_sll_epi32(v, count)), scale);
+}
+
+inline __m128i load(const int *p) {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+}
+
+unsigned copyStereoTo16Signed(
+        short *dst, const int *left, const int *right, unsigned nSamples, int leftShift) {
+    const __m128i leftCount = _mm_cvtsi32_si128(leftShift >= 0 ? leftShift : 0);
+    const __m128i rightCount = _mm_cvtsi32_si128(leftShift >= 0 ? 0 : -leftShift);
+    unsigned i = 0;
+    for (; i + 8 <= nSamples; i += 8) {
+        __m128i l16 = _mm_packs_epi32(shiftTo16(load(left + i), leftCount, rightCount),
+                                      shiftTo16(load(left + i + 4), leftCount, rightCount));
+        __m128i r16 = _mm_packs_epi32(shiftTo16(load(right + i), leftCount, rightCount),
+                                      shiftTo16(load(right + i + 4), leftCount, rightCount));
+        __m128i *d = reinterpret_cast<__m128i *>(dst + 2 * i);
+        _mm_storeu_si128(d, _mm_unpacklo_epi16(l16, r16));
+        _mm_storeu_si128(d + 1, _mm_unpackhi_epi16(l16, r16));
+    }
+    return i;
+}
+
+unsigned copyStereoToFloat(
+        float *dst, const int *left, const int *right, unsigned nSamples, unsigned leftShift) {
+    const __m128i count = _mm_cvtsi32_si128(leftShift);
+    const __m128 scale = _mm_set1_ps(float_from_i32(1));
+    unsigned i = 0;
+    for (; i + 4 <= nSamples; i += 4) {
+        __m128 l = toFloat(load(left + i), count, scale);
+        __m128 r = toFloat(load(right + i), count, scale);
+        _mm_storeu_ps(dst + 2 * i, _mm_unpacklo_ps(l, r));
+        _mm_storeu_ps(dst + 2 * i + 4, _mm_unpackhi_ps(l, r));
+    }
+    return i;
+}
+
+unsigned copyMultiTo16Signed(
+        short *dst, const int *const *src, unsigned nSamples, unsigned nChannels,
+        int leftShift) {
+    const __m128i leftCount = _mm_cvtsi32_si128(leftShift >= 0 ? leftShift : 0);
+    const __m128i rightCount = _mm_cvtsi32_si128(leftShift >= 0 ? 0 : -leftShift);
+    const unsigned frames = nSamples & ~3u;
+    for (unsigned c = 0; c < nChannels; c += 4) {
+        const unsigned first = c + 4 <= nChannels ? c : nChannels - 4;
+        const int *const s[4] = { src[first], src[first + 1], src[first + 2], src[first + 3] };
+        short *d = dst + first;
+        for (unsigned i = 0; i < frames; i += 4) {
+            __m128i v[4];
+            for (unsigned k = 0; k < 4; ++k) {
+                v[k] = shiftTo16(load(s[k] + i), leftCount, rightCount);
+            }
+            transpose4(v);
+            for (unsigned k = 0; k < 4; k += 2) {
+                __m128i pair = _mm_packs_epi32(v[k], v[k + 1]);
+                _mm_storel_epi64(reinterpret_cast<__m128i *>(d), pair);
+                _mm_storel_epi64(reinterpret_cast<__m128i *>(d + nChannels),
+                                 _mm_srli_si128(pair, 8));
+                d += 2 * nChannels;
+            }
+        }
+    }
+    return frames;
+}
+
+unsigned copyMultiToFloat(
+        float *dst, const int *const *src, unsigned nSamples, unsigned nChannels,
+        unsigned leftShift) {
+    const __m128i count = _mm_cvtsi32_si128(leftShift);
+    const __m128 scale = _mm_set1_ps(float_from_i32(1));
+    const unsigned frames = nSamples & ~3u;
+    for (unsigned c = 0; c < nChannels; c += 4) {
+        const unsigned first = c + 4 <= nChannels ? c : nChannels - 4;
+        const int *const s[4] = { src[first], src[first + 1], src[first + 2], src[first + 3] };
+        float *d = dst + first;
+        for (unsigned i = 0; i < frames; i += 4) {
+            __m128i v[4];
+            for (unsigned k = 0; k < 4; ++k) {
+                v[k] = load(s[k] + i);
+            }
+            transpose4(v);
+            for (unsigned k = 0; k < 4; ++k) {
+                _mm_storeu_ps(d, toFloat(v[k], count, scale));
+                d += nChannels;
+            }
+        }
+    }
+    return frames;
+}
+
+#else
+
+unsigned copyStereoTo16Signed(short *, const int *, const int *, unsigned, int) {
+    return 0;
+}
+
+unsigned copyStereoToFloat(float *, const int *, const int *, unsigned, unsigned) {
+    return 0;
+}
+
+unsigned copyMultiTo16Signed(short *, const int *const *, unsigned, unsigned, int) {
+    return 0;
+}
+
+unsigned copyMultiToFloat(float *, const int *const *, unsigned, unsigned, unsigned) {
+    return 0;
+}
+
+#endif
+
+}  // namespace
+
+void flacCopyTo16Signed(
+        short *dst,
+        const int *const *src,
+        unsigned nSamples,
+        unsigned nChannels,
+        unsigned bitsPerSample) {
+    const int leftShift = 16 - (int)bitsPerSample; // cast to int to prevent unsigned overflow.
+    unsigned done = 0;
+    if (nChannels == 2) {
+        done = copyStereoTo16Signed(dst, src[0], src[1], nSamples, leftShift);
+    } else if (nChannels >= 4 && nChannels <= FLAC__MAX_CHANNELS) {
+        done = copyMultiTo16Signed(dst, src, nSamples, nChannels, leftShift);
+    }
+    if (done == 0) {
+        copyTo16SignedScalar(dst, src, nSamples, nChannels, leftShift);
+        return;
+    }
+    const int *tail[FLAC__MAX_CHANNELS];
+    for (unsigned c = 0; c < nChannels; ++c) {
+        tail[c] = src[c] + done;
+    }
+    copyTo16SignedScalar(dst + done * nChannels, tail, nSamples - done, nChannels, leftShift);
+}
+
+void flacCopyToFloat(
+        float *dst,
+        const int *const *src,
+        unsigned nSamples,
+        unsigned nChannels,
+        unsigned bitsPerSample) {
+    const unsigned leftShift = 32 - bitsPerSample;
+    unsigned done = 0;
+    if (nChannels == 2) {
+        done = copyStereoToFloat(dst, src[0], src[1], nSamples, leftShift);
+    } else if (nChannels >= 4 && nChannels <= FLAC__MAX_CHANNELS) {
+        done = copyMultiToFloat(dst, src, nSamples, nChannels, leftShift);
+    }
+    if (done == 0) {
+        copyToFloatScalar(dst, src, nSamples, nChannels, leftShift);
+        return;
+    }
+    const int *tail[FLAC__MAX_CHANNELS];
+    for (unsigned c = 0; c < nChannels; ++c) {
+        tail[c] = src[c] + done;
+    }
+    copyToFloatScalar(dst + done * nChannels, tail, nSamples - done, nChannels, leftShift);
+}
+
+}  // namespace android
@@ -0,0 +1,41 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FLAC_SAMPLE_COPY_H_
+#define FLAC_SAMPLE_COPY_H_
+
+namespace android {
+
+// Copy samples from FLAC native 32-bit non-interleaved to 16-bit signed
+// or 32-bit float interleaved. 'src' holds one plane of nSamples per channel.
+// Stereo and 4 to 8 channels use NEON or SSE2.
+void flacCopyTo16Signed(
+        short *dst,
+        const int *const *src,
+        unsigned nSamples,
+        unsigned nChannels,
+        unsigned bitsPerSample);
+
+void flacCopyToFloat(
+        float *dst,
+        const int *const *src,
+        unsigned nSamples,
+        unsigned nChannels,
+        unsigned bitsPerSample);
+
+}  // namespace android
+
+#endif  // FLAC_SAMPLE_COPY_H_
@@ -0,0 +1,90 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <random>
+#include <vector>
+
+#include "FLACSampleCopy.h"
+
+using namespace android;
+
+// The largest block size of the FLAC subset, used by most encoders at 192 kHz.
+static constexpr unsigned kBlockSize = 4608;
+
+static std::vector<std::vector<int>> makePlanes(unsigned channels, unsigned bitsPerSample) {
+    std::minstd_rand rng(42);
+    std::uniform_int_distribution<int> dist(-(1 << (bitsPerSample - 1)),
+                                            (1 << (bitsPerSample - 1)) - 1);
+    std::vector<std::vector<int>> planes(channels, std::vector<int>(kBlockSize));
+    for (auto &plane : planes) {
+        for (int &sample : plane) {
+            sample = dist(rng);
+        }
+    }
+    return planes;
+}
+
+// Args: channel count, bits per sample.
+static void BM_CopyTo16Signed(benchmark::State &state) {
+    const unsigned channels = state.range(0);
+    const unsigned bitsPerSample = state.range(1);
+    const auto planes = makePlanes(channels, bitsPerSample);
+    std::vector<const int *> src;
+    for (const auto &plane : planes) {
+        src.push_back(plane.data());
+    }
+    std::vector<short> dst(kBlockSize * channels);
+
+    for (auto _ : state) {
+        flacCopyTo16Signed(dst.data(), src.data(), kBlockSize, channels, bitsPerSample);
+        benchmark::DoNotOptimize(dst.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * kBlockSize);
+}
+
+static void BM_CopyToFloat(benchmark::State &state) {
+    const unsigned channels = state.range(0);
+    const unsigned bitsPerSample = state.range(1);
+    const auto planes = makePlanes(channels, bitsPerSample);
+    std::vector<const int *> src;
+    for (const auto &plane : planes) {
+        src.push_back(plane.data());
+    }
+    std::vector<float> dst(kBlockSize * channels);
+
+    for (auto _ : state) {
+        flacCopyToFloat(dst.data(), src.data(), kBlockSize, channels, bitsPerSample);
+        benchmark::DoNotOptimize(dst.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * kBlockSize);
+}
+
+static void CopyArgs(benchmark::internal::Benchmark *b) {
+    for (int channels : {1, 2, 6, 8}) {
+        for (int bitsPerSample : {16, 24}) {
+            b->Args({channels, bitsPerSample});
+        }
+    }
+}
+
+BENCHMARK(BM_CopyTo16Signed)->Apply(CopyArgs);
+BENCHMARK(BM_CopyToFloat)->Apply(CopyArgs);
+
+BENCHMARK_MAIN();
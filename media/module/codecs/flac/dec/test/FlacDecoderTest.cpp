@@ -21,6 +21,7 @@
 #include <fstream>
 
 #include "FLACDecoder.h"
+#include "FLACSampleCopy.h"
 
 #include "FlacDecoderTestEnvironment.h"
 
@@ -245,6 +246,46 @@ TEST_P(FLACDecoderTest, DecodeTest) {
     ASSERT_EQ(status, 0) << "Test Failed. Decode returned error = " << status << endl;
 }
 
+// Compares the interleaving kernels with a per-sample loop for every channel count,
+// sample size and a block size that leaves a tail after the vectorized frames.
+TEST(FLACSampleCopyTest, MatchesPerSampleCopy) {
+    constexpr unsigned kSamples = 4099;
+    srand(1);
+    for (unsigned channels = 1; channels <= FLACDecoder::kMaxChannels; ++channels) {
+        for (unsigned bitsPerSample : {8u, 12u, 16u, 20u, 24u, 32u}) {
+            vector<vector<int>> planes(channels, vector<int>(kSamples));
+            const int *src[FLACDecoder::kMaxChannels];
+            for (unsigned c = 0; c < channels; ++c) {
+                for (int &sample : planes[c]) {
+                    sample = (int)(((uint32_t)rand() << 16) ^ (uint32_t)rand()) >>
+                             (32 - bitsPerSample);
+                }
+                src[c] = planes[c].data();
+            }
+
+            vector<short> out16(kSamples * channels);
+            vector<float> outFloat(kSamples * channels);
+            flacCopyTo16Signed(out16.data(), src, kSamples, channels, bitsPerSample);
+            flacCopyToFloat(outFloat.data(), src, kSamples, channels, bitsPerSample);
+
+            const int leftShift = 16 - (int)bitsPerSample;
+            for (unsigned i = 0; i < kSamples; ++i) {
+                for (unsigned c = 0; c < channels; ++c) {
+                    const int sample = src[c][i];
+                    const short expected16 = leftShift >= 0 ? sample << leftShift
+                                                            : sample >> -leftShift;
+                    const float expectedFloat = (float)(sample << (32 - bitsPerSample)) /
+                                                (float)(1u << 31);
+                    ASSERT_EQ(out16[i * channels + c], expected16)
+                            << channels << " channels, " << bitsPerSample << " bits, frame " << i;
+                    ASSERT_EQ(outFloat[i * channels + c], expectedFloat)
+                            << channels << " channels, " << bitsPerSample << " bits, frame " << i;
+                }
+            }
+        }
+    }
+}
+
 // TODO: Add remaining tests
 INSTANTIATE_TEST_SUITE_P(
         FLACDecoderTestAll, FLACDecoderTest,
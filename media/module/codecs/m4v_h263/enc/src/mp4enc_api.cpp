@@ -20,6 +20,7 @@
 #include "bitstream_io.h"
 #include "rate_control.h"
 #include "m4venc_oscl.h"
+#include "sad_simd_inline.h"
 
 #ifndef INT32_MAX
 #define INT32_MAX 0x7fffffff
@@ -1078,15 +1079,25 @@ OSCL_EXPORT_REF Bool    PVInitVideoEncoder(VideoEncControls *encoderControl, Vid
 
     video->functionPointer->ComputeMBSum = &ComputeMBSum_C;
     video->functionPointer->SAD_MB_HalfPel[0] = NULL;
+#ifdef SAD_SIMD
+    video->functionPointer->SAD_MB_HalfPel[1] = &SAD_MB_HalfPel_SIMDxh;
+    video->functionPointer->SAD_MB_HalfPel[2] = &SAD_MB_HalfPel_SIMDyh;
+    video->functionPointer->SAD_MB_HalfPel[3] = &SAD_MB_HalfPel_SIMDxhyh;
+#else
     video->functionPointer->SAD_MB_HalfPel[1] = &SAD_MB_HalfPel_Cxh;
     video->functionPointer->SAD_MB_HalfPel[2] = &SAD_MB_HalfPel_Cyh;
     video->functionPointer->SAD_MB_HalfPel[3] = &SAD_MB_HalfPel_Cxhyh;
+#endif
 
 #ifndef NO_INTER4V
     video->functionPointer->SAD_Blk_HalfPel = &SAD_Blk_HalfPel_C;
     video->functionPointer->SAD_Block = &SAD_Block_C;
 #endif
+#ifdef SAD_SIMD
+    video->functionPointer->SAD_Macroblock = &SAD_Macroblock_SIMD;
+#else
     video->functionPointer->SAD_Macroblock = &SAD_Macroblock_C;
+#endif
     video->functionPointer->ChooseMode = &ChooseMode_C;
     video->functionPointer->GetHalfPelMBRegion = &GetHalfPelMBRegion_C;
 //  video->functionPointer->SAD_MB_PADDING = &SAD_MB_PADDING; /* 4/21/01 */
@@ -19,6 +19,7 @@
 #include "mp4lib_int.h"
 
 #include "sad_inline.h"
+#include "sad_simd_inline.h"
 
 #define Cached_lx 176
 
@@ -90,6 +91,32 @@ extern "C"
         return x10;
     }
 
+#ifdef SAD_SIMD
+    /********** NEON / SSE2 ************/
+    Int SAD_Macroblock_SIMD(UChar *ref, UChar *blk, Int dmin_lx, void *extra_info)
+    {
+        Int i;
+        Int sad = 0;
+        Int dmin = (ULong)dmin_lx >> 16;
+        Int lx = dmin_lx & 0xFFFF;
+
+        OSCL_UNUSED_ARG(extra_info);
+
+        NUM_SAD_MB_CALL();
+
+        for (i = 0; i < 16; i++)
+        {
+            sad += sad_row(ref, blk);
+            if (sad > dmin)
+                return sad;
+            ref += lx;
+            blk += 16;
+        }
+
+        return sad;
+    }
+#endif
+
 #ifdef HTFM   /* HTFM with uniform subsampling implementation, 2/28/01 */
     /*===============================================================
         Function:   SAD_MB_HTFM_Collect and SAD_MB_HTFM
@@ -109,8 +136,11 @@ extern "C"
         Int sad = 0;
         UChar *p1;
         Int lx4 = (dmin_lx << 2) & 0x3FFFC;
+        Int saddata[16];    /* used when collecting flag (global) is on */
+#ifndef SAD_SIMD
         ULong cur_word;
-        Int saddata[16], tmp, tmp2;    /* used when collecting flag (global) is on */
+        Int tmp, tmp2;
+#endif
         Int difmad;
         HTFM_Stat *htfm_stat = (HTFM_Stat*) extra_info;
         Int *abs_dif_mad_avg = &(htfm_stat->abs_dif_mad_avg);
@@ -123,6 +153,10 @@ extern "C"
         for (i = 0; i < 16; i++)
         {
             p1 = ref + offsetRef[i];
+#ifdef SAD_SIMD
+            sad += sad_stage(p1, lx4, blk + 4);
+            blk += 16;
+#else
             cur_word = *((ULong*)(blk += 4));
             tmp = p1[12];
             tmp2 = (cur_word >> 24) & 0xFF;
@@ -182,6 +216,7 @@ extern "C"
             p1 += lx4;
             tmp2 = (cur_word & 0xFF);
             sad = SUB_SAD(sad, tmp, tmp2);
+#endif
 
             NUM_SAD_MB();
 
@@ -211,12 +246,14 @@ extern "C"
         UChar *p1;
 
         Int i;
+#ifndef SAD_SIMD
         Int tmp, tmp2;
+        ULong cur_word;
+#endif
         Int lx4 = (dmin_lx << 2) & 0x3FFFC;
         Int sadstar = 0, madstar;
         Int *nrmlz_th = (Int*) extra_info;
         Int *offsetRef = (Int*) extra_info + 32;
-        ULong cur_word;
 
         madstar = (ULong)dmin_lx >> 20;
 
@@ -226,6 +263,10 @@ extern "C"
         for (i = 0; i < 16; i++)
         {
             p1 = ref + offsetRef[i];
+#ifdef SAD_SIMD
+            sad += sad_stage(p1, lx4, blk + 4);
+            blk += 16;
+#else
             cur_word = *((ULong*)(blk += 4));
             tmp = p1[12];
             tmp2 = (cur_word >> 24) & 0xFF;
@@ -285,6 +326,7 @@ extern "C"
             p1 += lx4;
             tmp2 = (cur_word & 0xFF);
             sad = SUB_SAD(sad, tmp, tmp2);
+#endif
 
             NUM_SAD_MB();
 
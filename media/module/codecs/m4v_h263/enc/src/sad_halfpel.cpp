@@ -31,6 +31,7 @@ Int SAD_Blk_HalfPel_C(UChar *ref,UChar *blk,Int dmin,Int width,Int rx,Int xh,Int
 #include "mp4def.h"
 #include "mp4lib_int.h"
 #include "sad_halfpel_inline.h"
+#include "sad_simd_inline.h"
 
 #ifdef _SAD_STAT
 ULong num_sad_HP_MB = 0;
@@ -329,23 +330,101 @@ extern "C"
         return sad;
     }
 
+#ifdef SAD_SIMD
+    /********** NEON / SSE2 ************/
+    Int SAD_MB_HalfPel_SIMDxhyh(UChar *ref, UChar *blk, Int dmin_rx, void *extra_info)
+    {
+        Int i;
+        Int sad = 0;
+        Int rx = dmin_rx & 0xFFFF;
+
+        OSCL_UNUSED_ARG(extra_info);
+
+        NUM_SAD_HP_MB_CALL();
+
+        for (i = 0; i < 16; i++)
+        {
+            sad += sad_row_xhyh(ref, ref + rx, blk);
+
+            NUM_SAD_HP_MB();
+
+            if (sad > (Int)((ULong)dmin_rx >> 16))
+                return sad;
+            ref += rx;
+            blk += 16;
+        }
+        return sad;
+    }
+
+    Int SAD_MB_HalfPel_SIMDyh(UChar *ref, UChar *blk, Int dmin_rx, void *extra_info)
+    {
+        Int i;
+        Int sad = 0;
+        Int rx = dmin_rx & 0xFFFF;
+
+        OSCL_UNUSED_ARG(extra_info);
+
+        NUM_SAD_HP_MB_CALL();
+
+        for (i = 0; i < 16; i++)
+        {
+            sad += sad_row_yh(ref, ref + rx, blk);
+
+            NUM_SAD_HP_MB();
+
+            if (sad > (Int)((ULong)dmin_rx >> 16))
+                return sad;
+            ref += rx;
+            blk += 16;
+        }
+        return sad;
+    }
+
+    Int SAD_MB_HalfPel_SIMDxh(UChar *ref, UChar *blk, Int dmin_rx, void *extra_info)
+    {
+        Int i;
+        Int sad = 0;
+        Int rx = dmin_rx & 0xFFFF;
+
+        OSCL_UNUSED_ARG(extra_info);
+
+        NUM_SAD_HP_MB_CALL();
+
+        for (i = 0; i < 16; i++)
+        {
+            sad += sad_row_xh(ref, blk);
+
+            NUM_SAD_HP_MB();
+
+            if (sad > (Int)((ULong)dmin_rx >> 16))
+                return sad;
+            ref += rx;
+            blk += 16;
+        }
+        return sad;
+    }
+#endif /* SAD_SIMD */
+
 #ifdef HTFM  /* HTFM with uniform subsampling implementation, 2/28/01 */
 
 //Checheck here
     Int SAD_MB_HP_HTFM_Collectxhyh(UChar *ref, UChar *blk, Int dmin_rx, void *extra_info)
     {
-        Int i, j;
+        Int i;
         Int sad = 0;
         UChar *p1, *p2;
         Int rx = dmin_rx & 0xFFFF;
         Int refwx4 = rx << 2;
         Int saddata[16];      /* used when collecting flag (global) is on */
-        Int difmad, tmp, tmp2;
+        Int difmad;
         HTFM_Stat *htfm_stat = (HTFM_Stat*) extra_info;
         Int *abs_dif_mad_avg = &(htfm_stat->abs_dif_mad_avg);
         UInt *countbreak = &(htfm_stat->countbreak);
         Int *offsetRef = htfm_stat->offsetRef;
+#ifndef SAD_SIMD
+        Int j, tmp, tmp2;
         ULong cur_word;
+#endif
 
         NUM_SAD_HP_MB_CALL();
 
@@ -355,7 +434,10 @@ extern "C"
         {
             p1 = ref + offsetRef[i];
             p2 = p1 + rx;
-
+#ifdef SAD_SIMD
+            sad += sad_stage_xhyh(p1, p2, refwx4, blk + 4);
+            blk += 16;
+#else
             j = 4;/* 4 lines */
             do
             {
@@ -388,6 +470,7 @@ extern "C"
                 sad = INTERP2_SUB_SAD(sad, tmp, tmp2);;
             }
             while (--j);
+#endif
 
             NUM_SAD_HP_MB();
 
@@ -413,18 +496,21 @@ extern "C"
 
     Int SAD_MB_HP_HTFM_Collectyh(UChar *ref, UChar *blk, Int dmin_rx, void *extra_info)
     {
-        Int i, j;
+        Int i;
         Int sad = 0;
         UChar *p1, *p2;
         Int rx = dmin_rx & 0xFFFF;
         Int refwx4 = rx << 2;
         Int saddata[16];      /* used when collecting flag (global) is on */
-        Int difmad, tmp, tmp2;
+        Int difmad;
         HTFM_Stat *htfm_stat = (HTFM_Stat*) extra_info;
         Int *abs_dif_mad_avg = &(htfm_stat->abs_dif_mad_avg);
         UInt *countbreak = &(htfm_stat->countbreak);
         Int *offsetRef = htfm_stat->offsetRef;
+#ifndef SAD_SIMD
+        Int j, tmp, tmp2;
         ULong cur_word;
+#endif
 
         NUM_SAD_HP_MB_CALL();
 
@@ -434,6 +520,10 @@ extern "C"
         {
             p1 = ref + offsetRef[i];
             p2 = p1 + rx;
+#ifdef SAD_SIMD
+            sad += sad_stage_yh(p1, p2, refwx4, blk + 4);
+            blk += 16;
+#else
             j = 4;
             do
             {
@@ -466,6 +556,7 @@ extern "C"
                 sad = INTERP1_SUB_SAD(sad, tmp, tmp2);;
             }
             while (--j);
+#endif
 
             NUM_SAD_HP_MB();
 
@@ -491,18 +582,21 @@ extern "C"
 
     Int SAD_MB_HP_HTFM_Collectxh(UChar *ref, UChar *blk, Int dmin_rx, void *extra_info)
     {
-        Int i, j;
+        Int i;
         Int sad = 0;
         UChar *p1;
         Int rx = dmin_rx & 0xFFFF;
         Int refwx4 = rx << 2;
         Int saddata[16];      /* used when collecting flag (global) is on */
-        Int difmad, tmp, tmp2;
+        Int difmad;
         HTFM_Stat *htfm_stat = (HTFM_Stat*) extra_info;
         Int *abs_dif_mad_avg = &(htfm_stat->abs_dif_mad_avg);
         UInt *countbreak = &(htfm_stat->countbreak);
         Int *offsetRef = htfm_stat->offsetRef;
+#ifndef SAD_SIMD
+        Int j, tmp, tmp2;
         ULong cur_word;
+#endif
 
         NUM_SAD_HP_MB_CALL();
 
@@ -511,7 +605,10 @@ extern "C"
         for (i = 0; i < 16; i++) /* 16 stages */
         {
             p1 = ref + offsetRef[i];
-
+#ifdef SAD_SIMD
+            sad += sad_stage_xh(p1, refwx4, blk + 4);
+            blk += 16;
+#else
             j = 4; /* 4 lines */
             do
             {
@@ -543,6 +640,7 @@ extern "C"
                 sad = INTERP1_SUB_SAD(sad, tmp, tmp2);;
             }
             while (--j);
+#endif
 
             NUM_SAD_HP_MB();
 
@@ -568,15 +666,18 @@ extern "C"
 
     Int SAD_MB_HP_HTFMxhyh(UChar *ref, UChar *blk, Int dmin_rx, void *extra_info)
     {
-        Int i, j;
-        Int sad = 0, tmp, tmp2;
+        Int i;
+        Int sad = 0;
         UChar *p1, *p2;
         Int rx = dmin_rx & 0xFFFF;
         Int refwx4 = rx << 2;
         Int sadstar = 0, madstar;
         Int *nrmlz_th = (Int*) extra_info;
         Int *offsetRef = nrmlz_th + 32;
+#ifndef SAD_SIMD
+        Int j, tmp, tmp2;
         ULong cur_word;
+#endif
 
         madstar = (ULong)dmin_rx >> 20;
 
@@ -588,7 +689,10 @@ extern "C"
         {
             p1 = ref + offsetRef[i];
             p2 = p1 + rx;
-
+#ifdef SAD_SIMD
+            sad += sad_stage_xhyh(p1, p2, refwx4, blk + 4);
+            blk += 16;
+#else
             j = 4; /* 4 lines */
             do
             {
@@ -621,6 +725,7 @@ extern "C"
                 sad = INTERP2_SUB_SAD(sad, tmp, tmp2);;
             }
             while (--j);
+#endif
 
             NUM_SAD_HP_MB();
 
@@ -636,15 +741,18 @@ extern "C"
 
     Int SAD_MB_HP_HTFMyh(UChar *ref, UChar *blk, Int dmin_rx, void *extra_info)
     {
-        Int i, j;
-        Int sad = 0, tmp, tmp2;
+        Int i;
+        Int sad = 0;
         UChar *p1, *p2;
         Int rx = dmin_rx & 0xFFFF;
         Int refwx4 = rx << 2;
         Int sadstar = 0, madstar;
         Int *nrmlz_th = (Int*) extra_info;
         Int *offsetRef = nrmlz_th + 32;
+#ifndef SAD_SIMD
+        Int j, tmp, tmp2;
         ULong cur_word;
+#endif
 
         madstar = (ULong)dmin_rx >> 20;
 
@@ -656,6 +764,10 @@ extern "C"
         {
             p1 = ref + offsetRef[i];
             p2 = p1 + rx;
+#ifdef SAD_SIMD
+            sad += sad_stage_yh(p1, p2, refwx4, blk + 4);
+            blk += 16;
+#else
             j = 4;
             do
             {
@@ -688,6 +800,7 @@ extern "C"
                 sad = INTERP1_SUB_SAD(sad, tmp, tmp2);;
             }
             while (--j);
+#endif
 
             NUM_SAD_HP_MB();
             sadstar += madstar;
@@ -702,15 +815,18 @@ extern "C"
 
     Int SAD_MB_HP_HTFMxh(UChar *ref, UChar *blk, Int dmin_rx, void *extra_info)
     {
-        Int i, j;
-        Int sad = 0, tmp, tmp2;
+        Int i;
+        Int sad = 0;
         UChar *p1;
         Int rx = dmin_rx & 0xFFFF;
         Int refwx4 = rx << 2;
         Int sadstar = 0, madstar;
         Int *nrmlz_th = (Int*) extra_info;
         Int *offsetRef = nrmlz_th + 32;
+#ifndef SAD_SIMD
+        Int j, tmp, tmp2;
         ULong cur_word;
+#endif
 
         madstar = (ULong)dmin_rx >> 20;
 
@@ -721,7 +837,10 @@ extern "C"
         for (i = 0; i < 16; i++) /* 16 stages */
         {
             p1 = ref + offsetRef[i];
-
+#ifdef SAD_SIMD
+            sad += sad_stage_xh(p1, refwx4, blk + 4);
+            blk += 16;
+#else
             j = 4;/* 4 lines */
             do
             {
@@ -753,6 +872,7 @@ extern "C"
                 sad = INTERP1_SUB_SAD(sad, tmp, tmp2);;
             }
             while (--j);
+#endif
 
             NUM_SAD_HP_MB();
 
@@ -0,0 +1,211 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied.
+ * See the License for the specific language governing permissions
+ * and limitations under the License.
+ */
+/*********************************************************************************/
+/*  Filename: sad_simd_inline.h                                                  */
+/*  Description: NEON and SSE2 SAD kernels used in sad.cpp and sad_halfpel.cpp   */
+/*  Modified:                                                                   */
+/*********************************************************************************/
+#ifndef _SAD_SIMD_INLINE_H_
+#define _SAD_SIMD_INLINE_H_
+
+/* The kernels compute the SAD of 16 pixels, either one row of a macroblock or one
+   HTFM stage (every fourth pixel of four rows, in the order of video->currYMB).
+   Callers keep their early drop-out checks, so the results are bit-exact with the
+   C code.
+
+   The loads read 16 bytes from the start of a reference row, up to 3 bytes more than
+   the C code. Reference rows are inside the padded luma plane, which is followed by
+   the chroma planes of the same allocation.
+
+   Android requires NEON on arm64 and SSE2 on x86, so the kernels are selected at
+   compile time. Define M4VENC_NO_SIMD to build the C code only. */
+
+#if !defined(M4VENC_NO_SIMD) && (defined(__ARM_NEON) || defined(__ARM_NEON__))
+#define SAD_SIMD_NEON
+#include <arm_neon.h>
+#elif !defined(M4VENC_NO_SIMD) && defined(__SSE2__)
+#define SAD_SIMD_SSE2
+#include <emmintrin.h>
+#endif
+
+#if defined(SAD_SIMD_NEON) || defined(SAD_SIMD_SSE2)
+#define SAD_SIMD
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#ifdef SAD_SIMD_NEON
+
+    typedef uint8x16_t sad_pix16;
+
+    static inline sad_pix16 sad_load_row(const UChar *p)
+    {
+        return vld1q_u8(p);
+    }
+
+    /* pixels 0, 4, 8 and 12 of two rows */
+    static inline uint8x8_t sad_select_2rows(const UChar *p, Int lx)
+    {
+        uint16x4_t r0 = vmovn_u32(vreinterpretq_u32_u8(vld1q_u8(p)));
+        uint16x4_t r1 = vmovn_u32(vreinterpretq_u32_u8(vld1q_u8(p + lx)));
+        return vmovn_u16(vcombine_u16(r0, r1));
+    }
+
+    /* pixels 0, 4, 8 and 12 of four rows, lx apart */
+    static inline sad_pix16 sad_load_stage(const UChar *p, Int lx)
+    {
+        return vcombine_u8(sad_select_2rows(p, lx), sad_select_2rows(p + 2 * lx, lx));
+    }
+
+    /* (a + b + 1) >> 1 */
+    static inline sad_pix16 sad_avg2(sad_pix16 a, sad_pix16 b)
+    {
+        return vrhaddq_u8(a, b);
+    }
+
+    /* (a + b + c + d + 2) >> 2 */
+    static inline sad_pix16 sad_avg4(sad_pix16 a, sad_pix16 b, sad_pix16 c, sad_pix16 d)
+    {
+        uint16x8_t lo = vaddq_u16(vaddl_u8(vget_low_u8(a), vget_low_u8(b)),
+                                  vaddl_u8(vget_low_u8(c), vget_low_u8(d)));
+        uint16x8_t hi = vaddq_u16(vaddl_u8(vget_high_u8(a), vget_high_u8(b)),
+                                  vaddl_u8(vget_high_u8(c), vget_high_u8(d)));
+        return vcombine_u8(vrshrn_n_u16(lo, 2), vrshrn_n_u16(hi, 2));
+    }
+
+    static inline Int sad_sum16(sad_pix16 a, const UChar *blk)
+    {
+        uint8x16_t b = vld1q_u8(blk);
+        uint16x8_t d = vabdl_u8(vget_low_u8(a), vget_low_u8(b));
+        d = vabal_u8(d, vget_high_u8(a), vget_high_u8(b));
+#ifdef __aarch64__
+        return vaddlvq_u16(d);
+#else
+        uint64x2_t s = vpaddlq_u32(vpaddlq_u16(d));
+        return (Int)(vgetq_lane_u64(s, 0) + vgetq_lane_u64(s, 1));
+#endif
+    }
+
+#else /* SAD_SIMD_SSE2 */
+
+    typedef __m128i sad_pix16;
+
+    static inline sad_pix16 sad_load_row(const UChar *p)
+    {
+        return _mm_loadu_si128((const __m128i *)p);
+    }
+
+    /* pixels 0, 4, 8 and 12 of four rows, lx apart */
+    static inline sad_pix16 sad_load_stage(const UChar *p, Int lx)
+    {
+        const __m128i mask = _mm_set1_epi32(0xFF);
+        __m128i r0 = _mm_and_si128(_mm_loadu_si128((const __m128i *)p), mask);
+        __m128i r1 = _mm_and_si128(_mm_loadu_si128((const __m128i *)(p + lx)), mask);
+        __m128i r2 = _mm_and_si128(_mm_loadu_si128((const __m128i *)(p + 2 * lx)), mask);
+        __m128i r3 = _mm_and_si128(_mm_loadu_si128((const __m128i *)(p + 3 * lx)), mask);
+        return _mm_packus_epi16(_mm_packs_epi32(r0, r1), _mm_packs_epi32(r2, r3));
+    }
+
+    /* (a + b + 1) >> 1 */
+    static inline sad_pix16 sad_avg2(sad_pix16 a, sad_pix16 b)
+    {
+        return _mm_avg_epu8(a, b);
+    }
+
+    /* (a + b + c + d + 2) >> 2 */
+    static inline sad_pix16 sad_avg4(sad_pix16 a, sad_pix16 b, sad_pix16 c, sad_pix16 d)
+    {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i two = _mm_set1_epi16(2);
+        __m128i lo = _mm_add_epi16(_mm_add_epi16(_mm_unpacklo_epi8(a, zero),
+                                                 _mm_unpacklo_epi8(b, zero)),
+                                   _mm_add_epi16(_mm_unpacklo_epi8(c, zero),
+                                                 _mm_unpacklo_epi8(d, zero)));
+        __m128i hi = _mm_add_epi16(_mm_add_epi16(_mm_unpackhi_epi8(a, zero),
+                                                 _mm_unpackhi_epi8(b, zero)),
+                                   _mm_add_epi16(_mm_unpackhi_epi8(c, zero),
+                                                 _mm_unpackhi_epi8(d, zero)));
+        lo = _mm_srli_epi16(_mm_add_epi16(lo, two), 2);
+        hi = _mm_srli_epi16(_mm_add_epi16(hi, two), 2);
+        return _mm_packus_epi16(lo, hi);
+    }
+
+    static inline Int sad_sum16(sad_pix16 a, const UChar *blk)
+    {
+        __m128i s = _mm_sad_epu8(a, _mm_loadu_si128((const __m128i *)blk));
+        return _mm_cvtsi128_si32(s) + _mm_extract_epi16(s, 4);
+    }
+
+#endif /* SAD_SIMD_SSE2 */
+
+    /* one row of 16 pixels */
+    static inline Int sad_row(const UChar *ref, const UChar *blk)
+    {
+        return sad_sum16(sad_load_row(ref), blk);
+    }
+
+    static inline Int sad_row_xh(const UChar *ref, const UChar *blk)
+    {
+        return sad_sum16(sad_avg2(sad_load_row(ref), sad_load_row(ref + 1)), blk);
+    }
+
+    /* ref2 is the row below ref */
+    static inline Int sad_row_yh(const UChar *ref, const UChar *ref2, const UChar *blk)
+    {
+        return sad_sum16(sad_avg2(sad_load_row(ref), sad_load_row(ref2)), blk);
+    }
+
+    static inline Int sad_row_xhyh(const UChar *ref, const UChar *ref2, const UChar *blk)
+    {
+        return sad_sum16(sad_avg4(sad_load_row(ref), sad_load_row(ref + 1),
+                                  sad_load_row(ref2), sad_load_row(ref2 + 1)), blk);
+    }
+
+    /* one HTFM stage, rows lx4 apart */
+    static inline Int sad_stage(const UChar *ref, Int lx4, const UChar *blk)
+    {
+        return sad_sum16(sad_load_stage(ref, lx4), blk);
+    }
+
+    static inline Int sad_stage_xh(const UChar *ref, Int lx4, const UChar *blk)
+    {
+        return sad_sum16(sad_avg2(sad_load_stage(ref, lx4), sad_load_stage(ref + 1, lx4)), blk);
+    }
+
+    static inline Int sad_stage_yh(const UChar *ref, const UChar *ref2, Int lx4,
+                                   const UChar *blk)
+    {
+        return sad_sum16(sad_avg2(sad_load_stage(ref, lx4), sad_load_stage(ref2, lx4)), blk);
+    }
+
+    static inline Int sad_stage_xhyh(const UChar *ref, const UChar *ref2, Int lx4,
+                                     const UChar *blk)
+    {
+        return sad_sum16(sad_avg4(sad_load_stage(ref, lx4), sad_load_stage(ref + 1, lx4),
+                                  sad_load_stage(ref2, lx4), sad_load_stage(ref2 + 1, lx4)),
+                         blk);
+    }
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SAD_SIMD */
+
+#endif /* _SAD_SIMD_INLINE_H_ */
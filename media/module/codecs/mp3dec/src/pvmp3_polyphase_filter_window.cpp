@@ -76,11 +76,114 @@ Input
 #include "pvmp3_dec_defs.h"
 #include "pvmp3_tables.h"
 
+/*
+ * The window of each output pair (j, 32 - j) is computed four products at a
+ * time with NEON on arm64 and SSE4.1 on x86_64, which both ABIs require.
+ * Each product is truncated as in fxp_mac32_Q32(), and the sums wrap, so the
+ * output is bit-exact with the C code. Define PVMP3_NO_SIMD to build the C
+ * code only.
+ */
+#if !defined(PVMP3_NO_SIMD) && (defined(__ARM_NEON) || defined(__ARM_NEON__))
+#define PVMP3_SIMD_NEON
+#include <arm_neon.h>
+#elif !defined(PVMP3_NO_SIMD) && defined(__SSE4_1__)
+#define PVMP3_SIMD_SSE4
+#include <smmintrin.h>
+#endif
+
 /*----------------------------------------------------------------------------
 ; MACROS
 ; Define module1 specific macros here
 ----------------------------------------------------------------------------*/
 
+#if defined(PVMP3_SIMD_NEON)
+
+typedef int32x4_t vec32;
+
+static inline vec32 vec32_set(int32 a, int32 b, int32 c, int32 d)
+{
+    const int32 t[4] = { a, b, c, d };
+    return vld1q_s32(t);
+}
+
+static inline vec32 vec32_load(const int32 *p)
+{
+    return vld1q_s32(p);
+}
+
+/* (b, a, d, c) */
+static inline vec32 vec32_swap_pairs(vec32 v)
+{
+    return vrev64q_s32(v);
+}
+
+static inline vec32 vec32_add(vec32 a, vec32 b)
+{
+    return vaddq_s32(a, b);
+}
+
+/* (a * b) >> 32 per lane; ((2 * a * b) >> 32) >> 1 only saturates for a = b = INT32_MIN */
+static inline vec32 vec32_mul_Q32(vec32 a, vec32 b)
+{
+    return vshrq_n_s32(vqdmulhq_s32(a, b), 1);
+}
+
+/* sum of the lanes, negating those where neg is -1 */
+static inline int32 vec32_sum(vec32 v, vec32 neg)
+{
+    v = vsubq_s32(veorq_s32(v, neg), neg);
+#ifdef __aarch64__
+    return vaddvq_s32(v);
+#else
+    int32x2_t s = vadd_s32(vget_low_s32(v), vget_high_s32(v));
+    return vget_lane_s32(vpadd_s32(s, s), 0);
+#endif
+}
+
+#elif defined(PVMP3_SIMD_SSE4)
+
+typedef __m128i vec32;
+
+static inline vec32 vec32_set(int32 a, int32 b, int32 c, int32 d)
+{
+    return _mm_setr_epi32(a, b, c, d);
+}
+
+static inline vec32 vec32_load(const int32 *p)
+{
+    return _mm_loadu_si128((const __m128i *)p);
+}
+
+/* (b, a, d, c) */
+static inline vec32 vec32_swap_pairs(vec32 v)
+{
+    return _mm_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1));
+}
+
+static inline vec32 vec32_add(vec32 a, vec32 b)
+{
+    return _mm_add_epi32(a, b);
+}
+
+/* (a * b) >> 32 per lane */
+static inline vec32 vec32_mul_Q32(vec32 a, vec32 b)
+{
+    __m128i even = _mm_srli_epi64(_mm_mul_epi32(a, b), 32);
+    __m128i odd = _mm_mul_epi32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+    return _mm_blend_epi16(even, odd, 0xCC);
+}
+
+/* sum of the lanes, negating those where neg is -1 */
+static inline int32 vec32_sum(vec32 v, vec32 neg)
+{
+    v = _mm_sub_epi32(_mm_xor_si128(v, neg), neg);
+    v = _mm_add_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2)));
+    v = _mm_add_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtsi128_si32(v);
+}
+
+#endif
+
 
 
 /*----------------------------------------------------------------------------
@@ -122,6 +225,44 @@ void pvmp3_polyphase_filter_window(int32 *synth_buffer,
     int32 i;
 
 
+#if defined(PVMP3_SIMD_NEON) || defined(PVMP3_SIMD_SSE4)
+    /*
+     * HAN_SIZE == SUBBANDS_NUMBER << 4, so the loop over i below runs once.
+     * Each group of four window values multiplies (temp1, temp3, temp2, temp4)
+     * for sum1 and (temp3, temp1, temp4, temp2) for sum2; the products of
+     * fxp_msb32_Q32() are negated when the lanes are summed.
+     */
+    const vec32 neg1 = vec32_set(0, -1, 0, 0);
+    const vec32 neg2 = vec32_set(0, 0, -1, 0);
+
+    for (int16 j = 1; j < SUBBANDS_NUMBER / 2; j++)
+    {
+        const int32 *pt_1 = &synth_buffer[(SUBBANDS_NUMBER >> 1) + j];
+        const int32 *pt_2 = &synth_buffer[(SUBBANDS_NUMBER >> 1) - j];
+        vec32 acc1 = vec32_set(0x00000020, 0, 0, 0);
+        vec32 acc2 = acc1;
+
+        for (i = 0; i < 4; i++)
+        {
+            vec32 temp = vec32_set(pt_1[SUBBANDS_NUMBER * (2 * i)],
+                                   pt_2[SUBBANDS_NUMBER * (15 - 2 * i)],
+                                   pt_2[SUBBANDS_NUMBER * (2 * i + 1)],
+                                   pt_1[SUBBANDS_NUMBER * (14 - 2 * i)]);
+            vec32 win = vec32_load(&winPtr[4 * i]);
+
+            acc1 = vec32_add(acc1, vec32_mul_Q32(temp, win));
+            acc2 = vec32_add(acc2, vec32_mul_Q32(vec32_swap_pairs(temp), win));
+        }
+        winPtr += 16;
+
+        sum1 = vec32_sum(acc1, neg1);
+        sum2 = vec32_sum(acc2, neg2);
+
+        int32 k = j << (numChannels - 1);
+        outPcm[k] = saturate16(sum1 >> 6);
+        outPcm[(numChannels<<5) - k] = saturate16(sum2 >> 6);
+    }
+#else
     for (int16 j = 1; j < SUBBANDS_NUMBER / 2; j++)
     {
         sum1 = 0x00000020;
@@ -199,6 +340,7 @@ void pvmp3_polyphase_filter_window(int32 *synth_buffer,
         outPcm[k] = saturate16(sum1 >> 6);
         outPcm[(numChannels<<5) - k] = saturate16(sum2 >> 6);
     }
+#endif
 
 
 
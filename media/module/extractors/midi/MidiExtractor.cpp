@@ -28,11 +28,73 @@
 #include <libsonivox/eas_reverb.h>
 #include <watchdog/Watchdog.h>
 
+#include <algorithm>
+#include <list>
+#include <mutex>
+
 namespace android {
 
 // how many Sonivox output buffers to aggregate into one MediaBuffer
 static const int NUM_COMBINE_BUFFERS = 4;
 
+// Files up to this size are rendered once per process, as long as their PCM fits in
+// kMaxCachedPcmBytes. This covers notification sounds and ringtones, which are played
+// over and over.
+static const size_t kMaxCachedFileSize = 64 * 1024;
+static const size_t kMaxCachedPcmBytes = 2 * 1024 * 1024;
+static const size_t kMaxPcmCacheBytes = 8 * 1024 * 1024;
+
+// Rendered PCM of short files, shared by all engines of the process and keyed by the file
+// contents. The least recently used files are dropped first.
+class MidiPcmCache {
+public:
+    static MidiPcmCache &getInstance() {
+        static MidiPcmCache cache;
+        return cache;
+    }
+
+    std::shared_ptr<const std::vector<EAS_PCM>> lookup(const std::vector<uint8_t> &file) {
+        std::lock_guard<std::mutex> lock(mLock);
+        for (auto it = mEntries.begin(); it != mEntries.end(); ++it) {
+            if (*it->file == file) {
+                mEntries.splice(mEntries.begin(), mEntries, it);
+                return it->pcm;
+            }
+        }
+        return nullptr;
+    }
+
+    void insert(const std::shared_ptr<const std::vector<uint8_t>> &file,
+                const std::shared_ptr<const std::vector<EAS_PCM>> &pcm) {
+        std::lock_guard<std::mutex> lock(mLock);
+        for (const Entry &entry : mEntries) {
+            if (*entry.file == *file) {
+                return;
+            }
+        }
+        mEntries.push_front({file, pcm});
+        mBytes += entryBytes(mEntries.front());
+        while (mBytes > kMaxPcmCacheBytes) {
+            mBytes -= entryBytes(mEntries.back());
+            mEntries.pop_back();
+        }
+    }
+
+private:
+    struct Entry {
+        std::shared_ptr<const std::vector<uint8_t>> file;
+        std::shared_ptr<const std::vector<EAS_PCM>> pcm;
+    };
+
+    static size_t entryBytes(const Entry &entry) {
+        return entry.file->size() + entry.pcm->size() * sizeof(EAS_PCM);
+    }
+
+    std::mutex mLock;
+    std::list<Entry> mEntries;  // most recently used first
+    size_t mBytes = 0;
+};
+
 class MidiSource : public MediaTrackHelper {
 
 public:
@@ -150,7 +212,9 @@ MidiEngine::MidiEngine(CDataSource *dataSource,
             mEasData(NULL),
             mEasHandle(NULL),
             mEasConfig(NULL),
-            mIsInitialized(false) {
+            mIsInitialized(false),
+            mBufferSize(0),
+            mCachedPcmPos(0) {
     Watchdog watchdog(kTimeout);
 
     mIoWrapper = new MidiIoWrapper(dataSource);
@@ -187,6 +251,15 @@ MidiEngine::MidiEngine(CDataSource *dataSource,
                 trackMetadata, AMEDIAFORMAT_KEY_CHANNEL_COUNT, mEasConfig->numChannels);
         AMediaFormat_setInt32(
                 trackMetadata, AMEDIAFORMAT_KEY_PCM_ENCODING, kAudioEncodingPcm16bit);
+
+        const int size = mIoWrapper->size();
+        if (size > 0 && (size_t)size <= kMaxCachedFileSize) {
+            auto file = std::make_shared<std::vector<uint8_t>>(size);
+            if (mIoWrapper->readAt(file->data(), 0, size) == size) {
+                mCachedPcm = MidiPcmCache::getInstance().lookup(*file);
+                mFileData = std::move(file);
+            }
+        }
     }
     mIsInitialized = true;
 }
@@ -217,6 +290,13 @@ status_t MidiEngine::allocateBuffers(MediaBufferGroupHelper *group) {
     ALOGV("using %d byte buffer", bufsize);
     mGroup = group;
     mGroup->add_buffer(bufsize);
+    mBufferSize = bufsize;
+
+    EAS_I32 timeMs = -1;
+    EAS_GetLocation(mEasData, mEasHandle, &timeMs);
+    if (mCachedPcm == nullptr && mFileData != nullptr && timeMs == 0) {
+        mCapture = std::make_unique<std::vector<EAS_PCM>>();
+    }
     return OK;
 }
 
@@ -228,16 +308,35 @@ status_t MidiEngine::seekTo(int64_t positionUs) {
     Watchdog watchdog(kTimeout);
 
     ALOGV("seekTo %lld", (long long)positionUs);
+    if (mCachedPcm != nullptr) {
+        const size_t frame = positionUs * mEasConfig->sampleRate / 1000000;
+        mCachedPcmPos = std::min(frame * mEasConfig->numChannels, mCachedPcm->size());
+        return OK;
+    }
+    // only a playback from the start can be captured
+    if (mCapture != nullptr && (positionUs != 0 || !mCapture->empty())) {
+        mCapture.reset();
+    }
     EAS_RESULT result = EAS_Locate(mEasData, mEasHandle, positionUs / 1000, false);
     return result == EAS_SUCCESS ? OK : UNKNOWN_ERROR;
 }
 
 MediaBufferHelper* MidiEngine::readBuffer() {
+    if (mCachedPcm != nullptr) {
+        return readCachedBuffer();
+    }
+
     Watchdog watchdog(kTimeout);
 
     EAS_STATE state;
     EAS_State(mEasData, mEasHandle, &state);
     if ((state == EAS_STATE_STOPPED) || (state == EAS_STATE_ERROR)) {
+        if (state == EAS_STATE_STOPPED && mCapture != nullptr) {
+            // Serve later seeks, e.g. when looping, from the captured PCM too.
+            mCachedPcm = std::move(mCapture);
+            mCachedPcmPos = mCachedPcm->size();
+            MidiPcmCache::getInstance().insert(mFileData, mCachedPcm);
+        }
         return NULL;
     }
     MediaBufferHelper *buffer = nullptr;
@@ -260,6 +359,7 @@ MediaBufferHelper* MidiEngine::readBuffer() {
         EAS_RESULT result = EAS_Render(mEasData, p, mEasConfig->mixBufferSize, &numRendered);
         if (result != EAS_SUCCESS) {
             ALOGE("EAS_Render() returned %ld, numBytesOutput = %d", result, numBytesOutput);
+            mCapture.reset();
             buffer->release();
             return NULL; // Stop processing to prevent infinite loops.
         }
@@ -267,10 +367,48 @@ MediaBufferHelper* MidiEngine::readBuffer() {
         numBytesOutput += numRendered * mEasConfig->numChannels * sizeof(EAS_PCM);
     }
     buffer->set_range(0, numBytesOutput);
+    capture((const EAS_PCM *)buffer->data(), numBytesOutput / sizeof(EAS_PCM));
     ALOGV("readBuffer: returning %zd in buffer %p", buffer->range_length(), buffer);
     return buffer;
 }
 
+MediaBufferHelper* MidiEngine::readCachedBuffer() {
+    if (mCachedPcmPos >= mCachedPcm->size()) {
+        return NULL;
+    }
+    MediaBufferHelper *buffer = nullptr;
+    status_t err = mGroup->acquire_buffer(&buffer);
+    if (err != OK || buffer == nullptr) {
+        ALOGE("readCachedBuffer: no buffer");
+        return NULL;
+    }
+    int64_t timeUs = 1000000ll * (mCachedPcmPos / mEasConfig->numChannels)
+            / mEasConfig->sampleRate;
+    AMediaFormat *meta = buffer->meta_data();
+    AMediaFormat_setInt64(meta, AMEDIAFORMAT_KEY_TIME_US, timeUs);
+    AMediaFormat_setInt32(meta, AMEDIAFORMAT_KEY_IS_SYNC_FRAME, 1);
+
+    const size_t numSamples = std::min(mBufferSize / sizeof(EAS_PCM),
+                                       mCachedPcm->size() - mCachedPcmPos);
+    memcpy(buffer->data(), mCachedPcm->data() + mCachedPcmPos, numSamples * sizeof(EAS_PCM));
+    mCachedPcmPos += numSamples;
+    buffer->set_range(0, numSamples * sizeof(EAS_PCM));
+    ALOGV("readCachedBuffer: returning %zd in buffer %p", buffer->range_length(), buffer);
+    return buffer;
+}
+
+void MidiEngine::capture(const EAS_PCM *pcm, size_t numSamples) {
+    if (mCapture == nullptr) {
+        return;
+    }
+    if ((mCapture->size() + numSamples) * sizeof(EAS_PCM) > kMaxCachedPcmBytes) {
+        ALOGV("capture: too long to cache");
+        mCapture.reset();
+        return;
+    }
+    mCapture->insert(mCapture->end(), pcm, pcm + numSamples);
+}
+
 
 // MidiExtractor
 
@@ -26,6 +26,9 @@
 #include <utils/String8.h>
 #include <libsonivox/eas.h>
 
+#include <memory>
+#include <vector>
+
 namespace android {
 
 class MidiEngine {
@@ -48,6 +51,18 @@ private:
     EAS_HANDLE mEasHandle;
     const S_EAS_LIB_CONFIG* mEasConfig;
     bool mIsInitialized;
+    size_t mBufferSize;
+
+    // Short files are rendered once per process: the PCM of the first complete playback is
+    // captured and kept in a cache keyed by the file contents, and later playbacks of the same
+    // file are served from it without synthesis.
+    std::shared_ptr<const std::vector<uint8_t>> mFileData;
+    std::shared_ptr<const std::vector<EAS_PCM>> mCachedPcm;
+    size_t mCachedPcmPos;
+    std::unique_ptr<std::vector<EAS_PCM>> mCapture;
+
+    MediaBufferHelper* readCachedBuffer();
+    void capture(const EAS_PCM *pcm, size_t numSamples);
 };
 
 class MidiExtractor : public MediaExtractorPluginHelper {
@@ -38,6 +38,7 @@
 
 #include <arpa/inet.h>
 #include <inttypes.h>
+#include <algorithm>
 #include <vector>
 
 namespace android {
@@ -388,6 +389,7 @@ void BlockIterator::advance_l() {
             CHECK(!nextCluster->EOS());
 
             mCluster = nextCluster;
+            mExtractor->indexCluster_l(mCluster);
 
             res = mCluster->Parse(pos, len);
             ALOGV("Parse (2) returned %ld", res);
@@ -584,7 +586,7 @@ int64_t BlockIterator::blockTimeUs() const {
 }
 
 void BlockIterator::seekwithoutcue_l(int64_t seekTimeUs, int64_t *actualFrameTimeUs) {
-    mCluster = mExtractor->mSegment->FindCluster(seekTimeUs * 1000ll);
+    mCluster = mExtractor->findCluster_l(seekTimeUs * 1000ll);
     const long status = mCluster->GetFirst(mBlockEntry);
     if (status < 0) {  // error
         ALOGE("get last blockenry failed!");
@@ -1485,6 +1487,64 @@ bool MatroskaExtractor::isLiveStreaming() const {
     return mIsLiveStreaming;
 }
 
+void MatroskaExtractor::indexCluster_l(const mkvparser::Cluster *cluster) {
+    const long long timeNs = cluster->GetTime();
+    const long long pos = cluster->GetPosition();
+    if (timeNs < 0) {
+        return;
+    }
+    if (!mClusterIndex.empty()) {
+        const ClusterInfo &last = mClusterIndex.top();
+        if (pos <= last.mPos || timeNs < last.mTimeNs) {
+            // Already indexed, or out of order.
+            return;
+        }
+    }
+    mClusterIndex.push({timeNs, pos, cluster});
+}
+
+// Returns the last cluster starting at or before timeNs, or the first cluster. Clusters
+// are looked up in the index of those seen so far, and only the clusters past the end of
+// the index are walked, one cluster header at a time, rather than block by block.
+const mkvparser::Cluster *MatroskaExtractor::findCluster_l(long long timeNs) {
+    const mkvparser::Cluster *cluster = mSegment->GetFirst();
+    if (cluster == NULL || cluster->EOS()) {
+        return cluster;
+    }
+    if (mClusterIndex.empty()) {
+        indexCluster_l(cluster);
+    }
+
+    if (!mClusterIndex.empty()) {
+        const ClusterInfo *begin = mClusterIndex.array();
+        const ClusterInfo *end = begin + mClusterIndex.size();
+        const ClusterInfo *after = std::upper_bound(
+                begin, end, timeNs,
+                [](long long t, const ClusterInfo &info) { return t < info.mTimeNs; });
+        if (after != begin) {
+            cluster = (after - 1)->mCluster;
+        }
+    }
+
+    // The index may have gaps after seeks using Cues, so check the following clusters,
+    // which is cheap for those already loaded.
+    for (;;) {
+        const mkvparser::Cluster *next;
+        long long pos;
+        long len;
+        if (mSegment->ParseNext(cluster, next, pos, len) != 0
+                || next == NULL || next->EOS()) {
+            break;
+        }
+        indexCluster_l(next);
+        if (next->GetTime() > timeNs) {
+            break;
+        }
+        cluster = next;
+    }
+    return cluster;
+}
+
 static int bytesForSize(size_t size) {
     // use at most 28 bits (4 times 7)
     CHECK(size <= 0xfffffff);
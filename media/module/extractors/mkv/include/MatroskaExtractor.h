@@ -81,8 +81,17 @@ private:
         const mkvparser::CuePoint::TrackPosition *find(long long timeNs) const;
     };
 
+    // A cluster seen while reading or seeking, for seeking in files without Cues.
+    struct ClusterInfo {
+        long long mTimeNs;
+        long long mPos;
+        const mkvparser::Cluster *mCluster;  // owned by mSegment
+    };
+
     Mutex mLock;
     Vector<TrackInfo> mTracks;
+    // In increasing position and time order, guarded by mLock.
+    Vector<ClusterInfo> mClusterIndex;
 
     DataSourceHelper *mDataSource;
     DataSourceBaseReader *mReader;
@@ -105,6 +114,8 @@ private:
             const mkvparser::VideoTrack *vtrack,
             AMediaFormat *meta);
     bool isLiveStreaming() const;
+    void indexCluster_l(const mkvparser::Cluster *cluster);
+    const mkvparser::Cluster *findCluster_l(long long timeNs);
 
     MatroskaExtractor(const MatroskaExtractor &);
     MatroskaExtractor &operator=(const MatroskaExtractor &);
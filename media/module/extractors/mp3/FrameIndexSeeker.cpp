@@ -0,0 +1,182 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "FrameIndexSeeker"
+
+#include <inttypes.h>
+
+#include <utils/Log.h>
+
+#include "FrameIndexSeeker.h"
+
+#include <vector>
+
+#include <media/stagefright/foundation/avc_utils.h>
+
+#include <media/stagefright/foundation/ByteUtils.h>
+#include <media/stagefright/DataSourceBase.h>
+
+#include <media/MediaExtractorPluginApi.h>
+#include <media/MediaExtractorPluginHelper.h>
+
+namespace android {
+
+// static
+FrameIndexSeeker *FrameIndexSeeker::CreateFromSource(
+        DataSourceHelper *source, off64_t firstFramePos,
+        uint32_t fixedHeader, uint32_t headerMask) {
+    if (source->flags()
+            & (DataSourceBase::kIsCachingDataSource | DataSourceBase::kIsHTTPBasedSource)) {
+        return NULL;
+    }
+
+    size_t frameSize;
+    int sampleRate;
+    int samplesPerFrame;
+    if (!GetMPEGAudioFrameSize(
+                fixedHeader, &frameSize, &sampleRate, NULL, NULL, &samplesPerFrame)
+            || sampleRate <= 0 || samplesPerFrame <= 0) {
+        return NULL;
+    }
+
+    FrameIndexSeeker *seeker = new FrameIndexSeeker;
+    seeker->mDataSource = source;
+    seeker->mFixedHeader = fixedHeader;
+    seeker->mHeaderMask = headerMask;
+    seeker->mSampleRate = sampleRate;
+    seeker->mSamplesPerFrame = samplesPerFrame;
+    seeker->mScanPos = firstFramePos;
+
+    return seeker;
+}
+
+FrameIndexSeeker::FrameIndexSeeker()
+    : mDataSource(NULL),
+      mFixedHeader(0),
+      mHeaderMask(0),
+      mSampleRate(0),
+      mSamplesPerFrame(0),
+      mScanPos(0),
+      mNumFrames(0),
+      mScanDone(false) {
+}
+
+bool FrameIndexSeeker::getDuration(int64_t *durationUs) {
+    Mutex::Autolock autoLock(mLock);
+
+    // Only known once the whole file has been indexed.
+    if (!mScanDone || mNumFrames == 0) {
+        return false;
+    }
+    *durationUs = mNumFrames * mSamplesPerFrame * 1000000LL / mSampleRate;
+    return true;
+}
+
+bool FrameIndexSeeker::getOffsetForTime(int64_t *timeUs, off64_t *pos) {
+    Mutex::Autolock autoLock(mLock);
+
+    uint64_t frame = 0;
+    if (*timeUs > 0) {
+        frame = ((uint64_t)*timeUs * mSampleRate / 1000000) / mSamplesPerFrame;
+    }
+
+    scanTo_l(frame);
+    if (frame >= mNumFrames) {
+        // Past the end of the stream or of the frames that kept sync, let the
+        // caller fall back to the bitrate estimate.
+        return false;
+    }
+
+    // Walk the frame headers from the closest indexed frame.
+    size_t entry = frame / kFramesPerEntry;
+    off64_t offset = mEntries[entry];
+    for (uint64_t i = entry * kFramesPerEntry; i < frame; ++i) {
+        size_t frameSize;
+        if (!getFrameSizeAt_l(offset, &frameSize)) {
+            frame = i;
+            break;
+        }
+        offset += frameSize;
+    }
+
+    *pos = offset;
+    *timeUs = frame * mSamplesPerFrame * 1000000LL / mSampleRate;
+
+    ALOGV("getOffsetForTime %" PRId64 " us => frame %" PRIu64 " at %" PRId64,
+            *timeUs, frame, *pos);
+    return true;
+}
+
+void FrameIndexSeeker::onFrameRead(off64_t pos, size_t frameSize) {
+    Mutex::Autolock autoLock(mLock);
+
+    // Playback extends the index for free as long as it continues it.
+    if (!mScanDone && pos == mScanPos) {
+        addFrame_l(frameSize);
+    }
+}
+
+void FrameIndexSeeker::addFrame_l(size_t frameSize) {
+    if (mNumFrames % kFramesPerEntry == 0) {
+        mEntries.push_back(mScanPos);
+    }
+    mScanPos += frameSize;
+    ++mNumFrames;
+}
+
+void FrameIndexSeeker::scanTo_l(uint64_t frame) {
+    if (mScanDone || mNumFrames > frame) {
+        return;
+    }
+
+    std::vector<uint8_t> buffer(kScanBufferSize);
+    off64_t bufferPos = 0;
+    size_t bufferSize = 0;
+
+    while (!mScanDone && mNumFrames <= frame) {
+        if (mScanPos < bufferPos || mScanPos + 4 > bufferPos + (off64_t)bufferSize) {
+            ssize_t n = mDataSource->readAt(mScanPos, buffer.data(), buffer.size());
+            if (n < 4) {
+                mScanDone = true;
+                break;
+            }
+            bufferPos = mScanPos;
+            bufferSize = n;
+        }
+
+        uint32_t header = U32_AT(buffer.data() + (mScanPos - bufferPos));
+        size_t frameSize;
+        if ((header & mHeaderMask) != (mFixedHeader & mHeaderMask)
+                || !GetMPEGAudioFrameSize(header, &frameSize)) {
+            ALOGV("stopped indexing at %" PRId64 " after %" PRIu64 " frames",
+                    mScanPos, mNumFrames);
+            mScanDone = true;
+            break;
+        }
+        addFrame_l(frameSize);
+    }
+}
+
+bool FrameIndexSeeker::getFrameSizeAt_l(off64_t pos, size_t *frameSize) {
+    uint8_t header[4];
+    if (mDataSource->readAt(pos, header, sizeof(header)) < (ssize_t)sizeof(header)) {
+        return false;
+    }
+    return GetMPEGAudioFrameSize(U32_AT(header), frameSize);
+}
+
+}  // namespace android
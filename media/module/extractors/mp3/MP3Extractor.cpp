@@ -20,6 +20,7 @@
 
 #include "MP3Extractor.h"
 
+#include "FrameIndexSeeker.h"
 #include "ID3.h"
 #include "VBRISeeker.h"
 #include "XINGSeeker.h"
@@ -312,6 +313,12 @@ MP3Extractor::MP3Extractor(
         mFixedHeader = header;
     }
 
+    if (mSeeker == NULL) {
+        // Without a table of contents, seek by counting frames.
+        mSeeker = FrameIndexSeeker::CreateFromSource(
+                mDataSource, mFirstFramePos, mFixedHeader, kMask);
+    }
+
     size_t frame_size;
     int sample_rate;
     int num_channels;
@@ -588,6 +595,10 @@ media_status_t MP3Source::read(
 
     buffer->set_range(0, frame_size);
 
+    if (mSeeker != NULL) {
+        mSeeker->onFrameRead(mCurrentPos, frame_size);
+    }
+
     AMediaFormat *meta = buffer->meta_data();
     AMediaFormat_setInt64(meta, AMEDIAFORMAT_KEY_TIME_US, mCurrentTimeUs);
     AMediaFormat_setInt32(meta, AMEDIAFORMAT_KEY_IS_SYNC_FRAME, 1);
@@ -0,0 +1,76 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FRAME_INDEX_SEEKER_H_
+
+#define FRAME_INDEX_SEEKER_H_
+
+#include "MP3Seeker.h"
+
+#include <utils/threads.h>
+#include <utils/Vector.h>
+
+namespace android {
+
+class DataSourceHelper;
+
+// Seeks by frame count in files without a XING or VBRI table of contents.
+// Frame offsets are indexed as frames are read during playback, and seeks
+// past the indexed range scan the frame headers up to the target frame.
+struct FrameIndexSeeker : public MP3Seeker {
+    // Returns NULL if scanning the source ahead of playback would be costly,
+    // e.g. for network sources. Frames must match |fixedHeader| under
+    // |headerMask|.
+    static FrameIndexSeeker *CreateFromSource(
+            DataSourceHelper *source, off64_t firstFramePos,
+            uint32_t fixedHeader, uint32_t headerMask);
+
+    virtual bool getDuration(int64_t *durationUs);
+    virtual bool getOffsetForTime(int64_t *timeUs, off64_t *pos);
+    virtual void onFrameRead(off64_t pos, size_t frameSize);
+
+private:
+    // One offset is kept every kFramesPerEntry frames.
+    static const size_t kFramesPerEntry = 16;
+    static const size_t kScanBufferSize = 64 * 1024;
+
+    Mutex mLock;
+
+    DataSourceHelper *mDataSource;
+    uint32_t mFixedHeader;
+    uint32_t mHeaderMask;
+    int mSampleRate;
+    int mSamplesPerFrame;
+
+    Vector<off64_t> mEntries;
+    // Offset and index of the first frame not indexed yet.
+    off64_t mScanPos;
+    uint64_t mNumFrames;
+    // Set once the end of the stream or a frame that lost sync is reached.
+    bool mScanDone;
+
+    FrameIndexSeeker();
+
+    void addFrame_l(size_t frameSize);
+    void scanTo_l(uint64_t frame);
+    bool getFrameSizeAt_l(off64_t pos, size_t *frameSize);
+
+    DISALLOW_EVIL_CONSTRUCTORS(FrameIndexSeeker);
+};
+
+}  // namespace android
+
+#endif  // FRAME_INDEX_SEEKER_H_
@@ -33,6 +33,9 @@ struct MP3Seeker {
     // the actual time that seekpoint represents.
     virtual bool getOffsetForTime(int64_t *timeUs, off64_t *pos) = 0;
 
+    // Called for each frame read from the stream, starting at "pos".
+    virtual void onFrameRead(off64_t /* pos */, size_t /* frameSize */) {}
+
     virtual ~MP3Seeker() {}
 
 private:
@@ -0,0 +1,190 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "FragmentIndex"
+#include <utils/Log.h>
+
+#include <algorithm>
+
+#include "FragmentIndex.h"
+
+#include <media/MediaExtractorPluginHelper.h>
+#include <media/stagefright/foundation/ByteUtils.h>
+
+namespace android {
+
+// Returns the box at |*offset| in |data| and advances |*offset| past it.
+static bool nextBox(
+        const uint8_t *data, size_t size, size_t *offset, uint32_t *type,
+        const uint8_t **payload, size_t *payloadSize) {
+    if (*offset > size || size - *offset < 8) {
+        return false;
+    }
+    const uint8_t *box = data + *offset;
+    size_t available = size - *offset;
+    uint64_t boxSize = U32_AT(box);
+    size_t headerSize = 8;
+    if (boxSize == 1) {
+        if (available < 16) {
+            return false;
+        }
+        boxSize = U64_AT(box + 8);
+        headerSize = 16;
+    } else if (boxSize == 0) {
+        boxSize = available;
+    }
+    if (boxSize < headerSize || boxSize > available) {
+        return false;
+    }
+
+    *type = U32_AT(box + 4);
+    *payload = box + headerSize;
+    *payloadSize = boxSize - headerSize;
+    *offset += boxSize;
+    return true;
+}
+
+FragmentIndex::FragmentIndex(DataSourceHelper *source, off64_t firstMoofOffset)
+    : mDataSource(source),
+      mFirstMoofOffset(firstMoofOffset),
+      mScanned(false),
+      mNumFragments(0) {
+}
+
+FragmentIndex::~FragmentIndex() {
+}
+
+status_t FragmentIndex::findFragment(
+        uint32_t trackId, uint64_t time, Fragment *fragment, Fragment *next, bool *hasNext) {
+    Mutex::Autolock autoLock(mLock);
+
+    if (!mScanned) {
+        scan_l();
+        mScanned = true;
+    }
+
+    auto it = mFragments.find(trackId);
+    if (it == mFragments.end() || it->second.empty()) {
+        return NAME_NOT_FOUND;
+    }
+    const std::vector<Fragment> &fragments = it->second;
+
+    auto after = std::upper_bound(
+            fragments.begin(), fragments.end(), time,
+            [](uint64_t t, const Fragment &f) { return t < f.mBaseMediaDecodeTime; });
+    auto found = after == fragments.begin() ? after : after - 1;
+
+    *fragment = *found;
+    *hasNext = found + 1 != fragments.end();
+    if (*hasNext) {
+        *next = *(found + 1);
+    }
+    return OK;
+}
+
+void FragmentIndex::scan_l() {
+    off64_t offset = mFirstMoofOffset;
+    std::vector<uint8_t> moof;
+
+    while (mNumFragments < kMaxFragments) {
+        uint32_t size32, type;
+        if (!mDataSource->getUInt32(offset, &size32)
+                || !mDataSource->getUInt32(offset + 4, &type)) {
+            break;
+        }
+        uint64_t size = size32;
+        size_t headerSize = 8;
+        if (size == 1) {
+            if (!mDataSource->getUInt64(offset + 8, &size)) {
+                break;
+            }
+            headerSize = 16;
+        }
+        if (size == 0 || size < headerSize || offset > INT64_MAX - (off64_t)size) {
+            // A box extending to the end of the file is the last one.
+            break;
+        }
+
+        if (type == FOURCC("moof") && size - headerSize <= kMaxMoofSize) {
+            size_t payloadSize = size - headerSize;
+            moof.resize(payloadSize);
+            if (mDataSource->readAt(offset + headerSize, moof.data(), payloadSize)
+                    < (ssize_t)payloadSize) {
+                break;
+            }
+            addMoof_l(offset, moof.data(), payloadSize);
+        }
+        offset += size;
+    }
+
+    ALOGV("indexed %zu fragments of %zu tracks", mNumFragments, mFragments.size());
+}
+
+void FragmentIndex::addMoof_l(off64_t moofOffset, const uint8_t *data, size_t size) {
+    size_t offset = 0;
+    uint32_t type;
+    const uint8_t *payload;
+    size_t payloadSize;
+    while (nextBox(data, size, &offset, &type, &payload, &payloadSize)) {
+        if (type == FOURCC("traf")) {
+            addTrackFragment_l(moofOffset, payload, payloadSize);
+        }
+    }
+}
+
+void FragmentIndex::addTrackFragment_l(off64_t moofOffset, const uint8_t *data, size_t size) {
+    bool hasTrackId = false;
+    bool hasDecodeTime = false;
+    uint32_t trackId = 0;
+    uint64_t decodeTime = 0;
+
+    size_t offset = 0;
+    uint32_t type;
+    const uint8_t *payload;
+    size_t payloadSize;
+    while (nextBox(data, size, &offset, &type, &payload, &payloadSize)) {
+        if (type == FOURCC("tfhd") && payloadSize >= 8) {
+            trackId = U32_AT(payload + 4);
+            hasTrackId = true;
+        } else if (type == FOURCC("tfdt") && payloadSize >= 8) {
+            if (payload[0] == 1) {
+                if (payloadSize < 12) {
+                    continue;
+                }
+                decodeTime = U64_AT(payload + 4);
+            } else {
+                decodeTime = U32_AT(payload + 4);
+            }
+            hasDecodeTime = true;
+        }
+    }
+
+    if (!hasTrackId || !hasDecodeTime) {
+        return;
+    }
+
+    std::vector<Fragment> &fragments = mFragments[trackId];
+    if (!fragments.empty() && decodeTime < fragments.back().mBaseMediaDecodeTime) {
+        ALOGW("track %u: fragment decode time %llu is out of order, not indexed", trackId,
+                (unsigned long long)decodeTime);
+        return;
+    }
+    fragments.push_back({decodeTime, moofOffset});
+    ++mNumFragments;
+}
+
+}  // namespace android
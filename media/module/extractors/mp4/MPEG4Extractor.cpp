@@ -30,6 +30,7 @@
 #include <utils/Log.h>
 
 #include "AC4Parser.h"
+#include "FragmentIndex.h"
 #include "MPEG4Extractor.h"
 #include "SampleTable.h"
 #include "ItemTable.h"
@@ -85,6 +86,7 @@ enum {
 
 class MPEG4Source : public MediaTrackHelper {
 static const size_t  kMaxPcmFrameSize = 8192;
+static const size_t  kMaxReadAheadSize = 256 * 1024;
 public:
     // Caller retains ownership of both "dataSource" and "sampleTable".
     MPEG4Source(AMediaFormat *format,
@@ -94,6 +96,7 @@ public:
                 Vector<SidxEntry> &sidx,
                 const Trex *trex,
                 off64_t firstMoofOffset,
+                const sp<FragmentIndex> &fragmentIndex,
                 const sp<ItemTable> &itemTable,
                 uint64_t elstShiftStartTicks,
                 uint64_t elstInitialEmptyEditTicks);
@@ -123,6 +126,7 @@ private:
     Vector<SidxEntry> &mSegments;
     const Trex *mTrex;
     off64_t mFirstMoofOffset;
+    sp<FragmentIndex> mFragmentIndex;
     off64_t mCurrentMoofOffset;
     off64_t mCurrentMoofSize;
     off64_t mNextMoofOffset;
@@ -160,6 +164,11 @@ private:
     size_t mSrcBufferSize;
     uint8_t *mSrcBuffer;
 
+    // Samples following the current one in the same chunk, read ahead by readSampleData().
+    uint8_t *mReadAheadBuffer;
+    off64_t mReadAheadOffset;
+    size_t mReadAheadSize;
+
     bool mIsHeif;
     bool mIsAvif;
     bool mIsAudio;
@@ -176,6 +185,7 @@ private:
     uint64_t mElstInitialEmptyEditTicks;
 
     size_t parseNALSize(const uint8_t *data) const;
+    ssize_t readSampleData(off64_t offset, void *data, size_t size);
     status_t parseChunk(off64_t *offset);
     status_t parseTrackFragmentHeader(off64_t offset, off64_t size);
     status_t parseTrackFragmentRun(off64_t offset, off64_t size);
@@ -3727,6 +3737,14 @@ status_t MPEG4Extractor::parseSegmentIndex(off64_t offset, size_t size) {
         return -EINVAL;
     }
 
+    int64_t startUs = 0;
+    uint64_t startOffset = 0;
+    if (mSidxEntries.size() > 0) {
+        const SidxEntry &last = mSidxEntries[mSidxEntries.size() - 1];
+        startUs = last.mStartUs + last.mDurationUs;
+        startOffset = last.mStartOffset + last.mSize;
+    }
+
     uint64_t total_duration = 0;
     for (unsigned int i = 0; i < referenceCount; i++) {
         uint32_t d1, d2, d3;
@@ -3752,6 +3770,10 @@ status_t MPEG4Extractor::parseSegmentIndex(off64_t offset, size_t size) {
         SidxEntry se;
         se.mSize = d1 & 0x7fffffff;
         se.mDurationUs = 1000000LL * d2 / timeScale;
+        se.mStartUs = startUs;
+        se.mStartOffset = startOffset;
+        startUs += se.mDurationUs;
+        startOffset += se.mSize;
         mSidxEntries.add(se);
     }
 
@@ -4578,9 +4600,13 @@ MediaTrackHelper *MPEG4Extractor::getTrack(size_t index) {
     ALOGV("elst_initial_empty_edit_ticks in MediaTimeScale :%" PRIu64,
           elst_initial_empty_edit_ticks);
 
+    if (mMoofOffset > 0 && mSidxEntries.size() == 0 && mFragmentIndex == NULL) {
+        mFragmentIndex = new FragmentIndex(mDataSource, mMoofOffset);
+    }
+
     MPEG4Source* source =
             new MPEG4Source(track->meta, mDataSource, track->timescale, track->sampleTable,
-                            mSidxEntries, trex, mMoofOffset, itemTable,
+                            mSidxEntries, trex, mMoofOffset, mFragmentIndex, itemTable,
                             track->elst_shift_start_ticks, elst_initial_empty_edit_ticks);
     if (source->init() != OK) {
         delete source;
@@ -5083,6 +5109,7 @@ MPEG4Source::MPEG4Source(
         Vector<SidxEntry> &sidx,
         const Trex *trex,
         off64_t firstMoofOffset,
+        const sp<FragmentIndex> &fragmentIndex,
         const sp<ItemTable> &itemTable,
         uint64_t elstShiftStartTicks,
         uint64_t elstInitialEmptyEditTicks)
@@ -5095,6 +5122,7 @@ MPEG4Source::MPEG4Source(
       mSegments(sidx),
       mTrex(trex),
       mFirstMoofOffset(firstMoofOffset),
+      mFragmentIndex(fragmentIndex),
       mCurrentMoofOffset(firstMoofOffset),
       mCurrentMoofSize(0),
       mNextMoofOffset(-1),
@@ -5115,6 +5143,9 @@ MPEG4Source::MPEG4Source(
       mBuffer(NULL),
       mSrcBufferSize(0),
       mSrcBuffer(NULL),
+      mReadAheadBuffer(NULL),
+      mReadAheadOffset(0),
+      mReadAheadSize(0),
       mItemTable(itemTable),
       mElstShiftStartTicks(elstShiftStartTicks),
       mElstInitialEmptyEditTicks(elstInitialEmptyEditTicks) {
@@ -5316,6 +5347,10 @@ media_status_t MPEG4Source::stop() {
     delete[] mSrcBuffer;
     mSrcBuffer = NULL;
 
+    delete[] mReadAheadBuffer;
+    mReadAheadBuffer = NULL;
+    mReadAheadSize = 0;
+
     mStarted = false;
     mCurrentSampleIndex = 0;
 
@@ -6136,6 +6171,42 @@ int32_t MPEG4Source::parseHEVCLayerId(const uint8_t *data, size_t size) {
     return 0;
 }
 
+// Reads the sample at |offset|. Rather than issuing one read per sample, the samples up to
+// the end of the current chunk are read in one go and the following samples of the chunk
+// are served from that block. Must be called after getMetaDataForSample() for the sample.
+ssize_t MPEG4Source::readSampleData(off64_t offset, void *data, size_t size) {
+    if (mReadAheadSize > 0 && isInRange(mReadAheadOffset, mReadAheadSize, offset, size)) {
+        memcpy(data, mReadAheadBuffer + (offset - mReadAheadOffset), size);
+        return size;
+    }
+
+    off64_t chunkEndOffset = mSampleTable != NULL ? mSampleTable->getChunkEndOffset() : 0;
+    if (size >= kMaxReadAheadSize / 2 || offset < 0 || chunkEndOffset <= offset
+            || chunkEndOffset - offset <= (off64_t)size) {
+        // Large samples and the last sample of a chunk gain nothing from reading ahead.
+        return mDataSource->readAt(offset, data, size);
+    }
+
+    if (mReadAheadBuffer == NULL) {
+        mReadAheadBuffer = new (std::nothrow) uint8_t[kMaxReadAheadSize];
+        if (mReadAheadBuffer == NULL) {
+            return mDataSource->readAt(offset, data, size);
+        }
+    }
+
+    size_t readAheadSize = std::min((off64_t)kMaxReadAheadSize, chunkEndOffset - offset);
+    ssize_t numBytesRead = mDataSource->readAt(offset, mReadAheadBuffer, readAheadSize);
+    if (numBytesRead < (ssize_t)size) {
+        mReadAheadSize = 0;
+        return numBytesRead < 0 ? numBytesRead : mDataSource->readAt(offset, data, size);
+    }
+    mReadAheadOffset = offset;
+    mReadAheadSize = numBytesRead;
+
+    memcpy(data, mReadAheadBuffer, size);
+    return size;
+}
+
 media_status_t MPEG4Source::read(
         MediaBufferHelper **out, const ReadOptions *options) {
     Mutex::Autolock autoLock(mLock);
@@ -6406,7 +6477,7 @@ media_status_t MPEG4Source::read(
                 mBuffer->set_range(0, totalSize);
             } else {
                 ssize_t num_bytes_read =
-                    mDataSource->readAt(offset, (uint8_t *)mBuffer->data(), size);
+                    readSampleData(offset, (uint8_t *)mBuffer->data(), size);
 
                 if (num_bytes_read < (ssize_t)size) {
                     mBuffer->release();
@@ -6476,7 +6547,7 @@ media_status_t MPEG4Source::read(
         dstData[dstOffset++] = (uint8_t)((size >> 8) & 0xFF);
         dstData[dstOffset++] = (uint8_t)((size >> 0) & 0xFF);
 
-        ssize_t numBytesRead = mDataSource->readAt(offset, dstData + dstOffset, size);
+        ssize_t numBytesRead = readSampleData(offset, dstData + dstOffset, size);
         if (numBytesRead != (ssize_t)size) {
             mBuffer->release();
             mBuffer = NULL;
@@ -6510,63 +6581,106 @@ media_status_t MPEG4Source::read(
     } else {
         // Whole NAL units are returned but each fragment is prefixed by
         // the start code (0x00 00 00 01).
-        ssize_t num_bytes_read = 0;
-        bool mSrcBufferFitsDataToRead = size <= mSrcBufferSize;
-        if (mSrcBufferFitsDataToRead) {
-          num_bytes_read = mDataSource->readAt(offset, mSrcBuffer, size);
-        } else {
-          // We are trying to read a sample larger than the expected max sample size.
-          // Fall through and let the failure be handled by the following if.
-          android_errorWriteLog(0x534e4554, "188893559");
-        }
-
-        if (num_bytes_read < (ssize_t)size) {
-            mBuffer->release();
-            mBuffer = NULL;
-            return mSrcBufferFitsDataToRead ? AMEDIA_ERROR_IO : AMEDIA_ERROR_MALFORMED;
-        }
-
         uint8_t *dstData = (uint8_t *)mBuffer->data();
         size_t srcOffset = 0;
         size_t dstOffset = 0;
 
-        while (srcOffset < size) {
-            bool isMalFormed = !isInRange((size_t)0u, size, srcOffset, mNALLengthSize);
-            size_t nalLength = 0;
-            if (!isMalFormed) {
-                nalLength = parseNALSize(&mSrcBuffer[srcOffset]);
-                srcOffset += mNALLengthSize;
-                isMalFormed = !isInRange((size_t)0u, size, srcOffset, nalLength);
+        if (mNALLengthSize == 4) {
+            // The start codes take the place of the NAL lengths, so the sample is read
+            // straight into the output buffer and converted in place.
+            ssize_t num_bytes_read = readSampleData(offset, dstData, size);
+            if (num_bytes_read < (ssize_t)size) {
+                mBuffer->release();
+                mBuffer = NULL;
+                return AMEDIA_ERROR_IO;
             }
 
-            if (isMalFormed) {
-                //if nallength abnormal,ignore it.
-                ALOGW("abnormal nallength, ignore this NAL");
-                srcOffset = size;
-                break;
-            }
+            while (srcOffset < size) {
+                size_t nalLength = 0;
+                bool isMalFormed = !isInRange((size_t)0u, size, srcOffset, (size_t)4u);
+                if (!isMalFormed) {
+                    nalLength = parseNALSize(&dstData[srcOffset]);
+                    srcOffset += 4;
+                    isMalFormed = !isInRange((size_t)0u, size, srcOffset, nalLength);
+                }
 
-            if (nalLength == 0) {
-                continue;
+                if (isMalFormed) {
+                    //if nallength abnormal,ignore it.
+                    ALOGW("abnormal nallength, ignore this NAL");
+                    srcOffset = size;
+                    break;
+                }
+
+                if (nalLength == 0) {
+                    continue;
+                }
+
+                // Empty NAL units are dropped, so the output may trail the input.
+                if (dstOffset + 4 != srcOffset) {
+                    memmove(&dstData[dstOffset + 4], &dstData[srcOffset], nalLength);
+                }
+                dstData[dstOffset++] = 0;
+                dstData[dstOffset++] = 0;
+                dstData[dstOffset++] = 0;
+                dstData[dstOffset++] = 1;
+                srcOffset += nalLength;
+                dstOffset += nalLength;
+            }
+        } else {
+            ssize_t num_bytes_read = 0;
+            bool mSrcBufferFitsDataToRead = size <= mSrcBufferSize;
+            if (mSrcBufferFitsDataToRead) {
+              num_bytes_read = readSampleData(offset, mSrcBuffer, size);
+            } else {
+              // We are trying to read a sample larger than the expected max sample size.
+              // Fall through and let the failure be handled by the following if.
+              android_errorWriteLog(0x534e4554, "188893559");
             }
 
-            if (dstOffset > SIZE_MAX - 4 ||
-                    dstOffset + 4 > SIZE_MAX - nalLength ||
-                    dstOffset + 4 + nalLength > mBuffer->size()) {
-                ALOGE("b/27208621 : %zu %zu", dstOffset, mBuffer->size());
-                android_errorWriteLog(0x534e4554, "27208621");
+            if (num_bytes_read < (ssize_t)size) {
                 mBuffer->release();
                 mBuffer = NULL;
-                return AMEDIA_ERROR_MALFORMED;
+                return mSrcBufferFitsDataToRead ? AMEDIA_ERROR_IO : AMEDIA_ERROR_MALFORMED;
             }
 
-            dstData[dstOffset++] = 0;
-            dstData[dstOffset++] = 0;
-            dstData[dstOffset++] = 0;
-            dstData[dstOffset++] = 1;
-            memcpy(&dstData[dstOffset], &mSrcBuffer[srcOffset], nalLength);
-            srcOffset += nalLength;
-            dstOffset += nalLength;
+            while (srcOffset < size) {
+                bool isMalFormed = !isInRange((size_t)0u, size, srcOffset, mNALLengthSize);
+                size_t nalLength = 0;
+                if (!isMalFormed) {
+                    nalLength = parseNALSize(&mSrcBuffer[srcOffset]);
+                    srcOffset += mNALLengthSize;
+                    isMalFormed = !isInRange((size_t)0u, size, srcOffset, nalLength);
+                }
+
+                if (isMalFormed) {
+                    //if nallength abnormal,ignore it.
+                    ALOGW("abnormal nallength, ignore this NAL");
+                    srcOffset = size;
+                    break;
+                }
+
+                if (nalLength == 0) {
+                    continue;
+                }
+
+                if (dstOffset > SIZE_MAX - 4 ||
+                        dstOffset + 4 > SIZE_MAX - nalLength ||
+                        dstOffset + 4 + nalLength > mBuffer->size()) {
+                    ALOGE("b/27208621 : %zu %zu", dstOffset, mBuffer->size());
+                    android_errorWriteLog(0x534e4554, "27208621");
+                    mBuffer->release();
+                    mBuffer = NULL;
+                    return AMEDIA_ERROR_MALFORMED;
+                }
+
+                dstData[dstOffset++] = 0;
+                dstData[dstOffset++] = 0;
+                dstData[dstOffset++] = 0;
+                dstData[dstOffset++] = 1;
+                memcpy(&dstData[dstOffset], &mSrcBuffer[srcOffset], nalLength);
+                srcOffset += nalLength;
+                dstOffset += nalLength;
+            }
         }
         CHECK_EQ(srcOffset, size);
         CHECK(mBuffer != NULL);
@@ -6653,25 +6767,36 @@ media_status_t MPEG4Source::fragmentedRead(
               elstShiftStartUs);
 
         int numSidxEntries = mSegments.size();
+        uint64_t seekTime = seekTimeUs > 0 ? seekTimeUs * mTimescale / 1000000ll : 0;
+        FragmentIndex::Fragment fragment, nextFragment;
+        bool hasNextFragment = false;
         if (numSidxEntries != 0) {
-            int64_t totalTime = 0;
+            // Find the segment containing the requested time, i.e. the first one ending
+            // after it. Past the last segment, seek to the end.
+            const SidxEntry *begin = mSegments.array();
+            const SidxEntry *se = std::upper_bound(
+                    begin, begin + numSidxEntries, seekTimeUs,
+                    [](int64_t timeUs, const SidxEntry &e) {
+                        return timeUs < e.mStartUs + e.mDurationUs;
+                    });
+            int64_t totalTime;
             off64_t totalOffset = mFirstMoofOffset;
-            for (int i = 0; i < numSidxEntries; i++) {
-                const SidxEntry *se = &mSegments[i];
-                if (totalTime + se->mDurationUs > seekTimeUs) {
-                    // The requested time is somewhere in this segment
-                    if ((mode == ReadOptions::SEEK_NEXT_SYNC && seekTimeUs > totalTime) ||
-                        (mode == ReadOptions::SEEK_CLOSEST_SYNC &&
-                        (seekTimeUs - totalTime) > (totalTime + se->mDurationUs - seekTimeUs))) {
-                        // requested next sync, or closest sync and it was closer to the end of
-                        // this segment
-                        totalTime += se->mDurationUs;
-                        totalOffset += se->mSize;
-                    }
-                    break;
+            if (se == begin + numSidxEntries) {
+                const SidxEntry &last = begin[numSidxEntries - 1];
+                totalTime = last.mStartUs + last.mDurationUs;
+                totalOffset += last.mStartOffset + last.mSize;
+            } else {
+                totalTime = se->mStartUs;
+                totalOffset += se->mStartOffset;
+                // The requested time is somewhere in this segment
+                if ((mode == ReadOptions::SEEK_NEXT_SYNC && seekTimeUs > totalTime) ||
+                    (mode == ReadOptions::SEEK_CLOSEST_SYNC &&
+                    (seekTimeUs - totalTime) > (totalTime + se->mDurationUs - seekTimeUs))) {
+                    // requested next sync, or closest sync and it was closer to the end of
+                    // this segment
+                    totalTime += se->mDurationUs;
+                    totalOffset += se->mSize;
                 }
-                totalTime += se->mDurationUs;
-                totalOffset += se->mSize;
             }
             mCurrentMoofOffset = totalOffset;
             mNextMoofOffset = -1;
@@ -6682,8 +6807,28 @@ media_status_t MPEG4Source::fragmentedRead(
                 return AMEDIA_ERROR_UNKNOWN;
             }
             mCurrentTime = totalTime * mTimescale / 1000000ll;
+        } else if (mFragmentIndex != NULL && seekTimeUs > 0 && mFragmentIndex->findFragment(
+                mTrackId, seekTime, &fragment, &nextFragment, &hasNextFragment) == OK) {
+            // Fragments are assumed to start with a sync sample, as with sidx.
+            if (hasNextFragment && seekTime > fragment.mBaseMediaDecodeTime &&
+                    (mode == ReadOptions::SEEK_NEXT_SYNC ||
+                    (mode == ReadOptions::SEEK_CLOSEST_SYNC &&
+                    seekTime - fragment.mBaseMediaDecodeTime >
+                            nextFragment.mBaseMediaDecodeTime - seekTime))) {
+                fragment = nextFragment;
+            }
+            mCurrentMoofOffset = fragment.mMoofOffset;
+            mNextMoofOffset = -1;
+            mCurrentSamples.clear();
+            mCurrentSampleIndex = 0;
+            off64_t tmp = mCurrentMoofOffset;
+            status_t err = parseChunk(&tmp);
+            if (err != OK) {
+                return AMEDIA_ERROR_UNKNOWN;
+            }
+            mCurrentTime = fragment.mBaseMediaDecodeTime;
         } else {
-            // without sidx boxes, we can only seek to 0
+            // without sidx boxes or decode times, we can only seek to 0
             mCurrentMoofOffset = mFirstMoofOffset;
             mNextMoofOffset = -1;
             mCurrentSamples.clear();
@@ -22,6 +22,8 @@
 
 #include <arpa/inet.h>
 
+#include <algorithm>
+
 #include <media/stagefright/foundation/ADebug.h>
 #include <media/stagefright/foundation/ByteUtils.h>
 
@@ -32,6 +34,7 @@ namespace android {
 SampleIterator::SampleIterator(SampleTable *table)
     : mTable(table),
       mInitialized(false),
+      mCurrentChunkEndOffset(0),
       mTimeToSampleIndex(0),
       mTTSSampleIndex(0),
       mTTSSampleTime(0),
@@ -124,6 +127,11 @@ status_t SampleIterator::seekTo(uint32_t sampleIndex) {
             mCurrentChunkSampleSizes.push(sampleSize);
         }
 
+        mCurrentChunkEndOffset = mCurrentChunkOffset;
+        for (size_t i = 0; i < mCurrentChunkSampleSizes.size(); ++i) {
+            mCurrentChunkEndOffset += mCurrentChunkSampleSizes[i];
+        }
+
         mCurrentChunkIndex = chunk;
     }
 
@@ -199,6 +207,33 @@ status_t SampleIterator::findChunkRange(uint32_t sampleIndex) {
     return OK;
 }
 
+const uint8_t *SampleIterator::readTableEntry(
+        TableCache *cache, off64_t tableOffset, size_t tableSize, size_t entryOffset,
+        size_t entrySize) {
+    if (entryOffset > tableSize || entrySize > tableSize - entryOffset) {
+        return NULL;
+    }
+
+    off64_t offset = tableOffset + entryOffset;
+    if (cache->mOffset < 0 || offset < cache->mOffset
+            || offset + (off64_t)entrySize > cache->mOffset + (off64_t)cache->mSize) {
+        // Entries are at most 8 bytes and aligned to their size, so they do not straddle
+        // blocks.
+        size_t blockOffset = entryOffset - entryOffset % kTableCacheSize;
+        size_t size = std::min(kTableCacheSize, tableSize - blockOffset);
+        ssize_t n = mTable->mDataSource->readAt(tableOffset + blockOffset, cache->mData, size);
+        if (n < (ssize_t)(entryOffset - blockOffset + entrySize)) {
+            cache->mOffset = -1;
+            cache->mSize = 0;
+            return NULL;
+        }
+        cache->mOffset = tableOffset + blockOffset;
+        cache->mSize = n;
+    }
+
+    return &cache->mData[offset - cache->mOffset];
+}
+
 status_t SampleIterator::getChunkOffset(uint32_t chunk, off64_t *offset) {
     *offset = 0;
 
@@ -207,28 +242,25 @@ status_t SampleIterator::getChunkOffset(uint32_t chunk, off64_t *offset) {
     }
 
     if (mTable->mChunkOffsetType == SampleTable::kChunkOffsetType32) {
-        uint32_t offset32;
-
-        if (mTable->mDataSource->readAt(
-                    mTable->mChunkOffsetOffset + 8 + 4 * chunk,
-                    &offset32,
-                    sizeof(offset32)) < (ssize_t)sizeof(offset32)) {
+        const uint8_t *entry = readTableEntry(
+                &mChunkOffsetCache, mTable->mChunkOffsetOffset + 8,
+                (size_t)mTable->mNumChunkOffsets * 4, (size_t)chunk * 4, 4);
+        if (entry == NULL) {
             return ERROR_IO;
         }
 
-        *offset = ntohl(offset32);
+        *offset = U32_AT(entry);
     } else {
         CHECK_EQ(mTable->mChunkOffsetType, SampleTable::kChunkOffsetType64);
 
-        uint64_t offset64;
-        if (mTable->mDataSource->readAt(
-                    mTable->mChunkOffsetOffset + 8 + 8 * chunk,
-                    &offset64,
-                    sizeof(offset64)) < (ssize_t)sizeof(offset64)) {
+        const uint8_t *entry = readTableEntry(
+                &mChunkOffsetCache, mTable->mChunkOffsetOffset + 8,
+                (size_t)mTable->mNumChunkOffsets * 8, (size_t)chunk * 8, 8);
+        if (entry == NULL) {
             return ERROR_IO;
         }
 
-        *offset = ntoh64(offset64);
+        *offset = U64_AT(entry);
     }
 
     return OK;
@@ -247,43 +279,44 @@ status_t SampleIterator::getSampleSizeDirect(
         return OK;
     }
 
+    const off64_t tableOffset = mTable->mSampleSizeOffset + 12;
+    const size_t numSampleSizes = mTable->mNumSampleSizes;
+    const uint8_t *entry;
+
     switch (mTable->mSampleSizeFieldSize) {
         case 32:
         {
-            uint32_t x;
-            if (mTable->mDataSource->readAt(
-                        mTable->mSampleSizeOffset + 12 + 4 * sampleIndex,
-                        &x, sizeof(x)) < (ssize_t)sizeof(x)) {
+            entry = readTableEntry(&mSampleSizeCache, tableOffset,
+                    numSampleSizes * 4, (size_t)sampleIndex * 4, 4);
+            if (entry == NULL) {
                 return ERROR_IO;
             }
 
-            *size = ntohl(x);
+            *size = U32_AT(entry);
             break;
         }
 
         case 16:
         {
-            uint16_t x;
-            if (mTable->mDataSource->readAt(
-                        mTable->mSampleSizeOffset + 12 + 2 * sampleIndex,
-                        &x, sizeof(x)) < (ssize_t)sizeof(x)) {
+            entry = readTableEntry(&mSampleSizeCache, tableOffset,
+                    numSampleSizes * 2, (size_t)sampleIndex * 2, 2);
+            if (entry == NULL) {
                 return ERROR_IO;
             }
 
-            *size = ntohs(x);
+            *size = U16_AT(entry);
             break;
         }
 
         case 8:
         {
-            uint8_t x;
-            if (mTable->mDataSource->readAt(
-                        mTable->mSampleSizeOffset + 12 + sampleIndex,
-                        &x, sizeof(x)) < (ssize_t)sizeof(x)) {
+            entry = readTableEntry(&mSampleSizeCache, tableOffset,
+                    numSampleSizes, sampleIndex, 1);
+            if (entry == NULL) {
                 return ERROR_IO;
             }
 
-            *size = x;
+            *size = *entry;
             break;
         }
 
@@ -291,14 +324,13 @@ status_t SampleIterator::getSampleSizeDirect(
         {
             CHECK_EQ(mTable->mSampleSizeFieldSize, 4u);
 
-            uint8_t x;
-            if (mTable->mDataSource->readAt(
-                        mTable->mSampleSizeOffset + 12 + sampleIndex / 2,
-                        &x, sizeof(x)) < (ssize_t)sizeof(x)) {
+            entry = readTableEntry(&mSampleSizeCache, tableOffset,
+                    (numSampleSizes + 1) / 2, sampleIndex / 2, 1);
+            if (entry == NULL) {
                 return ERROR_IO;
             }
 
-            *size = (sampleIndex & 1) ? x & 0x0f : x >> 4;
+            *size = (sampleIndex & 1) ? *entry & 0x0f : *entry >> 4;
             break;
         }
     }
@@ -18,6 +18,7 @@
 //#define LOG_NDEBUG 0
 #include <utils/Log.h>
 
+#include <algorithm>
 #include <limits>
 
 #include "SampleTable.h"
@@ -129,6 +130,8 @@ SampleTable::SampleTable(DataSourceHelper *source)
       mTimeToSampleCount(0),
       mTimeToSample(NULL),
       mSampleTimeEntries(NULL),
+      mTimeToSampleRuns(NULL),
+      mNumTimeToSampleRuns(0),
       mCompositionTimeDeltaEntries(NULL),
       mNumCompositionTimeDeltaEntries(0),
       mCompositionDeltaLookup(new CompositionDeltaLookup),
@@ -160,6 +163,9 @@ SampleTable::~SampleTable() {
     delete[] mSampleTimeEntries;
     mSampleTimeEntries = NULL;
 
+    delete[] mTimeToSampleRuns;
+    mTimeToSampleRuns = NULL;
+
     delete mSampleIterator;
     mSampleIterator = NULL;
 }
@@ -632,13 +638,17 @@ int SampleTable::CompareIncreasingTime(const void *_a, const void *_b) {
 void SampleTable::buildSampleEntriesTable() {
     Mutex::Autolock autoLock(mLock);
 
-    if (mSampleTimeEntries != NULL || mNumSampleSizes == 0) {
+    if (hasSampleTimeIndex() || mNumSampleSizes == 0) {
         if (mNumSampleSizes == 0) {
             ALOGE("b/23247055, mNumSampleSizes(%u)", mNumSampleSizes);
         }
         return;
     }
 
+    if (mCompositionTimeDeltaEntries == NULL && buildTimeToSampleRuns()) {
+        return;
+    }
+
     mTotalSize += (uint64_t)mNumSampleSizes * sizeof(SampleTimeEntry);
     if (mTotalSize > kMaxTotalSize) {
         ALOGE("Sample entry table size would make sample table too large.\n"
@@ -714,12 +724,86 @@ void SampleTable::buildSampleEntriesTable() {
           CompareIncreasingTime);
 }
 
+bool SampleTable::buildTimeToSampleRuns() {
+    uint64_t numRuns = 0;
+    uint64_t numSamples = 0;
+    for (uint32_t i = 0; i < mTimeToSampleCount && numSamples < mNumSampleSizes; ++i) {
+        if (mTimeToSample[2 * i] > 0) {
+            ++numRuns;
+            numSamples += mTimeToSample[2 * i];
+        }
+    }
+    if (numSamples < mNumSampleSizes) {
+        // The samples past the time-to-sample table have time 0, so they are not in
+        // increasing composition time order.
+        return false;
+    }
+
+    uint64_t allocSize = numRuns * sizeof(TimeToSampleRun);
+    if (mTotalSize + allocSize > kMaxTotalSize) {
+        return false;
+    }
+    mTimeToSampleRuns = new (std::nothrow) TimeToSampleRun[numRuns];
+    if (!mTimeToSampleRuns) {
+        return false;
+    }
+    mTotalSize += allocSize;
+    mNumTimeToSampleRuns = numRuns;
+
+    uint32_t run = 0;
+    uint64_t sampleIndex = 0;
+    uint64_t sampleTime = 0;
+    for (uint32_t i = 0; run < mNumTimeToSampleRuns; ++i) {
+        uint32_t n = mTimeToSample[2 * i];
+        uint32_t delta = mTimeToSample[2 * i + 1];
+        if (n == 0) {
+            continue;
+        }
+
+        mTimeToSampleRuns[run].mFirstSampleIndex = sampleIndex;
+        mTimeToSampleRuns[run].mDelta = delta;
+        mTimeToSampleRuns[run].mFirstSampleTime = sampleTime;
+        ++run;
+
+        sampleIndex += n;
+        uint64_t duration;
+        if (__builtin_mul_overflow((uint64_t)n, delta, &duration)
+                || __builtin_add_overflow(sampleTime, duration, &sampleTime)) {
+            ALOGE("time-to-sample run %u would overflow, clamping", i);
+            sampleTime = UINT64_MAX;
+        }
+    }
+
+    return true;
+}
+
+uint64_t SampleTable::getCompositionTimeAt(uint32_t position) const {
+    if (mSampleTimeEntries != NULL) {
+        return mSampleTimeEntries[position].mCompositionTime;
+    }
+
+    // The first run starts at sample 0.
+    const TimeToSampleRun *run = std::upper_bound(
+            mTimeToSampleRuns, mTimeToSampleRuns + mNumTimeToSampleRuns, position,
+            [](uint32_t index, const TimeToSampleRun &r) {
+                return index < r.mFirstSampleIndex;
+            }) - 1;
+
+    uint64_t time;
+    if (__builtin_mul_overflow(
+                (uint64_t)(position - run->mFirstSampleIndex), run->mDelta, &time)
+            || __builtin_add_overflow(run->mFirstSampleTime, time, &time)) {
+        return UINT64_MAX;
+    }
+    return time;
+}
+
 status_t SampleTable::findSampleAtTime(
         uint64_t req_time, uint64_t scale_num, uint64_t scale_den,
         uint32_t *sample_index, uint32_t flags) {
     buildSampleEntriesTable();
 
-    if (mSampleTimeEntries == NULL) {
+    if (!hasSampleTimeIndex()) {
         return ERROR_OUT_OF_RANGE;
     }
 
@@ -727,7 +811,7 @@ status_t SampleTable::findSampleAtTime(
         if (req_time >= mNumSampleSizes) {
             return ERROR_OUT_OF_RANGE;
         }
-        *sample_index = mSampleTimeEntries[req_time].mSampleIndex;
+        *sample_index = getSampleIndexAt(req_time);
         return OK;
     }
 
@@ -743,7 +827,7 @@ status_t SampleTable::findSampleAtTime(
         } else if (req_time > centerTime) {
             left = center + 1;
         } else {
-            *sample_index = mSampleTimeEntries[center].mSampleIndex;
+            *sample_index = getSampleIndexAt(center);
             return OK;
         }
     }
@@ -792,7 +876,7 @@ status_t SampleTable::findSampleAtTime(
         }
     }
 
-    *sample_index = mSampleTimeEntries[closestIndex].mSampleIndex;
+    *sample_index = getSampleIndexAt(closestIndex);
     return OK;
 }
 
@@ -950,6 +1034,11 @@ uint32_t SampleTable::getLastSampleIndexInChunk() {
     return mSampleIterator->getLastSampleIndexInChunk();
 }
 
+off64_t SampleTable::getChunkEndOffset() {
+    Mutex::Autolock autoLock(mLock);
+    return mSampleIterator->getChunkEndOffset();
+}
+
 status_t SampleTable::getMetaDataForSample(
         uint32_t sampleIndex,
         off64_t *offset,
@@ -0,0 +1,83 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FRAGMENT_INDEX_H_
+
+#define FRAGMENT_INDEX_H_
+
+#include <sys/types.h>
+#include <stdint.h>
+
+#include <map>
+#include <vector>
+
+#include <utils/Errors.h>
+#include <utils/RefBase.h>
+#include <utils/threads.h>
+
+namespace android {
+
+class DataSourceHelper;
+
+// Maps the decode time of each track in each movie fragment to the offset of the
+// fragment's moof box, for fragmented files without sidx boxes. The file is scanned the
+// first time a track seeks, and the index is shared by all tracks of the file.
+class FragmentIndex : public RefBase {
+public:
+    // Caller retains ownership of "source".
+    FragmentIndex(DataSourceHelper *source, off64_t firstMoofOffset);
+
+    struct Fragment {
+        uint64_t mBaseMediaDecodeTime;  // in media timescale ticks
+        off64_t mMoofOffset;
+    };
+
+    // Finds the last fragment of track |trackId| starting at or before |time|, in media
+    // timescale ticks, or the first fragment of the track if there is none. |next| is set
+    // to the fragment following it, if any. Returns NAME_NOT_FOUND if the track has no
+    // fragments with a decode time.
+    status_t findFragment(
+            uint32_t trackId, uint64_t time, Fragment *fragment, Fragment *next,
+            bool *hasNext);
+
+protected:
+    ~FragmentIndex();
+
+private:
+    // Limits the memory used for files with very many small fragments.
+    static const size_t kMaxFragments = 1 << 20;
+    // moof boxes larger than this are not indexed.
+    static const size_t kMaxMoofSize = 1024 * 1024;
+
+    Mutex mLock;
+
+    DataSourceHelper *mDataSource;
+    off64_t mFirstMoofOffset;
+    bool mScanned;
+    size_t mNumFragments;
+    std::map<uint32_t, std::vector<Fragment>> mFragments;
+
+    void scan_l();
+    void addMoof_l(off64_t moofOffset, const uint8_t *data, size_t size);
+    void addTrackFragment_l(off64_t moofOffset, const uint8_t *data, size_t size);
+
+    FragmentIndex(const FragmentIndex &);
+    FragmentIndex &operator=(const FragmentIndex &);
+};
+
+}  // namespace android
+
+#endif  // FRAGMENT_INDEX_H_
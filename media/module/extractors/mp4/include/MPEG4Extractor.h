@@ -33,6 +33,7 @@ namespace android {
 struct AMessage;
 struct CDataSource;
 class DataSourceHelper;
+class FragmentIndex;
 class SampleTable;
 class String8;
 namespace heif {
@@ -43,6 +44,9 @@ using heif::ItemTable;
 struct SidxEntry {
     size_t mSize;
     uint32_t mDurationUs;
+    // Sums over the preceding entries, for seeking.
+    int64_t mStartUs;
+    uint64_t mStartOffset;  // relative to the first moof
 };
 
 struct Trex {
@@ -130,6 +134,8 @@ private:
 
     Vector<SidxEntry> mSidxEntries;
     off64_t mMoofOffset;
+    // Seek index of fragmented files without sidx, created by the first getTrack().
+    sp<FragmentIndex> mFragmentIndex;
     bool mMoofFound;
     bool mMdatFound;
 
@@ -41,10 +41,25 @@ struct SampleIterator {
                 ((mCurrentSampleIndex - mFirstChunkSampleIndex) % mSamplesPerChunk) - 1;
     }
 
+    // File offset just past the last sample of the current chunk.
+    off64_t getChunkEndOffset() const { return mCurrentChunkEndOffset; }
+
     status_t getSampleSizeDirect(
             uint32_t sampleIndex, size_t *size);
 
 private:
+    // The sample size and chunk offset tables are read in blocks of this many bytes.
+    static constexpr size_t kTableCacheSize = 4096;
+
+    // A block of the payload of a sample size or chunk offset table.
+    struct TableCache {
+        TableCache() : mOffset(-1), mSize(0) {}
+
+        off64_t mOffset;  // file offset of mData, or -1 if empty
+        size_t mSize;
+        uint8_t mData[kTableCacheSize];
+    };
+
     SampleTable *mTable;
 
     bool mInitialized;
@@ -60,6 +75,7 @@ private:
     uint32_t mCurrentChunkIndex;
     off64_t mCurrentChunkOffset;
     Vector<size_t> mCurrentChunkSampleSizes;
+    off64_t mCurrentChunkEndOffset;
 
     uint32_t mTimeToSampleIndex;
     uint32_t mTTSSampleIndex;
@@ -73,7 +89,13 @@ private:
     uint64_t mCurrentSampleTime;
     uint64_t mCurrentSampleDuration;
 
+    TableCache mSampleSizeCache;
+    TableCache mChunkOffsetCache;
+
     void reset();
+    const uint8_t *readTableEntry(
+            TableCache *cache, off64_t tableOffset, size_t tableSize, size_t entryOffset,
+            size_t entrySize);
     status_t findChunkRange(uint32_t sampleIndex);
     status_t getChunkOffset(uint32_t chunk, off64_t *offset);
     status_t findSampleTimeAndDuration(uint32_t sampleIndex, uint64_t *time, uint64_t *duration);
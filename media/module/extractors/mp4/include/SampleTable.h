@@ -73,6 +73,9 @@ public:
     // call only after getMetaDataForSample has been called successfully.
     uint32_t getLastSampleIndexInChunk();
 
+    // call only after getMetaDataForSample has been called successfully.
+    off64_t getChunkEndOffset();
+
     enum {
         kFlagBefore,
         kFlagAfter,
@@ -132,6 +135,16 @@ private:
     };
     SampleTimeEntry *mSampleTimeEntries;
 
+    // Without composition time offsets, samples are in increasing composition time order and
+    // seeks search the runs of the time-to-sample table instead of mSampleTimeEntries.
+    struct TimeToSampleRun {
+        uint32_t mFirstSampleIndex;
+        uint32_t mDelta;
+        uint64_t mFirstSampleTime;
+    };
+    TimeToSampleRun *mTimeToSampleRuns;
+    uint32_t mNumTimeToSampleRuns;
+
     int32_t *mCompositionTimeDeltaEntries;
     size_t mNumCompositionTimeDeltaEntries;
     CompositionDeltaLookup *mCompositionDeltaLookup;
@@ -155,20 +168,31 @@ private:
 
     friend struct SampleIterator;
 
+    // |position| is a position in increasing composition time order.
     // normally we don't round
     inline uint64_t getSampleTime(
-            size_t sample_index, uint64_t scale_num, uint64_t scale_den) const {
-        return (sample_index < (size_t)mNumSampleSizes && mSampleTimeEntries != NULL
-                && scale_den != 0)
-                ? (mSampleTimeEntries[sample_index].mCompositionTime * scale_num) / scale_den : 0;
+            size_t position, uint64_t scale_num, uint64_t scale_den) const {
+        return (position < (size_t)mNumSampleSizes && hasSampleTimeIndex() && scale_den != 0)
+                ? (getCompositionTimeAt(position) * scale_num) / scale_den : 0;
     }
 
+    bool hasSampleTimeIndex() const {
+        return mSampleTimeEntries != NULL || mTimeToSampleRuns != NULL;
+    }
+
+    uint32_t getSampleIndexAt(uint32_t position) const {
+        return mSampleTimeEntries != NULL ? mSampleTimeEntries[position].mSampleIndex : position;
+    }
+
+    uint64_t getCompositionTimeAt(uint32_t position) const;
+
     status_t getSampleSize_l(uint32_t sample_index, size_t *sample_size);
     int32_t getCompositionTimeOffset(uint32_t sampleIndex);
 
     static int CompareIncreasingTime(const void *, const void *);
 
     void buildSampleEntriesTable();
+    bool buildTimeToSampleRuns();
 
     SampleTable(const SampleTable &);
     SampleTable &operator=(const SampleTable &);
@@ -48,6 +48,7 @@ using hardware::cas::V1_0::ICas;
 static const size_t kTSPacketSize = 188;
 static const int kMaxDurationReadSize = 250000LL;
 static const int kMaxDurationRetry = 6;
+static const size_t kReadBufferPackets = 64;
 
 struct MPEG2TSSource : public MediaTrackHelper {
     MPEG2TSSource(
@@ -250,7 +251,9 @@ MPEG2TSExtractor::MPEG2TSExtractor(DataSourceHelper *source)
     : mDataSource(source),
       mParser(new ATSParser),
       mLastSyncEvent(0),
-      mOffset(0) {
+      mOffset(0),
+      mReadBufferOffset(0),
+      mReadBufferSize(0) {
     char header;
     if (source->readAt(0, &header, 1) == 1 && header == 0x47) {
         mHeaderSkip = 0;
@@ -481,19 +484,18 @@ void MPEG2TSExtractor::init() {
 status_t MPEG2TSExtractor::feedMore(bool isInit) {
     Mutex::Autolock autoLock(mLock);
 
-    uint8_t packet[kTSPacketSize];
-    ssize_t n = mDataSource->readAt(mOffset + mHeaderSkip, packet, kTSPacketSize);
-
-    if (n < (ssize_t)kTSPacketSize) {
-        if (n >= 0) {
+    status_t err;
+    const uint8_t *packet = readPacket_l(mOffset, &err);
+    if (packet == NULL) {
+        if (err == ERROR_END_OF_STREAM) {
             mParser->signalEOS(ERROR_END_OF_STREAM);
         }
-        return (n < 0) ? (status_t)n : ERROR_END_OF_STREAM;
+        return err;
     }
 
     ATSParser::SyncEvent event(mOffset);
-    mOffset += mHeaderSkip + n;
-    status_t err = mParser->feedTSPacket(packet, kTSPacketSize, &event);
+    mOffset += mHeaderSkip + kTSPacketSize;
+    err = mParser->feedTSPacket(packet, kTSPacketSize, &event);
     if (event.hasReturnedData()) {
         if (isInit) {
             mLastSyncEvent = event;
@@ -504,6 +506,28 @@ status_t MPEG2TSExtractor::feedMore(bool isInit) {
     return err;
 }
 
+const uint8_t *MPEG2TSExtractor::readPacket_l(off64_t offset, status_t *err) {
+    const size_t packetSize = mHeaderSkip + kTSPacketSize;
+    if (offset < mReadBufferOffset
+            || offset + packetSize > mReadBufferOffset + mReadBufferSize) {
+        mReadBuffer.resize(packetSize * kReadBufferPackets);
+        ssize_t n = mDataSource->readAt(offset, mReadBuffer.data(), mReadBuffer.size());
+        if (n < 0) {
+            mReadBufferSize = 0;
+            *err = (status_t)n;
+            return NULL;
+        }
+        mReadBufferOffset = offset;
+        mReadBufferSize = n;
+        if (mReadBufferSize < packetSize) {
+            *err = ERROR_END_OF_STREAM;
+            return NULL;
+        }
+    }
+    *err = OK;
+    return mReadBuffer.data() + (offset - mReadBufferOffset) + mHeaderSkip;
+}
+
 void MPEG2TSExtractor::addSyncPoint_l(const ATSParser::SyncEvent &event) {
     if (!event.hasReturnedData()) {
         return;
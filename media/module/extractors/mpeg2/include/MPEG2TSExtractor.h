@@ -28,6 +28,8 @@
 #include <utils/KeyedVector.h>
 #include <utils/Vector.h>
 
+#include <vector>
+
 namespace android {
 
 struct AMessage;
@@ -76,6 +78,12 @@ private:
 
     off64_t mOffset;
 
+    // Packets are read from the source in blocks, then fed one at a time so
+    // that sync points keep per-packet offsets.
+    std::vector<uint8_t> mReadBuffer;
+    off64_t mReadBufferOffset;
+    size_t mReadBufferSize;
+
     static bool isScrambledFormat(MetaDataBase &format);
 
     void init();
@@ -88,6 +96,9 @@ private:
     // returned, e.g., ERROR_END_OF_STREAM, or no data availalbe from DataSourceHelper, or
     // the data has syntax error during parsing, etc.
     status_t feedMore(bool isInit = false);
+    // Returns the TS packet at |offset|, reading the next block from the source
+    // if it is not buffered. Returns NULL at the end of the stream or on error.
+    const uint8_t *readPacket_l(off64_t offset, status_t *err);
     status_t seek(int64_t seekTimeUs,
             const MediaTrackHelper::ReadOptions::SeekMode& seekMode);
     status_t queueDiscontinuityForSeek(int64_t actualSeekTimeUs);
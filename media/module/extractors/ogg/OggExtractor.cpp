@@ -37,6 +37,8 @@
 #include <inttypes.h>
 #include <stdint.h>
 
+#include <vector>
+
 extern "C" {
     #include <Tremolo/codec_internal.h>
 
@@ -136,10 +138,23 @@ protected:
     AMediaFormat *mMeta;
     AMediaFormat *mFileMeta;
 
+    // Built for the whole file up front when seeking to the end is cheap.
+    // Otherwise it covers the pages played back so far, from the first data
+    // page up to mTableOfContentsEnd, with one entry per kTOCIntervalUs.
     Vector<TOCEntry> mTableOfContents;
+    bool mTableOfContentsComplete;
+    off64_t mTableOfContentsEnd;
+
+    // Page headers and small packets are served from a window of the source,
+    // so that many pages are parsed per read.
+    bool mBufferReads;
+    std::vector<uint8_t> mReadBuffer;
+    off64_t mReadBufferOffset;
+    size_t mReadBufferSize;
 
     int32_t mHapticChannelCount;
 
+    ssize_t readAtBuffered(off64_t offset, void *data, size_t size);
     ssize_t readPage(off64_t offset, Page *page);
     status_t findNextPage(off64_t startOffset, off64_t *pageOffset);
 
@@ -169,6 +184,7 @@ protected:
     status_t findPrevGranulePosition(off64_t pageOffset, uint64_t *granulePos);
 
     void buildTableOfContents();
+    void addPlaybackTOCEntry(off64_t pageOffset, size_t pageSize, uint64_t granulePos);
 
     void setChannelMask(int channelCount);
 
@@ -324,6 +340,11 @@ MyOggExtractor::MyOggExtractor(
       mNumHeaders(numHeaders),
       mSeekPreRollUs(seekPreRollUs),
       mFirstDataOffset(-1),
+      mTableOfContentsComplete(false),
+      mTableOfContentsEnd(-1),
+      mBufferReads(!(source->flags() & DataSourceBase::kIsCachingDataSource)),
+      mReadBufferOffset(0),
+      mReadBufferSize(0),
       mHapticChannelCount(0) {
     mCurrentPage.mNumSegments = 0;
     mCurrentPage.mFlags = 0;
@@ -493,7 +514,8 @@ status_t MyOggExtractor::seekToTime(int64_t timeUs) {
         timeUs = 0;
     }
 
-    if (mTableOfContents.isEmpty()) {
+    if (mTableOfContents.isEmpty()
+            || (!mTableOfContentsComplete && timeUs > mTableOfContents.top().mTimeUs)) {
         // Perform approximate seeking based on avg. bitrate.
         uint64_t bps = approxBitrate();
         if (bps <= 0) {
@@ -568,10 +590,37 @@ status_t MyOggExtractor::seekToOffset(off64_t offset) {
     return OK;
 }
 
+ssize_t MyOggExtractor::readAtBuffered(off64_t offset, void *data, size_t size) {
+    static const size_t kReadBufferSize = 64 * 1024;
+
+    if (!mBufferReads || size > kReadBufferSize / 2) {
+        return mSource->readAt(offset, data, size);
+    }
+
+    if (offset < mReadBufferOffset
+            || offset + (off64_t)size > mReadBufferOffset + (off64_t)mReadBufferSize) {
+        mReadBuffer.resize(kReadBufferSize);
+        ssize_t n = mSource->readAt(offset, mReadBuffer.data(), kReadBufferSize);
+        if (n < 0) {
+            mReadBufferSize = 0;
+            return n;
+        }
+        mReadBufferOffset = offset;
+        mReadBufferSize = n;
+    }
+
+    size_t available = mReadBufferOffset + mReadBufferSize - offset;
+    if (size > available) {
+        size = available;
+    }
+    memcpy(data, mReadBuffer.data() + (offset - mReadBufferOffset), size);
+    return size;
+}
+
 ssize_t MyOggExtractor::readPage(off64_t offset, Page *page) {
     uint8_t header[27];
     ssize_t n;
-    if ((n = mSource->readAt(offset, header, sizeof(header)))
+    if ((n = readAtBuffered(offset, header, sizeof(header)))
             < (ssize_t)sizeof(header)) {
         ALOGV("failed to read %zu bytes at offset %#016llx, got %zd bytes",
                 sizeof(header), (long long)offset, n);
@@ -613,7 +662,7 @@ ssize_t MyOggExtractor::readPage(off64_t offset, Page *page) {
     page->mPageNo = U32LE_AT(&header[18]);
 
     page->mNumSegments = header[26];
-    if (mSource->readAt(
+    if (readAtBuffered(
                 offset + sizeof(header), page->mLace, page->mNumSegments)
             < (ssize_t)page->mNumSegments) {
         return AMEDIA_ERROR_IO;
@@ -868,7 +917,7 @@ media_status_t MyOggExtractor::_readNextPacket(MediaBufferHelper **out, bool cal
             }
             buffer = tmp;
 
-            ssize_t n = mSource->readAt(
+            ssize_t n = readAtBuffered(
                     dataOffset,
                     (uint8_t *)buffer->data() + buffer->range_length(),
                     packetSize);
@@ -951,6 +1000,8 @@ media_status_t MyOggExtractor::_readNextPacket(MediaBufferHelper **out, bool cal
 
         mPrevGranulePosition = mCurrentPage.mGranulePosition;
 
+        addPlaybackTOCEntry(mOffset, n, mCurrentPage.mGranulePosition);
+
         mCurrentPageSize = n;
         mNextLaceIndex = 0;
 
@@ -1000,6 +1051,7 @@ status_t MyOggExtractor::init() {
     }
 
     mFirstDataOffset = mOffset + mCurrentPageSize;
+    mTableOfContentsEnd = mFirstDataOffset;
 
     off64_t size;
     uint64_t lastGranulePosition;
@@ -1064,6 +1116,41 @@ void MyOggExtractor::buildTableOfContents() {
 
         mTableOfContents = maxTOC;
     }
+
+    mTableOfContentsComplete = true;
+}
+
+void MyOggExtractor::addPlaybackTOCEntry(
+        off64_t pageOffset, size_t pageSize, uint64_t granulePos) {
+    static const int64_t kTOCIntervalUs = 1000000LL;
+    static const size_t kMaxNumPlaybackTOCEntries = 16384;
+
+    // Only extend the table with the page right after the ones it covers,
+    // so that it has no gaps after a seek past its end.
+    if (mTableOfContentsComplete || pageOffset != mTableOfContentsEnd) {
+        return;
+    }
+    mTableOfContentsEnd = pageOffset + pageSize;
+
+    if (granulePos == (uint64_t)-1) {
+        // No packet ends on this page.
+        return;
+    }
+
+    int64_t timeUs = getTimeUsOfGranule(granulePos);
+    if (!mTableOfContents.isEmpty()
+            && timeUs < mTableOfContents.top().mTimeUs + kTOCIntervalUs) {
+        return;
+    }
+    if (mTableOfContents.size() >= kMaxNumPlaybackTOCEntries) {
+        mTableOfContentsEnd = -1;
+        return;
+    }
+
+    TOCEntry entry;
+    entry.mPageOffset = pageOffset;
+    entry.mTimeUs = timeUs;
+    mTableOfContents.push(entry);
 }
 
 int32_t MyOggExtractor::getPacketBlockSize(MediaBufferHelper *buffer) {
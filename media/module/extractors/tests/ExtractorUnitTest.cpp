@@ -20,6 +20,8 @@
 
 #include <inttypes.h>
 
+#include <utils/Timers.h>
+
 #include <datasource/FileSource.h>
 #include <media/stagefright/MediaBufferGroup.h>
 #include <media/stagefright/MediaCodecConstants.h>
@@ -829,6 +831,79 @@ TEST_P(ExtractorFunctionalityTest, MonkeySeekTest) {
     }
 }
 
+// Measures the latency of the first seek of each track, which builds the sample time index of
+// MPEG4 tracks. The latency is reported rather than checked.
+TEST_P(ExtractorFunctionalityTest, FirstSeekLatencyTest) {
+    if (mDisableTest) return;
+    if (mExtractorName != MPEG4) return;
+
+    string inputFileName = gEnv->getRes() + get<1>(GetParam());
+    ALOGV("Measures first seek latency of %s Extractor, filename %s", mContainer.c_str(),
+          inputFileName.c_str());
+
+    int32_t status = setDataSource(inputFileName);
+    ASSERT_EQ(status, 0) << "SetDataSource failed for" << mContainer << "extractor";
+
+    status = createExtractor();
+    ASSERT_EQ(status, 0) << "Extractor creation failed for" << mContainer << "extractor";
+
+    int32_t numTracks = mExtractor->countTracks();
+    ASSERT_EQ(numTracks, mNumTracks)
+            << "Extractor reported wrong number of track for the given clip";
+
+    bool seekable = mExtractor->flags() & MediaExtractorPluginHelper::CAN_SEEK;
+    if (!seekable) {
+        cout << "[   WARN   ] Test Skipped. " << mContainer << " Extractor doesn't support seek\n";
+        return;
+    }
+
+    for (int32_t idx = 0; idx < numTracks; idx++) {
+        MediaTrackHelper *track = mExtractor->getTrack(idx);
+        ASSERT_NE(track, nullptr) << "Failed to get track for index " << idx;
+
+        CMediaTrack *cTrack = wrap(track);
+        ASSERT_NE(cTrack, nullptr) << "Failed to get track wrapper for index " << idx;
+
+        MediaBufferGroup *bufferGroup = new MediaBufferGroup();
+        status = cTrack->start(track, bufferGroup->wrap());
+        ASSERT_EQ(OK, (media_status_t)status) << "Failed to start the track";
+
+        AMediaFormat *trackMeta = AMediaFormat_new();
+        ASSERT_NE(trackMeta, nullptr) << "AMediaFormat_new returned null AMediaformat";
+
+        status = mExtractor->getTrackMetaData(trackMeta, idx, 1);
+        ASSERT_EQ(OK, (media_status_t)status) << "Failed to get trackMetaData";
+
+        int64_t clipDuration = 0;
+        AMediaFormat_getInt64(trackMeta, AMEDIAFORMAT_KEY_DURATION, &clipDuration);
+        AMediaFormat_delete(trackMeta);
+
+        if (clipDuration > 0) {
+            MediaTrackHelper::ReadOptions *options = new MediaTrackHelper::ReadOptions(
+                    CMediaTrackReadOptions::SEEK_CLOSEST | CMediaTrackReadOptions::SEEK,
+                    clipDuration / 2);
+            ASSERT_NE(options, nullptr) << "Cannot create read option";
+
+            MediaBufferHelper *buffer = nullptr;
+            nsecs_t startTime = systemTime(CLOCK_MONOTONIC);
+            status = track->read(&buffer, options);
+            nsecs_t seekTime = systemTime(CLOCK_MONOTONIC) - startTime;
+            if (buffer) buffer->release();
+            delete options;
+
+            ALOGI("First seek of track %d of %s took %" PRId64 " us", idx,
+                  inputFileName.c_str(), (int64_t)ns2us(seekTime));
+            cout << "[   INFO   ] First seek of track " << idx << " took " << ns2us(seekTime)
+                 << " us\n";
+        }
+
+        status = cTrack->stop(track);
+        ASSERT_EQ(OK, status) << "Failed to stop the track";
+        delete bufferGroup;
+        delete track;
+    }
+}
+
 // Tests extractors for invalid tracks
 TEST_P(ExtractorFunctionalityTest, SanityTest) {
     if (mDisableTest) return;
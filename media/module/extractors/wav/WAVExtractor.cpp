@@ -90,6 +90,8 @@ protected:
 
 private:
     static const size_t kMaxFrameSize;
+    static const size_t kMaxReadBufferSize;
+    static const int64_t kReadDurationUs;
 
     DataSourceHelper *mDataSource;
     AMediaFormat *mMeta;
@@ -102,6 +104,7 @@ private:
     size_t mSize;
     bool mStarted;
     off64_t mCurrentPos;
+    size_t mBufferSize;
 
     WAVSource(const WAVSource &);
     WAVSource &operator=(const WAVSource &);
@@ -366,6 +369,12 @@ status_t WAVExtractor::init() {
 
 const size_t WAVSource::kMaxFrameSize = 32768;
 
+// PCM buffers are sized to hold about kReadDurationUs of output, but no less than
+// kMaxFrameSize, so that multichannel and high resolution streams are not read in many small
+// pieces.
+const size_t WAVSource::kMaxReadBufferSize = 1 << 20;
+const int64_t WAVSource::kReadDurationUs = 40000LL;
+
 WAVSource::WAVSource(
         DataSourceHelper *dataSource,
         AMediaFormat *meta,
@@ -382,6 +391,13 @@ WAVSource::WAVSource(
     CHECK(AMediaFormat_getInt32(mMeta, AMEDIAFORMAT_KEY_SAMPLE_RATE, (int32_t*) &mSampleRate));
     CHECK(AMediaFormat_getInt32(mMeta, AMEDIAFORMAT_KEY_CHANNEL_COUNT, (int32_t*) &mNumChannels));
     CHECK(AMediaFormat_getInt32(mMeta, AMEDIAFORMAT_KEY_BITS_PER_SAMPLE, (int32_t*) &mBitsPerSample));
+
+    mBufferSize = kMaxFrameSize;
+    if (mWaveFormat == WAVE_FORMAT_PCM || mWaveFormat == WAVE_FORMAT_IEEE_FLOAT) {
+        const uint64_t bytesPerFrame = (uint64_t)mNumChannels * (mOutputFloat ? 4 : 2);
+        const uint64_t size = bytesPerFrame * mSampleRate * kReadDurationUs / 1000000LL;
+        mBufferSize = std::clamp(size, (uint64_t)kMaxFrameSize, (uint64_t)kMaxReadBufferSize);
+    }
 }
 
 WAVSource::~WAVSource() {
@@ -396,7 +412,7 @@ media_status_t WAVSource::start() {
     CHECK(!mStarted);
 
     // some WAV files may have large audio buffers that use shared memory transfer.
-    if (!mBufferGroup->init(4 /* buffers */, kMaxFrameSize)) {
+    if (!mBufferGroup->init(4 /* buffers */, mBufferSize)) {
         return AMEDIA_ERROR_UNKNOWN;
     }
 
@@ -422,7 +438,7 @@ media_status_t WAVSource::getFormat(AMediaFormat *meta) {
 
     const media_status_t status = AMediaFormat_copy(meta, mMeta);
     if (status == OK) {
-        AMediaFormat_setInt32(meta, AMEDIAFORMAT_KEY_MAX_INPUT_SIZE, kMaxFrameSize);
+        AMediaFormat_setInt32(meta, AMEDIAFORMAT_KEY_MAX_INPUT_SIZE, mBufferSize);
         AMediaFormat_setInt32(meta, AMEDIAFORMAT_KEY_PCM_ENCODING,
                 mOutputFloat ? kAudioEncodingPcmFloat : kAudioEncodingPcm16bit);
     }
@@ -470,7 +486,7 @@ media_status_t WAVSource::read(
     }
 
     // maxBytesToRead may be reduced so that in-place data conversion will fit in buffer size.
-    const size_t bufferSize = std::min(buffer->size(), kMaxFrameSize);
+    const size_t bufferSize = std::min(buffer->size(), mBufferSize);
     size_t maxBytesToRead;
     if (mOutputFloat) { // destination is float at 4 bytes per sample, source may be less.
         maxBytesToRead = (mBitsPerSample / 8) * (bufferSize / 4);
@@ -512,7 +528,8 @@ media_status_t WAVSource::read(
 
     buffer->set_range(0, n);
 
-    // TODO: add capability to return data as float PCM instead of 16 bit PCM.
+    // 16 bit PCM to 16 bit and float to float output is passed through as read. The other
+    // formats are converted in place.
     if (mWaveFormat == WAVE_FORMAT_PCM) {
         const size_t bytesPerFrame = (mBitsPerSample >> 3) * mNumChannels;
         const size_t numFrames = n / bytesPerFrame;
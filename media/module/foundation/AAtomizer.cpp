@@ -14,6 +14,7 @@
  * limitations under the License.
  */
 
+#include <string.h>
 #include <sys/types.h>
 
 #include "AAtomizer.h"
@@ -25,42 +26,63 @@ AAtomizer AAtomizer::gAtomizer;
 
 // static
 const char *AAtomizer::Atomize(const char *name) {
-    return gAtomizer.atomize(name);
+    return gAtomizer.atomize(name, Hash(name), false /* limited */);
 }
 
-AAtomizer::AAtomizer() {
-    for (size_t i = 0; i < 128; ++i) {
+// static
+const char *AAtomizer::TryAtomize(const char *name, uint32_t hash) {
+    return gAtomizer.atomize(name, hash, true /* limited */);
+}
+
+AAtomizer::AAtomizer()
+    : mNumAtoms(0) {
+    for (size_t i = 0; i < kNumBuckets; ++i) {
         mAtoms.push(List<AString>());
     }
 }
 
-const char *AAtomizer::atomize(const char *name) {
-    Mutex::Autolock autoLock(mLock);
+const char *AAtomizer::atomize(const char *name, uint32_t hash, bool limited) {
+    const size_t index = hash % mAtoms.size();
+    {
+        RWLock::AutoRLock autoLock(mLock);
+        const List<AString> &entry = mAtoms.itemAt(index);
+        for (List<AString>::const_iterator it = entry.begin(); it != entry.end(); ++it) {
+            if (!strcmp((*it).c_str(), name)) {
+                return (*it).c_str();
+            }
+        }
+    }
 
-    const size_t n = mAtoms.size();
-    size_t index = AAtomizer::Hash(name) % n;
+    RWLock::AutoWLock autoLock(mLock);
     List<AString> &entry = mAtoms.editItemAt(index);
-    List<AString>::iterator it = entry.begin();
-    while (it != entry.end()) {
-        if ((*it) == name) {
+    // another thread may have added the name while the lock was released
+    for (List<AString>::iterator it = entry.begin(); it != entry.end(); ++it) {
+        if (!strcmp((*it).c_str(), name)) {
             return (*it).c_str();
         }
-        ++it;
+    }
+    if (limited && mNumAtoms >= kMaxAtoms) {
+        return NULL;
     }
 
     entry.push_back(AString(name));
+    ++mNumAtoms;
 
     return (*--entry.end()).c_str();
 }
 
 // static
-uint32_t AAtomizer::Hash(const char *s) {
+uint32_t AAtomizer::Hash(const char *s, size_t *length) {
+    const char *start = s;
     uint32_t sum = 0;
     while (*s != '\0') {
         sum = (sum * 31) + *s;
         ++s;
     }
 
+    if (length != NULL) {
+        *length = s - start;
+    }
     return sum;
 }
 
@@ -16,6 +16,9 @@
 
 #include "ABitReader.h"
 
+#include <endian.h>
+#include <string.h>
+
 #include <media/stagefright/foundation/ADebug.h>
 
 namespace android {
@@ -31,15 +34,30 @@ ABitReader::ABitReader(const uint8_t *data, size_t size)
 ABitReader::~ABitReader() {
 }
 
+// Loads the next 8 bytes of |data| as a big-endian reservoir.
+static inline uint64_t loadReservoir(const uint8_t *data) {
+    uint64_t bits;
+    memcpy(&bits, data, sizeof(bits));
+    return be64toh(bits);
+}
+
 bool ABitReader::fillReservoir() {
     if (mSize == 0) {
         mOverRead = true;
         return false;
     }
 
+    if (mSize >= sizeof(mReservoir)) {
+        mReservoir = loadReservoir(mData);
+        mData += sizeof(mReservoir);
+        mSize -= sizeof(mReservoir);
+        mNumBitsLeft = 64;
+        return true;
+    }
+
     mReservoir = 0;
     size_t i;
-    for (i = 0; mSize > 0 && i < 4; ++i) {
+    for (i = 0; mSize > 0 && i < sizeof(mReservoir); ++i) {
         mReservoir = (mReservoir << 8) | *mData;
 
         ++mData;
@@ -47,7 +65,7 @@ bool ABitReader::fillReservoir() {
     }
 
     mNumBitsLeft = 8 * i;
-    mReservoir <<= 32 - mNumBitsLeft;
+    mReservoir <<= 64 - mNumBitsLeft;
     return true;
 }
 
@@ -68,7 +86,20 @@ bool ABitReader::getBitsGraceful(size_t n, uint32_t *out) {
         return false;
     }
 
-    uint32_t result = 0;
+    if (n == 0) {
+        *out = 0;
+        return true;
+    }
+
+    // Most reads are served from the reservoir without a refill.
+    if (n <= mNumBitsLeft) {
+        *out = mReservoir >> (64 - n);
+        mReservoir <<= n;
+        mNumBitsLeft -= n;
+        return true;
+    }
+
+    uint64_t result = 0;
     while (n > 0) {
         if (mNumBitsLeft == 0) {
             if (!fillReservoir()) {
@@ -81,7 +112,7 @@ bool ABitReader::getBitsGraceful(size_t n, uint32_t *out) {
             m = mNumBitsLeft;
         }
 
-        result = (result << m) | (mReservoir >> (32 - m));
+        result = (result << m) | (mReservoir >> (64 - m));
         mReservoir <<= m;
         mNumBitsLeft -= m;
 
@@ -107,6 +138,31 @@ bool ABitReader::skipBits(size_t n) {
     return true;
 }
 
+bool ABitReader::skipLeadingZeroBits(uint32_t *numZeros) {
+    uint32_t count = 0;
+    for (;;) {
+        if (mNumBitsLeft == 0) {
+            if (!fillReservoir()) {
+                *numZeros = count;
+                return false;
+            }
+        }
+
+        // Bits below the reservoir are not necessarily zero after putBits(), so only a one bit
+        // within mNumBitsLeft counts.
+        size_t zeros = mReservoir == 0 ? 64 : __builtin_clzll(mReservoir);
+        if (zeros < mNumBitsLeft) {
+            mReservoir = (mReservoir << zeros) << 1;
+            mNumBitsLeft -= zeros + 1;
+            *numZeros = count + zeros;
+            return true;
+        }
+
+        count += mNumBitsLeft;
+        mNumBitsLeft = 0;
+    }
+}
+
 void ABitReader::putBits(uint32_t x, size_t n) {
     if (mOverRead) {
         return;
@@ -114,13 +170,17 @@ void ABitReader::putBits(uint32_t x, size_t n) {
 
     CHECK_LE(n, 32u);
 
-    while (mNumBitsLeft + n > 32) {
+    if (n == 0) {
+        return;
+    }
+
+    while (mNumBitsLeft + n > 64) {
         mNumBitsLeft -= 8;
         --mData;
         ++mSize;
     }
 
-    mReservoir = (mReservoir >> n) | (x << (32 - n));
+    mReservoir = (mReservoir >> n) | ((uint64_t)x << (64 - n));
     mNumBitsLeft += n;
 }
 
@@ -169,15 +229,34 @@ bool NALBitReader::atLeastNumBitsLeft(size_t n) const {
     return (numBitsRemaining <= 0);
 }
 
+// Returns true iff any of the 8 bytes in |x| is zero.
+static inline bool hasZeroByte(uint64_t x) {
+    return ((x - 0x0101010101010101ull) & ~x & 0x8080808080808080ull) != 0;
+}
+
 bool NALBitReader::fillReservoir() {
     if (mSize == 0) {
         mOverRead = true;
         return false;
     }
 
+    // An emulation_prevention_three_byte follows two zero bytes, so 8 bytes without a zero
+    // byte can be used as they are, unless two zero bytes precede them.
+    if (mSize >= sizeof(mReservoir) && mNumZeros < 2) {
+        uint64_t bits = loadReservoir(mData);
+        if (!hasZeroByte(bits)) {
+            mReservoir = bits;
+            mData += sizeof(mReservoir);
+            mSize -= sizeof(mReservoir);
+            mNumBitsLeft = 64;
+            mNumZeros = 0;
+            return true;
+        }
+    }
+
     mReservoir = 0;
     size_t i = 0;
-    while (mSize > 0 && i < 4) {
+    while (mSize > 0 && i < sizeof(mReservoir)) {
         bool isEmulationPreventionByte = (mNumZeros >= 2 && *mData == 3);
 
         if (*mData == 0) {
@@ -197,7 +276,9 @@ bool NALBitReader::fillReservoir() {
     }
 
     mNumBitsLeft = 8 * i;
-    mReservoir <<= 32 - mNumBitsLeft;
+    if (mNumBitsLeft > 0) {
+        mReservoir <<= 64 - mNumBitsLeft;
+    }
     return true;
 }
 
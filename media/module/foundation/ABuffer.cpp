@@ -16,17 +16,187 @@
 
 #include "ABuffer.h"
 
+#include <inttypes.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include <atomic>
+
+#include <cutils/properties.h>
+#include <utils/String8.h>
+
 #include "ADebug.h"
 #include "ALooper.h"
 #include "AMessage.h"
 
 namespace android {
 
+namespace {
+
+// Optional slab cache for the ABuffer objects and the data of small buffers, enabled with
+// media.stagefright.abuffer-slab. Blocks of up to 4 KiB are rounded up to a power of two and
+// recycled through free lists of the thread freeing them, which keeps the many short lived
+// access unit, CSD and SEI buffers of a demux session from fragmenting the heap.
+constexpr size_t kMinSlabShift = 5;
+constexpr size_t kMaxSlabShift = 12;
+constexpr size_t kNumSlabBuckets = kMaxSlabShift - kMinSlabShift + 1;
+constexpr size_t kMaxCachedPerBucket = 64;
+
+struct SlabStats {
+    std::atomic<uint64_t> mAllocations[kNumSlabBuckets];
+    std::atomic<uint64_t> mCacheHits[kNumSlabBuckets];
+    std::atomic<int64_t> mCached[kNumSlabBuckets];
+    std::atomic<uint64_t> mLargeAllocations;
+};
+
+SlabStats sSlabStats;
+
+bool isSlabEnabled() {
+    static const bool sEnabled = property_get_bool("media.stagefright.abuffer-slab", false);
+    return sEnabled;
+}
+
+// Returns the bucket of an allocation, or -1 if it does not come from the slab.
+int slabBucket(size_t size) {
+    if (!isSlabEnabled()) {
+        return -1;
+    }
+    if (size > ((size_t)1 << kMaxSlabShift)) {
+        sSlabStats.mLargeAllocations.fetch_add(1, std::memory_order_relaxed);
+        return -1;
+    }
+    size_t shift = kMinSlabShift;
+    while (((size_t)1 << shift) < size) {
+        ++shift;
+    }
+    return shift - kMinSlabShift;
+}
+
+struct FreeBlock {
+    FreeBlock *mNext;
+};
+
+struct SlabCache {
+    FreeBlock *mHead[kNumSlabBuckets];
+    size_t mCount[kNumSlabBuckets];
+};
+
+pthread_key_t sSlabCacheKey;
+thread_local SlabCache *tSlabCache = nullptr;
+thread_local bool tSlabCacheReleased = false;
+
+void releaseSlabCache(void *arg) {
+    SlabCache *cache = static_cast<SlabCache *>(arg);
+    for (size_t b = 0; b < kNumSlabBuckets; ++b) {
+        while (cache->mHead[b] != nullptr) {
+            FreeBlock *block = cache->mHead[b];
+            cache->mHead[b] = block->mNext;
+            free(block);
+        }
+        sSlabStats.mCached[b].fetch_sub(cache->mCount[b], std::memory_order_relaxed);
+    }
+    delete cache;
+    tSlabCache = nullptr;
+    tSlabCacheReleased = true;  // blocks freed later in the thread exit go to the heap
+}
+
+SlabCache *getSlabCache() {
+    if (tSlabCache == nullptr && !tSlabCacheReleased) {
+        static pthread_once_t sOnce = PTHREAD_ONCE_INIT;
+        pthread_once(&sOnce, [] { pthread_key_create(&sSlabCacheKey, releaseSlabCache); });
+        tSlabCache = new SlabCache{};
+        pthread_setspecific(sSlabCacheKey, tSlabCache);
+    }
+    return tSlabCache;
+}
+
+void *slabAllocate(size_t size) {
+    const int b = slabBucket(size);
+    if (b < 0) {
+        return malloc(size);
+    }
+    sSlabStats.mAllocations[b].fetch_add(1, std::memory_order_relaxed);
+    SlabCache *cache = getSlabCache();
+    if (cache != nullptr && cache->mHead[b] != nullptr) {
+        FreeBlock *block = cache->mHead[b];
+        cache->mHead[b] = block->mNext;
+        --cache->mCount[b];
+        sSlabStats.mCacheHits[b].fetch_add(1, std::memory_order_relaxed);
+        sSlabStats.mCached[b].fetch_sub(1, std::memory_order_relaxed);
+        return block;
+    }
+    return malloc((size_t)1 << (b + kMinSlabShift));
+}
+
+// |size| must be the size given to slabAllocate()
+void slabFree(void *p, size_t size) {
+    if (p == nullptr) {
+        return;
+    }
+    const int b = isSlabEnabled() && size <= ((size_t)1 << kMaxSlabShift)
+            ? slabBucket(size) : -1;
+    SlabCache *cache = b < 0 ? nullptr : getSlabCache();
+    if (cache == nullptr || cache->mCount[b] >= kMaxCachedPerBucket) {
+        free(p);
+        return;
+    }
+    FreeBlock *block = static_cast<FreeBlock *>(p);
+    block->mNext = cache->mHead[b];
+    cache->mHead[b] = block;
+    ++cache->mCount[b];
+    sSlabStats.mCached[b].fetch_add(1, std::memory_order_relaxed);
+}
+
+}  // namespace
+
+// static
+void *ABuffer::operator new(size_t size) {
+    void *p = slabAllocate(size);
+    if (p == NULL) {
+        abort();
+    }
+    return p;
+}
+
+// static
+void *ABuffer::operator new(size_t size, const std::nothrow_t &) noexcept {
+    return slabAllocate(size);
+}
+
+// static
+void ABuffer::operator delete(void *p, size_t size) {
+    slabFree(p, size);
+}
+
+// static
+void ABuffer::dumpAllocatorStats(int fd) {
+    String8 s;
+    if (!isSlabEnabled()) {
+        s.append("  ABuffer slab disabled\n");
+    } else {
+        s.appendFormat("  ABuffer slab, %" PRIu64 " larger allocations\n",
+                sSlabStats.mLargeAllocations.load(std::memory_order_relaxed));
+        for (size_t b = 0; b < kNumSlabBuckets; ++b) {
+            const uint64_t allocations =
+                    sSlabStats.mAllocations[b].load(std::memory_order_relaxed);
+            if (allocations == 0) {
+                continue;
+            }
+            s.appendFormat("    %5zu bytes: %" PRIu64 " allocations, %" PRIu64 " from cache, "
+                    "%" PRId64 " cached\n",
+                    (size_t)1 << (b + kMinSlabShift), allocations,
+                    sSlabStats.mCacheHits[b].load(std::memory_order_relaxed),
+                    sSlabStats.mCached[b].load(std::memory_order_relaxed));
+        }
+    }
+    (void)write(fd, s.string(), s.size());
+}
+
 ABuffer::ABuffer(size_t capacity)
     : mRangeOffset(0),
       mInt32Data(0),
       mOwnsData(true) {
-    mData = malloc(capacity);
+    mData = slabAllocate(capacity);
     if (mData == NULL) {
         mCapacity = 0;
         mRangeLength = 0;
@@ -59,7 +229,7 @@ sp<ABuffer> ABuffer::CreateAsCopy(const void *data, size_t capacity)
 ABuffer::~ABuffer() {
     if (mOwnsData) {
         if (mData != NULL) {
-            free(mData);
+            slabFree(mData, mCapacity);
             mData = NULL;
         }
     }
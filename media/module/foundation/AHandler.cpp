@@ -40,6 +40,34 @@ void AHandler::deliverMessage(const sp<AMessage> &msg) {
     }
 }
 
+void AHandler::deliverMessages(const std::vector<sp<AMessage>> &msgs) {
+    const uint32_t what = msgs.front()->what();
+    setDeliveryStatus(true, what, ALooper::GetNowUs());
+    onMessagesReceived(msgs);
+    mMessageCounter += msgs.size();
+    mBatchCounter++;
+    mBatchedMessageCounter += msgs.size();
+    if (msgs.size() > mMaxBatchSize) {
+        mMaxBatchSize = msgs.size();
+    }
+    setDeliveryStatus(false, 0, 0);
+
+    if (mVerboseStats) {
+        ssize_t idx = mMessages.indexOfKey(what);
+        if (idx < 0) {
+            mMessages.add(what, msgs.size());
+        } else {
+            mMessages.editValueAt(idx) += msgs.size();
+        }
+    }
+}
+
+void AHandler::onMessagesReceived(const std::vector<sp<AMessage>> &msgs) {
+    for (const sp<AMessage> &msg : msgs) {
+        onMessageReceived(msg);
+    }
+}
+
 void AHandler::setDeliveryStatus(bool delivering, uint32_t what, int64_t startUs) {
     AutoMutex autoLock(mLock);
     mDeliveringMessage = delivering;
@@ -23,6 +23,8 @@
 
 #include <sys/time.h>
 
+#include <algorithm>
+
 #include "ALooper.h"
 
 #include "AHandler.h"
@@ -74,7 +76,8 @@ int64_t ALooper::getNowUs() {
 }
 
 ALooper::ALooper()
-    : mRunningLocally(false) {
+    : mEventSequence(0),
+      mRunningLocally(false) {
     // clean up stale AHandlers. Doing it here instead of in the destructor avoids
     // the side effect of objects being deleted from the unregister function recursively.
     gLooperRoster.unregisterStaleHandlers();
@@ -95,6 +98,22 @@ ALooper::handler_id ALooper::registerHandler(const sp<AHandler> &handler) {
 
 void ALooper::unregisterHandler(handler_id handlerID) {
     gLooperRoster.unregisterHandler(handlerID);
+
+    Mutex::Autolock autoLock(mLock);
+    mCoalescedMessages.erase(std::remove_if(mCoalescedMessages.begin(), mCoalescedMessages.end(),
+            [handlerID](const auto &entry) { return entry.first == handlerID; }),
+            mCoalescedMessages.end());
+}
+
+void ALooper::setCoalescedMessage(handler_id handlerID, uint32_t what, bool coalesce) {
+    Mutex::Autolock autoLock(mLock);
+    const auto entry = std::make_pair(handlerID, what);
+    auto it = std::find(mCoalescedMessages.begin(), mCoalescedMessages.end(), entry);
+    if (coalesce && it == mCoalescedMessages.end()) {
+        mCoalescedMessages.push_back(entry);
+    } else if (!coalesce && it != mCoalescedMessages.end()) {
+        mCoalescedMessages.erase(it);
+    }
 }
 
 status_t ALooper::start(
@@ -181,21 +200,21 @@ void ALooper::post(const sp<AMessage> &msg, int64_t delayUs) {
         whenUs = getNowUs();
     }
 
-    List<Event>::iterator it = mEventQueue.begin();
-    while (it != mEventQueue.end() && (*it).mWhenUs <= whenUs) {
-        ++it;
+    if (mEventQueue.empty() || whenUs < mEventQueue.front().mWhenUs) {
+        mQueueChangedCondition.signal();
     }
 
+    pushEvent_l(whenUs, msg, nullptr);
+}
+
+void ALooper::pushEvent_l(int64_t whenUs, const sp<AMessage> &msg, const sp<RefBase> &token) {
     Event event;
     event.mWhenUs = whenUs;
+    event.mSequence = mEventSequence++;
     event.mMessage = msg;
-    event.mToken = nullptr;
-
-    if (it == mEventQueue.begin()) {
-        mQueueChangedCondition.signal();
-    }
-
-    mEventQueue.insert(it, event);
+    event.mToken = token;
+    mEventQueue.push_back(std::move(event));
+    std::push_heap(mEventQueue.begin(), mEventQueue.end(), EventAfter());
 }
 
 status_t ALooper::postUnique(const sp<AMessage> &msg, const sp<RefBase> &token, int64_t delayUs) {
@@ -215,28 +234,17 @@ status_t ALooper::postUnique(const sp<AMessage> &msg, const sp<RefBase> &token,
     // We only need to wake the loop up if we're rescheduling to the earliest event in the queue.
     // This needs to be checked now, before we reschedule the message, in case this message is
     // already at the beginning of the queue.
-    bool shouldAwakeLoop = mEventQueue.empty() || whenUs < mEventQueue.begin()->mWhenUs;
+    bool shouldAwakeLoop = mEventQueue.empty() || whenUs < mEventQueue.front().mWhenUs;
 
     // Erase any previously-posted event with this token.
-    for (auto i = mEventQueue.begin(); i != mEventQueue.end();) {
-        if (i->mToken == token) {
-            i = mEventQueue.erase(i);
-        } else {
-            ++i;
-        }
-    }
-
-    // Find the insertion point for the rescheduled message.
-    List<Event>::iterator i = mEventQueue.begin();
-    while (i != mEventQueue.end() && i->mWhenUs <= whenUs) {
-        ++i;
+    auto erased = std::remove_if(mEventQueue.begin(), mEventQueue.end(),
+            [&token](const Event &event) { return event.mToken == token; });
+    if (erased != mEventQueue.end()) {
+        mEventQueue.erase(erased, mEventQueue.end());
+        std::make_heap(mEventQueue.begin(), mEventQueue.end(), EventAfter());
     }
 
-    Event event;
-    event.mWhenUs = whenUs;
-    event.mMessage = msg;
-    event.mToken = token;
-    mEventQueue.insert(i, event);
+    pushEvent_l(whenUs, msg, token);
 
     // If we rescheduled the event to be earlier than the first event, then we need to wake up the
     // looper earlier than it was previously scheduled to be woken up. Otherwise, it can sleep until
@@ -247,9 +255,39 @@ status_t ALooper::postUnique(const sp<AMessage> &msg, const sp<RefBase> &token,
     return OK;
 }
 
+void ALooper::takeCoalescedEvents_l(
+        const Event &first, int64_t nowUs, std::vector<Event> *batch) {
+    const handler_id target = first.mMessage->mTarget;
+    const uint32_t what = first.mMessage->what();
+    if (std::find(mCoalescedMessages.begin(), mCoalescedMessages.end(),
+            std::make_pair(target, what)) == mCoalescedMessages.end()) {
+        return;
+    }
+    size_t i = 0;
+    while (i < mEventQueue.size() && batch->size() + 1 < kMaxCoalescedMessages) {
+        Event &candidate = mEventQueue[i];
+        if (candidate.mWhenUs <= nowUs && candidate.mMessage->mTarget == target
+                && candidate.mMessage->what() == what) {
+            batch->push_back(std::move(candidate));
+            if (i + 1 < mEventQueue.size()) {
+                candidate = std::move(mEventQueue.back());
+            }
+            mEventQueue.pop_back();
+        } else {
+            ++i;
+        }
+    }
+    if (!batch->empty()) {
+        std::make_heap(mEventQueue.begin(), mEventQueue.end(), EventAfter());
+        std::sort(batch->begin(), batch->end(),
+                [](const Event &a, const Event &b) { return EventAfter()(b, a); });
+    }
+}
+
 bool ALooper::loop() {
 
     Event event;
+    std::vector<Event> coalesced;
 
     {
         Mutex::Autolock autoLock(mLock);
@@ -260,7 +298,7 @@ bool ALooper::loop() {
             mQueueChangedCondition.wait(mLock);
             return true;
         }
-        int64_t whenUs = (*mEventQueue.begin()).mWhenUs;
+        int64_t whenUs = mEventQueue.front().mWhenUs;
         int64_t nowUs = getNowUs();
 
         if (whenUs > nowUs) {
@@ -273,11 +311,26 @@ bool ALooper::loop() {
             return true;
         }
 
-        event = *mEventQueue.begin();
-        mEventQueue.erase(mEventQueue.begin());
+        std::pop_heap(mEventQueue.begin(), mEventQueue.end(), EventAfter());
+        event = std::move(mEventQueue.back());
+        mEventQueue.pop_back();
+
+        if (!mCoalescedMessages.empty()) {
+            takeCoalescedEvents_l(event, nowUs, &coalesced);
+        }
     }
 
-    event.mMessage->deliver();
+    if (coalesced.empty()) {
+        event.mMessage->deliver();
+    } else {
+        std::vector<sp<AMessage>> msgs;
+        msgs.reserve(coalesced.size() + 1);
+        msgs.push_back(std::move(event.mMessage));
+        for (Event &e : coalesced) {
+            msgs.push_back(std::move(e.mMessage));
+        }
+        AMessage::deliver(msgs);
+    }
 
     // NOTE: It's important to note that at this point our "ALooper" object
     // may no longer exist (its final reference may have gone away while
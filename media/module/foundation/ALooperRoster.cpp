@@ -157,6 +157,14 @@ void ALooperRoster::dump(int fd, const Vector<String16>& args) {
                                deliveringMessages,
                                currentMessageWhat,
                                currentDeliveryDurationUs);
+                if (handler->mBatchCounter > 0) {
+                    s.appendFormat(", %" PRIu64 " batches of %.1f messages on average, "
+                                   "max %zu",
+                                   handler->mBatchCounter,
+                                   (double)handler->mBatchedMessageCounter
+                                           / handler->mBatchCounter,
+                                   handler->mMaxBatchSize);
+                }
                 if (verboseStats) {
                     for (size_t j = 0; j < handler->mMessages.size(); j++) {
                         char fourcc[15];
@@ -171,6 +179,9 @@ void ALooperRoster::dump(int fd, const Vector<String16>& args) {
                 if (clear || (verboseStats && !oldVerbose)) {
                     handler->mMessageCounter = 0;
                     handler->mMessages.clear();
+                    handler->mBatchCounter = 0;
+                    handler->mBatchedMessageCounter = 0;
+                    handler->mMaxBatchSize = 0;
                 }
             } else {
                 s.append(": <stale handler>");
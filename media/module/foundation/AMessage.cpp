@@ -89,11 +89,11 @@ void AMessage::setTarget(const sp<const AHandler> &handler) {
 void AMessage::clear() {
     // Item needs to be handled delicately
     for (Item &item : mItems) {
-        delete[] item.mName;
-        item.mName = NULL;
+        item.freeName();
         freeItemValue(&item);
     }
     mItems.clear();
+    mIndex.clear();
 }
 
 void AMessage::freeItemValue(Item *item) {
@@ -150,20 +150,40 @@ static void reportStats() {
 }
 #endif
 
-inline size_t AMessage::findItemIndex(const char *name, size_t len) const {
+inline size_t AMessage::findItemIndex(const char *name, size_t len, uint32_t hash) const {
 #ifdef DUMP_STATS
     size_t memchecks = 0;
 #endif
     size_t i = 0;
-    for (; i < mItems.size(); i++) {
-        if (len != mItems[i].mNameLength) {
-            continue;
+    if (!mIndex.empty()) {
+        const size_t mask = mIndex.size() - 1;
+        i = mItems.size();
+        for (size_t slot = hash & mask; mIndex[slot] != 0; slot = (slot + 1) & mask) {
+            const Item &item = mItems[mIndex[slot] - 1];
+            if (item.mNameHash != hash || item.mNameLength != len) {
+                continue;
+            }
+#ifdef DUMP_STATS
+            ++memchecks;
+#endif
+            if (item.mName == name || !memcmp(item.mName, name, len)) {
+                i = mIndex[slot] - 1;
+                break;
+            }
         }
+    } else {
+        for (; i < mItems.size(); i++) {
+            const Item &item = mItems[i];
+            if (item.mNameHash != hash || item.mNameLength != len) {
+                continue;
+            }
 #ifdef DUMP_STATS
-        ++memchecks;
+            ++memchecks;
 #endif
-        if (!memcmp(mItems[i].mName, name, len)) {
-            break;
+            // names from AAtomizer are often looked up with the atom itself
+            if (item.mName == name || !memcmp(item.mName, name, len)) {
+                break;
+            }
         }
     }
 #ifdef DUMP_STATS
@@ -179,22 +199,78 @@ inline size_t AMessage::findItemIndex(const char *name, size_t len) const {
     return i;
 }
 
+size_t AMessage::findItemIndex(const char *name) const {
+    size_t len;
+    const uint32_t hash = AAtomizer::Hash(name, &len);
+    return findItemIndex(name, len, hash);
+}
+
+static void addToIndex(std::vector<uint16_t> &index, uint32_t hash, size_t itemIndex) {
+    const size_t mask = index.size() - 1;
+    size_t slot = hash & mask;
+    while (index[slot] != 0) {
+        slot = (slot + 1) & mask;
+    }
+    index[slot] = itemIndex + 1;
+}
+
+void AMessage::updateIndex() {
+    mIndex.clear();
+    if (mItems.size() <= kMinIndexedItems) {
+        return;
+    }
+    size_t size = 4 * kMinIndexedItems;
+    while (size < 2 * mItems.size()) {
+        size *= 2;
+    }
+    mIndex.assign(size, 0);
+    for (size_t i = 0; i < mItems.size(); ++i) {
+        addToIndex(mIndex, mItems[i].mNameHash, i);
+    }
+}
+
+void AMessage::indexLastItem() {
+    if (mItems.size() <= kMinIndexedItems) {
+        return;
+    }
+    if (mIndex.size() < 2 * mItems.size()) {
+        updateIndex();
+        return;
+    }
+    addToIndex(mIndex, mItems.back().mNameHash, mItems.size() - 1);
+}
+
 // assumes item's name was uninitialized or NULL
-void AMessage::Item::setName(const char *name, size_t len) {
+void AMessage::Item::setName(const char *name, size_t len, uint32_t hash, bool atomize) {
     mNameLength = len;
-    mName = new char[len + 1];
-    memcpy((void*)mName, name, len + 1);
+    mNameHash = hash;
+    mName = atomize ? AAtomizer::TryAtomize(name, hash) : NULL;
+    mNameIsAtom = mName != NULL;
+    if (!mNameIsAtom) {
+        char *copy = new char[len + 1];
+        memcpy(copy, name, len + 1);
+        mName = copy;
+    }
 }
 
-AMessage::Item::Item(const char *name, size_t len)
+void AMessage::Item::freeName() {
+    if (!mNameIsAtom) {
+        delete[] mName;
+    }
+    mName = NULL;
+    mNameIsAtom = false;
+}
+
+AMessage::Item::Item(const char *name, size_t len, uint32_t hash)
     : mType(kTypeInt32) {
-    // mName and mNameLength are initialized by setName
-    setName(name, len);
+    // mName, mNameLength, mNameHash and mNameIsAtom are initialized by setName
+    setName(name, len, hash, true /* atomize */);
 }
 
 AMessage::Item *AMessage::allocateItem(const char *name) {
-    size_t len = strlen(name);
-    size_t i = findItemIndex(name, len);
+    size_t len;
+    const uint32_t hash = AAtomizer::Hash(name, &len);
+    size_t i = findItemIndex(name, len, hash);
     Item *item;
 
     if (i < mItems.size()) {
@@ -202,9 +278,14 @@ AMessage::Item *AMessage::allocateItem(const char *name) {
         freeItemValue(item);
     } else {
         CHECK(mItems.size() < kMaxNumItems);
+        if (mItems.capacity() == 0) {
+            // avoid growing the vector item by item
+            mItems.reserve(kInitialNumItems);
+        }
         i = mItems.size();
         // place a 'blank' item at the end - this is of type kTypeInt32
-        mItems.emplace_back(name, len);
+        mItems.emplace_back(name, len, hash);
+        indexLastItem();
         item = &mItems[i];
     }
 
@@ -213,7 +294,7 @@ AMessage::Item *AMessage::allocateItem(const char *name) {
 
 const AMessage::Item *AMessage::findItem(
         const char *name, Type type) const {
-    size_t i = findItemIndex(name, strlen(name));
+    size_t i = findItemIndex(name);
     if (i < mItems.size()) {
         const Item *item = &mItems[i];
         return item->mType == type ? item : NULL;
@@ -223,7 +304,7 @@ const AMessage::Item *AMessage::findItem(
 }
 
 bool AMessage::findAsFloat(const char *name, float *value) const {
-    size_t i = findItemIndex(name, strlen(name));
+    size_t i = findItemIndex(name);
     if (i < mItems.size()) {
         const Item *item = &mItems[i];
         switch (item->mType) {
@@ -250,7 +331,7 @@ bool AMessage::findAsFloat(const char *name, float *value) const {
 }
 
 bool AMessage::findAsInt64(const char *name, int64_t *value) const {
-    size_t i = findItemIndex(name, strlen(name));
+    size_t i = findItemIndex(name);
     if (i < mItems.size()) {
         const Item *item = &mItems[i];
         switch (item->mType) {
@@ -268,7 +349,7 @@ bool AMessage::findAsInt64(const char *name, int64_t *value) const {
 }
 
 bool AMessage::contains(const char *name) const {
-    size_t i = findItemIndex(name, strlen(name));
+    size_t i = findItemIndex(name);
     return i < mItems.size();
 }
 
@@ -419,6 +500,18 @@ void AMessage::deliver() {
     handler->deliverMessage(this);
 }
 
+// static
+void AMessage::deliver(const std::vector<sp<AMessage>> &msgs) {
+    sp<AHandler> handler = msgs.front()->mHandler.promote();
+    if (handler == NULL) {
+        ALOGW("failed to deliver %zu messages as target handler %d is gone.",
+                msgs.size(), msgs.front()->mTarget);
+        return;
+    }
+
+    handler->deliverMessages(msgs);
+}
+
 status_t AMessage::post(int64_t delayUs) {
     sp<ALooper> looper = mLooper.promote();
     if (looper == NULL) {
@@ -491,6 +584,7 @@ bool AMessage::senderAwaitsResponse(sp<AReplyToken> *replyToken) {
 sp<AMessage> AMessage::dup() const {
     sp<AMessage> msg = new AMessage(mWhat, mHandler.promote());
     msg->mItems = mItems;
+    msg->mIndex = mIndex;
 
 #ifdef DUMP_STATS
     {
@@ -505,7 +599,9 @@ sp<AMessage> AMessage::dup() const {
         const Item *from = &mItems[i];
         Item *to = &msg->mItems[i];
 
-        to->setName(from->mName, from->mNameLength);
+        if (!from->mNameIsAtom) {
+            to->setName(from->mName, from->mNameLength, from->mNameHash, false /* atomize */);
+        }
         to->mType = from->mType;
 
         switch (from->mType) {
@@ -771,8 +867,12 @@ sp<AMessage> AMessage::FromParcel(const Parcel &parcel, size_t maxNestingLevel)
             }
         }
 
-        item->setName(name, strlen(name));
+        // names from other processes are not atomized so that they cannot fill the atomizer
+        size_t len;
+        const uint32_t hash = AAtomizer::Hash(name, &len);
+        item->setName(name, len, hash, false /* atomize */);
     }
+    msg->updateIndex();
 
     return msg;
 }
@@ -1022,13 +1122,14 @@ status_t AMessage::setEntryNameAt(size_t index, const char *name) {
     if (!strcmp(name, mItems[index].mName)) {
         return OK; // name has not changed
     }
-    size_t len = strlen(name);
-    if (findItemIndex(name, len) < mItems.size()) {
+    size_t len;
+    const uint32_t hash = AAtomizer::Hash(name, &len);
+    if (findItemIndex(name, len, hash) < mItems.size()) {
         return ALREADY_EXISTS;
     }
-    delete[] mItems[index].mName;
-    mItems[index].mName = nullptr;
-    mItems[index].setName(name, len);
+    mItems[index].freeName();
+    mItems[index].setName(name, len, hash, true /* atomize */);
+    updateIndex();
     return OK;
 }
 
@@ -1091,8 +1192,7 @@ status_t AMessage::removeEntryAt(size_t index) {
         return BAD_INDEX;
     }
     // delete entry data and objects
-    delete[] mItems[index].mName;
-    mItems[index].mName = nullptr;
+    mItems[index].freeName();
     freeItemValue(&mItems[index]);
 
     // swap entry with last entry and clear last entry's data
@@ -1100,9 +1200,11 @@ status_t AMessage::removeEntryAt(size_t index) {
     if (index < lastIndex) {
         mItems[index] = mItems[lastIndex];
         mItems[lastIndex].mName = nullptr;
+        mItems[lastIndex].mNameIsAtom = false;
         mItems[lastIndex].mType = kTypeInt32;
     }
     mItems.pop_back();
+    updateIndex();
     return OK;
 }
 
@@ -1146,7 +1248,7 @@ void AMessage::extend(const sp<AMessage> &other) {
 }
 
 size_t AMessage::findEntryByName(const char *name) const {
-    return name == nullptr ? countEntries() : findItemIndex(name, strlen(name));
+    return name == nullptr ? countEntries() : findItemIndex(name);
 }
 
 }  // namespace android
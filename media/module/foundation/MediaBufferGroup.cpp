@@ -17,12 +17,18 @@
 #define LOG_TAG "MediaBufferGroup"
 #include <utils/Log.h>
 
-#include <list>
+#include <inttypes.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <vector>
 
 #include <binder/MemoryDealer.h>
 #include <media/stagefright/foundation/ADebug.h>
 #include <media/stagefright/MediaBuffer.h>
 #include <media/stagefright/MediaBufferGroup.h>
+#include <utils/String8.h>
 #include <utils/threads.h>
 
 namespace android {
@@ -36,11 +42,96 @@ constexpr T MIN(const T &a, const T &b) { return a <= b ? a : b; }
 static const size_t kSharedMemoryThreshold = MIN(
         (size_t)MediaBuffer::kSharedMemThreshold, (size_t)(4 * 1024));
 
+// Buffers are kept in size classes by the bit width of their size, so that
+// acquire_buffer() only looks at the buffers which may be large enough.
+static constexpr size_t kNumSizeClasses = sizeof(size_t) * 8 + 1;
+
+static size_t sizeClass(size_t size) {
+    return size == 0 ? 0 : sizeof(size_t) * 8 - __builtin_clzl(size);
+}
+
 struct MediaBufferGroup::InternalData {
     Mutex mLock;
     Condition mCondition;
     size_t mGrowthLimit;  // Do not automatically grow group larger than this.
-    std::list<MediaBufferBase *> mBuffers;
+    size_t mNumBuffers = 0;
+    std::vector<MediaBufferBase *> mBuffers[kNumSizeClasses];
+
+    // Number of acquire_buffer() calls blocked or about to block. Returned buffers only
+    // take the lock to signal them.
+    std::atomic<int32_t> mWaiters{0};
+
+    // Memory of the caller for the next acquire_buffer(), see setDestination(). The
+    // buffer wrapping it is kept, so that tracks always see the same buffer object.
+    void *mDestination = nullptr;
+    size_t mDestinationSize = 0;
+    MediaBuffer *mDestinationBuffer = nullptr;
+
+    // Statistics for dump(), protected by mLock.
+    uint64_t mAcquireCount = 0;
+    uint64_t mAllocateCount = 0;
+    uint64_t mReallocateCount = 0;
+    uint64_t mWaitCount = 0;
+    uint64_t mWouldBlockCount = 0;
+    uint64_t mInPlaceCount = 0;
+    nsecs_t mWaitTimeNs = 0;
+    nsecs_t mMaxWaitTimeNs = 0;
+
+    void add_l(MediaBufferBase *buffer) {
+        mBuffers[sizeClass(buffer->size())].emplace_back(buffer);
+        ++mNumBuffers;
+    }
+
+    void remove_l(size_t sizeClass, size_t index) {
+        std::vector<MediaBufferBase *> &buffers = mBuffers[sizeClass];
+        buffers[index] = buffers.back();
+        buffers.pop_back();
+        --mNumBuffers;
+    }
+
+    // Returns a free buffer of at least requestedSize, from the smallest size class.
+    MediaBufferBase *findFree_l(size_t requestedSize) const {
+        for (size_t c = sizeClass(requestedSize); c < kNumSizeClasses; ++c) {
+            for (MediaBufferBase *buffer : mBuffers[c]) {
+                if (buffer->refcount() == 0 && buffer->size() >= requestedSize) {
+                    return buffer;
+                }
+            }
+        }
+        return nullptr;
+    }
+
+    // Finds the smallest free buffer, which is too small for requestedSize if
+    // findFree_l() failed. Returns false if all buffers are in use.
+    bool findSmallestFree_l(size_t requestedSize, size_t *sizeClass, size_t *index) const {
+        size_t smallest = requestedSize;
+        bool found = false;
+        for (size_t c = 0; c < kNumSizeClasses && !found; ++c) {
+            for (size_t i = 0; i < mBuffers[c].size(); ++i) {
+                const size_t size = mBuffers[c][i]->size();
+                if (mBuffers[c][i]->refcount() == 0 && size < smallest) {
+                    smallest = size;
+                    *sizeClass = c;
+                    *index = i;
+                    found = true;
+                }
+            }
+        }
+        return found;
+    }
+
+    size_t biggest_l() const {
+        for (size_t c = kNumSizeClasses; c-- > 0;) {
+            size_t biggest = 0;
+            for (MediaBufferBase *buffer : mBuffers[c]) {
+                biggest = std::max(biggest, buffer->size());
+            }
+            if (!mBuffers[c].empty()) {
+                return biggest;
+            }
+        }
+        return 0;
+    }
 };
 
 MediaBufferGroup::MediaBufferGroup(size_t growthLimit)
@@ -102,27 +193,35 @@ void MediaBufferGroup::init(size_t buffers, size_t buffer_size, size_t growthLim
 }
 
 MediaBufferGroup::~MediaBufferGroup() {
-    for (MediaBufferBase *buffer : mInternal->mBuffers) {
-        if (buffer->refcount() != 0) {
-            const int localRefcount = buffer->localRefcount();
-            const int remoteRefcount = buffer->remoteRefcount();
-
-            // Fatal if we have a local refcount.
-            LOG_ALWAYS_FATAL_IF(localRefcount != 0,
-                    "buffer(%p) localRefcount %d != 0, remoteRefcount %d",
-                    buffer, localRefcount, remoteRefcount);
-
-            // Log an error if we have a remaining remote refcount,
-            // as the remote process may have died or may have inappropriate behavior.
-            // The shared memory associated with the MediaBuffer will
-            // automatically be reclaimed when there are no remaining fds
-            // associated with it.
-            ALOGE("buffer(%p) has residual remoteRefcount %d",
-                    buffer, remoteRefcount);
+    for (const std::vector<MediaBufferBase *> &buffers : mInternal->mBuffers) {
+        for (MediaBufferBase *buffer : buffers) {
+            if (buffer->refcount() != 0) {
+                const int localRefcount = buffer->localRefcount();
+                const int remoteRefcount = buffer->remoteRefcount();
+
+                // Fatal if we have a local refcount.
+                LOG_ALWAYS_FATAL_IF(localRefcount != 0,
+                        "buffer(%p) localRefcount %d != 0, remoteRefcount %d",
+                        buffer, localRefcount, remoteRefcount);
+
+                // Log an error if we have a remaining remote refcount,
+                // as the remote process may have died or may have inappropriate behavior.
+                // The shared memory associated with the MediaBuffer will
+                // automatically be reclaimed when there are no remaining fds
+                // associated with it.
+                ALOGE("buffer(%p) has residual remoteRefcount %d",
+                        buffer, remoteRefcount);
+            }
+            // gracefully delete.
+            buffer->setObserver(nullptr);
+            buffer->release();
         }
-        // gracefully delete.
-        buffer->setObserver(nullptr);
-        buffer->release();
+    }
+    if (mInternal->mDestinationBuffer != nullptr) {
+        LOG_ALWAYS_FATAL_IF(mInternal->mDestinationBuffer->refcount() != 0,
+                "destination buffer(%p) still in use", mInternal->mDestinationBuffer);
+        mInternal->mDestinationBuffer->setObserver(nullptr);
+        mInternal->mDestinationBuffer->release();
     }
     delete mInternal;
     delete mWrapper;
@@ -132,64 +231,72 @@ void MediaBufferGroup::add_buffer(MediaBufferBase *buffer) {
     Mutex::Autolock autoLock(mInternal->mLock);
 
     // if we're above our growth limit, release buffers if we can
-    for (auto it = mInternal->mBuffers.begin();
-            mInternal->mGrowthLimit > 0
-            && mInternal->mBuffers.size() >= mInternal->mGrowthLimit
-            && it != mInternal->mBuffers.end();) {
-        if ((*it)->refcount() == 0) {
-            (*it)->setObserver(nullptr);
-            (*it)->release();
-            it = mInternal->mBuffers.erase(it);
-        } else {
-            ++it;
+    for (size_t c = 0; c < kNumSizeClasses; ++c) {
+        std::vector<MediaBufferBase *> &buffers = mInternal->mBuffers[c];
+        for (size_t i = 0; mInternal->mGrowthLimit > 0
+                && mInternal->mNumBuffers >= mInternal->mGrowthLimit
+                && i < buffers.size();) {
+            if (buffers[i]->refcount() == 0) {
+                buffers[i]->setObserver(nullptr);
+                buffers[i]->release();
+                mInternal->remove_l(c, i);
+            } else {
+                ++i;
+            }
         }
     }
 
     buffer->setObserver(this);
-    mInternal->mBuffers.emplace_back(buffer);
+    mInternal->add_l(buffer);
 }
 
 bool MediaBufferGroup::has_buffers() {
-    if (mInternal->mBuffers.size() < mInternal->mGrowthLimit) {
+    Mutex::Autolock autoLock(mInternal->mLock);
+    if (mInternal->mNumBuffers < mInternal->mGrowthLimit) {
         return true; // We can add more buffers internally.
     }
-    for (MediaBufferBase *buffer : mInternal->mBuffers) {
-        if (buffer->refcount() == 0) {
-            return true;
-        }
-    }
-    return false;
+    return mInternal->findFree_l(0 /* requestedSize */) != nullptr;
 }
 
 status_t MediaBufferGroup::acquire_buffer(
         MediaBufferBase **out, bool nonBlocking, size_t requestedSize) {
     Mutex::Autolock autoLock(mInternal->mLock);
+    bool waiting = false;
+    nsecs_t waitStartNs = 0;
+    if (mInternal->mDestination != nullptr
+            && mInternal->mDestinationSize >=
+                    (requestedSize == 0 ? mInternal->biggest_l() : requestedSize)) {
+        MediaBuffer *buffer = mInternal->mDestinationBuffer;
+        if (buffer == nullptr) {
+            buffer = new MediaBuffer(mInternal->mDestination, mInternal->mDestinationSize);
+            buffer->setObserver(this);
+            mInternal->mDestinationBuffer = buffer;
+        } else {
+            buffer->mData = mInternal->mDestination;
+            buffer->mSize = mInternal->mDestinationSize;
+        }
+        mInternal->mDestination = nullptr;
+        mInternal->mDestinationSize = 0;
+        ++mInternal->mAcquireCount;
+        ++mInternal->mInPlaceCount;
+        buffer->add_ref();
+        buffer->reset();
+        *out = buffer;
+        return OK;
+    }
     for (;;) {
-        size_t smallest = requestedSize;
-        size_t biggest = requestedSize;
-        MediaBufferBase *buffer = nullptr;
-        auto free = mInternal->mBuffers.end();
-        for (auto it = mInternal->mBuffers.begin(); it != mInternal->mBuffers.end(); ++it) {
-            const size_t size = (*it)->size();
-            if (size > biggest) {
-                biggest = size;
-            }
-            if ((*it)->refcount() == 0) {
-                if (size >= requestedSize) {
-                    buffer = *it;
-                    break;
-                }
-                if (size < smallest) {
-                    smallest = size; // always free the smallest buf
-                    free = it;
-                }
-            }
+        MediaBufferBase *buffer = mInternal->findFree_l(requestedSize);
+        size_t freeClass = 0;
+        size_t freeIndex = 0;
+        bool hasFree = false;
+        if (buffer == nullptr) {
+            hasFree = mInternal->findSmallestFree_l(requestedSize, &freeClass, &freeIndex);
         }
         if (buffer == nullptr
-                && (free != mInternal->mBuffers.end()
-                    || mInternal->mBuffers.size() < mInternal->mGrowthLimit)) {
+                && (hasFree || mInternal->mNumBuffers < mInternal->mGrowthLimit)) {
             // We alloc before we free so failure leaves group unchanged.
-            const size_t allocateSize = requestedSize == 0 ? biggest :
+            const size_t allocateSize = requestedSize == 0 ?
+                    mInternal->biggest_l() :
                     requestedSize < SIZE_MAX / 3 * 2 /* NB: ordering */ ?
                     requestedSize * 3 / 2 : requestedSize;
             buffer = new MediaBuffer(allocateSize);
@@ -199,28 +306,50 @@ status_t MediaBufferGroup::acquire_buffer(
                 buffer = nullptr;
             } else {
                 buffer->setObserver(this);
-                if (free != mInternal->mBuffers.end()) {
+                if (hasFree) {
+                    MediaBufferBase *smaller = mInternal->mBuffers[freeClass][freeIndex];
                     ALOGV("reallocate buffer, requested size %zu vs available %zu",
-                            requestedSize, (*free)->size());
-                    (*free)->setObserver(nullptr);
-                    (*free)->release();
-                    *free = buffer; // in-place replace
+                            requestedSize, smaller->size());
+                    smaller->setObserver(nullptr);
+                    smaller->release();
+                    mInternal->remove_l(freeClass, freeIndex);
+                    ++mInternal->mReallocateCount;
                 } else {
                     ALOGV("allocate buffer, requested size %zu", requestedSize);
-                    mInternal->mBuffers.emplace_back(buffer);
+                    ++mInternal->mAllocateCount;
                 }
+                mInternal->add_l(buffer);
             }
         }
         if (buffer != nullptr) {
+            if (waiting) {
+                mInternal->mWaiters.fetch_sub(1);
+                const nsecs_t waitNs = systemTime(SYSTEM_TIME_MONOTONIC) - waitStartNs;
+                mInternal->mWaitTimeNs += waitNs;
+                mInternal->mMaxWaitTimeNs = std::max(mInternal->mMaxWaitTimeNs, waitNs);
+            }
+            ++mInternal->mAcquireCount;
             buffer->add_ref();
             buffer->reset();
             *out = buffer;
             return OK;
         }
         if (nonBlocking) {
+            ++mInternal->mWouldBlockCount;
             *out = nullptr;
             return WOULD_BLOCK;
         }
+        if (!waiting) {
+            // Announce the wait, then check the buffers once more: a buffer returned
+            // after the first check either is seen by that check, or sees the waiter
+            // in signalBufferReturned() and signals.
+            waiting = true;
+            waitStartNs = systemTime(SYSTEM_TIME_MONOTONIC);
+            ++mInternal->mWaitCount;
+            mInternal->mWaiters.fetch_add(1);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            continue;
+        }
         // All buffers are in use, block until one of them is returned.
         mInternal->mCondition.wait(mInternal->mLock);
     }
@@ -228,12 +357,66 @@ status_t MediaBufferGroup::acquire_buffer(
 }
 
 size_t MediaBufferGroup::buffers() const {
-    return mInternal->mBuffers.size();
+    Mutex::Autolock autoLock(mInternal->mLock);
+    return mInternal->mNumBuffers;
 }
 
-void MediaBufferGroup::signalBufferReturned(MediaBufferBase *) {
+void MediaBufferGroup::setDestination(void *data, size_t size) {
+    Mutex::Autolock autoLock(mInternal->mLock);
+    if (mInternal->mDestinationBuffer != nullptr
+            && mInternal->mDestinationBuffer->refcount() != 0) {
+        // The previous sample read in place is not released yet.
+        ALOGV("destination buffer in use, using the buffers of the group");
+        return;
+    }
+    mInternal->mDestination = data;
+    mInternal->mDestinationSize = data != nullptr ? size : 0;
+}
+
+void MediaBufferGroup::clearDestination() {
+    Mutex::Autolock autoLock(mInternal->mLock);
+    mInternal->mDestination = nullptr;
+    mInternal->mDestinationSize = 0;
+}
+
+void MediaBufferGroup::signalBufferReturned(MediaBufferBase *buffer) {
+    // The local refcount of the buffer is already 0, so when nobody waits the next
+    // acquire_buffer() finds the buffer without a signal. Remote releases (nullptr)
+    // always signal, as their refcount is not ordered with mWaiters.
+    if (buffer != nullptr && mInternal->mWaiters.load() == 0) {
+        return;
+    }
     Mutex::Autolock autoLock(mInternal->mLock);
     mInternal->mCondition.signal();
 }
 
+void MediaBufferGroup::dump(int fd) const {
+    String8 s;
+    Mutex::Autolock autoLock(mInternal->mLock);
+    size_t used = 0;
+    for (const std::vector<MediaBufferBase *> &buffers : mInternal->mBuffers) {
+        for (MediaBufferBase *buffer : buffers) {
+            if (buffer->refcount() != 0) {
+                ++used;
+            }
+        }
+    }
+    s.appendFormat("  %zu buffers (%zu in use, growth limit %zu):",
+            mInternal->mNumBuffers, used, mInternal->mGrowthLimit);
+    for (size_t c = 0; c < kNumSizeClasses; ++c) {
+        if (!mInternal->mBuffers[c].empty()) {
+            s.appendFormat(" %zu of <%zu bytes", mInternal->mBuffers[c].size(),
+                    c < sizeof(size_t) * 8 ? (size_t)1 << c : SIZE_MAX);
+        }
+    }
+    s.appendFormat("\n  %" PRIu64 " acquired (%" PRIu64 " in place), %" PRIu64 " allocated, "
+            "%" PRIu64 " reallocated, %" PRIu64 " would block\n",
+            mInternal->mAcquireCount, mInternal->mInPlaceCount, mInternal->mAllocateCount,
+            mInternal->mReallocateCount, mInternal->mWouldBlockCount);
+    s.appendFormat("  %" PRIu64 " waits, total %" PRId64 " us, max %" PRId64 " us\n",
+            mInternal->mWaitCount, mInternal->mWaitTimeNs / 1000,
+            mInternal->mMaxWaitTimeNs / 1000);
+    (void)write(fd, s.string(), s.size());
+}
+
 }  // namespace android
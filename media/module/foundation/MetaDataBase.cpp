@@ -24,6 +24,8 @@
 #include <string.h>
 
 #include <mutex>
+#include <utility>
+#include <vector>
 
 #include <media/stagefright/foundation/ADebug.h>
 #include <media/stagefright/foundation/AString.h>
@@ -53,9 +55,12 @@ private:
     uint32_t mType;
     size_t mSize;
 
+    // int64_t, pointer and rect values are stored inline, only strings and raw data
+    // larger than the reservoir are allocated.
     union {
         void *ext_data;
-        float reservoir;
+        int64_t align;
+        uint8_t reservoir[16];
     } u;
 
     bool usesReservoir() const {
@@ -66,11 +71,11 @@ private:
     void freeStorage();
 
     void *storage() {
-        return usesReservoir() ? &u.reservoir : u.ext_data;
+        return usesReservoir() ? u.reservoir : u.ext_data;
     }
 
     const void *storage() const {
-        return usesReservoir() ? &u.reservoir : u.ext_data;
+        return usesReservoir() ? u.reservoir : u.ext_data;
     }
 };
 
@@ -79,9 +84,88 @@ struct MetaDataBase::Rect {
 };
 
 
+// Keys set on every sample buffer, kept in fixed slots so that the per sample metadata
+// does not touch the item vector. Sorted by value, to list all keys in order.
+static constexpr uint32_t kSlotKeys[] = {
+    kKeyDecodingTime,
+    kKeyDuration,
+    kKeyLastSampleIndexInChunk,
+    kKeySampleFileOffset,
+    kKeyIsSyncFrame,
+    kKeyTargetTime,
+    kKeyTime,
+};
+static constexpr size_t kNumSlots = sizeof(kSlotKeys) / sizeof(kSlotKeys[0]);
+
+static constexpr bool slotKeysAreSorted() {
+    for (size_t i = 1; i < kNumSlots; ++i) {
+        if (kSlotKeys[i - 1] >= kSlotKeys[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+static_assert(slotKeysAreSorted(), "kSlotKeys must be sorted");
+
+static ssize_t slotForKey(uint32_t key) {
+    switch (key) {
+        case kKeyDecodingTime:           return 0;
+        case kKeyDuration:               return 1;
+        case kKeyLastSampleIndexInChunk: return 2;
+        case kKeySampleFileOffset:       return 3;
+        case kKeyIsSyncFrame:            return 4;
+        case kKeyTargetTime:             return 5;
+        case kKeyTime:                   return 6;
+        default:                         return -1;
+    }
+}
+
 struct MetaDataBase::MetaDataInternal {
     std::mutex mLock;
+    // bit i is set when mSlots[i] holds the value of kSlotKeys[i]
+    uint32_t mSlotMask = 0;
+    MetaDataBase::typed_data mSlots[kNumSlots];
     KeyedVector<uint32_t, MetaDataBase::typed_data> mItems;
+
+    void copyFrom(const MetaDataInternal &from) {
+        mSlotMask = from.mSlotMask;
+        for (size_t i = 0; i < kNumSlots; ++i) {
+            if (mSlotMask & (1u << i)) {
+                mSlots[i] = from.mSlots[i];
+            } else {
+                mSlots[i].clear();
+            }
+        }
+        mItems = from.mItems;
+    }
+
+    const MetaDataBase::typed_data *find_l(uint32_t key) const {
+        ssize_t slot = slotForKey(key);
+        if (slot >= 0) {
+            return (mSlotMask & (1u << slot)) ? &mSlots[slot] : nullptr;
+        }
+        ssize_t i = mItems.indexOfKey(key);
+        return i < 0 ? nullptr : &mItems.valueAt(i);
+    }
+
+    // All items in key order, slots included.
+    std::vector<std::pair<uint32_t, const MetaDataBase::typed_data *>> items_l() const {
+        std::vector<std::pair<uint32_t, const MetaDataBase::typed_data *>> items;
+        items.reserve(kNumSlots + mItems.size());
+        size_t slot = 0;
+        for (size_t i = 0; i <= mItems.size(); ++i) {
+            const bool last = i == mItems.size();
+            for (; slot < kNumSlots && (last || kSlotKeys[slot] < mItems.keyAt(i)); ++slot) {
+                if (mSlotMask & (1u << slot)) {
+                    items.emplace_back(kSlotKeys[slot], &mSlots[slot]);
+                }
+            }
+            if (!last) {
+                items.emplace_back(mItems.keyAt(i), &mItems.valueAt(i));
+            }
+        }
+        return items;
+    }
 };
 
 
@@ -91,11 +175,13 @@ MetaDataBase::MetaDataBase()
 
 MetaDataBase::MetaDataBase(const MetaDataBase &from)
     : mInternalData(new MetaDataInternal()) {
-    mInternalData->mItems = from.mInternalData->mItems;
+    mInternalData->copyFrom(*from.mInternalData);
 }
 
 MetaDataBase& MetaDataBase::operator = (const MetaDataBase &rhs) {
-    this->mInternalData->mItems = rhs.mInternalData->mItems;
+    if (this != &rhs) {
+        this->mInternalData->copyFrom(*rhs.mInternalData);
+    }
     return *this;
 }
 
@@ -106,11 +192,32 @@ MetaDataBase::~MetaDataBase() {
 
 void MetaDataBase::clear() {
     std::lock_guard<std::mutex> guard(mInternalData->mLock);
-    mInternalData->mItems.clear();
+    // Slots keep their inline storage, so that a reused buffer (see MediaBuffer::reset())
+    // does not allocate for the metadata of the next sample.
+    for (size_t i = 0; i < kNumSlots; ++i) {
+        if (mInternalData->mSlotMask & (1u << i)) {
+            mInternalData->mSlots[i].clear();
+        }
+    }
+    mInternalData->mSlotMask = 0;
+    // VectorImpl::clear() reallocates the storage even when the vector is empty
+    if (!mInternalData->mItems.isEmpty()) {
+        mInternalData->mItems.clear();
+    }
 }
 
 bool MetaDataBase::remove(uint32_t key) {
     std::lock_guard<std::mutex> guard(mInternalData->mLock);
+    ssize_t slot = slotForKey(key);
+    if (slot >= 0) {
+        if (!(mInternalData->mSlotMask & (1u << slot))) {
+            return false;
+        }
+        mInternalData->mSlots[slot].clear();
+        mInternalData->mSlotMask &= ~(1u << slot);
+        return true;
+    }
+
     ssize_t i = mInternalData->mItems.indexOfKey(key);
 
     if (i < 0) {
@@ -258,6 +365,14 @@ bool MetaDataBase::setData(
     bool overwrote_existing = true;
 
     std::lock_guard<std::mutex> guard(mInternalData->mLock);
+    ssize_t slot = slotForKey(key);
+    if (slot >= 0) {
+        overwrote_existing = (mInternalData->mSlotMask & (1u << slot)) != 0;
+        mInternalData->mSlotMask |= 1u << slot;
+        mInternalData->mSlots[slot].setData(type, data, size);
+        return overwrote_existing;
+    }
+
     ssize_t i = mInternalData->mItems.indexOfKey(key);
     if (i < 0) {
         typed_data item;
@@ -276,28 +391,20 @@ bool MetaDataBase::setData(
 bool MetaDataBase::findData(uint32_t key, uint32_t *type,
                         const void **data, size_t *size) const {
     std::lock_guard<std::mutex> guard(mInternalData->mLock);
-    ssize_t i = mInternalData->mItems.indexOfKey(key);
+    const typed_data *item = mInternalData->find_l(key);
 
-    if (i < 0) {
+    if (item == nullptr) {
         return false;
     }
 
-    const typed_data &item = mInternalData->mItems.valueAt(i);
-
-    item.getData(type, data, size);
+    item->getData(type, data, size);
 
     return true;
 }
 
 bool MetaDataBase::hasData(uint32_t key) const {
     std::lock_guard<std::mutex> guard(mInternalData->mLock);
-    ssize_t i = mInternalData->mItems.indexOfKey(key);
-
-    if (i < 0) {
-        return false;
-    }
-
-    return true;
+    return mInternalData->find_l(key) != nullptr;
 }
 
 MetaDataBase::typed_data::typed_data()
@@ -362,7 +469,7 @@ void *MetaDataBase::typed_data::allocateStorage(size_t size) {
     mSize = size;
 
     if (usesReservoir()) {
-        return &u.reservoir;
+        return u.reservoir;
     }
 
     u.ext_data = malloc(mSize);
@@ -438,11 +545,12 @@ static void MakeFourCCString(uint32_t x, char *s) {
 String8 MetaDataBase::toString() const {
     String8 s;
     std::lock_guard<std::mutex> guard(mInternalData->mLock);
-    for (int i = mInternalData->mItems.size(); --i >= 0;) {
-        int32_t key = mInternalData->mItems.keyAt(i);
+    const auto items = mInternalData->items_l();
+    for (int i = items.size(); --i >= 0;) {
+        int32_t key = items[i].first;
         char cc[5];
         MakeFourCCString(key, cc);
-        const typed_data &item = mInternalData->mItems.valueAt(i);
+        const typed_data &item = *items[i].second;
         s.appendFormat("%s: %s", cc, item.asString(false).string());
         if (i != 0) {
             s.append(", ");
@@ -453,11 +561,12 @@ String8 MetaDataBase::toString() const {
 
 void MetaDataBase::dumpToLog() const {
     std::lock_guard<std::mutex> guard(mInternalData->mLock);
-    for (int i = mInternalData->mItems.size(); --i >= 0;) {
-        int32_t key = mInternalData->mItems.keyAt(i);
+    const auto items = mInternalData->items_l();
+    for (int i = items.size(); --i >= 0;) {
+        int32_t key = items[i].first;
         char cc[5];
         MakeFourCCString(key, cc);
-        const typed_data &item = mInternalData->mItems.valueAt(i);
+        const typed_data &item = *items[i].second;
         ALOGI("%s: %s", cc, item.asString(true /* verbose */).string());
     }
 }
@@ -466,14 +575,15 @@ void MetaDataBase::dumpToLog() const {
 status_t MetaDataBase::writeToParcel(Parcel &parcel) {
     status_t ret;
     std::lock_guard<std::mutex> guard(mInternalData->mLock);
-    size_t numItems = mInternalData->mItems.size();
+    const auto items = mInternalData->items_l();
+    size_t numItems = items.size();
     ret = parcel.writeUint32(uint32_t(numItems));
     if (ret) {
         return ret;
     }
     for (size_t i = 0; i < numItems; i++) {
-        int32_t key = mInternalData->mItems.keyAt(i);
-        const typed_data &item = mInternalData->mItems.valueAt(i);
+        int32_t key = items[i].first;
+        const typed_data &item = *items[i].second;
         uint32_t type;
         const void *data;
         size_t size;
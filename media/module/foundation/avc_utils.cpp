@@ -18,6 +18,7 @@
 #define LOG_TAG "avc_utils"
 #include <utils/Log.h>
 
+#include <string.h>
 
 #include <media/stagefright/foundation/ABitReader.h>
 #include <media/stagefright/foundation/ADebug.h>
@@ -31,10 +32,8 @@
 namespace android {
 
 unsigned parseUE(ABitReader *br) {
-    unsigned numZeroes = 0;
-    while (br->getBits(1) == 0) {
-        ++numZeroes;
-    }
+    uint32_t numZeroes;
+    CHECK(br->skipLeadingZeroBits(&numZeroes));
 
     unsigned x = br->getBits(numZeroes);
 
@@ -42,10 +41,9 @@ unsigned parseUE(ABitReader *br) {
 }
 
 unsigned parseUEWithFallback(ABitReader *br, unsigned fallback) {
-    unsigned numZeroes = 0;
-    while (br->getBitsWithFallback(1, 1) == 0) {
-        ++numZeroes;
-    }
+    // On over-read the zeros up to the end are counted, and reading the suffix fails below.
+    uint32_t numZeroes;
+    (void)br->skipLeadingZeroBits(&numZeroes);
     uint32_t x;
     if (numZeroes < 32) {
         if (br->getBitsGraceful(numZeroes, &x)) {
@@ -288,6 +286,15 @@ void FindAVCDimensions(
     }
 }
 
+// Returns the offset of the first |value| byte in data[offset, size), or size.
+static size_t findByte(const uint8_t *data, size_t offset, size_t size, uint8_t value) {
+    if (offset >= size) {
+        return size;
+    }
+    const uint8_t *found = (const uint8_t *)memchr(&data[offset], value, size - offset);
+    return found != NULL ? found - data : size;
+}
+
 status_t getNextNALUnit(
         const uint8_t **_data, size_t *_size,
         const uint8_t **nalStart, size_t *nalSize,
@@ -302,28 +309,27 @@ status_t getNextNALUnit(
         return -EAGAIN;
     }
 
-    size_t offset = 0;
-
     // A valid startcode consists of at least two 0x00 bytes followed by 0x01.
-    for (; offset + 2 < size; ++offset) {
-        if (data[offset + 2] == 0x01 && data[offset] == 0x00
-                && data[offset + 1] == 0x00) {
+    // Both searches jump between candidate 0x01 bytes with memchr(), which is
+    // much faster than a byte loop over long NAL units.
+    size_t offset = 2;
+    while ((offset = findByte(data, offset, size, 0x01)) < size) {
+        if (data[offset - 1] == 0x00 && data[offset - 2] == 0x00) {
             break;
         }
+        ++offset;
     }
-    if (offset + 2 >= size) {
-        *_data = &data[offset];
+    if (offset >= size) {
+        *_data = &data[size - 2];
         *_size = 2;
         return -EAGAIN;
     }
-    offset += 3;
+    ++offset;
 
     size_t startOffset = offset;
 
     for (;;) {
-        while (offset < size && data[offset] != 0x01) {
-            ++offset;
-        }
+        offset = findByte(data, offset, size, 0x01);
 
         if (offset == size) {
             if (startCodeFollows) {
@@ -360,6 +366,32 @@ status_t getNextNALUnit(
     return OK;
 }
 
+size_t RemoveEmulationPreventionBytes(uint8_t *data, size_t size) {
+    // Like getNextNALUnit(), jump between candidate 0x03 bytes with memchr(). Data is only
+    // moved once the first emulation_prevention_three_byte is found, and always backwards,
+    // so the bytes still to be checked are never overwritten.
+    size_t readOffset = 0;
+    size_t writeOffset = 0;
+    size_t offset = 2;
+    while ((offset = findByte(data, offset, size, 0x03)) < size) {
+        if (data[offset - 1] == 0x00 && data[offset - 2] == 0x00) {
+            if (writeOffset != readOffset) {
+                memmove(&data[writeOffset], &data[readOffset], offset - readOffset);
+            }
+            writeOffset += offset - readOffset;
+            readOffset = offset + 1;
+            // The next one needs two more zero bytes after this one.
+            offset += 3;
+        } else {
+            ++offset;
+        }
+    }
+    if (writeOffset != readOffset) {
+        memmove(&data[writeOffset], &data[readOffset], size - readOffset);
+    }
+    return size - (readOffset - writeOffset);
+}
+
 static sp<ABuffer> FindNAL(const uint8_t *data, size_t size, unsigned nalType) {
     const uint8_t *nalStart;
     size_t nalSize;
@@ -31,17 +31,30 @@ namespace android {
 struct AAtomizer {
     static const char *Atomize(const char *name);
 
+    // Same as Atomize() for a name with the given Hash(), but returns NULL instead of adding
+    // the name once kMaxAtoms names are known. Use this for names that are not from a fixed
+    // set, so that they cannot grow the table without bound.
+    static const char *TryAtomize(const char *name, uint32_t hash);
+
+    // Also returns the length of s if length is not NULL.
+    static uint32_t Hash(const char *s, size_t *length = NULL);
+
 private:
+    enum {
+        kNumBuckets = 256,
+        kMaxAtoms = 4096,
+    };
+
     static AAtomizer gAtomizer;
 
-    Mutex mLock;
+    // Atoms are only ever added, so lookups of existing atoms share the lock.
+    RWLock mLock;
     Vector<List<AString> > mAtoms;
+    size_t mNumAtoms;
 
     AAtomizer();
 
-    const char *atomize(const char *name);
-
-    static uint32_t Hash(const char *s);
+    const char *atomize(const char *name, uint32_t hash, bool limited);
 
     DISALLOW_EVIL_CONSTRUCTORS(AAtomizer);
 };
@@ -46,9 +46,15 @@ public:
     // Tries to skip |n| bits. Returns true iff successful. Skipping 0 bits will always succeed.
     bool skipBits(size_t n);
 
+    // Skips zero bits up to and including the next one bit, and stores the number of zero bits
+    // in |numZeros|. Returns false if the stream ends before a one bit, in which case all the
+    // remaining bits have been skipped and counted. This is the prefix of an Exp-Golomb code.
+    bool skipLeadingZeroBits(uint32_t *numZeros);
+
     // "Puts" |n| bits with the value |x| back virtually into the bit stream. The put-back bits
     // are not actually written into the data, but are tracked in a separate buffer that can
-    // store at most 32 bits. This is a no-op if the stream has already been over-read.
+    // store at most 64 bits. At most 32 bits can be put back per call. This is a no-op if the
+    // stream has already been over-read.
     void putBits(uint32_t x, size_t n);
 
     size_t numBitsLeft() const;
@@ -63,7 +69,7 @@ protected:
     const uint8_t *mData;
     size_t mSize;
 
-    uint32_t mReservoir;  // left-aligned bits
+    uint64_t mReservoir;  // left-aligned bits
     size_t mNumBitsLeft;
     bool mOverRead;
 
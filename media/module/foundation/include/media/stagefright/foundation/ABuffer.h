@@ -21,6 +21,8 @@
 #include <sys/types.h>
 #include <stdint.h>
 
+#include <new>
+
 #include <media/stagefright/foundation/ABase.h>
 #include <utils/RefBase.h>
 
@@ -48,6 +50,15 @@ struct ABuffer : public RefBase {
 
     sp<AMessage> meta();
 
+    // ABuffer objects and the data of small buffers may come from a slab cache,
+    // see ABuffer.cpp.
+    static void *operator new(size_t size);
+    static void *operator new(size_t size, const std::nothrow_t &) noexcept;
+    static void operator delete(void *p, size_t size);
+
+    // Writes the allocation counters of the slab cache.
+    static void dumpAllocatorStats(int fd);
+
 protected:
     virtual ~ABuffer();
 
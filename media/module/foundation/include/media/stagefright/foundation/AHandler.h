@@ -22,6 +22,8 @@
 #include <utils/KeyedVector.h>
 #include <utils/RefBase.h>
 
+#include <vector>
+
 namespace android {
 
 struct AMessage;
@@ -33,7 +35,10 @@ struct AHandler : public RefBase {
           mMessageCounter(0),
           mDeliveringMessage(false),
           mCurrentMessageWhat(0),
-          mCurrentMessageStartTimeUs(0){
+          mCurrentMessageStartTimeUs(0),
+          mBatchCounter(0),
+          mBatchedMessageCounter(0),
+          mMaxBatchSize(0) {
     }
 
     ALooper::handler_id id() const {
@@ -56,9 +61,13 @@ struct AHandler : public RefBase {
 protected:
     virtual void onMessageReceived(const sp<AMessage> &msg) = 0;
 
+    // Receives the messages of a type set with ALooper::setCoalescedMessage(), in delivery
+    // order. The default delivers them one by one to onMessageReceived().
+    virtual void onMessagesReceived(const std::vector<sp<AMessage>> &msgs);
+
 private:
-    friend struct AMessage;      // deliverMessage()
-    friend struct ALooperRoster; // setID()
+    friend struct AMessage;      // deliverMessage(), deliverMessages()
+    friend struct ALooperRoster; // setID(), dump()
 
     ALooper::handler_id mID;
     wp<ALooper> mLooper;
@@ -77,7 +86,13 @@ private:
     uint32_t  mCurrentMessageWhat;
     int64_t mCurrentMessageStartTimeUs;
 
+    // batched deliveries, cleared along with mMessageCounter
+    uint64_t mBatchCounter;
+    uint64_t mBatchedMessageCounter;
+    size_t mMaxBatchSize;
+
     void deliverMessage(const sp<AMessage> &msg);
+    void deliverMessages(const std::vector<sp<AMessage>> &msgs);
 
     void setDeliveryStatus(bool, uint32_t, int64_t);
     void getDeliveryStatus(bool&, uint32_t&, int64_t&);
@@ -26,6 +26,9 @@
 #include <utils/RefBase.h>
 #include <utils/threads.h>
 
+#include <utility>
+#include <vector>
+
 namespace android {
 
 struct AHandler;
@@ -44,6 +47,12 @@ struct ALooper : public RefBase {
     handler_id registerHandler(const sp<AHandler> &handler);
     void unregisterHandler(handler_id handlerID);
 
+    // Opt-in batched delivery. When a message of type |what| for the handler is delivered,
+    // the other pending messages of the same type for that handler which are already due are
+    // delivered with it, in order, in one AHandler::onMessagesReceived() call. These messages
+    // are delivered ahead of the other messages that became due before them.
+    void setCoalescedMessage(handler_id handlerID, uint32_t what, bool coalesce);
+
     status_t start(
             bool runOnCallingThread = false,
             bool canCallJava = false,
@@ -69,16 +78,32 @@ private:
 
     struct Event {
         int64_t mWhenUs;
+        uint64_t mSequence; // orders the events due at the same time by post order
         sp<AMessage> mMessage;
         sp<RefBase> mToken;
     };
 
+    // Heap order of mEventQueue, with the next event to deliver at the front.
+    struct EventAfter {
+        bool operator()(const Event &a, const Event &b) const {
+            return a.mWhenUs != b.mWhenUs ? a.mWhenUs > b.mWhenUs : a.mSequence > b.mSequence;
+        }
+    };
+
     Mutex mLock;
     Condition mQueueChangedCondition;
 
     AString mName;
 
-    List<Event> mEventQueue;
+    // Min-heap of the pending events. The vector keeps its storage after events are delivered,
+    // so a post does not allocate once the queue has reached its usual depth.
+    std::vector<Event> mEventQueue;
+    uint64_t mEventSequence;
+
+    // Limits the latency added to the other messages by a batch.
+    static constexpr size_t kMaxCoalescedMessages = 64;
+    // (handler, what) pairs set by setCoalescedMessage()
+    std::vector<std::pair<handler_id, uint32_t>> mCoalescedMessages;
 
     struct LooperThread;
     sp<LooperThread> mThread;
@@ -110,6 +135,11 @@ private:
 
     // END --- methods used only by AMessage
 
+    void pushEvent_l(int64_t whenUs, const sp<AMessage> &msg, const sp<RefBase> &token);
+
+    // Moves the due events to coalesce with |first| from the queue to |batch|.
+    void takeCoalescedEvents_l(const Event &first, int64_t nowUs, std::vector<Event> *batch);
+
     bool loop();
 
     DISALLOW_EVIL_CONSTRUCTORS(ALooper);
@@ -309,17 +309,38 @@ private:
         } u;
         const char *mName;
         size_t      mNameLength;
+        uint32_t    mNameHash;   // AAtomizer::Hash() of mName
+        bool        mNameIsAtom; // mName is owned by AAtomizer instead of by the item
         Type mType;
-        void setName(const char *name, size_t len);
-        Item() : mName(nullptr), mNameLength(0), mType(kTypeInt32) { }
-        Item(const char *name, size_t length);
+        void setName(const char *name, size_t len, uint32_t hash, bool atomize);
+        void freeName();
+        Item() : mName(nullptr), mNameLength(0), mNameHash(0), mNameIsAtom(false),
+                mType(kTypeInt32) { }
+        Item(const char *name, size_t length, uint32_t hash);
     };
 
     enum {
-        kMaxNumItems = 256
+        kMaxNumItems = 256,
+        // Storage reserved for the first items, most messages have no more.
+        kInitialNumItems = 8,
+        // Messages with more items than this also keep mIndex.
+        kMinIndexedItems = 16,
     };
     std::vector<Item> mItems;
 
+    /**
+     * Open addressing hash index of mItems, empty unless there are more than kMinIndexedItems
+     * items. Each slot holds an item index + 1, or 0 if empty. The size is a power of 2 and at
+     * least twice the number of items.
+     */
+    std::vector<uint16_t> mIndex;
+
+    /** Rebuilds mIndex after items were removed, renamed or added in bulk. */
+    void updateIndex();
+
+    /** Adds the last item of mItems to mIndex. */
+    void indexLastItem();
+
     /**
      * Allocates an item with the given key |name|. If the key already exists, the corresponding
      * item value is freed. Otherwise a new item is added.
@@ -349,10 +370,14 @@ private:
     void setObjectInternal(
             const char *name, const sp<RefBase> &obj, Type type);
 
-    size_t findItemIndex(const char *name, size_t len) const;
+    size_t findItemIndex(const char *name, size_t len, uint32_t hash) const;
+    size_t findItemIndex(const char *name) const;
 
     void deliver();
 
+    // Delivers messages for the same handler together.
+    static void deliver(const std::vector<sp<AMessage>> &msgs);
+
     DISALLOW_EVIL_CONSTRUCTORS(AMessage);
 };
 
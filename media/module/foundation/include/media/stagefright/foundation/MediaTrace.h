@@ -0,0 +1,78 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MEDIA_TRACE_H_
+#define MEDIA_TRACE_H_
+
+// Per buffer trace points along the media pipeline, from MediaCodec through the Codec2 client
+// and component to the renderer. Each point emits an empty slice named
+//
+//     MediaTrace:<stage> <name> ts=<timeUs> idx=<frameIndex>
+//
+// where |timeUs| is the client presentation time, which all stages carry, and |frameIndex| is
+// the Codec2 frame index or -1 where it is not known. Captures are analyzed by
+// media/tests/benchmark/scripts/media_trace_analysis.py.
+//
+// The categories are compiled out unless enabled for the module, like the HFR traces of the
+// camera service:
+//
+//     MEDIA_TRACE_ENABLE_CODEC   MediaCodec, CCodecBufferChannel, Codec2Client, components
+//     MEDIA_TRACE_ENABLE_RENDER  MediaCodec releaseOutputBuffer, NuPlayer renderer
+//
+// When enabled, a trace point costs a tag check unless the video tag is being captured.
+
+#if defined(MEDIA_TRACE_ENABLE_CODEC) || defined(MEDIA_TRACE_ENABLE_RENDER)
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <cutils/trace.h>
+
+namespace android {
+namespace media_trace {
+
+inline void mark(uint64_t tag, const char *stage, const char *name, int64_t timeUs,
+                 int64_t frameIndex) {
+    if (!atrace_is_tag_enabled(tag)) {
+        return;
+    }
+    char label[128];
+    snprintf(label, sizeof(label), "MediaTrace:%s %s ts=%lld idx=%lld", stage,
+             name == nullptr ? "-" : name, (long long)timeUs, (long long)frameIndex);
+    atrace_begin(tag, label);
+    atrace_end(tag);
+}
+
+}  // namespace media_trace
+}  // namespace android
+
+#endif
+
+#ifdef MEDIA_TRACE_ENABLE_CODEC
+#define MEDIA_TRACE_CODEC(stage, name, timeUs, frameIndex) \
+    ::android::media_trace::mark(ATRACE_TAG_VIDEO, stage, name, timeUs, frameIndex)
+#else
+#define MEDIA_TRACE_CODEC(stage, name, timeUs, frameIndex)
+#endif
+
+#ifdef MEDIA_TRACE_ENABLE_RENDER
+#define MEDIA_TRACE_RENDER(stage, name, timeUs, frameIndex) \
+    ::android::media_trace::mark(ATRACE_TAG_VIDEO, stage, name, timeUs, frameIndex)
+#else
+#define MEDIA_TRACE_RENDER(stage, name, timeUs, frameIndex)
+#endif
+
+#endif  // MEDIA_TRACE_H_
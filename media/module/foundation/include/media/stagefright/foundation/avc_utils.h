@@ -80,6 +80,10 @@ status_t getNextNALUnit(
         const uint8_t **nalStart, size_t *nalSize,
         bool startCodeFollows = false);
 
+// Removes the emulation_prevention_three_bytes from the NAL unit payload in |data|, in place,
+// and returns the new size. Applies to both AVC and HEVC.
+size_t RemoveEmulationPreventionBytes(uint8_t *data, size_t size);
+
 sp<ABuffer> MakeAVCCodecSpecificData(
         const sp<ABuffer> &accessUnit, int32_t *width, int32_t *height,
         int32_t *sarWidth = nullptr, int32_t *sarHeight = nullptr);
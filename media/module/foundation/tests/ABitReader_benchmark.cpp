@@ -0,0 +1,215 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Benchmark of the bit level parsing of AVC and HEVC elementary streams: NAL unit splitting,
+// Exp-Golomb parsing with emulation prevention, and unescaping NAL units.
+//
+// The streams are the Annex B files installed next to the benchmark, see Android.bp.
+
+#include <limits.h>
+#include <unistd.h>
+
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <media/stagefright/foundation/ABitReader.h>
+#include <media/stagefright/foundation/ABuffer.h>
+#include <media/stagefright/foundation/avc_utils.h>
+
+using namespace android;
+
+namespace {
+
+const char *const kStreams[] = {
+    "bbb_avc_176x144_300kbps_60fps.h264",
+    "bbb_avc_640x360_768kbps_30fps.h264",
+    "bbb_hevc_176x144_176kbps_60fps.hevc",
+    "bbb_hevc_640x360_1600kbps_30fps.hevc",
+};
+
+struct Stream {
+    std::vector<uint8_t> data;
+    std::vector<std::vector<uint8_t>> nalUnits;
+    // Parameter sets and SEI, whose whole payload is parsed bit by bit.
+    std::vector<std::vector<uint8_t>> headerNalUnits;
+};
+
+std::string resourceDir() {
+    std::string path;
+    char exe[PATH_MAX];
+    const ssize_t length = readlink("/proc/self/exe", exe, sizeof(exe) - 1);
+    if (length > 0) {
+        path.assign(exe, length);
+        path.resize(path.rfind('/') + 1);
+    }
+    return path;
+}
+
+const Stream &getStream(int index) {
+    static std::vector<Stream> streams = [] {
+        std::vector<Stream> result(std::size(kStreams));
+        const std::string dir = resourceDir();
+        for (size_t i = 0; i < std::size(kStreams); ++i) {
+            std::ifstream file(dir + kStreams[i], std::ios::binary);
+            Stream &stream = result[i];
+            stream.data.assign(std::istreambuf_iterator<char>(file),
+                               std::istreambuf_iterator<char>());
+            const bool hevc = std::string(kStreams[i]).find("hevc") != std::string::npos;
+            const uint8_t *data = stream.data.data();
+            size_t size = stream.data.size();
+            const uint8_t *nalStart;
+            size_t nalSize;
+            while (getNextNALUnit(&data, &size, &nalStart, &nalSize, true) == OK) {
+                if (nalSize < 2) {
+                    continue;
+                }
+                stream.nalUnits.emplace_back(nalStart, nalStart + nalSize);
+                const unsigned type = hevc ? (nalStart[0] >> 1) & 0x3f : nalStart[0] & 0x1f;
+                const bool header = hevc ? (type >= 32 && type <= 34) || type == 39 || type == 40
+                                         : (type >= 6 && type <= 8);
+                if (header) {
+                    stream.headerNalUnits.emplace_back(nalStart, nalStart + nalSize);
+                }
+            }
+        }
+        return result;
+    }();
+    return streams[index];
+}
+
+bool checkStream(benchmark::State &state, const Stream &stream) {
+    if (stream.nalUnits.empty()) {
+        state.SkipWithError("missing stream");
+        return false;
+    }
+    state.SetLabel(kStreams[state.range(0)]);
+    return true;
+}
+
+}  // namespace
+
+// Splits the whole stream into NAL units, as ESQueue and the IsIDR() checks of MPEG4Writer do.
+static void BM_GetNextNALUnit(benchmark::State &state) {
+    const Stream &stream = getStream(state.range(0));
+    if (!checkStream(state, stream)) {
+        return;
+    }
+    for (auto _ : state) {
+        const uint8_t *data = stream.data.data();
+        size_t size = stream.data.size();
+        const uint8_t *nalStart;
+        size_t nalSize;
+        while (getNextNALUnit(&data, &size, &nalStart, &nalSize, true) == OK) {
+            benchmark::DoNotOptimize(nalStart);
+        }
+    }
+    state.SetBytesProcessed(state.iterations() * stream.data.size());
+}
+
+// Reads Exp-Golomb codes through the whole payload of parameter sets and SEI, skipping
+// the emulation prevention bytes.
+static void BM_ParseUE(benchmark::State &state) {
+    const Stream &stream = getStream(state.range(0));
+    if (!checkStream(state, stream)) {
+        return;
+    }
+    size_t bytes = 0;
+    for (auto _ : state) {
+        for (const std::vector<uint8_t> &nal : stream.headerNalUnits) {
+            NALBitReader br(nal.data() + 1, nal.size() - 1);
+            while (!br.overRead()) {
+                benchmark::DoNotOptimize(parseUEWithFallback(&br, 0));
+                benchmark::DoNotOptimize(br.getBitsWithFallback(5, 0));
+            }
+            bytes += nal.size();
+        }
+    }
+    state.SetBytesProcessed(bytes);
+}
+
+// Reads all NAL units in fixed size fields, as the RTP assemblers and HevcUtils do.
+static void BM_NALBitReader(benchmark::State &state) {
+    const Stream &stream = getStream(state.range(0));
+    if (!checkStream(state, stream)) {
+        return;
+    }
+    size_t bytes = 0;
+    for (auto _ : state) {
+        for (const std::vector<uint8_t> &nal : stream.nalUnits) {
+            NALBitReader br(nal.data(), nal.size());
+            uint32_t value;
+            while (br.getBitsGraceful(13, &value)) {
+                benchmark::DoNotOptimize(value);
+            }
+            bytes += nal.size();
+        }
+    }
+    state.SetBytesProcessed(bytes);
+}
+
+// Unescapes copies of all NAL units in place. The copy is included in the time.
+static void BM_RemoveEmulationPreventionBytes(benchmark::State &state) {
+    const Stream &stream = getStream(state.range(0));
+    if (!checkStream(state, stream)) {
+        return;
+    }
+    std::vector<uint8_t> scratch;
+    size_t bytes = 0;
+    for (auto _ : state) {
+        for (const std::vector<uint8_t> &nal : stream.nalUnits) {
+            scratch = nal;
+            benchmark::DoNotOptimize(
+                    RemoveEmulationPreventionBytes(scratch.data(), scratch.size()));
+            bytes += nal.size();
+        }
+    }
+    state.SetBytesProcessed(bytes);
+}
+
+// Parses the first SPS of the AVC streams.
+static void BM_FindAVCDimensions(benchmark::State &state) {
+    const Stream &stream = getStream(state.range(0));
+    if (!checkStream(state, stream)) {
+        return;
+    }
+    sp<ABuffer> sps;
+    for (const std::vector<uint8_t> &nal : stream.headerNalUnits) {
+        if ((nal[0] & 0x1f) == 7) {
+            sps = ABuffer::CreateAsCopy(nal.data(), nal.size());
+            break;
+        }
+    }
+    if (sps == nullptr) {
+        state.SkipWithError("no SPS");
+        return;
+    }
+    int32_t width, height;
+    for (auto _ : state) {
+        FindAVCDimensions(sps, &width, &height);
+        benchmark::DoNotOptimize(width);
+    }
+}
+
+BENCHMARK(BM_GetNextNALUnit)->DenseRange(0, 3);
+BENCHMARK(BM_ParseUE)->DenseRange(0, 3);
+BENCHMARK(BM_NALBitReader)->DenseRange(0, 3);
+BENCHMARK(BM_RemoveEmulationPreventionBytes)->DenseRange(0, 3);
+BENCHMARK(BM_FindAVCDimensions)->DenseRange(0, 1);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,245 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <random>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include <media/stagefright/foundation/ABitReader.h>
+#include <media/stagefright/foundation/avc_utils.h>
+
+namespace android {
+
+namespace {
+
+// Bit at a time reader to check the results against.
+class ReferenceBitReader {
+public:
+    explicit ReferenceBitReader(const std::vector<uint8_t> &data) : mData(data) {}
+
+    bool getBits(size_t n, uint32_t *out) {
+        uint32_t result = 0;
+        for (size_t i = 0; i < n; ++i) {
+            if (mPosition == mData.size() * 8) {
+                return false;
+            }
+            result = (result << 1) | ((mData[mPosition / 8] >> (7 - mPosition % 8)) & 1);
+            ++mPosition;
+        }
+        *out = result;
+        return true;
+    }
+
+    size_t numBitsLeft() const { return mData.size() * 8 - mPosition; }
+
+private:
+    const std::vector<uint8_t> &mData;
+    size_t mPosition = 0;
+};
+
+std::vector<uint8_t> removeEmulationPrevention(const std::vector<uint8_t> &data) {
+    std::vector<uint8_t> result;
+    int numZeros = 0;
+    for (uint8_t byte : data) {
+        if (numZeros >= 2 && byte == 3) {
+            numZeros = 0;
+            continue;
+        }
+        numZeros = byte == 0 ? numZeros + 1 : 0;
+        result.push_back(byte);
+    }
+    return result;
+}
+
+// Random bytes with many zero and 0x03 bytes, like NAL units with emulation prevention.
+std::vector<uint8_t> makeNalLikeData(std::mt19937 &random, size_t size) {
+    std::vector<uint8_t> data(size);
+    for (uint8_t &byte : data) {
+        switch (random() % 4) {
+            case 0: byte = 0; break;
+            case 1: byte = 3; break;
+            default: byte = random(); break;
+        }
+    }
+    return data;
+}
+
+void appendBits(std::vector<bool> *bits, uint32_t value, size_t n) {
+    for (size_t i = n; i > 0; --i) {
+        bits->push_back((value >> (i - 1)) & 1);
+    }
+}
+
+}  // namespace
+
+TEST(ABitReaderTest, GetBitsMatchesReference) {
+    std::mt19937 random(42);
+    for (size_t size = 0; size < 40; ++size) {
+        std::vector<uint8_t> data(size);
+        for (uint8_t &byte : data) {
+            byte = random();
+        }
+        ABitReader br(data.data(), data.size());
+        ReferenceBitReader reference(data);
+        for (;;) {
+            const size_t n = random() % 33;
+            uint32_t expected = 0;
+            uint32_t actual = 0;
+            const bool ok = reference.getBits(n, &expected);
+            ASSERT_EQ(ok, br.getBitsGraceful(n, &actual)) << "size " << size;
+            if (!ok) {
+                EXPECT_TRUE(br.overRead());
+                break;
+            }
+            ASSERT_EQ(expected, actual) << "size " << size << " n " << n;
+            ASSERT_EQ(reference.numBitsLeft(), br.numBitsLeft());
+        }
+    }
+}
+
+TEST(ABitReaderTest, RejectsMoreThan32Bits) {
+    const uint8_t data[8] = {};
+    ABitReader br(data, sizeof(data));
+    uint32_t value;
+    EXPECT_FALSE(br.getBitsGraceful(33, &value));
+    EXPECT_FALSE(br.overRead());
+    EXPECT_EQ(64u, br.numBitsLeft());
+}
+
+TEST(ABitReaderTest, PutBitsRestoresBits) {
+    std::mt19937 random(7);
+    std::vector<uint8_t> data(24);
+    for (uint8_t &byte : data) {
+        byte = random();
+    }
+    for (size_t skip = 0; skip < 100; ++skip) {
+        for (size_t n = 1; n <= 32; ++n) {
+            ABitReader br(data.data(), data.size());
+            ASSERT_TRUE(br.skipBits(skip));
+            const uint32_t value = br.getBits(n);
+            const size_t bitsLeft = br.numBitsLeft();
+            br.putBits(value, n);
+            ASSERT_EQ(bitsLeft + n, br.numBitsLeft());
+            ASSERT_EQ(value, br.getBits(n)) << "skip " << skip << " n " << n;
+            ABitReader expected(data.data(), data.size());
+            ASSERT_TRUE(expected.skipBits(skip + n));
+            ASSERT_EQ(expected.getBitsWithFallback(32, 0), br.getBitsWithFallback(32, 0));
+        }
+    }
+}
+
+TEST(ABitReaderTest, ParsesExpGolomb) {
+    std::mt19937 random(3);
+    std::vector<unsigned> values;
+    std::vector<bool> bits;
+    for (int i = 0; i < 1000; ++i) {
+        const unsigned value = random() >> (random() % 32);
+        if (value == ~0u) {
+            continue;
+        }
+        const size_t length = 32 - __builtin_clz(value + 1);
+        appendBits(&bits, 0, length - 1);
+        appendBits(&bits, value + 1, length);
+        values.push_back(value);
+    }
+    std::vector<uint8_t> data((bits.size() + 7) / 8);
+    for (size_t i = 0; i < bits.size(); ++i) {
+        data[i / 8] |= bits[i] << (7 - i % 8);
+    }
+
+    ABitReader br(data.data(), data.size());
+    for (unsigned value : values) {
+        ASSERT_EQ(value, parseUEWithFallback(&br, ~0u));
+    }
+    EXPECT_FALSE(br.overRead());
+    EXPECT_LT(br.numBitsLeft(), 8u);
+}
+
+TEST(ABitReaderTest, SkipLeadingZeroBitsToEnd) {
+    const uint8_t data[11] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0x80};
+    ABitReader br(data, sizeof(data));
+    uint32_t numZeros;
+    EXPECT_TRUE(br.skipLeadingZeroBits(&numZeros));
+    EXPECT_EQ(80u, numZeros);
+    EXPECT_EQ(7u, br.numBitsLeft());
+    EXPECT_FALSE(br.skipLeadingZeroBits(&numZeros));
+    EXPECT_EQ(7u, numZeros);
+    EXPECT_TRUE(br.overRead());
+
+    // Only one bit left after the zeros, so the suffix cannot be read.
+    const uint8_t overRead[2] = {0, 0x01};
+    ABitReader fallback(overRead, sizeof(overRead));
+    EXPECT_EQ(1234u, parseUEWithFallback(&fallback, 1234u));
+}
+
+TEST(ABitReaderTest, NALBitReaderSkipsEmulationPrevention) {
+    std::mt19937 random(11);
+    for (int iteration = 0; iteration < 200; ++iteration) {
+        const std::vector<uint8_t> data = makeNalLikeData(random, random() % 64);
+        const std::vector<uint8_t> unescaped = removeEmulationPrevention(data);
+        NALBitReader br(data.data(), data.size());
+        ReferenceBitReader reference(unescaped);
+        for (;;) {
+            const size_t n = random() % 33;
+            ASSERT_EQ(reference.numBitsLeft() >= n, br.atLeastNumBitsLeft(n));
+            uint32_t expected = 0;
+            uint32_t actual = 0;
+            const bool ok = reference.getBits(n, &expected);
+            ASSERT_EQ(ok, br.getBitsGraceful(n, &actual));
+            if (!ok) {
+                break;
+            }
+            ASSERT_EQ(expected, actual) << "iteration " << iteration;
+        }
+    }
+}
+
+TEST(ABitReaderTest, NALBitReaderWithoutZeroBytes) {
+    std::vector<uint8_t> data(100);
+    for (size_t i = 0; i < data.size(); ++i) {
+        data[i] = i + 1;
+    }
+    // Two zero bytes before a block without zero bytes, which starts with an escape.
+    data[30] = 0;
+    data[31] = 0;
+    data[32] = 3;
+    const std::vector<uint8_t> unescaped = removeEmulationPrevention(data);
+    ASSERT_EQ(data.size() - 1, unescaped.size());
+
+    NALBitReader br(data.data(), data.size());
+    ReferenceBitReader reference(unescaped);
+    uint32_t expected;
+    while (reference.getBits(24, &expected)) {
+        ASSERT_EQ(expected, br.getBits(24));
+    }
+}
+
+TEST(ABitReaderTest, RemoveEmulationPreventionBytes) {
+    std::mt19937 random(5);
+    for (int iteration = 0; iteration < 500; ++iteration) {
+        std::vector<uint8_t> data = makeNalLikeData(random, random() % 200);
+        const std::vector<uint8_t> expected = removeEmulationPrevention(data);
+        data.resize(RemoveEmulationPreventionBytes(data.data(), data.size()));
+        ASSERT_EQ(expected, data) << "iteration " << iteration;
+    }
+
+    std::vector<uint8_t> data = {0, 0, 3, 0, 0, 3, 3, 0, 0, 3};
+    data.resize(RemoveEmulationPreventionBytes(data.data(), data.size()));
+    EXPECT_EQ((std::vector<uint8_t>{0, 0, 0, 0, 3, 0, 0}), data);
+}
+
+}  // namespace android
@@ -0,0 +1,171 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Stress benchmark of ALooper posts, reporting posts per second and heap allocations per post.
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdlib>
+#include <mutex>
+#include <random>
+
+#include <benchmark/benchmark.h>
+#include <media/stagefright/foundation/AHandler.h>
+#include <media/stagefright/foundation/ALooper.h>
+#include <media/stagefright/foundation/AMessage.h>
+
+using namespace android;
+
+// Counts every heap allocation of the process, including the ones of the looper thread.
+static std::atomic<int64_t> gAllocations{0};
+
+void* operator new(size_t size) {
+    gAllocations.fetch_add(1, std::memory_order_relaxed);
+    void* p = malloc(size);
+    if (p == nullptr) {
+        abort();
+    }
+    return p;
+}
+
+void operator delete(void* p) noexcept {
+    free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    free(p);
+}
+
+namespace {
+
+constexpr int kBatch = 256;
+
+class CountingHandler : public AHandler {
+  public:
+    void expect(int64_t count) {
+        std::lock_guard lock(mLock);
+        mExpected = count;
+    }
+
+    void waitForExpected() {
+        std::unique_lock lock(mLock);
+        mCondition.wait(lock, [this] { return mReceived >= mExpected; });
+    }
+
+  protected:
+    void onMessageReceived(const sp<AMessage>& /* msg */) override {
+        std::lock_guard lock(mLock);
+        if (++mReceived >= mExpected) {
+            mCondition.notify_one();
+        }
+    }
+
+  private:
+    std::mutex mLock;
+    std::condition_variable mCondition;
+    int64_t mReceived = 0;
+    int64_t mExpected = 0;
+};
+
+void setCounters(benchmark::State& state, int64_t posts, int64_t allocations) {
+    state.SetItemsProcessed(posts);
+    state.counters["posts/s"] = benchmark::Counter(posts, benchmark::Counter::kIsRate);
+    state.counters["allocs/post"] = posts > 0 ? (double)allocations / posts : 0.;
+}
+
+}  // namespace
+
+// Posts batches of immediate messages and waits for their delivery.
+// Arg: 0 reposts the same message, 1 allocates a message with a few items for each post,
+// as most callers do.
+static void BM_PostAndDeliver(benchmark::State& state) {
+    const bool newMessages = state.range(0) != 0;
+    sp<ALooper> looper = new ALooper;
+    sp<CountingHandler> handler = new CountingHandler;
+    looper->setName("BM_PostAndDeliver");
+    looper->registerHandler(handler);
+    looper->start();
+
+    sp<AMessage> reused = new AMessage(0, handler);
+    int64_t posts = 0;
+    const int64_t allocationsBefore = gAllocations.load();
+    for (auto _ : state) {
+        handler->expect(posts + kBatch);
+        for (int i = 0; i < kBatch; ++i) {
+            if (newMessages) {
+                sp<AMessage> msg = new AMessage(0, handler);
+                msg->setInt32("index", i);
+                msg->setInt64("timeUs", posts + i);
+                msg->setSize("size", 4096);
+                msg->post();
+            } else {
+                reused->post();
+            }
+        }
+        posts += kBatch;
+        handler->waitForExpected();
+    }
+    setCounters(state, posts, gAllocations.load() - allocationsBefore);
+
+    looper->stop();
+    looper->unregisterHandler(handler->id());
+}
+
+// Posts batches of delayed messages on a queue which already holds the given number of
+// pending events at random times, as with many timers pending on one looper.
+// The looper is not started, so that the messages stay queued.
+static void BM_PostDelayed(benchmark::State& state) {
+    const int queueDepth = state.range(0);
+    std::minstd_rand random(42);
+    std::uniform_int_distribution<int64_t> delayUs(1000000, 100000000);
+    int64_t delays[kBatch];
+    int64_t posts = 0;
+    int64_t allocations = 0;
+    for (auto _ : state) {
+        state.PauseTiming();
+        sp<ALooper> looper = new ALooper;
+        sp<CountingHandler> handler = new CountingHandler;
+        looper->registerHandler(handler);
+        sp<AMessage> msg = new AMessage(0, handler);
+        for (int i = 0; i < queueDepth; ++i) {
+            msg->post(delayUs(random));
+        }
+        for (int64_t& delay : delays) {
+            delay = delayUs(random);
+        }
+        const int64_t allocationsBefore = gAllocations.load();
+        state.ResumeTiming();
+
+        for (int64_t delay : delays) {
+            msg->post(delay);
+        }
+
+        state.PauseTiming();
+        allocations += gAllocations.load() - allocationsBefore;
+        posts += kBatch;
+        looper->unregisterHandler(handler->id());
+        msg.clear();
+        handler.clear();
+        looper.clear();
+        state.ResumeTiming();
+    }
+    setCounters(state, posts, allocations);
+}
+
+BENCHMARK(BM_PostAndDeliver)->Arg(0)->Arg(1)->UseRealTime();
+BENCHMARK(BM_PostDelayed)->Arg(0)->Arg(64)->Arg(1024)->Arg(8192);
+
+BENCHMARK_MAIN();
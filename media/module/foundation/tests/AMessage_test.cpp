@@ -24,9 +24,11 @@
 #include <media/stagefright/foundation/AMessage.h>
 #include <media/stagefright/foundation/AHandler.h>
 #include <media/stagefright/foundation/ALooper.h>
+#include <media/stagefright/foundation/AString.h>
 
 using namespace android;
 
+using ::testing::ElementsAre;
 using ::testing::InSequence;
 using ::testing::NiceMock;
 
@@ -53,6 +55,11 @@ public:
     MOCK_METHOD(void, onMessageReceived, (const sp<AMessage>&), (override));
 };
 
+class MockBatchHandler : public MockHandler {
+public:
+    MOCK_METHOD(void, onMessagesReceived, (const std::vector<sp<AMessage>>&), (override));
+};
+
 TEST(AMessage_tests, countsAndLimits) {
   sp<AMessage> m1 = new AMessage();
 
@@ -169,6 +176,58 @@ TEST(AMessage_tests, settersAndGetters) {
   EXPECT_NE(OK, m1->removeEntryByName("notpresent"));
 }
 
+TEST(AMessage_tests, findsItemsOfLargeMessages) {
+  sp<AMessage> m1 = new AMessage();
+
+  // enough items to use the hash index
+  constexpr int32_t kNumItems = 100;
+  for (int32_t i = 0; i < kNumItems; i++) {
+    m1->setInt32(AStringPrintf("key-%d", i).c_str(), i);
+  }
+  EXPECT_EQ(static_cast<size_t>(kNumItems), m1->countEntries());
+
+  int32_t i32;
+  for (int32_t i = 0; i < kNumItems; i++) {
+    EXPECT_TRUE(m1->findInt32(AStringPrintf("key-%d", i).c_str(), &i32));
+    EXPECT_EQ(i, i32);
+  }
+  EXPECT_FALSE(m1->findInt32("key-100", &i32));
+
+  // overwrite, remove and rename keep the other items reachable
+  m1->setInt32("key-7", 70);
+  EXPECT_EQ(static_cast<size_t>(kNumItems), m1->countEntries());
+  EXPECT_EQ(OK, m1->removeEntryByName("key-3"));
+  EXPECT_EQ(OK, m1->setEntryNameAt(m1->findEntryByName("key-5"), "renamed"));
+  EXPECT_EQ(ALREADY_EXISTS, m1->setEntryNameAt(m1->findEntryByName("key-6"), "renamed"));
+  EXPECT_FALSE(m1->contains("key-3"));
+  EXPECT_FALSE(m1->contains("key-5"));
+  EXPECT_TRUE(m1->findInt32("renamed", &i32));
+  EXPECT_EQ(5, i32);
+  EXPECT_TRUE(m1->findInt32("key-7", &i32));
+  EXPECT_EQ(70, i32);
+  EXPECT_TRUE(m1->findInt32("key-99", &i32));
+  EXPECT_EQ(99, i32);
+
+  // copies find the same items, also by the names returned by the original
+  sp<AMessage> m2 = m1->dup();
+  EXPECT_EQ(m1->countEntries(), m2->countEntries());
+  AMessage::Type type;
+  for (size_t i = 0; i < m1->countEntries(); i++) {
+    const char *name = m1->getEntryNameAt(i, &type);
+    EXPECT_EQ(i, m2->findEntryByName(name));
+    EXPECT_EQ(i, m2->findEntryByName(AString(name).c_str()));
+  }
+
+  // removing all but a few items goes back to the linear search
+  for (int32_t i = 10; i < kNumItems; i++) {
+    m2->removeEntryByName(AStringPrintf("key-%d", i).c_str());
+  }
+  EXPECT_TRUE(m2->findInt32("key-9", &i32));
+  EXPECT_EQ(9, i32);
+  EXPECT_TRUE(m2->contains("renamed"));
+  EXPECT_FALSE(m2->contains("key-10"));
+}
+
 TEST(AMessage_tests, deliversMultipleMessagesInOrderImmediately) {
   sp<NiceMock<MockHandler>> mockHandler = new NiceMock<MockHandler>;
   sp<LooperWithSettableClock> looper = new LooperWithSettableClock();
@@ -327,6 +386,31 @@ TEST(AMessage_tests, deliversUniqueMessageOnce) {
   nanosleep(&millis100, nullptr); // just enough time for the looper thread to run
 }
 
+TEST(AMessage_tests, deliversCoalescedMessagesTogether) {
+  sp<NiceMock<MockBatchHandler>> mockHandler = new NiceMock<MockBatchHandler>;
+  sp<LooperWithSettableClock> looper = new LooperWithSettableClock();
+  looper->registerHandler(mockHandler);
+  looper->setCoalescedMessage(mockHandler->id(), 1, true);
+
+  sp<AMessage> first = new AMessage(1, mockHandler);
+  first->post();
+  sp<AMessage> other = new AMessage(2, mockHandler);
+  other->post();
+  sp<AMessage> second = new AMessage(1, mockHandler);
+  second->post();
+  sp<AMessage> notDue = new AMessage(1, mockHandler);
+  notDue->post(100);
+
+  {
+    InSequence inSequence;
+    EXPECT_CALL(*mockHandler, onMessagesReceived(ElementsAre(first, second))).Times(1);
+    EXPECT_CALL(*mockHandler, onMessageReceived(other)).Times(1);
+  }
+  EXPECT_CALL(*mockHandler, onMessageReceived(notDue)).Times(0);
+  looper->start();
+  nanosleep(&millis100, nullptr); // just enough time for the looper thread to run
+}
+
 TEST(AMessage_tests, postUnique_withNullToken_returnsInvalidArgument) {
   sp<NiceMock<MockHandler>> mockHandler = new NiceMock<MockHandler>;
   sp<ALooper> looper = new ALooper();
@@ -276,4 +276,47 @@ TEST_F(MetaDataBaseUnitTest, ConvertToStringTest) {
                                 << info.length();
 }
 
+
+TEST_F(MetaDataBaseUnitTest, SampleKeysTest) {
+    // The per sample keys are stored apart from the other items, check that they behave
+    // the same across clear() and copies.
+    for (int iteration = 0; iteration < 2; ++iteration) {
+        MetaDataBase metaData;
+        ASSERT_FALSE(metaData.setInt64(kKeyTime, kDurationUs))
+                << "Initializing kKeyTime, overwrite is expected to be false";
+        ASSERT_TRUE(metaData.setInt64(kKeyTime, kDurationUs + iteration))
+                << "Setting kKeyTime again, overwrite is expected to be true";
+        ASSERT_FALSE(metaData.setInt32(kKeyIsSyncFrame, 1));
+        ASSERT_FALSE(metaData.setInt32(kKeyWidth, kWidth1));
+        ASSERT_FALSE(metaData.setRect(kKeyCropRect, kLeft, kTop, kRight, kBottom));
+
+        MetaDataBase metaDataCopy(metaData);
+        int64_t timeUs;
+        ASSERT_TRUE(metaDataCopy.findInt64(kKeyTime, &timeUs)) << "kKeyTime not copied";
+        ASSERT_EQ(timeUs, kDurationUs + iteration);
+        ASSERT_STREQ(metaData.toString().string(), metaDataCopy.toString().string());
+
+        ASSERT_TRUE(metaData.remove(kKeyIsSyncFrame));
+        ASSERT_FALSE(metaData.hasData(kKeyIsSyncFrame));
+        ASSERT_FALSE(metaData.remove(kKeyIsSyncFrame));
+        ASSERT_TRUE(metaDataCopy.hasData(kKeyIsSyncFrame)) << "Copy changed with the original";
+
+        metaData.clear();
+        ASSERT_FALSE(metaData.hasData(kKeyTime)) << "kKeyTime found after clear";
+        ASSERT_FALSE(metaData.hasData(kKeyWidth)) << "kKeyWidth found after clear";
+        ASSERT_EQ(metaData.toString().length(), 0);
+
+        // reuse after clear, as done for the buffers of a group
+        ASSERT_FALSE(metaData.setInt64(kKeyTime, kDurationUs))
+                << "Overwrite should be false since the metadata was cleared";
+        ASSERT_TRUE(metaData.findInt64(kKeyTime, &timeUs));
+        ASSERT_EQ(timeUs, kDurationUs);
+
+        metaDataCopy = metaData;
+        ASSERT_FALSE(metaDataCopy.hasData(kKeyIsSyncFrame)) << "Assignment kept a stale key";
+        ASSERT_TRUE(metaDataCopy.findInt64(kKeyTime, &timeUs));
+        ASSERT_EQ(timeUs, kDurationUs);
+    }
+}
+
 }  // namespace android
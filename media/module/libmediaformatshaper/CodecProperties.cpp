@@ -18,6 +18,7 @@
 #define LOG_TAG "CodecProperties"
 #include <utils/Log.h>
 
+#include <algorithm>
 #include <string>
 #include <stdlib.h>
 
@@ -29,6 +30,17 @@
 // we aren't going to mess with shaping points dimensions beyond this
 static const int32_t DIMENSION_LIMIT = 16384;
 
+// learning from finished encodings: sessions shorter than this say little about the codec
+static const int64_t LEARN_MIN_DURATION_US = 10 * 1000000LL;
+// learned values apply once this many sessions were reported for a bpp point
+static const int32_t LEARN_MIN_SESSIONS = 3;
+// weight of each new session in the learned value
+static const double LEARN_RATE = 0.25;
+// margin kept above the bitrate the sessions actually used
+static const double LEARN_HEADROOM = 1.10;
+// learning never lowers the tuned bpp below this fraction of it
+static const double LEARN_MIN_SCALE = 0.75;
+
 namespace android {
 namespace mediaformatshaper {
 
@@ -147,6 +159,14 @@ void CodecProperties::setTuningValue(std::string key, std::string value) {
             setPhaseOut(phaseout);
             legal = true;
         }
+    } else if (!strcmp(key.c_str(), "vq-learn-bpp")) {
+        const char *p = value.c_str();
+        char *q;
+        int32_t iValue =  strtol(p, &q, 0);
+        if (q != p) {
+            setLearnBpp(iValue != 0);
+            legal = true;
+        }
     } else if (!strcmp(key.c_str(), "vq-boost-missing-qp")) {
         const char *p = value.c_str();
         char *q;
@@ -269,25 +289,82 @@ bool CodecProperties::bppPoint(std::string resolution, std::string value) {
     return true;
 }
 
+struct CodecProperties::bpp_point *CodecProperties::findBppPoint(int32_t width,
+                                                                 int32_t height) {
+    int32_t pixels = width * height;
+
+    struct bpp_point *point = mBppPoints;
+    while (point && point->pixels < pixels) {
+        point = point->next;
+    }
+    return point;
+}
+
 double CodecProperties::getBpp(int32_t width, int32_t height) {
     // look in the per-resolution list
+    double bpp = mBpp;
+    struct bpp_point *point = findBppPoint(width, height);
+    if (point) {
+        ALOGV("getBpp(w=%d,h=%d) returns %f from bpppoint w=%d h=%d",
+            width, height, point->bpp, point->width, point->height);
+        bpp = point->bpp;
+    } else {
+        ALOGV("defaulting to %f bpp", mBpp);
+    }
 
-    int32_t pixels = width * height;
-
-    if (mBppPoints) {
-        struct bpp_point *point = mBppPoints;
-        while (point && point->pixels < pixels) {
-            point = point->next;
-        }
-        if (point) {
-            ALOGV("getBpp(w=%d,h=%d) returns %f from bpppoint w=%d h=%d",
-                width, height, point->bpp, point->width, point->height);
-            return point->bpp;
+    if (mLearnBpp) {
+        std::lock_guard<std::mutex> _l(mLearnLock);
+        auto learned = mLearnedBpp.find(point ? point->pixels : 0);
+        if (learned != mLearnedBpp.end() && learned->second.sessions >= LEARN_MIN_SESSIONS) {
+            ALOGV("getBpp(w=%d,h=%d) scales %f by learned %f", width, height, bpp,
+                  learned->second.scale);
+            bpp *= learned->second.scale;
         }
     }
+    return bpp;
+}
+
+void CodecProperties::reportEncoding(int32_t width, int32_t height, int64_t configuredBitrate,
+                                     int64_t achievedBitrate, int64_t durationUs) {
+    // without QP bounding, the bitrate floor is what protects quality; leave it alone
+    if (!mLearnBpp || !mSupportsQp) {
+        return;
+    }
+    if (width <= 0 || height <= 0 || width > DIMENSION_LIMIT || height > DIMENSION_LIMIT) {
+        return;
+    }
+    if (configuredBitrate <= 0 || achievedBitrate < 0 || durationUs < LEARN_MIN_DURATION_US) {
+        ALOGV("reportEncoding: %dx%d for %" PRId64 " us, too short to learn from",
+              width, height, durationUs);
+        return;
+    }
+
+    struct bpp_point *point = findBppPoint(width, height);
+    double bpp = point ? point->bpp : mBpp;
+    if (bpp <= 0) {
+        // not shaping at this size
+        return;
+    }
+
+    // only encodings configured near the floor tell us whether the floor is needed
+    double bitrateFloor = (double)width * height * bpp;
+    if (configuredBitrate > bitrateFloor * mPhaseOut) {
+        ALOGV("reportEncoding: configured %" PRId64 " above the shaping range", configuredBitrate);
+        return;
+    }
 
-    ALOGV("defaulting to %f bpp", mBpp);
-    return mBpp;
+    // what this session suggests for the floor, relative to the tuned one
+    double sessionScale = achievedBitrate / bitrateFloor * LEARN_HEADROOM;
+    sessionScale = std::clamp(sessionScale, LEARN_MIN_SCALE, 1.0);
+
+    std::lock_guard<std::mutex> _l(mLearnLock);
+    learned_bpp &learned = mLearnedBpp[point ? point->pixels : 0];
+    learned.scale += LEARN_RATE * (sessionScale - learned.scale);
+    learned.sessions++;
+    ALOGD("reportEncoding: codec %s %dx%d achieved %" PRId64 " of floor %.0f bps,"
+          " bpp scale %.3f after %d sessions",
+          mName.c_str(), width, height, achievedBitrate, bitrateFloor, learned.scale,
+          learned.sessions);
 }
 
 bool CodecProperties::qpMaxPoint(std::string resolution, std::string value) {
@@ -77,6 +77,15 @@ class CodecProperties {
     void setBpp(double bpp) { mBpp = bpp;}
     double getBpp(int32_t width, int32_t height);
 
+    // learn from finished encodings how much of the bitrate floor the codec uses.
+    // when it consistently encodes below the floor while bounded by qpmax, the bpp
+    // for that resolution is lowered, down to 3/4 of the tuned value.
+    // enabled by the 'vq-learn-bpp' tuning; only applies to codecs that support QP.
+    void setLearnBpp(bool learn) { mLearnBpp = learn; }
+    bool learnBpp() { return mLearnBpp; }
+    void reportEncoding(int32_t width, int32_t height, int64_t configuredBitrate,
+                        int64_t achievedBitrate, int64_t durationUs);
+
     // Does this codec support QP bounding
     // The getMapping() methods provide any needed mapping to non-standard keys.
     void setSupportsQp(bool supported) { mSupportsQp = supported;}
@@ -122,6 +131,18 @@ class CodecProperties {
     };
     struct bpp_point *mBppPoints = nullptr;
     bool bppPoint(std::string resolution, std::string value);
+    // the point getBpp() uses for this size, nullptr for the default mBpp
+    struct bpp_point *findBppPoint(int32_t width, int32_t height);
+
+    // what has been learned for each bpp point, keyed by its pixel count
+    // (0 for the default mBpp)
+    struct learned_bpp {
+        double scale = 1.0;
+        int32_t sessions = 0;
+    };
+    bool mLearnBpp = false;
+    std::mutex mLearnLock;
+    std::map<int32_t, learned_bpp> mLearnedBpp /*GUARDED_BY(mLearnLock)*/ ;
 
     // same thing for qpmax -- allow different ones based on resolution
     // allow different target bits-per-pixel based on resolution
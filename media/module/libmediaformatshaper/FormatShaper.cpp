@@ -117,6 +117,23 @@ int setTuning(shaperHandle_t shaper, const char *tuning, const char *value) {
     return 0;
 }
 
+int reportEncoding(shaperHandle_t shaper, int32_t width, int32_t height,
+                   int64_t configuredBitrate, int64_t achievedBitrate, int64_t durationUs) {
+    ALOGV("reportEncoding: %dx%d configured %" PRId64 " achieved %" PRId64 " over %" PRId64 " us",
+          width, height, configuredBitrate, achievedBitrate, durationUs);
+    CodecProperties *codec = (CodecProperties*) shaper;
+    if (codec == nullptr) {
+        return -1;
+    }
+    // only registered codecs shaped anything
+    if (!codec->isRegistered()) {
+        return -1;
+    }
+
+    codec->reportEncoding(width, height, configuredBitrate, achievedBitrate, durationUs);
+    return 0;
+}
+
 /*
  * The routines that manage finding, creating, and registering the shapers.
  */
@@ -183,7 +200,7 @@ const char **getReverseMappings(shaperHandle_t shaper, const char *kind) {
 // the system grabs this structure
 __attribute__ ((visibility ("default")))
 extern "C" FormatShaperOps_t shaper_ops = {
-    .version = SHAPER_VERSION_V1,
+    .version = SHAPER_VERSION_V2,
 
     .findShaper = findShaper,
     .createShaper = createShaper,
@@ -196,6 +213,8 @@ extern "C" FormatShaperOps_t shaper_ops = {
     .getReverseMappings = getReverseMappings,
 
     .setTuning = setTuning,
+
+    .reportEncoding = reportEncoding,
 };
 
 }  // namespace mediaformatshaper
@@ -89,6 +89,16 @@ typedef int (*setFeature_t)(shaperHandle_t shaper, const char *feature, int valu
  */
 typedef int (*setTuning_t)(shaperHandle_t shaper, const char *feature, const char * value);
 
+/*
+ * reports the outcome of a finished encoding shaped by "shaper": the resolution, the
+ * bitrate the codec was configured with after shaping, and the bitrate it achieved
+ * over "durationUs" of encoded content. The shaper may use this to adjust how it
+ * shapes later encodings. Available from SHAPER_VERSION_V2.
+ */
+typedef int (*reportEncoding_t)(shaperHandle_t shaper, int32_t width, int32_t height,
+                                int64_t configuredBitrate, int64_t achievedBitrate,
+                                int64_t durationUs);
+
 /*
  * The expectation is that the client will implement a flow similar to the following when
  * setting up an encoding.
@@ -127,12 +137,18 @@ typedef struct FormatShaperOps {
 
     setTuning_t setTuning;
 
+    /*
+     * feedback from finished encodings, SHAPER_VERSION_V2
+     */
+    reportEncoding_t reportEncoding;
+
     // additions happen at the end of the structure
 } FormatShaperOps_t;
 
 // versioninf information
 const uint32_t SHAPER_VERSION_UNKNOWN = 0;
 const uint32_t SHAPER_VERSION_V1 = 1;
+const uint32_t SHAPER_VERSION_V2 = 2;
 
 }  // namespace mediaformatshaper
 }  // namespace android
@@ -26,6 +26,7 @@
 #include <utils/AndroidThreads.h>
 #include <utils/Log.h>
 
+#include <algorithm>
 #include <thread>
 #include <utility>
 
@@ -71,27 +72,23 @@ struct TranscodingSessionController::Watchdog {
     // Starts monitoring the session.
     void start(const SessionKeyType& key);
     // Stops monitoring the session.
-    void stop();
+    void stop(const SessionKeyType& key);
     // Signals that the session is still alive. Must be sent at least every mTimeoutUs.
     // (Timeout will happen if no ping in mTimeoutUs since the last ping.)
-    void keepAlive();
+    void keepAlive(const SessionKeyType& key);
 
 private:
     void threadLoop();
-    void updateTimer_l();
 
     TranscodingSessionController* mOwner;
     const int64_t mTimeoutUs;
     mutable std::mutex mLock;
     std::condition_variable mCondition GUARDED_BY(mLock);
-    // Whether watchdog is monitoring a session for timeout.
-    bool mActive GUARDED_BY(mLock);
     // Whether watchdog is aborted and the monitoring thread should exit.
     bool mAbort GUARDED_BY(mLock);
-    // When watchdog is active, the next timeout time point.
-    std::chrono::steady_clock::time_point mNextTimeoutTime GUARDED_BY(mLock);
-    // When watchdog is active, the session being watched.
-    SessionKeyType mSessionToWatch GUARDED_BY(mLock);
+    // The sessions being watched, and their next timeout time points.
+    std::map<SessionKeyType, std::chrono::steady_clock::time_point> mTimeoutTimes
+            GUARDED_BY(mLock);
     std::thread mThread;
 };
 
@@ -99,7 +96,6 @@ TranscodingSessionController::Watchdog::Watchdog(TranscodingSessionController* o
                                                  int64_t timeoutUs)
       : mOwner(owner),
         mTimeoutUs(timeoutUs),
-        mActive(false),
         mAbort(false),
         mThread(&Watchdog::threadLoop, this) {
     ALOGV("Watchdog CTOR: %p", this);
@@ -123,67 +119,73 @@ TranscodingSessionController::Watchdog::~Watchdog() {
 void TranscodingSessionController::Watchdog::start(const SessionKeyType& key) {
     std::scoped_lock lock{mLock};
 
-    if (!mActive) {
+    if (mTimeoutTimes.count(key) == 0) {
         ALOGI("Watchdog start: %s", sessionToString(key).c_str());
 
-        mActive = true;
-        mSessionToWatch = key;
-        updateTimer_l();
+        mTimeoutTimes[key] =
+                std::chrono::steady_clock::now() + std::chrono::microseconds(mTimeoutUs);
         mCondition.notify_one();
     }
 }
 
-void TranscodingSessionController::Watchdog::stop() {
+void TranscodingSessionController::Watchdog::stop(const SessionKeyType& key) {
     std::scoped_lock lock{mLock};
 
-    if (mActive) {
-        ALOGI("Watchdog stop: %s", sessionToString(mSessionToWatch).c_str());
+    if (mTimeoutTimes.erase(key) > 0) {
+        ALOGI("Watchdog stop: %s", sessionToString(key).c_str());
 
-        mActive = false;
         mCondition.notify_one();
     }
 }
 
-void TranscodingSessionController::Watchdog::keepAlive() {
+void TranscodingSessionController::Watchdog::keepAlive(const SessionKeyType& key) {
     std::scoped_lock lock{mLock};
 
-    if (mActive) {
-        ALOGI("Watchdog keepAlive: %s", sessionToString(mSessionToWatch).c_str());
+    auto it = mTimeoutTimes.find(key);
+    if (it != mTimeoutTimes.end()) {
+        ALOGI("Watchdog keepAlive: %s", sessionToString(key).c_str());
 
-        updateTimer_l();
+        it->second = std::chrono::steady_clock::now() + std::chrono::microseconds(mTimeoutUs);
         mCondition.notify_one();
     }
 }
 
-// updateTimer_l() is only called with lock held.
-void TranscodingSessionController::Watchdog::updateTimer_l() NO_THREAD_SAFETY_ANALYSIS {
-    std::chrono::microseconds timeout(mTimeoutUs);
-    mNextTimeoutTime = std::chrono::steady_clock::now() + timeout;
-}
-
 // Unfortunately std::unique_lock is incompatible with -Wthread-safety.
 void TranscodingSessionController::Watchdog::threadLoop() NO_THREAD_SAFETY_ANALYSIS {
     androidSetThreadPriority(0 /*tid (0 = current) */, ANDROID_PRIORITY_BACKGROUND);
     std::unique_lock<std::mutex> lock{mLock};
 
     while (!mAbort) {
-        if (!mActive) {
+        if (mTimeoutTimes.empty()) {
             mCondition.wait(lock);
             continue;
         }
-        // Watchdog active, wait till next timeout time.
-        if (mCondition.wait_until(lock, mNextTimeoutTime) == std::cv_status::timeout) {
-            // If timeout happens, report timeout and deactivate watchdog.
-            mActive = false;
-            // Make a copy of session key, as once we unlock, it could be unprotected.
-            SessionKeyType sessionKey = mSessionToWatch;
-
-            ALOGE("Watchdog timeout: %s", sessionToString(sessionKey).c_str());
-
-            lock.unlock();
-            mOwner->onError(sessionKey.first, sessionKey.second,
-                            TranscodingErrorCode::kWatchdogTimeout);
-            lock.lock();
+        // Watchdog active, wait till the earliest timeout time.
+        auto nextIt = mTimeoutTimes.begin();
+        for (auto it = mTimeoutTimes.begin(); it != mTimeoutTimes.end(); ++it) {
+            if (it->second < nextIt->second) {
+                nextIt = it;
+            }
+        }
+        if (mCondition.wait_until(lock, nextIt->second) == std::cv_status::timeout) {
+            // The map may have changed while waiting, look for the expired session again.
+            auto now = std::chrono::steady_clock::now();
+            for (auto it = mTimeoutTimes.begin(); it != mTimeoutTimes.end(); ++it) {
+                if (it->second > now) {
+                    continue;
+                }
+                // If timeout happens, report timeout and stop watching the session.
+                SessionKeyType sessionKey = it->first;
+                mTimeoutTimes.erase(it);
+
+                ALOGE("Watchdog timeout: %s", sessionToString(sessionKey).c_str());
+
+                lock.unlock();
+                mOwner->onError(sessionKey.first, sessionKey.second,
+                                TranscodingErrorCode::kWatchdogTimeout);
+                lock.lock();
+                break;
+            }
         }
     }
 }
@@ -335,7 +337,6 @@ TranscodingSessionController::TranscodingSessionController(
         mUidPolicy(uidPolicy),
         mResourcePolicy(resourcePolicy),
         mThermalPolicy(thermalPolicy),
-        mCurrentSession(nullptr),
         mResourceLost(false) {
     // Only push empty offline queue initially. Realtime queues are added when requests come in.
     mUidSortedList.push_back(OFFLINE_UID);
@@ -346,10 +347,14 @@ TranscodingSessionController::TranscodingSessionController(
     if (config != nullptr) {
         mConfig = *config;
     }
+    mConfig.maxConcurrentSessions = std::max(mConfig.maxConcurrentSessions, 1);
+    mCodecCapacity = mConfig.maxConcurrentSessions;
     mPacer.reset(new Pacer(mConfig));
-    ALOGD("@@@ watchdog %lld, burst count %d, burst time %d, burst threshold %d",
+    mStats.startTime = std::chrono::steady_clock::now();
+    ALOGD("@@@ watchdog %lld, burst count %d, burst time %d, burst threshold %d, concurrency %d",
           (long long)mConfig.watchdogTimeoutUs, mConfig.pacerBurstCountQuota,
-          mConfig.pacerBurstTimeQuotaSeconds, mConfig.pacerBurstThresholdMs);
+          mConfig.pacerBurstTimeQuotaSeconds, mConfig.pacerBurstThresholdMs,
+          mConfig.maxConcurrentSessions);
 }
 
 TranscodingSessionController::~TranscodingSessionController() {}
@@ -378,6 +383,55 @@ void TranscodingSessionController::dumpSession_l(const Session& session, String8
     }
 }
 
+void TranscodingSessionController::dumpThroughput_l(String8& result) {
+    const size_t SIZE = 256;
+    char buffer[SIZE];
+
+    int32_t runningCount = 0;
+    std::chrono::microseconds busyTime = mStats.totalRunningTime;
+    auto now = std::chrono::steady_clock::now();
+    for (auto const& it : mSessionMap) {
+        const Session& session = it.second;
+        busyTime += session.runningTime;
+        if (session.getState() == Session::RUNNING) {
+            runningCount++;
+            busyTime += std::chrono::duration_cast<std::chrono::microseconds>(
+                    now - session.stateEnterTime);
+        }
+    }
+    double uptimeSec = std::chrono::duration_cast<std::chrono::microseconds>(
+                               now - mStats.startTime).count() / 1000000.0;
+
+    snprintf(buffer, SIZE, "\n========== Transcoder throughput =========\n");
+    result.append(buffer);
+    snprintf(buffer, SIZE, "  running: %d, capacity: %d (max %d, codec %d), peak: %d\n",
+             runningCount, getCapacity_l(), mConfig.maxConcurrentSessions, mCodecCapacity,
+             mStats.peakRunningCount);
+    result.append(buffer);
+    for (size_t i = 0; i < mCurrentSessions.size(); i++) {
+        snprintf(buffer, SIZE, "    transcoder %zu: %s\n", i,
+                 mCurrentSessions[i] == nullptr
+                         ? "idle"
+                         : sessionToString(mCurrentSessions[i]->key).c_str());
+        result.append(buffer);
+    }
+    snprintf(buffer, SIZE, "  finished: %d, failed: %d, canceled: %d, dropped: %d\n",
+             mStats.finishedCount, mStats.failedCount, mStats.canceledCount,
+             mStats.droppedCount);
+    result.append(buffer);
+    snprintf(buffer, SIZE, "  avg running time per finished session: %.1fs\n",
+             mStats.finishedCount == 0 ? 0.0f
+                                       : mStats.finishedRunningTime.count() / 1000000.0f /
+                                                 mStats.finishedCount);
+    result.append(buffer);
+    snprintf(buffer, SIZE, "  finished per hour: %.1f, transcoder utilization: %.1f%%\n",
+             uptimeSec > 0 ? mStats.finishedCount * 3600.0 / uptimeSec : 0.0,
+             uptimeSec > 0 ? busyTime.count() / 10000.0 / uptimeSec /
+                                     mConfig.maxConcurrentSessions
+                           : 0.0);
+    result.append(buffer);
+}
+
 void TranscodingSessionController::dumpAllSessions(int fd, const Vector<String16>& args __unused) {
     String8 result;
 
@@ -415,6 +469,8 @@ void TranscodingSessionController::dumpAllSessions(int fd, const Vector<String16
         }
     }
 
+    dumpThroughput_l(result);
+
     snprintf(buffer, SIZE, "\n========== Dumping past sessions =========\n");
     result.append(buffer);
     for (auto& session : mSessionHistory) {
@@ -425,31 +481,83 @@ void TranscodingSessionController::dumpAllSessions(int fd, const Vector<String16
 }
 
 /*
- * Returns nullptr if there is no session, or we're paused globally (due to resource lost,
- * thermal throttling, etc.). Otherwise, return the session that should be run next.
+ * Returns the number of sessions that can run at the same time, or 0 if we're paused
+ * globally (due to resource lost, thermal throttling, etc.).
  */
-TranscodingSessionController::Session* TranscodingSessionController::getTopSession_l() {
-    if (mSessionMap.empty()) {
-        return nullptr;
-    }
-
-    // Return nullptr if we're paused globally due to resource lost or thermal throttling.
+int32_t TranscodingSessionController::getCapacity_l() const {
+    // Return 0 if we're paused globally due to resource lost or thermal throttling.
     if (((mResourcePolicy != nullptr && mResourceLost) ||
          (mThermalPolicy != nullptr && mThermalThrottling))) {
-        return nullptr;
+        return 0;
+    }
+    return mCodecCapacity;
+}
+
+/*
+ * Returns the sessions that should be running, highest priority first. Empty if there is
+ * no session, or we're paused globally.
+ *
+ * The first session comes from the top uid. The remaining slots are handed out one
+ * session per uid at a time, in the order of mUidSortedList, so that a uid with a long
+ * queue doesn't hold all the transcoders while other uids wait.
+ */
+std::vector<TranscodingSessionController::Session*>
+TranscodingSessionController::getTopSessions_l() {
+    std::vector<Session*> topSessions;
+    const size_t capacity = getCapacity_l();
+    if (mSessionMap.empty() || capacity == 0) {
+        return topSessions;
     }
 
     uid_t topUid = *mUidSortedList.begin();
-    // If the current session is running, and it's in the topUid's queue, let it continue
+    // If a session is running, and it's in the topUid's queue, let it continue
     // to run even if it's not the earliest in that uid's queue.
     // For example, uid(B) is added to a session while it's pending in uid(A)'s queue, then
     // B is brought to front which caused the session to run, then user switches back to A.
-    if (mCurrentSession != nullptr && mCurrentSession->getState() == Session::RUNNING &&
-        mCurrentSession->allClientUids.count(topUid) > 0) {
-        return mCurrentSession;
+    for (Session* session : mCurrentSessions) {
+        if (session != nullptr && session->getState() == Session::RUNNING &&
+            session->allClientUids.count(topUid) > 0) {
+            topSessions.push_back(session);
+            break;
+        }
+    }
+
+    std::vector<std::pair<SessionQueueType::iterator, SessionQueueType::iterator>> cursors;
+    for (uid_t uid : mUidSortedList) {
+        cursors.emplace_back(mSessionQueues[uid].begin(), mSessionQueues[uid].end());
+    }
+    // The top uid already had its first turn if its running session was kept above.
+    const size_t first = topSessions.empty() ? 0 : 1;
+    for (size_t round = 0; topSessions.size() < capacity; round++) {
+        bool added = false;
+        for (size_t i = (round == 0 ? first : 0);
+             i < cursors.size() && topSessions.size() < capacity; i++) {
+            auto& cursor = cursors[i];
+            // A session in several uids' queues could have been picked already.
+            while (cursor.first != cursor.second &&
+                   std::find(topSessions.begin(), topSessions.end(),
+                             &mSessionMap[*cursor.first]) != topSessions.end()) {
+                ++cursor.first;
+            }
+            if (cursor.first != cursor.second) {
+                topSessions.push_back(&mSessionMap[*cursor.first]);
+                ++cursor.first;
+                added = true;
+            }
+        }
+        if (!added && round > 0) {
+            break;
+        }
+    }
+    return topSessions;
+}
+
+std::shared_ptr<TranscoderInterface> TranscodingSessionController::getTranscoder_l(
+        int32_t index) {
+    if (mTranscoders[index] == nullptr) {
+        mTranscoders[index] = mTranscoderFactory(shared_from_this());
     }
-    SessionKeyType topSessionKey = *mSessionQueues[topUid].begin();
-    return &mSessionMap[topSessionKey];
+    return mTranscoders[index];
 }
 
 void TranscodingSessionController::setSessionState_l(Session* session, Session::State state) {
@@ -461,14 +569,12 @@ void TranscodingSessionController::setSessionState_l(Session* session, Session::
         return;
     }
 
-    // Currently we only have 1 running session, and we always put the previous
-    // session in non-running state before we run the new session, so it's okay
-    // to start/stop the watchdog here. If this assumption changes, we need to
-    // track the number of running sessions and start/stop watchdog based on that.
+    // Every running session is watched on its own, a paused session doesn't
+    // get heart-beats from its transcoder.
     if (isRunning) {
         mWatchdog->start(session->key);
     } else {
-        mWatchdog->stop();
+        mWatchdog->stop(session->key);
     }
 }
 
@@ -501,72 +607,98 @@ void TranscodingSessionController::Session::setState(Session::State newState) {
     state = newState;
 }
 
-void TranscodingSessionController::updateCurrentSession_l() {
-    Session* curSession = mCurrentSession;
-    Session* topSession = nullptr;
-
-    // Delayed init of transcoder and watchdog.
-    if (mTranscoder == nullptr) {
-        mTranscoder = mTranscoderFactory(shared_from_this());
+void TranscodingSessionController::updateCurrentSessions_l() {
+    // Delayed init of transcoders and watchdog.
+    if (mTranscoders.empty()) {
+        mTranscoders.resize(mConfig.maxConcurrentSessions);
+        mCurrentSessions.resize(mConfig.maxConcurrentSessions, nullptr);
+        getTranscoder_l(0);
         mWatchdog = std::make_shared<Watchdog>(this, mConfig.watchdogTimeoutUs);
     }
 
-    // If we found a different top session, or the top session's running state is not
-    // correct. Take some actions to ensure it's correct.
-    while ((topSession = getTopSession_l()) != curSession ||
-           (topSession != nullptr && !topSession->isRunning())) {
-        ALOGV("updateCurrentSession_l: topSession is %s, curSession is %s",
-              topSession == nullptr ? "null" : sessionToString(topSession->key).c_str(),
-              curSession == nullptr ? "null" : sessionToString(curSession->key).c_str());
-
-        // If current session is running, pause it first. Note this is needed for either
-        // cases: 1) Top session is changing to another session, or 2) Top session is
-        // changing to null (which means we should be globally paused).
-        if (curSession != nullptr && curSession->getState() == Session::RUNNING) {
-            mTranscoder->pause(curSession->key.first, curSession->key.second);
-            setSessionState_l(curSession, Session::PAUSED);
-        }
+    bool retry;
+    do {
+        retry = false;
+        std::vector<Session*> topSessions = getTopSessions_l();
 
-        if (topSession == nullptr) {
-            // Nothing more to run (either no session or globally paused).
-            break;
+        // Pause the running sessions that shouldn't run any more, either because
+        // higher priority sessions took their place, or we're globally paused.
+        // This frees their transcoders for the sessions started below.
+        for (size_t i = 0; i < mCurrentSessions.size(); i++) {
+            Session* curSession = mCurrentSessions[i];
+            if (curSession == nullptr ||
+                std::find(topSessions.begin(), topSessions.end(), curSession) !=
+                        topSessions.end()) {
+                continue;
+            }
+            ALOGV("updateCurrentSessions_l: pausing %s", sessionToString(curSession->key).c_str());
+            if (curSession->getState() == Session::RUNNING) {
+                mTranscoders[i]->pause(curSession->key.first, curSession->key.second);
+                setSessionState_l(curSession, Session::PAUSED);
+            }
+            mCurrentSessions[i] = nullptr;
         }
 
-        // Otherwise, ensure topSession is running.
-        if (topSession->getState() == Session::NOT_STARTED) {
-            // Check if at least one client has quota to start the session.
-            bool keepForClient = false;
-            for (uid_t uid : topSession->allClientUids) {
-                if (mPacer->onSessionStarted(uid, topSession->callingUid)) {
-                    keepForClient = true;
-                    // DO NOT break here, because book-keeping still needs to happen
-                    // for the other uids.
-                }
+        // Ensure the top sessions are running.
+        for (Session* topSession : topSessions) {
+            if (topSession->isRunning()) {
+                continue;
             }
-            if (!keepForClient) {
-                // Unfortunately all uids requesting this session are out of quota.
-                // Drop this session and try the next one.
-                {
-                    auto clientCallback = mSessionMap[topSession->key].callback.lock();
-                    if (clientCallback != nullptr) {
-                        clientCallback->onTranscodingFailed(
-                                topSession->key.second, TranscodingErrorCode::kDroppedByService);
+            ALOGV("updateCurrentSessions_l: running %s", sessionToString(topSession->key).c_str());
+
+            if (topSession->getState() == Session::NOT_STARTED) {
+                // Check if at least one client has quota to start the session.
+                bool keepForClient = false;
+                for (uid_t uid : topSession->allClientUids) {
+                    if (mPacer->onSessionStarted(uid, topSession->callingUid)) {
+                        keepForClient = true;
+                        // DO NOT break here, because book-keeping still needs to happen
+                        // for the other uids.
                     }
                 }
-                removeSession_l(topSession->key, Session::DROPPED_BY_PACER);
-                continue;
+                if (!keepForClient) {
+                    // Unfortunately all uids requesting this session are out of quota.
+                    // Drop this session and try the next one.
+                    {
+                        auto clientCallback = mSessionMap[topSession->key].callback.lock();
+                        if (clientCallback != nullptr) {
+                            clientCallback->onTranscodingFailed(
+                                    topSession->key.second,
+                                    TranscodingErrorCode::kDroppedByService);
+                        }
+                    }
+                    removeSession_l(topSession->key, Session::DROPPED_BY_PACER);
+                    retry = true;
+                    break;
+                }
+                auto it = std::find(mCurrentSessions.begin(), mCurrentSessions.end(), nullptr);
+                LOG_ALWAYS_FATAL_IF(it == mCurrentSessions.end(), "no idle transcoder");
+                int32_t index = it - mCurrentSessions.begin();
+                getTranscoder_l(index)->start(topSession->key.first, topSession->key.second,
+                                              topSession->request, topSession->callingUid,
+                                              topSession->callback.lock());
+                topSession->transcoderIndex = index;
+                mCurrentSessions[index] = topSession;
+                setSessionState_l(topSession, Session::RUNNING);
+            } else if (topSession->getState() == Session::PAUSED) {
+                // Only the transcoder that paused the session can resume it. If that one
+                // is busy with another top session, this session waits for it.
+                int32_t index = topSession->transcoderIndex;
+                if (mCurrentSessions[index] != nullptr) {
+                    continue;
+                }
+                getTranscoder_l(index)->resume(topSession->key.first, topSession->key.second,
+                                               topSession->request, topSession->callingUid,
+                                               topSession->callback.lock());
+                mCurrentSessions[index] = topSession;
+                setSessionState_l(topSession, Session::RUNNING);
             }
-            mTranscoder->start(topSession->key.first, topSession->key.second, topSession->request,
-                               topSession->callingUid, topSession->callback.lock());
-            setSessionState_l(topSession, Session::RUNNING);
-        } else if (topSession->getState() == Session::PAUSED) {
-            mTranscoder->resume(topSession->key.first, topSession->key.second, topSession->request,
-                                topSession->callingUid, topSession->callback.lock());
-            setSessionState_l(topSession, Session::RUNNING);
         }
-        break;
-    }
-    mCurrentSession = topSession;
+    } while (retry);
+
+    int32_t runningCount = mCurrentSessions.size() -
+                           std::count(mCurrentSessions.begin(), mCurrentSessions.end(), nullptr);
+    mStats.peakRunningCount = std::max(mStats.peakRunningCount, runningCount);
 }
 
 void TranscodingSessionController::addUidToSession_l(uid_t clientUid,
@@ -648,13 +780,29 @@ void TranscodingSessionController::removeSession_l(
         return;
     }
 
-    // Clear current session.
-    if (mCurrentSession == &mSessionMap[sessionKey]) {
-        mCurrentSession = nullptr;
-    }
+    // Free the transcoder the session is running on.
+    std::replace(mCurrentSessions.begin(), mCurrentSessions.end(), &mSessionMap[sessionKey],
+                 (Session*)nullptr);
 
     setSessionState_l(&mSessionMap[sessionKey], finalState);
 
+    switch (finalState) {
+    case Session::FINISHED:
+        mStats.finishedCount++;
+        mStats.finishedRunningTime += mSessionMap[sessionKey].runningTime;
+        break;
+    case Session::ERROR:
+        mStats.failedCount++;
+        break;
+    case Session::DROPPED_BY_PACER:
+        mStats.droppedCount++;
+        break;
+    default:
+        mStats.canceledCount++;
+        break;
+    }
+    mStats.totalRunningTime += mSessionMap[sessionKey].runningTime;
+
     // We can use onSessionCompleted() even for CANCELLED, because runningTime is
     // now updated by setSessionState_l().
     for (uid_t uid : mSessionMap[sessionKey].allClientUids) {
@@ -760,7 +908,7 @@ bool TranscodingSessionController::submit(
 
     addUidToSession_l(clientUid, sessionKey);
 
-    updateCurrentSession_l();
+    updateCurrentSessions_l();
 
     validateState_l();
     return true;
@@ -801,7 +949,7 @@ bool TranscodingSessionController::cancel(ClientIdType clientId, SessionIdType s
         // the transcoder to discard any states for the session, otherwise the states may
         // never be discarded.
         if (mSessionMap[*it].getState() != Session::NOT_STARTED) {
-            mTranscoder->stop(it->first, it->second);
+            getTranscoder_l(mSessionMap[*it].transcoderIndex)->stop(it->first, it->second);
         }
 
         // Remove the session.
@@ -815,7 +963,7 @@ bool TranscodingSessionController::cancel(ClientIdType clientId, SessionIdType s
     }
 
     // Start next session.
-    updateCurrentSession_l();
+    updateCurrentSessions_l();
 
     validateState_l();
     return true;
@@ -840,7 +988,7 @@ bool TranscodingSessionController::addClientUid(ClientIdType clientId, SessionId
     mSessionMap[sessionKey].allClientUids.insert(clientUid);
     addUidToSession_l(clientUid, sessionKey);
 
-    updateCurrentSession_l();
+    updateCurrentSessions_l();
 
     validateState_l();
     return true;
@@ -949,7 +1097,7 @@ void TranscodingSessionController::onFinish(ClientIdType clientId, SessionIdType
         removeSession_l(sessionKey, Session::FINISHED);
 
         // Start next session.
-        updateCurrentSession_l();
+        updateCurrentSessions_l();
 
         validateState_l();
     });
@@ -961,10 +1109,11 @@ void TranscodingSessionController::onError(ClientIdType clientId, SessionIdType
         if (err == TranscodingErrorCode::kWatchdogTimeout) {
             // Abandon the transcoder, as its handler thread might be stuck in some call to
             // MediaTranscoder altogether, and may not be able to handle any new tasks.
-            mTranscoder->stop(clientId, sessionId, true /*abandon*/);
+            int32_t index = mSessionMap[sessionKey].transcoderIndex;
+            mTranscoders[index]->stop(clientId, sessionId, true /*abandon*/);
             // Clear the last ref count before we create new transcoder.
-            mTranscoder = nullptr;
-            mTranscoder = mTranscoderFactory(shared_from_this());
+            mTranscoders[index] = nullptr;
+            getTranscoder_l(index);
         }
 
         {
@@ -978,7 +1127,7 @@ void TranscodingSessionController::onError(ClientIdType clientId, SessionIdType
         removeSession_l(sessionKey, Session::ERROR);
 
         // Start next session.
-        updateCurrentSession_l();
+        updateCurrentSessions_l();
 
         validateState_l();
     });
@@ -997,7 +1146,7 @@ void TranscodingSessionController::onProgressUpdate(ClientIdType clientId, Sessi
 
 void TranscodingSessionController::onHeartBeat(ClientIdType clientId, SessionIdType sessionId) {
     notifyClient(clientId, sessionId, "heart-beat",
-                 [=](const SessionKeyType& /*sessionKey*/) { mWatchdog->keepAlive(); });
+                 [=](const SessionKeyType& sessionKey) { mWatchdog->keepAlive(sessionKey); });
 }
 
 void TranscodingSessionController::onResourceLost(ClientIdType clientId, SessionIdType sessionId) {
@@ -1018,6 +1167,7 @@ void TranscodingSessionController::onResourceLost(ClientIdType clientId, Session
         // so we don't need to call onPaused() to pause it. However, we still need to notify
         // the client and update the session state here.
         setSessionState_l(resourceLostSession, Session::PAUSED);
+        mCurrentSessions[resourceLostSession->transcoderIndex] = nullptr;
         // Notify the client as a paused event.
         auto clientCallback = resourceLostSession->callback.lock();
         if (clientCallback != nullptr) {
@@ -1026,7 +1176,19 @@ void TranscodingSessionController::onResourceLost(ClientIdType clientId, Session
         if (mResourcePolicy != nullptr) {
             mResourcePolicy->setPidResourceLost(resourceLostSession->request.clientPid);
         }
-        mResourceLost = true;
+        int32_t runningCount = mCurrentSessions.size() - std::count(mCurrentSessions.begin(),
+                                                                    mCurrentSessions.end(),
+                                                                    nullptr);
+        if (runningCount > 0) {
+            // The other sessions kept their codecs, so we ran into the codec limit
+            // rather than losing codecs altogether. Run one session less until
+            // resources become available again.
+            ALOGI("%s: lowering codec capacity to %d", __FUNCTION__, runningCount);
+            mCodecCapacity = runningCount;
+            updateCurrentSessions_l();
+        } else {
+            mResourceLost = true;
+        }
 
         validateState_l();
     });
@@ -1052,7 +1214,7 @@ void TranscodingSessionController::onTopUidsChanged(const std::unordered_set<uid
 
     moveUidsToTop_l(uids, true /*preserveTopUid*/);
 
-    updateCurrentSession_l();
+    updateCurrentSessions_l();
 
     validateState_l();
 }
@@ -1082,7 +1244,7 @@ void TranscodingSessionController::onUidGone(uid_t goneUid) {
         // the transcoder to discard any states for the session, otherwise the states may
         // never be discarded.
         if (mSessionMap[*it].getState() != Session::NOT_STARTED) {
-            mTranscoder->stop(it->first, it->second);
+            getTranscoder_l(mSessionMap[*it].transcoderIndex)->stop(it->first, it->second);
         }
 
         {
@@ -1104,7 +1266,7 @@ void TranscodingSessionController::onUidGone(uid_t goneUid) {
     }
 
     // Start next session.
-    updateCurrentSession_l();
+    updateCurrentSessions_l();
 
     validateState_l();
 }
@@ -1112,14 +1274,15 @@ void TranscodingSessionController::onUidGone(uid_t goneUid) {
 void TranscodingSessionController::onResourceAvailable() {
     std::scoped_lock lock{mLock};
 
-    if (!mResourceLost) {
+    if (!mResourceLost && mCodecCapacity == mConfig.maxConcurrentSessions) {
         return;
     }
 
     ALOGI("%s", __FUNCTION__);
 
     mResourceLost = false;
-    updateCurrentSession_l();
+    mCodecCapacity = mConfig.maxConcurrentSessions;
+    updateCurrentSessions_l();
 
     validateState_l();
 }
@@ -1134,7 +1297,7 @@ void TranscodingSessionController::onThrottlingStarted() {
     ALOGI("%s", __FUNCTION__);
 
     mThermalThrottling = true;
-    updateCurrentSession_l();
+    updateCurrentSessions_l();
 
     validateState_l();
 }
@@ -1149,7 +1312,7 @@ void TranscodingSessionController::onThrottlingStopped() {
     ALOGI("%s", __FUNCTION__);
 
     mThermalThrottling = false;
-    updateCurrentSession_l();
+    updateCurrentSessions_l();
 
     validateState_l();
 }
@@ -1184,6 +1347,14 @@ void TranscodingSessionController::validateState_l() {
                         "session count (including dup) from mSessionQueues doesn't match that from "
                         "mSessionMap, %d vs %d",
                         totalSessions, totalSessionsAlternative);
+
+    for (size_t i = 0; i < mCurrentSessions.size(); i++) {
+        Session* session = mCurrentSessions[i];
+        LOG_ALWAYS_FATAL_IF(session != nullptr && (!session->isRunning() ||
+                                                   session->transcoderIndex != (int32_t)i),
+                            "transcoder %zu has session %s that's not running on it", i,
+                            sessionToString(session->key).c_str());
+    }
 #endif  // VALIDATE_STATE
 }
 
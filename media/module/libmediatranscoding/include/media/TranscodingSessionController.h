@@ -32,6 +32,7 @@
 #include <list>
 #include <map>
 #include <mutex>
+#include <vector>
 
 namespace android {
 using ::aidl::android::media::TranscodingResultParcel;
@@ -108,6 +109,8 @@ private:
         int32_t pacerBurstCountQuota = 10;
         // Maximum allowed back-to-back running time.
         int32_t pacerBurstTimeQuotaSeconds = 120;  // 2-min
+        // Maximum number of sessions running at the same time, each on its own transcoder.
+        int32_t maxConcurrentSessions = 1;
     };
 
     struct Session {
@@ -132,6 +135,8 @@ private:
         std::chrono::microseconds waitingTime{0};
         std::chrono::microseconds runningTime{0};
         std::chrono::microseconds pausedTime{0};
+        // Index of the transcoder the session last ran on, which holds its paused state.
+        int32_t transcoderIndex = -1;
 
         TranscodingRequest request;
         std::weak_ptr<ITranscodingClientCallback> callback;
@@ -148,6 +153,19 @@ private:
     struct Watchdog;
     struct Pacer;
 
+    // Counters for the throughput section of the dump.
+    struct ThroughputStats {
+        std::chrono::time_point<std::chrono::steady_clock> startTime;
+        int32_t finishedCount = 0;
+        int32_t failedCount = 0;
+        int32_t canceledCount = 0;
+        int32_t droppedCount = 0;
+        int32_t peakRunningCount = 0;
+        // Running time of finished sessions, and of all closed sessions.
+        std::chrono::microseconds finishedRunningTime{0};
+        std::chrono::microseconds totalRunningTime{0};
+    };
+
     ControllerConfig mConfig;
 
     // TODO(chz): call transcoder without global lock.
@@ -166,17 +184,23 @@ private:
     std::map<uid_t, std::string> mUidPackageNames;
 
     TranscoderFactoryType mTranscoderFactory;
-    std::shared_ptr<TranscoderInterface> mTranscoder;
+    // One transcoder per concurrent session, created on first use.
+    std::vector<std::shared_ptr<TranscoderInterface>> mTranscoders;
+    // The session currently running on each transcoder, or nullptr if it's idle.
+    std::vector<Session*> mCurrentSessions;
     std::shared_ptr<UidPolicyInterface> mUidPolicy;
     std::shared_ptr<ResourcePolicyInterface> mResourcePolicy;
     std::shared_ptr<ThermalPolicyInterface> mThermalPolicy;
 
-    Session* mCurrentSession;
     bool mResourceLost;
+    // Number of sessions that can run before codecs get reclaimed, lowered when a
+    // session loses its codec while others are running.
+    int32_t mCodecCapacity;
     bool mThermalThrottling;
     std::list<Session> mSessionHistory;
     std::shared_ptr<Watchdog> mWatchdog;
     std::shared_ptr<Pacer> mPacer;
+    ThroughputStats mStats;
 
     // Only allow MediaTranscodingService and unit tests to instantiate.
     TranscodingSessionController(const TranscoderFactoryType& transcoderFactory,
@@ -186,8 +210,11 @@ private:
                                  const ControllerConfig* config = nullptr);
 
     void dumpSession_l(const Session& session, String8& result, bool closedSession = false);
-    Session* getTopSession_l();
-    void updateCurrentSession_l();
+    void dumpThroughput_l(String8& result);
+    int32_t getCapacity_l() const;
+    std::vector<Session*> getTopSessions_l();
+    std::shared_ptr<TranscoderInterface> getTranscoder_l(int32_t index);
+    void updateCurrentSessions_l();
     void addUidToSession_l(uid_t uid, const SessionKeyType& sessionKey);
     void removeSession_l(const SessionKeyType& sessionKey, Session::State finalState,
                          const std::shared_ptr<std::function<bool(uid_t uid)>>& keepUid = nullptr);
@@ -20,12 +20,31 @@
 #include <android-base/logging.h>
 #include <media/MediaSampleQueue.h>
 
+#include <algorithm>
+
 namespace android {
 
-bool MediaSampleQueue::enqueue(const std::shared_ptr<MediaSample>& sample) {
-    std::scoped_lock<std::mutex> lock(mMutex);
+bool MediaSampleQueue::isFull_l(size_t sampleBytes) {
+    if (mSampleQueue.empty()) {
+        return false;
+    }
+    return (mMaxSamples > 0 && mSampleQueue.size() >= mMaxSamples) ||
+           (mMaxBytes > 0 && mQueuedBytes + sampleBytes > mMaxBytes);
+}
+
+// Unfortunately std::unique_lock is incompatible with -Wthread-safety
+bool MediaSampleQueue::enqueue(const std::shared_ptr<MediaSample>& sample)
+        NO_THREAD_SAFETY_ANALYSIS {
+    std::unique_lock<std::mutex> lock(mMutex);
+    const size_t sampleBytes = sample != nullptr ? sample->info.size : 0;
+    while (isFull_l(sampleBytes) && !mAborted) {
+        mSpaceCondition.wait(lock);
+    }
+
     if (!mAborted) {
         mSampleQueue.push(sample);
+        mQueuedBytes += sampleBytes;
+        mPeakQueuedBytes = std::max(mPeakQueuedBytes, mQueuedBytes);
         mCondition.notify_one();
     }
     return mAborted;
@@ -39,10 +58,13 @@ bool MediaSampleQueue::dequeue(std::shared_ptr<MediaSample>* sample) NO_THREAD_S
     }
 
     if (!mAborted) {
+        const std::shared_ptr<MediaSample>& front = mSampleQueue.front();
+        mQueuedBytes -= front != nullptr ? front->info.size : 0;
         if (sample != nullptr) {
-            *sample = mSampleQueue.front();
+            *sample = front;
         }
         mSampleQueue.pop();
+        mSpaceCondition.notify_one();
     }
     return mAborted;
 }
@@ -54,10 +76,17 @@ bool MediaSampleQueue::isEmpty() {
 
 void MediaSampleQueue::abort() {
     std::scoped_lock<std::mutex> lock(mMutex);
-    // Clear the queue and notify consumers.
+    // Clear the queue and notify consumers and blocked producers.
     std::queue<std::shared_ptr<MediaSample>> empty = {};
     std::swap(mSampleQueue, empty);
+    mQueuedBytes = 0;
     mAborted = true;
     mCondition.notify_all();
+    mSpaceCondition.notify_all();
+}
+
+size_t MediaSampleQueue::getPeakQueuedBytes() {
+    std::scoped_lock<std::mutex> lock(mMutex);
+    return mPeakQueuedBytes;
 }
-}  // namespace android
\ No newline at end of file
+}  // namespace android
@@ -20,11 +20,16 @@
 #include <android-base/logging.h>
 #include <media/MediaSampleReaderNDK.h>
 
+#include <string.h>
+
 #include <algorithm>
 #include <cmath>
 
 namespace android {
 
+// Default amount of sample data each track may read ahead in sequential access mode.
+static constexpr size_t kDefaultReadAheadBytesPerTrack = 4 * 1024 * 1024;
+
 // Check that the extractor sample flags have the expected NDK meaning.
 static_assert(SAMPLE_FLAG_SYNC_SAMPLE == AMEDIAEXTRACTOR_SAMPLE_FLAG_SYNC,
               "Sample flag mismatch: SYNC_SAMPLE");
@@ -50,9 +55,12 @@ std::shared_ptr<MediaSampleReader> MediaSampleReaderNDK::createFromFd(int fd, si
 }
 
 MediaSampleReaderNDK::MediaSampleReaderNDK(AMediaExtractor* extractor)
-      : mExtractor(extractor), mTrackCount(AMediaExtractor_getTrackCount(mExtractor)) {
+      : mExtractor(extractor),
+        mTrackCount(AMediaExtractor_getTrackCount(mExtractor)),
+        mReadAheadLimit(kDefaultReadAheadBytesPerTrack) {
     if (mTrackCount > 0) {
         mTrackCursors.resize(mTrackCount);
+        mReadAheadCaches.resize(mTrackCount);
     }
 }
 
@@ -63,6 +71,14 @@ MediaSampleReaderNDK::~MediaSampleReaderNDK() {
 }
 
 void MediaSampleReaderNDK::advanceTrack_l(int trackIndex) {
+    if (!mReadAheadCaches[trackIndex].samples.empty()) {
+        popCachedSample_l(trackIndex);
+    } else {
+        advanceCursor_l(trackIndex);
+    }
+}
+
+void MediaSampleReaderNDK::advanceCursor_l(int trackIndex) {
     if (!mEnforceSequentialAccess) {
         // Note: Positioning the extractor before advancing the track is needed for two reasons:
         // 1. To enable multiple advances without explicitly letting the extractor catch up.
@@ -89,6 +105,57 @@ void MediaSampleReaderNDK::advanceTrack_l(int trackIndex) {
     return;
 }
 
+bool MediaSampleReaderNDK::readAhead_l() {
+    if (mReadAheadLimit == 0 || mExtractorTrackIndex < 0) {
+        return false;
+    }
+
+    // Only read the sample that the extractor track's consumer would read next.
+    const int trackIndex = mExtractorTrackIndex;
+    const SampleCursor& cursor = mTrackCursors[trackIndex];
+    if (!cursor.current.isSet || cursor.current.index != mExtractorSampleIndex) {
+        return false;
+    }
+
+    ReadAheadCache& cache = mReadAheadCaches[trackIndex];
+    const ssize_t sampleSize = AMediaExtractor_getSampleSize(mExtractor);
+    if (sampleSize < 0) {
+        return false;
+    } else if (!cache.samples.empty() && cache.bytes + sampleSize > mReadAheadLimit) {
+        mReadAheadStalled = true;
+        return false;
+    }
+
+    CachedSample sample;
+    sample.info.presentationTimeUs = AMediaExtractor_getSampleTime(mExtractor);
+    sample.info.flags = AMediaExtractor_getSampleFlags(mExtractor);
+    sample.info.size = sampleSize;
+    sample.data.resize(sampleSize);
+    if (AMediaExtractor_readSampleData(mExtractor, sample.data.data(), sampleSize) < sampleSize) {
+        LOG(ERROR) << "Unable to read ahead sample for track " << trackIndex;
+        return false;
+    }
+
+    cache.bytes += sampleSize;
+    cache.samples.push_back(std::move(sample));
+    advanceCursor_l(trackIndex);
+    return true;
+}
+
+void MediaSampleReaderNDK::popCachedSample_l(int trackIndex) {
+    ReadAheadCache& cache = mReadAheadCaches[trackIndex];
+    cache.bytes -= cache.samples.front().info.size;
+    cache.samples.pop_front();
+
+    // Wake up threads that stopped reading ahead because this cache was full.
+    if (mReadAheadStalled) {
+        mReadAheadStalled = false;
+        for (auto it = mTrackSignals.begin(); it != mTrackSignals.end(); ++it) {
+            it->second.notify_all();
+        }
+    }
+}
+
 bool MediaSampleReaderNDK::advanceExtractor_l() {
     // Reset the "next" sample time whenever the extractor advances past a sample that is current,
     // to ensure that "next" is appropriately updated when the extractor advances over the next
@@ -179,8 +246,16 @@ media_status_t MediaSampleReaderNDK::moveToTrack_l(int trackIndex) {
 
 media_status_t MediaSampleReaderNDK::waitForTrack_l(int trackIndex,
                                                     std::unique_lock<std::mutex>& lockHeld) {
-    while (trackIndex != mExtractorTrackIndex && !mEosReached && mEnforceSequentialAccess) {
-        mTrackSignals[trackIndex].wait(lockHeld);
+    while (trackIndex != mExtractorTrackIndex && !mEosReached && mEnforceSequentialAccess &&
+           mReadAheadCaches[trackIndex].samples.empty()) {
+        if (!readAhead_l()) {
+            mTrackSignals[trackIndex].wait(lockHeld);
+        }
+    }
+
+    // Another thread may have read ahead samples for this track while it was waiting.
+    if (!mReadAheadCaches[trackIndex].samples.empty()) {
+        return AMEDIA_OK;
     }
 
     if (mEosReached) {
@@ -399,8 +474,12 @@ media_status_t MediaSampleReaderNDK::getSampleInfoForTrack(int trackIndex, Media
         return AMEDIA_ERROR_INVALID_PARAMETER;
     }
 
-    media_status_t status = primeExtractorForTrack_l(trackIndex, lock);
-    if (status == AMEDIA_OK) {
+    const ReadAheadCache& cache = mReadAheadCaches[trackIndex];
+    media_status_t status =
+            cache.samples.empty() ? primeExtractorForTrack_l(trackIndex, lock) : AMEDIA_OK;
+    if (status == AMEDIA_OK && !cache.samples.empty()) {
+        *info = cache.samples.front().info;
+    } else if (status == AMEDIA_OK) {
         info->presentationTimeUs = AMediaExtractor_getSampleTime(mExtractor);
         info->flags = AMediaExtractor_getSampleFlags(mExtractor);
         info->size = AMediaExtractor_getSampleSize(mExtractor);
@@ -428,11 +507,25 @@ media_status_t MediaSampleReaderNDK::readSampleDataForTrack(int trackIndex, uint
         return AMEDIA_ERROR_INVALID_PARAMETER;
     }
 
-    media_status_t status = primeExtractorForTrack_l(trackIndex, lock);
+    const ReadAheadCache& cache = mReadAheadCaches[trackIndex];
+    media_status_t status =
+            cache.samples.empty() ? primeExtractorForTrack_l(trackIndex, lock) : AMEDIA_OK;
     if (status != AMEDIA_OK) {
         return status;
     }
 
+    if (!cache.samples.empty()) {
+        const CachedSample& sample = cache.samples.front();
+        if (bufferSize < sample.data.size()) {
+            LOG(ERROR) << "Buffer is too small for sample, " << bufferSize << " vs "
+                       << sample.data.size();
+            return AMEDIA_ERROR_INVALID_PARAMETER;
+        }
+        memcpy(buffer, sample.data.data(), sample.data.size());
+        popCachedSample_l(trackIndex);
+        return AMEDIA_OK;
+    }
+
     ssize_t sampleSize = AMediaExtractor_getSampleSize(mExtractor);
     if (bufferSize < sampleSize) {
         LOG(ERROR) << "Buffer is too small for sample, " << bufferSize << " vs " << sampleSize;
@@ -460,6 +553,11 @@ void MediaSampleReaderNDK::advanceTrack(int trackIndex) {
     }
 }
 
+void MediaSampleReaderNDK::setReadAheadLimit(size_t maxBytesPerTrack) {
+    std::scoped_lock lock(mExtractorMutex);
+    mReadAheadLimit = maxBytesPerTrack;
+}
+
 AMediaFormat* MediaSampleReaderNDK::getFileFormat() {
     return AMediaExtractor_getFileFormat(mExtractor);
 }
@@ -0,0 +1,323 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// #define LOG_NDEBUG 0
+#define LOG_TAG "VideoFrameScaler"
+
+#define EGL_EGLEXT_PROTOTYPES
+#define GL_GLEXT_PROTOTYPES
+
+#include <EGL/eglext.h>
+#include <GLES2/gl2ext.h>
+#include <android-base/logging.h>
+#include <android/hardware_buffer.h>
+#include <media/VideoFrameScaler.h>
+#include <string.h>
+
+namespace android {
+
+// Number of decoded frames the scaler may hold at once. Frames are drawn one at a time.
+static constexpr int32_t kMaxAcquiredImages = 2;
+
+static const char kVertexShader[] =
+        "attribute vec4 aPosition;\n"
+        "attribute vec2 aTexCoord;\n"
+        "varying vec2 vTexCoord;\n"
+        "void main() {\n"
+        "    gl_Position = aPosition;\n"
+        "    vTexCoord = aTexCoord;\n"
+        "}\n";
+
+static const char kFragmentShader[] =
+        "#extension GL_OES_EGL_image_external : require\n"
+        "precision mediump float;\n"
+        "varying vec2 vTexCoord;\n"
+        "uniform samplerExternalOES uTexture;\n"
+        "void main() {\n"
+        "    gl_FragColor = texture2D(uTexture, vTexCoord);\n"
+        "}\n";
+
+static GLuint loadShader(GLenum type, const char* source) {
+    GLuint shader = glCreateShader(type);
+    if (shader == 0) {
+        return 0;
+    }
+    glShaderSource(shader, 1, &source, nullptr);
+    glCompileShader(shader);
+
+    GLint compiled = GL_FALSE;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
+    if (compiled != GL_TRUE) {
+        char log[512] = {};
+        glGetShaderInfoLog(shader, sizeof(log), nullptr, log);
+        LOG(ERROR) << "Unable to compile shader: " << log;
+        glDeleteShader(shader);
+        return 0;
+    }
+    return shader;
+}
+
+// static
+std::unique_ptr<VideoFrameScaler> VideoFrameScaler::create(
+        ANativeWindow* encoderSurface, int32_t srcWidth, int32_t srcHeight, int32_t dstWidth,
+        int32_t dstHeight, const std::function<void()>& onFrameAvailable) {
+    if (encoderSurface == nullptr || srcWidth <= 0 || srcHeight <= 0 || dstWidth <= 0 ||
+        dstHeight <= 0 || onFrameAvailable == nullptr) {
+        LOG(ERROR) << "Invalid scaler configuration";
+        return nullptr;
+    }
+
+    std::unique_ptr<VideoFrameScaler> scaler(
+            new VideoFrameScaler(dstWidth, dstHeight, onFrameAvailable));
+    if (!scaler->initImageReader(srcWidth, srcHeight) || !scaler->initEgl(encoderSurface)) {
+        return nullptr;
+    }
+
+    LOG(INFO) << "Scaling frames on the GPU from " << srcWidth << "x" << srcHeight << " to "
+              << dstWidth << "x" << dstHeight;
+    return scaler;
+}
+
+VideoFrameScaler::~VideoFrameScaler() {
+    // Delete the reader first so that no more frame callbacks arrive.
+    if (mImageReader != nullptr) {
+        AImageReader_delete(mImageReader);
+    }
+
+    if (mDisplay != EGL_NO_DISPLAY) {
+        if (mSurface != EGL_NO_SURFACE) {
+            eglDestroySurface(mDisplay, mSurface);
+        }
+        if (mContext != EGL_NO_CONTEXT) {
+            eglDestroyContext(mDisplay, mContext);
+        }
+        eglTerminate(mDisplay);
+    }
+}
+
+// static
+void VideoFrameScaler::onImageAvailable(void* context, AImageReader* reader __unused) {
+    static_cast<VideoFrameScaler*>(context)->mOnFrameAvailable();
+}
+
+bool VideoFrameScaler::initImageReader(int32_t srcWidth, int32_t srcHeight) {
+    media_status_t status = AImageReader_newWithUsage(
+            srcWidth, srcHeight, AIMAGE_FORMAT_PRIVATE, AHARDWAREBUFFER_USAGE_GPU_SAMPLED_IMAGE,
+            kMaxAcquiredImages, &mImageReader);
+    if (status != AMEDIA_OK) {
+        LOG(ERROR) << "Unable to create image reader: " << status;
+        return false;
+    }
+
+    AImageReader_ImageListener listener = {.context = this,
+                                           .onImageAvailable = onImageAvailable};
+    status = AImageReader_setImageListener(mImageReader, &listener);
+    if (status != AMEDIA_OK) {
+        LOG(ERROR) << "Unable to set image reader listener: " << status;
+        return false;
+    }
+
+    status = AImageReader_getWindow(mImageReader, &mInputSurface);
+    if (status != AMEDIA_OK) {
+        LOG(ERROR) << "Unable to get image reader surface: " << status;
+        return false;
+    }
+    return true;
+}
+
+bool VideoFrameScaler::initEgl(ANativeWindow* encoderSurface) {
+    EGLDisplay display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    if (display == EGL_NO_DISPLAY || !eglInitialize(display, nullptr, nullptr)) {
+        LOG(ERROR) << "Unable to initialize EGL: " << eglGetError();
+        return false;
+    }
+    mDisplay = display;
+
+    static const EGLint kConfigAttribs[] = {EGL_RED_SIZE,        8,
+                                            EGL_GREEN_SIZE,      8,
+                                            EGL_BLUE_SIZE,       8,
+                                            EGL_RENDERABLE_TYPE, EGL_OPENGL_ES2_BIT,
+                                            EGL_RECORDABLE_ANDROID, 1,
+                                            EGL_NONE};
+    EGLConfig config;
+    EGLint numConfigs = 0;
+    if (!eglChooseConfig(mDisplay, kConfigAttribs, &config, 1, &numConfigs) || numConfigs < 1) {
+        LOG(ERROR) << "No recordable EGL config: " << eglGetError();
+        return false;
+    }
+
+    static const EGLint kContextAttribs[] = {EGL_CONTEXT_CLIENT_VERSION, 2, EGL_NONE};
+    mContext = eglCreateContext(mDisplay, config, EGL_NO_CONTEXT, kContextAttribs);
+    if (mContext == EGL_NO_CONTEXT) {
+        LOG(ERROR) << "Unable to create EGL context: " << eglGetError();
+        return false;
+    }
+
+    mSurface = eglCreateWindowSurface(mDisplay, config, encoderSurface, nullptr);
+    if (mSurface == EGL_NO_SURFACE) {
+        LOG(ERROR) << "Unable to create EGL surface for the encoder: " << eglGetError();
+        return false;
+    }
+
+    const char* extensions = eglQueryString(mDisplay, EGL_EXTENSIONS);
+    mHasNativeFenceSync =
+            extensions != nullptr && strstr(extensions, "EGL_ANDROID_native_fence_sync") != nullptr;
+
+    if (!eglMakeCurrent(mDisplay, mSurface, mSurface, mContext)) {
+        LOG(ERROR) << "Unable to make EGL context current: " << eglGetError();
+        return false;
+    }
+    const bool ok = initProgram();
+
+    // The context is made current again on the transcoding thread.
+    eglMakeCurrent(mDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    return ok;
+}
+
+bool VideoFrameScaler::initProgram() {
+    GLuint vertexShader = loadShader(GL_VERTEX_SHADER, kVertexShader);
+    GLuint fragmentShader = loadShader(GL_FRAGMENT_SHADER, kFragmentShader);
+    if (vertexShader == 0 || fragmentShader == 0) {
+        glDeleteShader(vertexShader);
+        glDeleteShader(fragmentShader);
+        return false;
+    }
+
+    mProgram = glCreateProgram();
+    glAttachShader(mProgram, vertexShader);
+    glAttachShader(mProgram, fragmentShader);
+    glLinkProgram(mProgram);
+    glDeleteShader(vertexShader);
+    glDeleteShader(fragmentShader);
+
+    GLint linked = GL_FALSE;
+    glGetProgramiv(mProgram, GL_LINK_STATUS, &linked);
+    if (linked != GL_TRUE) {
+        LOG(ERROR) << "Unable to link scaling program";
+        return false;
+    }
+
+    mPositionLoc = glGetAttribLocation(mProgram, "aPosition");
+    mTexCoordLoc = glGetAttribLocation(mProgram, "aTexCoord");
+    mTextureLoc = glGetUniformLocation(mProgram, "uTexture");
+
+    glGenTextures(1, &mTexture);
+    glBindTexture(GL_TEXTURE_EXTERNAL_OES, mTexture);
+    glTexParameteri(GL_TEXTURE_EXTERNAL_OES, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_EXTERNAL_OES, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_EXTERNAL_OES, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_EXTERNAL_OES, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    return glGetError() == GL_NO_ERROR;
+}
+
+media_status_t VideoFrameScaler::renderFrame() {
+    if (eglGetCurrentContext() != mContext &&
+        !eglMakeCurrent(mDisplay, mSurface, mSurface, mContext)) {
+        LOG(ERROR) << "Unable to make EGL context current: " << eglGetError();
+        return AMEDIA_ERROR_UNKNOWN;
+    }
+
+    AImage* image = nullptr;
+    media_status_t status = AImageReader_acquireNextImage(mImageReader, &image);
+    if (status != AMEDIA_OK) {
+        LOG(ERROR) << "Unable to acquire decoded frame: " << status;
+        return status;
+    }
+
+    // MediaCodec stamps rendered frames with the presentation time in nanoseconds.
+    AHardwareBuffer* hardwareBuffer = nullptr;
+    int64_t timestampNs = 0;
+    AImageCropRect crop;
+    if (AImage_getHardwareBuffer(image, &hardwareBuffer) != AMEDIA_OK ||
+        AImage_getTimestamp(image, &timestampNs) != AMEDIA_OK ||
+        AImage_getCropRect(image, &crop) != AMEDIA_OK) {
+        LOG(ERROR) << "Unable to query decoded frame";
+        AImage_delete(image);
+        return AMEDIA_ERROR_UNKNOWN;
+    }
+
+    static const EGLint kImageAttribs[] = {EGL_IMAGE_PRESERVED_KHR, EGL_TRUE, EGL_NONE};
+    EGLImageKHR eglImage =
+            eglCreateImageKHR(mDisplay, EGL_NO_CONTEXT, EGL_NATIVE_BUFFER_ANDROID,
+                              eglGetNativeClientBufferANDROID(hardwareBuffer), kImageAttribs);
+    if (eglImage == EGL_NO_IMAGE_KHR) {
+        LOG(ERROR) << "Unable to create EGLImage for decoded frame: " << eglGetError();
+        AImage_delete(image);
+        return AMEDIA_ERROR_UNKNOWN;
+    }
+
+    // Sample only the crop rectangle. Row 0 of the buffer is the top of the frame.
+    AHardwareBuffer_Desc desc;
+    AHardwareBuffer_describe(hardwareBuffer, &desc);
+    const GLfloat left = crop.left / static_cast<GLfloat>(desc.width);
+    const GLfloat right = crop.right / static_cast<GLfloat>(desc.width);
+    const GLfloat top = crop.top / static_cast<GLfloat>(desc.height);
+    const GLfloat bottom = crop.bottom / static_cast<GLfloat>(desc.height);
+    const GLfloat vertices[] = {
+            // x, y, u, v
+            -1.0f, -1.0f, left,  bottom,
+            1.0f,  -1.0f, right, bottom,
+            -1.0f, 1.0f,  left,  top,
+            1.0f,  1.0f,  right, top,
+    };
+
+    glViewport(0, 0, mDstWidth, mDstHeight);
+    glUseProgram(mProgram);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_EXTERNAL_OES, mTexture);
+    glEGLImageTargetTexture2DOES(GL_TEXTURE_EXTERNAL_OES, static_cast<GLeglImageOES>(eglImage));
+    glUniform1i(mTextureLoc, 0);
+    glVertexAttribPointer(mPositionLoc, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(GLfloat), vertices);
+    glVertexAttribPointer(mTexCoordLoc, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(GLfloat),
+                          vertices + 2);
+    glEnableVertexAttribArray(mPositionLoc);
+    glEnableVertexAttribArray(mTexCoordLoc);
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+
+    eglPresentationTimeANDROID(mDisplay, mSurface, timestampNs);
+    if (!eglSwapBuffers(mDisplay, mSurface)) {
+        LOG(ERROR) << "Unable to queue scaled frame to the encoder: " << eglGetError();
+        status = AMEDIA_ERROR_UNKNOWN;
+    }
+
+    // Hand the decoder buffer back once the GPU is done sampling it, without stalling on the draw
+    // when the driver supports native fences.
+    int releaseFenceFd = EGL_NO_NATIVE_FENCE_FD_ANDROID;
+    if (mHasNativeFenceSync) {
+        EGLSyncKHR sync = eglCreateSyncKHR(mDisplay, EGL_SYNC_NATIVE_FENCE_ANDROID, nullptr);
+        if (sync != EGL_NO_SYNC_KHR) {
+            glFlush();
+            releaseFenceFd = eglDupNativeFenceFDANDROID(mDisplay, sync);
+            eglDestroySyncKHR(mDisplay, sync);
+        }
+    }
+    if (releaseFenceFd == EGL_NO_NATIVE_FENCE_FD_ANDROID) {
+        glFinish();
+    }
+
+    eglDestroyImageKHR(mDisplay, eglImage);
+    AImage_deleteAsync(image, releaseFenceFd);
+    return status;
+}
+
+void VideoFrameScaler::releaseContext() {
+    if (mContext != EGL_NO_CONTEXT && eglGetCurrentContext() == mContext) {
+        eglMakeCurrent(mDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    }
+}
+
+}  // namespace android
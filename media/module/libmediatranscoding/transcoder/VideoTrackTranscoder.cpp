@@ -300,6 +300,29 @@ media_status_t VideoTrackTranscoder::configureDestinationFormat(
         return status;
     }
 
+    // The encoder only accepts frames at its configured size, so when the output resolution
+    // differs from the source the decoder renders into a GPU scaler instead of the encoder.
+    int32_t srcWidth, srcHeight, dstWidth, dstHeight;
+    if (AMediaFormat_getInt32(mSourceFormat.get(), AMEDIAFORMAT_KEY_WIDTH, &srcWidth) &&
+        AMediaFormat_getInt32(mSourceFormat.get(), AMEDIAFORMAT_KEY_HEIGHT, &srcHeight) &&
+        AMediaFormat_getInt32(mDestinationFormat.get(), AMEDIAFORMAT_KEY_WIDTH, &dstWidth) &&
+        AMediaFormat_getInt32(mDestinationFormat.get(), AMEDIAFORMAT_KEY_HEIGHT, &dstHeight) &&
+        (srcWidth != dstWidth || srcHeight != dstHeight)) {
+        std::weak_ptr<VideoTrackTranscoder> weakThis = shared_from_this();
+        mFrameScaler = VideoFrameScaler::create(
+                mSurface, srcWidth, srcHeight, dstWidth, dstHeight, [weakThis] {
+                    if (auto transcoder = weakThis.lock()) {
+                        transcoder->mCodecMessageQueue.push(
+                                [transcoder] { transcoder->scaleFrame(); });
+                    }
+                });
+        if (mFrameScaler == nullptr) {
+            LOG(WARNING) << "GPU scaling unavailable, decoder renders to the encoder directly";
+        }
+    }
+    ANativeWindow* decoderSurface =
+            mFrameScaler != nullptr ? mFrameScaler->getInputSurface() : mSurface;
+
     // Create and configure the decoder.
     const char* sourceMime = nullptr;
     ok = AMediaFormat_getString(mSourceFormat.get(), AMEDIAFORMAT_KEY_MIME, &sourceMime);
@@ -345,7 +368,8 @@ media_status_t VideoTrackTranscoder::configureDestinationFormat(
     CopyFormatEntries(mDestinationFormat.get(), decoderFormat.get(), kEncoderEntriesToCopy);
 
     LOG(INFO) << "Configuring decoder with: " << AMediaFormat_toString(decoderFormat.get());
-    status = AMediaCodec_configure(mDecoder, decoderFormat.get(), mSurface, NULL /* crypto */,
+    status = AMediaCodec_configure(mDecoder, decoderFormat.get(), decoderSurface,
+                                   NULL /* crypto */,
                                    0 /* flags */);
     if (status != AMEDIA_OK) {
         LOG(ERROR) << "Unable to configure video decoder: " << status;
@@ -454,18 +478,42 @@ void VideoTrackTranscoder::transferBuffer(int32_t bufferIndex, AMediaCodecBuffer
     if (bufferIndex >= 0) {
         bool needsRender = bufferInfo.size > 0;
         AMediaCodec_releaseOutputBuffer(mDecoder, bufferIndex, needsRender);
+        if (needsRender && mFrameScaler != nullptr) {
+            ++mPendingScaledFrames;
+        }
     }
 
     if (bufferInfo.flags & AMEDIACODEC_BUFFER_FLAG_END_OF_STREAM) {
         LOG(DEBUG) << "EOS from decoder.";
-        media_status_t status = AMediaCodec_signalEndOfInputStream(mEncoder->getCodec());
-        if (status != AMEDIA_OK) {
-            LOG(ERROR) << "SignalEOS on encoder returned error: " << status;
-            mStatus = status;
+        mEosFromDecoder = true;
+        // Frames still on their way through the scaler must reach the encoder before EOS.
+        if (mPendingScaledFrames == 0) {
+            signalEncoderEndOfStream();
         }
     }
 }
 
+void VideoTrackTranscoder::scaleFrame() {
+    media_status_t status = mFrameScaler->renderFrame();
+    if (status != AMEDIA_OK) {
+        LOG(ERROR) << "Unable to scale decoded frame: " << status;
+        mStatus = status;
+        return;
+    }
+
+    if (mPendingScaledFrames > 0 && --mPendingScaledFrames == 0 && mEosFromDecoder) {
+        signalEncoderEndOfStream();
+    }
+}
+
+void VideoTrackTranscoder::signalEncoderEndOfStream() {
+    media_status_t status = AMediaCodec_signalEndOfInputStream(mEncoder->getCodec());
+    if (status != AMEDIA_OK) {
+        LOG(ERROR) << "SignalEOS on encoder returned error: " << status;
+        mStatus = status;
+    }
+}
+
 void VideoTrackTranscoder::dequeueOutputSample(int32_t bufferIndex,
                                                AMediaCodecBufferInfo bufferInfo) {
     if (bufferIndex >= 0) {
@@ -629,6 +677,9 @@ media_status_t VideoTrackTranscoder::runTranscodeLoop(bool* stopped) {
 
     mCodecMessageQueue.abort();
     AMediaCodec_stop(mDecoder);
+    if (mFrameScaler != nullptr) {
+        mFrameScaler->releaseContext();
+    }
 
     // Signal if transcoding was stopped before it finished.
     if (mStopRequest != NONE && !mEosFromEncoder && mStatus == AMEDIA_OK) {
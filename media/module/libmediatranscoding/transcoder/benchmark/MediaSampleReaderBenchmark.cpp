@@ -34,6 +34,7 @@
 #include <android-base/logging.h>
 #include <benchmark/benchmark.h>
 #include <fcntl.h>
+#include <media/MediaSampleQueue.h>
 #include <media/MediaSampleReaderNDK.h>
 #include <unistd.h>
 
@@ -41,8 +42,44 @@
 
 using namespace android;
 
+// Limits of the per-track prefetch queues.
+static constexpr size_t kPrefetchMaxSamples = 64;
+static constexpr size_t kPrefetchMaxBytes = 4 * 1024 * 1024;
+
+/**
+ * Reads all samples of a track into its prefetch queue. The queue blocks the reader once it is
+ * full, so the reader runs ahead of the consumer by at most the queue's limits.
+ */
+static bool PrefetchTrackSamples(const std::shared_ptr<MediaSampleReader>& sampleReader,
+                                 int trackIndex, MediaSampleQueue* queue) {
+    MediaSample::OnSampleReleasedCallback freeBuffer = [](MediaSample* sample) {
+        delete[] sample->buffer;
+    };
+
+    while (true) {
+        MediaSampleInfo info;
+        media_status_t status = sampleReader->getSampleInfoForTrack(trackIndex, &info);
+        if (status == AMEDIA_ERROR_END_OF_STREAM) {
+            queue->enqueue(nullptr);
+            return true;
+        }
+
+        uint8_t* buffer = new uint8_t[info.size];
+        auto sample = MediaSample::createWithReleaseCallback(buffer, 0 /* offset */,
+                                                             0 /* bufferId */, freeBuffer);
+        sample->info = info;
+
+        status = sampleReader->readSampleDataForTrack(trackIndex, buffer, info.size);
+        if (status != AMEDIA_OK || queue->enqueue(sample)) {
+            queue->abort();
+            return status == AMEDIA_OK;
+        }
+    }
+}
+
 static void ReadMediaSamples(benchmark::State& state, const std::string& srcFileName,
-                             bool readAudio, bool sequentialAccess = false) {
+                             bool readAudio, bool sequentialAccess = false,
+                             bool prefetch = false) {
     // Asset directory.
     static const std::string kAssetDirectory = "/data/local/tmp/TranscodingBenchmark/";
 
@@ -88,6 +125,38 @@ static void ReadMediaSamples(benchmark::State& state, const std::string& srcFile
 
         // Start threads.
         std::vector<std::thread> trackThreads;
+        if (prefetch) {
+            std::vector<std::unique_ptr<MediaSampleQueue>> queues;
+            for (auto trackIndex : trackIndices) {
+                queues.emplace_back(new MediaSampleQueue(kPrefetchMaxSamples, kPrefetchMaxBytes));
+                MediaSampleQueue* queue = queues.back().get();
+
+                trackThreads.emplace_back([trackIndex, sampleReader, queue, &state] {
+                    if (!PrefetchTrackSamples(sampleReader, trackIndex, queue)) {
+                        state.SkipWithError("Error reading sample data");
+                    }
+                });
+                trackThreads.emplace_back([queue] {
+                    std::shared_ptr<MediaSample> sample;
+                    while (!queue->dequeue(&sample) && sample != nullptr) {
+                        sample.reset();  // Release the sample buffer.
+                    }
+                });
+            }
+
+            for (auto& thread : trackThreads) {
+                thread.join();
+            }
+
+            size_t peakQueuedBytes = 0;
+            for (const auto& queue : queues) {
+                peakQueuedBytes += queue->getPeakQueuedBytes();
+            }
+            state.counters["PeakQueuedBytes"] = benchmark::Counter(
+                    peakQueuedBytes, benchmark::Counter::kAvgIterations);
+            continue;
+        }
+
         for (auto trackIndex : trackIndices) {
             trackThreads.emplace_back([trackIndex, sampleReader, &state] {
                 LOG(INFO) << "Track " << trackIndex << " started";
@@ -142,6 +211,11 @@ static void BM_MediaSampleReader_AudioVideo_Sequential(benchmark::State& state)
                      true /* readAudio */, true /* sequentialAccess */);
 }
 
+static void BM_MediaSampleReader_AudioVideo_SequentialPrefetch(benchmark::State& state) {
+    ReadMediaSamples(state, "video_1920x1080_3648frame_h264_22Mbps_30fps_aac.mp4",
+                     true /* readAudio */, true /* sequentialAccess */, true /* prefetch */);
+}
+
 static void BM_MediaSampleReader_Video(benchmark::State& state) {
     ReadMediaSamples(state, "video_1920x1080_3648frame_h264_22Mbps_30fps_aac.mp4",
                      false /* readAudio */);
@@ -149,6 +223,7 @@ static void BM_MediaSampleReader_Video(benchmark::State& state) {
 
 TRANSCODER_BENCHMARK(BM_MediaSampleReader_AudioVideo_Parallel);
 TRANSCODER_BENCHMARK(BM_MediaSampleReader_AudioVideo_Sequential);
+TRANSCODER_BENCHMARK(BM_MediaSampleReader_AudioVideo_SequentialPrefetch);
 TRANSCODER_BENCHMARK(BM_MediaSampleReader_Video);
 
 BENCHMARK_MAIN();
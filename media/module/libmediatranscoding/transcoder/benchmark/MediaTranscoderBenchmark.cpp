@@ -527,6 +527,41 @@ static void BM_3840x2160_Hevc42Mbps2Avc20Mbps(benchmark::State& state) {
                        });
 }
 
+//-------------------------------- Resolution Change Benchmarks ------------------------------------
+static void SetMimeBitrateResolution(AMediaFormat* format, std::string mime, int32_t bitrate,
+                                     int32_t width, int32_t height) {
+    SetMimeBitrate(format, mime, bitrate);
+    AMediaFormat_setInt32(format, AMEDIAFORMAT_KEY_WIDTH, width);
+    AMediaFormat_setInt32(format, AMEDIAFORMAT_KEY_HEIGHT, height);
+}
+
+static void BM_1920x1080_Avc15Mbps2Avc1280x720_4Mbps(benchmark::State& state) {
+    TranscodeMediaFile(state, "tx_bm_1920_1080_30fps_h264_15Mbps.mp4",
+                       "tx_bm_1920_1080_30fps_h264_15Mbps_transcoded_h264_1280x720_4Mbps.mp4",
+                       false /* includeAudio */, true /* transcodeVideo */,
+                       [mime = "video/avc", bitrate = 4000000](AMediaFormat* dstFormat) {
+                           SetMimeBitrateResolution(dstFormat, mime, bitrate, 1280, 720);
+                       });
+}
+
+static void BM_1920x1080_Hevc17Mbps2Avc1280x720_4Mbps(benchmark::State& state) {
+    TranscodeMediaFile(state, "tx_bm_1920_1080_30fps_hevc_17Mbps.mp4",
+                       "tx_bm_1920_1080_30fps_hevc_17Mbps_transcoded_h264_1280x720_4Mbps.mp4",
+                       false /* includeAudio */, true /* transcodeVideo */,
+                       [mime = "video/avc", bitrate = 4000000](AMediaFormat* dstFormat) {
+                           SetMimeBitrateResolution(dstFormat, mime, bitrate, 1280, 720);
+                       });
+}
+
+static void BM_3840x2160_Hevc42Mbps2Avc1920x1080_12Mbps(benchmark::State& state) {
+    TranscodeMediaFile(state, "tx_bm_3840_2160_30fps_hevc_42Mbps.mp4",
+                       "tx_bm_3840_2160_30fps_hevc_42Mbps_transcoded_h264_1920x1080_12Mbps.mp4",
+                       false /* includeAudio */, true /* transcodeVideo */,
+                       [mime = "video/avc", bitrate = 12000000](AMediaFormat* dstFormat) {
+                           SetMimeBitrateResolution(dstFormat, mime, bitrate, 1920, 1080);
+                       });
+}
+
 //-------------------------------- Benchmark Registration ------------------------------------------
 
 // Benchmark registration wrapper for transcoding.
@@ -574,6 +609,10 @@ TRANSCODER_BENCHMARK(BM_720x1280_Avc10Mbps2Avc4Mbps);
 
 TRANSCODER_BENCHMARK(BM_3840x2160_Hevc42Mbps2Avc20Mbps);
 
+TRANSCODER_BENCHMARK(BM_1920x1080_Avc15Mbps2Avc1280x720_4Mbps);
+TRANSCODER_BENCHMARK(BM_1920x1080_Hevc17Mbps2Avc1280x720_4Mbps);
+TRANSCODER_BENCHMARK(BM_3840x2160_Hevc42Mbps2Avc1920x1080_12Mbps);
+
 class CustomCsvReporter : public benchmark::BenchmarkReporter {
 public:
     CustomCsvReporter() : mPrintedHeader(false) {}
@@ -30,12 +30,27 @@ namespace android {
  * MediaSampleQueue asynchronously connects a producer and a consumer of media samples.
  * Media samples flows through the queue in FIFO order. If the queue is empty the consumer will be
  * blocked until a new media sample is added or until the producer aborts the queue operation.
+ * A bounded queue also blocks the producer while it is full, which lets a producer read ahead of
+ * its consumer without buffering an unbounded amount of sample data.
  */
 class MediaSampleQueue {
 public:
+    /** Creates an unbounded queue. */
+    MediaSampleQueue() = default;
+
+    /**
+     * Creates a bounded queue. An empty queue always accepts a sample, even one larger than
+     * maxBytes, so that a single oversized sample cannot stall the producer.
+     * @param maxSamples Maximum number of queued samples, or 0 for no limit.
+     * @param maxBytes Maximum total size of queued sample data, or 0 for no limit.
+     */
+    MediaSampleQueue(size_t maxSamples, size_t maxBytes)
+          : mMaxSamples(maxSamples), mMaxBytes(maxBytes) {}
+
     /**
      * Enqueues a media sample at the end of the queue and notifies potentially waiting consumers.
-     * If the queue has previously been aborted this method does nothing.
+     * If the queue has previously been aborted this method does nothing. Note that for a bounded
+     * queue this method will block while the queue is full.
      * @param sample The media sample to enqueue.
      * @return True if the queue has been aborted.
      */
@@ -61,10 +76,23 @@ public:
      */
     void abort();
 
+    /**
+     * Returns the largest total size of sample data the queue has held at any one time.
+     * @return The high-water mark in bytes.
+     */
+    size_t getPeakQueuedBytes();
+
 private:
+    bool isFull_l(size_t sampleBytes);
+
+    const size_t mMaxSamples = 0;
+    const size_t mMaxBytes = 0;
     std::queue<std::shared_ptr<MediaSample>> mSampleQueue GUARDED_BY(mMutex);
     std::mutex mMutex;
     std::condition_variable mCondition;
+    std::condition_variable mSpaceCondition;
+    size_t mQueuedBytes GUARDED_BY(mMutex) = 0;
+    size_t mPeakQueuedBytes GUARDED_BY(mMutex) = 0;
     bool mAborted GUARDED_BY(mMutex) = false;
 };
 
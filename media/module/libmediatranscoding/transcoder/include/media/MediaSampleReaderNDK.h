@@ -20,6 +20,7 @@
 #include <media/MediaSampleReader.h>
 #include <media/NdkMediaExtractor.h>
 
+#include <deque>
 #include <map>
 #include <memory>
 #include <mutex>
@@ -56,6 +57,15 @@ public:
                                           size_t bufferSize) override;
     void advanceTrack(int trackIndex) override;
 
+    /**
+     * Sets how much sample data the reader may buffer per track in sequential access mode. A
+     * thread waiting for its track reads the samples the extractor points to into their tracks'
+     * read-ahead buffers, instead of blocking until the other tracks consume them. Reads stay
+     * sequential in the file but tracks no longer wait on each other's consumers.
+     * @param maxBytesPerTrack Maximum buffered sample data per track, or 0 to disable read-ahead.
+     */
+    void setReadAheadLimit(size_t maxBytesPerTrack);
+
     virtual ~MediaSampleReaderNDK() override;
 
 private:
@@ -89,6 +99,18 @@ private:
         SamplePosition next;
     };
 
+    /** A sample read ahead of its track's consumer. */
+    struct CachedSample {
+        MediaSampleInfo info;
+        std::vector<uint8_t> data;
+    };
+
+    /** Samples read ahead for a track, in track order. */
+    struct ReadAheadCache {
+        std::deque<CachedSample> samples;
+        size_t bytes = 0;
+    };
+
     /**
      * Creates a new MediaSampleReaderNDK object from an AMediaExtractor. The extractor needs to be
      * initialized with a valid data source before attempting to create a MediaSampleReaderNDK.
@@ -96,9 +118,22 @@ private:
      */
     MediaSampleReaderNDK(AMediaExtractor* extractor);
 
-    /** Advances the track to next sample. */
+    /** Advances the track to next sample, consuming a read-ahead sample first if there is one. */
     void advanceTrack_l(int trackIndex);
 
+    /** Advances the track's extractor cursor to next sample. */
+    void advanceCursor_l(int trackIndex);
+
+    /**
+     * In sequential mode, reads the sample the extractor points to into its track's read-ahead
+     * cache and advances the extractor past it.
+     * @return True if the extractor was advanced.
+     */
+    bool readAhead_l();
+
+    /** Removes the oldest read-ahead sample of the track. */
+    void popCachedSample_l(int trackIndex);
+
     /** Advances the extractor to next sample. */
     bool advanceExtractor_l();
 
@@ -135,6 +170,12 @@ private:
 
     // Samples cursor for each track in the file.
     std::vector<SampleCursor> mTrackCursors;
+
+    // Read-ahead samples for each track in the file.
+    std::vector<ReadAheadCache> mReadAheadCaches;
+    size_t mReadAheadLimit;
+    // Set when a track's read-ahead cache was too full to read ahead.
+    bool mReadAheadStalled = false;
 };
 
 }  // namespace android
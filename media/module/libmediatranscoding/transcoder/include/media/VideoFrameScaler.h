@@ -0,0 +1,102 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_VIDEO_FRAME_SCALER_H
+#define ANDROID_VIDEO_FRAME_SCALER_H
+
+#include <EGL/egl.h>
+#include <GLES2/gl2.h>
+#include <android/native_window.h>
+#include <media/NdkImageReader.h>
+#include <media/NdkMediaError.h>
+
+#include <functional>
+#include <memory>
+
+namespace android {
+
+/**
+ * GPU stage between the video decoder and the video encoder, used when the transcoded resolution
+ * differs from the source. The decoder renders into an AImageReader surface and each frame is
+ * sampled through an EGLImage and drawn, resized, onto the encoder's input surface with GLES.
+ * Frames never leave graphics memory.
+ *
+ * The EGL context is made current on the first thread that calls renderFrame(). All subsequent
+ * calls must come from that same thread.
+ */
+class VideoFrameScaler {
+public:
+    /**
+     * Creates a scaler drawing into the encoder's input surface.
+     * @param encoderSurface The encoder input surface. Not owned by the scaler.
+     * @param srcWidth Width of the decoded frames.
+     * @param srcHeight Height of the decoded frames.
+     * @param dstWidth Width of the encoder input frames.
+     * @param dstHeight Height of the encoder input frames.
+     * @param onFrameAvailable Called on an internal thread each time the decoder renders a frame.
+     * @return The new scaler, or nullptr if EGL or GLES could not be set up.
+     */
+    static std::unique_ptr<VideoFrameScaler> create(ANativeWindow* encoderSurface,
+                                                    int32_t srcWidth, int32_t srcHeight,
+                                                    int32_t dstWidth, int32_t dstHeight,
+                                                    const std::function<void()>& onFrameAvailable);
+
+    ~VideoFrameScaler();
+
+    /** Returns the surface the decoder should render into. Owned by the scaler. */
+    ANativeWindow* getInputSurface() const { return mInputSurface; }
+
+    /**
+     * Draws the oldest frame rendered by the decoder onto the encoder's input surface, keeping
+     * the frame's presentation time.
+     */
+    media_status_t renderFrame();
+
+    /** Releases the EGL context if it is current on the calling thread. */
+    void releaseContext();
+
+private:
+    VideoFrameScaler(int32_t dstWidth, int32_t dstHeight,
+                     const std::function<void()>& onFrameAvailable)
+          : mDstWidth(dstWidth), mDstHeight(dstHeight), mOnFrameAvailable(onFrameAvailable) {}
+
+    static void onImageAvailable(void* context, AImageReader* reader);
+
+    bool initImageReader(int32_t srcWidth, int32_t srcHeight);
+    bool initEgl(ANativeWindow* encoderSurface);
+    bool initProgram();
+
+    const int32_t mDstWidth;
+    const int32_t mDstHeight;
+    std::function<void()> mOnFrameAvailable;
+
+    AImageReader* mImageReader = nullptr;
+    ANativeWindow* mInputSurface = nullptr;
+
+    EGLDisplay mDisplay = EGL_NO_DISPLAY;
+    EGLContext mContext = EGL_NO_CONTEXT;
+    EGLSurface mSurface = EGL_NO_SURFACE;
+    bool mHasNativeFenceSync = false;
+
+    GLuint mProgram = 0;
+    GLuint mTexture = 0;
+    GLint mPositionLoc = -1;
+    GLint mTexCoordLoc = -1;
+    GLint mTextureLoc = -1;
+};
+
+}  // namespace android
+#endif  // ANDROID_VIDEO_FRAME_SCALER_H
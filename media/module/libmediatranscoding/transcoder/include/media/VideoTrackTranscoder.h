@@ -21,6 +21,7 @@
 #include <media/MediaTrackTranscoder.h>
 #include <media/NdkMediaCodecPlatform.h>
 #include <media/NdkMediaFormat.h>
+#include <media/VideoFrameScaler.h>
 
 #include <condition_variable>
 #include <deque>
@@ -81,6 +82,12 @@ private:
     // Moves a decoded buffer from the decoder's output to the encoder's input.
     void transferBuffer(int32_t bufferIndex, AMediaCodecBufferInfo bufferInfo);
 
+    // Draws a decoded frame onto the encoder's input surface at the output resolution.
+    void scaleFrame();
+
+    // Signals end of stream to the encoder once the decoder is done.
+    void signalEncoderEndOfStream();
+
     // Dequeues an encoded buffer from the encoder and adds it to the output queue.
     void dequeueOutputSample(int32_t bufferIndex, AMediaCodecBufferInfo bufferInfo);
 
@@ -90,7 +97,12 @@ private:
     AMediaCodec* mDecoder = nullptr;
     std::shared_ptr<CodecWrapper> mEncoder;
     ANativeWindow* mSurface = nullptr;
+    // Set when the output resolution differs from the source.
+    std::unique_ptr<VideoFrameScaler> mFrameScaler;
+    // Frames rendered by the decoder that the scaler has not yet drawn.
+    uint64_t mPendingScaledFrames = 0;
     bool mEosFromSource = false;
+    bool mEosFromDecoder = false;
     bool mEosFromEncoder = false;
     bool mLastSampleWasSync = false;
     media_status_t mStatus = AMEDIA_OK;
@@ -23,6 +23,7 @@
 #include <gtest/gtest.h>
 #include <media/MediaSampleQueue.h>
 
+#include <atomic>
 #include <thread>
 
 namespace android {
@@ -229,6 +230,71 @@ TEST_F(MediaSampleQueueTests, TestBlockingAbort) {
     abortingThread.join();
 }
 
+static std::shared_ptr<MediaSample> newSample(uint32_t id, size_t size) {
+    std::shared_ptr<MediaSample> sample = newSample(id);
+    sample->info.size = size;
+    return sample;
+}
+
+TEST_F(MediaSampleQueueTests, TestBoundedEnqueueBlocks) {
+    LOG(DEBUG) << "TestBoundedEnqueueBlocks Starts";
+
+    static constexpr int kMaxSamples = 2;
+    MediaSampleQueue sampleQueue(kMaxSamples, 0 /* maxBytes */);
+    for (int i = 0; i < kMaxSamples; ++i) {
+        EXPECT_FALSE(sampleQueue.enqueue(newSample(i)));
+    }
+
+    std::atomic_bool enqueued{false};
+    std::thread enqueueThread([&sampleQueue, &enqueued] {
+        EXPECT_FALSE(sampleQueue.enqueue(newSample(kMaxSamples)));
+        enqueued = true;
+    });
+
+    // Note: This is racy in the same way as TestBlockingDequeue but will not fail regardless.
+    std::this_thread::sleep_for(std::chrono::milliseconds(kThreadDelayDurationMs));
+    EXPECT_FALSE(enqueued);
+
+    for (int i = 0; i <= kMaxSamples; ++i) {
+        std::shared_ptr<MediaSample> sample;
+        EXPECT_FALSE(sampleQueue.dequeue(&sample));
+        EXPECT_NE(sample, nullptr);
+        EXPECT_EQ(sample->bufferId, i);
+    }
+
+    enqueueThread.join();
+    EXPECT_TRUE(enqueued);
+    EXPECT_TRUE(sampleQueue.isEmpty());
+}
+
+TEST_F(MediaSampleQueueTests, TestByteLimit) {
+    LOG(DEBUG) << "TestByteLimit Starts";
+
+    static constexpr size_t kMaxBytes = 100;
+    MediaSampleQueue sampleQueue(0 /* maxSamples */, kMaxBytes);
+
+    // An oversized sample is accepted into an empty queue.
+    EXPECT_FALSE(sampleQueue.enqueue(newSample(0, kMaxBytes * 2)));
+    EXPECT_EQ(sampleQueue.getPeakQueuedBytes(), kMaxBytes * 2);
+
+    std::shared_ptr<MediaSample> sample;
+    EXPECT_FALSE(sampleQueue.dequeue(&sample));
+
+    EXPECT_FALSE(sampleQueue.enqueue(newSample(1, 60)));
+    EXPECT_FALSE(sampleQueue.enqueue(newSample(2, 40)));
+
+    std::thread abortingThread([&sampleQueue] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(kThreadDelayDurationMs));
+        sampleQueue.abort();
+    });
+
+    // The queue is full so this blocks until the queue is aborted.
+    EXPECT_TRUE(sampleQueue.enqueue(newSample(3, 1)));
+    EXPECT_EQ(sampleQueue.getPeakQueuedBytes(), kMaxBytes * 2);
+
+    abortingThread.join();
+}
+
 }  // namespace android
 
 int main(int argc, char** argv) {
@@ -153,6 +153,11 @@ public:
         EXPECT_EQ(status, AMEDIA_OK);
     }
 
+    void setReadAheadLimit(size_t maxBytesPerTrack) {
+        std::static_pointer_cast<MediaSampleReaderNDK>(mSampleReader)
+                ->setReadAheadLimit(maxBytesPerTrack);
+    }
+
     std::vector<std::vector<Sample>>& getSamples() { return mSamples; }
 
     std::shared_ptr<MediaSampleReader> mSampleReader;
@@ -315,6 +320,23 @@ TEST_F(MediaSampleReaderNDKTests, TestSequentialSampleAccess) {
     compareSamples(tester.getSamples());
 }
 
+/**
+ * Reads all samples from each track in turn in sequential mode. This only completes if the reader
+ * reads ahead the samples of the tracks that are not being read.
+ */
+TEST_F(MediaSampleReaderNDKTests, TestSequentialReadAhead) {
+    LOG(DEBUG) << "TestSequentialReadAhead Starts";
+
+    SampleAccessTester tester{mSourceFd, mFileSize};
+    tester.setReadAheadLimit(mFileSize);
+    tester.setEnforceSequentialAccess(true);
+    for (int trackIndex = 0; trackIndex < mTrackCount; ++trackIndex) {
+        tester.readSamplesAsync(trackIndex, SAMPLE_COUNT_ALL);
+        tester.waitForTrack(trackIndex);
+    }
+    compareSamples(tester.getSamples());
+}
+
 /** Reads all samples from one track in parallel mode before switching to sequential mode. */
 TEST_F(MediaSampleReaderNDKTests, TestMixedSampleAccessTrackEOS) {
     LOG(DEBUG) << "TestMixedSampleAccessTrackEOS Starts";
@@ -43,7 +43,9 @@
 #include <utils/KeyedVector.h>
 #include <utils/Vector.h>
 
+#include <algorithm>
 #include <inttypes.h>
+#include <vector>
 
 namespace android {
 using hardware::hidl_string;
@@ -67,15 +69,9 @@ struct ATSParser::Program : public RefBase {
     bool parsePSISection(
             unsigned pid, ABitReader *br, status_t *err);
 
-    // Pass to appropriate stream according to pid, and set event if it's a PES
-    // with a sync frame.
-    // Note that the method itself does not touch event.
-    bool parsePID(
-            unsigned pid, unsigned continuity_counter,
-            unsigned payload_unit_start_indicator,
-            unsigned transport_scrambling_control,
-            unsigned random_access_indicator,
-            ABitReader *br, status_t *err, SyncEvent *event);
+    // Returns the stream carried on pid, or NULL if this program has none.
+    // The pointer stays valid until the next PSI section is parsed.
+    Stream *findStream(unsigned pid);
 
     void signalDiscontinuity(
             DiscontinuityType type, const sp<AMessage> &extra);
@@ -322,27 +318,12 @@ bool ATSParser::Program::parsePSISection(
     return true;
 }
 
-bool ATSParser::Program::parsePID(
-        unsigned pid, unsigned continuity_counter,
-        unsigned payload_unit_start_indicator,
-        unsigned transport_scrambling_control,
-        unsigned random_access_indicator,
-        ABitReader *br, status_t *err, SyncEvent *event) {
-    *err = OK;
-
+ATSParser::Stream *ATSParser::Program::findStream(unsigned pid) {
     ssize_t index = mStreams.indexOfKey(pid);
     if (index < 0) {
-        return false;
+        return NULL;
     }
-
-    *err = mStreams.editValueAt(index)->parse(
-            continuity_counter,
-            payload_unit_start_indicator,
-            transport_scrambling_control,
-            random_access_indicator,
-            br, event);
-
-    return true;
+    return mStreams.editValueAt(index).get();
 }
 
 void ATSParser::Program::signalDiscontinuity(
@@ -1563,7 +1544,8 @@ status_t ATSParser::Stream::flushScrambled(SyncEvent *event) {
     // have PES-level scrambling).
     for (auto it = mSubSamples.begin(); it != mSubSamples.end(); it++) {
         if (it->transport_scrambling_mode != 0) {
-            // TODO: handle keyId change, use the first non-zero keyId for now.
+            // Use the first non-zero keyId for the queue, key changes within the
+            // PES are handled when descrambling to a clear output below.
             if (tsScramblingControl == 0) {
                 tsScramblingControl = it->transport_scrambling_mode;
             }
@@ -1598,64 +1580,97 @@ status_t ATSParser::Stream::flushScrambled(SyncEvent *event) {
         memcpy(mDescrambledBuffer->data(), mBuffer->data(), descrambleBytes);
         mDescrambledBuffer->setRange(0, mBuffer->size());
 
-        hidl_vec<SubSample> subSamples;
-        subSamples.resize(descrambleSubSamples);
+        std::vector<SubSample> allSubSamples(descrambleSubSamples);
+        std::vector<uint32_t> keys(descrambleSubSamples);
 
         int32_t i = 0;
         for (auto it = mSubSamples.begin();
                 it != mSubSamples.end() && i < descrambleSubSamples; it++, i++) {
             if (it->transport_scrambling_mode != 0 || pesScramblingControl != 0) {
-                subSamples[i].numBytesOfClearData = 0;
-                subSamples[i].numBytesOfEncryptedData = it->subSampleSize;
+                allSubSamples[i].numBytesOfClearData = 0;
+                allSubSamples[i].numBytesOfEncryptedData = it->subSampleSize;
             } else {
-                subSamples[i].numBytesOfClearData = it->subSampleSize;
-                subSamples[i].numBytesOfEncryptedData = 0;
+                allSubSamples[i].numBytesOfClearData = it->subSampleSize;
+                allSubSamples[i].numBytesOfEncryptedData = 0;
             }
+            keys[i] = it->transport_scrambling_mode;
         }
 
         // If scrambled at PES-level, PES header is in the clear
         if (pesScramblingControl != 0) {
-            subSamples[0].numBytesOfClearData = pesOffset;
-            subSamples[0].numBytesOfEncryptedData -= pesOffset;
+            allSubSamples[0].numBytesOfClearData = pesOffset;
+            allSubSamples[0].numBytesOfEncryptedData -= pesOffset;
         }
 
-        Status status = Status::OK;
-        uint32_t bytesWritten = 0;
-        hidl_string detailedError;
-
         DestinationBuffer dstBuffer;
         dstBuffer.type = BufferType::SHARED_MEMORY;
         dstBuffer.nonsecureMemory = mDescramblerSrcBuffer;
 
-        auto returnVoid = mDescrambler->descramble(
-                (ScramblingControl) sctrl,
-                subSamples,
-                mDescramblerSrcBuffer,
-                0 /*srcOffset*/,
-                dstBuffer,
-                0 /*dstOffset*/,
-                [&status, &bytesWritten, &detailedError] (
-                        Status _status, uint32_t _bytesWritten,
-                        const hidl_string& _detailedError) {
-                    status = _status;
-                    bytesWritten = _bytesWritten;
-                    detailedError = _detailedError;
-                });
-
-        if (!returnVoid.isOk() || status != Status::OK) {
-            ALOGE("[stream %d] descramble failed, trans=%s, status=%d",
-                    mElementaryPID, returnVoid.description().c_str(), status);
-            return UNKNOWN_ERROR;
-        }
+        // Descramble each run of contiguous subsamples that use the same TS-level key
+        // with one call. Usually the whole PES is a single run; the key only changes
+        // within a PES at an odd/even key switch.
+        descrambleBytes = 0;
+        uint32_t runOffset = 0;
+        for (int32_t start = 0; start < descrambleSubSamples;) {
+            uint32_t runKey = 0;
+            uint32_t runSize = 0;
+            int32_t end = start;
+            for (; end < descrambleSubSamples; end++) {
+                if (keys[end] != 0) {
+                    if (runKey == 0) {
+                        runKey = keys[end];
+                    } else if (keys[end] != runKey) {
+                        break;
+                    }
+                }
+                runSize += allSubSamples[end].numBytesOfClearData
+                        + allSubSamples[end].numBytesOfEncryptedData;
+            }
+            const uint32_t runSctrl = runKey == 0 ? sctrl
+                    : runKey | (sctrl & DescramblerPlugin::kScrambling_Flag_PesHeader);
+
+            hidl_vec<SubSample> subSamples;
+            subSamples.setToExternal(&allSubSamples[start], end - start);
+
+            Status status = Status::OK;
+            uint32_t bytesWritten = 0;
+            hidl_string detailedError;
+
+            auto returnVoid = mDescrambler->descramble(
+                    (ScramblingControl) runSctrl,
+                    subSamples,
+                    mDescramblerSrcBuffer,
+                    runOffset /*srcOffset*/,
+                    dstBuffer,
+                    runOffset /*dstOffset*/,
+                    [&status, &bytesWritten, &detailedError] (
+                            Status _status, uint32_t _bytesWritten,
+                            const hidl_string& _detailedError) {
+                        status = _status;
+                        bytesWritten = _bytesWritten;
+                        detailedError = _detailedError;
+                    });
+
+            if (!returnVoid.isOk() || status != Status::OK) {
+                ALOGE("[stream %d] descramble failed, trans=%s, status=%d",
+                        mElementaryPID, returnVoid.description().c_str(), status);
+                return UNKNOWN_ERROR;
+            }
 
-        ALOGV("[stream %d] descramble succeeded, %d bytes",
-                mElementaryPID, bytesWritten);
+            ALOGV("[stream %d] descramble succeeded, %d bytes at %u",
+                    mElementaryPID, bytesWritten, runOffset);
 
-        // Set descrambleBytes to the returned result.
-        // Note that this might be smaller than the total length of input data.
-        // (eg. when we're descrambling the PES header portion of a secure stream,
-        // the plugin might cut it off right after the PES header.)
-        descrambleBytes = bytesWritten;
+            // Set descrambleBytes to the returned result.
+            // Note that this might be smaller than the total length of input data.
+            // (eg. when we're descrambling the PES header portion of a secure stream,
+            // the plugin might cut it off right after the PES header.)
+            descrambleBytes = runOffset + bytesWritten;
+            if (bytesWritten < runSize) {
+                break;
+            }
+            runOffset += runSize;
+            start = end;
+        }
     }
 
     // |buffer| points to the buffer from which we'd parse the PES header.
@@ -1903,6 +1918,7 @@ ATSParser::ATSParser(uint32_t flags)
       mTimeOffsetUs(0LL),
       mLastRecoveredPTS(-1LL),
       mNumTSPacketsParsed(0),
+      mStreamsByPID(kNumPIDs, NULL),
       mNumPCRs(0) {
     mPSISections.add(0 /* PID */, new PSISection);
     mCasManager = new CasManager();
@@ -1918,8 +1934,24 @@ status_t ATSParser::feedTSPacket(const void *data, size_t size,
         return BAD_VALUE;
     }
 
-    ABitReader br((const uint8_t *)data, kTSPacketSize);
-    return parseTS(&br, event);
+    return parseTS((const uint8_t *)data, event);
+}
+
+status_t ATSParser::feedTSPackets(const void *data, size_t size) {
+    if (size % kTSPacketSize != 0) {
+        ALOGE("Wrong TS packets size %zu", size);
+        return BAD_VALUE;
+    }
+
+    const uint8_t *packet = (const uint8_t *)data;
+    const uint8_t *end = packet + size;
+    for (; packet < end; packet += kTSPacketSize) {
+        status_t err = parseTS(packet, NULL);
+        if (err != OK) {
+            return err;
+        }
+    }
+    return OK;
 }
 
 status_t ATSParser::setMediaCas(const sp<ICas> &cas) {
@@ -2065,6 +2097,16 @@ status_t ATSParser::parsePID(
         unsigned transport_scrambling_control,
         unsigned random_access_indicator,
         SyncEvent *event) {
+    Stream *stream = mStreamsByPID[PID];
+    if (stream != NULL) {
+        return stream->parse(
+                continuity_counter,
+                payload_unit_start_indicator,
+                transport_scrambling_control,
+                random_access_indicator,
+                br, event);
+    }
+
     ssize_t sectionIndex = mPSISections.indexOfKey(PID);
 
     if (sectionIndex >= 0) {
@@ -2097,6 +2139,10 @@ status_t ATSParser::parsePID(
         if (!section->isCRCOkay()) {
             return BAD_VALUE;
         }
+
+        // Programs, their streams and the set of PSI PIDs can all change below.
+        std::fill(mStreamsByPID.begin(), mStreamsByPID.end(), (Stream *)NULL);
+
         ABitReader sectionBits(section->data(), section->size());
 
         if (PID == 0) {
@@ -2131,27 +2177,20 @@ status_t ATSParser::parsePID(
         return OK;
     }
 
-    bool handled = false;
     for (size_t i = 0; i < mPrograms.size(); ++i) {
-        status_t err;
-        if (mPrograms.editItemAt(i)->parsePID(
-                    PID, continuity_counter,
+        stream = mPrograms.editItemAt(i)->findStream(PID);
+        if (stream != NULL) {
+            mStreamsByPID[PID] = stream;
+            return stream->parse(
+                    continuity_counter,
                     payload_unit_start_indicator,
                     transport_scrambling_control,
                     random_access_indicator,
-                    br, &err, event)) {
-            if (err != OK) {
-                return err;
-            }
-
-            handled = true;
-            break;
+                    br, event);
         }
     }
 
-    if (!handled) {
-        handled = mCasManager->parsePID(br, PID);
-    }
+    bool handled = mCasManager->parsePID(br, PID);
 
     if (!handled) {
         ALOGV("PID 0x%04x not handled.", PID);
@@ -2230,37 +2269,42 @@ status_t ATSParser::parseAdaptationField(
     return OK;
 }
 
-status_t ATSParser::parseTS(ABitReader *br, SyncEvent *event) {
+status_t ATSParser::parseTS(const uint8_t *packet, SyncEvent *event) {
     ALOGV("---");
 
-    unsigned sync_byte = br->getBits(8);
+    unsigned sync_byte = packet[0];
     if (sync_byte != 0x47u) {
         ALOGE("[error] parseTS: return error as sync_byte=0x%x", sync_byte);
         return BAD_VALUE;
     }
 
-    if (br->getBits(1)) {  // transport_error_indicator
+    if (packet[1] & 0x80) {  // transport_error_indicator
         // silently ignore.
         return OK;
     }
 
-    unsigned payload_unit_start_indicator = br->getBits(1);
+    // The fixed 4-byte header is decoded directly, the adaptation field and
+    // payload through a bit reader positioned after it.
+    unsigned payload_unit_start_indicator = (packet[1] >> 6) & 1;
     ALOGV("payload_unit_start_indicator = %u", payload_unit_start_indicator);
 
-    MY_LOGV("transport_priority = %u", br->getBits(1));
+    MY_LOGV("transport_priority = %u", (packet[1] >> 5) & 1);
 
-    unsigned PID = br->getBits(13);
+    unsigned PID = ((packet[1] & 0x1f) << 8) | packet[2];
     ALOGV("PID = 0x%04x", PID);
 
-    unsigned transport_scrambling_control = br->getBits(2);
+    unsigned transport_scrambling_control = packet[3] >> 6;
     ALOGV("transport_scrambling_control = %u", transport_scrambling_control);
 
-    unsigned adaptation_field_control = br->getBits(2);
+    unsigned adaptation_field_control = (packet[3] >> 4) & 3;
     ALOGV("adaptation_field_control = %u", adaptation_field_control);
 
-    unsigned continuity_counter = br->getBits(4);
+    unsigned continuity_counter = packet[3] & 0x0f;
     ALOGV("PID = 0x%04x, continuity_counter = %u", PID, continuity_counter);
 
+    ABitReader reader(packet + 4, kTSPacketSize - 4);
+    ABitReader *br = &reader;
+
     // ALOGI("PID = 0x%04x, continuity_counter = %u", PID, continuity_counter);
 
     status_t err = OK;
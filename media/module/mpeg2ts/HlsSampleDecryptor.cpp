@@ -21,6 +21,7 @@
 
 #include <media/stagefright/foundation/ABuffer.h>
 #include <media/stagefright/foundation/ADebug.h>
+#include <media/stagefright/foundation/avc_utils.h>
 #include <media/stagefright/Utils.h>
 
 
@@ -90,9 +91,9 @@ size_t HlsSampleDecryptor::processNal(uint8_t *nalData, size_t nalSize) {
     if (isEncrypted) {
         // Encrypted NALUs have extra start code emulation prevention that must be
         // stripped out before we can decrypt it.
-        size_t newSize = unescapeStream(nalData, nalSize);
+        size_t newSize = RemoveEmulationPreventionBytes(nalData, nalSize);
 
-        ALOGV("processNal:unescapeStream[%d]: %zu -> %zu", nalType, nalSize, newSize);
+        ALOGV("processNal:RemoveEmulationPreventionBytes[%d]: %zu -> %zu", nalType, nalSize, newSize);
         nalSize = newSize;
 
         //Encrypted_nal_unit () {
@@ -261,50 +262,6 @@ void HlsSampleDecryptor::processAC3(uint8_t *data, size_t size) {
     }
 }
 
-// Unescapes data replacing occurrences of [0, 0, 3] with [0, 0] and returns the new size
-size_t HlsSampleDecryptor::unescapeStream(uint8_t *data, size_t limit) const {
-    Vector<size_t> scratchEscapePositions;
-    size_t position = 0;
-
-    while (position < limit) {
-        position = findNextUnescapeIndex(data, position, limit);
-        if (position < limit) {
-            scratchEscapePositions.add(position);
-            position += 3;
-        }
-    }
-
-    size_t scratchEscapeCount = scratchEscapePositions.size();
-    size_t escapedPosition = 0; // The position being read from.
-    size_t unescapedPosition = 0; // The position being written to.
-    for (size_t i = 0; i < scratchEscapeCount; i++) {
-        size_t nextEscapePosition = scratchEscapePositions[i];
-        //TODO: add 2 and get rid of the later = 0 assignments
-        size_t copyLength = nextEscapePosition - escapedPosition;
-        memmove(data+unescapedPosition, data+escapedPosition, copyLength);
-        unescapedPosition += copyLength;
-        data[unescapedPosition++] = 0;
-        data[unescapedPosition++] = 0;
-        escapedPosition += copyLength + 3;
-    }
-
-    size_t unescapedLength = limit - scratchEscapeCount;
-    size_t remainingLength = unescapedLength - unescapedPosition;
-    memmove(data+unescapedPosition, data+escapedPosition, remainingLength);
-
-    return unescapedLength;
-}
-
-size_t HlsSampleDecryptor::findNextUnescapeIndex(uint8_t *data, size_t offset, size_t limit) const {
-    for (size_t i = offset; i < limit - 2; i++) {
-        //TODO: speed
-        if (data[i] == 0x00 && data[i + 1] == 0x00 && data[i + 2] == 0x03) {
-            return i;
-        }
-    }
-    return limit;
-}
-
 status_t HlsSampleDecryptor::decryptBlock(uint8_t *buffer, size_t size,
         uint8_t AESInitVec[AES_BLOCK_SIZE]) {
     if (size == 0) {
@@ -122,6 +122,10 @@ struct ATSParser : public RefBase {
     status_t feedTSPacket(
             const void *data, size_t size, SyncEvent *event = NULL);
 
+    // Feed a run of contiguous TS packets, |size| must be a multiple of the
+    // packet size. Stops at and returns the first error.
+    status_t feedTSPackets(const void *data, size_t size);
+
     void signalDiscontinuity(
             DiscontinuityType type, const sp<AMessage> &extra);
 
@@ -223,6 +227,11 @@ private:
 
     size_t mNumTSPacketsParsed;
 
+    // Elementary stream of each PID, filled as packets are demuxed and
+    // cleared whenever a PSI section is parsed.
+    enum { kNumPIDs = 1 << 13 };
+    std::vector<Stream *> mStreamsByPID;
+
     sp<AMessage> mSampleAesKeyItem;
 
     void parseProgramAssociationTable(ABitReader *br);
@@ -249,7 +258,7 @@ private:
             ABitReader *br, unsigned PID, unsigned *random_access_indicator);
 
     // see feedTSPacket().
-    status_t parseTS(ABitReader *br, SyncEvent *event);
+    status_t parseTS(const uint8_t *packet, SyncEvent *event);
 
     void updatePCR(unsigned PID, uint64_t PCR, uint64_t byteOffsetFromStart);
 
@@ -134,6 +134,10 @@ protected:
     sp<ABuffer> dequeueAccessUnitDTSOrDTSHD();
     sp<ABuffer> dequeueAccessUnitDTSUHD();
 
+    // drop "size" bytes from the front of mBuffer. The bytes are skipped
+    // rather than moved, appendData() reclaims the space when it needs it.
+    void consumeData(size_t size);
+
     // consume a logical (compressed) access unit of size "size",
     // returns its timestamp in us (or -1 if no time information).
     int64_t fetchTimestamp(size_t size,
@@ -46,8 +46,6 @@ struct HlsSampleDecryptor : SampleDecryptor {
     static AString aesBlockToStr(uint8_t block[AES_BLOCK_SIZE]);
 
 private:
-    size_t unescapeStream(uint8_t *data, size_t limit) const;
-    size_t findNextUnescapeIndex(uint8_t *data, size_t offset, size_t limit) const;
     status_t decryptBlock(uint8_t *buffer, size_t size, uint8_t AESInitVec[AES_BLOCK_SIZE]);
 
     static const int VIDEO_CLEAR_LEAD = 32;
@@ -113,14 +113,10 @@ bool MtpFfsHandle::openEndpoints(bool ptp) {
 }
 
 void MtpFfsHandle::advise(int fd) {
-    for (unsigned i = 0; i < NUM_IO_BUFS; i++) {
-        if (posix_madvise(mIobuf[i].bufs.data(), MAX_FILE_CHUNK_SIZE,
-                POSIX_MADV_SEQUENTIAL | POSIX_MADV_WILLNEED) != 0)
-            PLOG(ERROR) << "Failed to madvise";
-    }
-    if (posix_fadvise(fd, 0, 0,
-                POSIX_FADV_SEQUENTIAL | POSIX_FADV_NOREUSE | POSIX_FADV_WILLNEED) != 0)
-        PLOG(ERROR) << "Failed to fadvise";
+    // The advice values are not flags and cannot be combined.
+    int ret = posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    if (ret != 0)
+        LOG(ERROR) << "Failed to fadvise: " << strerror(ret);
 }
 
 bool MtpFfsHandle::writeDescriptors(bool ptp) {
@@ -279,6 +275,9 @@ int MtpFfsHandle::start(bool ptp) {
             mIobuf[i].buf[j] = mIobuf[i].bufs.data() + j * AIO_BUF_LEN;
             mIobuf[i].iocb[j] = &mIobuf[i].iocbs[j];
         }
+        // The buffers are reused for every transfer, so advise them once.
+        if (posix_madvise(mIobuf[i].bufs.data(), MAX_FILE_CHUNK_SIZE, POSIX_MADV_SEQUENTIAL) != 0)
+            PLOG(ERROR) << "Failed to madvise";
     }
 
     memset(&mCtx, 0, sizeof(mCtx));
@@ -572,10 +571,12 @@ int MtpFfsHandle::sendFile(mtp_file_range mfr) {
     uint64_t offset = mfr.offset;
     int packet_size = getPacketSize(mBulkIn);
 
+    // The header and the first chunk of the file are sent in one transfer, queued like
+    // the following chunks, so that it overlaps with reading the next chunk from disk.
     // If file_length is larger than a size_t, truncating would produce the wrong comparison.
     // Instead, promote the left side to 64 bits, then truncate the small result.
     int init_read_len = std::min(
-            static_cast<uint64_t>(packet_size - sizeof(mtp_data_header)), file_length);
+            static_cast<uint64_t>(MAX_FILE_CHUNK_SIZE - sizeof(mtp_data_header)), file_length);
 
     advise(mfr.fd);
 
@@ -601,12 +602,14 @@ int MtpFfsHandle::sendFile(mtp_file_range mfr) {
     if (TEMP_FAILURE_RETRY(pread(mfr.fd, mIobuf[0].bufs.data() +
                     sizeof(mtp_data_header), init_read_len, offset))
             != init_read_len) return -1;
-    if (doAsync(mIobuf[0].bufs.data(), sizeof(mtp_data_header) + init_read_len,
-                false, false /* zlps are handled below */) == -1)
+    if (iobufSubmit(&mIobuf[0], mBulkIn, sizeof(mtp_data_header) + init_read_len,
+                false) == -1)
         return -1;
+    has_write = true;
     file_length -= init_read_len;
     offset += init_read_len;
     ret = init_read_len + sizeof(mtp_data_header);
+    i = 1;
 
     // Break down the file into pieces that fit in buffers
     while(file_length > 0 || has_write) {
@@ -658,6 +661,10 @@ int MtpFfsHandle::sendFile(mtp_file_range mfr) {
         i = (i + 1) % NUM_IO_BUFS;
     }
 
+    if (error) {
+        return -1;
+    }
+
     if (ret % packet_size == 0) {
         // If the last packet wasn't short, send a final empty packet
         if (write(mIobuf[0].bufs.data(), 0) != 0) {
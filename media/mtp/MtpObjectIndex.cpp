@@ -0,0 +1,143 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "MtpObjectIndex"
+
+#include "MtpDebug.h"
+#include "MtpObjectIndex.h"
+#include "MtpObjectInfo.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+namespace android {
+
+MtpObjectIndex::MtpObjectIndex()
+    :   mGeneration(0)
+{
+}
+
+uint32_t MtpObjectIndex::getGeneration() {
+    std::lock_guard<std::mutex> lg(mMutex);
+    return mGeneration;
+}
+
+bool MtpObjectIndex::getObjectList(MtpStorageID storageID, MtpObjectFormat format,
+        MtpObjectHandle parent, MtpObjectHandleList& handles) {
+    std::lock_guard<std::mutex> lg(mMutex);
+    auto iter = mLists.find(ListKey(storageID, format, parent));
+    if (iter == mLists.end())
+        return false;
+    handles = iter->second;
+    return true;
+}
+
+void MtpObjectIndex::putObjectList(uint32_t generation, MtpStorageID storageID,
+        MtpObjectFormat format, MtpObjectHandle parent, const MtpObjectHandleList& handles) {
+    std::lock_guard<std::mutex> lg(mMutex);
+    if (generation != mGeneration)
+        return;
+    if (mLists.size() >= kMaxLists)
+        mLists.clear();
+    mLists[ListKey(storageID, format, parent)] = handles;
+}
+
+bool MtpObjectIndex::getObjectInfo(MtpObjectHandle handle, MtpObjectInfo& info) {
+    std::lock_guard<std::mutex> lg(mMutex);
+    auto iter = mObjects.find(handle);
+    if (iter == mObjects.end())
+        return false;
+    const Entry& entry = iter->second;
+    char* name = strdup(entry.name.c_str());
+    char* keywords = strdup(entry.keywords.c_str());
+    if (!name || !keywords) {
+        free(name);
+        free(keywords);
+        return false;
+    }
+
+    info.mHandle = entry.handle;
+    info.mStorageID = entry.storageID;
+    info.mFormat = entry.format;
+    info.mProtectionStatus = entry.protectionStatus;
+    info.mCompressedSize = entry.compressedSize;
+    info.mThumbFormat = entry.thumbFormat;
+    info.mThumbCompressedSize = entry.thumbCompressedSize;
+    info.mThumbPixWidth = entry.thumbPixWidth;
+    info.mThumbPixHeight = entry.thumbPixHeight;
+    info.mImagePixWidth = entry.imagePixWidth;
+    info.mImagePixHeight = entry.imagePixHeight;
+    info.mImagePixDepth = entry.imagePixDepth;
+    info.mParent = entry.parent;
+    info.mAssociationType = entry.associationType;
+    info.mAssociationDesc = entry.associationDesc;
+    info.mSequenceNumber = entry.sequenceNumber;
+    free(info.mName);
+    info.mName = name;
+    info.mDateCreated = entry.dateCreated;
+    info.mDateModified = entry.dateModified;
+    free(info.mKeywords);
+    info.mKeywords = keywords;
+    return true;
+}
+
+void MtpObjectIndex::putObjectInfo(uint32_t generation, const MtpObjectInfo& info) {
+    std::lock_guard<std::mutex> lg(mMutex);
+    if (generation != mGeneration)
+        return;
+    if (mObjects.size() >= kMaxObjects)
+        mObjects.clear();
+
+    Entry& entry = mObjects[info.mHandle];
+    entry.handle = info.mHandle;
+    entry.storageID = info.mStorageID;
+    entry.format = info.mFormat;
+    entry.protectionStatus = info.mProtectionStatus;
+    entry.compressedSize = info.mCompressedSize;
+    entry.thumbFormat = info.mThumbFormat;
+    entry.thumbCompressedSize = info.mThumbCompressedSize;
+    entry.thumbPixWidth = info.mThumbPixWidth;
+    entry.thumbPixHeight = info.mThumbPixHeight;
+    entry.imagePixWidth = info.mImagePixWidth;
+    entry.imagePixHeight = info.mImagePixHeight;
+    entry.imagePixDepth = info.mImagePixDepth;
+    entry.parent = info.mParent;
+    entry.associationType = info.mAssociationType;
+    entry.associationDesc = info.mAssociationDesc;
+    entry.sequenceNumber = info.mSequenceNumber;
+    entry.name = info.mName ? info.mName : "";
+    entry.dateCreated = info.mDateCreated;
+    entry.dateModified = info.mDateModified;
+    entry.keywords = info.mKeywords ? info.mKeywords : "";
+}
+
+void MtpObjectIndex::objectChanged(MtpObjectHandle handle) {
+    std::lock_guard<std::mutex> lg(mMutex);
+    ALOGV("objectChanged %d", handle);
+    mGeneration++;
+    mObjects.erase(handle);
+    // Any list may gain or lose the object, and which ones is not known.
+    mLists.clear();
+}
+
+void MtpObjectIndex::clear() {
+    std::lock_guard<std::mutex> lg(mMutex);
+    mGeneration++;
+    mObjects.clear();
+    mLists.clear();
+}
+
+}  // namespace android
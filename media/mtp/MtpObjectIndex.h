@@ -0,0 +1,103 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _MTP_OBJECT_INDEX_H
+#define _MTP_OBJECT_INDEX_H
+
+#include "MtpTypes.h"
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <time.h>
+#include <tuple>
+
+namespace android {
+
+class MtpObjectInfo;
+
+// In-process index of the object handles and object info returned by the database,
+// so that hosts enumerating the same directories again do not go back to the database
+// for every request.
+//
+// The index is only correct as long as it is told about every change: the server
+// reports the objects it adds, removes or modifies itself, and the database reports
+// changes made on the device through MtpServer::sendObjectAdded() and friends.
+// Entries are dropped rather than updated.
+//
+// Lookups return a generation that must be passed back when storing the database
+// result, so that a result read before a concurrent change is not stored.
+class MtpObjectIndex {
+public:
+                        MtpObjectIndex();
+
+    uint32_t            getGeneration();
+
+    // Returns false and leaves 'handles' unchanged if the list is not indexed.
+    bool                getObjectList(MtpStorageID storageID, MtpObjectFormat format,
+                                MtpObjectHandle parent, MtpObjectHandleList& handles);
+    void                putObjectList(uint32_t generation, MtpStorageID storageID,
+                                MtpObjectFormat format, MtpObjectHandle parent,
+                                const MtpObjectHandleList& handles);
+
+    // Returns false and leaves 'info' unchanged if the object is not indexed.
+    bool                getObjectInfo(MtpObjectHandle handle, MtpObjectInfo& info);
+    void                putObjectInfo(uint32_t generation, const MtpObjectInfo& info);
+
+    // An object was added, removed, renamed, moved or modified.
+    void                objectChanged(MtpObjectHandle handle);
+    void                clear();
+
+private:
+    // The object info, with the strings owned by the index.
+    struct Entry {
+        MtpObjectHandle     handle;
+        MtpStorageID        storageID;
+        MtpObjectFormat     format;
+        uint16_t            protectionStatus;
+        uint32_t            compressedSize;
+        MtpObjectFormat     thumbFormat;
+        uint32_t            thumbCompressedSize;
+        uint32_t            thumbPixWidth;
+        uint32_t            thumbPixHeight;
+        uint32_t            imagePixWidth;
+        uint32_t            imagePixHeight;
+        uint32_t            imagePixDepth;
+        MtpObjectHandle     parent;
+        uint16_t            associationType;
+        uint32_t            associationDesc;
+        uint32_t            sequenceNumber;
+        std::string         name;
+        time_t              dateCreated;
+        time_t              dateModified;
+        std::string         keywords;
+    };
+
+    typedef std::tuple<MtpStorageID, MtpObjectFormat, MtpObjectHandle> ListKey;
+
+    // Bounds the memory used when a host walks a very large storage.
+    static constexpr size_t kMaxObjects = 65536;
+    static constexpr size_t kMaxLists = 1024;
+
+    std::mutex          mMutex;
+    uint32_t            mGeneration;
+    std::map<MtpObjectHandle, Entry> mObjects;
+    std::map<ListKey, MtpObjectHandleList> mLists;
+};
+
+}; // namespace android
+
+#endif // _MTP_OBJECT_INDEX_H
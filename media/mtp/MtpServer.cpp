@@ -138,6 +138,7 @@ void MtpServer::addStorage(MtpStorage* storage) {
     std::lock_guard<std::mutex> lg(mMutex);
 
     mStorages.push_back(storage);
+    mObjectIndex.clear();
     sendStoreAdded(storage->getStorageID());
 }
 
@@ -147,6 +148,7 @@ void MtpServer::removeStorage(MtpStorage* storage) {
     if (iter != mStorages.end()) {
         sendStoreRemoved(storage->getStorageID());
         mStorages.erase(iter);
+        mObjectIndex.clear();
     }
 }
 
@@ -255,16 +257,20 @@ void MtpServer::run() {
 
 void MtpServer::sendObjectAdded(MtpObjectHandle handle) {
     ALOGV("sendObjectAdded %d\n", handle);
+    mObjectIndex.objectChanged(handle);
     sendEvent(MTP_EVENT_OBJECT_ADDED, handle);
 }
 
 void MtpServer::sendObjectRemoved(MtpObjectHandle handle) {
     ALOGV("sendObjectRemoved %d\n", handle);
+    // the descendants of a directory are removed with it
+    mObjectIndex.clear();
     sendEvent(MTP_EVENT_OBJECT_REMOVED, handle);
 }
 
 void MtpServer::sendObjectInfoChanged(MtpObjectHandle handle) {
     ALOGV("sendObjectInfoChanged %d\n", handle);
+    mObjectIndex.objectChanged(handle);
     sendEvent(MTP_EVENT_OBJECT_INFO_CHANGED, handle);
 }
 
@@ -323,6 +329,7 @@ void MtpServer::removeEditObject(MtpObjectHandle handle) {
 
 void MtpServer::commitEdit(ObjectEdit* edit) {
     mDatabase->rescanFile((const char *)edit->mPath, edit->mHandle, edit->mFormat);
+    mObjectIndex.objectChanged(edit->mHandle);
 }
 
 
@@ -515,6 +522,7 @@ MtpResponseCode MtpServer::doOpenSession() {
 
     mSessionID = mRequest.getParameter(1);
     mSessionOpen = true;
+    mObjectIndex.clear();
 
     return MTP_RESPONSE_OK;
 }
@@ -524,6 +532,7 @@ MtpResponseCode MtpServer::doCloseSession() {
         return MTP_RESPONSE_SESSION_NOT_OPEN;
     mSessionID = 0;
     mSessionOpen = false;
+    mObjectIndex.clear();
     return MTP_RESPONSE_OK;
 }
 
@@ -590,9 +599,17 @@ MtpResponseCode MtpServer::doGetObjectHandles() {
     if (!hasStorage(storageID))
         return MTP_RESPONSE_INVALID_STORAGE_ID;
 
+    MtpObjectHandleList indexed;
+    if (mObjectIndex.getObjectList(storageID, format, parent, indexed)) {
+        mData.putAUInt32(&indexed);
+        return MTP_RESPONSE_OK;
+    }
+
+    uint32_t generation = mObjectIndex.getGeneration();
     MtpObjectHandleList* handles = mDatabase->getObjectList(storageID, format, parent);
     if (handles == NULL)
         return MTP_RESPONSE_INVALID_OBJECT_HANDLE;
+    mObjectIndex.putObjectList(generation, storageID, format, parent, *handles);
     mData.putAUInt32(handles);
     delete handles;
     return MTP_RESPONSE_OK;
@@ -610,7 +627,12 @@ MtpResponseCode MtpServer::doGetNumObjects() {
     if (!hasStorage(storageID))
         return MTP_RESPONSE_INVALID_STORAGE_ID;
 
-    int count = mDatabase->getNumObjects(storageID, format, parent);
+    int count;
+    MtpObjectHandleList indexed;
+    if (mObjectIndex.getObjectList(storageID, format, parent, indexed))
+        count = indexed.size();
+    else
+        count = mDatabase->getNumObjects(storageID, format, parent);
     if (count >= 0) {
         mResponse.setParameter(1, count);
         return MTP_RESPONSE_OK;
@@ -680,6 +702,7 @@ MtpResponseCode MtpServer::doSetObjectPropValue() {
     ALOGV("SetObjectPropValue %d %s\n", handle,
             MtpDebug::getObjectPropCodeName(property));
 
+    mObjectIndex.objectChanged(handle);
     return mDatabase->setObjectPropertyValue(handle, property, mData);
 }
 
@@ -739,7 +762,13 @@ MtpResponseCode MtpServer::doGetObjectInfo() {
         return MTP_RESPONSE_INVALID_PARAMETER;
     MtpObjectHandle handle = mRequest.getParameter(1);
     MtpObjectInfo info(handle);
-    MtpResponseCode result = mDatabase->getObjectInfo(handle, info);
+    MtpResponseCode result = MTP_RESPONSE_OK;
+    if (!mObjectIndex.getObjectInfo(handle, info)) {
+        uint32_t generation = mObjectIndex.getGeneration();
+        result = mDatabase->getObjectInfo(handle, info);
+        if (result == MTP_RESPONSE_OK)
+            mObjectIndex.putObjectInfo(generation, info);
+    }
     if (result == MTP_RESPONSE_OK) {
         char    date[20];
 
@@ -1029,6 +1058,7 @@ MtpResponseCode MtpServer::doSendObjectInfo() {
     if (handle == kInvalidObjectHandle) {
         return MTP_RESPONSE_GENERAL_ERROR;
     }
+    mObjectIndex.objectChanged(handle);
 
     if (format == MTP_FORMAT_ASSOCIATION) {
         int ret = makeFolder((const char *)path);
@@ -1125,6 +1155,8 @@ MtpResponseCode MtpServer::doMoveObject() {
     // If the move failed, undo the database change
     mDatabase->endMoveObject(info.mParent, parent, info.mStorageID, storageID, objectHandle,
             result == MTP_RESPONSE_OK);
+    // the descendants of a directory move with it
+    mObjectIndex.clear();
 
     return result;
 }
@@ -1194,6 +1226,7 @@ MtpResponseCode MtpServer::doCopyObject() {
     }
 
     mDatabase->endCopyObject(handle, result);
+    mObjectIndex.objectChanged(handle);
     mResponse.setParameter(1, handle);
     return result;
 }
@@ -1298,6 +1331,7 @@ done:
     mData.reset();
 
     mDatabase->endSendObject(mSendObjectHandle, result == MTP_RESPONSE_OK);
+    mObjectIndex.objectChanged(mSendObjectHandle);
     mSendObjectHandle = kInvalidObjectHandle;
     mSendObjectFormat = 0;
     mSendObjectModifiedTime = 0;
@@ -1334,6 +1368,8 @@ MtpResponseCode MtpServer::doDeleteObject() {
     bool success = deletePath((const char *)filePath);
 
     mDatabase->endDeleteObject(handle, success);
+    // the descendants of a directory are deleted with it
+    mObjectIndex.clear();
     return success ? result : MTP_RESPONSE_PARTIAL_DELETION;
 }
 
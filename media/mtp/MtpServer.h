@@ -25,6 +25,7 @@
 #include "mtp.h"
 #include "MtpUtils.h"
 #include "IMtpHandle.h"
+#include "MtpObjectIndex.h"
 
 #include <memory>
 #include <mutex>
@@ -43,6 +44,9 @@ class MtpServer {
 private:
     IMtpDatabase*       mDatabase;
 
+    // answers repeated enumeration requests without going to the database
+    MtpObjectIndex      mObjectIndex;
+
     // appear as a PTP device
     bool                mPtp;
 
@@ -0,0 +1,114 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#define LOG_TAG "MtpObjectIndex_test.cpp"
+
+#include <gtest/gtest.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "MtpObjectIndex.h"
+#include "MtpObjectInfo.h"
+#include "mtp.h"
+
+namespace android {
+
+static void fillInfo(MtpObjectInfo& info, MtpObjectHandle parent, const char* name) {
+    info.mStorageID = 0x10001;
+    info.mFormat = MTP_FORMAT_EXIF_JPEG;
+    info.mCompressedSize = 12345;
+    info.mParent = parent;
+    info.mName = strdup(name);
+    info.mDateModified = 1000;
+    info.mKeywords = strdup("");
+}
+
+TEST(MtpObjectIndexTest, testObjectListRoundTrip) {
+    MtpObjectIndex index;
+    MtpObjectHandleList handles;
+    EXPECT_FALSE(index.getObjectList(0x10001, 0, 5, handles));
+
+    index.putObjectList(index.getGeneration(), 0x10001, 0, 5, {6, 7, 8});
+    ASSERT_TRUE(index.getObjectList(0x10001, 0, 5, handles));
+    EXPECT_EQ(MtpObjectHandleList({6, 7, 8}), handles);
+
+    // other filters are separate entries
+    EXPECT_FALSE(index.getObjectList(0x10001, MTP_FORMAT_EXIF_JPEG, 5, handles));
+    EXPECT_FALSE(index.getObjectList(0xFFFFFFFF, 0, 5, handles));
+}
+
+TEST(MtpObjectIndexTest, testObjectInfoRoundTrip) {
+    MtpObjectIndex index;
+    MtpObjectInfo info(7);
+    fillInfo(info, 5, "IMG_0001.jpg");
+    index.putObjectInfo(index.getGeneration(), info);
+
+    MtpObjectInfo out(7);
+    out.mName = strdup("stale");
+    ASSERT_TRUE(index.getObjectInfo(7, out));
+    EXPECT_EQ(7u, out.mHandle);
+    EXPECT_EQ(0x10001u, out.mStorageID);
+    EXPECT_EQ(MTP_FORMAT_EXIF_JPEG, out.mFormat);
+    EXPECT_EQ(12345u, out.mCompressedSize);
+    EXPECT_EQ(5u, out.mParent);
+    EXPECT_STREQ("IMG_0001.jpg", out.mName);
+    EXPECT_EQ(1000, out.mDateModified);
+    EXPECT_STREQ("", out.mKeywords);
+
+    MtpObjectInfo missing(8);
+    EXPECT_FALSE(index.getObjectInfo(8, missing));
+    EXPECT_EQ(nullptr, missing.mName);
+}
+
+TEST(MtpObjectIndexTest, testObjectChangedDropsEntries) {
+    MtpObjectIndex index;
+    MtpObjectInfo info6(6), info7(7);
+    fillInfo(info6, 5, "a.jpg");
+    fillInfo(info7, 5, "b.jpg");
+    uint32_t generation = index.getGeneration();
+    index.putObjectInfo(generation, info6);
+    index.putObjectInfo(generation, info7);
+    index.putObjectList(generation, 0x10001, 0, 5, {6, 7});
+
+    index.objectChanged(7);
+
+    MtpObjectInfo out(6);
+    MtpObjectHandleList handles;
+    EXPECT_TRUE(index.getObjectInfo(6, out));
+    EXPECT_FALSE(index.getObjectInfo(7, out));
+    EXPECT_FALSE(index.getObjectList(0x10001, 0, 5, handles));
+
+    index.clear();
+    EXPECT_FALSE(index.getObjectInfo(6, out));
+}
+
+TEST(MtpObjectIndexTest, testStaleResultIsNotStored) {
+    MtpObjectIndex index;
+    // a change is reported while the database is being queried
+    uint32_t generation = index.getGeneration();
+    index.objectChanged(7);
+
+    MtpObjectInfo info(7);
+    fillInfo(info, 5, "a.jpg");
+    index.putObjectInfo(generation, info);
+    index.putObjectList(generation, 0x10001, 0, 5, {7});
+
+    MtpObjectInfo out(7);
+    MtpObjectHandleList handles;
+    EXPECT_FALSE(index.getObjectInfo(7, out));
+    EXPECT_FALSE(index.getObjectList(0x10001, 0, 5, handles));
+}
+
+} // namespace android
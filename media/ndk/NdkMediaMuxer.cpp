@@ -97,6 +97,19 @@ media_status_t AMediaMuxer_writeSampleData(AMediaMuxer *muxer,
             muxer->mImpl->writeSampleData(buf, trackIdx, info->presentationTimeUs, info->flags));
 }
 
+EXPORT
+media_status_t AMediaMuxer_writeSampleDataNoCopy(AMediaMuxer *muxer,
+        size_t trackIdx, const uint8_t *data, const AMediaCodecBufferInfo *info,
+        AMediaMuxer_SampleReleasedCallback onReleased, void *userdata) {
+    if (onReleased == nullptr) {
+        return AMEDIA_ERROR_INVALID_PARAMETER;
+    }
+    sp<ABuffer> buf = new ABuffer((void*)(data + info->offset), info->size);
+    return translate_error(muxer->mImpl->writeSampleDataNoCopy(
+            buf, trackIdx, info->presentationTimeUs, info->flags,
+            [onReleased, userdata, data]() { onReleased(userdata, data); }));
+}
+
 EXPORT
 AMediaMuxer* AMediaMuxer_append(int fd, AppendMode mode) {
     ALOGV("append");
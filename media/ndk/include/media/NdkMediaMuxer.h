@@ -161,6 +161,30 @@ media_status_t AMediaMuxer_writeSampleData(AMediaMuxer *muxer,
         size_t trackIdx, const uint8_t *data,
         const AMediaCodecBufferInfo *info) __INTRODUCED_IN(21);
 
+/**
+ * Called when the muxer no longer references a sample passed to
+ * {@link AMediaMuxer_writeSampleDataNoCopy}. The data may be reused or
+ * released from this point on, e.g. by releasing the codec output buffer
+ * it came from. This is called from an internal thread and must not block.
+ */
+typedef void (*AMediaMuxer_SampleReleasedCallback)(void *userdata, const uint8_t *data);
+
+/**
+ * Writes an encoded sample into the muxer without copying it.
+ * Same as {@link AMediaMuxer_writeSampleData}, except that the muxer keeps
+ * referencing data until the sample has been written to the file, and then
+ * calls onReleased. This saves a copy of every sample for high bitrate
+ * streams, at the cost of holding the samples for up to the muxer's
+ * interleaving duration (about a second); make sure the encoder has enough
+ * output buffers for that. onReleased is not called if an error is returned,
+ * in which case data can be reused immediately.
+ *
+ * Available since API level 35.
+ */
+media_status_t AMediaMuxer_writeSampleDataNoCopy(AMediaMuxer *muxer,
+        size_t trackIdx, const uint8_t *data, const AMediaCodecBufferInfo *info,
+        AMediaMuxer_SampleReleasedCallback onReleased, void *userdata) __INTRODUCED_IN(35);
+
 /**
  * Creates a new media muxer for appending data to an existing MPEG4 file.
  * This is a synchronous API call and could take a while to return if the existing file is large.
@@ -0,0 +1,129 @@
+#!/usr/bin/python3
+"""
+ * Copyright (C) 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+"""
+
+'''
+Report the per buffer latency between the stages of the media pipeline from a
+capture of the MediaTrace points, see
+media/module/foundation/include/media/stagefright/foundation/MediaTrace.h.
+
+The capture is a systrace text file, for example from
+    perfetto -o /data/misc/perfetto-traces/trace -t 10s video
+    traceconv systrace trace trace.txt
+
+Buffers are followed through the stages by their presentation time. When audio
+and video play together, their timestamps can collide; use --exclude to drop
+the other track, e.g. --exclude c2.android.aac.decoder --exclude audio.
+'''
+
+import argparse
+import re
+import sys
+
+# Stages in the usual pipeline order, used to sort the report. Latencies are
+# taken between the stages in the order they were seen for each buffer. A buffer
+# usually skips some of them, e.g. only one of the renderer stages applies.
+# MediaCodec marks its input once the codec has accepted the buffer.
+STAGES = [
+    'CCodecBufferChannel::queue',
+    'Codec2Client::queue',
+    'MediaCodec::queueInput',
+    'SimpleC2Component::process',
+    'SimpleC2Component::processed',
+    'CCodecBufferChannel::workDone',
+    'MediaCodec::outputAvailable',
+    'NuPlayerRenderer::writeAudio',
+    'NuPlayerRenderer::drainVideo',
+    'MediaCodec::renderOutput',
+]
+
+MARKER = re.compile(r'\s(\d+\.\d+): tracing_mark_write: B\|\d+\|'
+                    r'MediaTrace:(\S+) (\S+) ts=(-?\d+) idx=(-?\d+)')
+
+
+def parseCapture(lines, exclude):
+    '''Returns {timeUs: {stage: first time in seconds}}.'''
+    buffers = {}
+    for line in lines:
+        match = MARKER.search(line)
+        if match is None:
+            continue
+        seconds, stage, name, timeUs, _ = match.groups()
+        # CCodecBufferChannel appends #<instance> to the component name.
+        if stage in exclude or name.split('#')[0] in exclude:
+            continue
+        stages = buffers.setdefault(int(timeUs), {})
+        # A timestamp is reused after a seek or flush; keep its first pass.
+        stages.setdefault(stage, float(seconds))
+    return buffers
+
+
+def percentile(sortedValues, fraction):
+    index = min(len(sortedValues) - 1, int(fraction * len(sortedValues)))
+    return sortedValues[index]
+
+
+def collectLatencies(buffers):
+    '''Returns {(from, to): [latency in ms]} between consecutive stages seen
+    for each buffer, and from the first to the last stage.'''
+    latencies = {}
+    for stages in buffers.values():
+        seen = sorted((seconds, stage) for stage, seconds in stages.items())
+        if len(seen) < 2:
+            continue
+        for (_, a), (_, b) in zip(seen, seen[1:]):
+            latencies.setdefault((a, b), []).append((stages[b] - stages[a]) * 1000)
+        first, last = seen[0][1], seen[-1][1]
+        if len(seen) > 2:
+            latencies.setdefault((first, last), []).append(
+                    (stages[last] - stages[first]) * 1000)
+    return latencies
+
+
+def printReport(latencies, out):
+    order = {stage: i for i, stage in enumerate(STAGES)}
+    def key(pair):
+        return (order.get(pair[0], len(STAGES)), order.get(pair[1], len(STAGES)))
+    out.write('%-32s %-32s %7s %9s %9s %9s %9s\n' %
+              ('from', 'to', 'count', 'p50 ms', 'p90 ms', 'p99 ms', 'max ms'))
+    for pair in sorted(latencies, key=key):
+        values = sorted(latencies[pair])
+        out.write('%-32s %-32s %7d %9.3f %9.3f %9.3f %9.3f\n' %
+                  (pair[0], pair[1], len(values), percentile(values, 0.5),
+                   percentile(values, 0.9), percentile(values, 0.99), values[-1]))
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Per stage latency of MediaTrace points')
+    parser.add_argument('capture', help='systrace text file, or - for stdin')
+    parser.add_argument('--exclude', action='append', default=[],
+                        help='stage or component name to ignore, e.g. audio for the '
+                             'renderer; can be repeated')
+    args = parser.parse_args()
+
+    if args.capture == '-':
+        buffers = parseCapture(sys.stdin, set(args.exclude))
+    else:
+        with open(args.capture, errors='replace') as capture:
+            buffers = parseCapture(capture, set(args.exclude))
+    if not buffers:
+        sys.exit('no MediaTrace points found; was the module built with '
+                 'MEDIA_TRACE_ENABLE_CODEC or MEDIA_TRACE_ENABLE_RENDER?')
+    printReport(collectLatencies(buffers), sys.stdout)
+
+
+if __name__ == '__main__':
+    main()
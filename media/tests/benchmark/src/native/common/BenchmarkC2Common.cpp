@@ -96,6 +96,7 @@ void BenchmarkC2Common::handleWorkDone(std::list<std::unique_ptr<C2Work>> &workI
             if (work->worklets.front()->output.flags != C2FrameData::FLAG_INCOMPLETE) {
                 mEos = (work->worklets.front()->output.flags & C2FrameData::FLAG_END_OF_STREAM) !=
                        0;
+                mStats->setFrameDoneTime(work->input.ordinal.frameIndex.peeku());
                 ALOGV("WorkDone: frameID received %d , mEos : %d",
                       (int)work->worklets.front()->output.ordinal.frameIndex.peeku(), mEos);
                 work->input.buffers.clear();
@@ -121,6 +121,8 @@ class BenchmarkC2Common {
     // callback function to process onWorkDone received by Listener
     void handleWorkDone(std::list<std::unique_ptr<C2Work>> &workItems);
 
+    Stats *getStats() { return mStats; }
+
     bool mEos;
   protected:
     Stats *mStats;
@@ -19,6 +19,8 @@
 
 #include "BenchmarkCommon.h"
 #include <iostream>
+#include <sched.h>
+#include <sys/resource.h>
 
 void CallBackHandle::ioThread() {
     ALOGV("In %s mIsDone : %d, mSawError : %d ", __func__, mIsDone, mSawError);
@@ -101,3 +103,36 @@ AMediaCodec *createMediaCodec(AMediaFormat *format, const char *mime, string cod
     }
     return codec;
 }
+
+int32_t runConcurrentInstances(int32_t numInstances, const vector<int32_t> &cpus,
+                               const function<int32_t(int32_t)> &fn) {
+    vector<int32_t> results(numInstances, 0);
+    vector<thread> threads;
+    for (int32_t instance = 0; instance < numInstances; instance++) {
+        threads.emplace_back([instance, &cpus, &fn, &results]() {
+            if (!cpus.empty()) {
+                cpu_set_t cpuSet;
+                CPU_ZERO(&cpuSet);
+                CPU_SET(cpus[instance % cpus.size()], &cpuSet);
+                if (sched_setaffinity(0, sizeof(cpuSet), &cpuSet) != 0) {
+                    ALOGW("Unable to pin instance %d to cpu %d", instance,
+                          cpus[instance % cpus.size()]);
+                }
+            }
+            results[instance] = fn(instance);
+        });
+    }
+    for (thread &instanceThread : threads) {
+        instanceThread.join();
+    }
+    for (int32_t result : results) {
+        if (result != 0) return result;
+    }
+    return 0;
+}
+
+int64_t getMaxRssKb() {
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return -1;
+    return usage.ru_maxrss;
+}
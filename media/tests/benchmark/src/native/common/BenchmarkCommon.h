@@ -19,6 +19,7 @@
 
 #include <sys/stat.h>
 #include <inttypes.h>
+#include <functional>
 #include <mutex>
 #include <queue>
 #include <thread>
@@ -132,4 +133,13 @@ void OnErrorCB(AMediaCodec *codec, void * /* userdata */, media_status_t err, in
 AMediaCodec *createMediaCodec(AMediaFormat *format, const char *mime, string codecName,
                               bool isEncoder);
 
+// Utility to run fn(instance) for numInstances instances, each on its own thread.
+// Instance i is pinned to cpus[i % cpus.size()] unless cpus is empty.
+// Returns the first non-zero status returned by an instance, 0 otherwise.
+int32_t runConcurrentInstances(int32_t numInstances, const vector<int32_t> &cpus,
+                               const function<int32_t(int32_t)> &fn);
+
+// Returns the memory high-water mark of the process in kilobytes.
+int64_t getMaxRssKb();
+
 #endif  // __BENCHMARK_COMMON_H__
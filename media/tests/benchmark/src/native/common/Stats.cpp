@@ -156,3 +156,78 @@ void Stats::uploadMetrics(const string& operation, const string& inputReference,
     LOG_METRIC("%s_TimeforFirstFrame:%lld", prefix.c_str(), (long long)timeToFirstFrameNs);
 
 }
+
+/**
+ * Dumps the aggregate stats of instances which ran the same operation concurrently.
+ *
+ * \param stats          stats of each instance
+ * \param operation      describes the operation performed on the input media
+ *                       (i.e. decode/encode)
+ * \param inputReference input media
+ * \param componentName  describes the codecName.
+ * \param cpuTimeNs      CPU time used by the benchmark process during the run.
+ * \param maxRssKb       memory high-water mark of the benchmark process.
+ * \param statsFile      the file where the stats data is to be written.
+ */
+void Stats::dumpAggregateStatistics(const vector<Stats*>& stats, const string& operation,
+                                    const string& inputReference, const string& componentName,
+                                    nsecs_t cpuTimeNs, int64_t maxRssKb,
+                                    const string& statsFile) {
+    ALOGV("In %s", __func__);
+    nsecs_t startTimeNs = INT64_MAX;
+    nsecs_t endTimeNs = 0;
+    vector<nsecs_t> latencies;
+    for (Stats* instanceStats : stats) {
+        if (instanceStats->mOutputTimer.empty()) continue;
+        startTimeNs = std::min(startTimeNs, instanceStats->mStartTimeNs);
+        endTimeNs = std::max(endTimeNs, *(instanceStats->mOutputTimer.end() - 1));
+        vector<nsecs_t> instanceLatencies = instanceStats->getFrameLatencies();
+        latencies.insert(latencies.end(), instanceLatencies.begin(), instanceLatencies.end());
+    }
+    if (latencies.empty() || endTimeNs <= startTimeNs) {
+        ALOGE("No output produced");
+        return;
+    }
+    std::sort(latencies.begin(), latencies.end());
+    int64_t numFrames = latencies.size();
+    nsecs_t totalTimeTakenNs = endTimeNs - startTimeNs;
+    int64_t framesPerSec = (numFrames * 1000000000) / totalTimeTakenNs;
+    nsecs_t latencyP50Ns = latencies[(numFrames - 1) * 50 / 100];
+    nsecs_t latencyP99Ns = latencies[(numFrames - 1) * 99 / 100];
+    nsecs_t cpuTimePerFrameNs = cpuTimeNs / numFrames;
+
+    if (statsFile.empty()) {
+        string prefix = "CodecStats_NativeMulti";
+        prefix.append("_").append(componentName);
+        LOG_METRIC("%s_Instances:%zu", prefix.c_str(), stats.size());
+        LOG_METRIC("%s_FramesPerSec:%lld", prefix.c_str(), (long long)framesPerSec);
+        LOG_METRIC("%s_LatencyP50Ns:%lld", prefix.c_str(), (long long)latencyP50Ns);
+        LOG_METRIC("%s_LatencyP99Ns:%lld", prefix.c_str(), (long long)latencyP99Ns);
+        LOG_METRIC("%s_CpuTimePerFrameNs:%lld", prefix.c_str(), (long long)cpuTimePerFrameNs);
+        LOG_METRIC("%s_MaxRssKb:%lld", prefix.c_str(), (long long)maxRssKb);
+        return;
+    }
+
+    // Write the stats data to file.
+    string rowData = "";
+    rowData.append(to_string(systemTime(CLOCK_MONOTONIC)) + ", ");
+    rowData.append(inputReference + ", ");
+    rowData.append(operation + ", ");
+    rowData.append(componentName + ", ");
+    rowData.append(to_string(stats.size()) + ", ");
+    rowData.append(to_string(numFrames) + ", ");
+    rowData.append(to_string(totalTimeTakenNs) + ", ");
+    rowData.append(to_string(framesPerSec) + ", ");
+    rowData.append(to_string(latencyP50Ns) + ", ");
+    rowData.append(to_string(latencyP99Ns) + ", ");
+    rowData.append(to_string(cpuTimePerFrameNs) + ", ");
+    rowData.append(to_string(maxRssKb) + ",\n");
+
+    ofstream out(statsFile, ios::out | ios::app);
+    if(out.bad()) {
+        ALOGE("Failed to open stats file for writing!");
+        return;
+    }
+    out << rowData;
+    out.close();
+}
@@ -41,6 +41,8 @@
 
 #include <sys/time.h>
 #include <algorithm>
+#include <map>
+#include <mutex>
 #include <numeric>
 #include <vector>
 
@@ -68,6 +70,11 @@ class Stats {
     std::vector<nsecs_t> mInputTimer;
     std::vector<nsecs_t> mOutputTimer;
 
+    // Frame latencies are updated from the codec callback thread.
+    std::mutex mFrameLock;
+    std::map<uint64_t, nsecs_t> mFrameQueuedTimeNs;
+    std::vector<nsecs_t> mFrameLatencies;
+
   public:
     nsecs_t getCurTime() { return systemTime(CLOCK_MONOTONIC); }
 
@@ -83,10 +90,34 @@ class Stats {
 
     void addOutputTime() { mOutputTimer.push_back(systemTime(CLOCK_MONOTONIC)); }
 
+    // Records the time at which the given frame is queued to the codec.
+    void setFrameQueuedTime(uint64_t frameIndex) {
+        std::lock_guard<std::mutex> lock(mFrameLock);
+        mFrameQueuedTimeNs[frameIndex] = systemTime(CLOCK_MONOTONIC);
+    }
+
+    // Records the latency of the given frame, from the time it was queued until now.
+    void setFrameDoneTime(uint64_t frameIndex) {
+        nsecs_t now = systemTime(CLOCK_MONOTONIC);
+        std::lock_guard<std::mutex> lock(mFrameLock);
+        auto it = mFrameQueuedTimeNs.find(frameIndex);
+        if (it == mFrameQueuedTimeNs.end()) return;
+        mFrameLatencies.push_back(now - it->second);
+        mFrameQueuedTimeNs.erase(it);
+    }
+
+    std::vector<nsecs_t> getFrameLatencies() {
+        std::lock_guard<std::mutex> lock(mFrameLock);
+        return mFrameLatencies;
+    }
+
     void reset() {
         if (!mFrameSizes.empty()) mFrameSizes.clear();
         if (!mInputTimer.empty()) mInputTimer.clear();
         if (!mOutputTimer.empty()) mOutputTimer.clear();
+        std::lock_guard<std::mutex> lock(mFrameLock);
+        mFrameQueuedTimeNs.clear();
+        mFrameLatencies.clear();
     }
 
     std::vector<nsecs_t> getOutputTimer() { return mOutputTimer; }
@@ -95,6 +126,8 @@ class Stats {
 
     nsecs_t getDeInitTime() { return mDeInitTimeNs; }
 
+    nsecs_t getStartTime() { return mStartTimeNs; }
+
     nsecs_t getTimeDiff(nsecs_t sTime, nsecs_t eTime) { return (eTime - sTime); }
 
     nsecs_t getTotalTime() {
@@ -109,5 +142,10 @@ class Stats {
     void uploadMetrics(const string& operation, const string& inputReference,
                       const int64_t& durationUs, const string& componentName = "",
                       const string& mode = "");
+
+    static void dumpAggregateStatistics(const vector<Stats*>& stats, const string& operation,
+                                        const string& inputReference,
+                                        const string& componentName, nsecs_t cpuTimeNs,
+                                        int64_t maxRssKb, const string& statsFile = "");
 };
 #endif  // __STATS_H__
@@ -130,6 +130,7 @@ int32_t C2Decoder::decodeFrames(uint8_t *inputBuffer, vector<AMediaCodecBufferIn
 
         std::list<std::unique_ptr<C2Work>> items;
         items.push_back(std::move(work));
+        mStats->setFrameQueuedTime(mNumInputFrame);
         // queue() invokes process() function of C2 Plugin.
         status = mComponent->queue(&items);
         if (status != C2_OK) {
@@ -226,6 +226,7 @@ int32_t C2Encoder::encodeFrames(ifstream &eleStream, size_t inputBufferSize) {
 
         std::list<std::unique_ptr<C2Work>> items;
         items.push_back(std::move(work));
+        mStats->setFrameQueuedTime(mNumInputFrame);
         // queue() invokes process() function of C2 Plugin.
         status = mComponent->queue(&items);
         if (status != C2_OK) {
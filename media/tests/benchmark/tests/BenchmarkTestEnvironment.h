@@ -20,6 +20,10 @@
 #include <gtest/gtest.h>
 
 #include <getopt.h>
+#include <stdlib.h>
+
+#include <sstream>
+#include <vector>
 
 using namespace std;
 
@@ -27,7 +31,9 @@ class BenchmarkTestEnvironment : public ::testing::Environment {
   public:
     BenchmarkTestEnvironment()
         : res("/data/local/tmp/MediaBenchmark/res/"),
-          statsFile("/data/local/tmp/MediaBenchmark/res/stats.csv") {}
+          statsFile("/data/local/tmp/MediaBenchmark/res/stats.csv"),
+          multiInstanceStatsFile("/data/local/tmp/MediaBenchmark/res/multi_stats.csv"),
+          instances(1) {}
 
     // Parses the command line argument
     int initFromOptions(int argc, char **argv);
@@ -42,17 +48,50 @@ class BenchmarkTestEnvironment : public ::testing::Environment {
 
     bool writeStatsHeader();
 
+    void setMultiInstanceStatsFile(const string module) {
+        multiInstanceStatsFile = getRes() + module;
+    }
+
+    const string getMultiInstanceStatsFile() const { return multiInstanceStatsFile; }
+
+    bool writeMultiInstanceStatsHeader();
+
+    void setInstances(int32_t _instances) { instances = _instances; }
+
+    // Number of codec instances to run concurrently in the multi-instance tests.
+    int32_t getInstances() const { return instances; }
+
+    void setCpus(const char *_cpus);
+
+    // CPUs to pin the instances to, empty if they are not pinned.
+    const vector<int32_t> &getCpus() const { return cpus; }
+
   private:
     string res;
     string statsFile;
+    string multiInstanceStatsFile;
+    int32_t instances;
+    vector<int32_t> cpus;
 };
 
+void BenchmarkTestEnvironment::setCpus(const char *_cpus) {
+    cpus.clear();
+    stringstream cpuList(_cpus);
+    string cpu;
+    while (getline(cpuList, cpu, ',')) {
+        if (!cpu.empty()) cpus.push_back(atoi(cpu.c_str()));
+    }
+}
+
 int BenchmarkTestEnvironment::initFromOptions(int argc, char **argv) {
-    static struct option options[] = {{"path", required_argument, 0, 'P'}, {0, 0, 0, 0}};
+    static struct option options[] = {{"path", required_argument, 0, 'P'},
+                                      {"instances", required_argument, 0, 'N'},
+                                      {"cpus", required_argument, 0, 'C'},
+                                      {0, 0, 0, 0}};
 
     while (true) {
         int index = 0;
-        int c = getopt_long(argc, argv, "P:", options, &index);
+        int c = getopt_long(argc, argv, "P:N:C:", options, &index);
         if (c == -1) {
             break;
         }
@@ -62,6 +101,14 @@ int BenchmarkTestEnvironment::initFromOptions(int argc, char **argv) {
                 setRes(optarg);
                 break;
             }
+            case 'N': {
+                setInstances(atoi(optarg));
+                break;
+            }
+            case 'C': {
+                setCpus(optarg);
+                break;
+            }
             default:
                 break;
         }
@@ -72,7 +119,9 @@ int BenchmarkTestEnvironment::initFromOptions(int argc, char **argv) {
                 "unrecognized option: %s\n\n"
                 "usage: %s <gtest options> <test options>\n\n"
                 "test options are:\n\n"
-                "-P, --path: Resource files directory location\n",
+                "-P, --path: Resource files directory location\n"
+                "-N, --instances: Number of concurrent instances for multi-instance tests\n"
+                "-C, --cpus: Comma separated list of CPUs to pin the instances to\n",
                 argv[optind ?: 1], argv[0]);
         return 2;
     }
@@ -101,4 +150,23 @@ bool BenchmarkTestEnvironment::writeStatsHeader() {
     return true;
 }
 
+/**
+ * Writes the multi-instance stats header to a file
+ **/
+bool BenchmarkTestEnvironment::writeMultiInstanceStatsHeader() {
+    char statsHeader[] =
+        "currentTime, fileName, operation, componentName, instances, totalFrames, totalTime, "
+        "framesPerSec, latencyP50, latencyP99, cpuTimePerFrame, maxRssKb\n";
+    FILE *fpStats = fopen(multiInstanceStatsFile.c_str(), "w");
+    if(!fpStats) {
+        return false;
+    }
+    int32_t numBytes = fwrite(statsHeader, sizeof(char), sizeof(statsHeader), fpStats);
+    fclose(fpStats);
+    if(numBytes != sizeof(statsHeader)) {
+        return false;
+    }
+    return true;
+}
+
 #endif  // __BENCHMARK_TEST_ENVIRONMENT_H__
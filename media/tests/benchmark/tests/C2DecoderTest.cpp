@@ -61,6 +61,39 @@ void C2DecoderTest::setupC2DecoderTest() {
     ASSERT_GT(mCodecList.size(), 0) << "Codec2 client didn't recognise any component";
 }
 
+// Reads the CSD and the frames of the current track of the extractor into inputBuffer.
+static void readInput(Extractor *extractor, size_t fileSize, uint8_t *inputBuffer,
+                      vector<AMediaCodecBufferInfo> &frameInfo) {
+    AMediaCodecBufferInfo info;
+    uint32_t inputBufferOffset = 0;
+    int32_t idx = 0;
+
+    // Get CSD data
+    while (1) {
+        void *csdBuffer = extractor->getCSDSample(info, idx);
+        if (!csdBuffer || !info.size) break;
+        // copy the meta data and buffer to be passed to decoder
+        ASSERT_LE(inputBufferOffset + info.size, fileSize) << "Memory allocated not sufficient";
+
+        memcpy(inputBuffer + inputBufferOffset, csdBuffer, info.size);
+        frameInfo.push_back(info);
+        inputBufferOffset += info.size;
+        idx++;
+    }
+
+    // Get frame data
+    while (1) {
+        int32_t status = extractor->getFrameSample(info);
+        if (status || !info.size) break;
+        // copy the meta data and buffer to be passed to decoder
+        ASSERT_LE(inputBufferOffset + info.size, fileSize) << "Memory allocated not sufficient";
+
+        memcpy(inputBuffer + inputBufferOffset, extractor->getFrameBuf(), info.size);
+        frameInfo.push_back(info);
+        inputBufferOffset += info.size;
+    }
+}
+
 TEST_P(C2DecoderTest, Codec2Decode) {
     ALOGV("Decode the samples given by extractor using codec2");
     string inputFile = gEnv->getRes() + GetParam().first;
@@ -90,34 +123,7 @@ TEST_P(C2DecoderTest, Codec2Decode) {
         ASSERT_NE(inputBuffer, nullptr) << "Insufficient memory";
 
         vector<AMediaCodecBufferInfo> frameInfo;
-        AMediaCodecBufferInfo info;
-        uint32_t inputBufferOffset = 0;
-        int32_t idx = 0;
-
-        // Get CSD data
-        while (1) {
-            void *csdBuffer = extractor->getCSDSample(info, idx);
-            if (!csdBuffer || !info.size) break;
-            // copy the meta data and buffer to be passed to decoder
-            ASSERT_LE(inputBufferOffset + info.size, fileSize) << "Memory allocated not sufficient";
-
-            memcpy(inputBuffer.get() + inputBufferOffset, csdBuffer, info.size);
-            frameInfo.push_back(info);
-            inputBufferOffset += info.size;
-            idx++;
-        }
-
-        // Get frame data
-        while (1) {
-            status = extractor->getFrameSample(info);
-            if (status || !info.size) break;
-            // copy the meta data and buffer to be passed to decoder
-            ASSERT_LE(inputBufferOffset + info.size, fileSize) << "Memory allocated not sufficient";
-
-            memcpy(inputBuffer.get() + inputBufferOffset, extractor->getFrameBuf(), info.size);
-            frameInfo.push_back(info);
-            inputBufferOffset += info.size;
-        }
+        ASSERT_NO_FATAL_FAILURE(readInput(extractor.get(), fileSize, inputBuffer.get(), frameInfo));
 
         AMediaFormat *format = extractor->getFormat();
         // Decode the given input stream for all C2 codecs supported by device
@@ -149,6 +155,86 @@ TEST_P(C2DecoderTest, Codec2Decode) {
     }
 }
 
+TEST_P(C2DecoderTest, Codec2DecodeMultiInstance) {
+    ALOGV("Decode the samples given by extractor with concurrent codec2 instances");
+    int32_t numInstances = gEnv->getInstances();
+    if (numInstances < 2) {
+        GTEST_SKIP() << "Multi-instance test runs with -N set to 2 or more instances";
+    }
+    string inputFile = gEnv->getRes() + GetParam().first;
+    FILE *inputFp = fopen(inputFile.c_str(), "rb");
+    ASSERT_NE(inputFp, nullptr) << "Unable to open " << inputFile << " file for reading";
+
+    std::unique_ptr<Extractor> extractor(new (std::nothrow) Extractor());
+    ASSERT_NE(extractor, nullptr) << "Extractor creation failed";
+
+    // Read file properties
+    struct stat buf;
+    stat(inputFile.c_str(), &buf);
+    size_t fileSize = buf.st_size;
+    int32_t fd = fileno(inputFp);
+
+    ASSERT_LE(fileSize, kMaxBufferSize)
+            << "Input file size is greater than the threshold memory dedicated to the test";
+
+    int32_t trackCount = extractor->initExtractor(fd, fileSize);
+    ASSERT_GT(trackCount, 0) << "initExtractor failed";
+
+    for (int32_t curTrack = 0; curTrack < trackCount; curTrack++) {
+        int32_t status = extractor->setupTrackFormat(curTrack);
+        ASSERT_EQ(status, 0) << "Track Format invalid";
+
+        std::unique_ptr<uint8_t[]> inputBuffer(new (std::nothrow) uint8_t[fileSize]);
+        ASSERT_NE(inputBuffer, nullptr) << "Insufficient memory";
+
+        vector<AMediaCodecBufferInfo> frameInfo;
+        ASSERT_NO_FATAL_FAILURE(readInput(extractor.get(), fileSize, inputBuffer.get(), frameInfo));
+
+        AMediaFormat *format = extractor->getFormat();
+        // Decode the given input stream with all instances of each C2 codec supported by device
+        for (string codecName : mCodecList) {
+            if (codecName.find(GetParam().second) == string::npos ||
+                codecName.find("secure") != string::npos) {
+                continue;
+            }
+            vector<std::unique_ptr<C2Decoder>> decoders;
+            for (int32_t instance = 0; instance < numInstances; instance++) {
+                decoders.emplace_back(new (std::nothrow) C2Decoder());
+                ASSERT_NE(decoders.back(), nullptr) << "C2Decoder creation failed";
+                ASSERT_EQ(decoders.back()->setupCodec2(), 0) << "Codec2 setup failed";
+                status = decoders.back()->createCodec2Component(codecName, format);
+                ASSERT_EQ(status, 0) << "Create component failed for " << codecName;
+            }
+
+            // Send the inputs to every instance and wait till all buffers are returned.
+            nsecs_t cpuStartTimeNs = systemTime(SYSTEM_TIME_PROCESS);
+            status = runConcurrentInstances(
+                    numInstances, gEnv->getCpus(),
+                    [&decoders, &inputBuffer, &frameInfo](int32_t instance) {
+                        C2Decoder *decoder = decoders[instance].get();
+                        int32_t status = decoder->decodeFrames(inputBuffer.get(), frameInfo);
+                        if (status != 0) return status;
+                        decoder->waitOnInputConsumption();
+                        return decoder->mEos ? 0 : -1;
+                    });
+            nsecs_t cpuTimeNs = systemTime(SYSTEM_TIME_PROCESS) - cpuStartTimeNs;
+            ASSERT_EQ(status, 0) << "Decoder failed or didn't receive EOS for " << codecName;
+
+            vector<Stats *> stats;
+            for (std::unique_ptr<C2Decoder> &decoder : decoders) {
+                decoder->deInitCodec();
+                stats.push_back(decoder->getStats());
+            }
+            ALOGV("codec : %s", codecName.c_str());
+            Stats::dumpAggregateStatistics(stats, "c2decode", GetParam().first, codecName,
+                                           cpuTimeNs, getMaxRssKb(),
+                                           gEnv->getMultiInstanceStatsFile());
+        }
+    }
+    fclose(inputFp);
+    extractor->deInitExtractor();
+}
+
 // TODO: (b/140549596)
 // Add wav files
 INSTANTIATE_TEST_SUITE_P(
@@ -180,6 +266,8 @@ int main(int argc, char **argv) {
     if (status == 0) {
         gEnv->setStatsFile("C2Decoder.csv");
         status = gEnv->writeStatsHeader();
+        gEnv->setMultiInstanceStatsFile("C2DecoderMultiInstance.csv");
+        gEnv->writeMultiInstanceStatsHeader();
         ALOGV("Stats file = %d\n", status);
         status = RUN_ALL_TESTS();
         ALOGV("C2 Decoder Test result = %d\n", status);
@@ -61,6 +61,40 @@ void C2EncoderTest::setupC2EncoderTest() {
     ASSERT_GT(mCodecList.size(), 0) << "Codec2 client didn't recognise any component";
 }
 
+// Decodes the current track of the extractor of the decoder into outputFileName, which is then
+// used as the raw input of the encoders.
+static void decodeToFile(Decoder *decoder, size_t fileSize, const string &outputFileName) {
+    Extractor *extractor = decoder->getExtractor();
+    std::unique_ptr<uint8_t[]> inputBuffer(new (std::nothrow) uint8_t[fileSize]);
+    ASSERT_NE(inputBuffer, nullptr) << "Insufficient memory";
+
+    vector<AMediaCodecBufferInfo> frameInfo;
+    AMediaCodecBufferInfo info;
+    uint32_t inputBufferOffset = 0;
+
+    // Get frame data
+    while (1) {
+        int32_t status = extractor->getFrameSample(info);
+        if (status || !info.size) break;
+        // copy the meta data and buffer to be passed to decoder
+        ASSERT_LE(inputBufferOffset + info.size, fileSize) << "Memory allocated not sufficient";
+
+        memcpy(inputBuffer.get() + inputBufferOffset, extractor->getFrameBuf(), info.size);
+        frameInfo.push_back(info);
+        inputBufferOffset += info.size;
+    }
+
+    string decName = "";
+    FILE *outFp = fopen(outputFileName.c_str(), "wb");
+    ASSERT_NE(outFp, nullptr) << "Unable to open output file" << outputFileName
+                              << " for dumping decoder's output";
+
+    decoder->setupDecoder();
+    int32_t status = decoder->decode(inputBuffer.get(), frameInfo, decName,
+                                     false /*asyncMode */, outFp);
+    ASSERT_EQ(status, AMEDIA_OK) << "Decode returned error : " << status;
+}
+
 TEST_P(C2EncoderTest, Codec2Encode) {
     ALOGV("Encodes the input using codec2 framework");
     string inputFile = gEnv->getRes() + GetParam().first;
@@ -89,35 +123,8 @@ TEST_P(C2EncoderTest, Codec2Encode) {
         int32_t status = extractor->setupTrackFormat(curTrack);
         ASSERT_EQ(status, 0) << "Track Format invalid";
 
-        std::unique_ptr<uint8_t[]> inputBuffer(new (std::nothrow) uint8_t[fileSize]);
-        ASSERT_NE(inputBuffer, nullptr) << "Insufficient memory";
-
-        vector<AMediaCodecBufferInfo> frameInfo;
-        AMediaCodecBufferInfo info;
-        uint32_t inputBufferOffset = 0;
-
-        // Get frame data
-        while (1) {
-            status = extractor->getFrameSample(info);
-            if (status || !info.size) break;
-            // copy the meta data and buffer to be passed to decoder
-            ASSERT_LE(inputBufferOffset + info.size, fileSize) << "Memory allocated not sufficient";
-
-            memcpy(inputBuffer.get() + inputBufferOffset, extractor->getFrameBuf(), info.size);
-            frameInfo.push_back(info);
-            inputBufferOffset += info.size;
-        }
-
-        string decName = "";
         string outputFileName = "/data/local/tmp/decode.out";
-        FILE *outFp = fopen(outputFileName.c_str(), "wb");
-        ASSERT_NE(outFp, nullptr) << "Unable to open output file" << outputFileName
-                                  << " for dumping decoder's output";
-
-        decoder->setupDecoder();
-        status = decoder->decode(inputBuffer.get(), frameInfo, decName,
-                                 false /*asyncMode */, outFp);
-        ASSERT_EQ(status, AMEDIA_OK) << "Decode returned error : " << status;
+        ASSERT_NO_FATAL_FAILURE(decodeToFile(decoder.get(), fileSize, outputFileName));
 
         // Encode the given input stream for all C2 codecs supported by device
         AMediaFormat *format = extractor->getFormat();
@@ -158,6 +165,95 @@ TEST_P(C2EncoderTest, Codec2Encode) {
     mEncoder = nullptr;
 }
 
+TEST_P(C2EncoderTest, Codec2EncodeMultiInstance) {
+    ALOGV("Encodes the input with concurrent codec2 instances");
+    int32_t numInstances = gEnv->getInstances();
+    if (numInstances < 2) {
+        GTEST_SKIP() << "Multi-instance test runs with -N set to 2 or more instances";
+    }
+    string inputFile = gEnv->getRes() + GetParam().first;
+    FILE *inputFp = fopen(inputFile.c_str(), "rb");
+    ASSERT_NE(inputFp, nullptr) << "Unable to open input file for reading";
+
+    std::unique_ptr<Decoder> decoder(new (std::nothrow) Decoder());
+    ASSERT_NE(decoder, nullptr) << "Decoder creation failed";
+
+    Extractor *extractor = decoder->getExtractor();
+    ASSERT_NE(extractor, nullptr) << "Extractor creation failed";
+
+    // Read file properties
+    struct stat buf;
+    stat(inputFile.c_str(), &buf);
+    size_t fileSize = buf.st_size;
+    int32_t fd = fileno(inputFp);
+
+    ASSERT_LE(fileSize, kMaxBufferSize)
+            << "Input file size is greater than the threshold memory dedicated to the test";
+
+    int32_t trackCount = extractor->initExtractor(fd, fileSize);
+    ASSERT_GT(trackCount, 0) << "initExtractor failed";
+
+    for (int curTrack = 0; curTrack < trackCount; curTrack++) {
+        int32_t status = extractor->setupTrackFormat(curTrack);
+        ASSERT_EQ(status, 0) << "Track Format invalid";
+
+        string outputFileName = "/data/local/tmp/decode.out";
+        ASSERT_NO_FATAL_FAILURE(decodeToFile(decoder.get(), fileSize, outputFileName));
+
+        // Encode the given input stream with all instances of each C2 codec supported by device
+        AMediaFormat *format = extractor->getFormat();
+        for (string codecName : mCodecList) {
+            if (codecName.find(GetParam().second) == string::npos) continue;
+
+            vector<std::unique_ptr<C2Encoder>> encoders;
+            vector<ifstream> eleStreams(numInstances);
+            for (int32_t instance = 0; instance < numInstances; instance++) {
+                encoders.emplace_back(new (std::nothrow) C2Encoder());
+                ASSERT_NE(encoders.back(), nullptr) << "C2Encoder creation failed";
+                ASSERT_EQ(encoders.back()->setupCodec2(), 0) << "Codec2 setup failed";
+                status = encoders.back()->createCodec2Component(codecName, format);
+                ASSERT_EQ(status, 0) << "Create component failed for " << codecName;
+                eleStreams[instance].open(outputFileName.c_str(), ifstream::binary);
+                ASSERT_EQ(eleStreams[instance].is_open(), true)
+                        << outputFileName.c_str() << " - file not found";
+            }
+            eleStreams[0].seekg(0, ifstream::end);
+            size_t eleSize = eleStreams[0].tellg();
+            eleStreams[0].seekg(0, ifstream::beg);
+
+            // Send the inputs to every instance and wait till all buffers are returned.
+            nsecs_t cpuStartTimeNs = systemTime(SYSTEM_TIME_PROCESS);
+            status = runConcurrentInstances(
+                    numInstances, gEnv->getCpus(),
+                    [&encoders, &eleStreams, eleSize](int32_t instance) {
+                        C2Encoder *encoder = encoders[instance].get();
+                        int32_t status = encoder->encodeFrames(eleStreams[instance], eleSize);
+                        if (status != 0) return status;
+                        encoder->waitOnInputConsumption();
+                        return encoder->mEos ? 0 : -1;
+                    });
+            nsecs_t cpuTimeNs = systemTime(SYSTEM_TIME_PROCESS) - cpuStartTimeNs;
+            ASSERT_EQ(status, 0) << "Encoder failed or didn't receive EOS for " << codecName;
+
+            vector<Stats *> stats;
+            for (std::unique_ptr<C2Encoder> &encoder : encoders) {
+                encoder->deInitCodec();
+                stats.push_back(encoder->getStats());
+            }
+            ALOGV("codec : %s", codecName.c_str());
+            Stats::dumpAggregateStatistics(stats, "c2encode", GetParam().first, codecName,
+                                           cpuTimeNs, getMaxRssKb(),
+                                           gEnv->getMultiInstanceStatsFile());
+        }
+
+        // Destroy the decoder for the given input
+        decoder->deInitCodec();
+        decoder->resetDecoder();
+    }
+    fclose(inputFp);
+    extractor->deInitExtractor();
+}
+
 INSTANTIATE_TEST_SUITE_P(
         AudioEncoderTest, C2EncoderTest,
         ::testing::Values(make_pair("bbb_44100hz_2ch_128kbps_aac_30sec.mp4", "aac"),
@@ -183,6 +279,8 @@ int main(int argc, char **argv) {
     if (status == 0) {
         gEnv->setStatsFile("C2Encoder.csv");
         status = gEnv->writeStatsHeader();
+        gEnv->setMultiInstanceStatsFile("C2EncoderMultiInstance.csv");
+        gEnv->writeMultiInstanceStatsHeader();
         ALOGV("Stats file = %d\n", status);
         status = RUN_ALL_TESTS();
         ALOGV("C2 Encoder Test result = %d\n", status);
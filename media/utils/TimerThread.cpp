@@ -16,7 +16,9 @@
 
 #define LOG_TAG "TimerThread"
 
+#include <algorithm>
 #include <optional>
+#include <sched.h>
 #include <sstream>
 #include <unistd.h>
 #include <vector>
@@ -82,6 +84,10 @@ std::string TimerThread::SnapshotAnalysis::toString() const {
             .append(formatTime(std::chrono::system_clock::now()))
             .append("\nsecondChanceCount ")
             .append(std::to_string(secondChanceCount))
+            .append("\nretiredCount ")
+            .append(std::to_string(retiredCount))
+            .append("\ntimeoutCount ")
+            .append(std::to_string(timeoutCount))
             .append(analysisSummary)
             .append("\ntimeout [ ")
             .append(requestsToString(timeoutRequests))
@@ -120,6 +126,8 @@ struct TimerThread::SnapshotAnalysis TimerThread::getSnapshotAnalysis(size_t ret
     mRetiredQueue.copyRequests(analysis.retiredRequests, retiredCount);
     analysis.pendingRequests = getPendingRequests();
     analysis.secondChanceCount = mMonitorThread.getSecondChanceCount();
+    analysis.retiredCount = getRetiredCount();
+    analysis.timeoutCount = getTimeoutCount();
     // No call has timed out, so there is no analysis to be done.
     if (analysis.timeoutRequests.empty())
         return analysis;
@@ -225,48 +233,210 @@ std::string TimerThread::Request::toString() const {
         .append(" tid ").append(std::to_string(tid));
 }
 
+/* static */
+size_t TimerThread::getCurrentShard() {
+    // Use the current cpu so that concurrent calls on different cpus
+    // use different shards, otherwise fall back to the thread id.
+#if defined(__linux__)
+    const int cpu = sched_getcpu();
+    if (cpu >= 0) return static_cast<size_t>(cpu) & (kShards - 1);
+#endif
+    return static_cast<size_t>(getThreadIdWrapper()) & (kShards - 1);
+}
+
 void TimerThread::RequestQueue::add(std::shared_ptr<const Request> request) {
-    std::lock_guard lg(mRQMutex);
-    mRequestQueue.emplace_back(std::chrono::system_clock::now(), std::move(request));
-    if (mRequestQueue.size() > mRequestQueueMax) {
-        mRequestQueue.pop_front();
+    const uint64_t sequence = mAddedCount.fetch_add(1) + 1;
+    Slot& slot = mSlots[(sequence - 1) % mRequestQueueMax];
+    {
+        std::lock_guard lg(slot.mSlotMutex);
+        // A later add() may have wrapped around and claimed this slot first.
+        if (slot.mSequence < sequence) {
+            slot.mSequence = sequence;
+            slot.mRequest.swap(request);
+        }
     }
+    // The displaced request is released here outside of the lock.
 }
 
 void TimerThread::RequestQueue::copyRequests(
         std::vector<std::shared_ptr<const Request>>& requests, size_t n) const {
-    std::lock_guard lg(mRQMutex);
-    const size_t size = mRequestQueue.size();
-    size_t i = n >=  size ? 0 : size - n;
-    for (; i < size; ++i) {
-        const auto &[time, request] = mRequestQueue[i];
-        requests.emplace_back(request);
+    const uint64_t end = mAddedCount.load();
+    const uint64_t count = std::min({static_cast<uint64_t>(n),
+            static_cast<uint64_t>(mRequestQueueMax), end});
+    for (uint64_t sequence = end - count + 1; sequence <= end; ++sequence) {
+        const Slot& slot = mSlots[(sequence - 1) % mRequestQueueMax];
+        std::lock_guard lg(slot.mSlotMutex);
+        // Skip slots still being written, or already overwritten by a later add().
+        if (slot.mSequence == sequence) {
+            requests.emplace_back(slot.mRequest);
+        }
     }
 }
 
 TimerThread::Handle TimerThread::NoTimeoutMap::add(std::shared_ptr<const Request> request) {
-    std::lock_guard lg(mNTMutex);
-    // A unique handle is obtained by mNoTimeoutRequests.fetch_add(1),
-    // This need not be under a lock, but we do so anyhow.
-    const Handle handle = getUniqueHandle_l();
-    mMap[handle] = request;
+    const size_t shardIndex = getCurrentShard();
+    Shard& shard = mShards[shardIndex];
+    std::lock_guard lg(shard.mNTMutex);
+    const Handle handle = getUniqueHandle_l(shard.mMap, Duration{} /* timeout */,
+            makeHandleLsbValue(HANDLE_TYPE::NO_TIMEOUT, shardIndex));
+    shard.mMap.emplace_hint(shard.mMap.end(), handle, std::move(request));
     return handle;
 }
 
 std::shared_ptr<const TimerThread::Request> TimerThread::NoTimeoutMap::remove(Handle handle) {
-    std::lock_guard lg(mNTMutex);
-    auto it = mMap.find(handle);
-    if (it == mMap.end()) return {};
-    auto request = it->second;
-    mMap.erase(it);
+    Shard& shard = mShards[getShardFromHandle(handle)];
+    std::lock_guard lg(shard.mNTMutex);
+    auto it = shard.mMap.find(handle);
+    if (it == shard.mMap.end()) return {};
+    auto request = std::move(it->second);
+    shard.mMap.erase(it);
     return request;
 }
 
 void TimerThread::NoTimeoutMap::copyRequests(
         std::vector<std::shared_ptr<const Request>>& requests) const {
-    std::lock_guard lg(mNTMutex);
-    for (const auto &[handle, request] : mMap) {
-        requests.emplace_back(request);
+    for (const auto& shard : mShards) {
+        std::lock_guard lg(shard.mNTMutex);
+        for (const auto &[handle, request] : shard.mMap) {
+            requests.emplace_back(request);
+        }
+    }
+}
+
+void TimerThread::TimingWheel::add(Handle handle, Entry&& entry) {
+    if (mEntries.empty()) {
+        // Nothing is pending, so the wheel may skip ahead to the present.
+        mCurrentTick = std::max(mCurrentTick, toTick(std::chrono::steady_clock::now()));
+    }
+    auto [it, inserted] = mEntries.try_emplace(handle, Node{std::move(entry)});
+    if (inserted) place(it->first, it->second);
+}
+
+bool TimerThread::TimingWheel::remove(Handle handle, Entry* entry) {
+    const auto it = mEntries.find(handle);
+    if (it == mEntries.end()) return false;
+    unplace(it->second);
+    *entry = std::move(it->second.entry);
+    mEntries.erase(it);
+    return true;
+}
+
+void TimerThread::TimingWheel::place(Handle handle, Node& node) {
+    // Deadlines already passed go into the current slot.
+    const int64_t tick = std::max(toTick(handle), mCurrentTick);
+    const int64_t delta = tick - mCurrentTick;
+    size_t level = 0;
+    while (level < kLevels - 1 && delta >= (int64_t{1} << (kSlotBits * (level + 1)))) {
+        ++level;
+    }
+    // Deadlines beyond the range of the wheel wait in the last level,
+    // and are placed again when their slot cascades.
+    const int64_t placedTick = std::min(tick,
+            mCurrentTick + (int64_t{1} << (kSlotBits * kLevels)) - 1);
+    node.level = level;
+    node.slot = (placedTick >> (kSlotBits * level)) & kSlotMask;
+    auto& slot = mSlots[level][node.slot];
+    node.index = slot.size();
+    slot.push_back(handle);
+    ++mLevelCounts[level];
+}
+
+void TimerThread::TimingWheel::unplace(const Node& node) {
+    auto& slot = mSlots[node.level][node.slot];
+    if (node.index != slot.size() - 1) {
+        const Handle moved = slot.back();
+        slot[node.index] = moved;
+        mEntries.find(moved)->second.index = node.index;
+    }
+    slot.pop_back();
+    --mLevelCounts[node.level];
+}
+
+void TimerThread::TimingWheel::cascade() {
+    // Called as mCurrentTick starts a new rotation of level 0.
+    // Each coarser level is cascaded when the level below it starts a new rotation.
+    for (size_t level = 1; level < kLevels; ++level) {
+        const size_t index = (mCurrentTick >> (kSlotBits * level)) & kSlotMask;
+        std::vector<Handle> handles;
+        handles.swap(mSlots[level][index]);
+        mLevelCounts[level] -= handles.size();
+        for (const Handle handle : handles) {
+            place(handle, mEntries.find(handle)->second);
+        }
+        if (index != 0) break;
+    }
+}
+
+void TimerThread::TimingWheel::advance(
+        Handle now, std::vector<std::pair<Handle, Entry>>& expired) {
+    const int64_t nowTick = toTick(now);
+    if (mEntries.empty()) {
+        mCurrentTick = std::max(mCurrentTick, nowTick);
+        return;
+    }
+    while (true) {
+        const size_t index = mCurrentTick & kSlotMask;
+        if (index == 0) cascade();
+
+        // Every deadline in a slot of a past tick has expired, but the slot
+        // of the current tick is only partially expired.
+        auto& slot = mSlots[0][index];
+        for (size_t i = 0; i < slot.size(); ) {
+            const Handle handle = slot[i];
+            if (handle < now) {
+                Entry entry;
+                remove(handle, &entry);  // moves the last handle of the slot to i.
+                expired.emplace_back(handle, std::move(entry));
+            } else {
+                ++i;
+            }
+        }
+        if (mCurrentTick >= nowTick) break;
+
+        // Skip empty ticks, up to the next cascade.
+        if (mLevelCounts[0] == 0) {
+            mCurrentTick = std::min(nowTick, (mCurrentTick | int64_t{kSlotMask}) + 1);
+        } else {
+            ++mCurrentTick;
+        }
+    }
+}
+
+TimerThread::Handle TimerThread::TimingWheel::getNextDeadline() const {
+    if (mEntries.empty()) return INVALID_HANDLE;
+    Handle nextDeadline = INVALID_HANDLE;
+    if (mLevelCounts[0] != 0) {
+        // The first nonempty slot of level 0 holds the earliest deadlines.
+        for (size_t i = 0; i < kSlots; ++i) {
+            const auto& slot = mSlots[0][(mCurrentTick + i) & kSlotMask];
+            if (!slot.empty()) {
+                nextDeadline = *std::min_element(slot.begin(), slot.end());
+                break;
+            }
+        }
+    }
+    // A coarser level needs attention when its earliest nonempty slot cascades.
+    for (size_t level = 1; level < kLevels; ++level) {
+        if (mLevelCounts[level] == 0) continue;
+        const size_t shift = kSlotBits * level;
+        const int64_t current = mCurrentTick >> shift;
+        for (int64_t i = 1; i <= static_cast<int64_t>(kSlots); ++i) {
+            if (!mSlots[level][(current + i) & kSlotMask].empty()) {
+                const Handle cascadeTime = fromTick((current + i) << shift);
+                if (nextDeadline == INVALID_HANDLE || cascadeTime < nextDeadline) {
+                    nextDeadline = cascadeTime;
+                }
+                break;
+            }
+        }
+    }
+    return nextDeadline;
+}
+
+void TimerThread::TimingWheel::copyRequests(
+        std::vector<std::shared_ptr<const Request>>& requests) const {
+    for (const auto &[handle, node] : mEntries) {
+        requests.emplace_back(node.entry.first);
     }
 }
 
@@ -286,82 +456,95 @@ TimerThread::MonitorThread::~MonitorThread() {
     mThread.join();
 }
 
+TimerThread::Handle TimerThread::MonitorThread::processShard(Shard& shard, Handle now,
+        std::vector<std::pair<Handle, TimingWheel::Entry>>& expired,
+        std::vector<std::pair<Handle, TimingWheel::Entry>>& timeouts) {
+    std::lock_guard _l(shard.mShardMutex);
+    shard.mWheel.advance(now, expired);
+    for (auto& [handle, entry] : expired) {
+        // Deadline has expired, handle the request.
+        const auto secondChanceDuration = entry.first->secondChanceDuration;
+        if (secondChanceDuration.count() != 0) {
+            // We now apply the second chance duration to find the clock
+            // monotonic second deadline.  The unique key is then the
+            // pair<second_deadline, first_deadline>.
+            //
+            // The second chance prevents a false timeout should there be
+            // any clock monotonic advancement during suspend.
+            const Handle newHandle = now + secondChanceDuration;
+            ALOGD("%s: TimeCheck second chance applied for %s",
+                    __func__, entry.first->tag.c_str()); // should be rare event.
+            shard.mSecondChanceRequests.emplace(
+                    std::make_pair(newHandle, handle), std::move(entry));
+            // increment second chance counter.
+            mSecondChanceCount.fetch_add(1 /* arg */, std::memory_order_relaxed);
+        } else {
+            timeouts.emplace_back(handle, std::move(entry));
+        }
+    }
+    expired.clear();
+
+    // now process any second chance requests.
+    auto& secondChanceRequests = shard.mSecondChanceRequests;
+    while (!secondChanceRequests.empty() && secondChanceRequests.begin()->first.first < now) {
+        auto node = secondChanceRequests.extract(secondChanceRequests.begin());
+        const Handle originalHandle = node.key().second;
+        timeouts.emplace_back(originalHandle, std::move(node.mapped()));
+    }
+
+    Handle nextDeadline = shard.mWheel.getNextDeadline();
+    if (!secondChanceRequests.empty()) {
+        const Handle secondDeadline = secondChanceRequests.begin()->first.first;
+        if (nextDeadline == INVALID_HANDLE || secondDeadline < nextDeadline) {
+            nextDeadline = secondDeadline;
+        }
+    }
+    return nextDeadline;
+}
+
 void TimerThread::MonitorThread::threadFunc() {
+    std::vector<std::pair<Handle, TimingWheel::Entry>> expired;
+    std::vector<std::pair<Handle, TimingWheel::Entry>> timeouts;
     std::unique_lock _l(mMutex);
     ::android::base::ScopedLockAssertion lock_assertion(mMutex);
     while (!mShouldExit) {
+        // Any add() while we scan may precede the deadline we compute, so it
+        // must request a rescan.
+        mRescan = false;
+        mWakeupDeadline.store(kWakeupOnAdd);
+        _l.unlock();
+
+        const Handle now = std::chrono::steady_clock::now();
         Handle nextDeadline = INVALID_HANDLE;
-        Handle now = INVALID_HANDLE;
-        if (!mMonitorRequests.empty()) {
-            nextDeadline = mMonitorRequests.begin()->first;
-            now = std::chrono::steady_clock::now();
-            if (nextDeadline < now) {
-                auto node = mMonitorRequests.extract(mMonitorRequests.begin());
-                // Deadline has expired, handle the request.
-                auto secondChanceDuration = node.mapped().first->secondChanceDuration;
-                if (secondChanceDuration.count() != 0) {
-                    // We now apply the second chance duration to find the clock
-                    // monotonic second deadline.  The unique key is then the
-                    // pair<second_deadline, first_deadline>.
-                    //
-                    // The second chance prevents a false timeout should there be
-                    // any clock monotonic advancement during suspend.
-                    auto newHandle = now + secondChanceDuration;
-                    ALOGD("%s: TimeCheck second chance applied for %s",
-                            __func__, node.mapped().first->tag.c_str()); // should be rare event.
-                    mSecondChanceRequests.emplace_hint(mSecondChanceRequests.end(),
-                            std::make_pair(newHandle, nextDeadline),
-                            std::move(node.mapped()));
-                    // increment second chance counter.
-                    mSecondChanceCount.fetch_add(1 /* arg */, std::memory_order_relaxed);
-                } else {
-                    {
-                        _l.unlock();
-                        // We add Request to retired queue early so that it can be dumped out.
-                        mTimeoutQueue.add(std::move(node.mapped().first));
-                        node.mapped().second(nextDeadline);
-                        // Caution: we don't hold lock when we call TimerCallback,
-                        // but this is the timeout case!  We will crash soon,
-                        // maybe before returning.
-                        // anything left over is released here outside lock.
-                    }
-                    // reacquire the lock - if something was added, we loop immediately to check.
-                    _l.lock();
-                }
-                // always process expiring monitor requests first.
-                continue;
+        for (auto& shard : mShards) {
+            const Handle shardDeadline = processShard(shard, now, expired, timeouts);
+            if (shardDeadline != INVALID_HANDLE
+                    && (nextDeadline == INVALID_HANDLE || shardDeadline < nextDeadline)) {
+                nextDeadline = shardDeadline;
             }
         }
-        // now process any second chance requests.
-        if (!mSecondChanceRequests.empty()) {
-            Handle secondDeadline = mSecondChanceRequests.begin()->first.first;
-            if (now == INVALID_HANDLE) now = std::chrono::steady_clock::now();
-            if (secondDeadline < now) {
-                auto node = mSecondChanceRequests.extract(mSecondChanceRequests.begin());
-                {
-                    _l.unlock();
-                    // We add Request to retired queue early so that it can be dumped out.
-                    mTimeoutQueue.add(std::move(node.mapped().first));
-                    const Handle originalHandle = node.key().second;
-                    node.mapped().second(originalHandle);
-                    // Caution: we don't hold lock when we call TimerCallback.
-                    // This is benign issue - we permit concurrent operations
-                    // while in the callback to the MonitorQueue.
-                    //
-                    // Anything left over is released here outside lock.
-                }
-                // reacquire the lock - if something was added, we loop immediately to check.
-                _l.lock();
-                continue;
-            }
-            // update the deadline.
-            if (nextDeadline == INVALID_HANDLE) {
-                nextDeadline = secondDeadline;
-            } else {
-                nextDeadline = std::min(nextDeadline, secondDeadline);
+
+        if (!timeouts.empty()) {
+            std::sort(timeouts.begin(), timeouts.end(),
+                    [](const auto& t1, const auto& t2) { return t1.first < t2.first; });
+            for (auto& [handle, entry] : timeouts) {
+                // We add Request to retired queue early so that it can be dumped out.
+                mTimeoutQueue.add(std::move(entry.first));
+                entry.second(handle);
+                // Caution: we don't hold any lock when we call TimerCallback,
+                // but this is the timeout case!  We will crash soon,
+                // maybe before returning.
             }
+            timeouts.clear();  // anything left over is released here outside lock.
+            // reacquire the lock - we loop immediately to check.
+            _l.lock();
+            continue;
         }
+
+        _l.lock();
+        if (mRescan || mShouldExit) continue;
         if (nextDeadline != INVALID_HANDLE) {
+            mWakeupDeadline.store(nextDeadline.time_since_epoch().count());
             mCond.wait_until(_l, nextDeadline);
         } else {
             mCond.wait(_l);
@@ -371,22 +554,31 @@ void TimerThread::MonitorThread::threadFunc() {
 
 TimerThread::Handle TimerThread::MonitorThread::add(
         std::shared_ptr<const Request> request, TimerCallback&& func, Duration timeout) {
-    std::lock_guard _l(mMutex);
-    const Handle handle = getUniqueHandle_l(timeout);
-    mMonitorRequests.emplace_hint(mMonitorRequests.end(),
-            handle, std::make_pair(std::move(request), std::move(func)));
-    mCond.notify_all();
+    const size_t shardIndex = getCurrentShard();
+    Shard& shard = mShards[shardIndex];
+    Handle handle;
+    {
+        std::lock_guard _l(shard.mShardMutex);
+        handle = getUniqueHandle_l(shard.mWheel, timeout,
+                makeHandleLsbValue(HANDLE_TYPE::TIMEOUT, shardIndex));
+        shard.mWheel.add(handle, std::make_pair(std::move(request), std::move(func)));
+    }
+    // Only an earlier deadline than the worker thread is waiting for needs a wakeup,
+    // so typically add() takes no lock other than its shard.
+    if (handle.time_since_epoch().count() < mWakeupDeadline.load()) {
+        std::lock_guard _l(mMutex);
+        mRescan = true;
+        mCond.notify_all();
+    }
     return handle;
 }
 
 std::shared_ptr<const TimerThread::Request> TimerThread::MonitorThread::remove(Handle handle) {
-    std::pair<std::shared_ptr<const Request>, TimerCallback> data;
-    std::unique_lock ul(mMutex);
-    ::android::base::ScopedLockAssertion lock_assertion(mMutex);
-    if (const auto it = mMonitorRequests.find(handle);
-        it != mMonitorRequests.end()) {
-        data = std::move(it->second);
-        mMonitorRequests.erase(it);
+    TimingWheel::Entry data;
+    Shard& shard = mShards[getShardFromHandle(handle)];
+    std::unique_lock ul(shard.mShardMutex);
+    ::android::base::ScopedLockAssertion lock_assertion(shard.mShardMutex);
+    if (shard.mWheel.remove(handle, &data)) {
         ul.unlock();  // manually release lock here so func (data.second)
                       // is released outside of lock.
         return data.first;  // request
@@ -394,10 +586,11 @@ std::shared_ptr<const TimerThread::Request> TimerThread::MonitorThread::remove(H
 
     // this check is O(N), but since the second chance requests are ordered
     // in terms of earliest expiration time, we would expect better than average results.
-    for (auto it = mSecondChanceRequests.begin(); it != mSecondChanceRequests.end(); ++it) {
+    auto& secondChanceRequests = shard.mSecondChanceRequests;
+    for (auto it = secondChanceRequests.begin(); it != secondChanceRequests.end(); ++it) {
         if (it->first.second == handle) {
             data = std::move(it->second);
-            mSecondChanceRequests.erase(it);
+            secondChanceRequests.erase(it);
             ul.unlock();  // manually release lock here so func (data.second)
                           // is released outside of lock.
             return data.first; // request
@@ -408,16 +601,14 @@ std::shared_ptr<const TimerThread::Request> TimerThread::MonitorThread::remove(H
 
 void TimerThread::MonitorThread::copyRequests(
         std::vector<std::shared_ptr<const Request>>& requests) const {
-    std::lock_guard lg(mMutex);
-    for (const auto &[deadline, monitorpair] : mMonitorRequests) {
-        requests.emplace_back(monitorpair.first);
-    }
-    // we combine the second map with the first map - this is
-    // everything that is pending on the monitor thread.
-    // The second map will be older than the first map so this
-    // is in order.
-    for (const auto &[deadline, monitorpair] : mSecondChanceRequests) {
-        requests.emplace_back(monitorpair.first);
+    for (const auto& shard : mShards) {
+        std::lock_guard lg(shard.mShardMutex);
+        shard.mWheel.copyRequests(requests);
+        // we combine the second chance map with the wheel - this is
+        // everything that is pending on the monitor thread.
+        for (const auto &[deadline, monitorpair] : shard.mSecondChanceRequests) {
+            requests.emplace_back(monitorpair.first);
+        }
     }
 }
 
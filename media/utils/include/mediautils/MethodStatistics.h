@@ -16,9 +16,16 @@
 
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
 #include <map>
+#include <memory>
 #include <mutex>
+#include <sstream>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include <android-base/thread_annotations.h>
@@ -26,6 +33,70 @@
 
 namespace android::mediautils {
 
+/**
+ * PercentileSketch is a fixed size log-linear histogram of positive values,
+ * used to estimate percentiles.
+ *
+ * Each power of 2 from 2^kMinExponent to 2^kMaxExponent is split into
+ * kSubBuckets buckets, so an estimate is within about 1 / (2 * kSubBuckets)
+ * of the true value.  Smaller and larger values are clamped to the range.
+ *
+ * The PercentileSketch is NOT thread safe.
+ */
+class PercentileSketch {
+public:
+    static constexpr int kMinExponent = -10;  // about 1us if the value is in ms.
+    static constexpr int kMaxExponent = 16;   // about 65s if the value is in ms.
+    static constexpr size_t kSubBuckets = 8;
+    static constexpr size_t kBuckets = (kMaxExponent - kMinExponent) * kSubBuckets + 2;
+
+    void add(float value) {
+        ++mCounts[getBucket(value)];
+        ++mN;
+    }
+
+    int64_t getN() const { return mN; }
+
+    /**
+     * Returns the estimated value at percentile (0 to 100), or 0 if empty.
+     */
+    float getPercentile(float percentile) const {
+        if (mN == 0) return 0.f;
+        const int64_t rank = std::clamp(
+                (int64_t)std::ceil(percentile / 100.f * mN), (int64_t)1, mN);
+        int64_t cumulative = 0;
+        for (size_t i = 0; i < kBuckets; ++i) {
+            cumulative += mCounts[i];
+            if (cumulative >= rank) return getBucketValue(i);
+        }
+        return getBucketValue(kBuckets - 1);
+    }
+
+private:
+    static size_t getBucket(float value) {
+        if (!(value >= std::ldexp(1.f, kMinExponent))) return 0;  // includes NaN.
+        int exponent;
+        const float mantissa = std::frexp(value, &exponent);  // mantissa in [0.5, 1)
+        --exponent;
+        if (exponent >= kMaxExponent) return kBuckets - 1;
+        const size_t subBucket = std::min(
+                (size_t)((mantissa * 2.f - 1.f) * kSubBuckets), kSubBuckets - 1);
+        return 1 + (exponent - kMinExponent) * kSubBuckets + subBucket;
+    }
+
+    // Returns the midpoint of the bucket.
+    static float getBucketValue(size_t bucket) {
+        if (bucket == 0) return std::ldexp(1.f, kMinExponent);
+        if (bucket == kBuckets - 1) return std::ldexp(1.f, kMaxExponent);
+        const int exponent = (int)((bucket - 1) / kSubBuckets) + kMinExponent;
+        const size_t subBucket = (bucket - 1) % kSubBuckets;
+        return std::ldexp(1.f + (subBucket + 0.5f) / kSubBuckets, exponent);
+    }
+
+    std::array<uint32_t, kBuckets> mCounts{};
+    int64_t mN = 0;
+};
+
 /**
  * MethodStatistics is used to associate Binder codes
  * with a method name and execution time statistics.
@@ -35,6 +106,10 @@ namespace android::mediautils {
  *
  * Here, Code is the enumeration type for the method
  * lookup.
+ *
+ * Events are buffered per thread shard and merged into the statistics
+ * in batches, or whenever the statistics are read, so that concurrent
+ * binder threads rarely contend on a common lock.
  */
 template <typename Code>
 class MethodStatistics {
@@ -47,24 +122,26 @@ public:
      *
      * Initialized with the Binder transaction list for tracking AudioFlinger
      * and AudioPolicyManager execution statistics.
+     *
+     * If percentiles is true, a PercentileSketch is kept for each method
+     * and dump() includes the p50, p99 and p999 values.
      */
     explicit MethodStatistics(
-            const std::initializer_list<std::pair<const Code, std::string>>& methodMap = {})
-        : mMethodMap{methodMap} {}
+            const std::initializer_list<std::pair<const Code, std::string>>& methodMap = {},
+            bool percentiles = true)
+        : mMethodMap{methodMap}
+        , mPercentiles(percentiles) {}
 
     /**
      * Adds a method event, typically execution time in ms.
      */
     template <typename C>
     void event(C&& code, FloatType executeMs) {
-        std::lock_guard lg(mLock);
-        auto it = mStatisticsMap.lower_bound(code);
-        if (it != mStatisticsMap.end() && it->first == static_cast<Code>(code)) {
-            it->second.add(executeMs);
-        } else {
-            // StatsType ctor takes an optional array of data for initialization.
-            FloatType dataArray[1] = { executeMs };
-            mStatisticsMap.emplace_hint(it, std::forward<C>(code), dataArray);
+        Shard& shard = mShards[getShardIndex()];
+        std::lock_guard lg(shard.mLock);
+        shard.mEvents.emplace_back(static_cast<Code>(std::forward<C>(code)), executeMs);
+        if (shard.mEvents.size() >= kMaxBufferedEvents) {
+            flushShard_l(shard);
         }
     }
 
@@ -80,45 +157,107 @@ public:
      * Returns the number of times the method was invoked by event().
      */
     size_t getMethodCount(const Code& code) const {
+        flush();
         std::lock_guard lg(mLock);
         auto it = mStatisticsMap.find(code);
-        return it == mStatisticsMap.end() ? 0 : it->second.getN();
+        return it == mStatisticsMap.end() ? 0 : it->second.stats.getN();
     }
 
     /**
      * Returns the statistics object for the method.
      */
     StatsType getStatistics(const Code& code) const {
+        flush();
         std::lock_guard lg(mLock);
         auto it = mStatisticsMap.find(code);
-        return it == mStatisticsMap.end() ? StatsType{} : it->second;
+        return it == mStatisticsMap.end() ? StatsType{} : it->second.stats;
+    }
+
+    /**
+     * Returns the estimated value at percentile (0 to 100) for the method,
+     * or 0 if there are no events or percentiles are not enabled.
+     */
+    FloatType getPercentile(const Code& code, FloatType percentile) const {
+        flush();
+        std::lock_guard lg(mLock);
+        auto it = mStatisticsMap.find(code);
+        return it == mStatisticsMap.end() ? 0.f : it->second.sketch.getPercentile(percentile);
     }
 
     /**
      * Dumps the current method statistics.
      */
     std::string dump() const {
+        flush();
         std::stringstream ss;
         std::lock_guard lg(mLock);
-        if constexpr (std::is_same_v<Code, std::string>) {
-            for (const auto &[code, stats] : mStatisticsMap) {
-                ss << code <<
-                        " n=" << stats.getN() << " " << stats.toString() << "\n";
+        for (const auto &[code, accumulator] : mStatisticsMap) {
+            if constexpr (std::is_same_v<Code, std::string>) {
+                ss << code;
+            } else /* constexpr */ {
+                ss << int(code) << " " << getMethodForCode(code);
             }
-        } else /* constexpr */ {
-            for (const auto &[code, stats] : mStatisticsMap) {
-                ss << int(code) << " " << getMethodForCode(code) <<
-                        " n=" << stats.getN() << " " << stats.toString() << "\n";
+            ss << " n=" << accumulator.stats.getN() << " " << accumulator.stats.toString();
+            if (mPercentiles) {
+                ss << " p50=" << accumulator.sketch.getPercentile(50.f)
+                        << " p99=" << accumulator.sketch.getPercentile(99.f)
+                        << " p999=" << accumulator.sketch.getPercentile(99.9f);
             }
+            ss << "\n";
         }
         return ss.str();
     }
 
 private:
+    static constexpr size_t kShards = 8;
+    static constexpr size_t kMaxBufferedEvents = 32;
+
+    struct Accumulator {
+        StatsType stats;
+        PercentileSketch sketch;
+    };
+
+    struct alignas(64) Shard {  // avoid false sharing between shards.
+        std::mutex mLock;
+        std::vector<std::pair<Code, FloatType>> mEvents GUARDED_BY(mLock);
+    };
+
+    // Each thread is assigned a shard on first use.
+    static size_t getShardIndex() {
+        static std::atomic<size_t> nextShard{};
+        static thread_local const size_t shard = nextShard++ % kShards;
+        return shard;
+    }
+
+    // Merges the buffered events of the shard into the statistics.
+    // Lock order is shard, then mLock.
+    void flushShard_l(Shard& shard) const REQUIRES(shard.mLock) {
+        if (shard.mEvents.empty()) return;
+        std::lock_guard lg(mLock);
+        for (auto& [code, executeMs] : shard.mEvents) {
+            auto it = mStatisticsMap.lower_bound(code);
+            if (it == mStatisticsMap.end() || it->first != code) {
+                it = mStatisticsMap.emplace_hint(it, std::move(code), Accumulator{});
+            }
+            it->second.stats.add(executeMs);
+            if (mPercentiles) it->second.sketch.add(executeMs);
+        }
+        shard.mEvents.clear();
+    }
+
+    void flush() const {
+        for (auto& shard : mShards) {
+            std::lock_guard lg(shard.mLock);
+            flushShard_l(shard);
+        }
+    }
+
     // Note: we use a transparent comparator std::less<> for heterogeneous key lookup.
     const std::map<Code, std::string, std::less<>> mMethodMap;
+    const bool mPercentiles;
+    mutable std::array<Shard, kShards> mShards;
     mutable std::mutex mLock;
-    std::map<Code, StatsType, std::less<>> mStatisticsMap GUARDED_BY(mLock);
+    mutable std::map<Code, Accumulator, std::less<>> mStatisticsMap GUARDED_BY(mLock);
 };
 
 // Managed Statistics support.
@@ -16,15 +16,17 @@
 
 #pragma once
 
+#include <array>
 #include <atomic>
 #include <condition_variable>
-#include <deque>
 #include <functional>
+#include <limits>
 #include <map>
 #include <memory>
 #include <mutex>
 #include <string>
 #include <thread>
+#include <unordered_map>
 #include <vector>
 
 #include <android-base/thread_annotations.h>
@@ -90,27 +92,41 @@ class TimerThread {
                 enum_as_value(HANDLE_TYPE::TIMEOUT);
     }
 
-    // Returns a unique Handle that doesn't exist in the container.
-    template <size_t MAX_TYPED_HANDLES, size_t HANDLE_TYPE_AS_VALUE, typename C, typename T>
-    static Handle getUniqueHandleForHandleType_l(C container, T timeout) {
-        static_assert(MAX_TYPED_HANDLES > 0 && HANDLE_TYPE_AS_VALUE < MAX_TYPED_HANDLES
-                && is_power_of_2_v<MAX_TYPED_HANDLES>,
-                " handles must be power of two");
+    // Timeout and tracked tasks are spread over kShards, each with its own lock,
+    // so that concurrent scheduleTask() and cancelTask() calls on different cpus
+    // rarely contend.  The shard index is kept in the Handle lsbs above the HANDLE_TYPE.
+    static constexpr size_t kShards = 8;
+    static_assert(is_power_of_2_v<kShards>);
+
+    static constexpr size_t HANDLE_LSB_VALUES = HANDLE_TYPES * kShards;
+    static constexpr size_t HANDLE_LSB_MASK = mask_from_count_v<HANDLE_LSB_VALUES>;
+
+    static constexpr size_t makeHandleLsbValue(HANDLE_TYPE type, size_t shard) {
+        return enum_as_value(type) + HANDLE_TYPES * shard;
+    }
+
+    static inline size_t getShardFromHandle(Handle handle) {
+        return (handle.time_since_epoch().count() & HANDLE_LSB_MASK) / HANDLE_TYPES;
+    }
 
+    // Returns a unique Handle that doesn't exist in the container.
+    // The Handle lsbs are set to handleLsbValue, which encodes the HANDLE_TYPE and shard.
+    template <typename C, typename T>
+    static Handle getUniqueHandle_l(const C& container, T timeout, size_t handleLsbValue) {
         // Our initial handle is the deadline as computed from steady_clock.
         auto deadline = std::chrono::steady_clock::now() + timeout;
 
         // We adjust the lsbs by the minimum increment to have the correct
-        // HANDLE_TYPE in the least significant bits.
-        auto remainder = deadline.time_since_epoch().count() & HANDLE_TYPE_MASK;
-        size_t offset = HANDLE_TYPE_AS_VALUE > remainder ? HANDLE_TYPE_AS_VALUE - remainder :
-                     MAX_TYPED_HANDLES + HANDLE_TYPE_AS_VALUE - remainder;
+        // HANDLE_TYPE and shard in the least significant bits.
+        const size_t remainder = deadline.time_since_epoch().count() & HANDLE_LSB_MASK;
+        const size_t offset = handleLsbValue > remainder ? handleLsbValue - remainder :
+                     HANDLE_LSB_VALUES + handleLsbValue - remainder;
         deadline += std::chrono::steady_clock::duration(offset);
 
-        // To avoid key collisions, advance the handle by MAX_TYPED_HANDLES (the modulus factor)
+        // To avoid key collisions, advance the handle by HANDLE_LSB_VALUES (the modulus factor)
         // until the key is unique.
-        while (container.find(deadline) != container.end()) {
-            deadline += std::chrono::steady_clock::duration(MAX_TYPED_HANDLES);
+        while (container.count(deadline) != 0) {
+            deadline += std::chrono::steady_clock::duration(HANDLE_LSB_VALUES);
         }
         return deadline;
     }
@@ -194,6 +210,20 @@ class TimerThread {
      */
     std::string timeoutToString(size_t n = SIZE_MAX) const;
 
+    /**
+     * Returns the number of tasks retired by cancelTask() since construction.
+     *
+     * This is lock free.
+     */
+    size_t getRetiredCount() const { return mRetiredQueue.getAddedCount(); }
+
+    /**
+     * Returns the number of tasks which have timed out since construction.
+     *
+     * This is lock free.
+     */
+    size_t getTimeoutCount() const { return mTimeoutQueue.getAddedCount(); }
+
     /**
      * Dumps a container with SmartPointer<Request> to a string.
      *
@@ -263,6 +293,9 @@ class TimerThread {
         pid_t suspectTid = INVALID_PID;
         // Number of second chances given by the timer thread
         size_t secondChanceCount;
+        // Number of requests retired and timed out since the timer thread started.
+        size_t retiredCount;
+        size_t timeoutCount;
         // List of pending requests
         std::vector<std::shared_ptr<const Request>> pendingRequests;
         // List of timed-out requests
@@ -275,12 +308,14 @@ class TimerThread {
     };
 
   private:
-    // Deque of requests, in order of add().
-    // This class is thread-safe.
+    // Ring of the last requests added, in order of add().
+    // This class is thread-safe.  add() claims a slot with an atomic counter,
+    // so concurrent adds only contend if they land on the same slot.
     class RequestQueue {
       public:
         explicit RequestQueue(size_t maxSize)
-            : mRequestQueueMax(maxSize) {}
+            : mRequestQueueMax(maxSize)
+            , mSlots(std::make_unique<Slot[]>(maxSize)) {}
 
         void add(std::shared_ptr<const Request>);
 
@@ -288,61 +323,135 @@ class TimerThread {
         void copyRequests(std::vector<std::shared_ptr<const Request>>& requests,
             size_t n = SIZE_MAX) const;
 
+        // Returns the number of requests ever added.
+        size_t getAddedCount() const {
+            return mAddedCount.load(std::memory_order_relaxed);
+        }
+
       private:
+        struct Slot {
+            mutable std::mutex mSlotMutex;
+            uint64_t mSequence GUARDED_BY(mSlotMutex) = 0;  // 1-based add() count, 0 if empty.
+            std::shared_ptr<const Request> mRequest GUARDED_BY(mSlotMutex);
+        };
+
         const size_t mRequestQueueMax;
-        mutable std::mutex mRQMutex;
-        std::deque<std::pair<std::chrono::system_clock::time_point,
-                             std::shared_ptr<const Request>>>
-                mRequestQueue GUARDED_BY(mRQMutex);
+        std::atomic<uint64_t> mAddedCount{};
+        const std::unique_ptr<Slot[]> mSlots;
     };
 
     // A storage map of tasks without timeouts.  There is no TimerCallback
     // required, it just tracks the tasks with the tag, scheduled time and the tid.
     // These tasks show up on a pendingToString() until manually cancelled.
     class NoTimeoutMap {
-        mutable std::mutex mNTMutex;
-        std::map<Handle, std::shared_ptr<const Request>> mMap GUARDED_BY(mNTMutex);
-        Handle getUniqueHandle_l() REQUIRES(mNTMutex) {
-            return getUniqueHandleForHandleType_l<
-                    HANDLE_TYPES, enum_as_value(HANDLE_TYPE::NO_TIMEOUT)>(
-                mMap, Duration{} /* timeout */);
-        }
+        struct Shard {
+            mutable std::mutex mNTMutex;
+            std::map<Handle, std::shared_ptr<const Request>> mMap GUARDED_BY(mNTMutex);
+        };
+        std::array<Shard, kShards> mShards;
 
       public:
-        bool isValidHandle(Handle handle) const; // lock free
         Handle add(std::shared_ptr<const Request> request);
         std::shared_ptr<const Request> remove(Handle handle);
         void copyRequests(std::vector<std::shared_ptr<const Request>>& requests) const;
     };
 
+    // A hierarchical timing wheel of timeout requests keyed by Handle (the deadline).
+    //
+    // Requests are bucketed by deadline tick into kLevels levels of kSlots slots,
+    // each level kSlots times coarser than the one below.  Insertion and removal
+    // are O(1); requests cascade down to finer levels as time advances, so only
+    // the finest level is examined for expiration.
+    //
+    // This class is NOT thread-safe.
+    class TimingWheel {
+      public:
+        using Entry = std::pair<std::shared_ptr<const Request>, TimerCallback>;
+
+        size_t count(Handle handle) const { return mEntries.count(handle); }
+        bool empty() const { return mEntries.empty(); }
+
+        void add(Handle handle, Entry&& entry);
+
+        // Returns true and moves the entry out if the handle was present.
+        bool remove(Handle handle, Entry* entry);
+
+        // Removes the entries whose deadline is before now, appending them to expired.
+        void advance(Handle now, std::vector<std::pair<Handle, Entry>>& expired);
+
+        // Returns the time advance() should next be called, or INVALID_HANDLE if empty.
+        Handle getNextDeadline() const;
+
+        void copyRequests(std::vector<std::shared_ptr<const Request>>& requests) const;
+
+      private:
+        static constexpr Duration kTick = std::chrono::milliseconds(1);
+        static constexpr size_t kSlotBits = 6;
+        static constexpr size_t kSlots = 1 << kSlotBits;
+        static constexpr size_t kSlotMask = kSlots - 1;
+        static constexpr size_t kLevels = 4;  // 2^24 ticks, about 4.6 hours.
+
+        struct HandleHash {
+            size_t operator()(Handle handle) const {
+                return std::hash<Handle::rep>{}(handle.time_since_epoch().count());
+            }
+        };
+
+        struct Node {
+            Entry entry;
+            size_t level = 0;
+            size_t slot = 0;
+            size_t index = 0;  // position in the slot.
+        };
+
+        static int64_t toTick(Handle handle) { return handle.time_since_epoch() / kTick; }
+        static Handle fromTick(int64_t tick) { return Handle(tick * kTick); }
+
+        void place(Handle handle, Node& node);
+        void unplace(const Node& node);
+        void cascade();
+
+        int64_t mCurrentTick = 0;  // ticks before this have been expired.
+        std::unordered_map<Handle, Node, HandleHash> mEntries;
+        std::array<std::array<std::vector<Handle>, kSlots>, kLevels> mSlots;
+        std::array<size_t, kLevels> mLevelCounts{};
+    };
+
     // Monitor thread.
     // This thread manages shared pointers to Requests and a function to
     // call on timeout.
     // This class is thread-safe.
     class MonitorThread {
         std::atomic<size_t> mSecondChanceCount{};
-        mutable std::mutex mMutex;
-        mutable std::condition_variable mCond GUARDED_BY(mMutex);
 
-        // Ordered map of requests based on time of deadline.
-        //
-        std::map<Handle, std::pair<std::shared_ptr<const Request>, TimerCallback>>
-                mMonitorRequests GUARDED_BY(mMutex);
+        struct Shard {
+            mutable std::mutex mShardMutex;
+            TimingWheel mWheel GUARDED_BY(mShardMutex);
 
-        // Due to monotonic/steady clock inaccuracies during suspend,
-        // we allow an additional second chance waiting time to prevent
-        // false removal.
+            // Due to monotonic/steady clock inaccuracies during suspend,
+            // we allow an additional second chance waiting time to prevent
+            // false removal.
 
-        // This mSecondChanceRequests queue is almost always empty.
-        // Using a pair with the original handle allows lookup and keeps
-        // the Key unique.
-        std::map<std::pair<Handle /* new */, Handle /* original */>,
-                std::pair<std::shared_ptr<const Request>, TimerCallback>>
-                        mSecondChanceRequests GUARDED_BY(mMutex);
+            // This mSecondChanceRequests queue is almost always empty.
+            // Using a pair with the original handle allows lookup and keeps
+            // the Key unique.
+            std::map<std::pair<Handle /* new */, Handle /* original */>, TimingWheel::Entry>
+                    mSecondChanceRequests GUARDED_BY(mShardMutex);
+        };
+        std::array<Shard, kShards> mShards;
 
-        RequestQueue& mTimeoutQueue GUARDED_BY(mMutex); // added to when request times out.
+        RequestQueue& mTimeoutQueue; // added to when request times out.
+
+        // The deadline the worker thread is sleeping until.  add() only wakes the
+        // worker thread for an earlier deadline.  While the worker thread is scanning
+        // the shards this is kWakeupOnAdd, so that any add() requests a rescan.
+        static constexpr Handle::rep kWakeupOnAdd = std::numeric_limits<Handle::rep>::max();
+        std::atomic<Handle::rep> mWakeupDeadline{kWakeupOnAdd};
 
         // Worker thread variables
+        mutable std::mutex mMutex;
+        mutable std::condition_variable mCond GUARDED_BY(mMutex);
+        bool mRescan GUARDED_BY(mMutex) = false;
         bool mShouldExit GUARDED_BY(mMutex) = false;
 
         // To avoid race with initialization,
@@ -350,11 +459,13 @@ class TimerThread {
         std::thread mThread;
 
         void threadFunc();
-        Handle getUniqueHandle_l(Duration timeout) REQUIRES(mMutex) {
-            return getUniqueHandleForHandleType_l<
-                    HANDLE_TYPES, enum_as_value(HANDLE_TYPE::TIMEOUT)>(
-                mMonitorRequests, timeout);
-        }
+
+        // Expires the due requests of a shard, moving second chance requests
+        // into the shard and the rest into timeouts.
+        // Returns the next deadline of the shard, or INVALID_HANDLE if empty.
+        Handle processShard(Shard& shard, Handle now,
+                std::vector<std::pair<Handle, TimingWheel::Entry>>& expired,
+                std::vector<std::pair<Handle, TimingWheel::Entry>>& timeouts);
 
       public:
         MonitorThread(RequestQueue &timeoutQueue);
@@ -369,6 +480,8 @@ class TimerThread {
         }
     };
 
+    // Returns the shard for tasks added by the calling thread.
+    static size_t getCurrentShard();
 
     // A HAL method is where the substring "Hidl" is in the class name.
     // The tag should look like: ... Hidl ... :: ...
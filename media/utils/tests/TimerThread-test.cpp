@@ -16,6 +16,7 @@
 
 #include <chrono>
 #include <thread>
+#include <vector>
 #include <gtest/gtest.h>
 #include <mediautils/TimerThread.h>
 
@@ -274,4 +275,59 @@ TEST(TimerThread, TrackedTasks) {
     ASSERT_EQ(4ul, countChars(thread.retiredToString(), REQUEST_START));
 }
 
+TEST(TimerThread, EarlierDeadlineAcrossLevels) {
+    std::atomic<bool> longTaskRan = false;
+    std::atomic<bool> shortTaskRan = false;
+    TimerThread thread;
+
+    // The long deadline lands on a coarse level of the timing wheel,
+    // the short deadline must still wake the thread on time.
+    auto longHandle = thread.scheduleTask("Long", [&longTaskRan](TimerThread::Handle) {
+            longTaskRan = true; }, 10s, 0ms);
+    thread.scheduleTask("Short", [&shortTaskRan](TimerThread::Handle) {
+            shortTaskRan = true; }, 100ms, 0ms);
+
+    std::this_thread::sleep_for(100ms - kJitter);
+    ASSERT_FALSE(shortTaskRan);
+    std::this_thread::sleep_for(2 * kJitter);
+    ASSERT_TRUE(shortTaskRan);
+    ASSERT_FALSE(longTaskRan);
+
+    ASSERT_TRUE(thread.cancelTask(longHandle));
+    ASSERT_EQ(0ul, countChars(thread.pendingToString(), REQUEST_START));
+    ASSERT_EQ(1ul, thread.getTimeoutCount());
+    ASSERT_EQ(1ul, thread.getRetiredCount());
+}
+
+TEST(TimerThread, ConcurrentScheduleAndCancel) {
+    constexpr size_t kThreads = 8;
+    constexpr size_t kTasksPerThread = 1000;
+    std::atomic<size_t> tasksRan = 0;
+    std::atomic<size_t> cancelled = 0;
+    TimerThread thread;
+
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < kThreads; ++i) {
+        threads.emplace_back([&] {
+            for (size_t j = 0; j < kTasksPerThread; ++j) {
+                const auto handle = j % 2 == 0
+                        ? thread.scheduleTask("Concurrent", [&tasksRan](TimerThread::Handle) {
+                                ++tasksRan; }, 10s, 0ms)
+                        : thread.trackTask("Tracked");
+                if (thread.cancelTask(handle)) ++cancelled;
+            }
+        });
+    }
+    for (auto& t : threads) t.join();
+
+    ASSERT_EQ(0ul, tasksRan);
+    ASSERT_EQ(kThreads * kTasksPerThread, cancelled);
+    ASSERT_EQ(kThreads * kTasksPerThread, thread.getRetiredCount());
+    ASSERT_EQ(0ul, thread.getTimeoutCount());
+    ASSERT_EQ(0ul, countChars(thread.pendingToString(), REQUEST_START));
+    // Only the most recent retired tasks are kept.
+    ASSERT_LT(0ul, countChars(thread.retiredToString(), REQUEST_START));
+    ASSERT_GT(kThreads * kTasksPerThread, countChars(thread.retiredToString(), REQUEST_START));
+}
+
 }  // namespace
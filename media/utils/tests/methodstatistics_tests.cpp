@@ -19,6 +19,9 @@
 #include <mediautils/MethodStatistics.h>
 
 #include <atomic>
+#include <thread>
+#include <vector>
+
 #include <gtest/gtest.h>
 #include <utils/Log.h>
 
@@ -70,3 +73,56 @@ TEST(methodstatistics_tests, events) {
     ASSERT_EQ(0.f, unsetStats.getMean());
     ASSERT_EQ(0U, methodStatistics.getMethodCount(UNKNOWN_CODE));
 }
+
+TEST(methodstatistics_tests, percentiles) {
+    MethodStatistics<CodeType> methodStatistics{
+            {HELLO_CODE, HELLO_NAME},
+            {WORLD_CODE, WORLD_NAME},
+    };
+
+    constexpr size_t kEvents = 1000;
+    for (size_t i = 1; i <= kEvents; ++i) {
+        methodStatistics.event(HELLO_CODE, (float)i);
+    }
+
+    // The sketch is accurate to within 1 / (2 * kSubBuckets).
+    constexpr float kRelativeError = 1.f / (2 * PercentileSketch::kSubBuckets);
+    ASSERT_NEAR(500.f, methodStatistics.getPercentile(HELLO_CODE, 50.f), 500.f * kRelativeError);
+    ASSERT_NEAR(990.f, methodStatistics.getPercentile(HELLO_CODE, 99.f), 990.f * kRelativeError);
+    ASSERT_NEAR(999.f, methodStatistics.getPercentile(HELLO_CODE, 99.9f),
+            999.f * kRelativeError);
+    ASSERT_EQ(0.f, methodStatistics.getPercentile(WORLD_CODE, 50.f));
+
+    const std::string dump = methodStatistics.dump();
+    ASSERT_NE(std::string::npos, dump.find("p50="));
+    ASSERT_NE(std::string::npos, dump.find("p999="));
+
+    // Without percentiles, the dump is unchanged.
+    MethodStatistics<CodeType> noPercentiles({{HELLO_CODE, HELLO_NAME}}, false /* percentiles */);
+    noPercentiles.event(HELLO_CODE, 1.f);
+    ASSERT_EQ(std::string::npos, noPercentiles.dump().find("p50="));
+}
+
+TEST(methodstatistics_tests, concurrent_events) {
+    MethodStatistics<CodeType> methodStatistics{
+            {HELLO_CODE, HELLO_NAME},
+    };
+
+    constexpr size_t kThreads = 8;
+    constexpr size_t kEventsPerThread = 1001;  // not a multiple of the batch size.
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < kThreads; ++i) {
+        threads.emplace_back([&methodStatistics] {
+            for (size_t j = 0; j < kEventsPerThread; ++j) {
+                methodStatistics.event(HELLO_CODE, 2.f);
+            }
+        });
+    }
+    for (auto& thread : threads) thread.join();
+
+    // Buffered events are merged when read.
+    ASSERT_EQ(kThreads * kEventsPerThread, methodStatistics.getMethodCount(HELLO_CODE));
+    const auto helloStats = methodStatistics.getStatistics(HELLO_CODE);
+    ASSERT_EQ((signed)(kThreads * kEventsPerThread), helloStats.getN());
+    ASSERT_EQ(2.f, helloStats.getMean());
+}
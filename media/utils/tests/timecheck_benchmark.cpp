@@ -0,0 +1,61 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <chrono>
+
+#include <benchmark/benchmark.h>
+#include <mediautils/TimeCheck.h>
+#include <mediautils/TimerThread.h>
+
+using namespace std::chrono_literals;
+using namespace android::mediautils;
+
+namespace {
+
+// A TimeCheck is constructed and destroyed around every audioserver and
+// cameraserver binder call.  Run with multiple threads to measure contention.
+//
+// Arg 0 tracks the call without a timeout, arg 1 schedules a timeout.
+void BM_TimeCheck(benchmark::State& state) {
+    static const bool systemReady = (TimeCheck::setSystemReady(), true);
+    (void)systemReady;
+    const TimeCheck::Duration timeout = state.range(0) != 0 ? 5s : 0s;
+
+    for (auto _ : state) {
+        TimeCheck timeCheck("BM_TimeCheck", {} /* onTimer */, timeout,
+                {} /* secondChanceDuration */, false /* crashOnTimeout */);
+        benchmark::DoNotOptimize(timeCheck);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_TimeCheck)->Arg(0)->Arg(1)->ThreadRange(1, 16)->UseRealTime();
+
+// Schedules and cancels a task directly on a shared TimerThread.
+void BM_TimerThreadScheduleCancel(benchmark::State& state) {
+    static TimerThread timerThread;
+
+    for (auto _ : state) {
+        const auto handle = timerThread.scheduleTask("BM_TimerThreadScheduleCancel",
+                [](TimerThread::Handle) {}, 5s, 0s);
+        benchmark::DoNotOptimize(timerThread.cancelTask(handle));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_TimerThreadScheduleCancel)->ThreadRange(1, 16)->UseRealTime();
+
+} // namespace
+
+BENCHMARK_MAIN();
@@ -1299,6 +1299,7 @@ status_t AudioFlinger::createTrack(const media::CreateTrackRequest& _input,
         AudioSystem::moveEffectsToIo(effectIds, effectThreadId);
     }
 
+    output.cblk = track->getCblk();
     output.audioTrack = new TrackHandle(track);
     _output = VALUE_OR_FATAL(output.toAidl());
 
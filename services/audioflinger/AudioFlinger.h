@@ -99,6 +99,7 @@
 #include "SpdifStreamOut.h"
 #include "AudioHwDevice.h"
 #include "NBAIO_Tee.h"
+#include "ThreadHistograms.h"
 #include "ThreadMetrics.h"
 #include "TrackMetrics.h"
 #include "AllocatorFactory.h"
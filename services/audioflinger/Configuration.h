@@ -50,6 +50,10 @@
 
 // define MULTICHANNEL_EFFECT_CHAIN to allow multichannel effects (FLOAT_EFFECT_CHAIN defined)
 #define MULTICHANNEL_EFFECT_CHAIN
+
+// define ZERO_COPY_EFFECT_CHAIN to let in-place int16_t effects convert the chain float buffer
+// in place, instead of going through separate conversion buffers (FLOAT_EFFECT_CHAIN defined)
+#define ZERO_COPY_EFFECT_CHAIN
 #endif
 
 #endif // ANDROID_AUDIOFLINGER_CONFIGURATION_H
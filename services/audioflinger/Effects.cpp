@@ -673,6 +673,7 @@ void AudioFlinger::EffectModule::process()
 {
     Mutex::Autolock _l(mLock);
 
+    mBytesCopied = 0;
     if (mState == DESTROYED || mEffectInterface == 0 || mInBuffer == 0 || mOutBuffer == 0) {
         return;
     }
@@ -699,11 +700,13 @@ void AudioFlinger::EffectModule::process()
                 mConfig.outputCfg.buffer.f32,
                 mConfig.inputCfg.buffer.f32,
                 safeInputOutputSampleCount);
+        mBytesCopied += safeInputOutputSampleCount * sizeof(float);
 #else
         accumulate_i16(
                 mConfig.outputCfg.buffer.s16,
                 mConfig.inputCfg.buffer.s16,
                 safeInputOutputSampleCount);
+        mBytesCopied += safeInputOutputSampleCount * sizeof(int16_t);
 #endif
     };
     const auto copyInputToOutput = [this, safeInputOutputSampleCount]() {
@@ -712,12 +715,13 @@ void AudioFlinger::EffectModule::process()
                 mConfig.outputCfg.buffer.f32,
                 mConfig.inputCfg.buffer.f32,
                 safeInputOutputSampleCount * sizeof(*mConfig.outputCfg.buffer.f32));
-
+        mBytesCopied += safeInputOutputSampleCount * sizeof(*mConfig.outputCfg.buffer.f32);
 #else
         memcpy(
                 mConfig.outputCfg.buffer.s16,
                 mConfig.inputCfg.buffer.s16,
                 safeInputOutputSampleCount * sizeof(*mConfig.outputCfg.buffer.s16));
+        mBytesCopied += safeInputOutputSampleCount * sizeof(*mConfig.outputCfg.buffer.s16);
 #endif
     };
 
@@ -738,6 +742,7 @@ void AudioFlinger::EffectModule::process()
                             mConfig.inputCfg.buffer.f32,
                             mConfig.inputCfg.buffer.s32,
                             mConfig.inputCfg.buffer.frameCount);
+                    mBytesCopied += mConfig.inputCfg.buffer.frameCount * sizeof(float);
 #endif // !FLOAT_AUX
                 } else
 #endif // FLOAT_EFFECT_CHAIN
@@ -753,6 +758,7 @@ void AudioFlinger::EffectModule::process()
                             mConfig.inputCfg.buffer.s32,
                             mConfig.inputCfg.buffer.frameCount);
 #endif
+                    mBytesCopied += mConfig.inputCfg.buffer.frameCount * sizeof(int16_t);
                 }
             }
 #ifdef FLOAT_EFFECT_CHAIN
@@ -766,6 +772,7 @@ void AudioFlinger::EffectModule::process()
                         sizeof(float),
                         sizeof(float)
                         * mInChannelCountRequested * mConfig.inputCfg.buffer.frameCount);
+                mBytesCopied += sizeof(float) * inChannelCount * mConfig.inputCfg.buffer.frameCount;
                 inBuffer = mInConversionBuffer;
             }
             if (mConfig.outputCfg.accessMode == EFFECT_BUFFER_ACCESS_ACCUMULATE
@@ -776,9 +783,21 @@ void AudioFlinger::EffectModule::process()
                         sizeof(float),
                         sizeof(float)
                         * mOutChannelCountRequested * mConfig.outputCfg.buffer.frameCount);
+                mBytesCopied +=
+                        sizeof(float) * outChannelCount * mConfig.outputCfg.buffer.frameCount;
                 outBuffer = mOutConversionBuffer;
             }
-            if (!mSupportsFloat) { // convert input to int16_t as effect doesn't support float.
+            if (mConvertInPlace) {
+                // The effect reads and writes int16_t in the first half of the float buffer,
+                // see updateInPlaceConversion().
+                memcpy_to_i16_from_float(
+                        inBuffer->audioBuffer()->s16,
+                        inBuffer->audioBuffer()->f32,
+                        inChannelCount * mConfig.inputCfg.buffer.frameCount);
+                mBytesCopied +=
+                        sizeof(int16_t) * inChannelCount * mConfig.inputCfg.buffer.frameCount;
+            } else if (!mSupportsFloat) {
+                // convert input to int16_t as effect doesn't support float.
                 if (!auxType) {
                     if (mInConversionBuffer == nullptr) {
                         ALOGW("%s: mInConversionBuffer is null, bypassing", __func__);
@@ -788,6 +807,8 @@ void AudioFlinger::EffectModule::process()
                             mInConversionBuffer->audioBuffer()->s16,
                             inBuffer->audioBuffer()->f32,
                             inChannelCount * mConfig.inputCfg.buffer.frameCount);
+                    mBytesCopied +=
+                            sizeof(int16_t) * inChannelCount * mConfig.inputCfg.buffer.frameCount;
                     inBuffer = mInConversionBuffer;
                 }
                 if (mConfig.outputCfg.accessMode == EFFECT_BUFFER_ACCESS_ACCUMULATE) {
@@ -799,13 +820,22 @@ void AudioFlinger::EffectModule::process()
                             mOutConversionBuffer->audioBuffer()->s16,
                             outBuffer->audioBuffer()->f32,
                             outChannelCount * mConfig.outputCfg.buffer.frameCount);
+                    mBytesCopied +=
+                            sizeof(int16_t) * outChannelCount * mConfig.outputCfg.buffer.frameCount;
                     outBuffer = mOutConversionBuffer;
                 }
             }
 #endif
             ret = mEffectInterface->process();
 #ifdef FLOAT_EFFECT_CHAIN
-            if (!mSupportsFloat) { // convert output int16_t back to float.
+            if (mConvertInPlace) {
+                memcpy_to_float_from_i16(
+                        mOutBuffer->audioBuffer()->f32,
+                        mOutBuffer->audioBuffer()->s16,
+                        outChannelCount * mConfig.outputCfg.buffer.frameCount);
+                mBytesCopied +=
+                        sizeof(float) * outChannelCount * mConfig.outputCfg.buffer.frameCount;
+            } else if (!mSupportsFloat) { // convert output int16_t back to float.
                 sp<EffectBufferHalInterface> target =
                         mOutChannelCountRequested != outChannelCount
                         ? mOutConversionBuffer : mOutBuffer;
@@ -814,12 +844,16 @@ void AudioFlinger::EffectModule::process()
                         target->audioBuffer()->f32,
                         mOutConversionBuffer->audioBuffer()->s16,
                         outChannelCount * mConfig.outputCfg.buffer.frameCount);
+                mBytesCopied +=
+                        sizeof(float) * outChannelCount * mConfig.outputCfg.buffer.frameCount;
             }
             if (mOutChannelCountRequested != outChannelCount) {
                 adjust_selected_channels(mOutConversionBuffer->audioBuffer()->f32, outChannelCount,
                         mOutBuffer->audioBuffer()->f32, mOutChannelCountRequested,
                         sizeof(float),
                         sizeof(float) * outChannelCount * mConfig.outputCfg.buffer.frameCount);
+                mBytesCopied += sizeof(float)
+                        * mOutChannelCountRequested * mConfig.outputCfg.buffer.frameCount;
             }
 #endif
         } else {
@@ -1381,6 +1415,7 @@ void AudioFlinger::EffectModule::setInBuffer(const sp<EffectBufferHalInterface>&
             ALOGE("%s cannot create mInConversionBuffer", __func__);
         }
     }
+    updateInPlaceConversion();
 #endif
 }
 
@@ -1425,9 +1460,53 @@ void AudioFlinger::EffectModule::setOutBuffer(const sp<EffectBufferHalInterface>
             ALOGE("%s cannot create mOutConversionBuffer", __func__);
         }
     }
+    updateInPlaceConversion();
 #endif
 }
 
+#ifdef FLOAT_EFFECT_CHAIN
+void AudioFlinger::EffectModule::updateInPlaceConversion()
+{
+    // An int16_t insert effect that overwrites its float input buffer does not need
+    // the conversion buffers: the input is converted to int16_t in place, the effect
+    // processes in place, and its output is expanded back to float in place.
+    // The conversion buffers are kept, so that we can switch back when the buffers change.
+    const bool auxType = (mDescriptor.flags & EFFECT_FLAG_TYPE_MASK) == EFFECT_FLAG_TYPE_AUXILIARY;
+    const bool inFormatMismatch = !mSupportsFloat
+            || mInChannelCountRequested
+                    != audio_channel_count_from_out_mask(mConfig.inputCfg.channels);
+    const bool outFormatMismatch = !mSupportsFloat
+            || mOutChannelCountRequested
+                    != audio_channel_count_from_out_mask(mConfig.outputCfg.channels);
+    const bool convertInPlace =
+#ifdef ZERO_COPY_EFFECT_CHAIN
+            !mSupportsFloat && !auxType
+            && mInBuffer != nullptr && mOutBuffer != nullptr
+            && mConfig.inputCfg.buffer.raw == mConfig.outputCfg.buffer.raw
+            && mInChannelCountRequested
+                    == audio_channel_count_from_out_mask(mConfig.inputCfg.channels)
+            && mOutChannelCountRequested
+                    == audio_channel_count_from_out_mask(mConfig.outputCfg.channels);
+#else
+            false;
+#endif
+    if (convertInPlace) {
+        mEffectInterface->setInBuffer(mInBuffer);
+        mEffectInterface->setOutBuffer(mOutBuffer);
+    } else if (mConvertInPlace) {
+        // restore the buffers that setInBuffer() and setOutBuffer() would have selected.
+        mEffectInterface->setInBuffer(!auxType && inFormatMismatch && mInConversionBuffer != nullptr
+                ? mInConversionBuffer : mInBuffer);
+        mEffectInterface->setOutBuffer(outFormatMismatch && mOutConversionBuffer != nullptr
+                ? mOutConversionBuffer : mOutBuffer);
+    }
+    if (convertInPlace != mConvertInPlace) {
+        ALOGV("%s: effect %d converts %s", __func__, mId, convertInPlace ? "in place" : "by copy");
+        mConvertInPlace = convertInPlace;
+    }
+}
+#endif
+
 status_t AudioFlinger::EffectModule::setVolume(uint32_t *left, uint32_t *right, bool controller)
 {
     AutoLockReentrant _l(mLock, mSetVolumeReentrantTid);
@@ -1700,6 +1779,11 @@ NO_THREAD_SAFETY_ANALYSIS  // conditional try lock
             mStatus, mEffectInterface.get());
 
     result.appendFormat("\t\t- data: %s\n", mSupportsFloat ? "float" : "int16");
+#ifdef FLOAT_EFFECT_CHAIN
+    result.appendFormat("\t\t- conversion: %s\n",
+            mSupportsFloat ? "none" : mConvertInPlace ? "in place" : "by copy");
+#endif
+    result.appendFormat("\t\t- bytes copied by last process: %zu\n", mBytesCopied);
 
     result.append("\t\t- Input configuration:\n");
     result.append("\t\t\tBuffer     Frames  Smp rate Channels Format\n");
@@ -2304,9 +2388,14 @@ void AudioFlinger::EffectChain::process_l()
         if (mInBuffer->audioBuffer()->raw != mOutBuffer->audioBuffer()->raw) {
             mOutBuffer->update();
         }
+        size_t bytesCopied = 0;
         for (size_t i = 0; i < size; i++) {
             mEffects[i]->process();
+            bytesCopied += mEffects[i]->bytesCopied();
         }
+        mBytesCopiedLast.store(bytesCopied, std::memory_order_relaxed);
+        mBytesCopiedTotal.fetch_add(bytesCopied, std::memory_order_relaxed);
+        mProcessedCycles.fetch_add(1, std::memory_order_relaxed);
         mInBuffer->commit();
         if (mInBuffer->audioBuffer()->raw != mOutBuffer->audioBuffer()->raw) {
             mOutBuffer->commit();
@@ -2723,6 +2812,12 @@ NO_THREAD_SAFETY_ANALYSIS  // conditional try lock
                 (int)outBufferStr.size(), "Out buffer      ");
         result.appendFormat("\t%s   %s   %d\n",
                 inBufferStr.c_str(), outBufferStr.c_str(), mActiveTrackCnt);
+        const uint64_t cycles = mProcessedCycles.load(std::memory_order_relaxed);
+        result.appendFormat("\tBytes copied per cycle: last %zu  mean %llu  (%llu cycles)\n",
+                mBytesCopiedLast.load(std::memory_order_relaxed),
+                (unsigned long long)(cycles > 0
+                        ? mBytesCopiedTotal.load(std::memory_order_relaxed) / cycles : 0),
+                (unsigned long long)cycles);
         write(fd, result.string(), result.size());
 
         for (size_t i = 0; i < numEffects; ++i) {
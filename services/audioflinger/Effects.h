@@ -289,6 +289,9 @@ public:
 
     void             dump(int fd, const Vector<String16>& args);
 
+    // Number of bytes copied, accumulated or format converted by the last process().
+    size_t           bytesCopied() const { return mBytesCopied; }
+
 private:
     friend class AudioFlinger;      // for mHandles
 
@@ -308,6 +311,12 @@ private:
 
     status_t setVolumeInternal(uint32_t *left, uint32_t *right, bool controller);
 
+#ifdef FLOAT_EFFECT_CHAIN
+    // Selects, after a change of buffers, whether the int16_t conversion is done in place
+    // in the float input / output buffer and points the HAL at the buffers accordingly.
+    void updateInPlaceConversion();
+#endif
+
 
     effect_config_t     mConfig;    // input and output audio configuration
     sp<EffectHalInterface> mEffectInterface; // Effect module HAL
@@ -329,7 +338,9 @@ private:
     sp<EffectBufferHalInterface> mOutConversionBuffer;
     uint32_t mInChannelCountRequested;
     uint32_t mOutChannelCountRequested;
+    bool    mConvertInPlace = false;  // int16_t effect processes in place in mInBuffer
 #endif
+    size_t  mBytesCopied = 0;       // written by process(), read by EffectChain::process_l()
 
     class AutoLockReentrant {
     public:
@@ -690,6 +701,10 @@ private:
     volatile int32_t mTrackCnt;          // number of tracks connected
 
              int32_t mTailBufferCount;   // current effect tail buffer count
+             // bytes copied or converted by the effects, written by process_l(), read by dump()
+             std::atomic<size_t> mBytesCopiedLast{0};    // in the last processed cycle
+             std::atomic<uint64_t> mBytesCopiedTotal{0}; // in all processed cycles
+             std::atomic<uint64_t> mProcessedCycles{0};
              int32_t mMaxTailBuffers;    // maximum effect tail buffers
              int mVolumeCtrlIdx;         // index of insert effect having control over volume
              uint32_t mLeftVolume;       // previous volume on left channel
@@ -78,6 +78,9 @@ void AudioFlinger::MelReporter::onFirstRef() {
     mAudioFlinger.mPatchCommandThread->addListener(this);
 
     mSoundDoseManager = sp<SoundDoseManager>::make(sp<IMelReporterCallback>::fromExisting(this));
+    // Optionally use one MEL processor for all the streams on a device.
+    mSoundDoseManager->setShareProcessorsPerDevice(
+            property_get_bool("af.sound_dose.share_processors", false /* default_value */));
 }
 
 void AudioFlinger::MelReporter::updateMetadataForCsd(audio_io_handle_t streamHandle,
@@ -273,9 +276,14 @@ NO_THREAD_SAFETY_ANALYSIS  // access of AudioFlinger::checkOutputThread_l
         }
     }
 
-    mSoundDoseManager->removeStreamProcessor(patch.streamHandle);
+    const bool processorShared = mSoundDoseManager->removeStreamProcessor(patch.streamHandle);
     if (outputThread != nullptr && !useHalSoundDoseInterface_l()) {
-        outputThread->stopMelComputation_l();
+        if (processorShared) {
+            // other streams still use the processor, only detach it from this thread
+            outputThread->startMelComputation_l(nullptr);
+        } else {
+            outputThread->stopMelComputation_l();
+        }
     }
 }
 
@@ -597,11 +597,30 @@ status_t AudioFlinger::PatchPanel::Patch::createConnections(PatchPanel *panel)
     // create a special playback track to render to playback thread.
     // this track is given the same buffer as the PatchRecord buffer
 
+    // When both threads run at the same PCM format, the record thread only copies into the
+    // patch buffer and a MixerThread can copy the patch buffer straight to its sink while the
+    // patch track is the only active track, see MixerThread::prepareTracks_l().
+    // Fast patch tracks are left to the FastMixer.
+    const bool useDirectBridge = !usePassthruPatchRecord
+            && (outputFlags & AUDIO_OUTPUT_FLAG_FAST) == 0
+            && mPlayback.thread()->type() == ThreadBase::MIXER
+            && audio_is_linear_pcm(format)
+            && format == inputFormat
+            && sampleRate == mRecord.thread()->sampleRate()
+            && inChannelMask == mRecord.thread()->channelMask();
+
     // Default behaviour is to start as soon as possible to have the lowest possible latency even if
     // it might glitch.
     // Disable this behavior for FM Tuner source if no fast capture/mixer available.
+    // A direct bridge has no resampler to feed, so two periods of the slower thread are enough
+    // rather than a quarter of the pseudo LCM buffer.
     const bool isFmBridge = mAudioPatch.sources[0].ext.device.type == AUDIO_DEVICE_IN_FM_TUNER;
-    const size_t frameCountToBeReady = isFmBridge && !usePassthruPatchRecord ? frameCount / 4 : 1;
+    size_t frameCountToBeReady = 1;
+    if (isFmBridge && !usePassthruPatchRecord) {
+        frameCountToBeReady = useDirectBridge ?
+                std::min(frameCount, 2 * std::max(playbackFrameCount, recordFrameCount)) :
+                frameCount / 4;
+    }
     sp<PlaybackThread::PatchTrack> tempPatchTrack = new PlaybackThread::PatchTrack(
                                            mPlayback.thread().get(),
                                            streamType,
@@ -613,7 +632,8 @@ status_t AudioFlinger::PatchPanel::Patch::createConnections(PatchPanel *panel)
                                            tempRecordTrack->bufferSize(),
                                            outputFlags,
                                            {} /*timeout*/,
-                                           frameCountToBeReady);
+                                           frameCountToBeReady,
+                                           useDirectBridge);
     status = mPlayback.checkTrack(tempPatchTrack.get());
     if (status != NO_ERROR) {
         return status;
@@ -730,6 +750,22 @@ String8 AudioFlinger::PatchPanel::Patch::dump(audio_patch_handle_t myHandle) con
     if (getLatencyMs(&latencyMs) == OK) {
         result.appendFormat("  latency: %.2lf ms", latencyMs);
     }
+
+    // Copies of each buffer between the source and sink HAL streams: the record thread reads
+    // into its own buffer and converts into the patch buffer, then the playback thread either
+    // copies the patch buffer to its sink buffer or mixes it and converts the mix.
+    auto playbackThread = mPlayback.const_thread();
+    auto playbackTrack = mPlayback.const_track();
+    if (isSoftware() && playbackThread.get() != nullptr && playbackTrack.get() != nullptr) {
+        const bool bridged = playbackTrack->isBridged();
+        const bool mixed = !bridged && playbackThread->type() != ThreadBase::DIRECT
+                && playbackThread->type() != ThreadBase::OFFLOAD;
+        result.appendFormat("  copies: %d direct bridge: %s (%lld of %lld frames)",
+                mixed ? 4 : 3,
+                !playbackTrack->isDirectBridge() ? "unavailable" : bridged ? "active" : "idle",
+                (long long)playbackTrack->bridgedFrames(),
+                (long long)playbackTrack->framesConsumed());
+    }
     return result;
 }
 
@@ -218,6 +218,8 @@ public:
     float getSpeed() const { return mSpeed; }
     bool isSpatialized() const override { return mIsSpatialized; }
     bool isBitPerfect() const override { return mIsBitPerfect; }
+    // true for a PatchTrack that MixerThread may copy straight to its sink, see PatchTrack.
+    virtual bool isDirectBridge() const { return false; }
 
     /**
      * Updates the mute state and notifies the audio service. Call this only when holding player
@@ -484,11 +486,24 @@ public:
                                    size_t frameCountToBeReady = 1 /** Default behaviour is to start
                                                                     *  as soon as possible to have
                                                                     *  the lowest possible latency
-                                                                    *  even if it might glitch. */);
+                                                                    *  even if it might glitch. */,
+                                   bool isDirectBridge = false);
     virtual             ~PatchTrack();
 
             size_t      framesReady() const override;
 
+    // A direct bridge track has the format, channel mask and sample rate of its MixerThread.
+    // While it is the only active track at unity volume, the thread copies it straight to
+    // the sink buffer instead of running the mixer.
+            bool        isDirectBridge() const override { return mIsDirectBridge; }
+            // called on the MixerThread for each buffer it copies or mixes
+            void        setBridged(bool bridged) { mBridged.store(bridged); }
+            void        addBridgedFrames(size_t frames) { mBridgedFrames += frames; }
+            // for the patch dump
+            bool        isBridged() const { return mBridged.load(); }
+            int64_t     bridgedFrames() const { return mBridgedFrames.load(); }
+            int64_t     framesConsumed() const { return Track::framesReleased(); }
+
     virtual status_t    start(AudioSystem::sync_event_t event =
                                     AudioSystem::SYNC_EVENT_NONE,
                              audio_session_t triggerSession = AUDIO_SESSION_NONE);
@@ -504,4 +519,8 @@ public:
 
 private:
             void restartIfDisabled();
+
+    const bool                  mIsDirectBridge;
+    std::atomic_bool            mBridged{false};
+    std::atomic<int64_t>        mBridgedFrames{0};
 };  // end of PatchTrack
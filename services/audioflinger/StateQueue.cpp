@@ -33,8 +33,9 @@ void StateQueueObserverDump::dump(int fd)
 
 void StateQueueMutatorDump::dump(int fd)
 {
-    dprintf(fd, "State queue mutator: pushDirty=%u pushAck=%u blockedSequence=%u\n",
-            mPushDirty, mPushAck, mBlockedSequence);
+    dprintf(fd, "State queue mutator: pushDirty=%u pushAck=%u blockedSequence=%u"
+            " pushMerged=%u\n",
+            mPushDirty, mPushAck, mBlockedSequence, mPushMerged);
 }
 #endif
 
@@ -43,12 +44,14 @@ void StateQueueMutatorDump::dump(int fd)
 template<typename T> StateQueue<T>::StateQueue() :
     mAck(NULL), mCurrent(NULL),
     mMutating(&mStates[0]), mExpecting(NULL),
-    mInMutation(false), mIsDirty(false), mIsInitialized(false)
+    mInMutation(false), mIsDirty(false), mIsInitialized(false),
+    mBatchDepth(0), mBatchBlock(BLOCK_NEVER), mBatchPushes(0)
 #ifdef STATE_QUEUE_DUMP
     , mObserverDump(&mObserverDummyDump), mMutatorDump(&mMutatorDummyDump)
 #endif
 {
     atomic_init(&mNext, static_cast<uintptr_t>(0));
+    atomic_init(&mPushMerged, 0u);
 }
 
 template<typename T> StateQueue<T>::~StateQueue()
@@ -99,6 +102,16 @@ template<typename T> bool StateQueue<T>::push(StateQueue<T>::block_t block)
 
     ALOG_ASSERT(!mInMutation, "push() called when in a mutation");
 
+    if (mBatchDepth > 0) {
+        if (block > mBatchBlock) {
+            mBatchBlock = block;
+        }
+        if (mIsDirty) {
+            ++mBatchPushes;
+        }
+        return true;
+    }
+
 #ifdef STATE_QUEUE_DUMP
     if (block == BLOCK_UNTIL_ACKED) {
         mMutatorDump->mPushAck++;
@@ -124,6 +137,8 @@ template<typename T> bool StateQueue<T>::push(StateQueue<T>::block_t block)
                     break;
                 }
                 if (block == BLOCK_NEVER) {
+                    // remains dirty, so this state will be squashed into the next push
+                    countMerged(1);
                     return false;
                 }
 #ifdef STATE_QUEUE_DUMP
@@ -185,6 +200,40 @@ template<typename T> bool StateQueue<T>::push(StateQueue<T>::block_t block)
     return true;
 }
 
+template<typename T> void StateQueue<T>::beginBatch()
+{
+    ALOG_ASSERT(!mInMutation, "beginBatch() called when in a mutation");
+    if (mBatchDepth++ == 0) {
+        mBatchBlock = BLOCK_NEVER;
+        mBatchPushes = 0;
+    }
+}
+
+template<typename T> bool StateQueue<T>::endBatch()
+{
+    ALOG_ASSERT(!mInMutation, "endBatch() called when in a mutation");
+    ALOG_ASSERT(mBatchDepth > 0, "endBatch() called when not in a batch");
+    if (--mBatchDepth > 0) {
+        return true;
+    }
+    // all but one of the deferred pushes were merged into the push below
+    if (mBatchPushes > 1) {
+        countMerged(mBatchPushes - 1);
+    }
+    return push(mBatchBlock);
+}
+
+template<typename T> void StateQueue<T>::countMerged(unsigned count)
+{
+    // only the mutator writes, so load and store need not be a single atomic operation
+    atomic_store_explicit(&mPushMerged,
+            atomic_load_explicit(&mPushMerged, memory_order_relaxed) + count,
+            memory_order_relaxed);
+#ifdef STATE_QUEUE_DUMP
+    mMutatorDump->mPushMerged += count;
+#endif
+}
+
 }   // namespace android
 
 // Hack to avoid explicit template instantiation of
@@ -112,13 +112,15 @@ struct StateQueueObserverDump {
 };
 
 struct StateQueueMutatorDump {
-    StateQueueMutatorDump() : mPushDirty(0), mPushAck(0), mBlockedSequence(0) { }
+    StateQueueMutatorDump() : mPushDirty(0), mPushAck(0), mBlockedSequence(0),
+            mPushMerged(0) { }
     /*virtual*/ ~StateQueueMutatorDump() { }
     unsigned    mPushDirty;       // incremented each time push() is called with a dirty state
     unsigned    mPushAck;         // incremented each time push(BLOCK_UNTIL_ACKED) is called
     unsigned    mBlockedSequence; // incremented before and after each time that push()
                                   // blocks for more than one PUSH_BLOCK_ACK_NS;
                                   // if odd, then mutator is currently blocked inside push()
+    unsigned    mPushMerged;      // incremented each time a dirty push is merged into a later one
     void        dump(int fd);
 };
 #endif
@@ -173,6 +175,28 @@ public:
     // Return whether the current state is dirty (modified and not pushed).
     bool    isDirty() const { return mIsDirty; }
 
+    // Batch APIs
+
+    // Begin a batch of mutations which are published to the observer as a single state.
+    // Until the matching endBatch(), push() does not publish anything and returns true;
+    // it only records the strongest block_t requested, and all mutations are squashed
+    // together in the mutating state.  Batches may be nested, and only the outermost
+    // endBatch() pushes.  Must not be called in the middle of a mutation.
+    void    beginBatch();
+
+    // End a batch, and push the squashed state with the strongest block_t passed to push()
+    // during the batch, or BLOCK_NEVER if push() was not called.  Returns as for push().
+    bool    endBatch();
+
+    // Return whether the mutator is currently inside a batch.
+    bool    isInBatch() const { return mBatchDepth > 0; }
+
+    // Number of pushes of a dirty state that were merged into a later push, either
+    // because the push was deferred by a batch, or because a BLOCK_NEVER push would block.
+    // May be called from any thread.
+    unsigned pushMerged() const
+            { return atomic_load_explicit(&mPushMerged, memory_order_relaxed); }
+
 #ifdef STATE_QUEUE_DUMP
     // Register location of observer dump area
     void    setObserverDump(StateQueueObserverDump *dump)
@@ -184,6 +208,8 @@ public:
 #endif
 
 private:
+    void    countMerged(unsigned count);
+
     static const unsigned kN = 4;       // values < 4 are not supported by this code
     T                 mStates[kN];      // written by mutator, read by observer
 
@@ -200,6 +226,10 @@ private:
     bool              mInMutation;      // whether we're currently in the middle of a mutation
     bool              mIsDirty;         // whether mutating state has been modified since last push
     bool              mIsInitialized;   // whether mutating state has been initialized yet
+    unsigned          mBatchDepth;      // nesting depth of beginBatch()
+    block_t           mBatchBlock;      // strongest block_t requested by push() in the batch
+    unsigned          mBatchPushes;     // number of dirty pushes deferred by the batch
+    atomic_uint       mPushMerged;      // written by mutator, read by any thread
 
 #ifdef STATE_QUEUE_DUMP
     StateQueueObserverDump  mObserverDummyDump; // default area for observer dump if not set
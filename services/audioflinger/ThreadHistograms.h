@@ -0,0 +1,198 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_AUDIO_THREADHISTOGRAMS_H
+#define ANDROID_AUDIO_THREADHISTOGRAMS_H
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <sstream>
+#include <string>
+
+namespace android {
+
+/**
+ * ThreadHistograms collects per-cycle timing of an AudioFlinger thread loop,
+ * split by stage, for dumpsys and mediametrics.
+ *
+ * For each stage there is a histogram of log2 microsecond buckets, and the
+ * most recent cycles are kept in a ring so that a glitch can be attributed to a stage.
+ *
+ * add() must be called from a single thread, the thread loop, and is wait-free:
+ * it does not lock and does not allocate.  All other methods may be called from any
+ * thread.  The histogram counters are individually atomic, but a reader may see
+ * a cycle partially added; the ring entries are not atomic and may be inconsistent
+ * while a reader copies them, similar to FastThreadDumpState.
+ */
+class ThreadHistograms final {
+public:
+    enum Stage {
+        STAGE_PROCESS,          // mix or capture processing, from end of last I/O to next I/O
+        STAGE_SLEEP_OVERRUN,    // time slept beyond the requested sleep time
+        STAGE_IO,               // HAL write or read
+        STAGE_EFFECTS,          // effect chain processing
+        STAGE_COUNT,
+    };
+
+    static const char *stageToString(Stage stage) {
+        switch (stage) {
+        case STAGE_PROCESS:       return "process";
+        case STAGE_SLEEP_OVERRUN: return "sleepOverrun";
+        case STAGE_IO:            return "io";
+        case STAGE_EFFECTS:       return "effects";
+        default:                  return "unknown";
+        }
+    }
+
+    // Bucket 0 counts durations < 1 us, bucket b counts [2^(b-1), 2^b) us,
+    // and the last bucket counts everything longer.
+    static constexpr size_t kBuckets = 20;     // last bucket starts at 2^18 us, about 262 ms
+    static constexpr size_t kRingSize = 64;    // number of most recent cycles kept
+
+    // Stage durations of one thread loop cycle; negative values mean the stage did not run.
+    struct Cycle {
+        Cycle() { ns.fill(-1); }
+        std::array<int64_t, STAGE_COUNT> ns;
+    };
+
+    struct Summary {
+        int64_t count = 0;
+        int64_t totalNs = 0;
+        int64_t maxNs = 0;
+        double  meanMs() const { return count > 0 ? totalNs * 1e-6 / count : 0.; }
+        double  maxMs() const { return maxNs * 1e-6; }
+    };
+
+    void add(const Cycle& cycle) {
+        bool any = false;
+        for (size_t s = 0; s < STAGE_COUNT; ++s) {
+            const int64_t ns = cycle.ns[s];
+            if (ns < 0) continue;
+            any = true;
+            StageHistogram &h = mStages[s];
+            increment(h.buckets[bucketOf(ns)], 1);
+            increment(h.count, 1);
+            increment(h.totalNs, ns);
+            if (ns > h.maxNs.load(std::memory_order_relaxed)) {
+                h.maxNs.store(ns, std::memory_order_relaxed);
+            }
+        }
+        if (!any) return;
+        const uint64_t index = mRingCount.load(std::memory_order_relaxed);
+        mRing[index % kRingSize] = cycle;
+        mRingCount.store(index + 1, std::memory_order_release);
+    }
+
+    Summary summary(Stage stage) const {
+        const StageHistogram &h = mStages[stage];
+        Summary summary;
+        summary.count = h.count.load(std::memory_order_relaxed);
+        summary.totalNs = h.totalNs.load(std::memory_order_relaxed);
+        summary.maxNs = h.maxNs.load(std::memory_order_relaxed);
+        return summary;
+    }
+
+    // Upper bound in ms of the bucket containing the given percentile, or 0 if empty.
+    double percentileMs(Stage stage, double percentile) const {
+        const StageHistogram &h = mStages[stage];
+        std::array<int64_t, kBuckets> counts;
+        int64_t total = 0;
+        for (size_t b = 0; b < kBuckets; ++b) {
+            counts[b] = h.buckets[b].load(std::memory_order_relaxed);
+            total += counts[b];
+        }
+        if (total == 0) return 0.;
+        const int64_t target = std::max((int64_t)1, (int64_t)(total * percentile / 100.));
+        int64_t sum = 0;
+        for (size_t b = 0; b < kBuckets - 1; ++b) {
+            sum += counts[b];
+            if (sum >= target) return (1LL << b) * 1e-3;
+        }
+        return h.maxNs.load(std::memory_order_relaxed) * 1e-6;
+    }
+
+    // A human readable dump, each line prefixed by prefix.
+    std::string toString(const std::string& prefix) const {
+        std::stringstream ss;
+        ss << prefix << "Cycle histograms (us, log2 buckets: <1,<2,<4,...):\n";
+        for (size_t s = 0; s < STAGE_COUNT; ++s) {
+            const Summary sum = summary((Stage)s);
+            ss << prefix << "  " << stageToString((Stage)s)
+                    << ": count " << sum.count
+                    << " mean(ms) " << sum.meanMs()
+                    << " p99(ms) <= " << percentileMs((Stage)s, 99.)
+                    << " max(ms) " << sum.maxMs() << "\n";
+            if (sum.count == 0) continue;
+            ss << prefix << "   ";
+            size_t last = kBuckets;
+            while (last > 0 && mStages[s].buckets[last - 1].load(std::memory_order_relaxed) == 0) {
+                --last;
+            }
+            for (size_t b = 0; b < last; ++b) {
+                ss << " " << mStages[s].buckets[b].load(std::memory_order_relaxed);
+            }
+            ss << "\n";
+        }
+
+        const uint64_t ringCount = mRingCount.load(std::memory_order_acquire);
+        const size_t n = std::min(ringCount, (uint64_t)kRingSize);
+        if (n > 0) {
+            ss << prefix << "Last " << n << " cycles (us), oldest first, - if not run:\n";
+            for (size_t s = 0; s < STAGE_COUNT; ++s) {
+                ss << prefix << "  " << stageToString((Stage)s) << ":";
+                for (uint64_t i = ringCount - n; i < ringCount; ++i) {
+                    const int64_t ns = mRing[i % kRingSize].ns[s];
+                    if (ns < 0) {
+                        ss << " -";
+                    } else {
+                        ss << " " << ns / 1000;
+                    }
+                }
+                ss << "\n";
+            }
+        }
+        return ss.str();
+    }
+
+private:
+    static void increment(std::atomic<int64_t>& value, int64_t delta) {
+        // single writer, so a load and a store are sufficient.
+        value.store(value.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+    }
+
+    static size_t bucketOf(int64_t ns) {
+        const uint64_t us = ns / 1000;
+        if (us == 0) return 0;
+        const size_t b = 64 - __builtin_clzll(us);   // us in [2^(b-1), 2^b)
+        return std::min(b, kBuckets - 1);
+    }
+
+    struct StageHistogram {
+        std::array<std::atomic<int64_t>, kBuckets> buckets{};
+        std::atomic<int64_t> count{0};
+        std::atomic<int64_t> totalNs{0};
+        std::atomic<int64_t> maxNs{0};
+    };
+
+    std::array<StageHistogram, STAGE_COUNT> mStages;
+    std::array<Cycle, kRingSize> mRing;
+    std::atomic<uint64_t> mRingCount{0};    // total cycles added to mRing
+};
+
+} // namespace android
+
+#endif // ANDROID_AUDIO_THREADHISTOGRAMS_H
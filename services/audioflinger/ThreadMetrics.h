@@ -128,6 +128,23 @@ public:
         mUnderrunFrames += frames;
     }
 
+    // Logs the mean, 99th percentile upper bound and maximum of each thread loop stage.
+    void logCycleHistograms(const ThreadHistograms& histograms) const {
+        mediametrics::LogItem item(mMetricsId);
+        for (size_t s = 0; s < ThreadHistograms::STAGE_COUNT; ++s) {
+            const auto stage = (ThreadHistograms::Stage)s;
+            const ThreadHistograms::Summary summary = histograms.summary(stage);
+            if (summary.count == 0) continue;
+            const std::string prefix = std::string(AMEDIAMETRICS_PROP_PREFIX_CYCLE)
+                    + ThreadHistograms::stageToString(stage) + ".";
+            // ms units always double
+            item.set((prefix + "meanMs").c_str(), summary.meanMs())
+                .set((prefix + "p99Ms").c_str(), histograms.percentileMs(stage, 99.))
+                .set((prefix + "maxMs").c_str(), summary.maxMs());
+        }
+        item.record();
+    }
+
     const std::string& getMetricsId() const {
         return mMetricsId;
     }
@@ -21,6 +21,7 @@
 #define ATRACE_TAG ATRACE_TAG_AUDIO
 
 #include "Configuration.h"
+#include <algorithm>
 #include <math.h>
 #include <fcntl.h>
 #include <memory>
@@ -170,6 +171,9 @@ static const uint32_t kMinNormalSinkBufferSizeMs = 20;
 // maximum normal sink buffer size
 static const uint32_t kMaxNormalSinkBufferSizeMs = 24;
 
+// default limit of the latency added by af.spatializer.block_frames, see readOutputParameters_l()
+static const uint32_t kDefaultSpatializerBlockLatencyMs = 10;
+
 // minimum capture buffer size in milliseconds to _not_ need a fast capture thread
 // FIXME This should be based on experimentally observed scheduling jitter
 static const uint32_t kMinNormalCaptureBufferSizeMs = 12;
@@ -305,6 +309,37 @@ static void sFastTrackMultiplierInit()
     }
 }
 
+// Optionally split the normal mix of large track groups across worker threads,
+// see AudioMixerBase::setParallelMix().  Disabled unless af.mixer.parallel_workers > 0.
+static void configureParallelMix(AudioMixer *mixer, size_t frameCount, uint32_t sampleRate)
+{
+    const int32_t workerCount = property_get_int32("af.mixer.parallel_workers", 0);
+    if (workerCount <= 0 || sampleRate == 0) {
+        return;
+    }
+    const int32_t minTracksPerJob = property_get_int32("af.mixer.parallel_min_tracks", 8);
+
+    // optional comma separated list of CPUs the workers are pinned to, e.g. "4,5,6"
+    std::vector<int> cpus;
+    char value[PROPERTY_VALUE_MAX];
+    if (property_get("af.mixer.parallel_cpus", value, NULL) > 0) {
+        char *saveptr = nullptr;
+        for (char *token = strtok_r(value, ",", &saveptr); token != nullptr;
+                token = strtok_r(nullptr, ",", &saveptr)) {
+            char *endptr;
+            const long cpu = strtol(token, &endptr, 10);
+            if (*endptr == '\0' && cpu >= 0 && cpu < CPU_SETSIZE) {
+                cpus.push_back((int)cpu);
+            }
+        }
+    }
+
+    // Fall back to inline mixing when a parallel mix takes more than half of the mix period,
+    // leaving the remainder of the period for effects and the HAL write.
+    const int64_t deadlineNs = (int64_t)frameCount * NANOS_PER_SECOND / sampleRate / 2;
+    mixer->setParallelMix(workerCount, minTracksPerJob, deadlineNs, cpus);
+}
+
 // ----------------------------------------------------------------------------
 
 #ifdef ADD_BATTERY_DATA
@@ -970,9 +1005,12 @@ NO_THREAD_SAFETY_ANALYSIS  // conditional try lock
 
     // --all does the statistics
     bool dumpAll = false;
+    bool dumpHistograms = false;
     for (const auto &arg : args) {
         if (arg == String16("--all")) {
             dumpAll = true;
+        } else if (arg == String16("--histograms")) {
+            dumpHistograms = true;
         }
     }
     if (dumpAll || type() == SPATIALIZER) {
@@ -981,6 +1019,11 @@ NO_THREAD_SAFETY_ANALYSIS  // conditional try lock
             (void)write(fd, sched.c_str(), sched.size());
         }
     }
+    // no lock needed, the histograms are written by the threadLoop without locks.
+    if (dumpAll || dumpHistograms) {
+        const std::string histograms = mCycleHistograms.toString("  " /* prefix */);
+        (void)write(fd, histograms.c_str(), histograms.size());
+    }
 }
 
 void AudioFlinger::ThreadBase::dumpBase_l(int fd, const Vector<String16>& args __unused)
@@ -2025,6 +2068,8 @@ void AudioFlinger::ThreadBase::sendStatistics(bool force)
     }
 
     item->selfrecord();
+
+    mThreadMetrics.logCycleHistograms(mCycleHistograms);
 }
 
 product_strategy_t AudioFlinger::ThreadBase::getStrategyForStream(audio_stream_type_t stream) const
@@ -3151,6 +3196,24 @@ void AudioFlinger::PlaybackThread::readOutputParameters_l()
         } else {
             multiplier = floor(multiplier);
         }
+    } else if (mType == SPATIALIZER) {
+        // Optionally run the spatializer on blocks of at least af.spatializer.block_frames
+        // (e.g. 256) when the HAL period is smaller, as some spatializer implementations
+        // are much more efficient on larger blocks. The thread then writes several HAL
+        // periods at once and the HAL buffer absorbs the extra periods, so the added latency
+        // is (multiplier - 1) HAL periods, limited to af.spatializer.block_latency_ms.
+        const int32_t blockFrames = property_get_int32("af.spatializer.block_frames", 0);
+        if (blockFrames > 0 && (size_t)blockFrames > mFrameCount) {
+            const int32_t latencyMs = property_get_int32("af.spatializer.block_latency_ms",
+                    kDefaultSpatializerBlockLatencyMs);
+            const size_t maxAddedFrames = std::max(latencyMs, 0) * (size_t)mSampleRate / 1000;
+            const size_t periods = std::min((blockFrames + mFrameCount - 1) / mFrameCount,
+                    1 + maxAddedFrames / mFrameCount);
+            multiplier = (double)periods;
+            ALOGI("%s: spatializer block %zu frames for requested %d frames, "
+                    "added latency %zu frames within budget %d ms", __func__,
+                    periods * mFrameCount, blockFrames, (periods - 1) * mFrameCount, latencyMs);
+        }
     }
     mNormalFrameCount = multiplier * mFrameCount;
     // round up to nearest 16 frames to satisfy AudioMixer
@@ -3910,6 +3973,8 @@ NO_THREAD_SAFETY_ANALYSIS  // manual locking of AudioFlinger
 
         cpuStats.sample(myName);
 
+        ThreadHistograms::Cycle cycle; // stage durations of this loop, see mCycleHistograms
+
         Vector< sp<EffectChain> > effectChains;
         audio_session_t activeHapticSessionId = AUDIO_SESSION_NONE;
         bool isHapticSessionSpatialized = false;
@@ -4210,6 +4275,7 @@ NO_THREAD_SAFETY_ANALYSIS  // manual locking of AudioFlinger
 
             // only process effects if we're going to write
             if (mSleepTimeUs == 0 && mType != OFFLOAD && mType != DIRECT) {
+                const int64_t effectsBeginNs = effectChains.isEmpty() ? 0 : systemTime();
                 for (size_t i = 0; i < effectChains.size(); i ++) {
                     effectChains[i]->process_l();
                     // TODO: Write haptic data directly to sink buffer when mixing.
@@ -4234,6 +4300,9 @@ NO_THREAD_SAFETY_ANALYSIS  // manual locking of AudioFlinger
                                 EFFECT_BUFFER_FORMAT, mNormalFrameCount * mHapticChannelCount);
                     }
                 }
+                if (!effectChains.isEmpty()) {
+                    cycle.ns[ThreadHistograms::STAGE_EFFECTS] = systemTime() - effectsBeginNs;
+                }
             }
         }
         // Process effect chains for offloaded thread even if no audio
@@ -4325,6 +4394,7 @@ NO_THREAD_SAFETY_ANALYSIS  // manual locking of AudioFlinger
                     const int64_t lastIoBeginNs = systemTime();
                     ret = threadLoop_write();
                     const int64_t lastIoEndNs = systemTime();
+                    cycle.ns[ThreadHistograms::STAGE_IO] = lastIoEndNs - lastIoBeginNs;
                     if (ret < 0) {
                         mBytesRemaining = 0;
                     } else if (ret > 0) {
@@ -4346,6 +4416,8 @@ NO_THREAD_SAFETY_ANALYSIS  // manual locking of AudioFlinger
                                                 {0, 0} /* lastTimestamp */, mSampleRate);
                                 const double processMs =
                                        (lastIoBeginNs - mLastIoEndNs) * 1e-6;
+                                cycle.ns[ThreadHistograms::STAGE_PROCESS] =
+                                        lastIoBeginNs - mLastIoEndNs;
 
                                 Mutex::Autolock _l(mLock);
                                 mIoJitterMs.add(jitterMs);
@@ -4474,13 +4546,20 @@ NO_THREAD_SAFETY_ANALYSIS  // manual locking of AudioFlinger
                 }
 
                 if (!mSignalPending && mConfigEvents.isEmpty() && !exitPending()) {
-                    mWaitWorkCV.waitRelative(mLock, microseconds((nsecs_t)mSleepTimeUs));
+                    const nsecs_t sleepRequestNs = microseconds((nsecs_t)mSleepTimeUs);
+                    const nsecs_t sleepBeginNs = systemTime();
+                    mWaitWorkCV.waitRelative(mLock, sleepRequestNs);
+                    // an early wakeup by signal counts as no overrun.
+                    cycle.ns[ThreadHistograms::STAGE_SLEEP_OVERRUN] =
+                            std::max((nsecs_t)0, systemTime() - sleepBeginNs - sleepRequestNs);
                 }
 
                 ATRACE_END();
             }
         }
 
+        mCycleHistograms.add(cycle);
+
         // Finally let go of removed track(s), without the lock held
         // since we can't guarantee the destructors won't acquire that
         // same lock.  This will also mutate and push a new fast mixer state.
@@ -4924,6 +5003,7 @@ AudioFlinger::MixerThread::MixerThread(const sp<AudioFlinger>& audioFlinger, Aud
             mSampleRate, mChannelMask, mChannelCount, mFormat, mFrameSize, mFrameCount,
             mNormalFrameCount);
     mAudioMixer = new AudioMixer(mNormalFrameCount, mSampleRate);
+    configureParallelMix(mAudioMixer, mNormalFrameCount, mSampleRate);
 
     if (type == DUPLICATING) {
         // The Duplicating thread uses the AudioMixer and delivers data to OutputTracks
@@ -5283,8 +5363,12 @@ void AudioFlinger::PlaybackThread::onAsyncError()
 
 void AudioFlinger::MixerThread::threadLoop_mix()
 {
-    // mix buffers...
-    mAudioMixer->process();
+    if (mBridgeTrack != 0) {
+        threadLoop_copyBridgeTrack();
+    } else {
+        // mix buffers...
+        mAudioMixer->process();
+    }
     mCurrentWriteLength = mSinkBufferSize;
     // increase sleep time progressively when application underrun condition clears.
     // Only increase sleep time if the mixer is ready for two consecutive times to avoid
@@ -5299,6 +5383,30 @@ void AudioFlinger::MixerThread::threadLoop_mix()
 
 }
 
+void AudioFlinger::MixerThread::threadLoop_copyBridgeTrack()
+{
+    // The track has the sink format, so its buffer is copied as is. As in the mixer,
+    // a short read is completed with silence and tallied as underrun by the track.
+    size_t framesCopied = 0;
+    while (framesCopied < mNormalFrameCount) {
+        AudioBufferProvider::Buffer buffer;
+        buffer.frameCount = mNormalFrameCount - framesCopied;
+        if (mBridgeTrack->getNextBuffer(&buffer) != NO_ERROR || buffer.frameCount == 0) {
+            break;
+        }
+        memcpy((uint8_t *)mSinkBuffer + framesCopied * mFrameSize, buffer.raw,
+                buffer.frameCount * mFrameSize);
+        framesCopied += buffer.frameCount;
+        mBridgeTrack->releaseBuffer(&buffer);
+    }
+    if (framesCopied < mNormalFrameCount) {
+        memset((uint8_t *)mSinkBuffer + framesCopied * mFrameSize, 0,
+                (mNormalFrameCount - framesCopied) * mFrameSize);
+    }
+    mBridgeTrack->addBridgedFrames(framesCopied);
+    mBridgeTrack.clear();
+}
+
 void AudioFlinger::MixerThread::threadLoop_sleepTime()
 {
     // If no tracks are ready, sleep once for the duration of an output
@@ -5374,6 +5482,8 @@ AudioFlinger::PlaybackThread::mixer_state AudioFlinger::MixerThread::prepareTrac
     // counts only _active_ fast tracks
     size_t fastTracks = 0;
     uint32_t resetMask = 0; // bit mask of fast tracks that need to be reset
+    // direct bridge track that may be copied to the sink without mixing
+    sp<PatchTrack> bridgeTrack;
 
     float masterVolume = mMasterVolume;
     bool masterMute = mMasterMute;
@@ -5398,6 +5508,8 @@ AudioFlinger::PlaybackThread::mixer_state AudioFlinger::MixerThread::prepareTrac
     bool coldIdle = false;
     if (mFastMixer != 0) {
         sq = mFastMixer->sq();
+        // All fast track changes of this pass are published to the FastMixer as one state.
+        sq->beginBatch();
         state = sq->begin();
         coldIdle = state->mCommand == FastMixerState::COLD_IDLE;
     }
@@ -5821,6 +5933,8 @@ AudioFlinger::PlaybackThread::mixer_state AudioFlinger::MixerThread::prepareTrac
                 vaf = v * sendLevel * (1. / MAX_GAIN_INT);
             }
 
+            float prevVolumeLeft, prevVolumeRight;
+            track->getFinalVolume(&prevVolumeLeft, &prevVolumeRight);
             track->setFinalVolume(vrf, vlf);
 
             // Delegate volume control to effect in track effect chain if needed
@@ -5840,6 +5954,28 @@ AudioFlinger::PlaybackThread::mixer_state AudioFlinger::MixerThread::prepareTrac
                 track->mHasVolumeController = false;
             }
 
+            // A direct bridge track can skip the mixer if it is the only active track and
+            // the mixer would neither convert nor scale it. Unity volume is required for this
+            // and the previous buffer, so that no volume ramp is skipped.
+            if (track->isDirectBridge()) {
+                sp<PatchTrack> patchTrack = static_cast<PatchTrack*>(track);
+                patchTrack->setBridged(false);
+                if (count == 1 && chain == 0
+                        && (track->mainBuffer() == mSinkBuffer
+                                || track->mainBuffer() == mMixerBuffer)
+                        && track->auxBuffer() == nullptr
+                        && track->format() == mFormat
+                        && track->channelMask() == mChannelMask
+                        && proxy->getSampleRate() == mSampleRate
+                        && isAudioPlaybackRateEqual(playbackRate, AUDIO_PLAYBACK_RATE_DEFAULT)
+                        && vlf == GAIN_FLOAT_UNITY && vrf == GAIN_FLOAT_UNITY
+                        && prevVolumeLeft == GAIN_FLOAT_UNITY
+                        && prevVolumeRight == GAIN_FLOAT_UNITY
+                        && mAudioMixer->getUnreleasedFrames(trackId) == 0) {
+                    bridgeTrack = patchTrack;
+                }
+            }
+
             // XXX: these things DON'T need to be done each time
             mAudioMixer->setBufferProvider(trackId, track);
             mAudioMixer->enable(trackId);
@@ -6071,6 +6207,7 @@ AudioFlinger::PlaybackThread::mixer_state AudioFlinger::MixerThread::prepareTrac
         // This occurs with BT suspend when we idle the FastMixer with
         // active tracks, which may be added or removed.
         sq->push(coldIdle ? FastMixerStateQueue::BLOCK_NEVER : block);
+        sq->endBatch();
     }
 #ifdef AUDIO_WATCHDOG
     if (pauseAudioWatchdog && mAudioWatchdog != 0) {
@@ -6108,6 +6245,17 @@ AudioFlinger::PlaybackThread::mixer_state AudioFlinger::MixerThread::prepareTrac
         mEffectBufferValid = true;
     }
 
+    // The bridge track is copied to mSinkBuffer by threadLoop_mix(), so there is no mixer
+    // output. Post-mix processing of the mixer buffer must not be needed either.
+    mBridgeTrack.clear();
+    if (bridgeTrack != 0 && mType == MIXER && mixerStatus == MIXER_TRACKS_READY
+            && !mEffectBufferValid && mHapticChannelCount == 0 && !requireMonoBlend()
+            && (hasFastMixer() || mMasterBalance.load() == 0.f)) {
+        mBridgeTrack = bridgeTrack;
+        mBridgeTrack->setBridged(true);
+        mMixerBufferValid = false;
+    }
+
     if (mEffectBufferValid) {
         // as long as there are effects we should clear the effects buffer, to avoid
         // passing a non-clean buffer to the effect chain
@@ -6271,6 +6419,7 @@ bool AudioFlinger::MixerThread::checkForNewParameter_l(const String8& keyValuePa
             readOutputParameters_l();
             delete mAudioMixer;
             mAudioMixer = new AudioMixer(mNormalFrameCount, mSampleRate);
+            configureParallelMix(mAudioMixer, mNormalFrameCount, mSampleRate);
             for (const auto &track : mTracks) {
                 const int trackId = track->id();
                 const status_t createStatus = mAudioMixer->create(
@@ -6297,6 +6446,7 @@ void AudioFlinger::MixerThread::dumpInternals_l(int fd, const Vector<String16>&
     PlaybackThread::dumpInternals_l(fd, args);
     dprintf(fd, "  Thread throttle time (msecs): %u\n", mThreadThrottleTimeMs);
     dprintf(fd, "  AudioMixer tracks: %s\n", mAudioMixer->trackNames().c_str());
+    dprintf(fd, "  AudioMixer parallel mix: %s", mAudioMixer->parallelMixToString().c_str());
     dprintf(fd, "  Master mono: %s\n", mMasterMono ? "on" : "off");
     dprintf(fd, "  Master balance: %f (%s)\n", mMasterBalance.load(),
             (hasFastMixer() ? std::to_string(mFastMixer->getMasterBalance())
@@ -6311,6 +6461,7 @@ void AudioFlinger::MixerThread::dumpInternals_l(int fd, const Vector<String16>&
         const std::unique_ptr<FastMixerDumpState> copy =
                 std::make_unique<FastMixerDumpState>(mFastMixerDumpState);
         copy->dump(fd);
+        dprintf(fd, "  FastMixer state pushes merged: %u\n", mFastMixer->sq()->pushMerged());
 
 #ifdef STATE_QUEUE_DUMP
         // Similar for state queue
@@ -8105,6 +8256,8 @@ reacquire_wakelock:
 
     // loop while there is work to do
     for (int64_t loopCount = 0;; ++loopCount) {  // loopCount used for statistics tracking
+        ThreadHistograms::Cycle cycle; // stage durations of this loop, see mCycleHistograms
+
         Vector< sp<EffectChain> > effectChains;
 
         // activeTracks accumulates a copy of a subset of mActiveTracks
@@ -8132,7 +8285,13 @@ reacquire_wakelock:
             // sleep with mutex unlocked
             if (sleepUs > 0) {
                 ATRACE_BEGIN("sleepC");
-                mWaitWorkCV.waitRelative(mLock, microseconds((nsecs_t)sleepUs));
+                const nsecs_t sleepRequestNs = microseconds((nsecs_t)sleepUs);
+                const nsecs_t sleepBeginNs = systemTime();
+                mWaitWorkCV.waitRelative(mLock, sleepRequestNs);
+                // an early wakeup by signal counts as no overrun.
+                cycle.ns[ThreadHistograms::STAGE_SLEEP_OVERRUN] =
+                        std::max((nsecs_t)0, systemTime() - sleepBeginNs - sleepRequestNs);
+                mCycleHistograms.add(cycle);
                 ATRACE_END();
                 sleepUs = 0;
                 continue;
@@ -8271,9 +8430,13 @@ reacquire_wakelock:
         // thread mutex is now unlocked, mActiveTracks unknown, activeTracks.size() > 0
 
         size_t size = effectChains.size();
-        for (size_t i = 0; i < size; i++) {
-            // thread mutex is not locked, but effect chain is locked
-            effectChains[i]->process_l();
+        if (size > 0) {
+            const int64_t effectsBeginNs = systemTime();
+            for (size_t i = 0; i < size; i++) {
+                // thread mutex is not locked, but effect chain is locked
+                effectChains[i]->process_l();
+            }
+            cycle.ns[ThreadHistograms::STAGE_EFFECTS] = systemTime() - effectsBeginNs;
         }
 
         // Push a new fast capture state if fast capture is not already running, or cblk change
@@ -8402,6 +8565,7 @@ reacquire_wakelock:
         }
 
         const int64_t lastIoEndNs = systemTime(); // end IO timing
+        cycle.ns[ThreadHistograms::STAGE_IO] = lastIoEndNs - lastIoBeginNs;
 
         // Update server timestamp with server stats
         // systemTime() is optional if the hardware supports timestamps.
@@ -8481,6 +8645,12 @@ reacquire_wakelock:
         }
         mRsmpInRear = audio_utils::safe_add_overflow(mRsmpInRear, (int32_t)framesRead);
 
+        // convert once for each group of tracks sharing a destination configuration
+        updateConversionGroups(activeTracks);
+        for (const auto& group : mConversionGroups) {
+            group->convert();
+        }
+
         size = activeTracks.size();
 
         // loop over each active track
@@ -8492,6 +8662,9 @@ reacquire_wakelock:
                 continue;
             }
 
+            // tracks in a conversion group copy already converted data
+            ConversionGroup * const conversionGroup = getConversionGroup(activeTrack);
+
             // TODO: This code probably should be moved to RecordTrack.
             // TODO: Update the activeTrack buffer converter in case of reconfigure.
 
@@ -8513,7 +8686,11 @@ reacquire_wakelock:
                 // if the record track isn't draining fast enough.
                 bool hasOverrun;
                 size_t framesIn;
-                activeTrack->mResamplerBufferProvider->sync(&framesIn, &hasOverrun);
+                if (conversionGroup != nullptr) {
+                    conversionGroup->sync(activeTrack, &framesIn, &hasOverrun);
+                } else {
+                    activeTrack->mResamplerBufferProvider->sync(&framesIn, &hasOverrun);
+                }
                 if (hasOverrun) {
                     overrun = OVERRUN_TRUE;
                 }
@@ -8525,11 +8702,17 @@ reacquire_wakelock:
                 // from framesIn.
                 // This isn't strictly necessary but helps limit buffer resizing in
                 // RecordBufferConverter.  TODO: remove when no longer needed.
-                framesOut = min(framesOut,
+                // framesIn of a conversion group is already in destination frames.
+                framesOut = min(framesOut, conversionGroup != nullptr ? framesIn :
                         destinationFramesPossible(
                                 framesIn, mSampleRate, activeTrack->mSampleRate));
 
-                if (activeTrack->isDirect()) {
+                if (conversionGroup != nullptr) {
+                    framesOut = conversionGroup->read(
+                            activeTrack, activeTrack->mSink.raw, framesOut);
+                    // keep the track position current for getOldestFront_l()
+                    activeTrack->mResamplerBufferProvider->setFront(conversionGroup->getFront());
+                } else if (activeTrack->isDirect()) {
                     // No RecordBufferConverter used for direct streams. Pass
                     // straight from RecordThread buffer to RecordTrack buffer.
                     AudioBufferProvider::Buffer buffer;
@@ -8636,6 +8819,7 @@ unlock:
                     {framesRead, readPeriodNs},
                     {0, 0} /* lastTimestamp */, mSampleRate);
             const double processMs = (lastIoBeginNs - mLastIoEndNs) * 1e-6;
+            cycle.ns[ThreadHistograms::STAGE_PROCESS] = lastIoBeginNs - mLastIoEndNs;
 
             Mutex::Autolock _l(mLock);
             mIoJitterMs.add(jitterMs);
@@ -8645,6 +8829,7 @@ unlock:
         mLastIoBeginNs = lastIoBeginNs;
         mLastIoEndNs = lastIoEndNs;
         lastLoopCountRead = loopCount;
+        mCycleHistograms.add(cycle);
     }
 
     standbyIfNotAlreadyInStandby();
@@ -9237,6 +9422,9 @@ void AudioFlinger::RecordThread::dumpInternals_l(int fd, const Vector<String16>&
 
     dprintf(fd, "  Fast capture thread: %s\n", hasFastCapture() ? "yes" : "no");
     dprintf(fd, "  Fast track available: %s\n", mFastTrackAvail ? "yes" : "no");
+    dprintf(fd, "  Shared conversion groups: %zu (%zu tracks)\n",
+            mConversionGroupCount.load(std::memory_order_relaxed),
+            mConversionGroupMembers.load(std::memory_order_relaxed));
 
     // Make a non-atomic copy of fast capture dump state so it won't change underneath us
     // while we are dumping it.  It may be inconsistent, but it won't mutate!
@@ -9416,6 +9604,259 @@ void AudioFlinger::RecordThread::ResamplerBufferProvider::releaseBuffer(
     buffer->frameCount = 0;
 }
 
+AudioFlinger::RecordThread::ConversionGroup::ConversionGroup(
+        RecordThread *recordThread, const sp<RecordTrack>& track)
+    :   mRecordThread(recordThread),
+        mFormat(track->format()),
+        mChannelMask(track->channelMask()),
+        mSampleRate(track->mSampleRate),
+        mFrameSize(track->frameSize()),
+        mRecordBufferConverter(new RecordBufferConverter(
+                recordThread->mChannelMask, recordThread->mFormat, recordThread->mSampleRate,
+                mChannelMask, mFormat, mSampleRate)),
+        // continue from the position of the first member, so that it does not skip data
+        mRsmpInFront(track->mResamplerBufferProvider->getFront()),
+        mRsmpInUnrel(0),
+        // as much converted data as the RecordThread buffer holds before conversion
+        mBufferFrames(destinationFramesPossible(
+                recordThread->mRsmpInFrames, recordThread->mSampleRate, mSampleRate)),
+        mRear(0)
+{
+    mBuffer = calloc(mBufferFrames, mFrameSize);
+}
+
+AudioFlinger::RecordThread::ConversionGroup::~ConversionGroup()
+{
+    delete mRecordBufferConverter;
+    free(mBuffer);
+}
+
+bool AudioFlinger::RecordThread::ConversionGroup::matches(const sp<RecordTrack>& track) const
+{
+    return track->format() == mFormat
+            && track->channelMask() == mChannelMask
+            && track->mSampleRate == mSampleRate;
+}
+
+bool AudioFlinger::RecordThread::ConversionGroup::isMember(const sp<RecordTrack>& track) const
+{
+    return std::any_of(mMembers.begin(), mMembers.end(),
+            [&track](const Member& member) { return member.mTrack == track; });
+}
+
+AudioFlinger::RecordThread::ConversionGroup::Member *
+AudioFlinger::RecordThread::ConversionGroup::findMember(const sp<RecordTrack>& track)
+{
+    for (Member& member : mMembers) {
+        if (member.mTrack == track) {
+            return &member;
+        }
+    }
+    LOG_ALWAYS_FATAL("%s: track %d is not a member", __func__, track->id());
+}
+
+void AudioFlinger::RecordThread::ConversionGroup::addMember(const sp<RecordTrack>& track)
+{
+    ALOG_ASSERT(matches(track) && !isMember(track));
+    mMembers.push_back({track, mRear});
+}
+
+size_t AudioFlinger::RecordThread::ConversionGroup::removeMembersNotIn(
+        const Vector< sp<RecordTrack> >& tracks)
+{
+    mMembers.erase(std::remove_if(mMembers.begin(), mMembers.end(),
+            [&tracks](const Member& member) {
+                for (size_t i = 0; i < tracks.size(); ++i) {
+                    if (member.mTrack == tracks[i]) {
+                        return false;
+                    }
+                }
+                return true;
+            }), mMembers.end());
+    return mMembers.size();
+}
+
+void AudioFlinger::RecordThread::ConversionGroup::convert()
+{
+    // as ResamplerBufferProvider::sync(), skip the data overwritten in the RecordThread buffer
+    const int32_t rear = mRecordThread->mRsmpInRear;
+    const ssize_t filled = audio_utils::safe_sub_overflow(rear, mRsmpInFront);
+    if (filled < 0) {
+        mRsmpInFront = rear;
+    } else if ((size_t) filled > mRecordThread->mRsmpInFrames) {
+        mRsmpInFront = audio_utils::safe_sub_overflow(
+                rear, static_cast<int32_t>(mRecordThread->mRsmpInFrames));
+    }
+
+    // convert until the RecordThread data is consumed, in contiguous parts of the ring
+    for (;;) {
+        const size_t offset = mRear % mBufferFrames;
+        const size_t framesOut = mRecordBufferConverter->convert(
+                (uint8_t *)mBuffer + offset * mFrameSize, this, mBufferFrames - offset);
+        if (framesOut == 0) {
+            break;
+        }
+        mRear += framesOut;
+    }
+}
+
+void AudioFlinger::RecordThread::ConversionGroup::sync(
+        const sp<RecordTrack>& track, size_t *framesAvailable, bool *hasOverrun)
+{
+    Member * const member = findMember(track);
+    const int64_t filled = mRear - member->mFront;
+
+    size_t framesIn;
+    bool overrun = false;
+    if (filled < 0) {
+        // should not happen, but treat like a massive overrun and re-sync
+        framesIn = 0;
+        member->mFront = mRear;
+        overrun = true;
+    } else if ((size_t) filled <= mBufferFrames) {
+        framesIn = (size_t) filled;
+    } else {
+        // member is not keeping up with the group, but give it the latest data
+        framesIn = mBufferFrames;
+        member->mFront = mRear - (int64_t) framesIn;
+        overrun = true;
+    }
+    if (framesAvailable != NULL) {
+        *framesAvailable = framesIn;
+    }
+    if (hasOverrun != NULL) {
+        *hasOverrun = overrun;
+    }
+}
+
+size_t AudioFlinger::RecordThread::ConversionGroup::read(
+        const sp<RecordTrack>& track, void *dst, size_t frames)
+{
+    Member * const member = findMember(track);
+    const int64_t filled = mRear - member->mFront;
+    LOG_ALWAYS_FATAL_IF(!(0 <= filled && (size_t) filled <= mBufferFrames));
+    frames = std::min(frames, (size_t) filled);
+    for (size_t copied = 0; copied < frames; ) {
+        const size_t offset = member->mFront % mBufferFrames;
+        const size_t part = std::min(frames - copied, mBufferFrames - offset);
+        memcpy((uint8_t *)dst + copied * mFrameSize,
+                (const uint8_t *)mBuffer + offset * mFrameSize, part * mFrameSize);
+        copied += part;
+        member->mFront += part;
+    }
+    return frames;
+}
+
+// AudioBufferProvider interface
+status_t AudioFlinger::RecordThread::ConversionGroup::getNextBuffer(
+        AudioBufferProvider::Buffer* buffer)
+{
+    const int32_t rear = mRecordThread->mRsmpInRear;
+    int32_t front = mRsmpInFront;
+    const ssize_t filled = audio_utils::safe_sub_overflow(rear, front);
+    LOG_ALWAYS_FATAL_IF(!(0 <= filled && (size_t) filled <= mRecordThread->mRsmpInFrames));
+    // 'filled' may be non-contiguous, so return only the first contiguous chunk
+
+    front &= mRecordThread->mRsmpInFramesP2 - 1;
+    size_t part1 = std::min(mRecordThread->mRsmpInFramesP2 - front, (size_t) filled);
+    part1 = std::min(part1, buffer->frameCount);
+    if (part1 == 0) {
+        // out of data is fine since the resampler will return a short-count.
+        buffer->raw = NULL;
+        buffer->frameCount = 0;
+        mRsmpInUnrel = 0;
+        return NOT_ENOUGH_DATA;
+    }
+
+    buffer->raw = (uint8_t*)mRecordThread->mRsmpInBuffer + front * mRecordThread->mFrameSize;
+    buffer->frameCount = part1;
+    mRsmpInUnrel = part1;
+    return NO_ERROR;
+}
+
+// AudioBufferProvider interface
+void AudioFlinger::RecordThread::ConversionGroup::releaseBuffer(
+        AudioBufferProvider::Buffer* buffer)
+{
+    const int32_t stepCount = static_cast<int32_t>(buffer->frameCount);
+    if (stepCount == 0) {
+        return;
+    }
+    ALOG_ASSERT(stepCount <= (int32_t)mRsmpInUnrel);
+    mRsmpInUnrel -= stepCount;
+    mRsmpInFront = audio_utils::safe_add_overflow(mRsmpInFront, stepCount);
+    buffer->raw = NULL;
+    buffer->frameCount = 0;
+}
+
+void AudioFlinger::RecordThread::updateConversionGroups(
+        const Vector< sp<RecordTrack> >& activeTracks)
+{
+    // a group lives as long as it has a member, so that no member sees a discontinuity
+    // when another one stops.
+    mConversionGroups.erase(std::remove_if(mConversionGroups.begin(), mConversionGroups.end(),
+            [&activeTracks](const std::unique_ptr<ConversionGroup>& group) {
+                return group->removeMembersNotIn(activeTracks) == 0;
+            }), mConversionGroups.end());
+
+    // Fast tracks are served by FastCapture and direct tracks are not converted.
+    // A track with a start position in the shared audio history must read from that position.
+    const auto isCandidate = [this](const sp<RecordTrack>& track) {
+        return !track->isFastTrack() && !track->isDirect() && track->startFrames() < 0
+                && getConversionGroup(track) == nullptr;
+    };
+    const size_t size = activeTracks.size();
+    for (size_t i = 0; i < size; i++) {
+        const sp<RecordTrack>& track = activeTracks[i];
+        if (!isCandidate(track)) {
+            continue;
+        }
+        ConversionGroup *group = nullptr;
+        for (const auto& existing : mConversionGroups) {
+            if (existing->matches(track)) {
+                group = existing.get();
+                break;
+            }
+        }
+        if (group == nullptr) {
+            // create a group only once a second track shares the same configuration.
+            for (size_t j = i + 1; j < size; j++) {
+                const sp<RecordTrack>& other = activeTracks[j];
+                if (isCandidate(other)
+                        && other->format() == track->format()
+                        && other->channelMask() == track->channelMask()
+                        && other->mSampleRate == track->mSampleRate) {
+                    auto newGroup = std::make_unique<ConversionGroup>(this, track);
+                    group = newGroup.get();
+                    mConversionGroups.push_back(std::move(newGroup));
+                    break;
+                }
+            }
+        }
+        if (group != nullptr) {
+            group->addMember(track);
+        }
+    }
+
+    size_t members = 0;
+    for (const auto& group : mConversionGroups) {
+        members += group->memberCount();
+    }
+    mConversionGroupCount.store(mConversionGroups.size(), std::memory_order_relaxed);
+    mConversionGroupMembers.store(members, std::memory_order_relaxed);
+}
+
+AudioFlinger::RecordThread::ConversionGroup *AudioFlinger::RecordThread::getConversionGroup(
+        const sp<RecordTrack>& track) const
+{
+    for (const auto& group : mConversionGroups) {
+        if (group->isMember(track)) {
+            return group.get();
+        }
+    }
+    return nullptr;
+}
+
 void AudioFlinger::RecordThread::checkBtNrec()
 {
     Mutex::Autolock _l(mLock);
@@ -9564,6 +10005,10 @@ void AudioFlinger::RecordThread::readInputParameters_l()
     LOG_ALWAYS_FATAL_IF(result != OK, "Error retrieving audio properties from HAL: %d", result);
     mFormat = mHALFormat;
     mChannelCount = audio_channel_count_from_in_mask(mChannelMask);
+    // the conversion groups convert from the previous configuration
+    mConversionGroups.clear();
+    mConversionGroupCount = 0;
+    mConversionGroupMembers = 0;
     if (audio_is_linear_pcm(mFormat)) {
         LOG_ALWAYS_FATAL_IF(mChannelCount > FCC_LIMIT, "HAL channel count %d > %d",
                 mChannelCount, FCC_LIMIT);
@@ -9796,6 +10241,9 @@ void AudioFlinger::RecordThread::updateFronts_l(int32_t offset)
         front = audio_utils::safe_sub_overflow(front, offset);
         mTracks[i]->mResamplerBufferProvider->setFront(front);
     }
+    for (const auto& group : mConversionGroups) {
+        group->setFront(audio_utils::safe_sub_overflow(group->getFront(), offset));
+    }
 }
 
 void AudioFlinger::RecordThread::resizeInputBuffer_l(int32_t maxSharedAudioHistoryMs)
@@ -719,6 +719,8 @@ protected:
                 audio_utils::Statistics<double> mProcessTimeMs{0.995 /* alpha */};
                 audio_utils::Statistics<double> mLatencyMs{0.995 /* alpha */};
                 audio_utils::Statistics<double> mMonopipePipeDepthStats{0.999 /* alpha */};
+                // Written by the threadLoop without locks, may be read from any thread.
+                ThreadHistograms        mCycleHistograms;
 
                 // Save the last count when we delivered statistics to mediametrics.
                 int64_t                 mLastRecordedTimestampVerifierN = 0;
@@ -1561,6 +1563,13 @@ protected:
 
                 AudioMixer* mAudioMixer;    // normal mixer
 
+                // Set by prepareTracks_l() when the only active track is a direct bridge
+                // PatchTrack that can be copied to mSinkBuffer without mixing, and cleared
+                // by threadLoop_mix().
+                sp<PatchTrack> mBridgeTrack;
+                // threadLoop_mix() variant for mBridgeTrack
+                void        threadLoop_copyBridgeTrack();
+
             // Support low latency mode by default as unless explicitly indicated by the audio HAL
             // we assume the audio path is compatible with the head tracking latency requirements
             std::vector<audio_latency_mode_t> mSupportedLatencyModes = {AUDIO_LATENCY_MODE_FREE,AUDIO_LATENCY_MODE_LOW};
@@ -1918,6 +1927,63 @@ public:
                                             // rolling counter that is never cleared
     };
 
+    /* A ConversionGroup converts the RecordThread data once for all of the RecordTracks
+     * that request the same format, channel mask and sample rate, instead of once per track.
+     * The converted data is kept in a ring from which each member copies to its own buffer
+     * at its own read position, with the same overrun semantics as ResamplerBufferProvider.
+     * Only accessed from the threadLoop(), no locks required.
+     */
+    class ConversionGroup : public AudioBufferProvider
+    {
+    public:
+        ConversionGroup(RecordThread *recordThread, const sp<RecordTrack>& track);
+        ~ConversionGroup() override;
+
+        // true if the track requests the configuration converted by this group
+        bool        matches(const sp<RecordTrack>& track) const;
+        bool        isMember(const sp<RecordTrack>& track) const;
+        // a new member reads from the most recently converted frame
+        void        addMember(const sp<RecordTrack>& track);
+        // removes the members which are not in tracks; returns the remaining member count
+        size_t      removeMembersNotIn(const Vector< sp<RecordTrack> >& tracks);
+        size_t      memberCount() const { return mMembers.size(); }
+
+        // converts all of the RecordThread data not yet converted into the ring.
+        void        convert();
+
+        // as ResamplerBufferProvider::sync(), in converted frames for the member track
+        void        sync(const sp<RecordTrack>& track, size_t *framesAvailable, bool *hasOverrun);
+        // copies up to frames converted frames to dst for the member track, returns frames copied
+        size_t      read(const sp<RecordTrack>& track, void *dst, size_t frames);
+
+        int32_t     getFront() const { return mRsmpInFront; }
+        void        setFront(int32_t front) { mRsmpInFront = front; }
+
+        // AudioBufferProvider interface, used by the converter to read the RecordThread data
+        status_t    getNextBuffer(AudioBufferProvider::Buffer* buffer) override;
+        void        releaseBuffer(AudioBufferProvider::Buffer* buffer) override;
+
+    private:
+        struct Member {
+            wp<RecordTrack> mTrack;
+            int64_t         mFront;         // next converted frame to read
+        };
+        Member     *findMember(const sp<RecordTrack>& track);
+
+        RecordThread * const        mRecordThread;
+        const audio_format_t        mFormat;
+        const audio_channel_mask_t  mChannelMask;
+        const uint32_t              mSampleRate;
+        const size_t                mFrameSize;
+        RecordBufferConverter      *mRecordBufferConverter;
+        int32_t                     mRsmpInFront;   // next RecordThread frame to convert
+        size_t                      mRsmpInUnrel;   // unreleased frames of getNextBuffer
+        void                       *mBuffer;        // ring of converted frames
+        size_t                      mBufferFrames;  // ring size in frames
+        int64_t                     mRear;          // frames converted, never cleared
+        std::vector<Member>         mMembers;
+    };
+
 #include "RecordTracks.h"
 
             RecordThread(const sp<AudioFlinger>& audioFlinger,
@@ -2070,6 +2136,11 @@ private:
             int32_t getOldestFront_l();
             void    updateFronts_l(int32_t offset);
 
+            // Groups the active tracks which share a destination configuration, see
+            // ConversionGroup.  Called by the threadLoop() for each HAL read.
+            void    updateConversionGroups(const Vector< sp<RecordTrack> >& activeTracks);
+            ConversionGroup *getConversionGroup(const sp<RecordTrack>& track) const;
+
             AudioStreamIn                       *mInput;
             Source                              *mSource;
             SortedVector < sp<RecordTrack> >    mTracks;
@@ -2088,6 +2159,12 @@ private:
             // rolling index that is never cleared
             int32_t                             mRsmpInRear;    // last filled frame + 1
 
+            // accessible only within the threadLoop(), no locks required
+            std::vector<std::unique_ptr<ConversionGroup>> mConversionGroups;
+            // for dumpsys
+            std::atomic<size_t>                 mConversionGroupCount{0};
+            std::atomic<size_t>                 mConversionGroupMembers{0};
+
             // For dumpsys
             const sp<MemoryDealer>              mReadOnlyHeap;
 
@@ -2287,7 +2287,8 @@ AudioFlinger::PlaybackThread::PatchTrack::PatchTrack(PlaybackThread *playbackThr
                                                      size_t bufferSize,
                                                      audio_output_flags_t flags,
                                                      const Timeout& timeout,
-                                                     size_t frameCountToBeReady)
+                                                     size_t frameCountToBeReady,
+                                                     bool isDirectBridge)
     :   Track(playbackThread, NULL, streamType,
               audio_attributes_t{} /* currently unused for patch track */,
               sampleRate, format, channelMask, frameCount,
@@ -2295,12 +2296,14 @@ AudioFlinger::PlaybackThread::PatchTrack::PatchTrack(PlaybackThread *playbackThr
               AUDIO_SESSION_NONE, getpid(), audioServerAttributionSource(getpid()), flags,
               TYPE_PATCH, AUDIO_PORT_HANDLE_NONE, frameCountToBeReady),
         PatchTrackBase(new ClientProxy(mCblk, mBuffer, frameCount, mFrameSize, true, true),
-                       *playbackThread, timeout)
+                       *playbackThread, timeout),
+        mIsDirectBridge(isDirectBridge)
 {
-    ALOGV("%s(%d): sampleRate %d mPeerTimeout %d.%03d sec",
+    ALOGV("%s(%d): sampleRate %d mPeerTimeout %d.%03d sec directBridge %d",
                                       __func__, mId, sampleRate,
                                       (int)mPeerTimeout.tv_sec,
-                                      (int)(mPeerTimeout.tv_nsec / 1000000));
+                                      (int)(mPeerTimeout.tv_nsec / 1000000),
+                                      mIsDirectBridge);
 }
 
 AudioFlinger::PlaybackThread::PatchTrack::~PatchTrack()
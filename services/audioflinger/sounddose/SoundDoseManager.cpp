@@ -57,10 +57,12 @@ sp<audio_utils::MelProcessor> SoundDoseManager::getOrCreateProcessorForDevice(
 
     auto streamProcessor = mActiveProcessors.find(streamHandle);
     if (streamProcessor != mActiveProcessors.end()) {
-        auto processor = streamProcessor->second.promote();
+        auto processor = streamProcessor->second.processor.promote();
         // if processor is nullptr it means it was removed by the playback
         // thread and can be replaced in the mActiveProcessors map
-        if (processor != nullptr) {
+        // a processor shared with other streams cannot follow this stream to another device
+        if (processor != nullptr && (processor->getDeviceId() == deviceId
+                || !isProcessorShared_l(processor, streamHandle))) {
             ALOGV("%s: found callback for stream id %d", __func__, streamHandle);
             const auto activeTypeIt = mActiveDeviceTypes.find(deviceId);
             if (activeTypeIt != mActiveDeviceTypes.end()) {
@@ -72,6 +74,28 @@ sp<audio_utils::MelProcessor> SoundDoseManager::getOrCreateProcessorForDevice(
         }
     }
 
+    if (mShareProcessorsPerDevice) {
+        sp<audio_utils::MelProcessor> sharedProcessor;
+        for (const auto& [handle, active] : mActiveProcessors) {
+            if (handle == streamHandle || active.sampleRate != sampleRate
+                    || active.channelCount != channelCount || active.format != format) {
+                continue;
+            }
+            sp<audio_utils::MelProcessor> processor = active.processor.promote();
+            if (processor != nullptr && processor->getDeviceId() == deviceId) {
+                ALOGV("%s: sharing callback of stream id %d with stream id %d",
+                      __func__, handle, streamHandle);
+                sharedProcessor = processor;
+                break;
+            }
+        }
+        if (sharedProcessor != nullptr) {
+            mActiveProcessors[streamHandle] =
+                    StreamProcessor{sharedProcessor, sampleRate, channelCount, format};
+            return sharedProcessor;
+        }
+    }
+
     ALOGV("%s: creating new callback for stream id %d", __func__, streamHandle);
     sp<audio_utils::MelProcessor> melProcessor = sp<audio_utils::MelProcessor>::make(
             sampleRate, channelCount, format, this, deviceId, mRs2UpperBound);
@@ -79,10 +103,26 @@ sp<audio_utils::MelProcessor> SoundDoseManager::getOrCreateProcessorForDevice(
     if (activeTypeIt != mActiveDeviceTypes.end()) {
         melProcessor->setAttenuation(mMelAttenuationDB[activeTypeIt->second]);
     }
-    mActiveProcessors[streamHandle] = melProcessor;
+    mActiveProcessors[streamHandle] =
+            StreamProcessor{melProcessor, sampleRate, channelCount, format};
     return melProcessor;
 }
 
+bool SoundDoseManager::isProcessorShared_l(const sp<audio_utils::MelProcessor>& processor,
+                                           audio_io_handle_t streamHandle) const {
+    for (const auto& [handle, active] : mActiveProcessors) {
+        if (handle != streamHandle && active.processor.unsafe_get() == processor.get()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void SoundDoseManager::setShareProcessorsPerDevice(bool share) {
+    std::lock_guard _l(mLock);
+    mShareProcessorsPerDevice = share;
+}
+
 bool SoundDoseManager::setHalSoundDoseInterface(const std::string &module,
                                                 const std::shared_ptr<ISoundDose> &halSoundDose) {
     ALOGV("%s", __func__);
@@ -152,7 +192,7 @@ void SoundDoseManager::setOutputRs2UpperBound(float rs2Value) {
     }
 
     for (auto& streamProcessor : mActiveProcessors) {
-        sp<audio_utils::MelProcessor> processor = streamProcessor.second.promote();
+        sp<audio_utils::MelProcessor> processor = streamProcessor.second.processor.promote();
         if (processor != nullptr) {
             status_t result = processor->setOutputRs2UpperBound(rs2Value);
             if (result != NO_ERROR) {
@@ -165,12 +205,15 @@ void SoundDoseManager::setOutputRs2UpperBound(float rs2Value) {
     }
 }
 
-void SoundDoseManager::removeStreamProcessor(audio_io_handle_t streamHandle) {
+bool SoundDoseManager::removeStreamProcessor(audio_io_handle_t streamHandle) {
     std::lock_guard _l(mLock);
     auto callbackToRemove = mActiveProcessors.find(streamHandle);
-    if (callbackToRemove != mActiveProcessors.end()) {
-        mActiveProcessors.erase(callbackToRemove);
+    if (callbackToRemove == mActiveProcessors.end()) {
+        return false;
     }
+    sp<audio_utils::MelProcessor> processor = callbackToRemove->second.processor.promote();
+    mActiveProcessors.erase(callbackToRemove);
+    return processor != nullptr && isProcessorShared_l(processor, streamHandle);
 }
 
 audio_port_handle_t SoundDoseManager::getIdForAudioDevice(const AudioDevice& audioDevice) const {
@@ -394,7 +437,7 @@ void SoundDoseManager::updateAttenuation(float attenuationDB, audio_devices_t de
             __func__, deviceType, attenuationDB);
     mMelAttenuationDB[deviceType] = attenuationDB;
     for (const auto& mp : mActiveProcessors) {
-        auto melProcessor = mp.second.promote();
+        auto melProcessor = mp.second.processor.promote();
         if (melProcessor != nullptr) {
             auto deviceId = melProcessor->getDeviceId();
             const auto deviceTypeIt = mActiveDeviceTypes.find(deviceId);
@@ -415,7 +458,7 @@ void SoundDoseManager::setCsdEnabled(bool enabled) {
     mEnabledCsd = enabled;
 
     for (auto& activeEntry : mActiveProcessors) {
-        auto melProcessor = activeEntry.second.promote();
+        auto melProcessor = activeEntry.second.processor.promote();
         if (melProcessor != nullptr) {
             if (enabled) {
                 melProcessor->resume();
@@ -74,8 +74,22 @@ public:
      * \brief Removes stream processor when MEL computation is not needed anymore
      *
      * \param streamHandle      handle to the stream
+     *
+     * \return true if the processor of the stream is still used by other streams, in which
+     *         case it must not be paused.
+     */
+    bool removeStreamProcessor(audio_io_handle_t streamHandle);
+
+    /**
+     * \brief Shares one MelProcessor between the streams routed to the same device with the
+     * same audio format, instead of creating one processor per stream.
+     *
+     * The processor then measures the blocks of all its streams in the order they are
+     * written, so the reported MELs cover the sum of the stream durations as with separate
+     * processors, with a single filter state and reporting thread.
+     * Only affects processors created after the call.
      */
-    void removeStreamProcessor(audio_io_handle_t streamHandle);
+    void setShareProcessorsPerDevice(bool share);
 
     /**
      * Sets the output RS2 upper bound for momentary exposure warnings. Must not be
@@ -223,8 +237,18 @@ private:
     // no need for lock since MelAggregator is thread-safe
     const sp<audio_utils::MelAggregator> mMelAggregator;
 
-    std::unordered_map<audio_io_handle_t, wp<audio_utils::MelProcessor>> mActiveProcessors
-            GUARDED_BY(mLock);
+    struct StreamProcessor {
+        wp<audio_utils::MelProcessor> processor;
+        uint32_t sampleRate;
+        size_t channelCount;
+        audio_format_t format;
+    };
+
+    /** Returns true if another stream than streamHandle uses the processor. */
+    bool isProcessorShared_l(const sp<audio_utils::MelProcessor>& processor,
+                             audio_io_handle_t streamHandle) const REQUIRES(mLock);
+
+    std::unordered_map<audio_io_handle_t, StreamProcessor> mActiveProcessors GUARDED_BY(mLock);
 
     // map active device address and type to device id, used also for managing the pause/resume
     // logic for deviceId's that should not report MEL values (e.g.: do not have an active MUSIC
@@ -254,6 +278,8 @@ private:
     bool mUseFrameworkMel GUARDED_BY(mLock) = false;
     bool mComputeCsdOnAllDevices GUARDED_BY(mLock) = false;
 
+    bool mShareProcessorsPerDevice GUARDED_BY(mLock) = false;
+
     bool mEnabledCsd GUARDED_BY(mLock) = true;
 };
 
@@ -110,6 +110,68 @@ TEST_F(SoundDoseManagerTest, RemoveExistingStream) {
     EXPECT_NE(processor1, processor2);
 }
 
+TEST_F(SoundDoseManagerTest, SharedProcessorForStreamsOnSameDevice) {
+    mSoundDoseManager->setShareProcessorsPerDevice(true);
+    sp<audio_utils::MelProcessor> processor1 =
+        mSoundDoseManager->getOrCreateProcessorForDevice(/*deviceId=*/1,
+            /*streamHandle=*/1,
+            /*sampleRate*/48000,
+            /*channelCount*/2,
+            /*format*/AUDIO_FORMAT_PCM_FLOAT);
+    sp<audio_utils::MelProcessor> processor2 =
+        mSoundDoseManager->getOrCreateProcessorForDevice(/*deviceId=*/1,
+            /*streamHandle=*/2,
+            /*sampleRate*/48000,
+            /*channelCount*/2,
+            /*format*/AUDIO_FORMAT_PCM_FLOAT);
+    sp<audio_utils::MelProcessor> otherFormat =
+        mSoundDoseManager->getOrCreateProcessorForDevice(/*deviceId=*/1,
+            /*streamHandle=*/3,
+            /*sampleRate*/44100,
+            /*channelCount*/2,
+            /*format*/AUDIO_FORMAT_PCM_FLOAT);
+    sp<audio_utils::MelProcessor> otherDevice =
+        mSoundDoseManager->getOrCreateProcessorForDevice(/*deviceId=*/2,
+            /*streamHandle=*/4,
+            /*sampleRate*/48000,
+            /*channelCount*/2,
+            /*format*/AUDIO_FORMAT_PCM_FLOAT);
+
+    EXPECT_EQ(processor1, processor2);
+    EXPECT_NE(processor1, otherFormat);
+    EXPECT_NE(processor1, otherDevice);
+
+    // The processor is still in use by stream 2 after removing stream 1.
+    EXPECT_TRUE(mSoundDoseManager->removeStreamProcessor(1));
+    EXPECT_FALSE(mSoundDoseManager->removeStreamProcessor(2));
+}
+
+TEST_F(SoundDoseManagerTest, SharedProcessorDoesNotFollowStreamToNewDevice) {
+    mSoundDoseManager->setShareProcessorsPerDevice(true);
+    sp<audio_utils::MelProcessor> processor1 =
+        mSoundDoseManager->getOrCreateProcessorForDevice(/*deviceId=*/1,
+            /*streamHandle=*/1,
+            /*sampleRate*/48000,
+            /*channelCount*/2,
+            /*format*/AUDIO_FORMAT_PCM_FLOAT);
+    sp<audio_utils::MelProcessor> processor2 =
+        mSoundDoseManager->getOrCreateProcessorForDevice(/*deviceId=*/1,
+            /*streamHandle=*/2,
+            /*sampleRate*/48000,
+            /*channelCount*/2,
+            /*format*/AUDIO_FORMAT_PCM_FLOAT);
+    sp<audio_utils::MelProcessor> movedProcessor =
+        mSoundDoseManager->getOrCreateProcessorForDevice(/*deviceId=*/2,
+            /*streamHandle=*/2,
+            /*sampleRate*/48000,
+            /*channelCount*/2,
+            /*format*/AUDIO_FORMAT_PCM_FLOAT);
+
+    EXPECT_EQ(processor1, processor2);
+    EXPECT_NE(processor1, movedProcessor);
+    EXPECT_EQ(1, processor1->getDeviceId());
+}
+
 TEST_F(SoundDoseManagerTest, NewMelValuesCacheNewRecord) {
     std::vector<float>mels{1, 1};
 
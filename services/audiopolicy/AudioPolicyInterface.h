@@ -502,6 +502,12 @@ public:
     virtual status_t setStreamVolume(audio_stream_type_t stream, float volume,
                                      audio_io_handle_t output, int delayMs = 0) = 0;
 
+    // setStreamVolume() calls made between beginVolumeBatch() and the matching endVolumeBatch()
+    // may be deferred and sent together by endVolumeBatch(). Batches can be nested: only the
+    // outermost endVolumeBatch() sends the deferred volumes.
+    virtual void beginVolumeBatch() {}
+    virtual void endVolumeBatch() {}
+
     // function enabling to send proprietary informations directly from audio policy manager to
     // audio hardware interface.
     virtual void setParameters(audio_io_handle_t ioHandle, const String8& keyValuePairs,
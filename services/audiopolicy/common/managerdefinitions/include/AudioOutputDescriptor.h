@@ -30,6 +30,7 @@
 #include "ClientDescriptor.h"
 #include "DeviceDescriptor.h"
 #include "PolicyAudioPort.h"
+#include <cmath>
 #include <vector>
 
 namespace android {
@@ -105,9 +106,15 @@ public:
     void setIsVoice(bool isVoice) { mIsVoice = isVoice; }
     bool isVoice() const { return mIsVoice; }
 
+    void setVolumeDeviceTypes(const DeviceTypeSet& deviceTypes) {
+        mVolumeDeviceTypes = deviceTypes;
+    }
+    const DeviceTypeSet& getVolumeDeviceTypes() const { return mVolumeDeviceTypes; }
+
 private:
     int mMuteCount = 0; /**< mute request counter */
     float mCurVolumeDb = NAN; /**< current volume in dB. */
+    DeviceTypeSet mVolumeDeviceTypes; /**< devices the current volume was applied for. */
     bool mIsVoice = false; /** true if this volume source is used for voice call volume */
 };
 /**
@@ -238,6 +245,20 @@ public:
         return mVolumeActivities.find(vs) != std::end(mVolumeActivities) ?
                     mVolumeActivities.at(vs).getVolume() : NAN;
     }
+    /**
+     * @brief isVolumeDirty: the volume of a source must be applied again if it was never
+     * applied on this output, was last applied for other devices or was overridden since.
+     */
+    bool isVolumeDirty(VolumeSource vs, const DeviceTypeSet& deviceTypes) const
+    {
+        const auto it = mVolumeActivities.find(vs);
+        return it == std::end(mVolumeActivities) || std::isnan(it->second.getVolume()) ||
+                it->second.getVolumeDeviceTypes() != deviceTypes;
+    }
+    void setVolumeDirty(VolumeSource vs)
+    {
+        mVolumeActivities[vs].setVolumeDeviceTypes(DeviceTypeSet());
+    }
     VolumeSource getVoiceSource() {
         for (const auto &iter : mVolumeActivities) {
             if (iter.second.isVoice()) {
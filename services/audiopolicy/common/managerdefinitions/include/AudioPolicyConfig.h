@@ -49,6 +49,9 @@ public:
     static const constexpr char* const kDefaultConfigSource = "AudioPolicyConfig::setDefault";
     // The suffix of the "engine default" implementation shared library name.
     static const constexpr char* const kDefaultEngineLibraryNameSuffix = "default";
+    // The binary snapshot of the platform XML configuration, see ConfigSnapshot.h.
+    static const constexpr char* const kXmlConfigSnapshotFile =
+            "/data/misc/audioserver/audio_policy_configuration.snapshot";
 
     // Creates the default (fallback) configuration.
     static sp<const AudioPolicyConfig> createDefault();
@@ -56,14 +59,16 @@ public:
     static sp<const AudioPolicyConfig> loadFromApmAidlConfigWithFallback(
             const media::AudioPolicyConfig& aidl);
     // Attempts to load the configuration from the XML file, falls back to default on failure.
-    // If the XML file path is not provided, uses `audio_get_audio_policy_config_file` function.
+    // If the XML file path is not provided, uses `audio_get_audio_policy_config_file` function,
+    // and loads the configuration from kXmlConfigSnapshotFile if it is up to date.
     static sp<const AudioPolicyConfig> loadFromApmXmlConfigWithFallback(
             const std::string& xmlFilePath = "");
     // The factory method to use in APM tests which craft the configuration manually.
     static sp<AudioPolicyConfig> createWritableForTests();
     // The factory method to use in APM tests which use a custom XML file.
+    // If 'snapshotFile' is provided, it is used as the snapshot of the XML file.
     static error::Result<sp<AudioPolicyConfig>> loadFromCustomXmlConfigForTests(
-            const std::string& xmlFilePath);
+            const std::string& xmlFilePath, const std::string& snapshotFile = "");
     // The factory method to use in VTS tests. If the 'configPath' is empty,
     // it is determined automatically from the list of known config paths.
     static error::Result<sp<AudioPolicyConfig>> loadFromCustomXmlConfigForVtsTests(
@@ -147,7 +152,8 @@ private:
 
     void augmentData();
     status_t loadFromAidl(const media::AudioPolicyConfig& aidl);
-    status_t loadFromXml(const std::string& xmlFilePath, bool forVts);
+    status_t loadFromXml(const std::string& xmlFilePath, bool forVts,
+            const std::string& snapshotFile = "");
 
     std::string mSource;  // Not kDefaultConfigSource. Empty source means an empty config.
     std::string mEngineLibraryNameSuffix = kDefaultEngineLibraryNameSuffix;
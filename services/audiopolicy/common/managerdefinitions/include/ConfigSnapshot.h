@@ -0,0 +1,42 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "AudioPolicyConfig.h"
+
+namespace android {
+
+// A configuration snapshot is a binary image of an AudioPolicyConfig parsed from XML.
+// It records the build and the size and hash of every file the configuration was parsed
+// from, and is only loaded while all of them are unchanged. Loading a snapshot is much
+// cheaper than parsing the XML files.
+
+// Writes the snapshot of 'config', which was parsed from 'sourceFiles'.
+status_t writeAudioPolicyConfigSnapshot(const char *snapshotFile, const AudioPolicyConfig &config,
+        const std::vector<std::string> &sourceFiles);
+
+// Loads the snapshot into 'config', which is only modified on success.
+// Returns NAME_NOT_FOUND if there is no snapshot, INVALID_OPERATION if the snapshot was not
+// created from 'xmlFile' by this build or if one of its source files changed, BAD_VALUE if
+// it is corrupted.
+status_t readAudioPolicyConfigSnapshot(const char *snapshotFile, const char *xmlFile,
+        AudioPolicyConfig *config);
+
+} // namespace android
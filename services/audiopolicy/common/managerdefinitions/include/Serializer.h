@@ -16,11 +16,17 @@
 
 #pragma once
 
+#include <string>
+#include <vector>
+
 #include "AudioPolicyConfig.h"
 
 namespace android {
 
-status_t deserializeAudioPolicyFile(const char *fileName, AudioPolicyConfig *config);
+// If 'sourceFiles' is not null, it receives the paths of the configuration file
+// and of all the files it includes.
+status_t deserializeAudioPolicyFile(const char *fileName, AudioPolicyConfig *config,
+        std::vector<std::string> *sourceFiles = nullptr);
 // In VTS mode all vendor extensions are ignored. This is done because
 // VTS tests are built using AOSP code and thus can not use vendor overlays
 // of system libraries.
@@ -178,6 +178,7 @@ bool AudioOutputDescriptor::setVolume(float volumeDb, bool /*muted*/,
     if (volumeDb != getCurVolume(volumeSource) || force) {
         ALOGV("%s for volumeSrc %d, volume %f, delay %d", __func__, volumeSource, volumeDb, delayMs);
         setCurVolume(volumeSource, volumeDb, isVoiceVolSrc);
+        mVolumeActivities[volumeSource].setVolumeDeviceTypes(deviceTypes);
         return true;
     }
     return false;
@@ -501,6 +502,8 @@ void SwAudioOutputDescriptor::setSwMute(
                 for (const auto &stream : streamTypes) {
                     mClientInterface->setStreamVolume(stream, volumeAmpl, mIoHandle, delayMs);
                 }
+                // the stream volumes no longer match the current volume of the source
+                setVolumeDirty(vs);
                 return;
             }
         }
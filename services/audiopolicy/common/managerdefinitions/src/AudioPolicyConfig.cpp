@@ -17,6 +17,7 @@
 #define LOG_TAG "APM_Config"
 
 #include <AudioPolicyConfig.h>
+#include <ConfigSnapshot.h>
 #include <IOProfile.h>
 #include <Serializer.h>
 #include <hardware/audio.h>
@@ -192,8 +193,10 @@ sp<const AudioPolicyConfig> AudioPolicyConfig::loadFromApmXmlConfigWithFallback(
         const std::string& xmlFilePath) {
     const std::string filePath =
             xmlFilePath.empty() ? audio_get_audio_policy_config_file() : xmlFilePath;
+    const std::string snapshotFile = xmlFilePath.empty() ? kXmlConfigSnapshotFile : "";
     auto config = sp<AudioPolicyConfig>::make();
-    if (status_t status = config->loadFromXml(filePath, false /*forVts*/); status == NO_ERROR) {
+    if (status_t status = config->loadFromXml(filePath, false /*forVts*/, snapshotFile);
+            status == NO_ERROR) {
         return config;
     }
     return createDefault();
@@ -206,9 +209,10 @@ sp<AudioPolicyConfig> AudioPolicyConfig::createWritableForTests() {
 
 // static
 error::Result<sp<AudioPolicyConfig>> AudioPolicyConfig::loadFromCustomXmlConfigForTests(
-        const std::string& xmlFilePath) {
+        const std::string& xmlFilePath, const std::string& snapshotFile) {
     auto config = sp<AudioPolicyConfig>::make();
-    if (status_t status = config->loadFromXml(xmlFilePath, false /*forVts*/); status == NO_ERROR) {
+    if (status_t status = config->loadFromXml(xmlFilePath, false /*forVts*/, snapshotFile);
+            status == NO_ERROR) {
         return config;
     } else {
         return base::unexpected(status);
@@ -266,16 +270,29 @@ status_t AudioPolicyConfig::loadFromAidl(const media::AudioPolicyConfig& aidl) {
     return NO_ERROR;
 }
 
-status_t AudioPolicyConfig::loadFromXml(const std::string& xmlFilePath, bool forVts) {
+status_t AudioPolicyConfig::loadFromXml(const std::string& xmlFilePath, bool forVts,
+        const std::string& snapshotFile) {
     if (xmlFilePath.empty()) {
         ALOGE("Audio policy configuration file name is empty");
         return BAD_VALUE;
     }
+    if (!forVts && !snapshotFile.empty() && readAudioPolicyConfigSnapshot(
+                    snapshotFile.c_str(), xmlFilePath.c_str(), this) == NO_ERROR) {
+        ALOGI("Loaded audio policy configuration from snapshot \"%s\"", snapshotFile.c_str());
+        mSource = xmlFilePath;
+        augmentData();
+        return NO_ERROR;
+    }
+    std::vector<std::string> sourceFiles;
     status_t status = forVts ? deserializeAudioPolicyFileForVts(xmlFilePath.c_str(), this)
-            : deserializeAudioPolicyFile(xmlFilePath.c_str(), this);
+            : deserializeAudioPolicyFile(xmlFilePath.c_str(), this, &sourceFiles);
     if (status == NO_ERROR) {
         mSource = xmlFilePath;
         augmentData();
+        if (!forVts && !snapshotFile.empty()) {
+            // Failure only costs a parse on the next start.
+            (void)writeAudioPolicyConfigSnapshot(snapshotFile.c_str(), *this, sourceFiles);
+        }
     } else {
         ALOGE("Could not load audio policy from the configuration file \"%s\": %d",
                 xmlFilePath.c_str(), status);
@@ -0,0 +1,476 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "APM::ConfigSnapshot"
+//#define LOG_NDEBUG 0
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <android-base/file.h>
+#include <android-base/mapped_file.h>
+#include <android-base/properties.h>
+#include <android-base/unique_fd.h>
+#include <media/AidlConversionUtil.h>
+#include <utils/Log.h>
+
+#include "ConfigSnapshot.h"
+#include "IOProfile.h"
+
+namespace android {
+
+namespace {
+
+constexpr uint32_t kSnapshotMagic = 0x53435041; // "APCS"
+// Must be incremented whenever the layout below changes. Changes of the parsing code
+// are caught by the build fingerprint.
+constexpr uint32_t kSnapshotVersion = 1;
+
+std::string getBuildFingerprint() {
+    return base::GetProperty("ro.build.fingerprint", "");
+}
+
+// FNV-1a, to detect changes of the source files.
+uint64_t hashContent(const std::string& content) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (unsigned char c : content) {
+        hash = (hash ^ c) * 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+class SnapshotWriter {
+public:
+    template <typename T>
+    void write(T value) {
+        static_assert(std::is_trivially_copyable_v<T>);
+        mData.append(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+
+    void write(const std::string& str) {
+        write(static_cast<uint32_t>(str.size()));
+        mData.append(str);
+    }
+
+    template <typename C>
+    void writeValues(const C& values) {
+        write(static_cast<uint32_t>(values.size()));
+        for (const auto& value : values) {
+            write(value);
+        }
+    }
+
+    const std::string& data() const { return mData; }
+
+private:
+    std::string mData;
+};
+
+// All reads fail once the end of the data is reached, so that errors need only
+// be checked once per element.
+class SnapshotReader {
+public:
+    SnapshotReader(const char* data, size_t size) : mCur(data), mEnd(data + size) {}
+
+    bool ok() const { return mOk; }
+
+    template <typename T>
+    T read() {
+        static_assert(std::is_trivially_copyable_v<T>);
+        T value{};
+        if (check(sizeof(T))) {
+            memcpy(&value, mCur, sizeof(T));
+            mCur += sizeof(T);
+        }
+        return value;
+    }
+
+    std::string readString() {
+        const uint32_t size = read<uint32_t>();
+        if (!check(size)) return {};
+        std::string str(mCur, size);
+        mCur += size;
+        return str;
+    }
+
+    // Reads an element count, each element taking at least 'minSize' bytes.
+    uint32_t readCount(size_t minSize = 1) {
+        const uint32_t count = read<uint32_t>();
+        return check(static_cast<size_t>(count) * minSize) ? count : 0;
+    }
+
+    template <typename T, typename C>
+    void readValues(C* values) {
+        for (uint32_t count = readCount(sizeof(T)); count > 0; --count) {
+            values->insert(values->end(), read<T>());
+        }
+    }
+
+private:
+    // Checks that 'size' more bytes are available.
+    bool check(size_t size) {
+        if (!mOk || static_cast<size_t>(mEnd - mCur) < size) {
+            mOk = false;
+        }
+        return mOk;
+    }
+
+    const char* mCur;
+    const char* const mEnd;
+    bool mOk = true;
+};
+
+void writeProfiles(SnapshotWriter* w, const AudioProfileVector& profiles) {
+    w->write(static_cast<uint32_t>(profiles.size()));
+    for (const auto& profile : profiles) {
+        w->write(profile->getFormat());
+        w->writeValues(profile->getChannels());
+        w->writeValues(profile->getSampleRates());
+        w->write(profile->isDynamicFormat());
+        w->write(profile->isDynamicChannels());
+        w->write(profile->isDynamicRate());
+    }
+}
+
+AudioProfileVector readProfiles(SnapshotReader* r) {
+    AudioProfileVector profiles;
+    for (uint32_t count = r->readCount(); count > 0 && r->ok(); --count) {
+        const auto format = r->read<audio_format_t>();
+        ChannelMaskSet channels;
+        r->readValues<audio_channel_mask_t>(&channels);
+        SampleRateSet rates;
+        r->readValues<uint32_t>(&rates);
+        sp<AudioProfile> profile = new AudioProfile(format, channels, rates);
+        profile->setDynamicFormat(r->read<bool>());
+        profile->setDynamicChannels(r->read<bool>());
+        profile->setDynamicRate(r->read<bool>());
+        // Already sorted when the snapshot was written.
+        profiles.push_back(profile);
+    }
+    return profiles;
+}
+
+status_t writeGains(SnapshotWriter* w, const AudioGains& gains) {
+    w->write(static_cast<uint32_t>(gains.size()));
+    for (const auto& gain : gains) {
+        // The index and direction are only exposed through the parcelable.
+        auto aidl = gain->toParcelable();
+        if (!aidl.ok()) return aidl.error();
+        w->write(aidl.value().second.index);
+        w->write(aidl.value().second.isInput);
+        w->write(gain->getGain());
+        w->write(gain->canUseForVolume());
+    }
+    return NO_ERROR;
+}
+
+AudioGains readGains(SnapshotReader* r) {
+    AudioGains gains;
+    for (uint32_t count = r->readCount(); count > 0 && r->ok(); --count) {
+        const auto index = r->read<int32_t>();
+        const auto isInput = r->read<bool>();
+        const auto g = r->read<struct audio_gain>();
+        sp<AudioGain> gain = new AudioGain(index, isInput);
+        gain->setMode(g.mode);
+        gain->setChannelMask(g.channel_mask);
+        gain->setMinValueInMb(g.min_value);
+        gain->setMaxValueInMb(g.max_value);
+        gain->setDefaultValueInMb(g.default_value);
+        gain->setStepValueInMb(g.step_value);
+        gain->setMinRampInMs(g.min_ramp_ms);
+        gain->setMaxRampInMs(g.max_ramp_ms);
+        gain->setUseForVolume(r->read<bool>());
+        gains.add(gain);
+    }
+    return gains;
+}
+
+status_t writeModule(SnapshotWriter* w, const sp<HwModule>& module) {
+    w->write(std::string(module->getName()));
+    w->write(module->getHalVersionMajor());
+    w->write(module->getHalVersionMinor());
+
+    IOProfileCollection mixPorts;
+    for (const auto& profile : module->getOutputProfiles()) mixPorts.add(profile);
+    for (const auto& profile : module->getInputProfiles()) mixPorts.add(profile);
+    w->write(static_cast<uint32_t>(mixPorts.size()));
+    for (const auto& mixPort : mixPorts) {
+        w->write(mixPort->getName());
+        w->write(mixPort->getRole());
+        w->write(mixPort->getFlags());
+        w->write(mixPort->maxOpenCount);
+        w->write(mixPort->maxActiveCount);
+        w->write(mixPort->recommendedMuteDurationMs);
+        writeProfiles(w, mixPort->getAudioProfiles());
+        RETURN_STATUS_IF_ERROR(writeGains(w, mixPort->getGains()));
+    }
+
+    const DeviceVector& devices = module->getDeclaredDevices();
+    w->write(static_cast<uint32_t>(devices.size()));
+    for (const auto& device : devices) {
+        w->write(device->type());
+        w->write(device->getTagName());
+        w->write(device->address());
+        w->writeValues(device->encodedFormats());
+        writeProfiles(w, device->getAudioProfiles());
+        RETURN_STATUS_IF_ERROR(writeGains(w, device->getGains()));
+    }
+
+    const AudioRouteVector& routes = module->getRoutes();
+    w->write(static_cast<uint32_t>(routes.size()));
+    for (const auto& route : routes) {
+        w->write(route->getType());
+        w->write(route->getSink()->getTagName());
+        w->write(static_cast<uint32_t>(route->getSources().size()));
+        for (const auto& source : route->getSources()) {
+            w->write(source->getTagName());
+        }
+    }
+    return NO_ERROR;
+}
+
+sp<HwModule> readModule(SnapshotReader* r) {
+    const std::string name = r->readString();
+    const auto versionMajor = r->read<uint32_t>();
+    const auto versionMinor = r->read<uint32_t>();
+    sp<HwModule> module = new HwModule(name.c_str(), versionMajor, versionMinor);
+
+    IOProfileCollection mixPorts;
+    for (uint32_t count = r->readCount(); count > 0 && r->ok(); --count) {
+        const std::string portName = r->readString();
+        const auto role = r->read<audio_port_role_t>();
+        sp<IOProfile> mixPort = new IOProfile(portName, role);
+        mixPort->setFlags(r->read<uint32_t>());
+        mixPort->maxOpenCount = r->read<decltype(mixPort->maxOpenCount)>();
+        mixPort->maxActiveCount = r->read<decltype(mixPort->maxActiveCount)>();
+        mixPort->recommendedMuteDurationMs =
+                r->read<decltype(mixPort->recommendedMuteDurationMs)>();
+        mixPort->setAudioProfiles(readProfiles(r));
+        mixPort->setGains(readGains(r));
+        mixPorts.add(mixPort);
+    }
+    module->setProfiles(mixPorts);
+
+    DeviceVector devices;
+    for (uint32_t count = r->readCount(); count > 0 && r->ok(); --count) {
+        const auto type = r->read<audio_devices_t>();
+        const std::string tagName = r->readString();
+        const std::string address = r->readString();
+        FormatVector encodedFormats;
+        r->readValues<audio_format_t>(&encodedFormats);
+        sp<DeviceDescriptor> device = new DeviceDescriptor(type, tagName, address, encodedFormats);
+        device->setAudioProfiles(readProfiles(r));
+        device->setGains(readGains(r));
+        devices.add(device);
+    }
+    module->setDeclaredDevices(devices);
+
+    AudioRouteVector routes;
+    for (uint32_t count = r->readCount(); count > 0 && r->ok(); --count) {
+        sp<AudioRoute> route = new AudioRoute(r->read<audio_route_type_t>());
+        sp<PolicyAudioPort> sink = module->findPortByTagName(r->readString());
+        PolicyAudioPortVector sources;
+        for (uint32_t sourceCount = r->readCount(); sourceCount > 0 && r->ok(); --sourceCount) {
+            sp<PolicyAudioPort> source = module->findPortByTagName(r->readString());
+            if (source == nullptr) return nullptr;
+            sources.add(source);
+        }
+        if (sink == nullptr) return nullptr;
+        route->setSink(sink);
+        sink->addRoute(route);
+        for (const auto& source : sources) {
+            source->addRoute(route);
+        }
+        route->setSources(sources);
+        routes.add(route);
+    }
+    module->setRoutes(routes);
+    return r->ok() ? module : nullptr;
+}
+
+// Identifies a device by its module and tag name, which is unique within a module.
+bool writeDeviceRef(SnapshotWriter* w, const HwModuleCollection& modules,
+        const sp<DeviceDescriptor>& device) {
+    for (size_t i = 0; i < modules.size(); ++i) {
+        if (modules[i]->getDeclaredDevices().contains(device)) {
+            w->write(static_cast<int32_t>(i));
+            w->write(device->getTagName());
+            return true;
+        }
+    }
+    return false;
+}
+
+sp<DeviceDescriptor> readDeviceRef(SnapshotReader* r, const HwModuleCollection& modules) {
+    const auto moduleIndex = r->read<int32_t>();
+    const std::string tagName = r->readString();
+    if (!r->ok() || moduleIndex < 0 || static_cast<size_t>(moduleIndex) >= modules.size()) {
+        return nullptr;
+    }
+    return modules[moduleIndex]->getDeclaredDevices().getDeviceFromTagName(tagName);
+}
+
+}  // namespace
+
+status_t writeAudioPolicyConfigSnapshot(const char *snapshotFile, const AudioPolicyConfig &config,
+        const std::vector<std::string> &sourceFiles)
+{
+    SnapshotWriter w;
+    w.write(kSnapshotMagic);
+    w.write(kSnapshotVersion);
+    w.write(getBuildFingerprint());
+    w.write(static_cast<uint32_t>(sourceFiles.size()));
+    for (const auto& file : sourceFiles) {
+        std::string content;
+        if (!base::ReadFileToString(file, &content)) {
+            ALOGW("%s: could not read %s", __func__, file.c_str());
+            return BAD_VALUE;
+        }
+        w.write(file);
+        w.write(static_cast<uint64_t>(content.size()));
+        w.write(hashContent(content));
+    }
+
+    w.write(config.getEngineLibraryNameSuffix());
+    w.write(config.isCallScreenModeSupported());
+    const HwModuleCollection& modules = config.getHwModules();
+    w.write(static_cast<uint32_t>(modules.size()));
+    for (const auto& module : modules) {
+        RETURN_STATUS_IF_ERROR(writeModule(&w, module));
+    }
+    DeviceVector attachedDevices = config.getOutputDevices();
+    attachedDevices.add(config.getInputDevices());
+    w.write(static_cast<uint32_t>(attachedDevices.size()));
+    for (const auto& device : attachedDevices) {
+        if (!writeDeviceRef(&w, modules, device)) return BAD_VALUE;
+    }
+    const bool hasDefaultOutputDevice = config.getDefaultOutputDevice() != nullptr;
+    w.write(hasDefaultOutputDevice);
+    if (hasDefaultOutputDevice &&
+            !writeDeviceRef(&w, modules, config.getDefaultOutputDevice())) {
+        return BAD_VALUE;
+    }
+    const AudioPolicyConfig::SurroundFormats& surroundFormats = config.getSurroundFormats();
+    w.write(static_cast<uint32_t>(surroundFormats.size()));
+    for (const auto& [format, subFormats] : surroundFormats) {
+        w.write(format);
+        w.writeValues(subFormats);
+    }
+
+    // Write to a temporary file and rename, so that a reader never sees a partial snapshot.
+    const std::string tmpFile = std::string(snapshotFile) + ".tmp";
+    if (!base::WriteStringToFile(w.data(), tmpFile, S_IRUSR | S_IWUSR, getuid(), getgid()) ||
+            rename(tmpFile.c_str(), snapshotFile) != 0) {
+        ALOGW("%s: could not write %s: %s", __func__, snapshotFile, strerror(errno));
+        unlink(tmpFile.c_str());
+        return INVALID_OPERATION;
+    }
+    ALOGV("%s: wrote %zu bytes to %s", __func__, w.data().size(), snapshotFile);
+    return NO_ERROR;
+}
+
+status_t readAudioPolicyConfigSnapshot(const char *snapshotFile, const char *xmlFile,
+        AudioPolicyConfig *config)
+{
+    base::unique_fd fd(TEMP_FAILURE_RETRY(open(snapshotFile, O_RDONLY | O_CLOEXEC)));
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        return NAME_NOT_FOUND;
+    }
+    auto mapping = base::MappedFile::FromFd(fd, 0, st.st_size, PROT_READ);
+    if (mapping == nullptr) {
+        return NAME_NOT_FOUND;
+    }
+    SnapshotReader r(mapping->data(), mapping->size());
+    if (r.read<uint32_t>() != kSnapshotMagic || r.read<uint32_t>() != kSnapshotVersion) {
+        ALOGW("%s: %s has an unknown format", __func__, snapshotFile);
+        return BAD_VALUE;
+    }
+    if (r.readString() != getBuildFingerprint()) {
+        ALOGI("%s: %s was written by another build", __func__, snapshotFile);
+        return INVALID_OPERATION;
+    }
+
+    const uint32_t sourceCount = r.readCount();
+    for (uint32_t i = 0; i < sourceCount; ++i) {
+        const std::string file = r.readString();
+        const auto size = r.read<uint64_t>();
+        const auto hash = r.read<uint64_t>();
+        if (!r.ok()) return BAD_VALUE;
+        if (i == 0 && file != xmlFile) {
+            ALOGI("%s: snapshot of %s, not %s", __func__, file.c_str(), xmlFile);
+            return INVALID_OPERATION;
+        }
+        std::string content;
+        if (!base::ReadFileToString(file, &content) || content.size() != size ||
+                hashContent(content) != hash) {
+            ALOGI("%s: %s changed, ignoring snapshot", __func__, file.c_str());
+            return INVALID_OPERATION;
+        }
+    }
+    if (sourceCount == 0) return BAD_VALUE;
+
+    const std::string engineLibraryNameSuffix = r.readString();
+    const bool isCallScreenModeSupported = r.read<bool>();
+    HwModuleCollection modules;
+    for (uint32_t count = r.readCount(); count > 0 && r.ok(); --count) {
+        sp<HwModule> module = readModule(&r);
+        if (module == nullptr) return BAD_VALUE;
+        modules.add(module);
+    }
+    DeviceVector attachedDevices;
+    for (uint32_t count = r.readCount(); count > 0 && r.ok(); --count) {
+        sp<DeviceDescriptor> device = readDeviceRef(&r, modules);
+        if (device == nullptr) return BAD_VALUE;
+        attachedDevices.add(device);
+    }
+    sp<DeviceDescriptor> defaultOutputDevice;
+    if (r.read<bool>()) {
+        defaultOutputDevice = readDeviceRef(&r, modules);
+        if (defaultOutputDevice == nullptr) return BAD_VALUE;
+    }
+    AudioPolicyConfig::SurroundFormats surroundFormats;
+    for (uint32_t count = r.readCount(); count > 0 && r.ok(); --count) {
+        const auto format = r.read<audio_format_t>();
+        auto& subFormats = surroundFormats[format];
+        r.readValues<audio_format_t>(&subFormats);
+    }
+    if (!r.ok()) {
+        ALOGW("%s: %s is truncated", __func__, snapshotFile);
+        return BAD_VALUE;
+    }
+
+    config->setEngineLibraryNameSuffix(engineLibraryNameSuffix);
+    config->setCallScreenModeSupported(isCallScreenModeSupported);
+    config->setHwModules(modules);
+    for (const auto& device : attachedDevices) {
+        config->addDevice(device);
+    }
+    config->setDefaultOutputDevice(defaultOutputDevice);
+    config->setSurroundFormats(surroundFormats);
+    return NO_ERROR;
+}
+
+} // namespace android
@@ -230,7 +230,7 @@ class PolicySerializer
 {
 public:
     status_t deserialize(const char *configFile, AudioPolicyConfig *config,
-            bool ignoreVendorExtensions = false);
+            bool ignoreVendorExtensions = false, std::vector<std::string> *sourceFiles = nullptr);
 
     template <class Trait>
     status_t deserializeCollection(const xmlNode *cur,
@@ -291,6 +291,24 @@ std::string getXmlAttribute(const xmlNode *cur, const char *attribute)
     return value;
 }
 
+// Appends the paths of the files included with XInclude below 'cur' to 'files'.
+void getXIncludedFiles(const xmlNode *cur, std::vector<std::string> *files)
+{
+    for (; cur != NULL; cur = cur->next) {
+        if (cur->type == XML_XINCLUDE_START) {
+            auto href = make_xmlUnique(xmlGetProp(cur, reinterpret_cast<const xmlChar*>("href")));
+            auto base = make_xmlUnique(xmlNodeGetBase(cur->doc, cur));
+            if (href != nullptr) {
+                auto uri = make_xmlUnique(xmlBuildURI(href.get(), base.get()));
+                if (uri != nullptr) {
+                    files->emplace_back(reinterpret_cast<const char*>(uri.get()));
+                }
+            }
+        }
+        getXIncludedFiles(cur->children, files);
+    }
+}
+
 template <class Trait>
 const xmlNode* getReference(const xmlNode *cur, const std::string &refName)
 {
@@ -843,7 +861,8 @@ PolicySerializer::deserialize<SurroundSoundFormatTraits>(
 }
 
 status_t PolicySerializer::deserialize(const char *configFile, AudioPolicyConfig *config,
-                                       bool ignoreVendorExtensions)
+                                       bool ignoreVendorExtensions,
+                                       std::vector<std::string> *sourceFiles)
 {
     mIgnoreVendorExtensions = ignoreVendorExtensions;
     auto doc = make_xmlUnique(xmlParseFile(configFile));
@@ -859,6 +878,10 @@ status_t PolicySerializer::deserialize(const char *configFile, AudioPolicyConfig
     if (xmlXIncludeProcess(doc.get()) < 0) {
         ALOGE("%s: libxml failed to resolve XIncludes on %s document.", __func__, configFile);
     }
+    if (sourceFiles != nullptr) {
+        sourceFiles->push_back(configFile);
+        getXIncludedFiles(root, sourceFiles);
+    }
 
     if (xmlStrcmp(root->name, reinterpret_cast<const xmlChar*>(rootName)))  {
         ALOGE("%s: No %s root element found in xml data %s.", __func__, rootName,
@@ -898,10 +921,12 @@ status_t PolicySerializer::deserialize(const char *configFile, AudioPolicyConfig
 
 }  // namespace
 
-status_t deserializeAudioPolicyFile(const char *fileName, AudioPolicyConfig *config)
+status_t deserializeAudioPolicyFile(const char *fileName, AudioPolicyConfig *config,
+                                    std::vector<std::string> *sourceFiles)
 {
     PolicySerializer serializer;
-    status_t status = serializer.deserialize(fileName, config);
+    status_t status = serializer.deserialize(fileName, config, false /*ignoreVendorExtensions*/,
+                                             sourceFiles);
     return status;
 }
 
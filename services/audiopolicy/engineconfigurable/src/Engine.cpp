@@ -143,6 +143,7 @@ bool Engine::setPropertyForKey(const Property &property, const Key &key)
 
 status_t Engine::setPhoneState(audio_mode_t mode)
 {
+    invalidateStrategyRoutes();
     status_t status = mPolicyParameterMgr->setPhoneState(mode);
     if (status != NO_ERROR) {
         return status;
@@ -158,6 +159,7 @@ audio_mode_t Engine::getPhoneState() const
 status_t Engine::setForceUse(audio_policy_force_use_t usage,
                                       audio_policy_forced_cfg_t config)
 {
+    invalidateStrategyRoutes();
     status_t status = mPolicyParameterMgr->setForceUse(usage, config);
     if (status != NO_ERROR) {
         return status;
@@ -173,6 +175,7 @@ audio_policy_forced_cfg_t Engine::getForceUse(audio_policy_force_use_t usage) co
 status_t Engine::setOutputDevicesConnectionState(const DeviceVector &devices,
                                                  audio_policy_dev_state_t state)
 {
+    invalidateStrategyRoutes();
     for (const auto &device : devices) {
         mPolicyParameterMgr->setDeviceConnectionState(device->type(), device->address(), state);
     }
@@ -188,6 +191,7 @@ status_t Engine::setOutputDevicesConnectionState(const DeviceVector &devices,
 status_t Engine::setDeviceConnectionState(const sp<DeviceDescriptor> device,
                                           audio_policy_dev_state_t state)
 {
+    invalidateStrategyRoutes();
     mPolicyParameterMgr->setDeviceConnectionState(device->type(), device->address(), state);
     if (audio_is_output_device(device->type())) {
         return mPolicyParameterMgr->setAvailableOutputDevices(
@@ -222,6 +226,7 @@ status_t Engine::loadAudioPolicyEngineConfig(const std::string& xmlFilePath)
     };
 
     loadCriteria(result.parsedConfig->criteria, result.parsedConfig->criterionTypes);
+    invalidateStrategyRoutes();
     return result.nbSkippedElement == 0? NO_ERROR : BAD_VALUE;
 }
 
@@ -231,6 +236,7 @@ status_t Engine::setDevicesRoleForStrategy(product_strategy_t strategy, device_r
     DeviceVector availableOutputDevices = getApmObserver()->getAvailableOutputDevices();
     DeviceVector prevDisabledDevices =
             getDisabledDevicesForProductStrategy(availableOutputDevices, strategy);
+    invalidateStrategyRoutes();
     status_t status = EngineBase::setDevicesRoleForStrategy(strategy, role, devices);
     if (status != NO_ERROR) {
         return status;
@@ -264,6 +270,7 @@ status_t Engine::removeDevicesRoleForStrategy(product_strategy_t strategy, devic
     DeviceVector availableOutputDevices = getApmObserver()->getAvailableOutputDevices();
     DeviceVector prevDisabledDevices =
             getDisabledDevicesForProductStrategy(availableOutputDevices, strategy);
+    invalidateStrategyRoutes();
     status_t status = EngineBase::removeDevicesRoleForStrategy(strategy, role, devices);
     if (status != NO_ERROR || role == DEVICE_ROLE_PREFERRED) {
         return status;
@@ -289,6 +296,7 @@ status_t Engine::clearDevicesRoleForStrategy(product_strategy_t strategy, device
     DeviceVector availableOutputDevices = getApmObserver()->getAvailableOutputDevices();
     DeviceVector prevDisabledDevices =
             getDisabledDevicesForProductStrategy(availableOutputDevices, strategy);
+    invalidateStrategyRoutes();
     status_t status = EngineBase::clearDevicesRoleForStrategy(strategy, role);
     if (status != NO_ERROR || role == DEVICE_ROLE_PREFERRED || prevDisabledDevices.empty()) {
         return status;
@@ -319,32 +327,35 @@ status_t Engine::disableDevicesForStrategy(product_strategy_t strategy,
     setOutputDevicesConnectionState(devicesToDisable, AUDIO_POLICY_DEVICE_STATE_AVAILABLE);
 
     // Force reapply devices for given strategy
+    invalidateStrategyRoutes();
     getProductStrategies().at(strategy)->setDeviceTypes(deviceTypes);
     setDeviceAddressForProductStrategy(strategy, address);
     return NO_ERROR;
 }
 
-DeviceVector Engine::getDevicesForProductStrategy(product_strategy_t ps) const
-{
-    DeviceVector selectedDevices = {};
-    DeviceVector disabledDevices = {};
-    const auto productStrategies = getProductStrategies();
-    if (productStrategies.find(ps) == productStrategies.end()) {
-        ALOGE("%s: Trying to get device on invalid strategy %d", __FUNCTION__, ps);
-        return selectedDevices;
-    }
-    DeviceVector availableOutputDevices = getApmObserver()->getAvailableOutputDevices();
-    const SwAudioOutputCollection &outputs = getApmObserver()->getOutputs();
-    DeviceTypeSet availableOutputDevicesTypes = availableOutputDevices.types();
-
-    // check if this strategy has a preferred device that is available,
-    // if yes, give priority to it.
-    DeviceVector preferredAvailableDevVec =
-            getPreferredAvailableDevicesForProductStrategy(availableOutputDevices, ps);
-    if (!preferredAvailableDevVec.isEmpty()) {
-        return preferredAvailableDevVec;
+void Engine::compileStrategyRoutes(const DeviceVector &availableOutputDevices) const
+{
+    mStrategyRoutes.clear();
+    mNotificationStrategy = getProductStrategyForStream(AUDIO_STREAM_NOTIFICATION);
+    mMusicStrategy = getProductStrategyForStream(AUDIO_STREAM_MUSIC);
+    mAccessibilityStrategy = getProductStrategyForStream(AUDIO_STREAM_ACCESSIBILITY);
+    mRingStrategy = getProductStrategyForStream(AUDIO_STREAM_RING);
+    mStrategyRoutesInCall = is_state_in_call(getPhoneState());
+    for (const auto &iter : getProductStrategies()) {
+        const product_strategy_t ps = iter.first;
+        StrategyRoute &route = mStrategyRoutes[ps];
+        // check if this strategy has a preferred device that is available,
+        // if yes, give priority to it.
+        route.preferredDevices =
+                getPreferredAvailableDevicesForProductStrategy(availableOutputDevices, ps);
+        route.devices = getDevicesForProductStrategyFromRules(ps, ps, availableOutputDevices);
     }
+    mStrategyRoutesDevices = availableOutputDevices;
+    mStrategyRoutesValid = true;
+}
 
+product_strategy_t Engine::getFallbackStrategy(product_strategy_t ps) const
+{
     /** This is the only case handled programmatically because the PFW is unable to know the
      * activity of streams.
      *
@@ -355,25 +366,55 @@ DeviceVector Engine::getDevicesForProductStrategy(product_strategy_t ps) const
      *
      * -When media is not playing anymore, fall back on the sonification behavior
      */
-    DeviceTypeSet deviceTypes;
-    product_strategy_t psOrFallback = ps;
-    if (ps == getProductStrategyForStream(AUDIO_STREAM_NOTIFICATION) &&
-            !is_state_in_call(getPhoneState()) &&
+    const SwAudioOutputCollection &outputs = getApmObserver()->getOutputs();
+    if (ps == mNotificationStrategy &&
+            !mStrategyRoutesInCall &&
             !outputs.isActiveRemotely(toVolumeSource(AUDIO_STREAM_MUSIC),
                                       SONIFICATION_RESPECTFUL_AFTER_MUSIC_DELAY) &&
             outputs.isActive(toVolumeSource(AUDIO_STREAM_MUSIC),
                              SONIFICATION_RESPECTFUL_AFTER_MUSIC_DELAY)) {
-        psOrFallback = getProductStrategyForStream(AUDIO_STREAM_MUSIC);
-    } else if (ps == getProductStrategyForStream(AUDIO_STREAM_ACCESSIBILITY) &&
+        return mMusicStrategy;
+    } else if (ps == mAccessibilityStrategy &&
         (outputs.isActive(toVolumeSource(AUDIO_STREAM_RING)) ||
          outputs.isActive(toVolumeSource(AUDIO_STREAM_ALARM)))) {
             // do not route accessibility prompts to a digital output currently configured with a
             // compressed format as they would likely not be mixed and dropped.
             // Device For Sonification conf file has HDMI, SPDIF and HDMI ARC unreacheable.
-        psOrFallback = getProductStrategyForStream(AUDIO_STREAM_RING);
+        return mRingStrategy;
+    }
+    return ps;
+}
+
+DeviceVector Engine::getDevicesForProductStrategy(product_strategy_t ps) const
+{
+    const DeviceVector availableOutputDevices = getApmObserver()->getAvailableOutputDevices();
+    if (!mStrategyRoutesValid || mStrategyRoutesDevices != availableOutputDevices) {
+        compileStrategyRoutes(availableOutputDevices);
+    }
+    const auto route = mStrategyRoutes.find(ps);
+    if (route == mStrategyRoutes.end()) {
+        ALOGE("%s: Trying to get device on invalid strategy %d", __FUNCTION__, ps);
+        return {};
     }
-    disabledDevices = getDisabledDevicesForProductStrategy(availableOutputDevices, psOrFallback);
-    deviceTypes = productStrategies.getDeviceTypesForProductStrategy(psOrFallback);
+    if (!route->second.preferredDevices.isEmpty()) {
+        return route->second.preferredDevices;
+    }
+    const product_strategy_t psOrFallback = getFallbackStrategy(ps);
+    if (psOrFallback == ps) {
+        return route->second.devices;
+    }
+    return getDevicesForProductStrategyFromRules(ps, psOrFallback, availableOutputDevices);
+}
+
+DeviceVector Engine::getDevicesForProductStrategyFromRules(product_strategy_t ps,
+        product_strategy_t psOrFallback, DeviceVector availableOutputDevices) const
+{
+    DeviceVector selectedDevices = {};
+    const auto &productStrategies = getProductStrategies();
+    DeviceTypeSet availableOutputDevicesTypes = availableOutputDevices.types();
+    DeviceVector disabledDevices =
+            getDisabledDevicesForProductStrategy(availableOutputDevices, psOrFallback);
+    DeviceTypeSet deviceTypes = productStrategies.getDeviceTypesForProductStrategy(psOrFallback);
     // In case a fallback is decided on other strategy, prevent from selecting this device if
     // disabled for current strategy.
     availableOutputDevices.remove(disabledDevices);
@@ -497,6 +538,7 @@ void Engine::setDeviceAddressForProductStrategy(product_strategy_t strategy,
               strategy);
         return;
     }
+    invalidateStrategyRoutes();
     getProductStrategies().at(strategy)->setDeviceAddress(address);
 }
 
@@ -509,6 +551,7 @@ bool Engine::setDeviceTypesForProductStrategy(product_strategy_t strategy, uint6
     // Here device matches the criterion value, need to rebuitd android device types;
     DeviceTypeSet types =
             mPolicyParameterMgr->convertDeviceCriterionValueToDeviceTypes(devices, true /*isOut*/);
+    invalidateStrategyRoutes();
     getProductStrategies().at(strategy)->setDeviceTypes(types);
     return true;
 }
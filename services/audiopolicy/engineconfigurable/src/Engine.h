@@ -149,6 +149,41 @@ private:
     ///
     DeviceVector getDevicesForProductStrategy(product_strategy_t strategy) const override;
 
+    /**
+     * Applies the device types and address set by the rules for psOrFallback, and the devices
+     * disabled for it, to the given available devices.
+     */
+    DeviceVector getDevicesForProductStrategyFromRules(product_strategy_t ps,
+            product_strategy_t psOrFallback, DeviceVector availableOutputDevices) const;
+
+    /**
+     * @return the strategy whose rules are followed by ps given the current stream activity,
+     * which is ps itself unless one of the sonification fallbacks applies.
+     */
+    product_strategy_t getFallbackStrategy(product_strategy_t ps) const;
+
+    /**
+     * The rule outputs only change when a criterion changes, so the device selection of each
+     * strategy is compiled once into mStrategyRoutes and looked up by the following queries.
+     * Only the stream activity dependent fallbacks are still evaluated per query.
+     */
+    void invalidateStrategyRoutes() { mStrategyRoutesValid = false; }
+    void compileStrategyRoutes(const DeviceVector &availableOutputDevices) const;
+
+    struct StrategyRoute {
+        DeviceVector preferredDevices; /**< Available preferred devices, used first if any. */
+        DeviceVector devices;          /**< Selected by the rules of the strategy itself. */
+    };
+    mutable std::map<product_strategy_t, StrategyRoute> mStrategyRoutes;
+    /** Devices the routes were compiled for, to catch changes the engine is not told about. */
+    mutable DeviceVector mStrategyRoutesDevices;
+    mutable bool mStrategyRoutesValid = false;
+    mutable bool mStrategyRoutesInCall = false;
+    mutable product_strategy_t mNotificationStrategy = PRODUCT_STRATEGY_NONE;
+    mutable product_strategy_t mMusicStrategy = PRODUCT_STRATEGY_NONE;
+    mutable product_strategy_t mAccessibilityStrategy = PRODUCT_STRATEGY_NONE;
+    mutable product_strategy_t mRingStrategy = PRODUCT_STRATEGY_NONE;
+
     /**
      * Policy Parameter Manager hidden through a wrapper.
      */
@@ -73,6 +73,20 @@ using content::AttributionSourceState;
 // media / notification / system volume.
 constexpr float IN_CALL_EARPIECE_HEADROOM_DB = 3.f;
 
+// Defers the stream volumes set during its lifetime so that they are sent in one batch,
+// see AudioPolicyClientInterface::beginVolumeBatch(). Must not span a wait for a volume
+// change to take effect, e.g. the mute wait in checkDeviceMuteStrategies().
+class VolumeBatch {
+public:
+    explicit VolumeBatch(AudioPolicyClientInterface *clientInterface)
+            : mClientInterface(clientInterface) {
+        mClientInterface->beginVolumeBatch();
+    }
+    ~VolumeBatch() { mClientInterface->endVolumeBatch(); }
+private:
+    AudioPolicyClientInterface * const mClientInterface;
+};
+
 static const unsigned int DEFAULT_MUTE_LATENCY_FACTOR = 2;
 static const unsigned int DEFAULT_ROUTING_LATENCY_MS = 50;
 
@@ -214,6 +228,7 @@ status_t AudioPolicyManager::setDeviceConnectionStateInt(audio_devices_t deviceT
 status_t AudioPolicyManager::setDeviceConnectionStateInt(const sp<DeviceDescriptor> &device,
                                                          audio_policy_dev_state_t state)
 {
+    invalidateRoutingDecisions();
     // handle output devices
     if (audio_is_output_device(device->type())) {
         SortedVector <audio_io_handle_t> outputs;
@@ -550,6 +565,7 @@ status_t AudioPolicyManager::handleDeviceConfigChange(audio_devices_t device,
                                                       const char *device_name,
                                                       audio_format_t encodedFormat)
 {
+    invalidateRoutingDecisions();
     status_t status = NO_ERROR;
     String8 reply;
     AudioParameter param;
@@ -898,6 +914,7 @@ void AudioPolicyManager::connectTelephonyTxAudioSource(
 
 void AudioPolicyManager::setPhoneState(audio_mode_t state)
 {
+    invalidateRoutingDecisions();
     ALOGV("setPhoneState() state %d", state);
     // store previous phone state for management of sonification strategy below
     int oldState = mEngine->getPhoneState();
@@ -1025,6 +1042,7 @@ audio_mode_t AudioPolicyManager::getPhoneState() {
 void AudioPolicyManager::setForceUse(audio_policy_force_use_t usage,
                                      audio_policy_forced_cfg_t config)
 {
+    invalidateRoutingDecisions();
     ALOGV("setForceUse() usage %d, config %d, mPhoneState %d", usage, config, mEngine->getPhoneState());
     if (config == mEngine->getForceUse(usage)) {
         return;
@@ -1509,12 +1527,69 @@ status_t AudioPolicyManager::getOutputForAttr(const audio_attributes_t *attr,
     audio_config_t directConfig = *config;
     checkAndUpdateOffloadInfoForDirectTracks(attr, stream, &directConfig, flags);
 
-    status_t status = getOutputForAttrInt(&resultAttr, output, session, attr, stream, uid,
-            &directConfig, flags, selectedDeviceId, &isRequestedDeviceForExclusiveUse,
-            secondaryOutputs != nullptr ? &secondaryMixes : nullptr, outputType, isSpatialized,
-            isBitPerfect);
-    if (status != NO_ERROR) {
-        return status;
+    // Requests which can only be served by a mixed output are memoized: other requests may
+    // open a new output or depend on state not covered by the routing decision generation.
+    RoutingDecision request = {};
+    const bool cacheable = attr != nullptr && secondaryOutputs != nullptr
+            && (*flags & (AUDIO_OUTPUT_FLAG_DIRECT | AUDIO_OUTPUT_FLAG_COMPRESS_OFFLOAD
+                    | AUDIO_OUTPUT_FLAG_HW_AV_SYNC | AUDIO_OUTPUT_FLAG_MMAP_NOIRQ)) == 0
+            && audio_is_linear_pcm(directConfig.format)
+            && directConfig.offload_info.content_id == 0
+            && directConfig.offload_info.sync_id == 0
+            && mPreferredMixerAttrInfos.empty();
+    const RoutingDecision *decision = nullptr;
+    if (cacheable) {
+        request.generation = mRoutingDecisionGeneration;
+        request.attr = *attr;
+        request.config = directConfig;
+        request.stream = *stream;
+        request.flags = *flags;
+        request.uid = uid;
+        request.session = session;
+        request.requestedPortId = sanitizedRequestedPortId;
+        request.vrAudioModeOn = isVrAudioModeOn();
+        decision = findRoutingDecision(request);
+    }
+
+    status_t status = NO_ERROR;
+    if (decision != nullptr) {
+        mRoutingDecisionHits++;
+        resultAttr = decision->resultAttr;
+        *output = decision->output;
+        *stream = decision->resultStream;
+        *flags = decision->resultFlags;
+        *selectedDeviceId = decision->selectedDeviceId;
+        isRequestedDeviceForExclusiveUse = decision->isRequestedDeviceForExclusiveUse;
+        *outputType = API_OUTPUT_LEGACY;
+        *isSpatialized = false;
+        *isBitPerfect = decision->isBitPerfect;
+    } else {
+        const size_t outputCount = mOutputs.size();
+        status = getOutputForAttrInt(&resultAttr, output, session, attr, stream, uid,
+                &directConfig, flags, selectedDeviceId, &isRequestedDeviceForExclusiveUse,
+                secondaryOutputs != nullptr ? &secondaryMixes : nullptr, outputType,
+                isSpatialized, isBitPerfect);
+        if (status != NO_ERROR) {
+            return status;
+        }
+        if (cacheable) {
+            mRoutingDecisionMisses++;
+            const sp<SwAudioOutputDescriptor> desc = mOutputs.valueFor(*output);
+            if (*outputType == API_OUTPUT_LEGACY && !*isSpatialized && secondaryMixes.empty()
+                    && mOutputs.size() == outputCount && desc != nullptr
+                    && (desc->mFlags & AUDIO_OUTPUT_FLAG_DIRECT) == 0
+                    && desc->mPolicyMix == nullptr
+                    && getMsdAudioOutDevices().isEmpty()) {
+                request.resultAttr = resultAttr;
+                request.output = *output;
+                request.resultStream = *stream;
+                request.resultFlags = *flags;
+                request.selectedDeviceId = *selectedDeviceId;
+                request.isRequestedDeviceForExclusiveUse = isRequestedDeviceForExclusiveUse;
+                request.isBitPerfect = *isBitPerfect;
+                storeRoutingDecision(request);
+            }
+        }
     }
     std::vector<wp<SwAudioOutputDescriptor>> weakSecondaryOutputDescs;
     if (secondaryOutputs != nullptr) {
@@ -1684,6 +1759,54 @@ status_t AudioPolicyManager::openDirectOutput(audio_stream_type_t stream,
     return NO_ERROR;
 }
 
+bool AudioPolicyManager::isVrAudioModeOn() const
+{
+    String8 value;
+    String8 reply =  mpClientInterface->getParameters(AUDIO_IO_HANDLE_NONE,
+                                          String8("vr_audio_mode_on"));
+    AudioParameter repliedParameter(reply);
+    return repliedParameter.get(String8("vr_audio_mode_on"), value) == NO_ERROR &&
+            value.contains("true");
+}
+
+bool AudioPolicyManager::RoutingDecision::matches(const RoutingDecision& other) const
+{
+    // Structures are compared bytewise: differences in unused bytes only cause a miss.
+    return generation == other.generation
+            && stream == other.stream
+            && flags == other.flags
+            && uid == other.uid
+            && session == other.session
+            && requestedPortId == other.requestedPortId
+            && vrAudioModeOn == other.vrAudioModeOn
+            && memcmp(&attr, &other.attr, sizeof(attr)) == 0
+            && memcmp(&config, &other.config, sizeof(config)) == 0;
+}
+
+const AudioPolicyManager::RoutingDecision *AudioPolicyManager::findRoutingDecision(
+        const RoutingDecision& request) const
+{
+    for (const auto& decision : mRoutingDecisions) {
+        if (decision.matches(request)) {
+            // the output may have been closed without a generation change, e.g. on error.
+            return mOutputs.valueFor(decision.output) != nullptr ? &decision : nullptr;
+        }
+    }
+    return nullptr;
+}
+
+void AudioPolicyManager::storeRoutingDecision(const RoutingDecision& decision)
+{
+    const uint32_t generation = mRoutingDecisionGeneration;
+    mRoutingDecisions.erase(std::remove_if(mRoutingDecisions.begin(), mRoutingDecisions.end(),
+            [generation](const RoutingDecision& d) { return d.generation != generation; }),
+            mRoutingDecisions.end());
+    if (mRoutingDecisions.size() >= kMaxRoutingDecisions) {
+        mRoutingDecisions.clear();
+    }
+    mRoutingDecisions.push_back(decision);
+}
+
 audio_io_handle_t AudioPolicyManager::getOutputForDevices(
         const DeviceVector &devices,
         audio_session_t session,
@@ -1702,12 +1825,7 @@ audio_io_handle_t AudioPolicyManager::getOutputForDevices(
             : config->channel_mask;
 
 
-    String8 value;
-    String8 reply =  mpClientInterface->getParameters(AUDIO_IO_HANDLE_NONE,
-                                          String8("vr_audio_mode_on"));
-    AudioParameter repliedParameter(reply);
-    if (repliedParameter.get(String8("vr_audio_mode_on"), value) == NO_ERROR &&
-        value.contains("true")) {
+    if (isVrAudioModeOn()) {
         ALOGI("%s VR mode is on, switch to primary output requested flags 0x%X",__func__, *flags);
         *flags = (audio_output_flags_t)(*flags &
                     (~(AUDIO_OUTPUT_FLAG_FAST|AUDIO_OUTPUT_FLAG_RAW)));
@@ -2422,6 +2540,7 @@ status_t AudioPolicyManager::startSource(const sp<SwAudioOutputDescriptor>& outp
                                          const sp<TrackClientDescriptor>& client,
                                          uint32_t *delayMs)
 {
+    invalidateRoutingDecisions();
     // cannot start playback of STREAM_TTS if any other output is being used
     uint32_t beaconMuteLatency = 0;
 
@@ -2686,6 +2805,7 @@ status_t AudioPolicyManager::stopOutput(audio_port_handle_t portId)
 status_t AudioPolicyManager::stopSource(const sp<SwAudioOutputDescriptor>& outputDesc,
                                         const sp<TrackClientDescriptor>& client)
 {
+    invalidateRoutingDecisions();
     // always handle stream stop, check which stream type is stopping
     audio_stream_type_t stream = client->stream();
     auto clientVolSrc = client->volumeSource();
@@ -3482,6 +3602,7 @@ status_t AudioPolicyManager::setVolumeIndexForAttributes(const audio_attributes_
     audio_devices_t curSrcDevice = Volume::getDeviceForVolume(curSrcDevices);
     resetDeviceTypes(curSrcDevices, curSrcDevice);
 
+    VolumeBatch volumeBatch(mpClientInterface);
     // update volume on all outputs and streams matching the following:
     // - The requested stream (or a stream matching for volume control) is active on the output
     // - The device (or devices) selected by the engine for this stream includes
@@ -3721,6 +3842,7 @@ status_t AudioPolicyManager::registerEffect(const effect_descriptor_t *desc,
                                 int session,
                                 int id)
 {
+    invalidateRoutingDecisions();
     if (session != AUDIO_SESSION_DEVICE) {
         ssize_t index = mOutputs.indexOfKey(io);
         if (index < 0) {
@@ -3739,6 +3861,7 @@ status_t AudioPolicyManager::registerEffect(const effect_descriptor_t *desc,
 
 status_t AudioPolicyManager::unregisterEffect(int id)
 {
+    invalidateRoutingDecisions();
     if (mEffects.getEffect(id) == nullptr) {
         return INVALID_OPERATION;
     }
@@ -3751,6 +3874,7 @@ status_t AudioPolicyManager::unregisterEffect(int id)
 
 status_t AudioPolicyManager::setEffectEnabled(int id, bool enabled)
 {
+    invalidateRoutingDecisions();
     sp<EffectDescriptor> effect = mEffects.getEffect(id);
     if (effect == nullptr) {
         return INVALID_OPERATION;
@@ -3766,6 +3890,7 @@ status_t AudioPolicyManager::setEffectEnabled(int id, bool enabled)
 
 status_t AudioPolicyManager::moveEffectsToIo(const std::vector<int>& ids, audio_io_handle_t io)
 {
+    invalidateRoutingDecisions();
    mEffects.moveEffects(ids, io);
    return NO_ERROR;
 }
@@ -3818,6 +3943,7 @@ bool AudioPolicyManager::isSourceActive(audio_source_t source) const
 
 status_t AudioPolicyManager::registerPolicyMixes(const Vector<AudioMix>& mixes)
 {
+    invalidateRoutingDecisions();
     ALOGV("registerPolicyMixes() %zu mix(es)", mixes.size());
     status_t res = NO_ERROR;
     bool checkOutputs = false;
@@ -3955,6 +4081,7 @@ status_t AudioPolicyManager::registerPolicyMixes(const Vector<AudioMix>& mixes)
 
 status_t AudioPolicyManager::unregisterPolicyMixes(Vector<AudioMix> mixes)
 {
+    invalidateRoutingDecisions();
     ALOGV("unregisterPolicyMixes() num mixes %zu", mixes.size());
     status_t res = NO_ERROR;
     bool checkOutputs = false;
@@ -4082,6 +4209,7 @@ std::vector<sp<SwAudioOutputDescriptor>> AudioPolicyManager::getSoftwareOutputsF
 
 status_t AudioPolicyManager::setUidDeviceAffinities(uid_t uid,
         const AudioDeviceTypeAddrVector& devices) {
+    invalidateRoutingDecisions();
     ALOGV("%s() uid=%d num devices %zu", __FUNCTION__, uid, devices.size());
     if (!areAllDevicesSupported(devices, audio_is_output_device, __func__)) {
         return BAD_VALUE;
@@ -4099,6 +4227,7 @@ status_t AudioPolicyManager::setUidDeviceAffinities(uid_t uid,
 }
 
 status_t AudioPolicyManager::removeUidDeviceAffinities(uid_t uid) {
+    invalidateRoutingDecisions();
     ALOGV("%s() uid=%d", __FUNCTION__, uid);
     status_t res = mPolicyMixes.removeUidDeviceAffinities(uid);
     if (res != NO_ERROR) {
@@ -4117,6 +4246,7 @@ status_t AudioPolicyManager::removeUidDeviceAffinities(uid_t uid) {
 status_t AudioPolicyManager::setDevicesRoleForStrategy(product_strategy_t strategy,
                                                        device_role_t role,
                                                        const AudioDeviceTypeAddrVector &devices) {
+    invalidateRoutingDecisions();
     ALOGV("%s() strategy=%d role=%d %s", __func__, strategy, role,
             dumpAudioDeviceTypeAddrVector(devices).c_str());
 
@@ -4179,7 +4309,8 @@ void AudioPolicyManager::updateCallAndOutputRouting(bool forceVolumeReeval, uint
             delayMs = 0;
         }
         if (forceVolumeReeval && !newDevices.isEmpty()) {
-            applyStreamVolumes(outputDesc, newDevices.types(), waitMs, true);
+            VolumeBatch volumeBatch(mpClientInterface);
+            applyDirtyStreamVolumes(outputDesc, newDevices.types(), waitMs);
         }
     }
     reopenOutputsWithDevices(outputsToReopen);
@@ -4207,6 +4338,7 @@ status_t
 AudioPolicyManager::removeDevicesRoleForStrategy(product_strategy_t strategy,
                                                  device_role_t role,
                                                  const AudioDeviceTypeAddrVector &devices) {
+    invalidateRoutingDecisions();
     ALOGV("%s() strategy=%d role=%d %s", __func__, strategy, role,
             dumpAudioDeviceTypeAddrVector(devices).c_str());
 
@@ -4240,6 +4372,7 @@ AudioPolicyManager::removeDevicesRoleForStrategy(product_strategy_t strategy,
 status_t AudioPolicyManager::clearDevicesRoleForStrategy(product_strategy_t strategy,
                                                          device_role_t role)
 {
+    invalidateRoutingDecisions();
     ALOGV("%s() strategy=%d role=%d", __func__, strategy, role);
 
     status_t status = mEngine->clearDevicesRoleForStrategy(strategy, role);
@@ -4346,6 +4479,7 @@ status_t AudioPolicyManager::getDevicesForRoleAndCapturePreset(
 
 status_t AudioPolicyManager::setUserIdDeviceAffinities(int userId,
         const AudioDeviceTypeAddrVector& devices) {
+    invalidateRoutingDecisions();
     ALOGV("%s() userId=%d num devices %zu", __func__, userId, devices.size());
     if (!areAllDevicesSupported(devices, audio_is_output_device, __func__)) {
         return BAD_VALUE;
@@ -4368,6 +4502,7 @@ status_t AudioPolicyManager::setUserIdDeviceAffinities(int userId,
 }
 
 status_t AudioPolicyManager::removeUserIdDeviceAffinities(int userId) {
+    invalidateRoutingDecisions();
     ALOGV("%s() userId=%d", __FUNCTION__, userId);
     AudioDeviceTypeAddrVector devices;
     mPolicyMixes.getDevicesForUserId(userId, devices);
@@ -4415,6 +4550,9 @@ void AudioPolicyManager::dump(String8 *dst) const
     dst->appendFormat(" Master mono: %s\n", mMasterMono ? "on" : "off");
     dst->appendFormat(" Communication Strategy id: %d\n", mCommunnicationStrategy);
     dst->appendFormat(" Config source: %s\n", mConfig->getSource().c_str());
+    dst->appendFormat(" Routing decisions: generation %u, %zu memoized, %u hits, %u misses\n",
+            mRoutingDecisionGeneration, mRoutingDecisions.size(), mRoutingDecisionHits,
+            mRoutingDecisionMisses);
 
     dst->append("\n");
     mAvailableOutputDevices.dump(dst, String8("Available output"), 1);
@@ -4456,6 +4594,7 @@ status_t AudioPolicyManager::dump(int fd)
 
 status_t AudioPolicyManager::setAllowedCapturePolicy(uid_t uid, audio_flags_mask_t capturePolicy)
 {
+    invalidateRoutingDecisions();
     mAllowedCapturePolicies[uid] = capturePolicy;
     return NO_ERROR;
 }
@@ -4764,6 +4903,7 @@ status_t AudioPolicyManager::setPreferredMixerAttributes(
         audio_port_handle_t portId,
         uid_t uid,
         const audio_mixer_attributes_t *mixerAttributes) {
+    invalidateRoutingDecisions();
     ALOGV("%s, attr=%s, mixerAttributes={format=%#x, channelMask=%#x, samplingRate=%u, "
           "mixerBehavior=%d}, uid=%d, portId=%u",
           __func__, toString(*attr).c_str(), mixerAttributes->config.format,
@@ -4892,6 +5032,7 @@ status_t AudioPolicyManager::getPreferredMixerAttributes(
 status_t AudioPolicyManager::clearPreferredMixerAttributes(const audio_attributes_t *attr,
                                                            audio_port_handle_t portId,
                                                            uid_t uid) {
+    invalidateRoutingDecisions();
     const product_strategy_t strategy = mEngine->getProductStrategyForAttributes(*attr);
     const auto preferredMixerAttrInfo = getPreferredMixerAttributesInfo(portId, strategy);
     if (preferredMixerAttrInfo == nullptr) {
@@ -5855,6 +5996,7 @@ status_t AudioPolicyManager::stopAudioSource(audio_port_handle_t portId)
 
 status_t AudioPolicyManager::setMasterMono(bool mono)
 {
+    invalidateRoutingDecisions();
     if (mMasterMono == mono) {
         return NO_ERROR;
     }
@@ -5991,6 +6133,7 @@ status_t AudioPolicyManager::getReportedSurroundFormats(unsigned int *numSurroun
 
 status_t AudioPolicyManager::setSurroundFormatEnabled(audio_format_t audioFormat, bool enabled)
 {
+    invalidateRoutingDecisions();
     ALOGV("%s() format 0x%X enabled %d", __func__, audioFormat, enabled);
     const auto& formatIter = mConfig->getSurroundFormats().find(audioFormat);
     if (formatIter == mConfig->getSurroundFormats().end()) {
@@ -6633,6 +6776,7 @@ void AudioPolicyManager::onNewAudioModulesAvailableInt(DeviceVector *newDevices)
 void AudioPolicyManager::addOutput(audio_io_handle_t output,
                                    const sp<SwAudioOutputDescriptor>& outputDesc)
 {
+    invalidateRoutingDecisions();
     mOutputs.add(output, outputDesc);
     applyStreamVolumes(outputDesc, DeviceTypeSet(), 0 /* delayMs */, true /* force */);
     updateMono(output); // update mono status when adding to output list
@@ -6642,6 +6786,7 @@ void AudioPolicyManager::addOutput(audio_io_handle_t output,
 
 void AudioPolicyManager::removeOutput(audio_io_handle_t output)
 {
+    invalidateRoutingDecisions();
     if (mPrimaryOutput != 0 && mPrimaryOutput == mOutputs.valueFor(output)) {
         ALOGV("%s: removing primary output", __func__);
         mPrimaryOutput = nullptr;
@@ -8244,6 +8389,21 @@ void AudioPolicyManager::applyStreamVolumes(const sp<AudioOutputDescriptor>& out
     }
 }
 
+void AudioPolicyManager::applyDirtyStreamVolumes(const sp<AudioOutputDescriptor>& outputDesc,
+                                                 const DeviceTypeSet& deviceTypes,
+                                                 int delayMs)
+{
+    ALOGVV("%s() for device %s", __func__, dumpDeviceTypes(deviceTypes).c_str());
+    for (const auto &volumeGroup : mEngine->getVolumeGroups()) {
+        const VolumeSource volumeSource = toVolumeSource(volumeGroup);
+        auto &curves = getVolumeCurves(volumeSource);
+        // a clean volume source is only sent if its computed volume changed
+        checkAndSetVolume(curves, volumeSource, curves.getVolumeIndex(deviceTypes),
+                          outputDesc, deviceTypes, delayMs,
+                          outputDesc->isVolumeDirty(volumeSource, deviceTypes) /*force*/);
+    }
+}
+
 void AudioPolicyManager::setStrategyMute(product_strategy_t strategy,
                                          bool on,
                                          const sp<AudioOutputDescriptor>& outputDesc,
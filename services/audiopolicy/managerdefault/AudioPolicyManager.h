@@ -20,6 +20,7 @@
 #include <functional>
 #include <memory>
 #include <unordered_set>
+#include <vector>
 
 #include <stdint.h>
 #include <sys/types.h>
@@ -581,6 +582,12 @@ protected:
                                 const DeviceTypeSet& deviceTypes,
                                 int delayMs = 0, bool force = false);
 
+        // same as applyStreamVolumes() with force, but only forces the volume sources whose
+        // volume was not applied yet for these devices, see AudioOutputDescriptor::isVolumeDirty()
+        void applyDirtyStreamVolumes(const sp<AudioOutputDescriptor>& outputDesc,
+                                     const DeviceTypeSet& deviceTypes,
+                                     int delayMs = 0);
+
         /**
          * @brief setStrategyMute Mute or unmute all active clients on the considered output
          * following the given strategy.
@@ -983,6 +990,44 @@ protected:
 
         uint32_t nextAudioPortGeneration();
 
+        // Routing decisions of getOutputForAttr() memoized for identical requests.
+        // Only requests routed by the engine to an already opened mixed output are kept,
+        // see getOutputForAttr(). A decision is only reused while mRoutingDecisionGeneration
+        // is unchanged; invalidateRoutingDecisions() must be called whenever a state the
+        // routing depends on changes (devices, phone state, forced usages, effects, dynamic
+        // policies, device affinities and roles, stream activity, opened outputs...).
+        struct RoutingDecision {
+            uint32_t generation;
+            // request
+            audio_attributes_t attr;
+            audio_config_t config;
+            audio_stream_type_t stream;
+            audio_output_flags_t flags;
+            uid_t uid;
+            audio_session_t session;
+            audio_port_handle_t requestedPortId;
+            bool vrAudioModeOn;
+            // decision
+            audio_attributes_t resultAttr;
+            audio_io_handle_t output;
+            audio_stream_type_t resultStream;
+            audio_output_flags_t resultFlags;
+            audio_port_handle_t selectedDeviceId;
+            bool isRequestedDeviceForExclusiveUse;
+            bool isBitPerfect;
+
+            bool matches(const RoutingDecision& other) const;
+        };
+        static constexpr size_t kMaxRoutingDecisions = 64;
+        std::vector<RoutingDecision> mRoutingDecisions;
+        uint32_t mRoutingDecisionGeneration = 0;
+        uint32_t mRoutingDecisionHits = 0;
+        uint32_t mRoutingDecisionMisses = 0;
+
+        void invalidateRoutingDecisions() { mRoutingDecisionGeneration++; }
+        const RoutingDecision *findRoutingDecision(const RoutingDecision& request) const;
+        void storeRoutingDecision(const RoutingDecision& decision);
+
         // Surround formats that are enabled manually. Taken into account when
         // "encoded surround" is forced into "manual" mode.
         std::unordered_set<audio_format_t> mManualSurroundFormats;
@@ -1089,6 +1134,8 @@ protected:
                 output_type_t *outputType,
                 bool *isSpatialized,
                 bool *isBitPerfect);
+        // returns true if the audio HAL reports that VR audio mode is on
+        bool isVrAudioModeOn() const;
         // internal method to return the output handle for the given device and format
         virtual audio_io_handle_t getOutputForDevices(
                 const DeviceVector &devices,
@@ -17,6 +17,8 @@
 #define LOG_TAG "AudioPolicyClientImpl"
 //#define LOG_NDEBUG 0
 
+#include <algorithm>
+
 #include "AudioPolicyService.h"
 
 #include <utils/Log.h>
@@ -182,10 +184,56 @@ status_t AudioPolicyService::AudioPolicyClient::setStreamVolume(audio_stream_typ
                      float volume, audio_io_handle_t output,
                      int delay_ms)
 {
+    if (mVolumeBatchDepth > 0) {
+        // only the last volume of a stream on an output within the batch is sent
+        auto it = std::find_if(mPendingVolumes.begin(), mPendingVolumes.end(),
+                [stream, output](const auto& pending) {
+                    return pending.first.stream == stream && pending.first.output == output;
+                });
+        if (it != mPendingVolumes.end()) {
+            mPendingVolumes.erase(it);
+        }
+        mPendingVolumes.push_back({{stream, volume, output}, delay_ms});
+        return NO_ERROR;
+    }
     return mAudioPolicyService->setStreamVolume(stream, volume, output,
                                                delay_ms);
 }
 
+void AudioPolicyService::AudioPolicyClient::beginVolumeBatch()
+{
+    mVolumeBatchDepth++;
+}
+
+void AudioPolicyService::AudioPolicyClient::endVolumeBatch()
+{
+    if (mVolumeBatchDepth == 0 || --mVolumeBatchDepth > 0) {
+        return;
+    }
+    // one command per delay, in order of first use of the delay
+    std::vector<std::pair<StreamVolume, int>> pendingVolumes;
+    pendingVolumes.swap(mPendingVolumes);
+    while (!pendingVolumes.empty()) {
+        const int delayMs = pendingVolumes.front().second;
+        std::vector<StreamVolume> volumes;
+        auto it = pendingVolumes.begin();
+        while (it != pendingVolumes.end()) {
+            if (it->second == delayMs) {
+                volumes.push_back(it->first);
+                it = pendingVolumes.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        if (volumes.size() == 1) {
+            mAudioPolicyService->setStreamVolume(
+                    volumes[0].stream, volumes[0].volume, volumes[0].output, delayMs);
+        } else {
+            mAudioPolicyService->setStreamVolumes(volumes, delayMs);
+        }
+    }
+}
+
 void AudioPolicyService::AudioPolicyClient::setParameters(audio_io_handle_t io_handle,
                    const String8& keyValuePairs,
                    int delay_ms)
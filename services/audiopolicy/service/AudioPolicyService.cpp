@@ -21,6 +21,7 @@
 #undef __STRICT_ANSI__
 #define __STDINT_LIMITS
 #define __STDC_LIMIT_MACROS
+#include <algorithm>
 #include <stdint.h>
 #include <sys/time.h>
 #include <dlfcn.h>
@@ -777,7 +778,8 @@ void AudioPolicyService::NotificationClient::setAudioVolumeGroupCallbacksEnabled
 
 void AudioPolicyService::NotificationClient::onRoutingUpdated()
 {
-    if (mAudioPolicyServiceClient != 0 && isServiceUid(mUid)) {
+    // Sent to all clients: it invalidates the cache of policy queries in AudioSystem.
+    if (mAudioPolicyServiceClient != 0) {
         mAudioPolicyServiceClient->onRoutingUpdated();
     }
 }
@@ -2059,6 +2061,23 @@ bool AudioPolicyService::AudioCommandThread::threadLoop()
                                                                     data->mIO);
                     mLock.lock();
                     }break;
+                case SET_VOLUMES: {
+                    VolumesData *data = (VolumesData *)command->mParam.get();
+                    ALOGV("AudioCommandThread() processing set %zu volumes",
+                            data->mVolumes.size());
+                    mLock.unlock();
+                    // report the first error, but apply all volumes.
+                    status_t status = NO_ERROR;
+                    for (const auto& volume : data->mVolumes) {
+                        status_t volumeStatus = AudioSystem::setStreamVolume(
+                                volume.stream, volume.volume, volume.output);
+                        if (status == NO_ERROR) {
+                            status = volumeStatus;
+                        }
+                    }
+                    command->mStatus = status;
+                    mLock.lock();
+                    }break;
                 case SET_PARAMETERS: {
                     ParametersData *data = (ParametersData *)command->mParam.get();
                     ALOGV("AudioCommandThread() processing set parameters string %s, io %d",
@@ -2383,6 +2402,32 @@ status_t AudioPolicyService::AudioCommandThread::volumeCommand(audio_stream_type
     return sendCommand(command, delayMs);
 }
 
+status_t AudioPolicyService::AudioCommandThread::volumesCommand(
+        const std::vector<StreamVolume>& volumes, int delayMs)
+{
+    sp<AudioCommand> command = new AudioCommand();
+    command->mCommand = SET_VOLUMES;
+    sp<VolumesData> data = new VolumesData();
+    data->mVolumes = volumes;
+    command->mParam = data;
+    command->mWaitStatus = true;
+    ALOGV("AudioCommandThread() adding set %zu volumes", volumes.size());
+    return sendCommand(command, delayMs);
+}
+
+bool AudioPolicyService::AudioCommandThread::VolumesData::removeVolumes(
+        const std::vector<StreamVolume>& volumes)
+{
+    mVolumes.erase(std::remove_if(mVolumes.begin(), mVolumes.end(),
+            [&volumes](const StreamVolume& v) {
+                return std::any_of(volumes.begin(), volumes.end(),
+                        [&v](const StreamVolume& other) {
+                            return other.stream == v.stream && other.output == v.output;
+                        });
+            }), mVolumes.end());
+    return mVolumes.empty();
+}
+
 status_t AudioPolicyService::AudioCommandThread::parametersCommand(audio_io_handle_t ioHandle,
                                                                    const char *keyValuePairs,
                                                                    int delayMs)
@@ -2671,6 +2716,11 @@ void AudioPolicyService::AudioCommandThread::insertCommand_l(sp<AudioCommand>& c
                     (command2->mCommand != RELEASE_AUDIO_PATCH)) {
                 continue;
             }
+        } else if ((command->mCommand == SET_VOLUME) || (command->mCommand == SET_VOLUMES)) {
+            // single and batched volume commands are filtered against each other
+            if ((command2->mCommand != SET_VOLUME) && (command2->mCommand != SET_VOLUMES)) {
+                continue;
+            }
         } else if (command2->mCommand != command->mCommand) continue;
 
         switch (command->mCommand) {
@@ -2712,6 +2762,14 @@ void AudioPolicyService::AudioCommandThread::insertCommand_l(sp<AudioCommand>& c
 
         case SET_VOLUME: {
             VolumeData *data = (VolumeData *)command->mParam.get();
+            if (command2->mCommand == SET_VOLUMES) {
+                // the later batch must not restore the previous volume: drop it from the batch.
+                VolumesData *data2 = (VolumesData *)command2->mParam.get();
+                if (data2->removeVolumes({{data->mStream, data->mVolume, data->mIO}})) {
+                    removedCommands.add(command2);
+                }
+                break;
+            }
             VolumeData *data2 = (VolumeData *)command2->mParam.get();
             if (data->mIO != data2->mIO) break;
             if (data->mStream != data2->mStream) break;
@@ -2724,6 +2782,22 @@ void AudioPolicyService::AudioCommandThread::insertCommand_l(sp<AudioCommand>& c
             delayMs = 1;
         } break;
 
+        case SET_VOLUMES: {
+            // drop the volumes of the later commands which are also set by this batch.
+            VolumesData *data = (VolumesData *)command->mParam.get();
+            if (command2->mCommand == SET_VOLUME) {
+                VolumeData *data2 = (VolumeData *)command2->mParam.get();
+                for (const auto& volume : data->mVolumes) {
+                    if (volume.stream == data2->mStream && volume.output == data2->mIO) {
+                        removedCommands.add(command2);
+                        break;
+                    }
+                }
+            } else if (((VolumesData *)command2->mParam.get())->removeVolumes(data->mVolumes)) {
+                removedCommands.add(command2);
+            }
+        } break;
+
         case SET_VOICE_VOLUME: {
             VoiceVolumeData *data = (VoiceVolumeData *)command->mParam.get();
             VoiceVolumeData *data2 = (VoiceVolumeData *)command2->mParam.get();
@@ -2870,6 +2944,12 @@ int AudioPolicyService::setStreamVolume(audio_stream_type_t stream,
                                                    output, delayMs);
 }
 
+status_t AudioPolicyService::setStreamVolumes(const std::vector<StreamVolume>& volumes,
+                                              int delayMs)
+{
+    return mAudioCommandThread->volumesCommand(volumes, delayMs);
+}
+
 int AudioPolicyService::setVoiceVolume(float volume, int delayMs)
 {
     return (int)mAudioCommandThread->voiceVolumeCommand(volume, delayMs);
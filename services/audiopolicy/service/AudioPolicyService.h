@@ -46,6 +46,7 @@
 #include <android/content/AttributionSourceState.h>
 
 #include <unordered_map>
+#include <vector>
 
 namespace android {
 
@@ -327,6 +328,14 @@ public:
                                      float volume,
                                      audio_io_handle_t output,
                                      int delayMs = 0);
+    struct StreamVolume {
+        audio_stream_type_t stream;
+        float volume;
+        audio_io_handle_t output;
+    };
+    // sets several stream volumes with a single audio command
+    virtual status_t setStreamVolumes(const std::vector<StreamVolume>& volumes,
+                                      int delayMs = 0);
     virtual status_t setVoiceVolume(float volume, int delayMs = 0);
 
     void doOnNewAudioModulesAvailable();
@@ -570,6 +579,7 @@ private:
             CHECK_SPATIALIZER_OUTPUT, // verify if spatializer effect should be created or moved
             UPDATE_ACTIVE_SPATIALIZER_TRACKS, // Update active track counts on spalializer output
             VOL_RANGE_INIT_REQUEST, // request to reset the volume range indices
+            SET_VOLUMES, // several SET_VOLUME applied at once
         };
 
         AudioCommandThread (String8 name, const wp<AudioPolicyService>& service);
@@ -584,6 +594,8 @@ private:
                     void        exit();
                     status_t    volumeCommand(audio_stream_type_t stream, float volume,
                                             audio_io_handle_t output, int delayMs = 0);
+                    status_t    volumesCommand(const std::vector<StreamVolume>& volumes,
+                                            int delayMs = 0);
                     status_t    parametersCommand(audio_io_handle_t ioHandle,
                                             const char *keyValuePairs, int delayMs = 0);
                     status_t    voiceVolumeCommand(float volume, int delayMs = 0);
@@ -659,6 +671,15 @@ private:
             audio_io_handle_t mIO;
         };
 
+        class VolumesData : public AudioCommandData {
+        public:
+            std::vector<StreamVolume> mVolumes;
+
+            // removes the volumes of the (stream, output) pairs also set by volumes,
+            // returns true if no volume is left.
+            bool removeVolumes(const std::vector<StreamVolume>& volumes);
+        };
+
         class ParametersData : public AudioCommandData {
         public:
             audio_io_handle_t mIO;
@@ -803,6 +824,10 @@ private:
         // for each output (destination device) it is attached to.
         virtual status_t setStreamVolume(audio_stream_type_t stream, float volume, audio_io_handle_t output, int delayMs = 0);
 
+        // defer setStreamVolume() calls and send them with one audio command per delay.
+        void beginVolumeBatch() override;
+        void endVolumeBatch() override;
+
         // function enabling to send proprietary informations directly from audio policy manager to audio hardware interface.
         virtual void setParameters(audio_io_handle_t ioHandle, const String8& keyValuePairs, int delayMs = 0);
         // function enabling to receive proprietary informations directly from audio hardware interface to audio policy manager.
@@ -866,6 +891,11 @@ private:
 
      private:
         AudioPolicyService *mAudioPolicyService;
+
+        // calls to the client are serialized by the AudioPolicyService lock.
+        int mVolumeBatchDepth = 0;
+        // volumes deferred while mVolumeBatchDepth > 0, in call order, with their delay.
+        std::vector<std::pair<StreamVolume, int>> mPendingVolumes;
     };
 
     // --- Notification Client ---
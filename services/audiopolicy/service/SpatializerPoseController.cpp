@@ -15,6 +15,7 @@
  */
 
 #include "SpatializerPoseController.h"
+#include <algorithm>
 #include <android-base/stringprintf.h>
 #include <chrono>
 #include <cstdint>
@@ -102,6 +103,10 @@ SpatializerPoseController::SpatializerPoseController(Listener* listener,
                                         std::optional<std::chrono::microseconds> maxUpdatePeriod)
     : mListener(listener),
       mSensorPeriod(sensorPeriod),
+      // Batching sensor events reduces the audioserver wakeups at high sensor rates,
+      // at the cost of up to this much additional pose latency.
+      mSensorReportLatency(std::chrono::milliseconds(std::max(0,
+              property_get_int32("audio.spatializer.sensor_report_latency_ms", 0)))),
       mProcessor(createHeadTrackingProcessor(HeadTrackingProcessor::Options{
               .maxTranslationalVelocity = kMaxTranslationalVelocity / kTicksPerSecond,
               .maxRotationalVelocity = kMaxRotationalVelocity / kTicksPerSecond,
@@ -198,7 +203,8 @@ void SpatializerPoseController::setHeadSensor(int32_t sensor) {
         if (sensor != mScreenSensor) {
             // Start new sensor.
             mHeadSensor =
-                    mPoseProvider->startSensor(sensor, mSensorPeriod) ? sensor : INVALID_SENSOR;
+                    mPoseProvider->startSensor(sensor, mSensorPeriod, mSensorReportLatency)
+                            ? sensor : INVALID_SENSOR;
             if (mHeadSensor != INVALID_SENSOR) {
                 auto sensor = mPoseProvider->getSensorByHandle(mHeadSensor);
                 std::string stringType = sensor ? sensor->getStringType().c_str() : "";
@@ -237,7 +243,8 @@ void SpatializerPoseController::setScreenSensor(int32_t sensor) {
         if (sensor != mHeadSensor) {
             // Start new sensor.
             mScreenSensor =
-                    mPoseProvider->startSensor(sensor, mSensorPeriod) ? sensor : INVALID_SENSOR;
+                    mPoseProvider->startSensor(sensor, mSensorPeriod, mSensorReportLatency)
+                            ? sensor : INVALID_SENSOR;
             auto sensor = mPoseProvider->getSensorByHandle(mScreenSensor);
             std::string stringType = sensor ? sensor->getStringType().c_str() : "";
             mediametrics::LogItem(getSensorMetricsId(mScreenSensor))
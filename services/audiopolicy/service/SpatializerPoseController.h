@@ -121,6 +121,8 @@ class SpatializerPoseController : private media::SensorPoseProvider::Listener {
     mutable std::timed_mutex mMutex;
     Listener* const mListener;
     const std::chrono::microseconds mSensorPeriod;
+    // How long the sensors may batch events, see SensorPoseProvider::startSensor().
+    const std::chrono::microseconds mSensorReportLatency;
     std::unique_ptr<media::HeadTrackingProcessor> mProcessor;
     int32_t mHeadSensor = media::SensorPoseProvider::INVALID_HANDLE;
     int32_t mScreenSensor = media::SensorPoseProvider::INVALID_HANDLE;
@@ -43,6 +43,8 @@ class AudioPolicyTestManager : public AudioPolicyManager {
     using AudioPolicyManager::deviceToAudioPort;
     using AudioPolicyManager::handleDeviceConfigChange;
     uint32_t getAudioPortGeneration() const { return mAudioPortGeneration; }
+    uint32_t getRoutingDecisionHits() const { return mRoutingDecisionHits; }
+    uint32_t getRoutingDecisionMisses() const { return mRoutingDecisionMisses; }
 };
 
 }  // namespace android
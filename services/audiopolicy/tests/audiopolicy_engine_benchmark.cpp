@@ -0,0 +1,153 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Compares the cost of the output device selection of the default and configurable engines.
+//
+// The configurable engine needs the parameter framework configuration of the device, its
+// benchmarks are skipped when it is not installed.
+
+#include <iterator>
+#include <memory>
+#include <unistd.h>
+
+#include <benchmark/benchmark.h>
+#include <system/audio.h>
+
+#include "AudioPolicyManagerTestClient.h"
+#include "AudioPolicyTestManager.h"
+
+using namespace android;
+
+namespace {
+
+constexpr const char* kEngines[] = {"default", "configurable"};
+
+constexpr const char* kPfwConfigFiles[] = {
+    "/vendor/etc/parameter-framework/ParameterFrameworkConfigurationPolicy.xml",
+    "/etc/parameter-framework/ParameterFrameworkConfigurationPolicy.xml",
+};
+
+constexpr audio_usage_t kUsages[] = {
+    AUDIO_USAGE_MEDIA,
+    AUDIO_USAGE_VOICE_COMMUNICATION,
+    AUDIO_USAGE_ALARM,
+    AUDIO_USAGE_NOTIFICATION,
+    AUDIO_USAGE_ASSISTANCE_ACCESSIBILITY,
+    AUDIO_USAGE_ASSISTANCE_NAVIGATION_GUIDANCE,
+    AUDIO_USAGE_ASSISTANCE_SONIFICATION,
+    AUDIO_USAGE_GAME,
+};
+
+bool isEngineAvailable(const std::string& engine) {
+    if (engine != "configurable") {
+        return true;
+    }
+    for (const char* file : kPfwConfigFiles) {
+        if (access(file, R_OK) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+class ManagerFixture {
+  public:
+    explicit ManagerFixture(const std::string& engine) {
+        mConfig = AudioPolicyConfig::createWritableForTests();
+        mConfig->setDefault();
+        mConfig->setEngineLibraryNameSuffix(engine);
+        mClient = std::make_unique<AudioPolicyManagerTestClient>();
+        mManager = std::make_unique<AudioPolicyTestManager>(mConfig, mClient.get());
+        mStatus = mManager->initialize();
+    }
+    ~ManagerFixture() {
+        mManager.reset();
+        mClient.reset();
+    }
+
+    status_t status() const { return mStatus; }
+    AudioPolicyTestManager* manager() { return mManager.get(); }
+
+  private:
+    sp<AudioPolicyConfig> mConfig;
+    std::unique_ptr<AudioPolicyManagerTestClient> mClient;
+    std::unique_ptr<AudioPolicyTestManager> mManager;
+    status_t mStatus = NO_INIT;
+};
+
+std::unique_ptr<ManagerFixture> createFixture(benchmark::State& state) {
+    const std::string engine = kEngines[state.range(0)];
+    state.SetLabel(engine);
+    if (!isEngineAvailable(engine)) {
+        state.SkipWithError("parameter framework configuration not installed");
+        return nullptr;
+    }
+    auto fixture = std::make_unique<ManagerFixture>(engine);
+    if (fixture->status() != NO_ERROR) {
+        state.SkipWithError("cannot initialize the audio policy manager");
+        return nullptr;
+    }
+    return fixture;
+}
+
+}  // namespace
+
+// Device selection with unchanged criteria, e.g. during the routing updates of a playback
+// start or stop.
+static void BM_GetDevicesForAttributes(benchmark::State& state) {
+    auto fixture = createFixture(state);
+    if (fixture == nullptr) {
+        return;
+    }
+    AudioDeviceTypeAddrVector devices;
+    for (auto _ : state) {
+        for (audio_usage_t usage : kUsages) {
+            const audio_attributes_t attr = attributes_initializer(usage);
+            devices.clear();
+            benchmark::DoNotOptimize(fixture->manager()->getDevicesForAttributes(
+                    attr, &devices, false /*forVolume*/));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * std::size(kUsages));
+}
+
+// Device selection right after a criterion change, including the routing update done by the
+// manager for the change itself.
+static void BM_GetDevicesAfterForceUse(benchmark::State& state) {
+    auto fixture = createFixture(state);
+    if (fixture == nullptr) {
+        return;
+    }
+    AudioDeviceTypeAddrVector devices;
+    bool forced = false;
+    for (auto _ : state) {
+        forced = !forced;
+        fixture->manager()->setForceUse(AUDIO_POLICY_FORCE_FOR_MEDIA,
+                forced ? AUDIO_POLICY_FORCE_NO_BT_A2DP : AUDIO_POLICY_FORCE_NONE);
+        for (audio_usage_t usage : kUsages) {
+            const audio_attributes_t attr = attributes_initializer(usage);
+            devices.clear();
+            benchmark::DoNotOptimize(fixture->manager()->getDevicesForAttributes(
+                    attr, &devices, false /*forVolume*/));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * std::size(kUsages));
+}
+
+BENCHMARK(BM_GetDevicesForAttributes)->DenseRange(0, std::size(kEngines) - 1);
+BENCHMARK(BM_GetDevicesAfterForceUse)->DenseRange(0, std::size(kEngines) - 1);
+
+BENCHMARK_MAIN();
@@ -15,7 +15,9 @@
  */
 
 #include <cstring>
+#include <map>
 #include <memory>
+#include <set>
 #include <string>
 #include <sys/wait.h>
 #include <unistd.h>
@@ -24,8 +26,11 @@
 #include <gmock/gmock.h>
 
 #define LOG_TAG "APM_Test"
+#include <IOProfile.h>
 #include <Serializer.h>
 #include <android-base/file.h>
+#include <android-base/stringprintf.h>
+#include <android-base/strings.h>
 #include <android/content/AttributionSourceState.h>
 #include <media/AudioPolicy.h>
 #include <media/PatchBuilder.h>
@@ -124,6 +129,103 @@ TEST(AudioPolicyConfigTest, LoadForTests) {
     }
 }
 
+namespace {
+
+// DeviceVectors are sorted by pointer, so devices are described in tag name order.
+std::string describeDevices(const DeviceVector& devices) {
+    std::set<std::string> tagNames;
+    for (const auto& device : devices) tagNames.insert(device->getTagName());
+    return base::Join(tagNames, ",");
+}
+
+std::string describeConfig(const sp<const AudioPolicyConfig>& config) {
+    std::string result;
+    for (const auto& module : config->getHwModules()) {
+        result += base::StringPrintf("module %s %u.%u\n", module->getName(),
+                module->getHalVersionMajor(), module->getHalVersionMinor());
+        IOProfileCollection mixPorts;
+        for (const auto& profile : module->getOutputProfiles()) mixPorts.add(profile);
+        for (const auto& profile : module->getInputProfiles()) mixPorts.add(profile);
+        for (const auto& mixPort : mixPorts) {
+            mixPort->AudioPort::dump(&result, 2);
+            result += base::StringPrintf("  flags %#x open %u active %u mute %u devices %s\n",
+                    mixPort->getFlags(), mixPort->maxOpenCount, mixPort->maxActiveCount,
+                    mixPort->recommendedMuteDurationMs,
+                    describeDevices(mixPort->getSupportedDevices()).c_str());
+        }
+        std::map<std::string, std::string> devices;
+        for (const auto& device : module->getDeclaredDevices()) {
+            String8 dump;
+            device->dump(&dump, 2);
+            devices[device->getTagName()] = dump.c_str();
+        }
+        for (const auto& [_, dump] : devices) result += dump;
+        for (const auto& route : module->getRoutes()) {
+            std::set<std::string> sources;
+            for (const auto& source : route->getSources()) sources.insert(source->getTagName());
+            result += base::StringPrintf("  route %d %s <- %s\n", route->getType(),
+                    route->getSink()->getTagName().c_str(), base::Join(sources, ",").c_str());
+        }
+    }
+    result += "attached outputs " + describeDevices(config->getOutputDevices()) + "\n";
+    result += "attached inputs " + describeDevices(config->getInputDevices()) + "\n";
+    if (config->getDefaultOutputDevice() != nullptr) {
+        result += "default output " + config->getDefaultOutputDevice()->getTagName() + "\n";
+    }
+    std::map<audio_format_t, std::set<audio_format_t>> surroundFormats;
+    for (const auto& [format, subFormats] : config->getSurroundFormats()) {
+        surroundFormats[format].insert(subFormats.begin(), subFormats.end());
+    }
+    for (const auto& [format, subFormats] : surroundFormats) {
+        result += base::StringPrintf("surround %#x: %s\n", format,
+                base::Join(subFormats, ",").c_str());
+    }
+    result += base::StringPrintf("engine %s call screen %d\n",
+            config->getEngineLibraryNameSuffix().c_str(), config->isCallScreenModeSupported());
+    return result;
+}
+
+}  // namespace
+
+class AudioPolicyConfigSnapshotTest : public testing::TestWithParam<const char*> {};
+
+TEST_P(AudioPolicyConfigSnapshotTest, SameAsXml) {
+    const std::string source = base::GetExecutableDirectory() + "/" + GetParam();
+    TemporaryDir tempDir;
+    const std::string snapshot = std::string(tempDir.path) + "/config.snapshot";
+
+    auto xmlResult = AudioPolicyConfig::loadFromCustomXmlConfigForTests(source, snapshot);
+    ASSERT_TRUE(xmlResult.ok());
+    ASSERT_EQ(0, access(snapshot.c_str(), R_OK));
+    auto snapshotResult = AudioPolicyConfig::loadFromCustomXmlConfigForTests(source, snapshot);
+    ASSERT_TRUE(snapshotResult.ok());
+    EXPECT_EQ(source, snapshotResult.value()->getSource());
+    EXPECT_EQ(describeConfig(xmlResult.value()), describeConfig(snapshotResult.value()));
+}
+
+TEST_P(AudioPolicyConfigSnapshotTest, CorruptedSnapshotIsIgnored) {
+    const std::string source = base::GetExecutableDirectory() + "/" + GetParam();
+    TemporaryDir tempDir;
+    const std::string snapshot = std::string(tempDir.path) + "/config.snapshot";
+
+    auto xmlResult = AudioPolicyConfig::loadFromCustomXmlConfigForTests(source, snapshot);
+    ASSERT_TRUE(xmlResult.ok());
+    std::string content;
+    ASSERT_TRUE(base::ReadFileToString(snapshot, &content));
+    ASSERT_TRUE(base::WriteStringToFile(content.substr(0, content.size() / 2), snapshot));
+    auto result = AudioPolicyConfig::loadFromCustomXmlConfigForTests(source, snapshot);
+    ASSERT_TRUE(result.ok());
+    EXPECT_EQ(describeConfig(xmlResult.value()), describeConfig(result.value()));
+}
+
+INSTANTIATE_TEST_SUITE_P(
+        AudioPolicyConfig,
+        AudioPolicyConfigSnapshotTest,
+        testing::Values("test_audio_policy_configuration.xml",
+                        "test_audio_policy_primary_only_configuration.xml",
+                        "test_settop_box_surround_configuration.xml",
+                        "test_tv_apm_configuration.xml"));
+
 TEST(AudioPolicyManagerTestInit, EngineFailure) {
     AudioPolicyTestClient client;
     auto config = AudioPolicyConfig::createWritableForTests();
@@ -381,6 +483,48 @@ TEST_F(AudioPolicyManagerTest, Dump) {
     dumpToLog();
 }
 
+TEST_F(AudioPolicyManagerTest, RoutingDecisionIsReused) {
+    auto requestOutput = [this](audio_io_handle_t *output, audio_port_handle_t *portId) {
+        audio_attributes_t attr = {};
+        audio_stream_type_t stream = AUDIO_STREAM_DEFAULT;
+        audio_config_t config = AUDIO_CONFIG_INITIALIZER;
+        config.sample_rate = k48000SamplingRate;
+        config.channel_mask = AUDIO_CHANNEL_OUT_STEREO;
+        config.format = AUDIO_FORMAT_PCM_16_BIT;
+        audio_output_flags_t flags = AUDIO_OUTPUT_FLAG_NONE;
+        audio_port_handle_t selectedDeviceId = AUDIO_PORT_HANDLE_NONE;
+        std::vector<audio_io_handle_t> secondaryOutputs;
+        AudioPolicyInterface::output_type_t outputType;
+        bool isSpatialized;
+        bool isBitPerfect;
+        *portId = AUDIO_PORT_HANDLE_NONE;
+        ASSERT_EQ(OK, mManager->getOutputForAttr(
+                        &attr, output, AUDIO_SESSION_NONE, &stream,
+                        createAttributionSourceState(/*uid=*/ 0), &config, &flags,
+                        &selectedDeviceId, portId, &secondaryOutputs, &outputType,
+                        &isSpatialized, &isBitPerfect));
+        ASSERT_NE(AUDIO_IO_HANDLE_NONE, *output);
+    };
+
+    audio_io_handle_t output1 = AUDIO_IO_HANDLE_NONE, output2 = AUDIO_IO_HANDLE_NONE;
+    audio_port_handle_t portId1, portId2;
+    ASSERT_NO_FATAL_FAILURE(requestOutput(&output1, &portId1));
+    const uint32_t misses = mManager->getRoutingDecisionMisses();
+    const uint32_t hits = mManager->getRoutingDecisionHits();
+    ASSERT_NO_FATAL_FAILURE(requestOutput(&output2, &portId2));
+    EXPECT_EQ(output1, output2);
+    EXPECT_NE(portId1, portId2);
+    EXPECT_EQ(hits + 1, mManager->getRoutingDecisionHits());
+    EXPECT_EQ(misses, mManager->getRoutingDecisionMisses());
+
+    // a policy change invalidates the memoized decisions.
+    mManager->setForceUse(AUDIO_POLICY_FORCE_FOR_MEDIA, AUDIO_POLICY_FORCE_NONE);
+    ASSERT_NO_FATAL_FAILURE(requestOutput(&output2, &portId2));
+    EXPECT_EQ(output1, output2);
+    EXPECT_EQ(hits + 1, mManager->getRoutingDecisionHits());
+    EXPECT_EQ(misses + 1, mManager->getRoutingDecisionMisses());
+}
+
 TEST_F(AudioPolicyManagerTest, CreateAudioPatchFailure) {
     audio_patch patch{};
     audio_patch_handle_t handle = AUDIO_PATCH_HANDLE_NONE;
@@ -16,6 +16,11 @@
 
 #define LOG_TAG "CameraServiceWatchdog"
 
+#include <algorithm>
+
+#include <cutils/properties.h>
+#include <mediautils/MediaUtilsDelayed.h>
+
 #include "CameraServiceWatchdog.h"
 #include "android/set_abort_message.h"
 #include "utils/CameraServiceProxyWrapper.h"
@@ -34,6 +39,7 @@ bool CameraServiceWatchdog::threadLoop()
 
     std::this_thread::sleep_for(std::chrono::milliseconds(mCycleLengthMs));
 
+    std::vector<std::pair<uint32_t, std::string>> samples;
     {
         AutoMutex _l(mWatchdogLock);
 
@@ -42,6 +48,10 @@ bool CameraServiceWatchdog::threadLoop()
 
             mTidMap[currentThreadId].cycles++;
 
+            if (mProfilingEnabled && mTidMap[currentThreadId].cycles % kSoftThresholdCycles == 0) {
+                samples.emplace_back(currentThreadId, mTidMap[currentThreadId].functionName);
+            }
+
             if (mTidMap[currentThreadId].cycles >= mMaxCycles) {
                 std::string abortMessage = getAbortMessage(mTidMap[currentThreadId].functionName);
                 android_set_abort_message(abortMessage.c_str());
@@ -56,9 +66,107 @@ bool CameraServiceWatchdog::threadLoop()
         }
     }
 
+    if (!samples.empty()) {
+        sampleHotspots(samples);
+    }
+
     return true;
 }
 
+bool CameraServiceWatchdog::isProfilingEnabled() {
+    return property_get_bool("camera.watchdog.profiling", false);
+}
+
+void CameraServiceWatchdog::sampleHotspots(
+        const std::vector<std::pair<uint32_t, std::string>>& samples) {
+    for (const auto& [tid, functionName] : samples) {
+        std::string callStack = mediautils::getCallStackStringForTid(tid);
+        std::string key = functionName + "\n" + callStack;
+
+        {
+            AutoMutex _l(mWatchdogLock);
+            auto it = mTidMap.find(tid);
+            if (it == mTidMap.end() || it->second.functionName != functionName) {
+                // The call finished while unwinding; the stack is not representative.
+                continue;
+            }
+            bool newCall = it->second.hotspotKey.empty();
+            it->second.hotspotKey = key;
+
+            std::lock_guard<std::mutex> l(mHotspotLock);
+            auto hotspot = mHotspots.find(key);
+            if (hotspot == mHotspots.end()) {
+                if (mHotspots.size() >= kMaxHotspots) {
+                    // Evict the least sampled call site
+                    auto minIt = std::min_element(mHotspots.begin(), mHotspots.end(),
+                            [](const auto& a, const auto& b) {
+                                return a.second.sampleCount < b.second.sampleCount; });
+                    mHotspots.erase(minIt);
+                }
+                hotspot = mHotspots.emplace(key, Hotspot{functionName, callStack}).first;
+            }
+            hotspot->second.sampleCount++;
+            if (newCall) hotspot->second.callCount++;
+            hotspot->second.maxCycles = std::max(hotspot->second.maxCycles, it->second.cycles);
+        }
+        ALOGW("%s: Camera %s: %s on tid %d still running after %u ms", __FUNCTION__,
+                mCameraId.string(), functionName.c_str(), tid,
+                kSoftThresholdCycles * mCycleLengthMs);
+    }
+}
+
+void CameraServiceWatchdog::mergeHotspots(CameraServiceWatchdog& other) {
+    if (!mProfilingEnabled) return;
+
+    std::unordered_map<std::string, Hotspot> otherHotspots;
+    {
+        std::lock_guard<std::mutex> l(other.mHotspotLock);
+        otherHotspots = std::move(other.mHotspots);
+        other.mHotspots.clear();
+    }
+
+    // Convert the other watchdog's cycles to this watchdog's cycle length
+    uint32_t cycleLengthMs = other.mCycleLengthMs;
+    std::lock_guard<std::mutex> l(mHotspotLock);
+    for (auto& [key, otherHotspot] : otherHotspots) {
+        otherHotspot.maxCycles = otherHotspot.maxCycles * cycleLengthMs / mCycleLengthMs;
+        auto it = mHotspots.find(key);
+        if (it == mHotspots.end()) {
+            if (mHotspots.size() < kMaxHotspots) {
+                mHotspots.emplace(key, std::move(otherHotspot));
+            }
+            continue;
+        }
+        it->second.sampleCount += otherHotspot.sampleCount;
+        it->second.callCount += otherHotspot.callCount;
+        it->second.maxCycles = std::max(it->second.maxCycles, otherHotspot.maxCycles);
+    }
+}
+
+void CameraServiceWatchdog::dump(int fd) {
+    if (!mProfilingEnabled) return;
+
+    std::vector<Hotspot> hotspots;
+    {
+        std::lock_guard<std::mutex> l(mHotspotLock);
+        hotspots.reserve(mHotspots.size());
+        for (const auto& [key, hotspot] : mHotspots) {
+            hotspots.push_back(hotspot);
+        }
+    }
+    std::sort(hotspots.begin(), hotspots.end(), [](const Hotspot& a, const Hotspot& b) {
+            return a.sampleCount > b.sampleCount; });
+
+    dprintf(fd, "    Watchdog hotspots (calls slower than %u ms): %zu\n",
+            kSoftThresholdCycles * mCycleLengthMs, hotspots.size());
+    for (const auto& hotspot : hotspots) {
+        dprintf(fd, "      %s: %zu samples over %zu calls, longest %u ms\n",
+                hotspot.functionName.c_str(), hotspot.sampleCount, hotspot.callCount,
+                hotspot.maxCycles * mCycleLengthMs);
+        dprintf(fd, "%s\n", hotspot.callStack.c_str());
+    }
+}
+
 std::string CameraServiceWatchdog::getAbortMessage(const std::string& functionName) {
     std::string res = "CameraServiceWatchdog triggering abort during "
             + functionName;
@@ -94,6 +202,15 @@ void CameraServiceWatchdog::stop(uint32_t tid)
 {
     AutoMutex _l(mWatchdogLock);
 
+    auto it = mTidMap.find(tid);
+    if (it != mTidMap.end() && !it->second.hotspotKey.empty()) {
+        // Record the full duration of a sampled call
+        std::lock_guard<std::mutex> l(mHotspotLock);
+        auto hotspot = mHotspots.find(it->second.hotspotKey);
+        if (hotspot != mHotspots.end()) {
+            hotspot->second.maxCycles = std::max(hotspot->second.maxCycles, it->second.cycles);
+        }
+    }
     mTidMap.erase(tid);
 
     if (mTidMap.empty()) {
@@ -27,15 +27,22 @@
  *   more details.
  * To disable/enable:
  *   - adb shell cmd media.camera set-cameraservice-watchdog [0/1]
+ * Profiling mode:
+ *   - When the camera.watchdog.profiling property is set, calls that are still
+ *   running after kSoftThresholdCycles have the stack of the blocked thread
+ *   sampled once per soft threshold period. Samples are aggregated per call
+ *   site and reported in the camera device dumpsys output.
  */
 #pragma once
 #include <chrono>
+#include <mutex>
 #include <thread>
 #include <time.h>
 #include <utils/String8.h>
 #include <utils/Thread.h>
 #include <utils/Log.h>
 #include <unordered_map>
+#include <vector>
 
 #include "utils/CameraServiceProxyWrapper.h"
 
@@ -47,6 +54,8 @@
 // Default cycles and cycle length values used to calculate permitted elapsed time
 const static size_t   kMaxCycles     = 100;
 const static uint32_t kCycleLengthMs = 100;
+// Cycles after which a still running call is sampled in profiling mode
+const static uint32_t kSoftThresholdCycles = 5;
 
 namespace android {
 
@@ -55,6 +64,16 @@ class CameraServiceWatchdog : public Thread {
 struct MonitoredFunction {
     uint32_t cycles;
     std::string functionName;
+    std::string hotspotKey;             // Last sampled call site, empty if not sampled
+};
+
+// Aggregated stack samples of calls exceeding the soft threshold
+struct Hotspot {
+    std::string functionName;
+    std::string callStack;
+    size_t sampleCount = 0;             // Number of soft threshold periods sampled
+    size_t callCount = 0;               // Number of calls that hit this call site
+    uint32_t maxCycles = 0;             // Longest observed call, in cycles
 };
 
 public:
@@ -62,6 +81,7 @@ public:
             std::shared_ptr<CameraServiceProxyWrapper> cameraServiceProxyWrapper) :
                     mCameraId(cameraId), mPause(true), mMaxCycles(kMaxCycles),
                     mCycleLengthMs(kCycleLengthMs), mEnabled(true),
+                    mProfilingEnabled(isProfilingEnabled()),
                     mCameraServiceProxyWrapper(cameraServiceProxyWrapper) {};
 
     explicit CameraServiceWatchdog (const String8 &cameraId, size_t maxCycles,
@@ -69,6 +89,7 @@ public:
             std::shared_ptr<CameraServiceProxyWrapper> cameraServiceProxyWrapper) :
                     mCameraId(cameraId), mPause(true), mMaxCycles(maxCycles),
                     mCycleLengthMs(cycleLengthMs), mEnabled(enabled),
+                    mProfilingEnabled(isProfilingEnabled()),
                     mCameraServiceProxyWrapper(cameraServiceProxyWrapper) {};
 
     virtual ~CameraServiceWatchdog() {};
@@ -78,6 +99,9 @@ public:
     /** Enables/disables the watchdog */
     void setEnabled(bool enable);
 
+    /** Dumps the aggregated hotspots collected in profiling mode */
+    void dump(int fd);
+
     /** Used to wrap monitored calls in start and stop functions using custom timer values */
     template<typename T>
     auto watchThread(T func, uint32_t tid, const char* functionName, uint32_t cycles,
@@ -103,6 +127,7 @@ public:
 
             res = tempWatchdog->watchThread(func, tid, functionName);
             tempWatchdog->requestExit();
+            mergeHotspots(*tempWatchdog);
             tempWatchdog.clear();
         } else {
             // If custom timer values are equivalent to set class timer values, use
@@ -146,6 +171,17 @@ private:
 
     std::string getAbortMessage(const std::string& functionName);
 
+    static bool isProfilingEnabled();
+
+    /**
+     * Captures the stacks of the given threads and aggregates them into mHotspots.
+     * Must be called without mWatchdogLock held since unwinding is slow.
+     */
+    void sampleHotspots(const std::vector<std::pair<uint32_t, std::string>>& samples);
+
+    /** Adds the hotspots collected by another watchdog instance */
+    void mergeHotspots(CameraServiceWatchdog& other);
+
     virtual bool    threadLoop();
 
     Mutex           mWatchdogLock;      // Lock for condition variable
@@ -156,12 +192,17 @@ private:
     uint32_t        mMaxCycles;         // Max cycles
     uint32_t        mCycleLengthMs;     // Length of time elapsed per cycle
     bool            mEnabled;           // True if watchdog is enabled
+    const bool      mProfilingEnabled;  // True if slow calls are sampled
 
     std::shared_ptr<CameraServiceProxyWrapper> mCameraServiceProxyWrapper;
 
     std::unordered_map<uint32_t, MonitoredFunction> mTidMap; // Thread Id to MonitoredFunction type
                                                              // which retrieves the num of cycles
                                                              // and name of the function
+
+    static const size_t kMaxHotspots = 16;
+    std::mutex mHotspotLock;
+    std::unordered_map<std::string, Hotspot> mHotspots; // Call site to aggregated samples
 };
 
 }   // namespace android
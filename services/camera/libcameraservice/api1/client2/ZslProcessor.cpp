@@ -26,9 +26,11 @@
 #endif
 
 #include <inttypes.h>
+#include <algorithm>
 
 #include <utils/Log.h>
 #include <utils/Trace.h>
+#include <cutils/properties.h>
 #include <gui/Surface.h>
 
 #include "common/CameraDeviceBase.h"
@@ -45,6 +47,8 @@ namespace camera2 {
 using android::camera3::CAMERA_STREAM_ROTATION_0;
 using android::camera3::CAMERA_TEMPLATE_STILL_CAPTURE;
 
+const char *ZslProcessor::kZslRingBudgetProperty = "camera.zsl.ring_budget_kb";
+
 namespace {
 struct TimestampFinder : public RingBufferConsumer::RingBufferComparator {
     typedef RingBufferConsumer::BufferInfo BufferInfo;
@@ -176,6 +180,7 @@ ZslProcessor::ZslProcessor(
 
     mZslQueue.insertAt(0, mBufferQueueDepth);
     mFrameList.resize(mFrameListDepth);
+    mFrameInfo.resize(mFrameListDepth);
     sp<CaptureSequencer> captureSequencer = mSequencer.promote();
     if (captureSequencer != 0) captureSequencer->setZslProcessor(this);
 }
@@ -212,6 +217,7 @@ void ZslProcessor::onResultAvailable(const CaptureResult &result) {
     if (timestamp <= mLatestClearedBufferTimestamp) return;
 
     mFrameList[mFrameListHead] = result.mMetadata;
+    indexFrameLocked(mFrameListHead, mFrameList[mFrameListHead]);
     mFrameListHead = (mFrameListHead + 1) % mFrameListDepth;
 }
 
@@ -253,6 +259,8 @@ status_t ZslProcessor::updateStream(const Parameters &params) {
         sp<IGraphicBufferProducer> producer;
         sp<IGraphicBufferConsumer> consumer;
         BufferQueue::createBufferQueue(&producer, &consumer);
+        applyRingBudgetLocked(params.fastInfo.usedZslSize.width,
+                params.fastInfo.usedZslSize.height);
         mProducer = new RingBufferConsumer(consumer, GRALLOC_USAGE_HW_CAMERA_ZSL,
             mBufferQueueDepth);
         mProducer->setName(String8("Camera2-ZslRingBufferConsumer"));
@@ -675,6 +683,100 @@ void ZslProcessor::clearZslResultQueueLocked() {
     mFrameList.clear();
     mFrameListHead = 0;
     mFrameList.resize(mFrameListDepth);
+    mFrameInfo.clear();
+    mFrameInfo.resize(mFrameListDepth);
+    mCandidates.clear();
+}
+
+void ZslProcessor::applyRingBudgetLocked(int32_t width, int32_t height) {
+    int32_t budgetKb = property_get_int32(kZslRingBudgetProperty, 0);
+    if (budgetKb <= 0 || width <= 0 || height <= 0) {
+        return;
+    }
+
+    // ZSL buffers are implementation defined; assume YUV 4:2:0 layout.
+    size_t bufferSize = static_cast<size_t>(width) * height * 3 / 2;
+    size_t depth = std::max(static_cast<size_t>(budgetKb) * 1024 / bufferSize,
+            kMinBufferQueueDepth);
+    if (depth == mBufferQueueDepth) {
+        return;
+    }
+
+    ALOGV("%s: Camera %d: ZSL ring depth %zu -> %zu for a %d KB budget", __FUNCTION__, mId,
+            mBufferQueueDepth, depth, budgetKb);
+    mBufferQueueDepth = depth;
+    mFrameListDepth = depth - 1;
+    mZslQueue.clear();
+    mZslQueue.insertAt(0, mBufferQueueDepth);
+    clearZslResultQueueLocked();
+}
+
+bool ZslProcessor::isGoodCandidate(const ZslFrameInfo &info) const {
+    if (info.aeState == -1) {
+        /**
+         * This is most likely a HAL bug. The aeState field is
+         * mandatory, so it should always be in a metadata packet.
+         */
+        ALOGW("%s: ZSL queue frame has no AE state field!", __FUNCTION__);
+        return false;
+    }
+    if (info.aeState != ANDROID_CONTROL_AE_STATE_CONVERGED &&
+            info.aeState != ANDROID_CONTROL_AE_STATE_LOCKED) {
+        ALOGVV("%s: ZSL queue frame AE state is %d, need full capture", __FUNCTION__,
+                info.aeState);
+        return false;
+    }
+
+    if (info.afMode == -1) {
+        ALOGW("%s: ZSL queue frame has no AF mode field!", __FUNCTION__);
+        return false;
+    }
+    // Check AF state if device has focuser and focus mode isn't fixed
+    if (mHasFocuser && !isFixedFocusMode(info.afMode)) {
+        // Make sure the candidate frame has good focus.
+        if (info.afState == -1) {
+            ALOGW("%s: ZSL queue frame has no AF state field!", __FUNCTION__);
+            return false;
+        }
+        if (info.afState != ANDROID_CONTROL_AF_STATE_PASSIVE_FOCUSED &&
+                info.afState != ANDROID_CONTROL_AF_STATE_FOCUSED_LOCKED &&
+                info.afState != ANDROID_CONTROL_AF_STATE_NOT_FOCUSED_LOCKED) {
+            ALOGVV("%s: ZSL queue frame AF state is %d is not good for capture, skip it",
+                    __FUNCTION__, info.afState);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void ZslProcessor::indexFrameLocked(size_t idx, const CameraMetadata &frame) {
+    ZslFrameInfo &info = mFrameInfo[idx];
+    if (info.isCandidate) {
+        mCandidates.erase(std::make_pair(info.timestamp, idx));
+    }
+    info = ZslFrameInfo();
+
+    camera_metadata_ro_entry_t entry = frame.find(ANDROID_SENSOR_TIMESTAMP);
+    if (entry.count == 0) {
+        ALOGE("%s: Can't find timestamp in frame!", __FUNCTION__);
+        return;
+    }
+    info.valid = true;
+    info.timestamp = entry.data.i64[0];
+    entry = frame.find(ANDROID_CONTROL_AE_STATE);
+    if (entry.count > 0) info.aeState = entry.data.u8[0];
+    entry = frame.find(ANDROID_CONTROL_AF_MODE);
+    if (entry.count > 0) info.afMode = entry.data.u8[0];
+    entry = frame.find(ANDROID_CONTROL_AF_STATE);
+    if (entry.count > 0) info.afState = entry.data.u8[0];
+    entry = frame.find(ANDROID_LENS_STATE);
+    if (entry.count > 0) info.lensState = entry.data.u8[0];
+
+    info.isCandidate = isGoodCandidate(info);
+    if (info.isCandidate) {
+        mCandidates.emplace(info.timestamp, idx);
+    }
 }
 
 void ZslProcessor::dump(int fd, const Vector<String16>& /*args*/) const {
@@ -735,6 +837,26 @@ void ZslProcessor::dumpZslQueue(int fd) const {
         }
 
     }
+
+    String8 index = String8::format("ZSL candidate index (%zu candidates, ring depth %zu):",
+            mCandidates.size(), mBufferQueueDepth);
+    ALOGV("%s", index.string());
+    if (fd != -1) {
+        index = indent + index + "\n";
+        write(fd, index.string(), index.size());
+    }
+    for (size_t i = 0; i < mFrameInfo.size(); i++) {
+        const ZslFrameInfo &info = mFrameInfo[i];
+        if (!info.valid) continue;
+        String8 result = String8::format("   %zu: f: %" PRId64 ", AE state: %d, AF mode: %d,"
+                " AF state: %d, lens state: %d%s", i, info.timestamp, info.aeState, info.afMode,
+                info.afState, info.lensState, info.isCandidate ? " (candidate)" : "");
+        ALOGV("%s", result.string());
+        if (fd != -1) {
+            result = indent + result + "\n";
+            write(fd, result.string(), result.size());
+        }
+    }
 }
 
 bool ZslProcessor::isFixedFocusMode(uint8_t afMode) const {
@@ -758,84 +880,19 @@ nsecs_t ZslProcessor::getCandidateTimestampLocked(size_t* metadataIdx) const {
     /**
      * Find the smallest timestamp we know about so far
      * - ensure that aeState is either converged or locked
+     *
+     * Frames are checked against the selection criteria as their results
+     * arrive, so the oldest good candidate is simply the head of the index.
      */
 
     size_t idx = 0;
     nsecs_t minTimestamp = -1;
 
-    size_t emptyCount = mFrameList.size();
-
-    for (size_t j = 0; j < mFrameList.size(); j++) {
-        const CameraMetadata &frame = mFrameList[j];
-        if (!frame.isEmpty()) {
-
-            emptyCount--;
-
-            camera_metadata_ro_entry_t entry;
-            entry = frame.find(ANDROID_SENSOR_TIMESTAMP);
-            if (entry.count == 0) {
-                ALOGE("%s: Can't find timestamp in frame!",
-                        __FUNCTION__);
-                continue;
-            }
-            nsecs_t frameTimestamp = entry.data.i64[0];
-            if (minTimestamp > frameTimestamp || minTimestamp == -1) {
-
-                entry = frame.find(ANDROID_CONTROL_AE_STATE);
-
-                if (entry.count == 0) {
-                    /**
-                     * This is most likely a HAL bug. The aeState field is
-                     * mandatory, so it should always be in a metadata packet.
-                     */
-                    ALOGW("%s: ZSL queue frame has no AE state field!",
-                            __FUNCTION__);
-                    continue;
-                }
-                if (entry.data.u8[0] != ANDROID_CONTROL_AE_STATE_CONVERGED &&
-                        entry.data.u8[0] != ANDROID_CONTROL_AE_STATE_LOCKED) {
-                    ALOGVV("%s: ZSL queue frame AE state is %d, need "
-                           "full capture",  __FUNCTION__, entry.data.u8[0]);
-                    continue;
-                }
-
-                entry = frame.find(ANDROID_CONTROL_AF_MODE);
-                if (entry.count == 0) {
-                    ALOGW("%s: ZSL queue frame has no AF mode field!",
-                            __FUNCTION__);
-                    continue;
-                }
-                // Check AF state if device has focuser and focus mode isn't fixed
-                if (mHasFocuser) {
-                    uint8_t afMode = entry.data.u8[0];
-                    if (!isFixedFocusMode(afMode)) {
-                        // Make sure the candidate frame has good focus.
-                        entry = frame.find(ANDROID_CONTROL_AF_STATE);
-                        if (entry.count == 0) {
-                            ALOGW("%s: ZSL queue frame has no AF state field!",
-                                    __FUNCTION__);
-                            continue;
-                        }
-                        uint8_t afState = entry.data.u8[0];
-                        if (afState != ANDROID_CONTROL_AF_STATE_PASSIVE_FOCUSED &&
-                                afState != ANDROID_CONTROL_AF_STATE_FOCUSED_LOCKED &&
-                                afState != ANDROID_CONTROL_AF_STATE_NOT_FOCUSED_LOCKED) {
-                            ALOGVV("%s: ZSL queue frame AF state is %d is not good for capture,"
-                                    " skip it", __FUNCTION__, afState);
-                            continue;
-                        }
-                    }
-                }
-
-                minTimestamp = frameTimestamp;
-                idx = j;
-            }
-
-            ALOGVV("%s: Saw timestamp %" PRId64, __FUNCTION__, frameTimestamp);
-        }
-    }
-
-    if (emptyCount == mFrameList.size()) {
+    if (!mCandidates.empty()) {
+        minTimestamp = mCandidates.begin()->first;
+        idx = mCandidates.begin()->second;
+    } else if (std::none_of(mFrameInfo.begin(), mFrameInfo.end(),
+            [](const ZslFrameInfo &info) { return info.valid; })) {
         /**
          * This could be mildly bad and means our ZSL was triggered before
          * there were any frames yet received by the camera framework.
@@ -851,8 +908,8 @@ nsecs_t ZslProcessor::getCandidateTimestampLocked(size_t* metadataIdx) const {
         ALOGW("%s: ZSL queue has no metadata frames", __FUNCTION__);
     }
 
-    ALOGV("%s: Candidate timestamp %" PRId64 " (idx %zu), empty frames: %zu",
-          __FUNCTION__, minTimestamp, idx, emptyCount);
+    ALOGV("%s: Candidate timestamp %" PRId64 " (idx %zu), candidates: %zu",
+          __FUNCTION__, minTimestamp, idx, mCandidates.size());
 
     if (metadataIdx) {
         *metadataIdx = idx;
@@ -28,6 +28,10 @@
 #include <gui/IProducerListener.h>
 #include <camera/CameraMetadata.h>
 
+#include <set>
+#include <utility>
+#include <vector>
+
 #include "api1/client2/FrameProcessor.h"
 
 namespace android {
@@ -128,6 +132,29 @@ class ZslProcessor :
     std::vector<CameraMetadata> mFrameList;
     size_t mFrameListHead;
 
+    // Result fields relevant for ZSL candidate selection, extracted once per
+    // frame when the result arrives. Indexed like mFrameList.
+    struct ZslFrameInfo {
+        bool valid = false;
+        nsecs_t timestamp = 0;
+        int32_t aeState = -1;
+        int32_t afMode = -1;
+        int32_t afState = -1;
+        // Lens state at exposure; frames captured while the lens is moving
+        // are likely to be blurred.
+        int32_t lensState = -1;
+        bool isCandidate = false;
+    };
+    std::vector<ZslFrameInfo> mFrameInfo;
+    // (timestamp, frame list index) of all entries that are good enough for
+    // reprocessing, ordered by timestamp.
+    std::set<std::pair<nsecs_t, size_t>> mCandidates;
+
+    // Optional ZSL ring memory budget; when set the ring depth is derived from
+    // it instead of the pipeline depth.
+    static const char *kZslRingBudgetProperty;
+    static constexpr size_t kMinBufferQueueDepth = 2;
+
     ZslPair mNextPair;
 
     Vector<ZslPair> mZslQueue;
@@ -151,6 +178,14 @@ class ZslProcessor :
 
     void clearZslResultQueueLocked();
 
+    // Resize the ZSL ring according to the memory budget property, if any.
+    void applyRingBudgetLocked(int32_t width, int32_t height);
+
+    // Extract the candidate selection fields of a result and update the
+    // candidate index for frame list slot |idx|.
+    void indexFrameLocked(size_t idx, const CameraMetadata &frame);
+    bool isGoodCandidate(const ZslFrameInfo &info) const;
+
     void dumpZslQueue(int id) const;
 
     nsecs_t getCandidateTimestampLocked(size_t* metadataIdx) const;
@@ -86,6 +86,9 @@ public:
     // Get composite stream stats
     virtual void getStreamStats(hardware::CameraStreamStats* streamStats /*out*/) = 0;
 
+    // Dump composite stream specific processing state
+    virtual void dump(int /*fd*/, const Vector<String16>& /*args*/) {}
+
     void onResultAvailable(const CaptureResult& result);
     bool onError(int32_t errorCode, const CaptureResultExtras& resultExtras);
 
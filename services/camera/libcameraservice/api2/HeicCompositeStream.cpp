@@ -1598,9 +1598,43 @@ status_t HeicCompositeStream::copyOneYuvTile(sp<MediaCodecBuffer>& codecBuffer,
                     imageInfo->mPlane[MediaImage2::V].mRowInc * (row - top/2);
             mFnCopyRow(yuvBuffer.dataCr+row*yuvBuffer.chromaStride+left/2, dst, width/2);
         }
+    } else if (isCodecUvPlannar && yuvBuffer.chromaStep == 2) {
+        // Semiplannar camera chroma to plannar codec chroma: deinterleave
+        // with libyuv rather than one sample at a time.
+        size_t chromaRows = (top+height)/2 - top/2;
+        const uint8_t *src = std::min(yuvBuffer.dataCb, yuvBuffer.dataCr) +
+                (top/2)*yuvBuffer.chromaStride + left;
+        uint8_t *dstU = codecBuffer->data() + imageInfo->mPlane[MediaImage2::U].mOffset;
+        uint8_t *dstV = codecBuffer->data() + imageInfo->mPlane[MediaImage2::V].mOffset;
+        int32_t strideU = imageInfo->mPlane[MediaImage2::U].mRowInc;
+        int32_t strideV = imageInfo->mPlane[MediaImage2::V].mRowInc;
+        if (cameraUPlaneFirst) {
+            libyuv::SplitUVPlane(src, yuvBuffer.chromaStride, dstU, strideU, dstV, strideV,
+                    width/2, chromaRows);
+        } else {
+            libyuv::SplitUVPlane(src, yuvBuffer.chromaStride, dstV, strideV, dstU, strideU,
+                    width/2, chromaRows);
+        }
+    } else if (isCodecUvSemiplannar && yuvBuffer.chromaStep == 1) {
+        // Plannar camera chroma to semiplannar codec chroma: interleave with
+        // libyuv in the codec's UV order.
+        size_t chromaRows = (top+height)/2 - top/2;
+        size_t srcOffset = (top/2)*yuvBuffer.chromaStride + left/2;
+        const uint8_t *srcU = yuvBuffer.dataCb + srcOffset;
+        const uint8_t *srcV = yuvBuffer.dataCr + srcOffset;
+        uint8_t *dst = codecBuffer->data() + std::min(imageInfo->mPlane[MediaImage2::U].mOffset,
+                imageInfo->mPlane[MediaImage2::V].mOffset);
+        int32_t dstStride = imageInfo->mPlane[MediaImage2::U].mRowInc;
+        if (codecUPlaneFirst) {
+            libyuv::MergeUVPlane(srcU, yuvBuffer.chromaStride, srcV, yuvBuffer.chromaStride,
+                    dst, dstStride, width/2, chromaRows);
+        } else {
+            libyuv::MergeUVPlane(srcV, yuvBuffer.chromaStride, srcU, yuvBuffer.chromaStride,
+                    dst, dstStride, width/2, chromaRows);
+        }
     } else {
-        // Convert between semiplannar and plannar, or when UV orders are
-        // different.
+        // Convert when UV orders of semiplannar buffers are different, or
+        // for any other layout.
         uint8_t *dst = codecBuffer->data();
         for (auto row = top/2; row < (top+height)/2; row++) {
             for (auto col = left/2; col < (left+width)/2; col++) {
@@ -32,6 +32,9 @@
 #include "utils/SessionConfigurationUtils.h"
 #include <utils/Trace.h>
 
+#include <future>
+#include <inttypes.h>
+
 #include "JpegRCompositeStream.h"
 
 namespace android {
@@ -232,12 +235,33 @@ int64_t JpegRCompositeStream::getNextFailingInputLocked(int64_t *currentTs /*ino
     return ret;
 }
 
+status_t JpegRCompositeStream::dequeueOutputBuffer(size_t bufferSize,
+        ANativeWindowBuffer** anb /*out*/, int* fenceFd /*out*/) {
+    ATRACE_CALL();
+    status_t res;
+    if ((res = native_window_set_buffers_dimensions(mOutputSurface.get(), bufferSize, 1))
+            != OK) {
+        ALOGE("%s: Unable to configure stream buffer dimensions"
+                " %zux%u for stream %d", __FUNCTION__, bufferSize, 1U, mP010StreamId);
+        return res;
+    }
+
+    sp<ANativeWindow> outputANW = mOutputSurface;
+    res = outputANW->dequeueBuffer(mOutputSurface.get(), anb, fenceFd);
+    if (res != OK) {
+        ALOGE("%s: Error retrieving output buffer: %s (%d)", __FUNCTION__, strerror(-res),
+                res);
+    }
+    return res;
+}
+
 status_t JpegRCompositeStream::processInputFrame(nsecs_t ts, const InputFrame &inputFrame) {
     status_t res;
     sp<ANativeWindow> outputANW = mOutputSurface;
     ANativeWindowBuffer *anb;
     int fenceFd;
     void *dstBuffer;
+    nsecs_t startNs = systemTime();
 
     size_t maxJpegRBufferSize = 0;
     if (mMaxJpegBufferSize > 0) {
@@ -254,25 +278,61 @@ status_t JpegRCompositeStream::processInputFrame(nsecs_t ts, const InputFrame &i
         maxJpegRBufferSize = inputFrame.p010Buffer.width * inputFrame.p010Buffer.height;
     }
 
+    // Dequeuing may block until the client returns a buffer. Do it in parallel with
+    // scanning the input JPEG / generating the EXIF block below, neither of which
+    // needs the output buffer.
+    auto dequeueFuture = std::async(std::launch::async,
+            &JpegRCompositeStream::dequeueOutputBuffer, this, maxJpegRBufferSize, &anb,
+            &fenceFd);
+
     uint8_t jpegQuality = 100;
     auto entry = inputFrame.result.find(ANDROID_JPEG_QUALITY);
     if (entry.count > 0) {
         jpegQuality = entry.data.u8[0];
     }
 
-    if ((res = native_window_set_buffers_dimensions(mOutputSurface.get(), maxJpegRBufferSize, 1))
-            != OK) {
-        ALOGE("%s: Unable to configure stream buffer dimensions"
-                " %zux%u for stream %d", __FUNCTION__, maxJpegRBufferSize, 1U, mP010StreamId);
-        return res;
+    ultrahdr::jpegr_compressed_struct jpeg;
+    std::unique_ptr<ExifUtils> utils;
+    ultrahdr::jpegr_exif_struct exif;
+    if (mSupportInternalJpeg) {
+        jpeg.data = inputFrame.jpegBuffer.data;
+        jpeg.length = android::camera2::JpegProcessor::findJpegSize(inputFrame.jpegBuffer.data,
+                inputFrame.jpegBuffer.width);
+        if (jpeg.length == 0) {
+            ALOGW("%s: Failed to find input jpeg size, default to using entire buffer!",
+                    __FUNCTION__);
+            jpeg.length = inputFrame.jpegBuffer.width;
+        }
+
+        if (mOutputColorSpace == ANDROID_REQUEST_AVAILABLE_COLOR_SPACE_PROFILES_MAP_DISPLAY_P3) {
+            jpeg.colorGamut = ultrahdr::ultrahdr_color_gamut::ULTRAHDR_COLORGAMUT_P3;
+        } else {
+            jpeg.colorGamut = ultrahdr::ultrahdr_color_gamut::ULTRAHDR_COLORGAMUT_BT709;
+        }
+    } else {
+        const uint8_t* exifBuffer = nullptr;
+        size_t exifBufferSize = 0;
+        utils.reset(ExifUtils::create());
+        utils->initializeEmpty();
+        utils->setFromMetadata(inputFrame.result, mStaticInfo, inputFrame.p010Buffer.width,
+                inputFrame.p010Buffer.height);
+        if (utils->generateApp1()) {
+            exifBuffer = utils->getApp1Buffer();
+            exifBufferSize = utils->getApp1Length();
+        } else {
+            ALOGE("%s: Unable to generate App1 buffer", __FUNCTION__);
+        }
+
+        exif.data = reinterpret_cast<void*>(const_cast<uint8_t*>(exifBuffer));
+        exif.length = exifBufferSize;
     }
+    nsecs_t prepareDoneNs = systemTime();
 
-    res = outputANW->dequeueBuffer(mOutputSurface.get(), &anb, &fenceFd);
+    res = dequeueFuture.get();
     if (res != OK) {
-        ALOGE("%s: Error retrieving output buffer: %s (%d)", __FUNCTION__, strerror(-res),
-                res);
         return res;
     }
+    nsecs_t bufferReadyNs = systemTime();
 
     sp<GraphicBuffer> gb = GraphicBuffer::from(anb);
     GraphicBufferLocker gbLocker(gb);
@@ -290,6 +350,7 @@ status_t JpegRCompositeStream::processInputFrame(nsecs_t ts, const InputFrame &i
         outputANW->cancelBuffer(mOutputSurface.get(), anb, /*fence*/ -1);
         return BAD_VALUE;
     }
+    nsecs_t encodeStartNs = systemTime();
 
     size_t actualJpegRSize = 0;
     ultrahdr::jpegr_uncompressed_struct p010;
@@ -319,49 +380,17 @@ status_t JpegRCompositeStream::processInputFrame(nsecs_t ts, const InputFrame &i
     }
 
     if (mSupportInternalJpeg) {
-        ultrahdr::jpegr_compressed_struct jpeg;
-
-        jpeg.data = inputFrame.jpegBuffer.data;
-        jpeg.length = android::camera2::JpegProcessor::findJpegSize(inputFrame.jpegBuffer.data,
-                inputFrame.jpegBuffer.width);
-        if (jpeg.length == 0) {
-            ALOGW("%s: Failed to find input jpeg size, default to using entire buffer!",
-                    __FUNCTION__);
-            jpeg.length = inputFrame.jpegBuffer.width;
-        }
-
-        if (mOutputColorSpace == ANDROID_REQUEST_AVAILABLE_COLOR_SPACE_PROFILES_MAP_DISPLAY_P3) {
-            jpeg.colorGamut = ultrahdr::ultrahdr_color_gamut::ULTRAHDR_COLORGAMUT_P3;
-        } else {
-            jpeg.colorGamut = ultrahdr::ultrahdr_color_gamut::ULTRAHDR_COLORGAMUT_BT709;
-        }
-
         res = jpegREncoder.encodeJPEGR(&p010, &jpeg, transferFunction, &jpegR);
     } else {
-        const uint8_t* exifBuffer = nullptr;
-        size_t exifBufferSize = 0;
-        std::unique_ptr<ExifUtils> utils(ExifUtils::create());
-        utils->initializeEmpty();
-        utils->setFromMetadata(inputFrame.result, mStaticInfo, inputFrame.p010Buffer.width,
-                inputFrame.p010Buffer.height);
-        if (utils->generateApp1()) {
-            exifBuffer = utils->getApp1Buffer();
-            exifBufferSize = utils->getApp1Length();
-        } else {
-            ALOGE("%s: Unable to generate App1 buffer", __FUNCTION__);
-        }
-
-        ultrahdr::jpegr_exif_struct exif;
-        exif.data = reinterpret_cast<void*>(const_cast<uint8_t*>(exifBuffer));
-        exif.length = exifBufferSize;
-
         res = jpegREncoder.encodeJPEGR(&p010, transferFunction, &jpegR, jpegQuality, &exif);
     }
 
     if (res != OK) {
         ALOGE("%s: Error trying to encode JPEG/R: %s (%d)", __FUNCTION__, strerror(-res), res);
+        outputANW->cancelBuffer(mOutputSurface.get(), anb, /*fence*/ -1);
         return res;
     }
+    nsecs_t encodeDoneNs = systemTime();
 
     actualJpegRSize = jpegR.length;
 
@@ -376,6 +405,7 @@ status_t JpegRCompositeStream::processInputFrame(nsecs_t ts, const InputFrame &i
     if (res != OK) {
         ALOGE("%s: Stream %d: Error setting timestamp: %s (%d)", __FUNCTION__,
                 getStreamId(), strerror(-res), res);
+        outputANW->cancelBuffer(mOutputSurface.get(), anb, /*fence*/ -1);
         return res;
     }
 
@@ -397,9 +427,37 @@ status_t JpegRCompositeStream::processInputFrame(nsecs_t ts, const InputFrame &i
     }
     outputANW->queueBuffer(mOutputSurface.get(), anb, /*fence*/ -1);
 
+    {
+        std::lock_guard<std::mutex> l(mEncodeStatsLock);
+        mEncodeStats[kStagePrepare].add(prepareDoneNs - startNs);
+        mEncodeStats[kStageBufferWait].add(bufferReadyNs - prepareDoneNs);
+        mEncodeStats[kStageEncode].add(encodeDoneNs - encodeStartNs);
+        mEncodeStats[kStageTotal].add(systemTime() - startNs);
+        mLastJpegRSize = actualJpegRSize;
+    }
+
     return res;
 }
 
+void JpegRCompositeStream::dump(int fd, const Vector<String16>& /*args*/) {
+    static const char* kStageNames[kStageCount] = {
+        "Prepare", "Output buffer wait", "Encode", "Total" };
+    std::lock_guard<std::mutex> l(mEncodeStatsLock);
+    dprintf(fd, "      JPEG/R composite stream %d (%s JPEG):\n", mP010StreamId,
+            mSupportInternalJpeg ? "HAL" : "framework");
+    if (mEncodeStats[kStageTotal].count == 0) {
+        dprintf(fd, "        No frames encoded\n");
+        return;
+    }
+    dprintf(fd, "        Frames: %" PRId64 ", last size %zu bytes\n",
+            mEncodeStats[kStageTotal].count, mLastJpegRSize);
+    for (int i = 0; i < kStageCount; i++) {
+        const EncodeStageStats& stats = mEncodeStats[i];
+        dprintf(fd, "        %s: avg %.2f ms, max %.2f ms\n", kStageNames[i],
+                stats.totalNs / 1e6 / stats.count, stats.maxNs / 1e6);
+    }
+}
+
 void JpegRCompositeStream::releaseInputFrameLocked(InputFrame *inputFrame /*out*/) {
     if (inputFrame == nullptr) {
         return;
@@ -17,6 +17,9 @@
 #ifndef ANDROID_SERVERS_CAMERA_CAMERA3_JPEG_R_COMPOSITE_STREAM_H
 #define ANDROID_SERVERS_CAMERA_CAMERA3_JPEG_R_COMPOSITE_STREAM_H
 
+#include <algorithm>
+#include <mutex>
+
 #include <gui/CpuConsumer.h>
 #include "aidl/android/hardware/graphics/common/Dataspace.h"
 #include "system/graphics-base-v1.1.h"
@@ -69,6 +72,8 @@ public:
     // Get composite stream stats
     void getStreamStats(hardware::CameraStreamStats* streamStats) override;
 
+    void dump(int fd, const Vector<String16>& args) override;
+
 protected:
 
     bool threadLoop() override;
@@ -91,6 +96,8 @@ private:
     };
 
     status_t processInputFrame(nsecs_t ts, const InputFrame &inputFrame);
+    status_t dequeueOutputBuffer(size_t bufferSize, ANativeWindowBuffer** anb /*out*/,
+            int* fenceFd /*out*/);
 
     // Buffer/Results handling
     void compilePendingInputLocked();
@@ -147,6 +154,29 @@ private:
     const CameraMetadata mStaticInfo;
 
     SessionStatsBuilder  mSessionStatsBuilder;
+
+    // Per stage processing time of encoded frames, reported by dump()
+    enum EncodeStage {
+        kStagePrepare,    // EXIF generation or input JPEG scan
+        kStageBufferWait, // output buffer dequeue not hidden behind kStagePrepare
+        kStageEncode,     // gain map computation and JPEG/R packaging
+        kStageTotal,
+        kStageCount
+    };
+    struct EncodeStageStats {
+        int64_t count = 0;
+        nsecs_t totalNs = 0;
+        nsecs_t maxNs = 0;
+
+        void add(nsecs_t durationNs) {
+            count++;
+            totalNs += durationNs;
+            maxNs = std::max(maxNs, durationNs);
+        }
+    };
+    std::mutex           mEncodeStatsLock;
+    EncodeStageStats     mEncodeStats[kStageCount];
+    size_t               mLastJpegRSize = 0;
 };
 
 }; //namespace camera3
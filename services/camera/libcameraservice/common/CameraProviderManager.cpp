@@ -867,14 +867,43 @@ status_t CameraProviderManager::dump(int fd, const Vector<String16>& args) {
 
 void CameraProviderManager::ProviderInfo::initializeProviderInfoCommon(
         const std::vector<std::string> &devices) {
+    ATRACE_CALL();
+    // Fetching the static info of a device takes several HAL round trips and derives a
+    // number of framework tags, so do it for all devices of the provider in parallel and
+    // then register them in enumeration order. The caller holds the provider interface
+    // for the duration, so the device info fetches don't need to restart the provider.
+    struct PendingDevice {
+        std::string name;
+        std::future<std::unique_ptr<DeviceInfo>> deviceInfo;
+    };
+    std::vector<PendingDevice> pendingDevices;
+    std::set<std::pair<std::string, uint16_t>> pendingIds;
     for (auto& device : devices) {
+        ALOGI("Enumerating new camera device: %s", device.c_str());
         std::string id;
-        status_t res = addDevice(device, CameraDeviceStatus::PRESENT, &id);
+        uint16_t major, minor;
+        status_t res = checkNewDevice(device, &id, &major, &minor);
+        if (res == OK && !pendingIds.emplace(id, major).second) {
+            ALOGE("%s: Device %s: ID %s is already in use for device major version %d",
+                    __FUNCTION__, device.c_str(), id.c_str(), major);
+            res = BAD_VALUE;
+        }
         if (res != OK) {
             ALOGE("%s: Unable to enumerate camera device '%s': %s (%d)",
                     __FUNCTION__, device.c_str(), strerror(-res), res);
             continue;
         }
+        pendingDevices.push_back({device, std::async(std::launch::async,
+                [this, device, id, minor]() {
+                    return initializeDeviceInfo(device, mProviderTagid, id, minor);
+                })});
+    }
+    for (auto& pending : pendingDevices) {
+        status_t res = registerDevice(pending.deviceInfo.get(), CameraDeviceStatus::PRESENT);
+        if (res != OK) {
+            ALOGE("%s: Unable to enumerate camera device '%s': %s (%d)",
+                    __FUNCTION__, pending.name.c_str(), strerror(-res), res);
+        }
     }
 
     ALOGI("Camera provider %s ready with %zu camera devices",
@@ -2115,10 +2144,29 @@ status_t CameraProviderManager::ProviderInfo::addDevice(
     ALOGI("Enumerating new camera device: %s", name.c_str());
 
     uint16_t major, minor;
-    std::string type, id;
+    std::string id;
+    status_t res = checkNewDevice(name, &id, &major, &minor);
+    if (res != OK) {
+        return res;
+    }
+
+    res = registerDevice(initializeDeviceInfo(name, mProviderTagid, id, minor), initialStatus);
+    if (res != OK) {
+        return res;
+    }
+
+    if (parsedId != nullptr) {
+        *parsedId = id;
+    }
+    return OK;
+}
+
+status_t CameraProviderManager::ProviderInfo::checkNewDevice(const std::string& name,
+        /*out*/ std::string* id, /*out*/ uint16_t* major, /*out*/ uint16_t* minor) {
+    std::string type;
     IPCTransport transport = getIPCTransport();
 
-    status_t res = parseDeviceName(name, &major, &minor, &type, &id);
+    status_t res = parseDeviceName(name, major, minor, &type, id);
     if (res != OK) {
         return res;
     }
@@ -2128,28 +2176,27 @@ status_t CameraProviderManager::ProviderInfo::addDevice(
                 type.c_str(), mType.c_str());
         return BAD_VALUE;
     }
-    if (mManager->isValidDeviceLocked(id, major, transport)) {
+    if (mManager->isValidDeviceLocked(*id, *major, transport)) {
         ALOGE("%s: Device %s: ID %s is already in use for device major version %d", __FUNCTION__,
-                name.c_str(), id.c_str(), major);
+                name.c_str(), id->c_str(), *major);
         return BAD_VALUE;
     }
 
-    std::unique_ptr<DeviceInfo> deviceInfo;
     switch (transport) {
         case IPCTransport::HIDL:
-            switch (major) {
+            switch (*major) {
                 case 3:
                     break;
                 default:
                     ALOGE("%s: Device %s: Unsupported HIDL device HAL major version %d:",
-                          __FUNCTION__,  name.c_str(), major);
+                          __FUNCTION__,  name.c_str(), *major);
                     return BAD_VALUE;
             }
             break;
         case IPCTransport::AIDL:
-            if (major != 1) {
+            if (*major != 1) {
                 ALOGE("%s: Device %s: Unsupported AIDL device HAL major version %d:", __FUNCTION__,
-                        name.c_str(), major);
+                        name.c_str(), *major);
                 return BAD_VALUE;
             }
             break;
@@ -2158,11 +2205,16 @@ status_t CameraProviderManager::ProviderInfo::addDevice(
             return BAD_VALUE;
     }
 
-    deviceInfo = initializeDeviceInfo(name, mProviderTagid, id, minor);
+    return OK;
+}
+
+status_t CameraProviderManager::ProviderInfo::registerDevice(
+        std::unique_ptr<DeviceInfo> deviceInfo, CameraDeviceStatus initialStatus) {
     if (deviceInfo == nullptr) return BAD_VALUE;
     deviceInfo->notifyDeviceStateChange(getDeviceState());
     deviceInfo->mStatus = initialStatus;
     bool isAPI1Compatible = deviceInfo->isAPI1Compatible();
+    std::string id = deviceInfo->mId;
 
     mDevices.push_back(std::move(deviceInfo));
 
@@ -2176,9 +2228,6 @@ status_t CameraProviderManager::ProviderInfo::addDevice(
         }
     }
 
-    if (parsedId != nullptr) {
-        *parsedId = id;
-    }
     return OK;
 }
 
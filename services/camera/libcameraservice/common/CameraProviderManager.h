@@ -764,6 +764,13 @@ private:
                 const std::string& name, CameraDeviceStatus initialStatus,
                 /*out*/ std::string* parsedId);
 
+        // The steps of addDevice before and after the device info is fetched from the
+        // HAL, split out so that several devices can be fetched in parallel.
+        status_t checkNewDevice(const std::string& name, /*out*/ std::string* id,
+                /*out*/ uint16_t* major, /*out*/ uint16_t* minor);
+        status_t registerDevice(std::unique_ptr<DeviceInfo> deviceInfo,
+                CameraDeviceStatus initialStatus);
+
         void cameraDeviceStatusChangeInternal(const std::string& cameraDeviceName,
                 CameraDeviceStatus newStatus);
 
@@ -35,6 +35,7 @@
 #include <libexif/exif-data.h>
 #include <libexif/exif-system.h>
 #include <math.h>
+#include <future>
 #include <sstream>
 #include <utils/Errors.h>
 #include <utils/ExifUtils.h>
@@ -239,100 +240,84 @@ status_t encodeGrayscaleJpeg(size_t width, size_t height, uint8_t *in, void *out
     return ret;
 }
 
-inline void unpackDepth16(uint16_t value, std::vector<float> *points /*out*/,
-        std::vector<float> *confidence /*out*/, float *near /*out*/, float *far /*out*/) {
-    // Android densely packed depth map. The units for the range are in
-    // millimeters and need to be scaled to meters.
-    // The confidence value is encoded in the 3 most significant bits.
-    // The confidence data needs to be additionally normalized with
-    // values 1.0f, 0.0f representing maximum and minimum confidence
-    // respectively.
-    auto point = static_cast<float>(value & 0x1FFF) / 1000.f;
-    points->push_back(point);
-
-    auto conf = (value >> 13) & 0x7;
-    float normConfidence = (conf == 0) ? 1.f : (static_cast<float>(conf) - 1) / 7.f;
-    confidence->push_back(normConfidence);
-    if (normConfidence < CONFIDENCE_THRESHOLD) {
-        return;
-    }
-
-    if (*near > point) {
-        *near = point;
-    }
-    if (*far < point) {
-        *far = point;
-    }
-}
-
-// Trivial case, read forward from top,left corner.
-void rotate0AndUnpack(DepthPhotoInputFrame inputFrame, std::vector<float> *points /*out*/,
-        std::vector<float> *confidence /*out*/, float *near /*out*/, float *far /*out*/) {
-    for (size_t i = 0; i < inputFrame.mDepthMapHeight; i++) {
-        for (size_t j = 0; j < inputFrame.mDepthMapWidth; j++) {
-            unpackDepth16(inputFrame.mDepthMapBuffer[i*inputFrame.mDepthMapStride + j], points,
-                    confidence, near, far);
-        }
-    }
-}
-
-// 90 degrees CW rotation can be applied by starting to read from bottom, left corner
-// transposing rows and columns.
-void rotate90AndUnpack(DepthPhotoInputFrame inputFrame, std::vector<float> *points /*out*/,
-        std::vector<float> *confidence /*out*/, float *near /*out*/, float *far /*out*/) {
-    for (size_t i = 0; i < inputFrame.mDepthMapWidth; i++) {
-        for (ssize_t j = inputFrame.mDepthMapHeight-1; j >= 0; j--) {
-            unpackDepth16(inputFrame.mDepthMapBuffer[j*inputFrame.mDepthMapStride + i], points,
-                    confidence, near, far);
-        }
-    }
-}
-
-// 180 CW degrees rotation can be applied by starting to read backwards from bottom, right corner.
-void rotate180AndUnpack(DepthPhotoInputFrame inputFrame, std::vector<float> *points /*out*/,
-        std::vector<float> *confidence /*out*/, float *near /*out*/, float *far /*out*/) {
-    for (ssize_t i = inputFrame.mDepthMapHeight-1; i >= 0; i--) {
-        for (ssize_t j = inputFrame.mDepthMapWidth-1; j >= 0; j--) {
-            unpackDepth16(inputFrame.mDepthMapBuffer[i*inputFrame.mDepthMapStride + j], points,
-                    confidence, near, far);
-        }
-    }
-}
-
-// 270 degrees CW rotation can be applied by starting to read from top, right corner
-// transposing rows and columns.
-void rotate270AndUnpack(DepthPhotoInputFrame inputFrame, std::vector<float> *points /*out*/,
-        std::vector<float> *confidence /*out*/, float *near /*out*/, float *far /*out*/) {
-    for (ssize_t i = inputFrame.mDepthMapWidth-1; i >= 0; i--) {
-        for (size_t j = 0; j < inputFrame.mDepthMapHeight; j++) {
-            unpackDepth16(inputFrame.mDepthMapBuffer[j*inputFrame.mDepthMapStride + i], points,
-                    confidence, near, far);
-        }
-    }
-}
-
-bool rotateAndUnpack(DepthPhotoInputFrame inputFrame, std::vector<float> *points /*out*/,
-        std::vector<float> *confidence /*out*/, float *near /*out*/, float *far /*out*/) {
-    switch (inputFrame.mOrientation) {
+// Copy the depth samples in the requested rotation into a densely packed
+// buffer. 90 and 270 degree rotations transpose rows and columns; returns
+// whether the dimensions are switched.
+bool rotateDepth16(const DepthPhotoInputFrame& inputFrame, DepthPhotoOrientation orientation,
+        uint16_t *out /*out*/) {
+    const uint16_t *in = inputFrame.mDepthMapBuffer;
+    const size_t width = inputFrame.mDepthMapWidth;
+    const size_t height = inputFrame.mDepthMapHeight;
+    const size_t stride = inputFrame.mDepthMapStride;
+    switch (orientation) {
         case DepthPhotoOrientation::DEPTH_ORIENTATION_0_DEGREES:
-            rotate0AndUnpack(inputFrame, points, confidence, near, far);
+            // Trivial case, read forward from top,left corner.
+            for (size_t i = 0; i < height; i++) {
+                memcpy(out + i*width, in + i*stride, width * sizeof(uint16_t));
+            }
             return false;
         case DepthPhotoOrientation::DEPTH_ORIENTATION_90_DEGREES:
-            rotate90AndUnpack(inputFrame, points, confidence, near, far);
+            // 90 degrees CW rotation can be applied by starting to read from bottom, left
+            // corner transposing rows and columns.
+            for (size_t i = 0; i < width; i++) {
+                for (size_t j = 0; j < height; j++) {
+                    *out++ = in[(height-1-j)*stride + i];
+                }
+            }
             return true;
         case DepthPhotoOrientation::DEPTH_ORIENTATION_180_DEGREES:
-            rotate180AndUnpack(inputFrame, points, confidence, near, far);
+            // 180 CW degrees rotation can be applied by starting to read backwards from
+            // bottom, right corner.
+            for (size_t i = 0; i < height; i++) {
+                const uint16_t *row = in + (height-1-i)*stride;
+                for (size_t j = 0; j < width; j++) {
+                    *out++ = row[width-1-j];
+                }
+            }
             return false;
         case DepthPhotoOrientation::DEPTH_ORIENTATION_270_DEGREES:
-            rotate270AndUnpack(inputFrame, points, confidence, near, far);
+            // 270 degrees CW rotation can be applied by starting to read from top, right
+            // corner transposing rows and columns.
+            for (size_t i = 0; i < width; i++) {
+                for (size_t j = 0; j < height; j++) {
+                    *out++ = in[j*stride + width-1-i];
+                }
+            }
             return true;
         default:
             ALOGE("%s: Unsupported depth photo rotation: %d, default to 0", __FUNCTION__,
-                    inputFrame.mOrientation);
-            rotate0AndUnpack(inputFrame, points, confidence, near, far);
+                    orientation);
+            return rotateDepth16(inputFrame, DepthPhotoOrientation::DEPTH_ORIENTATION_0_DEGREES,
+                    out);
     }
+}
 
-    return false;
+// Android densely packed depth map. The units for the range are in
+// millimeters and need to be scaled to meters.
+// The confidence value is encoded in the 3 most significant bits.
+// The confidence data needs to be additionally normalized with
+// values 1.0f, 0.0f representing maximum and minimum confidence
+// respectively.
+//
+// The loops below are kept branch free over plain arrays so that the compiler
+// can vectorize them.
+void unpackDepth16(const uint16_t *depth, size_t count, float *points /*out*/,
+        float *confidence /*out*/, float *near /*out*/, float *far /*out*/) {
+    for (size_t i = 0; i < count; i++) {
+        points[i] = static_cast<float>(depth[i] & 0x1FFF) / 1000.f;
+        auto conf = (depth[i] >> 13) & 0x7;
+        confidence[i] = (conf == 0) ? 1.f : (static_cast<float>(conf) - 1) / 7.f;
+    }
+
+    float nearest = *near;
+    float farthest = *far;
+    for (size_t i = 0; i < count; i++) {
+        bool confident = confidence[i] >= CONFIDENCE_THRESHOLD;
+        nearest = (confident && points[i] < nearest) ? points[i] : nearest;
+        farthest = (confident && points[i] > farthest) ? points[i] : farthest;
+    }
+    *near = nearest;
+    *far = farthest;
 }
 
 std::unique_ptr<dynamic_depth::DepthMap> processDepthMapFrame(DepthPhotoInputFrame inputFrame,
@@ -342,22 +327,19 @@ std::unique_ptr<dynamic_depth::DepthMap> processDepthMapFrame(DepthPhotoInputFra
         return nullptr;
     }
 
-    std::vector<float> points, confidence;
-
     size_t pointCount = inputFrame.mDepthMapWidth * inputFrame.mDepthMapHeight;
-    points.reserve(pointCount);
-    confidence.reserve(pointCount);
-    float near = UINT16_MAX;
-    float far = .0f;
-    *switchDimensions = false;
+    std::vector<uint16_t> depth(pointCount);
     // Physical rotation of depth and confidence maps may be needed in case
     // the EXIF orientation is set to 0 degrees and the depth photo orientation
     // (source color image) has some different value.
-    if (exifOrientation == ExifOrientation::ORIENTATION_0_DEGREES) {
-        *switchDimensions = rotateAndUnpack(inputFrame, &points, &confidence, &near, &far);
-    } else {
-        rotate0AndUnpack(inputFrame, &points, &confidence, &near, &far);
-    }
+    DepthPhotoOrientation orientation = (exifOrientation == ExifOrientation::ORIENTATION_0_DEGREES) ?
+            inputFrame.mOrientation : DepthPhotoOrientation::DEPTH_ORIENTATION_0_DEGREES;
+    *switchDimensions = rotateDepth16(inputFrame, orientation, depth.data());
+
+    std::vector<float> points(pointCount), confidence(pointCount);
+    float near = UINT16_MAX;
+    float far = .0f;
+    unpackDepth16(depth.data(), pointCount, points.data(), confidence.data(), &near, &far);
 
     size_t width = inputFrame.mDepthMapWidth;
     size_t height = inputFrame.mDepthMapHeight;
@@ -371,19 +353,14 @@ std::unique_ptr<dynamic_depth::DepthMap> processDepthMapFrame(DepthPhotoInputFra
         return nullptr;
     }
 
-    std::vector<uint8_t> pointsQuantized, confidenceQuantized;
-    pointsQuantized.reserve(pointCount); confidenceQuantized.reserve(pointCount);
-    auto pointIt = points.begin();
-    auto confidenceIt = confidence.begin();
-    while ((pointIt != points.end()) && (confidenceIt != confidence.end())) {
-        auto point = *pointIt;
-        if ((*confidenceIt) < CONFIDENCE_THRESHOLD) {
+    std::vector<uint8_t> pointsQuantized(pointCount), confidenceQuantized(pointCount);
+    for (size_t i = 0; i < pointCount; i++) {
+        auto point = points[i];
+        if (confidence[i] < CONFIDENCE_THRESHOLD) {
             point = std::clamp(point, near, far);
         }
-        pointsQuantized.push_back(floorf(((far * (point - near)) /
-                (point * (far - near))) * 255.0f));
-        confidenceQuantized.push_back(floorf(*confidenceIt * 255.0f));
-        confidenceIt++; pointIt++;
+        pointsQuantized[i] = floorf(((far * (point - near)) / (point * (far - near))) * 255.0f);
+        confidenceQuantized[i] = floorf(confidence[i] * 255.0f);
     }
 
     DepthMapParams depthParams(DepthFormat::kRangeInverse, near, far, DepthUnits::kMeters,
@@ -392,24 +369,29 @@ std::unique_ptr<dynamic_depth::DepthMap> processDepthMapFrame(DepthPhotoInputFra
     depthParams.mime = "image/jpeg";
     depthParams.depth_image_data.resize(inputFrame.mMaxJpegSize);
     depthParams.confidence_data.resize(inputFrame.mMaxJpegSize);
+    // The depth and confidence maps are compressed independently; do the
+    // confidence map on a separate thread.
+    size_t actualConfidenceJpegSize = 0;
+    auto confidenceRet = std::async(std::launch::async, [&]() {
+        return encodeGrayscaleJpeg(width, height, confidenceQuantized.data(),
+                depthParams.confidence_data.data(), inputFrame.mMaxJpegSize,
+                inputFrame.mJpegQuality, exifOrientation, actualConfidenceJpegSize);
+    });
+
     size_t actualJpegSize;
     auto ret = encodeGrayscaleJpeg(width, height, pointsQuantized.data(),
             depthParams.depth_image_data.data(), inputFrame.mMaxJpegSize,
             inputFrame.mJpegQuality, exifOrientation, actualJpegSize);
-    if (ret != NO_ERROR) {
-        ALOGE("%s: Depth map compression failed!", __FUNCTION__);
+    if (confidenceRet.get() != NO_ERROR) {
+        ALOGE("%s: Confidence map compression failed!", __FUNCTION__);
         return nullptr;
     }
-    depthParams.depth_image_data.resize(actualJpegSize);
-
-    ret = encodeGrayscaleJpeg(width, height, confidenceQuantized.data(),
-            depthParams.confidence_data.data(), inputFrame.mMaxJpegSize,
-            inputFrame.mJpegQuality, exifOrientation, actualJpegSize);
     if (ret != NO_ERROR) {
-        ALOGE("%s: Confidence map compression failed!", __FUNCTION__);
+        ALOGE("%s: Depth map compression failed!", __FUNCTION__);
         return nullptr;
     }
-    depthParams.confidence_data.resize(actualJpegSize);
+    depthParams.depth_image_data.resize(actualJpegSize);
+    depthParams.confidence_data.resize(actualConfidenceJpegSize);
 
     return DepthMap::FromData(depthParams, items);
 }
@@ -747,6 +747,12 @@ status_t AidlProviderInfo::AidlDeviceInfo3::isSessionConfigurationSupported(
         return OK;
     }
 
+    // Applications typically query the same handful of session configurations
+    // again on every mode switch; skip the HAL round trip for those.
+    if (findCachedStreamCombination(streamConfiguration, status)) {
+        return OK;
+    }
+
     const std::shared_ptr<camera::device::ICameraDevice> interface =
             startDeviceInterface();
 
@@ -761,10 +767,34 @@ status_t AidlProviderInfo::AidlDeviceInfo3::isSessionConfigurationSupported(
         ALOGE("%s: Unexpected binder error: %s", __FUNCTION__, ret.getMessage());
         return mapToStatusT(ret);
     }
+    cacheStreamCombination(streamConfiguration, *status);
     return OK;
 
 }
 
+bool AidlProviderInfo::AidlDeviceInfo3::findCachedStreamCombination(
+        const camera::device::StreamConfiguration& config, bool *supported) {
+    std::lock_guard<std::mutex> lock(mStreamCombinationCacheLock);
+    for (auto it = mStreamCombinationCache.begin(); it != mStreamCombinationCache.end(); it++) {
+        if (it->streamConfiguration == config) {
+            *supported = it->supported;
+            mStreamCombinationCache.splice(mStreamCombinationCache.end(),
+                    mStreamCombinationCache, it);
+            return true;
+        }
+    }
+    return false;
+}
+
+void AidlProviderInfo::AidlDeviceInfo3::cacheStreamCombination(
+        const camera::device::StreamConfiguration& config, bool supported) {
+    std::lock_guard<std::mutex> lock(mStreamCombinationCacheLock);
+    if (mStreamCombinationCache.size() >= kMaxCachedStreamCombinations) {
+        mStreamCombinationCache.pop_front();
+    }
+    mStreamCombinationCache.push_back({config, supported});
+}
+
 status_t AidlProviderInfo::convertToAidlHALStreamCombinationAndCameraIdsLocked(
         const std::vector<CameraIdAndSessionConfiguration> &cameraIdsAndSessionConfigs,
         const std::set<std::string>& perfClassPrimaryCameraIds,
@@ -17,11 +17,15 @@
 #ifndef ANDROID_SERVERS_CAMERA_CAMERAPROVIDER_AIDLPROVIDERINFOH
 #define ANDROID_SERVERS_CAMERA_CAMERAPROVIDER_AIDLPROVIDERINFOH
 
+#include <list>
+#include <mutex>
+
 #include "common/CameraProviderManager.h"
 
 #include <aidl/android/hardware/camera/common/Status.h>
 #include <aidl/android/hardware/camera/provider/BnCameraProviderCallback.h>
 #include <aidl/android/hardware/camera/device/ICameraDevice.h>
+#include <aidl/android/hardware/camera/device/StreamConfiguration.h>
 
 namespace android {
 
@@ -134,6 +138,27 @@ struct AidlProviderInfo : public CameraProviderManager::ProviderInfo {
 
         std::shared_ptr<aidl::android::hardware::camera::device::ICameraDevice>
                 startDeviceInterface();
+
+      private:
+        // HAL answers to isStreamCombinationSupported for recently queried stream
+        // combinations. The answer only depends on the static capabilities of the
+        // device, so it stays valid for as long as this device info is alive.
+        struct StreamCombinationQuery {
+            aidl::android::hardware::camera::device::StreamConfiguration streamConfiguration;
+            bool supported;
+        };
+        static const size_t kMaxCachedStreamCombinations = 16;
+
+        bool findCachedStreamCombination(
+                const aidl::android::hardware::camera::device::StreamConfiguration& config,
+                bool *supported);
+        void cacheStreamCombination(
+                const aidl::android::hardware::camera::device::StreamConfiguration& config,
+                bool supported);
+
+        std::mutex mStreamCombinationCacheLock;
+        // Most recently used last
+        std::list<StreamCombinationQuery> mStreamCombinationCache;
     };
 
  private:
@@ -33,6 +33,11 @@ Camera3BufferManager::Camera3BufferManager() {
 }
 
 Camera3BufferManager::~Camera3BufferManager() {
+    for (auto& entry : mCachedBuffers) {
+        if (entry.fenceFd >= 0) {
+            close(entry.fenceFd);
+        }
+    }
 }
 
 status_t Camera3BufferManager::registerStream(wp<Camera3OutputStream>& stream,
@@ -91,6 +96,10 @@ status_t Camera3BufferManager::registerStream(wp<Camera3OutputStream>& stream,
                 __FUNCTION__, streamSetKey.id, streamSetKey.isMultiRes);
         // Create stream info map, then add to mStreamsetMap.
         StreamSet newStreamSet;
+        ssize_t observedIdx = mObservedHandoutCountMap.indexOfKey(streamSetKey);
+        if (observedIdx != NAME_NOT_FOUND) {
+            newStreamSet.maxObservedHandoutCount = mObservedHandoutCountMap.valueAt(observedIdx);
+        }
         setIdx = mStreamSetMap.add(streamSetKey, newStreamSet);
     }
     // Update stream set map and water mark.
@@ -112,6 +121,16 @@ status_t Camera3BufferManager::registerStream(wp<Camera3OutputStream>& stream,
        currentStreamSet.maxAllowedBufferCount = streamInfo.totalBufferCount;
     }
 
+    // Start the water mark from the depth this stream set was observed to need in earlier
+    // configurations, so buffers aren't freed while the pipeline ramps up again.
+    if (currentStreamSet.maxObservedHandoutCount > 0) {
+        size_t seededWaterMark = std::min(currentStreamSet.maxObservedHandoutCount + 1,
+                currentStreamSet.maxAllowedBufferCount);
+        if (seededWaterMark > currentStreamSet.allocatedBufferWaterMark) {
+            currentStreamSet.allocatedBufferWaterMark = seededWaterMark;
+        }
+    }
+
     return OK;
 }
 
@@ -148,11 +167,14 @@ status_t Camera3BufferManager::unregisterStream(int streamId, int streamSetId, b
     mStreamMap.removeItem(streamId);
 
     // Lazy solution: when a stream is unregistered, the streams will be reconfigured, reset
-    // the water mark and let it grow again.
-    currentSet.allocatedBufferWaterMark = 0;
+    // the water mark to the observed in-flight depth and let it grow again.
+    currentSet.allocatedBufferWaterMark = (currentSet.maxObservedHandoutCount > 0) ?
+            std::min(currentSet.maxObservedHandoutCount + 1, currentSet.maxAllowedBufferCount) : 0;
 
-    // Remove this stream set if all its streams have been removed.
+    // Remove this stream set if all its streams have been removed, remembering how deep it
+    // got for the next time it is registered.
     if (handOutBufferCounts.size() == 0 && infoMap.size() == 0) {
+        mObservedHandoutCountMap.replaceValueFor(streamSetKey, currentSet.maxObservedHandoutCount);
         mStreamSetMap.removeItem(streamSetKey);
     }
 
@@ -226,10 +248,12 @@ status_t Camera3BufferManager::checkAndFreeBufferOnOtherStreamsLocked(
         {
             mLock.unlock();
             sp<GraphicBuffer> buffer;
-            stream->detachBuffer(&buffer, /*fenceFd*/ nullptr);
+            int fenceFd = -1;
+            stream->detachBuffer(&buffer, &fenceFd);
             mLock.lock();
             if (buffer.get() != nullptr) {
                 bufferFreed = true;
+                cacheBufferLocked(buffer, fenceFd);
             }
         }
         if (bufferFreed) {
@@ -277,6 +301,7 @@ status_t Camera3BufferManager::getBufferForStream(int streamId, int streamSetId,
         // We've already attached more buffers to this stream than we currently have
         // outstanding, so have the stream just use an already-attached buffer
         bufferCount++;
+        updateObservedHandoutCountLocked(streamSet);
         return ALREADY_EXISTS;
     }
     ALOGV("Stream %d set %d(%d): Get buffer for stream: Allocate new",
@@ -285,26 +310,34 @@ status_t Camera3BufferManager::getBufferForStream(int streamId, int streamSetId,
     if (mGrallocVersion < HARDWARE_DEVICE_API_VERSION(1,0)) {
         const StreamInfo& info = streamSet.streamInfoMap.valueFor(streamId);
         GraphicBufferEntry buffer;
-        buffer.fenceFd = -1;
-        buffer.graphicBuffer = new GraphicBuffer(
-                info.width, info.height, PixelFormat(info.format), info.combinedUsage,
-                std::string("Camera3BufferManager pid [") +
-                        std::to_string(getpid()) + "]");
-        status_t res = buffer.graphicBuffer->initCheck();
-
-        ALOGV("%s: allocating a new graphic buffer (%dx%d, format 0x%x) %p with handle %p",
-                __FUNCTION__, info.width, info.height, info.format,
-                buffer.graphicBuffer.get(), buffer.graphicBuffer->handle);
-        if (res < 0) {
-            ALOGE("%s: graphic buffer allocation failed: (error %d %s) ",
-                    __FUNCTION__, res, strerror(-res));
-            return res;
+        status_t res = OK;
+        if (takeCachedBufferLocked(info, &buffer)) {
+            ALOGV("%s: reusing cached graphic buffer (%dx%d, format 0x%x) %p with handle %p",
+                    __FUNCTION__, info.width, info.height, info.format,
+                    buffer.graphicBuffer.get(), buffer.graphicBuffer->handle);
+        } else {
+            buffer.fenceFd = -1;
+            buffer.graphicBuffer = new GraphicBuffer(
+                    info.width, info.height, PixelFormat(info.format), info.combinedUsage,
+                    std::string("Camera3BufferManager pid [") +
+                            std::to_string(getpid()) + "]");
+            res = buffer.graphicBuffer->initCheck();
+
+            ALOGV("%s: allocating a new graphic buffer (%dx%d, format 0x%x) %p with handle %p",
+                    __FUNCTION__, info.width, info.height, info.format,
+                    buffer.graphicBuffer.get(), buffer.graphicBuffer->handle);
+            if (res < 0) {
+                ALOGE("%s: graphic buffer allocation failed: (error %d %s) ",
+                        __FUNCTION__, res, strerror(-res));
+                return res;
+            }
+            ALOGV("%s: allocation done", __FUNCTION__);
         }
-        ALOGV("%s: allocation done", __FUNCTION__);
 
         // Increase the hand-out and attached buffer counts for tracking purposes.
         bufferCount++;
         attachedBufferCount++;
+        updateObservedHandoutCountLocked(streamSet);
         // Update the water mark to be the max hand-out buffer count + 1. An additional buffer is
         // added to reduce the chance of buffer allocation during stream steady state, especially
         // for cases where one stream is active, the other stream may request some buffers randomly.
@@ -451,11 +484,65 @@ status_t Camera3BufferManager::onBuffersRemoved(int streamId, int streamSetId,
     return OK;
 }
 
+void Camera3BufferManager::returnBufferForReuse(const sp<GraphicBuffer>& buffer, int fenceFd) {
+    ATRACE_CALL();
+    Mutex::Autolock l(mLock);
+    cacheBufferLocked(buffer, fenceFd);
+}
+
+void Camera3BufferManager::cacheBufferLocked(const sp<GraphicBuffer>& buffer, int fenceFd) {
+    if (buffer == nullptr) {
+        if (fenceFd >= 0) {
+            close(fenceFd);
+        }
+        return;
+    }
+
+    if (mCachedBuffers.size() >= kMaxCachedBuffers) {
+        GraphicBufferEntry& oldest = mCachedBuffers.front();
+        if (oldest.fenceFd >= 0) {
+            close(oldest.fenceFd);
+        }
+        mCachedBuffers.pop_front();
+    }
+    mCachedBuffers.emplace_back(buffer, fenceFd);
+    ALOGV("%s: cached graphic buffer %p, %zu cached buffers", __FUNCTION__, buffer.get(),
+            mCachedBuffers.size());
+}
+
+bool Camera3BufferManager::takeCachedBufferLocked(const StreamInfo& info,
+        GraphicBufferEntry* entry) {
+    // Prefer the most recently cached buffer, whose release fence is the least likely to
+    // still be pending.
+    for (auto it = mCachedBuffers.rbegin(); it != mCachedBuffers.rend(); it++) {
+        const sp<GraphicBuffer>& gb = it->graphicBuffer;
+        if (gb->getWidth() == info.width && gb->getHeight() == info.height &&
+                gb->getPixelFormat() == PixelFormat(info.format) &&
+                gb->getUsage() == info.combinedUsage) {
+            *entry = *it;
+            mCachedBuffers.erase(std::next(it).base());
+            return true;
+        }
+    }
+    return false;
+}
+
+void Camera3BufferManager::updateObservedHandoutCountLocked(StreamSet& streamSet) {
+    size_t totalHandOutBufferCount = 0;
+    for (size_t i = 0; i < streamSet.handoutBufferCountMap.size(); i++) {
+        totalHandOutBufferCount += streamSet.handoutBufferCountMap[i];
+    }
+    if (totalHandOutBufferCount > streamSet.maxObservedHandoutCount) {
+        streamSet.maxObservedHandoutCount = totalHandOutBufferCount;
+    }
+}
+
 void Camera3BufferManager::dump(int fd, [[maybe_unused]] const Vector<String16>& args) const {
     Mutex::Autolock l(mLock);
 
     String8 lines;
     lines.appendFormat("      Total stream sets: %zu\n", mStreamSetMap.size());
+    lines.appendFormat("      Cached buffers for reuse: %zu\n", mCachedBuffers.size());
     for (size_t i = 0; i < mStreamSetMap.size(); i++) {
         lines.appendFormat("        Stream set %d(%d) has below streams:\n",
                 mStreamSetMap.keyAt(i).id, mStreamSetMap.keyAt(i).isMultiRes);
@@ -466,6 +553,8 @@ void Camera3BufferManager::dump(int fd, [[maybe_unused]] const Vector<String16>&
                 mStreamSetMap[i].maxAllowedBufferCount);
         lines.appendFormat("          Stream set buffer count water mark: %zu\n",
                 mStreamSetMap[i].allocatedBufferWaterMark);
+        lines.appendFormat("          Stream set max observed handout count: %zu\n",
+                mStreamSetMap[i].maxObservedHandoutCount);
         lines.appendFormat("          Handout buffer counts:\n");
         for (size_t m = 0; m < mStreamSetMap[i].handoutBufferCountMap.size(); m++) {
             int streamId = mStreamSetMap[i].handoutBufferCountMap.keyAt(m);
@@ -180,6 +180,17 @@ public:
      */
     void notifyBufferRemoved(int streamId, int streamSetId, bool isMultiRes);
 
+    /**
+     * This method hands a buffer that has been detached from its stream back to the buffer
+     * manager, so that a later getBufferForStream() call for a stream with the same size, format
+     * and usage can reuse it instead of allocating a new one. The cache is kept across stream
+     * reconfigurations for the lifetime of this buffer manager.
+     *
+     * The buffer manager takes ownership of fenceFd, which must be signaled before the buffer is
+     * written again. The buffer must not be attached to any buffer queue.
+     */
+    void returnBufferForReuse(const sp<GraphicBuffer>& buffer, int fenceFd);
+
     /**
      * Dump the buffer manager statistics.
      */
@@ -198,6 +209,9 @@ private:
     // (BUFFER_FREE_THRESHOLD + steady state handout buffer count) buffers.
     static const int BUFFER_FREE_THRESHOLD = 3;
 
+    // Max number of detached buffers kept for reuse across stream reconfigurations.
+    static const size_t kMaxCachedBuffers = 8;
+
     /**
      * Lock to synchronize the access to the methods of this class.
      */
@@ -283,10 +297,16 @@ private:
          * An attached buffer may be free or handed out
          */
         BufferCountMap attachedBufferCountMap;
+        /**
+         * The largest total hand-out buffer count seen for this stream set, i.e. the deepest
+         * the streams of this set have been in flight.
+         */
+        size_t maxObservedHandoutCount;
 
         StreamSet() {
             allocatedBufferWaterMark = 0;
             maxAllowedBufferCount = 0;
+            maxObservedHandoutCount = 0;
         }
     };
 
@@ -309,6 +329,19 @@ private:
     KeyedVector<StreamSetKey, StreamSet> mStreamSetMap;
     KeyedVector<StreamId, wp<Camera3OutputStream>> mStreamMap;
 
+    /**
+     * The max observed hand-out buffer count of stream sets whose streams have all been
+     * unregistered. When the stream set is registered again (e.g. after a reconfiguration), its
+     * water mark starts from this depth instead of growing again from zero, which would otherwise
+     * free buffers of the other streams in the set while the pipeline ramps up.
+     */
+    KeyedVector<StreamSetKey, size_t> mObservedHandoutCountMap;
+
+    /**
+     * Detached buffers available for reuse, oldest first.
+     */
+    std::list<GraphicBufferEntry> mCachedBuffers;
+
     // TODO: There is no easy way to query the Gralloc version in this code yet, we have different
     // code paths for different Gralloc versions, hardcode something here for now.
     const uint32_t mGrallocVersion = GRALLOC_DEVICE_API_VERSION_0_1;
@@ -324,6 +357,24 @@ private:
      * free one if so.
      */
     status_t checkAndFreeBufferOnOtherStreamsLocked(int streamId, StreamSetKey streamSetKey);
+
+    /**
+     * Add a detached buffer to the reuse cache, evicting the oldest one if the cache is full.
+     * This method needs to be called with mLock held.
+     */
+    void cacheBufferLocked(const sp<GraphicBuffer>& buffer, int fenceFd);
+
+    /**
+     * Take a cached buffer matching the given stream info, if any. This method needs to be
+     * called with mLock held.
+     */
+    bool takeCachedBufferLocked(const StreamInfo& info, GraphicBufferEntry* entry);
+
+    /**
+     * Update the max observed hand-out buffer count of a stream set. This method needs to be
+     * called with mLock held.
+     */
+    void updateObservedHandoutCountLocked(StreamSet& streamSet);
 };
 
 } // namespace camera3
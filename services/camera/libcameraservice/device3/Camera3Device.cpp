@@ -186,6 +186,8 @@ status_t Camera3Device::initializeCommonLocked() {
     /** Create buffer manager */
     mBufferManager = new Camera3BufferManager();
 
+    camera3::buildPhysicalResultKeys(mPhysicalDeviceInfoMap, &mPhysicalResultKeys);
+
     Vector<int32_t> sessionParamKeys;
     camera_metadata_entry_t sessionKeysEntry = mDeviceInfo.find(
             ANDROID_REQUEST_AVAILABLE_SESSION_KEYS);
@@ -658,6 +660,7 @@ status_t Camera3Device::dump(int fd, [[maybe_unused]] const Vector<String16> &ar
         mRequestThread->dumpCaptureRequestLatency(fd,
                 "    ProcessCaptureRequest latency histogram:");
     }
+    mSessionStatsBuilder.dump(fd);
 
     {
         lines = String8("    Last request sent:\n");
@@ -696,6 +699,10 @@ status_t Camera3Device::dump(int fd, [[maybe_unused]] const Vector<String16> &ar
 
     mTagMonitor.dumpMonitoredMetadata(fd);
 
+    if (mCameraServiceWatchdog != nullptr) {
+        mCameraServiceWatchdog->dump(fd);
+    }
+
     if (mInterface->valid()) {
         lines = String8("     HAL device dump:\n");
         write(fd, lines.string(), lines.size());
@@ -2907,6 +2914,11 @@ status_t Camera3Device::registerInFlight(uint32_t frameNumber,
             requestTimeNs, outputSurfaces));
     if (res < 0) return res;
 
+    nsecs_t halSubmitTimeNs = systemTime();
+    mInFlightMap.editValueAt(res).halSubmitTimeNs = halSubmitTimeNs;
+    mSessionStatsBuilder.incStageLatency(SessionStatsBuilder::STAGE_REQUEST_QUEUE,
+            ns2ms(halSubmitTimeNs - requestTimeNs));
+
     if (mInFlightMap.size() == 1) {
         // Hold a separate dedicated tracker lock to prevent race with disconnect and also
         // avoid a deadlock during reprocess requests.
@@ -2963,6 +2975,21 @@ void Camera3Device::removeInFlightMapEntryLocked(int idx) {
     onInflightEntryRemovedLocked(duration);
 }
 
+void Camera3Device::moveInFlightRequestsLocked(const std::vector<uint32_t>& frameNumbers,
+        InFlightRequestMap* offlineReqs) {
+    ATRACE_CALL();
+    for (uint32_t frameNumber : frameNumbers) {
+        ssize_t idx = mInFlightMap.indexOfKey(frameNumber);
+        if (idx < 0) {
+            continue;
+        }
+        std::unique_ptr<InFlightRequest> request = mInFlightMap.takeAt(idx);
+        nsecs_t duration = request->maxExpectedDuration;
+        offlineReqs->add(frameNumber, std::move(request));
+        onInflightEntryRemovedLocked(duration);
+    }
+}
+
 
 void Camera3Device::flushInflightRequests() {
     ATRACE_CALL();
@@ -3572,6 +3599,52 @@ void Camera3Device::RequestThread::updateNextRequest(NextRequest& nextRequest) {
     cleanupPhysicalSettings(nextRequest.captureRequest, &halRequest);
 }
 
+bool Camera3Device::RequestThread::isSameAsLatestSettings(const sp<CaptureRequest>& request,
+        const camera_metadata_t* settings) {
+    // HAL requires fresh settings after a configure or flush, which clear mPrevRequest.
+    // Physical camera settings would be reused along with the logical ones, so only
+    // compare requests without them.
+    if (mPrevRequest == nullptr || settings == nullptr || request->mSettingsList.size() > 1) {
+        return false;
+    }
+
+    // Triggers set by the application act once per request, and must not be
+    // folded into a repeat of the previous request.
+    const uint32_t triggerTags[] = {ANDROID_CONTROL_AF_TRIGGER,
+            ANDROID_CONTROL_AE_PRECAPTURE_TRIGGER};
+    for (uint32_t tag : triggerTags) {
+        camera_metadata_ro_entry_t e = camera_metadata_ro_entry_t();
+        if (find_camera_metadata_ro_entry(settings, tag, &e) == OK && e.count > 0 &&
+                e.data.u8[0] != 0 /*IDLE*/) {
+            return false;
+        }
+    }
+
+    Mutex::Autolock al(mLatestRequestMutex);
+    if (!mLatestPhysicalRequest.empty() || mLatestRequest.isEmpty()) {
+        return false;
+    }
+
+    // Both buffers are sorted, so identical settings have identical entry order.
+    const camera_metadata_t* latest = mLatestRequest.getAndLock();
+    size_t entryCount = get_camera_metadata_entry_count(settings);
+    bool same = entryCount == get_camera_metadata_entry_count(latest);
+    for (size_t i = 0; same && i < entryCount; i++) {
+        camera_metadata_ro_entry_t entry, latestEntry;
+        if (get_camera_metadata_ro_entry(settings, i, &entry) != OK ||
+                get_camera_metadata_ro_entry(latest, i, &latestEntry) != OK) {
+            same = false;
+            break;
+        }
+        same = entry.tag == latestEntry.tag && entry.type == latestEntry.type &&
+                entry.count == latestEntry.count &&
+                memcmp(entry.data.u8, latestEntry.data.u8,
+                        entry.count * camera_metadata_type_size[entry.type]) == 0;
+    }
+    mLatestRequest.unlock(latest);
+    return same;
+}
+
 bool Camera3Device::RequestThread::updateSessionParameters(const CameraMetadata& settings) {
     ATRACE_CALL();
     bool updatesDetected = false;
@@ -3959,17 +4032,30 @@ status_t Camera3Device::RequestThread::prepareHalRequests() {
              */
             captureRequest->mSettingsList.begin()->metadata.sort();
             halRequest->settings = captureRequest->mSettingsList.begin()->metadata.getAndLock();
+            // A different request object often carries the same settings, e.g. when a
+            // repeating request is re-submitted or alternates with single captures.
+            // Don't send those to HAL again; 'NULL settings == repeat' still holds.
+            if (!triggersMixedIn &&
+                    isSameAsLatestSettings(captureRequest, halRequest->settings)) {
+                captureRequest->mSettingsList.begin()->metadata.unlock(halRequest->settings);
+                halRequest->settings = nullptr;
+                newRequest = false;
+                ALOGVV("%s: Request settings are UNCHANGED", __FUNCTION__);
+            } else {
+                ALOGVV("%s: Request settings are NEW", __FUNCTION__);
+            }
             mPrevRequest = captureRequest;
             mPrevCameraIdsWithZoom = cameraIdsWithZoom;
-            ALOGVV("%s: Request settings are NEW", __FUNCTION__);
 
             IF_ALOGV() {
                 camera_metadata_ro_entry_t e = camera_metadata_ro_entry_t();
-                find_camera_metadata_ro_entry(
-                        halRequest->settings,
-                        ANDROID_CONTROL_AF_TRIGGER,
-                        &e
-                );
+                if (halRequest->settings != nullptr) {
+                    find_camera_metadata_ro_entry(
+                            halRequest->settings,
+                            ANDROID_CONTROL_AF_TRIGGER,
+                            &e
+                    );
+                }
                 if (e.count > 0) {
                     ALOGV("%s: Request (frame num %d) had AF trigger 0x%x",
                           __FUNCTION__,
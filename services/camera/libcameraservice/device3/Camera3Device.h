@@ -555,6 +555,8 @@ class Camera3Device :
     bool                       mSupportNativeZoomRatio;
     bool                       mIsCompositeJpegRDisabled;
     std::unordered_map<std::string, CameraMetadata> mPhysicalDeviceInfoMap;
+    // Result keys forwarded to clients per physical camera, built in initializeCommonLocked
+    camera3::PhysicalResultKeys mPhysicalResultKeys;
 
     CameraMetadata             mRequestTemplateCache[CAMERA_TEMPLATE_COUNT];
 
@@ -1093,6 +1095,12 @@ class Camera3Device :
         // Update next request sent to HAL
         void updateNextRequest(NextRequest& nextRequest);
 
+        // Check whether the fully prepared settings of a request that isn't the previous
+        // one are identical to the latest settings sent to HAL, so that they can be
+        // signaled as reused instead of being copied to HAL again.
+        bool isSameAsLatestSettings(const sp<CaptureRequest>& request,
+                const camera_metadata_t* settings);
+
         wp<Camera3Device>  mParent;
         wp<camera3::StatusTracker>  mStatusTracker;
         sp<HalInterface>   mInterface;
@@ -1300,15 +1308,26 @@ class Camera3Device :
     std::list<CaptureResult>    mResultQueue;
     std::condition_variable  mResultSignal;
     wp<NotificationListener> mListener;
+    // results waiting for metadata fixups outside of mInFlightLock
+    std::list<camera3::PendingCaptureResult> mPendingResults;
 
     /**** End scope for mOutputLock ****/
 
+    // Serializes metadata fixups of mPendingResults across HAL callback threads
+    std::mutex             mResultProcessingLock;
+
     /**** Scope for mInFlightLock ****/
 
     // Remove the in-flight map entry of the given index from mInFlightMap.
     // It must only be called with mInFlightLock held.
     void removeInFlightMapEntryLocked(int idx);
 
+    // Move the in-flight requests for the given frame numbers out of mInFlightMap
+    // and into offlineReqs without copying them, as when switching to an offline
+    // session. It must only be called with mInFlightLock held.
+    void moveInFlightRequestsLocked(const std::vector<uint32_t>& frameNumbers,
+            camera3::InFlightRequestMap* offlineReqs);
+
     // Remove all in-flight requests and return all buffers.
     // This is used after HAL interface is closed to cleanup any request/buffers
     // not returned by HAL.
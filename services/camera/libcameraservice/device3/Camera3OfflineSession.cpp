@@ -46,13 +46,13 @@ Camera3OfflineSession::Camera3OfflineSession(const String8 &id,
         const sp<camera3::Camera3Stream>& inputStream,
         const camera3::StreamSet& offlineStreamSet,
         camera3::BufferRecords&& bufferRecords,
-        const camera3::InFlightRequestMap& offlineReqs,
+        camera3::InFlightRequestMap&& offlineReqs,
         const Camera3OfflineStates& offlineStates) :
         mId(id),
         mInputStream(inputStream),
         mOutputStreams(offlineStreamSet),
         mBufferRecords(std::move(bufferRecords)),
-        mOfflineReqs(offlineReqs),
+        mOfflineReqs(std::move(offlineReqs)),
         mTagMonitor(offlineStates.mTagMonitor),
         mVendorTagId(offlineStates.mVendorTagId),
         mUseHalBufManager(offlineStates.mUseHalBufManager),
@@ -70,6 +70,7 @@ Camera3OfflineSession::Camera3OfflineSession(const String8 &id,
         mNextZslStillShutterFrameNumber(offlineStates.mNextZslStillShutterFrameNumber),
         mDeviceInfo(offlineStates.mDeviceInfo),
         mPhysicalDeviceInfoMap(offlineStates.mPhysicalDeviceInfoMap),
+        mPhysicalResultKeys(offlineStates.mPhysicalResultKeys),
         mDistortionMappers(offlineStates.mDistortionMappers),
         mZoomRatioMappers(offlineStates.mZoomRatioMappers),
         mRotateAndCropMappers(offlineStates.mRotateAndCropMappers),
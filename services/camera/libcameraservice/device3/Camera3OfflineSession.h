@@ -62,6 +62,7 @@ struct Camera3OfflineStates {
             const uint32_t nextShutterFN, const uint32_t nextReprocShutterFN,
             const uint32_t nextZslShutterFN, const CameraMetadata& deviceInfo,
             const std::unordered_map<std::string, CameraMetadata>& physicalDeviceInfoMap,
+            const camera3::PhysicalResultKeys& physicalResultKeys,
             const std::unordered_map<std::string, camera3::DistortionMapper>& distortionMappers,
             const std::unordered_map<std::string, camera3::ZoomRatioMapper>& zoomRatioMappers,
             const std::unordered_map<std::string, camera3::RotateAndCropMapper>&
@@ -80,6 +81,7 @@ struct Camera3OfflineStates {
             mNextZslStillShutterFrameNumber(nextZslShutterFN),
             mDeviceInfo(deviceInfo),
             mPhysicalDeviceInfoMap(physicalDeviceInfoMap),
+            mPhysicalResultKeys(physicalResultKeys),
             mDistortionMappers(distortionMappers),
             mZoomRatioMappers(zoomRatioMappers),
             mRotateAndCropMappers(rotateAndCropMappers) {}
@@ -119,6 +121,8 @@ struct Camera3OfflineStates {
 
     const std::unordered_map<std::string, CameraMetadata>& mPhysicalDeviceInfoMap;
 
+    const camera3::PhysicalResultKeys& mPhysicalResultKeys;
+
     const std::unordered_map<std::string, camera3::DistortionMapper>& mDistortionMappers;
 
     const std::unordered_map<std::string, camera3::ZoomRatioMapper>& mZoomRatioMappers;
@@ -142,7 +146,7 @@ class Camera3OfflineSession :
             const sp<camera3::Camera3Stream>& inputStream,
             const camera3::StreamSet& offlineStreamSet,
             camera3::BufferRecords&& bufferRecords,
-            const camera3::InFlightRequestMap& offlineReqs,
+            camera3::InFlightRequestMap&& offlineReqs,
             const Camera3OfflineStates& offlineStates);
 
     virtual ~Camera3OfflineSession();
@@ -210,10 +214,16 @@ class Camera3OfflineSession :
     uint32_t mNextReprocessShutterFrameNumber;
     // the minimal frame number of the next ZSL still capture shutter
     uint32_t mNextZslStillShutterFrameNumber;
+    // results waiting for metadata fixups outside of mInFlightLock
+    std::list<camera3::PendingCaptureResult> mPendingResults;
     // End of mOutputLock scope
 
+    // Serializes metadata fixups of mPendingResults across HAL callback threads
+    std::mutex mResultProcessingLock;
+
     const CameraMetadata mDeviceInfo;
     std::unordered_map<std::string, CameraMetadata> mPhysicalDeviceInfoMap;
+    camera3::PhysicalResultKeys mPhysicalResultKeys;
 
     std::unordered_map<std::string, camera3::DistortionMapper> mDistortionMappers;
 
@@ -1002,6 +1002,20 @@ status_t Camera3OutputStream::disconnectLocked() {
         mPreviewFrameSpacer->requestExit();
     }
 
+    // Hand the buffers the consumer has already released back to the buffer manager, so that
+    // a later configuration with the same size, format and usage doesn't need to allocate.
+    if (mUseBufferManager) {
+        for (size_t i = 0; i < mTotalBufferCount; i++) {
+            sp<GraphicBuffer> buffer;
+            sp<Fence> fence;
+            if (mConsumer->detachNextBuffer(&buffer, &fence) != OK || buffer == nullptr) {
+                break;
+            }
+            int fenceFd = (fence != nullptr && fence->isValid()) ? fence->dup() : -1;
+            mBufferManager->returnBufferForReuse(buffer, fenceFd);
+        }
+    }
+
     ALOGV("%s: disconnecting stream %d from native window", __FUNCTION__, getId());
 
     res = native_window_api_disconnect(mConsumer.get(),
@@ -1148,11 +1162,14 @@ void Camera3OutputStream::BufferProducerListener::onBufferReleased() {
 
     if (shouldFreeBuffer) {
         sp<GraphicBuffer> buffer;
-        // Detach and free a buffer (when buffer goes out of scope)
-        stream->detachBufferLocked(&buffer, /*fenceFd*/ nullptr);
+        int fenceFd = -1;
+        // Detach a buffer and hand it back to the buffer manager, which either keeps it for
+        // reuse or frees it
+        stream->detachBufferLocked(&buffer, &fenceFd);
         if (buffer.get() != nullptr) {
             stream->mBufferManager->notifyBufferRemoved(
                     stream->getId(), stream->getStreamSetId(), stream->isMultiResolution());
+            stream->mBufferManager->returnBufferForReuse(buffer, fenceFd);
         }
     }
 }
@@ -1383,9 +1400,18 @@ status_t Camera3OutputStream::setBatchSize(size_t batchSize) {
 }
 
 void Camera3OutputStream::onMinDurationChanged(nsecs_t duration, bool fixedFps) {
-    Mutex::Autolock l(mLock);
-    mMinExpectedDuration = duration;
-    mFixedFps = fixedFps;
+    sp<PreviewFrameSpacer> previewFrameSpacer;
+    {
+        Mutex::Autolock l(mLock);
+        mMinExpectedDuration = duration;
+        mFixedFps = fixedFps;
+        previewFrameSpacer = mPreviewFrameSpacer;
+    }
+    // The spacer thread calls back into this stream with its own lock held, so
+    // update it outside of mLock.
+    if (previewFrameSpacer != nullptr) {
+        previewFrameSpacer->setFixedFps(fixedFps);
+    }
 }
 
 void Camera3OutputStream::setStreamUseCase(int64_t streamUseCase) {
@@ -30,6 +30,7 @@
     "%s: " fmt, __FUNCTION__,                         \
     ##__VA_ARGS__)
 
+#include <algorithm>
 #include <inttypes.h>
 
 #include <utils/Log.h>
@@ -55,6 +56,73 @@ using namespace android::hardware::camera;
 namespace android {
 namespace camera3 {
 
+void buildPhysicalResultKeys(
+        const std::unordered_map<std::string, CameraMetadata>& physicalDeviceInfoMap,
+        PhysicalResultKeys* physicalResultKeys) {
+    physicalResultKeys->clear();
+    for (const auto& [physicalId, deviceInfo] : physicalDeviceInfoMap) {
+        camera_metadata_ro_entry_t entry = deviceInfo.find(ANDROID_REQUEST_AVAILABLE_RESULT_KEYS);
+        if (entry.count == 0) {
+            // Nothing advertised, forward everything the HAL reports
+            continue;
+        }
+        std::vector<uint32_t>& keys = (*physicalResultKeys)[physicalId];
+        keys.reserve(entry.count + 1);
+        for (size_t i = 0; i < entry.count; i++) {
+            keys.push_back(static_cast<uint32_t>(entry.data.i32[i]));
+        }
+        // Needed by finishCaptureResult even if the HAL forgot to advertise it
+        keys.push_back(ANDROID_SENSOR_TIMESTAMP);
+        std::sort(keys.begin(), keys.end());
+        keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+    }
+}
+
+// Copies a physical camera result from the HAL, dropping framework keys that the
+// physical camera doesn't advertise in ANDROID_REQUEST_AVAILABLE_RESULT_KEYS.
+// Vendor tags are always forwarded.
+static void copyPhysicalResult(const PhysicalResultKeys& physicalResultKeys,
+        const std::string& physicalId, const camera_metadata_t* halMetadata,
+        CameraMetadata* physicalMetadata) {
+    auto keysIt = physicalResultKeys.find(physicalId);
+    if (keysIt == physicalResultKeys.end()) {
+        physicalMetadata->append(halMetadata);
+        return;
+    }
+    const std::vector<uint32_t>& keys = keysIt->second;
+    auto isForwarded = [&keys](uint32_t tag) {
+        return tag >= (VENDOR_SECTION << 16) ||
+                std::binary_search(keys.begin(), keys.end(), tag);
+    };
+
+    size_t entryCount = get_camera_metadata_entry_count(halMetadata);
+    size_t droppedCount = 0;
+    camera_metadata_ro_entry_t entry;
+    for (size_t i = 0; i < entryCount; i++) {
+        get_camera_metadata_ro_entry(halMetadata, i, &entry);
+        if (!isForwarded(entry.tag)) {
+            droppedCount++;
+        }
+    }
+    if (droppedCount == 0) {
+        // Common case, a single buffer copy
+        physicalMetadata->append(halMetadata);
+        return;
+    }
+
+    CameraMetadata filtered(entryCount - droppedCount,
+            get_camera_metadata_data_count(halMetadata));
+    for (size_t i = 0; i < entryCount; i++) {
+        get_camera_metadata_ro_entry(halMetadata, i, &entry);
+        if (isForwarded(entry.tag)) {
+            filtered.update(entry);
+        }
+    }
+    *physicalMetadata = std::move(filtered);
+    ALOGVV("%s: Dropped %zu of %zu result entries of physical camera %s", __FUNCTION__,
+            droppedCount, entryCount, physicalId.c_str());
+}
+
 status_t fixupMonochromeTags(
         CaptureOutputStates& states,
         const CameraMetadata& deviceInfo,
@@ -234,9 +302,18 @@ void sendPartialCaptureResult(CaptureOutputStates& states,
     ATRACE_CALL();
     std::lock_guard<std::mutex> l(states.outputLock);
 
-    CaptureResult captureResult;
-    captureResult.mResultExtras = resultExtras;
-    captureResult.mMetadata = partialResult;
+    // Fixups are applied by processPendingResults() once the in-flight lock is released.
+    PendingCaptureResult& pending = states.pendingResults.emplace_back();
+    pending.result.mResultExtras = resultExtras;
+    pending.result.mMetadata = partialResult;
+    pending.frameNumber = frameNumber;
+    pending.partial = true;
+}
+
+void finishPartialCaptureResult(CaptureOutputStates& states, PendingCaptureResult& pending) {
+    ATRACE_CALL();
+    CaptureResult& captureResult = pending.result;
+    uint32_t frameNumber = pending.frameNumber;
 
     // Fix up result metadata for monochrome camera.
     status_t res = fixupMonochromeTags(states, states.deviceInfo, captureResult.mMetadata);
@@ -270,6 +347,7 @@ void sendPartialCaptureResult(CaptureOutputStates& states,
 
     // Send partial result
     if (captureResult.mMetadata.entryCount() > 0) {
+        std::lock_guard<std::mutex> l(states.outputLock);
         insertResultLocked(states, &captureResult, frameNumber);
     }
 }
@@ -282,7 +360,7 @@ void sendCaptureResult(
         uint32_t frameNumber,
         bool reprocess, bool zslStillCapture, bool rotateAndCropAuto,
         const std::set<std::string>& cameraIdsWithZoom,
-        const std::vector<PhysicalCaptureResultInfo>& physicalMetadatas) {
+        std::vector<PhysicalCaptureResultInfo>&& physicalMetadatas) {
     ATRACE_CALL();
     if (pendingMetadata.isEmpty())
         return;
@@ -316,15 +394,30 @@ void sendCaptureResult(
         states.nextResultFrameNum = frameNumber + 1;
     }
 
-    CaptureResult captureResult;
+    // Fixups are applied by processPendingResults() once the in-flight lock is released.
+    PendingCaptureResult& pending = states.pendingResults.emplace_back();
+    CaptureResult& captureResult = pending.result;
     captureResult.mResultExtras = resultExtras;
     captureResult.mMetadata = pendingMetadata;
-    captureResult.mPhysicalMetadatas = physicalMetadatas;
+    // Physical results are sent once, with the final result, so the in-flight
+    // request doesn't need its copy anymore
+    captureResult.mPhysicalMetadatas = std::move(physicalMetadatas);
 
     // Append any previous partials to form a complete result
     if (states.usePartialResult && !collectedPartialResult.isEmpty()) {
         captureResult.mMetadata.append(collectedPartialResult);
     }
+    pending.frameNumber = frameNumber;
+    pending.rotateAndCropAuto = rotateAndCropAuto;
+    pending.cameraIdsWithZoom = cameraIdsWithZoom;
+}
+
+void finishCaptureResult(CaptureOutputStates& states, PendingCaptureResult& pending) {
+    ATRACE_CALL();
+    CaptureResult& captureResult = pending.result;
+    uint32_t frameNumber = pending.frameNumber;
+    bool rotateAndCropAuto = pending.rotateAndCropAuto;
+    const std::set<std::string>& cameraIdsWithZoom = pending.cameraIdsWithZoom;
 
     captureResult.mMetadata.sort();
 
@@ -441,7 +534,7 @@ void sendCaptureResult(
     }
 
     std::unordered_map<std::string, CameraMetadata> monitoredPhysicalMetadata;
-    for (auto& m : physicalMetadatas) {
+    for (auto& m : captureResult.mPhysicalMetadatas) {
         monitoredPhysicalMetadata.emplace(String8(m.mPhysicalCameraId).string(),
                 CameraMetadata(m.mPhysicalCameraMetadata));
     }
@@ -449,9 +542,30 @@ void sendCaptureResult(
             frameNumber, sensorTimestamp, captureResult.mMetadata,
             monitoredPhysicalMetadata);
 
+    std::lock_guard<std::mutex> l(states.outputLock);
     insertResultLocked(states, &captureResult, frameNumber);
 }
 
+void processPendingResults(CaptureOutputStates& states) {
+    ATRACE_CALL();
+    std::lock_guard<std::mutex> pl(states.resultProcessingLock);
+    while (true) {
+        std::list<PendingCaptureResult> next;
+        {
+            std::lock_guard<std::mutex> l(states.outputLock);
+            if (states.pendingResults.empty()) {
+                break;
+            }
+            next.splice(next.end(), states.pendingResults, states.pendingResults.begin());
+        }
+        if (next.front().partial) {
+            finishPartialCaptureResult(states, next.front());
+        } else {
+            finishCaptureResult(states, next.front());
+        }
+    }
+}
+
 void removeInFlightMapEntryLocked(CaptureOutputStates& states, int idx) {
     ATRACE_CALL();
     InFlightRequestMap& inflightMap = states.inflightMap;
@@ -566,7 +680,7 @@ const std::set<std::string>& getCameraIdsWithZoomLocked(
     return r.cameraIdsWithZoom;
 }
 
-void processCaptureResult(CaptureOutputStates& states, const camera_capture_result *result) {
+void acceptCaptureResult(CaptureOutputStates& states, const camera_capture_result *result) {
     ATRACE_CALL();
 
     status_t res;
@@ -623,6 +737,15 @@ void processCaptureResult(CaptureOutputStates& states, const camera_capture_resu
         if (result->partial_result != 0)
             request.resultExtras.partialResultCount = result->partial_result;
 
+        if (result->result != nullptr && request.firstResultTimeNs == 0) {
+            request.firstResultTimeNs = systemTime();
+            if (request.halSubmitTimeNs > 0) {
+                states.sessionStatsBuilder.incStageLatency(
+                        SessionStatsBuilder::STAGE_FIRST_PARTIAL,
+                        ns2ms(request.firstResultTimeNs - request.halSubmitTimeNs));
+            }
+        }
+
         if (result->result != nullptr) {
             camera_metadata_ro_entry entry;
             auto ret = find_camera_metadata_ro_entry(result->result,
@@ -728,6 +851,11 @@ void processCaptureResult(CaptureOutputStates& states, const camera_capture_resu
             }
             request.haveResultMetadata = true;
             request.errorBufStrategy = ERROR_BUF_RETURN_NOTIFY;
+            if (request.halSubmitTimeNs > 0) {
+                states.sessionStatsBuilder.incStageLatency(
+                        SessionStatsBuilder::STAGE_FINAL_RESULT,
+                        ns2ms(systemTime() - request.halSubmitTimeNs));
+            }
         }
 
         uint32_t numBuffersReturned = result->num_output_buffers;
@@ -765,11 +893,12 @@ void processCaptureResult(CaptureOutputStates& states, const camera_capture_resu
         }
 
         if (result->result != NULL && !isPartialResult) {
+            request.physicalMetadatas.reserve(result->num_physcam_metadata);
             for (uint32_t i = 0; i < result->num_physcam_metadata; i++) {
-                CameraMetadata physicalMetadata;
-                physicalMetadata.append(result->physcam_metadata[i]);
-                request.physicalMetadatas.push_back({String16(result->physcam_ids[i]),
-                        physicalMetadata});
+                PhysicalCaptureResultInfo& info = request.physicalMetadatas.emplace_back();
+                info.mPhysicalCameraId = String16(result->physcam_ids[i]);
+                copyPhysicalResult(states.physicalResultKeys, result->physcam_ids[i],
+                        result->physcam_metadata[i], &info.mPhysicalCameraMetadata);
             }
             if (shutterTimestamp == 0) {
                 request.pendingMetadata = result->result;
@@ -783,7 +912,7 @@ void processCaptureResult(CaptureOutputStates& states, const camera_capture_resu
                     collectedPartialResult, frameNumber,
                     hasInputBufferInRequest, request.zslCapture && request.stillCapture,
                     request.rotateAndCropAuto, cameraIdsWithZoom,
-                    request.physicalMetadatas);
+                    std::move(request.physicalMetadatas));
             }
         }
         removeInFlightRequestIfReadyLocked(states, idx);
@@ -809,6 +938,13 @@ void processCaptureResult(CaptureOutputStates& states, const camera_capture_resu
     }
 }
 
+void processCaptureResult(CaptureOutputStates& states, const camera_capture_result *result) {
+    // Buffers are returned and results are ordered while holding the in-flight lock; metadata
+    // fixups and delivery to the result queue happen after it has been released.
+    acceptCaptureResult(states, result);
+    processPendingResults(states);
+}
+
 void returnOutputBuffers(
         bool useHalBufManager,
         sp<NotificationListener> listener,
@@ -981,6 +1117,10 @@ void notifyShutter(CaptureOutputStates& states, const camera_shutter_msg_t &msg)
             }
 
             r.shutterTimestamp = msg.timestamp;
+            if (r.halSubmitTimeNs > 0) {
+                states.sessionStatsBuilder.incStageLatency(SessionStatsBuilder::STAGE_SHUTTER,
+                        ns2ms(systemTime() - r.halSubmitTimeNs));
+            }
             if (msg.readout_timestamp_valid) {
                 r.resultExtras.hasReadoutTimestamp = true;
                 r.resultExtras.readoutTimestamp = msg.readout_timestamp;
@@ -1015,7 +1155,7 @@ void notifyShutter(CaptureOutputStates& states, const camera_shutter_msg_t &msg)
                     r.pendingMetadata, r.resultExtras,
                     r.collectedPartialResult, msg.frame_number,
                     r.hasInputBuffer, r.zslCapture && r.stillCapture,
-                    r.rotateAndCropAuto, cameraIdsWithZoom, r.physicalMetadatas);
+                    r.rotateAndCropAuto, cameraIdsWithZoom, std::move(r.physicalMetadatas));
             }
             returnAndRemovePendingOutputBuffers(
                     states.useHalBufManager, states.listener, r, states.sessionStatsBuilder);
@@ -1151,6 +1291,8 @@ void notify(CaptureOutputStates& states, const camera_notify_msg *msg) {
             SET_ERR("Unknown notify message from HAL: %d",
                     msg->type);
     }
+    // A shutter may have released results that were waiting for it.
+    processPendingResults(states);
 }
 
 void flushInflightRequests(FlushInflightReqStates& states) {
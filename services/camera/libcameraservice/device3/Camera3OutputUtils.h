@@ -17,8 +17,13 @@
 #ifndef ANDROID_SERVERS_CAMERA3_OUTPUT_UTILS_H
 #define ANDROID_SERVERS_CAMERA3_OUTPUT_UTILS_H
 
+#include <list>
 #include <memory>
 #include <mutex>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 #include <cutils/native_handle.h>
 
@@ -68,8 +73,28 @@ namespace camera3 {
             sp<NotificationListener> listener, // Only needed when outputSurfaces is not empty
             InFlightRequest& request, SessionStatsBuilder& sessionStatsBuilder);
 
+    // A capture result that has been accepted in frame order under the in-flight lock, but
+    // whose metadata fixups and delivery to the result queue are deferred until that lock
+    // is released.
+    struct PendingCaptureResult {
+        CaptureResult result;
+        uint32_t frameNumber = 0;
+        bool partial = false;
+        bool rotateAndCropAuto = false;
+        std::set<std::string> cameraIdsWithZoom;
+    };
+
     // Camera3Device/Camera3OfflineSession internal states used in notify/processCaptureResult
     // callbacks
+    // Physical camera id -> sorted framework result keys advertised by that camera
+    typedef std::unordered_map<std::string, std::vector<uint32_t>> PhysicalResultKeys;
+
+    // Precomputes the result keys forwarded to clients for each physical camera, from
+    // ANDROID_REQUEST_AVAILABLE_RESULT_KEYS of its static metadata.
+    void buildPhysicalResultKeys(
+            const std::unordered_map<std::string, CameraMetadata>& physicalDeviceInfoMap,
+            PhysicalResultKeys* physicalResultKeys);
+
     struct CaptureOutputStates {
         const String8& cameraId;
         std::mutex& inflightLock;
@@ -85,7 +110,11 @@ namespace camera3 {
         uint32_t& nextZslShutterFrameNum;
         uint32_t& nextResultFrameNum;
         uint32_t& nextReprocResultFrameNum;
-        uint32_t& nextZslResultFrameNum; // end of outputLock scope
+        uint32_t& nextZslResultFrameNum;
+        std::list<PendingCaptureResult>& pendingResults; // end of outputLock scope
+        // Serializes draining pendingResults, so that results reach resultQueue in the
+        // order they were accepted.
+        std::mutex& resultProcessingLock;
         const bool useHalBufManager;
         const bool usePartialResult;
         const bool needFixupMonoChrome;
@@ -93,6 +122,7 @@ namespace camera3 {
         const metadata_vendor_id_t vendorTagId;
         const CameraMetadata& deviceInfo;
         const std::unordered_map<std::string, CameraMetadata>& physicalDeviceInfoMap;
+        const PhysicalResultKeys& physicalResultKeys;
         std::unordered_map<std::string, camera3::DistortionMapper>& distortionMappers;
         std::unordered_map<std::string, camera3::ZoomRatioMapper>& zoomRatioMappers;
         std::unordered_map<std::string, camera3::RotateAndCropMapper>& rotateAndCropMappers;
@@ -15,6 +15,9 @@
  */
 
 #include <inttypes.h>
+#include <unistd.h>
+
+#include <algorithm>
 
 #define LOG_TAG "Camera3StreamSplitter"
 #define ATRACE_TAG ATRACE_TAG_CAMERA
@@ -143,6 +146,7 @@ void Camera3StreamSplitter::disconnect() {
     mOutputSurfaces.clear();
     mOutputSlots.clear();
     mConsumerBufferCount.clear();
+    mOutputStats.clear();
 
     if (mConsumer.get() != nullptr) {
         mConsumer->consumerDisconnect();
@@ -255,6 +259,14 @@ status_t Camera3StreamSplitter::addOutputLocked(size_t surfaceId, const sp<Surfa
         outputQueue->setDequeueTimeout(timeout);
     }
 
+    // CPU-only consumers (typically analysis readers) skip frames while they are
+    // busy rather than holding back preview and recording.
+    OutputStats stats;
+    if (res == OK && !(usage & (GRALLOC_USAGE_HW_COMPOSER | GRALLOC_USAGE_HW_TEXTURE |
+            GRALLOC_USAGE_HW_VIDEO_ENCODER))) {
+        stats.dropPolicy = DROP_POLICY_WHEN_BUSY;
+    }
+
     res = gbp->allowAllocation(false);
     if (res != OK) {
         SP_LOGE("%s: Failed to turn off allocation for outputQueue", __FUNCTION__);
@@ -271,6 +283,7 @@ status_t Camera3StreamSplitter::addOutputLocked(size_t surfaceId, const sp<Surfa
     }
     mNotifiers[gbp] = listener;
     mOutputSlots[gbp] = std::make_unique<OutputSlots>(totalBufferCount);
+    mOutputStats[surfaceId] = stats;
 
     mMaxConsumerBuffers += maxConsumerBuffers;
     return NO_ERROR;
@@ -327,6 +340,7 @@ status_t Camera3StreamSplitter::removeOutputLocked(size_t surfaceId) {
     for (const auto &id : pendingBufferIds) {
         decrementBufRefCountLocked(id, surfaceId);
     }
+    mOutputStats.erase(surfaceId);
 
     auto res = IInterface::asBinder(gbp)->unlinkToDeath(mNotifiers[gbp]);
     if (res != OK) {
@@ -360,9 +374,20 @@ status_t Camera3StreamSplitter::outputBufferLocked(const sp<IGraphicBufferProduc
     IGraphicBufferProducer::QueueBufferOutput queueOutput;
 
     uint64_t bufferId = bufferItem.mGraphicBuffer->getId();
-    const BufferTracker& tracker = *(mBuffers[bufferId]);
+    BufferTracker& tracker = *(mBuffers[bufferId]);
     int slot = getSlotForOutputLocked(output, tracker.getBuffer());
 
+    // Account for the buffer before the lock is dropped below, so that a release
+    // racing with queueBuffer finds it. A failed queue is unwound by the
+    // decrementBufRefCountLocked call further down.
+    tracker.markQueuedLocked(surfaceId);
+    auto stats = mOutputStats.find(surfaceId);
+    if (stats != mOutputStats.end()) {
+        stats->second.outstanding++;
+        stats->second.maxOutstanding =
+                std::max(stats->second.maxOutstanding, stats->second.outstanding);
+    }
+
     if (mOutputSurfaces[surfaceId] != nullptr) {
         sp<ANativeWindow> anw = mOutputSurfaces[surfaceId];
         camera3::Camera3Stream::queueHDRMetadata(
@@ -386,6 +411,14 @@ status_t Camera3StreamSplitter::outputBufferLocked(const sp<IGraphicBufferProduc
     if (mOutputSlots[output] == nullptr) {
         return res;
     }
+    stats = mOutputStats.find(surfaceId);
+    if (stats != mOutputStats.end()) {
+        if (res == OK) {
+            stats->second.framesQueued++;
+        } else {
+            stats->second.queueErrors++;
+        }
+    }
     if (res != OK) {
         if (res != NO_INIT && res != DEAD_OBJECT) {
             SP_LOGE("Queuing buffer to output failed (%d)", res);
@@ -435,10 +468,30 @@ status_t Camera3StreamSplitter::attachBufferToOutputs(ANativeWindowBuffer* anb,
     sp<GraphicBuffer> gb(static_cast<GraphicBuffer*>(anb));
     uint64_t bufferId = gb->getId();
 
+    // Leave out busy outputs whose policy allows dropping, unless that would
+    // leave the buffer with no output at all.
+    std::vector<size_t> outputIds;
+    outputIds.reserve(surface_ids.size());
+    for (auto& surface_id : surface_ids) {
+        if (!shouldDropForOutputLocked(surface_id)) {
+            outputIds.push_back(surface_id);
+        }
+    }
+    if (outputIds.empty()) {
+        outputIds = surface_ids;
+    } else if (outputIds.size() < surface_ids.size()) {
+        for (auto& surface_id : surface_ids) {
+            if (std::find(outputIds.begin(), outputIds.end(), surface_id) == outputIds.end()) {
+                SP_LOGV("%s: Dropping frame for busy output %zu", __FUNCTION__, surface_id);
+                mOutputStats[surface_id].framesDropped++;
+            }
+        }
+    }
+
     // Initialize buffer tracker for this input buffer
-    auto tracker = std::make_unique<BufferTracker>(gb, surface_ids);
+    auto tracker = std::make_unique<BufferTracker>(gb, outputIds);
 
-    for (auto& surface_id : surface_ids) {
+    for (auto& surface_id : outputIds) {
         sp<IGraphicBufferProducer>& gbp = mOutputs[surface_id];
         if (gbp.get() == nullptr) {
             //Output surface got likely removed by client.
@@ -570,6 +623,13 @@ void Camera3StreamSplitter::decrementBufRefCountLocked(uint64_t id, size_t surfa
         return;
     }
 
+    if (mBuffers[id]->clearQueuedLocked(surfaceId)) {
+        auto stats = mOutputStats.find(surfaceId);
+        if (stats != mOutputStats.end() && stats->second.outstanding > 0) {
+            stats->second.outstanding--;
+        }
+    }
+
     size_t referenceCount = mBuffers[id]->decrementReferenceCountLocked(surfaceId);
     if (referenceCount > 0) {
         return;
@@ -698,7 +758,7 @@ void Camera3StreamSplitter::returnOutputBufferLocked(const sp<Fence>& fence,
         return;
     }
 
-    auto outputSlots = *mOutputSlots[from];
+    auto& outputSlots = *mOutputSlots[from];
     buffer = outputSlots[slot];
     BufferTracker& tracker = *(mBuffers[buffer->getId()]);
     // Merge the release fence of the incoming buffer so that the fence we send
@@ -756,6 +816,42 @@ void Camera3StreamSplitter::onAbandonedLocked() {
     SP_LOGV("One of my outputs has abandoned me");
 }
 
+bool Camera3StreamSplitter::shouldDropForOutputLocked(size_t surfaceId) {
+    auto stats = mOutputStats.find(surfaceId);
+    if (stats == mOutputStats.end() || stats->second.dropPolicy != DROP_POLICY_WHEN_BUSY) {
+        return false;
+    }
+    size_t limit = std::max<size_t>(mConsumerBufferCount[surfaceId], 1);
+    return stats->second.outstanding >= limit;
+}
+
+status_t Camera3StreamSplitter::setOutputDropPolicy(size_t surfaceId, DropPolicy policy) {
+    Mutex::Autolock lock(mMutex);
+    auto stats = mOutputStats.find(surfaceId);
+    if (stats == mOutputStats.end()) {
+        SP_LOGE("%s: output surface %zu is not present!", __FUNCTION__, surfaceId);
+        return BAD_VALUE;
+    }
+    stats->second.dropPolicy = policy;
+    return OK;
+}
+
+void Camera3StreamSplitter::dump(int fd) const {
+    Mutex::Autolock lock(mMutex);
+    String8 lines;
+    lines.appendFormat("      Stream splitter %s: %zu tracked buffers, %zu acquired\n",
+            mConsumerName.string(), mBuffers.size(), mAcquiredInputBuffers);
+    for (const auto& it : mOutputStats) {
+        const OutputStats& stats = it.second;
+        lines.appendFormat("        Output %zu: %s, queued %" PRIu64 ", dropped %" PRIu64
+                ", errors %" PRIu64 ", outstanding %zu (max %zu)\n", it.first,
+                stats.dropPolicy == DROP_POLICY_WHEN_BUSY ? "drop when busy" : "no drop",
+                stats.framesQueued, stats.framesDropped, stats.queueErrors,
+                stats.outstanding, stats.maxOutstanding);
+    }
+    write(fd, lines.string(), lines.size());
+}
+
 int Camera3StreamSplitter::getSlotForOutputLocked(const sp<IGraphicBufferProducer>& gbp,
         const sp<GraphicBuffer>& gb) {
     auto& outputSlots = *mOutputSlots[gbp];
@@ -802,6 +898,19 @@ void Camera3StreamSplitter::BufferTracker::mergeFence(const sp<Fence>& with) {
     mMergedFence = Fence::merge(String8("Camera3StreamSplitter"), mMergedFence, with);
 }
 
+void Camera3StreamSplitter::BufferTracker::markQueuedLocked(size_t surfaceId) {
+    mQueuedSurfaces.push_back(surfaceId);
+}
+
+bool Camera3StreamSplitter::BufferTracker::clearQueuedLocked(size_t surfaceId) {
+    const auto& it = std::find(mQueuedSurfaces.begin(), mQueuedSurfaces.end(), surfaceId);
+    if (it == mQueuedSurfaces.end()) {
+        return false;
+    }
+    mQueuedSurfaces.erase(it);
+    return true;
+}
+
 size_t Camera3StreamSplitter::BufferTracker::decrementReferenceCountLocked(size_t surfaceId) {
     const auto& it = std::find(mRequestedSurfaces.begin(), mRequestedSurfaces.end(), surfaceId);
     if (it == mRequestedSurfaces.end()) {
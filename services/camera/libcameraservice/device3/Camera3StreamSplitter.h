@@ -94,6 +94,24 @@ public:
     // Disconnect the buffer queue from output surfaces.
     void disconnect();
 
+    // How an output is treated when its consumer falls behind.
+    enum DropPolicy {
+        // Every requested frame is queued to the output, and input buffers stay
+        // held for as long as the consumer keeps them.
+        DROP_POLICY_NONE,
+        // New frames are not sent to the output while it already holds as many
+        // frames as its consumer can acquire, so a slow consumer doesn't starve
+        // the other outputs sharing the stream of input buffers.
+        DROP_POLICY_WHEN_BUSY,
+    };
+
+    // Override the drop policy picked for an output when it was added. CPU-only
+    // consumers default to DROP_POLICY_WHEN_BUSY, all others to DROP_POLICY_NONE.
+    status_t setOutputDropPolicy(size_t surfaceId, DropPolicy policy);
+
+    // Dump per-output buffer sharing statistics.
+    void dump(int fd) const;
+
 private:
     // From IConsumerListener
     //
@@ -192,6 +210,11 @@ private:
 
         const std::vector<size_t> requestedSurfaces() const { return mRequestedSurfaces; }
 
+        // Record that the buffer has been queued to an output, and clear that
+        // record once the output releases it. Only called while mMutex is held.
+        void markQueuedLocked(size_t surfaceId);
+        bool clearQueuedLocked(size_t surfaceId);
+
     private:
 
         // Disallow copying
@@ -205,6 +228,8 @@ private:
         // available from the input queue, the registered surfaces are used to decide
         // which output is the buffer sent to.
         std::vector<size_t> mRequestedSurfaces;
+        // Outputs the buffer is currently queued to and not yet released by.
+        std::vector<size_t> mQueuedSurfaces;
         size_t mReferenceCount;
     };
 
@@ -221,6 +246,9 @@ private:
     status_t outputBufferLocked(const sp<IGraphicBufferProducer>& output,
             const BufferItem& bufferItem, size_t surfaceId);
 
+    // Whether a new frame should skip the given output because of its drop policy.
+    bool shouldDropForOutputLocked(size_t surfaceId);
+
     // Get unique name for the buffer queue consumer
     String8 getUniqueConsumerName();
 
@@ -242,7 +270,7 @@ private:
     static const nsecs_t kNormalDequeueBufferTimeout    = s2ns(1);  // 1 sec
     static const nsecs_t kHalBufMgrDequeueBufferTimeout = ms2ns(1); // 1 msec
 
-    Mutex mMutex;
+    mutable Mutex mMutex;
 
     sp<IGraphicBufferProducer> mProducer;
     sp<IGraphicBufferConsumer> mConsumer;
@@ -279,6 +307,19 @@ private:
     std::unordered_map<sp<IGraphicBufferProducer>, std::unique_ptr<OutputSlots>,
             GBPHash> mOutputSlots;
 
+    struct OutputStats {
+        DropPolicy dropPolicy = DROP_POLICY_NONE;
+        // Buffers queued to the output and not yet released back by it
+        size_t outstanding = 0;
+        size_t maxOutstanding = 0;
+        uint64_t framesQueued = 0;
+        uint64_t framesDropped = 0;
+        uint64_t queueErrors = 0;
+    };
+
+    //Map surface ids -> sharing statistics and drop policy
+    std::unordered_map<size_t, OutputStats> mOutputStats;
+
     //A set of buffers that could potentially stay in some of the outputs after removal
     //and therefore should be detached from the input queue.
     std::unordered_set<uint64_t> mDetachedBuffers;
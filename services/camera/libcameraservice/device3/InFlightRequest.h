@@ -17,10 +17,14 @@
 #ifndef ANDROID_SERVERS_CAMERA3_INFLIGHT_REQUEST_H
 #define ANDROID_SERVERS_CAMERA3_INFLIGHT_REQUEST_H
 
+#include <algorithm>
+#include <deque>
+#include <memory>
 #include <set>
 
 #include <camera/CaptureResult.h>
 #include <camera/CameraMetadata.h>
+#include <utils/Errors.h>
 #include <utils/String8.h>
 #include <utils/Timers.h>
 
@@ -191,6 +195,12 @@ struct InFlightRequest {
     // Time of capture request (from systemTime) in Ns
     nsecs_t requestTimeNs;
 
+    // Time the request was registered for submission to the HAL (from systemTime) in Ns
+    nsecs_t halSubmitTimeNs;
+
+    // Time the first (partial or final) result metadata arrived (from systemTime) in Ns
+    nsecs_t firstResultTimeNs;
+
     // What shared surfaces an output should go to
     SurfaceMap outputSurfaces;
 
@@ -219,6 +229,8 @@ struct InFlightRequest {
             rotateAndCropAuto(false),
             autoframingAuto(false),
             requestTimeNs(0),
+            halSubmitTimeNs(0),
+            firstResultTimeNs(0),
             transform(-1) {
     }
 
@@ -248,13 +260,127 @@ struct InFlightRequest {
             autoframingAuto(autoframingAuto),
             cameraIdsWithZoom(idsWithZoom),
             requestTimeNs(requestNs),
+            halSubmitTimeNs(0),
+            firstResultTimeNs(0),
             outputSurfaces(outSurfaces),
             transform(-1) {
     }
 };
 
-// Map from frame number to the in-flight request state
-typedef KeyedVector<uint32_t, InFlightRequest> InFlightRequestMap;
+// Map from frame number to the in-flight request state.
+//
+// Exposes the subset of the KeyedVector interface used by the device and offline
+// session, with entries ordered by ascending frame number so that positional indices
+// and flush iteration order are unchanged. Frame numbers are registered in increasing
+// order and almost always retired from the front, so entries are kept in a deque of
+// heap-allocated requests: insertion and removal at either end never copy a request,
+// and a lookup for a contiguous run of frame numbers resolves by offset from the
+// oldest entry, falling back to a binary search when the run has gaps.
+class InFlightRequestMap {
+  public:
+    InFlightRequestMap() = default;
+    InFlightRequestMap(InFlightRequestMap&&) = default;
+    InFlightRequestMap& operator=(InFlightRequestMap&&) = default;
+
+    InFlightRequestMap(const InFlightRequestMap& other) {
+        copyFrom(other);
+    }
+
+    InFlightRequestMap& operator=(const InFlightRequestMap& other) {
+        if (this != &other) {
+            mEntries.clear();
+            copyFrom(other);
+        }
+        return *this;
+    }
+
+    size_t size() const { return mEntries.size(); }
+    bool isEmpty() const { return mEntries.empty(); }
+
+    // Adds or replaces the request for frameNumber; returns its index.
+    ssize_t add(uint32_t frameNumber, const InFlightRequest& request) {
+        return add(frameNumber, std::make_unique<InFlightRequest>(request));
+    }
+
+    // Same as above, taking ownership of an already allocated request.
+    ssize_t add(uint32_t frameNumber, std::unique_ptr<InFlightRequest> request) {
+        if (mEntries.empty() || mEntries.back().frameNumber < frameNumber) {
+            mEntries.push_back(Entry{frameNumber, std::move(request)});
+            return mEntries.size() - 1;
+        }
+        auto it = lowerBound(frameNumber);
+        if (it != mEntries.end() && it->frameNumber == frameNumber) {
+            it->request = std::move(request);
+        } else {
+            it = mEntries.insert(it, Entry{frameNumber, std::move(request)});
+        }
+        return it - mEntries.begin();
+    }
+
+    // Removes the entry at index and hands its request over to the caller.
+    std::unique_ptr<InFlightRequest> takeAt(size_t index) {
+        std::unique_ptr<InFlightRequest> request = std::move(mEntries[index].request);
+        mEntries.erase(mEntries.begin() + index);
+        return request;
+    }
+
+    // Returns the index of frameNumber, or NAME_NOT_FOUND.
+    ssize_t indexOfKey(uint32_t frameNumber) const {
+        if (mEntries.empty()) return NAME_NOT_FOUND;
+        uint32_t first = mEntries.front().frameNumber;
+        if (frameNumber >= first) {
+            size_t offset = frameNumber - first;
+            if (offset < mEntries.size() && mEntries[offset].frameNumber == frameNumber) {
+                return offset;
+            }
+        }
+        auto it = lowerBound(frameNumber);
+        if (it == mEntries.end() || it->frameNumber != frameNumber) return NAME_NOT_FOUND;
+        return it - mEntries.begin();
+    }
+
+    uint32_t keyAt(size_t index) const { return mEntries[index].frameNumber; }
+    const InFlightRequest& valueAt(size_t index) const { return *mEntries[index].request; }
+    InFlightRequest& editValueAt(size_t index) { return *mEntries[index].request; }
+
+    // frameNumber must be present in the map.
+    const InFlightRequest& valueFor(uint32_t frameNumber) const {
+        return valueAt(indexOfKey(frameNumber));
+    }
+
+    ssize_t removeItemsAt(size_t index, size_t count = 1) {
+        if (index + count > mEntries.size()) return BAD_VALUE;
+        mEntries.erase(mEntries.begin() + index, mEntries.begin() + index + count);
+        return index;
+    }
+
+    void clear() { mEntries.clear(); }
+
+  private:
+    struct Entry {
+        uint32_t frameNumber;
+        std::unique_ptr<InFlightRequest> request;
+    };
+
+    std::deque<Entry>::const_iterator lowerBound(uint32_t frameNumber) const {
+        return std::lower_bound(mEntries.begin(), mEntries.end(), frameNumber,
+                [](const Entry& e, uint32_t key) { return e.frameNumber < key; });
+    }
+
+    std::deque<Entry>::iterator lowerBound(uint32_t frameNumber) {
+        return std::lower_bound(mEntries.begin(), mEntries.end(), frameNumber,
+                [](const Entry& e, uint32_t key) { return e.frameNumber < key; });
+    }
+
+    void copyFrom(const InFlightRequestMap& other) {
+        for (const auto& e : other.mEntries) {
+            mEntries.push_back(Entry{e.frameNumber,
+                    std::make_unique<InFlightRequest>(*e.request)});
+        }
+    }
+
+    std::deque<Entry> mEntries;
+};
 
 } // namespace camera3
 
@@ -63,6 +63,7 @@ bool PreviewFrameSpacer::threadLoop() {
     // If the readout interval exceeds threshold, directly queue
     // cached buffer.
     if (readoutInterval >= kFrameIntervalThreshold) {
+        mTargetPresentTime = 0;
         mPendingBuffers.pop();
         queueBufferToClientLocked(buffer, currentTime);
         return true;
@@ -71,8 +72,19 @@ bool PreviewFrameSpacer::threadLoop() {
     // Cache the frame to match readout time interval, for up to kMaxFrameWaitTime
     // Because the code between here and queueBuffer() takes time to execute, make sure the
     // presentationInterval is slightly shorter than readoutInterval.
-    nsecs_t expectedQueueTime = mLastCameraPresentTime + readoutInterval - kFrameAdjustThreshold;
-    nsecs_t frameWaitTime = std::min(kMaxFrameWaitTime, expectedQueueTime - currentTime);
+    //
+    // For fixed fps streams, target the display frame timeline instead, waiting for
+    // at most one readout interval.
+    nsecs_t expectedQueueTime = 0;
+    nsecs_t maxFrameWaitTime = kMaxFrameWaitTime;
+    if (mFixedFps && getPredictedQueueTimeLocked(readoutInterval, currentTime,
+            &expectedQueueTime)) {
+        maxFrameWaitTime = std::max(kMaxFrameWaitTime, readoutInterval);
+    } else {
+        mTargetPresentTime = 0;
+        expectedQueueTime = mLastCameraPresentTime + readoutInterval - kFrameAdjustThreshold;
+    }
+    nsecs_t frameWaitTime = std::min(maxFrameWaitTime, expectedQueueTime - currentTime);
     if (frameWaitTime > 0 && mPendingBuffers.size() < 2) {
         mBufferCond.waitRelative(mLock, frameWaitTime);
         if (exitPending()) {
@@ -95,6 +107,60 @@ void PreviewFrameSpacer::requestExit() {
     mBufferCond.signal();
 }
 
+void PreviewFrameSpacer::setFixedFps(bool fixedFps) {
+    mFixedFps = fixedFps;
+}
+
+bool PreviewFrameSpacer::getPredictedQueueTimeLocked(nsecs_t readoutInterval,
+        nsecs_t currentTime, nsecs_t* queueTime) {
+    ParcelableVsyncEventData parcelableVsyncEventData;
+    status_t res = mDisplayEventReceiver.getLatestVsyncEventData(&parcelableVsyncEventData);
+    if (res != OK) {
+        ALOGV("%s: Failed to get latest vsync event data: %s (%d)", __FUNCTION__,
+                strerror(-res), res);
+        return false;
+    }
+    const VsyncEventData& vsyncEventData = parcelableVsyncEventData.vsync;
+    nsecs_t frameInterval = vsyncEventData.frameInterval;
+    if (frameInterval <= 0) {
+        return false;
+    }
+
+    // The consumer latches a buffer for a frame timeline roughly one vsync ahead of
+    // its deadline. Round the readout interval to whole vsyncs so that the
+    // presentation cadence follows the sensor, e.g. 30fps on a 120Hz panel presents
+    // every 4th vsync. Without a previous target, use the earliest timeline.
+    int64_t numVsyncs = std::max<int64_t>(1, (readoutInterval + frameInterval / 2) /
+            frameInterval);
+    nsecs_t idealPresentT = mLastTargetPresentTime + numVsyncs * frameInterval;
+    nsecs_t minPresentT = mLastTargetPresentTime + frameInterval / 2;
+    bool hasLastTarget = (mLastTargetPresentTime != 0);
+
+    nsecs_t minDiff = INT64_MAX;
+    bool found = false;
+    int maxTimelines = std::min(kMaxTimelines, (int)vsyncEventData.frameTimelinesLength);
+    for (int i = 0; i < maxTimelines; i++) {
+        const auto& timeline = vsyncEventData.frameTimelines[i];
+        nsecs_t latchTime = timeline.deadlineTimestamp - frameInterval - kFrameAdjustThreshold;
+        if (latchTime < currentTime ||
+                (hasLastTarget && timeline.expectedPresentationTime <= minPresentT)) {
+            continue;
+        }
+        nsecs_t diff = hasLastTarget ?
+                std::abs(timeline.expectedPresentationTime - idealPresentT) : i;
+        if (diff < minDiff) {
+            minDiff = diff;
+            *queueTime = latchTime;
+            mTargetPresentTime = timeline.expectedPresentationTime;
+            found = true;
+        }
+    }
+    ALOGV("%s: readoutInterval %" PRId64 ", frameInterval %" PRId64 ", target present time %"
+            PRId64 " (%s)", __FUNCTION__, readoutInterval, frameInterval, mTargetPresentTime,
+            found ? "found" : "not found");
+    return found;
+}
+
 void PreviewFrameSpacer::queueBufferToClientLocked(
         const BufferHolder& bufferHolder, nsecs_t currentTime) {
     sp<Camera3OutputStream> parent = mParent.promote();
@@ -127,6 +193,7 @@ void PreviewFrameSpacer::queueBufferToClientLocked(
     parent->onCachedBufferQueued();
     mLastCameraPresentTime = currentTime;
     mLastCameraReadoutTime = bufferHolder.readoutTimestamp;
+    mLastTargetPresentTime = mTargetPresentTime;
 }
 
 }; // namespace camera3
@@ -17,8 +17,10 @@
 #ifndef ANDROID_SERVERS_CAMERA_CAMERA3_PREVIEWFRAMESPACER_H
 #define ANDROID_SERVERS_CAMERA_CAMERA3_PREVIEWFRAMESPACER_H
 
+#include <atomic>
 #include <queue>
 
+#include <gui/DisplayEventReceiver.h>
 #include <gui/Surface.h>
 #include <utils/Condition.h>
 #include <utils/Mutex.h>
@@ -46,6 +48,12 @@ class Camera3OutputStream;
  * - Queue frame buffers in the same cadence as the camera readout time.
  * - Maintain at most 1 queue-able buffer. If the 2nd preview buffer becomes
  *   available, queue the oldest cached buffer to the buffer queue.
+ *
+ * For fixed frame rate streams, the spacer additionally paces predictively:
+ * the readout interval is rounded to a whole number of display vsyncs, and
+ * the buffer is queued just before the consumer latches for the frame
+ * timeline closest to that target, so that frames land on evenly spaced
+ * vsyncs on 60/90/120Hz and variable refresh rate panels.
  */
 class PreviewFrameSpacer : public Thread {
   public:
@@ -59,6 +67,9 @@ class PreviewFrameSpacer : public Thread {
     bool threadLoop() override;
     void requestExit() override;
 
+    // Enable vsync based predictive pacing for fixed frame rate streams.
+    void setFixedFps(bool fixedFps);
+
   private:
     // structure holding cached preview buffer info
     struct BufferHolder {
@@ -75,6 +86,12 @@ class PreviewFrameSpacer : public Thread {
 
     void queueBufferToClientLocked(const BufferHolder& bufferHolder, nsecs_t currentTime);
 
+    // Find the time to queue the next buffer so that it is latched for the display
+    // frame timeline closest to the last presentation time plus readoutInterval.
+    // Returns false if no suitable frame timeline is available.
+    bool getPredictedQueueTimeLocked(nsecs_t readoutInterval, nsecs_t currentTime,
+            nsecs_t* queueTime);
+
     wp<Camera3OutputStream> mParent;
     sp<ANativeWindow> mConsumer;
     mutable Mutex mLock;
@@ -83,10 +100,17 @@ class PreviewFrameSpacer : public Thread {
     std::queue<BufferHolder> mPendingBuffers;
     nsecs_t mLastCameraReadoutTime = 0;
     nsecs_t mLastCameraPresentTime = 0;
+
+    // Predictive pacing state
+    std::atomic<bool> mFixedFps = false;
+    DisplayEventReceiver mDisplayEventReceiver;
+    nsecs_t mTargetPresentTime = 0;
+    nsecs_t mLastTargetPresentTime = 0;
     static constexpr nsecs_t kWaitDuration = 5000000LL; // 50ms
     static constexpr nsecs_t kFrameIntervalThreshold = 80000000LL; // 80ms
     static constexpr nsecs_t kMaxFrameWaitTime = 10000000LL; // 10ms
     static constexpr nsecs_t kFrameAdjustThreshold = 2000000LL; // 2ms
+    static constexpr int kMaxTimelines = 3;
 };
 
 }; //namespace camera3
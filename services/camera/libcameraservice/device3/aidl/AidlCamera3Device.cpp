@@ -375,8 +375,9 @@ status_t AidlCamera3Device::initialize(sp<CameraProviderManager> manager,
         mNextReprocessShutterFrameNumber, mNextZslStillShutterFrameNumber,
         mNextResultFrameNumber,
         mNextReprocessResultFrameNumber, mNextZslStillResultFrameNumber,
+        mPendingResults, mResultProcessingLock,
         mUseHalBufManager, mUsePartialResult, mNeedFixupMonochromeTags,
-        mNumPartialResults, mVendorTagId, mDeviceInfo, mPhysicalDeviceInfoMap,
+        mNumPartialResults, mVendorTagId, mDeviceInfo, mPhysicalDeviceInfoMap, mPhysicalResultKeys,
         mDistortionMappers, mZoomRatioMappers, mRotateAndCropMappers,
         mTagMonitor, mInputStream, mOutputStreams, mSessionStatsBuilder, listener, *this,
         *this, *(mInterface), mLegacyClient, mMinExpectedDuration, mIsFixedFps,
@@ -417,8 +418,9 @@ status_t AidlCamera3Device::initialize(sp<CameraProviderManager> manager,
         mNextReprocessShutterFrameNumber, mNextZslStillShutterFrameNumber,
         mNextResultFrameNumber,
         mNextReprocessResultFrameNumber, mNextZslStillResultFrameNumber,
+        mPendingResults, mResultProcessingLock,
         mUseHalBufManager, mUsePartialResult, mNeedFixupMonochromeTags,
-        mNumPartialResults, mVendorTagId, mDeviceInfo, mPhysicalDeviceInfoMap,
+        mNumPartialResults, mVendorTagId, mDeviceInfo, mPhysicalDeviceInfoMap, mPhysicalResultKeys,
         mDistortionMappers, mZoomRatioMappers, mRotateAndCropMappers,
         mTagMonitor, mInputStream, mOutputStreams, mSessionStatsBuilder, listener, *this,
         *this, *(mInterface), mLegacyClient, mMinExpectedDuration, mIsFixedFps,
@@ -497,7 +499,7 @@ status_t AidlCamera3Device::switchToOffline(
     // Verify offlineSessionInfo
     std::vector<int32_t> offlineStreamIds;
     offlineStreamIds.reserve(offlineSessionInfo.offlineStreams.size());
-    for (auto offlineStream : offlineSessionInfo.offlineStreams) {
+    for (const auto& offlineStream : offlineSessionInfo.offlineStreams) {
         // verify stream IDs
         int32_t id = offlineStream.id;
         if (std::find(streamIds.begin(), streamIds.end(), id) == streamIds.end()) {
@@ -548,10 +550,13 @@ status_t AidlCamera3Device::switchToOffline(
     }
 
     InFlightRequestMap offlineReqs;
-    // Verify inflight requests and their pending buffers
+    // Verify inflight requests and their pending buffers, then move them over to the
+    // offline session so that this device is idle again once its own requests finish.
     {
         std::lock_guard<std::mutex> l(mInFlightLock);
-        for (auto offlineReq : offlineSessionInfo.offlineRequests) {
+        std::vector<uint32_t> offlineFrameNumbers;
+        offlineFrameNumbers.reserve(offlineSessionInfo.offlineRequests.size());
+        for (const auto& offlineReq : offlineSessionInfo.offlineRequests) {
             int idx = mInFlightMap.indexOfKey(offlineReq.frameNumber);
             if (idx == NAME_NOT_FOUND) {
                 SET_ERR("Offline request frame number %d not found!", offlineReq.frameNumber);
@@ -566,15 +571,16 @@ status_t AidlCamera3Device::switchToOffline(
                         inflightReq.numBuffersLeft, offlineReq.pendingStreams.size());
                 return UNKNOWN_ERROR;
             }
-            offlineReqs.add(offlineReq.frameNumber, inflightReq);
+            offlineFrameNumbers.push_back(offlineReq.frameNumber);
         }
+        moveInFlightRequestsLocked(offlineFrameNumbers, &offlineReqs);
     }
 
     // Create Camera3OfflineSession and transfer object ownership
     //   (streams, inflight requests, buffer caches)
     camera3::StreamSet offlineStreamSet;
     sp<camera3::Camera3Stream> inputStream;
-    for (auto offlineStream : offlineSessionInfo.offlineStreams) {
+    for (const auto& offlineStream : offlineSessionInfo.offlineStreams) {
         int32_t id = offlineStream.id;
         if (mInputStream != nullptr && id == mInputStream->getId()) {
             inputStream = mInputStream;
@@ -592,15 +598,15 @@ status_t AidlCamera3Device::switchToOffline(
             mNextResultFrameNumber, mNextReprocessResultFrameNumber,
             mNextZslStillResultFrameNumber, mNextShutterFrameNumber,
             mNextReprocessShutterFrameNumber, mNextZslStillShutterFrameNumber,
-            mDeviceInfo, mPhysicalDeviceInfoMap, mDistortionMappers,
+            mDeviceInfo, mPhysicalDeviceInfoMap, mPhysicalResultKeys, mDistortionMappers,
             mZoomRatioMappers, mRotateAndCropMappers);
 
     *session = new AidlCamera3OfflineSession(mId, inputStream, offlineStreamSet,
-            std::move(bufferRecords), offlineReqs, offlineStates, offlineSession);
+            std::move(bufferRecords), std::move(offlineReqs), offlineStates, offlineSession);
 
     // Delete all streams that has been transferred to offline session
     Mutex::Autolock l(mLock);
-    for (auto offlineStream : offlineSessionInfo.offlineStreams) {
+    for (const auto& offlineStream : offlineSessionInfo.offlineStreams) {
         int32_t id = offlineStream.id;
         if (mInputStream != nullptr && id == mInputStream->getId()) {
             mInputStream.clear();
@@ -110,12 +110,12 @@ class AidlCamera3OfflineSession :
             const sp<camera3::Camera3Stream>& inputStream,
             const camera3::StreamSet& offlineStreamSet,
             camera3::BufferRecords&& bufferRecords,
-            const camera3::InFlightRequestMap& offlineReqs,
+            camera3::InFlightRequestMap&& offlineReqs,
             const Camera3OfflineStates& offlineStates,
             std::shared_ptr<aidl::android::hardware::camera::device::ICameraOfflineSession>
                     offlineSession) :
       Camera3OfflineSession(id, inputStream, offlineStreamSet, std::move(bufferRecords),
-              offlineReqs, offlineStates),
+              std::move(offlineReqs), offlineStates),
       mSession(offlineSession) {
         mCallbacks = ndk::SharedRefBase::make<AidlCameraDeviceCallbacks>(this);
       };
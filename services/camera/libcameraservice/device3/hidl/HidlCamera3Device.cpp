@@ -361,8 +361,9 @@ hardware::Return<void> HidlCamera3Device::processCaptureResult_3_4(
         mNextReprocessShutterFrameNumber, mNextZslStillShutterFrameNumber,
         mNextResultFrameNumber,
         mNextReprocessResultFrameNumber, mNextZslStillResultFrameNumber,
+        mPendingResults, mResultProcessingLock,
         mUseHalBufManager, mUsePartialResult, mNeedFixupMonochromeTags,
-        mNumPartialResults, mVendorTagId, mDeviceInfo, mPhysicalDeviceInfoMap,
+        mNumPartialResults, mVendorTagId, mDeviceInfo, mPhysicalDeviceInfoMap, mPhysicalResultKeys,
         mDistortionMappers, mZoomRatioMappers, mRotateAndCropMappers,
         mTagMonitor, mInputStream, mOutputStreams, mSessionStatsBuilder, listener, *this, *this,
         *mInterface, mLegacyClient, mMinExpectedDuration, mIsFixedFps, mOverrideToPortrait,
@@ -424,8 +425,9 @@ hardware::Return<void> HidlCamera3Device::processCaptureResult(
         mNextReprocessShutterFrameNumber, mNextZslStillShutterFrameNumber,
         mNextResultFrameNumber,
         mNextReprocessResultFrameNumber, mNextZslStillResultFrameNumber,
+        mPendingResults, mResultProcessingLock,
         mUseHalBufManager, mUsePartialResult, mNeedFixupMonochromeTags,
-        mNumPartialResults, mVendorTagId, mDeviceInfo, mPhysicalDeviceInfoMap,
+        mNumPartialResults, mVendorTagId, mDeviceInfo, mPhysicalDeviceInfoMap, mPhysicalResultKeys,
         mDistortionMappers, mZoomRatioMappers, mRotateAndCropMappers,
         mTagMonitor, mInputStream, mOutputStreams, mSessionStatsBuilder, listener, *this, *this,
         *mInterface, mLegacyClient, mMinExpectedDuration, mIsFixedFps, mOverrideToPortrait,
@@ -472,8 +474,9 @@ hardware::Return<void> HidlCamera3Device::notifyHelper(
         mNextReprocessShutterFrameNumber, mNextZslStillShutterFrameNumber,
         mNextResultFrameNumber,
         mNextReprocessResultFrameNumber, mNextZslStillResultFrameNumber,
+        mPendingResults, mResultProcessingLock,
         mUseHalBufManager, mUsePartialResult, mNeedFixupMonochromeTags,
-        mNumPartialResults, mVendorTagId, mDeviceInfo, mPhysicalDeviceInfoMap,
+        mNumPartialResults, mVendorTagId, mDeviceInfo, mPhysicalDeviceInfoMap, mPhysicalResultKeys,
         mDistortionMappers, mZoomRatioMappers, mRotateAndCropMappers,
         mTagMonitor, mInputStream, mOutputStreams, mSessionStatsBuilder, listener, *this, *this,
         *mInterface, mLegacyClient, mMinExpectedDuration, mIsFixedFps, mOverrideToPortrait,
@@ -551,7 +554,7 @@ status_t HidlCamera3Device::switchToOffline(
     // Verify offlineSessionInfo
     std::vector<int32_t> offlineStreamIds;
     offlineStreamIds.reserve(offlineSessionInfo.offlineStreams.size());
-    for (auto offlineStream : offlineSessionInfo.offlineStreams) {
+    for (const auto& offlineStream : offlineSessionInfo.offlineStreams) {
         // verify stream IDs
         int32_t id = offlineStream.id;
         if (std::find(streamIds.begin(), streamIds.end(), id) == streamIds.end()) {
@@ -602,10 +605,13 @@ status_t HidlCamera3Device::switchToOffline(
     }
 
     InFlightRequestMap offlineReqs;
-    // Verify inflight requests and their pending buffers
+    // Verify inflight requests and their pending buffers, then move them over to the
+    // offline session so that this device is idle again once its own requests finish.
     {
         std::lock_guard<std::mutex> l(mInFlightLock);
-        for (auto offlineReq : offlineSessionInfo.offlineRequests) {
+        std::vector<uint32_t> offlineFrameNumbers;
+        offlineFrameNumbers.reserve(offlineSessionInfo.offlineRequests.size());
+        for (const auto& offlineReq : offlineSessionInfo.offlineRequests) {
             int idx = mInFlightMap.indexOfKey(offlineReq.frameNumber);
             if (idx == NAME_NOT_FOUND) {
                 SET_ERR("Offline request frame number %d not found!", offlineReq.frameNumber);
@@ -620,15 +626,16 @@ status_t HidlCamera3Device::switchToOffline(
                         inflightReq.numBuffersLeft, offlineReq.pendingStreams.size());
                 return UNKNOWN_ERROR;
             }
-            offlineReqs.add(offlineReq.frameNumber, inflightReq);
+            offlineFrameNumbers.push_back(offlineReq.frameNumber);
         }
+        moveInFlightRequestsLocked(offlineFrameNumbers, &offlineReqs);
     }
 
     // Create Camera3OfflineSession and transfer object ownership
     //   (streams, inflight requests, buffer caches)
     camera3::StreamSet offlineStreamSet;
     sp<camera3::Camera3Stream> inputStream;
-    for (auto offlineStream : offlineSessionInfo.offlineStreams) {
+    for (const auto& offlineStream : offlineSessionInfo.offlineStreams) {
         int32_t id = offlineStream.id;
         if (mInputStream != nullptr && id == mInputStream->getId()) {
             inputStream = mInputStream;
@@ -646,15 +653,15 @@ status_t HidlCamera3Device::switchToOffline(
             mNextResultFrameNumber, mNextReprocessResultFrameNumber,
             mNextZslStillResultFrameNumber, mNextShutterFrameNumber,
             mNextReprocessShutterFrameNumber, mNextZslStillShutterFrameNumber,
-            mDeviceInfo, mPhysicalDeviceInfoMap, mDistortionMappers,
+            mDeviceInfo, mPhysicalDeviceInfoMap, mPhysicalResultKeys, mDistortionMappers,
             mZoomRatioMappers, mRotateAndCropMappers);
 
     *session = new HidlCamera3OfflineSession(mId, inputStream, offlineStreamSet,
-            std::move(bufferRecords), offlineReqs, offlineStates, offlineSession);
+            std::move(bufferRecords), std::move(offlineReqs), offlineStates, offlineSession);
 
     // Delete all streams that has been transferred to offline session
     Mutex::Autolock l(mLock);
-    for (auto offlineStream : offlineSessionInfo.offlineStreams) {
+    for (const auto& offlineStream : offlineSessionInfo.offlineStreams) {
         int32_t id = offlineStream.id;
         if (mInputStream != nullptr && id == mInputStream->getId()) {
             mInputStream.clear();
@@ -57,11 +57,11 @@ class HidlCamera3OfflineSession :
             const sp<camera3::Camera3Stream>& inputStream,
             const camera3::StreamSet& offlineStreamSet,
             camera3::BufferRecords&& bufferRecords,
-            const camera3::InFlightRequestMap& offlineReqs,
+            camera3::InFlightRequestMap&& offlineReqs,
             const Camera3OfflineStates& offlineStates,
             sp<hardware::camera::device::V3_6::ICameraOfflineSession> offlineSession) :
       Camera3OfflineSession(id, inputStream, offlineStreamSet, std::move(bufferRecords),
-              offlineReqs, offlineStates),
+              std::move(offlineReqs), offlineStates),
       mSession(offlineSession) {};
 
     virtual ~HidlCamera3OfflineSession();
@@ -0,0 +1,88 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <array>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <android-base/file.h>
+#include <benchmark/benchmark.h>
+
+#include "common/DepthPhotoProcessor.h"
+
+using namespace android;
+using namespace android::camera3;
+
+static const size_t kTestBufferWidth = 640;
+static const size_t kTestBufferHeight = 480;
+static const size_t kTestBufferDepthSize (kTestBufferWidth * kTestBufferHeight);
+static const size_t kSeed = 1234;
+static const char kMainJpegFile[] = "corpus/Canon_MakerNote_variant_type_1.jpg";
+
+// Runs the full depth photo composition (depth unpacking, rotation,
+// quantization, depth/confidence compression and container serialization)
+// for a single 640x480 depth map in the orientation given by the argument.
+static void BM_ProcessDepthPhotoFrame(benchmark::State& state) {
+    std::string mainJpeg;
+    if (!base::ReadFileToString(base::GetExecutableDirectory() + "/" + kMainJpegFile,
+            &mainJpeg)) {
+        state.SkipWithError("Unable to read the main JPEG image");
+        return;
+    }
+
+    std::vector<uint16_t> depth16Buffer(kTestBufferDepthSize);
+    std::default_random_engine gen(kSeed);
+    std::uniform_int_distribution<int> uniDist(0, UINT16_MAX - 1);
+    for (auto& sample : depth16Buffer) {
+        sample = uniDist(gen);
+    }
+
+    DepthPhotoInputFrame inputFrame;
+    inputFrame.mMainJpegBuffer = mainJpeg.data();
+    inputFrame.mMainJpegSize = mainJpeg.size();
+    inputFrame.mMainJpegWidth = kTestBufferWidth;
+    inputFrame.mMainJpegHeight = kTestBufferHeight;
+    inputFrame.mDepthMapBuffer = depth16Buffer.data();
+    inputFrame.mDepthMapStride = kTestBufferWidth;
+    inputFrame.mDepthMapWidth = kTestBufferWidth;
+    inputFrame.mDepthMapHeight = kTestBufferHeight;
+    inputFrame.mJpegQuality = 95;
+    inputFrame.mOrientation = static_cast<DepthPhotoOrientation>(state.range(0));
+    // Worst case both depth and confidence maps have the same size as the depth map
+    // in addition to the main color image.
+    inputFrame.mMaxJpegSize = inputFrame.mMainJpegSize + kTestBufferDepthSize * 2;
+
+    std::vector<uint8_t> depthPhotoBuffer(inputFrame.mMaxJpegSize);
+    for (auto _ : state) {
+        size_t actualDepthPhotoSize = 0;
+        if (processDepthPhotoFrame(inputFrame, depthPhotoBuffer.size(), depthPhotoBuffer.data(),
+                &actualDepthPhotoSize) != 0) {
+            state.SkipWithError("Depth photo processing failed");
+            break;
+        }
+        benchmark::DoNotOptimize(actualDepthPhotoSize);
+    }
+    state.SetItemsProcessed(state.iterations() * kTestBufferDepthSize);
+}
+
+BENCHMARK(BM_ProcessDepthPhotoFrame)
+        ->Arg(DepthPhotoOrientation::DEPTH_ORIENTATION_0_DEGREES)
+        ->Arg(DepthPhotoOrientation::DEPTH_ORIENTATION_90_DEGREES)
+        ->Arg(DepthPhotoOrientation::DEPTH_ORIENTATION_180_DEGREES)
+        ->Arg(DepthPhotoOrientation::DEPTH_ORIENTATION_270_DEGREES);
+
+BENCHMARK_MAIN();
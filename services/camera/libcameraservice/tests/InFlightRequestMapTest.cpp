@@ -0,0 +1,84 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_NDEBUG 0
+#define LOG_TAG "InFlightRequestMapTest"
+
+#include <gtest/gtest.h>
+
+#include "../device3/InFlightRequest.h"
+
+using namespace android;
+using namespace android::camera3;
+
+static InFlightRequest makeRequest(int numBuffers) {
+    return InFlightRequest(numBuffers, CaptureResultExtras(), /*hasInput*/false,
+            /*hasAppCallback*/true, /*minDuration*/0, /*maxDuration*/0, /*fixedFps*/false,
+            /*physicalCameraIdSet*/{}, /*isStillCapture*/false, /*isZslCapture*/false,
+            /*rotateAndCropAuto*/false, /*autoframingAuto*/false, /*idsWithZoom*/{},
+            /*requestNs*/0);
+}
+
+TEST(InFlightRequestMapTest, OrderedByFrameNumber) {
+    InFlightRequestMap map;
+    ASSERT_TRUE(map.isEmpty());
+
+    EXPECT_EQ(0, map.add(10, makeRequest(1)));
+    EXPECT_EQ(1, map.add(12, makeRequest(2)));
+    // Out-of-order insertion lands between its neighbours.
+    EXPECT_EQ(1, map.add(11, makeRequest(3)));
+    ASSERT_EQ(3u, map.size());
+
+    for (size_t i = 0; i < map.size(); i++) {
+        EXPECT_EQ(10u + i, map.keyAt(i));
+    }
+    EXPECT_EQ(3, map.valueAt(1).numBuffersLeft);
+    EXPECT_EQ(2, map.valueFor(12).numBuffersLeft);
+
+    // Adding an existing frame number replaces its request.
+    EXPECT_EQ(2, map.add(12, makeRequest(4)));
+    EXPECT_EQ(3u, map.size());
+    EXPECT_EQ(4, map.valueFor(12).numBuffersLeft);
+}
+
+TEST(InFlightRequestMapTest, LookupAndRemove) {
+    InFlightRequestMap map;
+    for (uint32_t frame = 100; frame < 110; frame++) {
+        map.add(frame, makeRequest(frame));
+    }
+
+    EXPECT_EQ(NAME_NOT_FOUND, map.indexOfKey(99));
+    EXPECT_EQ(NAME_NOT_FOUND, map.indexOfKey(110));
+    EXPECT_EQ(5, map.indexOfKey(105));
+
+    // Leave a gap so lookups can no longer resolve by offset.
+    map.removeItemsAt(map.indexOfKey(103));
+    map.removeItemsAt(0);
+    EXPECT_EQ(NAME_NOT_FOUND, map.indexOfKey(100));
+    EXPECT_EQ(NAME_NOT_FOUND, map.indexOfKey(103));
+    EXPECT_EQ(2, map.indexOfKey(104));
+    EXPECT_EQ(7, map.indexOfKey(109));
+
+    map.editValueAt(map.indexOfKey(104)).numBuffersLeft = 0;
+    EXPECT_EQ(0, map.valueFor(104).numBuffersLeft);
+
+    InFlightRequestMap copy(map);
+    map.clear();
+    EXPECT_TRUE(map.isEmpty());
+    ASSERT_EQ(8u, copy.size());
+    EXPECT_EQ(0, copy.valueFor(104).numBuffersLeft);
+    EXPECT_EQ(BAD_VALUE, copy.removeItemsAt(7, 2));
+}
@@ -21,7 +21,9 @@
 #include <numeric>
 
 #include <inttypes.h>
+#include <unistd.h>
 #include <utils/Log.h>
+#include <utils/String8.h>
 
 #include "SessionStatsBuilder.h"
 
@@ -33,6 +35,12 @@ namespace android {
 const std::array<int32_t, StreamStats::LATENCY_BIN_COUNT-1> StreamStats::mCaptureLatencyBins {
         { 100, 200, 300, 400, 500, 700, 900, 1300, 2100 } };
 
+// Bins for capture stage latency: [0, 5], [5, 10], [10, 20], ... [200, 500], [500, inf].
+// Stage latency is in the unit of millisecond.
+const std::array<int32_t, StreamStats::LATENCY_BIN_COUNT-1>
+        SessionStatsBuilder::mStageLatencyBins {
+        { 5, 10, 20, 33, 50, 66, 100, 200, 500 } };
+
 status_t SessionStatsBuilder::addStream(int id) {
     std::lock_guard<std::mutex> l(mLock);
     StreamStats stats;
@@ -71,6 +79,10 @@ void SessionStatsBuilder::buildAndReset(int64_t* requestCount,
         std::fill(streamStat.mCaptureLatencyHistogram.begin(),
                 streamStat.mCaptureLatencyHistogram.end(), 0);
     }
+    mLastStageLatency = mStageLatency;
+    for (auto& histogram : mStageLatency) {
+        histogram.fill(0);
+    }
 }
 
 void SessionStatsBuilder::startCounter(int id) {
@@ -125,17 +137,75 @@ void SessionStatsBuilder::onDeviceError() {
     mDeviceError = true;
 }
 
+void SessionStatsBuilder::incStageLatency(CaptureStage stage, int32_t latencyMs) {
+    std::lock_guard<std::mutex> l(mLock);
+    if (mCounterStopped || stage >= STAGE_COUNT) return;
+
+    StreamStats::addToHistogram(mStageLatencyBins, mStageLatency[stage], latencyMs);
+}
+
+void SessionStatsBuilder::dump(int fd) {
+    std::lock_guard<std::mutex> l(mLock);
+    dumpStageLatency(fd, "Current session", mStageLatency);
+    dumpStageLatency(fd, "Last session", mLastStageLatency);
+}
+
+const char* SessionStatsBuilder::getStageName(CaptureStage stage) {
+    switch (stage) {
+        case STAGE_REQUEST_QUEUE:
+            return "Request queue";
+        case STAGE_SHUTTER:
+            return "Shutter";
+        case STAGE_FIRST_PARTIAL:
+            return "First partial result";
+        case STAGE_FINAL_RESULT:
+            return "Final result";
+        default:
+            return "Unknown";
+    }
+}
+
+void SessionStatsBuilder::dumpStageLatency(int fd, const char* title,
+        const std::array<StageLatencyHistogram, STAGE_COUNT>& stageLatency) {
+    String8 lines;
+    for (int stage = 0; stage < STAGE_COUNT; stage++) {
+        const StageLatencyHistogram& histogram = stageLatency[stage];
+        int64_t total = std::accumulate(histogram.begin(), histogram.end(), 0LL);
+        if (total == 0) continue;
+
+        lines.appendFormat("      %s (%" PRId64 " samples):\n        ",
+                getStageName(static_cast<CaptureStage>(stage)), total);
+        for (size_t i = 0; i < mStageLatencyBins.size(); i++) {
+            lines.appendFormat("%7d", mStageLatencyBins[i]);
+        }
+        lines.append("    inf (max ms)\n        ");
+        for (size_t i = 0; i < histogram.size(); i++) {
+            lines.appendFormat("   %02.2f", 100.0 * histogram[i] / total);
+        }
+        lines.append(" (%)\n");
+    }
+    if (lines.isEmpty()) return;
+
+    dprintf(fd, "    %s capture stage latency:\n", title);
+    write(fd, lines.string(), lines.size());
+}
+
 void StreamStats::updateLatencyHistogram(int32_t latencyMs) {
+    addToHistogram(mCaptureLatencyBins, mCaptureLatencyHistogram, latencyMs);
+}
+
+void StreamStats::addToHistogram(const std::array<int32_t, LATENCY_BIN_COUNT-1>& bins,
+        std::array<int64_t, LATENCY_BIN_COUNT>& counts, int32_t latencyMs) {
     size_t i;
-    for (i = 0; i < mCaptureLatencyBins.size(); i++) {
-        if (latencyMs < mCaptureLatencyBins[i]) {
-            mCaptureLatencyHistogram[i] ++;
+    for (i = 0; i < bins.size(); i++) {
+        if (latencyMs < bins[i]) {
+            counts[i] ++;
             break;
         }
     }
 
-    if (i == mCaptureLatencyBins.size()) {
-        mCaptureLatencyHistogram[i]++;
+    if (i == bins.size()) {
+        counts[i]++;
     }
 }
 
@@ -51,11 +51,30 @@ struct StreamStats {
                   {}
 
     void updateLatencyHistogram(int32_t latencyMs);
+
+    // Increment the bin of |counts| that |latencyMs| falls into, given the boundary
+    // values |bins| separating adjacent bins.
+    static void addToHistogram(const std::array<int32_t, LATENCY_BIN_COUNT-1>& bins,
+            std::array<int64_t, LATENCY_BIN_COUNT>& counts, int32_t latencyMs);
 };
 
 // Helper class to build session stats
 class SessionStatsBuilder {
 public:
+    // Stages of the capture path tracked for the whole session, in addition to the
+    // per stream capture latency (request to buffer return).
+    enum CaptureStage {
+        STAGE_REQUEST_QUEUE = 0, // Request submitted by the client -> sent to the HAL
+        STAGE_SHUTTER,           // Sent to the HAL -> shutter notification
+        STAGE_FIRST_PARTIAL,     // Sent to the HAL -> first result metadata
+        STAGE_FINAL_RESULT,      // Sent to the HAL -> final result metadata
+        STAGE_COUNT
+    };
+    typedef std::array<int64_t, StreamStats::LATENCY_BIN_COUNT> StageLatencyHistogram;
+
+    // Boundary values separating between adjacent stage latency bins, excluding 0 and
+    // infinity.
+    const static std::array<int32_t, StreamStats::LATENCY_BIN_COUNT-1> mStageLatencyBins;
 
     status_t addStream(int streamId);
     status_t removeStream(int streamId);
@@ -76,6 +95,12 @@ public:
     void incResultCounter(bool dropped);
     void onDeviceError();
 
+    // Capture stage latency counter
+    void incStageLatency(CaptureStage stage, int32_t latencyMs);
+
+    // Dump the stage latency histograms of the current and the last completed session
+    void dump(int fd);
+
     SessionStatsBuilder() : mRequestCount(0), mErrorResultCount(0),
              mCounterStopped(false), mDeviceError(false) {}
 private:
@@ -87,6 +112,13 @@ private:
     std::string mUserTag;
     // Map from stream id to stream statistics
     std::map<int, StreamStats> mStatsMap;
+    // Stage latency histograms since the last buildAndReset, and up to it
+    std::array<StageLatencyHistogram, STAGE_COUNT> mStageLatency{};
+    std::array<StageLatencyHistogram, STAGE_COUNT> mLastStageLatency{};
+
+    static const char* getStageName(CaptureStage stage);
+    static void dumpStageLatency(int fd, const char* title,
+            const std::array<StageLatencyHistogram, STAGE_COUNT>& stageLatency);
 };
 
 }; // namespace android
@@ -20,6 +20,7 @@
 
 #include "TagMonitor.h"
 
+#include <algorithm>
 #include <inttypes.h>
 #include <utils/Log.h>
 #include <camera/VendorTagDescriptor.h>
@@ -37,11 +38,15 @@ TagMonitor::TagMonitor():
 TagMonitor::TagMonitor(const TagMonitor& other):
         mMonitoringEnabled(other.mMonitoringEnabled.load()),
         mMonitoredTagList(other.mMonitoredTagList),
+        mMonitoredSectionSlots(other.mMonitoredSectionSlots),
+        mMonitoredVendorSlots(other.mMonitoredVendorSlots),
         mLastMonitoredRequestValues(other.mLastMonitoredRequestValues),
         mLastMonitoredResultValues(other.mLastMonitoredResultValues),
         mLastMonitoredPhysicalRequestKeys(other.mLastMonitoredPhysicalRequestKeys),
         mLastMonitoredPhysicalResultKeys(other.mLastMonitoredPhysicalResultKeys),
         mMonitoringEvents(other.mMonitoringEvents),
+        mMonitoringEventHead(other.mMonitoringEventHead),
+        mMonitoringEventCount(other.mMonitoringEventCount),
         mVendorTagId(other.mVendorTagId) {}
 
 const String16 TagMonitor::kMonitorOption = String16("-m");
@@ -94,7 +99,10 @@ void TagMonitor::parseTagsToMonitor(String8 tagNames) {
                 mMonitoredTagList.clear();
                 gotTag = true;
             }
-            mMonitoredTagList.push_back(tag);
+            if (std::find(mMonitoredTagList.begin(), mMonitoredTagList.end(), tag) ==
+                    mMonitoredTagList.end()) {
+                mMonitoredTagList.push_back(tag);
+            }
         }
         nextTagName = strtok_r(nullptr, ", ", &savePtr);
     }
@@ -102,11 +110,53 @@ void TagMonitor::parseTagsToMonitor(String8 tagNames) {
     tagNames.unlockBuffer();
 
     if (gotTag) {
-        // Got at least one new tag
+        // Got at least one new tag. Last values are stored by slot, so they
+        // need to be reset along with the tag list.
+        compileMonitoredTagsLocked();
+        mLastMonitoredRequestValues.clear();
+        mLastMonitoredResultValues.clear();
+        mLastMonitoredPhysicalRequestKeys.clear();
+        mLastMonitoredPhysicalResultKeys.clear();
         mMonitoringEnabled = true;
     }
 }
 
+void TagMonitor::compileMonitoredTagsLocked() {
+    mMonitoredSectionSlots.clear();
+    mMonitoredVendorSlots.clear();
+    for (size_t i = 0; i < mMonitoredTagList.size(); i++) {
+        uint32_t tag = mMonitoredTagList[i];
+        if (tag >= VENDOR_SECTION_START) {
+            mMonitoredVendorSlots.emplace(tag, i);
+            continue;
+        }
+        uint32_t section = tag >> 16;
+        uint32_t index = tag & 0xFFFF;
+        if (mMonitoredSectionSlots.size() <= section) {
+            mMonitoredSectionSlots.resize(section + 1);
+        }
+        auto& slots = mMonitoredSectionSlots[section];
+        if (slots.size() <= index) {
+            slots.resize(index + 1, -1);
+        }
+        slots[index] = i;
+    }
+}
+
+int32_t TagMonitor::getMonitoredSlot(uint32_t tag) const {
+    if (tag >= VENDOR_SECTION_START) {
+        auto it = mMonitoredVendorSlots.find(tag);
+        return (it != mMonitoredVendorSlots.end()) ? it->second : -1;
+    }
+    uint32_t section = tag >> 16;
+    uint32_t index = tag & 0xFFFF;
+    if (section >= mMonitoredSectionSlots.size() ||
+            index >= mMonitoredSectionSlots[section].size()) {
+        return -1;
+    }
+    return mMonitoredSectionSlots[section][index];
+}
+
 void TagMonitor::disableMonitoring() {
     mMonitoringEnabled = false;
     mLastMonitoredRequestValues.clear();
@@ -129,106 +179,141 @@ void TagMonitor::monitorMetadata(eventSource source, int64_t frameNumber, nsecs_
     if (timestamp == 0) {
         timestamp = systemTime(SYSTEM_TIME_BOOTTIME);
     }
-    std::unordered_set<int32_t> outputStreamIds;
+    mOutputStreamIds.clear();
     for (size_t i = 0; i < numOutputBuffers; i++) {
         const camera3::camera_stream_buffer_t *src = outputBuffers + i;
         int32_t streamId = camera3::Camera3Stream::cast(src->stream)->getId();
-        outputStreamIds.emplace(streamId);
+        mOutputStreamIds.push_back(streamId);
+    }
+    std::sort(mOutputStreamIds.begin(), mOutputStreamIds.end());
+    mOutputStreamIds.erase(std::unique(mOutputStreamIds.begin(), mOutputStreamIds.end()),
+            mOutputStreamIds.end());
+
+    if (mFoundEntries.size() < physicalMetadata.size() + 1) {
+        mFoundEntries.resize(physicalMetadata.size() + 1);
+    }
+    findMonitoredEntriesLocked(metadata, &mFoundEntries[0]);
+    size_t cameraIdx = 1;
+    for (auto& m : physicalMetadata) {
+        findMonitoredEntriesLocked(m.second, &mFoundEntries[cameraIdx++]);
     }
+
     std::string emptyId;
-    for (auto tag : mMonitoredTagList) {
-        monitorSingleMetadata(source, frameNumber, timestamp, emptyId, tag, metadata,
-                outputStreamIds, inputStreamId);
+    for (size_t slot = 0; slot < mMonitoredTagList.size(); slot++) {
+        monitorSingleMetadata(source, frameNumber, timestamp, emptyId, slot,
+                mFoundEntries[0][slot], inputStreamId);
 
+        cameraIdx = 1;
         for (auto& m : physicalMetadata) {
-            monitorSingleMetadata(source, frameNumber, timestamp, m.first, tag, m.second,
-                    outputStreamIds, inputStreamId);
+            monitorSingleMetadata(source, frameNumber, timestamp, m.first, slot,
+                    mFoundEntries[cameraIdx++][slot], inputStreamId);
         }
     }
 }
 
+void TagMonitor::findMonitoredEntriesLocked(const CameraMetadata& metadata,
+        std::vector<camera_metadata_ro_entry_t> *entries /*out*/) {
+    camera_metadata_ro_entry_t absent{};
+    entries->assign(mMonitoredTagList.size(), absent);
+
+    const camera_metadata_t *buffer = metadata.getAndLock();
+    size_t entryCount = (buffer != nullptr) ? get_camera_metadata_entry_count(buffer) : 0;
+    for (size_t i = 0; i < entryCount; i++) {
+        camera_metadata_ro_entry_t entry;
+        if (get_camera_metadata_ro_entry(buffer, i, &entry) != OK) {
+            continue;
+        }
+        int32_t slot = getMonitoredSlot(entry.tag);
+        if (slot >= 0) {
+            (*entries)[slot] = entry;
+        }
+    }
+    metadata.unlock(buffer);
+}
+
+TagMonitor::MonitorEvent& TagMonitor::addMonitorEventLocked(eventSource source,
+        uint32_t frameNumber, nsecs_t timestamp, const std::string& cameraId) {
+    MonitorEvent &event = mMonitoringEvents[mMonitoringEventHead];
+    mMonitoringEventHead = (mMonitoringEventHead + 1) % mMonitoringEvents.size();
+    if (mMonitoringEventCount < mMonitoringEvents.size()) {
+        mMonitoringEventCount++;
+    }
+
+    event.source = source;
+    event.frameNumber = frameNumber;
+    event.timestamp = timestamp;
+    event.cameraId.assign(cameraId);
+    event.tag = 0;
+    event.type = 0;
+    event.newData.clear();
+    event.outputStreamIds.clear();
+    event.inputStreamId = -1;
+    return event;
+}
+
 void TagMonitor::monitorSingleMetadata(eventSource source, int64_t frameNumber, nsecs_t timestamp,
-        const std::string& cameraId, uint32_t tag, const CameraMetadata& metadata,
-        const std::unordered_set<int32_t> &outputStreamIds, int32_t inputStreamId) {
+        const std::string& cameraId, size_t slot, const camera_metadata_ro_entry_t& entry,
+        int32_t inputStreamId) {
 
-    CameraMetadata &lastValues = (source == REQUEST) ?
+    MonitoredValues &lastValues = (source == REQUEST) ?
             (cameraId.empty() ? mLastMonitoredRequestValues :
                     mLastMonitoredPhysicalRequestKeys[cameraId]) :
             (cameraId.empty() ? mLastMonitoredResultValues :
                     mLastMonitoredPhysicalResultKeys[cameraId]);
-
-    camera_metadata_ro_entry entry = metadata.find(tag);
-    if (lastValues.isEmpty()) {
-        lastValues = CameraMetadata(mMonitoredTagList.size());
-        const camera_metadata_t *metaBuffer =
-                lastValues.getAndLock();
-        set_camera_metadata_vendor_id(
-                const_cast<camera_metadata_t *> (metaBuffer), mVendorTagId);
-        lastValues.unlock(metaBuffer);
+    if (lastValues.size() != mMonitoredTagList.size()) {
+        lastValues.resize(mMonitoredTagList.size());
     }
-
-    camera_metadata_entry lastEntry = lastValues.find(tag);
+    MonitoredValue &lastValue = lastValues[slot];
+    uint32_t tag = mMonitoredTagList[slot];
 
     // Monitor when the stream ids change, this helps visually see what
     // monitored metadata values are for capture requests with different
     // stream ids.
     if (source == REQUEST) {
         if (inputStreamId != mLastInputStreamId) {
-            mMonitoringEvents.emplace(source, frameNumber, timestamp, camera_metadata_ro_entry_t{},
-                                      cameraId, std::unordered_set<int>(), inputStreamId);
+            addMonitorEventLocked(source, frameNumber, timestamp, cameraId).inputStreamId =
+                    inputStreamId;
             mLastInputStreamId = inputStreamId;
         }
 
-        if (outputStreamIds != mLastStreamIds) {
-            mMonitoringEvents.emplace(source, frameNumber, timestamp, camera_metadata_ro_entry_t{},
-                                      cameraId, outputStreamIds, -1);
-            mLastStreamIds = outputStreamIds;
+        if (mOutputStreamIds != mLastStreamIds) {
+            addMonitorEventLocked(source, frameNumber, timestamp, cameraId).outputStreamIds =
+                    mOutputStreamIds;
+            mLastStreamIds = mOutputStreamIds;
         }
     }
     if (entry.count > 0) {
-        bool isDifferent = false;
-        if (lastEntry.count > 0) {
-            // Have a last value, compare to see if changed
-            if (lastEntry.type == entry.type &&
-                    lastEntry.count == entry.count) {
-                // Same type and count, compare values
-                size_t bytesPerValue = camera_metadata_type_size[lastEntry.type];
-                size_t entryBytes = bytesPerValue * lastEntry.count;
-                int cmp = memcmp(entry.data.u8, lastEntry.data.u8, entryBytes);
-                if (cmp != 0) {
-                    isDifferent = true;
-                }
-            } else {
-                // Count or type has changed
-                isDifferent = true;
-            }
-        } else {
-            // No last entry, so always consider to be different
-            isDifferent = true;
-        }
+        size_t entryBytes = camera_metadata_type_size[entry.type] * entry.count;
+        // No last value, or count or type has changed, or same type and
+        // count but different values
+        bool isDifferent = !lastValue.present || lastValue.type != entry.type ||
+                lastValue.data.size() != entryBytes ||
+                memcmp(entry.data.u8, lastValue.data.data(), entryBytes) != 0;
 
         if (isDifferent) {
             ALOGV("%s: Tag %s changed", __FUNCTION__,
                   get_local_camera_metadata_tag_name_vendor_id(
                           tag, mVendorTagId));
-            lastValues.update(entry);
-            mMonitoringEvents.emplace(source, frameNumber, timestamp, entry, cameraId,
-                                      std::unordered_set<int>(), -1);
+            lastValue.present = true;
+            lastValue.type = entry.type;
+            lastValue.data.assign(entry.data.u8, entry.data.u8 + entryBytes);
+            MonitorEvent &event = addMonitorEventLocked(source, frameNumber, timestamp,
+                    cameraId);
+            event.tag = tag;
+            event.type = entry.type;
+            event.newData.assign(entry.data.u8, entry.data.u8 + entryBytes);
         }
-    } else if (lastEntry.count > 0) {
+    } else if (lastValue.present) {
         // Value has been removed
         ALOGV("%s: Tag %s removed", __FUNCTION__,
               get_local_camera_metadata_tag_name_vendor_id(
                       tag, mVendorTagId));
-        lastValues.erase(tag);
-        entry.tag = tag;
-        entry.type = get_local_camera_metadata_tag_type_vendor_id(tag,
-                mVendorTagId);
-        entry.count = 0;
+        lastValue.present = false;
         mLastInputStreamId = inputStreamId;
-        mLastStreamIds = outputStreamIds;
-        mMonitoringEvents.emplace(source, frameNumber, timestamp, entry, cameraId,
-                                  std::unordered_set<int>(), -1);
+        mLastStreamIds = mOutputStreamIds;
+        MonitorEvent &event = addMonitorEventLocked(source, frameNumber, timestamp, cameraId);
+        event.tag = tag;
+        event.type = get_local_camera_metadata_tag_type_vendor_id(tag, mVendorTagId);
     }
 }
 
@@ -248,7 +333,7 @@ void TagMonitor::dumpMonitoredMetadata(int fd) {
         dprintf(fd, "     Tag monitoring disabled (enable with -m <name1,..,nameN>)\n");
     }
 
-    if (mMonitoringEvents.size() == 0) { return; }
+    if (mMonitoringEventCount == 0) { return; }
 
     dprintf(fd, "     Monitored tag event log:\n");
 
@@ -265,9 +350,11 @@ void TagMonitor::getLatestMonitoredTagEvents(std::vector<std::string> &out) {
 }
 
 void TagMonitor::dumpMonitoredTagEventsToVectorLocked(std::vector<std::string> &vec) {
-    if (mMonitoringEvents.size() == 0) { return; }
-
-    for (const auto& event : mMonitoringEvents) {
+    // Most recent event first
+    for (size_t i = 0; i < mMonitoringEventCount; i++) {
+        const MonitorEvent &event = mMonitoringEvents[
+                (mMonitoringEventHead + mMonitoringEvents.size() - 1 - i) %
+                mMonitoringEvents.size()];
         int indentation = (event.source == REQUEST) ? 15 : 30;
         String8 eventString = String8::format("f%d:%" PRId64 "ns:%*s%*s",
                 event.frameNumber, event.timestamp,
@@ -386,22 +473,4 @@ String8 TagMonitor::getEventDataString(const uint8_t* data_ptr, uint32_t tag, in
     return returnStr;
 }
 
-template<typename T>
-TagMonitor::MonitorEvent::MonitorEvent(eventSource src, uint32_t frameNumber, nsecs_t timestamp,
-        const T &value, const std::string& cameraId,
-        const std::unordered_set<int32_t> &outputStreamIds,
-        int32_t inputStreamId) :
-        source(src),
-        frameNumber(frameNumber),
-        timestamp(timestamp),
-        cameraId(cameraId),
-        tag(value.tag),
-        type(value.type),
-        newData(value.data.u8, value.data.u8 + camera_metadata_type_size[value.type] * value.count),
-        outputStreamIds(outputStreamIds),
-        inputStreamId(inputStreamId) {}
-
-TagMonitor::MonitorEvent::~MonitorEvent() {
-}
-
 } // namespace android
@@ -26,7 +26,6 @@
 #include <utils/String8.h>
 #include <utils/Timers.h>
 
-#include <media/RingBuffer.h>
 #include <system/camera_metadata.h>
 #include <system/camera_vendor_tags.h>
 #include <camera/CameraMetadata.h>
@@ -88,10 +87,20 @@ class TagMonitor {
     static String8 getEventDataString(const uint8_t* data_ptr, uint32_t tag, int type, int count,
                                       int indentation);
 
+    // Returns the index of |tag| in mMonitoredTagList, or -1 if it is not monitored.
+    int32_t getMonitoredSlot(uint32_t tag) const;
+
+    // Rebuild the tag lookup tables from mMonitoredTagList.
+    void compileMonitoredTagsLocked();
+
+    // Single pass over the raw entries of |metadata|, collecting the entries of
+    // all monitored tags. Absent tags are reported with a count of 0.
+    void findMonitoredEntriesLocked(const CameraMetadata& metadata,
+            std::vector<camera_metadata_ro_entry_t> *entries /*out*/);
+
     void monitorSingleMetadata(TagMonitor::eventSource source, int64_t frameNumber,
-            nsecs_t timestamp, const std::string& cameraId, uint32_t tag,
-            const CameraMetadata& metadata, const std::unordered_set<int32_t> &outputStreamIds,
-            int32_t inputStreamId);
+            nsecs_t timestamp, const std::string& cameraId, size_t slot,
+            const camera_metadata_ro_entry_t& entry, int32_t inputStreamId);
 
     std::atomic<bool> mMonitoringEnabled;
     std::mutex mMonitorMutex;
@@ -99,45 +108,67 @@ class TagMonitor {
     // Current tags to monitor and record changes to
     std::vector<uint32_t> mMonitoredTagList;
 
-    // Latest-seen values of tracked tags
-    CameraMetadata mLastMonitoredRequestValues;
-    CameraMetadata mLastMonitoredResultValues;
+    // Compiled lookup from tag to its slot in mMonitoredTagList. Tags in the
+    // standard sections are indexed directly by [section][index in section],
+    // vendor tags go through a hash map.
+    std::vector<std::vector<int32_t>> mMonitoredSectionSlots;
+    std::unordered_map<uint32_t, int32_t> mMonitoredVendorSlots;
+
+    // Latest-seen value of a tracked tag
+    struct MonitoredValue {
+        bool present = false;
+        uint8_t type = 0;
+        std::vector<uint8_t> data;
+    };
+    // Latest-seen values of tracked tags, indexed by slot in mMonitoredTagList
+    typedef std::vector<MonitoredValue> MonitoredValues;
+    MonitoredValues mLastMonitoredRequestValues;
+    MonitoredValues mLastMonitoredResultValues;
 
-    std::unordered_map<std::string, CameraMetadata> mLastMonitoredPhysicalRequestKeys;
-    std::unordered_map<std::string, CameraMetadata> mLastMonitoredPhysicalResultKeys;
+    std::unordered_map<std::string, MonitoredValues> mLastMonitoredPhysicalRequestKeys;
+    std::unordered_map<std::string, MonitoredValues> mLastMonitoredPhysicalResultKeys;
 
     int32_t mLastInputStreamId = -1;
-    std::unordered_set<int32_t> mLastStreamIds;
+    // Sorted
+    std::vector<int32_t> mLastStreamIds;
+
+    // Scratch storage reused across monitorMetadata calls: the monitored
+    // entries of the logical and each physical camera, and the sorted output
+    // stream ids of the current request.
+    std::vector<std::vector<camera_metadata_ro_entry_t>> mFoundEntries;
+    std::vector<int32_t> mOutputStreamIds;
 
     /**
      * A monitoring event
      * Stores a new metadata field value and the timestamp at which it changed.
-     * Copies the source metadata value array and frees it on destruct.
+     * Events live in a preallocated ring and are overwritten in place, so the
+     * value and stream id storage is reused once the ring has wrapped.
      */
     struct MonitorEvent {
-        template<typename T>
-        MonitorEvent(eventSource src, uint32_t frameNumber, nsecs_t timestamp,
-                const T &newValue, const std::string& cameraId,
-                const std::unordered_set<int32_t> &outputStreamIds, int32_t inputStreamId);
-        ~MonitorEvent();
-
-        eventSource source;
-        uint32_t frameNumber;
-        nsecs_t timestamp;
+        eventSource source = REQUEST;
+        uint32_t frameNumber = 0;
+        nsecs_t timestamp = 0;
         std::string cameraId;
-        uint32_t tag;
-        uint8_t type;
+        uint32_t tag = 0;
+        uint8_t type = 0;
         std::vector<uint8_t> newData;
         // NOTE: We want to print changes to outputStreamIds and inputStreamId in their own lines.
         // So any MonitorEvent where these fields are not the default value will have garbage
         // values for all fields other than source, frameNumber, timestamp, and cameraId.
-        std::unordered_set<int32_t> outputStreamIds;
+        std::vector<int32_t> outputStreamIds;
         int32_t inputStreamId = -1;
     };
 
+    // Claim the next slot of the event ring, evicting the oldest event when full.
+    MonitorEvent& addMonitorEventLocked(eventSource source, uint32_t frameNumber,
+            nsecs_t timestamp, const std::string& cameraId);
+
     // A ring buffer for tracking the last kMaxMonitorEvents metadata changes
     static const int kMaxMonitorEvents = 100;
-    RingBuffer<MonitorEvent> mMonitoringEvents;
+    std::vector<MonitorEvent> mMonitoringEvents;
+    // Next slot to write and number of valid events in mMonitoringEvents
+    size_t mMonitoringEventHead = 0;
+    size_t mMonitoringEventCount = 0;
 
     // 3A fields to use with the "3a" option
     static const char *k3aTags;
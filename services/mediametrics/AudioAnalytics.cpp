@@ -533,7 +533,22 @@ AudioAnalytics::AudioAnalytics(const std::shared_ptr<StatsdLog>& statsdLog)
 AudioAnalytics::~AudioAnalytics()
 {
     ALOGD("%s", __func__);
-    mTimedAction.quit(); // ensure no deferred access during destructor.
+    mActionQueue.quit(); // ensure no deferred access during destructor.
+    mTimedAction.quit();
+}
+
+// Returns the key prefix used to stripe the action queue,
+// e.g. audio.track.10 -> audio.track, matching stringutils::splitPrefixKey().
+static std::string_view getStripeKey(const std::string& key)
+{
+    const size_t split = key.rfind('.');
+    if (split == std::string::npos) return key;
+    const char* suffix = key.c_str() + split + 1;
+    if (*suffix && (!strcmp(suffix, "error") || !strcmp(suffix, "status")
+            || stringutils::isNumeric(suffix))) {
+        return std::string_view(key).substr(0, split);
+    }
+    return key;
 }
 
 status_t AudioAnalytics::submit(
@@ -542,15 +557,16 @@ status_t AudioAnalytics::submit(
     if (!startsWith(item->getKey(), AMEDIAMETRICS_KEY_PREFIX_AUDIO)) return BAD_VALUE;
     status_t status = mAnalyticsState->submit(item, isTrusted);
 
-    // Status is selectively authenticated.
-    processStatus(item);
-
-    if (status != NO_ERROR) return status;  // may not be permitted.
+    // Process status and actions off the binder thread.
+    mActionQueue.post(getStripeKey(item->getKey()), [this, item, status]() {
+        // Status is selectively authenticated.
+        processStatus(item);
 
-    // Only if the item was successfully submitted (permission)
-    // do we check triggered actions.
-    processActions(item);
-    return NO_ERROR;
+        // Only if the item was successfully submitted (permission)
+        // do we check triggered actions.
+        if (status == NO_ERROR) processActions(item);
+    });
+    return status;  // may not be permitted.
 }
 
 std::pair<std::string, int32_t> AudioAnalytics::dump(
@@ -585,13 +601,44 @@ std::pair<std::string, int32_t> AudioAnalytics::dump(
 
 void AudioAnalytics::processActions(const std::shared_ptr<const mediametrics::Item>& item)
 {
-    auto actions = mActions.getActionsForItem(item); // internally locked.
+    auto actions = mActions.getTriggeredActionsForItem(item); // internally locked.
     // Execute actions with no lock held.
-    for (const auto& action : actions) {
+    for (const auto& [trigger, action] : actions) {
+        const int64_t startNs = systemTime(SYSTEM_TIME_MONOTONIC);
         (*action)(item);
+        const int64_t durationNs = systemTime(SYSTEM_TIME_MONOTONIC) - startNs;
+
+        std::lock_guard l(mActionStatsLock);
+        ActionStats& stats = mActionStats[trigger];
+        ++stats.count;
+        stats.totalNs += durationNs;
+        stats.maxNs = std::max(stats.maxNs, durationNs);
     }
 }
 
+std::pair<std::string, int32_t> AudioAnalytics::dumpActions(int32_t lines) const
+{
+    std::stringstream ss;
+    int32_t ll = lines;
+
+    if (ll > 0) {
+        auto [s, l] = mActionQueue.dump(ll);
+        ss << s;
+        ll -= l;
+    }
+
+    std::lock_guard l(mActionStatsLock);
+    for (const auto& [trigger, stats] : mActionStats) {
+        if (ll <= 0) break;
+        ss << trigger->first << "=" << trigger->second
+                << ": count " << stats.count
+                << " avg " << (stats.totalNs / stats.count / 1000) << " us"
+                << " max " << (stats.maxNs / 1000) << " us\n";
+        --ll;
+    }
+    return { ss.str(), lines - ll };
+}
+
 void AudioAnalytics::processStatus(const std::shared_ptr<const mediametrics::Item>& item)
 {
     int32_t status;
@@ -121,6 +121,32 @@ MediaMetricsService::~MediaMetricsService()
     mItems.clear();
 }
 
+status_t MediaMetricsService::submitBuffer(const char *buffer, size_t length)
+{
+    status_t status = NO_ERROR;
+    do {
+        uint32_t size;
+        if (length < sizeof(size)) return BAD_VALUE;
+        memcpy(&size, buffer, sizeof(size));
+        if (size < sizeof(size) || size > length) {
+            ALOGW("%s: invalid item size %u of %zu bytes remaining", __func__, size, length);
+            return BAD_VALUE;
+        }
+        mediametrics::Item *item = new mediametrics::Item();
+        status_t itemStatus = item->readFromByteString(buffer, size);
+        if (itemStatus == NO_ERROR) {
+            itemStatus = submitInternal(item, true /* release */);
+        } else {
+            delete item;
+        }
+        // Report the first failure, but keep going for the remaining items.
+        if (status == NO_ERROR) status = itemStatus;
+        buffer += size;
+        length -= size;
+    } while (length > 0);
+    return status;
+}
+
 status_t MediaMetricsService::submitInternal(mediametrics::Item *item, bool release)
 {
     // calling PID is 0 for one-way calls.
@@ -347,6 +373,15 @@ status_t MediaMetricsService::dump(int fd, const Vector<String16>& args)
                 result << "-- some lines may be truncated --\n";
             }
 
+            const int32_t actionLinesToDump = all ? INT32_MAX : 40;
+            result << "\nAudio Analytics Actions:";
+            const auto [ actionDumpString, actionLines ] =
+                    mAudioAnalytics.dumpActions(actionLinesToDump);
+            result << "\n" << actionDumpString;
+            if (actionLines == actionLinesToDump) {
+                result << "-- some lines may be truncated --\n";
+            }
+
             result << "\nLogSessionId:\n"
                    << mediametrics::ValidateId::get()->dump();
 
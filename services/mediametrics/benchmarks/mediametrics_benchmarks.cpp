@@ -14,7 +14,11 @@
  * limitations under the License.
  */
 
+#include <malloc.h>
+
 #include <media/MediaMetricsItem.h>
+#include <mediametricsservice/TimeMachine.h>
+#include <mediametricsservice/TransactionLog.h>
 #include <benchmark/benchmark.h>
 
 class MyItem : public android::mediametrics::BaseItem {
@@ -44,4 +48,64 @@ static void BM_SubmitBuffer(benchmark::State& state)
 
 BENCHMARK(BM_SubmitBuffer)->Iterations(4000);   // Adjust magic number until test runs
 
+// Returns an item shaped like a typical audio track update.
+static std::shared_ptr<const android::mediametrics::Item> makeItem(int64_t i)
+{
+    auto item = std::make_shared<android::mediametrics::Item>(
+            "audio.track." + std::to_string(i % 32));
+    (*item).set("event#", "ctor")
+           .set("frameCount", (int32_t)(960 + i % 3))
+           .set("sampleRate", (int32_t)48000)
+           .set("startupGlitch", (int32_t)(i % 2))
+           .set("volume.left", 1. - (i % 10) * 0.1)
+           .set("underrun", (int64_t)i)
+           .set("latencyMs", 20. + i % 7)
+           .setTimestamp(i + 1);
+    return item;
+}
+
+// Reports the put rate and the heap bytes retained per item put. Item contents are
+// allocated up front and shared, so only the container overhead is counted.
+template <typename Container, typename Put>
+static void putItems(benchmark::State& state, Container& container, Put put)
+{
+    std::vector<std::shared_ptr<const android::mediametrics::Item>> items;
+    constexpr int64_t kItems = 2000;
+    for (int64_t i = 0; i < kItems; ++i) items.push_back(makeItem(i));
+
+    const size_t heapBefore = mallinfo().uordblks;
+    int64_t count = 0;
+    while (state.KeepRunning()) {
+        put(container, items[count++ % kItems]);
+        benchmark::ClobberMemory();
+    }
+    const size_t heapAfter = mallinfo().uordblks;
+
+    state.SetItemsProcessed(count);
+    state.counters["items/s"] = benchmark::Counter(count, benchmark::Counter::kIsRate);
+    state.counters["bytes/item"] = heapAfter > heapBefore && count > 0
+            ? (double)(heapAfter - heapBefore) / count : 0.;
+}
+
+static void BM_TimeMachinePut(benchmark::State& state)
+{
+    android::mediametrics::TimeMachine timeMachine;
+    putItems(state, timeMachine, [](auto& tm, const auto& item) {
+        (void)tm.put(item, true /* isTrusted */);
+    });
+}
+
+// Stay below the garbage collection high water marks.
+BENCHMARK(BM_TimeMachinePut)->Iterations(2000);
+
+static void BM_TransactionLogPut(benchmark::State& state)
+{
+    android::mediametrics::TransactionLog transactionLog;
+    putItems(state, transactionLog, [](auto& tl, const auto& item) {
+        (void)tl.put(item);
+    });
+}
+
+BENCHMARK(BM_TransactionLogPut)->Iterations(1999);
+
 BENCHMARK_MAIN();
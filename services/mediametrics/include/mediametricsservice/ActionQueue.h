@@ -0,0 +1,152 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <android-base/thread_annotations.h>
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace android::mediametrics {
+
+/**
+ * ActionQueue executes functions on a fixed set of worker threads.
+ *
+ * Each function is posted with a stripe key.  Functions with the same stripe key
+ * run on the same worker in posting order, while functions with different stripe
+ * keys may run in parallel.
+ *
+ * The ActionQueue is thread safe.
+ */
+class ActionQueue {
+public:
+    static inline constexpr size_t kDefaultWorkers = 4;
+
+    explicit ActionQueue(size_t workers = kDefaultWorkers) {
+        for (size_t i = 0; i < std::max(workers, (size_t)1); ++i) {
+            mWorkers.emplace_back(std::make_unique<Worker>());
+        }
+        // Start threads after all workers are constructed.
+        for (auto& worker : mWorkers) {
+            worker->mThread = std::thread([w = worker.get()]() { w->threadLoop(); });
+        }
+    }
+
+    ~ActionQueue() {
+        quit();
+    }
+
+    void post(std::string_view stripeKey, std::function<void()> f) {
+        Worker& worker = *mWorkers[std::hash<std::string_view>{}(stripeKey) % mWorkers.size()];
+        std::lock_guard l(worker.mLock);
+        if (worker.mQuit) return;
+        worker.mQueue.emplace_back(std::move(f));
+        worker.mMaxDepth = std::max(worker.mMaxDepth, worker.mQueue.size());
+        worker.mCondition.notify_one();
+    }
+
+    /**
+     * Stops the workers.  Functions not yet started are discarded.
+     */
+    void quit() {
+        for (auto& worker : mWorkers) {
+            {
+                std::lock_guard l(worker->mLock);
+                if (worker->mQuit) continue;
+                worker->mQuit = true;
+                worker->mQueue.clear();
+                worker->mCondition.notify_all();
+            }
+            worker->mThread.join();
+        }
+    }
+
+    /**
+     * Blocks until all functions posted before this call have completed.
+     */
+    void waitIdle() NO_THREAD_SAFETY_ANALYSIS { // thread safety doesn't cover unique_lock
+        for (auto& worker : mWorkers) {
+            std::unique_lock l(worker->mLock);
+            while (!worker->mQuit && (!worker->mQueue.empty() || worker->mRunning)) {
+                worker->mIdleCondition.wait(l);
+            }
+        }
+    }
+
+    /**
+     * Returns a pair consisting of the dump string and the number of lines in the string.
+     */
+    std::pair<std::string, int32_t> dump(int32_t lines = INT32_MAX) const {
+        std::stringstream ss;
+        int32_t ll = lines;
+        for (size_t i = 0; i < mWorkers.size() && ll > 0; ++i) {
+            const Worker& worker = *mWorkers[i];
+            std::lock_guard l(worker.mLock);
+            ss << "worker " << i << ": depth " << worker.mQueue.size()
+                    << " max depth " << worker.mMaxDepth
+                    << " executed " << worker.mExecuted << "\n";
+            --ll;
+        }
+        return { ss.str(), lines - ll };
+    }
+
+private:
+    class Worker {
+    public:
+        void threadLoop() NO_THREAD_SAFETY_ANALYSIS { // thread safety doesn't cover unique_lock
+            std::unique_lock l(mLock);
+            while (true) {
+                while (!mQuit && mQueue.empty()) {
+                    mCondition.wait(l);
+                }
+                if (mQuit) break;
+                std::function<void()> f = std::move(mQueue.front());
+                mQueue.pop_front();
+                mRunning = true;
+                l.unlock();
+                f();
+                f = nullptr;  // release captures outside of lock.
+                l.lock();
+                mRunning = false;
+                ++mExecuted;
+                if (mQueue.empty()) mIdleCondition.notify_all();
+            }
+            mIdleCondition.notify_all();
+        }
+
+        mutable std::mutex mLock;
+        std::condition_variable mCondition;
+        std::condition_variable mIdleCondition;
+        bool mQuit GUARDED_BY(mLock) = false;
+        bool mRunning GUARDED_BY(mLock) = false;
+        std::deque<std::function<void()>> mQueue GUARDED_BY(mLock);
+        size_t mMaxDepth GUARDED_BY(mLock) = 0;
+        int64_t mExecuted GUARDED_BY(mLock) = 0;
+        std::thread mThread;
+    };
+
+    std::vector<std::unique_ptr<Worker>> mWorkers;  // fixed after construction.
+};
+
+} // namespace android::mediametrics
@@ -106,6 +106,28 @@ public:
         return actions;
     }
 
+    /**
+     * Get all the actions triggered for a particular item, with their triggers.
+     *
+     * The trigger pointers remain valid for the lifetime of the AnalyticsActions,
+     * and may be used to identify the action.
+     *
+     * \param item to be analyzed for actions.
+     */
+    std::vector<std::pair<const Trigger*, Action>>
+    getTriggeredActionsForItem(const std::shared_ptr<const mediametrics::Item>& item) {
+        std::vector<std::pair<const Trigger*, Action>> actions;
+        std::lock_guard l(mLock);
+
+        for (const auto &[trigger, action] : mFilters) {
+            if (isWildcardMatch(trigger, item) ==
+                    mediametrics::Item::RECURSIVE_WILDCARD_CHECK_MATCH_FOUND) {
+                actions.emplace_back(&trigger, action);
+            }
+        }
+        return actions;
+    }
+
 private:
 
     static inline bool isMatch(const Trigger& trigger,
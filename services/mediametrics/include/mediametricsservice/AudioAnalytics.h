@@ -17,6 +17,7 @@
 #pragma once
 
 #include <android-base/thread_annotations.h>
+#include "ActionQueue.h"
 #include "AnalyticsActions.h"
 #include "AnalyticsState.h"
 #include "AudioPowerUsage.h"
@@ -101,6 +102,20 @@ public:
         return mSpatializer.dump(lines);
     }
 
+    /**
+     * Returns a pair consisting of the dump string and the number of lines in the string.
+     *
+     * Action queue depth and the time spent per action.
+     */
+    std::pair<std::string, int32_t> dumpActions(int32_t lines = INT32_MAX) const;
+
+    /**
+     * Waits until the status and actions of all submitted items have been processed.
+     */
+    void waitForActions() {
+        mActionQueue.waitIdle();
+    }
+
     void clear() {
         // underlying state is locked.
         mPreviousAnalyticsState->clear();
@@ -180,6 +195,21 @@ private:
     SharedPtrWrap<AnalyticsState> mPreviousAnalyticsState;
 
     TimedAction mTimedAction; // locked internally
+
+    // Status and actions of submitted items are processed on the action queue,
+    // striped by key prefix so that e.g. audio.track and audio.record items are
+    // processed in parallel, while items with the same prefix remain in order.
+    ActionQueue mActionQueue; // locked internally
+
+    // Execution statistics per action, identified by its trigger.
+    struct ActionStats {
+        int64_t count = 0;
+        int64_t totalNs = 0;
+        int64_t maxNs = 0;
+    };
+    mutable std::mutex mActionStatsLock;
+    std::map<const AnalyticsActions::Trigger*, ActionStats> mActionStats
+            GUARDED_BY(mActionStatsLock);
     const std::shared_ptr<StatsdLog> mStatsdLog; // locked internally, ok for multiple threads.
 
     static constexpr size_t kHeatEntries = 100;
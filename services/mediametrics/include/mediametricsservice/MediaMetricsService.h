@@ -56,11 +56,13 @@ public:
         return submitInternal(item, false /* release */);
     }
 
-    status_t submitBuffer(const char *buffer, size_t length) {
-        mediametrics::Item *item = new mediametrics::Item();
-        return item->readFromByteString(buffer, length)
-                ?: submitInternal(item, true /* release */);
-    }
+    /**
+     * Submits the items in a byte string buffer.
+     *
+     * Clients may batch several items in one buffer; each item byte string
+     * starts with its total size, so items are read in place one after the other.
+     */
+    status_t submitBuffer(const char *buffer, size_t length);
 
     status_t dump(int fd, const Vector<String16>& args) override;
 
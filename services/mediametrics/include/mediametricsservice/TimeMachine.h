@@ -16,11 +16,13 @@
 
 #pragma once
 
+#include <algorithm>
 #include <any>
 #include <map>
 #include <mutex>
 #include <sstream>
 #include <string>
+#include <unordered_map>
 #include <variant>
 #include <vector>
 
@@ -28,6 +30,8 @@
 #include <media/MediaMetricsItem.h>
 #include <utils/Timers.h>
 
+#include "TimeSequence.h"
+
 namespace android::mediametrics {
 
 // define a way of printing the monostate
@@ -61,15 +65,62 @@ std::ostream & operator<< (std::ostream& s,
  * Any URL that ends with '#' (AMEDIAMETRICS_PROP_SUFFIX_CHAR_DUPLICATES_ALLOWED)
  * will have a time sequence that keeps duplicates.
  *
+ * Property names are interned process-wide, and each property history is a
+ * bounded ring buffer, so putting an item generally does not allocate.
+ *
  * The TimeMachine is NOT thread safe.
  */
 class TimeMachine final { // made final as we have copy constructor instead of dup() override.
 public:
     using Elem = Item::Prop::Elem;  // use the Item property element.
-    using PropertyHistory = std::multimap<int64_t /* time */, Elem>;
+    using PropertyHistory = TimeSequence<Elem>;
 
 private:
 
+    // PropertyNames interns property names, which come from a small vocabulary
+    // shared by all keys, so that each KeyHistory stores only integer ids.
+    // Names are never removed; the table is limited to kMaxPropertyNames.
+    class PropertyNames {
+    public:
+        static inline constexpr uint32_t kInvalidId = UINT32_MAX;
+
+        // Returns the id of name, adding it if necessary and there is space.
+        uint32_t getOrAdd(const std::string& name) {
+            std::lock_guard lock(mLock);
+            auto it = mIds.find(name);
+            if (it != mIds.end()) return it->second;
+            if (mNames.size() >= kMaxPropertyNames) return kInvalidId;
+            it = mIds.emplace(name, (uint32_t)mNames.size()).first;
+            mNames.push_back(&it->first);
+            return it->second;
+        }
+
+        // Returns the id of name, or kInvalidId if the name was never added.
+        uint32_t find(const std::string& name) const {
+            std::lock_guard lock(mLock);
+            auto it = mIds.find(name);
+            return it == mIds.end() ? kInvalidId : it->second;
+        }
+
+        // The returned reference is valid for the life of the process.
+        const std::string& getName(uint32_t id) const {
+            std::lock_guard lock(mLock);
+            return *mNames[id];
+        }
+
+    private:
+        static inline constexpr size_t kMaxPropertyNames = 4096;
+
+        mutable std::mutex mLock;
+        std::unordered_map<std::string, uint32_t> mIds GUARDED_BY(mLock);
+        std::vector<const std::string*> mNames GUARDED_BY(mLock);  // points into mIds
+    };
+
+    static PropertyNames& getPropertyNames() {
+        static PropertyNames propertyNames;
+        return propertyNames;
+    }
+
     // KeyHistory contains no lock.
     // Access is through the TimeMachine, and a hash-striped lock is used
     // before calling into KeyHistory.
@@ -108,14 +159,12 @@ private:
         status_t getValue(const std::string &property, T* value, int64_t time = 0) const
                 REQUIRES(mPseudoKeyHistoryLock) {
             if (time == 0) time = systemTime(SYSTEM_TIME_REALTIME);
-            const auto tsptr = mPropertyMap.find(property);
-            if (tsptr == mPropertyMap.end()) return BAD_VALUE;
-            const auto& timeSequence = tsptr->second;
-            auto eptr = timeSequence.upper_bound(time);
-            if (eptr == timeSequence.begin()) return BAD_VALUE;
-            --eptr;
-            if (eptr == timeSequence.end()) return BAD_VALUE;
-            const T* vptr = std::get_if<T>(&eptr->second);
+            const PropertyHistory* timeSequence =
+                    findPropertyHistory(getPropertyNames().find(property));
+            if (timeSequence == nullptr) return BAD_VALUE;
+            const size_t index = timeSequence->upperBound(time);
+            if (index == 0) return BAD_VALUE;
+            const T* vptr = std::get_if<T>(&(*timeSequence)[index - 1].second);
             if (vptr == nullptr) return BAD_VALUE;
             *value = *vptr;
             return NO_ERROR;
@@ -140,34 +189,49 @@ private:
                 REQUIRES(mPseudoKeyHistoryLock) {
             if (time == 0) time = systemTime(SYSTEM_TIME_REALTIME);
             mLastModificationTime = time;
-            if (mPropertyMap.size() >= kKeyMaxProperties &&
-                    !mPropertyMap.count(property)) {
-                ALOGV("%s: too many properties, rejecting %s", __func__, property.c_str());
+            const uint32_t id = getPropertyNames().getOrAdd(property);
+            if (id == PropertyNames::kInvalidId) {
+                ALOGV("%s: too many property names, rejecting %s", __func__, property.c_str());
                 mRejectedPropertiesCount++;
                 return;
             }
-            auto& timeSequence = mPropertyMap[property];
+            auto it = std::lower_bound(mPropertyHistories.begin(), mPropertyHistories.end(), id,
+                    [](const auto& entry, uint32_t value) { return entry.first < value; });
+            if (it == mPropertyHistories.end() || it->first != id) {
+                if (mPropertyHistories.size() >= kKeyMaxProperties) {
+                    ALOGV("%s: too many properties, rejecting %s", __func__, property.c_str());
+                    mRejectedPropertiesCount++;
+                    return;
+                }
+                it = mPropertyHistories.emplace(
+                        it, id, PropertyHistory(kTimeSequenceMaxElements));
+            }
+            auto& timeSequence = it->second;
             Elem el{std::forward<T>(e)};
             if (timeSequence.empty()           // no elements
                     || property.back() == AMEDIAMETRICS_PROP_SUFFIX_CHAR_DUPLICATES_ALLOWED
-                    || timeSequence.rbegin()->second != el) { // value changed
-                timeSequence.emplace_hint(timeSequence.end(), time, std::move(el));
-
-                if (timeSequence.size() > kTimeSequenceMaxElements) {
-                    ALOGV("%s: restricting maximum elements (discarding oldest) for %s",
-                            __func__, property.c_str());
-                    timeSequence.erase(timeSequence.begin());
-                }
+                    || timeSequence.back().second != el) { // value changed
+                // Discards the oldest element if more than kTimeSequenceMaxElements.
+                timeSequence.emplace(time, std::move(el));
             }
         }
 
         std::pair<std::string, int32_t> dump(int32_t lines, int64_t time) const
                 REQUIRES(mPseudoKeyHistoryLock) {
+            // Dump properties in name order.
+            std::vector<std::pair<const std::string*, const PropertyHistory*>> properties;
+            properties.reserve(mPropertyHistories.size());
+            for (const auto& [id, timeSequence] : mPropertyHistories) {
+                properties.emplace_back(&getPropertyNames().getName(id), &timeSequence);
+            }
+            std::sort(properties.begin(), properties.end(),
+                    [](const auto& a, const auto& b) { return *a.first < *b.first; });
+
             std::stringstream ss;
             int32_t ll = lines;
-            for (auto& tsPair : mPropertyMap) {
+            for (const auto& [name, timeSequence] : properties) {
                 if (ll <= 0) break;
-                std::string s = dump(mKey, tsPair, time);
+                std::string s = dump(mKey, *name, *timeSequence, time);
                 if (s.size() > 0) {
                     --ll;
                     ss << s;
@@ -185,28 +249,38 @@ private:
         }
 
     private:
+        const PropertyHistory* findPropertyHistory(uint32_t id) const
+                REQUIRES(mPseudoKeyHistoryLock) {
+            if (id == PropertyNames::kInvalidId) return nullptr;
+            auto it = std::lower_bound(mPropertyHistories.begin(), mPropertyHistories.end(), id,
+                    [](const auto& entry, uint32_t value) { return entry.first < value; });
+            if (it == mPropertyHistories.end() || it->first != id) return nullptr;
+            return &it->second;
+        }
+
         static std::string dump(
                 const std::string &key,
-                const std::pair<std::string /* prop */, PropertyHistory>& tsPair,
+                const std::string &property,
+                const PropertyHistory& timeSequence,
                 int64_t time) {
-            const auto timeSequence = tsPair.second;
-            auto eptr = timeSequence.lower_bound(time);
-            if (eptr == timeSequence.end()) {
-                return {}; // don't dump anything. tsPair.first + "={};\n";
+            size_t index = timeSequence.lowerBound(time);
+            if (index == timeSequence.size()) {
+                return {}; // don't dump anything. property + "={};\n";
             }
             std::stringstream ss;
-            ss << key << "." << tsPair.first << "={";
+            ss << key << "." << property << "={";
 
             time_string_t last_timestring{}; // last timestring used.
             while (true) {
-                const time_string_t timestring = mediametrics::timeStringFromNs(eptr->first);
+                const auto& [elemTime, elem] = timeSequence[index];
+                const time_string_t timestring = mediametrics::timeStringFromNs(elemTime);
                 // find common prefix offset.
                 const size_t offset = commonTimePrefixPosition(timestring.time,
                         last_timestring.time);
                 last_timestring = timestring;
                 ss << "(" << (offset == 0 ? "" : "~") << &timestring.time[offset]
-                    << ") " << eptr->second;
-                if (++eptr == timeSequence.end()) {
+                    << ") " << elem;
+                if (++index == timeSequence.size()) {
                     break;
                 }
                 ss << ", ";
@@ -221,7 +295,8 @@ private:
 
         unsigned int mRejectedPropertiesCount = 0;
         int64_t mLastModificationTime;
-        std::map<std::string /* property */, PropertyHistory> mPropertyMap;
+        // Sorted by interned property id.
+        std::vector<std::pair<uint32_t /* property id */, PropertyHistory>> mPropertyHistories;
     };
 
     using History = std::map<std::string /* key */, std::shared_ptr<KeyHistory>>;
@@ -0,0 +1,151 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace android::mediametrics {
+
+/**
+ * TimeSequence is a time ordered sequence of values stored in a ring buffer.
+ *
+ * It replaces a std::multimap<int64_t, T> for our access patterns: values are
+ * nearly always appended in time order, and removed from the oldest end.
+ * A TimeSequence needs no allocation per element; the ring grows geometrically
+ * up to maxElements, after which the oldest element is discarded on insertion.
+ *
+ * Values with equal time are kept in insertion order, as in a multimap.
+ *
+ * The TimeSequence is NOT thread safe.
+ */
+template <typename T>
+class TimeSequence {
+public:
+    using value_type = std::pair<int64_t /* time */, T>;
+
+    explicit TimeSequence(size_t maxElements = std::numeric_limits<size_t>::max())
+        : mMaxElements(std::max(maxElements, (size_t)1)) {}
+
+    size_t size() const { return mSize; }
+    bool empty() const { return mSize == 0; }
+    size_t maxElements() const { return mMaxElements; }
+
+    // Element access in time order, 0 is the oldest.
+    const value_type& operator[](size_t i) const { return mRing[physical(i)]; }
+    value_type& operator[](size_t i) { return mRing[physical(i)]; }
+    const value_type& front() const { return (*this)[0]; }
+    const value_type& back() const { return (*this)[mSize - 1]; }
+
+    /**
+     * Inserts a value after all values with time less than or equal to time.
+     *
+     * If the sequence is full, the oldest value (which may be the new value)
+     * is discarded.
+     */
+    void emplace(int64_t time, T&& value) {
+        if (mSize == mMaxElements) {
+            if (time < front().first) return;  // the new value is the oldest.
+            (void)takeFront();
+        }
+        if (mSize == mRing.size()) grow();
+
+        // Usually the new value is the most recent one.
+        size_t pos = mSize;
+        if (mSize > 0 && time < back().first) {
+            pos = upperBound(time);
+        }
+        mRing[physical(mSize)] = value_type{time, std::move(value)};
+        ++mSize;
+        for (size_t i = mSize - 1; i > pos; --i) {
+            std::swap((*this)[i], (*this)[i - 1]);
+        }
+    }
+
+    /**
+     * Removes the oldest value and returns it, so that it may be destroyed
+     * outside of any lock.
+     */
+    T takeFront() {
+        T value = std::move(mRing[mHead].second);
+        mRing[mHead].second = T{};  // release any resources held.
+        mHead = (mHead + 1) % mRing.size();
+        --mSize;
+        return value;
+    }
+
+    // Returns the index of the first value with time not less than time.
+    size_t lowerBound(int64_t time) const {
+        return partitionPoint([time](int64_t t) { return t < time; });
+    }
+
+    // Returns the index of the first value with time greater than time.
+    size_t upperBound(int64_t time) const {
+        return partitionPoint([time](int64_t t) { return t <= time; });
+    }
+
+    void clear() {
+        mRing.clear();
+        mRing.shrink_to_fit();
+        mHead = 0;
+        mSize = 0;
+    }
+
+private:
+    static inline constexpr size_t kMinCapacity = 4;
+
+    size_t physical(size_t i) const { return (mHead + i) % mRing.size(); }
+
+    template <typename F>
+    size_t partitionPoint(F pred) const {
+        size_t lo = 0;
+        size_t hi = mSize;
+        while (lo < hi) {
+            const size_t mid = lo + (hi - lo) / 2;
+            if (pred((*this)[mid].first)) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        return lo;
+    }
+
+    // Grows the ring geometrically, linearizing the contents.
+    void grow() {
+        const size_t capacity = std::min(mMaxElements,
+                std::max(kMinCapacity, mRing.size() * 2));
+        std::vector<value_type> ring;
+        ring.reserve(capacity);
+        for (size_t i = 0; i < mSize; ++i) {
+            ring.emplace_back(std::move((*this)[i]));
+        }
+        ring.resize(capacity);
+        mRing = std::move(ring);
+        mHead = 0;
+    }
+
+    size_t mMaxElements;
+    std::vector<value_type> mRing;
+    size_t mHead = 0;
+    size_t mSize = 0;
+};
+
+} // namespace android::mediametrics
@@ -24,6 +24,8 @@
 #include <android-base/thread_annotations.h>
 #include <media/MediaMetricsItem.h>
 
+#include "TimeSequence.h"
+
 namespace android::mediametrics {
 
 /**
@@ -34,6 +36,7 @@ namespace android::mediametrics {
  * just make this submit order).
  *
  * These Views have a cost in shared pointer storage, so they aren't quite free.
+ * Items are kept in ring buffers so that a put does not allocate per item.
  *
  * The TransactionLog is NOT thread safe.
  */
@@ -95,8 +98,12 @@ public:
         std::lock_guard lock(mLock);
 
         (void)gc(garbage);
-        mLog.emplace_hint(mLog.end(), time, item);
-        mItemMap[key].emplace_hint(mItemMap[key].end(), time, item);
+        mLog.emplace(time, std::shared_ptr<const mediametrics::Item>(item));
+        auto it = mItemMap.find(key);
+        if (it == mItemMap.end()) {
+            it = mItemMap.emplace(key, MapTimeItem{}).first;
+        }
+        it->second.emplace(time, std::shared_ptr<const mediametrics::Item>(item));
         return NO_ERROR;  // no errors for now.
     }
 
@@ -190,22 +197,21 @@ public:
     }
 
 private:
-    using MapTimeItem =
-            std::multimap<int64_t /* time */, std::shared_ptr<const mediametrics::Item>>;
+    using MapTimeItem = TimeSequence<std::shared_ptr<const mediametrics::Item>>;
 
     static std::pair<std::string, int32_t> dumpMapTimeItem(
             const MapTimeItem& mapTimeItem,
             int32_t lines, int64_t sinceNs = 0, const char *prefix = nullptr) {
         std::stringstream ss;
         int32_t ll = lines;
-        // Note: for our data, mapTimeItem.lower_bound(0) == mapTimeItem.begin().
-        for (auto it = mapTimeItem.lower_bound(sinceNs);
-                it != mapTimeItem.end(); ++it) {
+        // Note: for our data, mapTimeItem.lowerBound(0) == 0.
+        for (size_t i = mapTimeItem.lowerBound(sinceNs); i < mapTimeItem.size(); ++i) {
             if (ll <= 0) break;
-            if (prefix != nullptr && !startsWith(it->second->getKey(), prefix)) {
+            const auto& item = mapTimeItem[i].second;
+            if (prefix != nullptr && !startsWith(item->getKey(), prefix)) {
                 continue;
             }
-            ss << "  " << it->second->toString() << "\n";
+            ss << "  " << item->toString() << "\n";
             --ll;
         }
         return { ss.str(), lines - ll };
@@ -222,43 +228,35 @@ private:
     bool gc(std::vector<std::any>& garbage) REQUIRES(mLock) {
         if (mLog.size() < mHighWaterMark) return false;
 
-        auto eraseEnd = mLog.begin();
         size_t toRemove = mLog.size() - mLowWaterMark;
         // remove at least those elements.
 
+        // ensure that the erase boundary represents a unique time jump.
+        while (toRemove > 0 && toRemove < mLog.size()
+                && mLog[toRemove].first == mLog[toRemove - 1].first) {
+            ++toRemove;
+        }
+
         // use a stale vector with precise type to avoid type erasure overhead in garbage
         std::vector<std::shared_ptr<const mediametrics::Item>> stale;
+        stale.reserve(toRemove * 2);
 
         for (size_t i = 0; i < toRemove; ++i) {
-            stale.emplace_back(std::move(eraseEnd->second));
-            ++eraseEnd; // amortized O(1)
-        }
-        // ensure that eraseEnd is an lower bound on timeToErase.
-        const int64_t timeToErase = eraseEnd->first;
-        while (eraseEnd != mLog.end()) {
-            auto it = eraseEnd;
-            --it;  // amortized O(1)
-            if (it->first != timeToErase) {
-                break;  // eraseEnd represents a unique time jump.
-            }
-            stale.emplace_back(std::move(eraseEnd->second));
-            ++eraseEnd;
+            stale.emplace_back(mLog.takeFront());
         }
-
-        mLog.erase(mLog.begin(), eraseEnd);  // O(ptr_diff)
+        const int64_t eraseEndTime = mLog.empty() ? INT64_MAX : mLog.front().first;
 
         size_t itemMapCount = 0;
         for (auto it = mItemMap.begin(); it != mItemMap.end();) {
             auto &keyHist = it->second;
-            auto it2 = keyHist.lower_bound(timeToErase);
-            if (it2 == keyHist.end()) {
+            const size_t keep = keyHist.lowerBound(eraseEndTime);
+            if (keep == keyHist.size()) {
                 garbage.emplace_back(std::move(keyHist)); // directly move keyhist to garbage
                 it = mItemMap.erase(it);
             } else {
-                for (auto it3 = keyHist.begin(); it3 != it2; ++it3) {
-                    stale.emplace_back(std::move(it3->second));
+                for (size_t i = 0; i < keep; ++i) {
+                    stale.emplace_back(keyHist.takeFront());
                 }
-                keyHist.erase(keyHist.begin(), it2);
                 itemMapCount += keyHist.size();
                  ++it;
             }
@@ -276,15 +274,12 @@ private:
     static std::vector<std::shared_ptr<const mediametrics::Item>> getItemsInRange(
             const MapTimeItem& map,
             int64_t startTime = 0, int64_t endTime = INT64_MAX) {
-        auto it = map.lower_bound(startTime);
-        if (it == map.end()) return {};
-
-        auto it2 = map.upper_bound(endTime);
+        const size_t begin = map.lowerBound(startTime);
+        const size_t end = map.upperBound(endTime);
 
         std::vector<std::shared_ptr<const mediametrics::Item>> ret;
-        while (it != it2) {
-            ret.push_back(it->second);
-            ++it;
+        for (size_t i = begin; i < end; ++i) {
+            ret.push_back(map[i].second);
         }
         return ret;
     }
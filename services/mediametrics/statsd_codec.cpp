@@ -795,6 +795,18 @@ bool statsd_codec(const std::shared_ptr<const mediametrics::Item>& item,
                                mediaApexVersion,
                                bf_serialized);
 
+    // The per stage latencies of MediaCodec are only logged, the atom has no fields for them.
+    std::stringstream stageLatencies;
+    for (const char *stage : {"queue", "codec", "dispatch", "client"}) {
+        const std::string key = std::string("android.media.mediacodec.latency.") + stage;
+        int64_t stageAvg = -1;
+        int64_t stageMax = -1;
+        item->getInt64((key + ".avg").c_str(), &stageAvg);
+        item->getInt64((key + ".max").c_str(), &stageMax);
+        stageLatencies << " latency_" << stage << "_avg:" << stageAvg
+                << " latency_" << stage << "_max:" << stageMax;
+    }
+
     std::stringstream log;
     log << "result:" << result << " {"
             << " mediametrics_codec_reported:"
@@ -823,6 +835,7 @@ bool statsd_codec(const std::shared_ptr<const mediametrics::Item>& item,
             << " latency_avg:" << latencyAvg
             << " latency_count:" << latencyCount
             << " latency_unknown:" << latencyUnknown
+            << stageLatencies.str()
             << " queue_input_buffer_error:" << queueInputBufferError
             << " queue_secure_input_buffer_error:" << queueSecureInputBufferError
             << " bitrate_mode:" << bitrateMode
@@ -24,9 +24,11 @@
 
 #include <gtest/gtest.h>
 #include <media/MediaMetricsItem.h>
+#include <mediametricsservice/ActionQueue.h>
 #include <mediametricsservice/AudioTypes.h>
 #include <mediametricsservice/MediaMetricsService.h>
 #include <mediametricsservice/StringUtils.h>
+#include <mediametricsservice/TimeSequence.h>
 #include <mediametricsservice/ValidateId.h>
 #include <system/audio.h>
 
@@ -268,6 +270,27 @@ TEST(mediametrics_tests, instantiate) {
   mediaMetrics->dump(fileno(stdout), {} /* args */);
 }
 
+TEST(mediametrics_tests, submit_batched_buffer) {
+  sp mediaMetrics = new MediaMetricsService();
+
+  // Items batched by a client are concatenated byte strings.
+  std::vector<char> batch;
+  for (int32_t i = 0; i < 3; ++i) {
+    mediametrics::Item item("audiotrack");
+    item.setInt32("value", i);
+    char *buffer;
+    size_t length;
+    ASSERT_EQ(NO_ERROR, item.writeToByteString(&buffer, &length));
+    batch.insert(batch.end(), buffer, buffer + length);
+    free(buffer);
+  }
+  ASSERT_EQ(NO_ERROR, mediaMetrics->submitBuffer(batch.data(), batch.size()));
+
+  // A truncated batch delivers the complete items and reports an error.
+  ASSERT_EQ(BAD_VALUE, mediaMetrics->submitBuffer(batch.data(), batch.size() - 1));
+  ASSERT_EQ(BAD_VALUE, mediaMetrics->submitBuffer(batch.data(), 0));
+}
+
 TEST(mediametrics_tests, package_installer_check) {
   ASSERT_EQ(false, MediaMetricsService::useUidForPackage(
       "abcd", "installer"));  // ok, package name has no dot.
@@ -771,6 +794,66 @@ TEST(mediametrics_tests, transaction_log_gc) {
   ASSERT_EQ((size_t)2, transactionLog.size());
 }
 
+TEST(mediametrics_tests, time_sequence) {
+  android::mediametrics::TimeSequence<int32_t> timeSequence(4); // keep at most 4 values.
+  ASSERT_TRUE(timeSequence.empty());
+
+  timeSequence.emplace(10, 1);
+  timeSequence.emplace(30, 3);
+  timeSequence.emplace(20, 2);  // out of order.
+  timeSequence.emplace(20, 4);  // after the existing value with the same time.
+  ASSERT_EQ((size_t)4, timeSequence.size());
+  ASSERT_EQ(1, timeSequence[0].second);
+  ASSERT_EQ(2, timeSequence[1].second);
+  ASSERT_EQ(4, timeSequence[2].second);
+  ASSERT_EQ(3, timeSequence[3].second);
+
+  ASSERT_EQ((size_t)1, timeSequence.lowerBound(20));
+  ASSERT_EQ((size_t)3, timeSequence.upperBound(20));
+  ASSERT_EQ((size_t)0, timeSequence.upperBound(5));
+  ASSERT_EQ((size_t)4, timeSequence.lowerBound(40));
+
+  // When full, the oldest value is discarded.
+  timeSequence.emplace(40, 5);
+  ASSERT_EQ((size_t)4, timeSequence.size());
+  ASSERT_EQ(20, timeSequence.front().first);
+  ASSERT_EQ(5, timeSequence.back().second);
+
+  // A value older than all others is discarded directly.
+  timeSequence.emplace(0, 6);
+  ASSERT_EQ((size_t)4, timeSequence.size());
+  ASSERT_EQ(2, timeSequence.front().second);
+
+  ASSERT_EQ(2, timeSequence.takeFront());
+  ASSERT_EQ((size_t)3, timeSequence.size());
+  ASSERT_EQ(4, timeSequence.front().second);
+
+  timeSequence.clear();
+  ASSERT_TRUE(timeSequence.empty());
+}
+
+TEST(mediametrics_tests, time_machine_history) {
+  android::mediametrics::TimeMachine timeMachine;
+  auto item = std::make_shared<mediametrics::Item>("Key");
+  (*item).set("value", (int32_t)0).setTimestamp(1);
+  ASSERT_EQ(NO_ERROR, timeMachine.put(item, true));
+
+  // Put more values than the history holds, all distinct.
+  for (int32_t i = 1; i < 100; ++i) {
+    ASSERT_EQ(NO_ERROR, timeMachine.put("Key.value", i, 1 + i));
+  }
+
+  int32_t i32;
+  ASSERT_EQ(NO_ERROR, timeMachine.get("Key.value", &i32, -1));
+  ASSERT_EQ(99, i32);
+  ASSERT_EQ(NO_ERROR, timeMachine.get("Key.value", &i32, -1, 90 /* time */));
+  ASSERT_EQ(89, i32);
+
+  // The oldest values are discarded.
+  ASSERT_EQ(BAD_VALUE, timeMachine.get("Key.value", &i32, -1, 2 /* time */));
+  ASSERT_EQ(BAD_VALUE, timeMachine.get("Key.unknown_property", &i32, -1));
+}
+
 TEST(mediametrics_tests, analytics_actions) {
   mediametrics::AnalyticsActions analyticsActions;
   bool action1 = false;
@@ -976,6 +1059,35 @@ TEST(mediametrics_tests, timed_action) {
     ASSERT_EQ((size_t)1, timedAction.size());
 }
 
+TEST(mediametrics_tests, action_queue) {
+    android::mediametrics::ActionQueue actionQueue(2 /* workers */);
+    std::mutex lock;
+    std::vector<int> track;
+    std::atomic_int record = 0;
+
+    // Functions with the same stripe key execute in order.
+    for (int i = 0; i < 100; ++i) {
+        actionQueue.post("audio.track", [&, i] {
+            std::lock_guard l(lock);
+            track.push_back(i);
+        });
+        actionQueue.post("audio.record", [&record] { ++record; });
+    }
+    actionQueue.waitIdle();
+    ASSERT_EQ(100, record);
+    ASSERT_EQ((size_t)100, track.size());
+    for (int i = 0; i < 100; ++i) {
+        ASSERT_EQ(i, track[i]);
+    }
+    ASSERT_EQ(2, actionQueue.dump().second /* lines */);
+
+    // No functions are executed after quit.
+    actionQueue.quit();
+    actionQueue.post("audio.record", [&record] { ++record; });
+    actionQueue.waitIdle();
+    ASSERT_EQ(100, record);
+}
+
 // Ensure we don't introduce unexpected duplicates into our maps.
 TEST(mediametrics_tests, audio_types_tables) {
     using namespace android::mediametrics::types;
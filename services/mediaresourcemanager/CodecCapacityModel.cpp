@@ -0,0 +1,182 @@
+/*
+**
+** Copyright 2026, The Android Open Source Project
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "CodecCapacityModel"
+#include <utils/Log.h>
+
+#include "CodecCapacityModel.h"
+
+#include <algorithm>
+#include <sstream>
+
+namespace android {
+
+// static
+int64_t CodecCapacityModel::getMacroblocksPerSecond(const ClientConfigParcel& clientConfig) {
+    if (clientConfig.codecType != MediaResourceSubType::kVideoCodec &&
+        clientConfig.codecType != MediaResourceSubType::kImageCodec) {
+        return 0;
+    }
+    if (clientConfig.width <= 0 || clientConfig.height <= 0) {
+        return 0;
+    }
+    const int64_t macroblocks = ((clientConfig.width + 15) / 16) *
+            (int64_t)((clientConfig.height + 15) / 16);
+    const int32_t frameRate = clientConfig.frameRate > 0 ? clientConfig.frameRate
+                                                         : kDefaultFrameRate;
+    return macroblocks * frameRate;
+}
+
+void CodecCapacityModel::notifyClientStarted(const ClientConfigParcel& clientConfig) {
+    std::scoped_lock lock(mLock);
+    // A client restarted without being stopped is counted once.
+    removeClient_l(clientConfig.clientInfo.id);
+
+    CodecBucket bucket = getCodecBucket(clientConfig.isHardware,
+                                        clientConfig.isEncoder,
+                                        clientConfig.codecType);
+    learnCapacity_l(bucket, clientConfig);
+
+    Client client{bucket, clientConfig.clientInfo.name, getMacroblocksPerSecond(clientConfig)};
+    mLoad[bucket].mInstances++;
+    mLoad[bucket].mMacroblocksPerSecond += client.mMacroblocksPerSecond;
+    mInstancesByName[client.mName]++;
+    mClients.emplace(clientConfig.clientInfo.id, std::move(client));
+}
+
+void CodecCapacityModel::notifyClientStopped(const ClientConfigParcel& clientConfig) {
+    std::scoped_lock lock(mLock);
+    removeClient_l(clientConfig.clientInfo.id);
+}
+
+void CodecCapacityModel::notifyClientReleased(const ClientInfoParcel& clientInfo) {
+    std::scoped_lock lock(mLock);
+    // Release may be called without Stop.
+    removeClient_l(clientInfo.id);
+}
+
+void CodecCapacityModel::notifyClientConfigChanged(const ClientConfigParcel& clientConfig) {
+    std::scoped_lock lock(mLock);
+    auto found = mClients.find(clientConfig.clientInfo.id);
+    if (found == mClients.end()) {
+        return;
+    }
+    Client& client = found->second;
+    const int64_t macroblocksPerSecond = getMacroblocksPerSecond(clientConfig);
+    mLoad[client.mBucket].mMacroblocksPerSecond +=
+            macroblocksPerSecond - client.mMacroblocksPerSecond;
+    client.mMacroblocksPerSecond = macroblocksPerSecond;
+}
+
+bool CodecCapacityModel::hasCapacity(const ClientConfigParcel& clientConfig) const {
+    CodecBucket bucket = getCodecBucket(clientConfig.isHardware,
+                                        clientConfig.isEncoder,
+                                        clientConfig.codecType);
+    const int64_t needed = getMacroblocksPerSecond(clientConfig);
+
+    std::scoped_lock lock(mLock);
+    // Prefer the capacity reported by the caller, then the one reported earlier
+    // by the same codec, then the largest one seen for the bucket.
+    Capacity capacity = mCapacity[bucket];
+    int32_t instances = 0;
+    auto byName = mCapacityByName.find(clientConfig.clientInfo.name);
+    if (byName != mCapacityByName.end()) {
+        capacity = byName->second;
+    }
+    auto instancesByName = mInstancesByName.find(clientConfig.clientInfo.name);
+    if (instancesByName != mInstancesByName.end()) {
+        instances = instancesByName->second;
+    }
+    if (clientConfig.maxMacroblocksPerSecond > 0) {
+        capacity.mMacroblocksPerSecond = clientConfig.maxMacroblocksPerSecond;
+    }
+    if (clientConfig.maxConcurrentInstances > 0) {
+        capacity.mConcurrentInstances = clientConfig.maxConcurrentInstances;
+    }
+
+    if (capacity.mConcurrentInstances > 0 && instances >= capacity.mConcurrentInstances) {
+        ALOGV("%s: %s has %d of %d instances", __func__,
+              clientConfig.clientInfo.name.c_str(), instances, capacity.mConcurrentInstances);
+        return false;
+    }
+    const Load& load = mLoad[bucket];
+    if (capacity.mMacroblocksPerSecond > 0 && needed > 0 &&
+        load.mMacroblocksPerSecond + needed > capacity.mMacroblocksPerSecond) {
+        ALOGV("%s: bucket %d load %lld + %lld exceeds %lld macroblocks/s", __func__,
+              bucket, (long long)load.mMacroblocksPerSecond, (long long)needed,
+              (long long)capacity.mMacroblocksPerSecond);
+        return false;
+    }
+    return true;
+}
+
+std::string CodecCapacityModel::dump() const {
+    std::scoped_lock lock(mLock);
+    std::stringstream ss;
+    for (int bucket = CodecBucketUnspecified + 1; bucket < CodecBucketMaxSize; ++bucket) {
+        const Load& load = mLoad[bucket];
+        const Capacity& capacity = mCapacity[bucket];
+        if (load.mInstances == 0 && capacity.mMacroblocksPerSecond == 0) {
+            continue;
+        }
+        ss << "    Bucket " << bucket << ": instances " << load.mInstances
+           << " macroblocks/s " << load.mMacroblocksPerSecond
+           << " of " << capacity.mMacroblocksPerSecond << "\n";
+    }
+    for (const auto& [name, capacity] : mCapacityByName) {
+        auto instances = mInstancesByName.find(name);
+        ss << "    " << name << ": instances "
+           << (instances == mInstancesByName.end() ? 0 : instances->second)
+           << " of " << capacity.mConcurrentInstances
+           << " macroblocks/s " << capacity.mMacroblocksPerSecond << "\n";
+    }
+    return ss.str();
+}
+
+void CodecCapacityModel::learnCapacity_l(CodecBucket bucket,
+                                         const ClientConfigParcel& clientConfig) {
+    if (clientConfig.maxMacroblocksPerSecond <= 0 && clientConfig.maxConcurrentInstances <= 0) {
+        return;
+    }
+    Capacity& byName = mCapacityByName[clientConfig.clientInfo.name];
+    byName.mMacroblocksPerSecond = clientConfig.maxMacroblocksPerSecond;
+    byName.mConcurrentInstances = clientConfig.maxConcurrentInstances;
+
+    Capacity& byBucket = mCapacity[bucket];
+    byBucket.mMacroblocksPerSecond = std::max(byBucket.mMacroblocksPerSecond,
+                                              clientConfig.maxMacroblocksPerSecond);
+}
+
+void CodecCapacityModel::removeClient_l(int64_t clientId) {
+    auto found = mClients.find(clientId);
+    if (found == mClients.end()) {
+        return;
+    }
+    const Client& client = found->second;
+    Load& load = mLoad[client.mBucket];
+    load.mInstances = std::max(load.mInstances - 1, 0);
+    load.mMacroblocksPerSecond = std::max(
+            load.mMacroblocksPerSecond - client.mMacroblocksPerSecond, (int64_t)0);
+    auto instances = mInstancesByName.find(client.mName);
+    if (instances != mInstancesByName.end() && --instances->second <= 0) {
+        mInstancesByName.erase(instances);
+    }
+    mClients.erase(found);
+}
+
+} // namespace android
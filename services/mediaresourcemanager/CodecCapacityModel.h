@@ -0,0 +1,106 @@
+/*
+**
+** Copyright 2026, The Android Open Source Project
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+#ifndef ANDROID_MEDIA_CODECCAPACITYMODEL_H_
+#define ANDROID_MEDIA_CODECCAPACITYMODEL_H_
+
+#include <map>
+#include <mutex>
+#include <string>
+
+#include "ResourceManagerMetrics.h"
+
+namespace android {
+
+//
+// CodecCapacityModel keeps track of the load of the started codecs, so that
+// clients can ask whether a codec is likely to be admitted before allocating it.
+//
+// The load is maintained for each CodecBucket as:
+//   - # of concurrent instances, which is also tracked by codec name.
+//   - macroblocks per second, derived from the resolution and the frame rate.
+//
+// The capacity is advertised by the codecs in their MediaCodecInfo: the largest
+// performance point (in macroblocks per second) and the max concurrent instances.
+// Clients report it in ClientConfigParcel; the model remembers it by codec name,
+// and the largest macroblock rate seen for a CodecBucket is used for codecs that
+// haven't reported any.
+//
+// The model is only a prediction: it doesn't reserve anything, and codecs that
+// aren't started through MediaCodec (or the limits of the hardware not covered by
+// the performance points) can still cause the allocation to fail.
+//
+class CodecCapacityModel {
+public:
+    // Frame rate assumed for video codecs configured without one.
+    static constexpr int32_t kDefaultFrameRate = 30;
+
+    CodecCapacityModel() = default;
+
+    // To be called when a client is started, stopped or released.
+    void notifyClientStarted(const ClientConfigParcel& clientConfig);
+    void notifyClientStopped(const ClientConfigParcel& clientConfig);
+    void notifyClientReleased(const ClientInfoParcel& clientInfo);
+
+    // To be called when a client's configuration has changed.
+    void notifyClientConfigChanged(const ClientConfigParcel& clientConfig);
+
+    // Returns true if a codec with the given configuration fits in the remaining
+    // capacity, or if the capacity is not known.
+    bool hasCapacity(const ClientConfigParcel& clientConfig) const;
+
+    std::string dump() const;
+
+    // Returns the macroblocks per second needed by the codec configuration.
+    static int64_t getMacroblocksPerSecond(const ClientConfigParcel& clientConfig);
+
+private:
+    CodecCapacityModel(const CodecCapacityModel&) = delete;
+    CodecCapacityModel& operator=(const CodecCapacityModel&) = delete;
+
+    struct Capacity {
+        int64_t mMacroblocksPerSecond = 0;  // 0 if unknown
+        int32_t mConcurrentInstances = 0;   // 0 if unknown, not tracked by CodecBucket
+    };
+
+    struct Load {
+        int32_t mInstances = 0;
+        int64_t mMacroblocksPerSecond = 0;
+    };
+
+    // A started client.
+    struct Client {
+        CodecBucket mBucket;
+        std::string mName;
+        int64_t mMacroblocksPerSecond;
+    };
+
+    void learnCapacity_l(CodecBucket bucket, const ClientConfigParcel& clientConfig);
+    void removeClient_l(int64_t clientId);
+
+    mutable std::mutex mLock;
+    // Started clients by client id.
+    std::map<int64_t, Client> mClients;
+    Load mLoad[CodecBucketMaxSize];
+    std::map<std::string, int32_t> mInstancesByName;
+    Capacity mCapacity[CodecBucketMaxSize];
+    std::map<std::string, Capacity> mCapacityByName;
+};
+
+} // namespace android
+
+#endif  // ANDROID_MEDIA_CODECCAPACITYMODEL_H_
@@ -56,9 +56,9 @@ inline const char* getCodecType(MediaResourceSubType codecType) {
     return "Unspecified";
 }
 
-static CodecBucket getCodecBucket(bool isHardware,
-                                  bool isEncoder,
-                                  MediaResourceSubType codecType) {
+CodecBucket getCodecBucket(bool isHardware,
+                           bool isEncoder,
+                           MediaResourceSubType codecType) {
     if (isHardware) {
         switch (codecType) {
             case MediaResourceSubType::kAudioCodec:
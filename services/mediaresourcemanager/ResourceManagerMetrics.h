@@ -53,6 +53,9 @@ enum CodecBucket {
     CodecBucketMaxSize = 13,
 };
 
+// Returns the CodecBucket of a codec.
+CodecBucket getCodecBucket(bool isHardware, bool isEncoder, MediaResourceSubType codecType);
+
 // Map of client id and client configuration, when it was started last.
 typedef std::map<int64_t, ClientConfigParcel> ClientConfigMap;
 
@@ -37,6 +37,7 @@
 #include <unistd.h>
 
 #include "IMediaResourceMonitor.h"
+#include "CodecCapacityModel.h"
 #include "ResourceManagerMetrics.h"
 #include "ResourceManagerService.h"
 #include "ResourceObserverService.h"
@@ -153,24 +154,16 @@ static bool hasResourceType(MediaResource::Type type, MediaResource::SubType sub
     return false;
 }
 
-static bool hasResourceType(MediaResource::Type type, MediaResource::SubType subType,
-        const ResourceList& resources) {
-    for (auto it = resources.begin(); it != resources.end(); it++) {
-        if (hasResourceType(type, subType, it->second)) {
-            return true;
-        }
-    }
-    return false;
-}
-
-static bool hasResourceType(MediaResource::Type type, MediaResource::SubType subType,
-        const ResourceInfos& infos) {
-    for (size_t i = 0; i < infos.size(); ++i) {
-        if (hasResourceType(type, subType, infos[i].resources)) {
-            return true;
-        }
+// Returns the key under which the resource is indexed, matching hasResourceType().
+static ResourceIndexKey getResourceIndexKey(MediaResource::Type type,
+        MediaResource::SubType subType) {
+    switch (type) {
+        case MediaResource::Type::kSecureCodec:
+        case MediaResource::Type::kNonSecureCodec:
+            return ResourceIndexKey(type, subType);
+        default:
+            return ResourceIndexKey(type, MediaResource::SubType::kUnspecifiedSubType);
     }
-    return false;
 }
 
 static ResourceInfos& getResourceInfosForEdit(int pid, PidResourceInfosMap& map) {
@@ -305,6 +298,8 @@ binder_status_t ResourceManagerService::dump(int fd, const char** /*args*/, uint
             it->first, it->second);
         result.append(buffer);
     }
+    result.append("  Codec capacity:\n");
+    result.append(mCodecCapacityModel->dump().c_str());
     result.append("  Events logs (most recent at top):\n");
     result.append(serviceLog);
 
@@ -351,6 +346,7 @@ ResourceManagerService::ResourceManagerService(const sp<ProcessInfoInterface> &p
     mSystemCB->noteResetVideo();
     // Create ResourceManagerMetrics that handles all the metrics.
     mResourceManagerMetrics = std::make_unique<ResourceManagerMetrics>(mProcessInfo);
+    mCodecCapacityModel = std::make_unique<CodecCapacityModel>();
 }
 
 //static
@@ -461,54 +457,58 @@ Status ResourceManagerService::addResource(const ClientInfoParcel& clientInfo,
             pid, uid, (long long) clientId, getString(resources).string());
     mServiceLog->add(log);
 
-    Mutex::Autolock lock(mLock);
-    if (!mProcessInfo->isPidUidTrusted(pid, uid)) {
-        pid_t callingPid = IPCThreadState::self()->getCallingPid();
-        uid_t callingUid = IPCThreadState::self()->getCallingUid();
-        ALOGW("%s called with untrusted pid %d or uid %d, using calling pid %d, uid %d",
-                __FUNCTION__, pid, uid, callingPid, callingUid);
-        pid = callingPid;
-        uid = callingUid;
-    }
-    ResourceInfos& infos = getResourceInfosForEdit(pid, mMap);
-    ResourceInfo& info = getResourceInfoForEdit(uid, clientId, name, client, infos);
-    ResourceList resourceAdded;
+    {
+        Mutex::Autolock lock(mLock);
+        if (!mProcessInfo->isPidUidTrusted(pid, uid)) {
+            pid_t callingPid = IPCThreadState::self()->getCallingPid();
+            uid_t callingUid = IPCThreadState::self()->getCallingUid();
+            ALOGW("%s called with untrusted pid %d or uid %d, using calling pid %d, uid %d",
+                    __FUNCTION__, pid, uid, callingPid, callingUid);
+            pid = callingPid;
+            uid = callingUid;
+        }
+        ResourceInfos& infos = getResourceInfosForEdit(pid, mMap);
+        ResourceInfo& info = getResourceInfoForEdit(uid, clientId, name, client, infos);
+        ResourceList resourceAdded;
 
-    for (size_t i = 0; i < resources.size(); ++i) {
-        const auto &res = resources[i];
-        const auto resType = std::tuple(res.type, res.subType, res.id);
+        for (size_t i = 0; i < resources.size(); ++i) {
+            const auto &res = resources[i];
+            const auto resType = std::tuple(res.type, res.subType, res.id);
 
-        if (res.value < 0 && res.type != MediaResource::Type::kDrmSession) {
-            ALOGW("Ignoring request to remove negative value of non-drm resource");
-            continue;
-        }
-        if (info.resources.find(resType) == info.resources.end()) {
-            if (res.value <= 0) {
-                // We can't init a new entry with negative value, although it's allowed
-                // to merge in negative values after the initial add.
-                ALOGW("Ignoring request to add new resource entry with value <= 0");
+            if (res.value < 0 && res.type != MediaResource::Type::kDrmSession) {
+                ALOGW("Ignoring request to remove negative value of non-drm resource");
                 continue;
             }
-            onFirstAdded(res, info);
-            info.resources[resType] = res;
-        } else {
-            mergeResources(info.resources[resType], res);
+            if (info.resources.find(resType) == info.resources.end()) {
+                if (res.value <= 0) {
+                    // We can't init a new entry with negative value, although it's allowed
+                    // to merge in negative values after the initial add.
+                    ALOGW("Ignoring request to add new resource entry with value <= 0");
+                    continue;
+                }
+                onFirstAdded(res, info);
+                info.resources[resType] = res;
+                addToResourceIndex_l(pid, info.clientId, res);
+            } else {
+                mergeResources(info.resources[resType], res);
+            }
+            // Add it to the list of added resources for observers.
+            auto it = resourceAdded.find(resType);
+            if (it == resourceAdded.end()) {
+                resourceAdded[resType] = res;
+            } else {
+                mergeResources(it->second, res);
+            }
         }
-        // Add it to the list of added resources for observers.
-        auto it = resourceAdded.find(resType);
-        if (it == resourceAdded.end()) {
-            resourceAdded[resType] = res;
-        } else {
-            mergeResources(it->second, res);
+        if (info.cookie == 0 && client != nullptr) {
+            info.cookie = addCookieAndLink_l(client,
+                    new DeathNotifier(ref<ResourceManagerService>(), clientInfo));
+        }
+        if (mObserverService != nullptr && !resourceAdded.empty()) {
+            mObserverService->onResourceAdded(uid, pid, resourceAdded);
         }
     }
-    if (info.cookie == 0 && client != nullptr) {
-        info.cookie = addCookieAndLink_l(client,
-                new DeathNotifier(ref<ResourceManagerService>(), clientInfo));
-    }
-    if (mObserverService != nullptr && !resourceAdded.empty()) {
-        mObserverService->onResourceAdded(uid, pid, resourceAdded);
-    }
+    // The resource monitor is a binder call, don't hold mLock across it.
     notifyResourceGranted(pid, resources);
 
     return Status::ok();
@@ -563,6 +563,7 @@ Status ResourceManagerService::removeResource(const ClientInfoParcel& clientInfo
                 onLastRemoved(res, info);
                 actualRemoved.value = resource.value;
                 info.resources.erase(resType);
+                removeFromResourceIndex_l(pid, clientId, res);
             }
 
             // Add it to the list of removed resources for observers.
@@ -620,6 +621,7 @@ Status ResourceManagerService::removeResource(const ClientInfoParcel& clientInfo
 
     // Since this client has been removed, update the metrics collector.
     mResourceManagerMetrics->notifyClientReleased(clientInfo);
+    mCodecCapacityModel->notifyClientReleased(clientInfo);
 
     removeCookieAndUnlink_l(info.client, info.cookie);
 
@@ -627,6 +629,7 @@ Status ResourceManagerService::removeResource(const ClientInfoParcel& clientInfo
         mObserverService->onResourceRemoved(info.uid, pid, info.resources);
     }
 
+    removeClientFromResourceIndex_l(pid, info);
     infos.removeItemsAt(index);
     return Status::ok();
 }
@@ -796,6 +799,7 @@ bool ResourceManagerService::reclaimUnconditionallyFrom(
             ResourceInfos &infos = mMap.editValueAt(i);
             for (size_t j = 0; j < infos.size();) {
                 if (infos[j].client == failedClient) {
+                    removeClientFromResourceIndex_l(mMap.keyAt(i), infos[j]);
                     j = infos.removeItemsAt(j);
                     found = true;
                 } else {
@@ -1028,6 +1032,49 @@ bool ResourceManagerService::getPriority_l(int pid, int* priority) {
     return mProcessInfo->getPriority(newPid, priority);
 }
 
+void ResourceManagerService::addToResourceIndex_l(int pid, int64_t clientId,
+        const MediaResourceParcel& res) {
+    ++mResourceIndex[getResourceIndexKey(res.type, res.subType)][pid][clientId];
+}
+
+void ResourceManagerService::removeFromResourceIndex_l(int pid, int64_t clientId,
+        const MediaResourceParcel& res) {
+    auto typeIt = mResourceIndex.find(getResourceIndexKey(res.type, res.subType));
+    if (typeIt == mResourceIndex.end()) {
+        return;
+    }
+    auto pidIt = typeIt->second.find(pid);
+    if (pidIt == typeIt->second.end()) {
+        return;
+    }
+    auto clientIt = pidIt->second.find(clientId);
+    if (clientIt == pidIt->second.end()) {
+        return;
+    }
+    if (--clientIt->second > 0) {
+        return;
+    }
+    pidIt->second.erase(clientIt);
+    if (pidIt->second.empty()) {
+        typeIt->second.erase(pidIt);
+        if (typeIt->second.empty()) {
+            mResourceIndex.erase(typeIt);
+        }
+    }
+}
+
+void ResourceManagerService::removeClientFromResourceIndex_l(int pid, const ResourceInfo& info) {
+    for (auto it = info.resources.begin(); it != info.resources.end(); it++) {
+        removeFromResourceIndex_l(pid, info.clientId, it->second);
+    }
+}
+
+const ResourceHolders* ResourceManagerService::getResourceHolders_l(MediaResource::Type type,
+        MediaResource::SubType subType) const {
+    auto it = mResourceIndex.find(getResourceIndexKey(type, subType));
+    return it == mResourceIndex.end() ? nullptr : &it->second;
+}
+
 bool ResourceManagerService::getAllClients_l(int callingPid, MediaResource::Type type,
         MediaResource::SubType subType,
         PidUidVector* idVector,
@@ -1035,19 +1082,21 @@ bool ResourceManagerService::getAllClients_l(int callingPid, MediaResource::Type
     Vector<std::shared_ptr<IResourceManagerClient>> temp;
     PidUidVector tempIdList;
 
-    for (size_t i = 0; i < mMap.size(); ++i) {
-        ResourceInfos &infos = mMap.editValueAt(i);
-        for (size_t j = 0; j < infos.size(); ++j) {
-            if (hasResourceType(type, subType, infos[j].resources)) {
-                if (!isCallingPriorityHigher_l(callingPid, mMap.keyAt(i))) {
-                    // some higher/equal priority process owns the resource,
-                    // this request can't be fulfilled.
-                    ALOGE("getAllClients_l: can't reclaim resource %s from pid %d",
-                            asString(type), mMap.keyAt(i));
-                    return false;
-                }
-                temp.push_back(infos[j].client);
-                tempIdList.emplace_back(mMap.keyAt(i), infos[j].uid);
+    const ResourceHolders* holders = getResourceHolders_l(type, subType);
+    if (holders != nullptr) {
+        for (const auto& [pid, clientIds] : *holders) {
+            if (!isCallingPriorityHigher_l(callingPid, pid)) {
+                // some higher/equal priority process owns the resource,
+                // this request can't be fulfilled.
+                ALOGE("getAllClients_l: can't reclaim resource %s from pid %d",
+                        asString(type), pid);
+                return false;
+            }
+            const ResourceInfos &infos = mMap.valueFor(pid);
+            for (const auto& [clientId, count] : clientIds) {
+                const ResourceInfo &info = infos.valueFor(clientId);
+                temp.push_back(info.client);
+                tempIdList.emplace_back(pid, info.uid);
             }
         }
     }
@@ -1102,16 +1151,12 @@ bool ResourceManagerService::getLowestPriorityPid_l(MediaResource::Type type,
         MediaResource::SubType subType, int *lowestPriorityPid, int *lowestPriority) {
     int pid = -1;
     int priority = -1;
-    for (size_t i = 0; i < mMap.size(); ++i) {
-        if (mMap.valueAt(i).size() == 0) {
-            // no client on this process.
-            continue;
-        }
-        if (!hasResourceType(type, subType, mMap.valueAt(i))) {
-            // doesn't have the requested resource type
-            continue;
-        }
-        int tempPid = mMap.keyAt(i);
+    const ResourceHolders* holders = getResourceHolders_l(type, subType);
+    if (holders == nullptr) {
+        // no process has the requested resource type
+        return false;
+    }
+    for (const auto& [tempPid, clientIds] : *holders) {
         int tempPriority;
         if (!getPriority_l(tempPid, &tempPriority)) {
             ALOGV("getLowestPriorityPid_l: can't get priority of pid %d, skipped", tempPid);
@@ -1165,18 +1210,22 @@ bool ResourceManagerService::getBiggestClient_l(int pid, MediaResource::Type typ
     std::shared_ptr<IResourceManagerClient> clientTemp;
     uint64_t largestValue = 0;
     const ResourceInfos &infos = mMap.valueAt(index);
-    for (size_t i = 0; i < infos.size(); ++i) {
-        const ResourceList &resources = infos[i].resources;
-        if (pendingRemovalOnly && !infos[i].pendingRemoval) {
-            continue;
-        }
-        for (auto it = resources.begin(); it != resources.end(); it++) {
-            const MediaResourceParcel &resource = it->second;
-            if (hasResourceType(type, subType, resource)) {
-                if (resource.value > largestValue) {
-                    largestValue = resource.value;
-                    clientTemp = infos[i].client;
-                    uid = infos[i].uid;
+    const ResourceHolders* holders = getResourceHolders_l(type, subType);
+    if (holders != nullptr && holders->count(pid) > 0) {
+        // Only visit the clients of this process that hold the resource type.
+        for (const auto& [clientId, count] : holders->at(pid)) {
+            const ResourceInfo &info = infos.valueFor(clientId);
+            if (pendingRemovalOnly && !info.pendingRemoval) {
+                continue;
+            }
+            for (auto it = info.resources.begin(); it != info.resources.end(); it++) {
+                const MediaResourceParcel &resource = it->second;
+                if (hasResourceType(type, subType, resource)) {
+                    if (resource.value > largestValue) {
+                        largestValue = resource.value;
+                        clientTemp = info.client;
+                        uid = info.uid;
+                    }
                 }
             }
         }
@@ -1200,16 +1249,25 @@ Status ResourceManagerService::notifyClientCreated(const ClientInfoParcel& clien
 
 Status ResourceManagerService::notifyClientStarted(const ClientConfigParcel& clientConfig) {
     mResourceManagerMetrics->notifyClientStarted(clientConfig);
+    mCodecCapacityModel->notifyClientStarted(clientConfig);
     return Status::ok();
 }
 
 Status ResourceManagerService::notifyClientStopped(const ClientConfigParcel& clientConfig) {
     mResourceManagerMetrics->notifyClientStopped(clientConfig);
+    mCodecCapacityModel->notifyClientStopped(clientConfig);
     return Status::ok();
 }
 
 Status ResourceManagerService::notifyClientConfigChanged(const ClientConfigParcel& clientConfig) {
     mResourceManagerMetrics->notifyClientConfigChanged(clientConfig);
+    mCodecCapacityModel->notifyClientConfigChanged(clientConfig);
+    return Status::ok();
+}
+
+Status ResourceManagerService::hasCodecCapacity(const ClientConfigParcel& clientConfig,
+        bool* _aidl_return) {
+    *_aidl_return = mCodecCapacityModel->hasCapacity(clientConfig);
     return Status::ok();
 }
 
@@ -34,6 +34,7 @@
 
 namespace android {
 
+class CodecCapacityModel;
 class DeathNotifier;
 class ResourceManagerService;
 class ResourceObserverService;
@@ -70,6 +71,12 @@ typedef std::vector<std::pair<int32_t, uid_t>> PidUidVector;
 typedef KeyedVector<int64_t, ResourceInfo> ResourceInfos;
 typedef KeyedVector<int, ResourceInfos> PidResourceInfosMap;
 
+// Resource type and subtype as matched during reclaim. Codec resources are
+// segregated by subtype, other resources use kUnspecifiedSubType.
+typedef std::pair<MediaResource::Type, MediaResource::SubType> ResourceIndexKey;
+// pid -> clientId -> number of resource entries of the indexed type held by the client.
+typedef std::map<int, std::map<int64_t, int>> ResourceHolders;
+
 class ResourceManagerService : public BnResourceManagerService {
 public:
     struct SystemCallbackInterface : public RefBase {
@@ -129,9 +136,12 @@ public:
 
     Status notifyClientConfigChanged(const ClientConfigParcel& clientConfig) override;
 
+    Status hasCodecCapacity(const ClientConfigParcel& clientConfig, bool* _aidl_return) override;
+
 private:
     friend class ResourceManagerServiceTest;
-    friend class DeathNotifier;
+    friend class CodecCapacityModel;
+class DeathNotifier;
     friend class OverrideProcessInfoDeathNotifier;
 
     // Reclaims resources from |clients|. Returns true if reclaim succeeded
@@ -185,6 +195,16 @@ private:
     // Get priority from process's pid
     bool getPriority_l(int pid, int* priority);
 
+    // Maintain mResourceIndex as resource entries are added to or removed from a client.
+    void addToResourceIndex_l(int pid, int64_t clientId, const MediaResourceParcel& res);
+    void removeFromResourceIndex_l(int pid, int64_t clientId, const MediaResourceParcel& res);
+    void removeClientFromResourceIndex_l(int pid, const ResourceInfo& info);
+
+    // Returns the processes and clients holding the specified resource type,
+    // or nullptr if there are none.
+    const ResourceHolders* getResourceHolders_l(MediaResource::Type type,
+            MediaResource::SubType subType) const;
+
     void removeProcessInfoOverride(int pid);
 
     void removeProcessInfoOverride_l(int pid);
@@ -207,6 +227,8 @@ private:
     sp<SystemCallbackInterface> mSystemCB;
     sp<ServiceLog> mServiceLog;
     PidResourceInfosMap mMap;
+    // Index of mMap by resource type, so reclaim only visits the holders of a type.
+    std::map<ResourceIndexKey, ResourceHolders> mResourceIndex;
     bool mSupportsMultipleSecureCodecs;
     bool mSupportsSecureWithNonSecureCodec;
     int32_t mCpuBoostCount;
@@ -223,6 +245,7 @@ private:
             GUARDED_BY(sCookieLock);
     std::shared_ptr<ResourceObserverService> mObserverService;
     std::unique_ptr<ResourceManagerMetrics> mResourceManagerMetrics;
+    std::unique_ptr<CodecCapacityModel> mCodecCapacityModel;
 };
 
 // ----------------------------------------------------------------------------
@@ -799,6 +799,59 @@ public:
         EXPECT_EQ(priority2, priority);
     }
 
+    void testResourceIndexUpdatedOnRemoval() {
+        int pid;
+        int priority;
+        MediaResource::Type type = MediaResource::Type::kGraphicMemory;
+        MediaResource::SubType subType = MediaResource::SubType::kUnspecifiedSubType;
+
+        addResource();
+
+        // kTestPid1 has the lowest priority among the holders of graphic memory.
+        EXPECT_TRUE(mService->getLowestPriorityPid_l(type, subType, &pid, &priority));
+        EXPECT_EQ(kTestPid1, pid);
+
+        // Once mTestClient1 no longer holds graphic memory, kTestPid1 isn't a candidate.
+        ClientInfoParcel client1Info{.pid = static_cast<int32_t>(kTestPid1),
+                                     .uid = static_cast<int32_t>(kTestUid1),
+                                     .id = getId(mTestClient1),
+                                     .name = "none"};
+        std::vector<MediaResourceParcel> resources1;
+        resources1.push_back(MediaResource(type, 1000));
+        mService->removeResource(client1Info, resources1);
+        EXPECT_TRUE(mService->getLowestPriorityPid_l(type, subType, &pid, &priority));
+        EXPECT_EQ(kTestPid2, pid);
+
+        // mTestClient2 held the only non-secure codec.
+        ClientInfoParcel client2Info{.pid = static_cast<int32_t>(kTestPid2),
+                                     .uid = static_cast<int32_t>(kTestUid2),
+                                     .id = getId(mTestClient2),
+                                     .name = "none"};
+        mService->removeClient(client2Info);
+        std::shared_ptr<IResourceManagerClient> client;
+        uid_t uid = 0;
+        EXPECT_FALSE(mService->getBiggestClient_l(kTestPid2, MediaResource::Type::kNonSecureCodec,
+                subType, uid, &client));
+        Vector<std::shared_ptr<IResourceManagerClient> > clients;
+        PidUidVector idList;
+        EXPECT_TRUE(mService->getAllClients_l(kHighPriorityPid,
+                MediaResource::Type::kSecureCodec, subType, &idList, &clients));
+        EXPECT_EQ(2u, clients.size());
+
+        ClientInfoParcel client3Info{.pid = static_cast<int32_t>(kTestPid2),
+                                     .uid = static_cast<int32_t>(kTestUid2),
+                                     .id = getId(mTestClient3),
+                                     .name = "none"};
+        mService->removeClient(client3Info);
+        EXPECT_FALSE(mService->getLowestPriorityPid_l(type, subType, &pid, &priority));
+        clients.clear();
+        idList.clear();
+        EXPECT_TRUE(mService->getAllClients_l(kHighPriorityPid,
+                MediaResource::Type::kSecureCodec, subType, &idList, &clients));
+        ASSERT_EQ(1u, clients.size());
+        EXPECT_EQ(mTestClient1, clients[0]);
+    }
+
     void testIsCallingPriorityHigher() {
         EXPECT_FALSE(mService->isCallingPriorityHigher_l(101, 100));
         EXPECT_FALSE(mService->isCallingPriorityHigher_l(100, 100));
@@ -1504,6 +1557,84 @@ public:
              client3Config.width * client3Config.height));
         EXPECT_TRUE(currentPixelCountP2 == 0);
     }
+
+    void testCodecCapacity() {
+        std::shared_ptr<IResourceManagerClient> testClient4 =
+            createTestClient(kTestPid1, kTestUid1);
+        ClientInfoParcel client1Info{.pid = static_cast<int32_t>(kTestPid1),
+                                     .uid = static_cast<int32_t>(kTestUid1),
+                                     .id = getId(mTestClient1),
+                                     .name = "c2.hw.avc.decoder"};
+        ClientInfoParcel client2Info{.pid = static_cast<int32_t>(kTestPid2),
+                                     .uid = static_cast<int32_t>(kTestUid2),
+                                     .id = getId(mTestClient2),
+                                     .name = "c2.hw.avc.decoder"};
+        ClientInfoParcel client3Info{.pid = static_cast<int32_t>(kTestPid2),
+                                     .uid = static_cast<int32_t>(kTestUid2),
+                                     .id = getId(mTestClient3),
+                                     .name = "c2.hw.avc.decoder"};
+        ClientInfoParcel client4Info{.pid = static_cast<int32_t>(kTestPid1),
+                                     .uid = static_cast<int32_t>(kTestUid1),
+                                     .id = getId(testClient4),
+                                     .name = "c2.hw.hevc.decoder"};
+        ClientConfigParcel client1Config;
+        ClientConfigParcel client2Config;
+        ClientConfigParcel client3Config;
+        ClientConfigParcel client4Config;
+        initClientConfigParcel(false, true, 1920, 1080, 11111111, client1Info, client1Config);
+        initClientConfigParcel(false, true, 1920, 1080, 22222222, client2Info, client2Config);
+        initClientConfigParcel(false, true, 1280, 720, 33333333, client3Info, client3Config);
+        initClientConfigParcel(false, true, 3840, 2160, 44444444, client4Info, client4Config);
+        client2Config.frameRate = 60;
+
+        bool hasCapacity = false;
+        // Nothing is known about the capacity yet.
+        EXPECT_TRUE(mService->hasCodecCapacity(client4Config, &hasCapacity).isOk());
+        EXPECT_TRUE(hasCapacity);
+
+        // The avc decoder advertises 4K@30 (972000 macroblocks/s) and 3 instances.
+        client1Config.maxMacroblocksPerSecond = 240 * 135 * 30;
+        client1Config.maxConcurrentInstances = 3;
+        // 1080P@30 is 244800 macroblocks/s.
+        mService->notifyClientStarted(client1Config);
+
+        // 4K@30 no longer fits, using the capacity learned for the bucket.
+        mService->hasCodecCapacity(client4Config, &hasCapacity);
+        EXPECT_FALSE(hasCapacity);
+        // 1080P@60 fits.
+        mService->hasCodecCapacity(client2Config, &hasCapacity);
+        EXPECT_TRUE(hasCapacity);
+
+        mService->notifyClientStarted(client2Config);
+        // 244800 + 489600 + 244800 exceeds 972000.
+        mService->hasCodecCapacity(client1Config, &hasCapacity);
+        EXPECT_FALSE(hasCapacity);
+
+        // client2 changes to 720P@60 (216000 macroblocks/s).
+        client2Config.width = 1280;
+        client2Config.height = 720;
+        mService->notifyClientConfigChanged(client2Config);
+        mService->hasCodecCapacity(client3Config, &hasCapacity);
+        EXPECT_TRUE(hasCapacity);
+
+        // The avc decoder is limited to 3 instances, even if the load allows more.
+        mService->notifyClientStarted(client3Config);
+        ClientConfigParcel smallConfig;
+        initClientConfigParcel(false, true, 176, 144, 55555555, client1Info, smallConfig);
+        mService->hasCodecCapacity(smallConfig, &hasCapacity);
+        EXPECT_FALSE(hasCapacity);
+        // But the hevc decoder has no known instance limit.
+        initClientConfigParcel(false, true, 176, 144, 55555555, client4Info, smallConfig);
+        mService->hasCodecCapacity(smallConfig, &hasCapacity);
+        EXPECT_TRUE(hasCapacity);
+
+        // Once all clients stop, 4K@30 fits again.
+        mService->notifyClientStopped(client1Config);
+        mService->notifyClientStopped(client2Config);
+        mService->notifyClientStopped(client3Config);
+        mService->hasCodecCapacity(client4Config, &hasCapacity);
+        EXPECT_TRUE(hasCapacity);
+    }
 };
 
 TEST_F(ResourceManagerServiceTest, config) {
@@ -1547,6 +1678,10 @@ TEST_F(ResourceManagerServiceTest, getLowestPriorityPid_l) {
     testGetLowestPriorityPid();
 }
 
+TEST_F(ResourceManagerServiceTest, resourceIndexUpdatedOnRemoval) {
+    testResourceIndexUpdatedOnRemoval();
+}
+
 TEST_F(ResourceManagerServiceTest, isCallingPriorityHigher_l) {
     testIsCallingPriorityHigher();
 }
@@ -1592,4 +1727,8 @@ TEST_F(ResourceManagerServiceTest, concurrentCodecs) {
     testConcurrentCodecs();
 }
 
+TEST_F(ResourceManagerServiceTest, codecCapacity) {
+    testCodecCapacity();
+}
+
 } // namespace android
@@ -20,6 +20,7 @@
 
 #define ATRACE_TAG ATRACE_TAG_AUDIO
 
+#include <algorithm>
 #include <cstring>
 #include <utils/Trace.h>
 
@@ -29,6 +30,66 @@
 #define AAUDIO_MIXER_ATRACE_ENABLED    1
 #endif
 
+// To disable the SIMD accumulate for benchmarking, compile with -DUSE_NEON=false (arm)
+// or -DUSE_SSE=false (x86).
+#if (defined(__aarch64__) || defined(__ARM_NEON__)) && !(defined(USE_NEON) && !USE_NEON)
+#define AAUDIO_MIXER_USE_NEON 1
+#include <arm_neon.h>
+#else
+#define AAUDIO_MIXER_USE_NEON 0
+#endif
+
+#if defined(__SSE2__) && !(defined(USE_SSE) && !USE_SSE)
+#define AAUDIO_MIXER_USE_SSE 1
+#include <immintrin.h>
+#else
+#define AAUDIO_MIXER_USE_SSE 0
+#endif
+
+namespace {
+
+// destination[i] += source[i] * volume, or destination[i] += source[i] if !SCALE.
+// Multiply and add are kept separate (no fused multiply-add) to match the scalar loop.
+template <bool SCALE>
+void accumulateSamples(float *destination, const float *source, int32_t numSamples,
+                       float volume) {
+    int32_t i = 0;
+#if AAUDIO_MIXER_USE_NEON
+    const float32x4_t gain = vdupq_n_f32(volume);
+    for (; i + 8 <= numSamples; i += 8) {
+        float32x4_t s0 = vld1q_f32(source + i);
+        float32x4_t s1 = vld1q_f32(source + i + 4);
+        if constexpr (SCALE) {
+            s0 = vmulq_f32(s0, gain);
+            s1 = vmulq_f32(s1, gain);
+        }
+        vst1q_f32(destination + i, vaddq_f32(vld1q_f32(destination + i), s0));
+        vst1q_f32(destination + i + 4, vaddq_f32(vld1q_f32(destination + i + 4), s1));
+    }
+#elif AAUDIO_MIXER_USE_SSE
+    const __m128 gain = _mm_set1_ps(volume);
+    for (; i + 8 <= numSamples; i += 8) {
+        __m128 s0 = _mm_loadu_ps(source + i);
+        __m128 s1 = _mm_loadu_ps(source + i + 4);
+        if constexpr (SCALE) {
+            s0 = _mm_mul_ps(s0, gain);
+            s1 = _mm_mul_ps(s1, gain);
+        }
+        _mm_storeu_ps(destination + i, _mm_add_ps(_mm_loadu_ps(destination + i), s0));
+        _mm_storeu_ps(destination + i + 4, _mm_add_ps(_mm_loadu_ps(destination + i + 4), s1));
+    }
+#endif
+    for (; i < numSamples; i++) {
+        if constexpr (SCALE) {
+            destination[i] += source[i] * volume;
+        } else {
+            destination[i] += source[i];
+        }
+    }
+}
+
+} // namespace
+
 using android::WrappingBuffer;
 using android::FifoBuffer;
 using android::fifo_frames_t;
@@ -45,8 +106,8 @@ void AAudioMixer::clear() {
     memset(mOutputBuffer.get(), 0, mBufferSizeInBytes);
 }
 
-int32_t AAudioMixer::mix(
-        int streamIndex, const std::shared_ptr<FifoBuffer>& fifo, bool allowUnderflow) {
+int32_t AAudioMixer::mix(int streamIndex, const std::shared_ptr<FifoBuffer>& fifo,
+                         bool allowUnderflow, float volume) {
     WrappingBuffer wrappingBuffer;
     float *destination = mOutputBuffer.get();
 
@@ -88,8 +149,8 @@ int32_t AAudioMixer::mix(
             if (framesToMixFromPart > framesAvailableFromPart) {
                 framesToMixFromPart = framesAvailableFromPart;
             }
-            mixPart(destination, (float *)wrappingBuffer.data[partIndex],
-                    framesToMixFromPart);
+            mixPart(destination, (const float *)wrappingBuffer.data[partIndex],
+                    framesToMixFromPart, volume);
 
             destination += framesToMixFromPart * mSamplesPerFrame;
             framesLeft -= framesToMixFromPart;
@@ -105,14 +166,23 @@ int32_t AAudioMixer::mix(
     return (framesDesired - framesLeft); // framesRead
 }
 
-void AAudioMixer::mixPart(float *destination, float *source, int32_t numFrames) {
-    int32_t numSamples = numFrames * mSamplesPerFrame;
-    // TODO maybe optimize using SIMD
-    for (int sampleIndex = 0; sampleIndex < numSamples; sampleIndex++) {
-        *destination++ += *source++;
+void AAudioMixer::mixPart(float *destination, const float *source, int32_t numFrames,
+                          float volume) {
+    const int32_t numSamples = numFrames * mSamplesPerFrame;
+    if (volume == 1.0f) {
+        accumulateSamples<false /* SCALE */>(destination, source, numSamples, volume);
+    } else if (volume != 0.0f) {
+        accumulateSamples<true /* SCALE */>(destination, source, numSamples, volume);
     }
 }
 
+void AAudioMixer::accumulate(const AAudioMixer &other) {
+    accumulateSamples<false /* SCALE */>(mOutputBuffer.get(), other.mOutputBuffer.get(),
+            std::min(mSamplesPerFrame * mFramesPerBurst,
+                     other.mSamplesPerFrame * other.mFramesPerBurst),
+            1.0f /* volume */);
+}
+
 float *AAudioMixer::getOutputBuffer() {
     return mOutputBuffer.get();
 }
@@ -35,18 +35,26 @@ public:
      * @param streamIndex for marking stream variables in systrace
      * @param fifo to read from
      * @param allowUnderflow if true then allow mixer to advance read index past the write index
+     * @param volume linear gain applied to this stream before it is added to the mix
      * @return frames read from this stream
      */
     int32_t mix(int streamIndex,
                 const std::shared_ptr<android::FifoBuffer>& fifo,
-                bool allowUnderflow);
+                bool allowUnderflow,
+                float volume = 1.0f);
+
+    /**
+     * Add the output of another mixer with the same configuration to this mix.
+     * This is used to combine partial mixes computed on other threads.
+     */
+    void accumulate(const AAudioMixer &other);
 
     float *getOutputBuffer();
 
     int32_t getFramesPerBurst() const { return mFramesPerBurst; }
 
 private:
-    void mixPart(float *destination, float *source, int32_t numFrames);
+    void mixPart(float *destination, const float *source, int32_t numFrames, float volume);
 
     std::unique_ptr<float[]> mOutputBuffer;
     int32_t  mSamplesPerFrame = 0;
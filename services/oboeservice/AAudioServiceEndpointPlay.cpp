@@ -28,9 +28,12 @@
 #include "AAudioServiceEndpoint.h"
 #include <algorithm>
 #include <mutex>
+#include <sstream>
 #include <vector>
 
 #include "core/AudioStreamBuilder.h"
+#include "utility/AAudioUtilities.h"
+#include "utility/AudioClock.h"
 #include "AAudioServiceEndpoint.h"
 #include "AAudioServiceStreamShared.h"
 #include "AAudioServiceEndpointPlay.h"
@@ -59,10 +62,89 @@ aaudio_result_t AAudioServiceEndpointPlay::open(const aaudio::AAudioStreamReques
         }
         int32_t desiredBufferSize = burstsPerBuffer * getStreamInternal()->getFramesPerBurst();
         getStreamInternal()->setBufferSize(desiredBufferSize);
+        // Grow the buffer above the default when the hardware timing causes underruns,
+        // and shrink it back when it is stable.
+        getStreamInternal()->setBufferSizeTuningEnabled(mLatencyTuningEnabled);
+
+        const int32_t helperThreads = AAudioProperty_getMixerHelperThreads();
+        if (helperThreads > 0) {
+            mHelperPool = std::make_unique<AudioMixerWorkerPool>(helperThreads);
+            mHelperMixers.resize(helperThreads);
+            for (auto& mixer : mHelperMixers) {
+                mixer.allocate(getStreamInternal()->getSamplesPerFrame(),
+                               getStreamInternal()->getFramesPerBurst());
+            }
+        }
     }
     return result;
 }
 
+std::string AAudioServiceEndpointPlay::dump() const {
+    std::stringstream result;
+    result << AAudioServiceEndpointShared::dump();
+
+    const int64_t bursts = mBurstCount.load(std::memory_order_relaxed);
+    const int64_t totalNanos = mBurstMixTotalNanos.load(std::memory_order_relaxed);
+    result << "    Mixer Bursts:         " << bursts
+           << ", mix time last(us) " << mBurstMixLastNanos.load(std::memory_order_relaxed) / 1000
+           << " mean(us) " << (bursts > 0 ? totalNanos / bursts / 1000 : 0)
+           << " max(us) " << mBurstMixMaxNanos.load(std::memory_order_relaxed) / 1000 << "\n";
+    result << "    Mixer Last Burst:     " << mBurstStreamsLast.load(std::memory_order_relaxed)
+           << " streams on " << mBurstThreadsLast.load(std::memory_order_relaxed)
+           << " threads\n";
+    if (mHelperPool != nullptr) {
+        result << "    Mixer Helper Threads: " << mHelperPool->workerCount() << "\n";
+        result << mHelperPool->toString();
+    }
+    return result.str();
+}
+
+void AAudioServiceEndpointPlay::mixStream(AAudioMixer &mixer, const MixJob &job,
+                                          int64_t mmapFramesWritten) {
+    const sp<AAudioServiceStreamShared>& streamShared = job.stream;
+    int64_t clientFramesRead = 0;
+    {
+        // Lock the AudioFifo to protect against close.
+        std::lock_guard <std::mutex> lock(streamShared->audioDataQueueLock);
+        std::shared_ptr<SharedRingBuffer> audioDataQueue
+                = streamShared->getAudioDataQueue_l();
+        std::shared_ptr<FifoBuffer> fifo;
+        if (audioDataQueue && (fifo = audioDataQueue->getFifoBuffer())) {
+
+            // Determine offset between framePosition in client's stream
+            // vs the underlying MMAP stream.
+            clientFramesRead = fifo->getReadCounter();
+            // These two indices refer to the same frame.
+            int64_t positionOffset = mmapFramesWritten - clientFramesRead;
+            streamShared->setTimestampPositionOffset(positionOffset);
+
+            int32_t framesMixed = mixer.mix(job.index, fifo, job.allowUnderflow);
+
+            if (streamShared->isFlowing()) {
+                // Consider it an underflow if we got less than a burst
+                // after the data started flowing.
+                bool underflowed = job.allowUnderflow
+                                   && framesMixed < mixer.getFramesPerBurst();
+                if (underflowed) {
+                    streamShared->incrementXRunCount();
+                }
+            } else if (framesMixed > 0) {
+                // Mark beginning of data flow after a start.
+                streamShared->setFlowing(true);
+            }
+            clientFramesRead = fifo->getReadCounter();
+        }
+    }
+
+    if (clientFramesRead > 0) {
+        // This timestamp represents the completion of data being read out of the
+        // client buffer. It is sent to the client and used in the timing model
+        // to decide when the client has room to write more data.
+        Timestamp timestamp(clientFramesRead, AudioClock::getNanoseconds());
+        streamShared->markTransferTime(timestamp);
+    }
+}
+
 // Mix data from each application stream and write result to the shared MMAP stream.
 void *AAudioServiceEndpointPlay::callbackLoop() {
     ALOGD("%s() entering >>>>>>>>>>>>>>> MIXER", __func__);
@@ -79,8 +161,8 @@ void *AAudioServiceEndpointPlay::callbackLoop() {
             int64_t mmapFramesWritten = getStreamInternal()->getFramesWritten();
 
             std::lock_guard <std::mutex> lock(mLockStreams);
+            const int64_t beginNanos = AudioClock::getNanoseconds();
             for (const auto& clientStream : mRegisteredStreams) {
-                int64_t clientFramesRead = 0;
                 bool allowUnderflow = true;
 
                 if (clientStream->isSuspended()) {
@@ -96,50 +178,51 @@ void *AAudioServiceEndpointPlay::callbackLoop() {
 
                 sp<AAudioServiceStreamShared> streamShared =
                         static_cast<AAudioServiceStreamShared *>(clientStream.get());
+                mMixJobs.push_back({streamShared, allowUnderflow, index});
+                index++;
+            }
 
-                {
-                    // Lock the AudioFifo to protect against close.
-                    std::lock_guard <std::mutex> lock(streamShared->audioDataQueueLock);
-                    std::shared_ptr<SharedRingBuffer> audioDataQueue
-                            = streamShared->getAudioDataQueue_l();
-                    std::shared_ptr<FifoBuffer> fifo;
-                    if (audioDataQueue && (fifo = audioDataQueue->getFifoBuffer())) {
-
-                        // Determine offset between framePosition in client's stream
-                        // vs the underlying MMAP stream.
-                        clientFramesRead = fifo->getReadCounter();
-                        // These two indices refer to the same frame.
-                        int64_t positionOffset = mmapFramesWritten - clientFramesRead;
-                        streamShared->setTimestampPositionOffset(positionOffset);
-
-                        int32_t framesMixed = mMixer.mix(index, fifo, allowUnderflow);
-
-                        if (streamShared->isFlowing()) {
-                            // Consider it an underflow if we got less than a burst
-                            // after the data started flowing.
-                            bool underflowed = allowUnderflow
-                                               && framesMixed < mMixer.getFramesPerBurst();
-                            if (underflowed) {
-                                streamShared->incrementXRunCount();
-                            }
-                        } else if (framesMixed > 0) {
-                            // Mark beginning of data flow after a start.
-                            streamShared->setFlowing(true);
-                        }
-                        clientFramesRead = fifo->getReadCounter();
+            // Divide large sets of streams across the helper threads. Each thread mixes
+            // into its own buffer, which are then added to the main mix.
+            size_t threads = 1;
+            if (mHelperPool != nullptr) {
+                threads = std::min(mHelperPool->workerCount() + 1,
+                                   mMixJobs.size() / kMinStreamsPerMixThread);
+                threads = std::max(threads, (size_t)1);
+            }
+            if (threads > 1) {
+                auto mixJobs = [this, threads, mmapFramesWritten](size_t thread) {
+                    AAudioMixer &mixer = (thread == 0) ? mMixer : mHelperMixers[thread - 1];
+                    if (thread > 0) {
+                        mixer.clear();
+                    }
+                    for (size_t i = thread; i < mMixJobs.size(); i += threads) {
+                        mixStream(mixer, mMixJobs[i], mmapFramesWritten);
                     }
+                };
+                mHelperPool->run(threads, mixJobs);
+                for (size_t thread = 1; thread < threads; thread++) {
+                    mMixer.accumulate(mHelperMixers[thread - 1]);
                 }
-
-                if (clientFramesRead > 0) {
-                    // This timestamp represents the completion of data being read out of the
-                    // client buffer. It is sent to the client and used in the timing model
-                    // to decide when the client has room to write more data.
-                    Timestamp timestamp(clientFramesRead, AudioClock::getNanoseconds());
-                    streamShared->markTransferTime(timestamp);
+            } else {
+                for (const auto& job : mMixJobs) {
+                    mixStream(mMixer, job, mmapFramesWritten);
                 }
+            }
 
-                index++; // just used for labelling tracks in systrace
+            const int64_t mixNanos = AudioClock::getNanoseconds() - beginNanos;
+            mBurstCount.store(mBurstCount.load(std::memory_order_relaxed) + 1,
+                              std::memory_order_relaxed);
+            mBurstMixLastNanos.store(mixNanos, std::memory_order_relaxed);
+            mBurstMixTotalNanos.store(
+                    mBurstMixTotalNanos.load(std::memory_order_relaxed) + mixNanos,
+                    std::memory_order_relaxed);
+            if (mixNanos > mBurstMixMaxNanos.load(std::memory_order_relaxed)) {
+                mBurstMixMaxNanos.store(mixNanos, std::memory_order_relaxed);
             }
+            mBurstStreamsLast.store((int32_t)mMixJobs.size(), std::memory_order_relaxed);
+            mBurstThreadsLast.store((int32_t)threads, std::memory_order_relaxed);
+            mMixJobs.clear(); // release the stream references
         }
 
         // Write mixer output to stream using a blocking write.
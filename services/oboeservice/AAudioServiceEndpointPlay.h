@@ -19,9 +19,13 @@
 
 #include <atomic>
 #include <functional>
+#include <memory>
 #include <mutex>
+#include <string>
 #include <vector>
 
+#include <media/AudioMixerWorkerPool.h>
+
 #include "client/AudioStreamInternal.h"
 #include "client/AudioStreamInternalPlay.h"
 #include "binding/AAudioServiceMessage.h"
@@ -44,9 +48,38 @@ public:
 
     void *callbackLoop() override;
 
+    std::string dump() const override;
+
 private:
-    bool                     mLatencyTuningEnabled = false; // TODO implement tuning
+    // A client stream to be mixed in the current burst.
+    struct MixJob {
+        android::sp<AAudioServiceStreamShared> stream;
+        bool allowUnderflow;
+        int  index;             // just used for labelling tracks in systrace
+    };
+
+    // Mix one client stream into mixer and update its timing.
+    // Called on the endpoint thread or on a helper thread, at most once per stream per burst.
+    void mixStream(AAudioMixer &mixer, const MixJob &job, int64_t mmapFramesWritten);
+
+    // Streams are only divided across helper threads when each thread gets at least this many.
+    static constexpr size_t kMinStreamsPerMixThread = 4;
+
+    bool                     mLatencyTuningEnabled = false; // tune the MMAP buffer size
     AAudioMixer              mMixer;    //
+
+    // Only used by the endpoint thread.
+    std::vector<MixJob>      mMixJobs;
+    std::unique_ptr<android::AudioMixerWorkerPool> mHelperPool; // null if no helper threads
+    std::vector<AAudioMixer> mHelperMixers;    // one per helper thread
+
+    // Per-burst mix timing, written by the endpoint thread and read by dump().
+    std::atomic<int64_t>     mBurstCount{0};
+    std::atomic<int64_t>     mBurstMixLastNanos{0};
+    std::atomic<int64_t>     mBurstMixMaxNanos{0};
+    std::atomic<int64_t>     mBurstMixTotalNanos{0};
+    std::atomic<int32_t>     mBurstStreamsLast{0};
+    std::atomic<int32_t>     mBurstThreadsLast{0};
 };
 
 } /* namespace aaudio */
@@ -19,11 +19,14 @@
 #include "TunerDvr.h"
 
 #include <aidl/android/hardware/tv/tuner/Result.h>
+#include <android-base/stringprintf.h>
 #include <utils/Log.h>
+#include <unistd.h>
 
 #include "TunerFilter.h"
 
 using ::aidl::android::hardware::tv::tuner::Result;
+using ::android::base::StringPrintf;
 
 namespace aidl {
 namespace android {
@@ -31,22 +34,79 @@ namespace media {
 namespace tv {
 namespace tuner {
 
-TunerDvr::TunerDvr(shared_ptr<IDvr> dvr, DvrType type) {
+Mutex TunerDvr::sDvrsLock;
+std::set<TunerDvr*> TunerDvr::sDvrs;
+
+TunerDvr::TunerDvr(shared_ptr<IDvr> dvr, DvrType type, shared_ptr<DvrCallback> callback) {
     mDvr = dvr;
     mType = type;
+    mCallback = callback;
+
+    Mutex::Autolock _l(sDvrsLock);
+    sDvrs.insert(this);
 }
 
 TunerDvr::~TunerDvr() {
+    {
+        Mutex::Autolock _l(sDvrsLock);
+        sDvrs.erase(this);
+    }
     close();
     mDvr = nullptr;
 }
 
+void TunerDvr::dumpAll(int fd) {
+    string result;
+    Mutex::Autolock _l(sDvrsLock);
+    result.append(StringPrintf("%zu open DVR(s)\n", sDvrs.size()));
+    for (TunerDvr* dvr : sDvrs) {
+        result.append(dvr->dump());
+    }
+    write(fd, result.c_str(), result.size());
+}
+
+string TunerDvr::dump() {
+    string result = StringPrintf("  DVR %p: %s", this,
+                                 mType == DvrType::RECORD ? "record" : "playback");
+    {
+        Mutex::Autolock _l(mLock);
+        result.append(mStarted ? " started" : " stopped");
+        if (mConfigured) {
+            if (mSettings.getTag() == DvrSettings::record) {
+                const auto& settings = mSettings.get<DvrSettings::record>();
+                result.append(StringPrintf(" packetSize %lld threshold low %d high %d",
+                                           (long long)settings.packetSize,
+                                           settings.lowThreshold, settings.highThreshold));
+            } else {
+                const auto& settings = mSettings.get<DvrSettings::playback>();
+                result.append(StringPrintf(" packetSize %lld threshold low %d high %d",
+                                           (long long)settings.packetSize,
+                                           settings.lowThreshold, settings.highThreshold));
+            }
+        }
+    }
+    if (mCallback != nullptr) {
+        result.append(mCallback->dump());
+    }
+    result.append("\n");
+    return result;
+}
+
 ::ndk::ScopedAStatus TunerDvr::getQueueDesc(AidlMQDesc* _aidl_return) {
     return mDvr->getQueueDesc(_aidl_return);
 }
 
 ::ndk::ScopedAStatus TunerDvr::configure(const DvrSettings& in_settings) {
-    return mDvr->configure(in_settings);
+    ::ndk::ScopedAStatus s = mDvr->configure(in_settings);
+    if (s.isOk()) {
+        Mutex::Autolock _l(mLock);
+        mSettings = in_settings;
+        mConfigured = true;
+    }
+    if (mCallback != nullptr) {
+        mCallback->resetStatus();
+    }
+    return s;
 }
 
 ::ndk::ScopedAStatus TunerDvr::attachFilter(const shared_ptr<ITunerFilter>& in_filter) {
@@ -80,14 +140,31 @@ TunerDvr::~TunerDvr() {
 }
 
 ::ndk::ScopedAStatus TunerDvr::start() {
-    return mDvr->start();
+    if (mCallback != nullptr) {
+        mCallback->resetStatus();
+    }
+    ::ndk::ScopedAStatus s = mDvr->start();
+    if (s.isOk()) {
+        Mutex::Autolock _l(mLock);
+        mStarted = true;
+    }
+    return s;
 }
 
 ::ndk::ScopedAStatus TunerDvr::stop() {
-    return mDvr->stop();
+    ::ndk::ScopedAStatus s = mDvr->stop();
+    if (s.isOk()) {
+        Mutex::Autolock _l(mLock);
+        mStarted = false;
+    }
+    return s;
 }
 
 ::ndk::ScopedAStatus TunerDvr::flush() {
+    // The buffer is emptied, so the next status is a change even if it is the same as before.
+    if (mCallback != nullptr) {
+        mCallback->resetStatus();
+    }
     return mDvr->flush();
 }
 
@@ -112,19 +189,41 @@ TunerDvr::~TunerDvr() {
 
 /////////////// IDvrCallback ///////////////////////
 ::ndk::ScopedAStatus TunerDvr::DvrCallback::onRecordStatus(const RecordStatus status) {
-    if (mTunerDvrCallback != nullptr) {
+    if (mTunerDvrCallback != nullptr && onStatus(static_cast<int32_t>(status))) {
         mTunerDvrCallback->onRecordStatus(status);
     }
     return ndk::ScopedAStatus::ok();
 }
 
 ::ndk::ScopedAStatus TunerDvr::DvrCallback::onPlaybackStatus(const PlaybackStatus status) {
-    if (mTunerDvrCallback != nullptr) {
+    if (mTunerDvrCallback != nullptr && onStatus(static_cast<int32_t>(status))) {
         mTunerDvrCallback->onPlaybackStatus(status);
     }
     return ndk::ScopedAStatus::ok();
 }
 
+bool TunerDvr::DvrCallback::onStatus(int32_t status) {
+    Mutex::Autolock _l(mLock);
+    ++mReceivedCount;
+    if (status == mLastStatus) {
+        return false;
+    }
+    mLastStatus = status;
+    ++mForwardedCount;
+    return true;
+}
+
+void TunerDvr::DvrCallback::resetStatus() {
+    Mutex::Autolock _l(mLock);
+    mLastStatus = -1;
+}
+
+string TunerDvr::DvrCallback::dump() {
+    Mutex::Autolock _l(mLock);
+    return StringPrintf(" status callbacks received %lld forwarded %lld last %d",
+                        (long long)mReceivedCount, (long long)mForwardedCount, mLastStatus);
+}
+
 }  // namespace tuner
 }  // namespace tv
 }  // namespace media
@@ -25,6 +25,10 @@
 #include <aidl/android/hardware/tv/tuner/RecordStatus.h>
 #include <aidl/android/media/tv/tuner/BnTunerDvr.h>
 #include <aidl/android/media/tv/tuner/ITunerDvrCallback.h>
+#include <utils/Mutex.h>
+
+#include <set>
+#include <string>
 
 #include "TunerFilter.h"
 
@@ -36,6 +40,7 @@ using ::aidl::android::hardware::tv::tuner::DvrType;
 using ::aidl::android::hardware::tv::tuner::IDvr;
 using ::aidl::android::hardware::tv::tuner::PlaybackStatus;
 using ::aidl::android::hardware::tv::tuner::RecordStatus;
+using ::android::Mutex;
 
 using namespace std;
 
@@ -50,9 +55,14 @@ using AidlMQDesc = MQDescriptor<int8_t, SynchronizedReadWrite>;
 class TunerDvr : public BnTunerDvr {
 
 public:
-    TunerDvr(shared_ptr<IDvr> dvr, DvrType type);
+    struct DvrCallback;
+
+    TunerDvr(shared_ptr<IDvr> dvr, DvrType type, shared_ptr<DvrCallback> callback);
     ~TunerDvr();
 
+    // Writes the state and status statistics of all open DVRs, for dumpsys.
+    static void dumpAll(int fd);
+
     ::ndk::ScopedAStatus getQueueDesc(AidlMQDesc* _aidl_return) override;
     ::ndk::ScopedAStatus configure(const DvrSettings& in_settings) override;
     ::ndk::ScopedAStatus attachFilter(const shared_ptr<ITunerFilter>& in_filter) override;
@@ -63,6 +73,9 @@ public:
     ::ndk::ScopedAStatus close() override;
     ::ndk::ScopedAStatus setStatusCheckIntervalHint(int64_t in_milliseconds) override;
 
+    // Forwards the HAL status callbacks to the client. A status is only forwarded when it
+    // differs from the previous one: the client listens for status changes, and some HALs
+    // repeat the same status for every chunk of data, waking the client each time.
     struct DvrCallback : public BnDvrCallback {
         DvrCallback(const shared_ptr<ITunerDvrCallback> tunerDvrCallback)
               : mTunerDvrCallback(tunerDvrCallback){};
@@ -70,13 +83,34 @@ public:
         ::ndk::ScopedAStatus onRecordStatus(const RecordStatus status) override;
         ::ndk::ScopedAStatus onPlaybackStatus(const PlaybackStatus status) override;
 
+        // Forwards the next status even if it is the same as the last one.
+        void resetStatus();
+        string dump();
+
     private:
+        // Returns true if the status must be forwarded to the client.
+        bool onStatus(int32_t status);
+
         shared_ptr<ITunerDvrCallback> mTunerDvrCallback;
+        Mutex mLock;
+        int32_t mLastStatus = -1;  // -1 if no status was forwarded since the last reset.
+        int64_t mReceivedCount = 0;
+        int64_t mForwardedCount = 0;
     };
 
 private:
+    string dump();
+
+    static Mutex sDvrsLock;
+    static std::set<TunerDvr*> sDvrs;  // all open DVRs, for dumpsys.
+
     shared_ptr<IDvr> mDvr;
     DvrType mType;
+    shared_ptr<DvrCallback> mCallback;
+    Mutex mLock;
+    DvrSettings mSettings;
+    bool mConfigured = false;
+    bool mStarted = false;
 };
 
 }  // namespace tuner
@@ -19,7 +19,9 @@
 #include "TunerFilter.h"
 
 #include <aidl/android/hardware/tv/tuner/Result.h>
+#include <android-base/stringprintf.h>
 #include <binder/IPCThreadState.h>
+#include <unistd.h>
 
 #include "TunerHelper.h"
 #include "TunerService.h"
@@ -33,6 +35,7 @@ namespace tv {
 namespace tuner {
 
 using ::android::IPCThreadState;
+using ::android::base::StringPrintf;
 
 using namespace std;
 
@@ -44,9 +47,16 @@ TunerFilter::TunerFilter(const shared_ptr<IFilter> filter, const shared_ptr<Filt
         mShared(false),
         mClientPid(-1),
         mFilterCallback(cb),
-        mTunerService(tuner) {}
+        mTunerService(tuner) {
+    Mutex::Autolock _l(sFiltersLock);
+    sFilters.insert(this);
+}
 
 TunerFilter::~TunerFilter() {
+    {
+        Mutex::Autolock _l(sFiltersLock);
+        sFilters.erase(this);
+    }
     close();
     freeSharedFilterToken("");
     {
@@ -316,6 +326,34 @@ TunerFilter::~TunerFilter() {
     return mFilter->setDelayHint(in_hint);
 }
 
+Mutex TunerFilter::sFiltersLock;
+std::set<TunerFilter*> TunerFilter::sFilters;
+
+void TunerFilter::dumpAll(int fd) {
+    string result;
+    Mutex::Autolock _l(sFiltersLock);
+    result.append(StringPrintf("%zu open filter(s)\n", sFilters.size()));
+    for (TunerFilter* filter : sFilters) {
+        result.append(filter->dump());
+    }
+    write(fd, result.c_str(), result.size());
+}
+
+string TunerFilter::dump() {
+    string result;
+    {
+        Mutex::Autolock _l(mLock);
+        result = StringPrintf("  Filter %p: mainType %d%s%s", this,
+                              static_cast<int32_t>(mType.mainType),
+                              mStarted ? " started" : " stopped", mShared ? " shared" : "");
+    }
+    if (mFilterCallback != nullptr) {
+        result.append(mFilterCallback->dump());
+    }
+    result.append("\n");
+    return result;
+}
+
 bool TunerFilter::isSharedFilterAllowed(int callingPid) {
     return mShared && mClientPid != callingPid;
 }
@@ -342,6 +380,14 @@ shared_ptr<IFilter> TunerFilter::getHalFilter() {
 ::ndk::ScopedAStatus TunerFilter::FilterCallback::onFilterEvent(
         const vector<DemuxFilterEvent>& events) {
     Mutex::Autolock _l(mCallbackLock);
+    ++mEventCallbackCount;
+    mEventCount += events.size();
+    for (const DemuxFilterEvent& event : events) {
+        if (event.getTag() == DemuxFilterEvent::section) {
+            ++mSectionEventCount;
+            mSectionDataLength += event.get<DemuxFilterEvent::section>().dataLength;
+        }
+    }
     if (mTunerFilterCallback != nullptr) {
         mTunerFilterCallback->onFilterEvent(events);
     }
@@ -376,6 +422,13 @@ void TunerFilter::FilterCallback::detachCallbacks() {
     mTunerFilterCallback = nullptr;
 }
 
+string TunerFilter::FilterCallback::dump() {
+    Mutex::Autolock _l(mCallbackLock);
+    return StringPrintf(" event callbacks %lld events %lld section events %lld bytes %lld",
+                        (long long)mEventCallbackCount, (long long)mEventCount,
+                        (long long)mSectionEventCount, (long long)mSectionDataLength);
+}
+
 }  // namespace tuner
 }  // namespace tv
 }  // namespace media
@@ -29,6 +29,9 @@
 #include <aidl/android/media/tv/tuner/ITunerFilterCallback.h>
 #include <utils/Mutex.h>
 
+#include <set>
+#include <string>
+
 using ::aidl::android::hardware::common::NativeHandle;
 using ::aidl::android::hardware::common::fmq::MQDescriptor;
 using ::aidl::android::hardware::common::fmq::SynchronizedReadWrite;
@@ -69,11 +72,18 @@ public:
         void attachSharedFilterCallback(const shared_ptr<ITunerFilterCallback>& in_cb);
         void detachSharedFilterCallback();
         void detachCallbacks();
+        string dump();
 
     private:
         shared_ptr<ITunerFilterCallback> mTunerFilterCallback;
         shared_ptr<ITunerFilterCallback> mOriginalCallback;
         Mutex mCallbackLock;
+
+        // Event statistics, for dumpsys.
+        int64_t mEventCallbackCount = 0;
+        int64_t mEventCount = 0;
+        int64_t mSectionEventCount = 0;
+        int64_t mSectionDataLength = 0;
     };
 
     TunerFilter(const shared_ptr<IFilter> filter, const shared_ptr<FilterCallback> cb,
@@ -105,7 +115,15 @@ public:
     void attachSharedFilterCallback(const shared_ptr<ITunerFilterCallback>& in_cb);
     shared_ptr<IFilter> getHalFilter();
 
+    // Writes the state and event statistics of all open filters, for dumpsys.
+    static void dumpAll(int fd);
+
 private:
+    string dump();
+
+    static Mutex sFiltersLock;
+    static std::set<TunerFilter*> sFilters;  // all open filters, for dumpsys.
+
     shared_ptr<IFilter> mFilter;
     int32_t mId;
     int64_t mId64Bit;
@@ -29,11 +29,13 @@
 #include <binder/PermissionCache.h>
 #include <cutils/properties.h>
 #include <utils/Log.h>
+#include <unistd.h>
 
 #include <string>
 
 #include "TunerDemux.h"
 #include "TunerDescrambler.h"
+#include "TunerDvr.h"
 #include "TunerFrontend.h"
 #include "TunerHelper.h"
 #include "TunerLnb.h"
@@ -45,6 +47,7 @@ using ::aidl::android::hardware::tv::tuner::Result;
 using ::android::IPCThreadState;
 using ::android::PermissionCache;
 using ::android::sp;
+using ::android::String16;
 
 namespace aidl {
 namespace android {
@@ -273,6 +276,18 @@ binder_status_t TunerService::instantiate() {
     return mTuner->getMaxNumberOfFrontends(in_frontendType, _aidl_return);
 }
 
+binder_status_t TunerService::dump(int fd, const char** /* args */, uint32_t /* numArgs */) {
+    if (!PermissionCache::checkCallingPermission(String16("android.permission.DUMP"))) {
+        string result = "Permission Denial: can't dump TunerService\n";
+        write(fd, result.c_str(), result.size());
+        return PERMISSION_DENIED;
+    }
+
+    TunerDvr::dumpAll(fd);
+    TunerFilter::dumpAll(fd);
+    return STATUS_OK;
+}
+
 string TunerService::addFilterToShared(const shared_ptr<TunerFilter>& sharedFilter) {
     Mutex::Autolock _l(mSharedFiltersLock);
 